@@ -18,18 +18,28 @@
 #ifndef ISAAC_COMMON__MESSAGING__MESSAGE_BUFFER_HPP_
 #define ISAAC_COMMON__MESSAGING__MESSAGE_BUFFER_HPP_
 
+#include <cstddef>
 #include <cstdint>
-#include <list>
+#include <iterator>
 #include <utility>
 #include <vector>
 
 namespace nvidia::isaac_common::messaging
 {
 
+// A fixed capacity buffer of timestamped messages, ordered by timestamp.
+//
+// The messages are stored in a contiguous ring buffer which is allocated once at construction, so
+// pushing and popping never allocates. Messages which arrive out of order are inserted at their
+// sorted position, such that all time range queries are binary searches. The Peek* functions
+// return views into the buffer instead of copies; a view is invalidated by any modification of the
+// buffer. T has to be default constructible.
 template<class T>
 class MessageBuffer
 {
 public:
+  class ConstView;
+
   explicit MessageBuffer(int maxsize);
   void Push(const int64_t & timestamp, const T & msg);
   T Pop();
@@ -44,61 +54,208 @@ public:
   std::vector<T> ClearAndGetUpto(const int64_t & timestamp);
   std::vector<T> GetAll() const;
   std::vector<T> GetUpto(const int64_t & start_time, const int64_t & end_time) const;
+  // Same as GetAll() and GetUpto() but without copying the messages.
+  ConstView PeekAll() const;
+  ConstView PeekUpto(const int64_t & start_time, const int64_t & end_time) const;
 
 private:
-  // Buffer size
-  int max_size_;
+  // Index into storage_ of the i-th message in timestamp order.
+  size_t StorageIndex(size_t i) const;
+  std::pair<int64_t, T> & At(size_t i);
+  const std::pair<int64_t, T> & At(size_t i) const;
+  // Index of the first message with a timestamp not before (LowerBound) or after (UpperBound) the
+  // given timestamp.
+  size_t LowerBound(const int64_t & timestamp) const;
+  size_t UpperBound(const int64_t & timestamp) const;
+  // Remove the first num_messages messages.
+  void PopFront(size_t num_messages);
+
   // Timestamp of the last processed / removed message
   int64_t last_msg_ts_;
   // Timestamp of the lastest message that is added to the buffer
   int64_t current_msg_ts_;
   // Timestamp of the next message to be processed
   int64_t next_msg_ts_;
-  // Buffer to store a message along with a timestamp field.
-  std::list<std::pair<int64_t, T>> buffer_;
+  // Ring buffer to store a message along with a timestamp field. Its size is the capacity of the
+  // buffer.
+  std::vector<std::pair<int64_t, T>> storage_;
+  // Index into storage_ of the earliest message.
+  size_t head_ = 0;
+  // Number of messages in the buffer.
+  size_t size_ = 0;
+};
+
+// A read-only view of a range of consecutive messages of a MessageBuffer.
+template<class T>
+class MessageBuffer<T>::ConstView
+{
+public:
+  class Iterator
+  {
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const T *;
+    using reference = const T &;
+
+    Iterator(const MessageBuffer<T> * buffer, size_t index)
+    : buffer_{buffer}, index_{index} {}
+    reference operator*() const {return buffer_->At(index_).second;}
+    pointer operator->() const {return &buffer_->At(index_).second;}
+    int64_t Timestamp() const {return buffer_->At(index_).first;}
+    Iterator & operator++()
+    {
+      ++index_;
+      return *this;
+    }
+    Iterator operator++(int)
+    {
+      Iterator result = *this;
+      ++index_;
+      return result;
+    }
+    bool operator==(const Iterator & other) const {return index_ == other.index_;}
+    bool operator!=(const Iterator & other) const {return index_ != other.index_;}
+
+private:
+    const MessageBuffer<T> * buffer_;
+    size_t index_;
+  };
+
+  ConstView(const MessageBuffer<T> * buffer, size_t begin, size_t end)
+  : buffer_{buffer}, begin_{begin}, end_{end} {}
+  Iterator begin() const {return Iterator(buffer_, begin_);}
+  Iterator end() const {return Iterator(buffer_, end_);}
+  size_t size() const {return end_ - begin_;}
+  bool empty() const {return begin_ == end_;}
+  const T & operator[](size_t i) const {return buffer_->At(begin_ + i).second;}
+  int64_t Timestamp(size_t i) const {return buffer_->At(begin_ + i).first;}
+
+private:
+  const MessageBuffer<T> * buffer_;
+  size_t begin_;
+  size_t end_;
 };
 
 template<typename T>
 MessageBuffer<T>::MessageBuffer(int maxsize)
-: max_size_{maxsize}, last_msg_ts_{-1}, current_msg_ts_{-1}, next_msg_ts_{-1} {}
+: last_msg_ts_{-1}, current_msg_ts_{-1}, next_msg_ts_{-1}, storage_(maxsize > 0 ? maxsize : 0) {}
+
+template<typename T>
+size_t MessageBuffer<T>::StorageIndex(size_t i) const
+{
+  const size_t index = head_ + i;
+  return index < storage_.size() ? index : index - storage_.size();
+}
+
+template<typename T>
+std::pair<int64_t, T> & MessageBuffer<T>::At(size_t i)
+{
+  return storage_[StorageIndex(i)];
+}
+
+template<typename T>
+const std::pair<int64_t, T> & MessageBuffer<T>::At(size_t i) const
+{
+  return storage_[StorageIndex(i)];
+}
+
+template<typename T>
+size_t MessageBuffer<T>::LowerBound(const int64_t & timestamp) const
+{
+  size_t first = 0;
+  size_t count = size_;
+  while (count > 0) {
+    const size_t step = count / 2;
+    if (At(first + step).first < timestamp) {
+      first += step + 1;
+      count -= step + 1;
+    } else {
+      count = step;
+    }
+  }
+  return first;
+}
+
+template<typename T>
+size_t MessageBuffer<T>::UpperBound(const int64_t & timestamp) const
+{
+  size_t first = 0;
+  size_t count = size_;
+  while (count > 0) {
+    const size_t step = count / 2;
+    if (At(first + step).first <= timestamp) {
+      first += step + 1;
+      count -= step + 1;
+    } else {
+      count = step;
+    }
+  }
+  return first;
+}
+
+template<typename T>
+void MessageBuffer<T>::PopFront(size_t num_messages)
+{
+  for (size_t i = 0; i < num_messages; ++i) {
+    // Release the message (e.g. a shared pointer) right away.
+    At(0).second = T();
+    head_ = StorageIndex(1);
+    --size_;
+  }
+  next_msg_ts_ = size_ == 0 ? -1 : At(0).first;
+}
 
 template<typename T>
 void MessageBuffer<T>::Push(const int64_t & timestamp, const T & msg)
 {
-  if (static_cast<int>(buffer_.size()) >= max_size_) {
-    buffer_.pop_front();
+  if (storage_.empty()) {
+    return;
+  }
+  if (size_ == storage_.size()) {
+    PopFront(1);
+  }
+  // Messages usually arrive in order, in which case they are appended. Otherwise the later
+  // messages are shifted back by one.
+  size_t index = size_;
+  if (size_ > 0 && timestamp < At(size_ - 1).first) {
+    index = UpperBound(timestamp);
+    for (size_t i = size_; i > index; --i) {
+      At(i) = std::move(At(i - 1));
+    }
   }
-  buffer_.emplace_back(std::make_pair(timestamp, msg));
+  At(index) = std::make_pair(timestamp, msg);
+  ++size_;
   current_msg_ts_ = timestamp;
-  next_msg_ts_ = buffer_.front().first;
+  next_msg_ts_ = At(0).first;
 }
 
 template<typename T>
 T MessageBuffer<T>::Pop()
 {
-  auto result = buffer_.front();
-  buffer_.pop_front();
-  last_msg_ts_ = result.first;
-  next_msg_ts_ = buffer_.empty() ? -1 : buffer_.front().first;
-  return result.second;
+  T result = std::move(At(0).second);
+  last_msg_ts_ = At(0).first;
+  PopFront(1);
+  return result;
 }
 
 template<typename T>
 T MessageBuffer<T>::Peek() const
 {
-  return buffer_.front().second;
+  return At(0).second;
 }
 
 template<typename T>
 int MessageBuffer<T>::Size() const
 {
-  return buffer_.size();
+  return size_;
 }
 
 template<typename T>
 bool MessageBuffer<T>::IsEmpty() const
 {
-  return buffer_.empty();
+  return size_ == 0;
 }
 
 template<typename T>
@@ -122,43 +279,55 @@ int64_t MessageBuffer<T>::GetNextTimeStamp() const
 template<typename T>
 void MessageBuffer<T>::ClearAll()
 {
-  buffer_.clear();
+  PopFront(size_);
 }
 
 template<typename T>
 void MessageBuffer<T>::ClearUpto(const int64_t & timestamp)
 {
-  buffer_.remove_if([timestamp](std::pair<int64_t, T> msg) {return msg.first <= timestamp;});
+  PopFront(UpperBound(timestamp));
 }
 
 template<typename T>
 std::vector<T> MessageBuffer<T>::ClearAndGetUpto(const int64_t & timestamp)
 {
-  const auto values = GetUpto(-1, timestamp);
-  ClearUpto(timestamp);
+  const size_t end = UpperBound(timestamp);
+  std::vector<T> values;
+  values.reserve(end);
+  for (size_t i = 0; i < end; ++i) {
+    values.emplace_back(std::move(At(i).second));
+  }
+  PopFront(end);
   return values;
 }
 
 template<typename T>
 std::vector<T> MessageBuffer<T>::GetUpto(const int64_t & start_time, const int64_t & end_time) const
 {
-  std::vector<T> result;
-  for (auto msg : buffer_) {
-    if (msg.first >= start_time && msg.first <= end_time) {
-      result.emplace_back(msg.second);
-    }
-  }
-  return result;
+  const ConstView view = PeekUpto(start_time, end_time);
+  return std::vector<T>(view.begin(), view.end());
 }
 
 template<typename T>
 std::vector<T> MessageBuffer<T>::GetAll() const
 {
-  std::vector<T> result;
-  for (auto msg : buffer_) {
-    result.emplace_back(msg.second);
-  }
-  return result;
+  const ConstView view = PeekAll();
+  return std::vector<T>(view.begin(), view.end());
+}
+
+template<typename T>
+typename MessageBuffer<T>::ConstView MessageBuffer<T>::PeekAll() const
+{
+  return ConstView(this, 0, size_);
+}
+
+template<typename T>
+typename MessageBuffer<T>::ConstView MessageBuffer<T>::PeekUpto(
+  const int64_t & start_time, const int64_t & end_time) const
+{
+  const size_t begin = LowerBound(start_time);
+  const size_t end = UpperBound(end_time);
+  return ConstView(this, begin, end < begin ? begin : end);
 }
 
 }  // namespace nvidia::isaac_common::messaging
@@ -56,6 +56,12 @@ public:
   // And if we have a match call trigger the callback function.
   void PopBuffersAndTriggerCallback();
 
+  // Same as PopBuffersAndTriggerCallback(), but assumes that no more messages at or before
+  // timestamp arrive. Messages which can't match any later message are therefore popped even
+  // though some buffers are empty. Use with a min_num_messages below num_topics to bound the time
+  // a message waits for messages of other topics that are late or were dropped.
+  void FlushUpto(int64_t timestamp);
+
   // Callback that is called whenever we have a new matching set of messages.
   void RegisterCallback(CallbackFunction callback);
 
@@ -63,9 +69,17 @@ public:
   void ClearBuffers();
 
 private:
-  // Get the timestamps of the earliest message of every message buffer.
-  std::vector<int64_t> PeekMessageTimestamps() const;
-  void TriggerCallbackWithMessages(const std::vector<int> & buffer_indices);
+  // Make the min-heap of buffer heads reflect the current front message of
+  // buffer idx (removing the buffer if it is empty).
+  void UpdateHead(int idx);
+  void SwapHeapNodes(size_t a, size_t b);
+  void SiftUp(size_t pos);
+  void SiftDown(size_t pos);
+  // Collect the (sorted) indices of all buffers whose front message is within
+  // the threshold of the earliest front message into match_indices_.
+  void FindMatches();
+  // Pop the matched messages and pass them to the callback.
+  void PopMatchesAndTriggerCallback();
 
   // Threshold used to consider if timestamps of multiple messages are matching.
   const int timestamp_delta_threshold_ns_;
@@ -74,44 +88,38 @@ private:
 
   std::vector<MessageBuffer<Message>> message_buffers_;
   CallbackFunction callback_ = [](int64_t, const std::vector<std::pair<int, Message>> &) {};
-};
-
-namespace
-{
-std::vector<int> GetIndicesOfMessagesBeforeThreshold(
-  const std::vector<int64_t> & values, int64_t threshold)
-{
-  if (values.empty()) {
-    return {};
-  }
-
-  const int64_t min_value = *std::min_element(values.begin(), values.end());
 
-  std::vector<int> indices;
-  indices.reserve(values.size());
-
-  for (size_t i = 0; i < values.size(); ++i) {
-    if (values[i] <= min_value + threshold) {
-      indices.push_back(i);
-    }
-  }
-  return indices;
-}
-
-}  // namespace
+  // Min-heap of the timestamps of the front messages of all non-empty buffers,
+  // as (timestamp, buffer index).
+  std::vector<std::pair<int64_t, int>> heap_;
+  // Position of every buffer in heap_, -1 if the buffer is empty.
+  std::vector<int> heap_positions_;
+  // Storage reused between matches, preallocated to the number of topics.
+  std::vector<int> match_indices_;
+  std::vector<size_t> heap_search_stack_;
+  std::vector<std::pair<int, Message>> matched_messages_;
+};
 
 template<typename Message>
 MessageStreamSynchronizer<Message>::MessageStreamSynchronizer(
   int num_topics, int timestamp_delta_threshold_ns, int min_num_messages, int buffer_size)
 : timestamp_delta_threshold_ns_(timestamp_delta_threshold_ns),
   min_num_messages_(min_num_messages),
-  message_buffers_(num_topics, MessageBuffer<Message>(buffer_size)) {}
+  message_buffers_(num_topics, MessageBuffer<Message>(buffer_size)),
+  heap_positions_(num_topics, -1)
+{
+  heap_.reserve(num_topics);
+  match_indices_.reserve(num_topics);
+  heap_search_stack_.reserve(num_topics);
+  matched_messages_.reserve(num_topics);
+}
 
 template<typename Message>
 void MessageStreamSynchronizer<Message>::AddMessage(
   int idx, int64_t timestamp, const Message & message, bool trigger_callback)
 {
   message_buffers_[idx].Push(timestamp, message);
+  UpdateHead(idx);
   if (trigger_callback) {
     PopBuffersAndTriggerCallback();
   }
@@ -124,59 +132,143 @@ auto MessageStreamSynchronizer<Message>::PeekNextMessage(int idx) const -> Messa
 }
 
 template<typename Message>
-std::vector<int64_t> MessageStreamSynchronizer<Message>::PeekMessageTimestamps() const
+void MessageStreamSynchronizer<Message>::SwapHeapNodes(size_t a, size_t b)
 {
-  std::vector<int64_t> timestamps;
-  timestamps.reserve(message_buffers_.size());
-  for (const auto & buffer : message_buffers_) {
-    if (buffer.IsEmpty()) {
-      return {};
-    }
-    timestamps.push_back(buffer.GetNextTimeStamp());
-  }
-  return timestamps;
+  std::swap(heap_[a], heap_[b]);
+  heap_positions_[heap_[a].second] = a;
+  heap_positions_[heap_[b].second] = b;
 }
 
 template<typename Message>
-void MessageStreamSynchronizer<Message>::TriggerCallbackWithMessages(
-  const std::vector<int> & indices)
+void MessageStreamSynchronizer<Message>::SiftUp(size_t pos)
 {
-  int64_t max_timestamp = -1;
-  std::vector<Message> messages;
-  std::vector<std::pair<int, Message>> idx_and_images;
-  idx_and_images.reserve(indices.size());
-
-  for (auto & idx : indices) {
-    const int64_t timestamp = message_buffers_[idx].GetNextTimeStamp();
-    max_timestamp = std::max(timestamp, max_timestamp);
-    idx_and_images.push_back({idx, message_buffers_[idx].Peek()});
+  while (pos > 0) {
+    const size_t parent = (pos - 1) / 2;
+    if (heap_[parent].first <= heap_[pos].first) {
+      return;
+    }
+    SwapHeapNodes(pos, parent);
+    pos = parent;
   }
-
-  callback_(max_timestamp, idx_and_images);
 }
 
 template<typename Message>
-void MessageStreamSynchronizer<Message>::PopBuffersAndTriggerCallback()
+void MessageStreamSynchronizer<Message>::SiftDown(size_t pos)
 {
-  // Strategy: We look at the front message of every buffer and use all messages that are within the
-  // timestamp threshold.
   while (true) {
-    const std::vector<int64_t> timestamps = PeekMessageTimestamps();
-    // If empty we don't yet have enough values.
-    if (timestamps.empty()) {
+    size_t smallest = pos;
+    for (const size_t child : {2 * pos + 1, 2 * pos + 2}) {
+      if (child < heap_.size() && heap_[child].first < heap_[smallest].first) {
+        smallest = child;
+      }
+    }
+    if (smallest == pos) {
       return;
     }
+    SwapHeapNodes(pos, smallest);
+    pos = smallest;
+  }
+}
 
-    const std::vector<int> front_match_indices =
-      GetIndicesOfMessagesBeforeThreshold(timestamps, timestamp_delta_threshold_ns_);
+template<typename Message>
+void MessageStreamSynchronizer<Message>::UpdateHead(int idx)
+{
+  const MessageBuffer<Message> & buffer = message_buffers_[idx];
+  int pos = heap_positions_[idx];
+  if (buffer.IsEmpty()) {
+    if (pos < 0) {
+      return;
+    }
+    // Replace by the last node and restore the heap property.
+    SwapHeapNodes(pos, heap_.size() - 1);
+    heap_.pop_back();
+    heap_positions_[idx] = -1;
+    if (static_cast<size_t>(pos) < heap_.size()) {
+      const int moved_idx = heap_[pos].second;
+      SiftUp(pos);
+      SiftDown(heap_positions_[moved_idx]);
+    }
+    return;
+  }
+  if (pos < 0) {
+    pos = heap_.size();
+    heap_.emplace_back(buffer.GetNextTimeStamp(), idx);
+    heap_positions_[idx] = pos;
+  } else {
+    heap_[pos].first = buffer.GetNextTimeStamp();
+  }
+  SiftUp(pos);
+  SiftDown(heap_positions_[idx]);
+}
 
-    if (front_match_indices.size() >= min_num_messages_) {
-      TriggerCallbackWithMessages(front_match_indices);
+template<typename Message>
+void MessageStreamSynchronizer<Message>::FindMatches()
+{
+  // All nodes within the threshold of the root form a subtree containing the
+  // root, so a search which prunes at nodes above the threshold only visits the
+  // matches and their direct children.
+  match_indices_.clear();
+  const int64_t max_timestamp = heap_[0].first + timestamp_delta_threshold_ns_;
+  heap_search_stack_.clear();
+  heap_search_stack_.push_back(0);
+  while (!heap_search_stack_.empty()) {
+    const size_t pos = heap_search_stack_.back();
+    heap_search_stack_.pop_back();
+    if (pos >= heap_.size() || heap_[pos].first > max_timestamp) {
+      continue;
     }
+    match_indices_.push_back(heap_[pos].second);
+    heap_search_stack_.push_back(2 * pos + 1);
+    heap_search_stack_.push_back(2 * pos + 2);
+  }
+  std::sort(match_indices_.begin(), match_indices_.end());
+}
 
-    for (const int idx : front_match_indices) {
-      message_buffers_[idx].Pop();
+template<typename Message>
+void MessageStreamSynchronizer<Message>::PopMatchesAndTriggerCallback()
+{
+  const bool trigger_callback = match_indices_.size() >= min_num_messages_;
+  int64_t max_timestamp = -1;
+  for (const int idx : match_indices_) {
+    MessageBuffer<Message> & buffer = message_buffers_[idx];
+    max_timestamp = std::max(buffer.GetNextTimeStamp(), max_timestamp);
+    if (trigger_callback) {
+      matched_messages_.emplace_back(idx, buffer.Pop());
+    } else {
+      buffer.Pop();
     }
+    UpdateHead(idx);
+  }
+  if (trigger_callback) {
+    callback_(max_timestamp, matched_messages_);
+    matched_messages_.clear();
+  }
+}
+
+template<typename Message>
+void MessageStreamSynchronizer<Message>::PopBuffersAndTriggerCallback()
+{
+  // Strategy: We look at the front message of every buffer and use all messages that are within the
+  // timestamp threshold. The front messages are kept in a min-heap, such that finding the matches
+  // only visits the matching buffers and popping a message costs O(log(num_topics)).
+  //
+  // If any buffer is empty we don't yet have enough values.
+  while (!heap_.empty() && heap_.size() == message_buffers_.size()) {
+    FindMatches();
+    PopMatchesAndTriggerCallback();
+  }
+}
+
+template<typename Message>
+void MessageStreamSynchronizer<Message>::FlushUpto(int64_t timestamp)
+{
+  // Later messages can still match the front messages within the threshold of timestamp.
+  while (!heap_.empty() &&
+    (heap_.size() == message_buffers_.size() ||
+    heap_[0].first + timestamp_delta_threshold_ns_ <= timestamp))
+  {
+    FindMatches();
+    PopMatchesAndTriggerCallback();
   }
 }
 
@@ -192,6 +284,8 @@ void MessageStreamSynchronizer<Message>::ClearBuffers()
   for (auto & buffer : message_buffers_) {
     buffer.ClearAll();
   }
+  heap_.clear();
+  std::fill(heap_positions_.begin(), heap_positions_.end(), -1);
 }
 
 }  // namespace nvidia::isaac_common::messaging
@@ -167,4 +167,61 @@ TEST_F(MessageBufferTest, TestRangeAccessAndDelete) {
   ASSERT_EQ(msg_buffer.Size(), static_cast<size_t>(0));
 }
 
+// This test is verifying that messages arriving out of order are kept sorted by timestamp
+TEST_F(MessageBufferTest, TestOutOfOrderPush) {
+  msg_buffer.Push(timestamps[2], msgs[2]);
+  msg_buffer.Push(timestamps[0], msgs[0]);
+  msg_buffer.Push(timestamps[4], msgs[4]);
+  msg_buffer.Push(timestamps[1], msgs[1]);
+  msg_buffer.Push(timestamps[3], msgs[3]);
+  EXPECT_EQ(msg_buffer.GetNextTimeStamp(), 1);
+  EXPECT_EQ(msg_buffer.GetCurrentTimeStamp(), 4);
+
+  auto all_msgs = msg_buffer.GetAll();
+  ASSERT_EQ(all_msgs.size(), static_cast<size_t>(5));
+  for (uint8_t i = 0; i < 5; i++) {
+    EXPECT_EQ(all_msgs[i].sec, i + 1);
+  }
+
+  // Pushing into the full buffer drops the earliest message.
+  msg_buffer.Push(0, msgs[0]);
+  EXPECT_EQ(msg_buffer.Size(), static_cast<size_t>(5));
+  EXPECT_EQ(msg_buffer.Pop().sec, 1);
+  EXPECT_EQ(msg_buffer.GetLastTimeStamp(), 0);
+  EXPECT_EQ(msg_buffer.Pop().sec, 2);
+}
+
+// This test is verifying the views returned by PeekAll and PeekUpto, also after the ring buffer
+// wrapped around
+TEST_F(MessageBufferTest, TestViews) {
+  EXPECT_TRUE(msg_buffer.PeekAll().empty());
+  for (uint8_t i = 0; i < 8; i++) {
+    ExampleMessage msg;
+    msg.sec = i;
+    msg.nanosec = 0;
+    msg_buffer.Push(i, msg);
+  }
+
+  const auto all_view = msg_buffer.PeekAll();
+  ASSERT_EQ(all_view.size(), static_cast<size_t>(5));
+  int64_t expected_sec = 3;
+  for (const ExampleMessage & msg : all_view) {
+    EXPECT_EQ(msg.sec, expected_sec++);
+  }
+
+  const auto range_view = msg_buffer.PeekUpto(4, 6);
+  ASSERT_EQ(range_view.size(), static_cast<size_t>(3));
+  EXPECT_EQ(range_view[0].sec, 4);
+  EXPECT_EQ(range_view.Timestamp(2), 6);
+
+  EXPECT_TRUE(msg_buffer.PeekUpto(10, 20).empty());
+  EXPECT_TRUE(msg_buffer.PeekUpto(6, 4).empty());
+  EXPECT_EQ(msg_buffer.PeekUpto(-1, 3).size(), static_cast<size_t>(1));
+
+  msg_buffer.ClearUpto(5);
+  ASSERT_EQ(msg_buffer.Size(), static_cast<size_t>(2));
+  EXPECT_EQ(msg_buffer.GetNextTimeStamp(), 6);
+  EXPECT_EQ(msg_buffer.PeekAll()[0].sec, 6);
+}
+
 }  // namespace nvidia::isaac_common::messaging
@@ -14,6 +14,8 @@
 // limitations under the License.
 //
 // SPDX-License-Identifier: Apache-2.0
+#include <algorithm>
+#include <random>
 #include <utility>
 #include <vector>
 
@@ -119,4 +121,109 @@ TEST(MessageStreamSynchronizerTests, EverythingTest) {
   synced_msgs.clear();
 }
 
+TEST(MessageStreamSynchronizerTests, FlushUptoTest) {
+  constexpr int kNumTopics = 2;
+  constexpr int kBufferSize = 10;
+  constexpr int kTimestepDeltaThresholdNs = 4;
+  constexpr int kMinNumMessages = 1;
+  MessageStreamSynchronizer<ExampleMessage> sync(
+    kNumTopics, kTimestepDeltaThresholdNs, kMinNumMessages, kBufferSize);
+
+  std::vector<std::pair<int, ExampleMessage>> synced_msgs;
+  sync.RegisterCallback(
+    [&synced_msgs](int64_t /*timestamp_ns*/, const auto & callback_msgs) {
+      synced_msgs = callback_msgs;
+    });
+
+  // Topic 1 is late: topic 0 waits.
+  sync.AddMessage(0, 10, CreateMessage(10));
+  ExpectTimestamps(synced_msgs, {}, {});
+
+  // Topic 1 could still send a message matching 10 until 14.
+  sync.FlushUpto(13);
+  ExpectTimestamps(synced_msgs, {}, {});
+  sync.FlushUpto(14);
+  ExpectTimestamps(synced_msgs, {0}, {10});
+  synced_msgs.clear();
+
+  // Matching messages which arrive in time are still matched.
+  sync.AddMessage(1, 20, CreateMessage(20));
+  sync.FlushUpto(21);
+  ExpectTimestamps(synced_msgs, {}, {});
+  sync.AddMessage(0, 22, CreateMessage(22));
+  ExpectTimestamps(synced_msgs, {0, 1}, {22, 20});
+  synced_msgs.clear();
+
+  // Flushing doesn't affect matching while all buffers have messages.
+  sync.AddMessage(0, 30, CreateMessage(30));
+  sync.AddMessage(1, 31, CreateMessage(31));
+  ExpectTimestamps(synced_msgs, {0, 1}, {30, 31});
+}
+
+// Compare against a straightforward implementation of the matching strategy
+// for many topics with random delays and drops.
+TEST(MessageStreamSynchronizerTests, ManyTopicsTest) {
+  constexpr int kNumTopics = 16;
+  constexpr int kBufferSize = 100;
+  constexpr int kTimestepDeltaThresholdNs = 3;
+  constexpr int kMinNumMessages = 12;
+  constexpr int kNumSteps = 200;
+  MessageStreamSynchronizer<ExampleMessage> sync(
+    kNumTopics, kTimestepDeltaThresholdNs, kMinNumMessages, kBufferSize);
+
+  std::vector<std::vector<std::pair<int, int>>> synced_msgs;
+  sync.RegisterCallback(
+    [&synced_msgs](int64_t /*timestamp_ns*/, const auto & callback_msgs) {
+      std::vector<std::pair<int, int>> idx_and_stamps;
+      for (const auto & [idx, msg] : callback_msgs) {
+        idx_and_stamps.emplace_back(idx, msg.nanosec);
+      }
+      synced_msgs.push_back(idx_and_stamps);
+    });
+
+  // Reference: the front timestamps of all topics, matched exactly as described
+  // in PopBuffersAndTriggerCallback().
+  std::vector<std::vector<int>> reference_buffers(kNumTopics);
+  std::vector<std::vector<std::pair<int, int>>> expected_msgs;
+  const auto reference_pop = [&]() {
+      while (std::all_of(
+          reference_buffers.begin(), reference_buffers.end(),
+          [](const auto & buffer) {return !buffer.empty();}))
+      {
+        int min_stamp = reference_buffers[0].front();
+        for (const auto & buffer : reference_buffers) {
+          min_stamp = std::min(min_stamp, buffer.front());
+        }
+        std::vector<std::pair<int, int>> matches;
+        for (int idx = 0; idx < kNumTopics; ++idx) {
+          if (reference_buffers[idx].front() <= min_stamp + kTimestepDeltaThresholdNs) {
+            matches.emplace_back(idx, reference_buffers[idx].front());
+            reference_buffers[idx].erase(reference_buffers[idx].begin());
+          }
+        }
+        if (matches.size() >= kMinNumMessages) {
+          expected_msgs.push_back(matches);
+        }
+      }
+    };
+
+  std::mt19937 rng(0);
+  std::uniform_int_distribution<int> jitter(0, 2);
+  std::bernoulli_distribution drop(0.1);
+  for (int step = 0; step < kNumSteps; ++step) {
+    for (int idx = 0; idx < kNumTopics; ++idx) {
+      if (drop(rng)) {
+        continue;
+      }
+      const int stamp = 10 * step + jitter(rng);
+      sync.AddMessage(idx, stamp, CreateMessage(stamp));
+      reference_buffers[idx].push_back(stamp);
+      reference_pop();
+    }
+  }
+
+  EXPECT_FALSE(expected_msgs.empty());
+  EXPECT_EQ(synced_msgs, expected_msgs);
+}
+
 }  // namespace nvidia::isaac_common::messaging
@@ -50,6 +50,12 @@ def generate_launch_description() -> LaunchDescription:
         True,
         description='Whether to enable nav2 for navigation in Isaac Sim.',
         cli=True)
+    args.add_arg(
+        'intra_process_comms',
+        False,
+        description='Whether nvblox hands its outputs to the nodes in the same container (e.g. the '
+        'nav2 costmap layers) by pointer rather than serializing them.',
+        cli=True)
     actions = args.get_launch_actions()
 
     # Globally set use_sim_time
@@ -90,6 +96,7 @@ def generate_launch_description() -> LaunchDescription:
                 'camera': NvbloxCamera.isaac_sim,
                 'num_cameras': args.num_cameras,
                 'lidar': args.lidar,
+                'intra_process_comms': args.intra_process_comms,
             }))
 
     # Play ros2bag
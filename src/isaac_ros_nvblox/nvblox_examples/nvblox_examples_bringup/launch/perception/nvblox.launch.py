@@ -100,6 +100,7 @@ def add_nvblox(args: lu.ArgumentContainer) -> List[Action]:
     camera = NvbloxCamera[args.camera]
     num_cameras = int(args.num_cameras)
     use_lidar = lu.is_true(args.lidar)
+    use_intra_process_comms = lu.is_true(args.intra_process_comms)
 
     if camera == NvbloxCamera.realsense:
         assert args.num_cameras == 1, 'NvbloxCamera.realsense shall only be set for num_cameras==1'
@@ -169,6 +170,9 @@ def add_nvblox(args: lu.ArgumentContainer) -> List[Action]:
         plugin='nvblox::NvbloxNode',
         remappings=remappings,
         parameters=parameters,
+        # Within a shared container (e.g. with the nav2 costmap layers and the camera drivers), hand
+        # messages over by pointer instead of serializing them.
+        extra_arguments=[{'use_intra_process_comms': use_intra_process_comms}],
     )
 
     actions = []
@@ -191,6 +195,7 @@ def generate_launch_description() -> LaunchDescription:
     args.add_arg('lidar', 'False')
     args.add_arg('container_name', NVBLOX_CONTAINER_NAME)
     args.add_arg('run_standalone', 'False')
+    args.add_arg('intra_process_comms', 'False')
 
     args.add_opaque_function(add_nvblox)
     return LaunchDescription(args.get_launch_actions())
@@ -65,6 +65,12 @@ def generate_launch_description() -> LaunchDescription:
         True,
         description='Whether to enable nav2 for navigation.',
         cli=True)
+    args.add_arg(
+        'intra_process_comms',
+        False,
+        description='Whether nvblox hands its outputs to the nodes in the same container (e.g. the '
+        'nav2 costmap layers) by pointer rather than serializing them.',
+        cli=True)
     actions = args.get_launch_actions()
 
     # Globally set use_sim_time if we're running from bag or sim
@@ -133,6 +139,7 @@ def generate_launch_description() -> LaunchDescription:
                 'mode': args.mode,
                 'camera': camera_mode,
                 'num_cameras': args.num_cameras,
+                'intra_process_comms': args.intra_process_comms,
             },
         ))
     
@@ -50,12 +50,21 @@ def get_camera_node(camera_name: str, config_file_path: str, serial_number: Opti
     return realsense_node
 
 
-def get_splitter_node(camera_name: str) -> ComposableNode:
+def get_splitter_node(camera_name: str, use_nitros: bool = False) -> ComposableNode:
+    # The NITROS splitter forwards image handles instead of copying the images, which requires the
+    # camera and the consumers to run in the same container with intra-process communication.
+    if use_nitros:
+        plugin = 'nvblox::NitrosRealsenseSplitterNode'
+        extra_arguments = [{'use_intra_process_comms': True}]
+    else:
+        plugin = 'nvblox::RealsenseSplitterNode'
+        extra_arguments = []
     realsense_splitter_node = ComposableNode(
         namespace=camera_name,
         name='realsense_splitter_node',
         package='realsense_splitter',
-        plugin='nvblox::RealsenseSplitterNode',
+        plugin=plugin,
+        extra_arguments=extra_arguments,
         parameters=[{
             'input_qos': 'SENSOR_DATA',
             'output_qos': 'SENSOR_DATA'
@@ -113,6 +122,7 @@ def add_cameras(args: lu.ArgumentContainer) -> List[Action]:
             nodes.append(
                 get_splitter_node(
                     camera_name=camera_name,
+                    use_nitros=lu.is_true(args.use_nitros_splitter),
             ))
         # Note(xinjieyao: 2024/08/24): Multi-rs launch use RealSenseNodeFactory could be unstable
         # Camera node may fail to launch without any ERROR or app crashes
@@ -131,6 +141,8 @@ def generate_launch_description() -> LaunchDescription:
     args.add_arg('run_standalone', 'False')
     args.add_arg('camera_serial_numbers', '')
     args.add_arg('num_cameras', 1)
+    args.add_arg('use_nitros_splitter', 'False',
+                 'Whether to run the zero-copy NITROS version of the realsense splitter.')
 
     # Adding the cameras
     args.add_opaque_function(add_cameras)
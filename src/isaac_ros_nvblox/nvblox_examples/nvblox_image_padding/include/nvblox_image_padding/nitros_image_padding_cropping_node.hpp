@@ -0,0 +1,74 @@
+// SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+// Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef NVBLOX_IMAGE_PADDING__NITROS_IMAGE_PADDING_CROPPING_NODE_HPP_
+#define NVBLOX_IMAGE_PADDING__NITROS_IMAGE_PADDING_CROPPING_NODE_HPP_
+
+#include <cuda_runtime.h>
+
+#include <memory>
+#include <string>
+
+#include <rclcpp/rclcpp.hpp>
+
+#include <isaac_ros_managed_nitros/managed_nitros_publisher.hpp>
+#include <isaac_ros_managed_nitros/managed_nitros_subscriber.hpp>
+#include <isaac_ros_nitros_image_type/nitros_image.hpp>
+#include <isaac_ros_nitros_image_type/nitros_image_view.hpp>
+
+namespace nvblox
+{
+
+/// GPU version of the ImagePaddingCroppingNode. Images are received and published as NITROS
+/// images and are padded/cropped in device memory, such that they never leave the GPU.
+class NitrosImagePaddingCroppingNode : public rclcpp::Node
+{
+public:
+  explicit NitrosImagePaddingCroppingNode(
+    const rclcpp::NodeOptions & options = rclcpp::NodeOptions(),
+    const std::string & node_name = "nitros_image_padding_node");
+  virtual ~NitrosImagePaddingCroppingNode();
+
+  // Callbacks
+  void imageCallback(const nvidia::isaac_ros::nitros::NitrosImageView & image_view);
+
+private:
+  // Image subscriber
+  std::shared_ptr<nvidia::isaac_ros::nitros::ManagedNitrosSubscriber<
+      nvidia::isaac_ros::nitros::NitrosImageView>> image_sub_;
+
+  // Image publisher
+  std::shared_ptr<nvidia::isaac_ros::nitros::ManagedNitrosPublisher<
+      nvidia::isaac_ros::nitros::NitrosImage>> image_pub_;
+
+  // The amount to pad (or crop)
+  int desired_height_ = -1;
+  int desired_width_ = -1;
+
+  // The NITROS format of the input and output images
+  std::string nitros_format_ = "nitros_image_mono8";
+
+  // The stream on which the images are padded/cropped
+  cudaStream_t cuda_stream_ = nullptr;
+
+  // Default subscription QoS
+  const std::string kDefaultImageQos_ = "SYSTEM_DEFAULT";
+};
+
+}  // namespace nvblox
+
+#endif  // NVBLOX_IMAGE_PADDING__NITROS_IMAGE_PADDING_CROPPING_NODE_HPP_
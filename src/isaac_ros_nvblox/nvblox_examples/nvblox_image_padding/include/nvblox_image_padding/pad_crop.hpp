@@ -0,0 +1,64 @@
+// SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+// Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef NVBLOX_IMAGE_PADDING__PAD_CROP_HPP_
+#define NVBLOX_IMAGE_PADDING__PAD_CROP_HPP_
+
+#include <cuda_runtime.h>
+
+#include <cstddef>
+
+namespace nvblox
+{
+
+/// The rectangle which is copied from the input to the output image when
+/// padding/cropping an image, keeping it centered.
+struct PadCropRegion
+{
+  int src_x = 0;
+  int src_y = 0;
+  int dst_x = 0;
+  int dst_y = 0;
+  int width = 0;
+  int height = 0;
+};
+
+/// Compute the copied region for padding/cropping an image of size in_width x in_height to
+/// out_width x out_height. Each dimension is padded or cropped independently. If the size
+/// difference is odd, the extra pixel is on the right/bottom.
+PadCropRegion getPadCropRegion(int in_width, int in_height, int out_width, int out_height);
+
+/// Pad/crop a (pitched) device image of any pixel format. The output is zeroed outside the copied
+/// region. Only issues async memset and copies on the stream, no kernel launches.
+/// @param src              Input image in device memory.
+/// @param src_pitch_bytes  Row pitch of the input image.
+/// @param in_width         Input width in pixels.
+/// @param in_height        Input height in pixels.
+/// @param dst              Output image in device memory.
+/// @param dst_pitch_bytes  Row pitch of the output image.
+/// @param out_width        Output width in pixels.
+/// @param out_height       Output height in pixels.
+/// @param bytes_per_pixel  Size of a pixel in both images.
+/// @param cuda_stream      Stream to issue the operations on.
+void padOrCropImageGpuAsync(
+  const void * src, size_t src_pitch_bytes, int in_width, int in_height,
+  void * dst, size_t dst_pitch_bytes, int out_width, int out_height,
+  size_t bytes_per_pixel, cudaStream_t cuda_stream);
+
+}  // namespace nvblox
+
+#endif  // NVBLOX_IMAGE_PADDING__PAD_CROP_HPP_
@@ -0,0 +1,142 @@
+// SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+// Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <string>
+
+#include <isaac_ros_common/qos.hpp>
+#include <isaac_ros_nitros_image_type/nitros_image_builder.hpp>
+#include <nvblox_ros_common/check_cuda_errors.hpp>
+#include <sensor_msgs/image_encodings.hpp>
+#include <std_msgs/msg/header.hpp>
+
+#include "nvblox_image_padding/nitros_image_padding_cropping_node.hpp"
+#include "nvblox_image_padding/pad_crop.hpp"
+
+namespace nvblox
+{
+
+using std::placeholders::_1;
+using nvidia::isaac_ros::nitros::ManagedNitrosPublisher;
+using nvidia::isaac_ros::nitros::ManagedNitrosSubscriber;
+using nvidia::isaac_ros::nitros::NitrosDiagnosticsConfig;
+using nvidia::isaac_ros::nitros::NitrosImage;
+using nvidia::isaac_ros::nitros::NitrosImageBuilder;
+using nvidia::isaac_ros::nitros::NitrosImageView;
+
+NitrosImagePaddingCroppingNode::NitrosImagePaddingCroppingNode(
+  const rclcpp::NodeOptions & options,
+  const std::string & node_name)
+: Node(node_name, options)
+{
+  RCLCPP_INFO(get_logger(), "Starting up NitrosImagePaddingCroppingNode");
+
+  // Settings for QoS.
+  const rclcpp::QoS image_qos =
+    isaac_ros::common::AddQosParameter(*this, kDefaultImageQos_, "image_qos");
+
+  desired_height_ = declare_parameter<int>("desired_height", desired_height_);
+  desired_width_ = declare_parameter<int>("desired_width", desired_width_);
+  nitros_format_ = declare_parameter<std::string>("nitros_format", nitros_format_);
+
+  // Users like feedback!
+  if (desired_height_ <= 0 || desired_width_ <= 0) {
+    RCLCPP_FATAL_STREAM(
+      get_logger(),
+      "Parameters \"desired_height\" and \"desired_width\" need both to be "
+      "set and > 0. Currently desired_height="
+        << desired_height_ << " and desired_width=" << desired_width_);
+    exit(1);
+  }
+  RCLCPP_INFO_STREAM(
+    get_logger(), "Cropping/padding " << nitros_format_ << " images to desired_height="
+                                      << desired_height_
+                                      << ", and to desired_width=" << desired_width_);
+
+  checkCudaErrors(cudaStreamCreateWithFlags(&cuda_stream_, cudaStreamNonBlocking));
+
+  // Subscriptions
+  image_sub_ = std::make_shared<ManagedNitrosSubscriber<NitrosImageView>>(
+    this, "~/image_in", nitros_format_,
+    std::bind(&NitrosImagePaddingCroppingNode::imageCallback, this, _1),
+    NitrosDiagnosticsConfig(), image_qos);
+
+  // Publishers
+  image_pub_ = std::make_shared<ManagedNitrosPublisher<NitrosImage>>(
+    this, "~/image_out", nitros_format_, NitrosDiagnosticsConfig(), image_qos);
+}
+
+NitrosImagePaddingCroppingNode::~NitrosImagePaddingCroppingNode()
+{
+  if (cuda_stream_ != nullptr) {
+    cudaStreamDestroy(cuda_stream_);
+  }
+}
+
+void NitrosImagePaddingCroppingNode::imageCallback(const NitrosImageView & image_view)
+{
+  const std::string encoding = image_view.GetEncoding();
+  const size_t bytes_per_pixel = sensor_msgs::image_encodings::numChannels(encoding) *
+    sensor_msgs::image_encodings::bitDepth(encoding) / 8;
+  const int in_width = static_cast<int>(image_view.GetWidth());
+  const int in_height = static_cast<int>(image_view.GetHeight());
+
+  // Warn if the crop/pad amount is fractional
+  if (((desired_width_ - in_width) % 2) != 0) {
+    RCLCPP_WARN_ONCE(
+      get_logger(),
+      "Desired width - Image width not cleanly dividable by two. Extra pixel "
+      "will be made up on one side.");
+  }
+  if (((desired_height_ - in_height) % 2) != 0) {
+    RCLCPP_WARN_ONCE(
+      get_logger(),
+      "Desired height - Image height not cleanly dividable by two. Extra "
+      "pixel will be made up on one side.");
+  }
+
+  // The output buffer is owned by the published NITROS image, which frees it once all consumers
+  // are done with it.
+  const size_t out_pitch_bytes = desired_width_ * bytes_per_pixel;
+  void * output_buffer = nullptr;
+  checkCudaErrors(cudaMalloc(&output_buffer, out_pitch_bytes * desired_height_));
+
+  // NITROS images are densely packed.
+  padOrCropImageGpuAsync(
+    image_view.GetGpuData(), in_width * bytes_per_pixel, in_width, in_height, output_buffer,
+    out_pitch_bytes, desired_width_, desired_height_, bytes_per_pixel, cuda_stream_);
+  // Downstream consumers don't know about our stream.
+  checkCudaErrors(cudaStreamSynchronize(cuda_stream_));
+
+  std_msgs::msg::Header header;
+  header.stamp.sec = image_view.GetTimestampSeconds();
+  header.stamp.nanosec = image_view.GetTimestampNanoseconds();
+  header.frame_id = image_view.GetFrameId();
+
+  NitrosImage output_image = NitrosImageBuilder()
+    .WithHeader(header)
+    .WithEncoding(encoding)
+    .WithDimensions(desired_height_, desired_width_)
+    .WithGpuData(output_buffer)
+    .Build();
+  image_pub_->publish(output_image);
+}
+
+}  // namespace nvblox
+
+// Register the node as a component
+#include "rclcpp_components/register_node_macro.hpp"
+RCLCPP_COMPONENTS_REGISTER_NODE(nvblox::NitrosImagePaddingCroppingNode)
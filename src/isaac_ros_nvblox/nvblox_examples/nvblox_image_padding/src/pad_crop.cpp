@@ -0,0 +1,69 @@
+// SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+// Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "nvblox_image_padding/pad_crop.hpp"
+
+#include <algorithm>
+
+#include <nvblox_ros_common/check_cuda_errors.hpp>
+
+namespace nvblox
+{
+
+PadCropRegion getPadCropRegion(int in_width, int in_height, int out_width, int out_height)
+{
+  // Positive offsets crop the input, negative offsets pad it.
+  const int offset_x = (in_width - out_width) / 2;
+  const int offset_y = (in_height - out_height) / 2;
+  PadCropRegion region;
+  region.src_x = std::max(offset_x, 0);
+  region.src_y = std::max(offset_y, 0);
+  region.dst_x = std::max(-offset_x, 0);
+  region.dst_y = std::max(-offset_y, 0);
+  region.width = std::min(in_width - region.src_x, out_width - region.dst_x);
+  region.height = std::min(in_height - region.src_y, out_height - region.dst_y);
+  return region;
+}
+
+void padOrCropImageGpuAsync(
+  const void * src, size_t src_pitch_bytes, int in_width, int in_height,
+  void * dst, size_t dst_pitch_bytes, int out_width, int out_height,
+  size_t bytes_per_pixel, cudaStream_t cuda_stream)
+{
+  const PadCropRegion region = getPadCropRegion(in_width, in_height, out_width, out_height);
+
+  // Only clear the output if there is padding.
+  if (region.width < out_width || region.height < out_height) {
+    checkCudaErrors(
+      cudaMemset2DAsync(
+        dst, dst_pitch_bytes, 0, out_width * bytes_per_pixel, out_height,
+        cuda_stream));
+  }
+  if (region.width <= 0 || region.height <= 0) {
+    return;
+  }
+  const auto * src_start = static_cast<const unsigned char *>(src) +
+    region.src_y * src_pitch_bytes + region.src_x * bytes_per_pixel;
+  auto * dst_start = static_cast<unsigned char *>(dst) +
+    region.dst_y * dst_pitch_bytes + region.dst_x * bytes_per_pixel;
+  checkCudaErrors(
+    cudaMemcpy2DAsync(
+      dst_start, dst_pitch_bytes, src_start, src_pitch_bytes,
+      region.width * bytes_per_pixel, region.height, cudaMemcpyDeviceToDevice, cuda_stream));
+}
+
+}  // namespace nvblox
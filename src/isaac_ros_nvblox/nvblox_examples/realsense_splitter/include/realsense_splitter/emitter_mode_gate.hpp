@@ -0,0 +1,134 @@
+// SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+// Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef REALSENSE_SPLITTER__EMITTER_MODE_GATE_HPP_
+#define REALSENSE_SPLITTER__EMITTER_MODE_GATE_HPP_
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <optional>
+#include <string>
+#include <utility>
+
+namespace nvblox
+{
+
+/// Extract the "frame_emitter_mode" field from realsense json frame metadata.
+/// @return The emitter mode, or nullopt if the field is not present.
+inline std::optional<int> parseEmitterMode(const std::string & json_data)
+{
+  // Field name in json metadata
+  constexpr char frame_emitter_mode_str[] = "\"frame_emitter_mode\":";
+  constexpr size_t field_name_length =
+    sizeof(frame_emitter_mode_str) / sizeof(frame_emitter_mode_str[0]);
+  // Find the field
+  const size_t frame_emitter_mode_start_location = json_data.find(frame_emitter_mode_str);
+  if (frame_emitter_mode_start_location == json_data.npos) {
+    return std::nullopt;
+  }
+  // If it is found, parse the field.
+  const size_t field_location = frame_emitter_mode_start_location + field_name_length - 1;
+  if (field_location >= json_data.size()) {
+    return std::nullopt;
+  }
+  return static_cast<int>(json_data[field_location]) - static_cast<int>('0');
+}
+
+/// Forwards messages whose (exactly time-matched) frame metadata reports a given emitter mode.
+///
+/// This replaces a message_filters ExactTime synchronizer for the splitter, such that messages
+/// can be held as handles of any (e.g. type-adapted NITROS) type. Messages and emitter modes are
+/// matched by timestamp. Unmatched entries older than a match are dropped, and at most
+/// queue_size unmatched entries of each kind are kept.
+template<typename MessageHandle>
+class EmitterModeGate
+{
+public:
+  using Callback = std::function<void (const MessageHandle &)>;
+
+  EmitterModeGate(int forwarded_emitter_mode, size_t queue_size, Callback callback)
+  : forwarded_emitter_mode_(forwarded_emitter_mode),
+    queue_size_(queue_size),
+    callback_(std::move(callback)) {}
+
+  /// Add a message. It is forwarded (now or once its metadata arrives) if the emitter mode matches.
+  void addMessage(int64_t stamp_ns, MessageHandle message)
+  {
+    if (const std::optional<int> mode = popMatch(stamp_ns, &emitter_modes_)) {
+      forwardIfMode(*mode, message);
+    } else {
+      push(stamp_ns, std::move(message), &messages_);
+    }
+  }
+
+  /// Add the emitter mode of the frame with the given timestamp.
+  void addEmitterMode(int64_t stamp_ns, int emitter_mode)
+  {
+    if (std::optional<MessageHandle> message = popMatch(stamp_ns, &messages_)) {
+      forwardIfMode(emitter_mode, *message);
+    } else {
+      push(stamp_ns, emitter_mode, &emitter_modes_);
+    }
+  }
+
+private:
+  template<typename T>
+  using StampedQueue = std::deque<std::pair<int64_t, T>>;
+
+  void forwardIfMode(int emitter_mode, const MessageHandle & message)
+  {
+    if (emitter_mode == forwarded_emitter_mode_) {
+      callback_(message);
+    }
+  }
+
+  // Removes the entry with the given stamp and all older entries (which can no longer be matched
+  // as the streams are ordered). Returns the entry with the given stamp, if any.
+  template<typename T>
+  static std::optional<T> popMatch(int64_t stamp_ns, StampedQueue<T> * queue)
+  {
+    while (!queue->empty() && queue->front().first < stamp_ns) {
+      queue->pop_front();
+    }
+    if (queue->empty() || queue->front().first != stamp_ns) {
+      return std::nullopt;
+    }
+    std::optional<T> match(std::move(queue->front().second));
+    queue->pop_front();
+    return match;
+  }
+
+  template<typename T>
+  void push(int64_t stamp_ns, T value, StampedQueue<T> * queue) const
+  {
+    queue->emplace_back(stamp_ns, std::move(value));
+    while (queue->size() > queue_size_) {
+      queue->pop_front();
+    }
+  }
+
+  const int forwarded_emitter_mode_;
+  const size_t queue_size_;
+  Callback callback_;
+  StampedQueue<MessageHandle> messages_;
+  StampedQueue<int> emitter_modes_;
+};
+
+}  // namespace nvblox
+
+#endif  // REALSENSE_SPLITTER__EMITTER_MODE_GATE_HPP_
@@ -0,0 +1,79 @@
+// SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+// Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef REALSENSE_SPLITTER__NITROS_REALSENSE_SPLITTER_NODE_HPP_
+#define REALSENSE_SPLITTER__NITROS_REALSENSE_SPLITTER_NODE_HPP_
+
+#include <memory>
+#include <string>
+
+#include <rclcpp/rclcpp.hpp>
+#include <sensor_msgs/msg/point_cloud2.hpp>
+
+#include <isaac_ros_nitros_image_type/nitros_image.hpp>
+#include <realsense2_camera_msgs/msg/metadata.hpp>
+
+#include "realsense_splitter/emitter_mode_gate.hpp"
+
+namespace nvblox
+{
+
+/// Zero-copy variant of the RealsenseSplitterNode.
+///
+/// Images are received through type-adapted NITROS subscriptions and forwarded as NITROS handles,
+/// so (in a shared container) the full resolution frames are never serialized or copied by the
+/// splitter, and stay in GPU memory for NITROS consumers such as the nvblox node. Pointclouds
+/// are forwarded as regular ROS messages.
+class NitrosRealsenseSplitterNode : public rclcpp::Node
+{
+public:
+  explicit NitrosRealsenseSplitterNode(const rclcpp::NodeOptions & options);
+  virtual ~NitrosRealsenseSplitterNode() = default;
+
+private:
+  using NitrosImage = nvidia::isaac_ros::nitros::NitrosImage;
+  using NitrosImagePtr = std::shared_ptr<const NitrosImage>;
+  using PointCloudPtr = sensor_msgs::msg::PointCloud2::ConstSharedPtr;
+  using MetadataPtr = realsense2_camera_msgs::msg::Metadata::ConstSharedPtr;
+
+  // An input stream forwarded if the emitter has a certain mode.
+  template<typename MessageType>
+  struct GatedStream
+  {
+    std::unique_ptr<EmitterModeGate<std::shared_ptr<const MessageType>>> gate;
+    typename rclcpp::Subscription<MessageType>::SharedPtr sub;
+    rclcpp::Subscription<realsense2_camera_msgs::msg::Metadata>::SharedPtr metadata_sub;
+    typename rclcpp::Publisher<MessageType>::SharedPtr pub;
+  };
+
+  template<typename MessageType>
+  void createGatedStream(
+    const std::string & name, int emitter_mode, const rclcpp::QoS & input_qos,
+    const rclcpp::QoS & output_qos, GatedStream<MessageType> * stream);
+
+  // Extract the emitter metadata mode. Warns and returns kUnknown if it is not present.
+  int getEmitterModeFromMetadataMsg(const MetadataPtr & metadata);
+
+  GatedStream<NitrosImage> infra_1_;
+  GatedStream<NitrosImage> infra_2_;
+  GatedStream<NitrosImage> depth_;
+  GatedStream<sensor_msgs::msg::PointCloud2> pointcloud_;
+};
+
+}  // namespace nvblox
+
+#endif  // REALSENSE_SPLITTER__NITROS_REALSENSE_SPLITTER_NODE_HPP_
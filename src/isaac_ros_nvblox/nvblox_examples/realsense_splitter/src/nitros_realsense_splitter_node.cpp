@@ -0,0 +1,130 @@
+// SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+// Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "realsense_splitter/nitros_realsense_splitter_node.hpp"
+
+#include <optional>
+#include <string>
+
+#include <isaac_ros_common/qos.hpp>
+#include <isaac_ros_nitros_image_type/nitros_image_view.hpp>
+
+#include "realsense_splitter/realsense_splitter_node.hpp"
+
+namespace nvblox
+{
+
+namespace
+{
+
+int64_t stampToNanoseconds(int64_t sec, int64_t nanosec)
+{
+  constexpr int64_t kNanosecondsPerSecond = 1000000000;
+  return sec * kNanosecondsPerSecond + nanosec;
+}
+
+int64_t getStampNs(const nvidia::isaac_ros::nitros::NitrosImage & image)
+{
+  const nvidia::isaac_ros::nitros::NitrosImageView view(image);
+  return stampToNanoseconds(view.GetTimestampSeconds(), view.GetTimestampNanoseconds());
+}
+
+int64_t getStampNs(const sensor_msgs::msg::PointCloud2 & pointcloud)
+{
+  return stampToNanoseconds(pointcloud.header.stamp.sec, pointcloud.header.stamp.nanosec);
+}
+
+}  // namespace
+
+using EmitterMode = RealsenseSplitterNode::EmitterMode;
+
+NitrosRealsenseSplitterNode::NitrosRealsenseSplitterNode(const rclcpp::NodeOptions & options)
+: Node("realsense_splitter_node", options)
+{
+  RCLCPP_INFO(get_logger(), "Creating a NitrosRealsenseSplitterNode().");
+
+  // Subscriber/Publisher parameters
+  const std::string kDefaultQoS = "SYSTEM_DEFAULT";
+  constexpr size_t kInputQueueSize = 10;
+  constexpr size_t kOutputQueueSize = 10;
+
+  const rclcpp::QoS input_qos = isaac_ros::common::AddQosParameter(*this, kDefaultQoS, "input_qos")
+    .keep_last(kInputQueueSize);
+  const rclcpp::QoS output_qos =
+    isaac_ros::common::AddQosParameter(*this, kDefaultQoS, "output_qos")
+    .keep_last(kOutputQueueSize);
+
+  // Same topics as the RealsenseSplitterNode.
+  createGatedStream(
+    "infra_1", static_cast<int>(EmitterMode::kOff), input_qos, output_qos,
+    &infra_1_);
+  createGatedStream(
+    "infra_2", static_cast<int>(EmitterMode::kOff), input_qos, output_qos,
+    &infra_2_);
+  createGatedStream("depth", static_cast<int>(EmitterMode::kOn), input_qos, output_qos, &depth_);
+  createGatedStream(
+    "pointcloud", static_cast<int>(EmitterMode::kOn), input_qos, output_qos,
+    &pointcloud_);
+}
+
+template<typename MessageType>
+void NitrosRealsenseSplitterNode::createGatedStream(
+  const std::string & name, int emitter_mode, const rclcpp::QoS & input_qos,
+  const rclcpp::QoS & output_qos, GatedStream<MessageType> * stream)
+{
+  constexpr size_t kGateQueueSize = 10;
+  stream->pub = create_publisher<MessageType>("~/output/" + name, output_qos);
+  // Forwarding the handle neither copies nor serializes the message.
+  stream->gate = std::make_unique<EmitterModeGate<std::shared_ptr<const MessageType>>>(
+    emitter_mode, kGateQueueSize,
+    [publisher = stream->pub](const std::shared_ptr<const MessageType> & message) {
+      publisher->publish(*message);
+    });
+  stream->sub = create_subscription<MessageType>(
+    "input/" + name, input_qos,
+    [gate = stream->gate.get()](std::shared_ptr<const MessageType> message) {
+      const int64_t stamp_ns = getStampNs(*message);
+      gate->addMessage(stamp_ns, std::move(message));
+    });
+  stream->metadata_sub = create_subscription<realsense2_camera_msgs::msg::Metadata>(
+    "input/" + name + "_metadata", input_qos,
+    [this, gate = stream->gate.get()](const MetadataPtr metadata) {
+      gate->addEmitterMode(
+        stampToNanoseconds(metadata->header.stamp.sec, metadata->header.stamp.nanosec),
+        getEmitterModeFromMetadataMsg(metadata));
+    });
+}
+
+int NitrosRealsenseSplitterNode::getEmitterModeFromMetadataMsg(const MetadataPtr & metadata)
+{
+  const std::optional<int> emitter_mode = parseEmitterMode(metadata->json_data);
+  if (!emitter_mode) {
+    constexpr int kPublishPeriodMs = 1000;
+    auto & clk = *get_clock();
+    RCLCPP_WARN_THROTTLE(
+      get_logger(), clk, kPublishPeriodMs,
+      "Realsense frame metadata did not contain \"frame_emitter_mode\". Splitter will not work.");
+    return static_cast<int>(EmitterMode::kUnknown);
+  }
+  return *emitter_mode;
+}
+
+}  // namespace nvblox
+
+// Register the node as a component
+#include "rclcpp_components/register_node_macro.hpp"
+RCLCPP_COMPONENTS_REGISTER_NODE(nvblox::NitrosRealsenseSplitterNode)
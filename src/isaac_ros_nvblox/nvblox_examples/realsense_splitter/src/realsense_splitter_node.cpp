@@ -17,8 +17,12 @@
 
 #include "realsense_splitter/realsense_splitter_node.hpp"
 
+#include <optional>
+
 #include <isaac_ros_common/qos.hpp>
 
+#include "realsense_splitter/emitter_mode_gate.hpp"
+
 namespace nvblox
 {
 
@@ -89,14 +93,9 @@ RealsenseSplitterNode::RealsenseSplitterNode(const rclcpp::NodeOptions & options
 int RealsenseSplitterNode::getEmitterModeFromMetadataMsg(
   const realsense2_camera_msgs::msg::Metadata::ConstSharedPtr & metadata)
 {
-  // Field name in json metadata
-  constexpr char frame_emitter_mode_str[] = "\"frame_emitter_mode\":";
-  constexpr size_t field_name_length =
-    sizeof(frame_emitter_mode_str) / sizeof(frame_emitter_mode_str[0]);
-  // Find the field
-  const size_t frame_emitter_mode_start_location = metadata->json_data.find(frame_emitter_mode_str);
+  const std::optional<int> emitter_mode = parseEmitterMode(metadata->json_data);
   // If the emitter mode is not found, return unknown and warn the user.
-  if (frame_emitter_mode_start_location == metadata->json_data.npos) {
+  if (!emitter_mode) {
     constexpr int kPublishPeriodMs = 1000;
     auto & clk = *get_clock();
     RCLCPP_WARN_THROTTLE(
@@ -104,11 +103,7 @@ int RealsenseSplitterNode::getEmitterModeFromMetadataMsg(
       "Realsense frame metadata did not contain \"frame_emitter_mode\". Splitter will not work.");
     return static_cast<int>(EmitterMode::kUnknown);
   }
-  // If it is found, parse the field.
-  const size_t field_location = frame_emitter_mode_start_location + field_name_length - 1;
-  const int emitter_mode =
-    static_cast<int>(metadata->json_data[field_location]) - static_cast<int>('0');
-  return emitter_mode;
+  return *emitter_mode;
 }
 
 template<typename MessageType>
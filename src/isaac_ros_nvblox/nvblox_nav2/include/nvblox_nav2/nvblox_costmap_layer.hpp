@@ -21,14 +21,19 @@
 #include <Eigen/Core>
 #include <Eigen/Geometry>
 #include <tf2_ros/transform_listener.h>
+#include <algorithm>
 #include <string>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
 #include <nav2_costmap_2d/costmap_layer.hpp>
 #include <nav2_costmap_2d/layer.hpp>
 #include <nav2_costmap_2d/layered_costmap.hpp>
 #include <rclcpp/rclcpp.hpp>
 
 #include <nvblox_msgs/msg/distance_map_slice.hpp>
+#include <nvblox_msgs/msg/distance_map_slice_update.hpp>
 
 namespace nvblox
 {
@@ -49,14 +54,67 @@ public:
     nav2_costmap_2d::Costmap2D & master_grid, int min_i,
     int min_j, int max_i, int max_j) override;
 
+  // Resizes the layer to the master grid, which clears it.
+  void matchSize() override;
+
   void reset() override {}
   bool isClearable() override {return true;}
 
   void sliceCallback(
     const nvblox_msgs::msg::DistanceMapSlice::ConstSharedPtr slice);
 
+  // Applies a partial update in place to the last received slice.
+  void sliceUpdateCallback(
+    const nvblox_msgs::msg::DistanceMapSliceUpdate::ConstSharedPtr slice_update);
+
 private:
-  bool lookupInSlice(const Eigen::Vector2f & pos, float * distance);
+  // A half-open, axis-aligned window of cells [min_x, max_x) x [min_y, max_y).
+  struct CellWindow
+  {
+    int min_x = 0;
+    int min_y = 0;
+    int max_x = 0;
+    int max_y = 0;
+
+    bool empty() const {return min_x >= max_x || min_y >= max_y;}
+    bool contains(const CellWindow & other) const
+    {
+      return other.min_x >= min_x && other.min_y >= min_y && other.max_x <= max_x &&
+             other.max_y <= max_y;
+    }
+    CellWindow intersection(const CellWindow & other) const
+    {
+      return {std::max(min_x, other.min_x), std::max(min_y, other.min_y),
+        std::min(max_x, other.max_x), std::min(max_y, other.max_y)};
+    }
+    CellWindow merged(const CellWindow & other) const
+    {
+      return {std::min(min_x, other.min_x), std::min(min_y, other.min_y),
+        std::max(max_x, other.max_x), std::max(max_y, other.max_y)};
+    }
+  };
+
+  // Converts a distance in the slice to a nav2 cost.
+  uint8_t distanceToCost(float distance, float unknown_value) const;
+
+  // Recomputes the slice cell costs within the window and adds the cells
+  // whose cost changed to the dirty slice window.
+  void updateSliceCosts(const CellWindow & slice_window);
+
+  // Recomputes the layer's costs within a window of costmap cells.
+  void computeCosts(const CellWindow & costmap_window);
+
+  // Returns the (conservative) window of costmap cells which look up a cell
+  // inside the given window of slice cells.
+  CellWindow sliceWindowToCostmapWindow(const CellWindow & slice_window) const;
+
+  // Updates the transform from the slice to the nav2 costmap global frame.
+  // Returns false if the transform is unchanged.
+  bool setSliceTransform(const Eigen::Isometry2f & T_G_S);
+
+  // Makes the layer match the geometry of the master grid, moving rather than
+  // clearing the layer if only the origin changed.
+  void matchMasterGeometry();
 
   // Settings
   bool convert_to_binary_costmap_ = false;
@@ -64,13 +122,36 @@ private:
   float inflation_distance_ = 0.5f;
   // This should not include any "special" values like 255.
   uint8_t max_cost_value_ = 252;
+  // Whether to receive slices intra-process when nvblox runs in the same process.
+  bool use_intra_process_comms_ = true;
 
   // Subscribers
   rclcpp::Subscription<nvblox_msgs::msg::DistanceMapSlice>::SharedPtr
     slice_sub_;
+  rclcpp::Subscription<nvblox_msgs::msg::DistanceMapSliceUpdate>::SharedPtr
+    slice_update_sub_;
 
   // State
+  // Guards the slice state against the concurrent costmap update thread.
+  std::mutex slice_mutex_;
+
+  // The last slice. This is the received message itself until the first update arrives.
   nvblox_msgs::msg::DistanceMapSlice::ConstSharedPtr slice_;
+  // A copy of the last slice, made on the first update such that updates can be applied in
+  // place. Null until then. When set, slice_ points to it.
+  std::shared_ptr<nvblox_msgs::msg::DistanceMapSlice> mutable_slice_;
+
+  // The cost of every cell of the slice, computed once when the slice (or an
+  // update to it) arrives rather than for every costmap cell in updateCosts().
+  std::vector<uint8_t> slice_costs_;
+
+  // Slice cells whose cost changed since the last updateCosts().
+  std::optional<CellWindow> dirty_slice_window_;
+
+  // The costmap cells of this layer which are up to date with slice_costs_.
+  // Cells outside of this window are recomputed when requested.
+  CellWindow valid_costmap_window_;
+  bool all_costs_dirty_ = true;
 
   // Global frame of the nav2 costmap.
   // This should match with the global_frame of the corresponding global_costmap/local_costmap.
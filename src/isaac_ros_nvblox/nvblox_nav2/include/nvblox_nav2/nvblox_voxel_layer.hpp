@@ -0,0 +1,102 @@
+// SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+// Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+#ifndef NVBLOX_NAV2__NVBLOX_VOXEL_LAYER_HPP_
+#define NVBLOX_NAV2__NVBLOX_VOXEL_LAYER_HPP_
+
+#include <mutex>
+#include <string>
+#include <nav2_costmap_2d/costmap_layer.hpp>
+#include <nav2_costmap_2d/layer.hpp>
+#include <nav2_costmap_2d/layered_costmap.hpp>
+#include <nav2_msgs/msg/voxel_grid.hpp>
+#include <rclcpp/rclcpp.hpp>
+#include <rclcpp_lifecycle/lifecycle_publisher.hpp>
+
+#include <nvblox_msgs/msg/voxel_state_grid.hpp>
+
+namespace nvblox
+{
+namespace nav2
+{
+
+// A costmap layer fed with the 3D voxel state grids generated by nvblox on the GPU.
+//
+// This replaces nav2's VoxelLayer for 3D-aware planners: the occupied, free and unknown voxels
+// come from the nvblox map, such that nav2 doesn't raytrace the depth data a second time. As in
+// the VoxelLayer, a column is lethal if more than mark_threshold voxels between
+// min_obstacle_height and max_obstacle_height are occupied, and the grid can be republished as
+// a nav2_msgs/VoxelGrid for consumers of the VoxelLayer's grid.
+//
+// The grid must be published in the global frame of the costmap.
+class NvbloxVoxelLayer : public nav2_costmap_2d::CostmapLayer
+{
+public:
+  NvbloxVoxelLayer();
+
+  void onInitialize() override;
+  void activate() override;
+  void deactivate() override;
+  void updateBounds(
+    double robot_x, double robot_y, double robot_yaw,
+    double * min_x, double * min_y, double * max_x,
+    double * max_y) override;
+  void updateCosts(
+    nav2_costmap_2d::Costmap2D & master_grid, int min_i,
+    int min_j, int max_i, int max_j) override;
+
+  void reset() override {}
+  bool isClearable() override {return true;}
+
+  void voxelGridCallback(
+    const nvblox_msgs::msg::VoxelStateGrid::ConstSharedPtr voxel_grid);
+
+private:
+  // The mask of the voxels of a column of the grid between the obstacle heights.
+  uint32_t obstacleHeightMask(const nvblox_msgs::msg::VoxelStateGrid & voxel_grid) const;
+
+  // Converts a column of the grid to a nav2 cost.
+  uint8_t columnCost(uint32_t occupied_bits, uint32_t unknown_bits) const;
+
+  // Republishes the grid in the format of the VoxelLayer.
+  void publishVoxelMap(const nvblox_msgs::msg::VoxelStateGrid & voxel_grid);
+
+  // Settings
+  float min_obstacle_height_ = 0.0f;
+  float max_obstacle_height_ = 2.0f;
+  int mark_threshold_ = 0;
+  bool publish_voxel_map_ = false;
+  // Whether to receive grids intra-process when nvblox runs in the same process.
+  bool use_intra_process_comms_ = true;
+
+  // Global frame of the nav2 costmap.
+  std::string nav2_costmap_global_frame_ = "odom";
+
+  rclcpp::Subscription<nvblox_msgs::msg::VoxelStateGrid>::SharedPtr voxel_grid_sub_;
+  rclcpp_lifecycle::LifecyclePublisher<nav2_msgs::msg::VoxelGrid>::SharedPtr voxel_map_pub_;
+
+  // State
+  // Guards the grid against the concurrent costmap update thread.
+  std::mutex voxel_grid_mutex_;
+  // The last grid, and the mask of its voxels between the obstacle heights.
+  nvblox_msgs::msg::VoxelStateGrid::ConstSharedPtr voxel_grid_;
+  uint32_t obstacle_height_mask_ = 0;
+};
+
+}  // namespace nav2
+}  // namespace nvblox
+
+#endif  // NVBLOX_NAV2__NVBLOX_VOXEL_LAYER_HPP_
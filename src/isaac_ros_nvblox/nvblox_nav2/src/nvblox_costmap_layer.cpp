@@ -17,6 +17,9 @@
 
 #include "nvblox_nav2/nvblox_costmap_layer.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <memory>
 #include <string>
 
 #include <nav2_costmap_2d/costmap_math.hpp>
@@ -55,6 +58,13 @@ void NvbloxCostmapLayer::onInitialize()
   max_cost_value_ =
     node->declare_parameter<uint8_t>(getFullName("max_cost_value"), max_cost_value_);
 
+  // Partial updates are published next to the full slices.
+  std::string nvblox_map_slice_update_topic = nvblox_map_slice_topic + "_updates";
+  nvblox_map_slice_update_topic = node->declare_parameter<std::string>(
+    getFullName("nvblox_map_slice_update_topic"), nvblox_map_slice_update_topic);
+  use_intra_process_comms_ = node->declare_parameter<bool>(
+    getFullName("use_intra_process_comms"), use_intra_process_comms_);
+
   RCLCPP_INFO_STREAM(
     node->get_logger(),
     "Name: " << name_ << " Topic name: " << nvblox_map_slice_topic
@@ -62,9 +72,26 @@ void NvbloxCostmapLayer::onInitialize()
              << " Max obstacle distance: " << max_obstacle_distance_);
 
   // Add subscribers to the nvblox message.
+  // When nvblox runs in the same process (e.g. the same component container) and publishes
+  // intra-process too, slices are passed by pointer rather than serialized.
+  rclcpp::SubscriptionOptions subscription_options;
+  subscription_options.use_intra_process_comm =
+    use_intra_process_comms_ ? rclcpp::IntraProcessSetting::Enable :
+    rclcpp::IntraProcessSetting::NodeDefault;
   slice_sub_ = node->create_subscription<nvblox_msgs::msg::DistanceMapSlice>(
     nvblox_map_slice_topic, 1,
-    std::bind(&NvbloxCostmapLayer::sliceCallback, this, std::placeholders::_1));
+    std::bind(&NvbloxCostmapLayer::sliceCallback, this, std::placeholders::_1),
+    subscription_options);
+  // Updates must not be dropped, as each one only covers the cells changed since the last.
+  constexpr size_t kSliceUpdateQueueSize = 10;
+  slice_update_sub_ = node->create_subscription<nvblox_msgs::msg::DistanceMapSliceUpdate>(
+    nvblox_map_slice_update_topic, kSliceUpdateQueueSize,
+    std::bind(&NvbloxCostmapLayer::sliceUpdateCallback, this, std::placeholders::_1),
+    subscription_options);
+
+  // Cells which are not covered by a slice have no information. Note that this
+  // is also the value cells are reset to when the layer is resized or moved.
+  setDefaultValue(nav2_costmap_2d::NO_INFORMATION);
 
   // Init transform and listener.
   T_G_S_ = Eigen::Isometry2f::Identity();
@@ -84,6 +111,7 @@ void NvbloxCostmapLayer::updateBounds(
   // upstream controller.
   // According to nav2 the bounds can only grow bigger. So we only update the
   // bounds if it grows bigger or we keep the old values
+  std::lock_guard<std::mutex> lock(slice_mutex_);
   if (slice_ != nullptr) {
     double current_plugin_min_x = slice_->origin.x;
     double current_plugin_min_y = slice_->origin.y;
@@ -154,65 +182,25 @@ void NvbloxCostmapLayer::updateCosts(
   RCLCPP_DEBUG(
     node->get_logger(), "Update costs: Min i: %d Min j: %d Max i: %d Max j: %d", min_i,
     min_j, max_i, max_j);
-  // Copy over the relevant values to the internal costmap.
-  // We need to convert from meters to cell units.
-  // We'll just directly write to the costmap layer.
-  setDefaultValue(nav2_costmap_2d::NO_INFORMATION);
-  matchSize();
-  uint8_t * costmap_array = getCharMap();
-  unsigned int size_x = getSizeInCellsX(), size_y = getSizeInCellsY();
-
-  RCLCPP_DEBUG(node->get_logger(), "Size in cells x: %d size in cells y: %d", size_x, size_y);
-
-  for (int j = min_j; j < max_j; j++) {
-    for (int i = min_i; i < max_i; i++) {
-      int index = getIndex(i, j);
-
-      // Figure out the world coordinates of this gridcell.
-      double world_x, world_y;
-      mapToWorld(i, j, world_x, world_y);
-
-      // Transform the pose from nav2 costmap global frame to the slice frame.
-      Eigen::Vector2f pos_G(world_x, world_y);
-      Eigen::Vector2f pos_S = T_G_S_.inverse() * pos_G;
-
-      // Look up the corresponding cell in our latest slice.
-      float distance = 0.0f;
-      bool valid = lookupInSlice(Eigen::Vector2f(pos_S.x(), pos_S.y()), &distance);
-
-      // Convert the distance value to a costmap value if valid.
-      uint8_t cost = nav2_costmap_2d::NO_INFORMATION;
-      if (valid) {
-        if (distance <= 0.0f) {
-          // Inside obstacle. Never go here.
-          cost = nav2_costmap_2d::LETHAL_OBSTACLE;
-        } else {
-          if (convert_to_binary_costmap_) {
-            // If convert_to_binary_costmap is enabled,
-            // we only distinguish between lethal obstacle and free space.
-            cost = nav2_costmap_2d::FREE_SPACE;
-          } else {
-            // If convert_to_binary_costmap is disabled,
-            // we distinguish between lethal obstacle, inflation layer, interpolation layer and
-            // free space.
-            if (distance < inflation_distance_) {
-              cost = nav2_costmap_2d::INSCRIBED_INFLATED_OBSTACLE;
-            } else if (distance > max_obstacle_distance_) {
-              cost = nav2_costmap_2d::FREE_SPACE;
-            } else {
-              // Interpolate between inflation layer and free space.
-              cost = static_cast<uint8_t>(
-                max_cost_value_ *
-                (1.0f - std::min<float>(
-                  (distance - inflation_distance_) / max_obstacle_distance_,
-                  1.0f)));
-            }
-          }
-        }
-      }
-      costmap_array[index] = cost;
-    }
+
+  // The costs computed in earlier calls are kept in the layer's own costmap,
+  // such that only cells affected by a changed slice have to be recomputed.
+  std::lock_guard<std::mutex> lock(slice_mutex_);
+  matchMasterGeometry();
+
+  const CellWindow window{min_i, min_j, max_i, max_j};
+  if (all_costs_dirty_ || !valid_costmap_window_.contains(window)) {
+    // Recompute everything we've been asked for.
+    computeCosts(window);
+    valid_costmap_window_ = window;
+  } else if (dirty_slice_window_) {
+    // Only recompute the cells that look up a changed slice cell. The whole
+    // valid window is kept up to date, not just the requested window.
+    computeCosts(
+      valid_costmap_window_.intersection(sliceWindowToCostmapWindow(*dirty_slice_window_)));
   }
+  all_costs_dirty_ = false;
+  dirty_slice_window_.reset();
 
   // This combines the master costmap with the current costmap by taking
   // the max across all costmaps.
@@ -235,6 +223,7 @@ void NvbloxCostmapLayer::sliceCallback(
 
   // If the slice frame is not equal to the nav2 costmap global frame,
   // we listen for the transform.
+  Eigen::Isometry2f T_G_S = Eigen::Isometry2f::Identity();
   std::string slice_frame = slice->header.frame_id;
   if (nav2_costmap_global_frame_ != slice_frame) {
     rclcpp::Time timestamp = slice->header.stamp;
@@ -285,46 +274,263 @@ void NvbloxCostmapLayer::sliceCallback(
     }
 
     // Update the 2d transform
-    T_G_S_ =
+    T_G_S =
       Eigen::Isometry2f(
       Eigen::Translation2f(T_G_S_msg.translation.x, T_G_S_msg.translation.y) *
       Eigen::Rotation2Df(azimuth_angle_rad));
   }
 
   RCLCPP_DEBUG(node->get_logger(), "Slice callback.");
+  std::lock_guard<std::mutex> lock(slice_mutex_);
+  if (setSliceTransform(T_G_S)) {
+    all_costs_dirty_ = true;
+  }
+
+  // If the new slice covers the same cells as the last one, only the cells
+  // whose cost changed have to be recomputed in the costmap.
+  const bool same_geometry = slice_ != nullptr &&
+    slice_->header.frame_id == slice->header.frame_id &&
+    slice_->width == slice->width && slice_->height == slice->height &&
+    slice_->resolution == slice->resolution && slice_->origin.x == slice->origin.x &&
+    slice_->origin.y == slice->origin.y && slice_->unknown_value == slice->unknown_value;
+  // Hold on to the (possibly shared, intra-process) message itself. It's only copied once an
+  // update has to be applied to it.
   slice_ = slice;
+  mutable_slice_.reset();
+  if (!same_geometry) {
+    slice_costs_.assign(
+      static_cast<size_t>(slice_->width) * slice_->height, nav2_costmap_2d::NO_INFORMATION);
+    all_costs_dirty_ = true;
+  }
+  updateSliceCosts(
+    {0, 0, static_cast<int>(slice_->width), static_cast<int>(slice_->height)});
+}
+
+void NvbloxCostmapLayer::sliceUpdateCallback(
+  const nvblox_msgs::msg::DistanceMapSliceUpdate::ConstSharedPtr slice_update)
+{
+  if (!enabled_) {
+    return;
+  }
+
+  auto node = node_.lock();
+  if (!node) {
+    throw std::runtime_error{"Failed to lock node"};
+  }
+
+  std::lock_guard<std::mutex> lock(slice_mutex_);
+  if (slice_ == nullptr) {
+    return;
+  }
+
+  // The update has to fit into the slice it was computed against.
+  if (slice_update->header.frame_id != slice_->header.frame_id ||
+    slice_update->x + slice_update->width > slice_->width ||
+    slice_update->y + slice_update->height > slice_->height ||
+    slice_update->data.size() != static_cast<size_t>(slice_update->width) * slice_update->height)
+  {
+    constexpr int kWarnMessagePeriodMs = 1000;
+    RCLCPP_WARN_STREAM_THROTTLE(
+      node->get_logger(), *node->get_clock(), kWarnMessagePeriodMs,
+      "[NvbloxCostmapLayer] Dropping a slice update which doesn't match the last slice.");
+    return;
+  }
+
+  RCLCPP_DEBUG(node->get_logger(), "Slice update callback.");
+  if (mutable_slice_ == nullptr) {
+    mutable_slice_ = std::make_shared<nvblox_msgs::msg::DistanceMapSlice>(*slice_);
+    slice_ = mutable_slice_;
+  }
+  for (uint32_t row = 0; row < slice_update->height; row++) {
+    const auto update_row_start = slice_update->data.begin() + row * slice_update->width;
+    std::copy(
+      update_row_start, update_row_start + slice_update->width,
+      mutable_slice_->data.begin() + (slice_update->y + row) * slice_->width + slice_update->x);
+  }
+  mutable_slice_->header.stamp = slice_update->header.stamp;
+  updateSliceCosts(
+    {static_cast<int>(slice_update->x), static_cast<int>(slice_update->y),
+      static_cast<int>(slice_update->x + slice_update->width),
+      static_cast<int>(slice_update->y + slice_update->height)});
+}
+
+uint8_t NvbloxCostmapLayer::distanceToCost(float distance, float unknown_value) const
+{
+  // The value can still be allocated but unknown. Handle this case too.
+  if (distance == unknown_value) {
+    return nav2_costmap_2d::NO_INFORMATION;
+  }
+  if (distance <= 0.0f) {
+    // Inside obstacle. Never go here.
+    return nav2_costmap_2d::LETHAL_OBSTACLE;
+  }
+  if (convert_to_binary_costmap_) {
+    // If convert_to_binary_costmap is enabled,
+    // we only distinguish between lethal obstacle and free space.
+    return nav2_costmap_2d::FREE_SPACE;
+  }
+  // If convert_to_binary_costmap is disabled,
+  // we distinguish between lethal obstacle, inflation layer, interpolation layer and
+  // free space.
+  if (distance < inflation_distance_) {
+    return nav2_costmap_2d::INSCRIBED_INFLATED_OBSTACLE;
+  }
+  if (distance > max_obstacle_distance_) {
+    return nav2_costmap_2d::FREE_SPACE;
+  }
+  // Interpolate between inflation layer and free space.
+  return static_cast<uint8_t>(
+    max_cost_value_ *
+    (1.0f - std::min<float>((distance - inflation_distance_) / max_obstacle_distance_, 1.0f)));
 }
 
-bool NvbloxCostmapLayer::lookupInSlice(const Eigen::Vector2f & pos, float * distance)
+void NvbloxCostmapLayer::updateSliceCosts(const CellWindow & slice_window)
 {
+  CellWindow changed_window{slice_window.max_x, slice_window.max_y, slice_window.min_x,
+    slice_window.min_y};
+  for (int y = slice_window.min_y; y < slice_window.max_y; y++) {
+    const size_t row_start = static_cast<size_t>(y) * slice_->width;
+    for (int x = slice_window.min_x; x < slice_window.max_x; x++) {
+      const uint8_t cost = distanceToCost(slice_->data[row_start + x], slice_->unknown_value);
+      if (cost != slice_costs_[row_start + x]) {
+        slice_costs_[row_start + x] = cost;
+        changed_window = changed_window.merged({x, y, x + 1, y + 1});
+      }
+    }
+  }
+  if (changed_window.empty()) {
+    return;
+  }
+  dirty_slice_window_ =
+    dirty_slice_window_ ? dirty_slice_window_->merged(changed_window) : changed_window;
+}
+
+void NvbloxCostmapLayer::computeCosts(const CellWindow & costmap_window)
+{
+  if (costmap_window.empty()) {
+    return;
+  }
+  uint8_t * costmap_array = getCharMap();
+
   // If we don't have any slice, we don't have any costs. :(
   if (slice_ == nullptr) {
-    return false;
+    for (int j = costmap_window.min_y; j < costmap_window.max_y; j++) {
+      std::fill_n(
+        costmap_array + getIndex(costmap_window.min_x, j),
+        costmap_window.max_x - costmap_window.min_x, nav2_costmap_2d::NO_INFORMATION);
+    }
+    return;
   }
 
-  // Else look up in the actual slice.
-  Eigen::Vector2f scaled_position =
-    (pos - Eigen::Vector2f(slice_->origin.x, slice_->origin.y)) / slice_->resolution;
-  Eigen::Vector2i pos_index = scaled_position.array().round().cast<int>();
+  // The slice cell looked up by costmap cell (i, j) is an affine function of
+  // (i, j). So rather than transforming each cell center separately, we
+  // compute the (continuous) slice cell coordinates of cell (0, 0) and the
+  // steps per cell in i and j once, and walk the rows incrementally.
+  const Eigen::Isometry2f T_S_G = T_G_S_.inverse();
+  const float slice_cells_per_meter = 1.0f / slice_->resolution;
+  const Eigen::Vector2f slice_origin(slice_->origin.x, slice_->origin.y);
+  const Eigen::Vector2f first_cell_center_G(
+    origin_x_ + 0.5 * resolution_, origin_y_ + 0.5 * resolution_);
+  const Eigen::Vector2f first_cell_S =
+    (T_S_G * first_cell_center_G - slice_origin) * slice_cells_per_meter;
+  const Eigen::Vector2f step_i_S =
+    T_S_G.linear().col(0) * static_cast<float>(resolution_) * slice_cells_per_meter;
+  const Eigen::Vector2f step_j_S =
+    T_S_G.linear().col(1) * static_cast<float>(resolution_) * slice_cells_per_meter;
+
+  const int slice_width = static_cast<int>(slice_->width);
+  const int slice_height = static_cast<int>(slice_->height);
+  for (int j = costmap_window.min_y; j < costmap_window.max_y; j++) {
+    // Start every row from the exact position to avoid accumulating drift
+    // across rows.
+    Eigen::Vector2f cell_S =
+      first_cell_S + static_cast<float>(costmap_window.min_x) * step_i_S +
+      static_cast<float>(j) * step_j_S;
+    uint8_t * costmap_row = costmap_array + getIndex(costmap_window.min_x, j);
+    for (int i = costmap_window.min_x; i < costmap_window.max_x; i++) {
+      const int x = static_cast<int>(std::lround(cell_S.x()));
+      const int y = static_cast<int>(std::lround(cell_S.y()));
+      *costmap_row++ = (x >= 0 && x < slice_width && y >= 0 && y < slice_height) ?
+        slice_costs_[static_cast<size_t>(y) * slice_width + x] :
+        nav2_costmap_2d::NO_INFORMATION;
+      cell_S += step_i_S;
+    }
+  }
+}
 
-  if (pos_index.x() < 0 || pos_index.x() >= static_cast<int>(slice_->width) || pos_index.y() < 0 ||
-    pos_index.y() >= static_cast<int>(slice_->height))
-  {
+NvbloxCostmapLayer::CellWindow NvbloxCostmapLayer::sliceWindowToCostmapWindow(
+  const CellWindow & slice_window) const
+{
+  // A slice cell covers all positions which round to its index, i.e. it
+  // extends half a cell to either side of its center.
+  const float min_x_S = slice_->origin.x + (slice_window.min_x - 0.5f) * slice_->resolution;
+  const float min_y_S = slice_->origin.y + (slice_window.min_y - 0.5f) * slice_->resolution;
+  const float max_x_S = slice_->origin.x + (slice_window.max_x - 0.5f) * slice_->resolution;
+  const float max_y_S = slice_->origin.y + (slice_window.max_y - 0.5f) * slice_->resolution;
+  Eigen::Matrix<float, 2, 4> corners_S;
+  corners_S << min_x_S, min_x_S, max_x_S, max_x_S, min_y_S, max_y_S, min_y_S, max_y_S;
+  const Eigen::Matrix<float, 2, 4> corners_G = (T_G_S_ * corners_S.colwise().homogeneous());
+
+  // Pad by a cell to stay conservative with respect to rounding.
+  const auto to_cell = [this](float position, double origin) {
+      return static_cast<int>(std::floor((position - origin) / resolution_));
+    };
+  const CellWindow window{to_cell(corners_G.row(0).minCoeff(), origin_x_) - 1,
+    to_cell(corners_G.row(1).minCoeff(), origin_y_) - 1,
+    to_cell(corners_G.row(0).maxCoeff(), origin_x_) + 2,
+    to_cell(corners_G.row(1).maxCoeff(), origin_y_) + 2};
+  return window.intersection(
+    {0, 0, static_cast<int>(getSizeInCellsX()), static_cast<int>(getSizeInCellsY())});
+}
+
+bool NvbloxCostmapLayer::setSliceTransform(const Eigen::Isometry2f & T_G_S)
+{
+  if (T_G_S.matrix() == T_G_S_.matrix()) {
     return false;
   }
+  T_G_S_ = T_G_S;
+  return true;
+}
 
-  size_t linear_index = pos_index.y() * slice_->width + pos_index.x();
+void NvbloxCostmapLayer::matchSize()
+{
+  // Resizing clears the layer, so all costs have to be recomputed.
+  CostmapLayer::matchSize();
+  all_costs_dirty_ = true;
+}
 
-  if (linear_index >= slice_->width * slice_->height) {
-    return false;
+void NvbloxCostmapLayer::matchMasterGeometry()
+{
+  const nav2_costmap_2d::Costmap2D * master = layered_costmap_->getCostmap();
+  if (getSizeInCellsX() != master->getSizeInCellsX() ||
+    getSizeInCellsY() != master->getSizeInCellsY() ||
+    getResolution() != master->getResolution())
+  {
+    matchSize();
+    return;
+  }
+  if (getOriginX() == master->getOriginX() && getOriginY() == master->getOriginY()) {
+    return;
   }
 
-  *distance = slice_->data[linear_index];
-  // The value can still be allocated but unknown. Handle this case too.
-  if (*distance != slice_->unknown_value) {
-    return true;
+  // The master grid moved (rolling window). Move the layer along, which keeps
+  // the overlapping cells, and shift the window of valid cells accordingly.
+  const double previous_origin_x = getOriginX();
+  const double previous_origin_y = getOriginY();
+  updateOrigin(master->getOriginX(), master->getOriginY());
+  if (getOriginX() != master->getOriginX() || getOriginY() != master->getOriginY()) {
+    // The origins are not a whole number of cells apart.
+    matchSize();
+    return;
   }
-  return false;
+  const int shift_x =
+    static_cast<int>(std::lround((getOriginX() - previous_origin_x) / resolution_));
+  const int shift_y =
+    static_cast<int>(std::lround((getOriginY() - previous_origin_y) / resolution_));
+  valid_costmap_window_ = CellWindow{valid_costmap_window_.min_x - shift_x,
+    valid_costmap_window_.min_y - shift_y, valid_costmap_window_.max_x - shift_x,
+    valid_costmap_window_.max_y - shift_y}.intersection(
+    {0, 0, static_cast<int>(getSizeInCellsX()), static_cast<int>(getSizeInCellsY())});
 }
 
 }  // namespace nav2
@@ -0,0 +1,275 @@
+// SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+// Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+#include "nvblox_nav2/nvblox_voxel_layer.hpp"
+
+#include <algorithm>
+#include <bitset>
+#include <cmath>
+#include <memory>
+#include <string>
+
+#include <nav2_costmap_2d/cost_values.hpp>
+
+namespace nvblox
+{
+namespace nav2
+{
+
+namespace
+{
+
+// The most voxels of a column a nav2_msgs/VoxelGrid holds.
+constexpr int kMaxVoxelMapSizeZ = 16;
+
+}  // namespace
+
+NvbloxVoxelLayer::NvbloxVoxelLayer() {}
+
+void NvbloxVoxelLayer::onInitialize()
+{
+  auto node = node_.lock();
+  if (!node) {
+    throw std::runtime_error{"Failed to lock node"};
+  }
+  enabled_ = node->declare_parameter(getFullName("enabled"), true);
+  nav2_costmap_global_frame_ = node->declare_parameter(
+    getFullName("nav2_costmap_global_frame"), nav2_costmap_global_frame_);
+  const std::string nvblox_voxel_grid_topic = node->declare_parameter<std::string>(
+    getFullName("nvblox_voxel_grid_topic"), "/nvblox_node/static_voxel_state_grid");
+  min_obstacle_height_ =
+    node->declare_parameter<float>(getFullName("min_obstacle_height"), min_obstacle_height_);
+  max_obstacle_height_ =
+    node->declare_parameter<float>(getFullName("max_obstacle_height"), max_obstacle_height_);
+  mark_threshold_ = node->declare_parameter<int>(getFullName("mark_threshold"), mark_threshold_);
+  publish_voxel_map_ =
+    node->declare_parameter<bool>(getFullName("publish_voxel_map"), publish_voxel_map_);
+  use_intra_process_comms_ = node->declare_parameter<bool>(
+    getFullName("use_intra_process_comms"), use_intra_process_comms_);
+
+  RCLCPP_INFO_STREAM(
+    node->get_logger(),
+    "Name: " << name_ << " Topic name: " << nvblox_voxel_grid_topic
+             << " Obstacle heights: [" << min_obstacle_height_ << ", " << max_obstacle_height_
+             << "] Mark threshold: " << mark_threshold_);
+
+  rclcpp::SubscriptionOptions subscription_options;
+  subscription_options.use_intra_process_comm =
+    use_intra_process_comms_ ? rclcpp::IntraProcessSetting::Enable :
+    rclcpp::IntraProcessSetting::NodeDefault;
+  voxel_grid_sub_ = node->create_subscription<nvblox_msgs::msg::VoxelStateGrid>(
+    nvblox_voxel_grid_topic, 1,
+    std::bind(&NvbloxVoxelLayer::voxelGridCallback, this, std::placeholders::_1),
+    subscription_options);
+  if (publish_voxel_map_) {
+    voxel_map_pub_ = node->create_publisher<nav2_msgs::msg::VoxelGrid>(
+      getFullName("voxel_grid"), rclcpp::QoS(1));
+  }
+
+  // Cells which are not covered by a grid have no information.
+  setDefaultValue(nav2_costmap_2d::NO_INFORMATION);
+  current_ = true;
+}
+
+void NvbloxVoxelLayer::activate()
+{
+  if (voxel_map_pub_) {
+    voxel_map_pub_->on_activate();
+  }
+}
+
+void NvbloxVoxelLayer::deactivate()
+{
+  if (voxel_map_pub_) {
+    voxel_map_pub_->on_deactivate();
+  }
+}
+
+void NvbloxVoxelLayer::updateBounds(
+  double /*robot_x*/, double /*robot_y*/, double /*robot_yaw*/,
+  double * min_x, double * min_y, double * max_x, double * max_y)
+{
+  // The bounds can only grow, so just extend them by the grid.
+  std::lock_guard<std::mutex> lock(voxel_grid_mutex_);
+  if (voxel_grid_ == nullptr) {
+    return;
+  }
+  *min_x = std::min(*min_x, voxel_grid_->origin.x);
+  *min_y = std::min(*min_y, voxel_grid_->origin.y);
+  *max_x = std::max(*max_x, voxel_grid_->origin.x + voxel_grid_->size_x * voxel_grid_->resolution);
+  *max_y = std::max(*max_y, voxel_grid_->origin.y + voxel_grid_->size_y * voxel_grid_->resolution);
+}
+
+void NvbloxVoxelLayer::updateCosts(
+  nav2_costmap_2d::Costmap2D & master_grid, int min_i, int min_j,
+  int max_i, int max_j)
+{
+  if (!enabled_) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(voxel_grid_mutex_);
+  if (voxel_grid_ == nullptr) {
+    return;
+  }
+
+  // Look up the column below each cell center and combine with the master grid by taking the
+  // max, leaving cells without information untouched (as updateWithMax()). The columns are looked
+  // up straight from the master grid's cells, such that a rolling master grid needs no special
+  // handling.
+  const nvblox_msgs::msg::VoxelStateGrid & grid = *voxel_grid_;
+  const double inv_resolution = 1.0 / grid.resolution;
+  unsigned char * master_array = master_grid.getCharMap();
+  for (int j = min_j; j < max_j; j++) {
+    for (int i = min_i; i < max_i; i++) {
+      double world_x;
+      double world_y;
+      master_grid.mapToWorld(i, j, world_x, world_y);
+      const int x = static_cast<int>(std::floor((world_x - grid.origin.x) * inv_resolution));
+      const int y = static_cast<int>(std::floor((world_y - grid.origin.y) * inv_resolution));
+      if (x < 0 || y < 0 || x >= static_cast<int>(grid.size_x) ||
+        y >= static_cast<int>(grid.size_y))
+      {
+        continue;
+      }
+      const size_t column_idx = static_cast<size_t>(y) * grid.size_x + x;
+      const uint8_t cost =
+        columnCost(grid.occupied_columns[column_idx], grid.unknown_columns[column_idx]);
+      if (cost == nav2_costmap_2d::NO_INFORMATION) {
+        continue;
+      }
+      unsigned char & master_cost = master_array[master_grid.getIndex(i, j)];
+      if (master_cost == nav2_costmap_2d::NO_INFORMATION || master_cost < cost) {
+        master_cost = cost;
+      }
+    }
+  }
+  current_ = true;
+}
+
+void NvbloxVoxelLayer::voxelGridCallback(
+  const nvblox_msgs::msg::VoxelStateGrid::ConstSharedPtr voxel_grid)
+{
+  if (!enabled_) {
+    return;
+  }
+  auto node = node_.lock();
+  if (!node) {
+    throw std::runtime_error{"Failed to lock node"};
+  }
+  constexpr int kWarnMessagePeriodMs = 1000;
+  if (voxel_grid->header.frame_id != nav2_costmap_global_frame_) {
+    RCLCPP_WARN_STREAM_THROTTLE(
+      node->get_logger(), *node->get_clock(), kWarnMessagePeriodMs,
+      "[NvbloxVoxelLayer] Ignoring a voxel grid in frame " << voxel_grid->header.frame_id
+                                                           << ". It has to be published in the "
+                                                           << nav2_costmap_global_frame_
+                                                           << " frame.");
+    return;
+  }
+  const size_t num_columns = static_cast<size_t>(voxel_grid->size_x) * voxel_grid->size_y;
+  if (voxel_grid->occupied_columns.size() != num_columns ||
+    voxel_grid->unknown_columns.size() != num_columns || voxel_grid->resolution <= 0.0f)
+  {
+    RCLCPP_WARN_STREAM_THROTTLE(
+      node->get_logger(), *node->get_clock(), kWarnMessagePeriodMs,
+      "[NvbloxVoxelLayer] Ignoring a malformed voxel grid.");
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(voxel_grid_mutex_);
+    voxel_grid_ = voxel_grid;
+    obstacle_height_mask_ = obstacleHeightMask(*voxel_grid);
+  }
+  if (voxel_map_pub_ && voxel_map_pub_->is_activated()) {
+    publishVoxelMap(*voxel_grid);
+  }
+}
+
+uint32_t NvbloxVoxelLayer::obstacleHeightMask(
+  const nvblox_msgs::msg::VoxelStateGrid & voxel_grid) const
+{
+  // The voxels whose centers lie between the obstacle heights.
+  const int size_z = std::min<int>(voxel_grid.size_z, 32);
+  const int min_z = std::max(
+    0, static_cast<int>(std::ceil(
+      (min_obstacle_height_ - voxel_grid.origin.z) / voxel_grid.resolution - 0.5)));
+  const int max_z = std::min(
+    size_z - 1, static_cast<int>(std::floor(
+      (max_obstacle_height_ - voxel_grid.origin.z) / voxel_grid.resolution - 0.5)));
+  uint32_t mask = 0;
+  for (int z = min_z; z <= max_z; z++) {
+    mask |= 1U << z;
+  }
+  return mask;
+}
+
+uint8_t NvbloxVoxelLayer::columnCost(
+  const uint32_t occupied_bits,
+  const uint32_t unknown_bits) const
+{
+  if (obstacle_height_mask_ == 0) {
+    return nav2_costmap_2d::NO_INFORMATION;
+  }
+  const int num_occupied = std::bitset<32>(occupied_bits & obstacle_height_mask_).count();
+  if (num_occupied > mark_threshold_) {
+    return nav2_costmap_2d::LETHAL_OBSTACLE;
+  }
+  if ((unknown_bits & obstacle_height_mask_) == obstacle_height_mask_) {
+    return nav2_costmap_2d::NO_INFORMATION;
+  }
+  return nav2_costmap_2d::FREE_SPACE;
+}
+
+void NvbloxVoxelLayer::publishVoxelMap(const nvblox_msgs::msg::VoxelStateGrid & voxel_grid)
+{
+  if (voxel_grid.size_z > kMaxVoxelMapSizeZ) {
+    auto node = node_.lock();
+    if (node) {
+      RCLCPP_WARN_STREAM_ONCE(
+        node->get_logger(), "[NvbloxVoxelLayer] Can't publish voxel maps more than "
+          << kMaxVoxelMapSizeZ << " voxels high.");
+    }
+    return;
+  }
+  // In a nav2 voxel grid column, bit z + 16 and bit z are set for marked voxels, and only bit z
+  // for unknown ones.
+  auto voxel_map = std::make_unique<nav2_msgs::msg::VoxelGrid>();
+  voxel_map->header = voxel_grid.header;
+  voxel_map->size_x = voxel_grid.size_x;
+  voxel_map->size_y = voxel_grid.size_y;
+  voxel_map->size_z = voxel_grid.size_z;
+  voxel_map->origin.x = voxel_grid.origin.x;
+  voxel_map->origin.y = voxel_grid.origin.y;
+  voxel_map->origin.z = voxel_grid.origin.z;
+  voxel_map->resolutions.x = voxel_grid.resolution;
+  voxel_map->resolutions.y = voxel_grid.resolution;
+  voxel_map->resolutions.z = voxel_grid.resolution;
+  voxel_map->data.resize(voxel_grid.occupied_columns.size());
+  for (size_t i = 0; i < voxel_map->data.size(); i++) {
+    const uint32_t occupied_bits = voxel_grid.occupied_columns[i];
+    voxel_map->data[i] = (occupied_bits << kMaxVoxelMapSizeZ) |
+      occupied_bits | voxel_grid.unknown_columns[i];
+  }
+  voxel_map_pub_->publish(std::move(voxel_map));
+}
+
+}  // namespace nav2
+}  // namespace nvblox
+
+// Register the macro for this layer
+#include "pluginlib/class_list_macros.hpp"
+PLUGINLIB_EXPORT_CLASS(nvblox::nav2::NvbloxVoxelLayer, nav2_costmap_2d::Layer)
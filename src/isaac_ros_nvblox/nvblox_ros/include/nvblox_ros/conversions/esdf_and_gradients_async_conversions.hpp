@@ -0,0 +1,187 @@
+// SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+// Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef NVBLOX_ROS__CONVERSIONS__ESDF_AND_GRADIENTS_ASYNC_CONVERSIONS_HPP_
+#define NVBLOX_ROS__CONVERSIONS__ESDF_AND_GRADIENTS_ASYNC_CONVERSIONS_HPP_
+
+#include <nvblox/nvblox.h>
+#include <nvblox/core/cuda_event.h>
+
+#include <memory>
+#include <vector>
+
+#include <std_msgs/msg/float32_multi_array.hpp>
+
+#include <nvblox_msgs/msg/quantized_esdf_grid.hpp>
+#include <nvblox_msgs/srv/esdf_and_gradients.hpp>
+
+namespace nvblox
+{
+namespace conversions
+{
+
+/// The scale of the distances in QuantizedEsdfGrid messages (millimeters).
+constexpr float kQuantizedEsdfDistanceScaleM = 1e-3F;
+
+/// The format of EsdfAndGradients responses.
+struct EsdfAndGradientsFormat
+{
+  /// Fill the compact QuantizedEsdfGrid rather than the float32 multi array.
+  bool quantized = false;
+  /// Run-length encode the quantized distances.
+  bool run_length_encode = false;
+};
+
+/// Run-length encodes values: run_values[i] is repeated run_lengths[i] times. Runs are split at
+/// the largest uint16 run length.
+/// @param values The values to encode.
+/// @param num_values The number of values.
+/// @param run_values The value of each run.
+/// @param run_lengths The length of each run.
+void runLengthEncode(
+  const int16_t * values, size_t num_values, std::vector<int16_t> * run_values,
+  std::vector<uint16_t> * run_lengths);
+
+/// Decodes the distances of a QuantizedEsdfGrid (run-length encoded or not) to one value per
+/// voxel.
+/// @param grid_msg The message.
+/// @return The distances, in units of grid_msg.distance_scale_m.
+std::vector<int16_t> decodeQuantizedEsdfDistances(
+  const nvblox_msgs::msg::QuantizedEsdfGrid & grid_msg);
+
+/// An ESDF grid (and optionally its gradients) within an AABB, extracted on the GPU into pinned
+/// host memory by AsyncEsdfAndGradientsConverter::extractAsync().
+///
+/// The extraction is asynchronous. fillResponse() waits for it, and is meant to be called off
+/// the tick thread (see ServiceWorker), such that mapping doesn't wait on service handling.
+class EsdfAndGradientsSnapshot
+{
+public:
+  EsdfAndGradientsSnapshot() = default;
+
+  /// Whether the extraction is done, i.e. fillResponse() wouldn't block.
+  bool isReady() const;
+
+  /// Block until the extraction is done and fill the response.
+  /// The grid is written to response->esdf_and_gradients with the dimensions x, y, z (z varying
+  /// fastest). With gradients, a fourth dimension "channel" holds the distance followed by the
+  /// gradient along x, y and z. In the quantized format response->quantized_esdf_grid is filled
+  /// instead.
+  /// @param response The response to fill.
+  void fillResponse(nvblox_msgs::srv::EsdfAndGradients::Response * response) const;
+
+  /// Block until the extraction is done and return the grid as a message.
+  /// Only valid if the snapshot is not quantized.
+  std_msgs::msg::Float32MultiArray toMultiArrayMsg() const;
+
+  /// Block until the extraction is done and return the grid as a compact message. Run-length
+  /// encodes the distances (on the calling thread) if requested by the format.
+  /// Only valid if the snapshot is quantized.
+  nvblox_msgs::msg::QuantizedEsdfGrid toQuantizedEsdfGridMsg() const;
+
+  /// The format the snapshot was extracted in.
+  const EsdfAndGradientsFormat & format() const {return format_;}
+
+private:
+  friend class AsyncEsdfAndGradientsConverter;
+
+  // The grid, packed as in the message, in pinned host memory.
+  host_vector<float> data_;
+  // The grid in the quantized format, in pinned host memory.
+  host_vector<int16_t> quantized_distances_;
+  host_vector<int8_t> quantized_gradients_;
+  EsdfAndGradientsFormat format_;
+  Index3D min_index_ = Index3D::Zero();
+  Index3D aabb_size_ = Index3D::Zero();
+  float voxel_size_m_ = 0.F;
+  int num_channels_ = 1;
+  // Recorded after the copy to data_ has been enqueued.
+  CudaEvent extracted_event_;
+};
+
+/// Extracts ESDF (and gradient) grids for EsdfAndGradients service responses on the GPU.
+///
+/// The AABB is gathered into a dense grid by a kernel (voxelLayerToDenseVoxelGridInAABBAsync()),
+/// gradients are computed on the device (denseGridGradientsAsync()), the result is packed into
+/// the message layout on the device and copied into the pinned buffer of a snapshot. None of
+/// this blocks the calling (tick) thread.
+///
+/// Snapshots are recycled once the caller has released them, such that the pinned buffers are
+/// not reallocated for every request.
+class AsyncEsdfAndGradientsConverter
+{
+public:
+  AsyncEsdfAndGradientsConverter();
+  ~AsyncEsdfAndGradientsConverter() = default;
+
+  /// Enqueue the extraction of the grid requested by an EsdfAndGradients request. Uses the
+  /// request's AABB if use_aabb is set, and the AABB of all allocated blocks otherwise. The
+  /// format is taken from the request.
+  /// @param esdf_layer The layer used to fill the grid.
+  /// @param default_value The value of cells where the layer has no observation.
+  /// @param request The request defining the AABB.
+  /// @param cuda_stream The stream to do the extraction on.
+  /// @return The snapshot being extracted, or nullptr if the AABB is empty.
+  std::shared_ptr<const EsdfAndGradientsSnapshot> extractAsync(
+    const EsdfLayer & esdf_layer, const float default_value,
+    const nvblox_msgs::srv::EsdfAndGradients::Request & request,
+    const CudaStream & cuda_stream);
+
+  /// Enqueue the extraction of the grid within an AABB.
+  /// @param esdf_layer The layer used to fill the grid.
+  /// @param aabb The AABB to extract. The grid includes the aabb end points.
+  /// @param default_value The value of cells where the layer has no observation.
+  /// @param cuda_stream The stream to do the extraction on.
+  /// @param format The format of the response.
+  /// @return The snapshot being extracted, or nullptr if the AABB is empty.
+  std::shared_ptr<const EsdfAndGradientsSnapshot> extractAsync(
+    const EsdfLayer & esdf_layer, const AxisAlignedBoundingBox & aabb,
+    const float default_value, const CudaStream & cuda_stream,
+    const EsdfAndGradientsFormat & format = EsdfAndGradientsFormat());
+
+  /// A parameter getter
+  /// Whether the gradients are extracted along with the distances.
+  bool include_gradients() const;
+
+  /// A parameter setter
+  /// See include_gradients().
+  void include_gradients(bool include_gradients);
+
+  /// The number of snapshots allocated so far (for testing). Snapshots are recycled once
+  /// released, so this only grows with the number of snapshots held at once.
+  size_t num_allocated_snapshots() const {return snapshots_.size();}
+
+protected:
+  std::shared_ptr<EsdfAndGradientsSnapshot> getFreeSnapshot();
+
+  bool include_gradients_ = false;
+
+  // Staging space on the device
+  Unified3DGrid<float> distance_grid_;
+  Unified3DGrid<Vector3f> gradient_grid_;
+  device_vector<float> packed_grid_;
+  device_vector<int16_t> quantized_distances_;
+  device_vector<int8_t> quantized_gradients_;
+
+  // Snapshots handed out. Ones which are only referenced here are free.
+  std::vector<std::shared_ptr<EsdfAndGradientsSnapshot>> snapshots_;
+};
+
+}  // namespace conversions
+}  // namespace nvblox
+
+#endif  // NVBLOX_ROS__CONVERSIONS__ESDF_AND_GRADIENTS_ASYNC_CONVERSIONS_HPP_
@@ -0,0 +1,212 @@
+// SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+// Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef NVBLOX_ROS__CONVERSIONS__ESDF_SLICE_GRID_CONVERSIONS_HPP_
+#define NVBLOX_ROS__CONVERSIONS__ESDF_SLICE_GRID_CONVERSIONS_HPP_
+
+#include <nvblox/nvblox.h>
+
+#include <array>
+#include <memory>
+#include <optional>
+
+#include <map_msgs/msg/occupancy_grid_update.hpp>
+#include <nav_msgs/msg/occupancy_grid.hpp>
+#include <nvblox_msgs/msg/distance_map_slice.hpp>
+#include <nvblox_msgs/msg/distance_map_slice_update.hpp>
+
+namespace nvblox
+{
+namespace conversions
+{
+
+constexpr int8_t kOccupancyGridFreeCost = 0;
+constexpr int8_t kOccupancyGridOccupiedCost = 100;
+constexpr int8_t kOccupancyGridUnknownCost = -1;
+
+/// Converts ESDF slice images to the data of occupancy grid and distance map slice messages on
+/// the GPU.
+///
+/// Up to kMaxNumSlices slices (e.g. the static, dynamic and combined slices) are converted by a
+/// single kernel launch. The kernel writes straight into pinned host buffers, such that filling a
+/// message is a single copy rather than per-cell work on the CPU.
+///
+/// Alternatively, convertLayers() slices the static and dynamic ESDF layers directly. A single
+/// kernel then reads each layer once per cell and writes all slice variants (static, pessimistic
+/// static, dynamic and combined) along with their occupancy grids, such that the slicing cost
+/// doesn't grow with the number of requested outputs.
+///
+/// Distances are mapped to costs as follows:
+///  - unknown cells get kOccupancyGridUnknownCost,
+///  - cells at or below occupied_distance_m get kOccupancyGridOccupiedCost,
+///  - cells at or beyond free_distance_m get kOccupancyGridFreeCost,
+///  - in between, the cost decays linearly.
+/// With free_distance_m <= occupied_distance_m the grid is a plain threshold.
+///
+/// The same kernel compares each slice to the one converted before it, and records the window of
+/// cells which changed, such that partial (OccupancyGridUpdate / DistanceMapSliceUpdate) messages
+/// can be published instead of the full grids.
+class EsdfSliceGridConverter
+{
+public:
+  static constexpr int kMaxNumSlices = 4;
+
+  /// The slices written by convertLayers().
+  static constexpr int kStaticSliceIdx = 0;
+  static constexpr int kDynamicSliceIdx = 1;
+  static constexpr int kCombinedSliceIdx = 2;
+  static constexpr int kPessimisticStaticSliceIdx = 3;
+
+  /// A slice image along with its bounds (as returned by the slicer). Changed cells are only
+  /// tracked between consecutive slices with the same bounds.
+  struct Slice
+  {
+    const Image<float> * image = nullptr;
+    AxisAlignedBoundingBox aabb;
+  };
+  using Slices = std::array<Slice, kMaxNumSlices>;
+
+  /// The layers sliced by convertLayers(), and which slice variants to output.
+  struct LayerSlices
+  {
+    const EsdfLayer * static_layer = nullptr;
+    /// May be nullptr, in which case the dynamic and combined slices are skipped. May be coarser
+    /// than the static layer, in which case it's sampled at the slice cells of the static layer.
+    const EsdfLayer * dynamic_layer = nullptr;
+    float static_slice_height = 0.0F;
+    float dynamic_slice_height = 0.0F;
+    /// The bounds shared by all slices (e.g. from EsdfSlicer::getCombinedAabbOfLayersAtHeight()).
+    AxisAlignedBoundingBox aabb;
+    /// The value of unknown cells in all slices but the pessimistic one.
+    float unknown_value = 0.0F;
+    /// The value of unknown cells in the pessimistic static slice.
+    float pessimistic_unknown_value = 0.0F;
+    /// The slice variants to output, indexed by the k*SliceIdx constants.
+    std::array<bool, kMaxNumSlices> enabled{};
+  };
+  /// Optional device images receiving the slices of convertLayers() (e.g. for pointclouds).
+  using SliceImages = std::array<Image<float> *, kMaxNumSlices>;
+
+  /// An inclusive window of cells in a slice.
+  struct CellWindow
+  {
+    int min_col = 0;
+    int min_row = 0;
+    int max_col = -1;
+    int max_row = -1;
+    int width() const {return max_col - min_col + 1;}
+    int height() const {return max_row - min_row + 1;}
+  };
+
+  EsdfSliceGridConverter();
+  explicit EsdfSliceGridConverter(std::shared_ptr<CudaStream> cuda_stream);
+
+  /// Convert the passed slices. Slices with a nullptr image are skipped, but all passed slices
+  /// must have the same size. Synchronizes the stream, such that the data can be used right away.
+  /// @param slices            The slices to convert (images in device or unified memory).
+  /// @param unknown_value     The value marking unknown cells in the slice images.
+  /// @return False if the slices differ in size.
+  bool convertSliceImages(const Slices & slices, float unknown_value);
+
+  /// Slice the layers and convert the enabled slice variants, in a single kernel launch.
+  /// Synchronizes the stream, such that the data can be used right away.
+  /// @param layer_slices      The layers to slice, and the slice variants to output.
+  /// @param slice_images      If not nullptr, enabled slices are also written to these images
+  ///                          (resized to the slice, in device memory).
+  /// @return False if the layers differ in voxel size.
+  bool convertLayers(const LayerSlices & layer_slices, const SliceImages & slice_images = {});
+
+  /// Whether the slice at slice_idx was converted by the last call to convertSliceImages().
+  bool hasSlice(int slice_idx) const;
+
+  /// The window of cells of a slice which changed in the last call to convertSliceImages(), or
+  /// std::nullopt if none did. The window is the full slice if the slice wasn't converted before,
+  /// or its size, bounds or unknown value changed.
+  std::optional<CellWindow> changedCellWindow(int slice_idx) const;
+
+  /// Copy a window of the converted occupancy grid of a slice into an update message.
+  void occupancyGridUpdateMsgFromSlice(
+    int slice_idx, const CellWindow & window,
+    map_msgs::msg::OccupancyGridUpdate * occupancy_grid_update_msg) const;
+
+  /// Copy a window of the converted distances of a slice into an update message.
+  void distanceMapSliceUpdateMsgFromSlice(
+    int slice_idx, const CellWindow & window,
+    nvblox_msgs::msg::DistanceMapSliceUpdate * map_slice_update_msg) const;
+
+  /// Copy the converted occupancy grid of a slice into a message, and set its size.
+  void occupancyGridMsgDataFromSlice(
+    int slice_idx, nav_msgs::msg::OccupancyGrid * occupancy_grid_msg) const;
+
+  /// Copy the converted distances of a slice into a message, and set its size.
+  void distanceMapSliceMsgDataFromSlice(
+    int slice_idx, nvblox_msgs::msg::DistanceMapSlice * map_slice_msg) const;
+
+  /// A parameter getter
+  /// The distance at or below which cells are occupied.
+  float occupied_distance_m() const {return occupied_distance_m_;}
+
+  /// A parameter setter
+  /// See occupied_distance_m()
+  void occupied_distance_m(float occupied_distance_m) {occupied_distance_m_ = occupied_distance_m;}
+
+  /// A parameter getter
+  /// The distance at or beyond which cells are free.
+  float free_distance_m() const {return free_distance_m_;}
+
+  /// A parameter setter
+  /// See free_distance_m()
+  void free_distance_m(float free_distance_m) {free_distance_m_ = free_distance_m;}
+
+private:
+  // Resize the outputs to a rows x cols slice, and reset the changed cell windows.
+  void prepareOutputs(int rows, int cols);
+  // Read the changed cell windows back, and record the state the slices were converted with.
+  void finishConversion(
+    const std::array<bool, kMaxNumSlices> & compared,
+    const std::array<AxisAlignedBoundingBox, kMaxNumSlices> & aabbs,
+    const std::array<float, kMaxNumSlices> & unknown_values);
+
+  float occupied_distance_m_ = 0.0F;
+  float free_distance_m_ = 0.0F;
+
+  int rows_ = 0;
+  int cols_ = 0;
+  std::array<bool, kMaxNumSlices> has_slice_{};
+
+  // The state the previous slices were converted with. The previous distances are the contents
+  // of distances_host_, which the kernel compares to before overwriting them.
+  std::array<bool, kMaxNumSlices> has_previous_slice_{};
+  std::array<AxisAlignedBoundingBox, kMaxNumSlices> previous_aabbs_;
+  std::array<float, kMaxNumSlices> previous_unknown_values_{};
+
+  std::shared_ptr<CudaStream> cuda_stream_;
+
+  // Pinned output buffers, written directly by the kernel.
+  std::array<host_vector<int8_t>, kMaxNumSlices> occupancy_grids_host_;
+  std::array<host_vector<float>, kMaxNumSlices> distances_host_;
+
+  // The changed cell windows, as (min_col, min_row, max_col, max_row) per slice. Reduced with
+  // atomics on the device.
+  device_vector<int> changed_windows_device_;
+  host_vector<int> changed_windows_host_;
+};
+
+}  // namespace conversions
+}  // namespace nvblox
+
+#endif  // NVBLOX_ROS__CONVERSIONS__ESDF_SLICE_GRID_CONVERSIONS_HPP_
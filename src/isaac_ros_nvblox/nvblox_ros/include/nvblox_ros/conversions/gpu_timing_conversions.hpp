@@ -0,0 +1,48 @@
+// SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+// Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef NVBLOX_ROS__CONVERSIONS__GPU_TIMING_CONVERSIONS_HPP_
+#define NVBLOX_ROS__CONVERSIONS__GPU_TIMING_CONVERSIONS_HPP_
+
+#include <nvblox/utils/gpu_timing.h>
+
+#include <map>
+#include <string>
+
+#include <diagnostic_msgs/msg/diagnostic_status.hpp>
+
+namespace nvblox
+{
+namespace conversions
+{
+
+/// @brief Convert the GPU timing statistics of all stages to a diagnostic status.
+/// For each stage the status lists the number of samples and the mean, p50, p90, p99 and max GPU
+/// time in milliseconds, keyed as "<tag>/<statistic>". Its level is WARN if the p99 of any stage
+/// exceeds the budget.
+/// @param stats The statistics by tag, see timing::GpuTiming::GetAllStats().
+/// @param name The name of the status, e.g. the name of the node.
+/// @param p99_budget_ms The p99 GPU time above which the status is WARN. Non-positive disables.
+/// @param status_msg The resulting DiagnosticStatus message.
+void gpuTimingToDiagnosticStatusMsg(
+  const std::map<std::string, timing::GpuTimingStats> & stats, const std::string & name,
+  float p99_budget_ms, diagnostic_msgs::msg::DiagnosticStatus * status_msg);
+
+}  // namespace conversions
+}  // namespace nvblox
+
+#endif  // NVBLOX_ROS__CONVERSIONS__GPU_TIMING_CONVERSIONS_HPP_
@@ -0,0 +1,49 @@
+// SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+// Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef NVBLOX_ROS__CONVERSIONS__MEMORY_USAGE_CONVERSIONS_HPP_
+#define NVBLOX_ROS__CONVERSIONS__MEMORY_USAGE_CONVERSIONS_HPP_
+
+#include <nvblox/mapper/mapper.h>
+
+#include <string>
+
+#include <diagnostic_msgs/msg/diagnostic_status.hpp>
+
+namespace nvblox
+{
+namespace conversions
+{
+
+/// @brief Convert the memory usage of a mapper to a diagnostic status.
+/// The status lists, in MiB, the allocated and used bytes of the block pool, the GPU hash and the
+/// paged out blocks of each layer, the scratch arena and the device memory pool, as well as the
+/// device memory pressure. For each GPU hash it also lists the load factor, the peak load factor,
+/// the number of rehashes, the longest rehash stall and the mean sampled probe length. Its level is
+/// WARN if the pressure exceeds the watermark.
+/// @param usage The memory usage, see Mapper::memoryUsage().
+/// @param name The name of the status, e.g. the name of the mapper.
+/// @param pressure_watermark The device memory pressure above which the status is WARN.
+/// @param status_msg The resulting DiagnosticStatus message.
+void memoryUsageToDiagnosticStatusMsg(
+  const MapperMemoryUsage & usage, const std::string & name, float pressure_watermark,
+  diagnostic_msgs::msg::DiagnosticStatus * status_msg);
+
+}  // namespace conversions
+}  // namespace nvblox
+
+#endif  // NVBLOX_ROS__CONVERSIONS__MEMORY_USAGE_CONVERSIONS_HPP_
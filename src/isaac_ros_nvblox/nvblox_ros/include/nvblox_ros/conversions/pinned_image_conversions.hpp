@@ -0,0 +1,92 @@
+// SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+// Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef NVBLOX_ROS__CONVERSIONS__PINNED_IMAGE_CONVERSIONS_HPP_
+#define NVBLOX_ROS__CONVERSIONS__PINNED_IMAGE_CONVERSIONS_HPP_
+
+#include <nvblox/nvblox.h>
+
+#include "nvblox_ros/conversions/image_conversions_thrust.hpp"
+
+namespace nvblox
+{
+namespace conversions
+{
+
+/// Conversions of host images (e.g. from non-NITROS messages) to device images, staged through
+/// pinned memory.
+///
+/// The host image is copied into a pinned staging image (an Image with MemoryType::kHost). The
+/// conversion kernel then reads the staging image directly, such that the upload is fused with
+/// the conversion and no device scratch image or separate host-to-device copy is needed. The
+/// stream is synchronized before the staging image is overwritten, so a staging image should be
+/// used with a single stream, e.g. one per camera.
+
+/// Convert host int16 depth in millimeters -> device depth in meters.
+/// Output and staging images are resized if necessary.
+/// @param ptr_host           Input depth image in host memory
+/// @param height             Image height
+/// @param width              Image width
+/// @param depth_image        Output depth image
+/// @param staging_image      Pinned staging image. Must be MemoryType::kHost
+/// @param cuda_stream        Cuda stream used for the conversion
+/// @return True on success, False on failure.
+bool depthFromIntHostPinnedAsync(
+  const int16_t * ptr_host, const int height,
+  const int width, DepthImage * depth_image,
+  Image<int16_t> * staging_image,
+  const CudaStream & cuda_stream);
+
+/// Convert host RGB/BGRA -> device RGBA (with alpha = 255)
+/// See depthFromIntHostPinnedAsync() for params.
+template<typename T>
+bool rgbaFromHostPinnedAsync(
+  const T * ptr_host, const int height,
+  const int width, ColorImage * color_image,
+  Image<T> * staging_image,
+  const CudaStream & cuda_stream);
+
+/// Convert host NV12 -> device RGBA (with alpha = 255)
+/// NV12 is a full resolution Y plane followed by a half resolution plane of interleaved U and V.
+/// Chroma is upsampled (nearest) and converted with BT.601 limited range as part of the upload,
+/// such that no RGB image is produced on the host.
+/// @param ptr_host           Input NV12 image in host memory (height * width * 3 / 2 bytes)
+/// @param height             Image height. Must be even.
+/// @param width              Image width. Must be even.
+/// @param color_image        Output color image
+/// @param staging_image      Pinned staging image. Must be MemoryType::kHost
+/// @param cuda_stream        Cuda stream used for the conversion
+/// @return True on success, False on failure.
+bool rgbaFromNv12HostPinnedAsync(
+  const uint8_t * ptr_host, const int height,
+  const int width, ColorImage * color_image,
+  Image<uint8_t> * staging_image,
+  const CudaStream & cuda_stream);
+
+/// Convert host YUYV (YUV 4:2:2, ROS encoding yuv422_yuy2) -> device RGBA (with alpha = 255)
+/// Each pair of pixels is stored as Y0 U Y1 V. See rgbaFromNv12HostPinnedAsync() for params.
+/// The width must be even.
+bool rgbaFromYuyvHostPinnedAsync(
+  const uint8_t * ptr_host, const int height,
+  const int width, ColorImage * color_image,
+  Image<uint8_t> * staging_image,
+  const CudaStream & cuda_stream);
+
+}  // namespace conversions
+}  // namespace nvblox
+
+#endif  // NVBLOX_ROS__CONVERSIONS__PINNED_IMAGE_CONVERSIONS_HPP_
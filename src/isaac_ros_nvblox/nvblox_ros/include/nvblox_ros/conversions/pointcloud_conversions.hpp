@@ -65,6 +65,16 @@ public:
     const sensor_msgs::msg::PointCloud2::ConstSharedPtr & pointcloud,
     const Lidar & lidar, DepthImage * depth_image_ptr);
 
+  // Convert a pointcloud which is already in device memory (for example
+  // received over nitros) to a depth image. The points are read in place, such
+  // that, in contrast to the PointCloud2 overload, no upload is required.
+  // Points are expected to start with float32 x, y and z fields and to be
+  // point_step_bytes apart.
+  void depthImageFromPointcloudGPU(
+    const uint8_t * points_device, const int num_points,
+    const int point_step_bytes, const Lidar & lidar,
+    DepthImage * depth_image_ptr);
+
   // This function returns true if the pointcloud passed in is consistent with
   // the LiDAR intrinsics model.
   bool checkLidarPointcloud(
@@ -0,0 +1,89 @@
+// SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+// Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef NVBLOX_ROS__CONVERSIONS__POINTCLOUD_PACKING_HPP_
+#define NVBLOX_ROS__CONVERSIONS__POINTCLOUD_PACKING_HPP_
+
+#include <nvblox/nvblox.h>
+
+#include <memory>
+
+#include <sensor_msgs/msg/point_cloud2.hpp>
+
+#include "nvblox_ros/conversions/pointcloud_conversions.hpp"
+
+namespace nvblox
+{
+namespace conversions
+{
+
+/// Set the fields of a PointCloud2 message to those of PclPointXYZI (x, y, z and intensity as
+/// float32) and resize its data to num_points.
+/// @param num_points The number of points.
+/// @param pointcloud_msg The message to set up.
+void setPclPointXYZIMsgLayout(int num_points, sensor_msgs::msg::PointCloud2 * pointcloud_msg);
+
+/// Generates PointCloud2 messages of XYZI points on the GPU, for the ESDF and slice
+/// visualizations.
+///
+/// A single CUB DeviceSelect pass both compacts the valid cells or points and packs them as
+/// PclPointXYZI. The output goes straight to a pinned host buffer, such that filling the message
+/// is a single memcpy rather than per-point work on the CPU. The call synchronizes the stream
+/// once, to learn the number of points.
+class GpuPointcloudPacker
+{
+public:
+  GpuPointcloudPacker();
+  explicit GpuPointcloudPacker(std::shared_ptr<CudaStream> cuda_stream);
+
+  /// Convert a slice image to a pointcloud of the observed cells. Points are placed at the cell
+  /// centers at slice_height, with the distance as intensity.
+  /// @param slice_image The slice image (in device or unified memory).
+  /// @param aabb The bounds of the slice, as returned by the slicer.
+  /// @param slice_height The height of the points.
+  /// @param voxel_size The size of a slice cell.
+  /// @param unknown_value The value of unobserved cells, which are skipped.
+  /// @param pointcloud_msg The output message. Its header is left untouched.
+  void pointcloudMsgFromSliceImage(
+    const Image<float> & slice_image, const AxisAlignedBoundingBox & aabb,
+    float slice_height, float voxel_size, float unknown_value,
+    sensor_msgs::msg::PointCloud2 * pointcloud_msg);
+
+  /// Convert a pointcloud to a message. Non-finite points are skipped. The intensity is zero.
+  /// @param pointcloud The pointcloud (in device or unified memory).
+  /// @param pointcloud_msg The output message. Its header is left untouched.
+  void pointcloudMsgFromPointcloud(
+    const Pointcloud & pointcloud, sensor_msgs::msg::PointCloud2 * pointcloud_msg);
+
+private:
+  template<typename InputIteratorType, typename SelectOpType>
+  void selectToMsg(
+    InputIteratorType input_it, int num_items, SelectOpType select_op,
+    sensor_msgs::msg::PointCloud2 * pointcloud_msg);
+
+  std::shared_ptr<CudaStream> cuda_stream_;
+
+  // Buffers
+  host_vector<PclPointXYZI> points_host_;
+  unified_ptr<int> num_selected_host_;
+  device_vector<uint8_t> select_temp_storage_;
+};
+
+}  // namespace conversions
+}  // namespace nvblox
+
+#endif  // NVBLOX_ROS__CONVERSIONS__POINTCLOUD_PACKING_HPP_
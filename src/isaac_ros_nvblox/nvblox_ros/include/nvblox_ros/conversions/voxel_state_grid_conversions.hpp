@@ -0,0 +1,93 @@
+// SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+// Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+#ifndef NVBLOX_ROS__CONVERSIONS__VOXEL_STATE_GRID_CONVERSIONS_HPP_
+#define NVBLOX_ROS__CONVERSIONS__VOXEL_STATE_GRID_CONVERSIONS_HPP_
+
+#include <nvblox/nvblox.h>
+
+#include <memory>
+
+#include <nvblox_msgs/msg/voxel_state_grid.hpp>
+
+namespace nvblox
+{
+namespace conversions
+{
+
+/// Converts an ESDF layer within an AABB to a VoxelStateGrid message on the GPU.
+///
+/// The AABB is gathered into a dense grid by a kernel (voxelLayerToDenseVoxelGridInAABBAsync()),
+/// then a second kernel packs each (x, y) column into occupied and unknown bit words. Both write
+/// the message layout in pinned host memory, such that filling the message is a copy.
+///
+/// Voxels are:
+///  - unknown if the ESDF didn't observe them,
+///  - occupied if their signed distance is at or below occupied_distance_m,
+///  - free otherwise.
+class VoxelStateGridConverter
+{
+public:
+  /// The most voxels a column (and so the grid along z) holds.
+  static constexpr int kMaxSizeZ = 32;
+
+  VoxelStateGridConverter();
+  explicit VoxelStateGridConverter(std::shared_ptr<CudaStream> cuda_stream);
+
+  /// Convert the ESDF within an AABB. Sets everything but the header. Synchronizes the stream.
+  /// @param esdf_layer The layer to convert (in device or unified memory).
+  /// @param aabb The AABB to convert. The grid includes the voxels touched by its edges.
+  /// @param voxel_state_grid_msg The message to fill.
+  /// @return False if the AABB is empty or more than kMaxSizeZ voxels high.
+  bool esdfLayerToVoxelStateGridMsg(
+    const EsdfLayer & esdf_layer, const AxisAlignedBoundingBox & aabb,
+    nvblox_msgs::msg::VoxelStateGrid * voxel_state_grid_msg);
+
+  /// A parameter getter
+  /// The signed distance at or below which voxels are occupied.
+  float occupied_distance_m() const {return occupied_distance_m_;}
+
+  /// A parameter setter
+  /// See occupied_distance_m()
+  void occupied_distance_m(float occupied_distance_m) {occupied_distance_m_ = occupied_distance_m;}
+
+  /// A parameter getter
+  /// Whether the message includes the distance of every voxel.
+  bool include_distances() const {return include_distances_;}
+
+  /// A parameter setter
+  /// See include_distances()
+  void include_distances(bool include_distances) {include_distances_ = include_distances;}
+
+private:
+  float occupied_distance_m_ = 0.0F;
+  bool include_distances_ = false;
+
+  std::shared_ptr<CudaStream> cuda_stream_;
+
+  // Staging space on the device
+  Unified3DGrid<float> distance_grid_;
+
+  // Pinned output buffers, written directly by the kernel.
+  host_vector<uint32_t> occupied_columns_host_;
+  host_vector<uint32_t> unknown_columns_host_;
+  host_vector<float> distances_host_;
+};
+
+}  // namespace conversions
+}  // namespace nvblox
+
+#endif  // NVBLOX_ROS__CONVERSIONS__VOXEL_STATE_GRID_CONVERSIONS_HPP_
@@ -0,0 +1,113 @@
+// SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+// Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+#ifndef NVBLOX_ROS__IMAGE_MASK_MATCHER_HPP_
+#define NVBLOX_ROS__IMAGE_MASK_MATCHER_HPP_
+
+#include <glog/logging.h>
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "isaac_common/messaging/message_stream_synchronizer.hpp"
+
+namespace nvblox
+{
+
+/// Matches images with their segmentation masks, with a bounded wait for the mask.
+///
+/// The messages are matched by timestamp by an isaac_common MessageStreamSynchronizer, which
+/// stores them in fixed capacity buffers, such that matching doesn't allocate. An image is
+/// matched with the mask within match_tolerance_ns of it. If no such mask arrives within
+/// mask_deadline_ns of the latest matching mask timestamp, i.e. the mask is late or was dropped,
+/// the image is passed on without a mask rather than holding up the following images. An image
+/// is also passed on without a mask as soon as a later mask arrives. Left over masks are dropped.
+///
+/// The deadline is evaluated against the timestamps passed to addImage() and flushExpired(), so
+/// a stalled mask stream delays an image until the next image arrives, or until the next call
+/// to flushExpired().
+///
+/// All functions are thread-safe. The callback is called from within addImage(), addMask() and
+/// flushExpired(), with a lock held.
+/// @tparam MessageType The type of both the images and the masks, e.g. a tuple of a shared image
+/// pointer and camera info. Must be default constructible.
+template<typename MessageType>
+class ImageMaskMatcher
+{
+public:
+  /// Called for every image, with its mask, or with nullptr if no mask was matched.
+  using CallbackType = std::function<void (const MessageType & image, const MessageType * mask)>;
+
+  /// Constructor
+  /// @param match_tolerance_ns Maximum difference between the timestamps of an image and its
+  /// mask.
+  /// @param mask_deadline_ns Maximum time an image waits for its mask.
+  /// @param buffer_size The number of images (and masks) held while waiting for a match. When
+  /// full, the oldest is dropped.
+  /// @param callback Called for every matched or expired image.
+  ImageMaskMatcher(
+    int64_t match_tolerance_ns, int64_t mask_deadline_ns, int buffer_size,
+    CallbackType callback);
+
+  /// Add an image, and pass on all images whose deadline expired up to its timestamp.
+  /// @param stamp_ns Timestamp of the image.
+  /// @param image The image.
+  void addImage(int64_t stamp_ns, const MessageType & image);
+
+  /// Add a mask.
+  /// @param stamp_ns Timestamp of the mask.
+  /// @param mask The mask.
+  void addMask(int64_t stamp_ns, const MessageType & mask);
+
+  /// Pass on the images that waited for their masks for more than mask_deadline_ns.
+  /// @param now_ns The current time, on the clock of the timestamps.
+  void flushExpired(int64_t now_ns);
+
+  /// Drops all images and masks waiting for a match.
+  void clear();
+
+  /// The number of images passed on with a mask.
+  int64_t numMatched() const;
+  /// The number of images passed on without a mask.
+  int64_t numUnmasked() const;
+  /// The number of masks that weren't matched with an image.
+  int64_t numDroppedMasks() const;
+
+private:
+  static constexpr int kImageIdx = 0;
+  static constexpr int kMaskIdx = 1;
+
+  void synchronizerCallback(const std::vector<std::pair<int, MessageType>> & messages);
+
+  const int64_t match_tolerance_ns_;
+  const int64_t mask_deadline_ns_;
+  const CallbackType callback_;
+
+  mutable std::mutex mutex_;
+  nvidia::isaac_common::messaging::MessageStreamSynchronizer<MessageType> synchronizer_;
+  int64_t num_matched_ = 0;
+  int64_t num_unmasked_ = 0;
+  int64_t num_dropped_masks_ = 0;
+};
+
+}  // namespace nvblox
+
+#include "nvblox_ros/impl/image_mask_matcher_impl.hpp"
+
+#endif  // NVBLOX_ROS__IMAGE_MASK_MATCHER_HPP_
@@ -0,0 +1,116 @@
+// SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+// Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+#ifndef NVBLOX_ROS__IMPL__IMAGE_MASK_MATCHER_IMPL_HPP_
+#define NVBLOX_ROS__IMPL__IMAGE_MASK_MATCHER_IMPL_HPP_
+
+#include <utility>
+#include <vector>
+
+namespace nvblox
+{
+
+template<typename MessageType>
+ImageMaskMatcher<MessageType>::ImageMaskMatcher(
+  int64_t match_tolerance_ns, int64_t mask_deadline_ns, int buffer_size,
+  CallbackType callback)
+: match_tolerance_ns_(match_tolerance_ns),
+  mask_deadline_ns_(mask_deadline_ns),
+  callback_(std::move(callback)),
+  // Images are passed on by themselves at the latest, so a single message suffices for a match.
+  synchronizer_(2, static_cast<int>(match_tolerance_ns), 1, buffer_size)
+{
+  CHECK_GE(match_tolerance_ns_, 0);
+  CHECK_GE(mask_deadline_ns_, 0);
+  CHECK_GT(buffer_size, 0);
+  CHECK(callback_);
+  synchronizer_.RegisterCallback(
+    [this](int64_t, const std::vector<std::pair<int, MessageType>> & messages) {
+      synchronizerCallback(messages);
+    });
+}
+
+template<typename MessageType>
+void ImageMaskMatcher<MessageType>::addImage(int64_t stamp_ns, const MessageType & image)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  synchronizer_.AddMessage(kImageIdx, stamp_ns, image);
+  synchronizer_.FlushUpto(stamp_ns - mask_deadline_ns_);
+}
+
+template<typename MessageType>
+void ImageMaskMatcher<MessageType>::addMask(int64_t stamp_ns, const MessageType & mask)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  synchronizer_.AddMessage(kMaskIdx, stamp_ns, mask);
+}
+
+template<typename MessageType>
+void ImageMaskMatcher<MessageType>::flushExpired(int64_t now_ns)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  synchronizer_.FlushUpto(now_ns - mask_deadline_ns_);
+}
+
+template<typename MessageType>
+void ImageMaskMatcher<MessageType>::clear()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  synchronizer_.ClearBuffers();
+}
+
+template<typename MessageType>
+int64_t ImageMaskMatcher<MessageType>::numMatched() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return num_matched_;
+}
+
+template<typename MessageType>
+int64_t ImageMaskMatcher<MessageType>::numUnmasked() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return num_unmasked_;
+}
+
+template<typename MessageType>
+int64_t ImageMaskMatcher<MessageType>::numDroppedMasks() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return num_dropped_masks_;
+}
+
+template<typename MessageType>
+void ImageMaskMatcher<MessageType>::synchronizerCallback(
+  const std::vector<std::pair<int, MessageType>> & messages)
+{
+  // The messages are sorted by topic index, so the image comes first.
+  if (messages.front().first != kImageIdx) {
+    ++num_dropped_masks_;
+    return;
+  }
+  if (messages.size() > 1) {
+    ++num_matched_;
+    callback_(messages[0].second, &messages[1].second);
+  } else {
+    ++num_unmasked_;
+    callback_(messages[0].second, nullptr);
+  }
+}
+
+}  // namespace nvblox
+
+#endif  // NVBLOX_ROS__IMPL__IMAGE_MASK_MATCHER_IMPL_HPP_
@@ -0,0 +1,166 @@
+// SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+// Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef NVBLOX_ROS__IMPL__INPUT_QUEUE_IMPL_HPP_
+#define NVBLOX_ROS__IMPL__INPUT_QUEUE_IMPL_HPP_
+
+#include <utility>
+#include <vector>
+
+namespace nvblox
+{
+
+template<typename QueuedType>
+InputQueue<QueuedType>::InputQueue(size_t capacity)
+: capacity_(capacity), slots_(new Slot[capacity])
+{
+  CHECK_GT(capacity_, 0u);
+  for (size_t i = 0; i < capacity_; i++) {
+    slots_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+  // Held back items plus a full drain of the slots.
+  held_back_items_.reserve(2 * capacity_);
+  held_back_items_tmp_.reserve(2 * capacity_);
+}
+
+template<typename QueuedType>
+bool InputQueue<QueuedType>::push(QueuedType item)
+{
+  bool dropped = false;
+  // If the queue is full, drop the oldest item and try again. This only loops more than once if
+  // other producers refill the queue in between.
+  while (!tryPush(&item)) {
+    QueuedType oldest_item;
+    if (tryPop(&oldest_item)) {
+      num_dropped_.fetch_add(1, std::memory_order_relaxed);
+      dropped = true;
+    }
+  }
+  return dropped;
+}
+
+template<typename QueuedType>
+void InputQueue<QueuedType>::extractReadyItems(
+  const ReadyCheckFunctionType & ready_check_function,
+  std::vector<QueuedType> * ready_items)
+{
+  CHECK_NOTNULL(ready_items);
+  // Items held back from the last call are older than the ones in the slots, so they go first.
+  QueuedType item;
+  while (tryPop(&item)) {
+    held_back_items_.push_back(std::move(item));
+  }
+  // Bound the held back items too. Without this, items that never become ready would grow the
+  // buffer indefinitely.
+  if (held_back_items_.size() > capacity_) {
+    const size_t num_to_drop = held_back_items_.size() - capacity_;
+    held_back_items_.erase(held_back_items_.begin(), held_back_items_.begin() + num_to_drop);
+    num_dropped_.fetch_add(static_cast<int>(num_to_drop), std::memory_order_relaxed);
+  }
+
+  held_back_items_tmp_.clear();
+  for (QueuedType & held_back_item : held_back_items_) {
+    if (ready_check_function(held_back_item)) {
+      ready_items->push_back(std::move(held_back_item));
+    } else {
+      held_back_items_tmp_.push_back(std::move(held_back_item));
+    }
+  }
+  std::swap(held_back_items_, held_back_items_tmp_);
+}
+
+template<typename QueuedType>
+bool InputQueue<QueuedType>::empty() const
+{
+  return held_back_items_.empty() &&
+         push_position_.load(std::memory_order_acquire) ==
+         pop_position_.load(std::memory_order_acquire);
+}
+
+template<typename QueuedType>
+size_t InputQueue<QueuedType>::size() const
+{
+  const size_t pop_position = pop_position_.load(std::memory_order_acquire);
+  const size_t push_position = push_position_.load(std::memory_order_acquire);
+  return push_position > pop_position ? push_position - pop_position : 0;
+}
+
+template<typename QueuedType>
+bool InputQueue<QueuedType>::tryPush(QueuedType * item)
+{
+  size_t position = push_position_.load(std::memory_order_relaxed);
+  Slot * slot;
+  while (true) {
+    slot = &slots_[position % capacity_];
+    const size_t sequence = slot->sequence.load(std::memory_order_acquire);
+    const intptr_t difference =
+      static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+    if (difference == 0) {
+      // The slot is free. Claim it.
+      if (push_position_.compare_exchange_weak(
+          position, position + 1, std::memory_order_relaxed))
+      {
+        break;
+      }
+    } else if (difference < 0) {
+      // The slot still holds an item from the previous lap: full.
+      return false;
+    } else {
+      // Another producer claimed the slot first.
+      position = push_position_.load(std::memory_order_relaxed);
+    }
+  }
+  slot->item = std::move(*item);
+  slot->sequence.store(position + 1, std::memory_order_release);
+  return true;
+}
+
+template<typename QueuedType>
+bool InputQueue<QueuedType>::tryPop(QueuedType * item)
+{
+  size_t position = pop_position_.load(std::memory_order_relaxed);
+  Slot * slot;
+  while (true) {
+    slot = &slots_[position % capacity_];
+    const size_t sequence = slot->sequence.load(std::memory_order_acquire);
+    const intptr_t difference =
+      static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position + 1);
+    if (difference == 0) {
+      // The slot holds an item. Claim it.
+      if (pop_position_.compare_exchange_weak(
+          position, position + 1, std::memory_order_relaxed))
+      {
+        break;
+      }
+    } else if (difference < 0) {
+      // The slot hasn't been written yet: empty.
+      return false;
+    } else {
+      // Another consumer (or a dropping producer) claimed the slot first.
+      position = pop_position_.load(std::memory_order_relaxed);
+    }
+  }
+  *item = std::move(slot->item);
+  // Release what the item refers to now rather than when the slot is overwritten.
+  slot->item = QueuedType();
+  slot->sequence.store(position + capacity_, std::memory_order_release);
+  return true;
+}
+
+}  // namespace nvblox
+
+#endif  // NVBLOX_ROS__IMPL__INPUT_QUEUE_IMPL_HPP_
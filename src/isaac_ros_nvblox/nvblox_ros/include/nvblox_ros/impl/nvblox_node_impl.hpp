@@ -19,12 +19,13 @@
 #define NVBLOX_ROS__IMPL__NVBLOX_NODE_IMPL_HPP_
 
 #include <nvblox/utils/delays.h>
+#include <nvblox/utils/flight_recorder.h>
 #include <nvblox/utils/rates.h>
 #include <nvblox/utils/timing.h>
 
-#include <list>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace nvblox
@@ -32,7 +33,7 @@ namespace nvblox
 
 template<typename QueuedType>
 void NvbloxNode::processQueue(
-  std::unique_ptr<std::list<QueuedType>> & queue_ptr, std::mutex * queue_mutex_ptr,
+  std::unique_ptr<InputQueue<QueuedType>> & queue_ptr,
   ReadyCheckFunctionType<QueuedType> ready_check_function,
   ProcessFunctionType<QueuedType> process_function)
 {
@@ -41,22 +42,10 @@ void NvbloxNode::processQueue(
     return;
   }
 
-  // To avoid holding onto the queue lock longer than necessary, we first create copies of the
-  // elements in the queue before processing them.
-  std::unique_lock<std::mutex> lock(*queue_mutex_ptr);
+  // Move the ready items out of the queue before processing them, such that producers can keep
+  // pushing in the meantime.
   std::vector<QueuedType> items_to_process;
-  items_to_process.reserve(queue_ptr->size());
-
-  typename std::list<QueuedType>::iterator itr = queue_ptr->begin();
-  while (itr != queue_ptr->end()) {
-    if (ready_check_function(*itr)) {
-      items_to_process.push_back(*itr);
-      itr = queue_ptr->erase(itr);
-    } else {
-      ++itr;
-    }
-  }
-  lock.unlock();
+  queue_ptr->extractReadyItems(ready_check_function, &items_to_process);
 
   // Process all items
   for (auto item : items_to_process) {
@@ -68,36 +57,46 @@ void NvbloxNode::processQueue(
 template<typename QueuedType>
 void NvbloxNode::pushOntoQueue(
   const std::string & queue_name, QueuedType item,
-  std::unique_ptr<std::list<QueuedType>> & queue_ptr,
-  std::mutex * queue_mutex_ptr)
+  std::unique_ptr<InputQueue<QueuedType>> & queue_ptr)
 {
-  timing::Timer lock_timer("ros/push_onto_queue");
-  std::unique_lock<std::mutex> lock(*queue_mutex_ptr);
-  // Size should never grow larger than allowed since this is the only place where we push to the
-  // queue.
-  CHECK(queue_ptr->size() <= static_cast<size_t>(params_.maximum_input_queue_length));
+  timing::Timer push_timer("ros/push_onto_queue");
+  // The queue drops the oldest item if it's full.
+  const bool dropped = queue_ptr->push(std::move(item));
 
-  queue_ptr->emplace_back(item);
-  const int queue_ptr_size = queue_ptr->size();
+  if (dropped) {
+    number_of_dropped_queued_items_[queue_name] = queue_ptr->numDropped();
+  }
 
-  // Remove oldest item if queue is full
-  if (queue_ptr_size > params_.maximum_input_queue_length) {
-    queue_ptr->pop_front();
-    lock.unlock();
+  // Only pay for the metrics if they're served.
+  if (metrics_server_) {
+    const timing::MetricLabels labels = {{"queue", queue_name}};
+    timing::Metrics::setGauge(
+      "nvblox_ros_input_queue_depth", "The number of items waiting in an input queue.", labels,
+      static_cast<double>(queue_ptr->size()));
+    if (dropped) {
+      timing::Metrics::addToCounter(
+        "nvblox_ros_input_queue_dropped_items",
+        "Items dropped from an input queue because it was full.", labels);
+    }
+  }
 
-    // Print some debug info
-    if (params_.print_queue_drops_to_console) {
-      number_of_dropped_queued_items_[queue_name]++;
-      auto & clk = *get_clock();
-      RCLCPP_INFO_STREAM_THROTTLE(
-        get_logger(), clk, params_.print_statistics_on_console_period_ms,
-        "Dropped an item from: " <<
-          queue_name << ". Size of queue: " << queue_ptr_size <<
-          ". Total number of dropped items is: " <<
-          number_of_dropped_queued_items_[queue_name]);
+  if (timing::FlightRecorder::isEnabled()) {
+    timing::FlightRecorder::recordCounter(
+      "ros/queue_depth/" + queue_name, static_cast<double>(queue_ptr->size()));
+    if (dropped) {
+      timing::FlightRecorder::recordInstant("ros/queue_drop/" + queue_name);
     }
-  } else {
-    lock.unlock();
+  }
+
+  // Print some debug info
+  if (dropped && params_.print_queue_drops_to_console) {
+    auto & clk = *get_clock();
+    RCLCPP_INFO_STREAM_THROTTLE(
+      get_logger(), clk, params_.print_statistics_on_console_period_ms,
+      "Dropped an item from: " <<
+        queue_name << ". Capacity of queue: " << queue_ptr->capacity() <<
+        ". Total number of dropped items is: " <<
+        number_of_dropped_queued_items_[queue_name]);
   }
 }
 
@@ -0,0 +1,195 @@
+// SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+// Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef NVBLOX_ROS__INDEXED_ROSBAG_DATA_LOADER_HPP_
+#define NVBLOX_ROS__INDEXED_ROSBAG_DATA_LOADER_HPP_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "nvblox/datasets/data_loader.h"
+#include "nvblox/executables/fuser.h"
+#include "nvblox/nvblox.h"
+
+#include "rclcpp/logger.hpp"
+
+#include "nvblox_ros/conversions/image_conversions_thrust.hpp"
+#include "nvblox_ros/rosbag_frame_index.hpp"
+
+namespace nvblox
+{
+namespace datasets
+{
+namespace ros
+{
+
+/// Builds a Fuser that returns nvblox data from a ROSbag using the IndexedRosDataLoader.
+/// See @createFuser in rosbag_data_loader.hpp for params.
+/// @param prefetch_queue_size Number of frames the background reader loads ahead.
+std::unique_ptr<Fuser> createIndexedFuser(
+  const std::string & rosbag_path,               // NOLINT
+  const std::string & depth_topic,               // NOLINT
+  const std::string & depth_camera_info_topic,   // NOLINT
+  const std::string & color_topic,               // NOLINT
+  const std::string & color_camera_info_topic,   // NOLINT
+  const std::string & global_frame_id,           // NOLINT
+  const float tf_preload_time_s,                 // NOLINT
+  const int prefetch_queue_size = 8,             // NOLINT
+  std::shared_ptr<CudaStream> cuda_stream =
+  std::make_shared<CudaStreamOwning>());
+
+/// An nvblox data loader which loads data from a ROSbag, ahead of the caller.
+///
+/// In contrast to the RosDataLoader, which steps through the bag message by message on the
+/// calling thread, this loader:
+/// - indexes the matching depth/color/camera_info tuples in a first pass (see
+///   RosbagFrameIndex), such that non-matching messages are never deserialized, and
+/// - deserializes, converts and uploads the indexed frames to the GPU on a background thread,
+///   into a bounded queue of ready frames.
+/// loadNext() then only copies a ready frame on the GPU. The loader also supports seeking.
+///
+/// Like the RosDataLoader, it expects *exact* timestamp matches between the depth, color and
+/// camera_info topics. /tf is loaded such that it preceeds the images by tf_preload_time_s.
+/// Frames for which the camera poses can't be looked up are returned as kBadFrame.
+class IndexedRosDataLoader : public datasets::RgbdDataLoaderInterface
+{
+public:
+  /// Construct a data loader that returns nvblox data from a ROSbag.
+  /// See @RosDataLoader for params.
+  /// @param prefetch_queue_size Number of frames the background reader loads ahead.
+  IndexedRosDataLoader(
+    const std::string & rosbag_path,                         // NOLINT
+    const std::string & depth_topic,                         // NOLINT
+    const std::string & depth_camera_info_topic,             // NOLINT
+    const std::string & color_topic,                         // NOLINT
+    const std::string & color_camera_info_topic,             // NOLINT
+    const std::string & global_frame_id,                     // NOLINT
+    const float tf_preload_time_s,                           // NOLINT
+    const int prefetch_queue_size = 8,                       // NOLINT
+    std::shared_ptr<CudaStream> cuda_stream =
+    std::make_shared<CudaStreamOwning>());
+  virtual ~IndexedRosDataLoader();
+
+  /// Builds an IndexedRosDataLoader. See the constructor for params.
+  /// @return The dataset loader. May be nullptr if the bag contains no matching frames.
+  static std::unique_ptr<IndexedRosDataLoader> create(
+    const std::string & rosbag_path,               // NOLINT
+    const std::string & depth_topic,               // NOLINT
+    const std::string & depth_camera_info_topic,   // NOLINT
+    const std::string & color_topic,               // NOLINT
+    const std::string & color_camera_info_topic,   // NOLINT
+    const std::string & global_frame_id,           // NOLINT
+    const float tf_preload_time_s,                 // NOLINT
+    const int prefetch_queue_size = 8,             // NOLINT
+    std::shared_ptr<CudaStream> cuda_stream =
+    std::make_shared<CudaStreamOwning>());
+
+  /// See @RgbdDataLoaderInterface::loadNext. Single camera version.
+  DataLoadResult loadNext(
+    DepthImage * depth_frame_ptr,                       // NOLINT
+    Transform * T_L_C_ptr,                              // NOLINT
+    Camera * camera_ptr,                                // NOLINT
+    ColorImage * color_frame_ptr = nullptr) override;
+
+  /// See @RgbdDataLoaderInterface::loadNext. Separate depth and color cameras version.
+  DataLoadResult loadNext(
+    DepthImage * depth_frame_ptr,                       // NOLINT
+    Transform * T_L_D_ptr,                              // NOLINT
+    Camera * depth_camera_ptr,                          // NOLINT
+    ColorImage * color_frame_ptr,                       // NOLINT
+    Transform * T_L_C_ptr,                              // NOLINT
+    Camera * color_camera_ptr) override;
+
+  /// Continue loading at the first frame at or after a time.
+  /// Drops all prefetched frames and restarts the background reader.
+  /// @param stamp_ns The header stamp to seek to.
+  /// @return False if there are no frames at or after the time.
+  bool seek(uint64_t stamp_ns);
+
+  /// The index of the frames in the bag.
+  const RosbagFrameIndex & index() const {return index_;}
+
+private:
+  // A frame which is ready to be returned.
+  struct Frame
+  {
+    Frame()
+    : depth(MemoryType::kDevice), color(MemoryType::kDevice) {}
+    DepthImage depth;
+    ColorImage color;
+    Camera depth_camera;
+    Camera color_camera;
+    Transform T_L_D;
+    Transform T_L_C;
+    bool valid = false;
+  };
+
+  // Start the background reader at a frame of the index.
+  void startReader(size_t first_frame_index);
+  // Stop the background reader and drop all prefetched frames.
+  void stopReader();
+  // Background reader loop.
+  void readerLoop(size_t first_frame_index);
+  // Push a frame into the queue of ready frames. Blocks while the queue is full.
+  // Returns false if the reader was stopped.
+  bool pushFrame(std::unique_ptr<Frame> frame);
+  // Get a recycled or new frame.
+  std::unique_ptr<Frame> getEmptyFrame();
+
+  const std::string rosbag_path_;
+  const std::string depth_topic_;
+  const std::string depth_camera_info_topic_;
+  const std::string color_topic_;
+  const std::string color_camera_info_topic_;
+  const std::string global_frame_id_;
+  const float tf_lead_time_s_;
+  const size_t prefetch_queue_size_;
+
+  // The matching frames in the bag.
+  const RosbagFrameIndex index_;
+
+  // ROS logging.
+  rclcpp::Logger ros_logger_;
+
+  // The background reader and its state.
+  std::thread reader_thread_;
+  std::atomic<bool> stop_reader_{false};
+
+  // Frames ready to be returned, in index order, and frames available for reuse.
+  std::mutex mutex_;
+  std::condition_variable queue_not_full_;
+  std::condition_variable queue_not_empty_;
+  std::deque<std::unique_ptr<Frame>> ready_frames_;
+  std::vector<std::unique_ptr<Frame>> recycled_frames_;
+  bool reader_finished_ = false;
+
+  // Streams on which the reader converts, and on which frames are returned.
+  CudaStreamOwning reader_cuda_stream_;
+  std::shared_ptr<CudaStream> cuda_stream_;
+};
+
+}  // namespace ros
+}  // namespace datasets
+}  // namespace nvblox
+
+#endif  // NVBLOX_ROS__INDEXED_ROSBAG_DATA_LOADER_HPP_
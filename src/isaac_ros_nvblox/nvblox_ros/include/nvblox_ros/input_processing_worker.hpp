@@ -0,0 +1,87 @@
+// SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+// Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+#ifndef NVBLOX_ROS__INPUT_PROCESSING_WORKER_HPP_
+#define NVBLOX_ROS__INPUT_PROCESSING_WORKER_HPP_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace nvblox
+{
+
+/// Processes the input queues on a dedicated thread, whenever something may have become ready.
+///
+/// Instead of polling the queues from a timer, which delays an image whose pose arrives just
+/// after a poll by a full timer period and re-checks the poses in every idle poll, the worker
+/// sleeps on a condition variable until notify() is called, e.g. when an image is queued or the
+/// Transformer receives new transforms. Notifications arriving while the queues are processed
+/// are coalesced into a single further pass, such that no wakeup is lost and a burst of
+/// notifications doesn't cause a burst of passes.
+///
+/// A fallback period bounds the wait, for inputs becoming ready without a notification.
+///
+/// Usage:
+///   InputProcessingWorker worker([this]() {processDepthQueue(); processColorQueue();});
+///   // In the image callbacks, after pushing the image, and in the transform callback:
+///   worker.notify();
+class InputProcessingWorker
+{
+public:
+  using ProcessFunction = std::function<void ()>;
+
+  /// Starts the worker thread.
+  /// @param process_function Processes the ready items of the queues. Run on the worker thread.
+  /// @param fallback_period Maximum time between two passes, even without notifications.
+  explicit InputProcessingWorker(
+    ProcessFunction process_function,
+    std::chrono::milliseconds fallback_period = std::chrono::milliseconds(100));
+
+  /// Finishes the current pass and joins the worker thread.
+  ~InputProcessingWorker();
+
+  InputProcessingWorker(const InputProcessingWorker &) = delete;
+  InputProcessingWorker & operator=(const InputProcessingWorker &) = delete;
+
+  /// Wakes the worker for a pass over the queues. Returns immediately. Thread-safe.
+  void notify();
+
+  /// The number of passes, in total and of those which were not triggered by a notification.
+  int64_t numPasses() const;
+  int64_t numFallbackPasses() const;
+
+private:
+  void run();
+
+  const ProcessFunction process_function_;
+  const std::chrono::milliseconds fallback_period_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable notified_cv_;
+  bool notified_ = false;
+  bool stop_ = false;
+  int64_t num_passes_ = 0;
+  int64_t num_fallback_passes_ = 0;
+  std::thread thread_;
+};
+
+}  // namespace nvblox
+
+#endif  // NVBLOX_ROS__INPUT_PROCESSING_WORKER_HPP_
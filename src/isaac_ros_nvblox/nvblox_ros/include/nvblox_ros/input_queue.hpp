@@ -0,0 +1,112 @@
+// SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+// Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef NVBLOX_ROS__INPUT_QUEUE_HPP_
+#define NVBLOX_ROS__INPUT_QUEUE_HPP_
+
+#include <glog/logging.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace nvblox
+{
+
+/// A bounded queue for input messages, with a drop-oldest policy.
+///
+/// Pushing is lock-free and does not allocate: items are stored in slots that are allocated once
+/// on construction (a bounded queue with per-slot sequence numbers, after D. Vyukov). When the
+/// queue is full, push() drops the oldest item to make space.
+///
+/// Items are consumed with extractReadyItems(), which must only be called from a single thread.
+/// Items that are not yet ready are held back (in order) in a consumer-side buffer, such that
+/// they're checked again on the next call.
+/// @tparam QueuedType The type of the queued items. Must be default constructible.
+template<typename QueuedType>
+class InputQueue
+{
+public:
+  using ReadyCheckFunctionType = std::function<bool (const QueuedType &)>;
+
+  /// Constructor
+  /// @param capacity The maximum number of items held by the queue.
+  explicit InputQueue(size_t capacity);
+  ~InputQueue() = default;
+
+  InputQueue(const InputQueue &) = delete;
+  InputQueue & operator=(const InputQueue &) = delete;
+
+  /// Add an item to the queue. Safe to call from several threads concurrently.
+  /// @param item The item to add.
+  /// @return True if the oldest item had to be dropped to make space.
+  bool push(QueuedType item);
+
+  /// Moves all items passing the ready check out of the queue, oldest first. Single consumer.
+  /// @param ready_check_function Called on each item to check if it's ready to be processed.
+  /// @param ready_items Output vector which the ready items are appended to.
+  void extractReadyItems(
+    const ReadyCheckFunctionType & ready_check_function,
+    std::vector<QueuedType> * ready_items);
+
+  /// Whether the queue is (approximately) empty.
+  bool empty() const;
+
+  /// The (approximate) number of items in the queue, not counting the held back ones. Safe to
+  /// call from any thread.
+  size_t size() const;
+
+  /// The number of items that have been dropped because the queue was full.
+  int numDropped() const {return num_dropped_.load(std::memory_order_relaxed);}
+
+  /// The maximum number of items held by the queue.
+  size_t capacity() const {return capacity_;}
+
+private:
+  struct Slot
+  {
+    std::atomic<size_t> sequence;
+    QueuedType item;
+  };
+
+  // Lock-free primitives on the slots.
+  bool tryPush(QueuedType * item);
+  bool tryPop(QueuedType * item);
+
+  const size_t capacity_;
+  std::unique_ptr<Slot[]> slots_;
+
+  // The positions are kept on separate cache lines to stop producer and consumer from
+  // invalidating each other's cache.
+  alignas(64) std::atomic<size_t> push_position_{0};
+  alignas(64) std::atomic<size_t> pop_position_{0};
+  alignas(64) std::atomic<int> num_dropped_{0};
+
+  // Items that were popped but not yet ready. Only accessed by the consumer.
+  std::vector<QueuedType> held_back_items_;
+  std::vector<QueuedType> held_back_items_tmp_;
+};
+
+}  // namespace nvblox
+
+#include "nvblox_ros/impl/input_queue_impl.hpp"
+
+#endif  // NVBLOX_ROS__INPUT_QUEUE_HPP_
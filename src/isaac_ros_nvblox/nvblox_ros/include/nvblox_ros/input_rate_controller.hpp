@@ -0,0 +1,138 @@
+// SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+// Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+#ifndef NVBLOX_ROS__INPUT_RATE_CONTROLLER_HPP_
+#define NVBLOX_ROS__INPUT_RATE_CONTROLLER_HPP_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace nvblox
+{
+
+/// Decides which camera frames to integrate such that integration keeps up with the input.
+///
+/// The cost of integrating a frame is measured from the timing::Timer(s) of the integration.
+/// Together with a target GPU utilization this gives the number of frames per second that can
+/// be integrated. This budget is shared between the cameras in proportion to their weights
+/// (e.g. higher for forward-facing cameras), where cameras that need less than their share only
+/// get their input rate and leave the rest to the others. Each camera then integrates an evenly
+/// spaced subset of its frames at its allowed rate.
+///
+/// Compared to letting the input queues overflow, this keeps the queues short, and drops frames
+/// of all cameras evenly rather than in bursts.
+///
+/// Usage, for each incoming frame of a camera:
+///   if (input_rate_controller_.shouldIntegrate(camera_id, stamp_ns)) {
+///     pushOntoQueue(...);
+///   }
+class InputRateController
+{
+public:
+  using CameraId = int;
+
+  /// Constructor
+  /// @param integration_timer_tags Tags of the timing::Timer(s) measuring the integration of a
+  /// frame. The cost of a frame is the sum over these timers.
+  explicit InputRateController(const std::vector<std::string> & integration_timer_tags);
+
+  /// Register a camera.
+  /// @param name Name of the camera, used for logging.
+  /// @param weight Share of the budget relative to the other cameras.
+  /// @return The id used to refer to this camera.
+  CameraId registerCamera(const std::string & name, float weight = 1.F);
+
+  /// Returns true if a frame should be integrated. Should be called for every frame received,
+  /// as the input rate is measured from these calls.
+  /// @param camera_id The camera the frame is from.
+  /// @param stamp_ns The timestamp of the frame in nanoseconds.
+  /// @return True if the frame should be integrated.
+  bool shouldIntegrate(CameraId camera_id, int64_t stamp_ns);
+
+  /// The measured rate at which frames of a camera arrive.
+  /// @param camera_id The camera.
+  /// @return The rate in Hz, zero before two frames were received.
+  float inputRateHz(CameraId camera_id) const;
+
+  /// The rate at which frames of a camera are currently integrated.
+  /// @param camera_id The camera.
+  /// @return The rate in Hz.
+  float allowedRateHz(CameraId camera_id) const;
+
+  /// Total number of frames of a camera that were not integrated.
+  /// @param camera_id The camera.
+  /// @return The number of skipped frames.
+  int numSkipped(CameraId camera_id) const;
+
+  /// The measured cost of integrating a frame.
+  /// @return The cost in milliseconds, zero before any integration was timed.
+  float integrationCostMs() const {return integration_cost_s_ * 1000.F;}
+
+  /// A parameter getter
+  /// The fraction of the time integration may take. The remainder is left for the other work of
+  /// the node (e.g. ESDF and mesh updates).
+  float target_utilization() const {return target_utilization_;}
+
+  /// A parameter setter
+  /// See target_utilization().
+  void target_utilization(float target_utilization);
+
+  /// A parameter getter
+  /// The rate below which a camera is never throttled, such that no camera starves.
+  float min_rate_hz() const {return min_rate_hz_;}
+
+  /// A parameter setter
+  /// See min_rate_hz().
+  void min_rate_hz(float min_rate_hz);
+
+private:
+  struct CameraState
+  {
+    std::string name;
+    float weight;
+    int64_t last_stamp_ns = -1;
+    float mean_period_s = 0.F;
+    float allowed_rate_hz = 0.F;
+    // Accumulates the fraction of frames to integrate. A frame is integrated when this reaches
+    // one, which spreads the integrated frames evenly.
+    float credit = 1.F;
+    int num_skipped = 0;
+  };
+
+  struct TimerState
+  {
+    std::string tag;
+    double last_total_s = 0.0;
+    size_t last_num_samples = 0;
+  };
+
+  // Update the integration cost from the samples added to the timers since the last update.
+  void updateIntegrationCost();
+
+  // Share the budget between the cameras.
+  void updateAllowedRates();
+
+  float target_utilization_ = 0.8F;
+  float min_rate_hz_ = 1.F;
+  float integration_cost_s_ = 0.F;
+  std::vector<TimerState> timers_;
+  std::vector<CameraState> cameras_;
+};
+
+}  // namespace nvblox
+
+#endif  // NVBLOX_ROS__INPUT_RATE_CONTROLLER_HPP_
@@ -0,0 +1,140 @@
+// SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+// Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef NVBLOX_ROS__LATENCY_TRACKER_HPP_
+#define NVBLOX_ROS__LATENCY_TRACKER_HPP_
+
+#include <nvblox/core/time.h>
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <diagnostic_msgs/msg/diagnostic_status.hpp>
+
+namespace nvblox
+{
+
+/// The latency of a published output with respect to one input source (e.g. a camera).
+struct SourceLatency
+{
+  std::string source;
+  /// Time stamp of the newest input of the source that contributed to the output.
+  Time input_stamp;
+  /// Age of that input at publish time: publish time minus input time stamp.
+  Time age;
+  /// Time that input waited between being received and being integrated.
+  Time queue_wait;
+};
+
+/// Tracks the age of the inputs behind each published output (age-of-information).
+///
+/// The time stamps of incoming messages are carried from the input queues through integration
+/// and the stages computed from the integrated map (e.g. the ESDF), up to the published outputs.
+/// All measurements are also recorded in timing::Delays, under the tags
+///   "ros/latency/<source>/queue_wait"      receive -> integration,
+///   "ros/latency/<source>/integration"     input stamp -> integration,
+///   "ros/latency/<output>/<source>/age"    input stamp -> publish.
+/// All times are in nanoseconds, on the clock of the input time stamps.
+///
+/// Usage:
+///   latency_tracker_.inputReceived("camera_0", stamp, now);     // pushOntoQueue()
+///   latency_tracker_.inputIntegrated("camera_0", stamp, now);   // processDepthImage()
+///   latency_tracker_.stageCompleted("esdf");                    // processEsdf()
+///   latency_tracker_.outputPublished("static_map_slice", "esdf", now);
+///
+/// Thread-safe, such that inputs and outputs may be handled on different threads.
+class LatencyTracker
+{
+public:
+  LatencyTracker() = default;
+  ~LatencyTracker() = default;
+
+  /// Record that an input message has been received (i.e. pushed onto an input queue).
+  /// @param source The input source, e.g. the camera.
+  /// @param stamp The time stamp of the message.
+  /// @param receive_time The time at which the message was received.
+  void inputReceived(const std::string & source, Time stamp, Time receive_time);
+
+  /// Record that an input message has been integrated into the map.
+  /// @param source The input source, e.g. the camera.
+  /// @param stamp The time stamp of the message.
+  /// @param integrate_time The time at which the message was integrated.
+  void inputIntegrated(const std::string & source, Time stamp, Time integrate_time);
+
+  /// Record that a stage computed from the integrated map (e.g. the ESDF) has completed. Outputs
+  /// of the stage are attributed to the inputs integrated up to this point.
+  /// @param stage The name of the stage.
+  void stageCompleted(const std::string & stage);
+
+  /// Record that an output has been published.
+  /// @param output The name of the output, e.g. the topic.
+  /// @param stage The stage the output was computed from. If empty (or the stage never
+  /// completed), the output is attributed to the inputs integrated so far.
+  /// @param publish_time The time of publishing.
+  /// @return The latency with respect to every source that contributed to the output.
+  std::vector<SourceLatency> outputPublished(
+    const std::string & output, const std::string & stage, Time publish_time);
+
+  /// A parameter getter
+  /// The maximum number of received but not yet integrated inputs tracked per source. Older ones
+  /// are forgotten, e.g. when inputs get dropped from the queues.
+  size_t max_num_pending_inputs() const {return max_num_pending_inputs_;}
+
+  /// A parameter setter
+  /// See max_num_pending_inputs().
+  void max_num_pending_inputs(size_t max_num_pending_inputs);
+
+private:
+  struct IntegratedInput
+  {
+    Time stamp;
+    Time queue_wait;
+  };
+  using IntegratedInputs = std::map<std::string, IntegratedInput>;
+
+  size_t max_num_pending_inputs_ = 64;
+
+  std::mutex mutex_;
+  // Receive time by input stamp, per source.
+  std::unordered_map<std::string, std::map<Time, Time>> receive_times_;
+  // The newest integrated input per source.
+  IntegratedInputs integrated_;
+  // A snapshot of integrated_ per stage, taken when the stage completed.
+  std::unordered_map<std::string, IntegratedInputs> stage_inputs_;
+};
+
+namespace conversions
+{
+
+/// @brief Convert the latencies of a published output to a diagnostic status.
+/// The status lists, in milliseconds, the age and queue wait time of the newest input of every
+/// source contributing to the output. Its level is WARN if any age exceeds the maximum.
+/// @param output The name of the output, used as the name of the status.
+/// @param latencies The latencies, see LatencyTracker::outputPublished().
+/// @param max_age_ms The age above which the status is WARN. Non-positive disables.
+/// @param status_msg The resulting DiagnosticStatus message.
+void latencyToDiagnosticStatusMsg(
+  const std::string & output, const std::vector<SourceLatency> & latencies, float max_age_ms,
+  diagnostic_msgs::msg::DiagnosticStatus * status_msg);
+
+}  // namespace conversions
+}  // namespace nvblox
+
+#endif  // NVBLOX_ROS__LATENCY_TRACKER_HPP_
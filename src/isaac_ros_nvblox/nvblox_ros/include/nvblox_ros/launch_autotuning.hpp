@@ -0,0 +1,33 @@
+// SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+// Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef NVBLOX_ROS__LAUNCH_AUTOTUNING_HPP_
+#define NVBLOX_ROS__LAUNCH_AUTOTUNING_HPP_
+
+#include <rclcpp/rclcpp.hpp>
+
+namespace nvblox
+{
+
+/// Declares the launch_autotuning and launch_autotuning_cache_path parameters and configures the
+/// LaunchAutotuner with them, such that the fastest launch configurations for this GPU are
+/// selected from the cache or by tuning. Called once per process, before the first frame.
+void configureLaunchAutotunerFromParams(rclcpp::Node * node);
+
+}  // namespace nvblox
+
+#endif  // NVBLOX_ROS__LAUNCH_AUTOTUNING_HPP_
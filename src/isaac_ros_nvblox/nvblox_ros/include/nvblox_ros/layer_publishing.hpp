@@ -18,8 +18,11 @@
 #ifndef NVBLOX_ROS__LAYER_PUBLISHING_HPP_
 #define NVBLOX_ROS__LAYER_PUBLISHING_HPP_
 
+#include <functional>
+#include <map>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <rclcpp/rclcpp.hpp>
@@ -29,6 +32,7 @@
 #include <nvblox_msgs/msg/voxel_block_layer.hpp>
 #include "nvblox/nvblox.h"
 #include "nvblox_msgs/msg/mesh.hpp"
+#include "nvblox_msgs/srv/mesh_streaming_roi.hpp"
 #include "nvblox/serialization/layer_serializer_gpu.h"
 #include "nvblox_ros/conversions/pointcloud_conversions.hpp"
 
@@ -62,7 +66,63 @@ public:
     std::shared_ptr<Mapper> static_mapper,
     std::shared_ptr<Mapper> dynamic_mapper, const rclcpp::Logger & logger);
 
+  /// Add, update or remove a region of interest (ROI) subscription of the mesh (see
+  /// MeshStreamingRoi.srv). Each ROI is streamed with its own candidates and bandwidth limit.
+  ///
+  /// @param request The ROI request
+  /// @param T_L_F Transformation from the request frame to the layer frame
+  /// @param mapper The mapper whose mesh is streamed
+  /// @param response Set to the topic of the ROI and whether the request succeeded
+  void setMeshStreamingRoi(
+    const nvblox_msgs::srv::MeshStreamingRoi::Request & request, const Transform & T_L_F,
+    Mapper * mapper, nvblox_msgs::srv::MeshStreamingRoi::Response * response);
+
+  /// Serialize and publish the mesh blocks of each ROI which has subscribers. Radius-based ROIs
+  /// are re-centered on the current pose of their frame first.
+  ///
+  /// @param lookup_T_L_F Looks up the pose of a frame in the layer frame. Returns false if the
+  ///                     pose isn't available, in which case the ROI keeps its last center.
+  /// @param frame_id Frame id for the published topics
+  /// @param timestamp Timestamp for the published topics
+  /// @param mapper The mapper whose mesh is streamed
+  /// @param logger ROS logger
+  void serializeAndPublishMeshStreamingRois(
+    const std::function<bool(const std::string &, Transform *)> & lookup_T_L_F,
+    const std::string & frame_id, const rclcpp::Time & timestamp, Mapper * mapper,
+    const rclcpp::Logger & logger);
+
+  /// Whether to publish without a copy of the message (see publishWithoutCopy()).
+  void use_loaned_messages(bool use_loaned_messages) {use_loaned_messages_ = use_loaned_messages;}
+  bool use_loaned_messages() const {return use_loaned_messages_;}
+
 private:
+  /// Publish a message which is filled in place by fill_message(MessageT *).
+  ///
+  /// Publishing a message by reference copies it for intra-process subscribers. Instead, if the
+  /// middleware can loan messages, the message is written directly into the middleware-owned
+  /// buffer. Otherwise (most middlewares only loan fixed-size messages, which the layer messages
+  /// are not) the message is allocated once and ownership is passed to rclcpp, which hands it to
+  /// intra-process subscribers without copying.
+  template<typename MessageT, typename FillMessageFunctor>
+  void publishWithoutCopy(
+    rclcpp::Publisher<MessageT> & publisher,
+    FillMessageFunctor fill_message)
+  {
+    if (use_loaned_messages_ && publisher.can_loan_messages()) {
+      auto loaned_message = publisher.borrow_loaned_message();
+      fill_message(&loaned_message.get());
+      publisher.publish(std::move(loaned_message));
+    } else if (use_loaned_messages_) {
+      auto message = std::make_unique<MessageT>();
+      fill_message(message.get());
+      publisher.publish(std::move(message));
+    } else {
+      MessageT message;
+      fill_message(&message);
+      publisher.publish(message);
+    }
+  }
+
   /// Determine which layer should be streamed based on active subscribers
   LayerTypeBitMask getLayersToStreamBitMask();
 
@@ -76,10 +136,30 @@ private:
   // Cache the last known number of subscribers.
   size_t mesh_subscriber_count_ = 0;
 
+  // A subscription to the mesh blocks inside an ROI.
+  struct MeshStreamingRoiSubscription
+  {
+    // The id of the ROI in the mapper (see Mapper::addMeshStreamingRoi()).
+    int roi_id = -1;
+    // The frame followed by a radius-based ROI.
+    std::string frame_id;
+    // The region. The AABB is in the layer frame.
+    StreamingRoi roi;
+    float bandwidth_limit_mbps = -1.0;
+    // Publishes on ~/mesh/roi/<name>.
+    rclcpp::Publisher<nvblox_msgs::msg::Mesh>::SharedPtr publisher;
+  };
+  // The ROI subscriptions by name.
+  std::map<std::string, MeshStreamingRoiSubscription> mesh_streaming_rois_;
+
+  // The node, for creating the publishers of the ROIs.
+  rclcpp::Node * node_ = nullptr;
+
   // Params
   float min_tsdf_weight_ = 0;
   float exclusion_height_m_ = -1.0;
   float exclusion_radius_m_ = -1.0;
+  bool use_loaned_messages_ = true;
 
   // Publishers using nvblox plugin. Allows for bandwidth limitation.
   rclcpp::Publisher<nvblox_msgs::msg::Mesh>::SharedPtr mesh_publisher_;
@@ -21,8 +21,11 @@
 #include <string>
 #include <utility>
 
+#include <rclcpp/rclcpp.hpp>
+
 #include <isaac_ros_managed_nitros/managed_nitros_subscriber.hpp>
 #include <isaac_ros_nitros_image_type/nitros_image_view.hpp>
+#include <isaac_ros_nitros_point_cloud_type/nitros_point_cloud.hpp>
 
 namespace nvblox
 {
@@ -41,6 +44,18 @@ using NitrosViewPtr = std::shared_ptr<NitrosView>;
 // which can be invalidated at any time. We therefore store the frame_id separately to avoid
 // problems when buffering our messages. We can remove this struct once this is fixed in Nitros.
 using NitrosViewPtrAndFrameId = std::pair<NitrosViewPtr, std::string>;
+
+/// The pointcloud type transmitted by nitros. The points stay in device memory, such that they can
+/// be converted without a host round trip.
+using NitrosPointCloud = nvidia::isaac_ros::nitros::NitrosPointCloud;
+
+/// Type-adapted subscription receiving nitros pointclouds.
+using NitrosPointCloudSubscription = rclcpp::Subscription<NitrosPointCloud>;
+
+using NitrosPointCloudPtr = std::shared_ptr<const NitrosPointCloud>;
+
+// As for images, the frame_id is stored next to the (buffered) nitros pointcloud.
+using NitrosPointCloudPtrAndFrameId = std::pair<NitrosPointCloudPtr, std::string>;
 }  // namespace nvblox
 
 #endif  // NVBLOX_ROS__NITROS_TYPES_HPP_"
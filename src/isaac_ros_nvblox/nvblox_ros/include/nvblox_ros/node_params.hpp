@@ -40,6 +40,21 @@ constexpr Param<CudaStreamType>::Description kCudaStreamTypeParamDesc{"cuda_stre
   "stream(1), we can also use cuda default stream(0) or non blocking async stream(2) or "
   "per thread default stream(3)"};
 
+constexpr Param<int>::Description kDeviceMemoryPoolReserveMbParamDesc{
+  "device_memory_pool_reserve_mb", 0,
+  "Device memory (in MB) reserved in CUDA's memory pool at startup, such that the first frames "
+  "don't allocate their temporaries from the driver. 0 disables the reservation."};
+
+constexpr Param<bool>::Description kLaunchAutotuningParamDesc{
+  "launch_autotuning", false,
+  "Benchmark the candidate launch configurations of the kernels which have them on the first "
+  "frames, and select the fastest for this GPU model. Synchronizes the GPU while tuning."};
+
+constexpr StringParam::Description kLaunchAutotuningCachePathParamDesc{
+  "launch_autotuning_cache_path", "",
+  "File the selected launch configurations are loaded from at startup and saved to once tuned, "
+  "such that each GPU model is only tuned once. Empty disables the cache."};
+
 // ======= ROBOT FRAME PARAMS =======
 constexpr StringParam::Description kGlobalFrameParamDesc{
   "global_frame", "odom",
@@ -70,16 +85,58 @@ constexpr Param<bool>::Description kUseSegmentationParamDesc{"use_segmentation",
 constexpr Param<bool>::Description kUseLidarParamDesc{
   "use_lidar", true, "Whether to integrate LiDAR scans."};
 
+constexpr Param<bool>::Description kUseNitrosPointcloudParamDesc{
+  "use_nitros_pointcloud", false,
+  "Whether to receive LiDAR scans as nitros pointclouds. GPU-resident scans are then converted "
+  "in place, without being copied to the host."};
+
 // ======= INPUT DATA PARAMS =======
 constexpr Param<int>::Description kNumCamerasParamDesc{
   "num_cameras", 1,
-  "Number of cameras supported (number of subscribers created)"};
+  "Number of cameras supported (number of subscribers created). Camera i subscribes to "
+  "camera_<i>/depth, camera_<i>/color and camera_<i>/mask and is preprocessed on its own CUDA "
+  "stream."};
+
+constexpr Param<int>::Description kMaskDesiredHeightParamDesc{
+  "mask_desired_height", -1,
+  "If > 0 (together with mask_desired_width), segmentation masks are padded/cropped on the GPU "
+  "to this height, keeping them centered. This replaces a separate nvblox_image_padding node in "
+  "front of the mask topic."};
+
+constexpr Param<int>::Description kMaskDesiredWidthParamDesc{
+  "mask_desired_width", -1,
+  "If > 0 (together with mask_desired_height), segmentation masks are padded/cropped on the GPU "
+  "to this width. See mask_desired_height."};
+
+constexpr Param<float>::Description kMaskMatchToleranceMsParamDesc{
+  "mask_match_tolerance_ms", 5.F,
+  "Maximum difference between the timestamps of an image and its segmentation mask."};
+
+constexpr Param<float>::Description kMaskDeadlineMsParamDesc{
+  "mask_deadline_ms", 150.F,
+  "Maximum time an image waits for its segmentation mask. Images whose mask is later (or was "
+  "dropped) are integrated without a mask, instead of holding up the following images."};
 
 constexpr Param<int>::Description kMaximumSensorMessageQueueLengthParamDesc{
   "maximum_input_queue_length", 10,
   "How many items to store in the input queues (depth, color, lidar, services) before deleting "
   "oldest items."};
 
+constexpr Param<bool>::Description kAdaptiveInputRateParamDesc{
+  "adaptive_input_rate", false,
+  "Whether to adapt the rate at which camera frames are integrated to the measured integration "
+  "time, such that integration keeps up with the input instead of overflowing the input "
+  "queues. Frames are then skipped evenly, across all cameras."};
+
+constexpr Param<float>::Description kAdaptiveInputRateTargetUtilizationParamDesc{
+  "adaptive_input_rate_target_utilization", 0.8F,
+  "With adaptive_input_rate, the fraction of the time spent integrating camera frames."};
+
+constexpr Param<float>::Description kAdaptiveInputRateFrontCameraWeightParamDesc{
+  "adaptive_input_rate_front_camera_weight", 2.F,
+  "With adaptive_input_rate, the share of the integration budget of camera_0 (the forward-facing "
+  "camera) relative to each of the other cameras."};
+
 // ======= MAPPING PARAMS =======
 constexpr Param<float>::Description kVoxelSizeParamDesc{"voxel_size", .05F,
   "Voxel size (side of cube in meters) to use for the map."};
@@ -193,6 +250,12 @@ constexpr Param<float>::Description kLayerStreamerBandwidthLimitMbpsParamDesc{
   "layer_streamer_bandwidth_limit_mbps", 30.f,
   "Bandwidth limit for streaming layer visualizations (over WiFi) in mega-bits per second."};
 
+constexpr Param<bool>::Description kLayerStreamerUseLoanedMessagesParamDesc{
+  "layer_streamer_use_loaned_messages", true,
+  "Publish streamed layers without copying, for subscribers in the same process. Serialized "
+  "layers are written into middleware-loaned messages when the middleware supports it, and are "
+  "otherwise handed over as unique pointers (zero-copy when intra-process comms are enabled)."};
+
 // ======= UPDATE RATES =======
 constexpr Param<float>::Description kIntegrateDepthRateHzParamDesc{
   "integrate_depth_rate_hz", 40.F,
@@ -235,6 +298,55 @@ constexpr Param<float>::Description kClearMapOutsideRadiusRateHzParamDesc{
 constexpr Param<int>::Description kTickPeriodMsParamDesc{
   "tick_period_ms", 10, "Specifies How often the main tick function of the node is ticked."};
 
+constexpr Param<bool>::Description kPublishSliceUpdatesParamDesc{
+  "publish_slice_updates", false,
+  "Whether to publish partial updates of the occupancy grids and distance map slices on "
+  "<topic>_updates, covering only the window of cells which changed since the last publish. "
+  "Full grids and slices are then only published every full_slice_publish_interval publishes, "
+  "and whenever the slice bounds change."};
+
+constexpr Param<int>::Description kFullSlicePublishIntervalParamDesc{
+  "full_slice_publish_interval", 10,
+  "When publishing slice updates, the number of publishes between full grids and slices."};
+
+constexpr Param<float>::Description kEsdfSliceRadiusMParamDesc{
+  "esdf_slice_radius_m", 0.F,
+  "If positive, distance map slices and occupancy grids are limited to a square with a side "
+  "length of twice this radius, centered on esdf_slice_bounds_visualization_attachment_frame_id,"
+  " rather than covering all allocated blocks. Keeps slice latency and message size constant "
+  "as the map grows."};
+
+constexpr Param<bool>::Description kPublishVoxelStateGridParamDesc{
+  "publish_voxel_state_grid", false,
+  "Whether to publish a 3D grid of occupied, free and unknown voxels around the robot on "
+  "~/static_voxel_state_grid, for 3D-aware planners (e.g. the NvbloxVoxelLayer nav2 plugin). The "
+  "grid spans esdf_slice_min_height to esdf_slice_max_height and requires the 3D ESDF."};
+
+constexpr Param<float>::Description kVoxelStateGridRadiusMParamDesc{
+  "voxel_state_grid_radius_m", 5.F,
+  "Half the side length of the square around the robot covered by the voxel state grid."};
+
+constexpr Param<bool>::Description kVoxelStateGridIncludeDistancesParamDesc{
+  "voxel_state_grid_include_distances", false,
+  "Whether the voxel state grid includes the ESDF distance of every voxel."};
+
+constexpr Param<bool>::Description kEventDrivenInputProcessingParamDesc{
+  "event_driven_input_processing", false,
+  "Whether to process the depth, color and pointcloud queues on their own thread, woken by "
+  "incoming inputs and transforms, instead of polling them in every tick. This removes the wait "
+  "for the next tick once the pose of an input is available."};
+
+constexpr Param<bool>::Description kEsdfOnSeparateThreadParamDesc{
+  "esdf_on_separate_thread", false,
+  "Whether to compute, slice and publish the 3D ESDF on its own thread and CUDA stream, from a "
+  "snapshot of the changed TSDF blocks, such that it runs concurrently with integration."};
+
+constexpr Param<bool>::Description kUseThreadTopologyParamDesc{
+  "use_thread_topology", false,
+  "Whether to spin the ingestion, integration, ESDF, publishing and service callbacks on threads "
+  "of their own, each with the CPU affinity and SCHED_FIFO priority of its "
+  "thread_topology.<role> parameters. Otherwise all callbacks share a multi-threaded executor."};
+
 constexpr Param<int>::Description kPrintStatisticsOnConsolePeriodMsParamDesc{
   "print_statistics_on_console_period_ms", 10000,
   "Specified how often to print timing and rate statistics to the terminal."};
@@ -253,10 +365,45 @@ constexpr Param<bool>::Description kPrintQueueDropsToConsoleParamDesc{
   "print_queue_drops_to_console", false,
   "Whether to print message drops from queues to the console."};
 
+constexpr Param<int>::Description kMetricsPortParamDesc{
+  "metrics_port", 0,
+  "If positive, the timings, rates, delays, input queue depths and drops, and the memory usage "
+  "are served in the OpenMetrics (Prometheus) format on http://<host>:<metrics_port>/metrics. "
+  "The metrics are only computed when scraped."};
+
+constexpr Param<bool>::Description kUseFlightRecorderParamDesc{
+  "use_flight_recorder", false,
+  "Whether to keep the recent stage timings, queue depths, block counts and allocation and rehash "
+  "events in a ring buffer, which is written as a Chrome trace (open in ui.perfetto.dev) on a "
+  "latency spike or on a call of the ~/dump_flight_recorder service."};
+
+constexpr Param<float>::Description kFlightRecorderWindowSParamDesc{
+  "flight_recorder_window_s", 10.F, "The length of the history written by the flight recorder."};
+
+constexpr Param<float>::Description kFlightRecorderLatencyThresholdMsParamDesc{
+  "flight_recorder_latency_threshold_ms", 0.F,
+  "The age of the inputs behind a published output above which the flight recorder writes a "
+  "trace. At most one trace is written per flight_recorder_window_s. Non-positive disables the "
+  "automatic traces."};
+
+constexpr StringParam::Description kFlightRecorderOutputDirParamDesc{
+  "flight_recorder_output_dir", "/tmp",
+  "The directory of the traces written on latency spikes."};
+
 // ======= OUTPUT PARAMS =======
 constexpr Param<float>::Description kEsdfAndGradientsUnobservedValueParamDesc{
   "esdf_and_gradients_unobserved_value", -1000.F,
   "This value will be used for for unobserved voxels in the dense output grid."};
+constexpr Param<bool>::Description kEsdfAndGradientsAsyncResponseParamDesc{
+  "esdf_and_gradients_async_response", true,
+  "Whether EsdfAndGradients service responses are filled on a dedicated service thread. The "
+  "tick thread then only enqueues the extraction of the grid on the GPU, such that mapping "
+  "doesn't wait on large requests."};
+constexpr Param<bool>::Description kEsdfAndGradientsIncludeGradientsParamDesc{
+  "esdf_and_gradients_include_gradients", false,
+  "Whether EsdfAndGradients responses contain the ESDF gradients (computed on the GPU). If so, "
+  "the grid gets a fourth dimension \"channel\" holding the distance and the gradient along x, "
+  "y and z."};
 constexpr Param<bool>::Description kOutputPessimisticDistanceMap{
   "output_pessimistic_distance_map", true,
   "Whether or not to output the pessimistic distance map."};
@@ -301,6 +448,7 @@ public:
   Param<float> layer_visualization_exclusion_height_m{kLayerVisualizationExclusionHeightMParamDesc};
   Param<float> layer_visualization_exclusion_radius_m{kLayerVisualizationExclusionRadiusMParamDesc};
   Param<float> layer_streamer_bandwidth_limit_mbps{kLayerStreamerBandwidthLimitMbpsParamDesc};
+  Param<bool> layer_streamer_use_loaned_messages{kLayerStreamerUseLoanedMessagesParamDesc};
 
   // TODO(dtingdahl) handle enum-from-string logic more elegant so we don't need a separate member
   // for the enum mapping type
@@ -335,15 +483,31 @@ public:
   Param<bool> use_depth{kUseDepthParamDesc};
   Param<bool> use_segmentation{kUseSegmentationParamDesc};
   Param<bool> use_lidar{kUseLidarParamDesc};
+  Param<bool> use_nitros_pointcloud{kUseNitrosPointcloudParamDesc};
   Param<bool> layer_visualization_undo_gamma_correction{
     kLayerVisualizationUndoGammaCorrectionParamDesc};
   Param<bool> output_pessimistic_distance_map{kOutputPessimisticDistanceMap};
+  Param<bool> esdf_on_separate_thread{kEsdfOnSeparateThreadParamDesc};
+  Param<bool> use_thread_topology{kUseThreadTopologyParamDesc};
+  Param<bool> event_driven_input_processing{kEventDrivenInputProcessingParamDesc};
+  Param<bool> publish_slice_updates{kPublishSliceUpdatesParamDesc};
+  Param<bool> adaptive_input_rate{kAdaptiveInputRateParamDesc};
+  Param<bool> publish_voxel_state_grid{kPublishVoxelStateGridParamDesc};
+  Param<bool> voxel_state_grid_include_distances{kVoxelStateGridIncludeDistancesParamDesc};
+  Param<int> full_slice_publish_interval{kFullSlicePublishIntervalParamDesc};
 
   Param<int> maximum_input_queue_length{kMaximumSensorMessageQueueLengthParamDesc};
   Param<int> back_projection_subsampling{kBackProjectionSubsamplingParamDesc};
   Param<int> tick_period_ms{kTickPeriodMsParamDesc};
   Param<int> print_statistics_on_console_period_ms{kPrintStatisticsOnConsolePeriodMsParamDesc};
+  Param<int> metrics_port{kMetricsPortParamDesc};
+  Param<bool> use_flight_recorder{kUseFlightRecorderParamDesc};
+  Param<float> flight_recorder_window_s{kFlightRecorderWindowSParamDesc};
+  Param<float> flight_recorder_latency_threshold_ms{kFlightRecorderLatencyThresholdMsParamDesc};
+  StringParam flight_recorder_output_dir{kFlightRecorderOutputDirParamDesc};
   Param<int> num_cameras{kNumCamerasParamDesc};
+  Param<int> mask_desired_height{kMaskDesiredHeightParamDesc};
+  Param<int> mask_desired_width{kMaskDesiredWidthParamDesc};
   Param<int> lidar_width{kLidarWidthParamDesc};
   Param<int> lidar_height{kLidarHeightParamDesc};
 
@@ -366,8 +530,18 @@ public:
   Param<float> decay_tsdf_rate_hz{kDecayTsdfRateHzParamDesc};
   Param<float> decay_dynamic_occupancy_rate_hz{kDecayDynamicOccupancyRateHzParamDesc};
   Param<float> clear_map_outside_radius_rate_hz{kClearMapOutsideRadiusRateHzParamDesc};
+  Param<float> mask_match_tolerance_ms{kMaskMatchToleranceMsParamDesc};
+  Param<float> mask_deadline_ms{kMaskDeadlineMsParamDesc};
+  Param<float> adaptive_input_rate_target_utilization{
+    kAdaptiveInputRateTargetUtilizationParamDesc};
+  Param<float> adaptive_input_rate_front_camera_weight{
+    kAdaptiveInputRateFrontCameraWeightParamDesc};
   Param<float> esdf_and_gradients_unobserved_value{kEsdfAndGradientsUnobservedValueParamDesc};
+  Param<bool> esdf_and_gradients_async_response{kEsdfAndGradientsAsyncResponseParamDesc};
+  Param<bool> esdf_and_gradients_include_gradients{kEsdfAndGradientsIncludeGradientsParamDesc};
   Param<float> map_clearing_radius_m{kMapClearingRadiusMParamDesc};
+  Param<float> voxel_state_grid_radius_m{kVoxelStateGridRadiusMParamDesc};
+  Param<float> esdf_slice_radius_m{kEsdfSliceRadiusMParamDesc};
 };
 
 /// Container for all node params of the fuser node.
@@ -22,11 +22,9 @@
 
 #include <geometry_msgs/msg/vector3.h>
 #include <message_filters/subscriber.h>
-#include <message_filters/sync_policies/approximate_time.h>
 #include <message_filters/sync_policies/exact_time.h>
 
 #include <chrono>
-#include <list>
 #include <functional>
 #include <limits>
 #include <map>
@@ -41,6 +39,7 @@
 
 #include <rclcpp/rclcpp.hpp>
 #include <geometry_msgs/msg/point.hpp>
+#include <map_msgs/msg/occupancy_grid_update.hpp>
 #include <nav_msgs/msg/occupancy_grid.hpp>
 #include <sensor_msgs/msg/camera_info.hpp>
 #include <sensor_msgs/msg/image.hpp>
@@ -49,20 +48,34 @@
 #include <visualization_msgs/msg/marker.hpp>
 
 #include <nvblox_msgs/srv/file_path.hpp>
+#include <nvblox_msgs/srv/collision_check.hpp>
 #include <nvblox_msgs/srv/esdf_and_gradients.hpp>
+#include <nvblox_msgs/srv/mesh_streaming_roi.hpp>
 
 #include "nvblox_ros/layer_publishing.hpp"
 #include "nvblox_ros/conversions/image_conversions.hpp"
 #include "nvblox_ros/conversions/mesh_conversions.hpp"
 #include "nvblox_ros/conversions/pointcloud_conversions.hpp"
+#include "nvblox_ros/conversions/pointcloud_packing.hpp"
 #include "nvblox_ros/conversions/esdf_slice_conversions.hpp"
+#include "nvblox_ros/conversions/esdf_slice_grid_conversions.hpp"
+#include "nvblox_ros/conversions/esdf_and_gradients_async_conversions.hpp"
 #include "nvblox_ros/conversions/esdf_and_gradients_conversions.hpp"
+#include "nvblox_ros/conversions/voxel_state_grid_conversions.hpp"
 #include "nvblox_ros/mapper_initialization.hpp"
 #include "nvblox_ros/transformer.hpp"
 #include "nvblox_ros/camera_cache.hpp"
+#include "nvblox_ros/image_mask_matcher.hpp"
+#include "nvblox_ros/input_processing_worker.hpp"
+#include "nvblox_ros/input_queue.hpp"
+#include "nvblox_ros/input_rate_controller.hpp"
 #include "nvblox_ros/nitros_types.hpp"
 #include "nvblox_ros/node_params.hpp"
+#include "nvblox_ros/output_graph.hpp"
 #include "nvblox_ros/service_request_task.hpp"
+#include "nvblox_ros/service_worker.hpp"
+#include "nvblox_ros/thread_topology.hpp"
+#include "nvblox_ros/tick_scheduler.hpp"
 
 #include "isaac_ros_managed_nitros/managed_nitros_message_filters_subscriber.hpp"
 #include "isaac_ros_managed_nitros/managed_nitros_publisher.hpp"
@@ -92,6 +105,26 @@ public:
   void advertiseServices();
   void setupTimers();
 
+  // The callback group of the work of a role, for spinning it on the threads of the role (see
+  // ThreadTopologyExecutor). nullptr if the work runs in the default callback group.
+  rclcpp::CallbackGroup::SharedPtr callbackGroup(ThreadRole role) const
+  {
+    switch (role) {
+      case ThreadRole::kIngestion:
+        return group_ingestion_;
+      case ThreadRole::kIntegration:
+        return group_processing_;
+      case ThreadRole::kEsdf:
+        return group_esdf_;
+      case ThreadRole::kPublishing:
+        return group_publishing_;
+      case ThreadRole::kServices:
+        return group_services_;
+      default:
+        return nullptr;
+    }
+  }
+
   // Internal types for passing around images, their matching
   // segmentation masks, as well as the camera intrinsics.
   using ImageSegmentationMaskMsgTuple =
@@ -138,6 +171,7 @@ public:
     const sensor_msgs::msg::CameraInfo::ConstSharedPtr & color_camera_info);
   void pointcloudCallback(
     const sensor_msgs::msg::PointCloud2::ConstSharedPtr pointcloud);
+  void nitrosPointcloudCallback(const NitrosPointCloudPtr & pointcloud);
 
   void savePly(
     const std::shared_ptr<nvblox_msgs::srv::FilePath::Request> request,
@@ -154,9 +188,23 @@ public:
   void saveTimings(
     const std::shared_ptr<nvblox_msgs::srv::FilePath::Request> request,
     std::shared_ptr<nvblox_msgs::srv::FilePath::Response> response);
+  // Writes the flight recorder's history as a Chrome trace to the requested path.
+  void dumpFlightRecorder(
+    const std::shared_ptr<nvblox_msgs::srv::FilePath::Request> request,
+    std::shared_ptr<nvblox_msgs::srv::FilePath::Response> response);
   void getEsdfAndGradientService(
     const std::shared_ptr<nvblox_msgs::srv::EsdfAndGradients::Request> request,
     std::shared_ptr<nvblox_msgs::srv::EsdfAndGradients::Response> response);
+  // Returns the minimum clearance of a batch of spheres/capsules, computed with
+  // Mapper::computeClearances() on the processing thread.
+  void collisionCheckService(
+    const std::shared_ptr<nvblox_msgs::srv::CollisionCheck::Request> request,
+    std::shared_ptr<nvblox_msgs::srv::CollisionCheck::Response> response);
+  // Adds, updates or removes a region of interest subscription of the mesh, applied to the layer
+  // publisher on the processing thread.
+  void meshStreamingRoiService(
+    const std::shared_ptr<nvblox_msgs::srv::MeshStreamingRoi::Request> request,
+    std::shared_ptr<nvblox_msgs::srv::MeshStreamingRoi::Response> response);
 
   // Main tick function that process all input data queues in order
   virtual void tick();
@@ -172,6 +220,8 @@ public:
   virtual bool processColorImage(const ImageTypeVariant & color_mask_msg);
   virtual bool processLidarPointcloud(
     const sensor_msgs::msg::PointCloud2::ConstSharedPtr & pointcloud_ptr);
+  virtual bool processNitrosLidarPointcloud(
+    const NitrosPointCloudPtrAndFrameId & pointcloud_and_frame_id);
 
   // Return true if the tf-tree contains a transform for the given frame_id and timestamp
   bool canTransform(const std::string & frame_id, const rclcpp::Time & timestamp);
@@ -187,8 +237,12 @@ protected:
   virtual void processDepthQueue();
   virtual void processColorQueue();
   virtual void processPointcloudQueue();
+  virtual void processNitrosPointcloudQueue();
   virtual void processServiceRequestTaskQueue();
   virtual void processEsdf();
+  // Computes, slices and publishes the ESDF from the snapshot taken in processEsdf(). Run from
+  // esdf_processing_timer_ if esdf_on_separate_thread is set.
+  virtual void processEsdfSnapshot();
 
   // Return true if the time between the two passed timestamps is sufficient to trigger an action
   // under the requested rate.
@@ -237,13 +291,11 @@ protected:
   /// @param queue_name Name of the queue, used for logging.
   /// @param item Item to be added to the queue.
   /// @param queue_ptr Queue where to add the item.
-  /// @param queue_mutex_ptr Mutex protecting the queue.
   template<typename QueuedType>
   void pushOntoQueue(
     const std::string & queue_name,
     QueuedType item,
-    std::unique_ptr<std::list<QueuedType>> & queue_ptr,
-    std::mutex * queue_mutex_ptr);
+    std::unique_ptr<InputQueue<QueuedType>> & queue_ptr);
 
   // Used internally to unify processing of queues
   // that process an input item based on a ready check.
@@ -266,13 +318,12 @@ protected:
   /// calling a process function.
   /// @tparam QueuedType The type of the input items in the queue.
   /// @param queue_ptr Queue of input items to process.
-  /// @param queue_mutex_ptr Mutex protecting the queue.
   /// @param ready_check_function Function called on each item to check if
   /// it's ready to be processed
   /// @param process_function Function to process each ready item.
   template<typename QueuedType>
   void processQueue(
-    std::unique_ptr<std::list<QueuedType>> & queue_ptr, std::mutex * queue_mutex_ptr,
+    std::unique_ptr<InputQueue<QueuedType>> & queue_ptr,
     ReadyCheckFunctionType<QueuedType> ready_check_function,
     ProcessFunctionType<QueuedType> process_function);
 
@@ -292,42 +343,25 @@ protected:
   // Throttling debug messages to reduce spamming the console
   static constexpr float kTimeBetweenDebugMessagesMs = 1000.0;
 
-  /// Number of cameras supported (number of subscribers created).
-  static constexpr size_t kMaxNumCameras = 4;
-
-  /// Depth topics to listen to. At least one of these topics has to transmit images. All topics
-  /// are added to the same processing queue (depth or color) and thus gets the same treatment.
-  static constexpr std::array<const char *,
-    kMaxNumCameras> kDepthTopicBaseNames =
+  /// Topics to listen to, for each of the num_cameras cameras, e.g. "camera_0/depth". At least
+  /// one of the depth topics has to transmit images. All topics are added to the same processing
+  /// queue (depth or color) and thus get the same treatment.
+  static std::string cameraTopicBaseName(size_t camera_idx, const std::string & topic)
   {
-    // Multi-camera topics
-    "camera_0/depth",
-    "camera_1/depth",
-    "camera_2/depth",
-    "camera_3/depth",
-  };
-
-  /// Color topics to listen to.
-  static constexpr std::array<const char *,
-    kMaxNumCameras> kColorTopicBaseNames =
+    return "camera_" + std::to_string(camera_idx) + "/" + topic;
+  }
+  static std::string depthTopicBaseName(size_t camera_idx)
   {
-    // Multi-camera topics
-    "camera_0/color",
-    "camera_1/color",
-    "camera_2/color",
-    "camera_3/color",
-  };
-
-  /// Color topics to listen to.
-  static constexpr std::array<const char *,
-    kMaxNumCameras> kSegTopicBaseNames =
+    return cameraTopicBaseName(camera_idx, "depth");
+  }
+  static std::string colorTopicBaseName(size_t camera_idx)
   {
-    // Multi-camera topics
-    "camera_0/mask",
-    "camera_1/mask",
-    "camera_2/mask",
-    "camera_3/mask",
-  };
+    return cameraTopicBaseName(camera_idx, "color");
+  }
+  static std::string segTopicBaseName(size_t camera_idx)
+  {
+    return cameraTopicBaseName(camera_idx, "mask");
+  }
 
 
   /// Image + info subscribers
@@ -345,29 +379,32 @@ protected:
   segmentation_camera_info_subs_;
 
   // Sync Policies
-  using image_mask_approx_policy = ::message_filters::sync_policies::ApproximateTime<
-    nvidia::isaac_ros::nitros::NitrosImage, sensor_msgs::msg::CameraInfo,
-    nvidia::isaac_ros::nitros::NitrosImage, sensor_msgs::msg::CameraInfo>;
-  using image_mask_approx_sync = ::message_filters::Synchronizer<image_mask_approx_policy>;
-
   using image_exact_policy = ::message_filters::sync_policies::ExactTime<
     nvidia::isaac_ros::nitros::NitrosImage, sensor_msgs::msg::CameraInfo>;
   using image_exact_sync = ::message_filters::Synchronizer<image_exact_policy>;
 
-  using image_mask_exact_policy = ::message_filters::sync_policies::ExactTime<
-    nvidia::isaac_ros::nitros::NitrosImage, sensor_msgs::msg::CameraInfo,
-    nvidia::isaac_ros::nitros::NitrosImage, sensor_msgs::msg::CameraInfo>;
-  using image_mask_exact_sync = ::message_filters::Synchronizer<image_mask_exact_policy>;
-
-  std::vector<std::shared_ptr<image_mask_approx_sync>> timesync_depth_mask_;
-  std::vector<std::shared_ptr<image_mask_exact_sync>> timesync_color_mask_;
+  // Images and masks are synced exactly with their camera info.
   std::vector<std::shared_ptr<image_exact_sync>> timesync_depth_;
   std::vector<std::shared_ptr<image_exact_sync>> timesync_color_;
+  std::vector<std::shared_ptr<image_exact_sync>> timesync_mask_;
+
+  // With use_segmentation, the (depth or color) images of each camera are matched with the masks
+  // by an ImageMaskMatcher, which calls depthPlusMaskImageCallback() (colorPlusMaskImageCallback())
+  // for matched images and depthImageCallback() (colorImageCallback()) for images whose mask
+  // didn't arrive within mask_deadline_ms. Compared to a message_filters synchronizer of all four
+  // topics this doesn't allocate per match, and a late mask doesn't stall the input. The expired
+  // images are also flushed in every tick.
+  using ImageAndCameraInfoMsg = std::pair<nvidia::isaac_ros::nitros::NitrosImage::ConstSharedPtr,
+      sensor_msgs::msg::CameraInfo::ConstSharedPtr>;
+  std::vector<std::unique_ptr<ImageMaskMatcher<ImageAndCameraInfoMsg>>> depth_mask_matchers_;
+  std::vector<std::unique_ptr<ImageMaskMatcher<ImageAndCameraInfoMsg>>> color_mask_matchers_;
 
 
   // Pointcloud sub.
   rclcpp::Subscription<sensor_msgs::msg::PointCloud2>::SharedPtr
     pointcloud_sub_;
+  // Pointcloud sub used instead of the above if use_nitros_pointcloud is set.
+  NitrosPointCloudSubscription::SharedPtr nitros_pointcloud_sub_;
 
   // Optional transform subs.
   rclcpp::Subscription<geometry_msgs::msg::TransformStamped>::SharedPtr
@@ -412,6 +449,22 @@ protected:
     dynamic_occupancy_grid_publisher_;
   rclcpp::Publisher<nav_msgs::msg::OccupancyGrid>::SharedPtr
     combined_occupancy_grid_publisher_;
+  // Partial updates of the slices and grids above (see publish_slice_updates).
+  rclcpp::Publisher<nvblox_msgs::msg::DistanceMapSliceUpdate>::SharedPtr
+    static_map_slice_update_publisher_;
+  rclcpp::Publisher<nvblox_msgs::msg::DistanceMapSliceUpdate>::SharedPtr
+    dynamic_map_slice_update_publisher_;
+  rclcpp::Publisher<nvblox_msgs::msg::DistanceMapSliceUpdate>::SharedPtr
+    combined_map_slice_update_publisher_;
+  rclcpp::Publisher<map_msgs::msg::OccupancyGridUpdate>::SharedPtr
+    static_occupancy_grid_update_publisher_;
+  rclcpp::Publisher<map_msgs::msg::OccupancyGridUpdate>::SharedPtr
+    dynamic_occupancy_grid_update_publisher_;
+  rclcpp::Publisher<map_msgs::msg::OccupancyGridUpdate>::SharedPtr
+    combined_occupancy_grid_update_publisher_;
+  // The 3D voxel states around the robot (see publish_voxel_state_grid).
+  rclcpp::Publisher<nvblox_msgs::msg::VoxelStateGrid>::SharedPtr
+    static_voxel_state_grid_publisher_;
 
   // Services.
   rclcpp::Service<nvblox_msgs::srv::FilePath>::SharedPtr save_ply_service_;
@@ -419,13 +472,41 @@ protected:
   rclcpp::Service<nvblox_msgs::srv::FilePath>::SharedPtr load_map_service_;
   rclcpp::Service<nvblox_msgs::srv::FilePath>::SharedPtr save_rates_service_;
   rclcpp::Service<nvblox_msgs::srv::FilePath>::SharedPtr save_timings_service_;
+  rclcpp::Service<nvblox_msgs::srv::FilePath>::SharedPtr dump_flight_recorder_service_;
   rclcpp::Service<nvblox_msgs::srv::EsdfAndGradients>::SharedPtr send_esdf_and_gradient_service_;
+  rclcpp::Service<nvblox_msgs::srv::CollisionCheck>::SharedPtr collision_check_service_;
+  rclcpp::Service<nvblox_msgs::srv::MeshStreamingRoi>::SharedPtr mesh_streaming_roi_service_;
 
   // Callback groups.
   rclcpp::CallbackGroup::SharedPtr group_processing_;
+  // Only created if esdf_on_separate_thread is set. Mutually exclusive with itself only, such that
+  // the ESDF runs concurrently with the processing group (given a multi-threaded executor).
+  rclcpp::CallbackGroup::SharedPtr group_esdf_;
+  // Only created if use_thread_topology is set, for the subscriptions, the publishing timers and
+  // the services. The groups of a thread topology aren't added to the executor with the node,
+  // but to the executor of their role.
+  rclcpp::CallbackGroup::SharedPtr group_ingestion_;
+  rclcpp::CallbackGroup::SharedPtr group_publishing_;
+  rclcpp::CallbackGroup::SharedPtr group_services_;
 
   // Timers.
+  // The tick. Only processes the depth, color and pointcloud queues if
+  // event_driven_input_processing is not set.
   rclcpp::TimerBase::SharedPtr queue_processing_timer_;
+  rclcpp::TimerBase::SharedPtr esdf_processing_timer_;
+
+  // If esdf_on_separate_thread is set, processEsdf() only snapshots the ESDF input of the mappers
+  // (see Mapper::snapshotEsdfInput()), and processEsdfSnapshot() computes the ESDF on
+  // esdf_cuda_stream_. The mutex serializes everything else that accesses the ESDF layers while
+  // the ESDF is computed (i.e. map clearing, service calls and layer publishing).
+  std::shared_ptr<CudaStream> esdf_cuda_stream_ = nullptr;
+  std::mutex esdf_mutex_;
+
+  // If event_driven_input_processing is set, runs processDepthQueue(), processColorQueue() and
+  // processPointcloudQueue(), woken by the image and pointcloud callbacks and by the transformer
+  // receiving transforms. The mutex serializes the integration with the rest of the tick.
+  std::unique_ptr<InputProcessingWorker> input_processing_worker_;
+  std::mutex integration_mutex_;
 
   // Collection of params for the nvblox node
   NvbloxNodeParams params_;
@@ -470,12 +551,48 @@ protected:
   // Various converters for ROS message generation.
   conversions::PointcloudConverter pointcloud_converter_;
   conversions::EsdfSliceConverter esdf_slice_converter_;
+  // Packs the ESDF and slice pointclouds on the GPU, replacing the host-side packing of the
+  // converters above for the static, pessimistic, dynamic and combined ESDF pointclouds.
+  conversions::GpuPointcloudPacker pointcloud_packer_;
+  // Slices the static and dynamic ESDF layers, and converts the static, pessimistic static,
+  // dynamic and combined slices to occupancy grid and distance map data, in a single launch.
+  conversions::EsdfSliceGridConverter esdf_slice_grid_converter_;
+  // Packs the static ESDF around the robot into voxel state grids on the GPU.
+  conversions::VoxelStateGridConverter voxel_state_grid_converter_;
+  // Publishes since the last full slice, when publishing slice updates.
+  int num_slice_updates_since_full_publish_ = 0;
   conversions::EsdfAndGradientsConverter esdf_and_gradients_converter_;
+  // Extracts EsdfAndGradients grids on the GPU when responding asynchronously (see
+  // esdf_and_gradients_async_response). The responses are filled on esdf_service_worker_.
+  conversions::AsyncEsdfAndGradientsConverter async_esdf_and_gradients_converter_;
+  ServiceWorker esdf_service_worker_;
+  // saveMap() and savePly() only capture the map on the processing thread (see
+  // Mapper::saveLayerCakeAsync()). Waiting for the files to be written and filling the responses
+  // happens on file_writer_worker_, such that mapping continues meanwhile.
+  ServiceWorker file_writer_worker_;
 
   // Caches for GPU images
   ColorImage color_image_{MemoryType::kDevice};
   DepthImage depth_image_{MemoryType::kDevice};
   MonoImage mask_image_{MemoryType::kDevice};
+
+  // Per-camera GPU image caches and stream. The conversion, mask splitting and preprocessing of
+  // the frames of different cameras is issued on their own streams, and the frames are passed to
+  // the shared integrator through Mapper::stageDepthAsync() with the camera index as staging
+  // lane. Frames of different cameras are thus preprocessed in parallel.
+  struct CameraInput
+  {
+    std::shared_ptr<CudaStream> cuda_stream;
+    DepthImage depth_image{MemoryType::kDevice};
+    MonoImage mask_image{MemoryType::kDevice};
+    // The mask as received, before padding/cropping to mask_desired_height/width.
+    MonoImage mask_image_unpadded{MemoryType::kDevice};
+    ColorImage color_image{MemoryType::kDevice};
+  };
+  // One per camera, indexed by camera index (see cameraTopicBaseName()).
+  std::vector<std::unique_ptr<CameraInput>> camera_inputs_;
+  // Maps the frame_id of a camera's images to its camera index.
+  std::unordered_map<std::string, size_t> camera_index_from_frame_id_;
   DepthImage pointcloud_image_{MemoryType::kDevice};
   Image<conversions::Rgb> rgb_image_tmp_{MemoryType::kDevice};
 
@@ -493,35 +610,42 @@ protected:
       nvblox_msgs::srv::EsdfAndGradients>>;
   using FilePathServiceQueuedType = std::shared_ptr<ServiceRequestTask<NvbloxNode,
       nvblox_msgs::srv::FilePath>>;
-
-  // Input queues. Unique pointers are used to enable more flexibility when deallocating.
-  std::unique_ptr<std::list<sensor_msgs::msg::PointCloud2::ConstSharedPtr>> pointcloud_queue_;
-  std::unique_ptr<std::list<EsdfServiceQueuedType>> esdf_service_queue_;
-  std::unique_ptr<std::list<FilePathServiceQueuedType>> file_path_service_queue_;
-  std::unique_ptr<std::list<ImageTypeVariant>> depth_image_queue_;
-  std::unique_ptr<std::list<ImageTypeVariant>>
-  color_image_queue_;
+  using CollisionCheckServiceQueuedType = std::shared_ptr<ServiceRequestTask<NvbloxNode,
+      nvblox_msgs::srv::CollisionCheck>>;
+  using MeshStreamingRoiServiceQueuedType = std::shared_ptr<ServiceRequestTask<NvbloxNode,
+      nvblox_msgs::srv::MeshStreamingRoi>>;
+
+  // Input queues. Unique pointers are used to enable more flexibility when deallocating. The
+  // queues are bounded (maximum_input_queue_length) and lock-free, so neither the subscription
+  // callbacks nor the processing timer block on each other.
+  std::unique_ptr<InputQueue<sensor_msgs::msg::PointCloud2::ConstSharedPtr>> pointcloud_queue_;
+  std::unique_ptr<InputQueue<NitrosPointCloudPtrAndFrameId>> nitros_pointcloud_queue_;
+  std::unique_ptr<InputQueue<EsdfServiceQueuedType>> esdf_service_queue_;
+  std::unique_ptr<InputQueue<FilePathServiceQueuedType>> file_path_service_queue_;
+  std::unique_ptr<InputQueue<CollisionCheckServiceQueuedType>> collision_check_service_queue_;
+  std::unique_ptr<InputQueue<MeshStreamingRoiServiceQueuedType>> mesh_streaming_roi_service_queue_;
+  std::unique_ptr<InputQueue<ImageTypeVariant>> depth_image_queue_;
+  std::unique_ptr<InputQueue<ImageTypeVariant>> color_image_queue_;
 
   // Input queue names.
   static constexpr char kDepthQueueName[] = "depth_queue";
   static constexpr char kColorQueueName[] = "color_queue";
   static constexpr char kPointcloudQueueName[] = "pointcloud_queue";
+  static constexpr char kNitrosPointcloudQueueName[] = "nitros_pointcloud_queue";
   static constexpr char kFilePathServiceQueueName[] = "file_path_service_queue";
   static constexpr char kEsdfServiceQueueName[] = "esdf_service_queue";
-
-  // Input queue mutexes.
-  std::mutex depth_queue_mutex_;
-  std::mutex color_queue_mutex_;
-  std::mutex depth_mask_queue_mutex_;
-  std::mutex color_mask_queue_mutex_;
-  std::mutex pointcloud_queue_mutex_;
-  std::mutex esdf_service_queue_mutex_;
-  std::mutex file_path_service_queue_mutex_;
+  static constexpr char kCollisionCheckServiceQueueName[] = "collision_check_service_queue";
+  static constexpr char kMeshStreamingRoiServiceQueueName[] = "mesh_streaming_roi_service_queue";
 
   // Counts the number of messages dropped from the input queues.
   // Maps the input queue to the number of messages that have been dropped.
   std::unordered_map<std::string, int> number_of_dropped_queued_items_;
 
+  // Serves the metrics if metrics_port is set. Memory usage and GPU hash statistics are exported
+  // by a collector writing the mapper's MapperMemoryUsage, such that they're only computed when
+  // scraped.
+  std::unique_ptr<timing::MetricsServer> metrics_server_;
+
   // Device caches
   Pointcloud pointcloud_C_device_;
   Pointcloud human_pointcloud_C_device_;
@@ -535,6 +659,21 @@ protected:
   static constexpr bool kStartStopped = true;
   timing::Timer idle_timer_{"ros/idle", kStartStopped};
 
+  // Decides which of the due stages are run in a tick, such that the critical stages (depth,
+  // ESDF and slice) are not delayed by deferrable ones (mesh, color and visualization). The
+  // budget defaults to the tick period.
+  TickScheduler tick_scheduler_{static_cast<float>(kTickPeriodMsParamDesc.default_value)};
+
+  // With adaptive_input_rate, decides which camera frames are integrated, such that integration
+  // keeps up with the input and frames are skipped evenly across cameras rather than dropped in
+  // bursts from the overflowing input queues. Cameras are registered in order of their index.
+  InputRateController input_rate_controller_{{"tsdf/integrate", "occupancy/integrate"}};
+
+  // The outputs of the node (publishers) and the work producing them (e.g. slicing the combined
+  // ESDF or back-projecting depth). Work is only run in a tick if, as of the start of the tick,
+  // one of its outputs has subscribers or it has been requested (e.g. by a service call).
+  OutputGraph output_graph_;
+
   // Cuda stream for GPU work
   std::shared_ptr<CudaStream> cuda_stream_ = nullptr;
 
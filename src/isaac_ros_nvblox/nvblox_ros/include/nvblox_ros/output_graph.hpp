@@ -0,0 +1,128 @@
+// SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+// Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef NVBLOX_ROS__OUTPUT_GRAPH_HPP_
+#define NVBLOX_ROS__OUTPUT_GRAPH_HPP_
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <rclcpp/rclcpp.hpp>
+
+namespace nvblox
+{
+
+/// A declarative graph of the node's outputs and the work producing them, used to skip work
+/// nobody consumes.
+///
+/// There are two kinds of nodes:
+/// - Outputs (typically publishers), which state whether they are in demand (e.g. whether a
+///   publisher has subscribers).
+/// - Work items (e.g. slicing the combined ESDF), which are only needed if at least one node
+///   consuming them is needed.
+/// Each node states the work items it takes as inputs. Inputs have to be added before the nodes
+/// consuming them, which keeps the graph acyclic.
+///
+/// Demand is evaluated once per tick, such that all checks within a tick are consistent:
+///   output_graph_.update();
+///   if (output_graph_.isNeeded(kCombinedSliceWork)) {
+///     sliceLayersToCombinedDistanceImage(...);
+///   }
+/// Work needed for a one-off reason (e.g. a service call) is forced through requestForNextUpdate().
+class OutputGraph
+{
+public:
+  using NodeId = int;
+  using DemandFunction = std::function<bool ()>;
+
+  OutputGraph() = default;
+
+  /// Add an output.
+  /// @param name Name of the output, used for logging.
+  /// @param has_demand Returns whether the output is currently consumed.
+  /// @param inputs The work items producing this output.
+  /// @return The id used to refer to this output.
+  NodeId addOutput(
+    const std::string & name, DemandFunction has_demand,
+    const std::vector<NodeId> & inputs = {});
+
+  /// Add a work item.
+  /// @param name Name of the work item, used for logging.
+  /// @param inputs The work items this work item consumes.
+  /// @return The id used to refer to this work item.
+  NodeId addWork(const std::string & name, const std::vector<NodeId> & inputs = {});
+
+  /// Mark a node (and thereby its inputs) as needed in the next call to update(), regardless of
+  /// the demand of its outputs.
+  /// @param node_id The node to request.
+  void requestForNextUpdate(NodeId node_id);
+
+  /// Evaluate the demand of all outputs and propagate it to their inputs.
+  void update();
+
+  /// Returns true if, as of the last update(), the node has to be computed.
+  /// @param node_id The node.
+  /// @return Whether the node is needed.
+  bool isNeeded(NodeId node_id) const;
+
+  /// Name of a node.
+  /// @param node_id The node.
+  /// @return The name passed when adding the node.
+  const std::string & name(NodeId node_id) const;
+
+  /// Number of nodes in the graph.
+  size_t size() const {return nodes_.size();}
+
+private:
+  NodeId addNode(
+    const std::string & name, DemandFunction has_demand,
+    const std::vector<NodeId> & inputs);
+  void checkNodeId(NodeId node_id) const;
+
+  struct Node
+  {
+    std::string name;
+    // Empty for work items.
+    DemandFunction has_demand;
+    std::vector<NodeId> inputs;
+    bool is_requested = false;
+    bool is_needed = false;
+  };
+
+  std::vector<Node> nodes_;
+};
+
+/// A demand function which is true if a publisher has any (inter- or intra-process) subscribers.
+/// Only a weak reference to the publisher is kept.
+/// @param publisher The publisher.
+/// @return The demand function.
+template<typename PublisherT>
+OutputGraph::DemandFunction hasSubscribers(const std::shared_ptr<PublisherT> & publisher)
+{
+  return [weak_publisher = std::weak_ptr<PublisherT>(publisher)]() {
+           const auto publisher = weak_publisher.lock();
+           return publisher != nullptr &&
+                  (publisher->get_subscription_count() +
+                  publisher->get_intra_process_subscription_count()) > 0;
+         };
+}
+
+}  // namespace nvblox
+
+#endif  // NVBLOX_ROS__OUTPUT_GRAPH_HPP_
@@ -0,0 +1,113 @@
+// SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+// Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef NVBLOX_ROS__ROSBAG_FRAME_INDEX_HPP_
+#define NVBLOX_ROS__ROSBAG_FRAME_INDEX_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace nvblox
+{
+namespace datasets
+{
+namespace ros
+{
+
+/// Reads the header stamp of a serialized message without deserializing it.
+/// Works for all messages starting with a std_msgs/Header (e.g. Image, CameraInfo), which in CDR
+/// are prefixed by a 4 byte encapsulation header followed by the stamp's sec and nanosec.
+/// @param data The serialized (CDR) message.
+/// @param size_bytes The size of the serialized message.
+/// @return The stamp in nanoseconds, or nullopt if the data is too short or not CDR.
+std::optional<uint64_t> peekHeaderStampNs(const uint8_t * data, size_t size_bytes);
+
+/// A message in a bag, identified by its receive time in the bag.
+struct StampedBagMessage
+{
+  /// Header stamp of the message.
+  uint64_t stamp_ns = 0;
+  /// Time at which the message was recorded. Used to seek to and identify the message.
+  int64_t bag_time_ns = 0;
+};
+
+/// A tuple of depth, color and camera_info messages with exactly matching header stamps.
+struct RosbagFrameIndexEntry
+{
+  uint64_t stamp_ns = 0;
+  int64_t depth_bag_time_ns = 0;
+  int64_t depth_camera_info_bag_time_ns = 0;
+  int64_t color_bag_time_ns = 0;
+  int64_t color_camera_info_bag_time_ns = 0;
+
+  /// The earliest bag time of the messages in the tuple.
+  int64_t earliestBagTimeNs() const;
+};
+
+/// Find the tuples of messages that exactly match in header stamp, across the four streams.
+/// If a stream has several messages with the same stamp, the first recorded one is used.
+/// @return The matches, sorted by stamp.
+std::vector<RosbagFrameIndexEntry> matchExactStamps(
+  std::vector<StampedBagMessage> depth_msgs,
+  std::vector<StampedBagMessage> depth_camera_info_msgs,
+  std::vector<StampedBagMessage> color_msgs,
+  std::vector<StampedBagMessage> color_camera_info_msgs);
+
+/// Index of all the frames (matching depth/color/camera_info tuples) in a ROSbag.
+///
+/// Building the index is a single pass over the bag which only reads the header stamps from the
+/// serialized messages. The index then lets a reader skip non-matching messages without
+/// deserializing them and seek to a time.
+class RosbagFrameIndex
+{
+public:
+  RosbagFrameIndex() = default;
+
+  /// Index the frames in a bag.
+  /// @param rosbag_path The path to the ROSbag.
+  /// @param depth_topic Name of the depth topic.
+  /// @param depth_camera_info_topic Name of the camera_info topic of the depth topic.
+  /// @param color_topic Name of the color image topic.
+  /// @param color_camera_info_topic Name of the camera_info topic of the color topic.
+  /// @return The index. Empty if the bag doesn't contain any matching frames.
+  static RosbagFrameIndex build(
+    const std::string & rosbag_path, const std::string & depth_topic,
+    const std::string & depth_camera_info_topic, const std::string & color_topic,
+    const std::string & color_camera_info_topic);
+
+  /// Construct from already matched entries, sorted by stamp.
+  explicit RosbagFrameIndex(std::vector<RosbagFrameIndexEntry> entries);
+
+  const std::vector<RosbagFrameIndexEntry> & entries() const {return entries_;}
+  size_t size() const {return entries_.size();}
+  bool empty() const {return entries_.empty();}
+
+  /// The index of the first frame at or after a time. size() if there is none.
+  size_t findFirstAtOrAfter(uint64_t stamp_ns) const;
+
+private:
+  std::vector<RosbagFrameIndexEntry> entries_;
+};
+
+}  // namespace ros
+}  // namespace datasets
+}  // namespace nvblox
+
+#endif  // NVBLOX_ROS__ROSBAG_FRAME_INDEX_HPP_
@@ -0,0 +1,79 @@
+// SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+// Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef NVBLOX_ROS__SERVICE_WORKER_HPP_
+#define NVBLOX_ROS__SERVICE_WORKER_HPP_
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace nvblox
+{
+
+/// Runs jobs (e.g. filling service responses) on a dedicated thread, in the order they were
+/// posted.
+///
+/// The tick thread only enqueues the GPU work of a service request and posts the rest, such as
+/// waiting for the GPU and copying the result into the response, to the worker. Mapping therefore
+/// never waits on service handling.
+///
+/// Usage:
+///   ServiceWorker worker;
+///   worker.post([=]() {snapshot->fillResponse(response.get()); task->promise_.set_value();});
+class ServiceWorker
+{
+public:
+  using Job = std::function<void ()>;
+
+  /// Starts the worker thread.
+  ServiceWorker();
+
+  /// Runs the jobs which are still pending and joins the worker thread.
+  ~ServiceWorker();
+
+  ServiceWorker(const ServiceWorker &) = delete;
+  ServiceWorker & operator=(const ServiceWorker &) = delete;
+
+  /// Enqueue a job to be run on the worker thread. Returns immediately.
+  /// @param job The job to run.
+  void post(Job job);
+
+  /// Block until all jobs posted so far have been run.
+  void waitUntilIdle();
+
+  /// The number of jobs posted but not yet completed.
+  size_t numPendingJobs() const;
+
+private:
+  void run();
+
+  mutable std::mutex mutex_;
+  std::condition_variable job_posted_;
+  std::condition_variable job_completed_;
+  std::deque<Job> jobs_;
+  // The job currently running, if any, counts as pending.
+  size_t num_pending_jobs_ = 0;
+  bool stop_ = false;
+  std::thread thread_;
+};
+
+}  // namespace nvblox
+
+#endif  // NVBLOX_ROS__SERVICE_WORKER_HPP_
@@ -0,0 +1,129 @@
+// SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+// Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef NVBLOX_ROS__THREAD_TOPOLOGY_HPP_
+#define NVBLOX_ROS__THREAD_TOPOLOGY_HPP_
+
+#include <array>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <rclcpp/rclcpp.hpp>
+
+namespace nvblox
+{
+
+/// The kinds of work of the node which can be given threads of their own.
+enum class ThreadRole
+{
+  /// Sensor and transform subscriptions.
+  kIngestion,
+  /// The tick, integrating the input queues (group_processing_).
+  kIntegration,
+  /// The ESDF computation, if esdf_on_separate_thread is set (group_esdf_).
+  kEsdf,
+  /// Output publishing timers.
+  kPublishing,
+  /// Service callbacks.
+  kServices,
+};
+constexpr int kNumThreadRoles = 5;
+
+/// The name of a role, as used in the parameter names (e.g. "integration").
+std::string toString(ThreadRole role);
+
+/// How the threads of a role are run.
+struct ThreadConfig
+{
+  /// The number of threads spinning the callback groups of the role.
+  int num_threads = 1;
+  /// The CPUs the threads may run on. Empty means all CPUs.
+  std::vector<int> cpu_affinity;
+  /// If positive, the threads run with SCHED_FIFO at this priority (1-99). Otherwise they keep
+  /// the default (SCHED_OTHER) policy.
+  int sched_fifo_priority = 0;
+};
+using ThreadConfigs = std::array<ThreadConfig, kNumThreadRoles>;
+
+/// Parses a list of CPUs such as "2,3,6-7" (as in taskset and isolcpus).
+/// @return The CPUs, or std::nullopt if the list is malformed.
+std::optional<std::vector<int>> parseCpuList(const std::string & cpu_list);
+
+/// Applies the affinity and scheduling policy of a config to the calling thread. Threads created
+/// by it afterwards inherit both.
+/// @return False if any of the two couldn't be applied (e.g. SCHED_FIFO without CAP_SYS_NICE).
+/// The reason is logged.
+bool applyThreadConfigToCurrentThread(const ThreadConfig & config);
+
+/// Declares (or reads, if already declared) the parameters of the thread config of each role:
+/// thread_topology.<role>.num_threads, .cpu_affinity (a CPU list, see parseCpuList()) and
+/// .sched_fifo_priority.
+ThreadConfigs getThreadConfigsFromParams(rclcpp::Node * node);
+
+/// Spins callback groups on per-role executors, each running on threads configured by the
+/// ThreadConfig of its role. Such that e.g. integration has cores of its own, isolated from the
+/// ingestion and from other (real-time) processes on the system.
+///
+/// Usage:
+///   ThreadTopologyExecutor executor(getThreadConfigsFromParams(node.get()));
+///   executor.addNode(ThreadRole::kIngestion, node);
+///   executor.addCallbackGroup(ThreadRole::kIntegration, group, node->get_node_base_interface());
+///   executor.spin();
+class ThreadTopologyExecutor
+{
+public:
+  explicit ThreadTopologyExecutor(const ThreadConfigs & configs);
+
+  /// Cancels the executors and joins their threads.
+  ~ThreadTopologyExecutor();
+
+  ThreadTopologyExecutor(const ThreadTopologyExecutor &) = delete;
+  ThreadTopologyExecutor & operator=(const ThreadTopologyExecutor &) = delete;
+
+  /// Spin the default callback group of a node (and its groups added with the node) on a role.
+  void addNode(ThreadRole role, rclcpp::Node::SharedPtr node);
+
+  /// Spin a callback group on a role. The group must have been created without being
+  /// automatically added to the executor of its node.
+  void addCallbackGroup(
+    ThreadRole role, rclcpp::CallbackGroup::SharedPtr group,
+    rclcpp::node_interfaces::NodeBaseInterface::SharedPtr node_base);
+
+  /// Spin all roles which got work, until rclcpp is shut down.
+  void spin();
+
+  /// Stop spinning. Can be called from any thread.
+  void cancel();
+
+private:
+  struct RoleExecutor
+  {
+    ThreadConfig config;
+    std::shared_ptr<rclcpp::Executor> executor;
+    bool has_work = false;
+  };
+
+  std::array<RoleExecutor, kNumThreadRoles> role_executors_;
+  std::vector<std::thread> threads_;
+};
+
+}  // namespace nvblox
+
+#endif  // NVBLOX_ROS__THREAD_TOPOLOGY_HPP_
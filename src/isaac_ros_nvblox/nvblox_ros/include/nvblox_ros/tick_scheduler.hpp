@@ -0,0 +1,125 @@
+// SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+// Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef NVBLOX_ROS__TICK_SCHEDULER_HPP_
+#define NVBLOX_ROS__TICK_SCHEDULER_HPP_
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace nvblox
+{
+
+/// Priority of a stage run from the node's tick function.
+enum class TickStagePriority
+{
+  /// Always run when due (e.g. ESDF and slice output).
+  kCritical,
+  /// Deferred to a later tick if it doesn't fit in the remaining budget (e.g. mesh, color and
+  /// visualization).
+  kDeferrable
+};
+
+/// Decides which stages of a tick to run such that the tick stays within a time budget.
+///
+/// The cost of each stage is estimated from the mean of its timing::Timer. Critical stages
+/// always run. Deferrable stages only run if their estimated cost fits in what is left of the
+/// budget. To avoid starvation, a deferrable stage runs regardless once it has been deferred
+/// max_num_consecutive_deferrals() times in a row.
+///
+/// Usage from within tick():
+///   tick_scheduler_.startTick();
+///   if (shouldProcess(...) && tick_scheduler_.shouldRunStage(kMeshStage)) {
+///     ...
+///   }
+class TickScheduler
+{
+public:
+  using StageId = int;
+
+  /// Constructor
+  /// @param tick_budget_ms The target duration of a tick in milliseconds.
+  explicit TickScheduler(float tick_budget_ms);
+
+  /// Register a stage.
+  /// @param name Name of the stage, used for logging.
+  /// @param timer_tag Tag of the timing::Timer measuring the stage.
+  /// @param priority Whether the stage may be deferred.
+  /// @return The id used to refer to this stage.
+  StageId registerStage(
+    const std::string & name, const std::string & timer_tag,
+    TickStagePriority priority);
+
+  /// Mark the beginning of a tick. The budget is counted from this point.
+  void startTick();
+
+  /// Returns true if a stage should be run in this tick. Should only be called for stages that
+  /// are due, because a false return counts as a deferral.
+  /// @param stage_id The stage to check.
+  /// @return True if the stage should run.
+  bool shouldRunStage(StageId stage_id);
+
+  /// The estimated cost of a stage from its timer.
+  /// @param stage_id The stage.
+  /// @return The estimated time in milliseconds.
+  float estimatedStageCostMs(StageId stage_id) const;
+
+  /// The time left in the budget of the current tick.
+  /// @return The remaining time in milliseconds (negative if overrun).
+  float remainingBudgetMs() const;
+
+  /// Total number of times a stage has been deferred.
+  /// @param stage_id The stage.
+  /// @return The number of deferrals.
+  int numDeferrals(StageId stage_id) const;
+
+  /// A parameter getter
+  /// The target duration of a tick in milliseconds.
+  float tick_budget_ms() const {return tick_budget_ms_;}
+
+  /// A parameter setter
+  /// See tick_budget_ms().
+  void tick_budget_ms(float tick_budget_ms);
+
+  /// A parameter getter
+  /// The number of consecutive ticks a deferrable stage is skipped before it's forced to run.
+  int max_num_consecutive_deferrals() const {return max_num_consecutive_deferrals_;}
+
+  /// A parameter setter
+  /// See max_num_consecutive_deferrals().
+  void max_num_consecutive_deferrals(int max_num_consecutive_deferrals);
+
+private:
+  struct Stage
+  {
+    std::string name;
+    std::string timer_tag;
+    TickStagePriority priority;
+    int num_consecutive_deferrals = 0;
+    int num_deferrals = 0;
+  };
+
+  float tick_budget_ms_;
+  int max_num_consecutive_deferrals_ = 10;
+  std::vector<Stage> stages_;
+  std::chrono::steady_clock::time_point tick_start_time_;
+};
+
+}  // namespace nvblox
+
+#endif  // NVBLOX_ROS__TICK_SCHEDULER_HPP_
@@ -0,0 +1,114 @@
+// SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+// Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef NVBLOX_ROS__TRANSFORM_CACHE_HPP_
+#define NVBLOX_ROS__TRANSFORM_CACHE_HPP_
+
+#include <nvblox/core/types.h>
+
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+
+namespace nvblox
+{
+
+/// A cache of recently looked up transforms, in front of tf2.
+///
+/// For each pair of frames, the cache keeps a small ring buffer of transforms ordered by
+/// timestamp. A lookup at a cached timestamp returns the cached transform. A lookup between two
+/// cached timestamps interpolates between them (linearly for the translation, spherically for the
+/// rotation), as long as they are at most max_interpolation_interval_ns() apart. Lookups are
+/// O(log n) in the number of cached transforms of the frame pair.
+///
+/// Transforms which never change, such as sensor extrinsics, are memoized separately, without a
+/// timestamp.
+///
+/// All functions are thread-safe.
+class TransformCache
+{
+public:
+  /// Constructor
+  /// @param max_num_transforms_per_frame_pair Capacity of the ring buffer of each frame pair.
+  explicit TransformCache(size_t max_num_transforms_per_frame_pair = 64);
+
+  /// Add a transform to the cache. If the ring buffer is full, the oldest transform is dropped.
+  /// @param target_frame The frame the transform maps into.
+  /// @param source_frame The frame the transform maps from.
+  /// @param timestamp_ns Time of the transform.
+  /// @param transform The transform.
+  void insert(
+    const std::string & target_frame, const std::string & source_frame,
+    uint64_t timestamp_ns, const Transform & transform);
+
+  /// Look up a transform.
+  /// @param target_frame The frame the transform maps into.
+  /// @param source_frame The frame the transform maps from.
+  /// @param timestamp_ns Time of the transform.
+  /// @param transform The output transform.
+  /// @return True if the transform is cached or can be interpolated from cached transforms.
+  bool lookup(
+    const std::string & target_frame, const std::string & source_frame,
+    uint64_t timestamp_ns, Transform * transform) const;
+
+  /// Memoize a static transform.
+  /// @param target_frame The frame the transform maps into.
+  /// @param source_frame The frame the transform maps from.
+  /// @param transform The transform.
+  void insertStatic(
+    const std::string & target_frame, const std::string & source_frame,
+    const Transform & transform);
+
+  /// Look up a static transform memoized by insertStatic().
+  /// @param target_frame The frame the transform maps into.
+  /// @param source_frame The frame the transform maps from.
+  /// @param transform The output transform.
+  /// @return True if the transform is memoized.
+  bool lookupStatic(
+    const std::string & target_frame, const std::string & source_frame,
+    Transform * transform) const;
+
+  /// Drop all transforms, e.g. when the TF tree jumps back in time.
+  void clear();
+
+  /// A parameter getter
+  /// The largest gap between two cached transforms which is interpolated across.
+  uint64_t max_interpolation_interval_ns() const {return max_interpolation_interval_ns_;}
+
+  /// A parameter setter
+  /// See max_interpolation_interval_ns().
+  void max_interpolation_interval_ns(uint64_t max_interpolation_interval_ns);
+
+private:
+  using FramePair = std::pair<std::string, std::string>;
+  using TimestampedTransform = std::pair<uint64_t, Transform>;
+
+  size_t max_num_transforms_per_frame_pair_;
+  uint64_t max_interpolation_interval_ns_ = 50'000'000;  // 50 milliseconds
+
+  mutable std::mutex mutex_;
+  /// Transforms of each frame pair, ordered by timestamp.
+  std::map<FramePair, std::deque<TimestampedTransform>> transforms_;
+  std::map<FramePair, Transform> static_transforms_;
+};
+
+}  // namespace nvblox
+
+#endif  // NVBLOX_ROS__TRANSFORM_CACHE_HPP_
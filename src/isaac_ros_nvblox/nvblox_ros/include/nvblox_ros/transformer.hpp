@@ -22,14 +22,18 @@
 #include <tf2_ros/buffer.h>
 #include <tf2_ros/transform_listener.h>
 
+#include <functional>
 #include <map>
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <utility>
 
 #include <geometry_msgs/msg/pose_stamped.hpp>
 #include <geometry_msgs/msg/transform_stamped.hpp>
 
+#include "nvblox_ros/transform_cache.hpp"
+
 namespace nvblox
 {
 
@@ -45,7 +49,9 @@ public:
   ///         transforms from messages.
   /// @param sensor_frame The frame name.
   /// @param timestamp Time of the transform. Passing rclcpp::Time(0) will return the latest
-  ///                  transform in the queue.
+  ///                  transform in the queue. Lookups at other times go through
+  ///                  transform_cache_ first, such that repeated lookups (e.g. by
+  ///                  isPoseAvailable() and the processing of the same image) don't hit tf2.
   /// @param transform The output transform.
   /// @return true if the lookup was successful.
   bool lookupTransformToGlobalFrame(
@@ -71,6 +77,19 @@ public:
     pose_frame_ = pose_frame;
   }
 
+  /// Set a function called whenever new transforms are received, through tf2 or through
+  /// transformCallback()/poseCallback(). Used to wake the processing of the inputs waiting for
+  /// their poses. Called from the thread receiving the transforms. Call once, during setup.
+  using TransformsUpdatedCallback = std::function<void ()>;
+  void setTransformsUpdatedCallback(TransformsUpdatedCallback callback)
+  {
+    transforms_updated_callback_ = std::move(callback);
+    if (tf_buffer_ && !tf_listener_registered_) {
+      tf_buffer_->_addTransformsChangedListener([this]() {notifyTransformsUpdated();});
+      tf_listener_registered_ = true;
+    }
+  }
+
 private:
   bool lookupTransformTf(
     const std::string & from_frame,
@@ -85,6 +104,13 @@ private:
     const std::string & sensor_frame,
     Transform * transform);
 
+  void notifyTransformsUpdated() const
+  {
+    if (transforms_updated_callback_) {
+      transforms_updated_callback_();
+    }
+  }
+
   Transform transformToEigen(const geometry_msgs::msg::Transform & transform) const;
   Transform poseToEigen(const geometry_msgs::msg::Pose & pose) const;
 
@@ -116,6 +142,13 @@ private:
   std::map<uint64_t, Transform> transform_queue_;
   /// Maps sensor frame to transform pose frame -> sensor frame.
   std::unordered_map<std::string, Transform> sensor_transforms_;
+  /// Recent tf2 lookups of lookupTransformTf(), and the (static) transforms of
+  /// lookupSensorTransform(), memoized once resolved.
+  TransformCache transform_cache_;
+
+  /// See setTransformsUpdatedCallback().
+  TransformsUpdatedCallback transforms_updated_callback_;
+  bool tf_listener_registered_ = false;
 };
 
 }  // namespace nvblox
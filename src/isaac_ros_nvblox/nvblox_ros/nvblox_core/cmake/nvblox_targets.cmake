@@ -65,6 +65,34 @@ function(set_nvblox_compiler_options_internal target_name enable_warnings)
   target_compile_definitions(${target_name}
     PRIVATE
     "$<$<BOOL:${PRE_CXX11_ABI_LINKABLE}>:PRE_CXX11_ABI_LINKABLE>")
+  # Directive for half-precision TSDF voxels. This changes the layout of a public
+  # type and is therefore propagated to everything linking against nvblox.
+  target_compile_definitions(${target_name}
+    PUBLIC
+    "$<$<BOOL:${USE_HALF_PRECISION_TSDF}>:NVBLOX_HALF_PRECISION_TSDF>")
+  # Directive for compact color voxels. Also changes the layout of a public type.
+  target_compile_definitions(${target_name}
+    PUBLIC
+    "$<$<BOOL:${USE_COMPACT_COLOR_VOXEL}>:NVBLOX_COMPACT_COLOR_VOXEL>")
+  # Directive for quantized occupancy voxels. Also changes the layout of a public
+  # type.
+  target_compile_definitions(${target_name}
+    PUBLIC
+    "$<$<BOOL:${USE_QUANTIZED_OCCUPANCY}>:NVBLOX_QUANTIZED_OCCUPANCY>")
+  # Directive for compact freespace voxels. Also changes the layout of a public
+  # type.
+  target_compile_definitions(${target_name}
+    PUBLIC
+    "$<$<BOOL:${USE_COMPACT_FREESPACE_VOXEL}>:NVBLOX_COMPACT_FREESPACE_VOXEL>")
+  # Directive for the sync monitor. Public since the instrumented copies live in
+  # header templates compiled by the users of nvblox.
+  target_compile_definitions(${target_name}
+    PUBLIC
+    "$<$<BOOL:${USE_SYNC_MONITOR}>:NVBLOX_SYNC_MONITOR>")
+  # The VoxelBlock side length. Also changes the layout of public types.
+  target_compile_definitions(${target_name}
+    PUBLIC
+    "NVBLOX_VOXELS_PER_SIDE=${VOXELS_PER_SIDE}")
   # Change namespace cub:: into nvblox::cub. This is to avoid conflicts when other modules calls non
 # thread safe functions in the cub namespace. Appending nvblox:: ensures an unique symbol that is
 # only accesed by this library.
@@ -15,13 +15,28 @@ limitations under the License.
 */
 #pragma once
 
+#include <gflags/gflags.h>
+
+#include <condition_variable>
 #include <deque>
-#include <future>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 
+#include "nvblox/core/cuda_stream.h"
+#include "nvblox/core/pinned_host_buffer_pool.h"
 #include "nvblox/core/types.h"
+#include "nvblox/core/unified_vector.h"
 #include "nvblox/sensors/image.h"
 
+// Whether the dataset Fusers load images with a MultiThreadedImageLoader.
+DECLARE_bool(multithreaded_image_loading);
+// Whether the dataset Fusers load images with a GpuDecodingImageLoader.
+DECLARE_bool(gpu_image_decoding);
+
 namespace nvblox {
 namespace datasets {
 
@@ -35,6 +50,21 @@ bool load16BitDepthImage(
 bool load8BitColorImage(const std::string& filename,
                         ColorImage* color_image_ptr);
 
+// Returns a host buffer with space for (rows x cols) pixels, into which an
+// image is decoded.
+template <typename ElementType>
+using DecodeDestinationFunction =
+    std::function<ElementType*(int rows, int cols)>;
+
+// Decode image files into host memory. These functions don't make any CUDA
+// calls, such that they can be called from any thread.
+bool decode16BitDepthImage(
+    const std::string& filename, const float scaling_factor,
+    const DecodeDestinationFunction<float>& get_destination);
+bool decode8BitColorImage(
+    const std::string& filename,
+    const DecodeDestinationFunction<Color>& get_destination);
+
 using IndexToFilepathFunction = std::function<std::string(int image_idx)>;
 
 // Single-threaded image loader
@@ -51,6 +81,10 @@ class ImageLoader {
 
  protected:
   bool getImage(int image_idx, ImageType*);
+  bool decodeImage(
+      int image_idx,
+      const DecodeDestinationFunction<typename ImageType::ElementType>&
+          get_destination) const;
 
   int image_idx_ = 0;
   const IndexToFilepathFunction index_to_filepath_;
@@ -60,31 +94,117 @@ class ImageLoader {
 };
 
 // Multi-threaded image loader
-template <typename ImageType>
-using ImageOptional = std::pair<bool, ImageType>;
-
-// Multi-threaded image loader
+//
+// A pool of decode threads decodes the upcoming images of the sequence into a
+// bounded prefetch queue, while the caller consumes them in order. The
+// threads decode straight into pinned host buffers, such that the upload of an
+// image to its destination is a single async copy. The pinned buffers are
+// allocated on the calling thread and the decode threads make no CUDA calls.
 template <typename ImageType>
 class MultiThreadedImageLoader : public ImageLoader<ImageType> {
  public:
+  using ElementType = typename ImageType::ElementType;
+
+  /// Constructor
+  /// @param index_to_filepath Maps image indices to files.
+  /// @param num_threads The number of decode threads.
+  /// @param prefetch_queue_size The maximum number of images decoded ahead.
+  ///                            Must be at least num_threads to keep all
+  ///                            threads busy.
+  /// @param depth_image_scaling_factor See ImageLoader.
   MultiThreadedImageLoader(
       IndexToFilepathFunction index_to_filepath, int num_threads,
+      int prefetch_queue_size,
       float depth_image_scaling_factor = kDefaultUintDepthScaleFactor);
   ~MultiThreadedImageLoader();
 
   bool getNextImage(ImageType* image_ptr) override;
 
  protected:
-  void initLoadQueue();
-  void emptyLoadQueue();
-  void addNextImageToQueue(MemoryType memory_type);
-  ImageOptional<ImageType> getImageAsOptional(int image_idx,
-                                              MemoryType memory_type);
-
-  const int num_threads_;
-  std::deque<std::future<ImageOptional<ImageType>>> load_queue_;
+  // An image in the prefetch queue.
+  struct PrefetchedImage {
+    int image_idx = 0;
+    // Decode destination, acquired by the consuming thread when the image is
+    // queued. Empty if the image size is not known yet.
+    PinnedHostBufferPool::Buffer pinned_buffer;
+    // Decode destination used if the image doesn't fit the pinned buffer.
+    std::vector<ElementType> fallback_buffer;
+    bool decoded_into_pinned_buffer = false;
+    int rows = 0;
+    int cols = 0;
+    bool success = false;
+    bool done = false;
+  };
+
+  void fillPrefetchQueue();
+  void decodeThreadLoop();
+  void decode(PrefetchedImage* image) const;
+
+  const int prefetch_queue_size_;
+
+  // Images in sequence order. Elements are only added/removed by the
+  // consuming thread, and only written by a decode thread while not done.
+  std::deque<std::unique_ptr<PrefetchedImage>> prefetch_queue_;
+  // Queued images which are waiting for a decode thread.
+  std::deque<PrefetchedImage*> pending_images_;
+  std::mutex mutex_;
+  std::condition_variable pending_cv_;
+  std::condition_variable done_cv_;
+  bool stop_ = false;
+  std::vector<std::thread> decode_threads_;
+
+  // Size of the last loaded image, used to size the pinned buffers.
+  size_t expected_num_bytes_ = 0;
+  PinnedHostBufferPool pinned_buffer_pool_;
+  CudaStreamOwning cuda_stream_;
+};
+
+// Wraps the nvJPEG handles. Only defined when built with USE_NVJPEG.
+class NvjpegDecoder;
+
+// Whether the JPEG images are decoded on the GPU by GpuDecodingImageLoader,
+// i.e. whether nvblox was built with USE_NVJPEG.
+bool isGpuJpegDecodingAvailable();
+
+// Image loader which decodes into device images, taking the decode (or at
+// least the pixel conversion) off the CPU.
+//
+// JPEG color images are decoded by nvJPEG. The CUDA toolkit doesn't have a PNG
+// decoder, so PNGs are still inflated on the CPU: 16-bit depth PNGs are
+// uploaded as uint16, which halves the copy, and are converted to meters on
+// the GPU. Images which can't take the GPU path (color PNGs, builds without
+// nvJPEG, or destinations in host memory) are loaded as by ImageLoader.
+template <typename ImageType>
+class GpuDecodingImageLoader : public ImageLoader<ImageType> {
+ public:
+  GpuDecodingImageLoader(
+      IndexToFilepathFunction index_to_filepath,
+      float depth_image_scaling_factor = kDefaultUintDepthScaleFactor);
+  ~GpuDecodingImageLoader();
+
+  bool getNextImage(ImageType* image_ptr) override;
+
+ protected:
+  bool canDecodeOnGpu(const std::string& filename,
+                      const ImageType& image) const;
+  bool decodeOnGpu(const std::string& filename, ImageType* image_ptr);
+
+  CudaStreamOwning cuda_stream_;
+  // The nvJPEG state. Null if JPEG decoding isn't available or the loader
+  // doesn't load color images.
+  std::unique_ptr<NvjpegDecoder> jpeg_decoder_;
+  // Device staging of the encoded depth, or of the decoded RGB pixels.
+  DepthImageU16 depth_image_u16_{MemoryType::kDevice};
+  device_vector<uint8_t> rgb_buffer_;
 };
 
+// The number of decode threads used by createImageLoader(). Set through the
+// image_loader_num_threads gflag, or chosen based on the hardware if <= 0.
+int getNumImageLoaderThreads();
+// The prefetch queue size used by createImageLoader(). Set through the
+// image_loader_prefetch_queue_size gflag, or twice num_threads if <= 0.
+int getImageLoaderPrefetchQueueSize(int num_threads);
+
 // Factory Function
 template <typename ImageType>
 std::unique_ptr<ImageLoader<ImageType>> createImageLoader(
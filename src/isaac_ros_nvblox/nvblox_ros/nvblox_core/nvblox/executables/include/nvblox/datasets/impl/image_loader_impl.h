@@ -28,62 +28,121 @@ bool ImageLoader<ImageType>::getNextImage(ImageType* image_ptr) {
 template <typename ImageType>
 MultiThreadedImageLoader<ImageType>::MultiThreadedImageLoader(
     IndexToFilepathFunction index_to_filepath, int num_threads,
-    float depth_image_scaling_factor)
+    int prefetch_queue_size, float depth_image_scaling_factor)
     : ImageLoader<ImageType>(index_to_filepath, depth_image_scaling_factor),
-      num_threads_(num_threads) {
-  initLoadQueue();
+      prefetch_queue_size_(prefetch_queue_size),
+      pinned_buffer_pool_(prefetch_queue_size) {
+  CHECK_GT(num_threads, 0);
+  CHECK_GT(prefetch_queue_size, 0);
+  fillPrefetchQueue();
+  for (int i = 0; i < num_threads; i++) {
+    decode_threads_.emplace_back(
+        &MultiThreadedImageLoader<ImageType>::decodeThreadLoop, this);
+  }
 }
 
 template <typename ImageType>
 MultiThreadedImageLoader<ImageType>::~MultiThreadedImageLoader() {
-  emptyLoadQueue();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  pending_cv_.notify_all();
+  for (std::thread& thread : decode_threads_) {
+    thread.join();
+  }
 }
 
 template <typename ImageType>
 bool MultiThreadedImageLoader<ImageType>::getNextImage(ImageType* image_ptr) {
   CHECK_NOTNULL(image_ptr);
-  auto images_optional_future = std::move(load_queue_.front());
-  ImageOptional<ImageType> image_optional =
-      std::move(images_optional_future.get());
-  if (image_optional.first) {
-    *image_ptr = std::move(image_optional.second);
+  std::unique_ptr<PrefetchedImage> image;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    PrefetchedImage* front = prefetch_queue_.front().get();
+    done_cv_.wait(lock, [front]() { return front->done; });
+    image = std::move(prefetch_queue_.front());
+    prefetch_queue_.pop_front();
   }
-  load_queue_.pop_front();
-  addNextImageToQueue(image_ptr->memory_type());
-  return image_optional.first;
-}
 
-template <typename ImageType>
-void MultiThreadedImageLoader<ImageType>::initLoadQueue() {
-  for (int i = 0; i < num_threads_; i++) {
-    addNextImageToQueue(MemoryType::kDevice);
+  if (image->success) {
+    const ElementType* data =
+        image->decoded_into_pinned_buffer
+            ? reinterpret_cast<const ElementType*>(
+                  image->pinned_buffer.data.get())
+            : image->fallback_buffer.data();
+    image_ptr->copyFromAsync(image->rows, image->cols, data, cuda_stream_);
+    expected_num_bytes_ = static_cast<size_t>(image->rows) * image->cols *
+                          sizeof(ElementType);
   }
+  // The buffer is recycled once the copy from it has completed.
+  if (image->pinned_buffer.data) {
+    pinned_buffer_pool_.releaseAsync(std::move(image->pinned_buffer),
+                                     cuda_stream_);
+  }
+  cuda_stream_.synchronize();
+  // Queue the next image. Done after the copy, such that the pinned buffer we
+  // just released can be recycled for it.
+  fillPrefetchQueue();
+  return image->success;
 }
 
 template <typename ImageType>
-void MultiThreadedImageLoader<ImageType>::emptyLoadQueue() {
-  while (!load_queue_.empty()) {
-    load_queue_.pop_front();
+void MultiThreadedImageLoader<ImageType>::fillPrefetchQueue() {
+  while (static_cast<int>(prefetch_queue_.size()) < prefetch_queue_size_) {
+    auto image = std::make_unique<PrefetchedImage>();
+    image->image_idx = this->image_idx_++;
+    // Allocating pinned memory is a CUDA call, so it happens here rather than
+    // on the decode threads. Until the first image is loaded we don't know the
+    // size, and the decode threads use the fallback buffer.
+    if (expected_num_bytes_ > 0) {
+      image->pinned_buffer = pinned_buffer_pool_.acquire(expected_num_bytes_);
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_images_.push_back(image.get());
+    prefetch_queue_.push_back(std::move(image));
+    pending_cv_.notify_one();
   }
 }
 
 template <typename ImageType>
-void MultiThreadedImageLoader<ImageType>::addNextImageToQueue(
-    MemoryType memory_type) {
-  load_queue_.push_back(
-      std::async(std::launch::async,
-                 &MultiThreadedImageLoader<ImageType>::getImageAsOptional, this,
-                 this->image_idx_, memory_type));
-  ++this->image_idx_;
+void MultiThreadedImageLoader<ImageType>::decodeThreadLoop() {
+  while (true) {
+    PrefetchedImage* image = nullptr;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      pending_cv_.wait(lock,
+                       [this]() { return stop_ || !pending_images_.empty(); });
+      if (stop_) {
+        return;
+      }
+      image = pending_images_.front();
+      pending_images_.pop_front();
+    }
+    decode(image);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      image->done = true;
+    }
+    done_cv_.notify_all();
+  }
 }
 
 template <typename ImageType>
-ImageOptional<ImageType>
-MultiThreadedImageLoader<ImageType>::getImageAsOptional(
-    int image_idx, MemoryType memory_type) {
-  ImageType image(memory_type);
-  bool success_flag = ImageLoader<ImageType>::getImage(image_idx, &image);
-  return {success_flag, std::move(image)};
+void MultiThreadedImageLoader<ImageType>::decode(PrefetchedImage* image) const {
+  auto get_destination = [image](int rows, int cols) -> ElementType* {
+    image->rows = rows;
+    image->cols = cols;
+    const size_t num_elements = static_cast<size_t>(rows) * cols;
+    if (num_elements * sizeof(ElementType) <= image->pinned_buffer.size_bytes) {
+      image->decoded_into_pinned_buffer = true;
+      return reinterpret_cast<ElementType*>(image->pinned_buffer.data.get());
+    }
+    image->decoded_into_pinned_buffer = false;
+    image->fallback_buffer.resize(num_elements);
+    return image->fallback_buffer.data();
+  };
+  image->success = this->decodeImage(image->image_idx, get_destination);
 }
 
 // Factory Function
@@ -91,24 +150,23 @@ template <typename ImageType>
 std::unique_ptr<ImageLoader<ImageType>> createImageLoader(
     IndexToFilepathFunction index_to_path_function, const bool multithreaded,
     const float depth_image_scaling_factor) {
+  if (FLAGS_gpu_image_decoding) {
+    LOG(INFO) << "Decoding images on the GPU"
+              << (isGpuJpegDecodingAvailable() ? "."
+                                               : " (JPEG decoding not built).");
+    return std::make_unique<GpuDecodingImageLoader<ImageType>>(
+        index_to_path_function, depth_image_scaling_factor);
+  }
   if (multithreaded) {
-    // NOTE(dtingdahl): We see race conditions inside the
-    // cuda-runtime lib when running multi-threaded. We disable multithreading
-    // until this issue is resolved.
-    LOG(FATAL) << "Multithreaded image loading is currently not supported";
-
-    // NOTE(alexmillane): On my desktop the performance of threaded image
-    // loading seems to saturate at around 6 threads. On machines with less
-    // cores (I have 12 physical) presumably the saturation point will be less.
-    constexpr unsigned int kMaxLoadingThreads = 6;
-    unsigned int num_loading_threads =
-        std::min(kMaxLoadingThreads, std::thread::hardware_concurrency() / 2);
-    CHECK_GT(num_loading_threads, 0U)
-        << "std::thread::hardware_concurrency() returned 0";
+    const int num_loading_threads = getNumImageLoaderThreads();
+    const int prefetch_queue_size =
+        getImageLoaderPrefetchQueueSize(num_loading_threads);
     LOG(INFO) << "Using " << num_loading_threads
-              << " threads for loading images.";
+              << " threads for loading images, prefetching up to "
+              << prefetch_queue_size << " images.";
     return std::make_unique<MultiThreadedImageLoader<ImageType>>(
-        index_to_path_function, kMaxLoadingThreads, depth_image_scaling_factor);
+        index_to_path_function, num_loading_threads, prefetch_queue_size,
+        depth_image_scaling_factor);
   }
   return std::make_unique<ImageLoader<ImageType>>(index_to_path_function,
                                                   depth_image_scaling_factor);
@@ -17,8 +17,10 @@ limitations under the License.
 
 #include <glog/logging.h>
 
+#include <functional>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "nvblox/datasets/data_loader.h"
 #include "nvblox/dynamics/dynamics_detection.h"
@@ -49,6 +51,14 @@ class Fuser {
   void initFromGflags();
   // Runs an experiment
   int run();
+  // Integrates the dataset and writes the requested outputs. Same as run(),
+  // without printing and writing the (global) timings.
+  void integrateFramesAndWriteOutputs();
+
+  // Appends a suffix to all output paths (except the timing output path), e.g.
+  // such that several fusers don't overwrite each others outputs.
+  // "mesh.ply" becomes "mesh<suffix>.ply".
+  void appendOutputPathSuffix(const std::string& suffix);
 
   // Integrate a frame from the dataset
   datasets::DataLoadResult integrateFrame(const int frame_number);
@@ -130,4 +140,50 @@ class Fuser {
   std::shared_ptr<const SerializedMeshLayer> serialized_mesh_;
 };
 
+/// Creates the Fuser for one dataset sequence, e.g. wrapping
+/// datasets::replica::createFuser().
+using FuserFactory =
+    std::function<std::unique_ptr<Fuser>(const std::string& dataset_path)>;
+
+/// Params of runFuserBatch().
+struct BatchFuserParams {
+  /// The maximum number of sequences reconstructed at once. 0 means as many
+  /// as device memory allows (see device_memory_per_sequence_bytes).
+  int max_concurrent_sequences = 0;
+  /// The device memory reserved for the reconstruction of one sequence.
+  size_t device_memory_per_sequence_bytes = size_t{2} << 30;
+};
+
+/// Returns the number of sequences to reconstruct at once. Limited by the
+/// number of sequences, the params, and the number of sequences that fit
+/// into the free device memory. At least one.
+/// @param params The batch params.
+/// @param num_sequences The number of sequences to reconstruct.
+/// @param device_free_bytes The free device memory.
+/// @return The number of concurrent sequences.
+int getNumConcurrentSequences(const BatchFuserParams& params,
+                              const int num_sequences,
+                              const size_t device_free_bytes);
+
+/// Reconstructs several independent dataset sequences, several at once on
+/// one GPU. Each sequence gets its own Fuser, i.e. its own mappers (on their
+/// own CUDA stream) and data loader (with its own loader threads), run on
+/// its own thread. Output paths get the suffix "_<sequence index>".
+/// Timings are printed (and written) once, for all sequences.
+/// @param dataset_paths The paths of the sequences.
+/// @param fuser_factory Creates the Fuser of a sequence.
+/// @param params The batch params.
+/// @return 0 if all sequences were reconstructed, 1 otherwise.
+int runFuserBatch(const std::vector<std::string>& dataset_paths,
+                  const FuserFactory& fuser_factory,
+                  const BatchFuserParams& params);
+
+/// The dataset paths of batch mode, from the --batch_dataset_paths flag.
+/// @return The paths, empty if batch mode wasn't requested.
+std::vector<std::string> getBatchDatasetPathsFromGflags();
+
+/// The batch params from the --batch_* flags.
+/// @return The params.
+BatchFuserParams getBatchFuserParamsFromGflags();
+
 }  //  namespace nvblox
@@ -0,0 +1,75 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#pragma once
+
+#include <map>
+#include <ostream>
+#include <string>
+
+#include "nvblox/executables/fuser.h"
+#include "nvblox/utils/gpu_timing.h"
+
+namespace nvblox {
+
+/// Latency statistics of a stage over all frames it ran in.
+struct StageLatencyStats {
+  int num_samples = 0;
+  float mean_ms = 0.0f;
+  float p50_ms = 0.0f;
+  float p99_ms = 0.0f;
+  float max_ms = 0.0f;
+};
+
+/// The result of replaying a dataset, see runReplayBenchmark().
+struct ReplayBenchmarkResult {
+  /// The number of frames integrated.
+  int num_frames = 0;
+  /// Wall time of the replay including data loading.
+  double total_time_s = 0.0;
+  /// Integrated frames per second including data loading.
+  double frames_per_second = 0.0;
+  /// Integrated frames per second excluding data loading.
+  double frames_per_second_excluding_loading = 0.0;
+  /// Per-frame host latency of the fuser stages (e.g. "fuser/integrate_depth").
+  std::map<std::string, StageLatencyStats> stages;
+  /// GPU time of the stages instrumented with a timing::GpuTimer.
+  std::map<std::string, timing::GpuTimingStats> gpu_stages;
+  /// The peak device memory in use on the device (by all processes), sampled
+  /// after each frame.
+  size_t peak_device_used_bytes = 0;
+  /// The peak device memory allocated by the mappers: their layers' block
+  /// pools and GPU hashes and their scratch arenas. Sampled after each frame.
+  size_t peak_map_device_bytes = 0;
+
+  /// Write the result as a JSON object.
+  void writeJson(std::ostream& out) const;
+  /// Write the result as a human readable table.
+  void print(std::ostream& out) const;
+};
+
+/// Replay a dataset through a fuser as fast as possible and measure
+/// throughput, per-stage latency and peak device memory.
+///
+/// The frames are integrated with Fuser::integrateFrame(), so the fuser
+/// params (subsampling, number of frames etc.) apply. The per-stage latency of
+/// a frame is the time spent in the stage's timing::Timer during that frame.
+/// @param num_warmup_frames The number of frames integrated before measuring.
+/// Warmup frames are excluded from all statistics.
+/// @param fuser The fuser to replay, holding the data loader.
+/// @return The measurements.
+ReplayBenchmarkResult runReplayBenchmark(int num_warmup_frames, Fuser* fuser);
+
+}  // namespace nvblox
@@ -17,6 +17,7 @@ limitations under the License.
 
 #include <gflags/gflags.h>
 
+#include "nvblox/core/launch_autotuner.h"
 #include "nvblox/executables/fuser.h"
 #include "nvblox/mapper/multi_mapper_params.h"
 
@@ -72,6 +73,26 @@ DEFINE_double(
     "The frame rate of the input depth frames in Hz. Only used if running "
     "dynamic detection.");
 
+// Batch mode
+DEFINE_string(batch_dataset_paths, "",
+              "Comma-separated list of dataset sequences to reconstruct in "
+              "batch mode, several at once on one GPU. If empty, the "
+              "sequence passed as argument is reconstructed.");
+DEFINE_int32(batch_max_concurrent_sequences, 0,
+             "The maximum number of sequences reconstructed at once in batch "
+             "mode. 0 means as many as fit into device memory.");
+DEFINE_double(batch_device_memory_per_sequence_gb, 2.0,
+              "The device memory reserved for the reconstruction of one "
+              "sequence in batch mode.");
+
+// Launch autotuning
+DEFINE_bool(launch_autotuning, false,
+            "Benchmark the candidate launch configurations of tunable kernels "
+            "on the first frames and select the fastest for this GPU model.");
+DEFINE_string(launch_autotuning_cache_path, "",
+              "File the selected launch configurations are loaded from and "
+              "saved to, such that each GPU model is only tuned once.");
+
 // ============================ GET THE PARAMS ============================
 
 inline void get_global_params_from_gflags(float* voxel_size,
@@ -107,6 +128,21 @@ inline void get_global_params_from_gflags(float* voxel_size,
   }
 }
 
+inline void set_launch_autotuner_params_from_gflags() {
+  LaunchAutotuner& launch_autotuner = LaunchAutotuner::getInstance();
+  if (!gflags::GetCommandLineFlagInfoOrDie("launch_autotuning_cache_path")
+           .is_default) {
+    LOG(INFO) << "Command line parameter found: launch_autotuning_cache_path = "
+              << FLAGS_launch_autotuning_cache_path;
+    launch_autotuner.setCacheFilePath(FLAGS_launch_autotuning_cache_path);
+  }
+  if (!gflags::GetCommandLineFlagInfoOrDie("launch_autotuning").is_default) {
+    LOG(INFO) << "Command line parameter found: launch_autotuning = "
+              << FLAGS_launch_autotuning;
+    launch_autotuner.tuning_enabled(FLAGS_launch_autotuning);
+  }
+}
+
 inline void set_fuser_params_from_gflags(Fuser* fuser_ptr) {
   // Dataset flags
   if (!gflags::GetCommandLineFlagInfoOrDie("num_frames").is_default) {
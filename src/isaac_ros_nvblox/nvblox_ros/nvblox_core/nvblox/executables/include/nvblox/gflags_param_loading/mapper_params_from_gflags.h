@@ -31,6 +31,48 @@ DEFINE_int32(depth_preprocessing_num_dilations,
              kDepthPreprocessingNumDilationsParamDesc.default_value,
              kDepthPreprocessingNumDilationsParamDesc.help_string);
 
+DEFINE_bool(use_cuda_graphs, kUseCudaGraphsParamDesc.default_value,
+            kUseCudaGraphsParamDesc.help_string);
+
+DEFINE_bool(use_vpi_depth_preprocessing,
+            kUseVpiDepthPreprocessingParamDesc.default_value,
+            kUseVpiDepthPreprocessingParamDesc.help_string);
+
+DEFINE_bool(build_depth_pyramid, kBuildDepthPyramidParamDesc.default_value,
+            kBuildDepthPyramidParamDesc.help_string);
+
+DEFINE_bool(concurrent_layer_serialization,
+            kConcurrentLayerSerializationParamDesc.default_value,
+            kConcurrentLayerSerializationParamDesc.help_string);
+
+DEFINE_bool(compress_saved_maps, kCompressSavedMapsParamDesc.default_value,
+            kCompressSavedMapsParamDesc.help_string);
+
+DEFINE_bool(save_derived_layers, kSaveDerivedLayersParamDesc.default_value,
+            kSaveDerivedLayersParamDesc.help_string);
+
+DEFINE_bool(preallocate_blocks, kPreallocateBlocksParamDesc.default_value,
+            kPreallocateBlocksParamDesc.help_string);
+
+DEFINE_double(esdf_window_half_extent_m,
+              kEsdfWindowHalfExtentMParamDesc.default_value,
+              kEsdfWindowHalfExtentMParamDesc.help_string);
+
+DEFINE_double(memory_pressure_watermark,
+              kMemoryPressureWatermarkParamDesc.default_value,
+              kMemoryPressureWatermarkParamDesc.help_string);
+DEFINE_double(memory_pressure_keep_radius_m,
+              kMemoryPressureKeepRadiusMParamDesc.default_value,
+              kMemoryPressureKeepRadiusMParamDesc.help_string);
+DEFINE_bool(memory_pressure_page_out,
+            kMemoryPressurePageOutParamDesc.default_value,
+            kMemoryPressurePageOutParamDesc.help_string);
+DEFINE_bool(morton_ordered_blocks, kMortonOrderedBlocksParamDesc.default_value,
+            kMortonOrderedBlocksParamDesc.help_string);
+DEFINE_double(block_relayout_allocation_fraction,
+              kBlockRelayoutAllocationFractionParamDesc.default_value,
+              kBlockRelayoutAllocationFractionParamDesc.help_string);
+
 DEFINE_double(esdf_slice_min_height, kEsdfSliceMinHeightParamDesc.default_value,
               kEsdfSliceMinHeightParamDesc.help_string);
 
@@ -90,6 +132,24 @@ DEFINE_int32(
     static_cast<int>(kProjectiveIntegratorWeightingModeParamDesc.default_value),
     kProjectiveIntegratorWeightingModeParamDesc.help_string);
 
+DEFINE_bool(
+    projective_color_integrator_surface_only_allocation,
+    kProjectiveColorIntegratorSurfaceOnlyAllocationParamDesc.default_value,
+    kProjectiveColorIntegratorSurfaceOnlyAllocationParamDesc.help_string);
+
+DEFINE_bool(projective_color_integrator_reuse_depth_frame,
+            kProjectiveColorIntegratorReuseDepthFrameParamDesc.default_value,
+            kProjectiveColorIntegratorReuseDepthFrameParamDesc.help_string);
+
+DEFINE_bool(
+    lidar_projective_integrator_approximate_projection,
+    kLidarProjectiveIntegratorApproximateProjectionParamDesc.default_value,
+    kLidarProjectiveIntegratorApproximateProjectionParamDesc.help_string);
+
+DEFINE_int32(projective_integrator_subsampling_factor,
+             kProjectiveIntegratorSubsamplingFactorParamDesc.default_value,
+             kProjectiveIntegratorSubsamplingFactorParamDesc.help_string);
+
 // ======= OCCUPANCY INTEGRATOR =======
 DEFINE_double(free_region_occupancy_probability,
               kFreeRegionOccupancyProbabilityParamDesc.default_value,
@@ -140,6 +200,10 @@ DEFINE_double(workspace_bounds_max_corner_y_m,
               kWorkspaceBoundsMaxCornerYDesc.default_value,
               kWorkspaceBoundsMaxCornerYDesc.help_string);
 
+DEFINE_bool(hierarchical_planes_culling,
+            kHierarchicalPlanesCullingDesc.default_value,
+            kHierarchicalPlanesCullingDesc.help_string);
+
 // ======= ESDF INTEGRATOR =======
 DEFINE_double(esdf_integrator_max_distance_m,
               kEsdfIntegratorMaxDistanceMParamDesc.default_value,
@@ -149,6 +213,10 @@ DEFINE_double(esdf_integrator_min_weight,
               kEsdfIntegratorMinWeightParamDesc.default_value,
               kEsdfIntegratorMinWeightParamDesc.help_string);
 
+DEFINE_bool(esdf_integrator_use_persistent_kernel,
+            kEsdfIntegratorUsePersistentKernelParamDesc.default_value,
+            kEsdfIntegratorUsePersistentKernelParamDesc.help_string);
+
 DEFINE_double(esdf_integrator_max_site_distance_vox,
               kEsdfIntegratorMaxSiteDistanceVoxParamDesc.default_value,
               kEsdfIntegratorMaxSiteDistanceVoxParamDesc.help_string);
@@ -162,6 +230,14 @@ DEFINE_bool(mesh_integrator_weld_vertices,
             kMeshIntegratorWeldVerticesParamDesc.default_value,
             kMeshIntegratorWeldVerticesParamDesc.help_string);
 
+DEFINE_bool(mesh_integrator_fused_meshing,
+            kMeshIntegratorFusedMeshingParamDesc.default_value,
+            kMeshIntegratorFusedMeshingParamDesc.help_string);
+
+DEFINE_int32(mesh_integrator_num_cpu_threads,
+             kMeshIntegratorNumCpuThreadsParamDesc.default_value,
+             kMeshIntegratorNumCpuThreadsParamDesc.help_string);
+
 // ======= DECAY INTEGRATOR (TSDF/OCCUPANCY)=======
 DEFINE_bool(decay_integrator_deallocate_decayed_blocks,
             kDecayIntegratorDeallocateDecayedBlocks.default_value,
@@ -183,6 +259,26 @@ DEFINE_double(tsdf_decayed_free_distance_vox,
               kTsdfDecayedFreeDistanceVoxDesc.default_value,
               kTsdfDecayedFreeDistanceVoxDesc.help_string);
 
+DEFINE_bool(tsdf_lazy_decay, kTsdfLazyDecayDesc.default_value,
+            kTsdfLazyDecayDesc.help_string);
+
+DEFINE_int32(tsdf_lazy_decay_compaction_period,
+             kTsdfLazyDecayCompactionPeriodDesc.default_value,
+             kTsdfLazyDecayCompactionPeriodDesc.help_string);
+
+// ======= TSDF BLOCK PRUNER =======
+DEFINE_int32(tsdf_block_pruning_period,
+             kTsdfBlockPruningPeriodDesc.default_value,
+             kTsdfBlockPruningPeriodDesc.help_string);
+
+DEFINE_double(tsdf_block_pruning_min_weight,
+              kTsdfBlockPruningMinWeightDesc.default_value,
+              kTsdfBlockPruningMinWeightDesc.help_string);
+
+DEFINE_bool(tsdf_block_pruning_prune_outside_truncation_band,
+            kTsdfBlockPruningPruneOutsideTruncationBandDesc.default_value,
+            kTsdfBlockPruningPruneOutsideTruncationBandDesc.help_string);
+
 // ======= OCCUPANCY DECAY INTEGRATOR =======
 DEFINE_double(free_region_decay_probability,
               kFreeRegionDecayProbabilityParamDesc.default_value,
@@ -195,6 +291,9 @@ DEFINE_double(occupied_region_decay_probability,
 DEFINE_bool(occupancy_decay_to_free,
             kOccupancyDecayToFreeParamDesc.default_value,
             kOccupancyDecayToFreeParamDesc.help_string);
+DEFINE_bool(occupancy_decay_skip_inactive_blocks,
+            kOccupancyDecaySkipInactiveBlocksParamDesc.default_value,
+            kOccupancyDecaySkipInactiveBlocksParamDesc.help_string);
 
 // ======= FREESPACE INTEGRATOR =======
 DEFINE_double(max_tsdf_distance_for_occupancy_m,
@@ -221,6 +320,8 @@ DEFINE_int64(
 
 DEFINE_bool(check_neighborhood, kCheckNeighborhoodParamDesc.default_value,
             kCheckNeighborhoodParamDesc.help_string);
+DEFINE_bool(skip_settled_blocks, kSkipSettledBlocksParamDesc.default_value,
+            kSkipSettledBlocksParamDesc.help_string);
 
 // <<<<<<<<<<<<<<<<<<<<<<<<<< GET THE PARAMS >>>>>>>>>>>>>>>>>>>>>>>>>>
 
@@ -308,6 +409,94 @@ inline MapperParams get_mapper_params_from_gflags() {
     params.depth_preprocessing_num_dilations =
         FLAGS_depth_preprocessing_num_dilations;
   }
+  if (!gflags::GetCommandLineFlagInfoOrDie("use_cuda_graphs").is_default) {
+    LOG(INFO) << "command line parameter found: "
+                 "use_cuda_graphs = "
+              << FLAGS_use_cuda_graphs;
+    params.use_cuda_graphs = FLAGS_use_cuda_graphs;
+  }
+  if (!gflags::GetCommandLineFlagInfoOrDie("use_vpi_depth_preprocessing")
+           .is_default) {
+    LOG(INFO) << "command line parameter found: "
+                 "use_vpi_depth_preprocessing = "
+              << FLAGS_use_vpi_depth_preprocessing;
+    params.use_vpi_depth_preprocessing = FLAGS_use_vpi_depth_preprocessing;
+  }
+  if (!gflags::GetCommandLineFlagInfoOrDie("build_depth_pyramid").is_default) {
+    LOG(INFO) << "command line parameter found: build_depth_pyramid = "
+              << FLAGS_build_depth_pyramid;
+    params.build_depth_pyramid = FLAGS_build_depth_pyramid;
+  }
+  if (!gflags::GetCommandLineFlagInfoOrDie("concurrent_layer_serialization")
+           .is_default) {
+    LOG(INFO) << "command line parameter found: "
+                 "concurrent_layer_serialization = "
+              << FLAGS_concurrent_layer_serialization;
+    params.concurrent_layer_serialization =
+        FLAGS_concurrent_layer_serialization;
+  }
+  if (!gflags::GetCommandLineFlagInfoOrDie("compress_saved_maps")
+           .is_default) {
+    LOG(INFO) << "command line parameter found: "
+                 "compress_saved_maps = "
+              << FLAGS_compress_saved_maps;
+    params.compress_saved_maps = FLAGS_compress_saved_maps;
+  }
+  if (!gflags::GetCommandLineFlagInfoOrDie("save_derived_layers")
+           .is_default) {
+    LOG(INFO) << "command line parameter found: "
+                 "save_derived_layers = "
+              << FLAGS_save_derived_layers;
+    params.save_derived_layers = FLAGS_save_derived_layers;
+  }
+  if (!gflags::GetCommandLineFlagInfoOrDie("preallocate_blocks").is_default) {
+    LOG(INFO) << "Command line parameter found: preallocate_blocks = "
+              << FLAGS_preallocate_blocks;
+    params.preallocate_blocks = FLAGS_preallocate_blocks;
+  }
+  if (!gflags::GetCommandLineFlagInfoOrDie("esdf_window_half_extent_m")
+           .is_default) {
+    LOG(INFO) << "Command line parameter found: esdf_window_half_extent_m = "
+              << FLAGS_esdf_window_half_extent_m;
+    params.esdf_window_half_extent_m =
+        static_cast<float>(FLAGS_esdf_window_half_extent_m);
+  }
+  if (!gflags::GetCommandLineFlagInfoOrDie("memory_pressure_watermark")
+           .is_default) {
+    LOG(INFO) << "Command line parameter found: memory_pressure_watermark = "
+              << FLAGS_memory_pressure_watermark;
+    params.memory_pressure_watermark =
+        static_cast<float>(FLAGS_memory_pressure_watermark);
+  }
+  if (!gflags::GetCommandLineFlagInfoOrDie("memory_pressure_keep_radius_m")
+           .is_default) {
+    LOG(INFO) << "Command line parameter found: "
+                 "memory_pressure_keep_radius_m = "
+              << FLAGS_memory_pressure_keep_radius_m;
+    params.memory_pressure_keep_radius_m =
+        static_cast<float>(FLAGS_memory_pressure_keep_radius_m);
+  }
+  if (!gflags::GetCommandLineFlagInfoOrDie("memory_pressure_page_out")
+           .is_default) {
+    LOG(INFO) << "Command line parameter found: memory_pressure_page_out = "
+              << FLAGS_memory_pressure_page_out;
+    params.memory_pressure_page_out = FLAGS_memory_pressure_page_out;
+  }
+  if (!gflags::GetCommandLineFlagInfoOrDie("morton_ordered_blocks")
+           .is_default) {
+    LOG(INFO) << "Command line parameter found: morton_ordered_blocks = "
+              << FLAGS_morton_ordered_blocks;
+    params.morton_ordered_blocks = FLAGS_morton_ordered_blocks;
+  }
+  if (!gflags::GetCommandLineFlagInfoOrDie(
+           "block_relayout_allocation_fraction")
+           .is_default) {
+    LOG(INFO) << "Command line parameter found: "
+                 "block_relayout_allocation_fraction = "
+              << FLAGS_block_relayout_allocation_fraction;
+    params.block_relayout_allocation_fraction =
+        static_cast<float>(FLAGS_block_relayout_allocation_fraction);
+  }
   // 2D esdf slice
   if (!gflags::GetCommandLineFlagInfoOrDie("esdf_slice_min_height")
            .is_default) {
@@ -386,6 +575,48 @@ inline MapperParams get_mapper_params_from_gflags() {
         FLAGS_projective_tsdf_integrator_invalid_depth_decay_factor;
   }
 
+  // Color allocation
+  if (!gflags::GetCommandLineFlagInfoOrDie(
+           "projective_color_integrator_surface_only_allocation")
+           .is_default) {
+    LOG(INFO) << "Command line parameter found: "
+                 "projective_color_integrator_surface_only_allocation = "
+              << FLAGS_projective_color_integrator_surface_only_allocation;
+    params.projective_integrator_params
+        .projective_color_integrator_surface_only_allocation =
+        FLAGS_projective_color_integrator_surface_only_allocation;
+  }
+  if (!gflags::GetCommandLineFlagInfoOrDie(
+           "projective_color_integrator_reuse_depth_frame")
+           .is_default) {
+    LOG(INFO) << "Command line parameter found: "
+                 "projective_color_integrator_reuse_depth_frame = "
+              << FLAGS_projective_color_integrator_reuse_depth_frame;
+    params.projective_integrator_params
+        .projective_color_integrator_reuse_depth_frame =
+        FLAGS_projective_color_integrator_reuse_depth_frame;
+  }
+  if (!gflags::GetCommandLineFlagInfoOrDie(
+           "lidar_projective_integrator_approximate_projection")
+           .is_default) {
+    LOG(INFO) << "Command line parameter found: "
+                 "lidar_projective_integrator_approximate_projection = "
+              << FLAGS_lidar_projective_integrator_approximate_projection;
+    params.projective_integrator_params
+        .lidar_projective_integrator_approximate_projection =
+        FLAGS_lidar_projective_integrator_approximate_projection;
+  }
+  if (!gflags::GetCommandLineFlagInfoOrDie(
+           "projective_integrator_subsampling_factor")
+           .is_default) {
+    LOG(INFO) << "Command line parameter found: "
+                 "projective_integrator_subsampling_factor = "
+              << FLAGS_projective_integrator_subsampling_factor;
+    params.projective_integrator_params
+        .projective_integrator_subsampling_factor =
+        FLAGS_projective_integrator_subsampling_factor;
+  }
+
   // ======= OCCUPANCY INTEGRATOR =======
   if (!gflags::GetCommandLineFlagInfoOrDie("free_region_occupancy_probability")
            .is_default) {
@@ -484,6 +715,13 @@ inline MapperParams get_mapper_params_from_gflags() {
     params.view_calculator_params.workspace_bounds_max_corner_y_m =
         FLAGS_workspace_bounds_max_corner_y_m;
   }
+  if (!gflags::GetCommandLineFlagInfoOrDie("hierarchical_planes_culling")
+           .is_default) {
+    LOG(INFO) << "Command line parameter found: hierarchical_planes_culling = "
+              << FLAGS_hierarchical_planes_culling;
+    params.view_calculator_params.hierarchical_planes_culling =
+        FLAGS_hierarchical_planes_culling;
+  }
 
   // ======= ESDF INTEGRATOR =======
   if (!gflags::GetCommandLineFlagInfoOrDie("esdf_integrator_min_weight")
@@ -493,6 +731,15 @@ inline MapperParams get_mapper_params_from_gflags() {
     params.esdf_integrator_params.esdf_integrator_min_weight =
         FLAGS_esdf_integrator_min_weight;
   }
+  if (!gflags::GetCommandLineFlagInfoOrDie(
+           "esdf_integrator_use_persistent_kernel")
+           .is_default) {
+    LOG(INFO) << "Command line parameter found: "
+                 "esdf_integrator_use_persistent_kernel = "
+              << FLAGS_esdf_integrator_use_persistent_kernel;
+    params.esdf_integrator_params.esdf_integrator_use_persistent_kernel =
+        FLAGS_esdf_integrator_use_persistent_kernel;
+  }
   if (!gflags::GetCommandLineFlagInfoOrDie(
            "esdf_integrator_max_site_distance_vox")
            .is_default) {
@@ -527,6 +774,22 @@ inline MapperParams get_mapper_params_from_gflags() {
     params.mesh_integrator_params.mesh_integrator_weld_vertices =
         FLAGS_mesh_integrator_weld_vertices;
   }
+  if (!gflags::GetCommandLineFlagInfoOrDie("mesh_integrator_fused_meshing")
+           .is_default) {
+    LOG(INFO)
+        << "Command line parameter found: mesh_integrator_fused_meshing = "
+        << FLAGS_mesh_integrator_fused_meshing;
+    params.mesh_integrator_params.mesh_integrator_fused_meshing =
+        FLAGS_mesh_integrator_fused_meshing;
+  }
+  if (!gflags::GetCommandLineFlagInfoOrDie("mesh_integrator_num_cpu_threads")
+           .is_default) {
+    LOG(INFO)
+        << "Command line parameter found: mesh_integrator_num_cpu_threads = "
+        << FLAGS_mesh_integrator_num_cpu_threads;
+    params.mesh_integrator_params.mesh_integrator_num_cpu_threads =
+        FLAGS_mesh_integrator_num_cpu_threads;
+  }
 
   // ======= DECAY INTEGRATOR (TSDF/OCCUPANCY)=======
   if (!gflags::GetCommandLineFlagInfoOrDie(
@@ -572,6 +835,48 @@ inline MapperParams get_mapper_params_from_gflags() {
     params.tsdf_decay_integrator_params.tsdf_decayed_free_distance_vox =
         FLAGS_tsdf_decayed_free_distance_vox;
   }
+  if (!gflags::GetCommandLineFlagInfoOrDie("tsdf_lazy_decay").is_default) {
+    LOG(INFO) << "command line parameter found: "
+                 "tsdf_lazy_decay = "
+              << FLAGS_tsdf_lazy_decay;
+    params.tsdf_decay_integrator_params.tsdf_lazy_decay = FLAGS_tsdf_lazy_decay;
+  }
+  if (!gflags::GetCommandLineFlagInfoOrDie("tsdf_lazy_decay_compaction_period")
+           .is_default) {
+    LOG(INFO) << "command line parameter found: "
+                 "tsdf_lazy_decay_compaction_period = "
+              << FLAGS_tsdf_lazy_decay_compaction_period;
+    params.tsdf_decay_integrator_params.tsdf_lazy_decay_compaction_period =
+        FLAGS_tsdf_lazy_decay_compaction_period;
+  }
+
+  // ======= TSDF BLOCK PRUNER =======
+  if (!gflags::GetCommandLineFlagInfoOrDie("tsdf_block_pruning_period")
+           .is_default) {
+    LOG(INFO) << "command line parameter found: "
+                 "tsdf_block_pruning_period = "
+              << FLAGS_tsdf_block_pruning_period;
+    params.tsdf_block_pruner_params.tsdf_block_pruning_period =
+        FLAGS_tsdf_block_pruning_period;
+  }
+  if (!gflags::GetCommandLineFlagInfoOrDie("tsdf_block_pruning_min_weight")
+           .is_default) {
+    LOG(INFO) << "command line parameter found: "
+                 "tsdf_block_pruning_min_weight = "
+              << FLAGS_tsdf_block_pruning_min_weight;
+    params.tsdf_block_pruner_params.tsdf_block_pruning_min_weight =
+        static_cast<float>(FLAGS_tsdf_block_pruning_min_weight);
+  }
+  if (!gflags::GetCommandLineFlagInfoOrDie(
+           "tsdf_block_pruning_prune_outside_truncation_band")
+           .is_default) {
+    LOG(INFO) << "command line parameter found: "
+                 "tsdf_block_pruning_prune_outside_truncation_band = "
+              << FLAGS_tsdf_block_pruning_prune_outside_truncation_band;
+    params.tsdf_block_pruner_params
+        .tsdf_block_pruning_prune_outside_truncation_band =
+        FLAGS_tsdf_block_pruning_prune_outside_truncation_band;
+  }
 
   // ======= OCCUPANCY DECAY INTEGRATOR =======
   if (!gflags::GetCommandLineFlagInfoOrDie("free_region_decay_probability")
@@ -598,6 +903,16 @@ inline MapperParams get_mapper_params_from_gflags() {
     params.occupancy_decay_integrator_params.occupancy_decay_to_free =
         FLAGS_occupancy_decay_to_free;
   }
+  if (!gflags::GetCommandLineFlagInfoOrDie(
+           "occupancy_decay_skip_inactive_blocks")
+           .is_default) {
+    LOG(INFO) << "command line parameter found: "
+                 "occupancy_decay_skip_inactive_blocks = "
+              << FLAGS_occupancy_decay_skip_inactive_blocks;
+    params.occupancy_decay_integrator_params
+        .occupancy_decay_skip_inactive_blocks =
+        FLAGS_occupancy_decay_skip_inactive_blocks;
+  }
 
   // ======= FREESPACE INTEGRATOR =======
   if (!gflags::GetCommandLineFlagInfoOrDie("max_tsdf_distance_for_occupancy_m")
@@ -645,6 +960,13 @@ inline MapperParams get_mapper_params_from_gflags() {
     params.freespace_integrator_params.check_neighborhood =
         FLAGS_check_neighborhood;
   }
+  if (!gflags::GetCommandLineFlagInfoOrDie("skip_settled_blocks").is_default) {
+    LOG(INFO) << "command line parameter found: "
+                 "skip_settled_blocks = "
+              << FLAGS_skip_settled_blocks;
+    params.freespace_integrator_params.skip_settled_blocks =
+        FLAGS_skip_settled_blocks;
+  }
 
   // return the written params
   return params;
@@ -117,7 +117,8 @@ std::unique_ptr<ImageLoader<ColorImage>> createColorImageLoader(
 
 std::unique_ptr<Fuser> createFuser(const std::string base_path,
                                    const int seq_id, bool init_from_gflags) {
-  auto data_loader = DataLoader::create(base_path, seq_id, false);
+  auto data_loader = DataLoader::create(base_path, seq_id,
+                                        FLAGS_multithreaded_image_loading);
   if (!data_loader) {
     return std::unique_ptr<Fuser>();
   }
@@ -15,18 +15,42 @@ limitations under the License.
 */
 #include "nvblox/datasets/image_loader.h"
 
+#include <gflags/gflags.h>
 #include <Eigen/Core>
 
+#ifdef NVBLOX_WITH_NVJPEG
+#include <nvjpeg.h>
+#endif
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <type_traits>
+
 #include "nvblox/io/internal/thirdparty/stb_image.h"
 #include "nvblox/utils/timing.h"
 
+DEFINE_bool(multithreaded_image_loading, true,
+            "Whether the dataset Fusers decode images on multiple threads.");
+DEFINE_int32(image_loader_num_threads, 0,
+             "Number of threads decoding dataset images when loading "
+             "multi-threaded. If <= 0, chosen based on the number of cores.");
+DEFINE_int32(image_loader_prefetch_queue_size, 0,
+             "Maximum number of dataset images decoded ahead when loading "
+             "multi-threaded. If <= 0, twice the number of threads.");
+DEFINE_bool(gpu_image_decoding, false,
+            "Whether the dataset Fusers decode images into device memory, "
+            "decoding JPEGs with nvJPEG. Takes precedence over "
+            "multithreaded_image_loading.");
+
 namespace nvblox {
 namespace datasets {
 
-bool load16BitDepthImage(const std::string& filename,
-                         DepthImage* depth_frame_ptr,
-                         const float scale_factor) {
-  CHECK_NOTNULL(depth_frame_ptr);
+bool decode16BitDepthImage(
+    const std::string& filename, const float scale_factor,
+    const DecodeDestinationFunction<float>& get_destination) {
   timing::Timer stbi_timer("file_loading/depth_image/stbi");
   int width, height, num_channels;
   uint16_t* image_data =
@@ -41,21 +65,20 @@ bool load16BitDepthImage(const std::string& filename,
   // TODO(alexmillane): It's likely better to do this on the GPU.
   //                    Follow up: I measured and this scaling + cast takes
   //                    ~1ms. So only do this when 1ms is relevant.
-  std::vector<float> float_image_data(height * width);
-  for (size_t lin_idx = 0; lin_idx < float_image_data.size(); lin_idx++) {
+  float* float_image_data = get_destination(height, width);
+  const size_t num_pixels = static_cast<size_t>(height) * width;
+  for (size_t lin_idx = 0; lin_idx < num_pixels; lin_idx++) {
     float_image_data[lin_idx] =
         static_cast<float>(image_data[lin_idx]) * scale_factor;
   }
 
-  depth_frame_ptr->copyFrom(height, width, float_image_data.data());
-
   stbi_image_free(image_data);
   return true;
 }
 
-bool load8BitColorImage(const std::string& filename,
-                        ColorImage* color_image_ptr) {
-  CHECK_NOTNULL(color_image_ptr);
+bool decode8BitColorImage(
+    const std::string& filename,
+    const DecodeDestinationFunction<Color>& get_destination) {
   timing::Timer stbi_timer("file_loading/color_image/stbi");
   int width, height, num_channels;
   uint8_t* image_data =
@@ -72,13 +95,52 @@ bool load8BitColorImage(const std::string& filename,
   CHECK_EQ(sizeof(Color), 4 * sizeof(uint8_t))
       << "Color struct was padded by the compiler so image loading wont work.";
 
-  color_image_ptr->copyFrom(height, width,
-                            reinterpret_cast<Color*>(image_data));
+  std::memcpy(get_destination(height, width), image_data,
+              static_cast<size_t>(height) * width * sizeof(Color));
 
   stbi_image_free(image_data);
   return true;
 }
 
+bool load16BitDepthImage(const std::string& filename,
+                         DepthImage* depth_frame_ptr,
+                         const float scale_factor) {
+  CHECK_NOTNULL(depth_frame_ptr);
+  std::vector<float> float_image_data;
+  int rows = 0;
+  int cols = 0;
+  const bool res = decode16BitDepthImage(
+      filename, scale_factor, [&](int image_rows, int image_cols) {
+        rows = image_rows;
+        cols = image_cols;
+        float_image_data.resize(static_cast<size_t>(rows) * cols);
+        return float_image_data.data();
+      });
+  if (res) {
+    depth_frame_ptr->copyFrom(rows, cols, float_image_data.data());
+  }
+  return res;
+}
+
+bool load8BitColorImage(const std::string& filename,
+                        ColorImage* color_image_ptr) {
+  CHECK_NOTNULL(color_image_ptr);
+  std::vector<Color> color_image_data;
+  int rows = 0;
+  int cols = 0;
+  const bool res =
+      decode8BitColorImage(filename, [&](int image_rows, int image_cols) {
+        rows = image_rows;
+        cols = image_cols;
+        color_image_data.resize(static_cast<size_t>(rows) * cols);
+        return color_image_data.data();
+      });
+  if (res) {
+    color_image_ptr->copyFrom(rows, cols, color_image_data.data());
+  }
+  return res;
+}
+
 template <>
 bool ImageLoader<DepthImage>::getImage(int image_idx, DepthImage* image_ptr) {
   CHECK_NOTNULL(image_ptr);
@@ -94,5 +156,222 @@ bool ImageLoader<ColorImage>::getImage(int image_idx, ColorImage* image_ptr) {
   return res;
 }
 
+template <>
+bool ImageLoader<DepthImage>::decodeImage(
+    int image_idx,
+    const DecodeDestinationFunction<float>& get_destination) const {
+  return decode16BitDepthImage(index_to_filepath_(image_idx),
+                               depth_image_scaling_factor_, get_destination);
+}
+
+template <>
+bool ImageLoader<ColorImage>::decodeImage(
+    int image_idx,
+    const DecodeDestinationFunction<Color>& get_destination) const {
+  return decode8BitColorImage(index_to_filepath_(image_idx), get_destination);
+}
+
+#ifdef NVBLOX_WITH_NVJPEG
+
+#define checkNvjpegErrors(val) \
+  nvjpegCheck((val), #val, __FILE__, __LINE__)
+
+inline void nvjpegCheck(nvjpegStatus_t status, const char* const func,
+                        const char* const file, const int line) {
+  CHECK(status == NVJPEG_STATUS_SUCCESS)
+      << "nvJPEG error " << static_cast<int>(status) << " at " << file << ":"
+      << line << " '" << func << "'";
+}
+
+class NvjpegDecoder {
+ public:
+  NvjpegDecoder() {
+    checkNvjpegErrors(nvjpegCreateSimple(&handle_));
+    checkNvjpegErrors(nvjpegJpegStateCreate(handle_, &state_));
+  }
+  ~NvjpegDecoder() {
+    nvjpegJpegStateDestroy(state_);
+    nvjpegDestroy(handle_);
+  }
+
+  // Decodes an encoded JPEG into interleaved RGB on the device. Resizes rgb
+  // to (rows x cols x 3).
+  bool decode(const std::vector<unsigned char>& encoded,
+              device_vector<uint8_t>* rgb, int* rows, int* cols,
+              const CudaStream& cuda_stream) {
+    int num_components = 0;
+    nvjpegChromaSubsampling_t subsampling;
+    int widths[NVJPEG_MAX_COMPONENT];
+    int heights[NVJPEG_MAX_COMPONENT];
+    if (nvjpegGetImageInfo(handle_, encoded.data(), encoded.size(),
+                           &num_components, &subsampling, widths,
+                           heights) != NVJPEG_STATUS_SUCCESS) {
+      return false;
+    }
+    *rows = heights[0];
+    *cols = widths[0];
+    rgb->resizeAsync(static_cast<size_t>(*rows) * *cols * 3, cuda_stream);
+
+    nvjpegImage_t destination{};
+    destination.channel[0] = rgb->data();
+    destination.pitch[0] = static_cast<unsigned int>(*cols) * 3;
+    return nvjpegDecode(handle_, state_, encoded.data(), encoded.size(),
+                        NVJPEG_OUTPUT_RGBI, &destination,
+                        cuda_stream) == NVJPEG_STATUS_SUCCESS;
+  }
+
+ private:
+  nvjpegHandle_t handle_;
+  nvjpegJpegState_t state_;
+};
+
+bool isGpuJpegDecodingAvailable() { return true; }
+
+#else
+
+class NvjpegDecoder {};
+
+bool isGpuJpegDecodingAvailable() { return false; }
+
+#endif  // NVBLOX_WITH_NVJPEG
+
+namespace {
+
+bool isJpegFile(const std::string& filename) {
+  const size_t dot = filename.find_last_of('.');
+  if (dot == std::string::npos) {
+    return false;
+  }
+  std::string extension = filename.substr(dot + 1);
+  std::transform(extension.begin(), extension.end(), extension.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  return extension == "jpg" || extension == "jpeg";
+}
+
+}  // namespace
+
+template <typename ImageType>
+GpuDecodingImageLoader<ImageType>::GpuDecodingImageLoader(
+    IndexToFilepathFunction index_to_filepath,
+    float depth_image_scaling_factor)
+    : ImageLoader<ImageType>(index_to_filepath, depth_image_scaling_factor) {
+#ifdef NVBLOX_WITH_NVJPEG
+  if constexpr (std::is_same_v<ImageType, ColorImage>) {
+    jpeg_decoder_ = std::make_unique<NvjpegDecoder>();
+  }
+#endif
+}
+
+// Defined here, where NvjpegDecoder is complete.
+template <typename ImageType>
+GpuDecodingImageLoader<ImageType>::~GpuDecodingImageLoader() = default;
+
+template <typename ImageType>
+bool GpuDecodingImageLoader<ImageType>::getNextImage(ImageType* image_ptr) {
+  CHECK_NOTNULL(image_ptr);
+  const std::string filename = this->index_to_filepath_(this->image_idx_);
+  bool res;
+  if (canDecodeOnGpu(filename, *image_ptr)) {
+    res = decodeOnGpu(filename, image_ptr);
+  } else {
+    res = this->getImage(this->image_idx_, image_ptr);
+  }
+  ++this->image_idx_;
+  return res;
+}
+
+template <>
+bool GpuDecodingImageLoader<DepthImage>::canDecodeOnGpu(
+    const std::string&, const DepthImage& image) const {
+  return image.memory_type() != MemoryType::kHost;
+}
+
+template <>
+bool GpuDecodingImageLoader<ColorImage>::canDecodeOnGpu(
+    const std::string& filename, const ColorImage& image) const {
+  return jpeg_decoder_ != nullptr && isJpegFile(filename) &&
+         image.memory_type() != MemoryType::kHost;
+}
+
+template <>
+bool GpuDecodingImageLoader<DepthImage>::decodeOnGpu(
+    const std::string& filename, DepthImage* image_ptr) {
+  timing::Timer stbi_timer("file_loading/depth_image/stbi");
+  int width, height, num_channels;
+  uint16_t* image_data =
+      stbi_load_16(filename.c_str(), &width, &height, &num_channels, 0);
+  stbi_timer.Stop();
+  if (image_data == nullptr) {
+    return false;
+  }
+  CHECK_EQ(num_channels, 1);
+
+  // Upload the uint16 depth and convert it to meters on the GPU.
+  timing::Timer convert_timer("file_loading/depth_image/gpu_convert");
+  depth_image_u16_.copyFromAsync(height, width, image_data, cuda_stream_);
+  image::castGPUAsync(depth_image_u16_, depth_image_scaling_factor_,
+                      image_ptr, cuda_stream_);
+  cuda_stream_.synchronize();
+  convert_timer.Stop();
+
+  stbi_image_free(image_data);
+  return true;
+}
+
+template <>
+bool GpuDecodingImageLoader<ColorImage>::decodeOnGpu(
+    const std::string& filename, ColorImage* image_ptr) {
+#ifdef NVBLOX_WITH_NVJPEG
+  timing::Timer read_timer("file_loading/color_image/read");
+  std::ifstream file(filename, std::ios::binary);
+  if (!file) {
+    return false;
+  }
+  const std::vector<unsigned char> encoded(
+      (std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  read_timer.Stop();
+
+  timing::Timer decode_timer("file_loading/color_image/nvjpeg");
+  int rows = 0;
+  int cols = 0;
+  if (!jpeg_decoder_->decode(encoded, &rgb_buffer_, &rows, &cols,
+                             cuda_stream_)) {
+    // E.g. a progressive JPEG nvJPEG can't handle. Decode on the CPU.
+    return load8BitColorImage(filename, image_ptr);
+  }
+  image::colorImageFromRgbGPUAsync(rgb_buffer_.data(), rows, cols, image_ptr,
+                                   cuda_stream_);
+  cuda_stream_.synchronize();
+  return true;
+#else
+  (void)filename;
+  (void)image_ptr;
+  LOG(FATAL) << "Built without nvJPEG.";
+  return false;
+#endif
+}
+
+template class GpuDecodingImageLoader<DepthImage>;
+template class GpuDecodingImageLoader<ColorImage>;
+
+int getNumImageLoaderThreads() {
+  if (FLAGS_image_loader_num_threads > 0) {
+    return FLAGS_image_loader_num_threads;
+  }
+  // NOTE(alexmillane): On my desktop the performance of threaded image
+  // loading seems to saturate at around 6 threads. On machines with less
+  // cores (I have 12 physical) presumably the saturation point will be less.
+  constexpr unsigned int kMaxLoadingThreads = 6;
+  return static_cast<int>(std::clamp(std::thread::hardware_concurrency() / 2,
+                                     1U, kMaxLoadingThreads));
+}
+
+int getImageLoaderPrefetchQueueSize(int num_threads) {
+  if (FLAGS_image_loader_prefetch_queue_size > 0) {
+    return FLAGS_image_loader_prefetch_queue_size;
+  }
+  return 2 * num_threads;
+}
+
 }  // namespace datasets
 }  // namespace nvblox
@@ -146,7 +146,8 @@ std::unique_ptr<ImageLoader<ColorImage>> createColorImageLoader(
 
 std::unique_ptr<Fuser> createFuser(const std::string base_path,
                                    bool init_from_gflags) {
-  auto data_loader = DataLoader::create(base_path, false);
+  auto data_loader =
+      DataLoader::create(base_path, FLAGS_multithreaded_image_loading);
   if (!data_loader) {
     return std::unique_ptr<Fuser>();
   }
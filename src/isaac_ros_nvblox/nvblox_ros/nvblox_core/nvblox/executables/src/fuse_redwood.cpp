@@ -17,6 +17,7 @@ limitations under the License.
 #include <fstream>
 #include <sstream>
 #include <string>
+#include <vector>
 
 #include <iomanip>
 #include <iostream>
@@ -38,6 +39,18 @@ int main(int argc, char* argv[]) {
   FLAGS_alsologtostderr = true;
   google::InstallFailureSignalHandler();
 
+  // Batch mode: reconstruct several sequences at once.
+  const std::vector<std::string> batch_dataset_paths =
+      getBatchDatasetPathsFromGflags();
+  if (!batch_dataset_paths.empty()) {
+    return runFuserBatch(
+        batch_dataset_paths,
+        [](const std::string& dataset_path) {
+          return datasets::redwood::createFuser(dataset_path);
+        },
+        getBatchFuserParamsFromGflags());
+  }
+
   // Path to the dataset
   if (argc < 2) {
     LOG(ERROR) << "No path to data directory given, failing.";
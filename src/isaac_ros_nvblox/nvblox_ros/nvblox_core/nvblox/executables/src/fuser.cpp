@@ -15,11 +15,22 @@ limitations under the License.
 */
 #include "nvblox/executables/fuser.h"
 #include <gflags/gflags.h>
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <limits>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
 #include "nvblox/gflags_param_loading/fuser_params_from_gflags.h"
 #include "nvblox/gflags_param_loading/mapper_params_from_gflags.h"
 #include "nvblox/utils/logging.h"
 
+#include "nvblox/core/internal/error_check.h"
 #include "nvblox/core/parameter_tree.h"
+#include "nvblox/core/sync_monitor.h"
 #include "nvblox/executables/fuser.h"
 #include "nvblox/io/mesh_io.h"
 #include "nvblox/io/ply_writer.h"
@@ -54,6 +65,7 @@ void Fuser::initFromGflags() {
 
   // Init fuser params
   set_fuser_params_from_gflags(this);
+  set_launch_autotuner_params_from_gflags();
 
   // Init mapper params (for the two mapper held by the multi mapper)
   MapperParams mapper_params = get_mapper_params_from_gflags();
@@ -83,6 +95,23 @@ int Fuser::run() {
     LOG(FATAL) << "DataLoader was no set up sucessfully.";
   }
 
+  integrateFramesAndWriteOutputs();
+
+  LOG(INFO) << nvblox::timing::Timing::Print() << "\n";
+#ifdef NVBLOX_SYNC_MONITOR
+  LOG(INFO) << SyncMonitor::Print() << "\n";
+#endif
+  LOG(INFO) << nvblox::timing::Rates::Print() << "\n";
+
+  if (!timing_output_path_.empty()) {
+    LOG(INFO) << "Writing timings to file.";
+    outputTimingsToFile();
+  }
+
+  return 0;
+}
+
+void Fuser::integrateFramesAndWriteOutputs() {
   // Integrate all the data
   integrateFrames();
 
@@ -139,16 +168,30 @@ int Fuser::run() {
     LOG(INFO) << "Outputting the serialized map to " << map_output_path_;
     outputMapToFile();
   }
+}
 
-  LOG(INFO) << nvblox::timing::Timing::Print() << "\n";
-  LOG(INFO) << nvblox::timing::Rates::Print() << "\n";
-
-  if (!timing_output_path_.empty()) {
-    LOG(INFO) << "Writing timings to file.";
-    outputTimingsToFile();
-  }
-
-  return 0;
+void Fuser::appendOutputPathSuffix(const std::string& suffix) {
+  const auto append_suffix = [&suffix](std::string* path) {
+    if (path->empty()) {
+      return;
+    }
+    // Insert the suffix before the extension (if the file name has one).
+    const size_t file_name_start = path->find_last_of('/') + 1;
+    const size_t extension_start = path->find_last_of('.');
+    if (extension_start != std::string::npos &&
+        extension_start > file_name_start) {
+      path->insert(extension_start, suffix);
+    } else {
+      path->append(suffix);
+    }
+  };
+  append_suffix(&tsdf_output_path_);
+  append_suffix(&esdf_output_path_);
+  append_suffix(&occupancy_output_path_);
+  append_suffix(&freespace_output_path_);
+  append_suffix(&mesh_output_path_);
+  append_suffix(&map_output_path_);
+  append_suffix(&dynamic_overlay_path_);
 }
 
 void Fuser::integrateFrames() {
@@ -158,11 +201,16 @@ void Fuser::integrateFrames() {
              datasets::DataLoadResult::kNoMoreData) {
     timing::mark("Frame " + std::to_string(frame_number - 1), Color::Red());
     LOG(INFO) << "Integrating frame " << frame_number - 1;
+#ifdef NVBLOX_SYNC_MONITOR
+    SyncMonitor::endFrame();
+#endif
   }
   LOG(INFO) << "Ran out of data at frame: " << frame_number - 1;
 }
 
 datasets::DataLoadResult Fuser::integrateFrame(const int frame_number) {
+  const timing::ScopedFrameId scoped_frame_id(
+      timing::FrameId{"fuser", static_cast<uint64_t>(frame_number)});
   timing::Rates::tick("fuser/integrate_frame");
   timing::Timer timer_file("fuser/file_loading");
   const datasets::DataLoadResult load_result = data_loader_->loadNext(
@@ -311,4 +359,120 @@ std::shared_ptr<const SerializedMeshLayer> Fuser::getSerializedMesh() const {
   return multi_mapper_->background_mapper()->serializedMeshLayer();
 }
 
+int getNumConcurrentSequences(const BatchFuserParams& params,
+                              const int num_sequences,
+                              const size_t device_free_bytes) {
+  CHECK_GE(params.max_concurrent_sequences, 0);
+  CHECK_GT(params.device_memory_per_sequence_bytes, 0);
+  int num_concurrent = num_sequences;
+  if (params.max_concurrent_sequences > 0) {
+    num_concurrent = std::min(num_concurrent, params.max_concurrent_sequences);
+  }
+  const int num_fitting_device_memory = static_cast<int>(std::min<size_t>(
+      device_free_bytes / params.device_memory_per_sequence_bytes,
+      std::numeric_limits<int>::max()));
+  num_concurrent = std::min(num_concurrent, num_fitting_device_memory);
+  return std::max(num_concurrent, 1);
+}
+
+int runFuserBatch(const std::vector<std::string>& dataset_paths,
+                  const FuserFactory& fuser_factory,
+                  const BatchFuserParams& params) {
+  if (dataset_paths.empty()) {
+    LOG(ERROR) << "No dataset sequences given for batch reconstruction.";
+    return 1;
+  }
+  size_t device_free_bytes = 0;
+  size_t device_total_bytes = 0;
+  checkCudaErrors(cudaMemGetInfo(&device_free_bytes, &device_total_bytes));
+  const int num_concurrent = getNumConcurrentSequences(
+      params, static_cast<int>(dataset_paths.size()), device_free_bytes);
+  LOG(INFO) << "Reconstructing " << dataset_paths.size() << " sequences, "
+            << num_concurrent << " at once.";
+
+  // Each worker thread reconstructs sequences until none are left.
+  std::atomic<size_t> next_sequence_idx{0};
+  std::atomic<int> num_failed{0};
+  std::mutex timing_output_mutex;
+  std::string timing_output_path;
+  const auto worker = [&]() {
+    for (size_t sequence_idx = next_sequence_idx++;
+         sequence_idx < dataset_paths.size();
+         sequence_idx = next_sequence_idx++) {
+      const std::string& dataset_path = dataset_paths[sequence_idx];
+      LOG(INFO) << "Starting sequence " << sequence_idx << ": "
+                << dataset_path;
+      std::unique_ptr<Fuser> fuser = fuser_factory(dataset_path);
+      if (!fuser || !fuser->data_loader_ ||
+          !fuser->data_loader_->setup_success()) {
+        LOG(ERROR) << "Creation of the Fuser failed for " << dataset_path;
+        ++num_failed;
+        continue;
+      }
+      {
+        std::lock_guard<std::mutex> lock(timing_output_mutex);
+        timing_output_path = fuser->timing_output_path_;
+      }
+      fuser->appendOutputPathSuffix("_" + std::to_string(sequence_idx));
+      fuser->integrateFramesAndWriteOutputs();
+      LOG(INFO) << "Finished sequence " << sequence_idx << ": "
+                << dataset_path;
+    }
+  };
+  std::vector<std::thread> threads;
+  for (int i = 0; i < num_concurrent; ++i) {
+    threads.push_back(std::thread(worker));
+  }
+  std::for_each(threads.begin(), threads.end(),
+                [](std::thread& t) { t.join(); });
+
+  LOG(INFO) << nvblox::timing::Timing::Print() << "\n";
+  LOG(INFO) << nvblox::timing::Rates::Print() << "\n";
+  if (!timing_output_path.empty()) {
+    LOG(INFO) << "Writing timing to: " << timing_output_path;
+    std::ofstream timing_file(timing_output_path);
+    timing_file << nvblox::timing::Timing::Print();
+  }
+
+  if (num_failed > 0) {
+    LOG(ERROR) << num_failed << " of " << dataset_paths.size()
+               << " sequences failed.";
+    return 1;
+  }
+  return 0;
+}
+
+std::vector<std::string> getBatchDatasetPathsFromGflags() {
+  std::vector<std::string> dataset_paths;
+  std::stringstream paths_stream(FLAGS_batch_dataset_paths);
+  std::string path;
+  while (std::getline(paths_stream, path, ',')) {
+    if (!path.empty()) {
+      dataset_paths.push_back(path);
+    }
+  }
+  return dataset_paths;
+}
+
+BatchFuserParams getBatchFuserParamsFromGflags() {
+  BatchFuserParams params;
+  if (!gflags::GetCommandLineFlagInfoOrDie("batch_max_concurrent_sequences")
+           .is_default) {
+    LOG(INFO) << "Command line parameter found: "
+                 "batch_max_concurrent_sequences = "
+              << FLAGS_batch_max_concurrent_sequences;
+    params.max_concurrent_sequences = FLAGS_batch_max_concurrent_sequences;
+  }
+  if (!gflags::GetCommandLineFlagInfoOrDie(
+           "batch_device_memory_per_sequence_gb")
+           .is_default) {
+    LOG(INFO) << "Command line parameter found: "
+                 "batch_device_memory_per_sequence_gb = "
+              << FLAGS_batch_device_memory_per_sequence_gb;
+    params.device_memory_per_sequence_bytes = static_cast<size_t>(
+        FLAGS_batch_device_memory_per_sequence_gb * (size_t{1} << 30));
+  }
+  return params;
+}
+
 }  //  namespace nvblox
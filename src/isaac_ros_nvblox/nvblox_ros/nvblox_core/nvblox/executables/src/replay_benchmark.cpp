@@ -0,0 +1,235 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "nvblox/executables/replay_benchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <vector>
+
+#include "nvblox/core/internal/error_check.h"
+#include "nvblox/utils/timing.h"
+
+namespace nvblox {
+
+namespace {
+
+// The host timers of the fuser stages (see Fuser::integrateFrame()).
+const std::vector<std::string> kStageTags = {
+    "fuser/file_loading", "fuser/integrate_depth", "fuser/integrate_color",
+    "fuser/mesh",         "fuser/integrate_esdf",  "fuser/time_per_frame"};
+
+// Nearest-rank percentile of sorted samples.
+float percentile(const std::vector<float>& sorted_samples, float fraction) {
+  const size_t rank = static_cast<size_t>(
+      std::ceil(fraction * static_cast<float>(sorted_samples.size())));
+  return sorted_samples[std::clamp<size_t>(rank, 1, sorted_samples.size()) -
+                        1];
+}
+
+StageLatencyStats computeStats(std::vector<float> samples_ms) {
+  StageLatencyStats stats;
+  if (samples_ms.empty()) {
+    return stats;
+  }
+  std::sort(samples_ms.begin(), samples_ms.end());
+  double sum_ms = 0.0;
+  for (const float sample_ms : samples_ms) {
+    sum_ms += sample_ms;
+  }
+  stats.num_samples = static_cast<int>(samples_ms.size());
+  stats.mean_ms = static_cast<float>(sum_ms / samples_ms.size());
+  stats.p50_ms = percentile(samples_ms, 0.5f);
+  stats.p99_ms = percentile(samples_ms, 0.99f);
+  stats.max_ms = samples_ms.back();
+  return stats;
+}
+
+size_t getMapDeviceBytes(const Mapper& mapper) {
+  const MapperMemoryUsage usage = mapper.memoryUsage();
+  size_t bytes = usage.scratch_arena.allocated_bytes;
+  for (const auto& [name, layer_usage] : usage.layers) {
+    if (layer_usage.memory_type == MemoryType::kDevice) {
+      bytes += layer_usage.blocks.allocated_bytes;
+    }
+    bytes += layer_usage.gpu_hash.allocated_bytes;
+  }
+  return bytes;
+}
+
+size_t getDeviceUsedBytes() {
+  size_t free_bytes = 0;
+  size_t total_bytes = 0;
+  checkCudaErrors(cudaMemGetInfo(&free_bytes, &total_bytes));
+  return total_bytes - free_bytes;
+}
+
+// The time spent in the timers of the stages so far.
+std::vector<std::pair<double, size_t>> getStageTotals() {
+  std::vector<std::pair<double, size_t>> totals;
+  totals.reserve(kStageTags.size());
+  for (const std::string& tag : kStageTags) {
+    totals.emplace_back(timing::Timing::GetTotalSeconds(tag),
+                        timing::Timing::GetNumSamples(tag));
+  }
+  return totals;
+}
+
+template <typename StatsType>
+void writeStatsJson(const StatsType& stats, std::ostream& out) {
+  out << "{\"num_samples\": " << stats.num_samples
+      << ", \"mean_ms\": " << stats.mean_ms
+      << ", \"p50_ms\": " << stats.p50_ms
+      << ", \"p99_ms\": " << stats.p99_ms
+      << ", \"max_ms\": " << stats.max_ms << "}";
+}
+
+constexpr double kBytesToMiB = 1.0 / (1024.0 * 1024.0);
+
+}  // namespace
+
+ReplayBenchmarkResult runReplayBenchmark(int num_warmup_frames, Fuser* fuser) {
+  CHECK_NOTNULL(fuser);
+  CHECK_GE(num_warmup_frames, 0);
+  CHECK(fuser->data_loader_->setup_success())
+      << "DataLoader was not set up successfully.";
+
+  int frame_number = 0;
+  for (; frame_number < num_warmup_frames; ++frame_number) {
+    if (fuser->integrateFrame(frame_number) ==
+        datasets::DataLoadResult::kNoMoreData) {
+      LOG(WARNING) << "Ran out of data during warmup.";
+      return ReplayBenchmarkResult();
+    }
+  }
+  timing::GpuTiming::ResolveAll();
+  timing::GpuTiming::Reset();
+
+  ReplayBenchmarkResult result;
+  std::vector<std::vector<float>> stage_samples_ms(kStageTags.size());
+  std::vector<std::pair<double, size_t>> previous_totals = getStageTotals();
+  double loading_time_s = 0.0;
+  const auto start_time = std::chrono::steady_clock::now();
+  while (result.num_frames < fuser->num_frames_to_integrate_) {
+    const datasets::DataLoadResult load_result =
+        fuser->integrateFrame(frame_number++);
+    if (load_result == datasets::DataLoadResult::kNoMoreData) {
+      break;
+    }
+    const std::vector<std::pair<double, size_t>> totals = getStageTotals();
+    for (size_t i = 0; i < kStageTags.size(); ++i) {
+      // Only count the stages which ran in this frame.
+      if (totals[i].second > previous_totals[i].second) {
+        stage_samples_ms[i].push_back(static_cast<float>(
+            (totals[i].first - previous_totals[i].first) * 1000.0));
+      }
+    }
+    loading_time_s += totals[0].first - previous_totals[0].first;
+    previous_totals = totals;
+    if (load_result == datasets::DataLoadResult::kBadFrame) {
+      continue;
+    }
+
+    ++result.num_frames;
+    result.peak_device_used_bytes =
+        std::max(result.peak_device_used_bytes, getDeviceUsedBytes());
+    const size_t map_device_bytes =
+        getMapDeviceBytes(*fuser->multi_mapper()->background_mapper()) +
+        getMapDeviceBytes(*fuser->multi_mapper()->foreground_mapper());
+    result.peak_map_device_bytes =
+        std::max(result.peak_map_device_bytes, map_device_bytes);
+  }
+  result.total_time_s = std::chrono::duration<double>(
+                            std::chrono::steady_clock::now() - start_time)
+                            .count();
+
+  if (result.total_time_s > 0.0) {
+    result.frames_per_second = result.num_frames / result.total_time_s;
+  }
+  if (result.total_time_s > loading_time_s) {
+    result.frames_per_second_excluding_loading =
+        result.num_frames / (result.total_time_s - loading_time_s);
+  }
+  for (size_t i = 0; i < kStageTags.size(); ++i) {
+    if (!stage_samples_ms[i].empty()) {
+      result.stages[kStageTags[i]] = computeStats(stage_samples_ms[i]);
+    }
+  }
+  timing::GpuTiming::ResolveAll();
+  result.gpu_stages = timing::GpuTiming::GetAllStats();
+  return result;
+}
+
+void ReplayBenchmarkResult::writeJson(std::ostream& out) const {
+  out << std::fixed << std::setprecision(4);
+  out << "{\n";
+  out << "  \"num_frames\": " << num_frames << ",\n";
+  out << "  \"total_time_s\": " << total_time_s << ",\n";
+  out << "  \"frames_per_second\": " << frames_per_second << ",\n";
+  out << "  \"frames_per_second_excluding_loading\": "
+      << frames_per_second_excluding_loading << ",\n";
+  out << "  \"peak_device_used_mb\": " << peak_device_used_bytes * kBytesToMiB
+      << ",\n";
+  out << "  \"peak_map_device_mb\": " << peak_map_device_bytes * kBytesToMiB
+      << ",\n";
+  out << "  \"stages\": {";
+  bool first = true;
+  for (const auto& [tag, stats] : stages) {
+    out << (first ? "\n" : ",\n") << "    \"" << tag << "\": ";
+    writeStatsJson(stats, out);
+    first = false;
+  }
+  out << "\n  },\n";
+  out << "  \"gpu_stages\": {";
+  first = true;
+  for (const auto& [tag, stats] : gpu_stages) {
+    out << (first ? "\n" : ",\n") << "    \"" << tag << "\": ";
+    writeStatsJson(stats, out);
+    first = false;
+  }
+  out << "\n  }\n";
+  out << "}\n";
+}
+
+void ReplayBenchmarkResult::print(std::ostream& out) const {
+  out << std::fixed << std::setprecision(2);
+  out << "\nNVBlox Replay Benchmark\n";
+  out << "-----------\n";
+  out << "Frames: " << num_frames << " in " << total_time_s << " s\n";
+  out << "Throughput: " << frames_per_second << " frames/s ("
+      << frames_per_second_excluding_loading
+      << " frames/s excluding data loading)\n";
+  out << "Peak device memory used: " << peak_device_used_bytes * kBytesToMiB
+      << " MiB (maps: " << peak_map_device_bytes * kBytesToMiB << " MiB)\n";
+  out << "-----------\n";
+  out << "stage - NumSamples - Mean - P50 - P99 - Max (ms)\n";
+  for (const auto& [tag, stats] : stages) {
+    out << tag << "\t" << stats.num_samples << "\t" << stats.mean_ms << "\t"
+        << stats.p50_ms << "\t" << stats.p99_ms << "\t" << stats.max_ms
+        << "\n";
+  }
+  out << "-----------\n";
+  out << "GPU stage - NumSamples - Mean - P50 - P99 - Max (ms)\n";
+  for (const auto& [tag, stats] : gpu_stages) {
+    out << tag << "\t" << stats.num_samples << "\t" << stats.mean_ms << "\t"
+        << stats.p50_ms << "\t" << stats.p99_ms << "\t" << stats.max_ms
+        << "\n";
+  }
+  out << "-----------\n";
+}
+
+}  // namespace nvblox
@@ -0,0 +1,85 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include <gflags/gflags.h>
+#include "nvblox/utils/logging.h"
+
+#include "nvblox/core/internal/warmup_cuda.h"
+#include "nvblox/datasets/3dmatch.h"
+#include "nvblox/datasets/redwood.h"
+#include "nvblox/datasets/replica.h"
+#include "nvblox/executables/fuser.h"
+#include "nvblox/executables/replay_benchmark.h"
+
+DEFINE_int32(num_warmup_frames, 10,
+             "Number of frames integrated before measuring.");
+DEFINE_int32(threedmatch_seq_id, 1, "The 3DMatch sequence to replay.");
+
+using namespace nvblox;
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  FLAGS_alsologtostderr = true;
+  google::InstallFailureSignalHandler();
+
+  if (argc < 3) {
+    LOG(ERROR) << "Usage: replay_benchmark <3dmatch|replica|redwood> "
+                  "<dataset_path> [json_output_path]";
+    return 1;
+  }
+  const std::string dataset = argv[1];
+  const std::string base_path = argv[2];
+  LOG(INFO) << "Replaying " << dataset << " files from " << base_path;
+
+  warmupCuda();
+
+  // Fuser
+  std::unique_ptr<Fuser> fuser;
+  if (dataset == "3dmatch") {
+    fuser =
+        datasets::threedmatch::createFuser(base_path, FLAGS_threedmatch_seq_id);
+  } else if (dataset == "replica") {
+    fuser = datasets::replica::createFuser(base_path);
+  } else if (dataset == "redwood") {
+    fuser = datasets::redwood::createFuser(base_path);
+  } else {
+    LOG(ERROR) << "Unknown dataset: " << dataset;
+    return 1;
+  }
+  if (!fuser) {
+    LOG(FATAL) << "Creation of the Fuser failed";
+  }
+
+  const ReplayBenchmarkResult result =
+      runReplayBenchmark(FLAGS_num_warmup_frames, fuser.get());
+  result.print(std::cout);
+
+  // JSON output (optional)
+  if (argc >= 4) {
+    std::ofstream json_file(argv[3]);
+    if (!json_file) {
+      LOG(ERROR) << "Could not open " << argv[3] << " for writing.";
+      return 1;
+    }
+    result.writeJson(json_file);
+    LOG(INFO) << "Wrote results to " << argv[3];
+  }
+  return 0;
+}
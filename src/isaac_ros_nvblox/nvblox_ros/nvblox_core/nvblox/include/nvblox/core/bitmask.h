@@ -14,6 +14,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #pragma once
+#include <cuda_runtime.h>
 #include <cstdint>
 
 // Base class for wrapping an enum type into a bitmask.
@@ -60,4 +61,44 @@ class BitMask {
   MaskType bitmask_ = 0;
 };
 
+// A bitmask with a fixed (compile-time) number of bits, usable on host and
+// device. In contrast to BitMask above, bits are addressed by index.
+// @tparam kNumBits: The number of bits in the mask.
+template <int kNumBits>
+class FixedSizeBitMask {
+ public:
+  using WordType = uint32_t;
+  static constexpr int kBitsPerWord = 8 * sizeof(WordType);
+  static constexpr int kNumWords = (kNumBits + kBitsPerWord - 1) / kBitsPerWord;
+
+  FixedSizeBitMask() = default;
+
+  /// Set a single bit
+  __host__ __device__ void set(int bit);
+
+  /// Set a single bit atomically. Used by concurrent threads on the GPU.
+  __device__ void setAtomic(int bit);
+
+  /// Set all bits
+  __host__ __device__ void setAll();
+
+  /// Unset all bits
+  __host__ __device__ void clear();
+
+  /// Test if a given bit is set
+  __host__ __device__ bool isSet(int bit) const;
+
+  /// Whether any bit is set
+  __host__ __device__ bool any() const;
+
+  // Logical OR between this and rhs.
+  __host__ __device__ FixedSizeBitMask& operator|=(const FixedSizeBitMask& rhs);
+
+  // Equality check
+  __host__ __device__ bool operator==(const FixedSizeBitMask& other) const;
+
+ private:
+  WordType words_[kNumWords] = {};
+};
+
 #include "nvblox/core/internal/impl/bitmask_impl.h"
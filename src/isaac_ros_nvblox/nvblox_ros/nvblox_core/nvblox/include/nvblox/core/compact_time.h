@@ -0,0 +1,148 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#pragma once
+
+#include <cuda_runtime.h>
+#include <stdint.h>
+#include <ostream>
+
+#include "nvblox/core/time.h"
+
+namespace nvblox {
+
+/// A 32-bit timestamp in ms, which stores the lower bits of a Time.
+///
+/// The timestamp is relative to an epoch which implicitly moves on every
+/// 2^32 ms (~49 days), such that it never needs to be rebased. It can
+/// therefore only be compared to the current time, by the (modular) time
+/// elapsed since it, which is exact for timestamps less than 2^32 ms old.
+///
+/// The epoch itself, Time(0), is reserved: It is the only time mapping to a
+/// raw value of zero. Other times with zero lower bits are shifted by 1 ms.
+class CompactTimestamp {
+ public:
+  CompactTimestamp() = default;
+  __host__ __device__ CompactTimestamp(Time time) : value_(fromTime(time)) {}
+
+  __host__ __device__ CompactTimestamp& operator=(Time time) {
+    value_ = fromTime(time);
+    return *this;
+  }
+
+  /// The time elapsed since this timestamp.
+  /// @param current_time The current time, not before the timestamp.
+  /// @return The elapsed time.
+  __host__ __device__ Time elapsedSince(Time current_time) const {
+    return Time(static_cast<uint32_t>(fromTime(current_time) - value_));
+  }
+
+  __host__ __device__ bool operator==(const CompactTimestamp& other) const {
+    return value_ == other.value_;
+  }
+  __host__ __device__ bool operator!=(const CompactTimestamp& other) const {
+    return value_ != other.value_;
+  }
+  __host__ __device__ bool operator==(Time time) const {
+    return value_ == fromTime(time);
+  }
+  __host__ __device__ bool operator!=(Time time) const {
+    return value_ != fromTime(time);
+  }
+
+  /// The underlying 32-bit value.
+  __host__ __device__ uint32_t raw() const { return value_; }
+
+ private:
+  __host__ __device__ static uint32_t fromTime(Time time) {
+    const uint32_t value = static_cast<uint32_t>(static_cast<int64_t>(time));
+    return (value == 0 && time != Time(0)) ? 1 : value;
+  }
+
+  uint32_t value_;
+};
+
+/// A 16-bit duration in ms, which behaves like a Time.
+///
+/// Durations saturate at kMaxValue rather than overflowing, which keeps
+/// comparisons against thresholds up to kMaxValue exact.
+class CompactDuration {
+ public:
+  /// The longest duration representable.
+  static constexpr int64_t kMaxValue = UINT16_MAX;
+
+  CompactDuration() = default;
+  __host__ __device__ CompactDuration(Time duration)
+      : value_(fromTime(duration)) {}
+
+  __host__ __device__ operator Time() const { return Time(value_); }
+
+  __host__ __device__ CompactDuration& operator=(Time duration) {
+    value_ = fromTime(duration);
+    return *this;
+  }
+  __host__ __device__ CompactDuration& operator+=(Time duration) {
+    return *this = Time(value_) + duration;
+  }
+
+  __host__ __device__ bool operator==(const CompactDuration& other) const {
+    return value_ == other.value_;
+  }
+  __host__ __device__ bool operator!=(const CompactDuration& other) const {
+    return value_ != other.value_;
+  }
+  __host__ __device__ bool operator<(Time duration) const {
+    return Time(value_) < duration;
+  }
+  __host__ __device__ bool operator>(Time duration) const {
+    return Time(value_) > duration;
+  }
+  __host__ __device__ bool operator<=(Time duration) const {
+    return Time(value_) <= duration;
+  }
+  __host__ __device__ bool operator>=(Time duration) const {
+    return Time(value_) >= duration;
+  }
+
+ private:
+  __host__ __device__ static uint16_t fromTime(Time duration) {
+    const int64_t value = static_cast<int64_t>(duration);
+    if (value < 0) {
+      return 0;
+    }
+    return static_cast<uint16_t>(value > kMaxValue ? kMaxValue : value);
+  }
+
+  uint16_t value_;
+};
+
+static_assert(sizeof(CompactTimestamp) == 4,
+              "CompactTimestamp must be 32 bits.");
+static_assert(sizeof(CompactDuration) == 2,
+              "CompactDuration must be 16 bits.");
+
+__host__ inline std::ostream& operator<<(std::ostream& os,
+                                         const CompactTimestamp& timestamp) {
+  os << timestamp.raw();
+  return os;
+}
+
+__host__ inline std::ostream& operator<<(std::ostream& os,
+                                         const CompactDuration& duration) {
+  os << static_cast<Time>(duration);
+  return os;
+}
+
+}  // namespace nvblox
@@ -0,0 +1,54 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#pragma once
+
+namespace nvblox {
+
+/// @brief The number of CUDA devices on this machine.
+int getNumCudaDevices();
+
+/// @brief The CUDA device of the calling thread.
+int getCurrentCudaDevice();
+
+/// @brief The device owning a pointer to device memory.
+/// @param ptr The pointer.
+/// @return The device, or -1 for host and managed (unified) memory.
+int getCudaDeviceOfPointer(const void* ptr);
+
+/// @brief Allows kernels running on a device to access the memory of another
+/// device directly, and copies between the two to go peer-to-peer rather than
+/// through the host. Enabling access which is already enabled is fine.
+/// @param device The device which accesses the memory.
+/// @param peer_device The device owning the memory.
+/// @return False if the devices don't support peer access.
+bool enablePeerAccess(int device, int peer_device);
+
+/// @brief RAII guard setting the CUDA device of the calling thread for its
+/// lifetime, and restoring the previous device afterwards. Note that the
+/// device is a per-thread setting: threads start out on device 0.
+class ScopedCudaDevice {
+ public:
+  explicit ScopedCudaDevice(int device);
+  ~ScopedCudaDevice();
+
+  ScopedCudaDevice(const ScopedCudaDevice& other) = delete;
+  ScopedCudaDevice& operator=(const ScopedCudaDevice& other) = delete;
+
+ private:
+  int previous_device_;
+};
+
+}  // namespace nvblox
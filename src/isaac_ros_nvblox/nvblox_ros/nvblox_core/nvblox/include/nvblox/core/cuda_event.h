@@ -0,0 +1,64 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#pragma once
+
+#include "cuda_runtime.h"
+#include "nvblox/core/cuda_stream.h"
+
+namespace nvblox {
+
+/// @brief A simple RAII holder for a cuda event.
+/// Events mark a point in a stream. They can be used to wait for work on a
+/// stream up to that point, without waiting for work issued afterwards, or to
+/// order work between streams.
+class CudaEvent {
+ public:
+  /// Creates the event (with timing disabled) on construction and destroys it
+  /// on destruction.
+  CudaEvent();
+  ~CudaEvent();
+
+  // Events are owning and therefore not copyable.
+  CudaEvent(const CudaEvent& other) = delete;
+  CudaEvent(CudaEvent&& other) = delete;
+  CudaEvent& operator=(const CudaEvent& other) = delete;
+  CudaEvent& operator=(CudaEvent&& other) = delete;
+
+  /// Record the event at the current end of a stream.
+  /// @param cuda_stream The stream to record on.
+  void record(const CudaStream& cuda_stream);
+
+  /// Block the host until the work preceding the last record() is done.
+  void synchronize() const;
+
+  /// Check (without blocking) if the work preceding the last record() is done.
+  /// @return True if the work is done (or the event was never recorded).
+  bool isReady() const;
+
+  /// Make future work on a stream wait for the work preceding the last
+  /// record(). Does not block the host.
+  /// @param cuda_stream The stream which should wait.
+  void streamWait(const CudaStream& cuda_stream) const;
+
+  /// Returns the underlying CUDA event
+  /// @return The raw CUDA event
+  cudaEvent_t get() const { return event_; }
+
+ protected:
+  cudaEvent_t event_;
+};
+
+}  // namespace nvblox
@@ -0,0 +1,66 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#pragma once
+
+#include "cuda_runtime.h"
+#include "nvblox/core/cuda_stream.h"
+
+namespace nvblox {
+
+/// @brief A simple RAII holder for a captured and instantiated cuda graph.
+/// Work issued on a stream between beginCapture() and endCapture() is
+/// recorded rather than executed. The recorded work can then be replayed with
+/// a single launch(), which avoids the per-kernel launch overhead. A replay
+/// uses the exact same arguments (including pointers) as during capture, so
+/// the graph has to be re-captured if any of those change.
+class CudaGraph {
+ public:
+  CudaGraph() = default;
+  ~CudaGraph();
+
+  // Graphs are owning and therefore not copyable.
+  CudaGraph(const CudaGraph& other) = delete;
+  CudaGraph(CudaGraph&& other) = delete;
+  CudaGraph& operator=(const CudaGraph& other) = delete;
+  CudaGraph& operator=(CudaGraph&& other) = delete;
+
+  /// Start recording the work issued on a stream. Any previously captured
+  /// graph is discarded.
+  /// @param cuda_stream The stream to capture. Must not be the legacy default
+  /// stream.
+  void beginCapture(const CudaStream& cuda_stream);
+
+  /// Stop recording and instantiate the captured graph.
+  /// NOTE: The captured work is *not* executed. Call launch() to execute it.
+  /// @param cuda_stream The stream passed to beginCapture().
+  void endCapture(const CudaStream& cuda_stream);
+
+  /// Execute the captured work on a stream.
+  /// @param cuda_stream The stream to launch on.
+  void launch(const CudaStream& cuda_stream) const;
+
+  /// Whether a graph has been captured and is ready to launch.
+  /// @return True if launch() can be called.
+  bool isInstantiated() const { return graph_exec_ != nullptr; }
+
+ protected:
+  void reset();
+
+  cudaGraph_t graph_ = nullptr;
+  cudaGraphExec_t graph_exec_ = nullptr;
+};
+
+}  // namespace nvblox
@@ -58,6 +58,38 @@ inline std::string toString(const CudaStreamType& cuda_stream_type) {
   }
 }
 
+/// Declare enum class for the scheduling priority of a cuda stream. Work
+/// pending on a higher priority stream is scheduled before work pending on a
+/// lower priority stream, e.g. such that latency-critical kernels overtake
+/// background work (like meshing) which was queued earlier.
+enum class CudaStreamPriority {
+  // The priority of streams created without a priority.
+  kDefault,
+  // The greatest priority supported by the device.
+  kHigh,
+  // The least priority supported by the device.
+  kLow,
+};
+
+template <>
+inline std::string toString(const CudaStreamPriority& cuda_stream_priority) {
+  switch (cuda_stream_priority) {
+    case CudaStreamPriority::kDefault:
+      return "kDefault";
+      break;
+    case CudaStreamPriority::kHigh:
+      return "kHigh";
+      break;
+    case CudaStreamPriority::kLow:
+      return "kLow";
+      break;
+    default:
+      LOG(FATAL) << "Not implemented";
+      return "";
+      break;
+  }
+}
+
 /// A thin interface to a CudaStream, it is pure virtual and should not be
 /// instantiated.
 class CudaStream {
@@ -76,9 +108,10 @@ class CudaStream {
   virtual void synchronize() const = 0;
 
   // Helper function to create CudaStreamOwning based on various CudaStreamType
-  // options.
+  // options. The priority only applies to the async (owning) stream types.
   static std::shared_ptr<CudaStream> createCudaStream(
-      CudaStreamType stream_type);
+      CudaStreamType stream_type,
+      CudaStreamPriority priority = CudaStreamPriority::kDefault);
 
  protected:
   // Creating a CudaStream instance should never be performed outside of derived
@@ -156,7 +189,10 @@ class CudaStreamOwning : public CudaStreamAsync {
   /// destruction.
   ///
   /// @param flags  Stream creation flags from cuda_runtime.h
-  CudaStreamOwning(const unsigned int flags = cudaStreamDefault);
+  /// @param priority  The scheduling priority of the stream.
+  CudaStreamOwning(
+      const unsigned int flags = cudaStreamDefault,
+      const CudaStreamPriority priority = CudaStreamPriority::kDefault);
 
   virtual ~CudaStreamOwning();
 
@@ -0,0 +1,129 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "nvblox/core/types.h"
+
+namespace nvblox {
+
+/// A host hash map from Index3D to ValueType with open addressing.
+///
+/// The entries are stored contiguously, such that iteration is a linear scan,
+/// and are found through a table of slots, probed linearly. Each slot holds
+/// the position of its entry and a fingerprint of the entry's hash, such that
+/// most mismatching slots are skipped without touching the entry. Erasing
+/// moves the last entry into the erased position and shifts back the
+/// following slots, so there are no tombstones.
+///
+/// The interface is the subset of std::unordered_map used for the block
+/// hashes of layers. In contrast to std::unordered_map, inserting and erasing
+/// invalidate all iterators and references, and erase(iterator) returns an
+/// iterator to the entry moved into the erased position.
+template <typename ValueType>
+class Index3DFlatHashMap {
+ public:
+  typedef Index3D key_type;
+  typedef ValueType mapped_type;
+  typedef std::pair<Index3D, ValueType> value_type;
+  typedef typename std::vector<value_type>::iterator iterator;
+  typedef typename std::vector<value_type>::const_iterator const_iterator;
+
+  Index3DFlatHashMap() = default;
+  ~Index3DFlatHashMap() = default;
+
+  iterator begin() { return entries_.begin(); }
+  iterator end() { return entries_.end(); }
+  const_iterator begin() const { return entries_.begin(); }
+  const_iterator end() const { return entries_.end(); }
+
+  size_t size() const { return entries_.size(); }
+  bool empty() const { return entries_.empty(); }
+
+  /// Removes all entries. Keeps the memory.
+  void clear();
+
+  /// Makes room for num_entries entries without rehashing.
+  /// @param num_entries The number of entries.
+  void reserve(size_t num_entries);
+
+  /// Returns the entry of an index, or end() if there is none.
+  /// @param index The index to look up.
+  iterator find(const Index3D& index);
+  const_iterator find(const Index3D& index) const;
+
+  /// Returns the number of entries of an index (zero or one).
+  /// @param index The index to look up.
+  size_t count(const Index3D& index) const;
+
+  /// Inserts an entry if there is none for the index.
+  /// @param index The index of the entry.
+  /// @param value The value of the entry.
+  /// @return The entry of the index and whether it was inserted.
+  std::pair<iterator, bool> emplace(const Index3D& index, ValueType value);
+
+  /// Returns the value of an index, inserting a default value if needed.
+  /// @param index The index of the entry.
+  ValueType& operator[](const Index3D& index);
+
+  /// Erases an entry.
+  /// @param it The entry to erase. Must not be end().
+  /// @return The entry which took the place of the erased entry.
+  iterator erase(const_iterator it);
+
+  /// Erases the entry of an index, if any.
+  /// @param index The index of the entry.
+  /// @return The number of erased entries (zero or one).
+  size_t erase(const Index3D& index);
+
+ private:
+  static constexpr int32_t kEmptySlot = -1;
+  static constexpr size_t kMinNumSlots = 16;
+
+  struct Slot {
+    // The lower bits of the hash of the entry's index.
+    uint32_t fingerprint = 0;
+    // The position of the entry, or kEmptySlot.
+    int32_t entry_idx = kEmptySlot;
+  };
+
+  // Packs the index into 64 bits (21 bits per axis), and mixes the bits.
+  static uint64_t hash(const Index3D& index);
+
+  // Returns the slot holding the index, or the empty slot ending the probe.
+  size_t findSlot(const Index3D& index, uint32_t fingerprint) const;
+
+  // Returns the slot pointing at an entry, which must exist.
+  size_t findSlotOfEntry(int32_t entry_idx) const;
+
+  // Rebuilds the slot table with num_slots (a power of two) slots.
+  void rehash(size_t num_slots);
+
+  // Grows the slot table if inserting an entry would exceed the max. load.
+  void growIfNeeded();
+
+  size_t mask() const { return slots_.size() - 1; }
+
+  std::vector<value_type> entries_;
+  std::vector<Slot> slots_;
+};
+
+}  // namespace nvblox
+
+#include "nvblox/core/internal/impl/flat_hash_map_impl.h"
@@ -0,0 +1,66 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#pragma once
+
+#include <cuda_fp16.h>
+#include <cuda_runtime.h>
+
+namespace nvblox {
+
+/// A 16-bit floating point scalar which behaves like a float.
+///
+/// Values are converted to and from float on every access, so that code
+/// written against float members (e.g. voxel->distance += x) compiles
+/// unchanged. Conversion from float saturates at the largest finite half
+/// value rather than overflowing to infinity.
+class HalfFloat {
+ public:
+  /// The largest finite value representable.
+  static constexpr float kMaxValue = 65504.0f;
+
+  HalfFloat() = default;
+  __host__ __device__ HalfFloat(float value) : value_(fromFloat(value)) {}
+
+  __host__ __device__ operator float() const { return __half2float(value_); }
+
+  __host__ __device__ HalfFloat& operator=(float value) {
+    value_ = fromFloat(value);
+    return *this;
+  }
+  __host__ __device__ HalfFloat& operator+=(float value) {
+    return *this = static_cast<float>(*this) + value;
+  }
+  __host__ __device__ HalfFloat& operator-=(float value) {
+    return *this = static_cast<float>(*this) - value;
+  }
+  __host__ __device__ HalfFloat& operator*=(float value) {
+    return *this = static_cast<float>(*this) * value;
+  }
+  __host__ __device__ HalfFloat& operator/=(float value) {
+    return *this = static_cast<float>(*this) / value;
+  }
+
+ private:
+  __host__ __device__ static __half fromFloat(float value) {
+    return __float2half(fminf(fmaxf(value, -kMaxValue), kMaxValue));
+  }
+
+  __half value_;
+};
+
+static_assert(sizeof(HalfFloat) == 2, "HalfFloat must be 16 bits.");
+
+}  // namespace nvblox
@@ -63,6 +63,13 @@ getCenter2DPositionFromBlockIndexAndVoxelIndex(const float block_size_m,
 __host__ __device__ inline std::pair<int, int>
 getBlockAndVoxelIndexFrom1DPositionInLayer(const float block_size_m, float p);
 
+/// Gets the Morton (Z-order) code of a block index by interleaving the bits of
+/// its coordinates. Sorting blocks by their code keeps blocks which are close
+/// in space mostly close in the resulting order. Each coordinate contributes
+/// 21 bits, which covers indices in [-2^20, 2^20).
+__host__ __device__ inline uint64_t getMortonCodeFromBlockIndex(
+    const Index3D& block_index);
+
 }  // namespace nvblox
 
 #include "nvblox/core/internal/impl/indexing_impl.h"
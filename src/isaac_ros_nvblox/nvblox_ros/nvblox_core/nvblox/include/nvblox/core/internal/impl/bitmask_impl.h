@@ -71,3 +71,70 @@ template <typename EnumType>
 typename BitMask<EnumType>::MaskType BitMask<EnumType>::get() const {
   return bitmask_;
 }
+
+template <int kNumBits>
+__host__ __device__ void FixedSizeBitMask<kNumBits>::set(int bit) {
+  words_[bit / kBitsPerWord] |= (WordType(1) << (bit % kBitsPerWord));
+}
+
+#ifdef __CUDACC__
+template <int kNumBits>
+__device__ void FixedSizeBitMask<kNumBits>::setAtomic(int bit) {
+  atomicOr(&words_[bit / kBitsPerWord], WordType(1) << (bit % kBitsPerWord));
+}
+#endif
+
+template <int kNumBits>
+__host__ __device__ void FixedSizeBitMask<kNumBits>::setAll() {
+  for (int i = 0; i < kNumWords; i++) {
+    words_[i] = ~WordType(0);
+  }
+  // Keep the unused bits of the last word unset, such that operator==()
+  // behaves.
+  constexpr int kNumBitsInLastWord = kNumBits % kBitsPerWord;
+  if (kNumBitsInLastWord != 0) {
+    words_[kNumWords - 1] = (WordType(1) << kNumBitsInLastWord) - 1;
+  }
+}
+
+template <int kNumBits>
+__host__ __device__ void FixedSizeBitMask<kNumBits>::clear() {
+  for (int i = 0; i < kNumWords; i++) {
+    words_[i] = 0;
+  }
+}
+
+template <int kNumBits>
+__host__ __device__ bool FixedSizeBitMask<kNumBits>::isSet(int bit) const {
+  return words_[bit / kBitsPerWord] & (WordType(1) << (bit % kBitsPerWord));
+}
+
+template <int kNumBits>
+__host__ __device__ bool FixedSizeBitMask<kNumBits>::any() const {
+  for (int i = 0; i < kNumWords; i++) {
+    if (words_[i] != 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+template <int kNumBits>
+__host__ __device__ FixedSizeBitMask<kNumBits>&
+FixedSizeBitMask<kNumBits>::operator|=(const FixedSizeBitMask& rhs) {
+  for (int i = 0; i < kNumWords; i++) {
+    words_[i] |= rhs.words_[i];
+  }
+  return *this;
+}
+
+template <int kNumBits>
+__host__ __device__ bool FixedSizeBitMask<kNumBits>::operator==(
+    const FixedSizeBitMask& other) const {
+  for (int i = 0; i < kNumWords; i++) {
+    if (words_[i] != other.words_[i]) {
+      return false;
+    }
+  }
+  return true;
+}
@@ -0,0 +1,199 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#pragma once
+
+#include <glog/logging.h>
+
+#include <algorithm>
+
+namespace nvblox {
+
+template <typename ValueType>
+uint64_t Index3DFlatHashMap<ValueType>::hash(const Index3D& index) {
+  // The packing wraps for indices beyond +-2^20, which only costs collisions
+  // because entries are compared on the full index.
+  constexpr uint64_t kAxisMask = (1ULL << 21) - 1;
+  uint64_t h = (static_cast<uint64_t>(index.x()) & kAxisMask) |
+               ((static_cast<uint64_t>(index.y()) & kAxisMask) << 21) |
+               ((static_cast<uint64_t>(index.z()) & kAxisMask) << 42);
+  // The splitmix64 finalizer, such that neighbouring blocks spread over the
+  // table rather than forming long probe sequences.
+  h ^= h >> 30;
+  h *= 0xbf58476d1ce4e5b9ULL;
+  h ^= h >> 27;
+  h *= 0x94d049bb133111ebULL;
+  h ^= h >> 31;
+  return h;
+}
+
+template <typename ValueType>
+size_t Index3DFlatHashMap<ValueType>::findSlot(const Index3D& index,
+                                               uint32_t fingerprint) const {
+  size_t slot_idx = fingerprint & mask();
+  while (true) {
+    const Slot& slot = slots_[slot_idx];
+    if (slot.entry_idx == kEmptySlot ||
+        (slot.fingerprint == fingerprint &&
+         entries_[slot.entry_idx].first == index)) {
+      return slot_idx;
+    }
+    slot_idx = (slot_idx + 1) & mask();
+  }
+}
+
+template <typename ValueType>
+size_t Index3DFlatHashMap<ValueType>::findSlotOfEntry(int32_t entry_idx) const {
+  size_t slot_idx =
+      static_cast<uint32_t>(hash(entries_[entry_idx].first)) & mask();
+  while (slots_[slot_idx].entry_idx != entry_idx) {
+    DCHECK_NE(slots_[slot_idx].entry_idx, kEmptySlot);
+    slot_idx = (slot_idx + 1) & mask();
+  }
+  return slot_idx;
+}
+
+template <typename ValueType>
+void Index3DFlatHashMap<ValueType>::rehash(size_t num_slots) {
+  slots_.assign(num_slots, Slot());
+  for (size_t entry_idx = 0; entry_idx < entries_.size(); entry_idx++) {
+    const uint32_t fingerprint =
+        static_cast<uint32_t>(hash(entries_[entry_idx].first));
+    size_t slot_idx = fingerprint & mask();
+    while (slots_[slot_idx].entry_idx != kEmptySlot) {
+      slot_idx = (slot_idx + 1) & mask();
+    }
+    slots_[slot_idx] = Slot{fingerprint, static_cast<int32_t>(entry_idx)};
+  }
+}
+
+template <typename ValueType>
+void Index3DFlatHashMap<ValueType>::growIfNeeded() {
+  // Linear probing degrades quickly above a load factor of 3/4.
+  if (4 * (entries_.size() + 1) > 3 * slots_.size()) {
+    rehash(std::max(kMinNumSlots, 2 * slots_.size()));
+  }
+}
+
+template <typename ValueType>
+void Index3DFlatHashMap<ValueType>::clear() {
+  entries_.clear();
+  std::fill(slots_.begin(), slots_.end(), Slot());
+}
+
+template <typename ValueType>
+void Index3DFlatHashMap<ValueType>::reserve(size_t num_entries) {
+  size_t num_slots = kMinNumSlots;
+  while (3 * num_slots < 4 * num_entries) {
+    num_slots *= 2;
+  }
+  if (num_slots > slots_.size()) {
+    rehash(num_slots);
+  }
+  entries_.reserve(num_entries);
+}
+
+template <typename ValueType>
+typename Index3DFlatHashMap<ValueType>::iterator
+Index3DFlatHashMap<ValueType>::find(const Index3D& index) {
+  if (entries_.empty()) {
+    return entries_.end();
+  }
+  const Slot& slot =
+      slots_[findSlot(index, static_cast<uint32_t>(hash(index)))];
+  return slot.entry_idx == kEmptySlot ? entries_.end()
+                                      : entries_.begin() + slot.entry_idx;
+}
+
+template <typename ValueType>
+typename Index3DFlatHashMap<ValueType>::const_iterator
+Index3DFlatHashMap<ValueType>::find(const Index3D& index) const {
+  if (entries_.empty()) {
+    return entries_.end();
+  }
+  const Slot& slot =
+      slots_[findSlot(index, static_cast<uint32_t>(hash(index)))];
+  return slot.entry_idx == kEmptySlot ? entries_.end()
+                                      : entries_.begin() + slot.entry_idx;
+}
+
+template <typename ValueType>
+size_t Index3DFlatHashMap<ValueType>::count(const Index3D& index) const {
+  return find(index) == end() ? 0 : 1;
+}
+
+template <typename ValueType>
+std::pair<typename Index3DFlatHashMap<ValueType>::iterator, bool>
+Index3DFlatHashMap<ValueType>::emplace(const Index3D& index,
+                                       ValueType value) {
+  auto it = find(index);
+  if (it != entries_.end()) {
+    return {it, false};
+  }
+  growIfNeeded();
+  const uint32_t fingerprint = static_cast<uint32_t>(hash(index));
+  const int32_t entry_idx = static_cast<int32_t>(entries_.size());
+  slots_[findSlot(index, fingerprint)] = Slot{fingerprint, entry_idx};
+  entries_.emplace_back(index, std::move(value));
+  return {entries_.begin() + entry_idx, true};
+}
+
+template <typename ValueType>
+ValueType& Index3DFlatHashMap<ValueType>::operator[](const Index3D& index) {
+  return emplace(index, ValueType()).first->second;
+}
+
+template <typename ValueType>
+typename Index3DFlatHashMap<ValueType>::iterator
+Index3DFlatHashMap<ValueType>::erase(const_iterator it) {
+  const int32_t entry_idx = static_cast<int32_t>(it - entries_.cbegin());
+  CHECK_GE(entry_idx, 0);
+  CHECK_LT(entry_idx, static_cast<int32_t>(entries_.size()));
+
+  // Free the slot, and shift back the slots following it which would
+  // otherwise no longer be reachable from their home slot.
+  size_t hole_idx = findSlotOfEntry(entry_idx);
+  size_t next_idx = (hole_idx + 1) & mask();
+  while (slots_[next_idx].entry_idx != kEmptySlot) {
+    const size_t home_idx = slots_[next_idx].fingerprint & mask();
+    if (((next_idx - home_idx) & mask()) >= ((next_idx - hole_idx) & mask())) {
+      slots_[hole_idx] = slots_[next_idx];
+      hole_idx = next_idx;
+    }
+    next_idx = (next_idx + 1) & mask();
+  }
+  slots_[hole_idx] = Slot();
+
+  // Keep the entries contiguous by moving the last one into the gap.
+  const int32_t last_entry_idx = static_cast<int32_t>(entries_.size()) - 1;
+  if (entry_idx != last_entry_idx) {
+    slots_[findSlotOfEntry(last_entry_idx)].entry_idx = entry_idx;
+    entries_[entry_idx] = std::move(entries_.back());
+  }
+  entries_.pop_back();
+  return entries_.begin() + entry_idx;
+}
+
+template <typename ValueType>
+size_t Index3DFlatHashMap<ValueType>::erase(const Index3D& index) {
+  const auto it = find(index);
+  if (it == entries_.end()) {
+    return 0;
+  }
+  erase(it);
+  return 1;
+}
+
+}  // namespace nvblox
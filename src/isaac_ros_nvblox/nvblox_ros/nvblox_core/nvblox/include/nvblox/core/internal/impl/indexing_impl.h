@@ -116,4 +116,33 @@ std::pair<int, int> getBlockAndVoxelIndexFrom1DPositionInLayer(
   return {block_idx, voxel_idx};
 }
 
+namespace internal {
+
+// Spreads the lowest 21 bits of a value such that there are two zero bits
+// between each of them.
+__host__ __device__ inline uint64_t spreadBitsForMortonCode(uint64_t value) {
+  value &= 0x1fffff;
+  value = (value | value << 32) & 0x1f00000000ffff;
+  value = (value | value << 16) & 0x1f0000ff0000ff;
+  value = (value | value << 8) & 0x100f00f00f00f00f;
+  value = (value | value << 4) & 0x10c30c30c30c30c3;
+  value = (value | value << 2) & 0x1249249249249249;
+  return value;
+}
+
+}  // namespace internal
+
+uint64_t getMortonCodeFromBlockIndex(const Index3D& block_index) {
+  // Offset the (signed) coordinates, such that they're ordered as unsigned
+  // values.
+  constexpr int kOffset = 1 << 20;
+  const uint64_t x =
+      internal::spreadBitsForMortonCode(block_index.x() + kOffset);
+  const uint64_t y =
+      internal::spreadBitsForMortonCode(block_index.y() + kOffset);
+  const uint64_t z =
+      internal::spreadBitsForMortonCode(block_index.z() + kOffset);
+  return x | (y << 1) | (z << 2);
+}
+
 }  // namespace nvblox
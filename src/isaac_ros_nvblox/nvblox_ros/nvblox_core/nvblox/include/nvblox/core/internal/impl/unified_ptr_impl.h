@@ -19,6 +19,7 @@ limitations under the License.
 #include "nvblox/utils/logging.h"
 
 #include "nvblox/core/internal/error_check.h"
+#include "nvblox/core/sync_monitor.h"
 
 namespace nvblox {
 
@@ -108,12 +109,36 @@ unified_ptr<T>::unified_ptr(T_noextent* ptr, MemoryType memory_type,
       ptr_(ptr),
       ref_counter_(new std::atomic<int>(1)) {}
 
+// Aliasing constructor.
+template <typename T>
+template <typename OwnerT>
+unified_ptr<T>::unified_ptr(const unified_ptr<OwnerT>& owner, T_noextent* ptr)
+    : memory_type_(owner.memory_type_),
+      size_(1),
+      ptr_(ptr),
+      allocation_ptr_(owner.ptr_),
+      ref_counter_(owner.ref_counter_) {
+  static_assert(std::is_array<OwnerT>::value,
+                "An aliasing unified_ptr must point into an array.");
+  static_assert(
+      std::is_same<typename std::remove_cv<T_noextent>::type,
+                   typename std::remove_cv<
+                       typename std::remove_extent<OwnerT>::type>::type>::value,
+      "An aliasing unified_ptr must point to the type of the owned array.");
+  static_assert(std::is_trivially_destructible<T_noextent>::value,
+                "Aliased objects must be trivially destructible.");
+  CHECK(owner.ptr_ != nullptr);
+  CHECK(ptr >= allocation_ptr_ && ptr < allocation_ptr_ + owner.size_);
+  (*ref_counter_)++;
+}
+
 // Copy constructor.
 template <typename T>
 unified_ptr<T>::unified_ptr(const unified_ptr<T>& other)
     : memory_type_(other.memory_type_),
       size_(other.size_),
       ptr_(other.ptr_),
+      allocation_ptr_(other.allocation_ptr_),
       ref_counter_(other.ref_counter_) {
   if (ptr_ != nullptr) {
     (*ref_counter_)++;
@@ -126,6 +151,7 @@ unified_ptr<T>::unified_ptr(unified_ptr<T>&& other)
     : memory_type_(other.memory_type_),
       size_(other.size_),
       ptr_(other.ptr_),
+      allocation_ptr_(other.allocation_ptr_),
       ref_counter_(other.ref_counter_) {
   if (ptr_ != nullptr) {
     (*ref_counter_)++;
@@ -168,13 +194,23 @@ struct Deleter<T[]> {
   }
 };
 
+template <typename T>
+void unified_ptr<T>::destroy() {
+  if (allocation_ptr_ == nullptr) {
+    Deleter<T>::destroy(ptr_, memory_type_);
+  } else if constexpr (std::is_trivially_destructible<T_noextent>::value) {
+    // Aliasing pointers always point into an array.
+    Deleter<T_noextent[]>::destroy(allocation_ptr_, memory_type_);
+  }
+}
+
 // Destructor.
 template <typename T>
 unified_ptr<T>::~unified_ptr() {
   if (ptr_ != nullptr) {
     (*ref_counter_)--;
     if (*ref_counter_ <= 0) {
-      Deleter<T>::destroy(ptr_, memory_type_);
+      destroy();
       delete ref_counter_;
       ptr_ = nullptr;
       ref_counter_ = nullptr;
@@ -187,6 +223,7 @@ template <typename T>
 unified_ptr<T>& unified_ptr<T>::operator=(const unified_ptr<T>& other) {
   reset();
   ptr_ = other.ptr_;
+  allocation_ptr_ = other.allocation_ptr_;
   ref_counter_ = other.ref_counter_;
   memory_type_ = other.memory_type_;
   size_ = other.size_;
@@ -200,6 +237,7 @@ template <typename T>
 unified_ptr<T>& unified_ptr<T>::operator=(unified_ptr<T>&& other) {
   reset();
   ptr_ = other.ptr_;
+  allocation_ptr_ = other.allocation_ptr_;
   ref_counter_ = other.ref_counter_;
   memory_type_ = other.memory_type_;
   size_ = other.size_;
@@ -215,6 +253,7 @@ unified_ptr<T>::operator unified_ptr<const T2>() const {
   unified_ptr<const T2> const_ptr;
   if (ptr_ != nullptr) {
     const_ptr.ptr_ = ptr_;
+    const_ptr.allocation_ptr_ = allocation_ptr_;
     const_ptr.ref_counter_ = ref_counter_;
     const_ptr.memory_type_ = memory_type_;
     const_ptr.size_ = size_;
@@ -232,6 +271,7 @@ unified_ptr<T>::operator unified_ptr<T2>() const {
   unified_ptr<T2> base_class_ptr;
   if (ptr_ != nullptr) {
     base_class_ptr.ptr_ = dynamic_cast<T2*>(ptr_);
+    base_class_ptr.allocation_ptr_ = dynamic_cast<T2*>(allocation_ptr_);
     base_class_ptr.ref_counter_ = ref_counter_;
     base_class_ptr.memory_type_ = memory_type_;
     base_class_ptr.size_ = size_;
@@ -298,10 +338,11 @@ void unified_ptr<T>::reset() {
   if (ptr_ != nullptr) {
     (*ref_counter_)--;
     if (*ref_counter_ <= 0) {
-      Deleter<T>::destroy(ptr_, memory_type_);
+      destroy();
       delete ref_counter_;
     }
     ptr_ = nullptr;
+    allocation_ptr_ = nullptr;
     ref_counter_ = nullptr;
     size_ = 1;
   }
@@ -321,6 +362,7 @@ struct Cloner {
            "it's not supported on all devices (need "
            "concurrentManagedAccess=1)";
     auto other = make_unified_async<T_nonconst>(memory_type, cuda_stream);
+    NVBLOX_SYNC_MONITOR_RECORD_COPY(other.get(), original.get(), cuda_stream);
     checkCudaErrors(cudaMemcpyAsync(other.get(), original.get(), sizeof(T),
                                     cudaMemcpyDefault, cuda_stream));
     return other;
@@ -343,6 +385,7 @@ struct Cloner<T[]> {
            "concurrentManagedAccess=1)";
     auto other =
         make_unified_async<T_nonconst[]>(size, memory_type, cuda_stream);
+    NVBLOX_SYNC_MONITOR_RECORD_COPY(other.get(), original.get(), cuda_stream);
     checkCudaErrors(cudaMemcpyAsync(other.get(), original.get(),
                                     sizeof(T_noextent) * size,
                                     cudaMemcpyDefault, cuda_stream));
@@ -377,6 +420,7 @@ template <typename T>
 void unified_ptr<T>::copyToAsync(T_noextent* raw_ptr,
                                  const CudaStream& cuda_stream) const {
   CHECK(raw_ptr != nullptr);
+  NVBLOX_SYNC_MONITOR_RECORD_COPY(raw_ptr, this->get(), cuda_stream);
   checkCudaErrors(cudaMemcpyAsync(raw_ptr, this->get(),
                                   sizeof(T_noextent) * size_, cudaMemcpyDefault,
                                   cuda_stream));
@@ -403,6 +447,7 @@ void unified_ptr<T>::copyFromAsync(const T_noextent* const raw_ptr,
                                    const size_t num_elements,
                                    const CudaStream& cuda_stream) {
   CHECK(num_elements <= size_);
+  NVBLOX_SYNC_MONITOR_RECORD_COPY(this->get(), raw_ptr, cuda_stream);
   checkCudaErrors(cudaMemcpyAsync(this->get(), raw_ptr,
                                   sizeof(T_noextent) * num_elements,
                                   cudaMemcpyDefault, cuda_stream));
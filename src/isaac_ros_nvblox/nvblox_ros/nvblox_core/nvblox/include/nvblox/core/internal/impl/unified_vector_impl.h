@@ -24,6 +24,7 @@ limitations under the License.
 #include <memory>
 
 #include "nvblox/core/internal/error_check.h"
+#include "nvblox/core/sync_monitor.h"
 
 namespace nvblox {
 
@@ -72,7 +73,9 @@ unified_vector<T>::unified_vector(unified_vector<T>&& other)
     : memory_type_(other.memory_type_),
       buffer_(other.buffer_),
       buffer_size_(other.buffer_size_),
-      buffer_capacity_(other.buffer_capacity_) {
+      buffer_capacity_(other.buffer_capacity_),
+      preferred_location_(other.preferred_location_),
+      read_mostly_(other.read_mostly_) {
   other.buffer_ = nullptr;
   other.buffer_size_ = 0;
   other.buffer_capacity_ = 0;
@@ -102,6 +105,8 @@ unified_vector<T>& unified_vector<T>::operator=(unified_vector<T>&& other) {
   buffer_size_ = other.buffer_size_;
   buffer_capacity_ = other.buffer_capacity_;
   memory_type_ = other.memory_type_;
+  preferred_location_ = other.preferred_location_;
+  read_mostly_ = other.read_mostly_;
   other.buffer_ = nullptr;
   other.buffer_size_ = 0;
   other.buffer_capacity_ = 0;
@@ -121,6 +126,7 @@ void unified_vector<T>::copyFromAsync(const T_noextent* const raw_ptr,
                                       const CudaStream& cuda_stream) {
   resizeAsync(num_elements, cuda_stream);
   if (raw_ptr != nullptr) {
+    NVBLOX_SYNC_MONITOR_RECORD_COPY(buffer_, raw_ptr, cuda_stream);
     checkCudaErrors(cudaMemcpyAsync(buffer_, raw_ptr, sizeof(T) * num_elements,
                                     cudaMemcpyDefault, cuda_stream));
   }
@@ -130,6 +136,7 @@ template <typename T>
 void unified_vector<T>::copyToAsync(T_noextent* raw_ptr,
                                     const CudaStream& cuda_stream) const {
   CHECK(raw_ptr != nullptr);
+  NVBLOX_SYNC_MONITOR_RECORD_COPY(raw_ptr, this->data(), cuda_stream);
   checkCudaErrors(cudaMemcpyAsync(raw_ptr, this->data(),
                                   sizeof(T_noextent) * buffer_size_,
                                   cudaMemcpyDefault, cuda_stream));
@@ -144,6 +151,7 @@ std::vector<T> unified_vector<T>::toVectorAsync(
     return std::vector<T>();
   }
   std::vector<T> vect(buffer_size_);
+  NVBLOX_SYNC_MONITOR_RECORD_COPY(vect.data(), buffer_, cuda_stream);
   checkCudaErrors(cudaMemcpyAsync(vect.data(), buffer_,
                                   sizeof(T) * buffer_size_, cudaMemcpyDefault,
                                   cuda_stream));
@@ -158,6 +166,7 @@ inline std::vector<bool> unified_vector<bool>::toVectorAsync(
   // copy to an intermediate buffer.
   CHECK(buffer_ != nullptr);
   std::unique_ptr<bool[]> bool_buffer(new bool[buffer_size_]);
+  NVBLOX_SYNC_MONITOR_RECORD_COPY(bool_buffer.get(), buffer_, cuda_stream);
   checkCudaErrors(cudaMemcpyAsync(bool_buffer.get(), buffer_,
                                   sizeof(bool) * buffer_size_,
                                   cudaMemcpyDefault, cuda_stream));
@@ -201,6 +210,50 @@ void unified_vector<T>::toCPU() {
                                        cudaCpuDeviceId));
 }
 
+template <typename T>
+void unified_vector<T>::prefetchAsync(UnifiedMemoryLocation location,
+                                      const CudaStream& cuda_stream) {
+  if (memory_type_ != MemoryType::kUnified || buffer_size_ == 0) {
+    return;
+  }
+  prefetchUnifiedMemoryAsync(buffer_, buffer_size_ * sizeof(T), location,
+                             cuda_stream);
+}
+
+template <typename T>
+void unified_vector<T>::advisePreferredLocation(
+    UnifiedMemoryLocation location) {
+  preferred_location_ = location;
+  applyMemoryAdvice();
+}
+
+template <typename T>
+void unified_vector<T>::adviseReadMostly(bool read_mostly) {
+  // Only unset the advice if it was previously set.
+  const bool was_read_mostly = read_mostly_;
+  read_mostly_ = read_mostly;
+  if (was_read_mostly && !read_mostly_ &&
+      memory_type_ == MemoryType::kUnified && buffer_ != nullptr) {
+    adviseUnifiedMemoryReadMostly(buffer_, buffer_capacity_ * sizeof(T),
+                                  false);
+  }
+  applyMemoryAdvice();
+}
+
+template <typename T>
+void unified_vector<T>::applyMemoryAdvice() {
+  if (memory_type_ != MemoryType::kUnified || buffer_ == nullptr) {
+    return;
+  }
+  if (preferred_location_.has_value()) {
+    adviseUnifiedMemoryPreferredLocation(
+        buffer_, buffer_capacity_ * sizeof(T), preferred_location_.value());
+  }
+  if (read_mostly_) {
+    adviseUnifiedMemoryReadMostly(buffer_, buffer_capacity_ * sizeof(T), true);
+  }
+}
+
 // Accessors
 template <typename T>
 size_t unified_vector<T>::capacity() const {
@@ -238,6 +291,7 @@ void unified_vector<T>::reserveAsync(size_t capacity,
     if (buffer_ != nullptr) {
       // Copy the old values to the new buffer.
       CHECK(capacity >= buffer_size_);
+      NVBLOX_SYNC_MONITOR_RECORD_COPY(new_buffer, buffer_, cuda_stream);
       checkCudaErrors(cudaMemcpyAsync(new_buffer, buffer_,
                                       sizeof(T) * buffer_size_,
                                       cudaMemcpyDefault, cuda_stream));
@@ -254,6 +308,7 @@ void unified_vector<T>::reserveAsync(size_t capacity,
     }
     buffer_ = new_buffer;
     buffer_capacity_ = capacity;
+    applyMemoryAdvice();
   }
 }
 
@@ -288,6 +343,16 @@ void unified_vector<T>::clearAndDeallocate() {
   buffer_capacity_ = 0;
 }
 
+template <typename T>
+void unified_vector<T>::clearAndDeallocateAsync(const CudaStream& cuda_stream) {
+  if (buffer_ != nullptr && memory_type_ == MemoryType::kDevice) {
+    checkCudaErrors(
+        cudaFreeAsync(reinterpret_cast<void*>(buffer_), cuda_stream));
+    buffer_ = nullptr;
+  }
+  clearAndDeallocate();
+}
+
 template <typename T>
 void unified_vector<T>::push_back(const T& value,
                                   const CudaStream& cuda_stream) {
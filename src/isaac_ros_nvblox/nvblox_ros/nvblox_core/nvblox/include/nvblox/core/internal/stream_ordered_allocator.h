@@ -0,0 +1,70 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#pragma once
+
+#include <cstddef>
+
+#include <cuda_runtime.h>
+#include <thrust/system/cuda/execution_policy.h>
+
+#include "nvblox/core/cuda_stream.h"
+#include "nvblox/core/internal/error_check.h"
+
+namespace nvblox {
+
+/// An allocator for the temporary storage of thrust algorithms (e.g. sort),
+/// which allocates from the device's (stream-ordered) memory pool on a stream
+/// rather than with cudaMalloc/cudaFree. See memory_pool.h for keeping the
+/// memory cached in the pool.
+///
+/// Usage:
+///   StreamOrderedAllocator allocator(cuda_stream);
+///   thrust::sort(thrust::cuda::par(allocator).on(cuda_stream), ...);
+class StreamOrderedAllocator {
+ public:
+  using value_type = char;
+
+  /// Constructor
+  /// @param cuda_stream The stream on which memory is allocated and freed. Has
+  ///                    to outlive the allocator.
+  explicit StreamOrderedAllocator(const CudaStream& cuda_stream)
+      : cuda_stream_(cuda_stream) {}
+
+  char* allocate(std::ptrdiff_t num_bytes) {
+    void* ptr = nullptr;
+    checkCudaErrors(cudaMallocAsync(&ptr, num_bytes, cuda_stream_));
+    return static_cast<char*>(ptr);
+  }
+
+  void deallocate(char* ptr, size_t) {
+    checkCudaErrors(cudaFreeAsync(ptr, cuda_stream_));
+  }
+
+ private:
+  const CudaStream& cuda_stream_;
+};
+
+/// A thrust execution policy running on a stream, with temporary storage
+/// allocated by a StreamOrderedAllocator.
+/// @param allocator The allocator. Has to outlive the algorithm call.
+/// @param cuda_stream The stream to run on.
+/// @return The execution policy.
+inline auto streamOrderedPolicy(StreamOrderedAllocator& allocator,
+                                const CudaStream& cuda_stream) {
+  return thrust::cuda::par(allocator).on(cuda_stream);
+}
+
+}  // namespace nvblox
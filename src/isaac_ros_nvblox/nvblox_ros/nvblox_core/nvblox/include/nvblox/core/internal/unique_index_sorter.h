@@ -0,0 +1,62 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#pragma once
+
+#include <cstdint>
+
+#include "nvblox/core/cuda_stream.h"
+#include "nvblox/core/types.h"
+#include "nvblox/core/unified_vector.h"
+
+namespace nvblox {
+
+/// Sorts and removes duplicates from (arbitrarily large) sets of block
+/// indices on the GPU, using device-wide radix sort and select.
+///
+/// The indices are packed losslessly into 64-bit keys with kKeyBitsPerAxis
+/// bits per axis, such that sorting and comparing keys is equivalent to
+/// (lexicographically) sorting and comparing the indices. Each component
+/// therefore has to be in [-kMaxAbsIndex, kMaxAbsIndex).
+///
+/// The instance keeps its key buffers between calls, such that steady-state
+/// calls don't allocate (apart from the temporary storage of the
+/// algorithms, which is drawn from the stream-ordered memory pool).
+class UniqueIndexSorter {
+ public:
+  static constexpr int kKeyBitsPerAxis = 21;
+  static constexpr int kMaxAbsIndex = 1 << (kKeyBitsPerAxis - 1);
+
+  UniqueIndexSorter() = default;
+  ~UniqueIndexSorter() = default;
+
+  /// Sort the indices and remove duplicates.
+  /// @attention Synchronizes the stream, to resize the output.
+  /// @param num_indices The number of (leading) elements of indices to sort.
+  /// Elements past it are discarded.
+  /// @param indices The indices, in device memory. Resized to the number of
+  /// unique indices.
+  /// @param cuda_stream The stream to run on.
+  void sortAndTakeUnique(int num_indices, device_vector<Index3D>* indices,
+                         const CudaStream& cuda_stream);
+
+ private:
+  device_vector<uint64_t> keys_;
+  device_vector<uint64_t> sorted_keys_;
+  device_vector<int> num_unique_device_{1};
+  host_vector<int> num_unique_host_{1};
+};
+
+}  // namespace nvblox
@@ -15,9 +15,17 @@ limitations under the License.
 */
 #pragma once
 
+#include <future>
+
 namespace nvblox {
 
 // Little function that warms up the CUDA drivers.
 void warmupCuda();
 
+// Runs warmupCuda() on its own thread, such that the CUDA context is created
+// while the caller continues with (host-side) initialization. CUDA calls made
+// in the meantime wait for the context to be ready. Call get() on the returned
+// future to wait for the warmup (and rethrow any failure).
+std::future<void> warmupCudaAsync();
+
 }  // namespace nvblox
@@ -0,0 +1,141 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#pragma once
+
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "nvblox/core/cuda_stream.h"
+
+namespace nvblox {
+
+/// @brief The GPU model of a CUDA device, e.g. "Orin_sm87". Launch
+/// configurations are tuned per model, as they only depend on the hardware.
+/// @param device The device.
+/// @return The device name (with spaces replaced) and compute capability.
+std::string getCudaDeviceModel(int device);
+
+/// @brief Selects the fastest of several candidate launch configurations of a
+/// kernel, per GPU model.
+///
+/// Kernels with tunable launch configurations (e.g. the number of threads per
+/// thread block) are launched through launch(). Without tuning (the default),
+/// or once a kernel is tuned for the model of the current device, launch()
+/// directly launches the selected candidate. While tuning, the launches cycle
+/// through the candidates and time each one with CUDA events, which
+/// synchronizes the stream. Once every candidate has been timed
+/// num_trials_per_candidate() times, the one with the lowest mean time is
+/// selected. All launches do their actual work, so tuning happens on the first
+/// frames after startup, or offline by running a dataset through the fuser.
+///
+/// The selected candidates are saved to (and loaded from) a cache file, such
+/// that each kernel is tuned once per GPU model. The file has one line per
+/// kernel and GPU model: "<device_model> <kernel_name> <candidate>".
+class LaunchAutotuner {
+ public:
+  /// A kernel launch with a candidate launch configuration.
+  using LaunchFunction = std::function<void(int candidate)>;
+
+  /// Get a reference to the LaunchAutotuner singleton.
+  /// @return A reference to this program's autotuner.
+  static LaunchAutotuner& getInstance();
+
+  /// Launches a kernel with the selected candidate, or tunes it (see above).
+  /// @param kernel_name Unique name of the kernel (and its template params).
+  /// @param candidates The candidate launch configurations, e.g. thread
+  /// block sizes. Must not be empty.
+  /// @param default_candidate The candidate launched without tuning.
+  /// @param launch_function Launches the kernel with a candidate.
+  /// @param cuda_stream The stream the kernel is launched on.
+  void launch(const std::string& kernel_name,
+              const std::vector<int>& candidates, int default_candidate,
+              const LaunchFunction& launch_function,
+              const CudaStream& cuda_stream);
+
+  /// @brief Whether kernels without a selected candidate are tuned.
+  bool tuning_enabled() const;
+  /// @brief Enable or disable tuning.
+  void tuning_enabled(bool tuning_enabled);
+
+  /// @brief The number of timed launches per candidate.
+  int num_trials_per_candidate() const;
+  /// @brief Set the number of timed launches per candidate.
+  void num_trials_per_candidate(int num_trials_per_candidate);
+
+  /// @brief Set the cache file. Loads the selected candidates from it if it
+  /// exists, and saves them to it every time a kernel has been tuned.
+  /// @param cache_file_path The path. An empty path disables the cache.
+  void setCacheFilePath(const std::string& cache_file_path);
+
+  /// @brief Load selected candidates from a cache file. Replaces the
+  /// candidates of the kernels found in the file.
+  /// @param path The path of the file.
+  /// @return False if the file couldn't be read.
+  bool loadCache(const std::string& path);
+
+  /// @brief Save all selected candidates to a cache file.
+  /// @param path The path of the file.
+  /// @return False if the file couldn't be written.
+  bool saveCache(const std::string& path) const;
+
+  /// @brief The candidate selected for a kernel on a GPU model, if any.
+  std::optional<int> getSelectedCandidate(const std::string& device_model,
+                                          const std::string& kernel_name) const;
+
+  /// @brief Select the candidate of a kernel on a GPU model.
+  void setSelectedCandidate(const std::string& device_model,
+                            const std::string& kernel_name, int candidate);
+
+  /// @brief Forget all selected candidates and tuning progress.
+  void clear();
+
+ private:
+  LaunchAutotuner() = default;
+
+  // Identifies a kernel on a GPU model.
+  using Key = std::pair<std::string, std::string>;
+
+  // The timings of the candidates of a kernel being tuned.
+  struct TuningState {
+    std::vector<int> candidates;
+    std::vector<float> total_ms;
+    std::vector<int> num_trials;
+  };
+
+  // Launches and times the candidate of a kernel with the fewest trials.
+  // Selects the fastest candidate once all candidates are timed.
+  void launchTuning(const Key& key, const std::vector<int>& candidates,
+                    const LaunchFunction& launch_function,
+                    const CudaStream& cuda_stream);
+
+  // Caches the device models by device, as looking them up is slow.
+  std::string getCurrentCudaDeviceModel();
+
+  mutable std::mutex mutex_;
+  bool tuning_enabled_ = false;
+  int num_trials_per_candidate_ = 5;
+  std::string cache_file_path_;
+  std::map<Key, int> selected_candidates_;
+  std::map<Key, TuningState> tuning_states_;
+  std::map<int, std::string> device_models_;
+};
+
+}  // namespace nvblox
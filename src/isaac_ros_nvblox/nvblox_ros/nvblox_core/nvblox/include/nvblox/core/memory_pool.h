@@ -0,0 +1,60 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#pragma once
+
+#include <cstdint>
+
+namespace nvblox {
+
+/// Device memory of unified_vector (and of other stream-ordered allocations,
+/// see StreamOrderedAllocator) comes from the device's default CUDA memory
+/// pool. By default that pool releases all memory that isn't in use back to the
+/// OS whenever a stream is synchronized, such that every frame has to allocate
+/// from the driver again. The release threshold is the amount of unused
+/// memory the pool keeps instead, which makes steady-state frames free of
+/// driver-level allocations.
+
+/// Release threshold that keeps all memory freed to the pool.
+constexpr uint64_t kKeepAllMemoryPoolReleaseThreshold = UINT64_MAX;
+
+/// Set the release threshold of the current device's default memory pool.
+/// @param release_threshold_bytes Bytes of unused memory kept by the pool.
+void setDeviceMemoryPoolReleaseThreshold(uint64_t release_threshold_bytes);
+
+/// Get the release threshold of the current device's default memory pool.
+/// @return Bytes of unused memory kept by the pool.
+uint64_t getDeviceMemoryPoolReleaseThreshold();
+
+/// Memory held by the current device's default memory pool.
+struct DeviceMemoryPoolUsage {
+  /// Memory allocated from the driver, whether in use or not.
+  uint64_t reserved_bytes = 0;
+  /// Memory in use by allocations.
+  uint64_t used_bytes = 0;
+};
+
+/// Get the memory held by the current device's default memory pool.
+/// @return The usage.
+DeviceMemoryPoolUsage getDeviceMemoryPoolUsage();
+
+/// Grow the current device's default memory pool up front, by allocating and
+/// freeing num_bytes. The memory stays in the pool (up to the release
+/// threshold, so set that first), such that the first frames don't pay for
+/// driver-level allocations of their temporaries.
+/// @param num_bytes Bytes of memory to make available in the pool.
+void reserveDeviceMemoryPool(uint64_t num_bytes);
+
+}  // namespace nvblox
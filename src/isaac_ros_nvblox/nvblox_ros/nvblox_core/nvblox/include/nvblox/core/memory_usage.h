@@ -0,0 +1,45 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#pragma once
+
+#include <cstddef>
+
+namespace nvblox {
+
+/// The memory held by a container, e.g. the block pool of a layer.
+struct MemoryUsage {
+  /// Bytes allocated, whether in use or not.
+  size_t allocated_bytes = 0;
+  /// Bytes in use. The remainder is available for reuse without allocating.
+  size_t used_bytes = 0;
+
+  /// Bytes allocated but not in use.
+  size_t idle_bytes() const {
+    return (allocated_bytes > used_bytes) ? allocated_bytes - used_bytes : 0;
+  }
+
+  MemoryUsage& operator+=(const MemoryUsage& other) {
+    allocated_bytes += other.allocated_bytes;
+    used_bytes += other.used_bytes;
+    return *this;
+  }
+};
+
+inline MemoryUsage operator+(MemoryUsage lhs, const MemoryUsage& rhs) {
+  return lhs += rhs;
+}
+
+}  // namespace nvblox
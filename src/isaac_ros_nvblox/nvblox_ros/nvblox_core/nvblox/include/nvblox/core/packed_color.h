@@ -0,0 +1,90 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#pragma once
+
+#include <cuda_runtime.h>
+#include <stdint.h>
+#include <cmath>
+
+#include "nvblox/core/color.h"
+
+namespace nvblox {
+
+/// An 8-bit RGB color without alpha, which converts to and from Color.
+/// Colors converted from a PackedRgb are fully opaque.
+struct PackedRgb {
+  PackedRgb() = default;
+  __host__ __device__ PackedRgb(const Color& color)
+      : r(color.r), g(color.g), b(color.b) {}
+
+  __host__ __device__ operator Color() const { return Color(r, g, b); }
+
+  __host__ __device__ bool operator==(const PackedRgb& other) const {
+    return (r == other.r) && (g == other.g) && (b == other.b);
+  }
+
+  uint8_t r;
+  uint8_t g;
+  uint8_t b;
+};
+
+/// A non-negative, 8-bit fixed point scalar which behaves like a float.
+///
+/// Values are rounded to the nearest multiple of kResolution on assignment
+/// and saturate at kMaxValue. Intended for integration weights, where this
+/// covers the range of the usual maximum weights.
+class QuantizedWeight {
+ public:
+  /// The smallest non-zero value representable.
+  static constexpr float kResolution = 1.0f / 32.0f;
+  /// The largest value representable.
+  static constexpr float kMaxValue = 255.0f * kResolution;
+
+  QuantizedWeight() = default;
+  __host__ __device__ QuantizedWeight(float value)
+      : value_(fromFloat(value)) {}
+
+  __host__ __device__ operator float() const {
+    return static_cast<float>(value_) * kResolution;
+  }
+
+  __host__ __device__ QuantizedWeight& operator=(float value) {
+    value_ = fromFloat(value);
+    return *this;
+  }
+  __host__ __device__ QuantizedWeight& operator+=(float value) {
+    return *this = static_cast<float>(*this) + value;
+  }
+  __host__ __device__ QuantizedWeight& operator-=(float value) {
+    return *this = static_cast<float>(*this) - value;
+  }
+  __host__ __device__ QuantizedWeight& operator*=(float value) {
+    return *this = static_cast<float>(*this) * value;
+  }
+
+ private:
+  __host__ __device__ static uint8_t fromFloat(float value) {
+    return static_cast<uint8_t>(
+        rintf(fminf(fmaxf(value, 0.0f), kMaxValue) / kResolution));
+  }
+
+  uint8_t value_;
+};
+
+static_assert(sizeof(PackedRgb) == 3, "PackedRgb must be 24 bits.");
+static_assert(sizeof(QuantizedWeight) == 1, "QuantizedWeight must be 8 bits.");
+
+}  // namespace nvblox
@@ -0,0 +1,129 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "nvblox/core/cuda_event.h"
+#include "nvblox/core/cuda_stream.h"
+#include "nvblox/core/unified_ptr.h"
+#include "nvblox/core/unified_vector.h"
+
+namespace nvblox {
+
+/// A pool of pinned host buffers for staging uploads of data in pageable host
+/// memory (e.g. images and pointclouds from the CPU).
+///
+/// Host-to-device copies from pageable memory are staged by the driver and
+/// don't overlap with other work. Copying through a pinned buffer instead lets
+/// the copy run asynchronously on the stream. Released buffers are recycled
+/// once the work queued before their release has completed, such that the
+/// host never waits for an upload to be able to stage the next one.
+///
+/// The pool is thread-safe and may be shared between streams.
+class PinnedHostBufferPool {
+ public:
+  /// The maximum number of idle buffers kept by default.
+  static constexpr size_t kDefaultMaxNumIdleBuffers = 8;
+
+  /// A pinned buffer leased from the pool.
+  struct Buffer {
+    unified_ptr<uint8_t[]> data;
+    size_t size_bytes = 0;
+  };
+
+  /// Constructor
+  /// @param max_num_idle_buffers The maximum number of released buffers which
+  ///                             are kept for reuse. Beyond that, buffers whose
+  ///                             work has completed are freed.
+  explicit PinnedHostBufferPool(
+      size_t max_num_idle_buffers = kDefaultMaxNumIdleBuffers);
+  ~PinnedHostBufferPool() = default;
+
+  PinnedHostBufferPool(const PinnedHostBufferPool&) = delete;
+  PinnedHostBufferPool& operator=(const PinnedHostBufferPool&) = delete;
+
+  /// Lease a buffer of at least num_bytes. Recycles a released buffer if one
+  /// is large enough and no longer in use, and allocates one otherwise.
+  /// @param num_bytes The required size.
+  /// @return The buffer.
+  Buffer acquire(size_t num_bytes);
+
+  /// Return a buffer to the pool. It is recycled once the work that is
+  /// currently queued on cuda_stream (e.g. a copy from it) has completed.
+  /// @param buffer The buffer.
+  /// @param cuda_stream The stream using the buffer.
+  void releaseAsync(Buffer buffer, const CudaStream& cuda_stream);
+
+  /// Copy host data into a vector, staged through a pinned buffer such that
+  /// the copy is asynchronous on the stream. The host data may be modified
+  /// or freed as soon as the call returns. The vector is resized if needed.
+  /// @param host_ptr The data, in (pageable) host memory.
+  /// @param num_elements The number of elements to copy.
+  /// @param destination The vector to copy into.
+  /// @param cuda_stream The stream on which to copy.
+  template <typename T>
+  void uploadAsync(const T* host_ptr, size_t num_elements,
+                   unified_vector<T>* destination,
+                   const CudaStream& cuda_stream);
+
+  /// The number of buffers which are released and waiting to be recycled.
+  size_t num_idle_buffers() const;
+
+  /// The maximum number of idle buffers kept. See constructor.
+  size_t max_num_idle_buffers() const { return max_num_idle_buffers_; }
+
+ private:
+  struct IdleBuffer {
+    Buffer buffer;
+    // Recorded on release. The buffer is free for reuse once it's ready.
+    std::unique_ptr<CudaEvent> released_event;
+  };
+
+  const size_t max_num_idle_buffers_;
+  mutable std::mutex mutex_;
+  std::vector<IdleBuffer> idle_buffers_;
+};
+
+template <typename T>
+void PinnedHostBufferPool::uploadAsync(const T* host_ptr, size_t num_elements,
+                                       unified_vector<T>* destination,
+                                       const CudaStream& cuda_stream) {
+  CHECK_NOTNULL(destination);
+  if (num_elements == 0) {
+    destination->resizeAsync(0, cuda_stream);
+    return;
+  }
+  CHECK_NOTNULL(host_ptr);
+  if (destination->memory_type() == MemoryType::kHost) {
+    // The destination is pinned already.
+    destination->copyFromAsync(host_ptr, num_elements, cuda_stream);
+    return;
+  }
+  const size_t num_bytes = num_elements * sizeof(T);
+  Buffer staging_buffer = acquire(num_bytes);
+  std::memcpy(staging_buffer.data.get(), host_ptr, num_bytes);
+  destination->copyFromAsync(reinterpret_cast<const T*>(
+                                 staging_buffer.data.get()),
+                             num_elements, cuda_stream);
+  releaseAsync(std::move(staging_buffer), cuda_stream);
+}
+
+}  // namespace nvblox
@@ -0,0 +1,71 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#pragma once
+
+#include <cuda_runtime.h>
+#include <stdint.h>
+#include <cmath>
+
+namespace nvblox {
+
+/// A 16-bit fixed point log-odds value which behaves like a float.
+///
+/// Values are rounded to the nearest multiple of kResolution on assignment,
+/// and updates saturate at +-kMaxValue rather than overflowing. The range
+/// covers all log-odds produced by logOddsFromProbability().
+class QuantizedLogOdds {
+ public:
+  /// The smallest non-zero magnitude representable.
+  static constexpr float kResolution = 1.0f / 4096.0f;
+  /// The largest magnitude representable.
+  static constexpr float kMaxValue = 32767.0f * kResolution;
+
+  QuantizedLogOdds() = default;
+  __host__ __device__ QuantizedLogOdds(float value)
+      : value_(fromFloat(value)) {}
+
+  __host__ __device__ operator float() const {
+    return static_cast<float>(value_) * kResolution;
+  }
+
+  __host__ __device__ QuantizedLogOdds& operator=(float value) {
+    value_ = fromFloat(value);
+    return *this;
+  }
+  __host__ __device__ QuantizedLogOdds& operator+=(float value) {
+    return *this = static_cast<float>(*this) + value;
+  }
+  __host__ __device__ QuantizedLogOdds& operator-=(float value) {
+    return *this = static_cast<float>(*this) - value;
+  }
+
+  /// The underlying fixed point value. Ordered like the log-odds it
+  /// represents.
+  __host__ __device__ int16_t raw() const { return value_; }
+
+ private:
+  __host__ __device__ static int16_t fromFloat(float value) {
+    return static_cast<int16_t>(
+        rintf(fminf(fmaxf(value, -kMaxValue), kMaxValue) / kResolution));
+  }
+
+  int16_t value_;
+};
+
+static_assert(sizeof(QuantizedLogOdds) == 2,
+              "QuantizedLogOdds must be 16 bits.");
+
+}  // namespace nvblox
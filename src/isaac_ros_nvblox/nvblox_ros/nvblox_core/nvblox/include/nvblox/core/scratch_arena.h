@@ -0,0 +1,103 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "nvblox/core/cuda_stream.h"
+
+namespace nvblox {
+
+/// A bump allocator for device memory which is only needed during a single
+/// integrator call (e.g. intermediate buffers of a kernel pipeline).
+///
+/// All integrators running on the same stream can draw their temporaries from
+/// one arena, rather than each keeping private buffers sized for their own
+/// peak. The arena is reset once per frame. Memory handed out is valid until
+/// the next reset(), and because all allocations are ordered on a single
+/// stream, work queued before a reset may still use it.
+///
+/// When a frame needs more memory than the arena holds, additional chunks are
+/// allocated. On the next reset() these are coalesced into a single chunk of
+/// the peak size, such that steady-state frames don't allocate.
+///
+/// Note that the arena is not thread-safe and has to be used from a single
+/// stream.
+class ScratchArena {
+ public:
+  /// The alignment of all allocations in bytes.
+  static constexpr size_t kAlignmentBytes = 256;
+
+  ScratchArena() = default;
+  ~ScratchArena();
+
+  ScratchArena(const ScratchArena&) = delete;
+  ScratchArena& operator=(const ScratchArena&) = delete;
+
+  /// Allocate device memory which stays valid until the next reset().
+  /// @param num_bytes The size of the allocation.
+  /// @param cuda_stream The stream on which a new chunk is allocated, if
+  ///                    required.
+  /// @return A pointer to the memory, or nullptr if num_bytes is zero.
+  void* allocateBytesAsync(size_t num_bytes, const CudaStream& cuda_stream);
+
+  /// Allocate (uninitialized) device memory for an array of num_elements Ts.
+  /// See allocateBytesAsync().
+  template <typename T>
+  T* allocateAsync(size_t num_elements, const CudaStream& cuda_stream) {
+    return static_cast<T*>(
+        allocateBytesAsync(num_elements * sizeof(T), cuda_stream));
+  }
+
+  /// Invalidate all allocations, and coalesce the chunks allocated so far into
+  /// a single chunk of the peak size.
+  /// @param cuda_stream The stream on which chunks are freed and allocated.
+  void reset(const CudaStream& cuda_stream);
+
+  /// Release all memory held by the arena.
+  /// @param cuda_stream The stream on which chunks are freed.
+  void clearAndDeallocateAsync(const CudaStream& cuda_stream);
+
+  /// The number of bytes allocated since the last reset (including padding).
+  size_t used_bytes() const { return used_bytes_; }
+
+  /// The largest number of bytes used within a single frame.
+  size_t peak_bytes() const { return peak_bytes_; }
+
+  /// The number of bytes of device memory held by the arena.
+  size_t capacity_bytes() const;
+
+  /// The number of chunks the memory is split over.
+  size_t num_chunks() const { return chunks_.size(); }
+
+ private:
+  struct Chunk {
+    char* data = nullptr;
+    size_t size_bytes = 0;
+  };
+
+  void addChunkAsync(size_t size_bytes, const CudaStream& cuda_stream);
+  void freeChunksAsync(const CudaStream& cuda_stream);
+
+  std::vector<Chunk> chunks_;
+  // Bytes used in the last chunk. Earlier chunks are full.
+  size_t chunk_offset_bytes_ = 0;
+  size_t used_bytes_ = 0;
+  size_t peak_bytes_ = 0;
+};
+
+}  // namespace nvblox
@@ -0,0 +1,126 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#pragma once
+
+#include <cuda_runtime.h>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+
+#include "nvblox/core/types.h"
+
+namespace nvblox {
+
+/// The kinds of host stalls recorded by the SyncMonitor.
+enum class SyncEventType {
+  /// The host waited on a stream or an event (synchronize()).
+  kSynchronize,
+  /// A copy was enqueued on the legacy or per-thread default stream.
+  kDefaultStreamCopy,
+  /// A copy from or to pageable (non-pinned) host memory. These are staged
+  /// by the driver and block the host.
+  kPageableCopy,
+};
+constexpr int kNumSyncEventTypes = 3;
+
+template <>
+inline std::string toString(const SyncEventType& event_type) {
+  switch (event_type) {
+    case SyncEventType::kSynchronize:
+      return "kSynchronize";
+    case SyncEventType::kDefaultStreamCopy:
+      return "kDefaultStreamCopy";
+    case SyncEventType::kPageableCopy:
+      return "kPageableCopy";
+    default:
+      LOG(FATAL) << "Not implemented";
+      return "";
+  }
+}
+
+/// Counts the implicit and explicit host synchronizations of nvblox, such
+/// that stalls hidden in e.g. a copy between a std::vector and the device
+/// show up without running nsys.
+///
+/// Each event is attributed to the innermost timer running on the calling
+/// thread (or "untagged"). The hooks in CudaStream, CudaEvent,
+/// unified_vector and unified_ptr are only compiled in when building with
+/// USE_SYNC_MONITOR (which defines NVBLOX_SYNC_MONITOR), so the monitor has
+/// no cost in regular builds.
+class SyncMonitor {
+ public:
+  using Counts = std::array<uint64_t, kNumSyncEventTypes>;
+
+  /// Records an event at the call site of the calling thread.
+  static void record(SyncEventType event_type);
+
+  /// Records the events implied by a copy between dst and src on stream: a
+  /// kDefaultStreamCopy if stream is a default stream, and a kPageableCopy
+  /// if either of the buffers is pageable host memory.
+  static void recordCopy(const void* dst, const void* src, cudaStream_t stream);
+
+  /// Ends a frame: logs the counts of the events since the last call (if
+  /// there were any) and resets them.
+  /// @return The counts of the frame.
+  static Counts endFrame();
+
+  /// The counts of the events since the last endFrame().
+  static Counts frameCounts();
+  /// The counts of all events since the start (or the last reset()).
+  static Counts totalCounts();
+  /// The counts of all events, per call-site tag.
+  static std::map<std::string, Counts> countsPerTag();
+
+  /// Sets whether each event is logged as it happens. Off by default.
+  static void setLogEachEvent(bool log_each_event);
+
+  /// Clears all counts.
+  static void reset();
+
+  /// A table of the counts per tag.
+  static std::string Print();
+
+  /// Called by the timers to maintain the stack of call-site tags of the
+  /// calling thread.
+  static void pushTimerHandle(size_t timer_handle);
+  static void popTimerHandle(size_t timer_handle);
+
+ private:
+  static SyncMonitor& Instance();
+  static std::string currentTag();
+
+  std::mutex mutex_;
+  Counts frame_counts_{};
+  Counts total_counts_{};
+  std::map<std::string, Counts> counts_per_tag_;
+  std::atomic<bool> log_each_event_{false};
+};
+
+}  // namespace nvblox
+
+#ifdef NVBLOX_SYNC_MONITOR
+#define NVBLOX_SYNC_MONITOR_RECORD(event_type) \
+  ::nvblox::SyncMonitor::record(event_type)
+#define NVBLOX_SYNC_MONITOR_RECORD_COPY(dst, src, stream) \
+  ::nvblox::SyncMonitor::recordCopy(dst, src, stream)
+#else
+#define NVBLOX_SYNC_MONITOR_RECORD(event_type) ((void)0)
+#define NVBLOX_SYNC_MONITOR_RECORD_COPY(dst, src, stream) ((void)0)
+#endif
@@ -0,0 +1,64 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#pragma once
+
+#include <cstddef>
+
+#include "nvblox/core/cuda_stream.h"
+
+namespace nvblox {
+
+/// Hints to the driver about where unified (managed) memory is needed, such
+/// that pages are migrated ahead of time rather than faulted in one by one.
+///
+/// The hints are only effective on devices which support concurrent managed
+/// access. Elsewhere (e.g. on some Jetson devices, where managed memory is
+/// migrated wholesale at kernel launch), all functions here are no-ops.
+
+/// Where unified memory should reside.
+enum class UnifiedMemoryLocation { kDevice, kHost };
+
+/// Whether the current device supports prefetching and memory advice.
+/// @return True if hints are effective.
+bool unifiedMemoryHintsSupported();
+
+/// Migrate unified memory to a location, ordered on a stream.
+/// @param ptr The start of the memory range. Must be managed memory.
+/// @param num_bytes The size of the memory range.
+/// @param location Where the memory is needed next.
+/// @param cuda_stream The stream on which the memory is needed.
+void prefetchUnifiedMemoryAsync(const void* ptr, size_t num_bytes,
+                                UnifiedMemoryLocation location,
+                                const CudaStream& cuda_stream);
+
+/// Set the location where unified memory preferably resides. Accesses from
+/// elsewhere map the memory rather than migrating it.
+/// @param ptr The start of the memory range. Must be managed memory.
+/// @param num_bytes The size of the memory range.
+/// @param location The preferred location.
+void adviseUnifiedMemoryPreferredLocation(const void* ptr, size_t num_bytes,
+                                          UnifiedMemoryLocation location);
+
+/// Mark unified memory as (mostly) read, such that it is duplicated rather
+/// than migrated on access. Writes invalidate all copies but one, so this
+/// should only be set for memory which is rarely written.
+/// @param ptr The start of the memory range. Must be managed memory.
+/// @param num_bytes The size of the memory range.
+/// @param read_mostly Whether to set or unset the advice.
+void adviseUnifiedMemoryReadMostly(const void* ptr, size_t num_bytes,
+                                   bool read_mostly);
+
+}  // namespace nvblox
@@ -39,6 +39,11 @@ namespace nvblox {
 ///   - No Constructor called in kDevice mode.
 ///   - No destructor called for ANY memory setting so we make a static check
 ///     that objects are trivially destructable.
+/// - Aliasing
+///   - A pointer may point to a single element of an array owned by another
+///     unified_ptr, sharing its ownership. The array is freed once the last
+///     pointer sharing it is destroyed. Elements must be trivially
+///     destructible.
 template <typename T>
 class unified_ptr {
  public:
@@ -50,6 +55,12 @@ class unified_ptr {
   unified_ptr();
   explicit unified_ptr(T_noextent* ptr, MemoryType memory_type,
                        size_t size = 1);
+  /// Aliasing constructor. Points to an element of the array owned by owner
+  /// and shares the ownership of that array.
+  /// @param owner The pointer owning the array.
+  /// @param ptr Pointer to an element of the array.
+  template <typename OwnerT>
+  unified_ptr(const unified_ptr<OwnerT>& owner, T_noextent* ptr);
   unified_ptr(const unified_ptr<T>& other);
   unified_ptr(unified_ptr<T>&& other);
   ~unified_ptr();
@@ -99,6 +110,10 @@ class unified_ptr {
                                                  bool>::type = true>
   operator unified_ptr<T2>() const;
 
+  /// Whether this pointer aliases an element of an array (see the aliasing
+  /// constructor).
+  bool is_alias() const { return allocation_ptr_ != nullptr; }
+
   /// Get the raw pointer.
   T_noextent* get();
   const T_noextent* get() const;
@@ -146,10 +161,15 @@ class unified_ptr {
   friend class unified_ptr;
 
  private:
+  /// Frees the memory once the last reference is gone.
+  void destroy();
+
   MemoryType memory_type_;
   size_t size_;
 
   T_noextent* ptr_;
+  /// For aliasing pointers, the start of the array owning ptr_. Null else.
+  T_noextent* allocation_ptr_ = nullptr;
 
   mutable std::atomic<int>* ref_counter_;
 };
@@ -15,11 +15,13 @@ limitations under the License.
 */
 #pragma once
 
+#include <optional>
 #include <type_traits>
 #include <vector>
 #include "nvblox/core/cuda_stream.h"
 #include "nvblox/core/iterator.h"
 #include "nvblox/core/types.h"
+#include "nvblox/core/unified_memory_hints.h"
 #include "nvblox/utils/logging.h"
 
 namespace nvblox {
@@ -93,6 +95,24 @@ class unified_vector {
   void toGPU();
   void toCPU();
 
+  /// Migrate the memory to where it is needed next, ordered on a stream.
+  /// Only has an effect for MemoryType::kUnified (see unified_memory_hints.h).
+  /// @param location Where the memory is needed next.
+  /// @param cuda_stream The stream on which the memory is needed.
+  void prefetchAsync(UnifiedMemoryLocation location,
+                     const CudaStream& cuda_stream);
+
+  /// Set the location where the memory preferably resides. The advice is
+  /// kept across reallocations. Only has an effect for MemoryType::kUnified.
+  /// @param location The preferred location.
+  void advisePreferredLocation(UnifiedMemoryLocation location);
+
+  /// Mark the memory as (mostly) read, such that it is duplicated between the
+  /// CPU and GPU rather than migrated. The advice is kept across
+  /// reallocations. Only has an effect for MemoryType::kUnified.
+  /// @param read_mostly Whether the memory is mostly read.
+  void adviseReadMostly(bool read_mostly);
+
   /// Access information.
   size_t capacity() const;
   size_t size() const;
@@ -110,6 +130,11 @@ class unified_vector {
   /// Clear the vector and deallocate the data
   void clearAndDeallocate();
 
+  /// Clear the vector and deallocate the data. Device memory is freed on the
+  /// stream, which avoids the device-wide synchronization of cudaFree().
+  /// @param cuda_stream The stream on which the memory was last used.
+  void clearAndDeallocateAsync(const CudaStream& cuda_stream);
+
   /// Clear without deallocating
   void clearNoDeallocate();
 
@@ -132,11 +157,18 @@ class unified_vector {
   void setZeroAsync(const CudaStream& cuda_stream);
 
  private:
+  // Apply the memory advice to the current buffer.
+  void applyMemoryAdvice();
+
   MemoryType memory_type_;
 
   T* buffer_;
   size_t buffer_size_;
   size_t buffer_capacity_;
+
+  // Memory advice for unified memory.
+  std::optional<UnifiedMemoryLocation> preferred_location_;
+  bool read_mostly_ = false;
 };
 
 /// Specialization for unified_vector on device memory only.
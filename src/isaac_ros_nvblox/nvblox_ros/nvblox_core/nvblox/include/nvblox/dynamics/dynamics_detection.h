@@ -15,6 +15,7 @@ limitations under the License.
 */
 #pragma once
 
+#include "nvblox/core/cuda_event.h"
 #include "nvblox/core/cuda_stream.h"
 #include "nvblox/map/common_names.h"
 #include "nvblox/sensors/camera.h"
@@ -28,13 +29,19 @@ namespace nvblox {
 /// It takes a depth frame and compares it to the freespace layer.
 /// If any surface seen on the depth image falls into freespace it is assumed to
 /// be dynamic.
+///
+/// The detection can run asynchronously on its own stream (see
+/// computeDynamicsAsync()). The outputs are then consumed on other streams
+/// after waitForOutputs(), or on the host after synchronizeOutputs(), which
+/// only wait for the detection rather than for the whole stream.
 class DynamicsDetection {
  public:
   DynamicsDetection() = delete;
   DynamicsDetection(std::shared_ptr<CudaStream> cuda_stream);
   virtual ~DynamicsDetection() = default;
 
-  /// @brief Detect dynamics on the depth frames by comparing it to the tsdf
+  /// @brief Detect dynamics on the depth frames by comparing it to the tsdf.
+  /// Blocks until the outputs are ready.
   /// @param depth_frame_C The depth frame.
   /// @param tsdf_layer_L  The tsdf layer.
   /// @param camera The camera that belongs to the depth frame.
@@ -43,21 +50,43 @@ class DynamicsDetection {
                        const FreespaceLayer& tsdf_layer_L, const Camera& camera,
                        const Transform& T_L_C);
 
+  /// @brief Same as computeDynamics() but does not block. The depth frame and
+  /// the freespace layer must not be modified until the outputs are ready.
+  void computeDynamicsAsync(const DepthImage& depth_frame_C,
+                            const FreespaceLayer& tsdf_layer_L,
+                            const Camera& camera, const Transform& T_L_C);
+
+  /// @brief Make future work on a stream wait for the outputs of the last
+  /// detection. Does not block the host.
+  /// @param cuda_stream The stream consuming the outputs.
+  void waitForOutputs(const CudaStream& cuda_stream) const;
+
+  /// @brief Block the host until the outputs of the last detection are ready.
+  void synchronizeOutputs();
+
+  /// @brief Check (without blocking) whether the outputs of the last
+  /// detection are ready.
+  bool outputsReady() const;
+
   /// @brief Gets the 3D points detected as dynamics on the last depth frame.
+  /// Waits for the outputs of the last detection.
   /// @return The dynamic points as a 3*X matrix on host.
   Eigen::Matrix3Xf getDynamicPointsHost();
 
   /// @brief Gets the 3D points detected as dynamics on the last depth frame.
+  /// Waits for the outputs of the last detection.
   /// @return The dynamic points as a pointcloud object on device.
   const Pointcloud& getDynamicPointcloudDevice();
 
   /// @brief Gets the dynamic mask of the last depth frame (dynamics labelled as
-  /// 1, static pixels as 0).
+  /// 1, static pixels as 0). Does not wait for the detection, see
+  /// waitForOutputs() and synchronizeOutputs().
   /// @return The dynamic mask image.
   const MonoImage& getDynamicMaskImage() const;
 
   /// @brief Gets the dynamic overlay image of the last depth frame (dynamics
-  /// marked in red color).
+  /// marked in red color). Does not wait for the detection, see
+  /// waitForOutputs() and synchronizeOutputs().
   /// @return The dynamic overlay image.
   const ColorImage& getDynamicOverlayImage() const;
 
@@ -73,8 +102,12 @@ class DynamicsDetection {
   unified_ptr<int> dynamic_points_counter_host_;
   unified_ptr<int> dynamic_points_counter_device_;
   host_vector<Vector3f> dynamic_points_host_;
-  device_vector<Vector3f> dynamic_points_device_;
-  Pointcloud dynamic_pointcloud_device_;
+  Pointcloud dynamic_pointcloud_device_{MemoryType::kDevice};
+
+  // Recorded after the outputs of the last detection were written.
+  CudaEvent outputs_ready_event_;
+  // Whether the pointcloud was resized to the detected points.
+  bool outputs_synchronized_ = true;
 
   // CUDA stream to process dynamics detection on
   std::shared_ptr<CudaStream> cuda_stream_;
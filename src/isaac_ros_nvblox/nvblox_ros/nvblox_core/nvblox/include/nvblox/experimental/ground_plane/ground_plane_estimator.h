@@ -36,21 +36,36 @@ class GroundPlaneEstimator {
   /// @param cuda_stream Shared pointer to a CUDA stream for GPU operations.
   GroundPlaneEstimator(std::shared_ptr<CudaStream> cuda_stream);
 
-  /// Computes the zero-crossings in the TSDF layer, filters them based on the
-  /// specified z-height range, and attempts to fit a plane using the RANSAC
-  /// method.
+  /// Computes the zero-crossings in the TSDF layer within the specified
+  /// z-height range, and attempts to fit a plane using the RANSAC method.
+  /// The whole computation stays on the GPU. RANSAC is warm-started from the
+  /// previously estimated plane, if any. This (re)builds the cache of
+  /// zero-crossings from all blocks of the layer.
   /// If unsuccesfull, resets internal members and returns std::nullopt.
   /// @param tsdf_layer The TSDF layer used for zero-crossings extraction.
   /// @return std::optional<Plane> The estimated ground plane if successful,
   /// std::nullopt otherwise.
   std::optional<Plane> computeGroundPlane(const TsdfLayer& tsdf_layer);
 
-  /// @brief Gets the TSDF zero-crossing points.
-  std::optional<std::vector<Vector3f>> tsdf_zero_crossings() const;
-  /// @brief Gets the filtered (based on min/max z height)
-  /// TSDF zero-crossing points.
-  std::optional<std::vector<Vector3f>> tsdf_zero_crossings_ground_candidates()
-      const;
+  /// Same as above, but only recomputes the cached zero-crossings of the
+  /// blocks which were updated (or removed) since the last call such that
+  /// the cost is proportional to the change of the map. Falls back to
+  /// computeGroundPlane() on the whole layer if the cache was not built yet.
+  /// @param tsdf_layer The TSDF layer used for zero-crossings extraction.
+  /// @param updated_blocks The blocks updated or removed since the last call.
+  /// @return std::optional<Plane> The estimated ground plane if successful,
+  /// std::nullopt otherwise.
+  std::optional<Plane> computeGroundPlane(
+      const TsdfLayer& tsdf_layer, const std::vector<Index3D>& updated_blocks);
+
+  /// @brief Invalidates the cache of zero-crossings, such that the next
+  /// incremental computeGroundPlane() call processes the whole layer. Call
+  /// this when the blocks updated since the last call are unknown.
+  void resetCache();
+
+  /// @brief Gets the TSDF zero-crossing points within the min/max z height
+  /// that the last plane was fitted to (on the device).
+  const Pointcloud& tsdf_zero_crossings_ground_candidates() const;
   /// @brief Gets the estimated ground plane.
   std::optional<Plane> ground_plane() const;
 
@@ -77,10 +92,13 @@ class GroundPlaneEstimator {
       const std::string& name_remap = std::string()) const;
 
  private:
-  /// @brief Resets the internal optional members by setting them to
-  /// `std::nullopt`.
+  /// @brief Resets the internal members.
   void resetInternal();
 
+  /// @brief Fits the plane to the cached crossings within the z-height range
+  /// and stores the result.
+  std::optional<Plane> fitToCachedCrossings();
+
   /// @brief Extractor for TSDF zero-crossings
   TsdfZeroCrossingsExtractor tsdf_zero_crossings_extractor_;
   /// @brief RANSAC-based plane fitter used to estimate the ground plane.
@@ -88,14 +106,12 @@ class GroundPlaneEstimator {
   /// @brief Shared pointer to a CUDA stream used for GPU operations.
   std::shared_ptr<CudaStream> cuda_stream_;
 
-  /// @brief Holds the found tsdf zero crossings if succesfull.
-  std::optional<std::vector<Vector3f>> tsdf_zero_crossings_;
-  /// @brief Represents the filtered TSDF zero-crossing candidates
-  /// that are within the specified z-height range, if they exist.
-  std::optional<std::vector<Vector3f>> tsdf_zero_crossings_ground_candidates_;
-  /// @brief Pointcloud object of the filtered TSDF zero-crossing
-  /// candidates that are within the specified z-height range, if they exist.
-  Pointcloud tsdf_zero_crossings_ground_candidates_point_cloud_;
+  /// @brief Pointcloud object of the TSDF zero-crossing candidates that are
+  /// within the specified z-height range.
+  Pointcloud tsdf_zero_crossings_ground_candidates_{MemoryType::kDevice};
+
+  /// @brief Whether the zero-crossings cache of the extractor was built.
+  bool is_cache_initialized_ = false;
 
   /// @brief The most recently estimated ground plane, if one exists.
   std::optional<Plane> ground_plane_;
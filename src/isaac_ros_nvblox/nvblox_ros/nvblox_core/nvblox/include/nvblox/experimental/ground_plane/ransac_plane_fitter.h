@@ -37,8 +37,13 @@ class RansacPlaneFitter {
   /// @brief Fits a plane to a given point cloud.
   /// @param point_cloud The input vector of 3D points to which the plane is to
   /// be fitted.
+  /// @param initial_plane Optional plane to warm-start from, e.g. the plane
+  /// fitted in the previous frame. It is evaluated as one of the hypotheses,
+  /// such that it is kept unless a sampled plane fits the points better.
   /// @return The best-fitting plane if found, otherwise std::nullopt.
-  std::optional<Plane> fit(const Pointcloud& point_cloud);
+  std::optional<Plane> fit(
+      const Pointcloud& point_cloud,
+      const std::optional<Plane>& initial_plane = std::nullopt);
 
   /// A parameter setter
   /// @param ransac_distance_threshold the maximum distance a point
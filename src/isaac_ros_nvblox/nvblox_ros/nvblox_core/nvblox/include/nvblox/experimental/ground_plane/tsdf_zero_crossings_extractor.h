@@ -17,9 +17,11 @@ limitations under the License.
 
 #include <vector>
 
+#include "nvblox/core/hash.h"
 #include "nvblox/core/indexing.h"
 #include "nvblox/core/types.h"
 #include "nvblox/map/common_names.h"
+#include "nvblox/sensors/pointcloud.h"
 #include "nvblox/utils/timing.h"
 
 namespace nvblox {
@@ -38,6 +40,46 @@ class TsdfZeroCrossingsExtractor {
   std::optional<std::vector<Vector3f>> computeZeroCrossingsFromAboveOnGPU(
       const TsdfLayer& tsdf_layer);
 
+  /// @brief Computes the zero-crossings of a subset of blocks of the TSDF
+  /// layer in a height range, using the GPU. The crossings stay on the device.
+  /// @param tsdf_layer The input TSDF layer.
+  /// @param block_indices The (allocated) blocks to compute the crossings of.
+  /// @param min_z Only crossings at or above this height are returned.
+  /// @param max_z Only crossings at or below this height are returned.
+  /// @param p_L_crossings Output pointcloud of the crossings from positive to
+  /// negative.
+  /// @return False if the maximum buffer limit was reached.
+  bool computeZeroCrossingsFromAboveOnGPU(
+      const TsdfLayer& tsdf_layer, const std::vector<Index3D>& block_indices,
+      float min_z, float max_z, Pointcloud* p_L_crossings);
+
+  /// @brief Updates the persistent cache of zero crossings for the blocks
+  /// that changed since the last update. The cache holds the topmost
+  /// crossing from positive to negative of each voxel column of each block,
+  /// for the blocks that contain crossings. The crossings of a block also
+  /// depend on the block above, so the blocks below the updated ones are
+  /// updated as well. Blocks which were deallocated are evicted.
+  /// @param tsdf_layer The input TSDF layer.
+  /// @param updated_blocks The blocks updated (or removed) since the last
+  /// call.
+  void updateZeroCrossingsCacheOnGPU(
+      const TsdfLayer& tsdf_layer, const std::vector<Index3D>& updated_blocks);
+
+  /// @brief Gets the cached zero crossings in a height range. The crossings
+  /// stay on the device.
+  /// @param min_z Only crossings at or above this height are returned.
+  /// @param max_z Only crossings at or below this height are returned.
+  /// @param p_L_crossings Output pointcloud of the crossings.
+  /// @return False if the maximum buffer limit was reached.
+  bool getCachedZeroCrossingsOnGPU(float min_z, float max_z,
+                                   Pointcloud* p_L_crossings);
+
+  /// @brief Clears the cache of zero crossings.
+  void clearZeroCrossingsCache();
+
+  /// @brief The number of blocks with crossings in the cache.
+  int numCachedBlocks() const { return cache_slot_of_block_.size(); }
+
   /// @brief Set the minimum weight to consider a tsdf voxel for computation.
   void min_tsdf_weight(float min_tsdf_weight);
   /// @brief Get the minimum weight to consider a tsdf voxel for computation.
@@ -57,6 +99,13 @@ class TsdfZeroCrossingsExtractor {
   /// @brief Resets and allocates buffers
   void resetAndAllocateCrossingBuffers();
 
+  /// @brief Runs the crossings kernel on the blocks, writing up to
+  /// max_crossings_ crossings to p_L_crossings.
+  /// @return The number of crossings, or -1 if the maximum was reached.
+  int computeZeroCrossingsOfBlocksOnGPU(
+      const TsdfLayer& tsdf_layer, const std::vector<Index3D>& block_indices,
+      float min_z, float max_z, Vector3f* p_L_crossings);
+
   // Buffer counters for the tsdf crossings.
   unified_ptr<int> p_L_crossings_count_device_;
   unified_ptr<int> p_L_crossings_count_host_;
@@ -70,6 +119,19 @@ class TsdfZeroCrossingsExtractor {
   device_vector<const TsdfBlock*> block_ptrs_above_device_;
   device_vector<Index3D> block_indices_device_;
 
+  // The cache of crossings. Each cached block owns a slot of
+  // kVoxelsPerSide^2 columns in cached_crossings_device_. Columns without a
+  // crossing (and free slots) hold NaNs.
+  device_vector<Vector3f> cached_crossings_device_;
+  Index3DHashMapType<int>::type cache_slot_of_block_;
+  std::vector<int> free_cache_slots_;
+  int num_cache_slots_ = 0;
+
+  // Buffers for updating the cache.
+  device_vector<int> cache_slots_device_;
+  device_vector<int> cache_num_crossings_device_;
+  host_vector<int> cache_num_crossings_host_;
+
   // Maximum number of crossings to store. The internal buffer holding the zero
   // crossings is initialized to this size. If the maximum is reached, no more
   // crossings will be added.
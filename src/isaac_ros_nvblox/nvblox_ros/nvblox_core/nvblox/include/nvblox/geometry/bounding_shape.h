@@ -78,6 +78,10 @@ class BoundingShape {
   /// @return Whether the bounding shape touches the block.
   bool touchesBlock(const Index3D& block_index, const float block_size) const;
 
+  /// @brief The axis aligned bounding box of the shape.
+  /// @return The bounding box.
+  AxisAlignedBoundingBox boundingBox() const;
+
  private:
   /// The type of the shape.
   ShapeType type_;
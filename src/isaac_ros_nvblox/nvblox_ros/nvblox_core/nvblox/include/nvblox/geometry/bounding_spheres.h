@@ -15,7 +15,9 @@ limitations under the License.
 */
 #pragma once
 
+#include "nvblox/core/cuda_stream.h"
 #include "nvblox/core/types.h"
+#include "nvblox/core/unified_vector.h"
 
 namespace nvblox {
 
@@ -83,6 +85,21 @@ std::vector<Index3D> getBlocksOutsideRadius(
     const std::vector<Index3D>& input_blocks, float block_size,
     const Vector3f& center, float radius);
 
+/// Flag the blocks that are fully outside a radius around the center, see
+/// isBlockOutsideRadius(). The blocks are tested in a kernel, for long lists
+/// of blocks such as all blocks of a layer (see
+/// BlockLayer::getAllBlockIndicesOnGpu()).
+/// @param blocks The (device) block indices to test.
+/// @param block_size Metric size of the block.
+/// @param center The center from which we measure the radius.
+/// @param radius The radius in meters.
+/// @param is_outside_radius Output (device) flags, one per block.
+/// @param cuda_stream The stream on which to test the blocks.
+void flagBlocksOutsideRadiusOnGpuAsync(
+    const device_vector<Index3D>& blocks, float block_size,
+    const Vector3f& center, float radius,
+    device_vector<bool>* is_outside_radius, const CudaStream& cuda_stream);
+
 /// Get all of the blocks that are within a radius around the
 /// AABB.
 /// @param input_blocks The selection of blocks that should be tested.
@@ -0,0 +1,91 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "nvblox/core/cuda_stream.h"
+#include "nvblox/core/types.h"
+#include "nvblox/core/unified_vector.h"
+#include "nvblox/map/common_names.h"
+
+namespace nvblox {
+
+/// A capsule: all points within radius of the segment from start to end.
+/// A sphere is a capsule with start == end.
+struct CollisionCapsule {
+  CollisionCapsule() = default;
+  /// Sphere constructor
+  CollisionCapsule(const Vector3f& center, float _radius)
+      : start(center), end(center), radius(_radius) {}
+  /// Capsule constructor
+  CollisionCapsule(const Vector3f& _start, const Vector3f& _end, float _radius)
+      : start(_start), end(_end), radius(_radius) {}
+
+  Vector3f start = Vector3f::Zero();
+  Vector3f end = Vector3f::Zero();
+  float radius = 0.0f;
+};
+
+/// Evaluates batches of spheres/capsules against an ESDF on the GPU.
+/// For each primitive the minimum clearance is computed, i.e. the distance
+/// from the primitive's surface to the closest obstacle. A negative clearance
+/// means the primitive is in collision.
+class EsdfCollisionChecker {
+ public:
+  EsdfCollisionChecker();
+  EsdfCollisionChecker(std::shared_ptr<CudaStream> cuda_stream);
+  ~EsdfCollisionChecker() = default;
+
+  /// Compute the minimum clearance per primitive.
+  /// Capsules are evaluated at samples along their axis, spaced by a voxel.
+  /// Samples that fall into unobserved space get unobserved_distance_m().
+  /// @param capsules The primitives to check (in the layer frame).
+  /// @param esdf_layer The ESDF to check against.
+  /// @param clearances_m_ptr The minimum clearance per primitive, in meters.
+  void computeClearances(const std::vector<CollisionCapsule>& capsules,
+                         const EsdfLayer& esdf_layer,
+                         std::vector<float>* clearances_m_ptr);
+
+  /// See computeClearances(). Inputs and outputs stay on the GPU and the
+  /// stream is not synchronized.
+  void computeClearancesAsync(const device_vector<CollisionCapsule>& capsules,
+                              const EsdfLayer& esdf_layer,
+                              device_vector<float>* clearances_m_ptr);
+
+  /// A parameter getter
+  /// The distance assumed at samples in unobserved (or unallocated) space.
+  /// The default (0) treats unobserved space as occupied.
+  /// @returns the distance in meters.
+  float unobserved_distance_m() const;
+
+  /// A parameter setter
+  /// See unobserved_distance_m().
+  /// @param unobserved_distance_m the distance in meters.
+  void unobserved_distance_m(float unobserved_distance_m);
+
+ protected:
+  float unobserved_distance_m_ = 0.0f;
+
+  // Staging buffers
+  device_vector<CollisionCapsule> capsules_device_;
+  device_vector<float> clearances_device_;
+
+  std::shared_ptr<CudaStream> cuda_stream_;
+};
+
+}  // namespace nvblox
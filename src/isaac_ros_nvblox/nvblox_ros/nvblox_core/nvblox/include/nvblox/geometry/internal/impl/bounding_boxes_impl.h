@@ -69,7 +69,7 @@ template <typename BlockType>
 std::vector<Index3D> getAllocatedBlocksWithinAABB(
     const BlockLayer<BlockType>& layer, const AxisAlignedBoundingBox& aabb) {
   std::vector<Index3D> allocated_blocks;
-  for (const Index3D& idx : layer.getAllBlockIndices()) {
+  for (const Index3D& idx : layer.getAllBlockIndicesCached()) {
     if (isBlockTouchedByBoundingBox(idx, layer.block_size(), aabb)) {
       allocated_blocks.push_back(idx);
     }
@@ -15,6 +15,8 @@ limitations under the License.
 */
 #pragma once
 
+#include <optional>
+
 #include "nvblox/core/types.h"
 
 namespace nvblox {
@@ -70,6 +72,21 @@ bool applyWorkspaceBounds(const AxisAlignedBoundingBox& input_aabb,
                           const float workspace_bounds_max_height,
                           AxisAlignedBoundingBox* output_aabb);
 
+/// @brief Get the maximum number of blocks that can be allocated within the
+/// workspace bounds, e.g. to preallocate layers.
+/// @param bounds_type The type of workspace bounds.
+/// @param workspace_bounds_min_corner The minimal corner of the workspace
+/// bounds.
+/// @param workspace_bounds_max_corner  The maximal corner of the workspace
+/// bounds.
+/// @param block_size The metric size of a block.
+/// @return The number of blocks touched by the workspace bounding box, or
+/// std::nullopt if the workspace is not bounded in all directions.
+std::optional<size_t> getMaxNumBlocksInWorkspace(
+    const WorkspaceBoundsType bounds_type,
+    const Vector3f& workspace_bounds_min_corner,
+    const Vector3f& workspace_bounds_max_corner, const float block_size);
+
 inline std::ostream& operator<<(std::ostream& os,
                                 const WorkspaceBoundsType& bounds_type) {
   switch (bounds_type) {
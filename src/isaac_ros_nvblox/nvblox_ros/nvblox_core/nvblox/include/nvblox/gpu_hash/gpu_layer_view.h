@@ -16,13 +16,18 @@ limitations under the License.
 #pragma once
 
 #include <thrust/pair.h>
+#include <array>
+#include <cstdint>
+#include <deque>
 #include <memory>
 
 #include "nvblox/core/types.h"
 
 #include <thrust/pair.h>
 
+#include "nvblox/core/cuda_event.h"
 #include "nvblox/core/cuda_stream.h"
+#include "nvblox/core/memory_usage.h"
 #include "nvblox/core/unified_vector.h"
 
 namespace nvblox {
@@ -36,6 +41,61 @@ class GPUHashImpl;
 template <typename BlockType>
 class BlockLayer;
 
+/// Health statistics of a GPULayerView, accumulated since its construction
+/// or the last reset(). See GPULayerView::statistics().
+struct GPUHashStatistics {
+  /// The number of bins of the probe length histogram.
+  static constexpr int kNumProbeLengthBins = 8;
+  /// The number of load factors kept in load_factor_history.
+  static constexpr int kLoadFactorHistoryLength = 64;
+
+  /// Blocks inserted (through the cache or on the device) and removed.
+  uint64_t num_inserted_blocks = 0;
+  uint64_t num_removed_blocks = 0;
+  /// Flushes of a non-empty insertion or removal cache.
+  uint64_t num_flushes = 0;
+
+  /// Rehashes into a larger hash which block the caller (when a flush or
+  /// reservation doesn't fit), and those started in the background.
+  uint64_t num_synchronous_rehashes = 0;
+  uint64_t num_staged_rehashes = 0;
+  /// Host time blocked by rehashes: the synchronous rehashes and the waits
+  /// for a background rehash to complete.
+  double total_rehash_seconds = 0.0;
+  double max_rehash_seconds = 0.0;
+
+  /// The load factor after each insertion flush, oldest first.
+  std::deque<float> load_factor_history;
+  /// The highest load factor after any insertion flush.
+  float peak_load_factor = 0.0f;
+
+  /// Sampled probe lengths, see GPULayerView::sampleProbeLengths(). The probe
+  /// length of an entry is the number of entries in its bucket, i.e. an upper
+  /// bound on the lookups it takes to find it. Bin i counts probe lengths of
+  /// i + 1; the last bin also counts all longer ones.
+  std::array<uint64_t, kNumProbeLengthBins> probe_length_histogram{};
+
+  /// The number of entries in probe_length_histogram.
+  uint64_t numProbeLengthSamples() const {
+    uint64_t num_samples = 0;
+    for (const uint64_t count : probe_length_histogram) {
+      num_samples += count;
+    }
+    return num_samples;
+  }
+
+  /// The mean sampled probe length (lengths beyond the last bin count as the
+  /// last bin). Zero if nothing was sampled.
+  float meanProbeLength() const {
+    uint64_t sum = 0;
+    for (int i = 0; i < kNumProbeLengthBins; ++i) {
+      sum += (i + 1) * probe_length_histogram[i];
+    }
+    const uint64_t num_samples = numProbeLengthSamples();
+    return num_samples > 0 ? static_cast<float>(sum) / num_samples : 0.0f;
+  }
+};
+
 /// Class that manages a GPU hash
 ///
 /// Insertion and removal operations are cached on the CPU and consolidated into
@@ -85,6 +145,27 @@ class GPULayerView {
 
   /// Get the Gpu hash.
   const GPUHashImpl<BlockType>& getHash() const { return *gpu_hash_ptr_; }
+  GPUHashImpl<BlockType>& getHash() { return *gpu_hash_ptr_; }
+
+  /// Make sure that the hash can hold a number of additional blocks inserted
+  /// on the device (i.e. not through insertBlocksAsync()) without exceeding
+  /// max_load_factor(). The caches must be flushed.
+  /// @param num_additional_blocks The maximum number of blocks to be inserted.
+  /// @param cuda_stream Stream used if the hash needs to grow.
+  void reserveForDeviceInsertion(size_t num_additional_blocks,
+                                 const CudaStream& cuda_stream);
+
+  /// Grow the hash such that it can hold a number of blocks without any further
+  /// (staged or synchronous) growth, i.e. without exceeding
+  /// staged_growth_load_factor(). Does nothing if the hash is large enough
+  /// already.
+  /// @param num_blocks The total number of blocks to make space for.
+  /// @param cuda_stream Stream used if the hash needs to grow.
+  void reserve(size_t num_blocks, const CudaStream& cuda_stream);
+
+  /// Account for blocks that were inserted into the hash on the device.
+  /// @param num_inserted_blocks The number of blocks inserted.
+  void addDeviceInsertions(size_t num_inserted_blocks);
 
   /// Number of elements inside the hash
   size_t size() const;
@@ -92,12 +173,26 @@ class GPULayerView {
   /// Max number of blocks the cache can hold
   size_t capacity() const;
 
+  /// The (device) memory held by the hash, including a hash being grown in
+  /// the background. The size of the hash's bookkeeping structures is
+  /// estimated.
+  MemoryUsage memoryUsage() const;
+
   /// Max allowed load factor (size/capacity)
   float max_load_factor() const { return max_load_factor_; }
 
   /// When resizing the hash, it will be expanded with this amount
   float size_expansion_factor() const { return size_expansion_factor_; }
 
+  /// Load factor at which growth of the hash is started in the background.
+  /// See \ref startStagedGrowth.
+  float staged_growth_load_factor() const {
+    return staged_growth_load_factor_;
+  }
+
+  /// Whether a (background) growth of the hash is currently in flight.
+  bool isGrowing() const { return staged_gpu_hash_ptr_ != nullptr; }
+
   /// Flush the internal cache. This will execute any pending insertion or
   /// removal operations.
   void flushCache(const CudaStream& cuda_stream);
@@ -108,6 +203,23 @@ class GPULayerView {
   /// Check if the internal gpu hash is valid
   bool isValid(const CudaStream& cuda_stream) const;
 
+  /// Health statistics of the hash. The synchronous rehashes are also timed
+  /// under "gpu_hash/rehash" in timing::Timing.
+  const GPUHashStatistics& statistics() const { return statistics_; }
+
+  /// Sample the probe lengths of the entries into
+  /// statistics().probe_length_histogram (replacing the last sample). This
+  /// synchronizes the stream. The caches must be flushed.
+  /// @param cuda_stream Stream for the GPU work.
+  void sampleProbeLengths(const CudaStream& cuda_stream);
+
+  /// The probe lengths are sampled every this many insertion flushes. Zero
+  /// disables the sampling.
+  int probe_length_sampling_period() const {
+    return probe_length_sampling_period_;
+  }
+  void probe_length_sampling_period(int probe_length_sampling_period);
+
  private:
   // Apply cached insertion operations.
   void flushInsertionCache(const CudaStream& cuda_stream);
@@ -115,6 +227,25 @@ class GPULayerView {
   // Apply cached removal operations.
   void flushRemovalCache(const CudaStream& cuda_stream);
 
+  // Start growing the hash in the background. A larger hash is allocated and
+  // the current entries are copied into it on growth_stream_, overlapping with
+  // whatever work is done on the GPU until the hash is next modified. Lookups
+  // use the current hash in the meantime. The copy is ordered after the work
+  // queued on cuda_stream, which last modified the hash.
+  void startStagedGrowth(const CudaStream& cuda_stream);
+
+  // Complete the staged growth (if any) by swapping in the larger hash. Must be
+  // called before the current hash is modified.
+  void finishStagedGrowth();
+
+  // Synchronously grow the hash if num_blocks don't fit within
+  // max_load_factor_.
+  void growToFit(size_t num_blocks, const CudaStream& cuda_stream);
+
+  // Synchronously replace the hash by one of the passed capacity, holding the
+  // same entries.
+  void growTo(size_t new_max_num_blocks, const CudaStream& cuda_stream);
+
   // The load factor at which we reallocate space. Load factors of above 0.5
   // seem to cause the hash table to overfill in some cases, so please use
   // max loads lower than that.
@@ -123,10 +254,23 @@ class GPULayerView {
   // This is the factor by which we overallocate space
   const float size_expansion_factor_ = 2.0f;
 
+  // The load factor at which we start growing the hash in the background.
+  // Chosen such that growth usually completes before max_load_factor_ is hit,
+  // in which case the hash is grown synchronously.
+  const float staged_growth_load_factor_ = 0.375;
+
   // NOTE(alexmillane): To keep GPU code out of the header we use PIMPL to hide
   // the details of the GPU hash.
   std::shared_ptr<GPUHashImpl<BlockType>> gpu_hash_ptr_ = nullptr;
 
+  // The larger hash being populated during a staged growth, and the stream on
+  // which it is populated.
+  std::shared_ptr<GPUHashImpl<BlockType>> staged_gpu_hash_ptr_ = nullptr;
+  std::shared_ptr<CudaStream> growth_stream_ = nullptr;
+  // Recorded on the caller's stream when a staged growth starts, such that
+  // growth_stream_ only reads the hash after its last modification.
+  CudaEvent growth_start_event_;
+
   // Used for staging when transferring the gpu hash
   device_vector<thrust::pair<Index3D, BlockType*>> blocks_to_insert_device_;
   device_vector<Index3D> blocks_to_remove_device_;
@@ -138,6 +282,18 @@ class GPULayerView {
 
   // Size of GPU hash, taking insertion and removal cache into account.
   size_t size_including_cache_ = 0;
+
+  // Health statistics, reset by reset().
+  GPUHashStatistics statistics_;
+
+  // Default chosen such that the sampling (a pass over the hash, and a
+  // synchronization) is negligible next to the flushes.
+  static constexpr int kDefaultProbeLengthSamplingPeriod = 100;
+  int probe_length_sampling_period_ = kDefaultProbeLengthSamplingPeriod;
+  int num_insertion_flushes_since_probe_sample_ = 0;
+
+  // Record the host time blocked by a rehash.
+  void addRehashTime(double seconds);
 };
 
 }  // namespace nvblox
@@ -0,0 +1,97 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#pragma once
+
+#include "nvblox/core/cuda_stream.h"
+#include "nvblox/core/internal/error_check.h"
+#include "nvblox/core/types.h"
+#include "nvblox/core/unified_vector.h"
+#include "nvblox/gpu_hash/internal/cuda/gpu_hash_interface.cuh"
+
+namespace nvblox {
+
+/// The 3x3x3 blocks around (and including) a block, indexed by their offset
+/// in [-1, 1]^3 from the block, with x varying fastest.
+struct FullBlockNeighborhood {
+  static constexpr int kNumNeighbors = 27;
+  /// The index of the block itself.
+  static constexpr int kCenterIndex = 13;
+
+  __host__ __device__ static bool isInNeighborhood(const Index3D& offset) {
+    return offset.x() >= -1 && offset.x() <= 1 && offset.y() >= -1 &&
+           offset.y() <= 1 && offset.z() >= -1 && offset.z() <= 1;
+  }
+  __host__ __device__ static int indexFromOffset(const Index3D& offset) {
+    return (offset.x() + 1) + 3 * ((offset.y() + 1) + 3 * (offset.z() + 1));
+  }
+  __host__ __device__ static Index3D offsetFromIndex(const int index) {
+    return Index3D(index % 3 - 1, (index / 3) % 3 - 1, index / 9 - 1);
+  }
+};
+
+/// Looks up the neighbors of each block in the GPU hash, one thread per
+/// neighbor. Missing neighbors are null.
+/// @tparam NeighborhoodType Defines the neighbors, see FullBlockNeighborhood.
+template <typename BlockType, typename NeighborhoodType>
+__global__ void buildBlockNeighborTableKernel(
+    const int num_blocks, const Index3D* block_indices,
+    const Index3DDeviceHashMapType<BlockType> block_hash,
+    const BlockType** neighbor_table) {
+  constexpr int kNumNeighbors = NeighborhoodType::kNumNeighbors;
+  const int entry_idx = blockIdx.x * blockDim.x + threadIdx.x;
+  if (entry_idx >= num_blocks * kNumNeighbors) {
+    return;
+  }
+  const Index3D neighbor_index =
+      block_indices[entry_idx / kNumNeighbors] +
+      NeighborhoodType::offsetFromIndex(entry_idx % kNumNeighbors);
+  const auto it = block_hash.find(neighbor_index);
+  neighbor_table[entry_idx] = (it != block_hash.end()) ? it->second : nullptr;
+}
+
+/// Builds a table of the pointers to the neighbors of each block, once per
+/// pass over the blocks. Kernels index the table with
+/// block_idx * NeighborhoodType::kNumNeighbors + neighbor_idx, such that
+/// looking up a neighbor is a load rather than a hash probe.
+/// @tparam NeighborhoodType Defines the neighbors, see FullBlockNeighborhood.
+/// @param num_blocks The number of blocks.
+/// @param block_indices_device The indices of the blocks (on the device).
+/// @param block_hash The GPU hash of the layer.
+/// @param neighbor_table The output table.
+/// @param cuda_stream The stream to build the table on.
+template <typename NeighborhoodType = FullBlockNeighborhood,
+          typename BlockType>
+void buildBlockNeighborTableAsync(
+    const int num_blocks, const Index3D* block_indices_device,
+    const Index3DDeviceHashMapType<BlockType>& block_hash,
+    device_vector<const BlockType*>* neighbor_table,
+    const CudaStream& cuda_stream) {
+  CHECK_NOTNULL(neighbor_table);
+  const int num_entries = num_blocks * NeighborhoodType::kNumNeighbors;
+  neighbor_table->resizeAsync(num_entries, cuda_stream);
+  if (num_entries == 0) {
+    return;
+  }
+  constexpr int kNumThreads = 512;
+  const int num_thread_blocks = num_entries / kNumThreads + 1;
+  buildBlockNeighborTableKernel<BlockType, NeighborhoodType>
+      <<<num_thread_blocks, kNumThreads, 0, cuda_stream>>>(
+          num_blocks, block_indices_device, block_hash,
+          neighbor_table->data());
+  checkCudaErrors(cudaPeekAtLastError());
+}
+
+}  // namespace nvblox
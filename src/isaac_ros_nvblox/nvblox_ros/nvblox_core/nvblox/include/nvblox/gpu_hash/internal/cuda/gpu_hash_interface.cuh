@@ -19,6 +19,8 @@ limitations under the License.
 #include <thrust/host_vector.h>
 #include <thrust/pair.h>
 
+#include <vector>
+
 #include <stdgpu/cstddef.h>
 #include <stdgpu/unordered_map.cuh>
 
@@ -26,6 +28,7 @@ limitations under the License.
 #include "nvblox/core/hash.h"
 #include "nvblox/core/internal/error_check.h"
 #include "nvblox/core/types.h"
+#include "nvblox/core/unified_vector.h"
 #include "nvblox/utils/logging.h"
 
 namespace nvblox {
@@ -61,6 +64,28 @@ class GPUHashImpl {
   void initializeFromAsync(const GPUHashImpl<BlockType>& other,
                            const CudaStream& cuda_stream);
 
+  /// Insert everything from other without waiting for the insertion to
+  /// finish. Same requirements as initializeFromAsync(). The caller is
+  /// responsible for synchronizing cuda_stream before accessing either hash
+  /// from another stream, or modifying other.
+  ///
+  /// @param other       Gpu hash to insert from
+  /// @pram cuda_stream  Cuda stream for GPU work
+  void insertAllFromAsync(const GPUHashImpl<BlockType>& other,
+                          const CudaStream& cuda_stream);
+
+  /// Histogram the probe lengths, i.e. the number of entries sharing a
+  /// bucket, of the entries in every sample_stride-th slot. Bin i counts
+  /// probe lengths of i + 1; the last bin also counts all longer ones.
+  /// Synchronizes the stream.
+  ///
+  /// @param sample_stride  Stride between the sampled slots
+  /// @param num_bins       Number of bins of the histogram
+  /// @param cuda_stream    Cuda stream for GPU work
+  /// @return The histogram
+  std::vector<uint64_t> probeLengthHistogram(
+      int sample_stride, int num_bins, const CudaStream& cuda_stream) const;
+
   ///  Copy of impl_.bucket_size() to avoid costly device-to-host mem
   /// transfer
   stdgpu::index_t max_num_blocks_;
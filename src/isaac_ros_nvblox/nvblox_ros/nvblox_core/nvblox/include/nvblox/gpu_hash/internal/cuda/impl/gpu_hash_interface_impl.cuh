@@ -54,9 +54,79 @@ __global__ void setToZero(Index3DDeviceHashMapType<BlockType> block_hash) {
   }
 }
 
+// Kernel counting the entries hashed into each bucket.
+// Number of threads needed: block_hash.max_size()
+template <typename BlockType>
+__global__ void countEntriesPerBucketKernel(
+    Index3DDeviceHashMapType<BlockType> block_hash, int* bucket_counts) {
+  int idx = threadIdx.x + blockIdx.x * blockDim.x;
+  // See insertAllKernel() for why we look at the occupied flags.
+  if (idx < block_hash.max_size() && block_hash.occupied(idx)) {
+    const Index3D& block_idx = (block_hash.begin() + idx)->first;
+    atomicAdd(&bucket_counts[block_hash.bucket(block_idx)], 1);
+  }
+}
+
+// Kernel binning the bucket sizes of the entries in every sample_stride-th
+// slot.
+// Number of threads needed: block_hash.max_size() / sample_stride
+template <typename BlockType>
+__global__ void binProbeLengthsKernel(
+    Index3DDeviceHashMapType<BlockType> block_hash,
+    const int* bucket_counts, int sample_stride, int num_bins,
+    unsigned long long* histogram) {
+  const int idx = (threadIdx.x + blockIdx.x * blockDim.x) * sample_stride;
+  if (idx < block_hash.max_size() && block_hash.occupied(idx)) {
+    const Index3D& block_idx = (block_hash.begin() + idx)->first;
+    const int probe_length = bucket_counts[block_hash.bucket(block_idx)];
+    const int bin = min(probe_length, num_bins) - 1;
+    atomicAdd(&histogram[bin], 1ull);
+  }
+}
+
+template <typename BlockType>
+std::vector<uint64_t> GPUHashImpl<BlockType>::probeLengthHistogram(
+    int sample_stride, int num_bins, const CudaStream& cuda_stream) const {
+  CHECK_GT(sample_stride, 0);
+  CHECK_GT(num_bins, 0);
+  device_vector<int> bucket_counts(impl_.bucket_count());
+  bucket_counts.setZeroAsync(cuda_stream);
+  device_vector<unsigned long long> histogram(num_bins);
+  histogram.setZeroAsync(cuda_stream);
+
+  constexpr int kNumThreadsPerBlock = 512;
+  const int num_count_blocks = impl_.max_size() / kNumThreadsPerBlock + 1;
+  countEntriesPerBucketKernel<<<num_count_blocks, kNumThreadsPerBlock, 0,
+                                cuda_stream>>>(impl_, bucket_counts.data());
+  checkCudaErrors(cudaPeekAtLastError());
+  const int num_samples = impl_.max_size() / sample_stride + 1;
+  const int num_bin_blocks = num_samples / kNumThreadsPerBlock + 1;
+  binProbeLengthsKernel<<<num_bin_blocks, kNumThreadsPerBlock, 0,
+                          cuda_stream>>>(impl_, bucket_counts.data(),
+                                         sample_stride, num_bins,
+                                         histogram.data());
+  checkCudaErrors(cudaPeekAtLastError());
+
+  const std::vector<unsigned long long> histogram_host =
+      histogram.toVectorAsync(cuda_stream);
+  cuda_stream.synchronize();
+  return std::vector<uint64_t>(histogram_host.begin(), histogram_host.end());
+}
+
 template <typename BlockType>
 void GPUHashImpl<BlockType>::initializeFromAsync(
     const GPUHashImpl<BlockType>& other, const CudaStream& cuda_stream) {
+  insertAllFromAsync(other, cuda_stream);
+  cuda_stream.synchronize();
+  checkCudaErrors(cudaPeekAtLastError());
+
+  // Check that the sizes are equal after insertion
+  CHECK_EQ(impl_.size(), other.impl_.size());
+}
+
+template <typename BlockType>
+void GPUHashImpl<BlockType>::insertAllFromAsync(
+    const GPUHashImpl<BlockType>& other, const CudaStream& cuda_stream) {
   // Hash must be empty when we're initializing from another hash
   CHECK_EQ(impl_.size(), 0);
 
@@ -67,11 +137,7 @@ void GPUHashImpl<BlockType>::initializeFromAsync(
   const int num_blocks = other.impl_.max_size() / kNumThreadsPerBlock + 1;
   insertAllKernel<<<num_blocks, kNumThreadsPerBlock, 0, cuda_stream>>>(
       other.impl_, impl_);
-  cuda_stream.synchronize();
   checkCudaErrors(cudaPeekAtLastError());
-
-  // Check that the sizes are equal after insertion
-  CHECK_EQ(impl_.size(), other.impl_.size());
 }
 
 template <typename BlockType>
@@ -15,9 +15,13 @@ limitations under the License.
 */
 #pragma once
 
+#include <algorithm>
+#include <chrono>
+
 #include "nvblox/core/internal/error_check.h"
 #include "nvblox/gpu_hash/gpu_layer_view.h"
 #include "nvblox/gpu_hash/internal/cuda/gpu_hash_interface.cuh"
+#include "nvblox/utils/flight_recorder.h"
 #include "nvblox/utils/timing.h"
 
 namespace nvblox {
@@ -29,7 +33,11 @@ GPULayerView<BlockType>::GPULayerView(size_t max_num_blocks) {
 
 template <typename BlockType>
 GPULayerView<BlockType>::~GPULayerView() {
-  // The GPUHashImpl takes care of cleaning up GPU memory.
+  // The GPUHashImpl takes care of cleaning up GPU memory. We just have to make
+  // sure that a growth in flight is done with it.
+  if (isGrowing()) {
+    growth_stream_->synchronize();
+  }
 }
 
 template <typename BlockType>
@@ -90,27 +98,8 @@ void GPULayerView<BlockType>::flushInsertionCache(
   timing::Timer timer("gpu_hash/flush_insertion_cache");
   CHECK_NOTNULL(gpu_hash_ptr_);
 
-  if (loadFactor() > max_load_factor_) {
-    // Create a new hash with the required capacity
-    const size_t new_max_num_blocks = static_cast<size_t>(
-        std::ceil(size_expansion_factor_ *
-                  std::max<size_t>(size_including_cache_,
-                                   gpu_hash_ptr_->max_num_blocks_)));
-
-    LOG(INFO) << "Resizing GPU hash capacity from "
-              << gpu_hash_ptr_->max_num_blocks_ << " to " << new_max_num_blocks
-              << " in order to accomodate space for " << insertion_cache_.size()
-              << " new elements.";
-
-    auto new_gpu_hash = std::make_shared<GPUHashImpl<BlockType>>(
-        new_max_num_blocks, cuda_stream);
-
-    CHECK_GE(new_gpu_hash->max_num_blocks_, gpu_hash_ptr_->max_num_blocks_);
-
-    // Copy everything from the old hash into the new one and swap'em
-    new_gpu_hash->initializeFromAsync(*gpu_hash_ptr_, cuda_stream);
-    std::swap(gpu_hash_ptr_, new_gpu_hash);
-  }
+  finishStagedGrowth();
+  growToFit(size_including_cache_, cuda_stream);
 
   // Copy blocks from cache to device and insert them
   blocks_to_insert_device_.copyFromAsync(insertion_cache_, cuda_stream);
@@ -121,6 +110,8 @@ void GPULayerView<BlockType>::flushInsertionCache(
       stdgpu::make_device(blocks_to_insert_device_.data()),
       stdgpu::make_device(blocks_to_insert_device_.data() +
                           blocks_to_insert_device_.size()));
+  statistics_.num_inserted_blocks += insertion_cache_.size();
+  ++statistics_.num_flushes;
   insertion_cache_.clear();
   cuda_stream.synchronize();
 
@@ -129,7 +120,149 @@ void GPULayerView<BlockType>::flushInsertionCache(
   CHECK_EQ(size_including_cache_,
            static_cast<size_t>(gpu_hash_ptr_->impl_.size()));
 
-}  // namespace nvblox
+  const float load_factor = loadFactor();
+  statistics_.load_factor_history.push_back(load_factor);
+  if (statistics_.load_factor_history.size() >
+      GPUHashStatistics::kLoadFactorHistoryLength) {
+    statistics_.load_factor_history.pop_front();
+  }
+  statistics_.peak_load_factor =
+      std::max(statistics_.peak_load_factor, load_factor);
+  ++num_insertion_flushes_since_probe_sample_;
+  if (probe_length_sampling_period_ > 0 &&
+      num_insertion_flushes_since_probe_sample_ >=
+          probe_length_sampling_period_) {
+    sampleProbeLengths(cuda_stream);
+  }
+
+  // Get ahead of the next resize such that it doesn't stall a later flush.
+  if (load_factor > staged_growth_load_factor_) {
+    startStagedGrowth(cuda_stream);
+  }
+}
+
+template <typename BlockType>
+void GPULayerView<BlockType>::growToFit(size_t num_blocks,
+                                        const CudaStream& cuda_stream) {
+  if (static_cast<float>(num_blocks) / gpu_hash_ptr_->max_num_blocks_ <=
+      max_load_factor_) {
+    return;
+  }
+  // Create a new hash with the required capacity
+  const size_t new_max_num_blocks = static_cast<size_t>(std::ceil(
+      size_expansion_factor_ *
+      std::max<size_t>(num_blocks, gpu_hash_ptr_->max_num_blocks_)));
+
+  LOG(INFO) << "Resizing GPU hash capacity from "
+            << gpu_hash_ptr_->max_num_blocks_ << " to " << new_max_num_blocks
+            << " in order to accomodate space for " << num_blocks
+            << " elements.";
+  growTo(new_max_num_blocks, cuda_stream);
+}
+
+template <typename BlockType>
+void GPULayerView<BlockType>::growTo(size_t new_max_num_blocks,
+                                     const CudaStream& cuda_stream) {
+  timing::Timer timer("gpu_hash/rehash");
+  const auto start_time = std::chrono::steady_clock::now();
+  auto new_gpu_hash =
+      std::make_shared<GPUHashImpl<BlockType>>(new_max_num_blocks, cuda_stream);
+
+  CHECK_GE(new_gpu_hash->max_num_blocks_, gpu_hash_ptr_->max_num_blocks_);
+
+  // Copy everything from the old hash into the new one and swap'em
+  new_gpu_hash->initializeFromAsync(*gpu_hash_ptr_, cuda_stream);
+  std::swap(gpu_hash_ptr_, new_gpu_hash);
+
+  ++statistics_.num_synchronous_rehashes;
+  timing::FlightRecorder::recordInstant("gpu_hash/rehash", new_max_num_blocks);
+  addRehashTime(std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - start_time)
+                    .count());
+}
+
+template <typename BlockType>
+void GPULayerView<BlockType>::addRehashTime(double seconds) {
+  statistics_.total_rehash_seconds += seconds;
+  statistics_.max_rehash_seconds =
+      std::max(statistics_.max_rehash_seconds, seconds);
+}
+
+template <typename BlockType>
+void GPULayerView<BlockType>::reserveForDeviceInsertion(
+    size_t num_additional_blocks, const CudaStream& cuda_stream) {
+  CHECK(insertion_cache_.empty() && removal_cache_.empty());
+  // The device insertions modify the current hash, so any growth in flight
+  // has to be completed first.
+  finishStagedGrowth();
+  growToFit(size_including_cache_ + num_additional_blocks, cuda_stream);
+}
+
+template <typename BlockType>
+void GPULayerView<BlockType>::reserve(size_t num_blocks,
+                                      const CudaStream& cuda_stream) {
+  const size_t new_max_num_blocks = static_cast<size_t>(
+      std::ceil(static_cast<float>(num_blocks) / staged_growth_load_factor_));
+  if (new_max_num_blocks <= gpu_hash_ptr_->max_num_blocks_) {
+    return;
+  }
+  // The entries of a growth in flight are copied along from the current hash.
+  finishStagedGrowth();
+  LOG(INFO) << "Reserving GPU hash capacity of " << new_max_num_blocks
+            << " for " << num_blocks << " elements.";
+  growTo(new_max_num_blocks, cuda_stream);
+}
+
+template <typename BlockType>
+void GPULayerView<BlockType>::addDeviceInsertions(size_t num_inserted_blocks) {
+  CHECK(insertion_cache_.empty() && removal_cache_.empty());
+  size_including_cache_ += num_inserted_blocks;
+  statistics_.num_inserted_blocks += num_inserted_blocks;
+}
+
+template <typename BlockType>
+void GPULayerView<BlockType>::startStagedGrowth(
+    const CudaStream& cuda_stream) {
+  CHECK(!isGrowing());
+  timing::Timer timer("gpu_hash/start_staged_growth");
+
+  if (!growth_stream_) {
+    growth_stream_ = CudaStream::createCudaStream(CudaStreamType::kNonBlocking);
+  }
+  const size_t new_max_num_blocks = static_cast<size_t>(
+      std::ceil(size_expansion_factor_ * gpu_hash_ptr_->max_num_blocks_));
+  VLOG(3) << "Starting staged growth of GPU hash capacity from "
+          << gpu_hash_ptr_->max_num_blocks_ << " to " << new_max_num_blocks;
+
+  // The current hash is only modified after finishStagedGrowth(), so it's
+  // safe to read it on another stream once its last modification (on the
+  // caller's stream) is done.
+  growth_start_event_.record(cuda_stream);
+  growth_start_event_.streamWait(*growth_stream_);
+  staged_gpu_hash_ptr_ = std::make_shared<GPUHashImpl<BlockType>>(
+      new_max_num_blocks, *growth_stream_);
+  staged_gpu_hash_ptr_->insertAllFromAsync(*gpu_hash_ptr_, *growth_stream_);
+  ++statistics_.num_staged_rehashes;
+  timing::FlightRecorder::recordInstant("gpu_hash/staged_rehash",
+                                        new_max_num_blocks);
+}
+
+template <typename BlockType>
+void GPULayerView<BlockType>::finishStagedGrowth() {
+  if (!isGrowing()) {
+    return;
+  }
+  timing::Timer timer("gpu_hash/finish_staged_growth");
+  // Typically the copy finished long ago, so this doesn't block.
+  const auto start_time = std::chrono::steady_clock::now();
+  growth_stream_->synchronize();
+  addRehashTime(std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - start_time)
+                    .count());
+  CHECK_EQ(staged_gpu_hash_ptr_->impl_.size(), gpu_hash_ptr_->impl_.size());
+  std::swap(gpu_hash_ptr_, staged_gpu_hash_ptr_);
+  staged_gpu_hash_ptr_.reset();
+}
 
 template <typename BlockType>
 void GPULayerView<BlockType>::removeBlocksAsync(
@@ -158,6 +291,8 @@ void GPULayerView<BlockType>::flushRemovalCache(const CudaStream& cuda_stream) {
 
   timing::Timer timer("gpu_hash/flush_removal_cache");
 
+  finishStagedGrowth();
+
   CHECK_EQ(size_including_cache_,
            gpu_hash_ptr_->impl_.size() - removal_cache_.size());
   CHECK_NOTNULL(gpu_hash_ptr_);
@@ -169,6 +304,8 @@ void GPULayerView<BlockType>::flushRemovalCache(const CudaStream& cuda_stream) {
       stdgpu::make_device(blocks_to_remove_device_.data()),
       stdgpu::make_device(blocks_to_remove_device_.data() +
                           blocks_to_remove_device_.size()));
+  statistics_.num_removed_blocks += removal_cache_.size();
+  ++statistics_.num_flushes;
   removal_cache_.clear();
   cuda_stream.synchronize();
 }
@@ -178,12 +315,19 @@ void GPULayerView<BlockType>::reset(size_t new_max_num_blocks,
                                     const CudaStream& cuda_stream) {
   timing::Timer timer("gpu_hash/transfer/reset");
 
+  // Any growth in flight refers to the hash we're about to drop.
+  if (isGrowing()) {
+    growth_stream_->synchronize();
+    staged_gpu_hash_ptr_.reset();
+  }
   gpu_hash_ptr_ =
       std::make_shared<GPUHashImpl<BlockType>>(new_max_num_blocks, cuda_stream);
   gpu_hash_ptr_->impl_.clear();
   insertion_cache_.clear();
   removal_cache_.clear();
   size_including_cache_ = 0;
+  statistics_ = GPUHashStatistics();
+  num_insertion_flushes_since_probe_sample_ = 0;
 }
 
 template <typename BlockType>
@@ -196,6 +340,49 @@ size_t GPULayerView<BlockType>::capacity() const {
   return gpu_hash_ptr_->max_num_blocks_;
 }
 
+template <typename BlockType>
+MemoryUsage GPULayerView<BlockType>::memoryUsage() const {
+  // Besides the (key, value) pairs, stdgpu keeps per slot the bucket offsets,
+  // the excess list, and the occupancy and lock bits.
+  constexpr size_t kBookkeepingBytesPerSlot = 12;
+  constexpr size_t kBytesPerSlot =
+      sizeof(typename Index3DDeviceHashMapType<BlockType>::value_type) +
+      kBookkeepingBytesPerSlot;
+  MemoryUsage usage;
+  usage.allocated_bytes = capacity() * kBytesPerSlot;
+  usage.used_bytes = size() * kBytesPerSlot;
+  if (staged_gpu_hash_ptr_ != nullptr) {
+    usage.allocated_bytes += staged_gpu_hash_ptr_->max_num_blocks_ *
+                             kBytesPerSlot;
+  }
+  return usage;
+}
+
+template <typename BlockType>
+void GPULayerView<BlockType>::sampleProbeLengths(
+    const CudaStream& cuda_stream) {
+  CHECK(insertion_cache_.empty() && removal_cache_.empty());
+  timing::Timer timer("gpu_hash/sample_probe_lengths");
+  // Sample about kMaxNumSampledSlots slots. At the max load factor about half
+  // of them hold an entry.
+  constexpr int kMaxNumSampledSlots = 4096;
+  const int sample_stride =
+      std::max(1, static_cast<int>(gpu_hash_ptr_->impl_.max_size()) /
+                      kMaxNumSampledSlots);
+  const std::vector<uint64_t> histogram = gpu_hash_ptr_->probeLengthHistogram(
+      sample_stride, GPUHashStatistics::kNumProbeLengthBins, cuda_stream);
+  std::copy(histogram.begin(), histogram.end(),
+            statistics_.probe_length_histogram.begin());
+  num_insertion_flushes_since_probe_sample_ = 0;
+}
+
+template <typename BlockType>
+void GPULayerView<BlockType>::probe_length_sampling_period(
+    int probe_length_sampling_period) {
+  CHECK_GE(probe_length_sampling_period, 0);
+  probe_length_sampling_period_ = probe_length_sampling_period;
+}
+
 template <typename BlockType>
 bool GPULayerView<BlockType>::isValid(const CudaStream& cuda_stream) const {
   return gpu_hash_ptr_->impl_.valid(thrust::device.on(cuda_stream));
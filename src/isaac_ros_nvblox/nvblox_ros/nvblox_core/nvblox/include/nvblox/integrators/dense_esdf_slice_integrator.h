@@ -0,0 +1,176 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#pragma once
+
+#include <memory>
+
+#include "nvblox/core/log_odds.h"
+#include "nvblox/core/parameter_tree.h"
+#include "nvblox/core/types.h"
+#include "nvblox/core/unified_vector.h"
+#include "nvblox/integrators/esdf_integrator_params.h"
+#include "nvblox/map/common_names.h"
+#include "nvblox/map/layer.h"
+#include "nvblox/sensors/image.h"
+
+namespace nvblox {
+
+/// Computes a 2D ESDF slice directly from a TSDF or occupancy layer, without
+/// going through the (block-sparse) EsdfLayer.
+///
+/// The voxel columns between esdf_slice_min_height() and
+/// esdf_slice_max_height() are collapsed into a dense 2D obstacle image, on
+/// which an exact 2D Euclidean distance transform is computed using jump
+/// flooding (with an additional single step pass, "JFA+1"). The output is a
+/// distance image in the format produced by EsdfSlicer, such that it can be
+/// consumed in the same way (e.g. for publishing a DistanceMapSlice).
+/// Because the whole slice is recomputed on each call, this is best suited for
+/// consumers which need the 2D slice only.
+class DenseEsdfSliceIntegrator {
+ public:
+  DenseEsdfSliceIntegrator();
+  DenseEsdfSliceIntegrator(std::shared_ptr<CudaStream> cuda_stream);
+  virtual ~DenseEsdfSliceIntegrator() = default;
+
+  /// Returns the AABB of the blocks of a layer which intersect the slice
+  /// height range [esdf_slice_min_height(), esdf_slice_max_height()]. The z
+  /// extent of the returned AABB is the slice height range.
+  /// @param layer The input layer.
+  /// @return The AABB. Empty if no blocks intersect the height range.
+  AxisAlignedBoundingBox getAabbOfLayerInSlice(const TsdfLayer& layer) const;
+  AxisAlignedBoundingBox getAabbOfLayerInSlice(
+      const OccupancyLayer& layer) const;
+
+  /// Computes the 2D ESDF slice of a TsdfLayer inside an AABB.
+  /// Pixel (row, col) of the output corresponds to the voxel column with
+  /// center (aabb.min().x() + (col + 0.5) * voxel_size,
+  /// aabb.min().y() + (row + 0.5) * voxel_size). Distances are negative inside
+  /// obstacles and are clamped to max_esdf_distance_m().
+  /// @param layer The input TsdfLayer.
+  /// @param aabb The AABB to compute the slice in. Should be aligned to the
+  /// voxel grid, e.g. as returned by getAabbOfLayerInSlice().
+  /// @param unobserved_value Value of pixels for which no voxel in the column
+  /// is observed.
+  /// @param[out] output_image The output distance image (in meters). Resized
+  /// to fit the AABB.
+  void integrateSlice(const TsdfLayer& layer,
+                      const AxisAlignedBoundingBox& aabb,
+                      float unobserved_value, Image<float>* output_image);
+
+  /// Computes the 2D ESDF slice of an OccupancyLayer inside an AABB.
+  /// See integrateSlice() for the TsdfLayer above.
+  /// @param layer The input OccupancyLayer.
+  /// @param aabb The AABB to compute the slice in.
+  /// @param unobserved_value Value of pixels for which no voxel in the column
+  /// is observed.
+  /// @param[out] output_image The output distance image (in meters).
+  void integrateSlice(const OccupancyLayer& layer,
+                      const AxisAlignedBoundingBox& aabb,
+                      float unobserved_value, Image<float>* output_image);
+
+  /// A parameter getter
+  /// The minimum height, in meters, to consider obstacles part of the slice.
+  /// @returns the minimum height
+  float esdf_slice_min_height() const;
+
+  /// A parameter setter
+  /// See esdf_slice_min_height().
+  /// @param esdf_slice_min_height The minimum height.
+  void esdf_slice_min_height(float esdf_slice_min_height);
+
+  /// A parameter getter
+  /// The maximum height, in meters, to consider obstacles part of the slice.
+  /// @returns the maximum height
+  float esdf_slice_max_height() const;
+
+  /// A parameter setter
+  /// See esdf_slice_max_height().
+  /// @param esdf_slice_max_height The maximum height.
+  void esdf_slice_max_height(float esdf_slice_max_height);
+
+  /// A parameter getter
+  /// The maximum distance which we compute the slice out to. Distances in the
+  /// output are clamped to this value.
+  /// @returns the maximum distance in meters
+  float max_esdf_distance_m() const;
+
+  /// A parameter setter
+  /// See max_esdf_distance_m().
+  /// @param max_esdf_distance_m The maximum distance.
+  void max_esdf_distance_m(float max_esdf_distance_m);
+
+  /// A parameter getter
+  /// The minimum weight of a TSDF voxel required for it to be considered
+  /// observed.
+  /// @returns the minimum weight
+  float min_weight() const;
+
+  /// A parameter setter
+  /// See min_weight().
+  /// @param min_weight The minimum weight.
+  void min_weight(float min_weight);
+
+  /// A parameter getter
+  /// The occupancy probability above which an occupancy voxel is considered
+  /// an obstacle.
+  /// @returns the occupied threshold probability
+  float occupied_threshold() const;
+
+  /// A parameter setter
+  /// See occupied_threshold().
+  /// @param occupied_threshold The occupied threshold probability.
+  void occupied_threshold(float occupied_threshold);
+
+  /// Return the parameter tree.
+  /// @return the parameter tree
+  virtual parameters::ParameterTreeNode getParameterTree(
+      const std::string& name_remap = std::string()) const;
+
+ private:
+  template <typename LayerType>
+  AxisAlignedBoundingBox getAabbOfLayerInSliceTemplate(
+      const LayerType& layer) const;
+
+  template <typename LayerType>
+  void integrateSliceTemplate(const LayerType& layer,
+                              const AxisAlignedBoundingBox& aabb,
+                              float unobserved_value,
+                              Image<float>* output_image);
+
+  // Runs jump flooding on the seeds in seeds_ptr, using scratch_ptr as the
+  // second buffer. Returns the buffer containing the result.
+  const int* jumpFlood(int rows, int cols, device_vector<int>* seeds_ptr,
+                       device_vector<int>* scratch_ptr);
+
+  // Parameters
+  float esdf_slice_min_height_ = kEsdfSliceMinHeightParamDesc.default_value;
+  float esdf_slice_max_height_ = kEsdfSliceMaxHeightParamDesc.default_value;
+  float max_esdf_distance_m_ =
+      kEsdfIntegratorMaxDistanceMParamDesc.default_value;
+  float tsdf_min_weight_ = kEsdfIntegratorMinWeightParamDesc.default_value;
+  float occupied_threshold_log_odds_ = logOddsFromProbability(0.5f);
+
+  // Per-pixel obstacle state of the collapsed slice.
+  device_vector<uint8_t> column_states_;
+  // Nearest obstacle and nearest free pixel (linear index, -1 for none).
+  device_vector<int> obstacle_seeds_;
+  device_vector<int> free_seeds_;
+  device_vector<int> seeds_scratch_;
+
+  std::shared_ptr<CudaStream> cuda_stream_;
+};
+
+}  // namespace nvblox
@@ -16,6 +16,7 @@ limitations under the License.
 #pragma once
 
 #include "nvblox/core/cuda_stream.h"
+#include "nvblox/core/internal/unique_index_sorter.h"
 #include "nvblox/core/log_odds.h"
 #include "nvblox/core/parameter_tree.h"
 #include "nvblox/core/types.h"
@@ -36,6 +37,17 @@ struct Index3DDeviceSet;
 struct OccupancySiteFunctor;
 struct TsdfSiteFunctor;
 
+/// Describes one of several constant-height 2D ESDF slices which are computed
+/// together by EsdfIntegrator::integrateSlices().
+struct EsdfSliceSpec {
+  /// The minimum height, in meters, to consider obstacles part of the slice.
+  float min_height_m;
+  /// The maximum height, in meters, to consider obstacles part of the slice.
+  float max_height_m;
+  /// The output height, in meters, of the slice in its output layer.
+  float output_height_m;
+};
+
 /// A class performing (incremental) ESDF integration
 ///
 /// The Euclidean Signed Distance Function (ESDF) is a distance function where
@@ -79,6 +91,25 @@ class EsdfIntegrator {
                                const std::vector<Index3D>& block_indices,
                                EsdfLayer* esdf_layer);
 
+  /// Versions of the three functions above that output to a CompactEsdfLayer.
+  /// The compact layer uses 8 bytes per voxel rather than 20 but requires that
+  /// max_esdf_distance_m() is at most CompactEsdfVoxel::kMaxParentOffsetVox
+  /// voxels.
+  /// @param tsdf_layer The input TsdfLayer
+  /// @param block_indices The indices of the CompactEsdfLayer which should be
+  /// updated (usually because the TSDF at these indices has changed).
+  /// @param[out] esdf_layer The output CompactEsdfLayer
+  virtual void integrateBlocks(const TsdfLayer& tsdf_layer,
+                               const std::vector<Index3D>& block_indices,
+                               CompactEsdfLayer* esdf_layer);
+  virtual void integrateBlocks(const TsdfLayer& tsdf_layer,
+                               const FreespaceLayer& freespace_layer,
+                               const std::vector<Index3D>& block_indices,
+                               CompactEsdfLayer* esdf_layer);
+  virtual void integrateBlocks(const OccupancyLayer& occupancy_layer,
+                               const std::vector<Index3D>& block_indices,
+                               CompactEsdfLayer* esdf_layer);
+
   /// Build an EsdfLayer slice from a TsdfLayer (incremental) (on GPU)
   /// This function takes the voxels between z_min and z_max in the TsdfLayer.
   /// Any obstacle in this z range generates an obstacle in the ESDF output
@@ -172,6 +203,59 @@ class EsdfIntegrator {
                       const std::vector<Index3D>& block_indices,
                       const Plane& ground_plane, EsdfLayer* esdf_layer);
 
+  /// The maximum number of slices computed by a single call to
+  /// integrateSlices().
+  static constexpr int kMaxNumSlices = 4;
+
+  /// Build several EsdfLayer slices from a TsdfLayer (incremental) (on GPU)
+  /// Equivalent to calling integrateSlice() once per slice spec, but the
+  /// input layer is traversed (and its sites marked) in a single pass for all
+  /// slices. Each slice is written to its own output layer, because slices
+  /// sharing a layer would propagate distances into each other.
+  /// @param tsdf_layer The input TsdfLayer
+  /// @param block_indices The indices of the TsdfLayer which have changed.
+  /// @param slice_specs The slices to compute (at most kMaxNumSlices).
+  /// @param[out] esdf_layers The output EsdfLayers, one per slice spec.
+  void integrateSlices(const TsdfLayer& tsdf_layer,
+                       const std::vector<Index3D>& block_indices,
+                       const std::vector<EsdfSliceSpec>& slice_specs,
+                       const std::vector<EsdfLayer*>& esdf_layers);
+
+  /// Build several EsdfLayer slices from a TsdfLayer and a FreespaceLayer
+  /// (incremental) (on GPU). See integrateSlices() above.
+  /// @param tsdf_layer The input TsdfLayer
+  /// @param freespace_layer The input freespace layer (esdf sites are
+  /// ignored if they fall into freespace)
+  /// @param block_indices The indices of the TsdfLayer which have changed.
+  /// @param slice_specs The slices to compute (at most kMaxNumSlices).
+  /// @param[out] esdf_layers The output EsdfLayers, one per slice spec.
+  void integrateSlices(const TsdfLayer& tsdf_layer,
+                       const FreespaceLayer& freespace_layer,
+                       const std::vector<Index3D>& block_indices,
+                       const std::vector<EsdfSliceSpec>& slice_specs,
+                       const std::vector<EsdfLayer*>& esdf_layers);
+
+  /// Build several EsdfLayer slices from an OccupancyLayer (incremental) (on
+  /// GPU). See integrateSlices() above.
+  /// @param occupancy_layer The input OccupancyLayer
+  /// @param block_indices The indices of the OccupancyLayer which have
+  /// changed.
+  /// @param slice_specs The slices to compute (at most kMaxNumSlices).
+  /// @param[out] esdf_layers The output EsdfLayers, one per slice spec.
+  void integrateSlices(const OccupancyLayer& occupancy_layer,
+                       const std::vector<Index3D>& block_indices,
+                       const std::vector<EsdfSliceSpec>& slice_specs,
+                       const std::vector<EsdfLayer*>& esdf_layers);
+
+  /// The stream on which the integration is performed.
+  /// @returns the stream
+  std::shared_ptr<CudaStream> cuda_stream() const { return cuda_stream_; }
+
+  /// Set the stream on which the integration is performed. Waits for the work
+  /// on the previous stream to finish.
+  /// @param cuda_stream The new stream
+  void cuda_stream(std::shared_ptr<CudaStream> cuda_stream);
+
   /// A parameter getter
   /// The maximum distance in meters out to which to calculate the ESDF.
   /// @returns the maximum distance
@@ -282,6 +366,23 @@ class EsdfIntegrator {
     slice_height_thickness_m_ = slice_height_thickness_m;
   }
 
+  /// A parameter getter
+  /// Whether the propagation of the ESDF runs in a single persistent kernel,
+  /// looping over the wavefronts on the device, rather than launching
+  /// kernels (and reading back the number of updated blocks) per wavefront.
+  /// @returns use_persistent_kernel
+  bool use_persistent_kernel() const;
+
+  /// A parameter setter
+  /// See use_persistent_kernel(). Has no effect (but a warning) on GPUs
+  /// without support for cooperative launches.
+  /// @param use_persistent_kernel
+  void use_persistent_kernel(bool use_persistent_kernel);
+
+  /// Whether the current GPU supports the persistent kernel.
+  /// @returns True if cooperative launches are supported.
+  static bool isPersistentKernelSupported();
+
   /// Return the parameter tree.
   /// @return the parameter tree
   virtual parameters::ParameterTreeNode getParameterTree(
@@ -289,10 +390,10 @@ class EsdfIntegrator {
 
  protected:
   /// Templated version of the public functions above, used internally.
-  template <typename LayerType>
+  template <typename LayerType, typename EsdfLayerType>
   void integrateBlocksTemplate(
       const LayerType& layer, const std::vector<Index3D>& block_indices,
-      EsdfLayer* esdf_layer,
+      EsdfLayerType* esdf_layer,
       const FreespaceLayer* freespace_layer_ptr = nullptr);
 
   /// Templated version of the public functions above, used internally.
@@ -302,19 +403,28 @@ class EsdfIntegrator {
       const SliceDescriptionType& slice_spec, EsdfLayer* esdf_layer,
       const FreespaceLayer* freespace_layer_ptr = nullptr);
 
+  /// Templated version of the public integrateSlices() functions above.
+  template <typename LayerType>
+  void integrateSlicesTemplate(
+      const LayerType& layer, const std::vector<Index3D>& block_indices,
+      const std::vector<EsdfSliceSpec>& slice_specs,
+      const std::vector<EsdfLayer*>& esdf_layers,
+      const FreespaceLayer* freespace_layer_ptr = nullptr);
+
   /// Allocate all blocks in the given block indices list.
+  template <typename EsdfLayerType>
   void allocateBlocksOnCPU(const std::vector<Index3D>& block_indices,
-                           EsdfLayer* esdf_layer);
+                           EsdfLayerType* esdf_layer);
 
   /// Gets the site-finding functors for a specific layer type.
   OccupancySiteFunctor getSiteFunctor(const OccupancyLayer& layer);
   TsdfSiteFunctor getSiteFunctor(const TsdfLayer& layer);
 
-  template <typename LayerType>
+  template <typename LayerType, typename EsdfLayerType>
   void markAllSites(const LayerType& layer,
                     const std::vector<Index3D>& block_indices,
                     const FreespaceLayer* freespace_layer_ptr,
-                    EsdfLayer* esdf_layer,
+                    EsdfLayerType* esdf_layer,
                     device_vector<Index3D>* blocks_with_sites,
                     device_vector<Index3D>* cleared_blocks);
 
@@ -330,21 +440,61 @@ class EsdfIntegrator {
                         device_vector<Index3D>* updated_blocks,
                         device_vector<Index3D>* cleared_blocks);
 
-  // Internal helpers for GPU computation.
+  // Same as markSitesInSlice() but for several constant-height slices at
+  // once. Outputs the updated and cleared blocks of each slice.
+  template <typename LayerType>
+  void markSitesInSlices(
+      const LayerType& layer, const std::vector<Index3D>& block_indices,
+      const std::vector<EsdfSliceSpec>& slice_specs,
+      const FreespaceLayer* freespace_layer_ptr,
+      const std::vector<EsdfLayer*>& esdf_layers,
+      std::vector<std::vector<Index3D>>* updated_blocks_per_slice,
+      std::vector<std::vector<Index3D>>* cleared_blocks_per_slice);
+
+  // Internal helpers for GPU computation. These are templated on the output
+  // layer type such that they work on both EsdfLayer and CompactEsdfLayer.
+  template <typename EsdfLayerType>
   void updateNeighborBands(device_vector<Index3D>* block_indices,
-                           EsdfLayer* esdf_layer,
+                           EsdfLayerType* esdf_layer,
                            float max_squared_esdf_distance_vox,
                            device_vector<Index3D>* updated_block_indices);
 
+  template <typename EsdfLayerType>
   void sweepBlockBandAsync(device_vector<Index3D>* block_indices,
-                           EsdfLayer* esdf_layer,
+                           EsdfLayerType* esdf_layer,
                            float max_squared_esdf_distance_vox);
+  template <typename EsdfLayerType>
   void computeEsdf(const device_vector<Index3D>& blocks_with_sites,
-                   EsdfLayer* esdf_layer);
+                   EsdfLayerType* esdf_layer);
+  // Same as the loop in computeEsdf() but in a single cooperative launch.
+  template <typename EsdfLayerType>
+  void propagateEsdfPersistent(const device_vector<Index3D>& blocks_with_sites,
+                               EsdfLayerType* esdf_layer,
+                               const float max_squared_esdf_distance_vox);
+  template <typename EsdfLayerType>
   void clearAllInvalid(const std::vector<Index3D>& blocks_to_clear,
-                       EsdfLayer* esdf_layer,
+                       EsdfLayerType* esdf_layer,
                        device_vector<Index3D>* updated_blocks);
 
+  /// Gets the temporary block pointer storage for a specific output layer type.
+  device_vector<EsdfBlock*>* getTempBlockPointers(const EsdfLayer&) {
+    return &temp_block_pointers_;
+  }
+  device_vector<CompactEsdfBlock*>* getTempBlockPointers(
+      const CompactEsdfLayer&) {
+    return &temp_compact_block_pointers_;
+  }
+
+  /// Gets the temporary neighbor table storage for a specific output layer
+  /// type.
+  device_vector<const EsdfBlock*>* getTempNeighborTable(const EsdfLayer&) {
+    return &temp_neighbor_table_;
+  }
+  device_vector<const CompactEsdfBlock*>* getTempNeighborTable(
+      const CompactEsdfLayer&) {
+    return &temp_compact_neighbor_table_;
+  }
+
   // Helper method to de-dupe block indices.
   void sortAndTakeUniqueIndices(device_vector<Index3D>* block_indices);
 
@@ -369,6 +519,8 @@ class EsdfIntegrator {
       kSliceHeightAbovePlaneMParamDesc.default_value;
   float slice_height_thickness_m_ =
       kSliceHeightThicknessMParamDesc.default_value;
+  bool use_persistent_kernel_ =
+      kEsdfIntegratorUsePersistentKernelParamDesc.default_value;
 
   /// @brief OccupancyLayer related parameter
   /// The log odds value greater than which we consider a voxel occupied
@@ -397,7 +549,29 @@ class EsdfIntegrator {
   device_vector<int> counter_buffer_device_{2};
   host_vector<int> counter_buffer_host_{2};
 
+  // Scratch space of propagateEsdfPersistent(): the two wavefront queues, the
+  // set deduplicating the blocks reached by a wavefront, and the set slot of
+  // each reached block.
+  device_vector<Index3D> persistent_queues_device_;
+  device_vector<uint64_t> persistent_set_keys_device_;
+  device_vector<int> persistent_set_slots_device_;
+
+  // Sorts the updated block indices when there are too many for the single
+  // thread block sortUniqueKernel.
+  UniqueIndexSorter unique_index_sorter_;
+
+  // Outputs of markSitesInSlices(), with the blocks of each slice stored
+  // consecutively.
+  device_vector<Index3D> slices_updated_indices_device_;
+  device_vector<Index3D> slices_to_clear_indices_device_;
+  device_vector<int> slices_counters_device_;
+  host_vector<int> slices_counters_host_;
+
   device_vector<EsdfBlock*> temp_block_pointers_;
+  device_vector<CompactEsdfBlock*> temp_compact_block_pointers_;
+  // The 27 neighbors of the blocks in clearAllInvalid().
+  device_vector<const EsdfBlock*> temp_neighbor_table_;
+  device_vector<const CompactEsdfBlock*> temp_compact_neighbor_table_;
 };
 
 }  // namespace nvblox
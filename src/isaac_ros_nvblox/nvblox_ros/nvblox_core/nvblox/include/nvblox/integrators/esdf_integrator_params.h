@@ -50,6 +50,12 @@ constexpr Param<float>::Description kSliceHeightThicknessMParamDesc{
     "slice_height_thickness_m", 0.1,
     "The height of the slice (in meters) above the lower slice."};
 
+constexpr Param<bool>::Description kEsdfIntegratorUsePersistentKernelParamDesc{
+    "esdf_integrator_use_persistent_kernel", false,
+    "Whether to propagate the ESDF in a single persistent kernel with "
+    "grid-wide syncs, rather than with kernel launches per wavefront. Saves "
+    "the launch and readback latency of large updates."};
+
 struct EsdfIntegratorParams {
   Param<float> esdf_integrator_max_distance_m{
       kEsdfIntegratorMaxDistanceMParamDesc};
@@ -61,6 +67,8 @@ struct EsdfIntegratorParams {
   Param<float> esdf_slice_height{kEsdfSliceHeightParamDesc};
   Param<float> slice_height_above_plane_m{kSliceHeightAbovePlaneMParamDesc};
   Param<float> slice_height_thickness_m{kSliceHeightThicknessMParamDesc};
+  Param<bool> esdf_integrator_use_persistent_kernel{
+      kEsdfIntegratorUsePersistentKernelParamDesc};
 };
 
 }  // namespace nvblox
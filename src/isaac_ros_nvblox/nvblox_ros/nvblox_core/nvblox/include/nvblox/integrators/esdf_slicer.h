@@ -45,6 +45,28 @@ class EsdfSlicer {
       const EsdfLayer& layer_1, const EsdfLayer& layer_2,
       float layer_1_slice_height, float layer_2_slice_height);
 
+  /// Returns a square AABB of a fixed size, centered (in x and y) on a
+  /// position such as the robot's. Slicing inside it, instead of inside the
+  /// AABB of the layer, bounds the slice image to a constant size, such that
+  /// the cost of slicing doesn't grow as the map grows. The AABB is snapped to
+  /// the voxel grid.
+  /// @param center The position to center the AABB on.
+  /// @param side_length_m The side length of the AABB.
+  /// @param voxel_size The voxel size of the layer to slice.
+  /// @param slice_height The height of the slice.
+  static AxisAlignedBoundingBox getAabbAroundPosition(const Vector3f& center,
+                                                      float side_length_m,
+                                                      float voxel_size,
+                                                      float slice_height);
+
+  /// Returns the size of the distance image covering an AABB, as output by
+  /// sliceLayerToDistanceImage().
+  /// @param aabb The AABB of the slice.
+  /// @param voxel_size The voxel size of the layer to slice.
+  /// @return The number of rows (y) and columns (x) of the image.
+  static Index2D getSliceImageSize(const AxisAlignedBoundingBox& aabb,
+                                   float voxel_size);
+
   /// Slices an ESDF layer at a specific height to a distance image inside a
   /// custom AABB.
   /// @param layer Input ESDF layer.
@@ -61,7 +83,8 @@ class EsdfSlicer {
                                  Image<float>* output_image);
 
   /// Slices two ESDF layers at a specific height to a combined distance image
-  /// inside a custom AABB.
+  /// inside a custom AABB. The layers may have different voxel sizes, in which
+  /// case the image has the resolution of the finer layer.
   /// @param layer_1 First input ESDF layer.
   /// @param layer_2 Second input ESDF layer.
   /// @param layer_1_slice_height The height of the slice in layer 1.
@@ -16,8 +16,10 @@ limitations under the License.
 #pragma once
 
 #include <optional>
+#include <vector>
 
 #include "nvblox/core/parameter_tree.h"
+#include "nvblox/core/scratch_arena.h"
 #include "nvblox/core/time.h"
 #include "nvblox/core/types.h"
 #include "nvblox/integrators/freespace_integrator_params.h"
@@ -28,6 +30,16 @@ limitations under the License.
 
 namespace nvblox {
 
+/// The result of the view test of a ViewBasedInclusionData, precomputed for a
+/// set of blocks during TSDF integration of the same view (see
+/// ProjectiveIntegrator::in_view_voxel_masks()).
+struct InViewVoxelMasks {
+  /// The blocks for which the masks were computed.
+  const std::vector<Index3D>* block_indices = nullptr;
+  /// One mask per block in block_indices, flagging the voxels in view.
+  const device_vector<VoxelBlockMask>* masks_device = nullptr;
+};
+
 /// The FreespaceIntegrator class updates the freespace layer that
 /// classifies voxels as high confidence freespace or occupied.
 /// Freespace information can be used for dynamic detection as objects moving
@@ -61,10 +73,15 @@ class FreespaceIntegrator {
   /// @param view_to_update Describes the view of the scene in which voxels
   /// should be updated.
   /// @param freespace_layer_ptr The freespace layer that will be updated.
-  void updateFreespaceLayer(const std::vector<Index3D>& block_indices_to_update,
-                            Time update_time_ms, const TsdfLayer& tsdf_layer,
-                            const std::optional<ViewBasedInclusionData>& view,
-                            FreespaceLayer* freespace_layer_ptr);
+  /// @param in_view_voxel_masks Optional precomputed view test for a subset of
+  /// the blocks. Voxels in these blocks are not re-projected into the view.
+  void updateFreespaceLayer(
+      const std::vector<Index3D>& block_indices_to_update, Time update_time_ms,
+      const TsdfLayer& tsdf_layer,
+      const std::optional<ViewBasedInclusionData>& view,
+      FreespaceLayer* freespace_layer_ptr,
+      const std::optional<InViewVoxelMasks>& in_view_voxel_masks =
+          std::nullopt);
 
   /// A parameter getter
   /// Tsdf distance below which we assume a voxel to be occupied.
@@ -126,6 +143,37 @@ class FreespaceIntegrator {
   /// @param value whether to check the neighboring voxels
   void check_neighborhood(bool value);
 
+  /// A parameter getter
+  /// Whether to skip blocks which the update would leave unchanged. A block is
+  /// settled if all its voxels are high confidence freespace, and none of
+  /// them are occupied or were occupied within
+  /// max_unobserved_to_keep_consecutive_occupancy_ms(). Such blocks only
+  /// change once the TSDF marks one of their voxels occupied again, which a
+  /// cheap per-voxel check (without neighborhood or view test) detects before
+  /// the update. Skipping doesn't change the result of the update.
+  /// @returns whether to skip settled blocks
+  bool skip_settled_blocks() const;
+
+  /// A parameter setter
+  /// See skip_settled_blocks().
+  /// @param value whether to skip settled blocks
+  void skip_settled_blocks(bool value);
+
+  /// Getter
+  /// @return The number of blocks skipped by the last update, because they
+  /// were settled (see skip_settled_blocks()).
+  size_t num_skipped_blocks() const;
+
+  /// Getter
+  /// @return The arena from which temporary device buffers are allocated, or
+  /// nullptr if the integrator uses its own buffers.
+  ScratchArena* scratch_arena() const;
+
+  /// Setter. See scratch_arena(). The arena has to be used on the same stream
+  /// as the integrator, and has to outlive it.
+  /// @param scratch_arena The arena, or nullptr to use own buffers.
+  void scratch_arena(ScratchArena* scratch_arena);
+
   /// Return the parameter tree.
   /// @return the parameter tree
   virtual parameters::ParameterTreeNode getParameterTree(
@@ -136,13 +184,27 @@ class FreespaceIntegrator {
   // disabled
   void launchNonPaddedKernel(Time update_time_ms, const TsdfLayer& tsdf_layer,
                              const std::optional<ViewBasedInclusionData>& view,
+                             const VoxelBlockMask* in_view_masks,
                              FreespaceLayer* freespace_layer_ptr);
 
   // Use the padded kernel when check_neighborhood is enabled.
   void launchPaddedKernel(Time update_time_ms, const TsdfLayer& tsdf_layer,
                           const std::optional<ViewBasedInclusionData>& view,
+                          const VoxelBlockMask* in_view_masks,
                           FreespaceLayer* freespace_layer_ptr);
 
+  // Removes the settled blocks (see skip_settled_blocks()) from the blocks
+  // staged for update, on the host and the device.
+  void removeSettledBlocks(Time update_time_ms, const TsdfLayer& tsdf_layer,
+                           const FreespaceLayer& freespace_layer);
+
+  // Looks up, for each block staged for update, the index of its mask in the
+  // passed in-view masks (or -1). Returns the pointer to the masks to pass to
+  // the kernels, which is nullptr if no masks can be used.
+  const VoxelBlockMask* prepareInViewMasks(
+      const std::optional<ViewBasedInclusionData>& view,
+      const std::optional<InViewVoxelMasks>& in_view_voxel_masks);
+
   // Parameters (see getters for description)
   // Note: See comment behind each parameter for corresponding dynablox
   // parameter name
@@ -157,6 +219,7 @@ class FreespaceIntegrator {
       kMinConsecutiveOccupancyDurationForResetMsParamDesc
           .default_value};  // tau_r
   bool check_neighborhood_ = kCheckNeighborhoodParamDesc.default_value;
+  bool skip_settled_blocks_ = kSkipSettledBlocksParamDesc.default_value;
 
   // Time
   Time last_update_time_ms_{0};
@@ -165,6 +228,20 @@ class FreespaceIntegrator {
   host_vector<Index3D> block_indices_to_update_host_;
   device_vector<Index3D> block_indices_to_update_device_;
 
+  // For each block staged for update, whether it isn't settled.
+  device_vector<bool> update_flags_device_;
+  host_vector<bool> update_flags_host_;
+  size_t num_skipped_blocks_ = 0;
+
+  // For each block to update, the index of its precomputed in-view mask. The
+  // device indices are drawn from the scratch arena if there is one.
+  host_vector<int> in_view_mask_indices_host_;
+  device_vector<int> in_view_mask_indices_device_;
+  int* in_view_mask_indices_device_ptr_ = nullptr;
+
+  // Optional (not owned) arena for temporary device buffers.
+  ScratchArena* scratch_arena_ = nullptr;
+
   // CUDA stream to process integration on
   std::shared_ptr<CudaStream> cuda_stream_;
 };
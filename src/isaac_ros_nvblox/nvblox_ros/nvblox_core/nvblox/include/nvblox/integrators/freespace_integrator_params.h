@@ -47,6 +47,12 @@ constexpr Param<bool>::Description kCheckNeighborhoodParamDesc{
     "Whether to check the occupancy of the neighboring voxels for the high "
     "confidence freespace update."};
 
+constexpr Param<bool>::Description kSkipSettledBlocksParamDesc{
+    "skip_settled_blocks", true,
+    "Whether to skip the freespace update for blocks that the update would "
+    "leave unchanged, because none of their voxels is (or was lately) "
+    "occupied or pending to become high confidence freespace."};
+
 struct FreespaceIntegratorParams {
   Param<float> max_tsdf_distance_for_occupancy_m{
       kMaxTsdfDistanceForOccupancyMParamDesc};
@@ -57,6 +63,7 @@ struct FreespaceIntegratorParams {
   Param<Time> min_consecutive_occupancy_duration_for_reset_ms{
       kMinConsecutiveOccupancyDurationForResetMsParamDesc};
   Param<bool> check_neighborhood{kCheckNeighborhoodParamDesc};
+  Param<bool> skip_settled_blocks{kSkipSettledBlocksParamDesc};
 };
 
 }  // namespace nvblox
@@ -15,9 +15,12 @@ limitations under the License.
 */
 #include <nvblox/integrators/internal/decayer.h>
 
+#include <algorithm>
+
 #include "nvblox/integrators/internal/cuda/projective_integrators_common.cuh"
 #include "nvblox/integrators/internal/integrators_common.h"
 #include "nvblox/interpolation/interpolation_2d.h"
+#include "nvblox/map/internal/cuda/voxel_block_threads.cuh"
 
 namespace nvblox {
 
@@ -80,10 +83,14 @@ std::vector<Index3D> getBlockIndicesToDecay(
 
 }  // namespace
 
-template <typename BlockType, typename DecayFunctorType>
-__device__ void decay(BlockType** block_ptrs,
+// The passed do_decay callable decides per voxel index whether the voxel is
+// decayed.
+template <typename BlockType, typename DecayFunctorType,
+          typename DoDecayCallableType>
+__device__ void decay(BlockType* const* block_ptrs,
                       const DecayFunctorType& voxel_decayer,
-                      const bool do_decay, bool* is_block_fully_decayed) {
+                      const DoDecayCallableType& do_decay,
+                      bool* is_block_fully_decayed) {
   // Initialize the output
   __shared__ bool is_block_fully_decayed_shared;
   if (threadIdx.x == 0 && threadIdx.y == 0 && threadIdx.z == 0) {
@@ -91,23 +98,26 @@ __device__ void decay(BlockType** block_ptrs,
   }
   __syncthreads();
 
-  // Load the voxel from global memory
-  typename BlockType::VoxelType* voxel_ptr =
-      &(block_ptrs[blockIdx.x]->voxels[threadIdx.z][threadIdx.y][threadIdx.x]);
-  assert(voxel_ptr != nullptr);
+  forEachVoxelInThread([&](const Index3D& voxel_idx) {
+    // Load the voxel from global memory
+    typename BlockType::VoxelType* voxel_ptr =
+        &(block_ptrs[blockIdx.x]
+              ->voxels[voxel_idx.x()][voxel_idx.y()][voxel_idx.z()]);
+    assert(voxel_ptr != nullptr);
 
-  // If requested, do the decay step.
-  if (do_decay) {
-    voxel_decayer(voxel_ptr);
-  }
+    // If requested, do the decay step.
+    if (do_decay(voxel_idx)) {
+      voxel_decayer(voxel_ptr);
+    }
 
-  // If any voxel in the block is not decayed, set the block's decayed
-  // status to false. NOTE: There could be more than one thread writing
-  // this value, but because all of them write false it is no issue.
-  // If voxel *not* fully decayed, indicate block not fully decayed.
-  if (!voxel_decayer.isFullyDecayed(voxel_ptr)) {
-    is_block_fully_decayed_shared = false;
-  }
+    // If any voxel in the block is not decayed, set the block's decayed
+    // status to false. NOTE: There could be more than one thread writing
+    // this value, but because all of them write false it is no issue.
+    // If voxel *not* fully decayed, indicate block not fully decayed.
+    if (!voxel_decayer.isFullyDecayed(voxel_ptr)) {
+      is_block_fully_decayed_shared = false;
+    }
+  });
   __syncthreads();
 
   // One thread writes the output
@@ -117,16 +127,17 @@ __device__ void decay(BlockType** block_ptrs,
 }
 
 template <typename BlockType, typename DecayFunctorType>
-__global__ void decayKernel(BlockType** block_ptrs,
+__global__ void decayKernel(BlockType* const* block_ptrs,
                             const DecayFunctorType voxel_decayer,
                             bool* is_block_fully_decayed) {
-  constexpr bool kDoDecay = true;
-  decay(block_ptrs, voxel_decayer, kDoDecay, is_block_fully_decayed);
+  decay(
+      block_ptrs, voxel_decayer, [](const Index3D&) { return true; },
+      is_block_fully_decayed);
 }
 
 template <typename BlockType, typename DecayFunctorType>
 __global__ void decayTsdfExcludeImageKernel(
-    BlockType** block_ptrs,                // NOLINT
+    BlockType* const* block_ptrs,          // NOLINT
     const DecayFunctorType voxel_decayer,  // NOLINT
     const Index3D* block_indices,          // NOLINT
     const Camera camera,                   // NOLINT
@@ -139,11 +150,12 @@ __global__ void decayTsdfExcludeImageKernel(
     const float truncation_distance_m,     // NOLINT
     bool* is_block_fully_decayed) {
   // We do the decay step, only if the voxel is not in view.
-  Index3D block_idx, voxel_idx;
-  voxelAndBlockIndexFromCudaThreadIndex(block_indices, &block_idx, &voxel_idx);
-  const bool do_decay = (!doesVoxelHaveDepthMeasurement(
-      block_idx, voxel_idx, camera, depth_image, rows, cols, T_C_L,
-      block_size_m, max_distance_m, truncation_distance_m));
+  const Index3D block_idx = block_indices[blockIdx.x];
+  const auto do_decay = [&](const Index3D& voxel_idx) {
+    return !doesVoxelHaveDepthMeasurement(
+        block_idx, voxel_idx, camera, depth_image, rows, cols, T_C_L,
+        block_size_m, max_distance_m, truncation_distance_m);
+  };
   decay(block_ptrs, voxel_decayer, do_decay, is_block_fully_decayed);
 }
 
@@ -157,23 +169,85 @@ std::vector<Index3D> VoxelDecayer<LayerType>::decay(
     const std::optional<ViewBasedInclusionData>& view_exclusion_options,
     const CudaStream& cuda_stream) {
   CHECK_NOTNULL(layer_ptr);
+  // Decay writes the blocks through their device pointers, so snapshots of
+  // the layer have to copy them first.
+  layer_ptr->prepareAllBlocksForWriteAsync(cuda_stream);
+
+  // Blocks are only skipped while they're kept allocated. Once deallocation is
+  // requested, the skipped blocks are decayed once more such that they are
+  // freed in one go with the other fully decayed blocks.
+  if (deallocate_decayed_blocks) {
+    fully_decayed_blocks_.clear();
+  }
+
+  // Without exclusions (and no fully decayed blocks to skip) we decay all
+  // blocks, and launch directly over the layer's cached block lists.
+  if (!block_exclusion_options && fully_decayed_blocks_.empty()) {
+    const std::vector<Index3D>& block_indices_to_decay =
+        layer_ptr->getAllBlockIndicesCached();
+    if (block_indices_to_decay.empty()) {
+      return std::vector<Index3D>();
+    }
+    const Index3D* block_indices_device =
+        view_exclusion_options
+            ? layer_ptr->getAllBlockIndicesOnGpu(cuda_stream).data()
+            : nullptr;
+    decayBlocksOnGpu(layer_ptr, block_indices_to_decay.size(),
+                     layer_ptr->getAllBlockPointersOnGpu(cuda_stream).data(),
+                     block_indices_device, voxel_decay_functor,
+                     view_exclusion_options, cuda_stream);
+    if (skip_fully_decayed_blocks_ && !deallocate_decayed_blocks) {
+      updateFullyDecayedBlocks(block_indices_to_decay);
+    }
+    if (deallocate_decayed_blocks) {
+      return deallocateFullyDecayedBlocks(layer_ptr, block_indices_to_decay,
+                                          cuda_stream);
+    } else {
+      return std::vector<Index3D>();
+    }
+  }
 
-  // Get block indices to decay and their block pointers
-  const std::vector<Index3D> block_indices_to_decay =
+  // Get block indices to decay
+  std::vector<Index3D> block_indices_to_decay =
       getBlockIndicesToDecay(layer_ptr, block_exclusion_options);
+  if (!fully_decayed_blocks_.empty()) {
+    block_indices_to_decay.erase(
+        std::remove_if(block_indices_to_decay.begin(),
+                       block_indices_to_decay.end(),
+                       [this](const Index3D& block_index) {
+                         return fully_decayed_blocks_.count(block_index) > 0;
+                       }),
+        block_indices_to_decay.end());
+  }
+
+  return decayBlocks(layer_ptr, block_indices_to_decay, voxel_decay_functor,
+                     deallocate_decayed_blocks, view_exclusion_options,
+                     cuda_stream);
+}
+
+template <class LayerType>
+template <typename DecayFunctorType>
+std::vector<Index3D> VoxelDecayer<LayerType>::decayBlocks(
+    LayerType* layer_ptr,                                // NOLINT
+    const std::vector<Index3D>& block_indices_to_decay,  // NOLINT
+    const DecayFunctorType& voxel_decay_functor,         // NOLINT
+    const bool deallocate_decayed_blocks,                // NOLINT
+    const std::optional<ViewBasedInclusionData>& view_exclusion_options,
+    const CudaStream& cuda_stream) {
+  CHECK_NOTNULL(layer_ptr);
 
+  // Get the block pointers of the blocks to decay
   const std::vector<typename LayerType::BlockType*> block_ptrs_to_decay =
-      getBlockPtrsFromIndices(block_indices_to_decay, layer_ptr);
+      getBlockPtrsFromIndices(block_indices_to_decay, layer_ptr, cuda_stream);
 
   if (block_ptrs_to_decay.empty()) {
     // Empty layer, nothing to do here.
     return std::vector<Index3D>();
   }
 
-  expandBuffersIfRequired(
-      block_ptrs_to_decay.size(), cuda_stream, &allocated_block_ptrs_host_,
-      &allocated_block_ptrs_device_, &block_fully_decayed_device_,
-      &block_fully_decayed_host_);
+  expandBuffersIfRequired(block_ptrs_to_decay.size(), cuda_stream,
+                          &allocated_block_ptrs_host_,
+                          &allocated_block_ptrs_device_);
 
   // Get the block pointers on host and copy them to device
   allocated_block_ptrs_host_.copyFromAsync(block_ptrs_to_decay, cuda_stream);
@@ -193,14 +267,51 @@ std::vector<Index3D> VoxelDecayer<LayerType>::decay(
                                                   cuda_stream);
   }
 
-  block_fully_decayed_device_.resizeAsync(block_ptrs_to_decay.size(),
-                                          cuda_stream);
+  decayBlocksOnGpu(
+      layer_ptr, block_ptrs_to_decay.size(),
+      allocated_block_ptrs_device_.data(),
+      view_exclusion_options ? allocated_block_indices_device_.data() : nullptr,
+      voxel_decay_functor, view_exclusion_options, cuda_stream);
+
+  // Check if nothing is lost on the way
+  CHECK(allocated_block_ptrs_host_.size() == block_ptrs_to_decay.size());
+  CHECK(allocated_block_ptrs_device_.size() == block_ptrs_to_decay.size());
+  if (view_exclusion_options) {
+    CHECK(allocated_block_indices_host_.size() == block_ptrs_to_decay.size());
+    CHECK(allocated_block_indices_device_.size() == block_ptrs_to_decay.size());
+  }
+
+  if (skip_fully_decayed_blocks_ && !deallocate_decayed_blocks) {
+    updateFullyDecayedBlocks(block_indices_to_decay);
+  }
+
+  if (deallocate_decayed_blocks) {
+    return deallocateFullyDecayedBlocks(layer_ptr, block_indices_to_decay,
+                                        cuda_stream);
+  } else {
+    return std::vector<Index3D>();
+  }
+}
+
+template <class LayerType>
+template <typename DecayFunctorType>
+void VoxelDecayer<LayerType>::decayBlocksOnGpu(
+    LayerType* layer_ptr,                                     // NOLINT
+    const int num_blocks,                                     // NOLINT
+    typename LayerType::BlockType* const* block_ptrs_device,  // NOLINT
+    const Index3D* block_indices_device,                      // NOLINT
+    const DecayFunctorType& voxel_decay_functor,              // NOLINT
+    const std::optional<ViewBasedInclusionData>& view_exclusion_options,
+    const CudaStream& cuda_stream) {
+  expandBuffersIfRequired(num_blocks, cuda_stream, &block_fully_decayed_device_,
+                          &block_fully_decayed_host_);
+  block_fully_decayed_device_.resizeAsync(num_blocks, cuda_stream);
 
   // Kernel call - One ThreadBlock launched per VoxelBlock
-  constexpr int kVoxelsPerSide = VoxelBlock<bool>::kVoxelsPerSide;
-  const dim3 kThreadsPerBlock(kVoxelsPerSide, kVoxelsPerSide, kVoxelsPerSide);
-  const int num_thread_blocks = allocated_block_ptrs_host_.size();
+  const dim3 kThreadsPerBlock = voxelBlockThreadsPerBlock();
+  const int num_thread_blocks = num_blocks;
   if (view_exclusion_options) {
+    CHECK_NOTNULL(block_indices_device);
     // If the max view and/or truncation distances are not set, we set them to
     // something really high (such that they have no effect).
     const float kernel_max_view_distance_m =
@@ -215,9 +326,9 @@ std::vector<Index3D> VoxelDecayer<LayerType>::decay(
         << "At the moment we only support view exclusion *with* a DepthImage.";
     decayTsdfExcludeImageKernel<<<num_thread_blocks, kThreadsPerBlock, 0,
                                   cuda_stream>>>(
-        allocated_block_ptrs_device_.data(),                          // NOLINT
+        block_ptrs_device,                                            // NOLINT
         voxel_decay_functor,                                          // NOLINT
-        allocated_block_indices_device_.data(),                       // NOLINT
+        block_indices_device,                                         // NOLINT
         view_exclusion_options->camera,                               // NOLINT
         view_exclusion_options->depth_image.value()->dataConstPtr(),  // NOLINT
         view_exclusion_options->depth_image.value()->rows(),          // NOLINT
@@ -230,9 +341,9 @@ std::vector<Index3D> VoxelDecayer<LayerType>::decay(
     );
   } else {
     decayKernel<<<num_thread_blocks, kThreadsPerBlock, 0, cuda_stream>>>(
-        allocated_block_ptrs_device_.data(),  // NOLINT
-        voxel_decay_functor,                  // NOLINT
-        block_fully_decayed_device_.data()    // NOLINT
+        block_ptrs_device,                  // NOLINT
+        voxel_decay_functor,                // NOLINT
+        block_fully_decayed_device_.data()  // NOLINT
     );
   }
   checkCudaErrors(cudaPeekAtLastError());
@@ -243,21 +354,8 @@ std::vector<Index3D> VoxelDecayer<LayerType>::decay(
   cuda_stream.synchronize();
 
   // Check if nothing is lost on the way
-  CHECK(allocated_block_ptrs_host_.size() == block_ptrs_to_decay.size());
-  CHECK(allocated_block_ptrs_device_.size() == block_ptrs_to_decay.size());
-  CHECK(block_fully_decayed_device_.size() == block_ptrs_to_decay.size());
-  CHECK(block_fully_decayed_host_.size() == block_ptrs_to_decay.size());
-  if (view_exclusion_options) {
-    CHECK(allocated_block_indices_host_.size() == block_ptrs_to_decay.size());
-    CHECK(allocated_block_indices_device_.size() == block_ptrs_to_decay.size());
-  }
-
-  if (deallocate_decayed_blocks) {
-    return deallocateFullyDecayedBlocks(layer_ptr, block_indices_to_decay,
-                                        cuda_stream);
-  } else {
-    return std::vector<Index3D>();
-  }
+  CHECK(block_fully_decayed_device_.size() == static_cast<size_t>(num_blocks));
+  CHECK(block_fully_decayed_host_.size() == static_cast<size_t>(num_blocks));
 }
 
 template <class LayerType>
@@ -270,11 +368,50 @@ std::vector<Index3D> VoxelDecayer<LayerType>::deallocateFullyDecayedBlocks(
   deallocated_blocks.reserve(decayed_block_indices.size());
   for (size_t i = 0; i < decayed_block_indices.size(); ++i) {
     if (block_fully_decayed_host_[i]) {
-      layer_ptr->clearBlockAsync(decayed_block_indices[i], cuda_stream);
       deallocated_blocks.push_back(decayed_block_indices[i]);
     }
   }
+  // NOTE: Deallocating invalidates the layer's cached block lists, which
+  // decayed_block_indices may refer to. So we only clear once we're done with
+  // them.
+  layer_ptr->clearBlocksAsync(deallocated_blocks, cuda_stream);
   return deallocated_blocks;
 }
 
+template <class LayerType>
+void VoxelDecayer<LayerType>::updateFullyDecayedBlocks(
+    const std::vector<Index3D>& decayed_block_indices) {
+  CHECK_EQ(decayed_block_indices.size(), block_fully_decayed_host_.size());
+  for (size_t i = 0; i < decayed_block_indices.size(); ++i) {
+    if (block_fully_decayed_host_[i]) {
+      fully_decayed_blocks_.insert(decayed_block_indices[i]);
+    }
+  }
+}
+
+template <class LayerType>
+void VoxelDecayer<LayerType>::markBlocksAsActive(
+    const std::vector<Index3D>& block_indices) {
+  if (fully_decayed_blocks_.empty()) {
+    return;
+  }
+  for (const Index3D& block_index : block_indices) {
+    fully_decayed_blocks_.erase(block_index);
+  }
+}
+
+template <class LayerType>
+bool VoxelDecayer<LayerType>::skip_fully_decayed_blocks() const {
+  return skip_fully_decayed_blocks_;
+}
+
+template <class LayerType>
+void VoxelDecayer<LayerType>::skip_fully_decayed_blocks(
+    bool skip_fully_decayed_blocks) {
+  skip_fully_decayed_blocks_ = skip_fully_decayed_blocks;
+  if (!skip_fully_decayed_blocks_) {
+    fully_decayed_blocks_.clear();
+  }
+}
+
 }  // namespace nvblox
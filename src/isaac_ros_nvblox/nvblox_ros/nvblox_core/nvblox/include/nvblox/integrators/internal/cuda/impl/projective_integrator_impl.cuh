@@ -15,17 +15,23 @@ limitations under the License.
 */
 #pragma once
 
+#include <string>
+#include <type_traits>
 #include <vector>
 
 #include "nvblox/integrators/internal/projective_integrator.h"
 
 #include "nvblox/core/cuda_stream.h"
+#include "nvblox/core/hash.h"
+#include "nvblox/core/launch_autotuner.h"
 #include "nvblox/geometry/bounding_boxes.h"
 #include "nvblox/geometry/bounding_spheres.h"
 #include "nvblox/integrators/internal/cuda/projective_integrators_common.cuh"
 #include "nvblox/integrators/internal/integrators_common.h"
 #include "nvblox/integrators/weighting_function.h"
 #include "nvblox/interpolation/interpolation_2d.h"
+#include "nvblox/map/internal/cuda/voxel_block_threads.cuh"
+#include "nvblox/utils/gpu_timing.h"
 #include "nvblox/utils/timing.h"
 
 namespace nvblox {
@@ -36,66 +42,291 @@ namespace nvblox {
 
 namespace {
 
-std::pair<int, dim3> getLaunchSizes(int num_voxel_blocks) {
+std::pair<int, dim3> getLaunchSizes(
+    int num_voxel_blocks,
+    int thread_block_depth = VoxelBlock<bool>::kThreadBlockDepth) {
   // We call all kernels in this file with:
   // - One threadBlock per VoxelBlock
-  // - NxNxN threads where N is the block side-length in voxels.
-  constexpr int kVoxelsPerSide = VoxelBlock<bool>::kVoxelsPerSide;
-  const dim3 kThreadsPerBlock(kVoxelsPerSide, kVoxelsPerSide, kVoxelsPerSide);
+  // - NxNxD threads where N is the block side-length in voxels and D <= N
+  //   the thread block depth (see forEachVoxelInThread()).
   const int num_thread_blocks = num_voxel_blocks;
-  return {num_thread_blocks, kThreadsPerBlock};
+  const dim3 num_threads = voxelBlockThreadsPerBlock();
+  return {num_thread_blocks,
+          dim3(num_threads.x, num_threads.y, thread_block_depth)};
 }
 
+// The kernels in this file process any remaining voxels of a thread in a loop
+// (see forEachVoxelInThread()), so they can be launched with shallower thread
+// blocks. These are the depths tried by the LaunchAutotuner.
+const std::vector<int>& getThreadBlockDepthCandidates() {
+  static const std::vector<int> candidates = [] {
+    std::vector<int> depths;
+    for (int depth = VoxelBlock<bool>::kThreadBlockDepth; depth >= 1;
+         depth /= 2) {
+      depths.push_back(depth);
+    }
+    return depths;
+  }();
+  return candidates;
+}
+
+// Launches an integration kernel with the thread block depth selected by the
+// LaunchAutotuner.
+template <typename LaunchFunction>
+void launchWithTunedThreadBlockDepth(const std::string& kernel_name,
+                                     const LaunchFunction& launch_function,
+                                     const CudaStream& cuda_stream) {
+  LaunchAutotuner::getInstance().launch(
+      kernel_name, getThreadBlockDepthCandidates(),
+      VoxelBlock<bool>::kThreadBlockDepth, launch_function, cuda_stream);
+}
+
+// The checker used when interpolating a depth image. Integer depth can't be
+// NaN, invalid pixels are zero, which are handled by the update functors.
+template <typename DepthElementType>
+struct DepthPixelChecker {
+  using type = interpolation::checkers::PixelAlwaysValid<DepthElementType>;
+};
+template <>
+struct DepthPixelChecker<float> {
+  using type = interpolation::checkers::PixelNotNan<float>;
+};
+
 }  // namespace
 
+/*****************************************************************************
+ * Voxel change detection
+ ******************************************************************************/
+
+// Returns true if an update changed a voxel in a way which may affect the
+// surface extracted from the layer. Small changes (below the thresholds
+// below) are ignored, such that re-observing a static scene flags nothing.
+__device__ inline bool voxelSurfaceChanged(const TsdfVoxel& voxel_before,
+                                           const TsdfVoxel& voxel_after) {
+  // NOTE: The weight threshold matches the default mesh min_weight.
+  constexpr float kMinObservedWeight = 1e-4f;
+  constexpr float kMinDistanceChangeM = 1e-4f;
+  const bool observed_before = voxel_before.weight >= kMinObservedWeight;
+  const bool observed_after = voxel_after.weight >= kMinObservedWeight;
+  if (observed_before != observed_after) {
+    return true;
+  }
+  return observed_after &&
+         fabsf(voxel_after.distance - voxel_before.distance) >
+             kMinDistanceChangeM;
+}
+
+__device__ inline bool voxelSurfaceChanged(
+    const OccupancyVoxel& voxel_before, const OccupancyVoxel& voxel_after) {
+  constexpr float kMinLogOddsChange = 1e-4f;
+  return fabsf(voxel_after.log_odds - voxel_before.log_odds) >
+         kMinLogOddsChange;
+}
+
+// Flags the voxel addressed by this thread in the mask of this thread block's
+// VoxelBlock, if the voxel changed. Does nothing if no masks are requested.
+template <typename VoxelType>
+__device__ inline void flagVoxelIfSurfaceChanged(
+    const VoxelType& voxel_before, const VoxelType& voxel_after,
+    const Index3D& voxel_idx, VoxelBlockMask* updated_voxel_masks) {
+  if (updated_voxel_masks != nullptr &&
+      voxelSurfaceChanged(voxel_before, voxel_after)) {
+    updated_voxel_masks[blockIdx.x].setAtomic(voxelBlockMaskBit(voxel_idx));
+  }
+}
+
+// The labels updated by the camera kernel alongside the layer. Disabled if
+// block_ptrs is nullptr.
+struct LabelUpdate {
+  MonoImageConstView label_image;
+  // One per block, in the order of the layer's blocks.
+  LabelBlock** block_ptrs = nullptr;
+  // Voxels closer than this to the measured surface vote for its label.
+  float surface_band_m = 0.0f;
+  // Voxels further than this in front of the surface vote for free space.
+  float free_distance_m = 0.0f;
+};
+
+// Updates the label of the voxel addressed by this thread, see LabelUpdate.
+__device__ inline void updateThreadLabelVoxel(
+    const LabelUpdate& label_update, const Index2D& pix_pos, const int rows,
+    const int cols, const float voxel_to_surface_distance_m,
+    const bool is_masked, const Index3D& voxel_idx) {
+  if (voxel_to_surface_distance_m < -label_update.surface_band_m) {
+    return;
+  }
+  LabelVoxel* label_voxel_ptr =
+      &(label_update.block_ptrs[blockIdx.x]
+            ->voxels[voxel_idx.x()][voxel_idx.y()][voxel_idx.z()]);
+  if (voxel_to_surface_distance_m > label_update.free_distance_m) {
+    label_voxel_ptr->observeFree();
+  } else if (is_masked &&
+             voxel_to_surface_distance_m <= label_update.surface_band_m) {
+    // The label image may have another resolution than the (subsampled)
+    // depth image.
+    const int label_row = pix_pos.y() * label_update.label_image.rows() / rows;
+    const int label_col = pix_pos.x() * label_update.label_image.cols() / cols;
+    label_voxel_ptr->observeLabel(
+        label_update.label_image(label_row, label_col));
+  }
+}
+
 /*****************************************************************************
  * Kernels
  ******************************************************************************/
 
 // CAMERA
-template <typename VoxelType, typename UpdateFunctor>
+// Depth pixels are multiplied by depth_scale_m to get meters, which allows
+// integrating integer depth images directly.
+// @tparam kHasMask Whether the image has a mask attached. Without a mask all
+// pixels are masked, and the kernel skips the mask lookup.
+template <typename VoxelType, typename UpdateFunctor, typename DepthElementType,
+          bool kHasMask>
 __global__ void integrateBlocksKernel(
     const Index3D* block_indices_device_ptr, const Camera camera,
-    const MaskedDepthImageConstView image, const Transform T_C_L,
-    const float block_size, const float max_integration_distance,
-    UpdateFunctor* op, VoxelBlock<VoxelType>** block_device_ptrs) {
-  // Get - the image-space projection of the voxel associated with this thread
-  //     - the depth associated with the projection.
-  Eigen::Vector2f u_px;
-  float voxel_depth_m;
-  Vector3f p_voxel_center_C;
-  Index3D block_idx, voxel_idx;
-  voxelAndBlockIndexFromCudaThreadIndex(block_indices_device_ptr, &block_idx,
-                                        &voxel_idx);
-  if (!projectThreadVoxel(block_idx, voxel_idx, camera, T_C_L, block_size,
-                          max_integration_distance, &u_px, &voxel_depth_m,
-                          &p_voxel_center_C)) {
-    return;
-  }
+    const MaskedImageView<const DepthElementType> image,
+    const float depth_scale_m, const Transform T_C_L, const float block_size,
+    const float max_integration_distance, UpdateFunctor* op,
+    VoxelBlock<VoxelType>** block_device_ptrs,
+    VoxelBlockMask* updated_voxel_masks, VoxelBlockMask* in_view_voxel_masks,
+    const float in_view_occlusion_distance_m, const LabelUpdate label_update) {
+  const Index3D block_idx = block_indices_device_ptr[blockIdx.x];
+  forEachVoxelInThread([&](const Index3D& voxel_idx) {
+    // Get - the image-space projection of the voxel associated with this
+    //       thread
+    //     - the depth associated with the projection.
+    Eigen::Vector2f u_px;
+    float voxel_depth_m;
+    Vector3f p_voxel_center_C;
+    if (!projectThreadVoxel(block_idx, voxel_idx, camera, T_C_L, block_size,
+                            max_integration_distance, &u_px, &voxel_depth_m,
+                            &p_voxel_center_C)) {
+      return;
+    }
 
-  // Interpolate on the image plane
-  float image_value;
-  Index2D pix_pos;
-  if (!interpolation::interpolate2DClosest<
-          float, interpolation::checkers::PixelNotNan<float>>(
-          image.dataConstPtr(), u_px, image.rows(), image.cols(), &image_value,
-          &pix_pos)) {
-    return;
+    // Interpolate on the image plane
+    DepthElementType image_value_raw;
+    Index2D pix_pos;
+    if (!interpolation::interpolate2DClosest<
+            DepthElementType,
+            typename DepthPixelChecker<DepthElementType>::type>(
+            image.dataConstPtr(), u_px, image.rows(), image.cols(),
+            &image_value_raw, &pix_pos)) {
+      return;
+    }
+    const float image_value =
+        static_cast<float>(image_value_raw) * depth_scale_m;
+
+    // Record whether the voxel is in view. This is the test done by
+    // doesVoxelHaveDepthMeasurement(), reusing the projection above.
+    if (in_view_voxel_masks != nullptr && image_value > 0.0f &&
+        image_value - voxel_depth_m >= -in_view_occlusion_distance_m) {
+      in_view_voxel_masks[blockIdx.x].setAtomic(voxelBlockMaskBit(voxel_idx));
+    }
+
+    // Pixels of images without a mask are always masked.
+    bool is_masked = true;
+    if constexpr (kHasMask) {
+      is_masked = image.isMasked(pix_pos.y(), pix_pos.x());
+    }
+
+    // Update the label with the projection of the layer's update.
+    if (label_update.block_ptrs != nullptr && image_value > 0.0f) {
+      updateThreadLabelVoxel(label_update, pix_pos, image.rows(), image.cols(),
+                             image_value - voxel_depth_m, is_masked,
+                             voxel_idx);
+    }
+
+    // Get the Voxel we'll update in this thread
+    VoxelType* voxel_ptr = &(block_device_ptrs[blockIdx.x]->voxels
+                                 [voxel_idx.x()][voxel_idx.y()][voxel_idx.z()]);
+
+    // Update the voxel using the update rule for this layer type
+    const VoxelType voxel_before = *voxel_ptr;
+    (*op)(image_value, voxel_depth_m, is_masked, voxel_ptr);
+    flagVoxelIfSurfaceChanged(voxel_before, *voxel_ptr, voxel_idx,
+                              updated_voxel_masks);
+  });
+}
+
+// Launches the camera kernel above, with the mask lookup compiled in only for
+// images which have a mask attached.
+template <typename VoxelType, typename UpdateFunctor, typename DepthElementType>
+void launchIntegrateBlocksCameraKernel(
+    int num_thread_blocks, dim3 num_threads, const CudaStream& cuda_stream,
+    const Index3D* block_indices_device_ptr, const Camera& camera,
+    const MaskedImageView<const DepthElementType>& image,
+    const float depth_scale_m, const Transform& T_C_L, const float block_size,
+    const float max_integration_distance, UpdateFunctor* op,
+    VoxelBlock<VoxelType>** block_device_ptrs,
+    VoxelBlockMask* updated_voxel_masks, VoxelBlockMask* in_view_voxel_masks,
+    const float in_view_occlusion_distance_m, const LabelUpdate& label_update) {
+  if (image.mask().dataConstPtr() != nullptr) {
+    integrateBlocksKernel<VoxelType, UpdateFunctor, DepthElementType, true>
+        <<<num_thread_blocks, num_threads, 0, cuda_stream>>>(
+            block_indices_device_ptr, camera, image, depth_scale_m, T_C_L,
+            block_size, max_integration_distance, op, block_device_ptrs,
+            updated_voxel_masks, in_view_voxel_masks,
+            in_view_occlusion_distance_m, label_update);
+  } else {
+    integrateBlocksKernel<VoxelType, UpdateFunctor, DepthElementType, false>
+        <<<num_thread_blocks, num_threads, 0, cuda_stream>>>(
+            block_indices_device_ptr, camera, image, depth_scale_m, T_C_L,
+            block_size, max_integration_distance, op, block_device_ptrs,
+            updated_voxel_masks, in_view_voxel_masks,
+            in_view_occlusion_distance_m, label_update);
   }
+}
+
+// CAMERA (multiple views)
+template <typename VoxelType, typename UpdateFunctor>
+__global__ void integrateBlocksMultiViewKernel(
+    const Index3D* block_indices_device_ptr,
+    const ProjectiveCameraView* camera_views, const int num_views,
+    const float block_size, const float max_integration_distance,
+    UpdateFunctor* op, VoxelBlock<VoxelType>** block_device_ptrs,
+    VoxelBlockMask* updated_voxel_masks) {
+  const Index3D block_idx = block_indices_device_ptr[blockIdx.x];
+  forEachVoxelInThread([&](const Index3D& voxel_idx) {
+    // Get the Voxel we'll update in this thread
+    VoxelType* voxel_ptr = &(block_device_ptrs[blockIdx.x]->voxels
+                                 [voxel_idx.x()][voxel_idx.y()][voxel_idx.z()]);
+    const VoxelType voxel_before = *voxel_ptr;
+
+    // Fuse the views one after the other. Each view is handled exactly as in
+    // the single view kernel above.
+    for (int view_idx = 0; view_idx < num_views; view_idx++) {
+      const ProjectiveCameraView& view = camera_views[view_idx];
+
+      Eigen::Vector2f u_px;
+      float voxel_depth_m;
+      Vector3f p_voxel_center_C;
+      if (!projectThreadVoxel(block_idx, voxel_idx, view.camera, view.T_C_L,
+                              block_size, max_integration_distance, &u_px,
+                              &voxel_depth_m, &p_voxel_center_C)) {
+        continue;
+      }
 
-  // Note that isMasked is always true if there is no mask attached to the
-  // incoming image
-  const bool is_masked = image.isMasked(pix_pos.y(), pix_pos.x());
+      float image_value;
+      Index2D pix_pos;
+      if (!interpolation::interpolate2DClosest<
+              float, interpolation::checkers::PixelNotNan<float>>(
+              view.depth, u_px, view.rows, view.cols, &image_value,
+              &pix_pos)) {
+        continue;
+      }
 
-  // Get the Voxel we'll update in this thread
-  // NOTE(alexmillane): Note that we've reverse the voxel indexing order
-  // such that adjacent threads (x-major) access adjacent memory locations
-  // in the block (z-major).
-  VoxelType* voxel_ptr = &(block_device_ptrs[blockIdx.x]
-                               ->voxels[threadIdx.z][threadIdx.y][threadIdx.x]);
+      // No mask means that all pixels are masked.
+      const bool is_masked =
+          view.mask == nullptr ||
+          image::access(pix_pos.y(), pix_pos.x(),
+                        view.mask_stride_num_elements, view.mask);
 
-  // Update the voxel using the update rule for this layer type
-  (*op)(image_value, voxel_depth_m, is_masked, voxel_ptr);
+      (*op)(image_value, voxel_depth_m, is_masked, voxel_ptr);
+    }
+    flagVoxelIfSurfaceChanged(voxel_before, *voxel_ptr, voxel_idx,
+                              updated_voxel_masks);
+  });
 }
 
 // LIDAR
@@ -106,45 +337,101 @@ __global__ void integrateBlocksKernel(
     const float block_size, const float max_integration_distance,
     const float linear_interpolation_max_allowable_difference_m,
     const float nearest_interpolation_max_allowable_squared_dist_to_ray_m,
-    UpdateFunctor* op, VoxelBlock<VoxelType>** block_device_ptrs) {
-  // Get - the image-space projection of the voxel associated with this thread
-  //     - the depth associated with the projection.
-  Eigen::Vector2f u_px;
-  float voxel_depth_m;
-  Vector3f p_voxel_center_C;
-  Index3D block_idx, voxel_idx;
-  voxelAndBlockIndexFromCudaThreadIndex(block_indices_device_ptr, &block_idx,
-                                        &voxel_idx);
-  if (!projectThreadVoxel(block_idx, voxel_idx, lidar, T_C_L, block_size,
-                          max_integration_distance, &u_px, &voxel_depth_m,
-                          &p_voxel_center_C)) {
-    return;
-  }
+    UpdateFunctor* op, VoxelBlock<VoxelType>** block_device_ptrs,
+    VoxelBlockMask* updated_voxel_masks) {
+  const Index3D block_idx = block_indices_device_ptr[blockIdx.x];
+  forEachVoxelInThread([&](const Index3D& voxel_idx) {
+    // Get - the image-space projection of the voxel associated with this
+    //       thread
+    //     - the depth associated with the projection.
+    Eigen::Vector2f u_px;
+    float voxel_depth_m;
+    Vector3f p_voxel_center_C;
+    if (!projectThreadVoxel(block_idx, voxel_idx, lidar, T_C_L, block_size,
+                            max_integration_distance, &u_px, &voxel_depth_m,
+                            &p_voxel_center_C)) {
+      return;
+    }
 
-  // Interpolate on the image plane
-  float image_value;
-  Index2D pix_pos;
-  if (!interpolation::interpolateLidarImage(
-          lidar, p_voxel_center_C, image.dataConstPtr(), u_px, image.rows(),
-          image.cols(), linear_interpolation_max_allowable_difference_m,
-          nearest_interpolation_max_allowable_squared_dist_to_ray_m,
-          &image_value, &pix_pos)) {
-    return;
-  }
+    // Interpolate on the image plane
+    float image_value;
+    Index2D pix_pos;
+    if (!interpolation::interpolateLidarImage(
+            lidar, p_voxel_center_C, image.dataConstPtr(), u_px, image.rows(),
+            image.cols(), linear_interpolation_max_allowable_difference_m,
+            nearest_interpolation_max_allowable_squared_dist_to_ray_m,
+            &image_value, &pix_pos)) {
+      return;
+    }
 
-  // Note that isMasked is always true if there is no mask attached to the
-  // incoming image
-  const bool is_masked = image.isMasked(pix_pos.y(), pix_pos.x());
+    // Note that isMasked is always true if there is no mask attached to the
+    // incoming image
+    const bool is_masked = image.isMasked(pix_pos.y(), pix_pos.x());
 
-  // Get the Voxel we'll update in this thread
-  // NOTE(alexmillane): Note that we've reverse the voxel indexing order
-  // such that adjacent threads (x-major) access adjacent memory locations
-  // in the block (z-major).
-  VoxelType* voxel_ptr = &(block_device_ptrs[blockIdx.x]
-                               ->voxels[threadIdx.z][threadIdx.y][threadIdx.x]);
+    // Get the Voxel we'll update in this thread
+    VoxelType* voxel_ptr = &(block_device_ptrs[blockIdx.x]->voxels
+                                 [voxel_idx.x()][voxel_idx.y()][voxel_idx.z()]);
 
-  // Update the voxel using the update rule for this layer type
-  (*op)(image_value, voxel_depth_m, is_masked, voxel_ptr);
+    // Update the voxel using the update rule for this layer type
+    const VoxelType voxel_before = *voxel_ptr;
+    (*op)(image_value, voxel_depth_m, is_masked, voxel_ptr);
+    flagVoxelIfSurfaceChanged(voxel_before, *voxel_ptr, voxel_idx,
+                              updated_voxel_masks);
+  });
+}
+
+// LIDAR (multiple views)
+template <typename VoxelType, typename UpdateFunctor>
+__global__ void integrateBlocksMultiViewLidarKernel(
+    const Index3D* block_indices_device_ptr,
+    const ProjectiveLidarView* lidar_views, const int num_views,
+    const float block_size, const float max_integration_distance,
+    const float linear_interpolation_max_allowable_difference_m,
+    const float nearest_interpolation_max_allowable_squared_dist_to_ray_m,
+    UpdateFunctor* op, VoxelBlock<VoxelType>** block_device_ptrs,
+    VoxelBlockMask* updated_voxel_masks) {
+  const Index3D block_idx = block_indices_device_ptr[blockIdx.x];
+  forEachVoxelInThread([&](const Index3D& voxel_idx) {
+    // Get the Voxel we'll update in this thread
+    VoxelType* voxel_ptr = &(block_device_ptrs[blockIdx.x]->voxels
+                                 [voxel_idx.x()][voxel_idx.y()][voxel_idx.z()]);
+    const VoxelType voxel_before = *voxel_ptr;
+
+    // Fuse the views one after the other. Each view is handled exactly as in
+    // the single view LiDAR kernel.
+    for (int view_idx = 0; view_idx < num_views; view_idx++) {
+      const ProjectiveLidarView& view = lidar_views[view_idx];
+
+      Eigen::Vector2f u_px;
+      float voxel_depth_m;
+      Vector3f p_voxel_center_C;
+      if (!projectThreadVoxel(block_idx, voxel_idx, view.lidar, view.T_C_L,
+                              block_size, max_integration_distance, &u_px,
+                              &voxel_depth_m, &p_voxel_center_C)) {
+        continue;
+      }
+
+      float image_value;
+      Index2D pix_pos;
+      if (!interpolation::interpolateLidarImage(
+              view.lidar, p_voxel_center_C, view.depth, u_px, view.rows,
+              view.cols, linear_interpolation_max_allowable_difference_m,
+              nearest_interpolation_max_allowable_squared_dist_to_ray_m,
+              &image_value, &pix_pos)) {
+        continue;
+      }
+
+      // No mask means that all pixels are masked.
+      const bool is_masked =
+          view.mask == nullptr ||
+          image::access(pix_pos.y(), pix_pos.x(),
+                        view.mask_stride_num_elements, view.mask);
+
+      (*op)(image_value, voxel_depth_m, is_masked, voxel_ptr);
+    }
+    flagVoxelIfSurfaceChanged(voxel_before, *voxel_ptr, voxel_idx,
+                              updated_voxel_masks);
+  });
 }
 
 // COLOR
@@ -156,53 +443,52 @@ __global__ void integrateBlocksKernel(
     const Transform T_C_L, const float block_size,
     const float max_integration_distance, const int depth_subsample_factor,
     UpdateFunctor* op, ColorBlock** block_device_ptrs) {
-  // Get - the image-space projection of the voxel associated with this thread
-  //     - the depth associated with the projection.
-  Eigen::Vector2f u_px;
-  float voxel_depth_m;
-  Vector3f p_voxel_center_C;
-  Index3D block_idx, voxel_idx;
-  voxelAndBlockIndexFromCudaThreadIndex(block_indices_device_ptr, &block_idx,
-                                        &voxel_idx);
-  if (!projectThreadVoxel(block_idx, voxel_idx, camera, T_C_L, block_size,
-                          max_integration_distance, &u_px, &voxel_depth_m,
-                          &p_voxel_center_C)) {
-    return;
-  }
+  const Index3D block_idx = block_indices_device_ptr[blockIdx.x];
+  forEachVoxelInThread([&](const Index3D& voxel_idx) {
+    // Get - the image-space projection of the voxel associated with this
+    //       thread
+    //     - the depth associated with the projection.
+    Eigen::Vector2f u_px;
+    float voxel_depth_m;
+    Vector3f p_voxel_center_C;
+    if (!projectThreadVoxel(block_idx, voxel_idx, camera, T_C_L, block_size,
+                            max_integration_distance, &u_px, &voxel_depth_m,
+                            &p_voxel_center_C)) {
+      return;
+    }
 
-  const Eigen::Vector2f u_px_depth =
-      u_px / static_cast<float>(depth_subsample_factor);
-  float surface_depth_m;
-  if (!interpolation::interpolate2DLinear<float>(
-          depth_image, u_px_depth, depth_rows, depth_cols, &surface_depth_m)) {
-    return;
-  }
+    const Eigen::Vector2f u_px_depth =
+        u_px / static_cast<float>(depth_subsample_factor);
+    float surface_depth_m;
+    if (!interpolation::interpolate2DLinear<float>(depth_image, u_px_depth,
+                                                   depth_rows, depth_cols,
+                                                   &surface_depth_m)) {
+      return;
+    }
 
-  // Occlusion testing
-  // Get the distance of the voxel from the rendered surface. If outside
-  // truncation band, skip.
-  const float voxel_distance_from_surface = surface_depth_m - voxel_depth_m;
-  if (fabsf(voxel_distance_from_surface) > op->truncation_distance_m_) {
-    return;
-  }
+    // Occlusion testing
+    // Get the distance of the voxel from the rendered surface. If outside
+    // truncation band, skip.
+    const float voxel_distance_from_surface = surface_depth_m - voxel_depth_m;
+    if (fabsf(voxel_distance_from_surface) > op->truncation_distance_m_) {
+      return;
+    }
 
-  Color image_value;
-  if (!interpolation::interpolate2DLinear<
-          Color, interpolation::checkers::ColorPixelAlphaGreaterThanZero>(
-          color_image, u_px, color_rows, color_cols, &image_value)) {
-    return;
-  }
+    Color image_value;
+    if (!interpolation::interpolate2DLinear<
+            Color, interpolation::checkers::ColorPixelAlphaGreaterThanZero>(
+            color_image, u_px, color_rows, color_cols, &image_value)) {
+      return;
+    }
 
-  // Get the Voxel we'll update in this thread
-  // NOTE(alexmillane): Note that we've reverse the voxel indexing order such
-  // that adjacent threads (x-major) access adjacent memory locations in the
-  // block (z-major).
-  ColorVoxel* voxel_ptr =
-      &(block_device_ptrs[blockIdx.x]
-            ->voxels[threadIdx.z][threadIdx.y][threadIdx.x]);
+    // Get the Voxel we'll update in this thread
+    ColorVoxel* voxel_ptr =
+        &(block_device_ptrs[blockIdx.x]
+              ->voxels[voxel_idx.x()][voxel_idx.y()][voxel_idx.z()]);
 
-  // Update the voxel using the update rule for this layer type
-  (*op)(surface_depth_m, voxel_depth_m, image_value, voxel_ptr);
+    // Update the voxel using the update rule for this layer type
+    (*op)(surface_depth_m, voxel_depth_m, image_value, voxel_ptr);
+  });
 }
 
 /*****************************************************************************
@@ -215,10 +501,63 @@ template <typename UpdateFunctor>
 void ProjectiveIntegrator<VoxelType>::integrateFrame(
     const MaskedDepthImageConstView& depth_frame, const Transform& T_L_C,
     const Camera& camera, UpdateFunctor* op, VoxelBlockLayer<VoxelType>* layer,
-    std::vector<Index3D>* updated_blocks) {
+    std::vector<Index3D>* updated_blocks,
+    std::vector<VoxelBlockMask>* updated_voxel_masks) {
+  if (integration_subsampling_factor_ > 1) {
+    integrateFrameTemplate<Camera, UpdateFunctor>(
+        subsampleDepthFrameAsync(depth_frame), ColorImage(MemoryType::kDevice),
+        T_L_C, camera.downscaled(integration_subsampling_factor_), op, layer,
+        updated_blocks, updated_voxel_masks);
+    return;
+  }
   integrateFrameTemplate<Camera, UpdateFunctor>(
       depth_frame, ColorImage(MemoryType::kDevice), T_L_C, camera, op, layer,
-      updated_blocks);
+      updated_blocks, updated_voxel_masks);
+}
+
+// Camera (with labels)
+template <typename VoxelType>
+template <typename UpdateFunctor>
+void ProjectiveIntegrator<VoxelType>::integrateFrame(
+    const MaskedDepthImageConstView& depth_frame,
+    const MonoImageConstView& label_image, const Transform& T_L_C,
+    const Camera& camera, UpdateFunctor* op, VoxelBlockLayer<VoxelType>* layer,
+    LabelLayer* label_layer, std::vector<Index3D>* updated_blocks,
+    std::vector<VoxelBlockMask>* updated_voxel_masks) {
+  CHECK_NOTNULL(layer);
+  CHECK_NOTNULL(label_layer);
+  CHECK_GT(label_image.rows(), 0);
+  CHECK_GT(label_image.cols(), 0);
+  CHECK_EQ(label_layer->block_size(), layer->block_size());
+  label_image_ = label_image;
+  label_layer_ = label_layer;
+  integrateFrame(depth_frame, T_L_C, camera, op, layer, updated_blocks,
+                 updated_voxel_masks);
+  label_image_ = MonoImageConstView();
+  label_layer_ = nullptr;
+  label_layer->updateGpuHash(*cuda_stream_);
+}
+
+// Camera (integer depth)
+template <typename VoxelType>
+template <typename UpdateFunctor>
+void ProjectiveIntegrator<VoxelType>::integrateFrame(
+    const MaskedDepthImageU16ConstView& depth_frame, const float depth_scale_m,
+    const Transform& T_L_C, const Camera& camera, UpdateFunctor* op,
+    VoxelBlockLayer<VoxelType>* layer, std::vector<Index3D>* updated_blocks,
+    std::vector<VoxelBlockMask>* updated_voxel_masks) {
+  CHECK_GT(depth_scale_m, 0.0f);
+  if (integration_subsampling_factor_ > 1) {
+    integrateFrameTemplate<Camera, UpdateFunctor>(
+        subsampleDepthFrameAsync(depth_frame, depth_scale_m),
+        ColorImage(MemoryType::kDevice), T_L_C,
+        camera.downscaled(integration_subsampling_factor_), op, layer,
+        updated_blocks, updated_voxel_masks);
+    return;
+  }
+  integrateFrameTemplate<Camera, UpdateFunctor>(
+      depth_frame, ColorImage(MemoryType::kDevice), T_L_C, camera, op, layer,
+      updated_blocks, updated_voxel_masks, depth_scale_m);
 }
 
 // Lidar
@@ -227,10 +566,205 @@ template <typename UpdateFunctor>
 void ProjectiveIntegrator<VoxelType>::integrateFrame(
     const MaskedDepthImageConstView& depth_frame, const Transform& T_L_C,
     const Lidar& lidar, UpdateFunctor* op, VoxelBlockLayer<VoxelType>* layer,
-    std::vector<Index3D>* updated_blocks) {
+    std::vector<Index3D>* updated_blocks,
+    std::vector<VoxelBlockMask>* updated_voxel_masks) {
   integrateFrameTemplate<Lidar, UpdateFunctor>(
       depth_frame, ColorImage(MemoryType::kDevice), T_L_C, lidar, op, layer,
-      updated_blocks);
+      updated_blocks, updated_voxel_masks);
+}
+
+// Camera (multiple views)
+template <typename VoxelType>
+template <typename UpdateFunctor>
+void ProjectiveIntegrator<VoxelType>::integrateFrames(
+    const std::vector<MaskedDepthImageConstView>& depth_frames,
+    const std::vector<Transform>& T_L_C_vec,
+    const std::vector<Camera>& cameras, UpdateFunctor* op,
+    VoxelBlockLayer<VoxelType>* layer_ptr,
+    std::vector<Index3D>* updated_blocks,
+    std::vector<VoxelBlockMask>* updated_voxel_masks) {
+  CHECK_NOTNULL(layer_ptr);
+  CHECK_NOTNULL(op);
+  CHECK_EQ(depth_frames.size(), T_L_C_vec.size());
+  CHECK_EQ(depth_frames.size(), cameras.size());
+  using BlockType = VoxelBlock<VoxelType>;
+  if (!integrator_name_initialized_) {
+    integrator_name_ = getIntegratorName();
+  }
+
+  timing::Timer integration_timer(integrator_name_ + "/integrate_batch");
+
+  // Identify blocks we can (potentially) see in any of the views. Views that
+  // see nothing are dropped from the batch.
+  timing::Timer blocks_in_view_timer(integrator_name_ +
+                                     "/integrate_batch/get_blocks_in_view");
+  const float max_integration_distance_behind_surface_m =
+      truncation_distance_vox_ * layer_ptr->voxel_size();
+  Index3DSet block_indices_set;
+  camera_views_host_.clearNoDeallocate();
+  for (size_t i = 0; i < depth_frames.size(); i++) {
+    const std::vector<Index3D> view_block_indices =
+        view_calculator_.getBlocksInImageViewRaycast(
+            depth_frames[i], T_L_C_vec[i], cameras[i], layer_ptr->block_size(),
+            max_integration_distance_behind_surface_m,
+            max_integration_distance_m_);
+    if (view_block_indices.empty()) {
+      continue;
+    }
+    block_indices_set.insert(view_block_indices.begin(),
+                             view_block_indices.end());
+
+    ProjectiveCameraView view;
+    view.camera = cameras[i];
+    view.T_C_L = T_L_C_vec[i].inverse();
+    view.depth = depth_frames[i].dataConstPtr();
+    view.mask = depth_frames[i].mask().dataConstPtr();
+    view.rows = depth_frames[i].rows();
+    view.cols = depth_frames[i].cols();
+    view.mask_stride_num_elements =
+        depth_frames[i].mask().stride_num_elements();
+    camera_views_host_.push_back(view, *cuda_stream_);
+  }
+  const std::vector<Index3D> block_indices(block_indices_set.begin(),
+                                           block_indices_set.end());
+  blocks_in_view_timer.Stop();
+
+  // Masks of in-view voxels are only recorded for single views.
+  in_view_voxel_masks_device_.clearNoDeallocate();
+
+  // Return if we don't see anything
+  if (block_indices.empty()) {
+    if (updated_blocks != nullptr) {
+      updated_blocks->clear();
+    }
+    if (updated_voxel_masks != nullptr) {
+      updated_voxel_masks->clear();
+    }
+    return;
+  }
+
+  // Allocate blocks and move them, and the views, to GPU for update
+  allocateAndTransferBlocks(block_indices, layer_ptr,
+                            integrator_name_ + "/integrate_batch");
+  camera_views_device_.copyFromAsync(camera_views_host_, *cuda_stream_);
+
+  // Update identified blocks
+  timing::Timer update_blocks_timer(integrator_name_ +
+                                    "/integrate_batch/update_blocks");
+  timing::GpuTimer update_blocks_gpu_timer(
+      integrator_name_ + "/integrate_batch/update_blocks", *cuda_stream_);
+  VoxelBlockMask* updated_voxel_masks_device =
+      prepareUpdatedVoxelMasks(updated_voxel_masks != nullptr);
+  integrateBlocksMultiView(static_cast<int>(camera_views_host_.size()), op,
+                           layer_ptr, updated_voxel_masks_device);
+  update_blocks_timer.Stop();
+  update_blocks_gpu_timer.Stop();
+
+  if (updated_blocks != nullptr) {
+    *updated_blocks = block_indices;
+  }
+  if (updated_voxel_masks != nullptr) {
+    *updated_voxel_masks =
+        updated_voxel_masks_device_.toVectorAsync(*cuda_stream_);
+    cuda_stream_->synchronize();
+  }
+}
+
+// Lidar (multiple views)
+template <typename VoxelType>
+template <typename UpdateFunctor>
+void ProjectiveIntegrator<VoxelType>::integrateFrames(
+    const std::vector<MaskedDepthImageConstView>& depth_frames,
+    const std::vector<Transform>& T_L_C_vec, const std::vector<Lidar>& lidars,
+    UpdateFunctor* op, VoxelBlockLayer<VoxelType>* layer_ptr,
+    std::vector<Index3D>* updated_blocks,
+    std::vector<VoxelBlockMask>* updated_voxel_masks) {
+  CHECK_NOTNULL(layer_ptr);
+  CHECK_NOTNULL(op);
+  CHECK_EQ(depth_frames.size(), T_L_C_vec.size());
+  CHECK_EQ(depth_frames.size(), lidars.size());
+  if (!integrator_name_initialized_) {
+    integrator_name_ = getIntegratorName();
+  }
+
+  timing::Timer integration_timer(integrator_name_ + "/integrate_lidar_batch");
+
+  // Identify blocks we can (potentially) see in any of the scans. Scans that
+  // see nothing are dropped from the batch.
+  timing::Timer blocks_in_view_timer(
+      integrator_name_ + "/integrate_lidar_batch/get_blocks_in_view");
+  const float max_integration_distance_behind_surface_m =
+      truncation_distance_vox_ * layer_ptr->voxel_size();
+  Index3DSet block_indices_set;
+  lidar_views_host_.clearNoDeallocate();
+  for (size_t i = 0; i < depth_frames.size(); i++) {
+    const std::vector<Index3D> view_block_indices =
+        view_calculator_.getBlocksInImageViewRaycast(
+            depth_frames[i], T_L_C_vec[i], lidars[i], layer_ptr->block_size(),
+            max_integration_distance_behind_surface_m,
+            max_integration_distance_m_);
+    if (view_block_indices.empty()) {
+      continue;
+    }
+    block_indices_set.insert(view_block_indices.begin(),
+                             view_block_indices.end());
+
+    // The projection mode travels with the (by value) lidar.
+    ProjectiveLidarView view(lidars[i], T_L_C_vec[i].inverse());
+    if (lidar_approximate_projection_) {
+      view.lidar.approximate_projection(true);
+    }
+    view.depth = depth_frames[i].dataConstPtr();
+    view.mask = depth_frames[i].mask().dataConstPtr();
+    view.rows = depth_frames[i].rows();
+    view.cols = depth_frames[i].cols();
+    view.mask_stride_num_elements =
+        depth_frames[i].mask().stride_num_elements();
+    lidar_views_host_.push_back(view, *cuda_stream_);
+  }
+  const std::vector<Index3D> block_indices(block_indices_set.begin(),
+                                           block_indices_set.end());
+  blocks_in_view_timer.Stop();
+
+  in_view_voxel_masks_device_.clearNoDeallocate();
+
+  // Return if we don't see anything
+  if (block_indices.empty()) {
+    if (updated_blocks != nullptr) {
+      updated_blocks->clear();
+    }
+    if (updated_voxel_masks != nullptr) {
+      updated_voxel_masks->clear();
+    }
+    return;
+  }
+
+  // Allocate blocks and move them, and the views, to GPU for update
+  allocateAndTransferBlocks(block_indices, layer_ptr,
+                            integrator_name_ + "/integrate_lidar_batch");
+  lidar_views_device_.copyFromAsync(lidar_views_host_, *cuda_stream_);
+
+  // Update identified blocks
+  timing::Timer update_blocks_timer(integrator_name_ +
+                                    "/integrate_lidar_batch/update_blocks");
+  timing::GpuTimer update_blocks_gpu_timer(
+      integrator_name_ + "/integrate_lidar_batch/update_blocks",
+      *cuda_stream_);
+  VoxelBlockMask* updated_voxel_masks_device =
+      prepareUpdatedVoxelMasks(updated_voxel_masks != nullptr);
+  integrateBlocksMultiViewLidar(static_cast<int>(lidar_views_host_.size()),
+                                op, layer_ptr, updated_voxel_masks_device);
+  update_blocks_timer.Stop();
+  update_blocks_gpu_timer.Stop();
+
+  if (updated_blocks != nullptr) {
+    *updated_blocks = block_indices;
+  }
+  if (updated_voxel_masks != nullptr) {
+    *updated_voxel_masks =
+        updated_voxel_masks_device_.toVectorAsync(*cuda_stream_);
+    cuda_stream_->synchronize();
+  }
 }
 
 /*****************************************************************************
@@ -242,12 +776,18 @@ void ProjectiveIntegrator<VoxelType>::integrateFrame(
  ******************************************************************************/
 
 template <typename VoxelType>
-template <typename SensorType, typename UpdateFunctor>
+template <typename SensorType, typename UpdateFunctor, typename DepthFrameType>
 void ProjectiveIntegrator<VoxelType>::integrateFrameTemplate(
-    const MaskedDepthImageConstView& depth_frame, const ColorImage& color_frame,
+    const DepthFrameType& depth_frame, const ColorImage& color_frame,
     const Transform& T_L_C, const SensorType& sensor, UpdateFunctor* op,
     VoxelBlockLayer<VoxelType>* layer_ptr,
-    std::vector<Index3D>* updated_blocks) {
+    std::vector<Index3D>* updated_blocks,
+    std::vector<VoxelBlockMask>* updated_voxel_masks,
+    const float depth_scale_m) {
+  constexpr bool kIsIntegerDepth =
+      std::is_same_v<DepthFrameType, MaskedDepthImageU16ConstView>;
+  static_assert(!kIsIntegerDepth || std::is_same_v<SensorType, Camera>,
+                "Integer depth images are only supported for cameras.");
   CHECK_NOTNULL(layer_ptr);
   CHECK_NOTNULL(op);
   using BlockType = VoxelBlock<VoxelType>;
@@ -262,44 +802,179 @@ void ProjectiveIntegrator<VoxelType>::integrateFrameTemplate(
                                      "/integrate/get_blocks_in_view");
   const float max_integration_distance_behind_surface_m =
       truncation_distance_vox_ * layer_ptr->voxel_size();
-  const std::vector<Index3D> block_indices =
-      view_calculator_.getBlocksInImageViewRaycast(
-          depth_frame, T_L_C, sensor, layer_ptr->block_size(),
-          max_integration_distance_behind_surface_m,
-          max_integration_distance_m_);
+  std::vector<Index3D> block_indices;
+  if constexpr (kIsIntegerDepth) {
+    block_indices = view_calculator_.getBlocksInImageViewRaycast(
+        depth_frame, depth_scale_m, T_L_C, sensor, layer_ptr->block_size(),
+        max_integration_distance_behind_surface_m, max_integration_distance_m_);
+  } else {
+    block_indices = view_calculator_.getBlocksInImageViewRaycast(
+        depth_frame, T_L_C, sensor, layer_ptr->block_size(),
+        max_integration_distance_behind_surface_m, max_integration_distance_m_);
+  }
   blocks_in_view_timer.Stop();
 
+  // Filled by the camera kernel (if requested).
+  in_view_voxel_masks_device_.clearNoDeallocate();
+
   // Return if we don't see anything
   if (block_indices.empty()) {
+    if (updated_voxel_masks != nullptr) {
+      updated_voxel_masks->clear();
+    }
+    return;
+  }
+
+  // Allocate blocks and move them to GPU for update
+  allocateAndTransferBlocks(block_indices, layer_ptr,
+                            integrator_name_ + "/integrate");
+  allocateAndTransferLabelBlocks(block_indices);
+
+  // Update identified blocks
+  timing::Timer update_blocks_timer(integrator_name_ +
+                                    "/integrate/update_blocks");
+  timing::GpuTimer update_blocks_gpu_timer(
+      integrator_name_ + "/integrate/update_blocks", *cuda_stream_);
+  const Transform T_C_L = T_L_C.inverse();
+  VoxelBlockMask* updated_voxel_masks_device =
+      prepareUpdatedVoxelMasks(updated_voxel_masks != nullptr);
+  if constexpr (kIsIntegerDepth) {
+    integrateBlocks(depth_frame, depth_scale_m, T_C_L, sensor, op, layer_ptr,
+                    updated_voxel_masks_device);
+  } else {
+    integrateBlocks(depth_frame, color_frame, T_C_L, sensor, op, layer_ptr,
+                    updated_voxel_masks_device);
+  }
+  update_blocks_timer.Stop();
+  update_blocks_gpu_timer.Stop();
+
+  if (updated_blocks != nullptr) {
+    *updated_blocks = block_indices;
+  }
+  if (updated_voxel_masks != nullptr) {
+    *updated_voxel_masks =
+        updated_voxel_masks_device_.toVectorAsync(*cuda_stream_);
+    cuda_stream_->synchronize();
+  }
+}
+
+template <typename VoxelType>
+template <typename DepthFrameType>
+MaskedDepthImageConstView
+ProjectiveIntegrator<VoxelType>::subsampleDepthFrameAsync(
+    const DepthFrameType& depth_frame, const float depth_scale_m) {
+  if (!integrator_name_initialized_) {
+    integrator_name_ = getIntegratorName();
+  }
+  timing::Timer subsample_timer(integrator_name_ + "/integrate/subsample");
+  constexpr bool kIsIntegerDepth =
+      std::is_same_v<DepthFrameType, MaskedDepthImageU16ConstView>;
+  const bool has_mask = depth_frame.mask().dataConstPtr() != nullptr;
+  if constexpr (kIsIntegerDepth) {
+    image::minDownscaleGPUAsync(depth_frame, depth_scale_m,
+                                integration_subsampling_factor_,
+                                &subsampled_depth_frame_, &subsampled_mask_,
+                                *cuda_stream_);
+  } else {
+    // The pyramid holds the nearest depth of each patch already, but doesn't
+    // know about the mask.
+    const DepthPyramid* depth_pyramid = view_calculator_.depth_pyramid();
+    const int pyramid_level = DepthPyramid::levelForSubsamplingFactor(
+        integration_subsampling_factor_);
+    if (!has_mask && pyramid_level > 0 && depth_pyramid != nullptr &&
+        depth_pyramid->isBuiltFrom(depth_frame.dataConstPtr(),
+                                   depth_frame.rows(), depth_frame.cols())) {
+      depth_pyramid->minDepthToImageAsync(
+          pyramid_level, &subsampled_depth_frame_, *cuda_stream_);
+    } else {
+      image::minDownscaleGPUAsync(depth_frame, integration_subsampling_factor_,
+                                  &subsampled_depth_frame_, &subsampled_mask_,
+                                  *cuda_stream_);
+    }
+  }
+  return has_mask ? MaskedDepthImageConstView(subsampled_depth_frame_,
+                                              subsampled_mask_)
+                  : MaskedDepthImageConstView(subsampled_depth_frame_);
+}
+
+template <typename VoxelType>
+VoxelBlockMask* ProjectiveIntegrator<VoxelType>::prepareUpdatedVoxelMasks(
+    bool masks_requested) {
+  if (!masks_requested) {
+    return nullptr;
+  }
+  updated_voxel_masks_device_.resizeAsync(block_indices_device_.size(),
+                                          *cuda_stream_);
+  updated_voxel_masks_device_.setZeroAsync(*cuda_stream_);
+  return updated_voxel_masks_device_.data();
+}
+
+template <typename VoxelType>
+VoxelBlockMask* ProjectiveIntegrator<VoxelType>::prepareInViewVoxelMasks() {
+  if (!in_view_occlusion_distance_m_.has_value()) {
+    return nullptr;
+  }
+  in_view_voxel_masks_device_.resizeAsync(block_indices_device_.size(),
+                                          *cuda_stream_);
+  in_view_voxel_masks_device_.setZeroAsync(*cuda_stream_);
+  return in_view_voxel_masks_device_.data();
+}
+
+template <typename VoxelType>
+void ProjectiveIntegrator<VoxelType>::allocateAndTransferBlocks(
+    const std::vector<Index3D>& block_indices,
+    VoxelBlockLayer<VoxelType>* layer_ptr, const std::string& timer_prefix) {
+  using BlockType = VoxelBlock<VoxelType>;
+  // Snapshots of the layer get a copy of the blocks before we write them.
+  layer_ptr->prepareBlocksForWriteAsync(block_indices, *cuda_stream_);
+  if (allocate_blocks_on_gpu_) {
+    // Allocate blocks (GPU). Pointers are looked up in the GPU hash, such
+    // that the CPU hash is only touched when someone needs it.
+    timing::Timer allocate_blocks_timer(timer_prefix +
+                                        "/allocate_blocks_on_gpu");
+    transferBlocksIndicesToDevice(block_indices, *cuda_stream_,
+                                  &block_indices_host_,
+                                  &block_indices_device_);
+    layer_ptr->allocateBlocksAtIndicesOnGpuAsync(block_indices_device_,
+                                                 *cuda_stream_);
+    layer_ptr->getBlockPointersOnGpuAsync(block_indices_device_,
+                                          &block_ptrs_device_, *cuda_stream_);
     return;
   }
 
   // Allocate blocks (CPU)
-  timing::Timer allocate_blocks_timer(integrator_name_ +
-                                      "/integrate/allocate_blocks");
+  timing::Timer allocate_blocks_timer(timer_prefix + "/allocate_blocks");
   allocateBlocksWhereRequired(block_indices, layer_ptr, *cuda_stream_);
   allocate_blocks_timer.Stop();
 
+  // Migrate the blocks in view to the GPU ahead of the update kernels. Only
+  // has an effect for layers in unified memory. The GPU allocation path above
+  // skips this, as looking up the blocks would synchronize the CPU hash.
+  layer_ptr->prefetchBlocksAsync(block_indices, UnifiedMemoryLocation::kDevice,
+                                 *cuda_stream_);
+
   // Move blocks to GPU for update
-  timing::Timer transfer_blocks_timer(integrator_name_ +
-                                      "/integrate/transfer_blocks");
+  timing::Timer transfer_blocks_timer(timer_prefix + "/transfer_blocks");
   transferBlockPointersToDevice<BlockType>(block_indices, *cuda_stream_,
                                            layer_ptr, &block_ptrs_host_,
                                            &block_ptrs_device_);
   transferBlocksIndicesToDevice(block_indices, *cuda_stream_,
                                 &block_indices_host_, &block_indices_device_);
   transfer_blocks_timer.Stop();
+}
 
-  // Update identified blocks
-  timing::Timer update_blocks_timer(integrator_name_ +
-                                    "/integrate/update_blocks");
-  const Transform T_C_L = T_L_C.inverse();
-  integrateBlocks(depth_frame, color_frame, T_C_L, sensor, op, layer_ptr);
-  update_blocks_timer.Stop();
-
-  if (updated_blocks != nullptr) {
-    *updated_blocks = block_indices;
+template <typename VoxelType>
+void ProjectiveIntegrator<VoxelType>::allocateAndTransferLabelBlocks(
+    const std::vector<Index3D>& block_indices) {
+  if (label_layer_ == nullptr) {
+    return;
   }
+  timing::Timer label_blocks_timer(integrator_name_ +
+                                   "/integrate/allocate_label_blocks");
+  allocateBlocksWhereRequired(block_indices, label_layer_, *cuda_stream_);
+  transferBlockPointersToDevice<LabelBlock>(
+      block_indices, *cuda_stream_, label_layer_, &label_block_ptrs_host_,
+      &label_block_ptrs_device_);
 }
 
 /*****************************************************************************
@@ -314,20 +989,92 @@ template <typename UpdateFunctor>
 void ProjectiveIntegrator<VoxelType>::integrateBlocks(
     const MaskedDepthImageConstView& depth_frame, const ColorImage&, /*unused*/
     const Transform& T_C_L, const Camera& camera, UpdateFunctor* op,
-    VoxelBlockLayer<VoxelType>* layer_ptr) {
+    VoxelBlockLayer<VoxelType>* layer_ptr,
+    VoxelBlockMask* updated_voxel_masks_device) {
+  VoxelBlockMask* in_view_voxel_masks_device = prepareInViewVoxelMasks();
+  const float in_view_occlusion_distance_m =
+      in_view_occlusion_distance_m_.value_or(0.0f);
+  LabelUpdate label_update;
+  if (label_layer_ != nullptr) {
+    label_update.label_image = label_image_;
+    label_update.block_ptrs = label_block_ptrs_device_.data();
+    label_update.surface_band_m = layer_ptr->voxel_size();
+    label_update.free_distance_m =
+        get_truncation_distance_m(layer_ptr->voxel_size());
+  }
+
+  // Kernel
+  const auto launch_kernel = [&](int thread_block_depth) {
+    const auto [num_thread_blocks, num_threads] =
+        getLaunchSizes(block_indices_device_.size(), thread_block_depth);
+    launchIntegrateBlocksCameraKernel(
+        num_thread_blocks, num_threads,  // NOLINT
+        *cuda_stream_,                   // NOLINT
+        block_indices_device_.data(),    // NOLINT
+        camera,                          // NOLINT
+        depth_frame,                     // NOLINT
+        1.0f,                            // NOLINT
+        T_C_L,                           // NOLINT
+        layer_ptr->block_size(),         // NOLINT
+        max_integration_distance_m_,     // NOLINT
+        op,                              // NOLINT
+        block_ptrs_device_.data(),       // NOLINT
+        updated_voxel_masks_device,      // NOLINT
+        in_view_voxel_masks_device,      // NOLINT
+        in_view_occlusion_distance_m,    // NOLINT
+        label_update);                   // NOLINT
+  };
+  launchWithTunedThreadBlockDepth(
+      integrator_name_ + "/integrate_blocks/camera", launch_kernel,
+      *cuda_stream_);
+  cuda_stream_->synchronize();
+  checkCudaErrors(cudaPeekAtLastError());
+}
+
+// Camera (integer depth)
+template <typename VoxelType>
+template <typename UpdateFunctor>
+void ProjectiveIntegrator<VoxelType>::integrateBlocks(
+    const MaskedDepthImageU16ConstView& depth_frame, const float depth_scale_m,
+    const Transform& T_C_L, const Camera& camera, UpdateFunctor* op,
+    VoxelBlockLayer<VoxelType>* layer_ptr,
+    VoxelBlockMask* updated_voxel_masks_device) {
+  VoxelBlockMask* in_view_voxel_masks_device = prepareInViewVoxelMasks();
+  const float in_view_occlusion_distance_m =
+      in_view_occlusion_distance_m_.value_or(0.0f);
+  LabelUpdate label_update;
+  if (label_layer_ != nullptr) {
+    label_update.label_image = label_image_;
+    label_update.block_ptrs = label_block_ptrs_device_.data();
+    label_update.surface_band_m = layer_ptr->voxel_size();
+    label_update.free_distance_m =
+        get_truncation_distance_m(layer_ptr->voxel_size());
+  }
+
   // Kernel
-  const auto [num_thread_blocks, num_threads] =
-      getLaunchSizes(block_indices_device_.size());
-  integrateBlocksKernel<<<num_thread_blocks, num_threads, 0,
-                          *cuda_stream_>>>(
-      block_indices_device_.data(),  // NOLINT
-      camera,                        // NOLINT
-      depth_frame,                   // NOLINT
-      T_C_L,                         // NOLINT
-      layer_ptr->block_size(),       // NOLINT
-      max_integration_distance_m_,   // NOLINT
-      op,                            // NOLINT
-      block_ptrs_device_.data());    // NOLINT
+  const auto launch_kernel = [&](int thread_block_depth) {
+    const auto [num_thread_blocks, num_threads] =
+        getLaunchSizes(block_indices_device_.size(), thread_block_depth);
+    launchIntegrateBlocksCameraKernel(
+        num_thread_blocks, num_threads,  // NOLINT
+        *cuda_stream_,                   // NOLINT
+        block_indices_device_.data(),    // NOLINT
+        camera,                          // NOLINT
+        depth_frame,                     // NOLINT
+        depth_scale_m,                   // NOLINT
+        T_C_L,                           // NOLINT
+        layer_ptr->block_size(),         // NOLINT
+        max_integration_distance_m_,     // NOLINT
+        op,                              // NOLINT
+        block_ptrs_device_.data(),       // NOLINT
+        updated_voxel_masks_device,      // NOLINT
+        in_view_voxel_masks_device,      // NOLINT
+        in_view_occlusion_distance_m,    // NOLINT
+        label_update);                   // NOLINT
+  };
+  launchWithTunedThreadBlockDepth(
+      integrator_name_ + "/integrate_blocks/camera_u16", launch_kernel,
+      *cuda_stream_);
   cuda_stream_->synchronize();
   checkCudaErrors(cudaPeekAtLastError());
 }
@@ -338,7 +1085,84 @@ template <typename UpdateFunctor>
 void ProjectiveIntegrator<VoxelType>::integrateBlocks(
     const MaskedDepthImageConstView& depth_frame, const ColorImage&, /*unused*/
     const Transform& T_C_L, const Lidar& lidar, UpdateFunctor* op,
-    VoxelBlockLayer<VoxelType>* layer_ptr) {
+    VoxelBlockLayer<VoxelType>* layer_ptr,
+    VoxelBlockMask* updated_voxel_masks_device) {
+  // Metric params - LiDAR specific
+  const float voxel_size = layer_ptr->voxel_size();
+  const float linear_interpolation_max_allowable_difference_m =
+      lidar_linear_interpolation_max_allowable_difference_vox_ * voxel_size;
+  const float nearest_interpolation_max_allowable_squared_dist_to_ray_m =
+      std::pow(lidar_nearest_interpolation_max_allowable_dist_to_ray_vox_ *
+                   voxel_size,
+               2);
+
+  // The projection mode travels with the (by value) lidar.
+  Lidar projecting_lidar = lidar;
+  if (lidar_approximate_projection_) {
+    projecting_lidar.approximate_projection(true);
+  }
+
+  // Kernel
+  const auto launch_kernel = [&](int thread_block_depth) {
+    const auto [num_thread_blocks, num_threads] =
+        getLaunchSizes(block_indices_device_.size(), thread_block_depth);
+    integrateBlocksKernel<<<num_thread_blocks, num_threads, 0,
+                            *cuda_stream_>>>(
+        block_indices_device_.data(),                               // NOLINT
+        projecting_lidar,                                           // NOLINT
+        depth_frame,                                                // NOLINT
+        T_C_L,                                                      // NOLINT
+        layer_ptr->block_size(),                                    // NOLINT
+        max_integration_distance_m_,                                // NOLINT
+        linear_interpolation_max_allowable_difference_m,            // NOLINT
+        nearest_interpolation_max_allowable_squared_dist_to_ray_m,  // NOLINT
+        op,                                                         // NOLINT
+        block_ptrs_device_.data(),                                  // NOLINT
+        updated_voxel_masks_device);                                // NOLINT
+  };
+  launchWithTunedThreadBlockDepth(
+      integrator_name_ + "/integrate_blocks/lidar", launch_kernel,
+      *cuda_stream_);
+  cuda_stream_->synchronize();
+  checkCudaErrors(cudaPeekAtLastError());
+}
+
+// Camera (multiple views)
+template <typename VoxelType>
+template <typename UpdateFunctor>
+void ProjectiveIntegrator<VoxelType>::integrateBlocksMultiView(
+    const int num_views, UpdateFunctor* op,
+    VoxelBlockLayer<VoxelType>* layer_ptr,
+    VoxelBlockMask* updated_voxel_masks_device) {
+  // Kernel
+  const auto launch_kernel = [&](int thread_block_depth) {
+    const auto [num_thread_blocks, num_threads] =
+        getLaunchSizes(block_indices_device_.size(), thread_block_depth);
+    integrateBlocksMultiViewKernel<<<num_thread_blocks, num_threads, 0,
+                                     *cuda_stream_>>>(
+        block_indices_device_.data(),  // NOLINT
+        camera_views_device_.data(),   // NOLINT
+        num_views,                     // NOLINT
+        layer_ptr->block_size(),       // NOLINT
+        max_integration_distance_m_,   // NOLINT
+        op,                            // NOLINT
+        block_ptrs_device_.data(),     // NOLINT
+        updated_voxel_masks_device);   // NOLINT
+  };
+  launchWithTunedThreadBlockDepth(
+      integrator_name_ + "/integrate_blocks/multi_view", launch_kernel,
+      *cuda_stream_);
+  cuda_stream_->synchronize();
+  checkCudaErrors(cudaPeekAtLastError());
+}
+
+// Lidar (multiple views)
+template <typename VoxelType>
+template <typename UpdateFunctor>
+void ProjectiveIntegrator<VoxelType>::integrateBlocksMultiViewLidar(
+    const int num_views, UpdateFunctor* op,
+    VoxelBlockLayer<VoxelType>* layer_ptr,
+    VoxelBlockMask* updated_voxel_masks_device) {
   // Metric params - LiDAR specific
   const float voxel_size = layer_ptr->voxel_size();
   const float linear_interpolation_max_allowable_difference_m =
@@ -349,20 +1173,25 @@ void ProjectiveIntegrator<VoxelType>::integrateBlocks(
                2);
 
   // Kernel
-  const auto [num_thread_blocks, num_threads] =
-      getLaunchSizes(block_indices_device_.size());
-  integrateBlocksKernel<<<num_thread_blocks, num_threads, 0,
-                          *cuda_stream_>>>(
-      block_indices_device_.data(),                               // NOLINT
-      lidar,                                                      // NOLINT
-      depth_frame,                                                // NOLINT
-      T_C_L,                                                      // NOLINT
-      layer_ptr->block_size(),                                    // NOLINT
-      max_integration_distance_m_,                                // NOLINT
-      linear_interpolation_max_allowable_difference_m,            // NOLINT
-      nearest_interpolation_max_allowable_squared_dist_to_ray_m,  // NOLINT
-      op,                                                         // NOLINT
-      block_ptrs_device_.data());                                 // NOLINT
+  const auto launch_kernel = [&](int thread_block_depth) {
+    const auto [num_thread_blocks, num_threads] =
+        getLaunchSizes(block_indices_device_.size(), thread_block_depth);
+    integrateBlocksMultiViewLidarKernel<<<num_thread_blocks, num_threads, 0,
+                                          *cuda_stream_>>>(
+        block_indices_device_.data(),                               // NOLINT
+        lidar_views_device_.data(),                                 // NOLINT
+        num_views,                                                  // NOLINT
+        layer_ptr->block_size(),                                    // NOLINT
+        max_integration_distance_m_,                                // NOLINT
+        linear_interpolation_max_allowable_difference_m,            // NOLINT
+        nearest_interpolation_max_allowable_squared_dist_to_ray_m,  // NOLINT
+        op,                                                         // NOLINT
+        block_ptrs_device_.data(),                                  // NOLINT
+        updated_voxel_masks_device);                                // NOLINT
+  };
+  launchWithTunedThreadBlockDepth(
+      integrator_name_ + "/integrate_blocks/lidar_multi_view", launch_kernel,
+      *cuda_stream_);
   cuda_stream_->synchronize();
   checkCudaErrors(cudaPeekAtLastError());
 }
@@ -375,29 +1204,35 @@ template <typename UpdateFunctor>
 void ProjectiveIntegrator<ColorVoxel>::integrateBlocks(
     const MaskedDepthImageConstView& depth_frame, const ColorImage& color_frame,
     const Transform& T_C_L, const Camera& camera, UpdateFunctor* op,
-    VoxelBlockLayer<ColorVoxel>* layer_ptr) {
+    VoxelBlockLayer<ColorVoxel>* layer_ptr,
+    VoxelBlockMask* /*updated_voxel_masks_device*/) {
   // Let the kernel know that we've subsampled - Color specific
   const int depth_subsampling_factor = color_frame.rows() / depth_frame.rows();
 
   // Kernel
-  const auto [num_thread_blocks, num_threads] =
-      getLaunchSizes(block_indices_device_.size());
-  integrateBlocksKernel<<<num_thread_blocks, num_threads, 0,
-                          *cuda_stream_>>>(
-      block_indices_device_.data(),  // NOLINT
-      camera,                        // NOLINT
-      color_frame.dataConstPtr(),    // NOLINT
-      color_frame.rows(),            // NOLINT
-      color_frame.cols(),            // NOLINT
-      depth_frame.dataConstPtr(),    // NOLINT
-      depth_frame.rows(),            // NOLINT
-      depth_frame.cols(),            // NOLINT
-      T_C_L,                         // NOLINT
-      layer_ptr->block_size(),       // NOLINT
-      max_integration_distance_m_,   // NOLINT
-      depth_subsampling_factor,      // NOLINT
-      op,                            // NOLINT
-      block_ptrs_device_.data());    // NOLINT
+  const auto launch_kernel = [&](int thread_block_depth) {
+    const auto [num_thread_blocks, num_threads] =
+        getLaunchSizes(block_indices_device_.size(), thread_block_depth);
+    integrateBlocksKernel<<<num_thread_blocks, num_threads, 0,
+                            *cuda_stream_>>>(
+        block_indices_device_.data(),  // NOLINT
+        camera,                        // NOLINT
+        color_frame.dataConstPtr(),    // NOLINT
+        color_frame.rows(),            // NOLINT
+        color_frame.cols(),            // NOLINT
+        depth_frame.dataConstPtr(),    // NOLINT
+        depth_frame.rows(),            // NOLINT
+        depth_frame.cols(),            // NOLINT
+        T_C_L,                         // NOLINT
+        layer_ptr->block_size(),       // NOLINT
+        max_integration_distance_m_,   // NOLINT
+        depth_subsampling_factor,      // NOLINT
+        op,                            // NOLINT
+        block_ptrs_device_.data());    // NOLINT
+  };
+  launchWithTunedThreadBlockDepth(
+      integrator_name_ + "/integrate_blocks/camera", launch_kernel,
+      *cuda_stream_);
 
   cuda_stream_->synchronize();
   checkCudaErrors(cudaPeekAtLastError());
@@ -422,16 +1257,18 @@ __device__ inline void setUnobservedVoxel(const OccupancyVoxel& voxel_value,
 
 // Call with:
 // - One threadBlock per VoxelBlock
-// - 8x8x8 threads per threadBlock
+// - voxelBlockThreadsPerBlock() threads per threadBlock
 template <typename VoxelType>
 __global__ void setUnobservedVoxelsKernel(const VoxelType voxel_value,
                                           VoxelBlock<VoxelType>** block_ptrs) {
-  // Get the voxel addressed by this thread.
   VoxelBlock<VoxelType>* block = block_ptrs[blockIdx.x];
-  VoxelType* block_voxel =
-      &block->voxels[threadIdx.z][threadIdx.y][threadIdx.x];
-  // Call for the voxel type.
-  setUnobservedVoxel(voxel_value, block_voxel);
+  forEachVoxelInThread([&](const Index3D& voxel_idx) {
+    // Get the voxel addressed by this thread.
+    VoxelType* block_voxel =
+        &block->voxels[voxel_idx.x()][voxel_idx.y()][voxel_idx.z()];
+    // Call for the voxel type.
+    setUnobservedVoxel(voxel_value, block_voxel);
+  });
 }
 
 template <typename VoxelType>
@@ -449,17 +1286,20 @@ void ProjectiveIntegrator<VoxelType>::markUnobservedFreeInsideRadiusTemplate(
   // Narrow to radius
   const std::vector<Index3D> blocks_inside_radius = getBlocksWithinRadius(
       blocks_touched_by_aabb, layer->block_size(), center, radius);
-  // Allocate (if they're not already);
-  std::for_each(blocks_inside_radius.begin(), blocks_inside_radius.end(),
-                [layer, this](const Index3D& idx) {
-                  layer->allocateBlockAtIndexAsync(idx, *cuda_stream_);
-                });
-
-  // VoxelBlock<VoxelType> pointers to GPU
-  const std::vector<VoxelBlock<VoxelType>*> block_ptrs_host =
-      getBlockPtrsFromIndices(blocks_inside_radius, layer);
-  device_vector<VoxelBlock<VoxelType>*> block_ptrs_device;
-  block_ptrs_device.copyFromAsync(block_ptrs_host, *cuda_stream_);
+  if (blocks_inside_radius.empty()) {
+    if (updated_blocks_ptr != nullptr) {
+      updated_blocks_ptr->clear();
+    }
+    return;
+  }
+  // Allocate (if they're not already) and look up the blocks in one batch on
+  // the GPU, rather than block by block through the CPU hash.
+  layer->prepareBlocksForWriteAsync(blocks_inside_radius, *cuda_stream_);
+  block_indices_device_.copyFromAsync(blocks_inside_radius, *cuda_stream_);
+  layer->allocateBlocksAtIndicesOnGpuAsync(block_indices_device_,
+                                           *cuda_stream_);
+  layer->getBlockPointersOnGpuAsync(block_indices_device_, &block_ptrs_device_,
+                                    *cuda_stream_);
 
   // The value given to "observed" voxels
   VoxelType slightly_observed_voxel;
@@ -474,13 +1314,11 @@ void ProjectiveIntegrator<VoxelType>::markUnobservedFreeInsideRadiusTemplate(
   }
 
   // Kernel launch
-  const int num_thread_blocks = block_ptrs_device.size();
-  constexpr int kVoxelsPerSide = VoxelBlock<VoxelType>::kVoxelsPerSide;
-  const dim3 num_threads_per_block(kVoxelsPerSide, kVoxelsPerSide,
-                                   kVoxelsPerSide);
+  const int num_thread_blocks = blocks_inside_radius.size();
+  const dim3 num_threads_per_block = voxelBlockThreadsPerBlock();
   setUnobservedVoxelsKernel<<<num_thread_blocks, num_threads_per_block, 0,
                               *cuda_stream_>>>(slightly_observed_voxel,
-                                               block_ptrs_device.data());
+                                               block_ptrs_device_.data());
   cuda_stream_->synchronize();
   checkCudaErrors(cudaPeekAtLastError());
 
@@ -47,13 +47,6 @@ __device__ inline bool projectThreadVoxel(
   return true;
 }
 
-__device__ inline void voxelAndBlockIndexFromCudaThreadIndex(
-    const Index3D* block_indices_device_ptr, Index3D* const block_idx,
-    Index3D* voxel_idx) {
-  *block_idx = block_indices_device_ptr[blockIdx.x];
-  *voxel_idx = Index3D(threadIdx.z, threadIdx.y, threadIdx.x);
-}
-
 __device__ inline bool doesVoxelHaveDepthMeasurement(
     const Index3D& block_idx, const Index3D& voxel_idx, const Camera camera,
     const float* image, int rows, int cols, const Transform T_C_L,
@@ -15,7 +15,11 @@ limitations under the License.
 */
 #include "nvblox/integrators/shape_clearer.h"
 
+#include "nvblox/core/hash.h"
+#include "nvblox/core/indexing.h"
+#include "nvblox/geometry/bounding_boxes.h"
 #include "nvblox/integrators/internal/integrators_common.h"
+#include "nvblox/map/internal/cuda/voxel_block_threads.cuh"
 
 namespace nvblox {
 
@@ -33,27 +37,34 @@ __device__ inline void clearVoxel(ColorVoxel* voxel_ptr) {
   voxel_ptr->weight = 0.f;
 }
 
+// Each block is only tested against the shapes binned into it:
+// shape_indices[shape_offsets[blockIdx.x]...shape_offsets[blockIdx.x + 1]].
 template <typename VoxelType>
 __global__ void clearShapesKernel(const Index3D* block_indices_device_ptr,
                                   const float block_size,
                                   const BoundingShape* shape_list,
-                                  const int shape_list_size,
+                                  const int* shape_offsets,
+                                  const int* shape_indices,
                                   VoxelBlock<VoxelType>** block_device_ptrs) {
   const Index3D block_idx = block_indices_device_ptr[blockIdx.x];
-  const Index3D voxel_idx(threadIdx.z, threadIdx.y, threadIdx.x);
-
-  // Voxel center point
-  const Vector3f p_voxel_center = getCenterPositionFromBlockIndexAndVoxelIndex(
-      block_size, block_idx, voxel_idx);
-
-  for (size_t i = 0; i < shape_list_size; i++) {
-    if (shape_list[i].contains(p_voxel_center)) {
-      VoxelType* voxel_ptr =
-          &(block_device_ptrs[blockIdx.x]
-                ->voxels[threadIdx.z][threadIdx.y][threadIdx.x]);
-      clearVoxel(voxel_ptr);
+  forEachVoxelInThread([&](const Index3D& voxel_idx) {
+    // Voxel center point
+    const Vector3f p_voxel_center =
+        getCenterPositionFromBlockIndexAndVoxelIndex(block_size, block_idx,
+                                                     voxel_idx);
+
+    for (int i = shape_offsets[blockIdx.x]; i < shape_offsets[blockIdx.x + 1];
+         i++) {
+      if (shape_list[shape_indices[i]].contains(p_voxel_center)) {
+        VoxelType* voxel_ptr =
+            &(block_device_ptrs[blockIdx.x]
+                  ->voxels[voxel_idx.x()][voxel_idx.y()][voxel_idx.z()]);
+        clearVoxel(voxel_ptr);
+        // Clearing once is enough.
+        break;
+      }
     }
-  }
+  });
 }
 
 template <typename LayerType>
@@ -64,24 +75,73 @@ template <typename LayerType>
 ShapeClearer<LayerType>::ShapeClearer(std::shared_ptr<CudaStream> cuda_stream)
     : cuda_stream_(cuda_stream) {}
 
+template <typename LayerType>
+void ShapeClearer<LayerType>::binShapesIntoBlocks(
+    const std::vector<BoundingShape>& bounding_shapes, const LayerType& layer,
+    std::vector<Index3D>* block_indices, std::vector<int>* shape_offsets,
+    std::vector<int>* shape_indices) const {
+  const float block_size = layer.block_size();
+  const size_t num_allocated_blocks = layer.numAllocatedBlocks();
+
+  // The shapes touching each block.
+  Index3DHashMapType<std::vector<int>>::type shapes_per_block;
+  for (int shape_idx = 0; shape_idx < static_cast<int>(bounding_shapes.size());
+       shape_idx++) {
+    const BoundingShape& shape = bounding_shapes[shape_idx];
+    auto bin_shape = [&](const Index3D& block_index) {
+      if (shape.touchesBlock(block_index, block_size)) {
+        shapes_per_block[block_index].push_back(shape_idx);
+      }
+    };
+    // Visit the blocks overlapped by the bounding box of the shape. Shapes
+    // covering more blocks than the layer has allocated visit the allocated
+    // blocks instead.
+    const AxisAlignedBoundingBox aabb = shape.boundingBox();
+    const Index3D min_block_index =
+        getBlockIndexFromPositionInLayer(block_size, aabb.min());
+    const Index3D max_block_index =
+        getBlockIndexFromPositionInLayer(block_size, aabb.max());
+    const Eigen::Vector3d num_blocks_per_axis =
+        (max_block_index - min_block_index).cast<double>().array() + 1.0;
+    if (num_blocks_per_axis.prod() <=
+        static_cast<double>(num_allocated_blocks)) {
+      for (const Index3D& block_index :
+           getBlockIndicesTouchedByBoundingBox(block_size, aabb)) {
+        if (layer.isBlockAllocated(block_index)) {
+          bin_shape(block_index);
+        }
+      }
+    } else {
+      for (const Index3D& block_index : layer.getAllBlockIndicesCached()) {
+        bin_shape(block_index);
+      }
+    }
+  }
+
+  // Flatten
+  block_indices->clear();
+  shape_offsets->clear();
+  shape_indices->clear();
+  block_indices->reserve(shapes_per_block.size());
+  shape_offsets->reserve(shapes_per_block.size() + 1);
+  shape_offsets->push_back(0);
+  for (const auto& [block_index, shapes] : shapes_per_block) {
+    block_indices->push_back(block_index);
+    shape_indices->insert(shape_indices->end(), shapes.begin(), shapes.end());
+    shape_offsets->push_back(shape_indices->size());
+  }
+}
+
 template <typename LayerType>
 std::vector<Index3D> ShapeClearer<LayerType>::clear(
     const std::vector<BoundingShape>& bounding_shapes, LayerType* layer_ptr) {
   CHECK_NOTNULL(layer_ptr);
-  const float block_size = layer_ptr->block_size();
-
-  // Predicate that returns true for blocks that are partially or fully
-  // contained by on of the AABBs.
-  auto predicate = [&bounding_shapes, &block_size](const Index3D& index) {
-    for (const auto& shape_variant : bounding_shapes) {
-      if (shape_variant.touchesBlock(index, block_size)) {
-        return true;
-      }
-    }
-    return false;
-  };
-  const std::vector<Index3D> block_indices =
-      layer_ptr->getBlockIndicesIf(predicate);
+
+  std::vector<Index3D> block_indices;
+  std::vector<int> shape_offsets;
+  std::vector<int> shape_indices;
+  binShapesIntoBlocks(bounding_shapes, *layer_ptr, &block_indices,
+                      &shape_offsets, &shape_indices);
   const int num_blocks = block_indices.size();
 
   std::vector<VoxelBlock<VoxelType>*> block_ptrs;
@@ -112,13 +172,17 @@ std::vector<Index3D> ShapeClearer<LayerType>::clear(
   block_ptrs_host_.copyFromAsync(block_ptrs, *cuda_stream_);
   block_ptrs_device_.copyFromAsync(block_ptrs_host_, *cuda_stream_);
 
-  constexpr int kVoxelsPerSide = VoxelBlock<bool>::kVoxelsPerSide;
-  const dim3 kThreadsPerBlock(kVoxelsPerSide, kVoxelsPerSide, kVoxelsPerSide);
+  // The shapes binned into each block
+  shape_offsets_device_.copyFromAsync(shape_offsets, *cuda_stream_);
+  shape_indices_device_.copyFromAsync(shape_indices, *cuda_stream_);
+
+  const dim3 kThreadsPerBlock = voxelBlockThreadsPerBlock();
   clearShapesKernel<<<num_blocks, kThreadsPerBlock, 0, *cuda_stream_>>>(
       block_indices_device_.data(),    // NOLINT
       layer_ptr->block_size(),         // NOLINT
       shapes_to_clear_device_.data(),  // NOLINT
-      shapes_to_clear_device_.size(),  // NOLINT
+      shape_offsets_device_.data(),    // NOLINT
+      shape_indices_device_.data(),    // NOLINT
       block_ptrs_device_.data());      // NOLINT
   cuda_stream_->synchronize();
   checkCudaErrors(cudaPeekAtLastError());
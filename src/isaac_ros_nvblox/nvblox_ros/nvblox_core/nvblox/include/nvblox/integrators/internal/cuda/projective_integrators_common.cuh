@@ -50,20 +50,6 @@ __device__ inline bool projectThreadVoxel(
     const float max_depth, Eigen::Vector2f* u_px_ptr, float* u_depth_ptr,
     Vector3f* p_voxel_center_C_ptr);
 
-/// Get Block and Voxel indices from ThreadIdx and BlockIdx
-/// block_indices_device_ptr[blockIdx.x]:
-///                 - The index of the block we're working on (blockIdx.y/z
-///                   should be zero)
-/// threadIdx.x/y/z - The indices of the voxel within the block (we
-///                   expect the threadBlockDims == voxelBlockDims)
-/// @param block_indices_device_ptr A list of block pointers.
-/// @param[out] block_idx The block index for this thread.
-/// @param[out] voxel_idx The voxel index for this thread.
-/// @return A pair of block_idx and voxel_idx.
-__device__ inline void voxelAndBlockIndexFromCudaThreadIndex(
-    const Index3D* block_indices_device_ptr, Index3D* const block_idx,
-    Index3D* voxel_idx);
-
 /// Returns true if a voxel is in view of the camera, is not occluded, is not
 /// out of max range, and has a valid depth measurment.
 /// @param block_idx The block index of the voxel in question.
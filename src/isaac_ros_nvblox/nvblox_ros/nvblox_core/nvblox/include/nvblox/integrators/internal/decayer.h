@@ -18,6 +18,7 @@ limitations under the License.
 #include <memory>
 
 #include "nvblox/core/cuda_stream.h"
+#include "nvblox/core/hash.h"
 #include "nvblox/core/log_odds.h"
 #include "nvblox/core/parameter_tree.h"
 #include "nvblox/integrators/viewpoint.h"
@@ -58,7 +59,69 @@ class VoxelDecayer {
       const std::optional<ViewBasedInclusionData>& view_exclusion_options,
       const CudaStream& cuda_stream);
 
+  /// @brief Runs the voxel_decay_functor on all voxels of the passed blocks.
+  /// @tparam DecayFunctorType The (unnamed) type of the functor.
+  /// @param layer_ptr The layer to run the decay on.
+  /// @param block_indices_to_decay The (allocated) blocks to decay.
+  /// @param voxel_decay_functor The functor object which does the decay, which
+  /// is run on every voxel.
+  /// @param deallocate_decayed_blocks If fully decayed blocks should be
+  /// deallocated.
+  /// @param view_exclusion_options Specifies view-based voxel exclusion.
+  /// @param cuda_stream The stream to do GPU work on.
+  /// @return A vector containing the indices of the blocks deallocated.
+  template <typename DecayFunctorType>
+  std::vector<Index3D> decayBlocks(
+      LayerType* layer_ptr,                                // NOLINT
+      const std::vector<Index3D>& block_indices_to_decay,  // NOLINT
+      const DecayFunctorType& voxel_decay_functor,         // NOLINT
+      const bool deallocate_decayed_blocks,                // NOLINT
+      const std::optional<ViewBasedInclusionData>& view_exclusion_options,
+      const CudaStream& cuda_stream);
+
+  /// Marks blocks as (possibly) no longer fully decayed, for example because
+  /// they were integrated into. See skip_fully_decayed_blocks().
+  /// @param block_indices The blocks touched since the last decay.
+  void markBlocksAsActive(const std::vector<Index3D>& block_indices);
+
+  /// A parameter getter
+  /// Whether decay() skips blocks which were found fully decayed (and kept
+  /// allocated) by an earlier call, and weren't marked as active since. Decay
+  /// then scales with the number of blocks which are not yet decayed. Anything
+  /// writing to the layer must call markBlocksAsActive() on the blocks it
+  /// touches.
+  /// @returns Whether fully decayed blocks are skipped.
+  bool skip_fully_decayed_blocks() const;
+
+  /// A parameter setter
+  /// See skip_fully_decayed_blocks().
+  /// @param skip_fully_decayed_blocks Whether to skip fully decayed blocks.
+  void skip_fully_decayed_blocks(bool skip_fully_decayed_blocks);
+
+  /// @return The number of blocks currently skipped by decay().
+  size_t numFullyDecayedBlocks() const { return fully_decayed_blocks_.size(); }
+
  protected:
+  /// Runs the voxel_decay_functor on the blocks passed as device pointers, and
+  /// writes which of them are fully decayed to block_fully_decayed_host_.
+  /// @param layer_ptr The layer to run the decay on.
+  /// @param num_blocks The number of blocks to decay.
+  /// @param block_ptrs_device Device pointers to the blocks.
+  /// @param block_indices_device The indices of the blocks on device. Only
+  /// needed (and may be nullptr otherwise) with view_exclusion_options.
+  /// @param voxel_decay_functor The functor object which does the decay.
+  /// @param view_exclusion_options Specifies view-based voxel exclusion.
+  /// @param cuda_stream The stream to do GPU work on.
+  template <typename DecayFunctorType>
+  void decayBlocksOnGpu(
+      LayerType* layer_ptr,                                     // NOLINT
+      const int num_blocks,                                     // NOLINT
+      typename LayerType::BlockType* const* block_ptrs_device,  // NOLINT
+      const Index3D* block_indices_device,                      // NOLINT
+      const DecayFunctorType& voxel_decay_functor,              // NOLINT
+      const std::optional<ViewBasedInclusionData>& view_exclusion_options,
+      const CudaStream& cuda_stream);
+
   /// Given a vector of blocks that have been decayed, deallocate the ones that
   /// are *fully* decayed (i.e. having a weight that is close to zero)
   /// @param layer_ptr The layer in which to deallocate
@@ -70,6 +133,16 @@ class VoxelDecayer {
       LayerType* layer_ptr, const std::vector<Index3D>& decayed_block_indices,
       const CudaStream& cuda_stream);
 
+  /// Records which of the passed blocks (just decayed, and in the order of
+  /// block_fully_decayed_host_) are fully decayed, such that they are skipped
+  /// by later calls.
+  void updateFullyDecayedBlocks(
+      const std::vector<Index3D>& decayed_block_indices);
+
+  // Fully decayed blocks, skipped by decay() (see skip_fully_decayed_blocks()).
+  bool skip_fully_decayed_blocks_ = false;
+  Index3DSet fully_decayed_blocks_;
+
   // Internal buffers
   host_vector<typename LayerType::BlockType*> allocated_block_ptrs_host_;
   device_vector<typename LayerType::BlockType*> allocated_block_ptrs_device_;
@@ -19,12 +19,13 @@ namespace nvblox {
 
 template <typename BlockType>
 __host__ std::vector<BlockType*> getBlockPtrsFromIndices(
-    const std::vector<Index3D>& block_indices,
-    BlockLayer<BlockType>* layer_ptr) {
+    const std::vector<Index3D>& block_indices, BlockLayer<BlockType>* layer_ptr,
+    const CudaStream& cuda_stream) {
   std::vector<BlockType*> block_ptrs;
   block_ptrs.reserve(block_indices.size());
   for (const Index3D& block_index : block_indices) {
-    typename BlockType::Ptr block_ptr = layer_ptr->getBlockAtIndex(block_index);
+    typename BlockType::Ptr block_ptr =
+        layer_ptr->getBlockAtIndexAsync(block_index, cuda_stream);
     CHECK(block_ptr);
     block_ptrs.push_back(block_ptr.get());
   }
@@ -82,6 +82,49 @@ float ProjectiveIntegrator<VoxelType>::get_truncation_distance_m(
   return truncation_distance_vox_ * voxel_size;
 }
 
+template <typename VoxelType>
+bool ProjectiveIntegrator<VoxelType>::allocate_blocks_on_gpu() const {
+  return allocate_blocks_on_gpu_;
+}
+
+template <typename VoxelType>
+void ProjectiveIntegrator<VoxelType>::allocate_blocks_on_gpu(
+    bool allocate_blocks_on_gpu) {
+  allocate_blocks_on_gpu_ = allocate_blocks_on_gpu;
+}
+
+template <typename VoxelType>
+bool ProjectiveIntegrator<VoxelType>::lidar_approximate_projection() const {
+  return lidar_approximate_projection_;
+}
+
+template <typename VoxelType>
+void ProjectiveIntegrator<VoxelType>::lidar_approximate_projection(
+    bool lidar_approximate_projection) {
+  lidar_approximate_projection_ = lidar_approximate_projection;
+}
+
+template <typename VoxelType>
+std::optional<float>
+ProjectiveIntegrator<VoxelType>::in_view_occlusion_distance_m() const {
+  return in_view_occlusion_distance_m_;
+}
+
+template <typename VoxelType>
+void ProjectiveIntegrator<VoxelType>::in_view_occlusion_distance_m(
+    std::optional<float> in_view_occlusion_distance_m) {
+  if (in_view_occlusion_distance_m.has_value()) {
+    CHECK_GT(in_view_occlusion_distance_m.value(), 0.0f);
+  }
+  in_view_occlusion_distance_m_ = in_view_occlusion_distance_m;
+}
+
+template <typename VoxelType>
+const device_vector<VoxelBlockMask>&
+ProjectiveIntegrator<VoxelType>::in_view_voxel_masks() const {
+  return in_view_voxel_masks_device_;
+}
+
 template <typename VoxelType>
 const ViewCalculator& ProjectiveIntegrator<VoxelType>::view_calculator() const {
   return view_calculator_;
@@ -93,6 +136,18 @@ ViewCalculator& ProjectiveIntegrator<VoxelType>::view_calculator() {
   return view_calculator_;
 }
 
+template <typename VoxelType>
+int ProjectiveIntegrator<VoxelType>::integration_subsampling_factor() const {
+  return integration_subsampling_factor_;
+}
+
+template <typename VoxelType>
+void ProjectiveIntegrator<VoxelType>::integration_subsampling_factor(
+    int integration_subsampling_factor) {
+  CHECK_GE(integration_subsampling_factor, 1);
+  integration_subsampling_factor_ = integration_subsampling_factor;
+}
+
 template <typename VoxelType>
 parameters::ParameterTreeNode ProjectiveIntegrator<VoxelType>::getParameterTree(
     const std::string& name_remap) const {
@@ -113,6 +168,11 @@ parameters::ParameterTreeNode ProjectiveIntegrator<VoxelType>::getParameterTree(
                          std::to_string(truncation_distance_vox_)),
        ParameterTreeNode("max_integration_distance_m:",
                          std::to_string(max_integration_distance_m_)),
+       ParameterTreeNode("allocate_blocks_on_gpu:", allocate_blocks_on_gpu_),
+       ParameterTreeNode("lidar_approximate_projection:",
+                         lidar_approximate_projection_),
+       ParameterTreeNode("integration_subsampling_factor:",
+                         std::to_string(integration_subsampling_factor_)),
        view_calculator_.getParameterTree()});
 }
 
@@ -30,33 +30,61 @@ float WeightingFunction::operator()(float measured_depth, float voxel_depth,
                                     float truncation_distance) const {
   switch (type_) {
     case WeightingFunctionType::kConstantWeight:
-      return constant_weight;
+      return compute<WeightingFunctionType::kConstantWeight>(
+          measured_depth, voxel_depth, truncation_distance);
     case WeightingFunctionType::kConstantDropoffWeight:
-      return constant_weight *
-             computeDropoff(measured_depth, voxel_depth, truncation_distance);
+      return compute<WeightingFunctionType::kConstantDropoffWeight>(
+          measured_depth, voxel_depth, truncation_distance);
     case WeightingFunctionType::kInverseSquareWeight:
-      return computeInverseSquare(measured_depth, voxel_depth,
-                                  truncation_distance);
+      return compute<WeightingFunctionType::kInverseSquareWeight>(
+          measured_depth, voxel_depth, truncation_distance);
     case WeightingFunctionType::kInverseSquareDropoffWeight:
-      return computeInverseSquare(measured_depth, voxel_depth,
-                                  truncation_distance) *
-             computeDropoff(measured_depth, voxel_depth, truncation_distance);
+      return compute<WeightingFunctionType::kInverseSquareDropoffWeight>(
+          measured_depth, voxel_depth, truncation_distance);
     case WeightingFunctionType::kInverseSquareTsdfDistancePenalty:
-      return computeInverseSquare(measured_depth, voxel_depth,
-                                  truncation_distance) *
-             computeTsdfDistancePenalty(measured_depth, voxel_depth,
-                                        truncation_distance);
+      return compute<WeightingFunctionType::kInverseSquareTsdfDistancePenalty>(
+          measured_depth, voxel_depth, truncation_distance);
     case WeightingFunctionType::kLinearWithMax:
-      return computeLinearWithMax(voxel_depth);
+      return compute<WeightingFunctionType::kLinearWithMax>(
+          measured_depth, voxel_depth, truncation_distance);
     default:
       NVBLOX_ABORT("Requested weighting function type not implemented");
       return 0.0;
   };
 }
 
+template <WeightingFunctionType kType>
+float WeightingFunction::compute(float measured_depth, float voxel_depth,
+                                 float truncation_distance) {
+  if constexpr (kType == WeightingFunctionType::kConstantWeight) {
+    return constant_weight;
+  } else if constexpr (kType == WeightingFunctionType::kConstantDropoffWeight) {
+    return constant_weight *
+           computeDropoff(measured_depth, voxel_depth, truncation_distance);
+  } else if constexpr (kType == WeightingFunctionType::kInverseSquareWeight) {
+    return computeInverseSquare(measured_depth, voxel_depth,
+                                truncation_distance);
+  } else if constexpr (kType ==
+                       WeightingFunctionType::kInverseSquareDropoffWeight) {
+    return computeInverseSquare(measured_depth, voxel_depth,
+                                truncation_distance) *
+           computeDropoff(measured_depth, voxel_depth, truncation_distance);
+  } else if constexpr (kType == WeightingFunctionType::
+                                    kInverseSquareTsdfDistancePenalty) {
+    return computeInverseSquare(measured_depth, voxel_depth,
+                                truncation_distance) *
+           computeTsdfDistancePenalty(measured_depth, voxel_depth,
+                                      truncation_distance);
+  } else {
+    static_assert(kType == WeightingFunctionType::kLinearWithMax,
+                  "Requested weighting function type not implemented");
+    return computeLinearWithMax(voxel_depth);
+  }
+}
+
 // Computes the dropoff from 1 to 0.
 float WeightingFunction::computeDropoff(float measured_depth, float voxel_depth,
-                                        float truncation_distance) const {
+                                        float truncation_distance) {
   if (truncation_distance <= kWeightEpsilon) {
     return 0.0f;
   }
@@ -80,7 +108,7 @@ float WeightingFunction::computeDropoff(float measured_depth, float voxel_depth,
 /// Returns 1/(z^2) where z is the voxel distance from the camera.
 float WeightingFunction::computeInverseSquare(float measured_depth,
                                               float voxel_depth,
-                                              float truncation_distance) const {
+                                              float truncation_distance) {
   // NOTE(alexmillane): This is only a function of the voxel distance from
   // camera. Ensure we don't get a divide by zero. Close to the cam ->
   // weight 1.0.
@@ -96,7 +124,7 @@ float WeightingFunction::computeInverseSquare(float measured_depth,
 }
 
 float WeightingFunction::computeTsdfDistancePenalty(
-    float measured_depth, float voxel_depth, float truncation_distance) const {
+    float measured_depth, float voxel_depth, float truncation_distance) {
   // Big tsdf distances measurements are susceptible to viewpoint changes.
   // Therefore we decrease the weight outside the truncation distance.
   // Note: can help to reduce holes in the floor reconstruction.
@@ -108,7 +136,7 @@ float WeightingFunction::computeTsdfDistancePenalty(
   return 1.0f;
 }
 
-inline float WeightingFunction::computeLinearWithMax(float voxel_depth) const {
+inline float WeightingFunction::computeLinearWithMax(float voxel_depth) {
   // Linear drop off after 1.0
   if (voxel_depth > 1.0f) {
     return 1.0f / voxel_depth;
@@ -29,11 +29,13 @@ namespace nvblox {
 /// @param block_indices A vector of the 3D indices of blocks who's pointers we
 /// want
 /// @param layer_ptr A pointer to the layer containing the blocks.
+/// @param cuda_stream The stream on which the blocks are written (see
+/// BlockLayer::getBlockAtIndexAsync()).
 /// @param return a vector of block pointers.
 template <typename BlockType>
 __host__ std::vector<BlockType*> getBlockPtrsFromIndices(
-    const std::vector<Index3D>& block_indices,
-    BlockLayer<BlockType>* layer_ptr);
+    const std::vector<Index3D>& block_indices, BlockLayer<BlockType>* layer_ptr,
+    const CudaStream& cuda_stream);
 
 /// Convert a list of BlockIndices on host, to a list of (const) device pointers
 /// on host.
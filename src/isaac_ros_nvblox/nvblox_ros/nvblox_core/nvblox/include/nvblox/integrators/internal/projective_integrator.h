@@ -15,6 +15,8 @@ limitations under the License.
 */
 #pragma once
 
+#include <optional>
+
 #include "nvblox/core/cuda_stream.h"
 #include "nvblox/core/parameter_tree.h"
 #include "nvblox/gpu_hash/gpu_layer_view.h"
@@ -27,6 +29,42 @@ limitations under the License.
 #include "nvblox/sensors/lidar.h"
 namespace nvblox {
 
+/// A flat description of a single camera view used by the batched
+/// (multi-view) integration kernel. Holds raw pointers to the underlying image
+/// buffers, so the images must outlive the integration call.
+struct ProjectiveCameraView {
+  Camera camera;
+  Transform T_C_L;
+  const float* depth = nullptr;
+  const uint8_t* mask = nullptr;
+  int rows = 0;
+  int cols = 0;
+  int mask_stride_num_elements = 0;
+};
+
+/// The LiDAR counterpart of ProjectiveCameraView, used by the batched
+/// (multi-view) LiDAR integration kernel.
+struct ProjectiveLidarView {
+  /// Elements of unified vectors must be default constructible (although their
+  /// constructors are never called). A default constructed view has no LiDAR
+  /// and must not be used.
+  ProjectiveLidarView() {}
+  ProjectiveLidarView(const Lidar& _lidar, const Transform& _T_C_L)
+      : lidar(_lidar), T_C_L(_T_C_L) {}
+
+  // Lidar has no default constructor. The union leaves it uninitialized in the
+  // default constructor above.
+  union {
+    Lidar lidar;
+  };
+  Transform T_C_L;
+  const float* depth = nullptr;
+  const uint8_t* mask = nullptr;
+  int rows = 0;
+  int cols = 0;
+  int mask_stride_num_elements = 0;
+};
+
 /// A pure-virtual base-class for the projective occupancy and tsdf integrators.
 ///
 /// Integrators deriving from this base class insert (integrate) image and lidar
@@ -42,18 +80,78 @@ class ProjectiveIntegrator {
   virtual ~ProjectiveIntegrator() = default;
 
   /// Update a generic layer using depth image
+  /// If updated_voxel_masks is passed, it is filled with one mask per updated
+  /// block, flagging the voxels whose surface-relevant state changed (see
+  /// voxelSurfaceChanged()).
   template <typename UpdateFunctor>
-  void integrateFrame(const MaskedDepthImageConstView& depth_frame,
-                      const Transform& T_L_C, const Camera& camera,
-                      UpdateFunctor* op, VoxelBlockLayer<VoxelType>* layer,
-                      std::vector<Index3D>* updated_blocks);
+  void integrateFrame(
+      const MaskedDepthImageConstView& depth_frame, const Transform& T_L_C,
+      const Camera& camera, UpdateFunctor* op,
+      VoxelBlockLayer<VoxelType>* layer, std::vector<Index3D>* updated_blocks,
+      std::vector<VoxelBlockMask>* updated_voxel_masks = nullptr);
+
+  /// Update a generic layer and a label layer using a depth image and a
+  /// multi-class mask (label image) of the same camera. The labels are voted
+  /// for by the integration kernel: voxels within a voxel of the measured
+  /// surface vote for the label of their pixel, voxels in front of the
+  /// surface (beyond the truncation distance) vote for free space. See
+  /// LabelVoxel. The label layer gets the blocks of the integrated layer.
+  /// @param label_image The class of each pixel, 0 for the background. May have
+  /// a different resolution than the depth image, but the same field of view.
+  /// @param label_layer The layer of the labels. Must have the block size of
+  /// layer.
+  template <typename UpdateFunctor>
+  void integrateFrame(
+      const MaskedDepthImageConstView& depth_frame,
+      const MonoImageConstView& label_image, const Transform& T_L_C,
+      const Camera& camera, UpdateFunctor* op,
+      VoxelBlockLayer<VoxelType>* layer, LabelLayer* label_layer,
+      std::vector<Index3D>* updated_blocks,
+      std::vector<VoxelBlockMask>* updated_voxel_masks = nullptr);
+
+  /// Update a generic layer using an integer depth image. Pixel values are
+  /// converted to meters, by multiplying with depth_scale_m, as they're read by
+  /// the kernels, such that no float copy of the image is needed.
+  template <typename UpdateFunctor>
+  void integrateFrame(
+      const MaskedDepthImageU16ConstView& depth_frame,
+      const float depth_scale_m, const Transform& T_L_C, const Camera& camera,
+      UpdateFunctor* op, VoxelBlockLayer<VoxelType>* layer,
+      std::vector<Index3D>* updated_blocks,
+      std::vector<VoxelBlockMask>* updated_voxel_masks = nullptr);
 
   /// Update a generic layer using a (potentially) sparse depth image from lidar
   template <typename UpdateFunctor>
-  void integrateFrame(const MaskedDepthImageConstView& depth_frame,
-                      const Transform& T_L_C, const Lidar& lidar,
-                      UpdateFunctor* op, VoxelBlockLayer<VoxelType>* layer,
-                      std::vector<Index3D>* updated_blocks);
+  void integrateFrame(
+      const MaskedDepthImageConstView& depth_frame, const Transform& T_L_C,
+      const Lidar& lidar, UpdateFunctor* op,
+      VoxelBlockLayer<VoxelType>* layer, std::vector<Index3D>* updated_blocks,
+      std::vector<VoxelBlockMask>* updated_voxel_masks = nullptr);
+
+  /// Update a generic layer using several depth images in a single pass.
+  /// The blocks in view of all images are merged, allocated and
+  /// transferred once, and all views are fused by a single kernel launch.
+  /// Views are fused into each voxel in the order in which they are passed.
+  template <typename UpdateFunctor>
+  void integrateFrames(
+      const std::vector<MaskedDepthImageConstView>& depth_frames,
+      const std::vector<Transform>& T_L_C_vec,
+      const std::vector<Camera>& cameras, UpdateFunctor* op,
+      VoxelBlockLayer<VoxelType>* layer, std::vector<Index3D>* updated_blocks,
+      std::vector<VoxelBlockMask>* updated_voxel_masks = nullptr);
+
+  /// Update a generic layer using several (potentially) sparse lidar depth
+  /// images in a single pass, e.g. the scans of several LiDARs on a robot.
+  /// As for cameras, the blocks in view of all scans are merged and all scans
+  /// are fused by a single kernel launch, in the order in which they are
+  /// passed.
+  template <typename UpdateFunctor>
+  void integrateFrames(
+      const std::vector<MaskedDepthImageConstView>& depth_frames,
+      const std::vector<Transform>& T_L_C_vec,
+      const std::vector<Lidar>& lidars, UpdateFunctor* op,
+      VoxelBlockLayer<VoxelType>* layer, std::vector<Index3D>* updated_blocks,
+      std::vector<VoxelBlockMask>* updated_voxel_masks = nullptr);
 
   /// A parameter getter
   /// The maximum allowable value for the maximum distance between the linearly
@@ -112,6 +210,73 @@ class ProjectiveIntegrator {
   /// meters.
   void max_integration_distance_m(float max_integration_distance_m);
 
+  /// A parameter getter
+  /// Whether blocks are allocated on the GPU, see
+  /// BlockLayer::allocateBlocksAtIndicesOnGpuAsync(). This avoids hashing the
+  /// blocks in view on the CPU.
+  /// @returns whether blocks are allocated on the GPU
+  bool allocate_blocks_on_gpu() const;
+
+  /// A parameter setter
+  /// See allocate_blocks_on_gpu().
+  /// @param allocate_blocks_on_gpu whether to allocate blocks on the GPU.
+  void allocate_blocks_on_gpu(bool allocate_blocks_on_gpu);
+
+  /// A parameter getter
+  /// Whether LiDAR frames are integrated with Lidar::approximate_projection()
+  /// set, i.e. voxels are projected without atan2() and acos() calls.
+  /// @returns whether the LiDAR projection is approximated
+  bool lidar_approximate_projection() const;
+
+  /// A parameter setter
+  /// See lidar_approximate_projection().
+  /// @param lidar_approximate_projection whether to approximate.
+  void lidar_approximate_projection(bool lidar_approximate_projection);
+
+  /// A parameter getter
+  /// The factor by which camera depth frames are downscaled before
+  /// integration (see image::minDownscaleGPUAsync()). Each pixel of the
+  /// downscaled frame keeps the nearest valid depth of its patch, such that
+  /// fewer, coarser rays are cast to find the blocks in view and the voxels
+  /// read a smaller image. If the view calculator's depth pyramid (see
+  /// ViewCalculator::depth_pyramid()) was built from the frame, frames
+  /// without a mask are read from the matching pyramid level. 1 integrates
+  /// at full resolution. Applies to single camera frames, not to LiDAR or
+  /// batched (integrateFrames()) integration.
+  /// @returns the integration subsampling factor
+  int integration_subsampling_factor() const;
+
+  /// A parameter setter
+  /// See integration_subsampling_factor(). Can be changed between frames,
+  /// e.g. to keep the integration rate steady under load.
+  /// @param integration_subsampling_factor the factor, at least 1.
+  void integration_subsampling_factor(int integration_subsampling_factor);
+
+  /// A parameter getter
+  /// The occlusion distance used to record which voxels are in view of the
+  /// integrated camera frame, or std::nullopt if no recording takes place. See
+  /// in_view_voxel_masks().
+  /// @returns the occlusion distance in meters
+  std::optional<float> in_view_occlusion_distance_m() const;
+
+  /// A parameter setter
+  /// See in_view_occlusion_distance_m().
+  /// @param in_view_occlusion_distance_m the occlusion distance in meters, or
+  /// std::nullopt to disable recording.
+  void in_view_occlusion_distance_m(
+      std::optional<float> in_view_occlusion_distance_m);
+
+  /// Masks of the voxels which were in view of the last integrated frame,
+  /// where in view means that the voxel projects onto a valid depth
+  /// measurement, and is at most in_view_occlusion_distance_m() behind it (the
+  /// test of doesVoxelHaveDepthMeasurement()). The masks are computed during
+  /// the projection done for integration, such that later passes over the
+  /// same view (the freespace update) don't need to re-project the voxels.
+  /// There is one mask per block in updated_blocks of the last call. Only
+  /// filled by single-view camera integration, empty otherwise.
+  /// @returns masks of the in-view voxels in device memory
+  const device_vector<VoxelBlockMask>& in_view_voxel_masks() const;
+
   /// Returns the object used to calculate the blocks in camera views.
   const ViewCalculator& view_calculator() const;
   /// Returns the object used to calculate the blocks in camera views.
@@ -136,14 +301,18 @@ class ProjectiveIntegrator {
       std::vector<Index3D>* updated_blocks = nullptr);
 
   // Called from the integrateFrame() interfaces.
-  // Captures common behaviour between sensors.
-  template <typename SensorType, typename UpdateFunctor>
-  void integrateFrameTemplate(const MaskedDepthImageConstView& depth_frame,
-                              const ColorImage& color_frame,
-                              const Transform& T_L_C, const SensorType& sensor,
-                              UpdateFunctor* op,
-                              VoxelBlockLayer<VoxelType>* layer,
-                              std::vector<Index3D>* updated_blocks = nullptr);
+  // Captures common behaviour between sensors. Integer depth frames
+  // (MaskedDepthImageU16ConstView) are only supported for cameras, and are
+  // converted to meters using depth_scale_m.
+  template <typename SensorType, typename UpdateFunctor,
+            typename DepthFrameType = MaskedDepthImageConstView>
+  void integrateFrameTemplate(
+      const DepthFrameType& depth_frame, const ColorImage& color_frame,
+      const Transform& T_L_C, const SensorType& sensor, UpdateFunctor* op,
+      VoxelBlockLayer<VoxelType>* layer,
+      std::vector<Index3D>* updated_blocks = nullptr,
+      std::vector<VoxelBlockMask>* updated_voxel_masks = nullptr,
+      const float depth_scale_m = 1.0f);
 
   // Two methods below are specialized for Camera/LiDAR
   // - Calls GPU kernel to do block update.
@@ -151,12 +320,64 @@ class ProjectiveIntegrator {
   void integrateBlocks(const MaskedDepthImageConstView& depth_frame,
                        const ColorImage& color_frame, const Transform& T_C_L,
                        const Camera& camera, UpdateFunctor* op,
-                       VoxelBlockLayer<VoxelType>* layer_ptr);
+                       VoxelBlockLayer<VoxelType>* layer_ptr,
+                       VoxelBlockMask* updated_voxel_masks_device = nullptr);
+  template <typename UpdateFunctor>
+  void integrateBlocks(const MaskedDepthImageU16ConstView& depth_frame,
+                       const float depth_scale_m, const Transform& T_C_L,
+                       const Camera& camera, UpdateFunctor* op,
+                       VoxelBlockLayer<VoxelType>* layer_ptr,
+                       VoxelBlockMask* updated_voxel_masks_device = nullptr);
   template <typename UpdateFunctor>
   void integrateBlocks(const MaskedDepthImageConstView& depth_frame,
                        const ColorImage& color_frame, const Transform& T_C_L,
                        const Lidar& lidar, UpdateFunctor* op,
-                       VoxelBlockLayer<VoxelType>* layer_ptr);
+                       VoxelBlockLayer<VoxelType>* layer_ptr,
+                       VoxelBlockMask* updated_voxel_masks_device = nullptr);
+
+  // Downscales a camera frame by integration_subsampling_factor_ into
+  // subsampled_depth_frame_ (and subsampled_mask_). Integer depth is
+  // converted to meters.
+  template <typename DepthFrameType>
+  MaskedDepthImageConstView subsampleDepthFrameAsync(
+      const DepthFrameType& depth_frame, const float depth_scale_m = 1.0f);
+
+  // Allocates the blocks where required and transfers their indices and
+  // pointers to block_indices_device_ and block_ptrs_device_.
+  void allocateAndTransferBlocks(const std::vector<Index3D>& block_indices,
+                                 VoxelBlockLayer<VoxelType>* layer_ptr,
+                                 const std::string& timer_prefix);
+
+  // Zeros updated_voxel_masks_device_ for the blocks currently staged in
+  // block_indices_device_. Returns the pointer to pass to the kernels, which
+  // is nullptr if the masks were not requested.
+  VoxelBlockMask* prepareUpdatedVoxelMasks(bool masks_requested);
+
+  // As above, for in_view_voxel_masks_device_. Returns nullptr if
+  // in_view_occlusion_distance_m_ is not set.
+  VoxelBlockMask* prepareInViewVoxelMasks();
+
+  // Allocates the blocks of block_indices in label_layer_ and transfers their
+  // pointers to label_block_ptrs_device_. Does nothing if label_layer_ isn't
+  // set.
+  void allocateAndTransferLabelBlocks(
+      const std::vector<Index3D>& block_indices);
+
+  // Calls the multi-view GPU kernel on the views currently staged in
+  // camera_views_device_.
+  template <typename UpdateFunctor>
+  void integrateBlocksMultiView(
+      const int num_views, UpdateFunctor* op,
+      VoxelBlockLayer<VoxelType>* layer_ptr,
+      VoxelBlockMask* updated_voxel_masks_device = nullptr);
+
+  // Calls the multi-view GPU kernel on the LiDAR views currently staged in
+  // lidar_views_device_.
+  template <typename UpdateFunctor>
+  void integrateBlocksMultiViewLidar(
+      const int num_views, UpdateFunctor* op,
+      VoxelBlockLayer<VoxelType>* layer_ptr,
+      VoxelBlockMask* updated_voxel_masks_device = nullptr);
 
   // Get the child integrator name
   virtual std::string getIntegratorName() const = 0;
@@ -171,6 +392,17 @@ class ProjectiveIntegrator {
       kProjectiveIntegratorTruncationDistanceVoxParamDesc.default_value;
   float max_integration_distance_m_ =
       kProjectiveIntegratorMaxIntegrationDistanceMParamDesc.default_value;
+  bool allocate_blocks_on_gpu_ = false;
+  bool lidar_approximate_projection_ =
+      kLidarProjectiveIntegratorApproximateProjectionParamDesc.default_value;
+  std::optional<float> in_view_occlusion_distance_m_;
+  int integration_subsampling_factor_ =
+      kProjectiveIntegratorSubsamplingFactorParamDesc.default_value;
+
+  // The downscaled frame (and mask) integrated on the current call, if
+  // integration_subsampling_factor_ > 1.
+  DepthImage subsampled_depth_frame_{MemoryType::kDevice};
+  MonoImage subsampled_mask_{MemoryType::kDevice};
 
   // Frustum calculation.
   mutable ViewCalculator view_calculator_;
@@ -183,6 +415,27 @@ class ProjectiveIntegrator {
   host_vector<Index3D> block_indices_host_;
   host_vector<VoxelBlock<VoxelType>*> block_ptrs_host_;
 
+  // Per-block masks of the voxels changed on the current call. Only filled if
+  // requested by the caller.
+  device_vector<VoxelBlockMask> updated_voxel_masks_device_;
+
+  // Per-block masks of the voxels in view on the last call. Only filled if
+  // in_view_occlusion_distance_m_ is set.
+  device_vector<VoxelBlockMask> in_view_voxel_masks_device_;
+
+  // The label image and layer of the current call, if integrating labels. The
+  // label blocks are in the order of block_ptrs_device_.
+  MonoImageConstView label_image_;
+  LabelLayer* label_layer_ = nullptr;
+  device_vector<LabelBlock*> label_block_ptrs_device_;
+  host_vector<LabelBlock*> label_block_ptrs_host_;
+
+  // Views integrated on the current call to integrateFrames().
+  device_vector<ProjectiveCameraView> camera_views_device_;
+  host_vector<ProjectiveCameraView> camera_views_host_;
+  device_vector<ProjectiveLidarView> lidar_views_device_;
+  host_vector<ProjectiveLidarView> lidar_views_host_;
+
   // CUDA stream to process integration on
   std::shared_ptr<CudaStream> cuda_stream_;
 };
@@ -122,6 +122,23 @@ class OccupancyDecayIntegrator : public DecayIntegratorBase<OccupancyLayer> {
   /// @param decay_to_free Whether we want to decay to free
   void decay_to_free(bool decay_to_free);
 
+  /// A parameter getter
+  /// Whether decay skips blocks which were fully decayed by an earlier decay
+  /// step (and not deallocated) until they are marked as active again.
+  /// @returns Whether inactive blocks are skipped.
+  bool skip_inactive_blocks() const;
+
+  /// A parameter setter
+  /// See skip_inactive_blocks().
+  /// @param skip_inactive_blocks Whether to skip inactive blocks.
+  void skip_inactive_blocks(bool skip_inactive_blocks);
+
+  /// Marks blocks which were written to (e.g. integrated) since the last decay
+  /// step, such that they are decayed again. Only needed with
+  /// skip_inactive_blocks().
+  /// @param block_indices The blocks written to.
+  void markBlocksAsActive(const std::vector<Index3D>& block_indices);
+
   /// Return the parameter tree.
   /// @return the parameter tree
   virtual parameters::ParameterTreeNode getParameterTree(
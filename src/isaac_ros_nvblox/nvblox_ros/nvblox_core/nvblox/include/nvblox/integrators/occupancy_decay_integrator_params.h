@@ -34,12 +34,20 @@ constexpr Param<bool>::Description kOccupancyDecayToFreeParamDesc{
     "If true we set fully decayed voxels to the free probability. Otherwise "
     "they will set to unkown probability."};
 
+constexpr Param<bool>::Description kOccupancyDecaySkipInactiveBlocksParamDesc{
+    "occupancy_decay_skip_inactive_blocks", false,
+    "If true, decay skips blocks which are fully decayed (and not "
+    "deallocated) until they are observed again. Decay then scales with the "
+    "number of blocks which are not yet decayed rather than the map size."};
+
 struct OccupancyDecayIntegratorParams {
   Param<float> free_region_decay_probability{
       kFreeRegionDecayProbabilityParamDesc};
   Param<float> occupied_region_decay_probability{
       kOccupiedRegionDecayProbabilityParamDesc};
   Param<bool> occupancy_decay_to_free{kOccupancyDecayToFreeParamDesc};
+  Param<bool> occupancy_decay_skip_inactive_blocks{
+      kOccupancyDecaySkipInactiveBlocksParamDesc};
 };
 
 }  // namespace nvblox
@@ -0,0 +1,185 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "nvblox/core/cuda_stream.h"
+#include "nvblox/core/parameter_tree.h"
+#include "nvblox/core/types.h"
+#include "nvblox/core/unified_ptr.h"
+#include "nvblox/core/unified_vector.h"
+#include "nvblox/integrators/projective_integrator_params.h"
+#include "nvblox/integrators/weighting_function.h"
+#include "nvblox/map/blox.h"
+#include "nvblox/map/common_names.h"
+#include "nvblox/map/layer.h"
+#include "nvblox/sensors/pointcloud.h"
+
+namespace nvblox {
+
+struct Index3DDeviceSet;
+
+/// Per-voxel sums of the observations of a single pointcloud, fused into the
+/// TSDF after all rays have been cast.
+struct TsdfObservationSum {
+  float weighted_distance;
+  float weight;
+};
+
+/// A class performing TSDF integration of pointclouds by raycasting.
+///
+/// In contrast to the ProjectiveTsdfIntegrator, which requires LiDAR scans to
+/// be rasterized to a depth image, this integrator consumes the points
+/// directly. Rays are cast on the GPU from the sensor origin to each point,
+/// first at block resolution to find (and allocate) the blocks in view, and
+/// then at voxel resolution to update the voxels along the ray. Points
+/// therefore don't need to follow a regular (spherical) scan pattern.
+class PointcloudTsdfIntegrator {
+ public:
+  PointcloudTsdfIntegrator();
+  PointcloudTsdfIntegrator(std::shared_ptr<CudaStream> cuda_stream);
+  virtual ~PointcloudTsdfIntegrator();
+
+  /// Integrates a pointcloud in to the passed TSDF layer.
+  /// @param pointcloud_S The points, expressed in the sensor frame (S). May be
+  /// in any memory type.
+  /// @param T_L_S The pose of the sensor. Supplied as a Transform mapping
+  /// points in the sensor frame (S) to the layer frame (L).
+  /// @param layer A pointer to the layer into which this observation will be
+  /// intergrated.
+  /// @param updated_blocks Optional pointer to a vector which will contain the
+  /// 3D indices of blocks affected by the integration.
+  /// @param updated_voxel_masks Optional pointer to a vector which will contain
+  /// one mask per block in updated_blocks, flagging the voxels whose distance
+  /// or observed-state changed.
+  void integrateFrame(const Pointcloud& pointcloud_S, const Transform& T_L_S,
+                      TsdfLayer* layer,
+                      std::vector<Index3D>* updated_blocks = nullptr,
+                      std::vector<VoxelBlockMask>* updated_voxel_masks =
+                          nullptr);
+
+  /// A parameter getter
+  /// The truncation distance in units of voxels.
+  /// @returns the truncation distance in voxels
+  float truncation_distance_vox() const;
+
+  /// A parameter setter
+  /// See truncation_distance_vox().
+  /// @param truncation_distance_vox the truncation distance in voxels.
+  void truncation_distance_vox(float truncation_distance_vox);
+
+  /// A parameter getter
+  /// Points further than this distance from the sensor are only used to clear
+  /// the space up to this distance.
+  /// @returns the maximum integration distance in meters
+  float max_integration_distance_m() const;
+
+  /// A parameter setter
+  /// See max_integration_distance_m().
+  /// @param max_integration_distance_m the maximum integration distance in
+  /// meters.
+  void max_integration_distance_m(float max_integration_distance_m);
+
+  /// A parameter getter
+  /// The maximum weight that voxels can have. The integrator clips the voxel
+  /// weight to this value after integration.
+  /// @returns the maximum weight
+  float max_weight() const;
+
+  /// A parameter setter
+  /// See max_weight().
+  /// @param max_weight the maximum weight of a voxel.
+  void max_weight(float max_weight);
+
+  /// A parameter getter
+  /// The type of weighting function used to fuse observations
+  /// @returns The weighting function type used.
+  WeightingFunctionType weighting_function_type() const;
+
+  /// A parameter setter
+  /// See weighting_function_type().
+  /// @param weighting_function_type The type of weighting function to be used
+  void weighting_function_type(WeightingFunctionType weighting_function_type);
+
+  /// Gets the metric truncation distance which is calculated from truncation
+  /// distance in voxels and the input voxel size.
+  /// @param voxel_size The voxel size of the layer you want the truncation
+  /// distance for.
+  /// @return The truncation distance
+  float get_truncation_distance_m(float voxel_size) const;
+
+  /// Return the parameter tree.
+  /// @return the parameter tree
+  virtual parameters::ParameterTreeNode getParameterTree(
+      const std::string& name_remap = std::string()) const;
+
+ protected:
+  // Casts block-resolution rays and returns the (sorted) indices of all blocks
+  // touched by the rays.
+  std::vector<Index3D> getBlocksAlongRays(const Transform& T_L_S,
+                                          const Vector3f* points_S_device,
+                                          int num_points, float block_size,
+                                          float truncation_distance_m);
+
+  // Casts voxel-resolution rays, summing the observations per voxel.
+  void accumulateObservationsAlongRays(const Transform& T_L_S,
+                                       const Vector3f* points_S_device,
+                                       int num_points, float block_size,
+                                       float truncation_distance_m);
+
+  // Fuses the summed observations into the voxels of the layer.
+  void fuseObservations(float truncation_distance_m,
+                        bool compute_updated_voxel_masks);
+
+  // Parameters
+  float truncation_distance_vox_ =
+      kProjectiveIntegratorTruncationDistanceVoxParamDesc.default_value;
+  float max_integration_distance_m_ =
+      kLidarProjectiveIntegratorMaxIntegrationDistanceMParamDesc.default_value;
+  float max_weight_ = kProjectiveIntegratorMaxWeightParamDesc.default_value;
+  WeightingFunctionType weighting_function_type_ =
+      kProjectiveIntegratorWeightingModeParamDesc.default_value;
+
+  // Set of blocks touched by the rays of the current pointcloud. Grown (and
+  // the block pass repeated) if a pointcloud touches more blocks than fit.
+  size_t blocks_in_view_set_size_;
+  std::unique_ptr<Index3DDeviceSet> blocks_in_view_set_;
+  unified_ptr<int> num_failed_insertions_device_ =
+      make_unified<int>(MemoryType::kDevice);
+  unified_ptr<int> num_failed_insertions_host_ =
+      make_unified<int>(MemoryType::kHost);
+
+  // Staging buffer for pointclouds which aren't in device memory.
+  Pointcloud points_device_{MemoryType::kDevice};
+
+  // Blocks to integrate, sorted such that they can be binary searched on the
+  // GPU.
+  host_vector<TsdfBlock*> block_ptrs_host_;
+  device_vector<TsdfBlock*> block_ptrs_device_;
+  host_vector<Index3D> block_indices_host_;
+  device_vector<Index3D> block_indices_device_;
+
+  // One sum per voxel of the blocks above.
+  device_vector<TsdfObservationSum> observation_sums_device_;
+  device_vector<VoxelBlockMask> updated_voxel_masks_device_;
+
+  std::shared_ptr<CudaStream> cuda_stream_;
+};
+
+}  // namespace nvblox
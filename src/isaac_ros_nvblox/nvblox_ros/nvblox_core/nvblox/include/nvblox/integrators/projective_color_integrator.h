@@ -58,6 +58,30 @@ class ProjectiveColorIntegrator : public ProjectiveIntegrator<ColorVoxel> {
                       ColorLayer* color_layer,
                       std::vector<Index3D>* updated_blocks = nullptr);
 
+  /// Integrates a color image, resolving occlusions with a depth frame taken
+  /// from the same pose rather than with a sphere traced synthetic depth
+  /// image. For registered and synchronized RGB-D cameras, this skips the
+  /// sphere tracing, as well as the blocks-in-view calculation if the blocks
+  /// in view of the depth frame's TSDF integration are passed in.
+  /// @param color_frame A color image.
+  /// @param depth_frame A depth image registered to the color image. Its
+  /// resolution must be that of the color image divided by an integer factor.
+  /// @param T_L_C The pose of the camera (shared by both images).
+  /// @param camera The camera (intrinsics) model of the color image.
+  /// @param tsdf_layer The TSDF layer with which the color layer associated.
+  /// @param block_indices_in_view The blocks in view of the depth frame, e.g.
+  /// the blocks updated by its TSDF integration.
+  /// @param color_layer A pointer to the layer into which this image will be
+  /// intergrated.
+  /// @param updated_blocks Optional pointer to a vector which will contain the
+  /// 3D indices of blocks affected by the integration.
+  void integrateFrame(const ColorImage& color_frame,
+                      const DepthImage& depth_frame, const Transform& T_L_C,
+                      const Camera& camera, const TsdfLayer& tsdf_layer,
+                      const std::vector<Index3D>& block_indices_in_view,
+                      ColorLayer* color_layer,
+                      std::vector<Index3D>* updated_blocks = nullptr);
+
   /// Returns the sphere tracer used for color integration.
   /// In order to perform color integration from an rgb image we have to
   /// determine which surfaces are in view. We use sphere tracing for this
@@ -113,6 +137,31 @@ class ProjectiveColorIntegrator : public ProjectiveIntegrator<ColorVoxel> {
   /// @param weighting_function_type The type of weighting function to be used
   void weighting_function_type(WeightingFunctionType weighting_function_type);
 
+  /// A parameter getter
+  /// Whether color blocks are only allocated (and updated) where the TSDF
+  /// block contains an *observed* voxel inside the truncation band. Unobserved
+  /// TSDF voxels have zero distance, so otherwise any TSDF block with an
+  /// unobserved voxel counts as being in the truncation band.
+  /// @returns whether allocation is restricted to the observed surface
+  bool surface_only_allocation() const;
+
+  /// A parameter setter
+  /// See surface_only_allocation().
+  /// @param surface_only_allocation whether to restrict allocation.
+  void surface_only_allocation(bool surface_only_allocation);
+
+  /// A parameter getter
+  /// Whether the mapper integrates color frames with the overload taking the
+  /// last depth frame (and its blocks in view) when possible, rather than
+  /// sphere tracing a synthetic depth image.
+  /// @returns whether the depth frame is reused
+  bool reuse_depth_frame() const;
+
+  /// A parameter setter
+  /// See reuse_depth_frame().
+  /// @param reuse_depth_frame whether to reuse the depth frame.
+  void reuse_depth_frame(bool reuse_depth_frame);
+
   /// Returns the object used to calculate the blocks in camera views.
   const ViewCalculator& view_calculator() const;
   /// Returns the object used to calculate the blocks in camera views.
@@ -136,6 +185,23 @@ class ProjectiveColorIntegrator : public ProjectiveIntegrator<ColorVoxel> {
   unified_ptr<UpdateColorVoxelFunctor> getColorUpdateFunctorOnDevice(
       float voxel_size);
 
+  // Reduces the blocks in view to those in the truncation band (see
+  // reduceBlocksToThoseInTruncationBand()) and allocates them in the color
+  // layer. Returns the reduced blocks.
+  std::vector<Index3D> reduceAndAllocateBlocksInView(
+      const std::vector<Index3D>& block_indices_in_view,
+      const TsdfLayer& tsdf_layer, ColorLayer* color_layer);
+
+  // Integrates the color image into the (allocated) blocks, using depth_frame
+  // to resolve occlusions. Shared between the sphere tracing and the depth
+  // frame versions of integrateFrame().
+  void updateBlocks(const std::vector<Index3D>& block_indices,
+                    const ColorImage& color_frame,
+                    const DepthImage& depth_frame, const Transform& T_L_C,
+                    const Camera& camera, const TsdfLayer& tsdf_layer,
+                    ColorLayer* color_layer,
+                    std::vector<Index3D>* updated_blocks);
+
   // Functor which defines the voxel update operation.
   unified_ptr<UpdateColorVoxelFunctor> update_functor_host_ptr_;
 
@@ -144,6 +210,9 @@ class ProjectiveColorIntegrator : public ProjectiveIntegrator<ColorVoxel> {
   float max_weight_ = kProjectiveIntegratorMaxWeightParamDesc.default_value;
   WeightingFunctionType weighting_function_type_ =
       kProjectiveIntegratorWeightingModeParamDesc.default_value;
+  bool surface_only_allocation_ = false;
+  bool reuse_depth_frame_ =
+      kProjectiveColorIntegratorReuseDepthFrameParamDesc.default_value;
 
   // Frustum calculation.
   mutable ViewCalculator view_calculator_;
@@ -62,6 +62,40 @@ constexpr Param<
     "sensor data. A negative value for this parameter disables the effect,"
     "i.e. no decay takes place."};
 
+constexpr Param<bool>::Description
+    kProjectiveColorIntegratorSurfaceOnlyAllocationParamDesc{
+        "projective_color_integrator_surface_only_allocation", false,
+        "Whether to only allocate color blocks where the TSDF block contains an "
+        "observed voxel inside the truncation band. Otherwise unobserved TSDF "
+        "voxels, which have zero distance, also lead to color allocations."};
+
+constexpr Param<bool>::Description
+    kProjectiveColorIntegratorReuseDepthFrameParamDesc{
+        "projective_color_integrator_reuse_depth_frame", false,
+        "Whether color integration resolves occlusions with the last "
+        "(preprocessed) depth frame and reuses the blocks in view of its TSDF "
+        "integration, instead of sphere tracing a synthetic depth image. Only "
+        "applies to color frames taken from the pose of the depth frame, with "
+        "the resolution of the depth frame or an integer multiple of it, i.e. "
+        "registered and synchronized RGB-D cameras. Other color frames fall "
+        "back to sphere tracing."};
+
+constexpr Param<bool>::Description
+    kLidarProjectiveIntegratorApproximateProjectionParamDesc{
+        "lidar_projective_integrator_approximate_projection", false,
+        "Whether LiDAR integration projects voxels with a polynomial "
+        "approximation of the arctangent (max. error ~1e-5 rad) instead of "
+        "the atan2() and acos() calls, which dominate LiDAR integration on "
+        "embedded GPUs."};
+
+constexpr Param<
+    int>::Description kProjectiveIntegratorSubsamplingFactorParamDesc{
+    "projective_integrator_subsampling_factor", 1,
+    "The factor by which camera depth frames are downscaled before projective "
+    "(TSDF and occupancy) integration, keeping the nearest depth of each "
+    "patch. 1 integrates at full resolution. Trades detail for a steady "
+    "integration rate under load, and can be changed per frame."};
+
 struct ProjectiveIntegratorParams {
   Param<float> projective_integrator_max_integration_distance_m{
       kProjectiveIntegratorMaxIntegrationDistanceMParamDesc};
@@ -75,6 +109,14 @@ struct ProjectiveIntegratorParams {
       kProjectiveIntegratorMaxWeightParamDesc};
   Param<float> projective_tsdf_integrator_invalid_depth_decay_factor{
       kProjectiveTsdfIntegratorInvalidDepthDecayFactor};
+  Param<bool> projective_color_integrator_surface_only_allocation{
+      kProjectiveColorIntegratorSurfaceOnlyAllocationParamDesc};
+  Param<bool> projective_color_integrator_reuse_depth_frame{
+      kProjectiveColorIntegratorReuseDepthFrameParamDesc};
+  Param<bool> lidar_projective_integrator_approximate_projection{
+      kLidarProjectiveIntegratorApproximateProjectionParamDesc};
+  Param<int> projective_integrator_subsampling_factor{
+      kProjectiveIntegratorSubsamplingFactorParamDesc};
 };
 
 }  // namespace nvblox
@@ -52,6 +52,45 @@ class ProjectiveOccupancyIntegrator
                       OccupancyLayer* layer,
                       std::vector<Index3D>* updated_blocks = nullptr);
 
+  /// Integrates a depth image in to the passed occupancy layer and the class
+  /// labels of label_image in to label_layer. See
+  /// ProjectiveTsdfIntegrator::integrateFrame().
+  void integrateFrame(const MaskedDepthImageConstView& depth_frame,
+                      const MonoImageConstView& label_image,
+                      const Transform& T_L_C, const Camera& camera,
+                      OccupancyLayer* layer, LabelLayer* label_layer,
+                      std::vector<Index3D>* updated_blocks = nullptr);
+
+  /// Integrates several depth images in to the passed occupancy layer in a
+  /// single pass. See ProjectiveTsdfIntegrator::integrateFrames().
+  /// @param depth_frames The depth images.
+  /// @param T_L_C_vec The poses of the cameras, one per depth image.
+  /// @param cameras The camera (intrinsics) models, one per depth image.
+  /// @param layer A pointer to the layer into which the observations will be
+  /// intergrated.
+  /// @param updated_blocks Optional pointer to a vector which will contain
+  /// the 3D indices of blocks affected by the integration.
+  void integrateFrames(
+      const std::vector<MaskedDepthImageConstView>& depth_frames,
+      const std::vector<Transform>& T_L_C_vec,
+      const std::vector<Camera>& cameras, OccupancyLayer* layer,
+      std::vector<Index3D>* updated_blocks = nullptr);
+
+  /// Integrates several LiDAR depth images in to the passed occupancy layer in
+  /// a single pass. See ProjectiveTsdfIntegrator::integrateFrames().
+  /// @param depth_frames The depth images.
+  /// @param T_L_C_vec The poses of the LiDARs, one per depth image.
+  /// @param lidars The LiDAR models, one per depth image.
+  /// @param layer A pointer to the layer into which the observations will be
+  /// intergrated.
+  /// @param updated_blocks Optional pointer to a vector which will contain
+  /// the 3D indices of blocks affected by the integration.
+  void integrateFrames(
+      const std::vector<MaskedDepthImageConstView>& depth_frames,
+      const std::vector<Transform>& T_L_C_vec,
+      const std::vector<Lidar>& lidars, OccupancyLayer* layer,
+      std::vector<Index3D>* updated_blocks = nullptr);
+
   /// Integrates a depth image in to the passed occupancy layer.
   /// @param depth_frame A depth image.
   /// @param T_L_C The pose of the camera. Supplied as a Transform mapping
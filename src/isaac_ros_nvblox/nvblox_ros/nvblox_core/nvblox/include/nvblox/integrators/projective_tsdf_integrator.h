@@ -45,10 +45,62 @@ class ProjectiveTsdfIntegrator : public ProjectiveIntegrator<TsdfVoxel> {
   /// intergrated.
   /// @param updated_blocks Optional pointer to a vector which will contain the
   /// 3D indices of blocks affected by the integration.
+  /// @param updated_voxel_masks Optional pointer to a vector which will contain
+  /// one mask per block in updated_blocks, flagging the voxels whose distance
+  /// or observed-state changed.
   void integrateFrame(const MaskedDepthImageConstView& depth_frame,
                       const Transform& T_L_C, const Camera& camera,
                       TsdfLayer* layer,
-                      std::vector<Index3D>* updated_blocks = nullptr);
+                      std::vector<Index3D>* updated_blocks = nullptr,
+                      std::vector<VoxelBlockMask>* updated_voxel_masks =
+                          nullptr);
+
+  /// Integrates a depth image in to the passed TSDF layer and the per-voxel
+  /// class labels of label_image in to label_layer, in the same kernel.
+  /// Voxels near the surface vote for the label of their (masked) pixel,
+  /// voxels in front of the truncation band vote for free space.
+  /// @param depth_frame A depth image. Only masked pixels vote for labels.
+  /// @param label_image The class of each pixel, below
+  /// LabelVoxel::kNumLabels.
+  /// May have a different resolution than depth_frame.
+  /// @param T_L_C The pose of the camera.
+  /// @param camera A the camera (intrinsics) model of depth_frame.
+  /// @param layer A pointer to the layer into which this observation will be
+  /// intergrated.
+  /// @param label_layer The label layer. Must have the block size of layer.
+  /// @param updated_blocks See above.
+  /// @param updated_voxel_masks See above.
+  void integrateFrame(const MaskedDepthImageConstView& depth_frame,
+                      const MonoImageConstView& label_image,
+                      const Transform& T_L_C, const Camera& camera,
+                      TsdfLayer* layer, LabelLayer* label_layer,
+                      std::vector<Index3D>* updated_blocks = nullptr,
+                      std::vector<VoxelBlockMask>* updated_voxel_masks =
+                          nullptr);
+
+  /// Integrates an integer depth image (e.g. uint16 millimeters, as output by
+  /// most depth cameras) in to the passed TSDF layer. Depth is converted to
+  /// meters on the fly, which avoids allocating and writing a float copy of
+  /// the image. The in-view voxel masks (see in_view_voxel_masks()) are
+  /// recorded as for float images, such that the freespace update can follow.
+  /// @param depth_frame An integer depth image.
+  /// @param depth_scale_m The factor converting pixel values to meters.
+  /// @param T_L_C The pose of the camera. Supplied as a Transform mapping
+  /// points in the camera frame (C) to the layer frame (L).
+  /// @param camera A the camera (intrinsics) model.
+  /// @param layer A pointer to the layer into which this observation will be
+  /// intergrated.
+  /// @param updated_blocks Optional pointer to a vector which will contain the
+  /// 3D indices of blocks affected by the integration.
+  /// @param updated_voxel_masks Optional pointer to a vector which will contain
+  /// one mask per block in updated_blocks, flagging the voxels whose distance
+  /// or observed-state changed.
+  void integrateFrame(const MaskedDepthImageU16ConstView& depth_frame,
+                      const float depth_scale_m, const Transform& T_L_C,
+                      const Camera& camera, TsdfLayer* layer,
+                      std::vector<Index3D>* updated_blocks = nullptr,
+                      std::vector<VoxelBlockMask>* updated_voxel_masks =
+                          nullptr);
 
   /// Integrates a depth image in to the passed TSDF layer.
   /// @param depth_frame A depth image.
@@ -59,10 +111,54 @@ class ProjectiveTsdfIntegrator : public ProjectiveIntegrator<TsdfVoxel> {
   /// intergrated.
   /// @param updated_blocks Optional pointer to a vector which will contain the
   /// 3D indices of blocks affected by the integration.
+  /// @param updated_voxel_masks Optional pointer to a vector which will contain
+  /// one mask per block in updated_blocks, flagging the voxels whose distance
+  /// or observed-state changed.
   void integrateFrame(const MaskedDepthImageConstView& depth_frame,
                       const Transform& T_L_C, const Lidar& lidar,
                       TsdfLayer* layer,
-                      std::vector<Index3D>* updated_blocks = nullptr);
+                      std::vector<Index3D>* updated_blocks = nullptr,
+                      std::vector<VoxelBlockMask>* updated_voxel_masks =
+                          nullptr);
+
+  /// Integrates several depth images in to the passed TSDF layer in a single
+  /// pass. Cheaper than calling integrateFrame() for each image because block
+  /// allocation, transfer and the integration kernel are shared by all views.
+  /// @param depth_frames The depth images.
+  /// @param T_L_C_vec The poses of the cameras, one per depth image.
+  /// @param cameras The camera (intrinsics) models, one per depth image.
+  /// @param layer A pointer to the layer into which the observations will be
+  /// intergrated.
+  /// @param updated_blocks Optional pointer to a vector which will contain the
+  /// 3D indices of blocks affected by the integration.
+  /// @param updated_voxel_masks Optional pointer to a vector which will contain
+  /// one mask per block in updated_blocks, flagging the voxels whose distance
+  /// or observed-state changed.
+  void integrateFrames(
+      const std::vector<MaskedDepthImageConstView>& depth_frames,
+      const std::vector<Transform>& T_L_C_vec,
+      const std::vector<Camera>& cameras, TsdfLayer* layer,
+      std::vector<Index3D>* updated_blocks = nullptr,
+      std::vector<VoxelBlockMask>* updated_voxel_masks = nullptr);
+
+  /// Integrates several LiDAR depth images in to the passed TSDF layer in a
+  /// single pass, e.g. the scans of several LiDARs mounted on the same robot.
+  /// @param depth_frames The depth images.
+  /// @param T_L_C_vec The poses of the LiDARs, one per depth image.
+  /// @param lidars The LiDAR models, one per depth image.
+  /// @param layer A pointer to the layer into which the observations will be
+  /// intergrated.
+  /// @param updated_blocks Optional pointer to a vector which will contain the
+  /// 3D indices of blocks affected by the integration.
+  /// @param updated_voxel_masks Optional pointer to a vector which will contain
+  /// one mask per block in updated_blocks, flagging the voxels whose distance
+  /// or observed-state changed.
+  void integrateFrames(
+      const std::vector<MaskedDepthImageConstView>& depth_frames,
+      const std::vector<Transform>& T_L_C_vec,
+      const std::vector<Lidar>& lidars, TsdfLayer* layer,
+      std::vector<Index3D>* updated_blocks = nullptr,
+      std::vector<VoxelBlockMask>* updated_voxel_masks = nullptr);
 
   /// A parameter getter
   /// The maximum weight that voxels can have. The integrator clips the
@@ -141,9 +237,11 @@ class ProjectiveTsdfIntegrator : public ProjectiveIntegrator<TsdfVoxel> {
  protected:
   std::string getIntegratorName() const override;
 
-  // Internally used to move the VoxelUpdateFunctor to the device
-  unified_ptr<UpdateTsdfVoxelFunctor> getTsdfUpdateFunctorOnDevice(
-      float voxel_size);
+  // Internally used to move the VoxelUpdateFunctor to the device and to call
+  // integrate(op) with the functor on the device.
+  template <typename IntegrateFunction>
+  void integrateWithUpdateFunctor(float voxel_size,
+                                  IntegrateFunction integrate);
 
   // Functor which defines the voxel update operation.
   unified_ptr<UpdateTsdfVoxelFunctor> update_functor_host_ptr_;
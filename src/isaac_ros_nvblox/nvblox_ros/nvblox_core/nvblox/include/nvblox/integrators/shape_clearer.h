@@ -34,6 +34,10 @@ class ShapeClearer {
   ~ShapeClearer() = default;
 
   /// @brief Clearing the bounding shapes in the layer.
+  /// The shapes are binned into the blocks they touch, such that blocks
+  /// touched by no shape are skipped and each voxel is only tested against
+  /// the shapes touching its block. The cost therefore scales with the
+  /// volume covered by the shapes rather than with blocks times shapes.
   /// @param bounding_shapes The bounding shapes that define which voxels to
   /// clear.
   /// @param layer_ptr The layer we want to clear.
@@ -42,6 +46,14 @@ class ShapeClearer {
                              LayerType* layer_ptr);
 
  private:
+  // Bin the shapes into the allocated blocks they touch. Outputs, for each
+  // touched block, the range [offsets[i], offsets[i+1]) of shape_indices.
+  void binShapesIntoBlocks(const std::vector<BoundingShape>& bounding_shapes,
+                           const LayerType& layer,
+                           std::vector<Index3D>* block_indices,
+                           std::vector<int>* shape_offsets,
+                           std::vector<int>* shape_indices) const;
+
   // Host and device buffers.
   host_vector<Index3D> block_indices_host_;
   host_vector<BlockType*> block_ptrs_host_;
@@ -49,6 +61,8 @@ class ShapeClearer {
   device_vector<Index3D> block_indices_device_;
   device_vector<BlockType*> block_ptrs_device_;
   device_vector<BoundingShape> shapes_to_clear_device_;
+  device_vector<int> shape_offsets_device_;
+  device_vector<int> shape_indices_device_;
 
   // CUDA stream to process integration on.
   std::shared_ptr<CudaStream> cuda_stream_;
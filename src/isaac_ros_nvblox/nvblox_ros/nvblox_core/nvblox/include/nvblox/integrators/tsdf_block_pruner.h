@@ -0,0 +1,113 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "nvblox/core/cuda_stream.h"
+#include "nvblox/core/parameter_tree.h"
+#include "nvblox/core/unified_vector.h"
+#include "nvblox/integrators/tsdf_block_pruner_params.h"
+#include "nvblox/map/common_names.h"
+
+namespace nvblox {
+
+/// Finds the blocks of a TSDF layer which no longer carry information, such
+/// that they can be returned to the block memory pool. These are blocks whose
+/// voxels all have a weight below min_weight() (e.g. after decay) and,
+/// optionally, blocks whose observed voxels all lie outside the truncation
+/// band (i.e. blocks which only carry freespace).
+///
+/// The blocks are tested on the GPU, with one thread block per TSDF block, so
+/// a pass costs a single kernel launch and a copy of one flag per block.
+class TsdfBlockPruner {
+ public:
+  TsdfBlockPruner();
+  TsdfBlockPruner(std::shared_ptr<CudaStream> cuda_stream);
+  ~TsdfBlockPruner() = default;
+
+  /// Finds the blocks to prune. The layer is not modified.
+  /// @param layer The layer to search.
+  /// @param truncation_distance_m The truncation distance of the layer. Only
+  /// used if prune_outside_truncation_band() is true.
+  /// @return The indices of the blocks which can be deallocated.
+  std::vector<Index3D> getBlocksToPrune(const TsdfLayer& layer,
+                                        float truncation_distance_m);
+
+  /// Registers a single depth integration.
+  void registerIntegration();
+
+  /// Whether enough integrations were registered since the last pass that
+  /// another one is due. Pruning passes are due every period() integrations.
+  /// Resets the count if a pass is due.
+  /// @return True if a pruning pass should be run.
+  bool isPruningDue();
+
+  /// A parameter getter for the pruning period.
+  /// @returns The number of integrations between pruning passes. 0 means
+  /// that pruning is disabled.
+  int period() const;
+
+  /// A parameter setter for the pruning period.
+  /// @param period The number of integrations between pruning passes. 0
+  /// disables pruning.
+  void period(const int period);
+
+  /// A parameter getter for the minimum weight.
+  /// @returns The weight below which a voxel is considered to be empty.
+  float min_weight() const;
+
+  /// A parameter setter for the minimum weight.
+  /// @param min_weight The weight below which a voxel is considered to be
+  /// empty.
+  void min_weight(const float min_weight);
+
+  /// A parameter getter for the truncation band flag.
+  /// @returns Whether blocks without voxels in the truncation band are
+  /// pruned.
+  bool prune_outside_truncation_band() const;
+
+  /// A parameter setter for the truncation band flag.
+  /// @param prune_outside_truncation_band Whether blocks without voxels in
+  /// the truncation band are pruned.
+  void prune_outside_truncation_band(const bool prune_outside_truncation_band);
+
+  /// Return the parameter tree.
+  /// @return the parameter tree
+  parameters::ParameterTreeNode getParameterTree(
+      const std::string& name_remap = std::string()) const;
+
+ private:
+  // Params
+  int period_{kTsdfBlockPruningPeriodDesc.default_value};
+  float min_weight_{kTsdfBlockPruningMinWeightDesc.default_value};
+  bool prune_outside_truncation_band_{
+      kTsdfBlockPruningPruneOutsideTruncationBandDesc.default_value};
+
+  // The number of integrations since the last pruning pass.
+  int num_integrations_since_pruning_{0};
+
+  // Per-block keep flags.
+  device_vector<bool> keep_block_device_;
+  host_vector<bool> keep_block_host_;
+
+  // CUDA stream to process pruning on.
+  std::shared_ptr<CudaStream> cuda_stream_;
+};
+
+}  // namespace nvblox
@@ -0,0 +1,47 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#pragma once
+
+#include "nvblox/utils/params.h"
+
+namespace nvblox {
+
+constexpr Param<int>::Description kTsdfBlockPruningPeriodDesc{
+    "tsdf_block_pruning_period", 0,
+    "The number of depth integrations between TSDF block pruning passes. A "
+    "pass deallocates the blocks which no longer carry information. 0 "
+    "disables pruning."};
+
+constexpr Param<float>::Description kTsdfBlockPruningMinWeightDesc{
+    "tsdf_block_pruning_min_weight", 1e-3,
+    "Blocks in which the weights of all voxels are below this value are "
+    "pruned."};
+
+constexpr Param<bool>::Description
+    kTsdfBlockPruningPruneOutsideTruncationBandDesc{
+        "tsdf_block_pruning_prune_outside_truncation_band", false,
+        "If true, blocks in which no observed voxel lies within the truncation "
+        "band are pruned too. Such blocks only carry freespace, which is lost "
+        "by pruning them."};
+
+struct TsdfBlockPrunerParams {
+  Param<int> tsdf_block_pruning_period{kTsdfBlockPruningPeriodDesc};
+  Param<float> tsdf_block_pruning_min_weight{kTsdfBlockPruningMinWeightDesc};
+  Param<bool> tsdf_block_pruning_prune_outside_truncation_band{
+      kTsdfBlockPruningPruneOutsideTruncationBandDesc};
+};
+
+}  // namespace nvblox
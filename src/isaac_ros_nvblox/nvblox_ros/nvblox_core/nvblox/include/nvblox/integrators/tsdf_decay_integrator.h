@@ -18,6 +18,7 @@ limitations under the License.
 #include <memory>
 
 #include "nvblox/core/cuda_stream.h"
+#include "nvblox/core/hash.h"
 #include "nvblox/core/log_odds.h"
 #include "nvblox/core/parameter_tree.h"
 #include "nvblox/integrators/internal/decay_integrator_base.h"
@@ -32,6 +33,13 @@ namespace nvblox {
 /// Decay a Tsdf layer. The decay operation for a TsdfLayer reduces the weight,
 /// until (optionally) a block is deallocated or set to some (freespace)
 /// distance.
+///
+/// In addition to decaying the whole layer on each call to decay(), the
+/// integrator supports lazy decay (see lazy_decay()). In that mode decay steps
+/// are only counted, and the accumulated decay is applied to a block when it's
+/// about to be integrated (applyPendingDecay()) or during periodic compaction
+/// passes (applyAllPendingDecay()). The cost of a decay step then scales with
+/// the number of blocks being observed rather than the size of the map.
 class TsdfDecayIntegrator : public DecayIntegratorBase<TsdfLayer> {
  public:
   TsdfDecayIntegrator() = default;
@@ -124,12 +132,73 @@ class TsdfDecayIntegrator : public DecayIntegratorBase<TsdfLayer> {
   /// voxels to when set_free_distance_on_decayed is true.
   void free_distance_vox(const float free_distance_vox);
 
+  /// Registers a single (lazy) decay step, without touching the layer.
+  void addPendingDecayStep();
+
+  /// Whether enough decay steps were registered since the last compaction pass
+  /// that another one is due. See lazy_decay_compaction_period().
+  /// @return True if applyAllPendingDecay() should be called.
+  bool isCompactionDue() const;
+
+  /// Applies the decay steps that are pending for the passed blocks. Should be
+  /// called before integrating into the blocks. Blocks which are not allocated
+  /// are skipped, but marked as up to date, such that blocks allocated by the
+  /// subsequent integration don't inherit pending decay.
+  /// @param layer_ptr     Layer to decay
+  /// @param block_indices The blocks to bring up to date.
+  /// @param cuda_stream   Cuda stream for GPU work
+  void applyPendingDecay(TsdfLayer* layer_ptr,
+                         const std::vector<Index3D>& block_indices,
+                         const CudaStream& cuda_stream);
+
+  /// Marks the passed blocks as up to date without decaying them. Used for
+  /// blocks which were allocated by an integration whose view (and therefore
+  /// the blocks passed to applyPendingDecay()) isn't known in advance.
+  /// @param block_indices The blocks to mark.
+  void markBlocksAsDecayed(const std::vector<Index3D>& block_indices);
+
+  /// Applies the pending decay steps to all blocks in the layer (a compaction
+  /// pass). Fully decayed blocks will be deallocated if
+  /// deallocate_decayed_blocks is true.
+  /// @param layer_ptr    Layer to decay
+  /// @param cuda_stream  Cuda stream for GPU work
+  /// @return A vector containing the indices of the blocks deallocated.
+  std::vector<Index3D> applyAllPendingDecay(TsdfLayer* layer_ptr,
+                                            const CudaStream& cuda_stream);
+
+  /// The number of decay steps which are pending for a block.
+  /// @param block_index The index of the block.
+  /// @return The number of pending decay steps.
+  int numPendingDecaySteps(const Index3D& block_index) const;
+
+  /// A parameter getter for the lazy decay flag.
+  /// @returns Whether decay steps are applied lazily (see class description).
+  bool lazy_decay() const;
+
+  /// A parameter setter for the lazy decay flag.
+  /// @param lazy_decay Whether decay steps are applied lazily.
+  void lazy_decay(const bool lazy_decay);
+
+  /// A parameter getter for the lazy decay compaction period.
+  /// @returns The number of lazy decay steps between compaction passes.
+  int lazy_decay_compaction_period() const;
+
+  /// A parameter setter for the lazy decay compaction period.
+  /// @param lazy_decay_compaction_period The number of lazy decay steps between
+  /// compaction passes.
+  void lazy_decay_compaction_period(const int lazy_decay_compaction_period);
+
   /// Return the parameter tree.
   /// @return the parameter tree
   virtual parameters::ParameterTreeNode getParameterTree(
       const std::string& name_remap = std::string()) const;
 
  private:
+  // Decays each of the passed (allocated) blocks by its pending decay steps.
+  std::vector<Index3D> decayByPendingSteps(
+      TsdfLayer* layer_ptr, const std::vector<Index3D>& block_indices,
+      const bool deallocate_decayed_blocks, const CudaStream& cuda_stream);
+
   // The decayer which performs the decay
   VoxelDecayer<TsdfLayer> decayer_;
 
@@ -153,6 +222,21 @@ class TsdfDecayIntegrator : public DecayIntegratorBase<TsdfLayer> {
   // AND set_free_distance_on_decayed is true. Should be equal or greater than
   // the truncation distance.
   float free_distance_vox_{kTsdfDecayedFreeDistanceVoxDesc.default_value};
+
+  // Lazy decay parameters. See the getters above.
+  bool lazy_decay_{kTsdfLazyDecayDesc.default_value};
+  int lazy_decay_compaction_period_{
+      kTsdfLazyDecayCompactionPeriodDesc.default_value};
+
+  // The number of lazy decay steps registered so far, and the step at which
+  // the last compaction pass brought all blocks up to date.
+  int num_decay_steps_ = 0;
+  int last_compaction_step_ = 0;
+
+  // The step up to which each block was decayed, for blocks which were brought
+  // up to date since the last compaction pass. All other blocks are up to date
+  // as of last_compaction_step_.
+  Index3DHashMapType<int>::type last_decay_step_per_block_;
 };
 
 }  // namespace nvblox
@@ -37,12 +37,27 @@ constexpr Param<float>::Description kTsdfDecayedFreeDistanceVoxDesc{
     "The distance in voxels that we give to fully decayed voxels "
     "(if requested)."};
 
+constexpr Param<bool>::Description kTsdfLazyDecayDesc{
+    "tsdf_lazy_decay", false,
+    "If true, decay calls only count decay steps. The accumulated decay is "
+    "applied to blocks when they are next integrated, and to all blocks in "
+    "periodic compaction passes."};
+
+constexpr Param<int>::Description kTsdfLazyDecayCompactionPeriodDesc{
+    "tsdf_lazy_decay_compaction_period", 10,
+    "The number of (lazy) decay steps between compaction passes. A compaction "
+    "pass applies the pending decay to all blocks and deallocates fully "
+    "decayed blocks (if requested)."};
+
 struct TsdfDecayIntegratorParams {
   Param<float> tsdf_decay_factor{kTsdfDecayFactorParamDesc};
   Param<float> tsdf_decayed_weight_threshold{kTsdfDecayedWeightThresholdDesc};
   Param<bool> tsdf_set_free_distance_on_decayed{
       kTsdfSetFreeDistanceOnDecayedDesc};
   Param<float> tsdf_decayed_free_distance_vox{kTsdfDecayedFreeDistanceVoxDesc};
+  Param<bool> tsdf_lazy_decay{kTsdfLazyDecayDesc};
+  Param<int> tsdf_lazy_decay_compaction_period{
+      kTsdfLazyDecayCompactionPeriodDesc};
 };
 
 }  // namespace nvblox
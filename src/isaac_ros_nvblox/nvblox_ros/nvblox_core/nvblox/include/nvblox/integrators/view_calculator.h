@@ -17,15 +17,19 @@ limitations under the License.
 
 #include <deque>
 #include <memory>
+#include <mutex>
 
 #include "nvblox/core/cuda_stream.h"
 #include "nvblox/core/parameter_tree.h"
+#include "nvblox/core/scratch_arena.h"
 #include "nvblox/core/types.h"
 #include "nvblox/core/unified_vector.h"
 #include "nvblox/geometry/workspace_bounds.h"
 #include "nvblox/integrators/view_calculator_params.h"
 #include "nvblox/sensors/camera.h"
+#include "nvblox/sensors/depth_pyramid.h"
 #include "nvblox/sensors/image.h"
+#include "nvblox/sensors/internal/camera_ray_cache.h"
 #include "nvblox/sensors/lidar.h"
 namespace nvblox {
 
@@ -45,7 +49,9 @@ class ViewCalculator {
 
   /// Gets blocks which fall into the camera view (without using an image)
   /// Operates by checking if voxel block corners fall inside the pyramid formed
-  /// by the 4 images sides and the max distance plane.
+  /// by the 4 images sides and the max distance plane. If
+  /// hierarchical_planes_culling() is set, groups of blocks are tested at once
+  /// first, and only groups which straddle the pyramid are tested per block.
   /// @param T_L_C The pose of the camera. Supplied as a Transform mapping
   /// points in the camera frame (C) to the layer frame (L).
   /// @param camera The camera (intrinsics) model.
@@ -62,6 +68,9 @@ class ViewCalculator {
   /// Operates by ray through the grid returning the blocks traversed in the ray
   /// casting process. The number of pixels on the image plane raycast is
   /// determined by the class parameter raycast_subsampling_factor.
+  /// Rays are clipped to the workspace bounds, such that only blocks inside
+  /// the workspace are returned, and rays which only pass through space
+  /// outside of the workspace are skipped.
   /// @param depth_frame the depth image.
   /// @param T_L_C The pose of the camera. Supplied as a Transform mapping
   /// points in the camera frame (C) to the layer frame (L).
@@ -76,6 +85,15 @@ class ViewCalculator {
       const float max_integration_distance_behind_surface_m,
       const float max_integration_distance_m);
 
+  /// As above, for an integer depth image which is converted to meters by
+  /// multiplying with depth_scale_m.
+  std::vector<Index3D> getBlocksInImageViewRaycast(
+      const MaskedDepthImageU16ConstView& depth_frame,
+      const float depth_scale_m, const Transform& T_L_C, const Camera& camera,
+      const float block_size,
+      const float max_integration_distance_behind_surface_m,
+      const float max_integration_distance_m);
+
   /// Gets blocks which fall into the lidar view (using a depth image)
   /// Performs ray casting to get the blocks in view
   /// Operates by ray through the grid returning the blocks traversed in the ray
@@ -134,6 +152,17 @@ class ViewCalculator {
   void workspace_bounds_max_corner_m(
       const Vector3f& workspace_bounds_max_corner_m);
 
+  /// A parameter getter
+  /// Whether getBlocksInViewPlanes() first culls groups of blocks (see
+  /// kHierarchicalPlanesCullingDesc).
+  /// @returns whether hierarchical culling is used
+  bool hierarchical_planes_culling() const;
+
+  /// A parameter setter
+  /// See hierarchical_planes_culling()
+  /// @param hierarchical_planes_culling whether to use hierarchical culling
+  void hierarchical_planes_culling(bool hierarchical_planes_culling);
+
   /// @brief A parameter getter
   /// @return Whether or not to avoid re-computing viewpoints for repeated
   /// queries.
@@ -160,6 +189,38 @@ class ViewCalculator {
   void set_viewpoint_cache(std::shared_ptr<ViewpointCache> viewpoint_cache,
                            const CalculationType calculation_type);
 
+  /// Getter
+  /// @return The arena from which temporary device buffers are allocated, or
+  /// nullptr if the calculator uses its own buffers.
+  ScratchArena* scratch_arena() const;
+
+  /// Setter. See scratch_arena(). The arena has to be used on the same stream
+  /// as the calculator, and has to outlive it.
+  /// @param scratch_arena The arena, or nullptr to use own buffers.
+  void scratch_arena(ScratchArena* scratch_arena);
+
+  /// Getter
+  /// @return The (not owned) depth pyramid used when raycasting, or nullptr.
+  const DepthPyramid* depth_pyramid() const;
+
+  /// Setter. See depth_pyramid(). If the pyramid was built from the depth
+  /// frame being raycast and has a level matching
+  /// raycast_subsampling_factor(), each ray is cast to the max depth of the
+  /// pixels it represents rather than to the depth of its own pixel. Rays of
+  /// patches without valid depth are skipped. The pyramid has to outlive the
+  /// calculator.
+  /// @param depth_pyramid The pyramid, or nullptr to not use one.
+  void depth_pyramid(const DepthPyramid* depth_pyramid);
+
+  /// Getter
+  /// @return The cache of camera rays used when raycasting camera images.
+  std::shared_ptr<CameraRayCache> camera_ray_cache() const;
+
+  /// Setter. See camera_ray_cache(). Allows sharing the rays with other
+  /// components working on the same stream.
+  /// @param camera_ray_cache The cache.
+  void camera_ray_cache(std::shared_ptr<CameraRayCache> camera_ray_cache);
+
   /// Return the parameter tree.
   /// @return the parameter tree
   virtual parameters::ParameterTreeNode getParameterTree(
@@ -167,11 +228,12 @@ class ViewCalculator {
 
  private:
   // Raycasts through (possibly subsampled) pixels in the image.
-  template <typename SensorType>
+  template <typename SensorType, typename DepthFrameType>
   void getBlocksByRaycastingPixelsAsync(
       const Transform& T_L_C,                                 // NOLINT
       const SensorType& camera,                               // NOLINT
-      const MaskedDepthImageConstView& depth_frame,           // NOLINT
+      const DepthFrameType& depth_frame,                      // NOLINT
+      const float depth_scale_m,                              // NOLINT
       float block_size,                                       // NOLINT
       const float max_integration_distance_behind_surface_m,  // NOLINT
       const float max_integration_distance_m,                 // NOLINT
@@ -181,19 +243,31 @@ class ViewCalculator {
 
   // Templated version of the public getBlocksInImageViewRaycast() methods.
   // Internally we use this templated version of this function called with
-  // Camera and Lidar classes.
-  template <typename SensorType>
+  // Camera and Lidar classes, and float or integer depth images. Depth is
+  // converted to meters by multiplying with depth_scale_m.
+  template <typename SensorType, typename DepthFrameType>
   std::vector<Index3D> getBlocksInImageViewRaycastTemplate(
-      const MaskedDepthImageConstView& depth_frame, const Transform& T_L_C,
-      const SensorType& camera, const float block_size,
+      const DepthFrameType& depth_frame, const float depth_scale_m,
+      const Transform& T_L_C, const SensorType& camera, const float block_size,
       const float max_integration_distance_behind_surface_m,
       const float max_integration_distance_m);
 
   // A 3D grid of bools, one for each block in the AABB, which indicates if it
-  // is in the view. The 3D grid is represented as a flat vector.
+  // is in the view. The 3D grid is represented as a flat vector. The device
+  // buffer is only used when there's no scratch arena.
   device_vector<bool> aabb_device_buffer_;
   host_vector<bool> aabb_host_buffer_;
 
+  // Optional (not owned) arena for temporary device buffers.
+  ScratchArena* scratch_arena_ = nullptr;
+
+  // Optional (not owned) pyramid of the depth frame being raycast.
+  const DepthPyramid* depth_pyramid_ = nullptr;
+
+  // The (possibly shared) per-pixel rays of the cameras raycast.
+  std::shared_ptr<CameraRayCache> camera_ray_cache_ =
+      std::make_shared<CameraRayCache>();
+
   // Parameters.
   unsigned int raycast_subsampling_factor_ =
       kRaycastSubsamplingFactorDesc.default_value;
@@ -211,6 +285,8 @@ class ViewCalculator {
       kWorkspaceBoundsMinCornerYDesc.default_value;
   float workspace_bounds_max_corner_y_m_ =
       kWorkspaceBoundsMaxCornerYDesc.default_value;
+  bool hierarchical_planes_culling_ =
+      kHierarchicalPlanesCullingDesc.default_value;
 
   // Caching the last viewpoint calculation.
   bool cache_last_viewpoint_ = true;
@@ -221,54 +297,76 @@ class ViewCalculator {
   std::shared_ptr<CudaStream> cuda_stream_;
 };
 
+/// A cache of blocks in view. Thread-safe, such that it can be shared between
+/// integrators running concurrently.
 class ViewpointCache {
  public:
-  /// Gets a cached result of previous getBlocksInViewCalls, if the viewpoint
-  /// and intrinsics were the same.
+  /// The extent of a view, which next to the viewpoint determines the blocks in
+  /// view. Integrators sharing a cache may query the same viewpoint with
+  /// different extents (e.g. the TSDF and the color integrator), which must not
+  /// hit each other's results.
+  struct ViewExtent {
+    float block_size;
+    float max_distance_m;
+    float max_distance_behind_surface_m = 0.0f;
+  };
+
+  /// Gets a cached result of previous getBlocksInViewCalls, if the viewpoint,
+  /// intrinsics and view extent were the same.
   /// @param T_L_C The pose of the camera.
   /// @param camera The intrinsics of the camera.
-  /// @return The cached blocks in view if the viewpoint is the same, otherwise
+  /// @param extent The block size and distances of the view.
+  /// @return The cached blocks in view if the view is the same, otherwise
   /// std::nullopt.
   std::optional<std::vector<Index3D>> getCachedResult(
-      const Transform& T_L_C, const Camera& camera) const;
+      const Transform& T_L_C, const Camera& camera,
+      const ViewExtent& extent) const;
 
-  /// Gets a cached result of previous getBlocksInViewCalls, if the viewpoint
-  /// and intrinsics were the same.
+  /// Gets a cached result of previous getBlocksInViewCalls, if the viewpoint,
+  /// intrinsics and view extent were the same.
   /// @param T_L_C The pose of the lidar.
   /// @param lidar The intrinsics of the lidar.
-  /// @return The cached blocks in view if the viewpoint is the same, otherwise
+  /// @param extent The block size and distances of the view.
+  /// @return The cached blocks in view if the view is the same, otherwise
   /// std::nullopt.
-  std::optional<std::vector<Index3D>> getCachedResult(const Transform& T_L_C,
-                                                      const Lidar& lidar) const;
+  std::optional<std::vector<Index3D>> getCachedResult(
+      const Transform& T_L_C, const Lidar& lidar,
+      const ViewExtent& extent) const;
 
   /// Stores the result of a call to getBlocksInView*() in the cache.
   /// @param T_L_C The pose of the camera.
   /// @param camera The intrinsics of the camera.
+  /// @param extent The block size and distances of the view.
   /// @param blocks_in_view The calculated blocks in view list.
   void storeResultInCache(const Transform& T_L_C, const Camera& camera,
+                          const ViewExtent& extent,
                           const std::vector<Index3D>& blocks_in_view);
 
   /// Stores the result of a call to getBlocksInView*() in the cache.
   /// @param T_L_C The pose of the lidar.
   /// @param lidar The intrinsics of the lidar.
+  /// @param extent The block size and distances of the view.
   /// @param blocks_in_view The calculated blocks in view list.
   void storeResultInCache(const Transform& T_L_C, const Lidar& lidar,
+                          const ViewExtent& extent,
                           const std::vector<Index3D>& blocks_in_view);
 
  private:
   std::deque<Camera> camera_cache_;
   std::deque<Lidar> lidar_cache_;
   std::deque<Transform> pose_cache_;
+  std::deque<ViewExtent> extent_cache_;
   std::deque<std::vector<Index3D>> blocks_in_view_cache_;
+  mutable std::mutex mutex_;
 
   /// Maximum number of views to store in the cache.
   /// A cache size of 1 is sufficient to cache a view between the static and
-  /// dynamic mapper as they are guaranteed to integrate the frame in
-  /// sequence.
-  /// Currently we set cache size to 2 to also allow caching 2 static cameras.
-  /// If you want to support caching for n static cameras,
-  /// you want to increase the maximum cache size to n.
-  static constexpr int kMaxCacheSize = 2;
+  /// dynamic mapper as they integrate the same frames. Per camera we store two
+  /// extents, such that the depth integration (and the paging and decay using
+  /// its extent) and the color integration both hit the cache. The size of 4
+  /// supports 2 static cameras. If you want to support caching for n static
+  /// cameras, you want to increase the maximum cache size to 2n.
+  static constexpr int kMaxCacheSize = 4;
 };
 
 }  // namespace nvblox
@@ -58,6 +58,13 @@ constexpr Param<float>::Description kWorkspaceBoundsMaxCornerYDesc{
     "The y-component of the  maximal corner of the workspace bounds. Only used "
     "if workspace_bounds_type:=bounding_box."};
 
+constexpr Param<bool>::Description kHierarchicalPlanesCullingDesc{
+    "hierarchical_planes_culling", false,
+    "Whether to cull groups of 4x4x4 blocks against the view frustum at once "
+    "when getting the blocks in view without a depth image. This returns the "
+    "same blocks as testing each block, but is much cheaper for long range "
+    "views."};
+
 struct ViewCalculatorParams {
   Param<int> raycast_subsampling_factor{kRaycastSubsamplingFactorDesc};
   Param<WorkspaceBoundsType> workspace_bounds_type{kWorkspaceBoundsTypeDesc};
@@ -67,6 +74,7 @@ struct ViewCalculatorParams {
   Param<float> workspace_bounds_max_corner_x_m{kWorkspaceBoundsMaxCornerXDesc};
   Param<float> workspace_bounds_min_corner_y_m{kWorkspaceBoundsMinCornerYDesc};
   Param<float> workspace_bounds_max_corner_y_m{kWorkspaceBoundsMaxCornerYDesc};
+  Param<bool> hierarchical_planes_culling{kHierarchicalPlanesCullingDesc};
 };
 
 }  // namespace nvblox
@@ -54,24 +54,48 @@ class WeightingFunction {
   /// @param type The type of weighting to be used
   __host__ __device__ inline void type(const WeightingFunctionType type);
 
+  /// Computes the weight of an observation for a weighting type known at
+  /// compile time. See operator().
+  /// @tparam kType The type of the weighting to be used.
+  template <WeightingFunctionType kType>
+  __host__ __device__ static inline float compute(float measured_depth,
+                                                  float voxel_depth,
+                                                  float truncation_distance);
+
  private:
-  __host__ __device__ inline float computeDropoff(
-      float measured_depth, float voxel_depth, float truncation_distance) const;
+  __host__ __device__ static inline float computeDropoff(
+      float measured_depth, float voxel_depth, float truncation_distance);
 
-  __host__ __device__ inline float computeInverseSquare(
-      float measured_depth, float voxel_depth, float truncation_distance) const;
+  __host__ __device__ static inline float computeInverseSquare(
+      float measured_depth, float voxel_depth, float truncation_distance);
 
-  __host__ __device__ inline float computeTsdfDistancePenalty(
-      float measured_depth, float voxel_depth, float truncation_distance) const;
+  __host__ __device__ static inline float computeTsdfDistancePenalty(
+      float measured_depth, float voxel_depth, float truncation_distance);
 
-  __host__ __device__ inline float computeLinearWithMax(
-      float voxel_depth) const;
+  __host__ __device__ static inline float computeLinearWithMax(
+      float voxel_depth);
 
   WeightingFunctionType type_;
 
   constexpr static float constant_weight = kDefaultConstantWeight;
 };
 
+/// A WeightingFunction with its type fixed at compile time. Computes the same
+/// weights as WeightingFunction(kType), but without a switch on the type for
+/// every call. Used by the integration kernels of the common configurations.
+template <WeightingFunctionType kType>
+struct FixedWeightingFunction {
+  __host__ __device__ inline float operator()(float measured_depth,
+                                              float voxel_depth,
+                                              float truncation_distance) const {
+    return WeightingFunction::compute<kType>(measured_depth, voxel_depth,
+                                             truncation_distance);
+  }
+  __host__ __device__ constexpr WeightingFunctionType type() const {
+    return kType;
+  }
+};
+
 }  // namespace nvblox
 
 #include "nvblox/integrators/internal/impl/weighting_function_impl.h"
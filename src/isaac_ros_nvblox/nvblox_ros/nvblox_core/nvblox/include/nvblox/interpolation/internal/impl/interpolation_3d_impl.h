@@ -15,6 +15,13 @@ limitations under the License.
 */
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <numeric>
+#include <tuple>
+
+#include "nvblox/utils/parallel_for.h"
+
 namespace nvblox {
 namespace interpolation {
 
@@ -22,19 +29,29 @@ template <typename VoxelType>
 void interpolateOnCPU(const std::vector<Vector3f>& points_L,
                       const VoxelBlockLayer<VoxelType>& layer,
                       std::vector<float>* distances_ptr,
-                      std::vector<bool>* success_flags_ptr) {
+                      std::vector<bool>* success_flags_ptr,
+                      const int num_threads) {
   CHECK_NOTNULL(distances_ptr);
   CHECK_NOTNULL(success_flags_ptr);
   CHECK(layer.memory_type() == MemoryType::kUnified)
       << "For CPU-based interpolation, the layer must be CPU accessible (ie "
          "MemoryType::kUnified).";
-  distances_ptr->reserve(points_L.size());
-  success_flags_ptr->reserve(points_L.size());
-  for (const Vector3f& p_L : points_L) {
-    float distance;
-    success_flags_ptr->push_back(interpolateOnCPU(p_L, layer, &distance));
-    distances_ptr->push_back(distance);
-  }
+  // Bring the CPU hash up to date, such that the threads only read it.
+  layer.syncCpuHash();
+  // The results are appended to the outputs. Success flags are collected as
+  // bytes first, because neighbouring elements of a std::vector<bool> can't
+  // be written concurrently.
+  const size_t offset = distances_ptr->size();
+  distances_ptr->resize(offset + points_L.size());
+  std::vector<uint8_t> success_flags(points_L.size());
+  parallelFor(points_L.size(), num_threads, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      success_flags[i] =
+          interpolateOnCPU(points_L[i], layer, &(*distances_ptr)[offset + i]);
+    }
+  });
+  success_flags_ptr->insert(success_flags_ptr->end(), success_flags.begin(),
+                            success_flags.end());
 }
 
 namespace internal {
@@ -164,6 +181,185 @@ bool interpolateMemberOnCPU(const Vector3f& p_L,
   return true;
 }
 
+/// The number of points interpolated at once by interpolateBatchOnCPU(). One
+/// AVX register of floats.
+constexpr int kInterpolationBatchSize = 8;
+
+/// The interpolated quantity of each voxel type, and which voxels take part in
+/// the interpolation.
+template <typename VoxelType>
+struct InterpolatedMember;
+
+template <>
+struct InterpolatedMember<TsdfVoxel> {
+  static constexpr float kMinWeight = 1e-4;
+  static float get(const TsdfVoxel& voxel) { return voxel.distance; }
+  static bool isValid(const TsdfVoxel& voxel) {
+    return voxel.weight > kMinWeight;
+  }
+};
+
+template <>
+struct InterpolatedMember<EsdfVoxel> {
+  static float get(const EsdfVoxel& voxel) {
+    return std::sqrt(voxel.squared_distance_vox);
+  }
+  static bool isValid(const EsdfVoxel& voxel) { return voxel.observed; }
+};
+
+template <>
+struct InterpolatedMember<OccupancyVoxel> {
+  static float get(const OccupancyVoxel& voxel) {
+    return probabilityFromLogOdds(voxel.log_odds);
+  }
+  static bool isValid(const OccupancyVoxel&) { return true; }
+};
+
 }  // namespace internal
+
+template <typename VoxelType>
+void interpolateBatchOnCPU(const std::vector<Vector3f>& points_L,
+                           const VoxelBlockLayer<VoxelType>& layer,
+                           std::vector<float>* distances_ptr,
+                           std::vector<bool>* success_flags_ptr,
+                           const int num_threads) {
+  CHECK_NOTNULL(distances_ptr);
+  CHECK_NOTNULL(success_flags_ptr);
+  CHECK(layer.memory_type() == MemoryType::kHost ||
+        layer.memory_type() == MemoryType::kUnified)
+      << "For CPU-based interpolation, the layer must be CPU accessible (ie "
+         "MemoryType::kUnified).";
+  using Member = internal::InterpolatedMember<VoxelType>;
+  using BlockType = VoxelBlock<VoxelType>;
+  constexpr int kVoxelsPerSide = BlockType::kVoxelsPerSide;
+  constexpr int kBatchSize = internal::kInterpolationBatchSize;
+  using BatchArray = Eigen::Array<float, kBatchSize, 1>;
+
+  // Bring the CPU hash up to date, such that the threads only read it.
+  layer.syncCpuHash();
+  const size_t offset = distances_ptr->size();
+  distances_ptr->resize(offset + points_L.size());
+  std::vector<uint8_t> success_flags(points_L.size(), 0);
+
+  // Find the low-side voxel of each point, as in getSurroundingVoxels3D().
+  const float block_size = layer.block_size();
+  const float voxel_size = layer.voxel_size();
+  const float half_voxel_size = voxel_size * 0.5f;
+  std::vector<Index3D> low_block_indices(points_L.size());
+  std::vector<Index3D> low_voxel_indices(points_L.size());
+  for (size_t i = 0; i < points_L.size(); ++i) {
+    getBlockAndVoxelIndexFromPositionInLayer(
+        block_size, points_L[i].array() - half_voxel_size,
+        &low_block_indices[i], &low_voxel_indices[i]);
+  }
+
+  // Group the points by their low-side block.
+  std::vector<size_t> order(points_L.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&](size_t lhs, size_t rhs) {
+    const Index3D& lhs_idx = low_block_indices[lhs];
+    const Index3D& rhs_idx = low_block_indices[rhs];
+    return std::tie(lhs_idx.x(), lhs_idx.y(), lhs_idx.z()) <
+           std::tie(rhs_idx.x(), rhs_idx.y(), rhs_idx.z());
+  });
+  std::vector<size_t> group_starts;
+  for (size_t i = 0; i < order.size(); ++i) {
+    if (i == 0 || low_block_indices[order[i]] !=
+                      low_block_indices[order[i - 1]]) {
+      group_starts.push_back(i);
+    }
+  }
+  group_starts.push_back(order.size());
+  const size_t num_groups = group_starts.size() - 1;
+
+  parallelFor(num_groups, num_threads, [&](size_t begin, size_t end) {
+    for (size_t group = begin; group < end; ++group) {
+      // The low-side block and its neighbours on the high side, with the same
+      // linear indexing as the voxel corners (x major).
+      const Index3D& block_idx = low_block_indices[order[group_starts[group]]];
+      std::array<const BlockType*, 8> blocks;
+      for (int corner = 0; corner < 8; ++corner) {
+        const Index3D direction(corner >> 2, (corner >> 1) & 1, corner & 1);
+        blocks[corner] = layer.getBlockAtIndex(block_idx + direction).get();
+      }
+
+      for (size_t batch_start = group_starts[group];
+           batch_start < group_starts[group + 1]; batch_start += kBatchSize) {
+        const int batch_size = static_cast<int>(std::min<size_t>(
+            kBatchSize, group_starts[group + 1] - batch_start));
+
+        // Gather the corner values and the offsets of the batch's points.
+        std::array<BatchArray, 8> values;
+        for (BatchArray& corner_values : values) {
+          corner_values.setZero();
+        }
+        BatchArray offset_x = BatchArray::Zero();
+        BatchArray offset_y = BatchArray::Zero();
+        BatchArray offset_z = BatchArray::Zero();
+        std::array<bool, kBatchSize> valid{};
+        for (int lane = 0; lane < batch_size; ++lane) {
+          const size_t point_idx = order[batch_start + lane];
+          const Index3D& low_voxel_idx = low_voxel_indices[point_idx];
+          valid[lane] = true;
+          for (int corner = 0; corner < 8 && valid[lane]; ++corner) {
+            Index3D voxel_idx =
+                low_voxel_idx +
+                Index3D(corner >> 2, (corner >> 1) & 1, corner & 1);
+            // Move into a neighbouring block(s) if required
+            const Eigen::Array<bool, 3, 1> limits_hit_flags =
+                (voxel_idx.array() == kVoxelsPerSide);
+            const int block_num = 4 * limits_hit_flags.x() +
+                                  2 * limits_hit_flags.y() +
+                                  limits_hit_flags.z();
+            voxel_idx = limits_hit_flags.select(0, voxel_idx);
+            const BlockType* block_ptr = blocks[block_num];
+            if (block_ptr == nullptr) {
+              valid[lane] = false;
+              break;
+            }
+            const VoxelType& voxel =
+                block_ptr->voxels[voxel_idx.x()][voxel_idx.y()][voxel_idx.z()];
+            if (!Member::isValid(voxel)) {
+              valid[lane] = false;
+              break;
+            }
+            values[corner][lane] = Member::get(voxel);
+          }
+          const Vector3f p_corner_L =
+              getPositionFromBlockIndexAndVoxelIndex(block_size, block_idx,
+                                                     low_voxel_idx) +
+              half_voxel_size * Vector3f::Ones();
+          const Vector3f p_offset_in_voxels_L =
+              (points_L[point_idx] - p_corner_L) / voxel_size;
+          offset_x[lane] = p_offset_in_voxels_L.x();
+          offset_y[lane] = p_offset_in_voxels_L.y();
+          offset_z[lane] = p_offset_in_voxels_L.z();
+        }
+
+        // Trilinearly interpolate all lanes at once: along x, then y, then z.
+        // Corners are indexed as 4 * x + 2 * y + z.
+        const BatchArray c00 = values[0] + offset_x * (values[4] - values[0]);
+        const BatchArray c01 = values[1] + offset_x * (values[5] - values[1]);
+        const BatchArray c10 = values[2] + offset_x * (values[6] - values[2]);
+        const BatchArray c11 = values[3] + offset_x * (values[7] - values[3]);
+        const BatchArray c0 = c00 + offset_y * (c10 - c00);
+        const BatchArray c1 = c01 + offset_y * (c11 - c01);
+        const BatchArray result = c0 + offset_z * (c1 - c0);
+
+        // Scatter the results back to the order of the input points.
+        for (int lane = 0; lane < batch_size; ++lane) {
+          const size_t point_idx = order[batch_start + lane];
+          success_flags[point_idx] = valid[lane];
+          if (valid[lane]) {
+            (*distances_ptr)[offset + point_idx] = result[lane];
+          }
+        }
+      }
+    }
+  });
+  success_flags_ptr->insert(success_flags_ptr->end(), success_flags.begin(),
+                            success_flags.end());
+}
+
 }  // namespace interpolation
 }  // namespace nvblox
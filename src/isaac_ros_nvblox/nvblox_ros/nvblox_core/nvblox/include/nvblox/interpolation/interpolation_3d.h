@@ -15,8 +15,10 @@ limitations under the License.
 */
 #pragma once
 
+#include "nvblox/core/cuda_stream.h"
 #include "nvblox/core/log_odds.h"
 #include "nvblox/core/types.h"
+#include "nvblox/core/unified_vector.h"
 #include "nvblox/map/blox.h"
 #include "nvblox/map/common_names.h"
 #include "nvblox/map/layer.h"
@@ -34,11 +36,60 @@ bool interpolateOnCPU(const Vector3f& p_L, const OccupancyLayer& layer,
                       float* distance);
 
 /// Vectors of points
+/// The points are split between num_threads threads (all hardware threads if
+/// zero or negative).
 template <typename VoxelType>
 void interpolateOnCPU(const std::vector<Vector3f>& points_L,
                       const VoxelBlockLayer<VoxelType>& layer,
                       std::vector<float>* distances_ptr,
-                      std::vector<bool>* success_flags_ptr);
+                      std::vector<bool>* success_flags_ptr,
+                      const int num_threads = 1);
+
+/// Batched vectors of points
+/// Interpolates the same quantity as interpolateOnCPU() but groups the points
+/// by block, such that the (up to 8) blocks around a group are looked up once
+/// rather than per voxel, and interpolates 8 points at a time on fixed-size
+/// Eigen arrays, which Eigen maps onto SIMD registers (SSE/AVX/NEON). The results are appended to the outputs, in the order of
+/// the input points. The groups are split between num_threads threads (all
+/// hardware threads if zero or negative).
+template <typename VoxelType>
+void interpolateBatchOnCPU(const std::vector<Vector3f>& points_L,
+                           const VoxelBlockLayer<VoxelType>& layer,
+                           std::vector<float>* distances_ptr,
+                           std::vector<bool>* success_flags_ptr,
+                           const int num_threads = 1);
+
+/// Batched interpolation on the GPU.
+/// Trilinearly interpolates the same quantity as interpolateOnCPU() (TSDF
+/// distance, ESDF distance in voxels, or occupancy probability) at each point,
+/// along with its spatial gradient (per meter). The voxels are looked up
+/// through the layer's GPU hash, so the layer does not need to be CPU
+/// accessible. Interpolation fails for points where any of the 8 surrounding
+/// voxels is unallocated or invalid.
+/// @param points_L The query points, in the layer frame.
+/// @param layer The layer to interpolate in (in device or unified memory).
+/// @param distances_ptr The interpolated values, one per point.
+/// @param gradients_ptr The interpolated gradients. May be nullptr.
+/// @param success_flags_ptr Whether interpolation succeeded, one per point.
+/// @param cuda_stream The stream to do the work on. Not synchronized.
+void interpolateOnGPUAsync(const device_vector<Vector3f>& points_L,
+                           const TsdfLayer& layer,
+                           device_vector<float>* distances_ptr,
+                           device_vector<Vector3f>* gradients_ptr,
+                           device_vector<bool>* success_flags_ptr,
+                           const CudaStream& cuda_stream);
+void interpolateOnGPUAsync(const device_vector<Vector3f>& points_L,
+                           const EsdfLayer& layer,
+                           device_vector<float>* distances_ptr,
+                           device_vector<Vector3f>* gradients_ptr,
+                           device_vector<bool>* success_flags_ptr,
+                           const CudaStream& cuda_stream);
+void interpolateOnGPUAsync(const device_vector<Vector3f>& points_L,
+                           const OccupancyLayer& layer,
+                           device_vector<float>* probabilities_ptr,
+                           device_vector<Vector3f>* gradients_ptr,
+                           device_vector<bool>* success_flags_ptr,
+                           const CudaStream& cuda_stream);
 
 }  // namespace interpolation
 }  // namespace nvblox
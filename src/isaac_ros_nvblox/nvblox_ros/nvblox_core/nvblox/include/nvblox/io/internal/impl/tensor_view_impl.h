@@ -0,0 +1,151 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#pragma once
+
+#include <cuda_runtime.h>
+
+#include "nvblox/core/color.h"
+#include "nvblox/core/internal/error_check.h"
+
+namespace nvblox {
+namespace io {
+
+inline int64_t TensorView::numel() const {
+  int64_t num_elements = 1;
+  for (int i = 0; i < ndim; ++i) {
+    num_elements *= shape[i];
+  }
+  return num_elements;
+}
+
+template <typename _ScalarType, TensorTypeCode _kTypeCode, int _kNumChannels>
+struct TensorElementTraitsBase {
+  using ScalarType = _ScalarType;
+  static constexpr TensorTypeCode kTypeCode = _kTypeCode;
+  static constexpr uint8_t kTypeBits = 8 * sizeof(ScalarType);
+  static constexpr int kNumChannels = _kNumChannels;
+};
+
+template <>
+struct TensorElementTraits<float>
+    : TensorElementTraitsBase<float, TensorTypeCode::kFloat, 1> {};
+template <>
+struct TensorElementTraits<double>
+    : TensorElementTraitsBase<double, TensorTypeCode::kFloat, 1> {};
+template <>
+struct TensorElementTraits<int8_t>
+    : TensorElementTraitsBase<int8_t, TensorTypeCode::kInt, 1> {};
+template <>
+struct TensorElementTraits<uint8_t>
+    : TensorElementTraitsBase<uint8_t, TensorTypeCode::kUInt, 1> {};
+template <>
+struct TensorElementTraits<uint16_t>
+    : TensorElementTraitsBase<uint16_t, TensorTypeCode::kUInt, 1> {};
+template <>
+struct TensorElementTraits<int32_t>
+    : TensorElementTraitsBase<int32_t, TensorTypeCode::kInt, 1> {};
+template <>
+struct TensorElementTraits<bool>
+    : TensorElementTraitsBase<bool, TensorTypeCode::kBool, 1> {};
+// RGBA
+template <>
+struct TensorElementTraits<Color>
+    : TensorElementTraitsBase<uint8_t, TensorTypeCode::kUInt, 4> {};
+// E.g. the gradients output by denseGridGradientsAsync().
+template <typename ScalarType, int kRows, int kOptions, int kMaxRows>
+struct TensorElementTraits<
+    Eigen::Matrix<ScalarType, kRows, 1, kOptions, kMaxRows, 1>>
+    : TensorElementTraitsBase<
+          ScalarType, TensorElementTraits<ScalarType>::kTypeCode, kRows> {};
+
+namespace internal {
+
+inline TensorDeviceType tensorDeviceTypeFromMemoryType(
+    const MemoryType memory_type) {
+  switch (memory_type) {
+    case MemoryType::kDevice:
+      return TensorDeviceType::kCuda;
+    case MemoryType::kUnified:
+      return TensorDeviceType::kCudaManaged;
+    case MemoryType::kHost:
+      // nvblox host memory is pinned.
+      return TensorDeviceType::kCudaHost;
+  }
+  LOG(FATAL) << "Unknown memory type.";
+  return TensorDeviceType::kCuda;
+}
+
+template <typename CellType>
+TensorView makeTensorView(const CellType* data, const MemoryType memory_type) {
+  using Traits = TensorElementTraits<CellType>;
+  static_assert(sizeof(CellType) ==
+                    Traits::kNumChannels * sizeof(typename Traits::ScalarType),
+                "Cells must be tightly packed scalars.");
+  TensorView view;
+  view.data = const_cast<CellType*>(data);
+  view.device_type = tensorDeviceTypeFromMemoryType(memory_type);
+  checkCudaErrors(cudaGetDevice(&view.device_id));
+  view.type_code = Traits::kTypeCode;
+  view.type_bits = Traits::kTypeBits;
+  return view;
+}
+
+// Appends a channel dimension if there's more than one scalar per cell.
+inline void addChannelDimension(const int num_channels, TensorView* view) {
+  if (num_channels > 1) {
+    view->shape[view->ndim] = num_channels;
+    view->strides[view->ndim] = 1;
+    ++view->ndim;
+  }
+}
+
+}  // namespace internal
+
+template <typename ElementType>
+TensorView tensorViewFromImage(const Image<ElementType>& image) {
+  const int num_channels = TensorElementTraits<ElementType>::kNumChannels *
+                           image.num_elements_per_pixel();
+  TensorView view = internal::makeTensorView(image.dataConstPtr(),
+                                             image.memory_type());
+  view.ndim = 2;
+  view.shape[0] = image.rows();
+  view.shape[1] = image.cols();
+  view.strides[0] = static_cast<int64_t>(image.stride_num_elements()) *
+                    TensorElementTraits<ElementType>::kNumChannels;
+  view.strides[1] = num_channels;
+  internal::addChannelDimension(num_channels, &view);
+  return view;
+}
+
+template <typename CellType>
+TensorView tensorViewFromGrid(const Unified3DGrid<CellType>& grid) {
+  const int num_channels = TensorElementTraits<CellType>::kNumChannels;
+  const Index3D aabb_size = grid.aabb_size();
+  TensorView view =
+      internal::makeTensorView(grid.data().data(), grid.data().memory_type());
+  view.ndim = 3;
+  view.shape[0] = aabb_size.x();
+  view.shape[1] = aabb_size.y();
+  view.shape[2] = aabb_size.z();
+  view.strides[2] = num_channels;
+  view.strides[1] = view.strides[2] * aabb_size.z();
+  view.strides[0] = view.strides[1] * aabb_size.y();
+  internal::addChannelDimension(num_channels, &view);
+  return view;
+}
+
+}  // namespace io
+}  // namespace nvblox
@@ -20,10 +20,29 @@ limitations under the License.
 namespace nvblox {
 namespace io {
 
+/// Write the layer cake in the default (SQLite) format. If compress_blocks is
+/// set, the blocks of layers supporting it are compressed, which shrinks the
+/// file at the cost of slower loading. If store_derived_layers is set, the
+/// ESDF and mesh are stored such that they can be restored instead of
+/// recomputed, see Serializer::store_derived_layers(). They have to be up to
+/// date with the TSDF.
 bool writeLayerCakeToFile(const std::string& filename, const LayerCake& cake,
-                          const CudaStream& cuda_stream = CudaStreamOwning());
+                          const CudaStream& cuda_stream = CudaStreamOwning(),
+                          bool compress_blocks = false,
+                          bool store_derived_layers = false);
+/// Write the layer cake in the memory-mappable binary map format, which loads
+/// much faster than the default (SQLite) format.
+bool writeLayerCakeToBinaryFile(
+    const std::string& filename, const LayerCake& cake,
+    const CudaStream& cuda_stream = CudaStreamOwning());
+/// Load a layer cake. The default, the binary map and the checkpoint log
+/// format are supported, the format is detected from the file contents.
+/// If derived_layers_consistent is passed, it's set to whether the ESDF and
+/// the mesh were restored along with the TSDF they were computed from (only
+/// for files written with store_derived_layers).
 LayerCake loadLayerCakeFromFile(const std::string& filename,
-                                MemoryType memory_type);
+                                MemoryType memory_type,
+                                bool* derived_layers_consistent = nullptr);
 
 }  // namespace io
 }  // namespace nvblox
@@ -17,7 +17,9 @@ limitations under the License.
 
 #include <string>
 
+#include "nvblox/io/ply_writer.h"
 #include "nvblox/map/layer.h"
+#include "nvblox/mesh/mesh.h"
 #include "nvblox/mesh/mesh_block.h"
 
 namespace nvblox {
@@ -30,6 +32,20 @@ void combineMeshBlocks(const BlockLayer<MeshBlock>& layer,
                        std::vector<Vector3f>* normals_ptr,
                        std::vector<int>* triangles_ptr);
 
+// Writes a combined mesh. The mesh is on the host, so unlike
+// outputMeshLayerToPly() this can run on a thread other than the one mapping.
+bool outputMeshToPly(const Mesh& mesh, const std::string& filename,
+                     PlyFormat format = PlyFormat::kAscii);
+
+// Writes the mesh blocks in a layer to a binary .ply file, without combining
+// them first. The blocks are streamed through a pinned staging buffer in
+// chunks, and each chunk is packed on num_threads threads (all hardware
+// threads by default) while the file is written, which makes this suitable
+// for large meshes. Normals and colors are written if all blocks have them.
+bool outputMeshLayerToBinaryPly(
+    const BlockLayer<MeshBlock>& layer, const std::string& filename,
+    const CudaStream& cuda_stream = CudaStreamOwning(), int num_threads = 0);
+
 bool outputMeshLayerToPly(const BlockLayer<MeshBlock>& layer,
                           const std::string& filename);
 
@@ -15,21 +15,71 @@ limitations under the License.
 */
 #pragma once
 
+#include <cstdint>
 #include <fstream>
 #include <string>
+#include <vector>
 
 #include "nvblox/core/color.h"
 #include "nvblox/core/types.h"
 
 namespace nvblox {
 namespace io {
+
+/// The encoding of the data in a .ply file.
+enum class PlyFormat {
+  kAscii,
+  /// Much smaller, and faster to write and read than ASCII.
+  kBinaryLittleEndian
+};
+
+/// The elements and properties of a .ply file.
+struct PlyHeader {
+  size_t num_vertices = 0;
+  bool has_normals = false;
+  bool has_intensities = false;
+  bool has_colors = false;
+  /// The face element is only written if set.
+  bool has_triangles = false;
+  size_t num_triangles = 0;
+};
+
+/// Writes the header of a .ply file.
+void writePlyHeader(const PlyHeader& header, PlyFormat format,
+                    std::ostream* out);
+
+/// The number of bytes of a vertex in a binary .ply file.
+size_t binaryPlyVertexSize(const PlyHeader& header);
+
+/// The number of bytes of a triangle in a binary .ply file.
+constexpr size_t kBinaryPlyTriangleSize = sizeof(uint8_t) + 3 * sizeof(int);
+
+/// Packs a vertex of a binary .ply file. The property pointers are ignored
+/// for properties not in the header.
+/// @param dst Where to write binaryPlyVertexSize() bytes.
+void packBinaryPlyVertex(const PlyHeader& header, const Vector3f& point,
+                         const Vector3f* normal, const float* intensity,
+                         const Color* color, uint8_t* dst);
+
+/// Packs a triangle of a binary .ply file.
+/// @param triangle The three vertex indices of the triangle.
+/// @param vertex_offset Added to the vertex indices.
+/// @param dst Where to write kBinaryPlyTriangleSize bytes.
+void packBinaryPlyTriangle(const int* triangle, int vertex_offset,
+                           uint8_t* dst);
+
 /**
  * Writes a mesh to a .ply file. For reference on the format, see:
  *  http://paulbourke.net/dataformats/ply/
  */
 class PlyWriter {
  public:
-  explicit PlyWriter(const std::string& filename) : file_(filename) {}
+  explicit PlyWriter(const std::string& filename,
+                     PlyFormat format = PlyFormat::kAscii)
+      : format_(format),
+        file_(filename, format == PlyFormat::kAscii
+                            ? std::ios::out
+                            : std::ios::out | std::ios::binary) {}
 
   ~PlyWriter() { file_.close(); }
 
@@ -49,9 +99,13 @@ class PlyWriter {
   bool write();
 
  private:
-  void writeHeader();
+  PlyHeader header() const;
   void writePoints();
   void writeTriangles();
+  void writePointsBinary(const PlyHeader& header);
+  void writeTrianglesBinary();
+
+  const PlyFormat format_;
 
   const std::vector<Vector3f>* points_ = nullptr;
   const std::vector<Vector3f>* normals_ = nullptr;
@@ -0,0 +1,96 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#pragma once
+
+#include <stdint.h>
+#include <array>
+
+#include "nvblox/core/types.h"
+#include "nvblox/map/unified_3d_grid.h"
+#include "nvblox/sensors/image.h"
+
+namespace nvblox {
+namespace io {
+
+/// Where the data of a tensor lives. The values are those of DLDeviceType.
+enum class TensorDeviceType : int32_t {
+  kCpu = 1,          // kDLCPU
+  kCuda = 2,         // kDLCUDA
+  kCudaHost = 3,     // kDLCUDAHost, i.e. pinned host memory
+  kCudaManaged = 13  // kDLCUDAManaged
+};
+
+/// The type of the elements of a tensor. The values are those of
+/// DLDataTypeCode.
+enum class TensorTypeCode : uint8_t {
+  kInt = 0,    // kDLInt
+  kUInt = 1,   // kDLUInt
+  kFloat = 2,  // kDLFloat
+  kBool = 6    // kDLBool
+};
+
+/// A non-owning view of an nvblox image or dense grid as an N-dimensional
+/// tensor. The fields map one-to-one onto a DLPack DLTensor (with shape and
+/// strides pointing into this struct, and strides in elements), such that a
+/// binding can hand the data to e.g. PyTorch or CuPy without copying it.
+///
+/// The view doesn't keep the data alive: The image or grid must outlive
+/// every consumer of the view, and must not be resized in the meantime.
+struct TensorView {
+  static constexpr int kMaxNumDims = 4;
+
+  void* data = nullptr;
+  TensorDeviceType device_type = TensorDeviceType::kCuda;
+  int32_t device_id = 0;
+  TensorTypeCode type_code = TensorTypeCode::kFloat;
+  /// The number of bits of a (scalar) element.
+  uint8_t type_bits = 32;
+  int32_t ndim = 0;
+  /// The size of each dimension. Only the first ndim entries are used.
+  std::array<int64_t, kMaxNumDims> shape{};
+  /// The stride of each dimension, in elements.
+  std::array<int64_t, kMaxNumDims> strides{};
+
+  /// The number of elements.
+  int64_t numel() const;
+};
+
+/// Describes how a cell type of an image or grid maps to tensor elements.
+/// Specialized for the scalar types and for types made of several scalars
+/// (e.g. Color), which get an extra, innermost, dimension.
+template <typename CellType>
+struct TensorElementTraits;
+
+/// Views an image as a tensor of shape (rows, cols), or (rows, cols,
+/// channels) for images with several scalars per pixel. Row padding is
+/// represented by the row stride.
+/// @param image The image to view (in any memory type).
+/// @return The view.
+template <typename ElementType>
+TensorView tensorViewFromImage(const Image<ElementType>& image);
+
+/// Views a dense grid, e.g. as output by
+/// voxelLayerToDenseVoxelGridInAABBAsync(), as a tensor of shape (x, y, z), or
+/// (x, y, z, channels) for cells made of several scalars. z varies fastest.
+/// @param grid The grid to view (in any memory type).
+/// @return The view.
+template <typename CellType>
+TensorView tensorViewFromGrid(const Unified3DGrid<CellType>& grid);
+
+}  // namespace io
+}  // namespace nvblox
+
+#include "nvblox/io/internal/impl/tensor_view_impl.h"
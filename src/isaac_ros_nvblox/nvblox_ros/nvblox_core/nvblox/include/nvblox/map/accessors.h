@@ -54,14 +54,24 @@ using VoxelCallbackFunction = std::function<void(
     const Index3D& block_index, const Index3D& voxel_index, VoxelType* voxel)>;
 
 /// Call function on all voxels in a layer (const).
+/// With more than one thread, the blocks are split between the threads and
+/// the callback is called concurrently (for voxels of different blocks), so
+/// it has to be thread-safe.
+/// @param layer The layer.
+/// @param callback Called for every voxel.
+/// @param num_threads The number of threads. All hardware threads if zero or
+/// negative.
 template <typename VoxelType>
 void callFunctionOnAllVoxels(const BlockLayer<VoxelBlock<VoxelType>>& layer,
-                             ConstVoxelCallbackFunction<VoxelType> callback);
+                             ConstVoxelCallbackFunction<VoxelType> callback,
+                             const int num_threads = 1);
 
 /// Call function on all voxels in a layer (non-const).
+/// See the const version above for num_threads.
 template <typename VoxelType>
 void callFunctionOnAllVoxels(BlockLayer<VoxelBlock<VoxelType>>* layer,
-                             VoxelCallbackFunction<VoxelType> callback);
+                             VoxelCallbackFunction<VoxelType> callback,
+                             const int num_threads = 1);
 
 /// Accessors for calling a function on all voxels in a block (const).
 template <typename VoxelType>
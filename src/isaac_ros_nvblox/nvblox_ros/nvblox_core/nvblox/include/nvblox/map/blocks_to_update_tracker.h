@@ -19,11 +19,28 @@ limitations under the License.
 
 #include "nvblox/core/hash.h"
 #include "nvblox/core/types.h"
+#include "nvblox/map/blox.h"
 
 namespace nvblox {
 
 /// @brief Types of blocks being tracked.
-enum class BlocksToUpdateType { kEsdf, kMesh, kFreespace, kLayerStreamer };
+/// kCheckpoint blocks are blocks which were updated *or removed* since the
+/// last checkpoint, and are only tracked if enabled through
+/// trackCheckpointBlocks(). Similarly kGroundPlane blocks are blocks which
+/// were updated or removed since the last ground plane update, and are only
+/// tracked if enabled through trackGroundPlaneBlocks().
+/// kMeshColor blocks are blocks whose colors changed since the last mesh
+/// update, which are only added through addColorBlocksToUpdate(). Their mesh
+/// blocks need recoloring even if their geometry is unchanged.
+enum class BlocksToUpdateType {
+  kEsdf,
+  kMesh,
+  kFreespace,
+  kLayerStreamer,
+  kCheckpoint,
+  kGroundPlane,
+  kMeshColor
+};
 
 /// @brief Class to keep track of blocks that need to be updated.
 class BlocksToUpdateTracker {
@@ -33,8 +50,24 @@ class BlocksToUpdateTracker {
 
   /// @brief Adding blocks that need an update.
   /// @param blocks_to_update Vector of block indices that need an update.
+  /// All voxels of these blocks are considered changed for meshing.
   void addBlocksToUpdate(const std::vector<Index3D>& blocks_to_update);
 
+  /// @brief Adding blocks that need an update, along with the voxels that
+  /// changed in each block. Only blocks with changed voxels (and their
+  /// neighbors sharing marching cubes with them) need re-meshing, see
+  /// getMeshBlocksToRemesh().
+  /// @param blocks_to_update Vector of block indices that need an update.
+  /// @param updated_voxel_masks Masks of the changed voxels, one per block.
+  void addBlocksToUpdate(
+      const std::vector<Index3D>& blocks_to_update,
+      const std::vector<VoxelBlockMask>& updated_voxel_masks);
+
+  /// @brief Adding blocks whose colors changed. These only need their mesh
+  /// recolored, see BlocksToUpdateType::kMeshColor.
+  /// @param blocks_to_update Vector of block indices with changed colors.
+  void addColorBlocksToUpdate(const std::vector<Index3D>& blocks_to_update);
+
   /// @brief Removing blocks from the set of blocks that need an update.
   /// @param blocks_to_remove Vector of block indices that don't need an update.
   void removeBlocksToUpdate(const std::vector<Index3D>& blocks_to_remove);
@@ -47,10 +80,29 @@ class BlocksToUpdateTracker {
   std::vector<Index3D> getBlocksToUpdate(
       BlocksToUpdateType blocks_to_update_type) const;
 
+  /// @brief Get the mesh blocks whose geometry needs to be re-extracted. This
+  /// is the subset of getBlocksToUpdate(kMesh) containing changed voxels,
+  /// plus the neighboring blocks whose marching cubes reach into these
+  /// voxels (the cubes of the blocks below reach into the lower faces of a
+  /// block).
+  /// @return Vector of block indices that need re-meshing.
+  std::vector<Index3D> getMeshBlocksToRemesh() const;
+
   /// @brief Mark all blocks of a block type to be updated.
   /// @param blocks_to_update_type The type of blocks that got updated.
   void markBlocksAsUpdated(BlocksToUpdateType blocks_to_update_type);
 
+  /// @brief Enable or disable tracking of checkpoint blocks. Tracking is off by
+  /// default to avoid the overhead for users that don't checkpoint. Clears
+  /// the checkpoint blocks.
+  /// @param track_checkpoint_blocks Whether to track checkpoint blocks.
+  void trackCheckpointBlocks(bool track_checkpoint_blocks);
+
+  /// @brief Enable or disable tracking of ground plane blocks. Tracking is off
+  /// by default. Clears the ground plane blocks.
+  /// @param track_ground_plane_blocks Whether to track ground plane blocks.
+  void trackGroundPlaneBlocks(bool track_ground_plane_blocks);
+
  private:
   ProjectiveLayerType projective_layer_type_;
 
@@ -61,6 +113,20 @@ class BlocksToUpdateTracker {
   Index3DSet mesh_blocks_to_update_;
   Index3DSet freespace_blocks_to_update_;
   Index3DSet layer_streamer_blocks_to_update_;
+  Index3DSet mesh_color_blocks_to_update_;
+  /// NOTE: Not size limited (see clearIfTooLarge()), as dropping blocks would
+  /// silently lose them from the checkpoint. It is bounded by the number of
+  /// blocks in the map.
+  Index3DSet checkpoint_blocks_to_update_;
+  bool track_checkpoint_blocks_ = false;
+  /// NOTE: Not size limited either, for the same reason as the checkpoint
+  /// blocks.
+  Index3DSet ground_plane_blocks_to_update_;
+  bool track_ground_plane_blocks_ = false;
+
+  /// The changed voxels in each of the mesh_blocks_to_update_. Blocks without
+  /// changed voxels are not stored.
+  Index3DHashMapType<VoxelBlockMask>::type mesh_changed_voxel_masks_;
 
   // Object to synchronize async functions (initialize to valid)
   mutable std::future<void> future_ = std::async(std::launch::async, []() {});
@@ -17,6 +17,8 @@ limitations under the License.
 
 #include <memory>
 
+#include "nvblox/core/bitmask.h"
+#include "nvblox/core/types.h"
 #include "nvblox/core/unified_ptr.h"
 #include "nvblox/core/unified_vector.h"
 #include "nvblox/map/voxel_iterator.h"
@@ -24,7 +26,14 @@ limitations under the License.
 
 namespace nvblox {
 
-/// A block that contains 8x8x8 voxels of a given type.
+/// The number of voxels along each side of a VoxelBlock. Set at build time
+/// through the VOXELS_PER_SIDE CMake option.
+#ifndef NVBLOX_VOXELS_PER_SIDE
+#define NVBLOX_VOXELS_PER_SIDE 8
+#endif
+
+/// A block that contains NxNxN voxels of a given type, with
+/// N = NVBLOX_VOXELS_PER_SIDE (8 by default).
 template <typename _VoxelType>
 struct VoxelBlock {
   using Ptr = unified_ptr<VoxelBlock>;
@@ -33,9 +42,19 @@ struct VoxelBlock {
   /// Allow introspection of the voxel type through BlockType::VoxelType
   using VoxelType = _VoxelType;
 
-  static constexpr int kVoxelsPerSide = 8;
+  static constexpr int kVoxelsPerSide = NVBLOX_VOXELS_PER_SIDE;
   static constexpr int kNumVoxels =
       kVoxelsPerSide * kVoxelsPerSide * kVoxelsPerSide;
+  static_assert(kVoxelsPerSide == 8 || kVoxelsPerSide == 16,
+                "Only blocks with 8 or 16 voxels per side are supported.");
+
+  /// Kernels which process a block with one thread per voxel are launched
+  /// with kVoxelsPerSide x kVoxelsPerSide x kThreadBlockDepth threads. CUDA
+  /// limits thread blocks to 1024 threads, so for 16^3 blocks each thread
+  /// processes kVoxelsPerSide / kThreadBlockDepth voxels along threadIdx.z.
+  static constexpr int kThreadBlockDepth =
+      (kNumVoxels <= 1024) ? kVoxelsPerSide
+                           : 1024 / (kVoxelsPerSide * kVoxelsPerSide);
 
   /// Voxel iterator types
   using iterator = VoxelIterator<VoxelType, kVoxelsPerSide, false>;
@@ -66,6 +85,18 @@ struct VoxelBlock {
   const_iterator cend() const;
 };
 
+/// A mask holding one bit per voxel of a VoxelBlock, e.g. to flag which voxels
+/// of a block changed during an update.
+using VoxelBlockMask = FixedSizeBitMask<VoxelBlock<bool>::kNumVoxels>;
+
+/// The bit in a VoxelBlockMask corresponding to a voxel. This is the linear
+/// index of the voxel in VoxelBlock::voxels.
+__host__ __device__ inline int voxelBlockMaskBit(const Index3D& voxel_idx) {
+  constexpr int kVoxelsPerSide = VoxelBlock<bool>::kVoxelsPerSide;
+  return (voxel_idx.x() * kVoxelsPerSide + voxel_idx.y()) * kVoxelsPerSide +
+         voxel_idx.z();
+}
+
 /// Return the size in bytes of a voxel block. Note that  function needs to be
 /// called from host and can therefore not be a member of VoxelBlock (which is
 /// typically allocated as a GPU pointers)
@@ -91,6 +122,20 @@ void initializeBlocksAsync(host_vector<BlockType*>& blocks,
                            const CudaStream& cuda_stream,
                            const MemoryType memory_type = MemoryType::kHost);
 
+/// Batch copy of device blocks, i.e. blocks in device or unified memory.
+///
+/// Block i of src_blocks is copied to block i of dst_blocks with a single
+/// kernel launch, rather than with one cudaMemcpy per block.
+///
+/// @param src_blocks  Device vector of source block pointers
+/// @param dst_blocks  Device vector of destination block pointers
+/// @param num_bytes_per_block  The size of a block in bytes
+/// @param cuda_stream  Cuda stream
+void copyBlocksAsync(const device_vector<const void*>& src_blocks,
+                     const device_vector<void*>& dst_blocks,
+                     const size_t num_bytes_per_block,
+                     const CudaStream& cuda_stream);
+
 }  // namespace nvblox
 
 #include "nvblox/map/internal/impl/blox_impl.h"
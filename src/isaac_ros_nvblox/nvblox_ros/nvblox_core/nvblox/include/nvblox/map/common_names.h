@@ -31,8 +31,12 @@ using OccupancyBlock = VoxelBlock<OccupancyVoxel>;
 using OccupancyLayer = VoxelBlockLayer<OccupancyVoxel>;
 using EsdfBlock = VoxelBlock<EsdfVoxel>;
 using EsdfLayer = VoxelBlockLayer<EsdfVoxel>;
+using CompactEsdfBlock = VoxelBlock<CompactEsdfVoxel>;
+using CompactEsdfLayer = VoxelBlockLayer<CompactEsdfVoxel>;
 using ColorBlock = VoxelBlock<ColorVoxel>;
 using ColorLayer = VoxelBlockLayer<ColorVoxel>;
+using LabelBlock = VoxelBlock<LabelVoxel>;
+using LabelLayer = VoxelBlockLayer<LabelVoxel>;
 using MeshLayer = BlockLayer<MeshBlock>;
 
 }  // namespace nvblox
@@ -0,0 +1,150 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#pragma once
+
+#include <array>
+#include <memory>
+#include <vector>
+
+#include "nvblox/core/cuda_stream.h"
+#include "nvblox/core/types.h"
+#include "nvblox/core/unified_vector.h"
+#include "nvblox/map/blocks_to_update_tracker.h"
+
+namespace nvblox {
+
+struct Index3DDeviceSet;
+
+/// @brief A device-resident counterpart of the BlocksToUpdateTracker.
+///
+/// Keeps one GPU hash set per BlocksToUpdateType, which are filled from, and
+/// read out to, device vectors of block indices. Producers which already hold
+/// their updated blocks on the device (e.g. GPU allocation or ray casting)
+/// can therefore feed consumers which run on the device without the block
+/// lists passing through host memory.
+///
+/// All functions are asynchronous on the stream passed, except where noted.
+/// The sets grow on demand. Growing requires one synchronization to read the
+/// set sizes, which is only done once the sum of added blocks could exceed
+/// the capacity.
+///
+/// NOTE: Unlike the BlocksToUpdateTracker, the changed voxels of mesh blocks
+/// are not tracked, such that all kMesh blocks are re-meshed completely.
+class GpuBlocksToUpdateTracker {
+ public:
+  static constexpr size_t kInitialCapacity = 4096;
+
+  GpuBlocksToUpdateTracker(ProjectiveLayerType projective_layer_type);
+  ~GpuBlocksToUpdateTracker();
+
+  GpuBlocksToUpdateTracker(const GpuBlocksToUpdateTracker&) = delete;
+  GpuBlocksToUpdateTracker& operator=(const GpuBlocksToUpdateTracker&) =
+      delete;
+
+  /// @brief Adding blocks that need an update.
+  /// @param blocks_to_update Device pointer to the block indices.
+  /// @param num_blocks The number of block indices.
+  /// @param cuda_stream The stream to work on.
+  void addBlocksToUpdateAsync(const Index3D* blocks_to_update, int num_blocks,
+                              const CudaStream& cuda_stream);
+  /// See above.
+  void addBlocksToUpdateAsync(const device_vector<Index3D>& blocks_to_update,
+                              const CudaStream& cuda_stream);
+
+  /// @brief Adding blocks whose colors changed, see
+  /// BlocksToUpdateTracker::addColorBlocksToUpdate(). These are the only
+  /// blocks added to the kMeshColor set.
+  /// @param blocks_to_update Device vector of the block indices.
+  /// @param cuda_stream The stream to work on.
+  void addColorBlocksToUpdateAsync(
+      const device_vector<Index3D>& blocks_to_update,
+      const CudaStream& cuda_stream);
+
+  /// @brief Removing blocks from the sets of blocks that need an update. As
+  /// in the BlocksToUpdateTracker, removed blocks are added to the checkpoint
+  /// and ground plane blocks if these are tracked.
+  /// @param blocks_to_remove Device vector of the block indices.
+  /// @param cuda_stream The stream to work on.
+  void removeBlocksToUpdateAsync(const device_vector<Index3D>& blocks_to_remove,
+                                 const CudaStream& cuda_stream);
+
+  /// @brief Get the blocks that need update, in device memory.
+  /// @param blocks_to_update_type The type of blocks to get.
+  /// @param[out] blocks_to_update The block indices, in no particular order.
+  /// @param cuda_stream The stream to work on.
+  void getBlocksToUpdateAsync(BlocksToUpdateType blocks_to_update_type,
+                              device_vector<Index3D>* blocks_to_update,
+                              const CudaStream& cuda_stream);
+
+  /// @brief Get the blocks that need update on the host. Blocking.
+  /// @param blocks_to_update_type The type of blocks to get.
+  /// @param cuda_stream The stream to work on.
+  /// @return The block indices, in no particular order.
+  std::vector<Index3D> getBlocksToUpdate(
+      BlocksToUpdateType blocks_to_update_type, const CudaStream& cuda_stream);
+
+  /// @brief Mark all blocks of a block type to be updated.
+  /// @param blocks_to_update_type The type of blocks that got updated.
+  /// @param cuda_stream The stream to work on.
+  void markBlocksAsUpdated(BlocksToUpdateType blocks_to_update_type,
+                           const CudaStream& cuda_stream);
+
+  /// @brief Enable or disable tracking of checkpoint blocks. See
+  /// BlocksToUpdateTracker::trackCheckpointBlocks().
+  /// @param track_checkpoint_blocks Whether to track checkpoint blocks.
+  /// @param cuda_stream The stream to work on.
+  void trackCheckpointBlocks(bool track_checkpoint_blocks,
+                             const CudaStream& cuda_stream);
+
+  /// @brief Enable or disable tracking of ground plane blocks. See
+  /// BlocksToUpdateTracker::trackGroundPlaneBlocks().
+  /// @param track_ground_plane_blocks Whether to track ground plane blocks.
+  /// @param cuda_stream The stream to work on.
+  void trackGroundPlaneBlocks(bool track_ground_plane_blocks,
+                              const CudaStream& cuda_stream);
+
+ private:
+  static constexpr int kNumTypes =
+      static_cast<int>(BlocksToUpdateType::kMeshColor) + 1;
+
+  // Whether blocks are added to the set of a type.
+  bool isTracked(BlocksToUpdateType type) const;
+
+  // Inserts blocks into the set of a type.
+  void insertBlocksAsync(int type_idx, const Index3D* blocks, int num_blocks,
+                         const CudaStream& cuda_stream);
+
+  // Grow the set of a type, if needed, such that num_blocks more blocks fit.
+  void reserveForInsertion(int type_idx, size_t num_blocks,
+                           const CudaStream& cuda_stream);
+
+  ProjectiveLayerType projective_layer_type_;
+  bool track_checkpoint_blocks_ = false;
+  bool track_ground_plane_blocks_ = false;
+
+  // One set per BlocksToUpdateType
+  std::array<std::unique_ptr<Index3DDeviceSet>, kNumTypes> sets_;
+  std::array<size_t, kNumTypes> capacities_;
+  // An upper bound of the number of blocks in each set. Duplicates added
+  // make this an over-estimate, which is refreshed from the set when it
+  // reaches the capacity.
+  std::array<size_t, kNumTypes> max_sizes_;
+
+  // Buffer for re-inserting the blocks when growing a set.
+  device_vector<Index3D> grow_buffer_;
+};
+
+}  // namespace nvblox
@@ -15,12 +15,27 @@ limitations under the License.
 */
 #pragma once
 
+#include <memory>
 #include <stack>
 #include <vector>
+#include "nvblox/core/cuda_event.h"
+#include "nvblox/core/memory_usage.h"
 #include "nvblox/core/unified_ptr.h"
 
 namespace nvblox {
 
+/// How a BlockMemoryPool allocates its blocks.
+enum class BlockAllocationMode {
+  /// Every block is a separate allocation. Expansion happens when the pool
+  /// runs empty and synchronizes the stream.
+  kPerBlock,
+  /// Blocks are carved out of large contiguous allocations (slabs). Expansion
+  /// happens asynchronously, ahead of demand, once the fraction of blocks in
+  /// use exceeds a high-water mark. Only available for trivially destructible
+  /// block types.
+  kSlab
+};
+
 /// Storage class for pre-allcoated blocks
 ///
 /// Maintains a large number of blocks (unified pointers) that are pre-allocated
@@ -32,31 +47,94 @@ namespace nvblox {
 ///
 /// Whenever the client needs to free a block, pushblock() should be used
 /// which returns the block to the pool and makes it ready for re-use.
+///
+/// See BlockAllocationMode for the two ways of allocating blocks. Blocks
+/// allocated in either mode can be mixed, such that the mode can be changed at
+/// any time.
 template <class BlockType>
 class BlockMemoryPool {
  public:
   /// Constructor that allocates blocks
   /// @param memory_type              Memory type
   /// @param num_preallocated_blocks  Number of blocks allocated on construction
+  /// @param allocation_mode          How blocks are allocated
   BlockMemoryPool(const MemoryType memory_type,
-                  const int num_preallocated_blocks = 2048);
+                  const int num_preallocated_blocks = 2048,
+                  const BlockAllocationMode allocation_mode =
+                      BlockAllocationMode::kPerBlock);
 
   /// Obtain a block from the pool. Should be used instead of allocating a new
   /// block. The pool is expanded if there are no more blocks remaining.
   /// @param cuda_stream Used when allocating memory in case the buffer needs
-  ///                    expansion. Will be synchronized.
+  ///                    expansion. Will be synchronized, except in slab mode
+  ///                    where work on the stream is instead ordered after the
+  ///                    expansion.
   typename BlockType::Ptr popBlock(const CudaStream& cuda_stream);
 
+  /// Obtain several blocks from the pool, sorted by address. Blocks which are
+  /// assigned in the returned order (e.g. to block indices in Morton order)
+  /// are therefore laid out in memory in that order as well.
+  /// @param num_blocks  The number of blocks.
+  /// @param cuda_stream See popBlock().
+  std::vector<typename BlockType::Ptr> popBlocks(const int num_blocks,
+                                                 const CudaStream& cuda_stream);
+
   /// Return a block to the pool. Should be used instead of de-allocating the
   /// block.
   /// @param block  Block to push
   void pushBlock(typename BlockType::Ptr block);
 
+  /// Expand the pool such that it holds at least a number of blocks, in use or
+  /// not. Note that in slab mode the pool still expands ahead of demand once
+  /// slab_high_water_mark() is exceeded.
+  /// @param num_blocks  The total number of blocks.
+  /// @param cuda_stream Used when allocating memory. See popBlock().
+  void reserve(const int num_blocks, const CudaStream& cuda_stream);
+
+  /// Number of blocks allocated by the pool, whether in use or not.
+  int num_allocated_blocks() const { return num_allocated_blocks_; }
+
+  /// Number of blocks ready to be popped.
+  int num_free_blocks() const { return static_cast<int>(blocks_.size()); }
+
+  /// The memory held by the pool. Blocks which are popped count as used.
+  /// Memory owned by the blocks themselves (e.g. mesh vertices) is not
+  /// included.
+  MemoryUsage memoryUsage() const {
+    MemoryUsage usage;
+    usage.allocated_bytes = num_allocated_blocks_ * sizeof(BlockType);
+    usage.used_bytes =
+        (num_allocated_blocks_ - num_free_blocks()) * sizeof(BlockType);
+    return usage;
+  }
+
+  /// A parameter getter
+  /// How new blocks are allocated.
+  BlockAllocationMode allocation_mode() const { return allocation_mode_; }
+
+  /// A parameter setter
+  /// See allocation_mode().
+  void allocation_mode(BlockAllocationMode allocation_mode);
+
+  /// A parameter getter
+  /// In slab mode, the fraction of allocated blocks in use above which the pool
+  /// is expanded.
+  float slab_high_water_mark() const { return slab_high_water_mark_; }
+
+  /// A parameter setter
+  /// See slab_high_water_mark().
+  void slab_high_water_mark(float slab_high_water_mark);
+
  private:
   /// Expand the memory pool and synchronize the stream
   void expand(const size_t num_blocks_to_allocate,
               const CudaStream& cuda_stream);
 
+  /// Expand the memory pool with a single slab of blocks, without
+  /// synchronizing. Records expansion_event_.
+  void expandSlabAsync(const size_t num_blocks_to_allocate,
+                       const CudaStream& cuda_stream);
+
   /// Container for storing the memory in the pool
   std::stack<typename BlockType::Ptr> blocks_;
 
@@ -67,6 +145,18 @@ class BlockMemoryPool {
   MemoryType memory_type_;
   int num_allocated_blocks_ = 0;
 
+  BlockAllocationMode allocation_mode_;
+  float slab_high_water_mark_ = 0.75f;
+
+  /// Recorded after initializing the last slab. Streams popping blocks wait on
+  /// it, such that they don't use blocks before they're initialized. Lazily
+  /// created on the first slab expansion.
+  std::unique_ptr<CudaEvent> expansion_event_;
+
+  /// Pointers to the blocks of the last slab, read by its initialization
+  /// kernel. Only reused once that kernel finished.
+  host_vector<BlockType*> slab_block_ptrs_;
+
   /// When expanding the pool, this number is muliplied with the current
   /// num_allocated_blocks to get the new size.
   static constexpr int kExpansionFactor = 2;
@@ -15,8 +15,11 @@ limitations under the License.
 */
 #pragma once
 
+#include <algorithm>
+
 #include "nvblox/gpu_hash/internal/cuda/gpu_indexing.cuh"
 #include "nvblox/map/layer.h"
+#include "nvblox/utils/timing.h"
 
 namespace nvblox {
 
@@ -41,6 +44,131 @@ __global__ void queryVoxelsKernel(
   }
 }
 
+// Allocate blocks which are not yet in the hash, drawing from a free list.
+// Number of threads needed: num_indices
+template <typename BlockType>
+__global__ void allocateBlocksKernel(
+    int num_indices, const Index3D* indices,
+    Index3DDeviceHashMapType<BlockType> block_hash, BlockType** free_list,
+    int* free_list_size, Index3D* allocated_indices,
+    int failed_allocation_marker) {
+  const int idx = threadIdx.x + blockIdx.x * blockDim.x;
+  if (idx >= num_indices) {
+    return;
+  }
+  const Index3D block_index = indices[idx];
+  if (block_hash.contains(block_index)) {
+    return;
+  }
+  // The free list holds at least one block per index, so this never
+  // underflows.
+  const int slot = atomicSub(free_list_size, 1) - 1;
+  const auto result = block_hash.emplace(block_index, free_list[slot]);
+  if (result.second) {
+    allocated_indices[slot] = block_index;
+  } else {
+    // Duplicate index in the input, allocated by another thread.
+    allocated_indices[slot] = Index3D::Constant(failed_allocation_marker);
+  }
+}
+
+// Look up block pointers in the hash.
+// Number of threads needed: num_indices
+template <typename BlockType>
+__global__ void getBlockPointersKernel(
+    int num_indices, const Index3D* indices,
+    Index3DDeviceHashMapType<BlockType> block_hash, BlockType** block_ptrs) {
+  const int idx = threadIdx.x + blockIdx.x * blockDim.x;
+  if (idx >= num_indices) {
+    return;
+  }
+  auto it = block_hash.find(indices[idx]);
+  block_ptrs[idx] = (it != block_hash.end()) ? it->second : nullptr;
+}
+
+template <typename BlockType>
+void BlockLayer<BlockType>::allocateBlocksAtIndicesOnGpuAsync(
+    const device_vector<Index3D>& indices, const CudaStream& cuda_stream) {
+  // Account for the last allocation on the GPU, and pending CPU operations,
+  // before modifying the hash on the GPU.
+  syncCpuHash();
+  const int num_indices = indices.size();
+  if (num_indices == 0) {
+    return;
+  }
+  timing::Timer timer("layer/allocate_blocks_on_gpu");
+  gpu_layer_view_->flushCache(cuda_stream);
+  gpu_layer_view_->reserveForDeviceInsertion(num_indices, cuda_stream);
+
+  // Make sure the free list can serve every index. We top up with some margin
+  // such that we don't go back to the pool on every call.
+  constexpr int kMinFreeListTopUp = 256;
+  if (static_cast<int>(gpu_free_list_blocks_.size()) < num_indices) {
+    releaseRelaidOutBlocks(false);
+    const int target_size = std::max(num_indices, kMinFreeListTopUp);
+    while (static_cast<int>(gpu_free_list_blocks_.size()) < target_size) {
+      gpu_free_list_blocks_.push_back(memory_pool_.popBlock(cuda_stream));
+    }
+    gpu_free_list_dirty_ = true;
+  }
+  const int free_list_size = gpu_free_list_blocks_.size();
+  if (gpu_free_list_dirty_) {
+    std::vector<BlockType*> free_list_ptrs;
+    free_list_ptrs.reserve(free_list_size);
+    for (const auto& block : gpu_free_list_blocks_) {
+      free_list_ptrs.push_back(block.get());
+    }
+    gpu_free_list_.copyFromAsync(free_list_ptrs, cuda_stream);
+    gpu_free_list_dirty_ = false;
+  }
+  if (!gpu_free_list_size_device_) {
+    gpu_free_list_size_device_ = make_unified<int>(MemoryType::kDevice);
+    gpu_free_list_size_host_ = make_unified<int>(MemoryType::kHost);
+    gpu_allocation_event_ = std::make_unique<CudaEvent>();
+  }
+  *gpu_free_list_size_host_ = free_list_size;
+  gpu_free_list_size_device_.copyFromAsync(gpu_free_list_size_host_,
+                                           cuda_stream);
+  gpu_allocated_indices_device_.resizeAsync(free_list_size, cuda_stream);
+
+  constexpr int kNumThreads = 512;
+  const int num_blocks = num_indices / kNumThreads + 1;
+  allocateBlocksKernel<BlockType><<<num_blocks, kNumThreads, 0, cuda_stream>>>(
+      num_indices, indices.data(), gpu_layer_view_->getHash().impl_,
+      gpu_free_list_.data(), gpu_free_list_size_device_.get(),
+      gpu_allocated_indices_device_.data(), kFailedGpuAllocation);
+  checkCudaErrors(cudaPeekAtLastError());
+
+  // Stage the results for syncCpuHash(), which then just waits on the event.
+  gpu_free_list_size_host_.copyFromAsync(gpu_free_list_size_device_,
+                                         cuda_stream);
+  gpu_allocated_indices_host_.copyFromAsync(gpu_allocated_indices_device_,
+                                            cuda_stream);
+  gpu_allocation_event_->record(cuda_stream);
+  cpu_hash_stale_ = true;
+}
+
+template <typename BlockType>
+void BlockLayer<BlockType>::getBlockPointersOnGpuAsync(
+    const device_vector<Index3D>& indices,
+    device_vector<BlockType*>* block_ptrs, const CudaStream& cuda_stream) {
+  CHECK_NOTNULL(block_ptrs);
+  const int num_indices = indices.size();
+  block_ptrs->resizeAsync(num_indices, cuda_stream);
+  if (num_indices == 0) {
+    return;
+  }
+  // NOTE: We deliberately don't get the hash through getGpuLayerView(), which
+  // would sync the CPU hash.
+  constexpr int kNumThreads = 512;
+  const int num_blocks = num_indices / kNumThreads + 1;
+  getBlockPointersKernel<BlockType>
+      <<<num_blocks, kNumThreads, 0, cuda_stream>>>(
+          num_indices, indices.data(), gpu_layer_view_->getHash().impl_,
+          block_ptrs->data());
+  checkCudaErrors(cudaPeekAtLastError());
+}
+
 template <typename VoxelType>
 void VoxelBlockLayer<VoxelType>::getVoxelsGPU(
     const device_vector<Vector3f>& positions_L,
@@ -15,12 +15,16 @@ limitations under the License.
 */
 #pragma once
 
+#include <glog/logging.h>
+
 #include "nvblox/core/cuda_stream.h"
+#include "nvblox/core/internal/error_check.h"
 #include "nvblox/core/types.h"
 #include "nvblox/geometry/bounding_boxes.h"
 #include "nvblox/gpu_hash/gpu_layer_view.h"
 #include "nvblox/gpu_hash/internal/cuda/gpu_indexing.cuh"
 #include "nvblox/gpu_hash/internal/cuda/impl/gpu_layer_view_impl.cuh"
+#include "nvblox/map/internal/cuda/voxel_block_threads.cuh"
 #include "nvblox/map/unified_3d_grid.h"
 
 namespace nvblox {
@@ -42,34 +46,34 @@ __device__ void copyBlock(
   }
   __syncthreads();
 
-  // The voxel addressed by this thread
+  // The voxels addressed by this thread
   // NOTE(alexmillane): Note the x,y,z reversal in the voxel index for
   // coallessed access.
-  const Index3D voxel_idx = {threadIdx.z, threadIdx.y, threadIdx.x};
   constexpr int kVoxelsPerSide = BlockType::kVoxelsPerSide;
-
-  // Get a pointer to the output voxel
-  const Index3D global_voxel_idx = block_idx * kVoxelsPerSide + voxel_idx;
-  if (!grid.isInsideGrid(global_voxel_idx)) {
-    // We indexed outside the grid.
-    return;
-  }
-  OutputCellType& voxel = grid(global_voxel_idx);
-
-  // If we could look up the block,
-  if (block_ptr) {
-    // Do the copy over.
-    voxel = conversion_op(
-        block_ptr->voxels[voxel_idx.x()][voxel_idx.y()][voxel_idx.z()]);
-  } else {
-    // Otherwise set the default value.
-    voxel = default_value;
-  }
+  forEachVoxelInThread([&](const Index3D& voxel_idx) {
+    // Get a pointer to the output voxel
+    const Index3D global_voxel_idx = block_idx * kVoxelsPerSide + voxel_idx;
+    if (!grid.isInsideGrid(global_voxel_idx)) {
+      // We indexed outside the grid.
+      return;
+    }
+    OutputCellType& voxel = grid(global_voxel_idx);
+
+    // If we could look up the block,
+    if (block_ptr) {
+      // Do the copy over.
+      voxel = conversion_op(
+          block_ptr->voxels[voxel_idx.x()][voxel_idx.y()][voxel_idx.z()]);
+    } else {
+      // Otherwise set the default value.
+      voxel = default_value;
+    }
+  });
 }
 
 // Call Requirements
 // - #ThreadBlocks: A 3D grid equal to the size of the AABB in blocks.
-// - #Threads: 3D grid of side length kVoxelsPerSide.
+// - #Threads: voxelBlockThreadsPerBlock().
 template <typename InputVoxelType, typename OutputCellType,
           typename ConversionOperatorType>
 __global__ void extractValuesToGrid(
@@ -139,11 +143,10 @@ void voxelLayerToDenseVoxelGridInAABBAsync(
   const Index3D dims_in_blox = max_block_idx - min_block_idx + Index3D::Ones();
 
   // Extract the values into a grid.
-  constexpr int kVoxelsPerSide = VoxelBlock<InputVoxelType>::kVoxelsPerSide;
   const dim3 thread_blocks = {static_cast<unsigned int>(dims_in_blox.x()),
                               static_cast<unsigned int>(dims_in_blox.y()),
                               static_cast<unsigned int>(dims_in_blox.z())};
-  const dim3 kThreadsPerBlock(kVoxelsPerSide, kVoxelsPerSide, kVoxelsPerSide);
+  const dim3 kThreadsPerBlock = voxelBlockThreadsPerBlock();
   extractValuesToGrid<<<thread_blocks, kThreadsPerBlock, 0, cuda_stream>>>(
       layer.getGpuLayerView(cuda_stream).getHash().impl_, min_block_idx,
       default_value, conversion_op, grid->getGPUView());
@@ -162,4 +165,74 @@ void voxelLayerToDenseVoxelGridInAABBAsync(
                                         conversion_op, grid, cuda_stream);
 }
 
+// Call Requirements
+// - #Threads: One per grid cell (or more).
+template <typename ScalarType>
+__global__ void denseGridGradientsKernel(
+    const ScalarType* distances, const Index3D aabb_size,
+    const float inv_voxel_size, const ScalarType unobserved_value,
+    Eigen::Matrix<ScalarType, 3, 1>* gradients) {
+  const int num_cells = aabb_size.x() * aabb_size.y() * aabb_size.z();
+  const int linear_idx = blockIdx.x * blockDim.x + threadIdx.x;
+  if (linear_idx >= num_cells) {
+    return;
+  }
+  // Linear indexing is z-major (see layerIndexToAabbLinearIndex()).
+  const Index3D strides(aabb_size.z() * aabb_size.y(), aabb_size.z(), 1);
+  const Index3D idx(linear_idx / strides.x(),
+                    (linear_idx / strides.y()) % aabb_size.y(),
+                    linear_idx % aabb_size.z());
+
+  Eigen::Matrix<ScalarType, 3, 1> gradient =
+      Eigen::Matrix<ScalarType, 3, 1>::Zero();
+  const ScalarType center = distances[linear_idx];
+  if (center != unobserved_value) {
+    for (int axis = 0; axis < 3; axis++) {
+      // Neighbours outside the grid or unobserved are replaced by the center
+      // cell, which turns the central difference into a one-sided one.
+      int num_steps = 0;
+      ScalarType previous = center;
+      if (idx[axis] > 0 &&
+          distances[linear_idx - strides[axis]] != unobserved_value) {
+        previous = distances[linear_idx - strides[axis]];
+        ++num_steps;
+      }
+      ScalarType next = center;
+      if (idx[axis] < aabb_size[axis] - 1 &&
+          distances[linear_idx + strides[axis]] != unobserved_value) {
+        next = distances[linear_idx + strides[axis]];
+        ++num_steps;
+      }
+      if (num_steps > 0) {
+        gradient[axis] = (next - previous) * inv_voxel_size / num_steps;
+      }
+    }
+  }
+  gradients[linear_idx] = gradient;
+}
+
+template <typename ScalarType>
+void denseGridGradientsAsync(
+    const Unified3DGrid<ScalarType>& distance_grid, const float voxel_size,
+    const ScalarType unobserved_value,
+    Unified3DGrid<Eigen::Matrix<ScalarType, 3, 1>>* gradient_grid,
+    const CudaStream& cuda_stream) {
+  CHECK_NOTNULL(gradient_grid);
+  CHECK_GT(voxel_size, 0.0f);
+  gradient_grid->setAABBAsync(distance_grid.min_index(),
+                              distance_grid.aabb_size(), cuda_stream);
+  const int num_cells = distance_grid.data().size();
+  if (num_cells == 0) {
+    return;
+  }
+  constexpr int kNumThreadsPerBlock = 256;
+  const int num_thread_blocks =
+      (num_cells + kNumThreadsPerBlock - 1) / kNumThreadsPerBlock;
+  denseGridGradientsKernel<<<num_thread_blocks, kNumThreadsPerBlock, 0,
+                             cuda_stream>>>(
+      distance_grid.data().data(), distance_grid.aabb_size(),
+      1.0f / voxel_size, unobserved_value, gradient_grid->data().data());
+  checkCudaErrors(cudaPeekAtLastError());
+}
+
 }  // namespace nvblox
@@ -0,0 +1,34 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#pragma once
+
+namespace nvblox {
+
+__host__ __device__ inline dim3 voxelBlockThreadsPerBlock() {
+  constexpr int kVoxelsPerSide = VoxelBlock<bool>::kVoxelsPerSide;
+  return dim3(kVoxelsPerSide, kVoxelsPerSide,
+              VoxelBlock<bool>::kThreadBlockDepth);
+}
+
+template <typename CallableType>
+__device__ inline void forEachVoxelInThread(const CallableType& callable) {
+  constexpr int kVoxelsPerSide = VoxelBlock<bool>::kVoxelsPerSide;
+  for (int x = threadIdx.z; x < kVoxelsPerSide; x += blockDim.z) {
+    callable(Index3D(x, threadIdx.y, threadIdx.x));
+  }
+}
+
+}  // namespace nvblox
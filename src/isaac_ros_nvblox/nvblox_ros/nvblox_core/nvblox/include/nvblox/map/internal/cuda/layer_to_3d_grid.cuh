@@ -57,6 +57,25 @@ void voxelLayerToDenseVoxelGridInAABBAsync(
     const ConversionFunctor& conversion_op, Unified3DGrid<OutputCellType>* grid,
     const CudaStream& cuda_stream);
 
+/// Computes the gradients of a dense grid of distances (e.g. as extracted by
+/// voxelLayerToDenseVoxelGridInAABBAsync()) on the GPU.
+/// Gradients are central differences. At the grid borders, and next to cells
+/// with the unobserved value, one-sided differences are used instead. Cells
+/// which are themselves unobserved, or for which an axis has no observed
+/// neighbour, get a zero gradient (along that axis).
+/// @tparam ScalarType The type of the distances.
+/// @param distance_grid The grid of distances (in device or unified memory).
+/// @param voxel_size The size of a grid cell, used to scale the gradients.
+/// @param unobserved_value The value marking unobserved cells.
+/// @param gradient_grid The output grid, resized to the distance grid.
+/// @param cuda_stream The stream on which to process the work.
+template <typename ScalarType>
+void denseGridGradientsAsync(
+    const Unified3DGrid<ScalarType>& distance_grid, const float voxel_size,
+    const ScalarType unobserved_value,
+    Unified3DGrid<Eigen::Matrix<ScalarType, 3, 1>>* gradient_grid,
+    const CudaStream& cuda_stream);
+
 }  // namespace nvblox
 
 #include "nvblox/map/internal/cuda/impl/layer_to_3d_grid_impl.cuh"
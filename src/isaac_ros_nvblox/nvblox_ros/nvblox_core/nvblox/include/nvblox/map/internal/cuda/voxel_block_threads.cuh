@@ -0,0 +1,43 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#pragma once
+
+#include "nvblox/core/types.h"
+#include "nvblox/map/blox.h"
+
+namespace nvblox {
+
+/// The thread block dimensions for kernels which process a VoxelBlock with
+/// (up to) one thread per voxel. See VoxelBlock::kThreadBlockDepth.
+__host__ __device__ inline dim3 voxelBlockThreadsPerBlock();
+
+/// Calls the passed callable with the index of each voxel processed by this
+/// thread, in a kernel launched with voxelBlockThreadsPerBlock() threads per
+/// VoxelBlock. These are the voxels (x, threadIdx.y, threadIdx.x) for
+/// x = threadIdx.z, threadIdx.z + blockDim.z, ... For 8x8x8 blocks the
+/// callable is called exactly once. Returning from the callable moves on to
+/// the next voxel of the thread.
+///
+/// NOTE: The voxel index order is reversed w.r.t. the thread index, such that
+/// adjacent threads (x-major) access adjacent memory locations in the block
+/// (z-major).
+/// @param callable A callable with signature void(const Index3D& voxel_idx).
+template <typename CallableType>
+__device__ inline void forEachVoxelInThread(const CallableType& callable);
+
+}  // namespace nvblox
+
+#include "nvblox/map/internal/cuda/impl/voxel_block_threads_impl.cuh"
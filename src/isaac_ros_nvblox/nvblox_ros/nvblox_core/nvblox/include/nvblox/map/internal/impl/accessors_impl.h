@@ -19,6 +19,7 @@ limitations under the License.
 #include "nvblox/core/types.h"
 #include "nvblox/map/layer.h"
 #include "nvblox/map/voxels.h"
+#include "nvblox/utils/parallel_for.h"
 
 namespace nvblox {
 
@@ -53,7 +54,10 @@ bool getVoxelAtPosition(const BlockLayer<VoxelBlock<VoxelType>>& layer,
 
 template <typename VoxelType>
 void callFunctionOnAllVoxels(const BlockLayer<VoxelBlock<VoxelType>>& layer,
-                             ConstVoxelCallbackFunction<VoxelType> callback) {
+                             ConstVoxelCallbackFunction<VoxelType> callback,
+                             const int num_threads) {
+  // NOTE: This also brings the CPU hash up to date, such that the threads
+  // below only read it.
   std::vector<Index3D> block_indices = layer.getAllBlockIndices();
 
   constexpr int kVoxelsPerSide = VoxelBlock<VoxelType>::kVoxelsPerSide;
@@ -61,64 +65,79 @@ void callFunctionOnAllVoxels(const BlockLayer<VoxelBlock<VoxelType>>& layer,
   bool clone = (layer.memory_type() == MemoryType::kDevice);
 
   // Iterate over all the blocks:
-  for (const Index3D& block_index : block_indices) {
-    Index3D voxel_index;
-    typename VoxelBlock<VoxelType>::ConstPtr block;
-    if (clone) {
-      block = layer.getBlockAtIndex(block_index).clone(MemoryType::kHost);
-    } else {
-      block = layer.getBlockAtIndex(block_index);
-    }
-    if (!block) {
-      continue;
-    }
-    // Iterate over all the voxels:
-    for (voxel_index.x() = 0; voxel_index.x() < kVoxelsPerSide;
-         voxel_index.x()++) {
-      for (voxel_index.y() = 0; voxel_index.y() < kVoxelsPerSide;
-           voxel_index.y()++) {
-        for (voxel_index.z() = 0; voxel_index.z() < kVoxelsPerSide;
-             voxel_index.z()++) {
-          // Get the voxel and call the callback on it:
-          const VoxelType* voxel =
-              &block->voxels[voxel_index.x()][voxel_index.y()][voxel_index.z()];
-          callback(block_index, voxel_index, voxel);
+  parallelFor(block_indices.size(), num_threads, [&](size_t begin,
+                                                     size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      const Index3D& block_index = block_indices[i];
+      Index3D voxel_index;
+      typename VoxelBlock<VoxelType>::ConstPtr block;
+      if (clone) {
+        block = layer.getBlockAtIndex(block_index).clone(MemoryType::kHost);
+      } else {
+        block = layer.getBlockAtIndex(block_index);
+      }
+      if (!block) {
+        continue;
+      }
+      // Iterate over all the voxels:
+      for (voxel_index.x() = 0; voxel_index.x() < kVoxelsPerSide;
+           voxel_index.x()++) {
+        for (voxel_index.y() = 0; voxel_index.y() < kVoxelsPerSide;
+             voxel_index.y()++) {
+          for (voxel_index.z() = 0; voxel_index.z() < kVoxelsPerSide;
+               voxel_index.z()++) {
+            // Get the voxel and call the callback on it:
+            const VoxelType* voxel =
+                &block->voxels[voxel_index.x()][voxel_index.y()]
+                              [voxel_index.z()];
+            callback(block_index, voxel_index, voxel);
+          }
         }
       }
     }
-  }
+  });
 }
 
 template <typename VoxelType>
 void callFunctionOnAllVoxels(BlockLayer<VoxelBlock<VoxelType>>* layer,
-                             VoxelCallbackFunction<VoxelType> callback) {
+                             VoxelCallbackFunction<VoxelType> callback,
+                             const int num_threads) {
   std::vector<Index3D> block_indices = layer->getAllBlockIndices();
 
   constexpr int kVoxelsPerSide = VoxelBlock<VoxelType>::kVoxelsPerSide;
 
+  // Look up the blocks up front such that the threads don't access the layer.
+  std::vector<VoxelBlock<VoxelType>*> blocks(block_indices.size());
+  for (size_t i = 0; i < block_indices.size(); ++i) {
+    blocks[i] = layer->getBlockAtIndex(block_indices[i]).get();
+  }
+
   // Iterate over all the blocks:
-  for (const Index3D& block_index : block_indices) {
-    Index3D voxel_index;
-    typename VoxelBlock<VoxelType>::Ptr block =
-        layer->getBlockAtIndex(block_index);
-    if (!block) {
-      continue;
-    }
-    // Iterate over all the voxels:
-    for (voxel_index.x() = 0; voxel_index.x() < kVoxelsPerSide;
-         voxel_index.x()++) {
-      for (voxel_index.y() = 0; voxel_index.y() < kVoxelsPerSide;
-           voxel_index.y()++) {
-        for (voxel_index.z() = 0; voxel_index.z() < kVoxelsPerSide;
-             voxel_index.z()++) {
-          // Get the voxel and call the callback on it:
-          VoxelType* voxel =
-              &block->voxels[voxel_index.x()][voxel_index.y()][voxel_index.z()];
-          callback(block_index, voxel_index, voxel);
+  parallelFor(block_indices.size(), num_threads, [&](size_t begin,
+                                                     size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      const Index3D& block_index = block_indices[i];
+      VoxelBlock<VoxelType>* block = blocks[i];
+      if (!block) {
+        continue;
+      }
+      Index3D voxel_index;
+      // Iterate over all the voxels:
+      for (voxel_index.x() = 0; voxel_index.x() < kVoxelsPerSide;
+           voxel_index.x()++) {
+        for (voxel_index.y() = 0; voxel_index.y() < kVoxelsPerSide;
+             voxel_index.y()++) {
+          for (voxel_index.z() = 0; voxel_index.z() < kVoxelsPerSide;
+               voxel_index.z()++) {
+            // Get the voxel and call the callback on it:
+            VoxelType* voxel = &block->voxels[voxel_index.x()][voxel_index.y()]
+                                             [voxel_index.z()];
+            callback(block_index, voxel_index, voxel);
+          }
         }
       }
     }
-  }
+  });
 }
 
 template <typename VoxelType>
@@ -179,11 +198,12 @@ void callFunctionOnAllVoxels(VoxelBlock<VoxelType>* block,
 template <typename BlockType>
 void callFunctionOnAllBlocks(const BlockLayer<BlockType>& layer,
                              ConstBlockCallbackFunction<BlockType> callback) {
-  const std::vector<Index3D> block_indices = layer.getAllBlockIndices();
-  for (const Index3D& block_index : block_indices) {
-    typename BlockType::ConstPtr block = layer.getBlockAtIndex(block_index);
-    CHECK(block);
-    callback(block_index, block.get());
+  // The layer can't change while we iterate, so we walk its cached block
+  // lists rather than looking up every block.
+  const std::vector<Index3D>& block_indices = layer.getAllBlockIndicesCached();
+  const std::vector<BlockType*>& block_ptrs = layer.getAllBlockPointersCached();
+  for (size_t i = 0; i < block_indices.size(); ++i) {
+    callback(block_indices[i], block_ptrs[i]);
   }
 }
 
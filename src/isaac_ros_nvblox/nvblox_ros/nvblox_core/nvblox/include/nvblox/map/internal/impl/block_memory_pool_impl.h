@@ -15,15 +15,29 @@ limitations under the License.
 */
 #pragma once
 
+#include <algorithm>
+#include <type_traits>
+
+#include "nvblox/core/unified_memory_hints.h"
 #include "nvblox/map/internal/block_memory_pool.h"
+#include "nvblox/utils/flight_recorder.h"
 
 namespace nvblox {
 
 template <class BlockType>
-BlockMemoryPool<BlockType>::BlockMemoryPool(const MemoryType memory_type,
-                                            const int num_preallocated_blocks)
+BlockMemoryPool<BlockType>::BlockMemoryPool(
+    const MemoryType memory_type, const int num_preallocated_blocks,
+    const BlockAllocationMode allocation_mode)
     : memory_type_(memory_type) {
-  expand(num_preallocated_blocks, CudaStreamOwning());
+  this->allocation_mode(allocation_mode);
+  if (allocation_mode_ == BlockAllocationMode::kSlab) {
+    // Pre-allocation is expected to block.
+    CudaStreamOwning cuda_stream;
+    expandSlabAsync(num_preallocated_blocks, cuda_stream);
+    cuda_stream.synchronize();
+  } else {
+    expand(num_preallocated_blocks, CudaStreamOwning());
+  }
 }
 
 template <class BlockType>
@@ -38,7 +52,22 @@ typename BlockType::Ptr BlockMemoryPool<BlockType>::popBlock(
   }
 
   // Expand if needed
-  if (blocks_.size() == 0) {
+  if (allocation_mode_ == BlockAllocationMode::kSlab) {
+    // Expand ahead of demand, such that the expansion (normally) completes
+    // before the new blocks are needed.
+    const int num_used_blocks =
+        num_allocated_blocks_ - static_cast<int>(blocks_.size()) + 1;
+    if (blocks_.empty() ||
+        num_used_blocks > slab_high_water_mark_ * num_allocated_blocks_) {
+      expandSlabAsync(std::max(kExpansionFactor * num_allocated_blocks_, 1),
+                      cuda_stream);
+    }
+    // Order work on the stream after the initialization of the last slab,
+    // without blocking the host.
+    if (expansion_event_ && !expansion_event_->isReady()) {
+      expansion_event_->streamWait(cuda_stream);
+    }
+  } else if (blocks_.size() == 0) {
     expand(kExpansionFactor * num_allocated_blocks_, cuda_stream);
   }
 
@@ -48,23 +77,131 @@ typename BlockType::Ptr BlockMemoryPool<BlockType>::popBlock(
   return popped;
 }
 
+template <class BlockType>
+std::vector<typename BlockType::Ptr> BlockMemoryPool<BlockType>::popBlocks(
+    const int num_blocks, const CudaStream& cuda_stream) {
+  std::vector<typename BlockType::Ptr> popped;
+  popped.reserve(num_blocks);
+  for (int i = 0; i < num_blocks; ++i) {
+    popped.push_back(popBlock(cuda_stream));
+  }
+  std::sort(popped.begin(), popped.end(),
+            [](const typename BlockType::Ptr& a,
+               const typename BlockType::Ptr& b) { return a.get() < b.get(); });
+  return popped;
+}
+
 template <class BlockType>
 void BlockMemoryPool<BlockType>::pushBlock(typename BlockType::Ptr block) {
   recycled_blocks_.push_back(block.get());
   blocks_.push(block);
 }
 
+template <class BlockType>
+void BlockMemoryPool<BlockType>::reserve(const int num_blocks,
+                                         const CudaStream& cuda_stream) {
+  const int num_blocks_to_allocate = num_blocks - num_allocated_blocks_;
+  if (num_blocks_to_allocate <= 0) {
+    return;
+  }
+  if (allocation_mode_ == BlockAllocationMode::kSlab) {
+    expandSlabAsync(num_blocks_to_allocate, cuda_stream);
+  } else {
+    expand(num_blocks_to_allocate, cuda_stream);
+  }
+}
+
+template <class BlockType>
+void BlockMemoryPool<BlockType>::allocation_mode(
+    BlockAllocationMode allocation_mode) {
+  CHECK(allocation_mode != BlockAllocationMode::kSlab ||
+        std::is_trivially_destructible<BlockType>::value)
+      << "Slab allocation requires a trivially destructible block type.";
+  allocation_mode_ = allocation_mode;
+}
+
+template <class BlockType>
+void BlockMemoryPool<BlockType>::slab_high_water_mark(
+    float slab_high_water_mark) {
+  CHECK_GT(slab_high_water_mark, 0.0f);
+  CHECK_LE(slab_high_water_mark, 1.0f);
+  slab_high_water_mark_ = slab_high_water_mark;
+}
+
 template <class BlockType>
 void BlockMemoryPool<BlockType>::expand(const size_t num_blocks_to_allocate,
                                         const CudaStream& cuda_stream) {
   for (size_t i = 0; i < num_blocks_to_allocate; ++i) {
     blocks_.push(BlockType::allocateAsync(memory_type_, cuda_stream));
+    if (memory_type_ == MemoryType::kUnified) {
+      // Blocks are mostly accessed by kernels. CPU accesses map the memory
+      // rather than migrating it away from the GPU.
+      adviseUnifiedMemoryPreferredLocation(blocks_.top().get(),
+                                           sizeof(BlockType),
+                                           UnifiedMemoryLocation::kDevice);
+    }
   }
   num_allocated_blocks_ += num_blocks_to_allocate;
 
+  timing::FlightRecorder::recordInstant("block_memory_pool/expand",
+                                        num_blocks_to_allocate);
   LOG(INFO) << "Expanding the memory pool with " << num_blocks_to_allocate
             << " blocks. Number of allocated blocks: " << num_allocated_blocks_;
 
   cuda_stream.synchronize();
 }
+
+template <class BlockType>
+void BlockMemoryPool<BlockType>::expandSlabAsync(
+    const size_t num_blocks_to_allocate, const CudaStream& cuda_stream) {
+  if constexpr (std::is_trivially_destructible<BlockType>::value) {
+    if (num_blocks_to_allocate == 0) {
+      return;
+    }
+    // Host and unified slabs are default constructed on allocation. Device
+    // slabs are initialized in a kernel.
+    unified_ptr<BlockType[]> slab = make_unified_async<BlockType[]>(
+        num_blocks_to_allocate, memory_type_, cuda_stream);
+    if (memory_type_ == MemoryType::kUnified) {
+      // See expand().
+      adviseUnifiedMemoryPreferredLocation(
+          slab.get(), num_blocks_to_allocate * sizeof(BlockType),
+          UnifiedMemoryLocation::kDevice);
+    }
+    if (memory_type_ == MemoryType::kDevice) {
+      if (expansion_event_) {
+        // The last initialization kernel may still read the pointers.
+        expansion_event_->synchronize();
+      }
+      slab_block_ptrs_.resize(num_blocks_to_allocate);
+      for (size_t i = 0; i < num_blocks_to_allocate; ++i) {
+        slab_block_ptrs_[i] = slab.get() + i;
+      }
+      initializeBlocksAsync<BlockType>(slab_block_ptrs_, cuda_stream,
+                                       memory_type_);
+    }
+    if (!expansion_event_) {
+      expansion_event_ = std::make_unique<CudaEvent>();
+    }
+    expansion_event_->record(cuda_stream);
+
+    // The blocks share the ownership of the slab, which is freed once the
+    // last of them is gone.
+    for (size_t i = 0; i < num_blocks_to_allocate; ++i) {
+      blocks_.push(typename BlockType::Ptr(slab, slab.get() + i));
+    }
+    num_allocated_blocks_ += num_blocks_to_allocate;
+
+    timing::FlightRecorder::recordInstant("block_memory_pool/expand_slab",
+                                          num_blocks_to_allocate);
+    LOG(INFO) << "Expanding the memory pool with a slab of "
+              << num_blocks_to_allocate
+              << " blocks. Number of allocated blocks: "
+              << num_allocated_blocks_;
+  } else {
+    LOG(FATAL) << "Slab allocation requires a trivially destructible block "
+                  "type.";
+  }
+}
+
 }  // namespace nvblox
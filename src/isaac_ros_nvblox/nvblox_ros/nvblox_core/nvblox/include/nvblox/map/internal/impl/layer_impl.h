@@ -15,11 +15,14 @@ limitations under the License.
 */
 #pragma once
 
+#include <algorithm>
+
 #include "nvblox/utils/logging.h"
 
 #include "nvblox/core/indexing.h"
 #include "nvblox/core/types.h"
 #include "nvblox/map/accessors.h"
+#include "nvblox/utils/timing.h"
 
 namespace nvblox {
 
@@ -36,26 +39,93 @@ void BlockLayer<BlockType>::copyFromAsync(const BlockLayer& other,
   LOG(INFO) << "Deep copy of BlockLayer containing "
             << other.numAllocatedBlocks() << " blocks.";
 
+  syncCpuHash();
+  prepareAllBlocksForWriteAsync(cuda_stream);
   blocks_.clear();
+  ++allocation_generation_;
 
   block_size_ = other.block_size_;
 
   // Re-create all the blocks.
-  std::vector<Index3D> all_block_indices = other.getAllBlockIndices();
+  other.syncCpuHash();
+  std::vector<typename BlockType::ConstPtr> src_blocks;
+  std::vector<typename BlockType::Ptr> dst_blocks;
+  std::vector<thrust::pair<Index3D, BlockType*>> new_blocks;
+  src_blocks.reserve(other.blocks_.size());
+  dst_blocks.reserve(other.blocks_.size());
+  new_blocks.reserve(other.blocks_.size());
+  releaseRelaidOutBlocks(false);
+  for (const auto& kv : other.blocks_) {
+    typename BlockType::Ptr new_block = memory_pool_.popBlock(cuda_stream);
+    blocks_.emplace(kv.first, new_block);
+    src_blocks.push_back(kv.second);
+    dst_blocks.push_back(new_block);
+    new_blocks.emplace_back(kv.first, new_block.get());
+  }
+  gpu_layer_view_->insertBlocksAsync(new_blocks, cuda_stream);
 
-  // Iterate over all blocks, clonin'.
-  for (const Index3D& block_index : all_block_indices) {
+  // Clonin'.
+  copyBlockDataAsync(src_blocks, other.memory_type_, dst_blocks, cuda_stream);
+}
+
+template <typename BlockType>
+void BlockLayer<BlockType>::copyBlocksFromAsync(
+    const BlockLayer& other, const std::vector<Index3D>& block_indices,
+    const CudaStream& cuda_stream) {
+  CHECK_EQ(block_size_, other.block_size_);
+  std::vector<typename BlockType::ConstPtr> src_blocks;
+  std::vector<typename BlockType::Ptr> dst_blocks;
+  src_blocks.reserve(block_indices.size());
+  dst_blocks.reserve(block_indices.size());
+  for (const Index3D& block_index : block_indices) {
     typename BlockType::ConstPtr block = other.getBlockAtIndex(block_index);
     if (block == nullptr) {
       continue;
     }
+    src_blocks.push_back(block);
+    dst_blocks.push_back(allocateBlockAtIndexAsync(block_index, cuda_stream));
+  }
+  copyBlockDataAsync(src_blocks, other.memory_type_, dst_blocks, cuda_stream);
+}
 
-    typename BlockType::Ptr new_block = memory_pool_.popBlock(cuda_stream);
-    new_block.copyFromAsync(block, cuda_stream);
-
-    blocks_.emplace(block_index, new_block);
-    gpu_layer_view_->insertBlockAsync(
-        thrust::make_pair(block_index, new_block.get()), cuda_stream);
+template <typename BlockType>
+void BlockLayer<BlockType>::copyBlockDataAsync(
+    const std::vector<typename BlockType::ConstPtr>& src_blocks,
+    MemoryType src_memory_type,
+    const std::vector<typename BlockType::Ptr>& dst_blocks,
+    const CudaStream& cuda_stream) {
+  CHECK_EQ(src_blocks.size(), dst_blocks.size());
+  if (src_blocks.empty()) {
+    return;
+  }
+  if constexpr (std::is_trivially_copyable<BlockType>::value) {
+    // Kernels can only read blocks on other devices with peer access, so
+    // those are left to cudaMemcpy.
+    const bool is_device_accessible = memory_type_ != MemoryType::kHost &&
+                                      src_memory_type != MemoryType::kHost;
+    const int src_device =
+        is_device_accessible ? getCudaDeviceOfPointer(src_blocks.front().get())
+                             : -1;
+    if (is_device_accessible &&
+        (src_device < 0 || src_device == getCurrentCudaDevice())) {
+      std::vector<const void*> src_block_ptrs;
+      std::vector<void*> dst_block_ptrs;
+      src_block_ptrs.reserve(src_blocks.size());
+      dst_block_ptrs.reserve(dst_blocks.size());
+      for (size_t i = 0; i < src_blocks.size(); ++i) {
+        src_block_ptrs.push_back(src_blocks[i].get());
+        dst_block_ptrs.push_back(dst_blocks[i].get());
+      }
+      src_block_ptrs_device_.copyFromAsync(src_block_ptrs, cuda_stream);
+      dst_block_ptrs_device_.copyFromAsync(dst_block_ptrs, cuda_stream);
+      copyBlocksAsync(src_block_ptrs_device_, dst_block_ptrs_device_,
+                      sizeof(BlockType), cuda_stream);
+      return;
+    }
+  }
+  for (size_t i = 0; i < src_blocks.size(); ++i) {
+    typename BlockType::Ptr dst_block = dst_blocks[i];
+    dst_block.copyFromAsync(src_blocks[i], cuda_stream);
   }
 }
 
@@ -63,6 +133,11 @@ void BlockLayer<BlockType>::copyFromAsync(const BlockLayer& other,
 template <typename BlockType>
 typename BlockType::Ptr BlockLayer<BlockType>::getBlockAtIndex(
     const Index3D& index) {
+  syncCpuHash();
+  if (hasSnapshots()) {
+    const std::vector<Index3D> indices{index};
+    copySharedBlocksIntoSnapshots(&indices);
+  }
   // Look up the block in the hash?
   // And return it.
   auto it = blocks_.find(index);
@@ -73,9 +148,25 @@ typename BlockType::Ptr BlockLayer<BlockType>::getBlockAtIndex(
   }
 }
 
+template <typename BlockType>
+typename BlockType::Ptr BlockLayer<BlockType>::getBlockAtIndexAsync(
+    const Index3D& index, const CudaStream& cuda_stream) {
+  syncCpuHash();
+  if (hasSnapshots()) {
+    prepareBlocksForWriteAsync({index}, cuda_stream);
+  }
+  auto it = blocks_.find(index);
+  if (it != blocks_.end()) {
+    return it->second;
+  } else {
+    return typename BlockType::Ptr();
+  }
+}
+
 template <typename BlockType>
 typename BlockType::ConstPtr BlockLayer<BlockType>::getBlockAtIndex(
     const Index3D& index) const {
+  syncCpuHash();
   const auto it = blocks_.find(index);
   if (it != blocks_.end()) {
     return (it->second);
@@ -84,18 +175,59 @@ typename BlockType::ConstPtr BlockLayer<BlockType>::getBlockAtIndex(
   }
 }
 
+template <typename BlockType>
+void BlockLayer<BlockType>::prefetchBlocksAsync(
+    const std::vector<Index3D>& indices, UnifiedMemoryLocation location,
+    const CudaStream& cuda_stream) const {
+  if (memory_type_ != MemoryType::kUnified || indices.empty() ||
+      !unifiedMemoryHintsSupported()) {
+    return;
+  }
+  syncCpuHash();
+  std::vector<const char*> block_ptrs;
+  block_ptrs.reserve(indices.size());
+  for (const Index3D& index : indices) {
+    const auto it = blocks_.find(index);
+    if (it != blocks_.end()) {
+      block_ptrs.push_back(reinterpret_cast<const char*>(it->second.get()));
+    }
+  }
+  // Blocks from the same slab are often adjacent. Merge them into ranges to
+  // reduce the number of prefetches.
+  std::sort(block_ptrs.begin(), block_ptrs.end());
+  block_ptrs.erase(std::unique(block_ptrs.begin(), block_ptrs.end()),
+                   block_ptrs.end());
+  size_t range_start = 0;
+  for (size_t i = 1; i <= block_ptrs.size(); i++) {
+    if (i < block_ptrs.size() &&
+        block_ptrs[i] == block_ptrs[i - 1] + sizeof(BlockType)) {
+      continue;
+    }
+    if (range_start < block_ptrs.size()) {
+      prefetchUnifiedMemoryAsync(block_ptrs[range_start],
+                                 (i - range_start) * sizeof(BlockType),
+                                 location, cuda_stream);
+    }
+    range_start = i;
+  }
+}
+
 template <typename BlockType>
 typename BlockType::Ptr BlockLayer<BlockType>::allocateBlockAtIndexAsync(
     const Index3D& index, const CudaStream& cuda_stream) {
+  syncCpuHash();
   auto it = blocks_.find(index);
   if (it != blocks_.end()) {
     return it->second;
   } else {
     // Blocks define their own method for allocation.
+    releaseRelaidOutBlocks(false);
     auto new_block = memory_pool_.popBlock(cuda_stream);
     auto insert_status = blocks_.emplace(index, new_block);
 
     if (insert_status.second) {
+      ++allocation_generation_;
+      ++num_allocations_since_relayout_;
       gpu_layer_view_->insertBlockAsync(
           thrust::make_pair(index, new_block.get()), cuda_stream);
     }
@@ -148,36 +280,179 @@ typename BlockType::Ptr BlockLayer<BlockType>::allocateBlockAtPosition(
 
 template <typename BlockType>
 std::vector<Index3D> BlockLayer<BlockType>::getAllBlockIndices() const {
-  std::vector<Index3D> indices;
-  indices.reserve(blocks_.size());
-
-  for (const auto& kv : blocks_) {
-    indices.push_back(kv.first);
-  }
-  return indices;
+  return getAllBlockIndicesCached();
 }
 
 template <typename BlockType>
 std::vector<BlockType*> BlockLayer<BlockType>::getAllBlockPointers() {
-  std::vector<BlockType*> block_ptrs;
-  block_ptrs.reserve(blocks_.size());
+  if (hasSnapshots()) {
+    copySharedBlocksIntoSnapshots(nullptr);
+  }
+  return getAllBlockPointersCached();
+}
 
-  for (auto& kv : blocks_) {
-    block_ptrs.push_back(kv.second.get());
+template <typename BlockType>
+std::vector<BlockType*> BlockLayer<BlockType>::getAllBlockPointersAsync(
+    const CudaStream& cuda_stream) {
+  if (hasSnapshots()) {
+    prepareAllBlocksForWriteAsync(cuda_stream);
   }
-  return block_ptrs;
+  return getAllBlockPointersCached();
 }
 
 template <typename BlockType>
 std::vector<const BlockType*> BlockLayer<BlockType>::getAllBlockPointers()
     const {
-  std::vector<const BlockType*> block_ptrs;
-  block_ptrs.reserve(blocks_.size());
+  const std::vector<BlockType*>& block_ptrs = getAllBlockPointersCached();
+  return std::vector<const BlockType*>(block_ptrs.begin(), block_ptrs.end());
+}
 
-  for (auto& kv : blocks_) {
-    block_ptrs.push_back(kv.second.get());
+template <typename BlockType>
+const std::vector<Index3D>& BlockLayer<BlockType>::getAllBlockIndicesCached()
+    const {
+  updateBlockListCache();
+  return cached_block_indices_;
+}
+
+template <typename BlockType>
+const std::vector<BlockType*>&
+BlockLayer<BlockType>::getAllBlockPointersCached() const {
+  updateBlockListCache();
+  return cached_block_ptrs_;
+}
+
+template <typename BlockType>
+const device_vector<Index3D>& BlockLayer<BlockType>::getAllBlockIndicesOnGpu(
+    const CudaStream& cuda_stream) const {
+  getAllBlockPointersOnGpu(cuda_stream);
+  return cached_block_indices_device_;
+}
+
+template <typename BlockType>
+const device_vector<BlockType*>&
+BlockLayer<BlockType>::getAllBlockPointersOnGpu(
+    const CudaStream& cuda_stream) const {
+  updateBlockListCache();
+  if (cached_block_lists_device_generation_ != allocation_generation_) {
+    cached_block_indices_device_.copyFromAsync(cached_block_indices_,
+                                               cuda_stream);
+    cached_block_ptrs_device_.copyFromAsync(cached_block_ptrs_, cuda_stream);
+    cached_block_lists_device_generation_ = allocation_generation_;
+  }
+  return cached_block_ptrs_device_;
+}
+
+template <typename BlockType>
+void BlockLayer<BlockType>::updateBlockListCache() const {
+  syncCpuHash();
+  if (cached_block_lists_generation_ == allocation_generation_) {
+    return;
+  }
+  cached_block_indices_.clear();
+  cached_block_ptrs_.clear();
+  cached_block_indices_.reserve(blocks_.size());
+  cached_block_ptrs_.reserve(blocks_.size());
+  if (morton_ordered_block_lists_) {
+    std::vector<std::pair<uint64_t, const typename BlockHash::value_type*>>
+        sorted_blocks;
+    sorted_blocks.reserve(blocks_.size());
+    for (const auto& kv : blocks_) {
+      sorted_blocks.emplace_back(getMortonCodeFromBlockIndex(kv.first), &kv);
+    }
+    std::sort(sorted_blocks.begin(), sorted_blocks.end(),
+              [](const auto& a, const auto& b) { return a.first < b.first; });
+    for (const auto& [code, kv] : sorted_blocks) {
+      cached_block_indices_.push_back(kv->first);
+      cached_block_ptrs_.push_back(kv->second.get());
+    }
+  } else {
+    for (const auto& kv : blocks_) {
+      cached_block_indices_.push_back(kv.first);
+      cached_block_ptrs_.push_back(kv.second.get());
+    }
+  }
+  cached_block_lists_generation_ = allocation_generation_;
+}
+
+template <typename BlockType>
+void BlockLayer<BlockType>::morton_ordered_block_lists(
+    bool morton_ordered_block_lists) {
+  if (morton_ordered_block_lists != morton_ordered_block_lists_) {
+    // Rebuild the cached lists in the new order.
+    cached_block_lists_generation_ = kInvalidGeneration;
+    cached_block_lists_device_generation_ = kInvalidGeneration;
   }
-  return block_ptrs;
+  morton_ordered_block_lists_ = morton_ordered_block_lists;
+}
+
+template <typename BlockType>
+void BlockLayer<BlockType>::relayoutBlocksAsync(const CudaStream& cuda_stream) {
+  if constexpr (std::is_trivially_copyable<BlockType>::value) {
+    syncCpuHash();
+    num_allocations_since_relayout_ = 0;
+    if (blocks_.empty() || hasSnapshots()) {
+      return;
+    }
+    timing::Timer timer("layer/relayout_blocks");
+    // Relayouts are far apart, so this normally doesn't wait.
+    releaseRelaidOutBlocks(true);
+
+    // The blocks in Morton order, paired with new blocks in address order.
+    std::vector<std::pair<uint64_t, Index3D>> sorted_indices;
+    sorted_indices.reserve(blocks_.size());
+    for (const auto& kv : blocks_) {
+      sorted_indices.emplace_back(getMortonCodeFromBlockIndex(kv.first),
+                                  kv.first);
+    }
+    std::sort(sorted_indices.begin(), sorted_indices.end(),
+              [](const auto& a, const auto& b) { return a.first < b.first; });
+    std::vector<typename BlockType::Ptr> dst_blocks =
+        memory_pool_.popBlocks(sorted_indices.size(), cuda_stream);
+
+    std::vector<Index3D> block_indices;
+    std::vector<typename BlockType::ConstPtr> src_blocks;
+    std::vector<thrust::pair<Index3D, BlockType*>> new_blocks;
+    block_indices.reserve(sorted_indices.size());
+    relaid_out_blocks_.reserve(sorted_indices.size());
+    src_blocks.reserve(sorted_indices.size());
+    new_blocks.reserve(sorted_indices.size());
+    for (size_t i = 0; i < sorted_indices.size(); ++i) {
+      const Index3D& block_index = sorted_indices[i].second;
+      typename BlockType::Ptr& block = blocks_.find(block_index)->second;
+      relaid_out_blocks_.push_back(block);
+      src_blocks.push_back(block);
+      block = dst_blocks[i];
+      block_indices.push_back(block_index);
+      new_blocks.emplace_back(block_index, dst_blocks[i].get());
+    }
+    copyBlockDataAsync(src_blocks, memory_type_, dst_blocks, cuda_stream);
+    ++allocation_generation_;
+    gpu_layer_view_->removeBlocksAsync(block_indices, cuda_stream);
+    gpu_layer_view_->insertBlocksAsync(new_blocks, cuda_stream);
+
+    // The old blocks are only returned to the memory pool once the copies
+    // have completed, otherwise they could be reused (and overwritten) early.
+    if (!relayout_event_) {
+      relayout_event_ = std::make_unique<CudaEvent>();
+    }
+    relayout_event_->record(cuda_stream);
+  }
+}
+
+template <typename BlockType>
+void BlockLayer<BlockType>::releaseRelaidOutBlocks(bool wait_for_copies) {
+  if (relaid_out_blocks_.empty()) {
+    return;
+  }
+  if (wait_for_copies) {
+    relayout_event_->synchronize();
+  } else if (!relayout_event_->isReady()) {
+    return;
+  }
+  for (const typename BlockType::Ptr& block : relaid_out_blocks_) {
+    memory_pool_.pushBlock(block);
+  }
+  relaid_out_blocks_.clear();
 }
 
 template <typename BlockType>
@@ -192,13 +467,19 @@ std::vector<Index3D> BlockLayer<BlockType>::getBlockIndicesIf(
 
 template <typename BlockType>
 bool BlockLayer<BlockType>::isBlockAllocated(const Index3D& index) const {
+  syncCpuHash();
   const auto it = blocks_.find(index);
   return (it != blocks_.end());
 }
 
 template <typename BlockType>
 void BlockLayer<BlockType>::clear() {
+  syncCpuHash();
+  copySharedBlocksIntoSnapshots(nullptr);
   blocks_.clear();
+  ++allocation_generation_;
+  paged_out_blocks_.clear();
+  paged_out_blocks_aabb_.setEmpty();
   gpu_layer_view_->reset();
 }
 
@@ -210,11 +491,21 @@ bool BlockLayer<BlockType>::clearBlock(const Index3D& index) {
 template <typename BlockType>
 bool BlockLayer<BlockType>::clearBlockAsync(const Index3D& index,
                                             const CudaStream& cuda_stream) {
+  syncCpuHash();
+  if (hasSnapshots()) {
+    // The memory pool can hand the block out on any stream, so its copy has
+    // to complete before it's returned.
+    const std::vector<Index3D> indices{index};
+    if (copySharedBlocksIntoSnapshotsAsync(&indices, cuda_stream)) {
+      cuda_stream.synchronize();
+    }
+  }
   auto it = blocks_.find(index);
   if (it != blocks_.end()) {
     // return the block to the memory pool and remove it from the CPU hash
     memory_pool_.pushBlock(it->second);
     blocks_.erase(it);
+    ++allocation_generation_;
 
     gpu_layer_view_->removeBlockAsync(index, cuda_stream);
     return true;
@@ -231,13 +522,321 @@ void BlockLayer<BlockType>::clearBlocks(const std::vector<Index3D>& indices) {
 template <typename BlockType>
 void BlockLayer<BlockType>::clearBlocksAsync(
     const std::vector<Index3D>& indices, const CudaStream& cuda_stream) {
+  syncCpuHash();
+  // The memory pool can hand the blocks out on any stream, so their copies
+  // have to complete before they're returned.
+  if (copySharedBlocksIntoSnapshotsAsync(&indices, cuda_stream)) {
+    cuda_stream.synchronize();
+  }
+  std::vector<Index3D> cleared_indices;
+  cleared_indices.reserve(indices.size());
   for (const auto& idx : indices) {
-    clearBlockAsync(idx, cuda_stream);
+    auto it = blocks_.find(idx);
+    if (it == blocks_.end()) {
+      continue;
+    }
+    // The returned blocks are re-initialized in one batch once they're
+    // popped from the memory pool again.
+    memory_pool_.pushBlock(it->second);
+    blocks_.erase(it);
+    cleared_indices.push_back(idx);
   }
+  if (!cleared_indices.empty()) {
+    ++allocation_generation_;
+    gpu_layer_view_->removeBlocksAsync(cleared_indices, cuda_stream);
+  }
+}
+
+template <typename BlockType>
+std::vector<Index3D> BlockLayer<BlockType>::pageOutBlocks(
+    const std::vector<Index3D>& indices, const CudaStream& cuda_stream) {
+  static_assert(std::is_trivially_copyable<BlockType>::value,
+                "Only trivially copyable blocks can be paged.");
+  // Copy all blocks to the host first, such that we only synchronize once.
+  syncCpuHash();
+  std::vector<Index3D> paged_out_indices;
+  paged_out_indices.reserve(indices.size());
+  for (const Index3D& idx : indices) {
+    const auto it = blocks_.find(idx);
+    if (it == blocks_.end()) {
+      continue;
+    }
+    paged_out_blocks_[idx] =
+        it->second.cloneAsync(MemoryType::kHost, cuda_stream);
+    paged_out_blocks_aabb_.extend(AxisAlignedBoundingBox(
+        idx.cast<float>() * block_size_,
+        (idx.cast<float>() + Vector3f::Ones()) * block_size_));
+    paged_out_indices.push_back(idx);
+  }
+  // The device blocks are only returned to the memory pool once the copies
+  // have completed, otherwise they could be reused (and overwritten) early.
+  cuda_stream.synchronize();
+  clearBlocksAsync(paged_out_indices, cuda_stream);
+  return paged_out_indices;
+}
+
+template <typename BlockType>
+std::vector<Index3D> BlockLayer<BlockType>::pageInBlocks(
+    const std::vector<Index3D>& indices, const CudaStream& cuda_stream) {
+  static_assert(std::is_trivially_copyable<BlockType>::value,
+                "Only trivially copyable blocks can be paged.");
+  // Free the host copies of earlier calls whose transfers completed.
+  if (page_in_event_ && page_in_event_->isReady()) {
+    paged_in_host_blocks_.clear();
+  }
+  std::vector<Index3D> paged_in_indices;
+  paged_in_indices.reserve(indices.size());
+  for (const Index3D& idx : indices) {
+    const auto it = paged_out_blocks_.find(idx);
+    if (it == paged_out_blocks_.end()) {
+      continue;
+    }
+    typename BlockType::Ptr block = allocateBlockAtIndexAsync(idx, cuda_stream);
+    block.copyFromAsync(it->second, cuda_stream);
+    paged_in_indices.push_back(idx);
+  }
+  if (paged_in_indices.empty()) {
+    return paged_in_indices;
+  }
+
+  // The host copies have to outlive the transfers, so they are only freed
+  // once the event recorded after them signals.
+  if (!page_in_event_) {
+    page_in_event_ = std::make_unique<CudaEvent>();
+  }
+  page_in_event_->streamWait(cuda_stream);
+  page_in_event_->record(cuda_stream);
+  for (const Index3D& idx : paged_in_indices) {
+    auto it = paged_out_blocks_.find(idx);
+    paged_in_host_blocks_.push_back(std::move(it->second));
+    paged_out_blocks_.erase(it);
+  }
+  paged_out_blocks_aabb_.setEmpty();
+  for (const auto& kv : paged_out_blocks_) {
+    paged_out_blocks_aabb_.extend(AxisAlignedBoundingBox(
+        kv.first.cast<float>() * block_size_,
+        (kv.first.cast<float>() + Vector3f::Ones()) * block_size_));
+  }
+  return paged_in_indices;
+}
+
+template <typename BlockType>
+void BlockLayer<BlockType>::syncCpuHash() const {
+  if (!cpu_hash_stale_) {
+    return;
+  }
+  cpu_hash_stale_ = false;
+  timing::Timer timer("layer/sync_cpu_hash");
+
+  // The allocation kernel, and the readback of its results, are done.
+  gpu_allocation_event_->synchronize();
+
+  // The entries consumed from the (stack-like) free list are those on top of
+  // the remaining ones.
+  const int num_remaining = *gpu_free_list_size_host_;
+  const int num_total = gpu_free_list_blocks_.size();
+  CHECK_GE(num_remaining, 0);
+  CHECK_LE(num_remaining, num_total);
+
+  std::vector<typename BlockType::Ptr> unused_blocks;
+  int num_inserted = 0;
+  for (int slot = num_remaining; slot < num_total; ++slot) {
+    const Index3D& block_index = gpu_allocated_indices_host_[slot];
+    if (block_index.x() == kFailedGpuAllocation) {
+      // Another thread allocated the same index. The block was never touched.
+      unused_blocks.push_back(gpu_free_list_blocks_[slot]);
+      continue;
+    }
+    blocks_.emplace(block_index, gpu_free_list_blocks_[slot]);
+    ++num_inserted;
+  }
+  gpu_free_list_blocks_.resize(num_remaining);
+  if (!unused_blocks.empty()) {
+    gpu_free_list_blocks_.insert(gpu_free_list_blocks_.end(),
+                                 unused_blocks.begin(), unused_blocks.end());
+    gpu_free_list_dirty_ = true;
+  }
+  gpu_layer_view_->addDeviceInsertions(num_inserted);
+  num_allocations_since_relayout_ += num_inserted;
+  if (num_inserted > 0) {
+    ++allocation_generation_;
+  }
+}
+
+template <typename BlockType>
+bool BlockLayer<BlockType>::isBlockPagedOut(const Index3D& index) const {
+  return paged_out_blocks_.find(index) != paged_out_blocks_.end();
+}
+
+template <typename BlockType>
+std::vector<Index3D> BlockLayer<BlockType>::getAllPagedOutBlockIndices()
+    const {
+  std::vector<Index3D> indices;
+  indices.reserve(paged_out_blocks_.size());
+  for (const auto& kv : paged_out_blocks_) {
+    indices.push_back(kv.first);
+  }
+  return indices;
+}
+
+template <typename BlockType>
+void BlockLayer<BlockType>::reserve(size_t num_blocks,
+                                    const CudaStream& cuda_stream) {
+  memory_pool_.reserve(static_cast<int>(num_blocks), cuda_stream);
+  blocks_.reserve(num_blocks);
+  gpu_layer_view_->reserve(num_blocks, cuda_stream);
+}
+
+template <typename BlockType>
+LayerMemoryUsage BlockLayer<BlockType>::memoryUsage() const {
+  LayerMemoryUsage usage;
+  usage.memory_type = memory_type_;
+  usage.blocks = memory_pool_.memoryUsage();
+  if (gpu_layer_view_) {
+    usage.gpu_hash = gpu_layer_view_->memoryUsage();
+    usage.gpu_hash_statistics = gpu_layer_view_->statistics();
+  }
+  usage.paged_out_bytes = paged_out_blocks_.size() * sizeof(BlockType);
+  return usage;
+}
+
+template <typename BlockType>
+BlockLayer<BlockType>::~BlockLayer() {
+  copySharedBlocksIntoSnapshots(nullptr);
+}
+
+template <typename BlockType>
+BlockLayerSnapshot<BlockType> BlockLayer<BlockType>::snapshot(
+    const CudaStream& cuda_stream) const {
+  static_assert(std::is_trivially_copyable<BlockType>::value,
+                "Only trivially copyable blocks can be snapshotted.");
+  syncCpuHash();
+  cuda_stream.synchronize();
+  using SnapshotState = typename BlockLayerSnapshot<BlockType>::State;
+  auto state = std::make_shared<SnapshotState>();
+  state->block_size = block_size_;
+  state->shared_blocks.reserve(blocks_.size());
+  for (const auto& kv : blocks_) {
+    state->shared_blocks.emplace(kv.first, kv.second.get());
+  }
+  snapshots_.push_back(state);
+  return BlockLayerSnapshot<BlockType>(std::move(state));
+}
+
+template <typename BlockType>
+bool BlockLayer<BlockType>::hasSnapshots() const {
+  return !liveSnapshots().empty();
+}
+
+template <typename BlockType>
+std::vector<std::shared_ptr<typename BlockLayerSnapshot<BlockType>::State>>
+BlockLayer<BlockType>::liveSnapshots() const {
+  std::vector<std::shared_ptr<typename BlockLayerSnapshot<BlockType>::State>>
+      live_snapshots;
+  if (snapshots_.empty()) {
+    return live_snapshots;
+  }
+  live_snapshots.reserve(snapshots_.size());
+  for (const auto& snapshot : snapshots_) {
+    if (auto state = snapshot.lock()) {
+      live_snapshots.push_back(std::move(state));
+    }
+  }
+  snapshots_.assign(live_snapshots.begin(), live_snapshots.end());
+  return live_snapshots;
+}
+
+template <typename BlockType>
+void BlockLayer<BlockType>::prepareBlocksForWriteAsync(
+    const std::vector<Index3D>& indices, const CudaStream& cuda_stream) {
+  copySharedBlocksIntoSnapshotsAsync(&indices, cuda_stream);
+}
+
+template <typename BlockType>
+void BlockLayer<BlockType>::prepareAllBlocksForWriteAsync(
+    const CudaStream& cuda_stream) {
+  copySharedBlocksIntoSnapshotsAsync(nullptr, cuda_stream);
+}
+
+template <typename BlockType>
+bool BlockLayer<BlockType>::copySharedBlocksIntoSnapshotsAsync(
+    const std::vector<Index3D>* indices, const CudaStream& cuda_stream) {
+  bool copied_any = false;
+  if constexpr (std::is_trivially_copyable<BlockType>::value) {
+    for (const auto& state : liveSnapshots()) {
+      std::lock_guard<std::mutex> lock(state->mutex);
+      std::vector<Index3D> indices_to_copy;
+      if (indices != nullptr) {
+        for (const Index3D& index : *indices) {
+          if (state->shared_blocks.count(index) > 0) {
+            indices_to_copy.push_back(index);
+          }
+        }
+      } else {
+        for (const auto& kv : state->shared_blocks) {
+          indices_to_copy.push_back(kv.first);
+        }
+      }
+      if (indices_to_copy.empty()) {
+        continue;
+      }
+      // Readers only wait for the last recorded event, so earlier copies on
+      // other streams are ordered before it.
+      state->copies_event.streamWait(cuda_stream);
+      for (const Index3D& index : indices_to_copy) {
+        if (state->copied_blocks.count(index) > 0) {
+          // Duplicate index.
+          continue;
+        }
+        typename BlockType::Ptr copy =
+            BlockType::allocateAsync(MemoryType::kHost, cuda_stream);
+        checkCudaErrors(cudaMemcpyAsync(
+            copy.get(), state->shared_blocks.find(index)->second,
+            sizeof(BlockType), cudaMemcpyDefault, cuda_stream));
+        state->copied_blocks.emplace(index, std::move(copy));
+        state->shared_blocks.erase(index);
+      }
+      state->copies_event.record(cuda_stream);
+      copied_any = true;
+    }
+  }
+  return copied_any;
+}
+
+template <typename BlockType>
+bool BlockLayer<BlockType>::sharesBlocksWithSnapshots(
+    const std::vector<Index3D>* indices) const {
+  for (const auto& state : liveSnapshots()) {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    if (indices == nullptr) {
+      if (!state->shared_blocks.empty()) {
+        return true;
+      }
+      continue;
+    }
+    for (const Index3D& index : *indices) {
+      if (state->shared_blocks.count(index) > 0) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+template <typename BlockType>
+void BlockLayer<BlockType>::copySharedBlocksIntoSnapshots(
+    const std::vector<Index3D>* indices) {
+  if (!sharesBlocksWithSnapshots(indices)) {
+    return;
+  }
+  CudaStreamOwning cuda_stream;
+  copySharedBlocksIntoSnapshotsAsync(indices, cuda_stream);
+  cuda_stream.synchronize();
 }
 
 template <typename BlockType>
 void BlockLayer<BlockType>::updateGpuHash(const CudaStream& cuda_stream) const {
+  syncCpuHash();
   gpu_layer_view_->flushCache(cuda_stream);
 }
 
@@ -293,8 +892,10 @@ void VoxelBlockLayer<VoxelType>::getVoxels(
     const auto block_raw_ptr = block_ptr.get();
     const VoxelType* voxel_ptr =
         &block_raw_ptr->voxels[voxel_idx.x()][voxel_idx.y()][voxel_idx.z()];
-    // Copy the Voxel to the CPU (if on the GPU)
-    if (this->memory_type_ == MemoryType::kDevice) {
+    // Copy the Voxel to the CPU (if on the GPU). Unified memory is copied as
+    // well, such that the query doesn't migrate the block's pages away from
+    // the GPU.
+    if (this->memory_type_ != MemoryType::kHost) {
       checkCudaErrors(cudaMemcpyAsync(&(*voxels_ptr)[i], voxel_ptr,
                                       sizeof(VoxelType), cudaMemcpyDefault,
                                       *cuda_stream_ptr));
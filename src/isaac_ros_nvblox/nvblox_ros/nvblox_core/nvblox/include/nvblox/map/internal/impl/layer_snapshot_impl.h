@@ -0,0 +1,111 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#pragma once
+
+#include <glog/logging.h>
+
+#include "nvblox/core/internal/error_check.h"
+
+namespace nvblox {
+
+template <typename BlockType>
+float BlockLayerSnapshot<BlockType>::block_size() const {
+  CHECK(valid());
+  return state_->block_size;
+}
+
+template <typename BlockType>
+size_t BlockLayerSnapshot<BlockType>::numBlocks() const {
+  CHECK(valid());
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  return state_->shared_blocks.size() + state_->copied_blocks.size();
+}
+
+template <typename BlockType>
+size_t BlockLayerSnapshot<BlockType>::numCopiedBlocks() const {
+  CHECK(valid());
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  return state_->copied_blocks.size();
+}
+
+template <typename BlockType>
+std::vector<Index3D> BlockLayerSnapshot<BlockType>::getAllBlockIndices()
+    const {
+  CHECK(valid());
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  std::vector<Index3D> indices;
+  indices.reserve(state_->shared_blocks.size() +
+                  state_->copied_blocks.size());
+  for (const auto& kv : state_->shared_blocks) {
+    indices.push_back(kv.first);
+  }
+  for (const auto& kv : state_->copied_blocks) {
+    indices.push_back(kv.first);
+  }
+  return indices;
+}
+
+template <typename BlockType>
+bool BlockLayerSnapshot<BlockType>::hasBlock(const Index3D& index) const {
+  CHECK(valid());
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  return state_->shared_blocks.count(index) > 0 ||
+         state_->copied_blocks.count(index) > 0;
+}
+
+template <typename BlockType>
+bool BlockLayerSnapshot<BlockType>::copyBlockToHost(
+    const Index3D& index, BlockType* block_ptr,
+    const CudaStream& cuda_stream) const {
+  static_assert(std::is_trivially_copyable<BlockType>::value,
+                "Only trivially copyable blocks can be snapshotted.");
+  CHECK(valid());
+  CHECK_NOTNULL(block_ptr);
+  // NOTE: The lock is held until the copy completed, such that the layer
+  // can't start writing a shared block while we read it.
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  const BlockType* src_ptr = nullptr;
+  const auto copied_it = state_->copied_blocks.find(index);
+  if (copied_it != state_->copied_blocks.end()) {
+    src_ptr = copied_it->second.get();
+    state_->copies_event.streamWait(cuda_stream);
+  } else {
+    const auto shared_it = state_->shared_blocks.find(index);
+    if (shared_it == state_->shared_blocks.end()) {
+      return false;
+    }
+    src_ptr = shared_it->second;
+  }
+  checkCudaErrors(cudaMemcpyAsync(block_ptr, src_ptr, sizeof(BlockType),
+                                  cudaMemcpyDefault, cuda_stream));
+  cuda_stream.synchronize();
+  return true;
+}
+
+template <typename BlockType>
+void BlockLayerSnapshot<BlockType>::copyToLayer(
+    BlockLayer<BlockType>* layer_ptr, const CudaStream& cuda_stream) const {
+  CHECK(valid());
+  CHECK_NOTNULL(layer_ptr);
+  CHECK_EQ(layer_ptr->block_size(), block_size());
+  for (const Index3D& index : getAllBlockIndices()) {
+    typename BlockType::Ptr block_ptr = layer_ptr->allocateBlockAtIndex(index);
+    // Blocks are never dropped from a snapshot, so this can't fail.
+    CHECK(copyBlockToHost(index, block_ptr.get(), cuda_stream));
+  }
+}
+
+}  // namespace nvblox
@@ -15,18 +15,26 @@ limitations under the License.
 */
 #pragma once
 
+#include <limits>
 #include <memory>
+#include <type_traits>
 #include <vector>
 
+#include "nvblox/core/cuda_device.h"
+#include "nvblox/core/cuda_event.h"
 #include "nvblox/core/cuda_stream.h"
+#include "nvblox/core/flat_hash_map.h"
 #include "nvblox/core/hash.h"
+#include "nvblox/core/memory_usage.h"
 #include "nvblox/core/traits.h"
 #include "nvblox/core/types.h"
+#include "nvblox/core/unified_memory_hints.h"
 #include "nvblox/core/unified_ptr.h"
 #include "nvblox/core/unified_vector.h"
 #include "nvblox/gpu_hash/gpu_layer_view.h"
 #include "nvblox/map/blox.h"
 #include "nvblox/map/internal/block_memory_pool.h"
+#include "nvblox/map/layer_snapshot.h"
 
 namespace nvblox {
 
@@ -41,6 +49,21 @@ class BaseLayer {
   // Just an interface class
 };
 
+/// The memory held by a BlockLayer.
+struct LayerMemoryUsage {
+  /// Where the blocks are stored.
+  MemoryType memory_type = MemoryType::kDevice;
+  /// The blocks in the layer's memory pool (see BlockMemoryPool).
+  MemoryUsage blocks;
+  /// The GPU hash of the layer (see GPULayerView). Always device memory.
+  MemoryUsage gpu_hash;
+  /// The health of the GPU hash, reported alongside its memory such that its
+  /// capacity can be tuned.
+  GPUHashStatistics gpu_hash_statistics;
+  /// Host memory held by the blocks which are paged out.
+  size_t paged_out_bytes = 0;
+};
+
 /// A layer that contains blocks, which are stored in a hash map.
 template <typename _BlockType>
 class BlockLayer : public BaseLayer {
@@ -61,8 +84,10 @@ class BlockLayer : public BaseLayer {
   typedef BlockLayer<BlockType> LayerType;
   typedef GPULayerView<BlockType> GPULayerViewType;
 
-  /// The type of the CPU hash map from Index3D to BlockType::Ptr.
-  typedef typename Index3DHashMapType<typename BlockType::Ptr>::type BlockHash;
+  /// The type of the CPU hash map from Index3D to BlockType::Ptr. A flat,
+  /// open-addressing map, such that lookups and iteration over all blocks
+  /// don't chase pointers through the nodes of a std::unordered_map.
+  typedef Index3DFlatHashMap<typename BlockType::Ptr> BlockHash;
 
   /// No default constructor.
   BlockLayer() = delete;
@@ -75,7 +100,8 @@ class BlockLayer : public BaseLayer {
         memory_type_(memory_type),
         memory_pool_(memory_type),
         gpu_layer_view_(std::make_unique<GPULayerViewType>()) {}
-  virtual ~BlockLayer() = default;
+  /// Snapshots still sharing blocks with the layer get copies of them.
+  virtual ~BlockLayer();
 
   /// Use copyFrom() instead of copy constructors
   BlockLayer(const BlockLayer& other) = delete;
@@ -88,24 +114,84 @@ class BlockLayer : public BaseLayer {
 
   /// Replace this Layer's data with a copy of data from another.
   /// If this and other's memory types differ, the memory becomes the MemoryType
-  /// of *this.
+  /// of *this. Blocks in device or unified memory are copied in one batch.
   /// @param other The layer containing the copied-from data
   void copyFrom(const BlockLayer& other);
   /// See copyFrom(). Copy is performed on a stream.
   /// @param other The layer containing the copied-from data
   void copyFromAsync(const BlockLayer& other, const CudaStream& cuda_stream);
 
+  /// Copy some blocks of another layer into this one, allocating them if
+  /// needed and overwriting them otherwise. The other layer may reside on
+  /// another device, in which case the blocks are copied peer-to-peer if the
+  /// peer access is enabled (see enablePeerAccess()).
+  /// @param other The layer containing the copied-from blocks.
+  /// @param block_indices The blocks to copy. Blocks not allocated in other
+  /// are skipped.
+  /// @param cuda_stream The stream to copy on.
+  void copyBlocksFromAsync(const BlockLayer& other,
+                           const std::vector<Index3D>& block_indices,
+                           const CudaStream& cuda_stream);
+
   /// Get a block by it's 3D index.
   /// @param index The 3D index of the block
   /// @return A pointer to the block.
   typename BlockType::Ptr getBlockAtIndex(const Index3D& index);
   typename BlockType::ConstPtr getBlockAtIndex(const Index3D& index) const;
+  /// Same as getBlockAtIndex(), for a block which is written on the passed
+  /// stream: if the block is shared with a snapshot, it's copied into the
+  /// snapshot on the stream (see prepareBlocksForWriteAsync()).
+  /// @param index The 3D index of the block
+  /// @param cuda_stream The stream on which the block is written.
+  /// @return A pointer to the block.
+  typename BlockType::Ptr getBlockAtIndexAsync(const Index3D& index,
+                                               const CudaStream& cuda_stream);
   typename BlockType::Ptr allocateBlockAtIndex(const Index3D& index);
   typename BlockType::Ptr allocateBlockAtIndexAsync(
       const Index3D& index, const CudaStream& cuda_stream);
   void allocateBlocksAtIndices(const std::vector<Index3D>& indices,
                                const CudaStream& cuda_stream);
 
+  /// Allocate blocks at indices which reside on the GPU, without hashing on
+  /// the CPU. The blocks are allocated in a kernel, which inserts into the
+  /// GPU hash, drawing from a device-side free list that is filled from the
+  /// memory pool. The CPU hash is updated lazily, on the next call to a
+  /// CPU-side accessor (see syncCpuHash()).
+  /// NOTE: Only available for VoxelBlock layers.
+  /// @param indices Block indices to allocate. May contain duplicates and
+  ///                indices of blocks which are already allocated.
+  /// @param cuda_stream The stream on which to allocate.
+  void allocateBlocksAtIndicesOnGpuAsync(const device_vector<Index3D>& indices,
+                                         const CudaStream& cuda_stream);
+
+  /// Look up the (device) pointers of allocated blocks, using the GPU hash.
+  /// Unlike getBlockAtIndex() this doesn't require the CPU hash to be up to
+  /// date. Pointers of non-allocated blocks are set to nullptr.
+  /// NOTE: Only available for VoxelBlock layers.
+  /// @param indices Block indices to look up.
+  /// @param block_ptrs Output pointers, one per index.
+  /// @param cuda_stream The stream on which to perform the look up.
+  void getBlockPointersOnGpuAsync(const device_vector<Index3D>& indices,
+                                  device_vector<BlockType*>* block_ptrs,
+                                  const CudaStream& cuda_stream);
+
+  /// Update the CPU hash with blocks allocated by
+  /// allocateBlocksAtIndicesOnGpuAsync(). Blocks until the allocation is
+  /// done. This is called by all CPU-side accessors, so it is only required
+  /// to call it explicitly to control when the synchronization takes place.
+  void syncCpuHash() const;
+
+  /// Migrate blocks to where they are needed next, e.g. the blocks in view to
+  /// the GPU before integrating into them. Only has an effect for layers in
+  /// MemoryType::kUnified (see unified_memory_hints.h).
+  /// @param indices Block indices to prefetch. Non-allocated blocks are
+  ///                skipped.
+  /// @param location Where the blocks are needed next.
+  /// @param cuda_stream The stream on which the blocks are needed.
+  void prefetchBlocksAsync(const std::vector<Index3D>& indices,
+                           UnifiedMemoryLocation location,
+                           const CudaStream& cuda_stream) const;
+
   /// Get a block by 3D position. The function returns the block containing the
   /// passed location.
   /// @param index A 3D point which the returned block should contain.
@@ -123,10 +209,80 @@ class BlockLayer : public BaseLayer {
   /// Get the pointers to all allocated blocks
   /// @return The pointers.
   std::vector<BlockType*> getAllBlockPointers();
+  /// Same as getAllBlockPointers(), for blocks which are written on the passed
+  /// stream (see getBlockAtIndexAsync()).
+  /// @param cuda_stream The stream on which the blocks are written.
+  /// @return The pointers.
+  std::vector<BlockType*> getAllBlockPointersAsync(
+      const CudaStream& cuda_stream);
   /// Get the pointers to all allocated blocks
   /// @return The pointers.
   std::vector<const BlockType*> getAllBlockPointers() const;
 
+  /// Get the 3D indices of all allocated blocks without copying them.
+  /// The list is cached and only rebuilt after blocks have been allocated or
+  /// deallocated. The reference stays valid until the next call to a
+  /// block-list getter after such a change.
+  /// @return The indices.
+  const std::vector<Index3D>& getAllBlockIndicesCached() const;
+  /// Get the pointers to all allocated blocks without copying them. Entry i
+  /// belongs to entry i of getAllBlockIndicesCached().
+  /// @return The pointers.
+  const std::vector<BlockType*>& getAllBlockPointersCached() const;
+  /// Get the 3D indices of all allocated blocks in device memory, e.g. to
+  /// launch a kernel over all blocks. Only transferred to the device after
+  /// blocks have been (de)allocated.
+  /// @param cuda_stream The stream on which to copy the indices.
+  /// @return The indices.
+  const device_vector<Index3D>& getAllBlockIndicesOnGpu(
+      const CudaStream& cuda_stream) const;
+  /// Get the pointers to all allocated blocks in device memory. See
+  /// getAllBlockIndicesOnGpu().
+  /// @param cuda_stream The stream on which to copy the pointers.
+  /// @return The pointers.
+  const device_vector<BlockType*>& getAllBlockPointersOnGpu(
+      const CudaStream& cuda_stream) const;
+
+  /// A parameter getter
+  /// Whether the cached block lists (getAllBlockIndicesCached() and the
+  /// related getters) are sorted by the Morton code of the block indices
+  /// (see getMortonCodeFromBlockIndex()), rather than in hash order. Kernels
+  /// launched over these lists then process neighbouring blocks together.
+  bool morton_ordered_block_lists() const {
+    return morton_ordered_block_lists_;
+  }
+
+  /// A parameter setter
+  /// See morton_ordered_block_lists().
+  void morton_ordered_block_lists(bool morton_ordered_block_lists);
+
+  /// Moves all blocks into blocks freshly popped from the memory pool, such
+  /// that their order in memory follows the Morton order of their indices.
+  /// Blocks allocated over time are scattered over the pool, which this
+  /// undoes to improve the cache locality of kernels accessing neighbouring
+  /// blocks. Pointers to the blocks are invalidated. Does nothing if any
+  /// snapshot of the layer is alive, or for blocks which aren't trivially
+  /// copyable. Does not synchronize the stream: the replaced blocks are only
+  /// returned to the memory pool once their copies completed.
+  /// @param cuda_stream The stream on which to copy the blocks.
+  void relayoutBlocksAsync(const CudaStream& cuda_stream);
+
+  /// The number of blocks allocated since the last call to
+  /// relayoutBlocksAsync() (or the construction of the layer).
+  /// @return The number of allocations.
+  int numAllocationsSinceRelayout() const {
+    syncCpuHash();
+    return num_allocations_since_relayout_;
+  }
+
+  /// A counter increased every time blocks are allocated or deallocated. If it
+  /// didn't change, the set of allocated blocks didn't change either.
+  /// @return The generation.
+  uint64_t allocation_generation() const {
+    syncCpuHash();
+    return allocation_generation_;
+  }
+
   /// Get block indices for which the provided predicate evaluates to true
   /// @param predicate A function taking an index and returning a flag
   /// indicating if the block should be returned.
@@ -145,13 +301,20 @@ class BlockLayer : public BaseLayer {
 
   /// Get the number of allocated blocks
   /// @return The total number of allocated blocks.
-  int numAllocatedBlocks() const { return blocks_.size(); }
+  int numAllocatedBlocks() const {
+    syncCpuHash();
+    return blocks_.size();
+  }
 
   /// Get the number of allocated blocks
   /// @return The total number of allocated blocks.
-  size_t size() const { return blocks_.size(); }
+  size_t size() const {
+    syncCpuHash();
+    return blocks_.size();
+  }
 
-  /// Clear the layer of all data. Deallocate all blocks.
+  /// Clear the layer of all data. Deallocate all blocks, including paged out
+  /// blocks.
   void clear();
 
   /// Clear (deallocate) a single block. Does nothing if the block is not in the
@@ -163,16 +326,103 @@ class BlockLayer : public BaseLayer {
 
   /// Clear (deallocate) blocks passed in
   /// Note if a block does not exist, this function just (silently)
-  /// continues trying the rest of the list.
+  /// continues trying the rest of the list. The blocks are returned to the
+  /// memory pool, and removed from the GPU hash, in one batch.
   /// @param indices A list of block indices to delete.
   void clearBlocks(const std::vector<Index3D>& indices);
   void clearBlocksAsync(const std::vector<Index3D>& indices,
                         const CudaStream& cuda_stream);
 
+  /// Page (evict) blocks out of the layer into a host-side store.
+  /// The blocks are removed from the layer, returning their memory to the
+  /// pool, but their data is retained such that they can be restored with
+  /// pageInBlocks(). Indices not allocated in the layer are (silently)
+  /// skipped. The call synchronizes the stream once for the whole batch.
+  /// @param indices The indices of the blocks to page out.
+  /// @param cuda_stream The stream on which to perform the copies.
+  /// @return The indices of the blocks that were paged out.
+  std::vector<Index3D> pageOutBlocks(const std::vector<Index3D>& indices,
+                                     const CudaStream& cuda_stream);
+
+  /// Page (restore) blocks from the host-side store back into the layer.
+  /// Indices that are not paged out are (silently) skipped. If a block was
+  /// re-allocated in the layer since it was paged out, the paged out data
+  /// overwrites it. The copies are ordered on the stream without
+  /// synchronizing it; the host copies are freed once they completed.
+  /// @param indices The indices of the blocks to page in.
+  /// @param cuda_stream The stream on which to perform the copies.
+  /// @return The indices of the blocks that were paged in.
+  std::vector<Index3D> pageInBlocks(const std::vector<Index3D>& indices,
+                                    const CudaStream& cuda_stream);
+
+  /// Check if a block is currently paged out.
+  /// @param index The 3D grid index.
+  /// @return True if the block is held in the paged out store.
+  bool isBlockPagedOut(const Index3D& index) const;
+
+  /// Get the number of paged out blocks
+  /// @return The number of blocks in the paged out store.
+  int numPagedOutBlocks() const { return paged_out_blocks_.size(); }
+
+  /// Get the AABB covering all paged out blocks, e.g. to skip looking for
+  /// blocks to page in. Empty if no block is paged out.
+  /// @return The AABB.
+  const AxisAlignedBoundingBox& pagedOutBlocksAABB() const {
+    return paged_out_blocks_aabb_;
+  }
+
+  /// Get the 3D indices of all paged out blocks.
+  /// @return The indices.
+  std::vector<Index3D> getAllPagedOutBlockIndices() const;
+
   /// The memory type of the blocks stored in the Layer.
   /// @return The memory type.
   MemoryType memory_type() const { return memory_type_; }
 
+  /// The memory pool from which the layer's blocks are allocated, e.g. to
+  /// switch it to BlockAllocationMode::kSlab.
+  /// @return The memory pool.
+  BlockMemoryPool<BlockType>& memory_pool() { return memory_pool_; }
+
+  /// Preallocate the block pool and the GPU hash such that up to a number of
+  /// blocks can be allocated in the layer without growing either of them.
+  /// @param num_blocks The total number of blocks.
+  /// @param cuda_stream The stream on which to allocate.
+  void reserve(size_t num_blocks, const CudaStream& cuda_stream);
+
+  /// The memory held by the layer, i.e. by its block pool, its GPU hash and
+  /// its paged out blocks.
+  /// @return The memory usage.
+  LayerMemoryUsage memoryUsage() const;
+
+  /// Takes a copy-on-write snapshot of the layer, see BlockLayerSnapshot.
+  /// No block data is copied. Synchronizes the stream, such that writes
+  /// queued on it are part of the snapshot. Like all writes, this has to be
+  /// called from the thread writing the layer.
+  /// @param cuda_stream The stream on which the layer is written.
+  /// @return The snapshot.
+  BlockLayerSnapshot<BlockType> snapshot(const CudaStream& cuda_stream) const;
+
+  /// Whether any snapshot taken from this layer is still alive.
+  bool hasSnapshots() const;
+
+  /// Copies blocks which are about to be written (or freed) into the live
+  /// snapshots still sharing them. Does nothing if there are no snapshots.
+  /// The layer calls this itself from getBlockAtIndex(), getAllBlockPointers()
+  /// and the clear functions. Writers going through other accessors, e.g.
+  /// kernels on the pointers of getAllBlockPointersCached() or the
+  /// GPULayerView, have to call it before writing. Does not synchronize the
+  /// stream: the blocks are copied before the writes queued on it after this
+  /// call, and snapshot readers wait for the copies.
+  /// @param indices The indices of the blocks about to be written.
+  /// @param cuda_stream The stream on which the blocks are written.
+  void prepareBlocksForWriteAsync(const std::vector<Index3D>& indices,
+                                  const CudaStream& cuda_stream);
+
+  /// See prepareBlocksForWriteAsync(), for all blocks of the layer.
+  /// @param cuda_stream The stream on which the blocks are written.
+  void prepareAllBlocksForWriteAsync(const CudaStream& cuda_stream);
+
   /// Return a GPULayerView which can be used to access the layer data on the
   /// GPU. For more details see \ref GPULayerView.
   /// @param cuda_stream The stream on which to perform the CPU to GPU copy of
@@ -192,7 +442,9 @@ class BlockLayer : public BaseLayer {
   MemoryType memory_type_;
 
   /// CPU Hash (Index3D -> BlockType::Ptr)
-  BlockHash blocks_;
+  /// The "mutable" here is to enable the lazy update from GPU allocations in
+  /// const member functions (see syncCpuHash()).
+  mutable BlockHash blocks_;
 
   /// Memory pool that stores preallocated blocks.
   /// NOTE(dtingdahl): The memory pool works together with the BlockHash and
@@ -200,6 +452,15 @@ class BlockLayer : public BaseLayer {
   /// common class or making an allocator out of the memory pool.
   BlockMemoryPool<BlockType> memory_pool_;
 
+  /// Blocks that have been paged out of the layer (always in host memory).
+  BlockHash paged_out_blocks_;
+  /// See pagedOutBlocksAABB().
+  AxisAlignedBoundingBox paged_out_blocks_aabb_;
+  /// The host copies of blocks paged in by pageInBlocks(), kept alive until
+  /// page_in_event_ signals that their transfers completed.
+  std::vector<typename BlockType::Ptr> paged_in_host_blocks_;
+  std::unique_ptr<CudaEvent> page_in_event_;
+
   /// GPU Hash
   /// NOTE(alexmillane):
   /// - This is subservient to the CPU version. The layer has to copy the
@@ -209,6 +470,100 @@ class BlockLayer : public BaseLayer {
   /// - Lazily allocated (space allocated on the GPU first request)
   /// - The "mutable" here is to enable caching in const member functions.
   mutable std::unique_ptr<GPULayerViewType> gpu_layer_view_;
+
+  /// The state of the snapshots taken from the layer. Expired snapshots are
+  /// dropped lazily.
+  mutable std::vector<
+      std::weak_ptr<typename BlockLayerSnapshot<BlockType>::State>>
+      snapshots_;
+
+  /// Returns the live snapshots, dropping the expired ones.
+  std::vector<std::shared_ptr<typename BlockLayerSnapshot<BlockType>::State>>
+  liveSnapshots() const;
+
+  /// Copies blocks into the live snapshots which still share them.
+  /// @param indices The blocks to copy, or nullptr for all blocks.
+  /// @return Whether any block was copied.
+  bool copySharedBlocksIntoSnapshotsAsync(const std::vector<Index3D>* indices,
+                                          const CudaStream& cuda_stream);
+
+  /// Whether any of the blocks is still shared with a live snapshot, i.e.
+  /// whether writing them requires a copy. Used by the functions without a
+  /// stream argument to only create a stream if there's something to copy.
+  /// @param indices The blocks to check, or nullptr for all blocks.
+  bool sharesBlocksWithSnapshots(const std::vector<Index3D>* indices) const;
+
+  /// Copies blocks about to be written from the host (or freed) into the live
+  /// snapshots which still share them, on a new stream which is synchronized.
+  /// @param indices The blocks to copy, or nullptr for all blocks.
+  void copySharedBlocksIntoSnapshots(const std::vector<Index3D>* indices);
+
+  /// Copy the data of blocks into (allocated) blocks of this layer. Trivially
+  /// copyable blocks in device or unified memory are copied by a single kernel
+  /// launch, others block by block.
+  /// @param src_blocks The blocks to copy from.
+  /// @param src_memory_type The memory type of the blocks copied from.
+  /// @param dst_blocks The blocks to copy to, one per block copied from.
+  /// @param cuda_stream The stream to copy on.
+  void copyBlockDataAsync(
+      const std::vector<typename BlockType::ConstPtr>& src_blocks,
+      MemoryType src_memory_type,
+      const std::vector<typename BlockType::Ptr>& dst_blocks,
+      const CudaStream& cuda_stream);
+
+  /// Rebuild the cached block lists if blocks have been (de)allocated since
+  /// they were last built.
+  void updateBlockListCache() const;
+
+  /// Cached lists of allocated blocks. Valid if their generation matches
+  /// allocation_generation_.
+  mutable uint64_t allocation_generation_ = 0;
+  static constexpr uint64_t kInvalidGeneration =
+      std::numeric_limits<uint64_t>::max();
+  mutable uint64_t cached_block_lists_generation_ = kInvalidGeneration;
+  mutable uint64_t cached_block_lists_device_generation_ = kInvalidGeneration;
+  mutable std::vector<Index3D> cached_block_indices_;
+  mutable std::vector<BlockType*> cached_block_ptrs_;
+  mutable device_vector<Index3D> cached_block_indices_device_;
+  mutable device_vector<BlockType*> cached_block_ptrs_device_;
+  bool morton_ordered_block_lists_ = false;
+
+  /// See numAllocationsSinceRelayout().
+  mutable int num_allocations_since_relayout_ = 0;
+
+  /// The blocks replaced by the last relayoutBlocksAsync(), kept alive until
+  /// relayout_event_ signals that they were copied.
+  std::vector<typename BlockType::Ptr> relaid_out_blocks_;
+  std::unique_ptr<CudaEvent> relayout_event_;
+
+  /// Returns relaid_out_blocks_ to the memory pool if their copies completed.
+  /// @param wait_for_copies Whether to wait for the copies to complete.
+  void releaseRelaidOutBlocks(bool wait_for_copies);
+
+  /// Pointers to the blocks processed by copyBlockDataAsync().
+  /// NOTE: The buffers are reused between calls, which is only safe because
+  /// the copies are ordered on the stream they're issued on.
+  device_vector<const void*> src_block_ptrs_device_;
+  device_vector<void*> dst_block_ptrs_device_;
+
+  /// State for allocating blocks on the GPU.
+  /// Written to gpu_allocated_indices_device_ for blocks which lost an
+  /// allocation race.
+  static constexpr int kFailedGpuAllocation = std::numeric_limits<int>::min();
+  /// Blocks on the device free list. They are owned here, such that entry i
+  /// owns gpu_free_list_[i], until syncCpuHash() moves them into blocks_.
+  mutable std::vector<typename BlockType::Ptr> gpu_free_list_blocks_;
+  device_vector<BlockType*> gpu_free_list_;
+  mutable bool gpu_free_list_dirty_ = false;
+  /// The number of blocks remaining on the device free list.
+  mutable unified_ptr<int> gpu_free_list_size_device_;
+  mutable unified_ptr<int> gpu_free_list_size_host_;
+  /// For each consumed free list entry, the index the block was allocated at.
+  mutable device_vector<Index3D> gpu_allocated_indices_device_;
+  mutable host_vector<Index3D> gpu_allocated_indices_host_;
+  /// Marks the end of the last allocation on the GPU.
+  mutable std::unique_ptr<CudaEvent> gpu_allocation_event_;
+  mutable bool cpu_hash_stale_ = false;
 };
 
 /// Specialization for BlockLayer that exclusively contains VoxelBlocks to
@@ -0,0 +1,152 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#pragma once
+
+#include <cuda_runtime.h>
+#include <stdint.h>
+#include <array>
+#include <memory>
+
+#include "nvblox/core/cuda_stream.h"
+#include "nvblox/core/types.h"
+#include "nvblox/gpu_hash/gpu_layer_view.h"
+#include "nvblox/map/layer.h"
+
+namespace nvblox {
+
+/// Describes a layer snapshot exported by a LayerIpcExporter. The struct is
+/// plain data, such that it can be sent as bytes to another process on the
+/// same machine (e.g. over a socket or shared memory), which opens it with a
+/// LayerIpcClient.
+///
+/// The exported buffer holds the indices of the blocks, followed by the
+/// blocks themselves:
+///   [Index3D x capacity][padding][BlockType x capacity]
+struct LayerIpcHandle {
+  /// The handle of the exported (device) buffer.
+  cudaIpcMemHandle_t mem_handle;
+  /// Increased on every export. Lets a client detect a new snapshot.
+  uint64_t generation = 0;
+  /// The number of blocks in the snapshot.
+  int64_t num_blocks = 0;
+  /// The offset of the first block in the buffer, in bytes.
+  uint64_t blocks_offset_bytes = 0;
+  /// sizeof(BlockType) of the exporter. Checked by the client.
+  uint64_t block_size_bytes = 0;
+  /// The metric size of a block in the layer.
+  float block_size = 0.0f;
+};
+
+/// Exports read-only snapshots of a layer to other processes through CUDA
+/// IPC.
+///
+/// The blocks of a layer are allocated one by one and the GPU hash holds
+/// pointers which are only valid in this process, so neither can be shared
+/// directly. An export instead gathers the blocks into a single device buffer
+/// (one device-to-device copy) which is shared. The client rebuilds a GPU
+/// hash over the shared blocks, after which it reads them without copies.
+///
+/// The exporter alternates between two buffers: A snapshot stays valid while
+/// the next one is exported, and is overwritten by the export after that.
+/// Clients should therefore be done with a snapshot within one export period.
+/// Buffers are reallocated (and have new handles) when the layer outgrows
+/// them.
+template <typename BlockType>
+class LayerIpcExporter {
+ public:
+  LayerIpcExporter() = default;
+  ~LayerIpcExporter();
+
+  LayerIpcExporter(const LayerIpcExporter& other) = delete;
+  LayerIpcExporter& operator=(const LayerIpcExporter& other) = delete;
+
+  /// Copies the current blocks of a layer into the next export buffer.
+  /// Synchronizes the stream, such that the snapshot is complete once the
+  /// handle is returned.
+  /// @param layer The layer to export. Must be in device or unified memory.
+  /// @param cuda_stream The stream on which to copy.
+  /// @return The handle to send to clients.
+  LayerIpcHandle exportLayer(const BlockLayer<BlockType>& layer,
+                             const CudaStream& cuda_stream);
+
+  /// The number of exports so far.
+  uint64_t generation() const { return generation_; }
+
+  /// The buffer of the latest export (in this process), or nullptr if
+  /// nothing was exported yet.
+  const void* latestBufferDevice() const;
+
+ private:
+  struct ExportBuffer {
+    void* buffer_device = nullptr;
+    int64_t capacity = 0;
+    cudaIpcMemHandle_t mem_handle;
+  };
+
+  // Makes sure the buffer has space for a number of blocks.
+  void reserve(int64_t num_blocks, ExportBuffer* buffer);
+
+  std::array<ExportBuffer, 2> buffers_;
+  uint64_t generation_ = 0;
+};
+
+/// Opens a layer snapshot exported by a LayerIpcExporter in another process,
+/// and provides a GPU hash over the shared blocks. The blocks are read in
+/// place; they're only valid for reading, and until the exporter reuses the
+/// buffer (see LayerIpcExporter).
+template <typename BlockType>
+class LayerIpcClient {
+ public:
+  /// Opens a snapshot and builds the GPU hash over its blocks.
+  /// @param handle The handle received from the exporting process.
+  /// @param cuda_stream The stream on which to build the hash.
+  LayerIpcClient(const LayerIpcHandle& handle, const CudaStream& cuda_stream);
+  ~LayerIpcClient();
+
+  LayerIpcClient(const LayerIpcClient& other) = delete;
+  LayerIpcClient& operator=(const LayerIpcClient& other) = delete;
+
+  /// The GPU hash over the shared blocks, e.g. to pass getHash().impl_ to a
+  /// kernel. The blocks must not be written.
+  const GPULayerView<BlockType>& gpu_layer_view() const {
+    return *gpu_layer_view_;
+  }
+
+  /// The generation of the snapshot, see LayerIpcHandle.
+  uint64_t generation() const { return handle_.generation; }
+  /// The number of blocks in the snapshot.
+  int64_t numBlocks() const { return handle_.num_blocks; }
+  /// The metric size of a block.
+  float block_size() const { return handle_.block_size; }
+
+ protected:
+  /// Builds the GPU hash over a buffer laid out as described in
+  /// LayerIpcHandle, which is already mapped into this process.
+  /// @param handle The handle describing the buffer.
+  /// @param buffer_device The mapped buffer.
+  /// @param cuda_stream The stream on which to build the hash.
+  /// @return The GPU hash.
+  static std::unique_ptr<GPULayerView<BlockType>> buildGpuLayerView(
+      const LayerIpcHandle& handle, const void* buffer_device,
+      const CudaStream& cuda_stream);
+
+ private:
+  LayerIpcHandle handle_;
+  void* buffer_device_ = nullptr;
+  std::unique_ptr<GPULayerView<BlockType>> gpu_layer_view_;
+};
+
+}  // namespace nvblox
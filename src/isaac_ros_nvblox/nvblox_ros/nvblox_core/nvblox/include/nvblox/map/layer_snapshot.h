@@ -0,0 +1,112 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "nvblox/core/cuda_event.h"
+#include "nvblox/core/cuda_stream.h"
+#include "nvblox/core/flat_hash_map.h"
+#include "nvblox/core/types.h"
+
+namespace nvblox {
+
+template <typename BlockType>
+class BlockLayer;
+
+/// A read-only view of the blocks of a BlockLayer, as they were when the
+/// snapshot was taken with BlockLayer::snapshot().
+///
+/// Taking a snapshot doesn't copy any block data. Blocks are shared with the
+/// layer until the layer is about to write or free them, at which point the
+/// layer first copies them into host memory owned by the snapshot
+/// (copy-before-write, see BlockLayer::prepareBlocksForWriteAsync()). A
+/// snapshot can therefore be read, e.g. saved or serialized, on another
+/// thread while mapping continues, and costs memory only for the blocks
+/// changed during its lifetime.
+///
+/// Blocks are read with copyBlockToHost(), which holds the snapshot lock for
+/// the duration of the copy, such that a block can't be written while it's
+/// read. Snapshots are cheap to copy; copies share the same state.
+template <typename BlockType>
+class BlockLayerSnapshot {
+ public:
+  BlockLayerSnapshot() = default;
+  ~BlockLayerSnapshot() = default;
+
+  /// Whether this snapshot was taken from a layer.
+  bool valid() const { return state_ != nullptr; }
+
+  /// The block size of the layer the snapshot was taken from.
+  float block_size() const;
+
+  /// The number of blocks in the snapshot.
+  size_t numBlocks() const;
+
+  /// The number of blocks the layer has copied into the snapshot, because
+  /// they were written or freed after the snapshot was taken.
+  size_t numCopiedBlocks() const;
+
+  /// The indices of the blocks in the snapshot.
+  std::vector<Index3D> getAllBlockIndices() const;
+
+  /// Whether a block is in the snapshot.
+  /// @param index The index of the block.
+  bool hasBlock(const Index3D& index) const;
+
+  /// Copies a block of the snapshot. Synchronizes the stream.
+  /// @param index The index of the block.
+  /// @param block_ptr The (host) block to copy to.
+  /// @param cuda_stream The stream on which to copy.
+  /// @return Whether the block is in the snapshot.
+  bool copyBlockToHost(const Index3D& index, BlockType* block_ptr,
+                       const CudaStream& cuda_stream) const;
+
+  /// Copies all blocks of the snapshot into a layer, e.g. one in host memory
+  /// to serialize it. The blocks are copied one by one, such that the layer
+  /// the snapshot was taken from is never held up for long.
+  /// @param layer_ptr The (empty) layer to copy to.
+  /// @param cuda_stream The stream on which to copy.
+  void copyToLayer(BlockLayer<BlockType>* layer_ptr,
+                   const CudaStream& cuda_stream) const;
+
+ private:
+  friend class BlockLayer<BlockType>;
+
+  struct State {
+    // Guards both maps, and the transfer of blocks between them.
+    mutable std::mutex mutex;
+    float block_size = 0.0f;
+    // Blocks which are still shared with (owned by) the layer.
+    Index3DFlatHashMap<const BlockType*> shared_blocks;
+    // Blocks copied since the snapshot was taken (in host memory).
+    Index3DFlatHashMap<typename BlockType::Ptr> copied_blocks;
+    // Recorded after the last copy into copied_blocks, which readers wait
+    // for. The copies are queued on the (asynchronous) write path.
+    CudaEvent copies_event;
+  };
+
+  explicit BlockLayerSnapshot(std::shared_ptr<State> state)
+      : state_(std::move(state)) {}
+
+  std::shared_ptr<State> state_;
+};
+
+}  // namespace nvblox
+
+#include "nvblox/map/internal/impl/layer_snapshot_impl.h"
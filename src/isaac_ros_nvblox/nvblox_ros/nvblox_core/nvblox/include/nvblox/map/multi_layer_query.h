@@ -0,0 +1,59 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#pragma once
+
+#include "nvblox/core/cuda_stream.h"
+#include "nvblox/core/types.h"
+#include "nvblox/core/unified_vector.h"
+#include "nvblox/map/layer_cake.h"
+#include "nvblox/map/voxels.h"
+
+namespace nvblox {
+
+/// The voxels of several layers at a set of query points, as a struct of
+/// arrays. Each requested layer fills its voxels and success flags, with one
+/// element per query point. The vectors of layers not queried are empty.
+struct MultiLayerQueryResults {
+  device_vector<TsdfVoxel> tsdf_voxels;
+  device_vector<bool> tsdf_success_flags;
+  device_vector<EsdfVoxel> esdf_voxels;
+  device_vector<bool> esdf_success_flags;
+  device_vector<ColorVoxel> color_voxels;
+  device_vector<bool> color_success_flags;
+  device_vector<OccupancyVoxel> occupancy_voxels;
+  device_vector<bool> occupancy_success_flags;
+  device_vector<FreespaceVoxel> freespace_voxels;
+  device_vector<bool> freespace_success_flags;
+};
+
+/// Gets the voxels of several layers at a set of points in a single kernel.
+/// The block and voxel index of each point are computed once and are then
+/// looked up in the GPU hash of each requested layer. This requires all
+/// layers to have the same block size, which holds within a LayerCake.
+/// Requested layers which are not in the cake are skipped, as are mesh
+/// layers, which have no voxels.
+/// @param layers The layers to query.
+/// @param positions_L The query points in layer frame (on the device).
+/// @param layer_type_bitmask The layers to query.
+/// @param results The voxels of the requested layers.
+/// @param cuda_stream The stream to query on. Synchronized on return.
+void queryLayersGPU(const LayerCake& layers,
+                    const device_vector<Vector3f>& positions_L,
+                    const LayerTypeBitMask layer_type_bitmask,
+                    MultiLayerQueryResults* results,
+                    const CudaStream& cuda_stream);
+
+}  // namespace nvblox
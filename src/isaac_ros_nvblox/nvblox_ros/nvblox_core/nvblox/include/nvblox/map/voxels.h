@@ -16,34 +16,84 @@ limitations under the License.
 #pragma once
 
 #include <Eigen/Core>
+#include <cstdint>
 
 #include "nvblox/core/color.h"
 #include "nvblox/core/time.h"
 
+#ifdef NVBLOX_HALF_PRECISION_TSDF
+#include "nvblox/core/half_float.h"
+#endif
+
+#ifdef NVBLOX_COMPACT_COLOR_VOXEL
+#include "nvblox/core/packed_color.h"
+#endif
+
+#ifdef NVBLOX_QUANTIZED_OCCUPANCY
+#include "nvblox/core/quantized_log_odds.h"
+#endif
+
+#ifdef NVBLOX_COMPACT_FREESPACE_VOXEL
+#include "nvblox/core/compact_time.h"
+#endif
+
 namespace nvblox {
 
 /// A voxel storing TSDF (truncated signed distance field) values.
+/// When building with USE_HALF_PRECISION_TSDF the members are stored as
+/// (saturating) 16-bit floats, halving the size of a TsdfBlock. In that case
+/// the voxel is 4-byte aligned such that it can be updated with a single
+/// 32-bit atomic.
+#ifdef NVBLOX_HALF_PRECISION_TSDF
+struct alignas(4) TsdfVoxel {
+  using ScalarType = HalfFloat;
+#else
 struct TsdfVoxel {
+  using ScalarType = float;
+#endif
   __host__ __device__ TsdfVoxel() : distance(0.0f), weight(0.0f) {}
   /// Signed projective distance of the voxel from a surface.
-  float distance;
+  ScalarType distance;
   /// How many observations/how confident we are in this observation.
-  float weight;
+  ScalarType weight;
 };
 
 /// The freespace voxels and layer including its updating is based on
 /// the dynablox paper: https://ieeexplore.ieee.org/document/10218983
+/// When building with USE_COMPACT_FREESPACE_VOXEL the timestamp is stored in
+/// 32 bits (see CompactTimestamp) and the duration in (saturating) 16 bits,
+/// shrinking the voxel from 24 to 8 bytes. Timestamps then have to be
+/// compared through timeSinceLastOccupied().
 struct FreespaceVoxel {
+#ifdef NVBLOX_COMPACT_FREESPACE_VOXEL
+  using TimestampType = CompactTimestamp;
+  using DurationType = CompactDuration;
+#else
+  using TimestampType = Time;
+  using DurationType = Time;
+#endif
   __host__ __device__ FreespaceVoxel()
-      : last_occupied_timestamp_ms(0),
-        consecutive_occupancy_duration_ms(0),
+      : last_occupied_timestamp_ms(Time(0)),
+        consecutive_occupancy_duration_ms(Time(0)),
         is_high_confidence_freespace(false) {}
+
+  /// The time elapsed since the voxel was last seen occupied.
+  /// @param current_time_ms The current time, not before the last occupancy.
+  /// @return The elapsed time in ms.
+  __host__ __device__ Time timeSinceLastOccupied(Time current_time_ms) const {
+#ifdef NVBLOX_COMPACT_FREESPACE_VOXEL
+    return last_occupied_timestamp_ms.elapsedSince(current_time_ms);
+#else
+    return current_time_ms - last_occupied_timestamp_ms;
+#endif
+  }
+
   /// Timestamp in ms when the voxel was last seen occupied.
   /// Corresponds to t_o in dynablox.
-  Time last_occupied_timestamp_ms;
+  TimestampType last_occupied_timestamp_ms;
   /// Duration of consecutive occupancy in ms. Used to change voxel from high
   /// confidence freespace back to occupied. Corresponds to t_d in dynablox.
-  Time consecutive_occupancy_duration_ms;
+  DurationType consecutive_occupancy_duration_ms;
   /// Whether a voxel belongs to the high confidence free space.
   /// Corresponds to f in dynablox.
   bool is_high_confidence_freespace;
@@ -71,18 +121,182 @@ struct EsdfVoxel {
   bool is_site;
 };
 
+/// A compact (8 byte) alternative to the EsdfVoxel above (20 bytes).
+/// The parent direction is stored as int8 offsets and the three flags are
+/// packed into a single byte. Because parent directions never exceed the
+/// maximum ESDF distance, this voxel can represent ESDFs with a maximum
+/// distance of up to kMaxParentOffsetVox voxels.
+struct CompactEsdfVoxel {
+  /// The largest parent offset (per axis) that can be represented.
+  static constexpr int kMaxParentOffsetVox = 127;
+
+  __host__ __device__ CompactEsdfVoxel()
+      : squared_distance_vox(0.0f), parent_offset{0, 0, 0}, flags(0) {}
+
+  /// Direction towards the parent, *in units of voxels*.
+  __host__ __device__ Eigen::Vector3i parent_direction() const {
+    return Eigen::Vector3i(parent_offset[0], parent_offset[1],
+                           parent_offset[2]);
+  }
+  __host__ __device__ void parent_direction(
+      const Eigen::Vector3i& parent_direction) {
+    parent_offset[0] = static_cast<int8_t>(parent_direction.x());
+    parent_offset[1] = static_cast<int8_t>(parent_direction.y());
+    parent_offset[2] = static_cast<int8_t>(parent_direction.z());
+  }
+  __host__ __device__ bool has_parent_direction() const {
+    return (parent_offset[0] != 0) || (parent_offset[1] != 0) ||
+           (parent_offset[2] != 0);
+  }
+
+  /// Whether this voxel is inside the surface or not.
+  __host__ __device__ bool is_inside() const { return flags & kIsInsideBit; }
+  __host__ __device__ void is_inside(bool value) {
+    setFlag(kIsInsideBit, value);
+  }
+  /// Whether this voxel has been observed.
+  __host__ __device__ bool observed() const { return flags & kObservedBit; }
+  __host__ __device__ void observed(bool value) {
+    setFlag(kObservedBit, value);
+  }
+  /// Whether this voxel is a "site": i.e., near the zero-crossing and is
+  /// eligible to be considered a parent.
+  __host__ __device__ bool is_site() const { return flags & kIsSiteBit; }
+  __host__ __device__ void is_site(bool value) {
+    setFlag(kIsSiteBit, value);
+  }
+
+  /// Expand to a full EsdfVoxel, for example for use in queries or output.
+  __host__ __device__ EsdfVoxel toEsdfVoxel() const {
+    EsdfVoxel voxel;
+    voxel.squared_distance_vox = squared_distance_vox;
+    voxel.parent_direction = parent_direction();
+    voxel.is_inside = is_inside();
+    voxel.observed = observed();
+    voxel.is_site = is_site();
+    return voxel;
+  }
+
+  /// Cached squared distance towards the parent.
+  float squared_distance_vox;
+  /// Direction towards the parent, *in units of voxels*, one int8 per axis.
+  int8_t parent_offset[3];
+  /// Packed is_inside/observed/is_site flags.
+  uint8_t flags;
+
+ private:
+  static constexpr uint8_t kIsInsideBit = 1 << 0;
+  static constexpr uint8_t kObservedBit = 1 << 1;
+  static constexpr uint8_t kIsSiteBit = 1 << 2;
+
+  __host__ __device__ void setFlag(uint8_t bit, bool value) {
+    flags = value ? (flags | bit) : (flags & ~bit);
+  }
+};
+
 /// Voxel that stores the color near the surface.
+/// When building with USE_COMPACT_COLOR_VOXEL the color is stored without
+/// alpha and the weight as an 8-bit fixed point value (see QuantizedWeight),
+/// shrinking the voxel from 8 to 4 bytes. Both members convert to and from
+/// Color and float respectively.
+#ifdef NVBLOX_COMPACT_COLOR_VOXEL
+struct alignas(4) ColorVoxel {
+  using ColorType = PackedRgb;
+  using WeightType = QuantizedWeight;
+#else
 struct ColorVoxel {
+  using ColorType = Color;
+  using WeightType = float;
+#endif
   __host__ __device__ ColorVoxel() : color(Color::Gray()), weight(0.0f) {}
   /// The color!
-  Color color;
+  ColorType color;
   /// How many observations/how confident we are in this observation.
-  float weight;
+  WeightType weight;
 };
 
+/// Voxel that stores the log-odds of occupancy.
+/// When building with USE_QUANTIZED_OCCUPANCY the log-odds are stored as a
+/// (saturating) 16-bit fixed point value, halving the size of an
+/// OccupancyBlock.
 struct OccupancyVoxel {
+#ifdef NVBLOX_QUANTIZED_OCCUPANCY
+  using ScalarType = QuantizedLogOdds;
+#else
+  using ScalarType = float;
+#endif
   __host__ __device__ OccupancyVoxel() : log_odds(0.0f) {}
-  float log_odds;
+  ScalarType log_odds;
+};
+
+/// A compact (1 byte) voxel storing a class label, e.g. person, forklift or
+/// cart, integrated from multi-class masks alongside the TSDF or occupancy
+/// (see ProjectiveIntegrator::integrateFrame() with a label image). Label 0 is
+/// the background (no class).
+///
+/// The label (4 bits) is decided by a saturating vote (4 bits of confidence):
+/// observations of the voxel's label increase the confidence, observations of
+/// other labels and of free space decrease it, and the label is replaced once
+/// the confidence reached zero.
+struct LabelVoxel {
+  /// The number of labels which can be stored, including the background.
+  static constexpr int kNumLabels = 16;
+  static constexpr int kMaxConfidence = 15;
+
+  __host__ __device__ LabelVoxel() : label_and_confidence(0) {}
+
+  /// The label, 0 if the voxel has none.
+  __host__ __device__ uint8_t label() const {
+    return label_and_confidence & kLabelMask;
+  }
+  /// The number of votes for the label (saturated at kMaxConfidence).
+  __host__ __device__ int confidence() const {
+    return label_and_confidence >> kConfidenceShift;
+  }
+  /// Whether the voxel has a (non-background) label.
+  __host__ __device__ bool has_label() const {
+    return label() != 0 && confidence() > 0;
+  }
+
+  /// Vote for a label. Labels of at least kNumLabels are ignored.
+  __host__ __device__ void observeLabel(uint8_t observed_label) {
+    if (observed_label >= kNumLabels) {
+      return;
+    }
+    const int current_confidence = confidence();
+    if (current_confidence == 0) {
+      set(observed_label, 1);
+    } else if (observed_label == label()) {
+      set(observed_label, current_confidence < kMaxConfidence
+                              ? current_confidence + 1
+                              : kMaxConfidence);
+    } else {
+      set(label(), current_confidence - 1);
+    }
+  }
+
+  /// Vote against the label, as the voxel was observed to be free.
+  __host__ __device__ void observeFree() {
+    const int current_confidence = confidence();
+    if (current_confidence <= 1) {
+      set(0, 0);
+    } else {
+      set(label(), current_confidence - 1);
+    }
+  }
+
+  /// The label in the low, and the confidence in the high 4 bits.
+  uint8_t label_and_confidence;
+
+ private:
+  static constexpr uint8_t kLabelMask = 0x0F;
+  static constexpr int kConfidenceShift = 4;
+
+  __host__ __device__ void set(uint8_t new_label, int new_confidence) {
+    label_and_confidence =
+        static_cast<uint8_t>((new_confidence << kConfidenceShift) |
+                             (new_label & kLabelMask));
+  }
 };
 
 }  // namespace nvblox
@@ -0,0 +1,138 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "nvblox/core/cuda_stream.h"
+#include "nvblox/core/hash.h"
+#include "nvblox/core/unified_vector.h"
+#include "nvblox/map/layer_cake.h"
+#include "nvblox/map_saving/internal/layer_type_register.h"
+#include "nvblox/serialization/internal/serialization_gpu.h"
+
+namespace nvblox {
+
+/// Class to write and load a layer cake in a binary format which is designed
+/// to be memory mapped.
+///
+/// In contrast to the SQLite format (see Serializer), the voxels of all blocks
+/// of a layer are stored contiguously. Loading maps the file, allocates all
+/// blocks at once and transfers the voxels to the device in a few large
+/// copies, rather than running a query and a copy per block.
+///
+/// File layout (little endian, sections 8-byte aligned):
+///   Header:      magic "NVBLXMAP", uint32 version, uint32 num_layers,
+///                uint64 offset of the layer table.
+///   Per layer:   Index table of num_blocks * (int32 x, y, z),
+///                followed by num_blocks * num_bytes_per_block voxel bytes.
+///   Layer table: One entry per layer with its name, block size, number of
+///                blocks, number of bytes per block and section offsets.
+class BinaryMapSerializer {
+ public:
+  static constexpr uint32_t kVersion = 1;
+
+  /// Common types are automatically registered.
+  BinaryMapSerializer();
+  virtual ~BinaryMapSerializer() = default;
+
+  /// Write out a layer cake to a file, return success. Only layers which
+  /// support batched serialization are written.
+  bool writeLayerCake(const std::string& filename, const LayerCake& cake,
+                      const CudaStream& cuda_stream);
+
+  /// Load a layer cake of a given memory type from a file.
+  /// @return The loaded cake, or an empty cake on failure.
+  LayerCake loadLayerCake(const std::string& filename, MemoryType memory_type,
+                          const CudaStream& cuda_stream);
+
+  /// Whether the file starts with the magic of this format.
+  static bool isBinaryMapFile(const std::string& filename);
+
+ private:
+  ScatterCopierGpu scatter_copier_;
+};
+
+/// A read-only memory mapping of a file. Defined in the translation unit.
+class MappedFile;
+
+/// Class which loads the blocks of a binary map file (see BinaryMapSerializer)
+/// on demand.
+///
+/// Opening a file only reads its block index tables, the voxels stay on disk
+/// until the blocks are requested through loadBlocks(). Memory use and load
+/// time therefore scale with the region of the map in use.
+class LazyBinaryMapLoader {
+ public:
+  LazyBinaryMapLoader();
+  virtual ~LazyBinaryMapLoader();
+
+  /// Map a file and read its block index tables, return success.
+  bool open(const std::string& filename);
+
+  /// Close the file and forget all unloaded blocks.
+  void close();
+
+  /// Whether a file is open.
+  bool valid() const;
+
+  /// Create a layer cake containing an empty layer for each layer in the file.
+  LayerCake createLayerCake(MemoryType memory_type) const;
+
+  /// Load the blocks at the indices that are still on disk into the matching
+  /// layers of the cake. Each block is loaded at most once.
+  /// @param indices The indices of the blocks to load.
+  /// @param cake The cake to load into. Usually from createLayerCake().
+  /// @param cuda_stream The stream on which to perform the copies.
+  /// @return The indices of the blocks that were loaded.
+  std::vector<Index3D> loadBlocks(const std::vector<Index3D>& indices,
+                                  LayerCake* cake,
+                                  const CudaStream& cuda_stream);
+
+  /// Forget blocks still on disk, such that they will never be loaded.
+  void discardBlocks(const std::vector<Index3D>& indices);
+
+  /// Get the indices of blocks that are still on disk in any of the layers.
+  std::vector<Index3D> getUnloadedBlockIndices() const;
+
+  /// The number of blocks which are still on disk (in the largest layer).
+  size_t numUnloadedBlocks() const;
+
+  /// The block size of the layers in the file.
+  float block_size() const;
+
+ private:
+  struct UnloadedLayer {
+    std::string name;
+    float block_size;
+    size_t num_bytes_per_block;
+    // Start of the voxel payload in the mapped file.
+    const Byte* payload;
+    // Position in the payload of each block still on disk.
+    Index3DHashMapType<uint64_t>::type unloaded_blocks;
+  };
+
+  std::unique_ptr<MappedFile> file_;
+  std::vector<UnloadedLayer> layers_;
+
+  host_vector<Byte> staging_host_;
+  ScatterCopierGpu scatter_copier_;
+};
+
+}  // namespace nvblox
@@ -0,0 +1,149 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <future>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "nvblox/core/cuda_stream.h"
+#include "nvblox/core/hash.h"
+#include "nvblox/map/layer_cake.h"
+#include "nvblox/map_saving/internal/layer_type_register.h"
+
+namespace nvblox {
+
+/// Class to incrementally checkpoint a layer cake to a log-structured file.
+///
+/// Each checkpoint appends a segment containing only the blocks that changed
+/// since the previous checkpoint. Removed blocks are recorded with an empty
+/// payload. A segment only becomes valid once its commit trailer is written,
+/// such that a crash during a checkpoint leaves the previous checkpoints
+/// loadable. When the file grows beyond compaction_ratio() times the size of
+/// the live blocks, it is compacted in the background: the live blocks are
+/// rewritten into a new file which atomically replaces the log.
+///
+/// File layout (little endian):
+///   Header:   magic "NVBLXLOG", uint32 version, uint32 reserved.
+///   Segments: uint32 segment magic, uint32 num_layers, then per layer:
+///             name, block size and number of records, followed by records
+///             of (int32 x, y, z, uint32 num_bytes, payload). The segment ends
+///             with a commit trailer holding the segment offset.
+class CheckpointLog {
+ public:
+  static constexpr uint32_t kVersion = 1;
+  static constexpr float kDefaultCompactionRatio = 2.0f;
+
+  /// Common types are automatically registered.
+  CheckpointLog();
+  /// Waits for a running compaction.
+  virtual ~CheckpointLog();
+
+  CheckpointLog(const CheckpointLog&) = delete;
+  CheckpointLog& operator=(const CheckpointLog&) = delete;
+
+  /// Create (or truncate) a log file for appending checkpoints.
+  bool open(const std::string& filename);
+
+  /// Close the file, after waiting for a running compaction.
+  void close();
+
+  /// Whether a file is open.
+  bool valid() const;
+
+  /// The name of the open file.
+  const std::string& filename() const { return filename_; }
+
+  /// Append a checkpoint of the blocks at the passed indices in all layers of
+  /// the cake. Indices not allocated in a layer are recorded as removed. The
+  /// data is flushed to disk before returning.
+  /// @param cake The cake to checkpoint.
+  /// @param changed_blocks The blocks changed since the last checkpoint.
+  /// @param cuda_stream The stream on which to serialize the blocks.
+  /// @return True if the checkpoint was committed.
+  bool appendCheckpoint(const LayerCake& cake,
+                        const std::vector<Index3D>& changed_blocks,
+                        const CudaStream& cuda_stream);
+
+  /// Append a checkpoint of all blocks of the cake.
+  bool appendFullCheckpoint(const LayerCake& cake,
+                            const CudaStream& cuda_stream);
+
+  /// Start compacting the log in the background. Does nothing if a
+  /// compaction is running already.
+  void compactAsync();
+
+  /// Block until a running compaction has finished.
+  void waitForCompaction() const;
+
+  /// The current size of the file in bytes.
+  uint64_t num_bytes() const;
+
+  /// The size of the live (latest, non-removed) blocks in bytes.
+  uint64_t num_live_bytes() const;
+
+  /// The ratio between the file size and the live block size above which the
+  /// log is compacted after a checkpoint. Values <= 1 disable compaction.
+  float compaction_ratio() const { return compaction_ratio_; }
+  void compaction_ratio(float compaction_ratio) {
+    compaction_ratio_ = compaction_ratio;
+  }
+
+  /// Whether the file starts with the magic of this format.
+  static bool isCheckpointLogFile(const std::string& filename);
+
+  /// Load the latest committed state of a log file into a layer cake.
+  /// @return The loaded cake, or an empty cake on failure.
+  static LayerCake loadLayerCake(const std::string& filename,
+                                 MemoryType memory_type,
+                                 const CudaStream& cuda_stream);
+
+  /// Location of a block record's payload in the file.
+  struct BlockRecord {
+    uint64_t payload_offset;
+    uint32_t num_bytes;
+  };
+  /// The live blocks of a layer.
+  struct LayerIndex {
+    float block_size = 0.0f;
+    Index3DHashMapType<BlockRecord>::type blocks;
+  };
+  /// Live blocks by layer name.
+  using LogIndex = std::map<std::string, LayerIndex>;
+
+ private:
+  // Called with mutex_ held.
+  bool appendSegment(const LayerCake& cake,
+                     const std::vector<Index3D>& changed_blocks,
+                     const CudaStream& cuda_stream);
+  void compact();
+
+  std::string filename_;
+  std::FILE* file_ = nullptr;
+  uint64_t num_bytes_ = 0;
+  LogIndex index_;
+  float compaction_ratio_ = kDefaultCompactionRatio;
+
+  // Guards the file and the index against the background compaction.
+  mutable std::mutex mutex_;
+  mutable std::future<void> compaction_future_;
+};
+
+}  // namespace nvblox
@@ -50,6 +50,35 @@ LayerSerializationFunctions bindDefaultFunctions() {
       };
   layer_functions.serialize_data = lambda_serialize_data;
 
+  LayerSerializationFunctions::SerializeLayerDataBatchFunction
+      lambda_serialize_data_batch =
+          [](const BaseLayer* base_layer, const std::vector<Index3D>& indices,
+             const LayerSerializationFunctions::WriteLayerDataFunction&
+                 write_data,
+             const CudaStream& cuda_stream) {
+            const LayerType& layer =
+                *dynamic_cast<const LayerType*>(base_layer);
+
+            return serializeLayerDataInBatches(layer, indices, write_data,
+                                               cuda_stream);
+          };
+  layer_functions.serialize_data_batch = lambda_serialize_data_batch;
+
+  LayerSerializationFunctions::SerializeLayerDataBatchFunction
+      lambda_serialize_compressed_data_batch =
+          [](const BaseLayer* base_layer, const std::vector<Index3D>& indices,
+             const LayerSerializationFunctions::WriteLayerDataFunction&
+                 write_data,
+             const CudaStream& cuda_stream) {
+            const LayerType& layer =
+                *dynamic_cast<const LayerType*>(base_layer);
+
+            return serializeCompressedLayerDataInBatches(
+                layer, indices, write_data, cuda_stream);
+          };
+  layer_functions.serialize_compressed_data_batch =
+      lambda_serialize_compressed_data_batch;
+
   LayerSerializationFunctions::ConstructLayerFunction lambda_construct_layer =
       [](MemoryType memory_type, const LayerParameterStruct& layer_params) {
         std::unique_ptr<LayerType> layer =
@@ -68,6 +97,60 @@ LayerSerializationFunctions bindDefaultFunctions() {
       };
   layer_functions.add_data = lambda_add_data;
 
+  LayerSerializationFunctions::AddDataToLayerFunction
+      lambda_add_compressed_data =
+          [](const Index3D& index, const std::vector<Byte>& data,
+             BaseLayer* base_layer, const CudaStream& cuda_stream) {
+            LayerType* layer = dynamic_cast<LayerType*>(base_layer);
+
+            addCompressedDataToLayer(index, data, layer, cuda_stream);
+          };
+  layer_functions.add_compressed_data = lambda_add_compressed_data;
+
+  LayerSerializationFunctions::AllocateLayerBlocksFunction
+      lambda_allocate_blocks =
+          [](const std::vector<Index3D>& indices, size_t num_bytes_per_block,
+             BaseLayer* base_layer, std::vector<Byte*>* block_data,
+             const CudaStream& cuda_stream) {
+            LayerType* layer = dynamic_cast<LayerType*>(base_layer);
+
+            return allocateLayerBlocks(indices, num_bytes_per_block, layer,
+                                       block_data, cuda_stream);
+          };
+  layer_functions.allocate_blocks = lambda_allocate_blocks;
+
+  return layer_functions;
+}
+
+// Mesh blocks aren't voxel blocks, so only the non-batched functions are
+// available.
+inline LayerSerializationFunctions bindMeshLayerFunctions() {
+  LayerSerializationFunctions layer_functions;
+  layer_functions.serialize_params = [](const BaseLayer* base_layer) {
+    return serializeLayerParameters(
+        *dynamic_cast<const MeshLayer*>(base_layer));
+  };
+  layer_functions.get_data_indices = [](const BaseLayer* base_layer) {
+    return getLayerDataIndices(*dynamic_cast<const MeshLayer*>(base_layer));
+  };
+  layer_functions.serialize_data = [](const BaseLayer* base_layer,
+                                      const Index3D& index,
+                                      const CudaStream& cuda_stream) {
+    return serializeLayerDataAtIndex(
+        *dynamic_cast<const MeshLayer*>(base_layer), index, cuda_stream);
+  };
+  layer_functions.construct_layer = [](MemoryType memory_type,
+                                       const LayerParameterStruct& params)
+      -> std::unique_ptr<BaseLayer> {
+    return deserializeMeshLayerParameters(memory_type, params);
+  };
+  layer_functions.add_data = [](const Index3D& index,
+                                const std::vector<Byte>& data,
+                                BaseLayer* base_layer,
+                                const CudaStream& cuda_stream) {
+    addDataToLayer(index, data, dynamic_cast<MeshLayer*>(base_layer),
+                   cuda_stream);
+  };
   return layer_functions;
 }
 
@@ -80,6 +163,8 @@ void registerCommonTypes() {
                                   bindDefaultFunctions<ColorLayer>());
   LayerTypeRegister::registerType("occupancy_layer", typeid(OccupancyLayer),
                                   bindDefaultFunctions<OccupancyLayer>());
+  LayerTypeRegister::registerType("mesh_layer", typeid(MeshLayer),
+                                  bindMeshLayerFunctions());
 }
 
 }  // namespace nvblox
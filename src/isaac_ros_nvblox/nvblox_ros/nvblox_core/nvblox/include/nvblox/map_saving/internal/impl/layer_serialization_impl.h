@@ -48,6 +48,105 @@ std::vector<Byte> serializeLayerDataAtIndex(
   return serializeBlock(block, cuda_stream);
 }
 
+template <typename VoxelType>
+bool serializeLayerDataInBatches(
+    const VoxelBlockLayer<VoxelType>& layer,
+    const std::vector<Index3D>& indices,
+    const LayerSerializationFunctions::WriteLayerDataFunction& write_data,
+    const CudaStream& cuda_stream) {
+  using LayerType = VoxelBlockLayer<VoxelType>;
+  using BlockType = typename LayerType::BlockType;
+  // 2048 TSDF blocks are 8MB.
+  constexpr size_t kNumBlocksPerBatch = 2048;
+  constexpr int kNumBuffers = 2;
+
+  // Double buffering: batch i is serialized into buffer i % kNumBuffers.
+  struct Buffer {
+    LayerSerializerGpuInternal<LayerType, VoxelType> serializer;
+    std::vector<Index3D> indices;
+    host_vector<VoxelType> voxels;
+    host_vector<int32_t> offsets;
+  };
+  Buffer buffers[kNumBuffers];
+
+  auto get_data_and_size =
+      [](const BlockType* block) -> std::pair<const VoxelType*, int> {
+    if (block == nullptr) {
+      return {nullptr, 0};
+    }
+    return {&block->voxels[0][0][0], BlockType::kNumVoxels};
+  };
+  auto serialize_batch_async = [&](const size_t batch_idx) {
+    Buffer& buffer = buffers[batch_idx % kNumBuffers];
+    const size_t start = batch_idx * kNumBlocksPerBatch;
+    const size_t end = std::min(start + kNumBlocksPerBatch, indices.size());
+    buffer.indices.assign(indices.begin() + start, indices.begin() + end);
+    buffer.serializer.serializeAsync(layer, buffer.indices, buffer.voxels,
+                                     buffer.offsets, get_data_and_size,
+                                     cuda_stream);
+  };
+  auto write_batch = [&](const size_t batch_idx) -> bool {
+    const Buffer& buffer = buffers[batch_idx % kNumBuffers];
+    for (size_t i = 0; i < buffer.indices.size(); ++i) {
+      const int32_t num_voxels = buffer.offsets[i + 1] - buffer.offsets[i];
+      const Byte* data =
+          reinterpret_cast<const Byte*>(buffer.voxels.data() +
+                                        buffer.offsets[i]);
+      if (!write_data(buffer.indices[i], data,
+                      num_voxels * sizeof(VoxelType))) {
+        return false;
+      }
+    }
+    return true;
+  };
+
+  const size_t num_batches =
+      (indices.size() + kNumBlocksPerBatch - 1) / kNumBlocksPerBatch;
+  if (num_batches == 0) {
+    return true;
+  }
+  serialize_batch_async(0);
+  for (size_t batch_idx = 0; batch_idx < num_batches; ++batch_idx) {
+    // Wait for this batch.
+    cuda_stream.synchronize();
+    // Start on the next batch on the GPU while we write this one.
+    if (batch_idx + 1 < num_batches) {
+      serialize_batch_async(batch_idx + 1);
+    }
+    if (!write_batch(batch_idx)) {
+      cuda_stream.synchronize();
+      return false;
+    }
+  }
+  return true;
+}
+
+template <typename VoxelType>
+bool serializeCompressedLayerDataInBatches(
+    const VoxelBlockLayer<VoxelType>& layer,
+    const std::vector<Index3D>& indices,
+    const LayerSerializationFunctions::WriteLayerDataFunction& write_data,
+    const CudaStream& cuda_stream) {
+  constexpr size_t kNumBlocksPerBatch = 2048;
+  LayerCompressorGpuInternal<VoxelBlockLayer<VoxelType>, VoxelType> compressor;
+  host_vector<uint8_t> compressed;
+  host_vector<int32_t> offsets;
+  std::vector<Index3D> batch_indices;
+  for (size_t start = 0; start < indices.size(); start += kNumBlocksPerBatch) {
+    const size_t end = std::min(start + kNumBlocksPerBatch, indices.size());
+    batch_indices.assign(indices.begin() + start, indices.begin() + end);
+    compressor.compress(layer, batch_indices, compressed, offsets,
+                        cuda_stream);
+    for (size_t i = 0; i < batch_indices.size(); ++i) {
+      if (!write_data(batch_indices[i], compressed.data() + offsets[i],
+                      offsets[i + 1] - offsets[i])) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
 template <typename VoxelType>
 std::unique_ptr<VoxelBlockLayer<VoxelType>> deserializeLayerParameters(
     MemoryType memory_type, const LayerParameterStruct& params) {
@@ -75,4 +174,49 @@ void addDataToLayer(const Index3D& index, const std::vector<Byte>& data,
   deserializeBlock(data, block, cuda_stream);
 }
 
+template <typename VoxelType>
+void addCompressedDataToLayer(const Index3D& index,
+                              const std::vector<Byte>& data,
+                              VoxelBlockLayer<VoxelType>* layer,
+                              const CudaStream& cuda_stream) {
+  using BlockType = typename VoxelBlockLayer<VoxelType>::BlockType;
+  std::vector<VoxelType> voxels(BlockType::kNumVoxels);
+  if (!decompressVoxelBlock<VoxelType, BlockType::kNumVoxels>(
+          data.data(), data.size(), voxels.data())) {
+    LOG(ERROR) << "Malformed compressed block at index: "
+               << index.transpose();
+    return;
+  }
+  auto block = layer->allocateBlockAtIndexAsync(index, cuda_stream);
+  checkCudaErrors(cudaMemcpyAsync(block->voxels, voxels.data(),
+                                  sizeof(block->voxels), cudaMemcpyDefault,
+                                  cuda_stream));
+  // The voxels go out of scope.
+  cuda_stream.synchronize();
+}
+
+template <typename VoxelType>
+bool allocateLayerBlocks(const std::vector<Index3D>& indices,
+                         size_t num_bytes_per_block,
+                         VoxelBlockLayer<VoxelType>* layer,
+                         std::vector<Byte*>* block_data,
+                         const CudaStream& cuda_stream) {
+  CHECK_NOTNULL(block_data);
+  using BlockType = typename VoxelBlockLayer<VoxelType>::BlockType;
+  if (num_bytes_per_block != BlockType::kNumVoxels * sizeof(VoxelType)) {
+    LOG(ERROR) << "Block size mismatch. Expected "
+               << BlockType::kNumVoxels * sizeof(VoxelType)
+               << " bytes per block, got " << num_bytes_per_block;
+    return false;
+  }
+  layer->allocateBlocksAtIndices(indices, cuda_stream);
+  block_data->resize(indices.size());
+  for (size_t i = 0; i < indices.size(); ++i) {
+    typename BlockType::Ptr block = layer->getBlockAtIndex(indices[i]);
+    CHECK(block);
+    (*block_data)[i] = reinterpret_cast<Byte*>(&block->voxels[0][0][0]);
+  }
+  return true;
+}
+
 }  // namespace nvblox
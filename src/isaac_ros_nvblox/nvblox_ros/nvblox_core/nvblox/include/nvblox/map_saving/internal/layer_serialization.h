@@ -15,15 +15,19 @@ limitations under the License.
 */
 #pragma once
 
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <vector>
 
 #include "nvblox/core/types.h"
 #include "nvblox/core/unified_ptr.h"
+#include "nvblox/map/common_names.h"
 #include "nvblox/map/layer.h"
 #include "nvblox/map_saving/internal/block_serialization.h"
 #include "nvblox/map_saving/internal/layer_type_register.h"
+#include "nvblox/serialization/internal/serialization_gpu.h"
+#include "nvblox/serialization/internal/voxel_block_compression.h"
 
 namespace nvblox {
 
@@ -54,6 +58,37 @@ std::vector<Byte> serializeLayerDataAtIndex(
     const VoxelBlockLayer<VoxelType>& layer, const Index3D& index,
     const CudaStream& cuda_stream);
 
+// Mesh specializations. Each mesh block is stored as the sizes of its
+// vertices, normals, colors and triangles (as uint32_t), followed by the
+// elements of each of these vectors.
+LayerParameterStruct serializeLayerParameters(const MeshLayer& layer);
+
+std::vector<Index3D> getLayerDataIndices(const MeshLayer& layer);
+
+std::vector<Byte> serializeLayerDataAtIndex(const MeshLayer& layer,
+                                            const Index3D& index,
+                                            const CudaStream& cuda_stream);
+
+/// Serialize the blocks at the passed indices and pass each to write_data().
+/// Blocks are copied to the host on the GPU in batches. The next batch is
+/// serialized while the current batch is being written.
+/// @return False if a call to write_data() failed. Writing stops on failure.
+template <typename VoxelType>
+bool serializeLayerDataInBatches(
+    const VoxelBlockLayer<VoxelType>& layer,
+    const std::vector<Index3D>& indices,
+    const LayerSerializationFunctions::WriteLayerDataFunction& write_data,
+    const CudaStream& cuda_stream);
+
+/// Like serializeLayerDataInBatches(), but the blocks are compressed on the
+/// GPU (see LayerCompressorGpuInternal) before being passed to write_data().
+template <typename VoxelType>
+bool serializeCompressedLayerDataInBatches(
+    const VoxelBlockLayer<VoxelType>& layer,
+    const std::vector<Index3D>& indices,
+    const LayerSerializationFunctions::WriteLayerDataFunction& write_data,
+    const CudaStream& cuda_stream);
+
 // ------------------- Deserialization ----------------------
 
 template <typename LayerType>
@@ -83,6 +118,31 @@ template <typename VoxelType>
 void addDataToLayer(const Index3D& index, const std::vector<Byte>& data,
                     VoxelBlockLayer<VoxelType>* layer);
 
+// Mesh specializations
+std::unique_ptr<MeshLayer> deserializeMeshLayerParameters(
+    MemoryType memory_type, const LayerParameterStruct& params);
+
+void addDataToLayer(const Index3D& index, const std::vector<Byte>& data,
+                    MeshLayer* layer, const CudaStream& cuda_stream);
+
+/// Add a block serialized by serializeCompressedLayerDataInBatches(). The
+/// block is decompressed on the CPU.
+template <typename VoxelType>
+void addCompressedDataToLayer(const Index3D& index,
+                              const std::vector<Byte>& data,
+                              VoxelBlockLayer<VoxelType>* layer,
+                              const CudaStream& cuda_stream);
+
+/// Allocate the blocks at the passed indices and output pointers to their
+/// voxels, in the same order as the indices.
+/// @return False if num_bytes_per_block does not match the block size.
+template <typename VoxelType>
+bool allocateLayerBlocks(const std::vector<Index3D>& indices,
+                         size_t num_bytes_per_block,
+                         VoxelBlockLayer<VoxelType>* layer,
+                         std::vector<Byte*>* block_data,
+                         const CudaStream& cuda_stream);
+
 }  // namespace nvblox
 
 #include "nvblox/map_saving/internal/impl/layer_serialization_impl.h"
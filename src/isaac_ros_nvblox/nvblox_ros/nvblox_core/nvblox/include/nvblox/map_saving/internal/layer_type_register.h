@@ -44,6 +44,15 @@ struct LayerSerializationFunctions {
   typedef std::function<std::vector<Byte>(const BaseLayer*, const Index3D&,
                                           const CudaStream& cuda_stream)>
       SerializeLayerDataFunction;
+  // Called by the batched serialization for each serialized block. The data
+  // is only valid during the call.
+  typedef std::function<bool(const Index3D&, const Byte* data,
+                             size_t num_bytes)>
+      WriteLayerDataFunction;
+  typedef std::function<bool(const BaseLayer*, const std::vector<Index3D>&,
+                             const WriteLayerDataFunction& write_data,
+                             const CudaStream& cuda_stream)>
+      SerializeLayerDataBatchFunction;
 
   // Deserialization functions.
   typedef std::function<std::unique_ptr<BaseLayer>(MemoryType,
@@ -52,15 +61,32 @@ struct LayerSerializationFunctions {
   typedef std::function<void(const Index3D&, const std::vector<Byte>&,
                              BaseLayer*, const CudaStream& cuda_stream)>
       AddDataToLayerFunction;
+  // Allocates blocks and returns pointers to their (uninitialized) data, such
+  // that many blocks can be filled at once. Returns false if the layer does
+  // not store blocks of num_bytes_per_block bytes.
+  typedef std::function<bool(const std::vector<Index3D>&,
+                             size_t num_bytes_per_block, BaseLayer*,
+                             std::vector<Byte*>* block_data,
+                             const CudaStream& cuda_stream)>
+      AllocateLayerBlocksFunction;
 
   // The 5 functions that have to be defined to serialize and deserialize a
   // layer type.
   SerializeLayerParametersFunction serialize_params;
   GetLayerDataIndicesFunction get_data_indices;
   SerializeLayerDataFunction serialize_data;
+  // Optional. Serializes many blocks at once, faster than serialize_data.
+  SerializeLayerDataBatchFunction serialize_data_batch;
+  // Optional. Like serialize_data_batch, but emits compressed blocks, which
+  // have to be deserialized with add_compressed_data.
+  SerializeLayerDataBatchFunction serialize_compressed_data_batch;
 
   ConstructLayerFunction construct_layer;
   AddDataToLayerFunction add_data;
+  // Optional. Needed for loading binary map files.
+  AllocateLayerBlocksFunction allocate_blocks;
+  // Optional. Needed for loading compressed blocks.
+  AddDataToLayerFunction add_compressed_data;
 };
 
 /// A class that allows registering a layer type to be used for serialization.
@@ -16,6 +16,8 @@ limitations under the License.
 #pragma once
 
 #include <ios>
+#include <set>
+#include <typeindex>
 #include <vector>
 
 #include "nvblox/map/layer_cake.h"
@@ -25,6 +27,16 @@ limitations under the License.
 
 namespace nvblox {
 
+/// How the blocks of a layer are stored in the database. The choice is
+/// recorded per layer in its metadata table, under "compression".
+enum class BlockCompression {
+  /// Raw voxel data.
+  kNone,
+  /// Run-length encoded voxels, compressed on the GPU (see
+  /// LayerCompressorGpuInternal) and decompressed on the CPU when loading.
+  kVoxelRuns,
+};
+
 /// Class to serialize and read a layer cake from an SQLite database.
 class Serializer {
  public:
@@ -45,12 +57,35 @@ class Serializer {
             std::ios_base::openmode openmode = std::ios::in);
 
   /// Load a layer cake from the opened file of a given memory type.
+  /// Derived layers stored with a TSDF other than the one in the file are
+  /// skipped, see store_derived_layers().
   LayerCake loadLayerCake(MemoryType memory_type,
                           const CudaStream& cuda_stream);
 
   /// Write out a layer cake to the opened file, return success.
   bool writeLayerCake(const LayerCake& cake, const CudaStream& cuda_stream);
 
+  /// Set how blocks are compressed by writeLayerCake(). Layers that don't
+  /// support the compression are written uncompressed. Loading picks up the
+  /// compression of each layer from the file.
+  void block_compression(BlockCompression block_compression);
+  BlockCompression block_compression() const;
+
+  /// Set whether writeLayerCake() stores the layers derived from the TSDF,
+  /// i.e. the ESDF (always compressed) and the mesh, tagged with a
+  /// fingerprint of the stored TSDF. When not set (the default) the ESDF is
+  /// stored like any other layer and the mesh isn't stored.
+  void store_derived_layers(bool store_derived_layers);
+  bool store_derived_layers() const;
+
+  /// Whether the last loadLayerCake() restored a derived layer of this type
+  /// whose fingerprint matches the loaded TSDF. Such a layer doesn't have to
+  /// be recomputed from the TSDF.
+  template <typename LayerType>
+  bool isConsistentDerivedLayer() const {
+    return consistent_derived_layers_.count(typeid(LayerType)) > 0;
+  }
+
   /// Close the file.
   bool close();
 
@@ -71,6 +106,17 @@ class Serializer {
   bool addLayerData(const std::string& layer_name, const Index3D& index,
                     const std::vector<Byte>& data);
 
+  /// Write all data of a layer to its table, in a single transaction and
+  /// through a single prepared statement. Uses batched serialization if the
+  /// layer type supports it. If data_fingerprint is passed, it's set to an
+  /// order-independent hash of the written blocks.
+  bool addAllLayerData(
+      const std::string& layer_name,
+      const LayerSerializationFunctions& layer_functions,
+      const BaseLayer* layer, const CudaStream& cuda_stream,
+      BlockCompression block_compression = BlockCompression::kNone,
+      uint64_t* data_fingerprint = nullptr);
+
  private:
   // Set layer parameters in the database.
   bool setLayerParameterString(const std::string& layer_name,
@@ -112,6 +158,9 @@ class Serializer {
   std::string layerMetadataTableName(const std::string& layer_name) const;
 
   SqliteDatabase sqlite_;
+  BlockCompression block_compression_ = BlockCompression::kNone;
+  bool store_derived_layers_ = false;
+  std::set<std::type_index> consistent_derived_layers_;
 };
 
 }  // namespace nvblox
@@ -21,6 +21,7 @@ limitations under the License.
 
 // forward declaration
 struct sqlite3;
+struct sqlite3_stmt;
 
 namespace nvblox {
 /// Class to wrap access to the C interface of SQLite in a slightly more
@@ -48,6 +49,22 @@ class SqliteDatabase {
   bool runStatementWithBlob(const std::string& statement,
                             const std::vector<Byte>& blob);
 
+  /// Prepare a return-value-less statement, which can then be run many times
+  /// with different parameters through runPreparedStatement(). This avoids
+  /// parsing the statement for each run. Replaces the previously prepared
+  /// statement.
+  bool prepareStatement(const std::string& statement);
+  /// Run the prepared statement. The ints are bound to the first parameters
+  /// and the blob (not copied) to the parameter after those.
+  bool runPreparedStatement(const std::vector<int>& int_params,
+                            const Byte* blob, size_t blob_size);
+  /// Release the prepared statement.
+  void finalizePreparedStatement();
+
+  /// Set the journal mode, e.g. "WAL" or "DELETE" (sqlite's default).
+  /// Returns false if the database does not support the mode.
+  bool setJournalMode(const std::string& journal_mode);
+
   /// Run a query that has a SINGLE return value of the given type:
   bool runSingleQueryString(const std::string& sql_query, std::string* result);
   bool runSingleQueryInt(const std::string& sql_query, int* result);
@@ -64,6 +81,7 @@ class SqliteDatabase {
 
  private:
   sqlite3* db_ = nullptr;
+  sqlite3_stmt* prepared_statement_ = nullptr;
 };
 
 }  // namespace nvblox
@@ -0,0 +1,127 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#pragma once
+
+#include <memory>
+
+#include "nvblox/core/cuda_stream.h"
+#include "nvblox/core/types.h"
+#include "nvblox/map/common_names.h"
+#include "nvblox/mapper/depth_change_gate_params.h"
+#include "nvblox/rays/sphere_tracer.h"
+#include "nvblox/sensors/camera.h"
+#include "nvblox/sensors/image.h"
+
+namespace nvblox {
+
+/// Removes the pixels of a depth frame which re-observe the reconstruction,
+/// such that only changed pixels are integrated. While DepthFrameGate skips
+/// whole frames, this gate works per pixel, which saves work while the camera
+/// moves through static, already-converged geometry.
+///
+/// The reconstructed surface is rendered from the pose of the frame by sphere
+/// tracing the TSDF. A pixel is unchanged if both it and the rendered surface
+/// have valid depth, differing by at most min_residual_m. Unchanged pixels
+/// are set to invalid depth. Blocks only seen by unchanged pixels are
+/// therefore not integrated at all (given raycasting view calculation), and
+/// neither do they trigger mesh and ESDF updates.
+///
+/// Every full_frame_period'th frame is passed through unchanged, such that the
+/// weights of static geometry are kept fresh, e.g. against decay.
+class DepthChangeGate {
+ public:
+  DepthChangeGate() = delete;
+  DepthChangeGate(std::shared_ptr<CudaStream> cuda_stream);
+  virtual ~DepthChangeGate() = default;
+
+  /// Removes the unchanged pixels of a depth frame, writing the result to
+  /// gated_depth().
+  /// @param depth_frame The depth frame, in device or unified memory.
+  /// @param T_L_C The pose of the camera.
+  /// @param camera The intrinsics of the camera.
+  /// @param tsdf_layer The reconstruction to compare against.
+  /// @param truncation_distance_m The truncation distance of tsdf_layer.
+  /// @return Whether the frame was gated. If not (on full frames), the caller
+  /// is expected to integrate the passed frame.
+  bool gateFrame(const DepthImageConstView& depth_frame, const Transform& T_L_C,
+                 const Camera& camera, const TsdfLayer& tsdf_layer,
+                 const float truncation_distance_m);
+
+  /// The last gated frame, in device memory. Valid until the next call to
+  /// gateFrame().
+  const DepthImage& gated_depth() const { return gated_depth_; }
+
+  /// Make the next frame a full frame.
+  void reset();
+
+  /// The number of frames that were gated (i.e. not passed through in full)
+  /// since construction.
+  int num_gated_frames() const { return num_gated_frames_; }
+
+  /// A parameter getter
+  /// The depth residual in meters above which a pixel counts as changed.
+  /// @returns the minimum residual
+  float min_residual_m() const { return min_residual_m_; }
+
+  /// A parameter setter
+  /// See min_residual_m().
+  /// @param min_residual_m the minimum residual.
+  void min_residual_m(float min_residual_m);
+
+  /// A parameter getter
+  /// Every this many frames, a frame is passed through in full.
+  /// @returns the full frame period
+  int full_frame_period() const { return full_frame_period_; }
+
+  /// A parameter setter
+  /// See full_frame_period().
+  /// @param full_frame_period the period in frames, at least 1.
+  void full_frame_period(int full_frame_period);
+
+  /// A parameter getter
+  /// The subsampling factor of the rendered depth image.
+  /// @returns the render subsampling factor
+  int render_subsampling_factor() const { return render_subsampling_factor_; }
+
+  /// A parameter setter
+  /// See render_subsampling_factor().
+  /// @param render_subsampling_factor the subsampling factor, at least 1.
+  void render_subsampling_factor(int render_subsampling_factor);
+
+ protected:
+  // Params
+  float min_residual_m_ = kDepthChangeGateMinResidualMParamDesc.default_value;
+  int full_frame_period_ =
+      kDepthChangeGateFullFramePeriodParamDesc.default_value;
+  int render_subsampling_factor_ =
+      kDepthChangeGateRenderSubsamplingFactorParamDesc.default_value;
+
+  // Frames since the last full frame. Starts such that the first frame is a
+  // full one.
+  int num_frames_since_full_frame_ = -1;
+  int num_gated_frames_ = 0;
+
+  // Renders the reconstructed surface.
+  SphereTracer sphere_tracer_;
+  DepthImage rendered_depth_{MemoryType::kDevice};
+
+  // The output.
+  DepthImage gated_depth_{MemoryType::kDevice};
+
+  std::shared_ptr<CudaStream> cuda_stream_;
+};
+
+}  // namespace nvblox
@@ -0,0 +1,49 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#pragma once
+
+#include "nvblox/utils/params.h"
+
+namespace nvblox {
+
+constexpr Param<float>::Description kDepthChangeGateMinResidualMParamDesc{
+    "depth_change_gate_min_residual_m", 0.05f,
+    "The difference, in meters, between the depth of a pixel and the depth of "
+    "the reconstructed surface rendered from the same pose above which the "
+    "pixel counts as changed, and is integrated."};
+constexpr Param<int>::Description kDepthChangeGateFullFramePeriodParamDesc{
+    "depth_change_gate_full_frame_period", 10,
+    "Every this many frames, a depth frame is integrated in full, such that "
+    "the weights of unchanged geometry are kept fresh. 1 integrates every "
+    "frame in full."};
+constexpr Param<int>::Description
+    kDepthChangeGateRenderSubsamplingFactorParamDesc{
+        "depth_change_gate_render_subsampling_factor", 2,
+        "The subsampling factor of the rendered depth image the depth frame is "
+        "compared against. Higher factors are cheaper to render, but "
+        "integrate more pixels at depth discontinuities."};
+
+/// A structure containing the depth change gate parameters.
+struct DepthChangeGateParams {
+  Param<float> depth_change_gate_min_residual_m{
+      kDepthChangeGateMinResidualMParamDesc};
+  Param<int> depth_change_gate_full_frame_period{
+      kDepthChangeGateFullFramePeriodParamDesc};
+  Param<int> depth_change_gate_render_subsampling_factor{
+      kDepthChangeGateRenderSubsamplingFactorParamDesc};
+};
+
+}  // namespace nvblox
@@ -0,0 +1,133 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#pragma once
+
+#include <memory>
+#include <optional>
+
+#include "nvblox/core/cuda_stream.h"
+#include "nvblox/core/types.h"
+#include "nvblox/core/unified_ptr.h"
+#include "nvblox/mapper/depth_frame_gate_params.h"
+#include "nvblox/sensors/image.h"
+
+namespace nvblox {
+
+/// Decides whether a depth frame is redundant, i.e. adds (almost) nothing to
+/// the last integrated frame (the keyframe), such that its integration can be
+/// skipped. A frame is redundant if both
+/// - the camera moved less than max_translation_m and rotated less than
+///   max_rotation_rad w.r.t. the keyframe, and
+/// - at most max_changed_pixel_fraction of the pixels changed depth by more
+///   than max_depth_change_m w.r.t. the keyframe. A pixel changing between
+///   valid and invalid depth counts as changed.
+///
+/// Comparing against the keyframe rather than the previous frame means slow
+/// drift eventually triggers an integration.
+class DepthFrameGate {
+ public:
+  DepthFrameGate() = delete;
+  DepthFrameGate(std::shared_ptr<CudaStream> cuda_stream);
+  virtual ~DepthFrameGate() = default;
+
+  /// Checks whether a frame is redundant. If not, the frame becomes the new
+  /// keyframe, so the caller is expected to integrate it.
+  /// @param depth_frame The depth frame, in device or unified memory.
+  /// @param T_L_C The pose of the camera.
+  /// @return Whether the frame is redundant.
+  bool isRedundant(const DepthImageConstView& depth_frame,
+                   const Transform& T_L_C);
+
+  /// Forget the keyframe, such that the next frame is not redundant.
+  void reset();
+
+  /// The number of frames found redundant since construction.
+  int num_redundant_frames() const { return num_redundant_frames_; }
+
+  /// A parameter getter
+  /// The largest camera translation in meters for a frame to be redundant.
+  /// @returns the maximum translation
+  float max_translation_m() const { return max_translation_m_; }
+
+  /// A parameter setter
+  /// See max_translation_m().
+  /// @param max_translation_m the maximum translation.
+  void max_translation_m(float max_translation_m);
+
+  /// A parameter getter
+  /// The largest camera rotation in radians for a frame to be redundant.
+  /// @returns the maximum rotation
+  float max_rotation_rad() const { return max_rotation_rad_; }
+
+  /// A parameter setter
+  /// See max_rotation_rad().
+  /// @param max_rotation_rad the maximum rotation.
+  void max_rotation_rad(float max_rotation_rad);
+
+  /// A parameter getter
+  /// The depth change in meters above which a pixel counts as changed.
+  /// @returns the maximum depth change
+  float max_depth_change_m() const { return max_depth_change_m_; }
+
+  /// A parameter setter
+  /// See max_depth_change_m().
+  /// @param max_depth_change_m the maximum depth change.
+  void max_depth_change_m(float max_depth_change_m);
+
+  /// A parameter getter
+  /// The largest fraction of changed pixels for a frame to be redundant.
+  /// @returns the maximum fraction of changed pixels
+  float max_changed_pixel_fraction() const {
+    return max_changed_pixel_fraction_;
+  }
+
+  /// A parameter setter
+  /// See max_changed_pixel_fraction().
+  /// @param max_changed_pixel_fraction the maximum fraction in [0, 1].
+  void max_changed_pixel_fraction(float max_changed_pixel_fraction);
+
+ protected:
+  // Make the passed frame the keyframe.
+  void setKeyframe(const DepthImageConstView& depth_frame,
+                   const Transform& T_L_C);
+
+  // Count the pixels which changed w.r.t. the keyframe.
+  int countChangedPixels(const DepthImageConstView& depth_frame);
+
+  // Params
+  float max_translation_m_ =
+      kDepthFrameGateMaxTranslationMParamDesc.default_value;
+  float max_rotation_rad_ =
+      kDepthFrameGateMaxRotationRadParamDesc.default_value;
+  float max_depth_change_m_ =
+      kDepthFrameGateMaxDepthChangeMParamDesc.default_value;
+  float max_changed_pixel_fraction_ =
+      kDepthFrameGateMaxChangedPixelFractionParamDesc.default_value;
+
+  // The last frame which was not redundant.
+  DepthImage keyframe_depth_{MemoryType::kDevice};
+  std::optional<Transform> T_L_keyframe_;
+
+  // Changed pixel counters
+  unified_ptr<int> changed_pixels_device_;
+  unified_ptr<int> changed_pixels_host_;
+
+  int num_redundant_frames_ = 0;
+
+  std::shared_ptr<CudaStream> cuda_stream_;
+};
+
+}  // namespace nvblox
@@ -0,0 +1,52 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#pragma once
+
+#include "nvblox/utils/params.h"
+
+namespace nvblox {
+
+constexpr Param<float>::Description kDepthFrameGateMaxTranslationMParamDesc{
+    "depth_frame_gate_max_translation_m", 0.02f,
+    "The largest camera translation, in meters, since the last integrated "
+    "depth frame for which a depth frame may be considered redundant."};
+constexpr Param<float>::Description kDepthFrameGateMaxRotationRadParamDesc{
+    "depth_frame_gate_max_rotation_rad", 0.02f,
+    "The largest camera rotation, in radians, since the last integrated depth "
+    "frame for which a depth frame may be considered redundant."};
+constexpr Param<float>::Description kDepthFrameGateMaxDepthChangeMParamDesc{
+    "depth_frame_gate_max_depth_change_m", 0.05f,
+    "The change in depth, in meters, w.r.t. the last integrated depth frame "
+    "above which a pixel counts as changed."};
+constexpr Param<float>::Description
+    kDepthFrameGateMaxChangedPixelFractionParamDesc{
+        "depth_frame_gate_max_changed_pixel_fraction", 0.01f,
+        "The largest fraction of changed pixels for which a depth frame may "
+        "be considered redundant."};
+
+/// A structure containing the depth frame gate parameters.
+struct DepthFrameGateParams {
+  Param<float> depth_frame_gate_max_translation_m{
+      kDepthFrameGateMaxTranslationMParamDesc};
+  Param<float> depth_frame_gate_max_rotation_rad{
+      kDepthFrameGateMaxRotationRadParamDesc};
+  Param<float> depth_frame_gate_max_depth_change_m{
+      kDepthFrameGateMaxDepthChangeMParamDesc};
+  Param<float> depth_frame_gate_max_changed_pixel_fraction{
+      kDepthFrameGateMaxChangedPixelFractionParamDesc};
+};
+
+}  // namespace nvblox
@@ -15,34 +15,56 @@ limitations under the License.
 */
 #pragma once
 
+#include <future>
+#include <memory>
+#include <mutex>
 #include <optional>
+#include <string>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
+#include "nvblox/core/cuda_event.h"
 #include "nvblox/core/hash.h"
+#include "nvblox/core/memory_usage.h"
 #include "nvblox/core/parameter_tree.h"
+#include "nvblox/core/scratch_arena.h"
 #include "nvblox/dynamics/dynamics_detection.h"
+#include "nvblox/geometry/esdf_collision_checker.h"
+#include "nvblox/integrators/dense_esdf_slice_integrator.h"
 #include "nvblox/integrators/esdf_integrator.h"
 #include "nvblox/integrators/freespace_integrator.h"
 #include "nvblox/integrators/occupancy_decay_integrator.h"
 #include "nvblox/integrators/projective_color_integrator.h"
 #include "nvblox/integrators/projective_occupancy_integrator.h"
+#include "nvblox/integrators/pointcloud_tsdf_integrator.h"
 #include "nvblox/integrators/projective_tsdf_integrator.h"
 #include "nvblox/integrators/shape_clearer.h"
+#include "nvblox/integrators/tsdf_block_pruner.h"
 #include "nvblox/integrators/tsdf_decay_integrator.h"
 #include "nvblox/map/blocks_to_update_tracker.h"
 #include "nvblox/map/blox.h"
 #include "nvblox/map/common_names.h"
 #include "nvblox/map/layer.h"
 #include "nvblox/map/layer_cake.h"
+#include "nvblox/map/multi_layer_query.h"
 #include "nvblox/map/voxels.h"
+#include "nvblox/map_saving/internal/binary_map_serializer.h"
+#include "nvblox/map_saving/internal/checkpoint_log.h"
+#include "nvblox/mapper/depth_change_gate.h"
+#include "nvblox/mapper/depth_frame_gate.h"
 #include "nvblox/mapper/mapper_params.h"
 #include "nvblox/mesh/mesh_integrator.h"
 #include "nvblox/semantics/image_masker.h"
 #include "nvblox/sensors/camera.h"
+#include "nvblox/utils/metrics.h"
 #include "nvblox/sensors/depth_preprocessing.h"
+#include "nvblox/sensors/depth_pyramid.h"
+#include "nvblox/sensors/internal/camera_ray_cache.h"
 #include "nvblox/sensors/lidar.h"
 #include "nvblox/serialization/layer_cake_streamer.h"
 #include "nvblox/serialization/layer_streamer.h"
+#include "nvblox/serialization/serialized_layer_merger.h"
 
 namespace nvblox {
 
@@ -74,6 +96,35 @@ inline std::string toString(const EsdfMode& esdf_mode) {
 /// require and update (tracked by BlocksToUpdateTracker).
 enum class UpdateFullLayer { kNo, kYes };
 
+/// The memory held by a Mapper, see Mapper::memoryUsage().
+struct MapperMemoryUsage {
+  /// The memory of each layer, keyed by the layer's name (e.g. "tsdf").
+  std::vector<std::pair<std::string, LayerMemoryUsage>> layers;
+  /// The per-frame scratch memory of the integrators.
+  MemoryUsage scratch_arena;
+  /// The device's default (stream-ordered) memory pool. Includes the scratch
+  /// arena.
+  MemoryUsage device_memory_pool;
+  /// Free and total device memory as reported by the driver.
+  size_t device_free_bytes = 0;
+  size_t device_total_bytes = 0;
+
+  /// Device memory in use which cannot be recovered by reusing the idle
+  /// memory of the layers' block pools and of the device memory pool.
+  /// @return The number of bytes.
+  size_t deviceBytesInUse() const;
+  /// The fraction of the device's memory in use, see deviceBytesInUse().
+  /// @return The fraction in [0, 1].
+  float devicePressure() const;
+
+  /// Write the memory usage and the GPU hash statistics as metrics, see
+  /// timing::Metrics.
+  /// @param mapper_name Distinguishes the mappers of a process, e.g. "static".
+  /// @param writer The output.
+  void writeMetrics(const std::string& mapper_name,
+                    timing::MetricsWriter* writer) const;
+};
+
 /// The mapper classes wraps layers and integrators together.
 /// In the base class we only specify that a mapper should contain map layers
 /// and leave it up to sub-classes to add functionality.
@@ -153,6 +204,14 @@ class Mapper : public MapperBase {
   /// Occupancy: Voxels updated with unmasked depth are treated as
   /// "unobserved".
   ///
+  /// If skip_redundant_depth_frames() is set, frames which are redundant with
+  /// the last integrated frame are skipped (see DepthFrameGate). Note that
+  /// this only skips the projective integration: freespace updates and
+  /// dynamics detection keep running on the skipped frames.
+  ///
+  /// If gate_unchanged_depth_pixels() is set, only the pixels which differ
+  /// from the reconstructed surface are integrated (see DepthChangeGate).
+  ///
   ///@param depth_frame Depth frame to integrate. Depth in the image is
   ///                   specified as a float representing meters.
   ///@param T_L_C Pose of the camera, specified as a transform from
@@ -163,6 +222,73 @@ class Mapper : public MapperBase {
   void integrateDepth(const MaskedDepthImageConstView& depth_frame,
                       const Transform& T_L_C, const Camera& camera);
 
+  /// Integrates a depth frame, and the per-pixel classes of a multi-class
+  /// mask in to the label layer (see label_layer()), in the same pass.
+  ///
+  /// Unlike the MultiMapper, which integrates each class in to a mapper of
+  /// its own, this keeps a single projective layer and one byte per voxel
+  /// for the labels. Masked pixels of depth_frame vote for the label of the
+  /// voxels at their surface, all pixels vote for free space in front of it.
+  ///
+  ///@param depth_frame Depth frame to integrate.
+  ///@param label_image The class of each pixel, below LabelVoxel::kNumLabels.
+  ///                   May have another resolution than depth_frame.
+  ///@param T_L_C Pose of the camera.
+  ///@param camera Intrinsics model of the camera of depth_frame.
+  void integrateDepth(const MaskedDepthImageConstView& depth_frame,
+                      const MonoImageConstView& label_image,
+                      const Transform& T_L_C, const Camera& camera);
+
+  /// Integrates several depth frames in a single batched pass.
+  ///
+  /// Equivalent to calling integrateDepth() once per frame, but the blocks in
+  /// view of all frames are merged and integrated with a single kernel launch
+  /// and a single GPU hash update. Use this when several cameras produce
+  /// frames at (roughly) the same time.
+  ///
+  ///@param depth_frames Depth frames to integrate.
+  ///@param T_L_C_vec Poses of the cameras, one per depth frame.
+  ///@param cameras Intrinsics models of the cameras, one per depth frame.
+  void integrateDepth(
+      const std::vector<MaskedDepthImageConstView>& depth_frames,
+      const std::vector<Transform>& T_L_C_vec,
+      const std::vector<Camera>& cameras);
+
+  /// Pipelined depth integration, part 1.
+  /// Stages a depth frame for integration by a later call to
+  /// integrateStagedDepth(). The frame is copied into a buffer owned by the
+  /// mapper and preprocessed on a separate staging stream. The host does not
+  /// wait for this work, which therefore overlaps with work on the mapper
+  /// stream, like the integration of the previous frame. Up to
+  /// kMaxNumStagedDepthFrames frames can be staged at a time.
+  /// Each staging lane has its own stream and preprocessor. Using one lane
+  /// per camera, the frames of different cameras are preprocessed in
+  /// parallel.
+  ///@param depth_frame Depth frame to integrate. The image (and mask) memory
+  ///                   must remain valid until the frame is integrated.
+  ///@param T_L_C Pose of the camera, specified as a transform from
+  ///             Camera-frame to Layer-frame transform.
+  ///@param camera Intrinsics model of the camera.
+  ///@param staging_lane The lane to stage on, e.g. the camera index. Lanes
+  ///                    are created on first use.
+  void stageDepthAsync(const MaskedDepthImageConstView& depth_frame,
+                       const Transform& T_L_C, const Camera& camera,
+                       int staging_lane = 0);
+
+  /// Pipelined depth integration, part 2.
+  /// Integrates the oldest frame staged with stageDepthAsync(). The mapper
+  /// stream waits for the staging on the device, the host doesn't block on
+  /// it. For the rest, this is equivalent to integrateDepth().
+  void integrateStagedDepth();
+
+  /// The number of frames staged with stageDepthAsync() and not yet
+  /// integrated.
+  int numStagedDepthFrames() const { return num_staged_depth_frames_; }
+
+  /// The maximum number of frames staged at a time, e.g. a frame for each of
+  /// up to 8 cameras, for the current and the next integration.
+  static constexpr int kMaxNumStagedDepthFrames = 16;
+
   /// Integrates a color frame into the reconstruction.
   ///@param color_frame Color image to integrate.
   ///@param T_L_C Pose of the camera, specified as a transform from
@@ -179,12 +305,44 @@ class Mapper : public MapperBase {
   void integrateLidarDepth(const DepthImage& depth_frame,
                            const Transform& T_L_C, const Lidar& lidar);
 
+  /// Integrates several 3D LiDAR scans in a single batched pass.
+  ///
+  /// Equivalent to calling integrateLidarDepth() once per scan, but the blocks
+  /// in view of all scans are merged and integrated with a single kernel
+  /// launch and a single GPU hash update. Use this when several LiDARs on the
+  /// same robot produce scans at (roughly) the same time.
+  ///
+  ///@param depth_frames Depth images representing the LiDAR scans.
+  ///@param T_L_C_vec Poses of the LiDARs, one per scan.
+  ///@param lidars Intrinsics models of the LiDARs, one per scan.
+  void integrateLidarDepth(
+      const std::vector<MaskedDepthImageConstView>& depth_frames,
+      const std::vector<Transform>& T_L_C_vec,
+      const std::vector<Lidar>& lidars);
+
+  /// Integrates a 3D LiDAR scan, given as a pointcloud, into the
+  /// reconstruction. In contrast to integrateLidarDepth() the points are
+  /// raycast directly, so no depth image (or LiDAR intrinsics) are required.
+  /// Only supported for TSDF layers.
+  ///@param pointcloud_S Points of the scan, in the LiDAR frame (S).
+  ///@param T_L_S Pose of the LiDAR, specified as a transform from LiDAR-frame
+  ///             to Layer-frame transform.
+  void integrateLidarPointcloud(const Pointcloud& pointcloud_S,
+                                const Transform& T_L_S);
+
   /// Decay the TSDF layer (reduce weights)
   void decayTsdf();
 
   /// Decay the full occupancy layer.
   void decayOccupancy();
 
+  /// Deallocate the TSDF blocks which no longer carry information (see
+  /// TsdfBlockPruner), together with the corresponding blocks of the derived
+  /// layers. Also called every tsdf_block_pruner().period() depth
+  /// integrations.
+  /// @return The indices of the pruned blocks.
+  std::vector<Index3D> pruneTsdfBlocks();
+
   /// @brief Clear the TSDF layer inside the passed shapes.
   /// @param shapes Vector of shapes to clear.
   void clearTsdfInsideShapes(const std::vector<BoundingShape>& shapes);
@@ -214,6 +372,17 @@ class Mapper : public MapperBase {
   /// mesh layer, for example.
   void updateMesh(UpdateFullLayer update_full_layer = UpdateFullLayer::kNo);
 
+  /// Gets the voxels of several layers at a set of points, resolving the
+  /// block of each point once for all layers (see queryLayersGPU()).
+  /// Lookups fail in layers which aren't mapped, given the projective layer
+  /// type.
+  /// @param positions_L The query points in layer frame (on the device).
+  /// @param layer_type_bitmask The layers to query.
+  /// @param results The voxels of the requested layers.
+  void queryLayers(const device_vector<Vector3f>& positions_L,
+                   const LayerTypeBitMask layer_type_bitmask,
+                   MultiLayerQueryResults* results) const;
+
   /// Serialize selected layers.
   ///
   /// Will update serialized layers to contain new blocks added to the map since
@@ -233,9 +402,38 @@ class Mapper : public MapperBase {
       const BlockExclusionParams& maybe_exclusion_params =
           BlockExclusionParams());
 
-  /// Return the serialized mesh layer.
+  /// Return the serialized mesh layer. With
+  /// mesh_streaming_max_bytes_per_publish() set, these are the highest
+  /// priority mesh blocks that fit the byte budget.
   std::shared_ptr<const SerializedMeshLayer> serializedMeshLayer();
 
+  /// Adds a region of interest (ROI) for mesh streaming. Each ROI has its own
+  /// candidates and byte budget, such that its consumer only receives the
+  /// mesh blocks inside of it. The mesh blocks already inside of the ROI are
+  /// streamed first. ROI candidates are collected by
+  /// serializeSelectedLayers(), which therefore has to be called even if
+  /// no layer is selected.
+  /// @param roi The region. The block size is set by the mapper.
+  /// @return The id of the ROI.
+  int addMeshStreamingRoi(const StreamingRoi& roi);
+
+  /// Changes the region of a mesh streaming ROI, e.g. to follow the robot.
+  /// @param roi_id The id returned by addMeshStreamingRoi().
+  /// @param roi The new region.
+  void updateMeshStreamingRoi(const int roi_id, const StreamingRoi& roi);
+
+  /// Removes a mesh streaming ROI.
+  /// @param roi_id The id returned by addMeshStreamingRoi().
+  void removeMeshStreamingRoi(const int roi_id);
+
+  /// Serializes the highest priority mesh blocks of an ROI within a byte
+  /// budget.
+  /// @param roi_id The id returned by addMeshStreamingRoi().
+  /// @param num_bytes The byte budget of the ROI.
+  /// @return The serialized mesh blocks of the ROI.
+  std::shared_ptr<const SerializedMeshLayer> serializeMeshStreamingRoi(
+      const int roi_id, const size_t num_bytes);
+
   /// Return the serialized TSDF layer.
   std::shared_ptr<const SerializedTsdfLayer> serializedTsdfLayer();
 
@@ -251,6 +449,33 @@ class Mapper : public MapperBase {
   /// Return the serialized freespace layer.
   std::shared_ptr<const SerializedFreespaceLayer> serializedFreespaceLayer();
 
+  /// Merge blocks of another map, e.g. serialized by serializeSelectedLayers()
+  /// on another robot, into the TSDF layer. The voxels are fused on the GPU by
+  /// weighted averaging (see SerializedLayerMerger), up to the maximum weight
+  /// of the TSDF integrator. Merging only the blocks that changed since the
+  /// last exchange keeps the cost proportional to the change of the map. The
+  /// merged blocks are marked for update.
+  /// @param serialized_layer The uncompressed blocks to merge.
+  /// @return The indices of the merged blocks.
+  std::vector<Index3D> mergeSerializedTsdfLayer(
+      const SerializedTsdfLayer& serialized_layer);
+
+  /// Merge blocks of another map into the occupancy layer. See
+  /// mergeSerializedTsdfLayer().
+  /// @param serialized_layer The uncompressed blocks to merge.
+  /// @return The indices of the merged blocks.
+  std::vector<Index3D> mergeSerializedOccupancyLayer(
+      const SerializedOccupancyLayer& serialized_layer);
+
+  /// Enable or disable tracking the blocks changed for ground plane
+  /// estimation, see getGroundPlaneBlocksToUpdate(). Off by default.
+  void trackGroundPlaneBlocks(bool track_ground_plane_blocks);
+
+  /// Returns the blocks which were updated or removed since the last call
+  /// (while tracking is enabled through trackGroundPlaneBlocks()), and marks
+  /// them as consumed.
+  std::vector<Index3D> getGroundPlaneBlocksToUpdate();
+
   /// Updates the ESDF blocks.
   /// Note that currently we limit the Mapper class to calculating *either*
   /// the 2D or 3D ESDF, not both. Which is to be calculated is determined by
@@ -279,12 +504,131 @@ class Mapper : public MapperBase {
   void updateEsdfSlice(UpdateFullLayer update_full_layer = UpdateFullLayer::kNo,
                        std::optional<Plane> ground_plane = std::nullopt);
 
+  /// Updates the 3D ESDF within an axis-aligned window of half extent
+  /// esdf_window_half_extent_m() centred on window_center (typically the
+  /// robot position). ESDF blocks that leave the window are cleared and blocks
+  /// that enter it are recomputed, such that the cost of a call is bounded by
+  /// the window size rather than by the size of the map. Within the window,
+  /// only blocks requiring an update (see updateEsdf()) are recomputed.
+  /// Shares the 3D ESDF mode with updateEsdf().
+  /// @param window_center The center of the window in the layer frame.
+  void updateEsdfInWindow(const Vector3f& window_center);
+
+  /// Takes a snapshot of the input of the next 3D ESDF update, i.e. of the
+  /// TSDF/occupancy (and freespace) blocks that changed since the last update.
+  /// Only the changed blocks are copied, on the mapper stream. Snapshots taken
+  /// before the next call to updateEsdfFromSnapshot() are merged. Together
+  /// with updateEsdfFromSnapshot() this allows computing the ESDF on another
+  /// thread, and on esdf_cuda_stream(), while the next frames are integrated.
+  /// Shares the 3D ESDF mode with updateEsdf().
+  /// @param update_full_layer Whether to snapshot the full layer or only the
+  /// blocks that require an update.
+  void snapshotEsdfInput(
+      UpdateFullLayer update_full_layer = UpdateFullLayer::kNo);
+
+  /// Updates the 3D ESDF from the snapshot taken by snapshotEsdfInput(). Does
+  /// nothing if no blocks changed since the last call. The snapshots are
+  /// double buffered, such that this function may run concurrently with
+  /// integration and snapshotEsdfInput(). It must not run concurrently with
+  /// other functions accessing the ESDF layer (e.g. clearing the map or
+  /// slicing the ESDF): serializing these is up to the caller.
+  void updateEsdfFromSnapshot();
+
+  /// Computes the 2D ESDF slice of the TSDF/occupancy layer directly into a
+  /// dense distance image, without going through the ESDF layer (see
+  /// DenseEsdfSliceIntegrator). The slice covers all blocks in the slice height
+  /// range. Independent of the ESDF mode, and does not affect the ESDF layer.
+  /// @param unobserved_value Value of pixels with no observed voxel.
+  /// @param slice_image_ptr The output distance image (in meters).
+  /// @param aabb_ptr The AABB covered by the output image.
+  void computeDenseEsdfSlice(float unobserved_value,
+                             Image<float>* slice_image_ptr,
+                             AxisAlignedBoundingBox* aabb_ptr);
+
+  /// Computes the minimum clearance of a batch of spheres/capsules against the
+  /// ESDF. A negative clearance means the primitive is in collision. Uses the
+  /// ESDF as it is: call updateEsdf() first for an up-to-date result.
+  /// @param capsules The spheres/capsules to check (in the layer frame).
+  /// @param clearances_m_ptr The minimum clearance in meters, one per capsule.
+  void computeClearances(const std::vector<CollisionCapsule>& capsules,
+                         std::vector<float>* clearances_m_ptr);
+
   /// Clears the reconstruction outside a radius around a center point,
   /// deallocating the memory.
   ///@param center The center of the keep-sphere.
   ///@param radius The radius of the keep-sphere.
   void clearOutsideRadius(const Vector3f& center, float radius);
 
+  /// Clears blocks of the reconstruction, deallocating the memory. The blocks
+  /// are removed from the projective layer and all layers derived from it.
+  ///@param block_indices The blocks to clear.
+  void clearBlocks(const std::vector<Index3D>& block_indices);
+
+  /// Pages the reconstruction outside a radius around a center point out of
+  /// the (device) layers into host memory. In contrast to clearOutsideRadius()
+  /// the TSDF/occupancy, color and freespace data is retained, and paged back
+  /// in when the blocks come into view again during integrateDepth(). Derived
+  /// layers (mesh and ESDF) are cleared and recomputed on page in.
+  ///@param center The center of the keep-sphere.
+  ///@param radius The radius of the keep-sphere.
+  void pageOutOutsideRadius(const Vector3f& center, float radius);
+
+  /// The memory held by the layers and the integrators' scratch memory,
+  /// together with the device's memory status.
+  ///@return The memory usage.
+  MapperMemoryUsage memoryUsage() const;
+
+  /// Frees device memory if it is under pressure: if the memory in use (see
+  /// MapperMemoryUsage::devicePressure()) exceeds
+  /// memory_pressure_watermark(), the reconstruction outside
+  /// memory_pressure_keep_radius_m() around the center is cleared or, if
+  /// memory_pressure_page_out(), paged out. Typically called once per frame
+  /// with the robot position.
+  ///@param center The center of the keep-sphere.
+  ///@return True if memory was under pressure and the map was reduced.
+  bool relieveMemoryPressure(const Vector3f& center);
+
+  /// Lays out the blocks of the layers written by integration (i.e. all but
+  /// the ESDF and mesh layers) in memory in Morton order of their indices (see
+  /// BlockLayer::relayoutBlocksAsync()). Called by integrateDepth() after heavy
+  /// allocation if morton_ordered_blocks(), see
+  /// block_relayout_allocation_fraction(). Does not synchronize the mapper
+  /// stream.
+  void relayoutBlocks();
+
+  /// Pages previously paged out blocks which are in the view of a camera back
+  /// into the layers. The paged in blocks are marked for update. This is
+  /// called by integrateDepth() if any blocks are paged out. Cheap if none of
+  /// them overlaps the view (see BlockLayer::pagedOutBlocksAABB()).
+  ///@param T_L_C The pose of the camera.
+  ///@param camera The camera (intrinsics) model.
+  ///@return The indices of the blocks that were paged in.
+  std::vector<Index3D> pageInBlocksInView(const Transform& T_L_C,
+                                          const Camera& camera);
+
+  /// Get the number of blocks currently paged out of the projective layer.
+  ///@return The number of paged out blocks.
+  int numPagedOutBlocks() const;
+
+  /// Loads the blocks of a map opened with loadMapLazy() that lie within a
+  /// radius around a center point, e.g. ahead of ESDF queries around the
+  /// robot. The loaded blocks are marked for update.
+  ///@param center The center of the sphere.
+  ///@param radius The radius of the sphere.
+  ///@return The indices of the blocks that were loaded.
+  std::vector<Index3D> loadMapBlocksInRadius(const Vector3f& center,
+                                             float radius);
+
+  /// Preallocates the block pools and GPU hashes of all layers such that up to
+  /// a number of blocks can be allocated without growing them. Called on
+  /// setMapperParams() and when loading a map if preallocate_blocks().
+  ///@param num_blocks The number of blocks per layer.
+  void reserveBlocks(size_t num_blocks);
+
+  /// Get the number of blocks of a lazily loaded map which are still on disk.
+  ///@return The number of unloaded blocks.
+  int numUnloadedMapBlocks() const;
+
   /// Allocates blocks touched by radius and gives their voxels some small
   /// positive weight.
   /// @param center The center of allocation-sphere
@@ -326,6 +670,16 @@ class Mapper : public MapperBase {
   ///@return const MeshLayer& Mesh layer
   const MeshLayer& mesh_layer() const { return layers_.get<MeshLayer>(); }
   /// Getter
+  ///@return bool Whether labels were integrated, i.e. label_layer() exists.
+  bool hasLabelLayer() const { return label_layer_ != nullptr; }
+  /// Getter
+  ///@return const LabelLayer& The per-voxel labels. Created by the first call
+  ///        to integrateDepth() with a label image.
+  const LabelLayer& label_layer() const {
+    CHECK(hasLabelLayer()) << "No labels were integrated.";
+    return *label_layer_;
+  }
+  /// Getter
   /// @return const LayerCakeStreamer& The layer cake streamer.
   const LayerCakeStreamer& layer_streamers() const { return layer_streamers_; }
 
@@ -384,6 +738,12 @@ class Mapper : public MapperBase {
     return lidar_tsdf_integrator_;
   }
   /// Getter
+  ///@return const PointcloudTsdfIntegrator& TSDF integrator used for
+  ///        3D LiDAR pointcloud integration.
+  const PointcloudTsdfIntegrator& lidar_pointcloud_tsdf_integrator() const {
+    return lidar_pointcloud_tsdf_integrator_;
+  }
+  /// Getter
   ///@return const ProjectiveOccupancyIntegrator& occupancy integrator used
   /// for 3D LiDAR scan integration.
   const ProjectiveOccupancyIntegrator& lidar_occupancy_integrator() const {
@@ -402,6 +762,12 @@ class Mapper : public MapperBase {
     return tsdf_decay_integrator_;
   }
   /// Getter
+  ///@return const TsdfBlockPruner& pruner used for deallocating empty TSDF
+  ///        blocks.
+  const TsdfBlockPruner& tsdf_block_pruner() const {
+    return tsdf_block_pruner_;
+  }
+  /// Getter
   ///@return const TsdfShapeClearer& TSDF clearer used for
   ///        clearing tsdf inside given shapes.
   const TsdfShapeClearer& tsdf_shape_clearer() const {
@@ -418,6 +784,11 @@ class Mapper : public MapperBase {
   /// Getter
   ///@return const EsdfIntegrator& ESDF integrator
   const EsdfIntegrator& esdf_integrator() const { return esdf_integrator_; }
+  /// Getter
+  ///@return const DenseEsdfSliceIntegrator& Dense 2D ESDF slice integrator
+  const DenseEsdfSliceIntegrator& dense_esdf_slice_integrator() const {
+    return dense_esdf_slice_integrator_;
+  }
 
   /// Getter
   ///@return ProjectiveTsdfIntegrator& TSDF integrator used for
@@ -440,6 +811,12 @@ class Mapper : public MapperBase {
     return lidar_tsdf_integrator_;
   }
   /// Getter
+  ///@return PointcloudTsdfIntegrator& TSDF integrator used for
+  ///        3D LiDAR pointcloud integration.
+  PointcloudTsdfIntegrator& lidar_pointcloud_tsdf_integrator() {
+    return lidar_pointcloud_tsdf_integrator_;
+  }
+  /// Getter
   ///@return ProjectiveOccupancyIntegrator& occupancy integrator used for
   ///        3D LiDAR scan integration.
   ProjectiveOccupancyIntegrator& lidar_occupancy_integrator() {
@@ -459,6 +836,9 @@ class Mapper : public MapperBase {
     return tsdf_decay_integrator_;
   }
   /// Getter
+  ///@return TsdfBlockPruner& pruner used for deallocating empty TSDF blocks.
+  TsdfBlockPruner& tsdf_block_pruner() { return tsdf_block_pruner_; }
+  /// Getter
   ///@return TsdfShapeClearer& TSDF clearer used for
   ///        clearing tsdf inside given shapes.
   TsdfShapeClearer& tsdf_shape_clearer() { return tsdf_shape_clearer_; }
@@ -472,6 +852,32 @@ class Mapper : public MapperBase {
   ///@return EsdfIntegrator& ESDF integrator
   EsdfIntegrator& esdf_integrator() { return esdf_integrator_; }
   /// Getter
+  ///@return DenseEsdfSliceIntegrator& Dense 2D ESDF slice integrator
+  DenseEsdfSliceIntegrator& dense_esdf_slice_integrator() {
+    return dense_esdf_slice_integrator_;
+  }
+  /// Getter
+  ///@return EsdfCollisionChecker& ESDF collision checker
+  EsdfCollisionChecker& collision_checker() { return collision_checker_; }
+  /// Getter
+  ///@return DepthFrameGate& The gate deciding which depth frames are
+  ///        redundant, see skip_redundant_depth_frames().
+  DepthFrameGate& depth_frame_gate() { return depth_frame_gate_; }
+  /// Getter
+  ///@return const DepthFrameGate& The gate deciding which depth frames are
+  ///        redundant, see skip_redundant_depth_frames().
+  const DepthFrameGate& depth_frame_gate() const { return depth_frame_gate_; }
+  /// Getter
+  ///@return DepthChangeGate& The gate removing unchanged depth pixels, see
+  ///        gate_unchanged_depth_pixels().
+  DepthChangeGate& depth_change_gate() { return depth_change_gate_; }
+  /// Getter
+  ///@return const DepthChangeGate& The gate removing unchanged depth pixels,
+  ///        see gate_unchanged_depth_pixels().
+  const DepthChangeGate& depth_change_gate() const {
+    return depth_change_gate_;
+  }
+  /// Getter
   /// @return The voxel size in meters
   float voxel_size_m() const { return voxel_size_m_; };
   /// Getter
@@ -503,6 +909,215 @@ class Mapper : public MapperBase {
     depth_preprocessing_num_dilations_ = depth_preprocessing_num_dilations;
   }
 
+  /// Getter
+  /// @return Whether the depth preprocessing kernels are replayed from a
+  /// captured CUDA graph.
+  bool use_cuda_graphs() const { return depth_preprocessor_.use_cuda_graph(); }
+  /// Setter. See use_cuda_graphs()
+  /// @param use_cuda_graphs Whether to use CUDA graphs.
+  void use_cuda_graphs(const bool use_cuda_graphs);
+
+  /// Getter
+  /// @return Whether the depth preprocessing dilations run on the PVA engine
+  /// through VPI.
+  bool use_vpi_depth_preprocessing() const;
+  /// Setter. See use_vpi_depth_preprocessing(). Has no effect (but a warning)
+  /// if nvblox is built without VPI.
+  /// @param use_vpi_depth_preprocessing Whether to use VPI.
+  void use_vpi_depth_preprocessing(const bool use_vpi_depth_preprocessing);
+
+  /// Getter
+  /// @return Whether serializeSelectedLayers() serializes layers concurrently.
+  bool concurrent_layer_serialization() const {
+    return concurrent_layer_serialization_;
+  }
+  /// Setter. See concurrent_layer_serialization()
+  /// @param concurrent_layer_serialization Whether to serialize concurrently.
+  void concurrent_layer_serialization(
+      const bool concurrent_layer_serialization) {
+    concurrent_layer_serialization_ = concurrent_layer_serialization;
+  }
+
+  /// Getter
+  /// @return The byte budget per serializeSelectedLayers() call of the
+  /// prioritized mesh streaming. 0 means the mesh is streamed by age and
+  /// estimated bandwidth instead.
+  int mesh_streaming_max_bytes_per_publish() const {
+    return mesh_streaming_max_bytes_per_publish_;
+  }
+  /// Setter. See mesh_streaming_max_bytes_per_publish()
+  /// @param mesh_streaming_max_bytes_per_publish The mesh byte budget.
+  void mesh_streaming_max_bytes_per_publish(
+      const int mesh_streaming_max_bytes_per_publish);
+
+  /// Getter
+  /// @return The priority subtracted per meter of distance to the robot in
+  /// the prioritized mesh streaming.
+  float mesh_streaming_distance_weight() const {
+    return mesh_streaming_distance_weight_;
+  }
+  /// Setter. See mesh_streaming_distance_weight()
+  /// @param mesh_streaming_distance_weight The distance weight.
+  void mesh_streaming_distance_weight(
+      const float mesh_streaming_distance_weight);
+
+  /// Getter
+  /// @return The priority added per call a mesh block waited in the
+  /// prioritized mesh streaming.
+  float mesh_streaming_staleness_weight() const {
+    return mesh_streaming_staleness_weight_;
+  }
+  /// Setter. See mesh_streaming_staleness_weight()
+  /// @param mesh_streaming_staleness_weight The staleness weight.
+  void mesh_streaming_staleness_weight(
+      const float mesh_streaming_staleness_weight);
+
+  /// Getter
+  /// @return Whether saveLayerCake() compresses the voxel blocks.
+  bool compress_saved_maps() const { return compress_saved_maps_; }
+  /// Setter. See compress_saved_maps()
+  /// @param compress_saved_maps Whether to compress saved maps.
+  void compress_saved_maps(const bool compress_saved_maps) {
+    compress_saved_maps_ = compress_saved_maps;
+  }
+
+  /// Getter
+  /// @return Whether saveLayerCake() stores the ESDF and mesh for loadMap()
+  /// to restore.
+  bool save_derived_layers() const { return save_derived_layers_; }
+  /// Setter. See save_derived_layers()
+  /// @param save_derived_layers Whether to store the ESDF and mesh.
+  void save_derived_layers(const bool save_derived_layers) {
+    save_derived_layers_ = save_derived_layers;
+  }
+
+  /// Getter
+  /// @return The stream on which the ESDF is computed. Defaults to the mapper
+  /// stream.
+  std::shared_ptr<CudaStream> esdf_cuda_stream() const {
+    return esdf_integrator_.cuda_stream();
+  }
+  /// Setter. See esdf_cuda_stream(). Work on the ESDF stream waits for the
+  /// work preceding it on the mapper stream.
+  /// @param esdf_cuda_stream The stream on which to compute the ESDF.
+  void esdf_cuda_stream(std::shared_ptr<CudaStream> esdf_cuda_stream) {
+    esdf_integrator_.cuda_stream(esdf_cuda_stream);
+  }
+
+  /// Getter
+  /// @return The stream on which the mesh is computed. Defaults to the mapper
+  /// stream.
+  std::shared_ptr<CudaStream> mesh_cuda_stream() const {
+    return mesh_integrator_.cuda_stream();
+  }
+  /// Setter. See mesh_cuda_stream(). Work on the mesh stream waits for the
+  /// work preceding it on the mapper stream, and work queued on the mapper
+  /// stream after updateMesh() waits for the meshing. Passing a low priority
+  /// stream lets latency-critical work on higher priority streams (e.g. the
+  /// ESDF) overtake the meshing.
+  /// @param mesh_cuda_stream The stream on which to compute the mesh.
+  void mesh_cuda_stream(std::shared_ptr<CudaStream> mesh_cuda_stream) {
+    mesh_integrator_.cuda_stream(mesh_cuda_stream);
+  }
+
+  /// Getter
+  /// @return The arena from which the integrators running on the mapper stream
+  /// allocate their temporary device buffers. It is reset once per integrated
+  /// frame.
+  const ScratchArena& scratch_arena() const { return scratch_arena_; }
+
+  /// Getter
+  /// @return Half the side length of the window used by updateEsdfInWindow().
+  float esdf_window_half_extent_m() const {
+    return esdf_window_half_extent_m_;
+  }
+  /// Setter. See esdf_window_half_extent_m()
+  /// @param esdf_window_half_extent_m The window half extent in meters.
+  void esdf_window_half_extent_m(const float esdf_window_half_extent_m) {
+    CHECK_GT(esdf_window_half_extent_m, 0.0f);
+    esdf_window_half_extent_m_ = esdf_window_half_extent_m;
+  }
+
+  /// A parameter getter
+  /// Whether the layers are preallocated for the workspace bounding box and
+  /// for loaded maps. See reserveBlocks().
+  /// @returns whether to preallocate.
+  bool preallocate_blocks() const { return preallocate_blocks_; }
+  /// A parameter setter
+  /// See preallocate_blocks(). Takes effect on the next call to
+  /// setMapperParams() or on loading a map.
+  /// @param preallocate_blocks whether to preallocate.
+  void preallocate_blocks(const bool preallocate_blocks) {
+    preallocate_blocks_ = preallocate_blocks;
+  }
+
+  /// A parameter getter
+  /// The fraction of device memory in use above which relieveMemoryPressure()
+  /// reduces the map. A value of 1 or larger disables the policy.
+  /// @returns the memory pressure watermark.
+  float memory_pressure_watermark() const {
+    return memory_pressure_watermark_;
+  }
+  /// A parameter setter
+  /// See memory_pressure_watermark()
+  /// @param memory_pressure_watermark the fraction of device memory.
+  void memory_pressure_watermark(const float memory_pressure_watermark) {
+    CHECK_GT(memory_pressure_watermark, 0.0f);
+    memory_pressure_watermark_ = memory_pressure_watermark;
+  }
+
+  /// A parameter getter
+  /// The radius around the center passed to relieveMemoryPressure() within
+  /// which the map is kept.
+  /// @returns the keep radius in meters.
+  float memory_pressure_keep_radius_m() const {
+    return memory_pressure_keep_radius_m_;
+  }
+  /// A parameter setter
+  /// See memory_pressure_keep_radius_m()
+  /// @param keep_radius_m the keep radius in meters.
+  void memory_pressure_keep_radius_m(const float keep_radius_m) {
+    CHECK_GT(keep_radius_m, 0.0f);
+    memory_pressure_keep_radius_m_ = keep_radius_m;
+  }
+
+  /// A parameter getter
+  /// Whether relieveMemoryPressure() pages the map out to host memory rather
+  /// than clearing it.
+  /// @returns true if the map is paged out.
+  bool memory_pressure_page_out() const { return memory_pressure_page_out_; }
+  /// A parameter setter
+  /// See memory_pressure_page_out()
+  /// @param memory_pressure_page_out whether to page out.
+  void memory_pressure_page_out(const bool memory_pressure_page_out) {
+    memory_pressure_page_out_ = memory_pressure_page_out;
+  }
+
+  /// A parameter getter
+  /// Whether the blocks of the layers are processed, and periodically laid
+  /// out in memory, in Morton order of their indices.
+  /// @returns true if the blocks are Morton ordered.
+  bool morton_ordered_blocks() const { return morton_ordered_blocks_; }
+  /// A parameter setter
+  /// See morton_ordered_blocks()
+  /// @param morton_ordered_blocks whether to Morton order the blocks.
+  void morton_ordered_blocks(const bool morton_ordered_blocks);
+
+  /// A parameter getter
+  /// The fraction of the allocated blocks which, once allocated since the
+  /// last layout, trigger relayoutBlocks().
+  /// @returns the allocation fraction.
+  float block_relayout_allocation_fraction() const {
+    return block_relayout_allocation_fraction_;
+  }
+  /// A parameter setter
+  /// See block_relayout_allocation_fraction()
+  /// @param allocation_fraction the allocation fraction.
+  void block_relayout_allocation_fraction(const float allocation_fraction) {
+    CHECK_GT(allocation_fraction, 0.0f);
+    block_relayout_allocation_fraction_ = allocation_fraction;
+  }
+
   /// Whether to exclude voxel contained observed in the the last depth frame
   /// passed to integrateDepth from the voxels which are decayed.
   bool exclude_last_view_from_decay() const {
@@ -515,17 +1130,101 @@ class Mapper : public MapperBase {
     exclude_last_view_from_decay_ = exclude_last_view_from_decay;
   }
 
+  /// A parameter getter
+  /// Whether a min/max/valid-count pyramid of each integrated depth frame is
+  /// built (see depth_pyramid()). The camera view calculators use it when
+  /// raycasting the frame.
+  /// @returns true if the pyramid is built.
+  bool build_depth_pyramid() const { return build_depth_pyramid_; }
+  /// A parameter setter
+  /// See build_depth_pyramid()
+  /// @param build_depth_pyramid
+  void build_depth_pyramid(const bool build_depth_pyramid);
+
+  /// The pyramid of the last depth frame integrated through the camera path,
+  /// if build_depth_pyramid() is set. Empty otherwise.
+  /// @returns The depth pyramid.
+  const DepthPyramid& depth_pyramid() const { return depth_pyramid_; }
+
+  /// A parameter getter
+  /// Whether integrateDepth() skips redundant depth frames.
+  /// @returns true if redundant frames are skipped.
+  bool skip_redundant_depth_frames() const {
+    return skip_redundant_depth_frames_;
+  }
+  /// A parameter setter
+  /// See skip_redundant_depth_frames()
+  /// @param skip_redundant_depth_frames
+  void skip_redundant_depth_frames(const bool skip_redundant_depth_frames) {
+    skip_redundant_depth_frames_ = skip_redundant_depth_frames;
+    depth_frame_gate_.reset();
+  }
+
+  /// A parameter getter
+  /// Whether integrateDepth() only integrates the depth pixels which changed
+  /// w.r.t. the reconstruction.
+  /// @returns true if unchanged pixels are removed.
+  bool gate_unchanged_depth_pixels() const {
+    return gate_unchanged_depth_pixels_;
+  }
+  /// A parameter setter
+  /// See gate_unchanged_depth_pixels()
+  /// @param gate_unchanged_depth_pixels
+  void gate_unchanged_depth_pixels(const bool gate_unchanged_depth_pixels) {
+    gate_unchanged_depth_pixels_ = gate_unchanged_depth_pixels;
+    depth_change_gate_.reset();
+  }
+
   /// Saving and loading functions.
-  /// Saving a map will serialize the TSDF and ESDF layers to a file.
+  /// Saving a map will serialize the TSDF and ESDF layers to a file. The mesh
+  /// is stored as well if save_derived_layers() is set.
   ///@param filename
   ///@return true
   ///@return false
   bool saveLayerCake(const std::string& filename) const;
   bool saveLayerCake(const char* filename) const;
+  /// Save the map in the binary map format, which is memory mapped on loading
+  /// and therefore loads much faster. Loaded through loadMap() as well.
+  bool saveLayerCakeBinary(const std::string& filename) const;
   /// Loading the map will load a the TSDF and ESDF layers from a file.
-  /// Will clear anything in the map already.
+  /// Will clear anything in the map already. The mesh is recomputed, unless
+  /// it was stored along with the TSDF (see save_derived_layers()).
   bool loadMap(const std::string& filename);
   bool loadMap(const char* filename);
+  /// Checkpoint the map to a log-structured file, which can be loaded with
+  /// loadMap(). The first checkpoint to a file (re)creates it with the full
+  /// map. Subsequent checkpoints only append the blocks changed or removed
+  /// since the previous one, making frequent checkpoints cheap. The file is
+  /// compacted in the background once it grows too large (see
+  /// CheckpointLog). Paged out blocks are checkpointed once paged in again and
+  /// blocks of a lazily loaded map which are still on disk are not included.
+  bool saveCheckpoint(const std::string& filename);
+  /// Open a map saved with saveLayerCakeBinary() in lazy mode: only the block
+  /// index is read. Blocks are loaded from disk when they come into view
+  /// during integration (like paged out blocks, see pageInBlocksInView()) or
+  /// through loadMapBlocksInRadius(). clearOutsideRadius() discards the
+  /// unloaded blocks outside the radius. Will clear anything in the map
+  /// already.
+  bool loadMapLazy(const std::string& filename);
+  /// Load a map on a background thread while mapping continues, e.g. after a
+  /// relocalization. Unlike loadMap() the live map is kept. Once loaded, the
+  /// blocks of the map are merged into the live layers by
+  /// mergeBackgroundLoadedMapBlocks(). Replaces any background load in
+  /// progress.
+  /// @param filename The map file, see loadMap().
+  void loadMapInBackground(const std::string& filename);
+  /// Merge blocks of the map loaded by loadMapInBackground() into the live
+  /// layers. Call repeatedly (e.g. once per frame) until the map is merged.
+  /// Loaded data yields to fresher observations: blocks which are allocated in
+  /// the live projective layer are kept as they are. The merged blocks are
+  /// marked for update.
+  /// @param max_num_blocks The maximum number of blocks to merge in this call.
+  /// @return The indices of the merged blocks. Empty while the map is loading
+  /// or if there is nothing (left) to merge.
+  std::vector<Index3D> mergeBackgroundLoadedMapBlocks(int max_num_blocks);
+  /// Whether a map passed to loadMapInBackground() is still being loaded or
+  /// merged.
+  bool isLoadingMapInBackground() const;
 
   /// Write mesh as a PLY
   /// @param filename Path to output PLY file.
@@ -552,6 +1251,18 @@ class Mapper : public MapperBase {
   /// @return bool Flag indicating if the write was successful.
   bool saveOccupancyAsPly(const std::string& filename) const;
 
+  /// Non-blocking versions of saveLayerCake(), saveMeshAsPly() and
+  /// saveEsdfAsPly(). Only snapshots of the layers are taken (see
+  /// BlockLayer::snapshot()), and the files are written on a background
+  /// thread while mapping continues. Layers whose blocks can't be snapshotted
+  /// (the ESDF and mesh) are copied to the host first. Must be called from the
+  /// thread which updates the layers.
+  /// @param filename Path to the output file.
+  /// @return A future holding whether the write was successful.
+  std::future<bool> saveLayerCakeAsync(const std::string& filename) const;
+  std::future<bool> saveMeshAsPlyAsync(const std::string& filename) const;
+  std::future<bool> saveEsdfAsPlyAsync(const std::string& filename) const;
+
   /// Return the parameter tree.
   /// @return the parameter tree
   virtual parameters::ParameterTreeNode getParameterTree(
@@ -578,21 +1289,86 @@ class Mapper : public MapperBase {
   void markBlocksForUpdate(const std::vector<Index3D>& blocks);
 
  protected:
-  /// Update the freespace layer, with an optional viewpoint.
-  void updateFreespace(Time update_time_ms,
-                       std::optional<ViewBasedInclusionData> view_to_update,
-                       UpdateFullLayer update_full_layer);
+  /// Update the freespace layer, with an optional viewpoint and optional
+  /// in-view masks precomputed for it.
+  void updateFreespace(
+      Time update_time_ms, std::optional<ViewBasedInclusionData> view_to_update,
+      UpdateFullLayer update_full_layer,
+      const std::optional<InViewVoxelMasks>& in_view_voxel_masks =
+          std::nullopt);
+
+  /// The occlusion distance used to test whether voxels are in view for the
+  /// freespace update.
+  float freespaceOcclusionDistanceM() const;
+
+  /// Load blocks of the lazily loaded map and mark them for update.
+  std::vector<Index3D> loadMapBlocks(const std::vector<Index3D>& indices);
+
+  /// Stop checkpointing, such that the next checkpoint is a full one.
+  void resetCheckpoint();
+
+  /// Serialize the highest priority mesh blocks within the byte budget (see
+  /// mesh_streaming_max_bytes_per_publish()).
+  void serializePrioritizedMeshBlocks(
+      const std::vector<Index3D>& blocks_to_serialize,
+      const BlockExclusionParams& exclusion_params,
+      const CudaStream& cuda_stream);
+
+  /// The prioritized mesh streamer, created on first use.
+  MeshLayerStreamerViewPriority& prioritizedMeshStreamer();
 
   /// Serialize layers needed for color visualization
   void serializeColorTsdfAndFreespaceLayers(
       const std::vector<Index3D>& blocks_to_serialize,
       const LayerTypeBitMask layer_type_bitmask,
       const float bandwidth_limit_mbps,
-      const BlockExclusionParams& exclusion_params);
+      const BlockExclusionParams& exclusion_params,
+      const CudaStream& cuda_stream);
 
   /// Perform preprocessing on a depth image
   const DepthImage& preprocessDepthImageAsync(
       const DepthImageConstView& depth_image);
+  const DepthImage& preprocessDepthImageAsync(
+      const DepthImageConstView& depth_image,
+      DepthImage* preprocessed_depth_image);
+
+  /// Integrate a depth image which has already been preprocessed (if
+  /// requested). Shared between the direct and pipelined integration.
+  /// If label_image is passed, its labels are integrated in to label_layer_.
+  void integratePreprocessedDepth(
+      const MaskedDepthImageConstView& depth_image_for_integration,
+      const Transform& T_L_C, const Camera& camera,
+      const MonoImageConstView* label_image = nullptr);
+
+  /// Pass the blocks updated by a depth integration to the tracker. The changed
+  /// voxel masks are only available for TSDF layers.
+  void addIntegratedBlocksToUpdate(
+      const std::vector<Index3D>& updated_blocks,
+      const std::optional<std::vector<VoxelBlockMask>>& updated_voxel_masks);
+
+  /// Apply the pending lazy TSDF decay to the blocks in view of a camera, ahead
+  /// of integrating into them. Does nothing if lazy decay is off.
+  void applyPendingTsdfDecay(const Transform& T_L_C, const Camera& camera);
+
+  /// Apply the pending lazy TSDF decay to the blocks within an AABB, ahead of
+  /// integrating into them. Does nothing if lazy decay is off.
+  void applyPendingTsdfDecay(const AxisAlignedBoundingBox& aabb);
+
+  /// Store a copy of the depth frame for the color integration (see
+  /// ProjectiveColorIntegrator::reuse_depth_frame()).
+  void storeColorDepthFrame(const DepthImageConstView& depth_image,
+                            const Transform& T_L_C, const Camera& camera,
+                            const std::vector<Index3D>& block_indices);
+
+  /// Returns true if the stored depth frame was taken from the viewpoint of
+  /// the color camera, such that it can be used for the color integration.
+  bool canReuseDepthFrameForColor(const ColorImage& color_frame,
+                                  const Transform& T_L_C,
+                                  const Camera& camera) const;
+
+  /// Store the viewpoint used for view-based decay exclusion.
+  void storeLastDepthView(const DepthImageConstView& depth_image,
+                          const Transform& T_L_C, const Camera& camera);
 
   /// @brief Get the esdf, mesh or freespace blocks that need and update.
   /// @param blocks_to_update_type The type of blocks you want to get the
@@ -604,13 +1380,80 @@ class Mapper : public MapperBase {
       BlocksToUpdateType blocks_to_update_type,
       UpdateFullLayer update_full_layer) const;
 
+  /// @brief Run the 3D ESDF integrator (for the current projective layer
+  /// type) on the passed blocks.
+  /// @param blocks_to_update Vector of blocks to update.
+  void integrateEsdfBlocks(const std::vector<Index3D>& blocks_to_update);
+  /// Same as above, reading the TSDF/occupancy (and freespace) blocks from the
+  /// passed layers instead of the mapper's.
+  void integrateEsdfBlocks(const std::vector<Index3D>& blocks_to_update,
+                           const LayerCake& input_layers);
+
+  /// Count a depth integration towards the TSDF pruning period and prune if a
+  /// pass is due. Pruning synchronizes the mapper stream once per pass.
+  void pruneTsdfBlocksIfDue();
+
+  /// Call relayoutBlocks() if morton_ordered_blocks() and enough blocks were
+  /// allocated since the last layout.
+  void relayoutBlocksIfDue();
+
+  /// Record the number of updated and allocated blocks in the
+  /// timing::FlightRecorder, if it's enabled.
+  void recordBlockCounts(size_t num_updated_blocks) const;
+
+  /// Reserve blocks (see reserveBlocks()) for the workspace bounding box and
+  /// the blocks of the map, if preallocate_blocks().
+  void preallocateBlocks();
+
+  /// Let the integrators running on the mapper stream allocate their
+  /// temporary buffers from scratch_arena_.
+  void shareScratchArena();
+
+  /// Let the camera integrators and the sphere tracer share the ray tables in
+  /// camera_ray_cache_.
+  void shareCameraRayCache();
+
   /// @brief Deallocate blocks int the esdf, mesh and freespace layer.
   /// @param blocks_to_clear Vector of blocks to clear.
   void clearBlocksInLayers(const std::vector<Index3D>& blocks_to_clear);
 
+  /// Deallocate blocks in the layers written on the integration thread only,
+  /// i.e. as clearBlocksInLayers() but without the esdf layer.
+  /// @param blocks_to_clear Vector of blocks to clear.
+  void clearBlocksInIntegrationLayers(
+      const std::vector<Index3D>& blocks_to_clear);
+
+  /// Deallocate the esdf blocks of cleared projective blocks. In 2D, an esdf
+  /// block is only cleared if its column holds no other projective block.
+  /// @param blocks_to_clear Vector of cleared projective blocks.
+  /// @param cuda_stream The stream to clear on.
+  void clearEsdfBlocks(const std::vector<Index3D>& blocks_to_clear,
+                       const CudaStream& cuda_stream);
+
+  /// Queue blocks for removal from the esdf layer by the next esdf update,
+  /// for use on the integration thread while the ESDF thread may be updating
+  /// the esdf layer (see updateEsdfFromSnapshot()).
+  /// @param block_indices The blocks to remove.
+  void queueEsdfBlockRemovals(const std::vector<Index3D>& block_indices);
+
+  /// Take the blocks queued by queueEsdfBlockRemovals().
+  /// @return The blocks to remove from the esdf layer.
+  std::vector<Index3D> takeQueuedEsdfBlockRemovals();
+
   /// The CUDA stream that mapper work is processed on
   std::shared_ptr<CudaStream> cuda_stream_;
 
+  /// The per-voxel class labels. Only allocated once labels are integrated,
+  /// and not part of layers_ such that it isn't serialized or streamed.
+  std::unique_ptr<LabelLayer> label_layer_;
+
+  /// Shared per-frame temporary device memory. See scratch_arena().
+  ScratchArena scratch_arena_;
+
+  /// Ray tables of the cameras integrated, shared between components.
+  std::shared_ptr<CameraRayCache> camera_ray_cache_ =
+      std::make_shared<CameraRayCache>();
+
   /// The size of the voxels to be used in the TSDF, ESDF, Color layers.
   float voxel_size_m_;
   /// The storage location for the TSDF, ESDF, Color, and Mesh Layers.
@@ -625,22 +1468,97 @@ class Mapper : public MapperBase {
   /// in.
   EsdfMode esdf_mode_ = EsdfMode::kUnset;
 
+  /// The window used by updateEsdfInWindow() and the one used on its previous
+  /// call, if any. Blocks outside the previous window have no valid ESDF.
+  float esdf_window_half_extent_m_ =
+      kEsdfWindowHalfExtentMParamDesc.default_value;
+  std::optional<AxisAlignedBoundingBox> last_esdf_window_;
+
+  /// See preallocate_blocks().
+  bool preallocate_blocks_ = kPreallocateBlocksParamDesc.default_value;
+
+  /// The policy of relieveMemoryPressure().
+  float memory_pressure_watermark_ =
+      kMemoryPressureWatermarkParamDesc.default_value;
+  float memory_pressure_keep_radius_m_ =
+      kMemoryPressureKeepRadiusMParamDesc.default_value;
+  bool memory_pressure_page_out_ =
+      kMemoryPressurePageOutParamDesc.default_value;
+
+  /// See morton_ordered_blocks().
+  bool morton_ordered_blocks_ = kMortonOrderedBlocksParamDesc.default_value;
+  float block_relayout_allocation_fraction_ =
+      kBlockRelayoutAllocationFractionParamDesc.default_value;
+
+  /// The input blocks of an ESDF update, see snapshotEsdfInput().
+  struct EsdfInputSnapshot {
+    LayerCake layers;
+    Index3DSet block_indices;
+  };
+  /// Double buffer of snapshots. snapshotEsdfInput() writes to the pending
+  /// snapshot, which updateEsdfFromSnapshot() swaps with the active one before
+  /// computing the ESDF. Both are allocated on first use.
+  std::unique_ptr<EsdfInputSnapshot> pending_esdf_snapshot_;
+  std::unique_ptr<EsdfInputSnapshot> active_esdf_snapshot_;
+  /// Guards the pending snapshot and its event, and
+  /// queued_esdf_block_removals_.
+  std::mutex esdf_snapshot_mutex_;
+  /// See queueEsdfBlockRemovals().
+  Index3DSet queued_esdf_block_removals_;
+  /// Marks the end of the copy into the pending snapshot.
+  CudaEvent esdf_snapshot_event_;
+  /// Used to make the ESDF stream wait for the mapper stream, if they differ.
+  CudaEvent esdf_input_event_;
+  /// Used to order the mesh stream and the mapper stream, if they differ.
+  CudaEvent mesh_input_event_;
+  CudaEvent mesh_output_event_;
+
   /// Integrators
   ProjectiveTsdfIntegrator tsdf_integrator_;
   ProjectiveTsdfIntegrator lidar_tsdf_integrator_;
+  PointcloudTsdfIntegrator lidar_pointcloud_tsdf_integrator_;
   FreespaceIntegrator freespace_integrator_;
   ProjectiveOccupancyIntegrator occupancy_integrator_;
   ProjectiveOccupancyIntegrator lidar_occupancy_integrator_;
   OccupancyDecayIntegrator occupancy_decay_integrator_;
   TsdfDecayIntegrator tsdf_decay_integrator_;
+  TsdfBlockPruner tsdf_block_pruner_;
   TsdfShapeClearer tsdf_shape_clearer_;
   ProjectiveColorIntegrator color_integrator_;
   MeshIntegrator mesh_integrator_;
   EsdfIntegrator esdf_integrator_;
+  DenseEsdfSliceIntegrator dense_esdf_slice_integrator_;
+  EsdfCollisionChecker collision_checker_;
 
   // Layer Streamers
   LayerCakeStreamer layer_streamers_;
 
+  // Fuses blocks of other maps into the layers
+  SerializedLayerMerger serialized_layer_merger_;
+
+  /// Concurrent serialization of layers. Each layer is serialized on its own
+  /// stream from the pool (grown on demand), after waiting for the mapper
+  /// stream.
+  bool concurrent_layer_serialization_ =
+      kConcurrentLayerSerializationParamDesc.default_value;
+  std::vector<std::shared_ptr<CudaStream>> serialization_cuda_streams_;
+  CudaEvent serialization_start_event_;
+
+  /// Prioritized, byte-budgeted mesh streaming. Created on first use, since
+  /// the mesh block size is only known once the map is loaded.
+  int mesh_streaming_max_bytes_per_publish_ =
+      kMeshStreamingMaxBytesPerPublishParamDesc.default_value;
+  float mesh_streaming_distance_weight_ =
+      kMeshStreamingDistanceWeightParamDesc.default_value;
+  float mesh_streaming_staleness_weight_ =
+      kMeshStreamingStalenessWeightParamDesc.default_value;
+  std::unique_ptr<MeshLayerStreamerViewPriority> prioritized_mesh_streamer_;
+
+  /// Whether saveLayerCake() compresses the voxel blocks.
+  bool compress_saved_maps_ = kCompressSavedMapsParamDesc.default_value;
+  /// Whether saveLayerCake() stores the ESDF and mesh.
+  bool save_derived_layers_ = kSaveDerivedLayersParamDesc.default_value;
+
   /// Preprocessing depth maps prior to integration.
   /// Currently, the only preprocessing step is to dilate the invalid regions
   /// of the input depth image. We have found this useful to reduce the
@@ -649,8 +1567,49 @@ class Mapper : public MapperBase {
   int depth_preprocessing_num_dilations_ =
       kDepthPreprocessingNumDilationsParamDesc.default_value;
   DepthPreprocessor depth_preprocessor_;
+  /// Min/max/valid-count pyramid of the integrated depth frame.
+  bool build_depth_pyramid_ = kBuildDepthPyramidParamDesc.default_value;
+  DepthPyramid depth_pyramid_;
+  /// Skipping of redundant depth frames in integrateDepth().
+  bool skip_redundant_depth_frames_ =
+      kSkipRedundantDepthFramesParamDesc.default_value;
+  DepthFrameGate depth_frame_gate_;
+  /// Removal of unchanged depth pixels before the projective integration.
+  bool gate_unchanged_depth_pixels_ =
+      kGateUnchangedDepthPixelsParamDesc.default_value;
+  DepthChangeGate depth_change_gate_;
   std::shared_ptr<DepthImage> preprocessed_depth_image_ =
       std::make_shared<DepthImage>(MemoryType::kDevice);
+  /// Preprocessing buffers for batched depth integration. One per frame in the
+  /// largest batch seen so far.
+  std::vector<std::unique_ptr<DepthImage>> batch_preprocessed_depth_images_;
+
+  /// A depth frame staged for pipelined integration.
+  struct StagedDepthFrame {
+    DepthImage depth_image{MemoryType::kDevice};
+    MonoImage mask{MemoryType::kDevice};
+    bool has_mask = false;
+    Transform T_L_C;
+    Camera camera;
+    /// Marks the end of the copy and preprocessing on the staging stream.
+    CudaEvent staged_event;
+    /// Marks the end of the integration on the mapper stream, after which the
+    /// buffers may be reused.
+    CudaEvent integrated_event;
+  };
+  /// Ring buffer of staged frames, allocated on first use. The image buffers
+  /// are only allocated once a frame is staged into them.
+  std::vector<std::unique_ptr<StagedDepthFrame>> staged_depth_frames_;
+  int next_staged_depth_frame_idx_ = 0;
+  int num_staged_depth_frames_ = 0;
+  /// Stream and preprocessor (which holds its own scratch images) used for
+  /// staging.
+  struct DepthStagingLane {
+    std::shared_ptr<CudaStream> cuda_stream;
+    std::unique_ptr<DepthPreprocessor> depth_preprocessor;
+  };
+  /// The staging lanes, indexed by stageDepthAsync()'s staging_lane.
+  std::vector<DepthStagingLane> depth_staging_lanes_;
 
   /// Helper to keep track of which blocks need to be updated on the next
   /// calls to updateMesh(), updateFreespace() upd updateEsdf() respectively.
@@ -659,6 +1618,22 @@ class Mapper : public MapperBase {
   /// Keeping track of the mesh blocks that got deleted in the mesh layer.
   Index3DSet cleared_blocks_;
 
+  /// Which blocks clearOutsideRadius() clears, one flag per block.
+  device_vector<bool> blocks_outside_radius_device_;
+  host_vector<bool> blocks_outside_radius_host_;
+
+  /// The map opened by loadMapLazy(), holding the blocks still on disk.
+  std::unique_ptr<LazyBinaryMapLoader> lazy_map_loader_;
+
+  /// The log written by saveCheckpoint().
+  std::unique_ptr<CheckpointLog> checkpoint_log_;
+
+  /// The map loaded by loadMapInBackground(), and the blocks of it still to be
+  /// merged. The future is valid while the map is being loaded.
+  std::future<LayerCake> background_map_future_;
+  std::unique_ptr<LayerCake> background_map_;
+  std::vector<Index3D> background_map_blocks_to_merge_;
+
   /// Whether to exclude the last depth frustum from the decay
   bool exclude_last_view_from_decay_ =
       kExcludeLastViewFromDecayParamDesc.default_value;
@@ -666,6 +1641,28 @@ class Mapper : public MapperBase {
   std::optional<DepthImage> last_depth_image_;
   std::optional<Camera> last_depth_camera_;
   std::optional<Transform> last_depth_T_L_C_;
+
+  /// The view of the last TSDF integration for which the integrator recorded
+  /// in-view voxel masks. Used by updateFreespace() to skip re-projecting the
+  /// voxels if called with the same view.
+  struct InViewFrame {
+    const float* depth_image_ptr;
+    Transform T_L_C;
+    Camera camera;
+    std::vector<Index3D> block_indices;
+  };
+  std::optional<InViewFrame> last_in_view_frame_;
+
+  /// Copy of the last integrated depth frame, kept for the color integration
+  /// if color_integrator().reuse_depth_frame() is set. Used instead of a sphere
+  /// traced depth image if the color frame is taken from the same viewpoint.
+  struct ColorDepthFrame {
+    DepthImage depth_image{MemoryType::kDevice};
+    Transform T_L_C;
+    Camera camera;
+    std::vector<Index3D> block_indices;
+  };
+  std::optional<ColorDepthFrame> last_color_depth_frame_;
 };
 
 }  // namespace nvblox
@@ -23,7 +23,10 @@ limitations under the License.
 #include "nvblox/integrators/projective_integrator_params.h"
 #include "nvblox/integrators/projective_occupancy_integrator.h"
 #include "nvblox/integrators/projective_tsdf_integrator.h"
+#include "nvblox/integrators/tsdf_block_pruner.h"
 #include "nvblox/integrators/tsdf_decay_integrator.h"
+#include "nvblox/mapper/depth_change_gate_params.h"
+#include "nvblox/mapper/depth_frame_gate_params.h"
 #include "nvblox/mesh/mesh_integrator.h"
 #include "nvblox/utils/params.h"
 
@@ -41,6 +44,111 @@ constexpr Param<int>::Description kDepthPreprocessingNumDilationsParamDesc{
     "Number of times to run the invalid region dilation in the depth "
     "preprocessing pipeline (if do_depth_preprocessing is enabled)."};
 
+constexpr Param<bool>::Description kSkipRedundantDepthFramesParamDesc{
+    "skip_redundant_depth_frames", false,
+    "Whether integrateDepth() skips depth frames which are redundant with the "
+    "last integrated frame, i.e. the camera barely moved and the depth barely "
+    "changed. Saves GPU time, e.g. while the robot is parked."};
+
+constexpr Param<bool>::Description kGateUnchangedDepthPixelsParamDesc{
+    "gate_unchanged_depth_pixels", false,
+    "Whether integrateDepth() only integrates the pixels whose depth differs "
+    "from the reconstructed surface, with periodic full frames. Saves "
+    "integration, mesh and ESDF work in static scenes. TSDF mapping only."};
+
+constexpr Param<bool>::Description kUseCudaGraphsParamDesc{
+    "use_cuda_graphs", false,
+    "Whether to capture the kernels of the depth preprocessing pipeline into "
+    "a CUDA graph and replay it for subsequent frames, reducing kernel launch "
+    "overhead. The graph is re-captured when the image size or the "
+    "preprocessing parameters change."};
+
+constexpr Param<bool>::Description kUseVpiDepthPreprocessingParamDesc{
+    "use_vpi_depth_preprocessing", false,
+    "Whether to run the invalid region dilations of the depth preprocessing "
+    "on the PVA engine through VPI, leaving the GPU free for integration. "
+    "Only available on Jetson with nvblox built with USE_VPI."};
+
+constexpr Param<bool>::Description kBuildDepthPyramidParamDesc{
+    "build_depth_pyramid", false,
+    "Whether to build a min/max/valid-count mip pyramid of each (preprocessed) "
+    "depth frame. The camera view calculators then cast each subsampled ray "
+    "to the max depth of the pixels it represents, rather than sampling a "
+    "single pixel, and skip patches without valid depth."};
+
+// ======= SERIALIZATION =======
+constexpr Param<bool>::Description kConcurrentLayerSerializationParamDesc{
+    "concurrent_layer_serialization", false,
+    "Whether serializeSelectedLayers() serializes the selected layers "
+    "concurrently, each on its own CUDA stream, such that the serialization "
+    "kernels and device-to-host copies of the layers overlap."};
+constexpr Param<int>::Description kMeshStreamingMaxBytesPerPublishParamDesc{
+    "mesh_streaming_max_bytes_per_publish", 0,
+    "If positive, serializeSelectedLayers() streams at most this many bytes "
+    "of mesh blocks per call, selecting the blocks by priority (closeness to "
+    "the robot and time waited) rather than by age and estimated bandwidth. "
+    "serializedMeshLayer() then returns these blocks. 0 disables."};
+constexpr Param<float>::Description kMeshStreamingDistanceWeightParamDesc{
+    "mesh_streaming_distance_weight", 1.0f,
+    "The priority subtracted per meter of distance between a mesh block and "
+    "the robot, when mesh_streaming_max_bytes_per_publish is set."};
+constexpr Param<float>::Description kMeshStreamingStalenessWeightParamDesc{
+    "mesh_streaming_staleness_weight", 1.0f,
+    "The priority added for each call a mesh block waited to be streamed, "
+    "when mesh_streaming_max_bytes_per_publish is set. Ensures that far-away "
+    "blocks are eventually streamed."};
+constexpr Param<bool>::Description kPreallocateBlocksParamDesc{
+    "preallocate_blocks", false,
+    "Whether to preallocate the block pools and GPU hashes of the layers for "
+    "all blocks within the workspace bounding box (if any) and for all blocks "
+    "of a loaded map, such that they never grow while mapping. Beware that "
+    "this allocates the memory of a fully mapped workspace up front."};
+constexpr Param<bool>::Description kCompressSavedMapsParamDesc{
+    "compress_saved_maps", false,
+    "Whether saveLayerCake() compresses the voxel blocks of the map. This "
+    "shrinks the saved file, at the cost of decompressing the blocks when "
+    "loading."};
+constexpr Param<bool>::Description kSaveDerivedLayersParamDesc{
+    "save_derived_layers", false,
+    "Whether saveLayerCake() also stores the ESDF and the mesh, tagged with a "
+    "fingerprint of the TSDF. loadMap() restores them instead of recomputing "
+    "them if they match the loaded TSDF, such that the map is usable right "
+    "after loading. Only applies if the ESDF and mesh are up to date."};
+
+// ======= ESDF =======
+constexpr Param<float>::Description kEsdfWindowHalfExtentMParamDesc{
+    "esdf_window_half_extent_m", 5.0f,
+    "Half the side length of the axis-aligned, robot-centred window to which "
+    "updateEsdfInWindow() limits the 3D ESDF. ESDF blocks outside the window "
+    "are cleared."};
+
+// ======= MEMORY PRESSURE =======
+constexpr Param<float>::Description kMemoryPressureWatermarkParamDesc{
+    "memory_pressure_watermark", 1.0f,
+    "The fraction of device memory in use above which "
+    "relieveMemoryPressure() clears (or pages out) the map outside "
+    "memory_pressure_keep_radius_m. A value of 1 or larger disables it."};
+constexpr Param<float>::Description kMemoryPressureKeepRadiusMParamDesc{
+    "memory_pressure_keep_radius_m", 10.0f,
+    "The radius around the robot within which the map is kept when "
+    "relieving memory pressure."};
+constexpr Param<bool>::Description kMemoryPressurePageOutParamDesc{
+    "memory_pressure_page_out", false,
+    "Whether to page the map out to host memory rather than clearing it when "
+    "relieving memory pressure."};
+
+// ======= BLOCK LAYOUT =======
+constexpr Param<bool>::Description kMortonOrderedBlocksParamDesc{
+    "morton_ordered_blocks", false,
+    "Whether the blocks of the layers are processed, and periodically laid "
+    "out in memory, in Morton (Z-order) order of their indices. This improves "
+    "the cache locality of kernels accessing neighbouring blocks."};
+constexpr Param<float>::Description kBlockRelayoutAllocationFractionParamDesc{
+    "block_relayout_allocation_fraction", 0.5f,
+    "If morton_ordered_blocks, the blocks are laid out again once the number "
+    "of blocks allocated since the last layout exceeds this fraction of the "
+    "allocated blocks."};
+
 // ======= DECAY =======
 constexpr Param<bool>::Description kExcludeLastViewFromDecayParamDesc{
     "exclude_last_view_from_decay", false,
@@ -53,14 +161,41 @@ struct MapperParams {
   Param<bool> do_depth_preprocessing{kDoDepthPrepocessingParamDesc};
   Param<int> depth_preprocessing_num_dilations{
       kDepthPreprocessingNumDilationsParamDesc};
+  Param<bool> skip_redundant_depth_frames{kSkipRedundantDepthFramesParamDesc};
+  Param<bool> gate_unchanged_depth_pixels{kGateUnchangedDepthPixelsParamDesc};
+  Param<bool> use_cuda_graphs{kUseCudaGraphsParamDesc};
+  Param<bool> use_vpi_depth_preprocessing{kUseVpiDepthPreprocessingParamDesc};
+  Param<bool> build_depth_pyramid{kBuildDepthPyramidParamDesc};
+  Param<bool> concurrent_layer_serialization{
+      kConcurrentLayerSerializationParamDesc};
+  Param<int> mesh_streaming_max_bytes_per_publish{
+      kMeshStreamingMaxBytesPerPublishParamDesc};
+  Param<float> mesh_streaming_distance_weight{
+      kMeshStreamingDistanceWeightParamDesc};
+  Param<float> mesh_streaming_staleness_weight{
+      kMeshStreamingStalenessWeightParamDesc};
+  Param<bool> compress_saved_maps{kCompressSavedMapsParamDesc};
+  Param<bool> save_derived_layers{kSaveDerivedLayersParamDesc};
+  Param<bool> preallocate_blocks{kPreallocateBlocksParamDesc};
+  Param<float> esdf_window_half_extent_m{kEsdfWindowHalfExtentMParamDesc};
+  Param<float> memory_pressure_watermark{kMemoryPressureWatermarkParamDesc};
+  Param<float> memory_pressure_keep_radius_m{
+      kMemoryPressureKeepRadiusMParamDesc};
+  Param<bool> memory_pressure_page_out{kMemoryPressurePageOutParamDesc};
+  Param<bool> morton_ordered_blocks{kMortonOrderedBlocksParamDesc};
+  Param<float> block_relayout_allocation_fraction{
+      kBlockRelayoutAllocationFractionParamDesc};
   Param<bool> exclude_last_view_from_decay{kExcludeLastViewFromDecayParamDesc};
 
+  DepthFrameGateParams depth_frame_gate_params;
+  DepthChangeGateParams depth_change_gate_params;
   EsdfIntegratorParams esdf_integrator_params;
   ProjectiveIntegratorParams projective_integrator_params;
   ViewCalculatorParams view_calculator_params;
   OccupancyIntegratorParams occupancy_integrator_params;
   MeshIntegratorParams mesh_integrator_params;
   TsdfDecayIntegratorParams tsdf_decay_integrator_params;
+  TsdfBlockPrunerParams tsdf_block_pruner_params;
   DecayIntegratorBaseParams decay_integrator_base_params;
   OccupancyDecayIntegratorParams occupancy_decay_integrator_params;
   FreespaceIntegratorParams freespace_integrator_params;
@@ -15,6 +15,11 @@ limitations under the License.
 */
 #pragma once
 
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
 #include "nvblox/experimental/ground_plane/ground_plane_estimator.h"
 #include "nvblox/mapper/mapper.h"
 #include "nvblox/mapper/multi_mapper_params.h"
@@ -119,13 +124,23 @@ class MultiMapper {
   /// @param esdf_mode 2D or 3D. See EsdfMode.
   /// @param memory_type In which type of memory the layers should be stored.
   /// @param cuda_stream Optional cuda stream to perform all work on.
+  /// @param foreground_cuda_device Optional CUDA device to run the foreground
+  /// mapper on, e.g. to offload dynamic/human mapping to a second GPU. The
+  /// foreground mapper's layers then reside on that device, and it reads the
+  /// (masked) input frames from the primary device peer-to-peer. Defaults to
+  /// the current device. Note that work on foreground_mapper() has to be
+  /// issued with that device set (see ScopedCudaDevice).
   MultiMapper(float voxel_size_m, MappingType mapping_type, EsdfMode esdf_mode,
               MemoryType memory_type = MemoryType::kDevice,
               std::shared_ptr<CudaStream> cuda_stream =
-                  std::make_shared<CudaStreamOwning>());
-  ~MultiMapper() = default;
+                  std::make_shared<CudaStreamOwning>(),
+              std::optional<int> foreground_cuda_device = std::nullopt);
+  ~MultiMapper();
 
   /// @brief Setting the multi mapper param struct
+  /// If the foreground voxel size or memory type changes, the foreground
+  /// mapper is recreated (with the params passed to setMapperParams()), which
+  /// drops its map. Set them before integrating.
   /// @param multi_mapper_params the param struct
   void setMultiMapperParams(const MultiMapperParams& multi_mapper_params);
 
@@ -198,6 +213,27 @@ class MultiMapper {
                       const Camera& depth_camera,
                       const Camera& detection_boxes_camera);
 
+  /// @brief Integrates a depth and a color frame with the same mask into the
+  /// reconstruction (for mapping type
+  /// kHumanWithStaticTsdf/kHumanWithStaticOccupancy).
+  /// Equivalent to integrateDepth() followed by integrateColor() with the
+  /// mask, but the mask is cleaned once and both frames are split in a single
+  /// pass. Assumes the color and mask images come from the same camera.
+  ///@param depth_frame Depth frame to integrate.
+  ///@param color_frame Color image to integrate.
+  ///@param mask Mask. Interpreted as 0=background, >0=foreground.
+  ///@param T_L_CD Pose of the depth camera in the layer frame.
+  ///@param T_L_C Pose of the color camera in the layer frame.
+  ///@param T_CM_CD Transform from depth camera to mask camera frame.
+  ///@param depth_camera Intrinsics model of the depth camera.
+  ///@param color_camera Intrinsics model of the color (and mask) camera.
+  void integrateDepthAndColor(const DepthImage& depth_frame,
+                              const ColorImage& color_frame,
+                              const MonoImage& mask, const Transform& T_L_CD,
+                              const Transform& T_L_C, const Transform& T_CM_CD,
+                              const Camera& depth_camera,
+                              const Camera& color_camera);
+
   /// @brief Integrates a color frame into the reconstruction (for mapping
   /// type kStaticTsdf/kStaticOccupancy/kDynamic).
   /// @param color_frame Color image to integrate.
@@ -246,6 +282,15 @@ class MultiMapper {
   std::shared_ptr<Mapper> background_mapper() { return background_mapper_; }
   /// Access to one of the mappers
   std::shared_ptr<Mapper> foreground_mapper() { return foreground_mapper_; }
+  /// The CUDA device the foreground mapper runs on.
+  int foreground_cuda_device() const { return foreground_cuda_device_; }
+
+  /// Whether the work on the background and foreground mappers runs
+  /// concurrently (the default) or one after the other, e.g. for debugging.
+  bool parallel_mapper_updates() const { return parallel_mapper_updates_; }
+  void parallel_mapper_updates(bool parallel_mapper_updates) {
+    parallel_mapper_updates_ = parallel_mapper_updates;
+  }
 
   /// Getter
   ///@return GroundPlaneEstimator& ground_plane_estimator
@@ -274,6 +319,32 @@ class MultiMapper {
   virtual std::string getParametersAsString() const;
 
  protected:
+  // (Re)creates the foreground mapper on the foreground device and lets the
+  // integrators of both mappers share their viewpoint caches.
+  void createForegroundMapper(float voxel_size_m, MemoryType memory_type);
+
+  // Runs the work on the background and foreground mappers concurrently and
+  // returns once both are done. The mappers share no layers and work on their
+  // own CUDA streams, so the work also overlaps on the GPU. The foreground
+  // work runs on foreground_worker_, with the foreground device set.
+  void runOnBothMappers(const std::function<void()>& background_work,
+                        const std::function<void()>& foreground_work);
+
+  // The loop of foreground_worker_, running the foreground work passed by
+  // runOnBothMappers() until the multi mapper is destroyed.
+  void runForegroundWorker();
+
+  // The foreground depth frame of human mapping, as integrated.
+  struct ForegroundDepthFrame {
+    const DepthImage* depth_frame;
+    Camera camera;
+  };
+  // Get the foreground depth frame to integrate, cropped to the masked region
+  // if crop_foreground_depth_to_mask is set. Returns nullopt if nothing is
+  // masked.
+  std::optional<ForegroundDepthFrame> getForegroundDepthFrameForIntegration(
+      const Camera& depth_camera);
+
   // Performs the esdf update on the passed mapper
   void updateEsdfOfMapper(const std::shared_ptr<Mapper> mapper,
                           std::optional<Plane> ground_plane = std::nullopt);
@@ -281,6 +352,15 @@ class MultiMapper {
   // Mapping type needed on construction
   const MappingType mapping_type_;
   const EsdfMode esdf_mode_;
+  // The voxel size and memory type passed on construction, used by the
+  // background mapper (and the foreground mapper unless overridden).
+  const float voxel_size_m_;
+  const MemoryType memory_type_;
+  MemoryType foreground_memory_type_;
+
+  // The params last passed to the foreground mapper, applied again if it's
+  // recreated.
+  std::optional<MapperParams> foreground_mapper_params_;
 
   // Parameter struct for multi mapper
   MultiMapperParams params_;
@@ -298,6 +378,7 @@ class MultiMapper {
   ImageMasker image_masker_;
   DepthImage depth_frame_background_{MemoryType::kDevice};
   DepthImage depth_frame_foreground_{MemoryType::kDevice};
+  DepthImage depth_frame_foreground_cropped_{MemoryType::kDevice};
   ColorImage color_frame_background_{MemoryType::kDevice};
   ColorImage color_frame_foreground_{MemoryType::kDevice};
 
@@ -306,6 +387,7 @@ class MultiMapper {
   ColorImage foreground_color_overlay_{MemoryType::kDevice};
 
   // The two mappers to which the frames are integrated.
+  int foreground_cuda_device_;
   std::shared_ptr<Mapper> foreground_mapper_;
   std::shared_ptr<Mapper> background_mapper_;
 
@@ -317,6 +399,17 @@ class MultiMapper {
 
   // The CUDA stream on which to process all work
   std::shared_ptr<CudaStream> cuda_stream_;
+
+  // See parallel_mapper_updates().
+  bool parallel_mapper_updates_ = true;
+
+  // The thread running the foreground work of runOnBothMappers(), started on
+  // first use. The mutex guards the work handed to it and the stop flag.
+  std::thread foreground_worker_;
+  std::mutex foreground_work_mutex_;
+  std::condition_variable foreground_work_condition_;
+  const std::function<void()>* foreground_work_ = nullptr;
+  bool stop_foreground_worker_ = false;
 };
 
 }  // namespace nvblox
@@ -40,6 +40,29 @@ constexpr Param<float>::Description
         "Distance in meters to the depth histogram mode for a depth "
         "pixel to be classified as masked."};
 
+constexpr Param<bool>::Description kCropForegroundDepthToMaskParamDesc{
+    "crop_foreground_depth_to_mask", true,
+    "If set to true, the foreground depth frame of human mapping is cropped "
+    "to the bounding box of the masked pixels before integration, such that "
+    "the cost of the foreground integration scales with the masked region."};
+
+// ======= FOREGROUND MAPPER =======
+constexpr Param<float>::Description kForegroundVoxelSizeMParamDesc{
+    "foreground_voxel_size_m", 0.0f,
+    "The voxel size of the foreground (dynamic/human) mapper. Humans and "
+    "dynamic obstacles typically only need coarse occupancy. Values <= 0 use "
+    "the voxel size of the background mapper."};
+
+constexpr Param<bool>::Description kForegroundOccupancyOnlyParamDesc{
+    "foreground_occupancy_only", false,
+    "If set to true, the foreground mapper only maps occupancy (and the ESDF "
+    "derived from it), i.e. the foreground color is not integrated."};
+
+constexpr Param<bool>::Description kForegroundUseDeviceMemoryParamDesc{
+    "foreground_use_device_memory", false,
+    "If set to true, the layers of the foreground mapper are stored in device "
+    "memory, independent of the memory type of the background mapper."};
+
 /// A structure containing the multi-mapper parameters.
 struct MultiMapperParams {
   Param<int> connected_mask_component_size_threshold{
@@ -49,6 +72,12 @@ struct MultiMapperParams {
   float segmentation_mask_mode_proximity_threshold =
       kSegmentationMaskModeProximityThresholdParamDesc.default_value;
   Param<bool> use_ground_plane_estimation{kUseGroundPlaneEstimationDesc};
+  Param<bool> crop_foreground_depth_to_mask{
+      kCropForegroundDepthToMaskParamDesc};
+  Param<float> foreground_voxel_size_m{kForegroundVoxelSizeMParamDesc};
+  Param<bool> foreground_occupancy_only{kForegroundOccupancyOnlyParamDesc};
+  Param<bool> foreground_use_device_memory{
+      kForegroundUseDeviceMemoryParamDesc};
 
   RansacPlaneFitterParams ransac_plane_fitter_params;
   GroundPlaneEstimatorParams ground_plane_estimator_params;
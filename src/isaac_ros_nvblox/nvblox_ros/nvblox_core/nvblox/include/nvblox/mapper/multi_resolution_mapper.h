@@ -0,0 +1,185 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#pragma once
+
+#include "nvblox/mapper/mapper.h"
+#include "nvblox/mapper/multi_resolution_mapper_params.h"
+
+namespace nvblox {
+
+/// The MultiResolutionMapper class is composed of two standard Mappers which
+/// map the same scene at different resolutions.
+/// Setup:
+/// - fine mapper: Integrates depth up to fine_level_max_integration_distance_m
+///                at the nominal voxel size. Provides detailed geometry near
+///                the robot.
+/// - coarse mapper: Integrates depth downscaled by
+///                  coarse_level_depth_downscale_factor up to
+///                  coarse_level_max_integration_distance_m, at a voxel size
+///                  coarse_voxel_size_factor times the nominal voxel size.
+///
+/// Because the fine level only covers a near band, the number of fine blocks
+/// is bounded by the near range rather than by the full sensor range. ESDF
+/// queries are answered by the fine level where it is observed and fall back
+/// to the coarse level elsewhere.
+///
+/// As the robot moves on, fine blocks it left behind can be dropped where the
+/// coarse level represents them well (see coarsenFineLevel()), such that, e.g.,
+/// large flat floors are only stored at the coarse resolution. Coming back
+/// within the fine integration distance refines them again.
+class MultiResolutionMapper {
+ public:
+  /// Constructor
+  /// @param voxel_size_m The voxel size in meters of the fine level.
+  /// @param coarse_voxel_size_factor The voxel size of the coarse level as a
+  ///        multiple of voxel_size_m.
+  /// @param projective_layer_type The layer type to which the projective
+  ///        data is integrated (either tsdf or occupancy).
+  /// @param memory_type In which type of memory the layers should be stored.
+  /// @param cuda_stream Optional cuda stream to perform all work on.
+  MultiResolutionMapper(
+      float voxel_size_m, int coarse_voxel_size_factor = 4,
+      ProjectiveLayerType projective_layer_type = ProjectiveLayerType::kTsdf,
+      MemoryType memory_type = MemoryType::kDevice,
+      std::shared_ptr<CudaStream> cuda_stream =
+          std::make_shared<CudaStreamOwning>());
+  ~MultiResolutionMapper() = default;
+
+  /// @brief Setting the multi-resolution mapper param struct
+  /// @param params the param struct
+  void setMultiResolutionMapperParams(
+      const MultiResolutionMapperParams& params);
+
+  /// @brief Setting the mapper param struct to the two mappers. The
+  /// integration distances of both levels are subsequently overwritten by the
+  /// multi-resolution mapper params.
+  /// @param fine_mapper_params param struct for the fine mapper
+  /// @param coarse_mapper_params param struct for the coarse mapper
+  /// (optional, defaults to the params of the fine mapper)
+  void setMapperParams(
+      const MapperParams& fine_mapper_params,
+      const std::optional<MapperParams>& coarse_mapper_params = std::nullopt);
+
+  /// @brief Integrates a depth frame into both levels.
+  /// @param depth_frame Depth frame to integrate.
+  /// @param T_L_C Pose of the depth camera, specified as a transform from
+  ///              camera frame to layer frame transform.
+  /// @param camera Intrinsics model of the depth camera.
+  void integrateDepth(const DepthImage& depth_frame, const Transform& T_L_C,
+                      const Camera& camera);
+
+  /// @brief Integrates a color frame into the fine level. The coarse level is
+  /// only used for geometry.
+  /// @param color_frame Color image to integrate.
+  /// @param T_L_C Pose of the camera, specified as a transform from camera
+  /// frame to the layer frame.
+  /// @param camera Intrinsics model of the camera.
+  void integrateColor(const ColorImage& color_frame, const Transform& T_L_C,
+                      const Camera& camera);
+
+  /// @brief Updates the 3D ESDF of both levels.
+  void updateEsdf();
+
+  /// @brief Updates the 2D ESDF slice of both levels.
+  void updateEsdfSlice();
+
+  /// @brief Updates the mesh of both levels.
+  void updateMesh();
+
+  /// @brief Drops fine blocks beyond the fine integration distance whose TSDF
+  /// is smooth (e.g. planar), where the coarse level is observed. Does
+  /// nothing unless coarsen_fine_level is set.
+  /// @param robot_position_L The position of the robot in the layer frame.
+  /// @return The indices of the dropped fine blocks.
+  std::vector<Index3D> coarsenFineLevel(const Vector3f& robot_position_L);
+
+  /// @brief Queries the 3D ESDF at a batch of points. Each point is looked up
+  /// in the fine level, and in the coarse level if the fine level is not
+  /// observed at that point.
+  /// @param points_L The query points, in the layer frame.
+  /// @param distances_m The unsigned distance to the nearest obstacle in
+  /// meters, one per point.
+  /// @param success_flags Whether the query succeeded in either level, one
+  /// per point.
+  /// The outputs are ready when this function returns.
+  void getEsdfDistances(const device_vector<Vector3f>& points_L,
+                        device_vector<float>* distances_m,
+                        device_vector<bool>* success_flags);
+
+  /// Scale a camera to an image downscaled by an integer factor with
+  /// image::naiveDownscaleGPUAsync().
+  /// @param camera The camera of the full resolution image.
+  /// @param factor The downscaling factor.
+  /// @return The camera of the downscaled image.
+  static Camera getDownscaledCamera(const Camera& camera, int factor);
+
+  /// Access to one of the mappers
+  const Mapper& fine_mapper() const { return *fine_mapper_.get(); }
+  /// Access to one of the mappers
+  const Mapper& coarse_mapper() const { return *coarse_mapper_.get(); }
+  /// Access to one of the mappers
+  std::shared_ptr<Mapper> fine_mapper() { return fine_mapper_; }
+  /// Access to one of the mappers
+  std::shared_ptr<Mapper> coarse_mapper() { return coarse_mapper_; }
+
+  /// The depth frame last integrated into the coarse level.
+  const DepthImage& getLastCoarseDepthFrame() const {
+    return depth_frame_coarse_;
+  }
+
+  /// Return the parameter tree.
+  /// @return the parameter tree
+  virtual parameters::ParameterTreeNode getParameterTree(
+      const std::string& name_remap = std::string()) const;
+
+  /// Return the parameter tree represented as a string
+  /// @return the parameter tree string
+  virtual std::string getParametersAsString() const;
+
+ protected:
+  // Apply the per-level integration distances to the mappers' integrators.
+  void setIntegrationDistances();
+
+  // Get those of the passed fine TSDF blocks which are smooth.
+  std::vector<Index3D> getSmoothFineBlocks(
+      const std::vector<Index3D>& block_indices);
+
+  // Parameter struct for the multi-resolution mapper
+  MultiResolutionMapperParams params_;
+
+  // The two mappers to which the frames are integrated.
+  std::shared_ptr<Mapper> fine_mapper_;
+  std::shared_ptr<Mapper> coarse_mapper_;
+
+  // The downscaled depth frame integrated into the coarse level.
+  DepthImage depth_frame_coarse_{MemoryType::kDevice};
+
+  // Per-block results of the smoothness check in coarsenFineLevel().
+  device_vector<const TsdfBlock*> fine_block_ptrs_device_;
+  device_vector<bool> fine_block_is_smooth_device_;
+  host_vector<bool> fine_block_is_smooth_host_;
+
+  // Per-level query results, combined in getEsdfDistances().
+  device_vector<float> fine_distances_vox_;
+  device_vector<bool> fine_success_flags_;
+  device_vector<float> coarse_distances_vox_;
+  device_vector<bool> coarse_success_flags_;
+
+  // The CUDA stream on which to process all work
+  std::shared_ptr<CudaStream> cuda_stream_;
+};
+
+}  // namespace nvblox
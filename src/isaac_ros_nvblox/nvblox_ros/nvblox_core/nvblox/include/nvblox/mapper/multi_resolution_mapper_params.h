@@ -0,0 +1,63 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#pragma once
+
+#include "nvblox/utils/params.h"
+
+namespace nvblox {
+
+constexpr Param<float>::Description kFineLevelMaxIntegrationDistanceMParamDesc{
+    "fine_level_max_integration_distance_m", 10.0f,
+    "The maximum distance, in meters, at which depth is integrated into the "
+    "fine level. Beyond this only the coarse level is updated."};
+
+constexpr Param<float>::Description
+    kCoarseLevelMaxIntegrationDistanceMParamDesc{
+        "coarse_level_max_integration_distance_m", 30.0f,
+        "The maximum distance, in meters, at which depth is integrated into "
+        "the coarse level."};
+
+constexpr Param<int>::Description kCoarseLevelDepthDownscaleFactorParamDesc{
+    "coarse_level_depth_downscale_factor", 4,
+    "Integer factor by which depth images are downscaled before being "
+    "integrated into the coarse level."};
+
+constexpr Param<bool>::Description kCoarsenFineLevelParamDesc{
+    "coarsen_fine_level", false,
+    "Whether coarsenFineLevel() drops smooth fine blocks beyond the fine "
+    "integration distance, such that only the coarse level represents them."};
+
+constexpr Param<float>::Description
+    kFineLevelCoarseningMaxSecondDifferenceMParamDesc{
+        "fine_level_coarsening_max_second_difference_m", 0.01f,
+        "The largest second difference of the TSDF, in meters, along any axis "
+        "within a fine block for which the block is considered smooth, i.e. "
+        "well enough represented by the coarse level."};
+
+/// A structure containing the multi-resolution mapper parameters.
+struct MultiResolutionMapperParams {
+  Param<float> fine_level_max_integration_distance_m{
+      kFineLevelMaxIntegrationDistanceMParamDesc};
+  Param<float> coarse_level_max_integration_distance_m{
+      kCoarseLevelMaxIntegrationDistanceMParamDesc};
+  Param<int> coarse_level_depth_downscale_factor{
+      kCoarseLevelDepthDownscaleFactorParamDesc};
+  Param<bool> coarsen_fine_level{kCoarsenFineLevelParamDesc};
+  Param<float> fine_level_coarsening_max_second_difference_m{
+      kFineLevelCoarseningMaxSecondDifferenceMParamDesc};
+};
+
+}  // namespace nvblox
@@ -0,0 +1,59 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#pragma once
+
+#include <cuda_runtime.h>
+
+#include "nvblox/core/color.h"
+#include "nvblox/core/types.h"
+#include "nvblox/map/common_names.h"
+
+namespace nvblox {
+
+/// Gets the color of a mesh vertex from the color voxel closest to it.
+///
+/// NOTE(alexmillane): Here we make some assumptions.
+/// - We assume that the closest voxel to the vertex is in the ColorBlock
+///   co-located with the MeshBlock from which the vertex was drawn.
+/// - This is will (very?) occationally be incorrect when mesh vertices
+///   escape block boundaries. However, making this assumption saves us any
+///   neighbour calculations.
+/// @param color_block The co-located color block. May be null.
+/// @param p_L_B_m The position of the block in the layer.
+/// @param p_L_V_m The position of the vertex in the layer.
+/// @param voxel_size The voxel size.
+/// @param default_color The color returned if there's no color block.
+/// @return The color of the vertex.
+__device__ inline Color getClosestVoxelColorInBlock(
+    const ColorBlock* color_block, const Vector3f& p_L_B_m,
+    const Vector3f& p_L_V_m, const float voxel_size,
+    const Color& default_color) {
+  if (color_block == nullptr) {
+    return default_color;
+  }
+  // The position of this vertex in the block, converted to a voxel index.
+  const Vector3f p_B_V_m = p_L_V_m - p_L_B_m;
+  Index3D voxel_idx_in_block = (p_B_V_m.array() / voxel_size).cast<int>();
+  constexpr int kVoxelsPerSideMinusOne = ColorBlock::kVoxelsPerSide - 1;
+  voxel_idx_in_block =
+      voxel_idx_in_block.array().min(kVoxelsPerSideMinusOne).max(0);
+  return color_block
+      ->voxels[voxel_idx_in_block.x()][voxel_idx_in_block.y()]
+              [voxel_idx_in_block.z()]
+      .color;
+}
+
+}  // namespace nvblox
@@ -0,0 +1,167 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "nvblox/core/color.h"
+#include "nvblox/core/cuda_stream.h"
+#include "nvblox/core/hash.h"
+#include "nvblox/core/types.h"
+#include "nvblox/core/unified_vector.h"
+#include "nvblox/map/common_names.h"
+#include "nvblox/mesh/mesh_block.h"
+
+namespace nvblox {
+
+/// The location of a single block's mesh inside a MeshArena.
+/// Normals and colors share the vertex range.
+struct MeshArenaRange {
+  int32_t vertex_offset = 0;
+  int32_t num_vertices = 0;
+  int32_t vertex_capacity = 0;
+  int32_t triangle_offset = 0;
+  int32_t num_triangle_indices = 0;
+  int32_t triangle_capacity = 0;
+};
+
+/// Stores the mesh of many blocks in a few large, shared device buffers.
+///
+/// Each block's mesh is a (offset, count) range in the shared buffers, rather
+/// than a set of per-block vectors. This avoids a device allocation per block
+/// on re-meshing and allows the whole mesh to be transferred with a single
+/// copy per buffer (see MeshSerializerGpu).
+///
+/// Updated blocks are written in-place if they fit in their current range and
+/// are appended otherwise. The space left behind is reclaimed by compact(),
+/// which is called automatically once the fraction of unused space exceeds
+/// max_wasted_fraction(). Triangle indices are local to their block, i.e. they
+/// index into the block's vertex range.
+class MeshArena {
+ public:
+  MeshArena();
+  MeshArena(std::shared_ptr<CudaStream> cuda_stream);
+  ~MeshArena() = default;
+
+  /// Copy the mesh of the given blocks into the arena. Blocks which are not
+  /// in the layer, or are empty, are removed from the arena.
+  /// @attention: Input mesh layer must be in device or unified memory
+  /// @param mesh_layer The mesh layer to copy from.
+  /// @param block_indices The blocks to copy.
+  void updateBlocks(const MeshLayer& mesh_layer,
+                    const std::vector<Index3D>& block_indices);
+
+  /// Remove blocks from the arena. Their space is reclaimed on compaction.
+  /// @param block_indices The blocks to remove.
+  void removeBlocks(const std::vector<Index3D>& block_indices);
+
+  /// Repack the stored blocks such that they are contiguous and without gaps.
+  void compact();
+
+  /// Remove all blocks (without deallocating the buffers).
+  void clear();
+
+  /// Copy a block out of the arena.
+  /// @param block_index The block to copy.
+  /// @param mesh_block The output mesh block.
+  /// @return False if the block is not in the arena.
+  bool copyBlockTo(const Index3D& block_index, MeshBlock* mesh_block) const;
+
+  /// Get the range of a block.
+  /// @param block_index The block.
+  /// @param range The output range.
+  /// @return False if the block is not in the arena.
+  bool getRange(const Index3D& block_index, MeshArenaRange* range) const;
+
+  /// The stored blocks, in the order they are laid out in the buffers.
+  std::vector<Index3D> getAllBlockIndices() const;
+
+  /// Whether the stored blocks occupy the buffers without gaps, in the order
+  /// returned by getAllBlockIndices().
+  bool isCompact() const;
+
+  /// Number of blocks stored.
+  size_t numBlocks() const { return ranges_.size(); }
+  /// Number of vertices in use by the stored blocks.
+  int32_t numVertices() const { return num_used_vertices_; }
+  /// Number of triangle indices in use by the stored blocks.
+  int32_t numTriangleIndices() const { return num_used_triangle_indices_; }
+
+  /// The shared buffers. Only the first vertexEnd()/triangleEnd() elements
+  /// are in use; the content of the gaps between ranges is undefined.
+  const device_vector<Vector3f>& vertices() const { return vertices_; }
+  const device_vector<Vector3f>& normals() const { return normals_; }
+  const device_vector<Color>& colors() const { return colors_; }
+  const device_vector<int>& triangles() const { return triangles_; }
+  int32_t vertexEnd() const { return vertex_end_; }
+  int32_t triangleEnd() const { return triangle_end_; }
+
+  /// The block size of the layer the blocks were copied from.
+  float block_size() const { return block_size_; }
+
+  /// A parameter getter
+  /// The fraction of the used part of the buffers which may be unused (i.e.
+  /// left behind by moved or removed blocks) before the arena is compacted.
+  /// @returns the fraction
+  float max_wasted_fraction() const { return max_wasted_fraction_; }
+
+  /// A parameter setter
+  /// See max_wasted_fraction().
+  /// @param max_wasted_fraction The fraction, in [0, 1].
+  void max_wasted_fraction(float max_wasted_fraction);
+
+ private:
+  // Release the space of a range.
+  void releaseRange(const MeshArenaRange& range);
+
+  // Grow the buffers (keeping their content) such that they can hold at least
+  // the requested number of elements.
+  void reserveBuffers(int32_t num_vertices, int32_t num_triangle_indices);
+
+  // Params
+  float max_wasted_fraction_ = 0.5f;
+
+  // Shared mesh data
+  device_vector<Vector3f> vertices_;
+  device_vector<Vector3f> normals_;
+  device_vector<Color> colors_;
+  device_vector<int> triangles_;
+
+  // Where each block lives in the shared data
+  Index3DHashMapType<MeshArenaRange>::type ranges_;
+
+  // The end of the used part of the buffers and the amount of it in use.
+  int32_t vertex_end_ = 0;
+  int32_t triangle_end_ = 0;
+  int32_t num_used_vertices_ = 0;
+  int32_t num_used_triangle_indices_ = 0;
+  float block_size_ = 0.0f;
+
+  // Staging buffers for the blocks copied on the current call.
+  host_vector<CudaMeshBlock> source_blocks_;
+  host_vector<MeshArenaRange> destination_ranges_;
+
+  // Buffers swapped in on compaction.
+  device_vector<Vector3f> compacted_vertices_;
+  device_vector<Vector3f> compacted_normals_;
+  device_vector<Color> compacted_colors_;
+  device_vector<int> compacted_triangles_;
+
+  std::shared_ptr<CudaStream> cuda_stream_;
+};
+
+}  // namespace nvblox
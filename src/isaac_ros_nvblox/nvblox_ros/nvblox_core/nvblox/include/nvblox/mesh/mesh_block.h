@@ -114,6 +114,7 @@ inline void BlockLayer<MeshBlock>::copyFromAsync(
     copy->copyFromAsync(*block, cuda_stream);
     blocks_.emplace(block_index, copy);
   }
+  ++allocation_generation_;
 }
 
 }  // namespace nvblox
@@ -0,0 +1,113 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "nvblox/core/cuda_stream.h"
+#include "nvblox/core/types.h"
+#include "nvblox/core/unified_vector.h"
+#include "nvblox/map/common_names.h"
+#include "nvblox/mesh/mesh_block.h"
+
+namespace nvblox {
+
+/// Produces coarser (level-of-detail) versions of mesh blocks on the GPU,
+/// e.g. to reduce the bandwidth and rendering cost of streaming the mesh of
+/// distant parts of the map.
+///
+/// Decimation is done by vertex clustering: a block's vertices are snapped to
+/// the centers of a grid of cells which are 2^lod voxels wide, and triangles
+/// which collapse are dropped. The cells are aligned with the block grid, such
+/// that neighboring blocks at the same level of detail meet without cracks.
+class MeshDecimator {
+ public:
+  /// At this level a single cell covers a whole block.
+  static constexpr int kMaxLodLevel = 3;
+
+  MeshDecimator();
+  MeshDecimator(std::shared_ptr<CudaStream> cuda_stream);
+  ~MeshDecimator() = default;
+
+  /// Decimate the selected blocks of a mesh layer.
+  /// @attention: Input mesh layer must be in device or unified memory
+  /// @param mesh_layer The full resolution mesh layer.
+  /// @param block_indices The blocks to decimate.
+  /// @param lod_levels The level of detail for each block. Level 0 copies the
+  /// block, each further level doubles the cell size (up to kMaxLodLevel).
+  /// @param decimated_mesh_layer The output layer. Blocks which are empty in
+  /// the input are cleared.
+  void decimateBlocks(const MeshLayer& mesh_layer,
+                      const std::vector<Index3D>& block_indices,
+                      const std::vector<int>& lod_levels,
+                      MeshLayer* decimated_mesh_layer);
+
+  /// Decimate the selected blocks of a mesh layer, selecting the level of
+  /// detail of each block from its distance to a viewer (see getLodLevel()).
+  void decimateBlocksForViewer(const MeshLayer& mesh_layer,
+                               const std::vector<Index3D>& block_indices,
+                               const Vector3f& viewer_position,
+                               MeshLayer* decimated_mesh_layer);
+
+  /// Get the level of detail for a block. Blocks closer than
+  /// full_resolution_distance_m() to the viewer get level 0, after which the
+  /// level increases by one every time the distance doubles, such that the
+  /// size of the cells on screen stays roughly constant.
+  /// @param block_index The index of the mesh block.
+  /// @param block_size The size of the mesh block in meters.
+  /// @param viewer_position The position of the viewer (or robot).
+  /// @return The level of detail.
+  int getLodLevel(const Index3D& block_index, float block_size,
+                  const Vector3f& viewer_position) const;
+
+  /// A parameter getter
+  /// Blocks closer than this distance to the viewer are not decimated.
+  /// @returns the distance in meters
+  float full_resolution_distance_m() const {
+    return full_resolution_distance_m_;
+  }
+
+  /// A parameter setter
+  /// See full_resolution_distance_m().
+  /// @param full_resolution_distance_m The distance in meters.
+  void full_resolution_distance_m(float full_resolution_distance_m);
+
+  /// A parameter getter
+  /// The coarsest level of detail returned by getLodLevel().
+  /// @returns the level
+  int max_lod_level() const { return max_lod_level_; }
+
+  /// A parameter setter
+  /// See max_lod_level().
+  /// @param max_lod_level The level, in [0, kMaxLodLevel].
+  void max_lod_level(int max_lod_level);
+
+ private:
+  // Params
+  float full_resolution_distance_m_ = 5.0f;
+  int max_lod_level_ = kMaxLodLevel;
+
+  // Staging buffers for the blocks decimated on the current call.
+  device_vector<CudaMeshBlock> input_blocks_device_;
+  device_vector<CudaMeshBlock> output_blocks_device_;
+  device_vector<Vector3f> block_origins_device_;
+  device_vector<int> lod_levels_device_;
+
+  std::shared_ptr<CudaStream> cuda_stream_;
+};
+
+}  // namespace nvblox
@@ -19,6 +19,7 @@ limitations under the License.
 #include "nvblox/map/common_names.h"
 #include "nvblox/map/layer.h"
 #include "nvblox/mesh/internal/marching_cubes.h"
+#include "nvblox/mesh/mesh_arena.h"
 #include "nvblox/mesh/mesh_block.h"
 #include "nvblox/mesh/mesh_integrator_params.h"
 namespace nvblox {
@@ -36,7 +37,8 @@ class MeshIntegrator {
       const DeviceType device_type = DeviceType::kGPU);
 
   /// Integrates only the selected blocks from the distance layer on the CPU.
-  /// Prefer to use the GPU version.
+  /// Prefer to use the GPU version. The blocks are meshed on num_cpu_threads()
+  /// threads.
   bool integrateBlocksCPU(const TsdfLayer& distance_layer,
                           const std::vector<Index3D>& block_indices,
                           BlockLayer<MeshBlock>* mesh_layer);
@@ -46,10 +48,14 @@ class MeshIntegrator {
   /// @param block_indices Which block indices to integrate, can either be
   /// updated ones or all blocks in the TSDF layer.
   /// @param mesh_layer The mesh layer for output.
+  /// @param color_layer Optional color layer to color the integrated blocks
+  /// with, see colorMesh(). With fused meshing the vertices are colored as
+  /// they're written to the mesh blocks, rather than in a separate pass.
   /// @return Whether the integration succeeded.
   bool integrateBlocksGPU(const TsdfLayer& distance_layer,
                           const std::vector<Index3D>& block_indices,
-                          BlockLayer<MeshBlock>* mesh_layer);
+                          BlockLayer<MeshBlock>* mesh_layer,
+                          const ColorLayer* color_layer = nullptr);
 
   /// Color mesh layer.
   /// TODO(alexmillane): Currently these functions color vertices by taking the
@@ -74,6 +80,42 @@ class MeshIntegrator {
   bool weld_vertices() const { return weld_vertices_; }
   void weld_vertices(bool weld_vertices) { weld_vertices_ = weld_vertices; }
 
+  /// A parameter getter
+  /// Whether integrateBlocksGPU() meshes with the fused marching cubes kernel.
+  /// The fused kernel tests meshability, classifies the cubes, prefix-sums
+  /// their triangle counts, and emits (optionally welded) vertices into a
+  /// staging arena in a single pass. The result only waits on the GPU once,
+  /// to size the output mesh blocks.
+  /// @returns whether fused meshing is enabled
+  bool fused_meshing() const { return fused_meshing_; }
+
+  /// A parameter setter
+  /// See fused_meshing().
+  /// @param fused_meshing Whether to use the fused kernel.
+  void fused_meshing(bool fused_meshing) { fused_meshing_ = fused_meshing; }
+
+  /// A parameter getter
+  /// The number of threads integrateBlocksCPU() meshes the blocks on. All
+  /// hardware threads if zero or negative.
+  /// @returns the number of threads
+  int num_cpu_threads() const { return num_cpu_threads_; }
+
+  /// A parameter setter
+  /// See num_cpu_threads().
+  /// @param num_cpu_threads The number of threads.
+  void num_cpu_threads(int num_cpu_threads) {
+    num_cpu_threads_ = num_cpu_threads;
+  }
+
+  /// The stream on which the meshing is performed.
+  /// @returns the stream
+  std::shared_ptr<CudaStream> cuda_stream() const { return cuda_stream_; }
+
+  /// Set the stream on which the meshing is performed. Waits for the work on
+  /// the previous stream to finish.
+  /// @param cuda_stream The new stream
+  void cuda_stream(std::shared_ptr<CudaStream> cuda_stream);
+
   /// Return the parameter tree.
   /// @return the parameter tree
   virtual parameters::ParameterTreeNode getParameterTree(
@@ -106,6 +148,29 @@ class MeshIntegrator {
                      const std::vector<Index3D>& block_indices,
                      BlockLayer<MeshBlock>* mesh_layer);
 
+  // Meshes the blocks with the fused kernel. Blocks which turn out not to be
+  // meshable are skipped, such that the input needs no meshability check.
+  // The blocks are colored while copied out of the staging arena if a color
+  // layer is passed.
+  void meshBlocksFusedGPU(const TsdfLayer& distance_layer,
+                          const std::vector<Index3D>& block_indices,
+                          float cutoff_distance,
+                          BlockLayer<MeshBlock>* mesh_layer,
+                          const ColorLayer* color_layer);
+
+  // Gathers the pointers to each block and its 7 positive neighbors (which
+  // may be null) from the GPU hash, and copies the block positions to the
+  // device.
+  void getBlockNeighborhoodsAsync(const TsdfLayer& distance_layer,
+                                  const std::vector<Index3D>& block_indices);
+
+  // Allocates the output mesh block, with room for at least the given number
+  // of vertices and triangle indices, and sets its size.
+  MeshBlock* allocateMeshBlockAsync(const Index3D& block_index,
+                                    size_t num_vertices,
+                                    size_t num_triangle_indices,
+                                    BlockLayer<MeshBlock>* mesh_layer);
+
   // Weld overlapping vertices together, updaing the normals & indices of the
   // reduced vertex count.
   void weldVertices(device_vector<CudaMeshBlock>* cuda_mesh_blocks);
@@ -120,6 +185,10 @@ class MeshIntegrator {
   // of vertices by 5x.
   bool weld_vertices_ = kMeshIntegratorWeldVerticesParamDesc.default_value;
 
+  // Whether to mesh with the fused kernel.
+  bool fused_meshing_ = kMeshIntegratorFusedMeshingParamDesc.default_value;
+  int num_cpu_threads_ = kMeshIntegratorNumCpuThreadsParamDesc.default_value;
+
   // Offsets for cube indices.
   Eigen::Matrix<int, 3, 8> cube_index_offsets_;
 
@@ -133,12 +202,17 @@ class MeshIntegrator {
   // frame.
   host_vector<const VoxelBlock<TsdfVoxel>*> block_ptrs_host_;
   device_vector<const VoxelBlock<TsdfVoxel>*> block_ptrs_device_;
+  host_vector<Index3D> block_indices_host_;
+  device_vector<Index3D> block_indices_device_;
   host_vector<bool> meshable_host_;
   device_vector<bool> meshable_device_;
   host_vector<Vector3f> block_positions_host_;
   device_vector<Vector3f> block_positions_device_;
   host_vector<CudaMeshBlock> mesh_blocks_host_;
   device_vector<CudaMeshBlock> mesh_blocks_device_;
+  // The color blocks co-located with the mesh blocks (may be null).
+  host_vector<const ColorBlock*> color_block_ptrs_host_;
+  device_vector<const ColorBlock*> color_block_ptrs_device_;
   // Caches for welding.
   device_vector<Vector3f> input_vertices_;
   device_vector<Vector3f> input_normals_;
@@ -148,6 +222,16 @@ class MeshIntegrator {
       marching_cubes_results_device_;
   device_vector<int> mesh_block_sizes_device_;
   host_vector<int> mesh_block_sizes_host_;
+
+  // Staging arena the fused kernel emits into, the range of each block in
+  // it, and the end of its used part (vertices, triangle indices).
+  device_vector<Vector3f> staged_vertices_;
+  device_vector<Vector3f> staged_normals_;
+  device_vector<int> staged_triangles_;
+  device_vector<MeshArenaRange> staged_ranges_device_;
+  host_vector<MeshArenaRange> staged_ranges_host_;
+  device_vector<int> staged_ends_device_;
+  host_vector<int> staged_ends_host_;
 };
 
 }  // namespace nvblox
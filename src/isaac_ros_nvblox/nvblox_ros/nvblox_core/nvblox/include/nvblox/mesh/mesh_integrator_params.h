@@ -24,11 +24,24 @@ constexpr Param<float>::Description kMeshIntegratorMinWeightParamDesc{
 constexpr Param<bool>::Description kMeshIntegratorWeldVerticesParamDesc{
     "mesh_integrator_weld_vertices", true,
     "Whether to weld identical vertices together in the mesh."};
+constexpr Param<bool>::Description kMeshIntegratorFusedMeshingParamDesc{
+    "mesh_integrator_fused_meshing", true,
+    "Whether to mesh on the GPU with a single fused marching cubes kernel, "
+    "rather than with separate meshability, table index, vertex and welding "
+    "passes."};
+constexpr Param<int>::Description kMeshIntegratorNumCpuThreadsParamDesc{
+    "mesh_integrator_num_cpu_threads", 1,
+    "The number of threads to mesh on when meshing on the CPU. All hardware "
+    "threads if zero or negative."};
 
 struct MeshIntegratorParams {
   Param<float> mesh_integrator_min_weight{kMeshIntegratorMinWeightParamDesc};
   Param<bool> mesh_integrator_weld_vertices{
       kMeshIntegratorWeldVerticesParamDesc};
+  Param<bool> mesh_integrator_fused_meshing{
+      kMeshIntegratorFusedMeshingParamDesc};
+  Param<int> mesh_integrator_num_cpu_threads{
+      kMeshIntegratorNumCpuThreadsParamDesc};
 };
 
 }  // namespace nvblox
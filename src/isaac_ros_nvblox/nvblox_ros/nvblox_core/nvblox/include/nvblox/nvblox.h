@@ -33,10 +33,12 @@ limitations under the License.
 #include "nvblox/geometry/bounding_boxes.h"
 #include "nvblox/geometry/bounding_shape.h"
 #include "nvblox/geometry/bounding_spheres.h"
+#include "nvblox/geometry/esdf_collision_checker.h"
 #include "nvblox/geometry/plane.h"
 #include "nvblox/geometry/transforms.h"
 #include "nvblox/geometry/workspace_bounds.h"
 #include "nvblox/gpu_hash/gpu_layer_view.h"
+#include "nvblox/integrators/dense_esdf_slice_integrator.h"
 #include "nvblox/integrators/esdf_integrator.h"
 #include "nvblox/integrators/esdf_integrator_params.h"
 #include "nvblox/integrators/esdf_slicer.h"
@@ -45,11 +47,14 @@ limitations under the License.
 #include "nvblox/integrators/occupancy_decay_integrator.h"
 #include "nvblox/integrators/occupancy_decay_integrator_params.h"
 #include "nvblox/integrators/occupancy_integrator_params.h"
+#include "nvblox/integrators/pointcloud_tsdf_integrator.h"
 #include "nvblox/integrators/projective_color_integrator.h"
 #include "nvblox/integrators/projective_integrator_params.h"
 #include "nvblox/integrators/projective_occupancy_integrator.h"
 #include "nvblox/integrators/projective_tsdf_integrator.h"
 #include "nvblox/integrators/shape_clearer.h"
+#include "nvblox/integrators/tsdf_block_pruner.h"
+#include "nvblox/integrators/tsdf_block_pruner_params.h"
 #include "nvblox/integrators/tsdf_decay_integrator.h"
 #include "nvblox/integrators/tsdf_decay_integrator_params.h"
 #include "nvblox/integrators/view_calculator.h"
@@ -64,6 +69,7 @@ limitations under the License.
 #include "nvblox/io/mesh_io.h"
 #include "nvblox/io/ply_writer.h"
 #include "nvblox/io/pointcloud_io.h"
+#include "nvblox/io/tensor_view.h"
 #include "nvblox/map/accessors.h"
 #include "nvblox/map/blocks_to_update_tracker.h"
 #include "nvblox/map/blox.h"
@@ -77,8 +83,12 @@ limitations under the License.
 #include "nvblox/mapper/mapper_params.h"
 #include "nvblox/mapper/multi_mapper.h"
 #include "nvblox/mapper/multi_mapper_params.h"
+#include "nvblox/mapper/multi_resolution_mapper.h"
+#include "nvblox/mapper/multi_resolution_mapper_params.h"
 #include "nvblox/mesh/mesh.h"
+#include "nvblox/mesh/mesh_arena.h"
 #include "nvblox/mesh/mesh_block.h"
+#include "nvblox/mesh/mesh_decimator.h"
 #include "nvblox/mesh/mesh_integrator.h"
 #include "nvblox/mesh/mesh_integrator_params.h"
 #include "nvblox/primitives/primitives.h"
@@ -100,7 +110,9 @@ limitations under the License.
 #include "nvblox/serialization/layer_streamer.h"
 #include "nvblox/serialization/mesh_serializer_gpu.h"
 #include "nvblox/utils/delays.h"
+#include "nvblox/utils/flight_recorder.h"
 #include "nvblox/utils/logging.h"
+#include "nvblox/utils/metrics.h"
 #include "nvblox/utils/nvblox_art.h"
 #include "nvblox/utils/nvtx_ranges.h"
 #include "nvblox/utils/params.h"
@@ -72,6 +72,7 @@ class Primitive {
 
   Color getColor() const { return color_; }
   Type getType() const { return type_; }
+  const Vector3f& getCenter() const { return center_; }
 
   /// Raycasting accessors.
   virtual bool getRayIntersection(const Vector3f& ray_origin,
@@ -100,6 +101,8 @@ class Sphere : public Primitive {
                                   Vector3f* intersect_point,
                                   float* intersect_dist) const override;
 
+  float getRadius() const { return radius_; }
+
  protected:
   float radius_;
 };
@@ -119,6 +122,8 @@ class Cube : public Primitive {
                                   Vector3f* intersect_point,
                                   float* intersect_dist) const override;
 
+  const Vector3f& getSize() const { return size_; }
+
  protected:
   Vector3f size_;
 };
@@ -143,6 +148,8 @@ class Plane : public Primitive {
                                   Vector3f* intersect_point,
                                   float* intersect_dist) const override;
 
+  const Vector3f& getNormal() const { return normal_; }
+
  protected:
   Vector3f normal_;
 };
@@ -165,6 +172,9 @@ class Cylinder : public Primitive {
                                   Vector3f* intersect_point,
                                   float* intersect_dist) const override;
 
+  float getRadius() const { return radius_; }
+  float getHeight() const { return height_; }
+
  protected:
   float radius_;
   float height_;
@@ -107,6 +107,11 @@ class Scene {
   /// Returns a list of the primitive types contained in the scene
   std::vector<Primitive::Type> getPrimitiveTypeList() const;
 
+  /// The primitives of the scene.
+  const std::vector<std::unique_ptr<Primitive>>& getPrimitives() const {
+    return primitives_;
+  }
+
  protected:
   template <typename VoxelType>
   inline void setVoxel(float value, VoxelType* voxel) const;
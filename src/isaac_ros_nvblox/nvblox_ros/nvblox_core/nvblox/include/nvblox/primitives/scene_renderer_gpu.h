@@ -0,0 +1,99 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "nvblox/core/cuda_stream.h"
+#include "nvblox/core/types.h"
+#include "nvblox/core/unified_vector.h"
+#include "nvblox/map/common_names.h"
+#include "nvblox/primitives/scene.h"
+#include "nvblox/sensors/camera.h"
+#include "nvblox/sensors/image.h"
+
+namespace nvblox {
+namespace primitives {
+
+/// A Primitive in a form that can be copied to and evaluated on the GPU.
+struct PrimitiveDescriptor {
+  Primitive::Type type;
+  Vector3f center;
+  /// kSphere: (radius, -, -), kCube: size, kPlane: normal,
+  /// kCylinder: (radius, height, -).
+  Vector3f parameters;
+};
+
+/// Converts the primitives of a scene to descriptors.
+std::vector<PrimitiveDescriptor> getPrimitiveDescriptors(const Scene& scene);
+
+/// Renders depth images and ground-truth TSDF layers of a Scene on the GPU.
+/// The output matches Scene::generateDepthImageFromScene() and
+/// Scene::generateLayerFromScene(), which evaluate every primitive per pixel
+/// or voxel on the CPU and are too slow to generate frames at rates that
+/// stress the mapper.
+class SceneRendererGpu {
+ public:
+  SceneRendererGpu();
+  SceneRendererGpu(std::shared_ptr<CudaStream> cuda_stream);
+  ~SceneRendererGpu() = default;
+
+  /// Copies the primitives and bounding box of a scene to the GPU. Has to be
+  /// called again after changing the scene.
+  /// @param scene The scene to render.
+  void setScene(const Scene& scene);
+
+  /// Generates a synthetic view of the scene, see
+  /// Scene::generateDepthImageFromScene().
+  /// @param camera The camera model.
+  /// @param T_S_C The pose of the camera in the scene.
+  /// @param max_dist Surfaces further away than this are not visible.
+  /// @param depth_frame The output image. Must be GPU accessible (kDevice or
+  /// kUnified) and of the size of the camera.
+  /// @param invalid_depth The depth of pixels not hitting a surface.
+  void generateDepthImageFromScene(const Camera& camera,
+                                   const Transform& T_S_C, float max_dist,
+                                   DepthImage* depth_frame,
+                                   const float invalid_depth = 0.f);
+
+  /// Computes the ground-truth TSDF of all voxels in the bounding box of the
+  /// scene, see Scene::generateLayerFromScene().
+  /// @param max_dist The truncation distance.
+  /// @param layer The output layer. Must be GPU accessible (kDevice or
+  /// kUnified).
+  void generateLayerFromScene(float max_dist, TsdfLayer* layer);
+
+  /// The number of primitives set with setScene().
+  int numPrimitives() const { return primitives_device_.size(); }
+
+ private:
+  // The primitives of the scene.
+  host_vector<PrimitiveDescriptor> primitives_host_;
+  device_vector<PrimitiveDescriptor> primitives_device_;
+  AxisAlignedBoundingBox aabb_;
+
+  // Scratch buffers for layer generation.
+  host_vector<TsdfBlock*> block_ptrs_host_;
+  device_vector<TsdfBlock*> block_ptrs_device_;
+  host_vector<Index3D> block_indices_host_;
+  device_vector<Index3D> block_indices_device_;
+
+  std::shared_ptr<CudaStream> cuda_stream_;
+};
+
+}  // namespace primitives
+}  // namespace nvblox
@@ -17,15 +17,29 @@ limitations under the License.
 
 #include <memory>
 #include <utility>
+#include <vector>
 
 #include "nvblox/core/cuda_stream.h"
+#include "nvblox/core/unified_vector.h"
 #include "nvblox/gpu_hash/gpu_layer_view.h"
 #include "nvblox/map/common_names.h"
 #include "nvblox/sensors/camera.h"
 #include "nvblox/sensors/image.h"
+#include "nvblox/sensors/internal/camera_ray_cache.h"
 
 namespace nvblox {
 
+/// A flat description of a single view rendered by the batched (multi-view)
+/// sphere tracing kernel. Holds a raw pointer to the output image buffer, so
+/// the image must outlive the render call.
+struct SphereTracingView {
+  Camera camera;
+  Transform T_L_C;
+  float* depth = nullptr;
+  /// The unit rays of the (subsampled) pixels, see CameraRayCache.
+  const Vector3f* rays_C = nullptr;
+};
+
 /// A class for rendering synthetic depth images using sphere tracing.
 class SphereTracer {
  public:
@@ -88,6 +102,45 @@ class SphereTracer {
                         const MemoryType output_image_memory_type,
                         const int ray_subsampling_factor = 1);
 
+  /// Render images from several views on the GPU
+  /// All views are rendered by a single kernel launch, sharing the GPU layer
+  /// view. This allocates output images that do not have the right size.
+  /// @param cameras The camera (intrinsics) models, one per view.
+  /// @param T_L_C_vec The poses of the cameras, one per view.
+  /// @param tsdf_layer The tsdf layer to be sphere traced.
+  /// @param truncation_distance_m The (metric) truncation distance used during
+  /// the construction of tsdf_layer.
+  /// @param depth_ptrs Pointers to the output images, one per view.
+  /// @param output_image_memory_type The memory type that the images should be
+  /// stored in.
+  /// @param ray_subsampling_factor The subsampling rate applied to the number
+  /// of traced rays (see renderImageOnGPU()). Applied to all views.
+  void renderImagesOnGPU(const std::vector<Camera>& cameras,
+                         const std::vector<Transform>& T_L_C_vec,
+                         const TsdfLayer& tsdf_layer,
+                         const float truncation_distance_m,
+                         const std::vector<DepthImage*>& depth_ptrs,
+                         const MemoryType output_image_memory_type,
+                         const int ray_subsampling_factor = 1);
+
+  /// Render images from several views on the GPU into image views.
+  /// All views are rendered by a single kernel launch. Each image view must
+  /// have the (possibly subsampled) size of its camera.
+  /// @param cameras The camera (intrinsics) models, one per view.
+  /// @param T_L_C_vec The poses of the cameras, one per view.
+  /// @param tsdf_layer The tsdf layer to be sphere traced.
+  /// @param truncation_distance_m The (metric) truncation distance used during
+  /// the construction of tsdf_layer.
+  /// @param depth_ptrs Pointers to the output image views, one per view.
+  /// @param ray_subsampling_factor The subsampling rate applied to the number
+  /// of traced rays (see renderImageOnGPU()). Applied to all views.
+  void renderImagesOnGPU(const std::vector<Camera>& cameras,
+                         const std::vector<Transform>& T_L_C_vec,
+                         const TsdfLayer& tsdf_layer,
+                         const float truncation_distance_m,
+                         const std::vector<DepthImageView*>& depth_ptrs,
+                         const int ray_subsampling_factor = 1);
+
   /// Render a depth and color image on the GPU
   /// Rendering occurs by sphere tracing the passed TsdfLayer.
   /// Colors are decided by looking up the Color voxel corresponding to ray
@@ -179,6 +232,30 @@ class SphereTracer {
   /// @returns the distance to the surface.
   float surface_distance_epsilon_vox() const;
 
+  /// A parameter getter.
+  /// Whether rays in unobserved space jump over unallocated blocks, rather
+  /// than stepping through them by the truncation distance. Unallocated
+  /// blocks contain no surface, so this only skips empty space, and
+  /// significantly reduces the number of steps for long rays.
+  /// @returns whether unallocated blocks are skipped
+  bool skip_unallocated_blocks() const;
+
+  /// A parameter getter.
+  /// Whether renderImageOnGPU() reprojects the previously rendered depth image
+  /// into the new view, and starts each ray just in front of the reprojected
+  /// surface. Rays without a reprojected depth (e.g. disocclusions), or for
+  /// which the warm start fails, are marched in full. This makes rendering a
+  /// slowly moving camera significantly cheaper. Note that surfaces that
+  /// appeared in front of the previously rendered ones can be missed.
+  /// @returns whether previous renders are reprojected
+  bool reproject_previous_render() const;
+
+  /// A parameter setter.
+  /// See reproject_previous_render(). Setting this discards the previous
+  /// render.
+  /// @param reproject_previous_render whether to reproject previous renders.
+  void reproject_previous_render(bool reproject_previous_render);
+
   /// A parameter setter.
   /// See maximum_steps().
   /// @param maximum_steps the maximum number of steps along the ray.
@@ -194,6 +271,20 @@ class SphereTracer {
   /// @param surface_distance_epsilon_vox the distance to the surface.
   void surface_distance_epsilon_vox(float surface_distance_epsilon_vox);
 
+  /// A parameter setter.
+  /// See skip_unallocated_blocks().
+  /// @param skip_unallocated_blocks whether to skip unallocated blocks.
+  void skip_unallocated_blocks(bool skip_unallocated_blocks);
+
+  /// Getter
+  /// @return The cache of the ray directions of the rendered cameras.
+  std::shared_ptr<CameraRayCache> camera_ray_cache() const;
+
+  /// Setter. See camera_ray_cache(). Allows sharing the rays with other
+  /// components working on the same stream.
+  /// @param camera_ray_cache The cache.
+  void camera_ray_cache(std::shared_ptr<CameraRayCache> camera_ray_cache);
+
  protected:
   // NOTE(alex.millane): The functions below are used in the tests.
 
@@ -216,6 +307,31 @@ class SphereTracer {
   int maximum_steps_ = 100;
   float maximum_ray_length_m_ = 15.0f;
   float surface_distance_epsilon_vox_ = 0.1f;
+  bool skip_unallocated_blocks_ = false;
+  bool reproject_previous_render_ = false;
+
+  // Fills start_depth_image_ by reprojecting the previous render into the
+  // passed view.
+  void reprojectPreviousRender(const Camera& camera, const Transform& T_L_C,
+                               const int ray_subsampling_factor);
+
+  // The last render (see reproject_previous_render()) and the depths it
+  // reprojects to in the current view.
+  bool has_previous_render_ = false;
+  DepthImage previous_depth_image_{MemoryType::kDevice};
+  Camera previous_camera_;
+  Transform previous_T_L_C_;
+  int previous_ray_subsampling_factor_ = 1;
+  DepthImage start_depth_image_{MemoryType::kDevice};
+
+  // The views rendered by renderImagesOnGPU(). Members to avoid
+  // reallocation.
+  host_vector<SphereTracingView> views_host_;
+  device_vector<SphereTracingView> views_device_;
+
+  // The (possibly shared) ray directions of the rendered cameras.
+  std::shared_ptr<CameraRayCache> camera_ray_cache_ =
+      std::make_shared<CameraRayCache>();
 
   // The CUDA stream on which processing occurs
   std::shared_ptr<CudaStream> cuda_stream_;
@@ -17,6 +17,7 @@ limitations under the License.
 
 #include <limits>
 #include <memory>
+#include <vector>
 
 #include "nvblox/core/cuda_stream.h"
 #include "nvblox/core/types.h"
@@ -24,16 +25,30 @@ limitations under the License.
 #include "nvblox/core/unified_vector.h"
 #include "nvblox/sensors/camera.h"
 #include "nvblox/sensors/image.h"
+#include "nvblox/sensors/internal/camera_ray_cache.h"
 #include "nvblox/sensors/pointcloud.h"
 
 namespace nvblox {
 
+struct Index3DDeviceSet;
+
+/// A depth image which is back projected as part of a batch.
+struct BackProjectionFrame {
+  /// The depth image. Must be in device or unified memory.
+  const DepthImage* depth_image = nullptr;
+  /// The intrinsics of the camera which captured the image.
+  const Camera* camera = nullptr;
+  /// The pose of the camera in the output frame (L). Identity to get points
+  /// in the camera frame.
+  Transform T_L_C = Transform::Identity();
+};
+
 /// A class which takes care of back projecting images on the GPU.
 class DepthImageBackProjector {
  public:
   DepthImageBackProjector();
   DepthImageBackProjector(std::shared_ptr<CudaStream> cuda_stream);
-  ~DepthImageBackProjector() = default;
+  ~DepthImageBackProjector();
 
   /// Back projects a depth image to a pointcloud in the camera frame.
   ///@param image DepthImage to be back projected
@@ -48,6 +63,35 @@ class DepthImageBackProjector {
                         const float max_back_projection_distance_m =
                             std::numeric_limits<float>::max());
 
+  /// Back projects a batch of depth images (e.g. from all cameras) in a single
+  /// kernel launch.
+  ///@param frames The images to back project, along with their cameras and
+  /// poses.
+  ///@param pointclouds_L Output pointclouds, one per frame, in the frame L of
+  /// the frame's pose. Must be in either device or unified memory.
+  ///@param max_back_projection_distance_m See backProjectOnGPU().
+  void backProjectBatchOnGPU(const std::vector<BackProjectionFrame>& frames,
+                             const std::vector<Pointcloud*>& pointclouds_L,
+                             const float max_back_projection_distance_m =
+                                 std::numeric_limits<float>::max());
+
+  /// Back projects a batch of depth images in a single kernel launch, and
+  /// returns the centers of the voxels containing the points of all images.
+  /// Duplicates are removed while back projecting, by inserting the voxels
+  /// into a GPU hash set, such that the output holds each voxel once
+  /// (in no particular order).
+  ///@param frames The images to back project, with their poses in the layer
+  /// frame L.
+  ///@param voxel_size The side length of the voxels in the layer.
+  ///@param voxel_center_pointcloud_L Voxel centers stored as a pointcloud.
+  /// Must be in either device or unified memory.
+  ///@param max_back_projection_distance_m See backProjectOnGPU().
+  void backProjectBatchToVoxelCentersOnGPU(
+      const std::vector<BackProjectionFrame>& frames, float voxel_size,
+      Pointcloud* voxel_center_pointcloud_L,
+      const float max_back_projection_distance_m =
+          std::numeric_limits<float>::max());
+
   /// Takes a collection of points, and returns the center of the voxels that
   /// contain the points. Note that this function deletes duplicates, that is
   /// that the output pointcloud may have less points than the input pointcloud.
@@ -58,10 +102,50 @@ class DepthImageBackProjector {
                                      float voxel_size,
                                      Pointcloud* voxel_center_pointcloud_L);
 
+  /// Getter
+  /// @return The cache of camera rays used for back projection.
+  std::shared_ptr<CameraRayCache> camera_ray_cache() const {
+    return camera_ray_cache_;
+  }
+
+  /// Setter. See camera_ray_cache(). Allows sharing the rays with other
+  /// components working on the same stream.
+  /// @param camera_ray_cache The cache.
+  void camera_ray_cache(std::shared_ptr<CameraRayCache> camera_ray_cache) {
+    camera_ray_cache_ = camera_ray_cache;
+  }
+
  private:
+  // Per-frame parameters of the batched kernels.
+  struct FrameView {
+    const Vector3f* rays_C;
+    const float* depth_image;
+    int rows;
+    int cols;
+    Transform T_L_C;
+  };
+  // Fill in and upload the parameters of a batch. Returns the largest image
+  // size of the batch, which the launch has to cover.
+  Index2D prepareBatch(const std::vector<BackProjectionFrame>& frames);
+
+  std::shared_ptr<CameraRayCache> camera_ray_cache_ =
+      std::make_shared<CameraRayCache>();
+
   unified_ptr<int> pointcloud_size_device_;
   unified_ptr<int> pointcloud_size_host_;
 
+  // Batch buffers.
+  host_vector<FrameView> frame_views_host_;
+  device_vector<FrameView> frame_views_device_;
+  // Keeps the ray tables of a batch alive, should the cache evict them.
+  std::vector<std::shared_ptr<const RayTable>> batch_rays_C_;
+  host_vector<Vector3f*> pointcloud_ptrs_host_;
+  device_vector<Vector3f*> pointcloud_ptrs_device_;
+  device_vector<int> pointcloud_sizes_device_;
+  host_vector<int> pointcloud_sizes_host_;
+  std::unique_ptr<Index3DDeviceSet> voxel_set_;
+  int voxel_set_capacity_ = 0;
+
   std::shared_ptr<CudaStream> cuda_stream_;
 };
 
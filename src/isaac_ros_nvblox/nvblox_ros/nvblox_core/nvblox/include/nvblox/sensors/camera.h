@@ -25,7 +25,33 @@ class BoundingPlane;
 /// Class representing the image rectangle
 using CameraViewport = Eigen::AlignedBox<float, 2>;
 
+/// The lens models supported by the Camera.
+enum class CameraModel {
+  /// An ideal pinhole camera, i.e. an undistorted (rectified) image.
+  kPinhole,
+  /// The equidistant (Kannala-Brandt) fisheye model. Supports raw fisheye and
+  /// wide-angle images with a field of view of up to ~170 degrees.
+  kEquidistant,
+};
+
+/// The coefficients of the equidistant distortion model. A ray at an angle
+/// theta to the optical axis is imaged at the distance
+///   theta_d = theta * (1 + k1 theta^2 + k2 theta^4 + k3 theta^6 + k4 theta^8)
+/// from the principal point (in normalized image coordinates). This matches
+/// the "equidistant" model of ROS and the fisheye model of OpenCV.
+struct EquidistantDistortion {
+  float k1;
+  float k2;
+  float k3;
+  float k4;
+};
+
 /// Class that describes the parameters and FoV of a camera.
+///
+/// Distorted cameras are handled by undistorting into (and distorting from)
+/// normalized image coordinates, such that raw distorted images can be
+/// integrated and raycast directly. Note that normalized coordinates and the
+/// depth are still the ones of a pinhole camera: (x/z, y/z) and z.
 class Camera {
  public:
   /// Constructor
@@ -46,6 +72,17 @@ class Camera {
   /// @param width Width (in pixels) of the image plane.
   /// @param height Height (in pixels) of the image plane.
   __host__ __device__ inline Camera(float fu, float fv, int width, int height);
+  /// Constructor of an equidistant (fisheye) camera.
+  /// @param fu Focal length (in pixels) in the u (x/width) direction.
+  /// @param fv Focal length (in pixels) in the v (y/height) direction.
+  /// @param cu Principal point position in the u (x/width) direction.
+  /// @param cv Principal point position in the v (y/height) direction.
+  /// @param width Width (in pixels) of the image plane.
+  /// @param height Height (in pixels) of the image plane.
+  /// @param distortion The coefficients of the distortion model.
+  __host__ __device__ inline Camera(float fu, float fv, float cu, float cv,
+                                    int width, int height,
+                                    const EquidistantDistortion& distortion);
 
   /// Project a 3D point in camera image space to a 2D pixel coordinate.
   /// @param p_C Input 3D point coordinate in image space.
@@ -64,6 +101,21 @@ class Camera {
       const Eigen::Vector3f& p_C, Eigen::Vector2f* u_C,
       const float min_depth = kDefaultMinProjectionDepth);
 
+  /// Apply the lens distortion to normalized image coordinates (the identity
+  /// for a pinhole camera).
+  /// @param x_C Undistorted normalized image coordinates.
+  /// @return Distorted normalized image coordinates.
+  __host__ __device__ inline Vector2f distortNormalizedCoordinates(
+      const Vector2f& x_C) const;
+
+  /// Remove the lens distortion from normalized image coordinates (the
+  /// identity for a pinhole camera). The inverse of
+  /// distortNormalizedCoordinates() within the supported field of view.
+  /// @param x_d_C Distorted normalized image coordinates.
+  /// @return Undistorted normalized image coordinates.
+  __host__ __device__ inline Vector2f undistortNormalizedCoordinates(
+      const Vector2f& x_d_C) const;
+
   /// Get the depth of a 3D point (just the z component).
   /// @param p_C The point in the coordinate frame of the camera.
   /// @return The depth.
@@ -110,7 +162,8 @@ class Camera {
       const float min_depth, const float max_depth) const;
 
   /// Get the camera viewport in normalized image coordinates with an
-  /// appended margin in pixels.
+  /// appended margin in pixels. For distorted cameras this is the bounding
+  /// box of the undistorted image border.
   ///
   /// A normalized camera has K = I and thus its image coordinates
   /// reside in a plane situated one length-unit in front of the
@@ -145,6 +198,15 @@ class Camera {
   __host__ __device__ inline int height() const { return height_; }
   __host__ __device__ inline int cols() const { return width_; }
   __host__ __device__ inline int rows() const { return height_; }
+  __host__ __device__ inline CameraModel model() const { return model_; }
+  __host__ __device__ inline const EquidistantDistortion& distortion() const {
+    return distortion_;
+  }
+
+  /// Whether two cameras have the same lens model and distortion
+  /// coefficients (the intrinsics aren't compared).
+  __host__ __device__ inline bool hasSameDistortion(
+      const Camera& other) const;
 
   /// Camera factory.
   /// @param mat Matrix representation of the camera intrinsics.
@@ -154,8 +216,40 @@ class Camera {
   inline static Camera fromIntrinsicsMatrix(const Eigen::Matrix3f& mat,
                                             int width, int height);
 
+  /// Get a camera with the same lens model and distortion, but different
+  /// intrinsics, e.g. of a resampled image.
+  __host__ __device__ inline Camera withIntrinsics(float fu, float fv,
+                                                   float cu, float cv,
+                                                   int width,
+                                                   int height) const;
+
+  /// Get the camera of a crop of the image.
+  /// @param bbox The cropped region (inclusive, x being the column and y the
+  /// row), see image::cropGPUAsync().
+  /// @return The camera of the cropped image.
+  __host__ __device__ inline Camera cropped(const ImageBoundingBox& bbox) const;
+
+  /// Get the camera of an image downscaled by an integer factor, where pixel
+  /// (u, v) of the downscaled image covers the pixels starting at (u, v) *
+  /// factor of the image. Partial patches at the border are kept, i.e. the
+  /// size is rounded up, see image::minDownscaleGPUAsync().
+  /// @param factor The downscaling factor.
+  /// @return The camera of the downscaled image.
+  __host__ __device__ inline Camera downscaled(int factor) const;
+
  private:
   static constexpr float kDefaultMinProjectionDepth = 1E-6;
+  // The largest angle (in radians) to the optical axis of an undistorted ray.
+  // Rays beyond it (i.e. distorted images with a larger field of view) are
+  // clamped, as their pinhole coordinates grow without bound.
+  static constexpr float kMaxUndistortedTheta = 1.48f;
+  static constexpr int kNumUndistortionIterations = 10;
+
+  // The distorted angle theta_d(theta) of the equidistant model and its
+  // derivative.
+  __host__ __device__ inline float distortAngle(const float theta) const;
+  __host__ __device__ inline float distortAngleDerivative(
+      const float theta) const;
 
   float fu_;
   float fv_;
@@ -164,6 +258,9 @@ class Camera {
 
   int width_;
   int height_;
+
+  CameraModel model_;
+  EquidistantDistortion distortion_;
 };
 
 // Stream Camera as text
@@ -15,19 +15,30 @@ limitations under the License.
 */
 #pragma once
 
+#include <memory>
+#include <vector>
+
+#include "nvblox/core/cuda_graph.h"
 #include "nvblox/core/cuda_stream.h"
 #include "nvblox/sensors/image.h"
+#include "nvblox/sensors/internal/vpi_mask_dilator.h"
 #include "nvblox/sensors/npp_image_operations.h"
 
 namespace nvblox {
 
+/// Where the dilation of the invalid depth regions is computed.
+enum class DepthPreprocessingBackend {
+  kCuda,  ///< NPP kernels on the GPU.
+  kVpi,   ///< VPI on the PVA engine (Jetson only, requires USE_VPI).
+};
+
 /// A class which implements preprocessing steps for an input depth image. At
 /// the moment this is only expanding the invalid depth regions.
 class DepthPreprocessor {
  public:
   DepthPreprocessor();
   DepthPreprocessor(std::shared_ptr<CudaStream> cuda_stream);
-  ~DepthPreprocessor() = default;
+  ~DepthPreprocessor();
 
   /// @brief Dilates the invalid region in a depth image N times.
   /// @param num_dilations The number of times to apply a 3x3 dilation.
@@ -35,6 +46,17 @@ class DepthPreprocessor {
   void dilateInvalidRegionsAsync(const int num_dilations,
                                  DepthImage* depth_image_ptr);
 
+  /// @brief Dilates the invalid region in an integer depth image N times.
+  /// The invalid depth threshold and value (in meters) are converted to the
+  /// units of the image, such that the image doesn't have to be converted to
+  /// float first.
+  /// @param num_dilations The number of times to apply a 3x3 dilation.
+  /// @param depth_scale_m The factor converting pixel values to meters.
+  /// @param depth_image_ptr The image to be dilated.
+  void dilateInvalidRegionsAsync(const int num_dilations,
+                                 const float depth_scale_m,
+                                 DepthImageU16* depth_image_ptr);
+
   /// A parameter getter.
   /// The depth value, below which a depth pixel is considered to be invalid.
   /// @return The threshold.
@@ -55,7 +77,78 @@ class DepthPreprocessor {
   /// @param invalid_depth_value The value.
   void invalid_depth_value(float invalid_depth_value);
 
+  /// A parameter getter.
+  /// Whether the dilation kernels are captured into a CUDA graph and replayed,
+  /// rather than launched one by one. The graph is re-captured when the input
+  /// image, its size, or the parameters change.
+  /// @return True if CUDA graphs are used.
+  bool use_cuda_graph() const;
+
+  /// A parameter setter
+  /// See use_cuda_graph()
+  /// @param use_cuda_graph Whether to use CUDA graphs.
+  void use_cuda_graph(bool use_cuda_graph);
+
+  /// A parameter getter.
+  /// Where the dilations are computed. With kVpi, the threshold and masked set
+  /// still run on the GPU but the repeated dilations run on the PVA engine,
+  /// leaving the GPU free for the integration. The VPI backend synchronizes
+  /// the stream (and is therefore never captured into a CUDA graph).
+  /// @return The backend.
+  DepthPreprocessingBackend backend() const;
+
+  /// A parameter setter
+  /// See backend(). Requesting kVpi from a build without VPI support logs a
+  /// warning and keeps the CUDA backend.
+  /// @param backend The backend.
+  void backend(DepthPreprocessingBackend backend);
+
  private:
+  // Common implementation of the float and integer dilations. The threshold
+  // and value are in the units of the image.
+  template <typename ImageType>
+  void dilateInvalidRegionsTemplateAsync(
+      const int num_dilations,
+      const typename ImageType::ElementType invalid_depth_threshold,
+      const typename ImageType::ElementType invalid_depth_value,
+      ImageType* depth_image_ptr);
+
+  // Launches the kernels making up the dilation.
+  template <typename ImageType>
+  void launchDilationKernelsAsync(
+      const int num_dilations,
+      const typename ImageType::ElementType invalid_depth_threshold,
+      const typename ImageType::ElementType invalid_depth_value,
+      ImageType* depth_image_ptr);
+
+  // A captured dilation along with everything it depends on. The threshold
+  // and value are in the units of the captured image.
+  struct DilationGraph {
+    const void* depth_image_ptr;
+    int rows;
+    int cols;
+    int num_dilations;
+    float invalid_depth_threshold;
+    float invalid_depth_value;
+    CudaGraph graph;
+  };
+  // Returns a previously captured graph matching the request, or nullptr.
+  const DilationGraph* findDilationGraph(const int num_dilations,
+                                         const void* depth_image_ptr,
+                                         const int rows, const int cols,
+                                         const float invalid_depth_threshold,
+                                         const float invalid_depth_value) const;
+
+  // A small number of graphs are cached, such that callers alternating
+  // between a few (double-buffered) images do not re-capture every frame.
+  static constexpr int kMaxNumDilationGraphs = 4;
+  bool use_cuda_graph_ = false;
+  std::vector<std::unique_ptr<DilationGraph>> dilation_graphs_;
+  int next_dilation_graph_idx_ = 0;
+
+  // Created when the VPI backend is selected.
+  std::unique_ptr<VpiMaskDilator> vpi_mask_dilator_;
+
   // The value below which we deem pixels to be invalid in a depth image.
   float invalid_depth_threshold_ = 1e-2f;
 
@@ -0,0 +1,123 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include "nvblox/core/cuda_stream.h"
+#include "nvblox/core/types.h"
+#include "nvblox/core/unified_vector.h"
+#include "nvblox/sensors/image.h"
+
+namespace nvblox {
+
+/// The depth statistics of a square patch of pixels. Pixels with a depth
+/// larger than zero are valid. If there are no valid pixels, the min and max
+/// depth are zero.
+struct DepthPyramidCell {
+  float min_depth;
+  float max_depth;
+  int num_valid;
+};
+
+/// A min/max/valid-count mip pyramid of a depth image.
+///
+/// Level l (1 <= l <= kNumLevels) has a cell per 2^l x 2^l patch of pixels,
+/// such that cell (r, c) covers the pixels starting at (r, c) * 2^l. Cells at
+/// the image border cover partial patches. All levels are built by a single
+/// kernel launch.
+///
+/// The pyramid gives consumers (block culling, empty space skipping,
+/// subsampled rendering) coarse depth bounds without scanning the full
+/// resolution image.
+class DepthPyramid {
+ public:
+  /// The number of levels above the full resolution image.
+  static constexpr int kNumLevels = 5;
+
+  DepthPyramid() = default;
+  ~DepthPyramid() = default;
+
+  /// Builds the pyramid of a depth image (in meters).
+  /// @param depth_image The depth image.
+  /// @param cuda_stream The stream on which to build.
+  void buildAsync(const DepthImageConstView& depth_image,
+                  const CudaStream& cuda_stream);
+
+  /// Whether a pyramid has been built.
+  bool empty() const { return source_ptr_ == nullptr; }
+
+  /// Whether the pyramid was built from this image, i.e. the same data and
+  /// size. The image content is not compared.
+  /// @param depth_image_ptr The data of the image.
+  /// @param rows The number of rows of the image.
+  /// @param cols The number of columns of the image.
+  bool isBuiltFrom(const float* depth_image_ptr, int rows, int cols) const {
+    return !empty() && depth_image_ptr == source_ptr_ &&
+           rows == source_rows_ && cols == source_cols_;
+  }
+
+  /// Returns the level whose cells cover subsampling_factor x
+  /// subsampling_factor pixels, or zero if there's no such level.
+  /// @param subsampling_factor The number of pixels per cell along each axis.
+  static int levelForSubsamplingFactor(int subsampling_factor);
+
+  /// The number of rows of cells of a level.
+  /// @param level The level in [1, kNumLevels].
+  int rows(int level) const;
+  /// The number of columns of cells of a level.
+  /// @param level The level in [1, kNumLevels].
+  int cols(int level) const;
+
+  /// The (device) cells of a level, stored row-major.
+  /// @param level The level in [1, kNumLevels].
+  const DepthPyramidCell* cellsDevicePtr(int level) const;
+
+  /// Copies the cells of a level to the host. Synchronizes the stream.
+  /// @param level The level in [1, kNumLevels].
+  /// @param cuda_stream The stream on which to copy.
+  std::vector<DepthPyramidCell> levelToHost(
+      int level, const CudaStream& cuda_stream) const;
+
+  /// Writes the min depth of the cells of a level to a depth image, i.e. the
+  /// image downscaled by 2^level as by image::minDownscaleGPUAsync() (for
+  /// images without a mask), without re-reading the full resolution image.
+  /// @param level The level in [1, kNumLevels].
+  /// @param[out] image_out The downscaled image, resized to the level.
+  /// @param cuda_stream The stream on which to copy.
+  void minDepthToImageAsync(int level, DepthImage* image_out,
+                            const CudaStream& cuda_stream) const;
+
+  /// Returns the depth statistics of the whole image, reduced from the
+  /// coarsest level. Synchronizes the stream.
+  /// @param cuda_stream The stream on which to copy.
+  DepthPyramidCell getImageCell(const CudaStream& cuda_stream) const;
+
+ private:
+  int checkedLevelIndex(int level) const;
+
+  // The image the pyramid was built from. Not owned, only used to match it.
+  const float* source_ptr_ = nullptr;
+  int source_rows_ = 0;
+  int source_cols_ = 0;
+
+  std::array<device_vector<DepthPyramidCell>, kNumLevels> levels_;
+  std::array<int, kNumLevels> level_rows_{};
+  std::array<int, kNumLevels> level_cols_{};
+};
+
+}  // namespace nvblox
@@ -19,6 +19,7 @@ limitations under the License.
 #include <memory>
 
 #include "nvblox/core/color.h"
+#include "nvblox/core/pinned_host_buffer_pool.h"
 #include "nvblox/core/types.h"
 #include "nvblox/core/unified_vector.h"
 
@@ -291,6 +292,20 @@ class Image : public ImageBase<_ElementType> {
                 const size_t num_elements_per_pixel,
                 const ElementType* const buffer);
 
+  /// Copy from a buffer in pageable host memory, staged through a pinned
+  /// buffer from staging_pool such that the upload is asynchronous on the
+  /// stream. The buffer may be modified as soon as the call returns.
+  void copyFromHostAsync(const size_t rows, const size_t cols,
+                         const ElementType* const buffer,
+                         PinnedHostBufferPool* staging_pool,
+                         const CudaStream& cuda_stream);
+  void copyFromHostAsync(const size_t rows, const size_t cols,
+                         const size_t stride_num_elements,
+                         const size_t num_elements_per_pixel,
+                         const ElementType* const buffer,
+                         PinnedHostBufferPool* staging_pool,
+                         const CudaStream& cuda_stream);
+
   // Copy to a buffer. We assume the buffer has sufficient capacity.
   void copyToAsync(ElementType* buffer, const CudaStream& cuda_stream) const;
   void copyTo(ElementType* buffer) const;
@@ -412,6 +427,14 @@ using ColorImageConstView = ImageView<const Color>;
 using MonoImageConstView = ImageView<const uint8_t>;
 using MaskedDepthImageConstView = MaskedImageView<const float>;
 
+/// Depth images as delivered by most depth sensors, i.e. integer depth which
+/// is converted to meters by multiplying with a scale factor (e.g. 1e-3 for
+/// millimeters). Consumers convert on the fly, such that no float copy is
+/// needed.
+using DepthImageU16 = Image<uint16_t>;
+using DepthImageU16ConstView = ImageView<const uint16_t>;
+using MaskedDepthImageU16ConstView = MaskedImageView<const uint16_t>;
+
 // Image Operations
 namespace image {
 
@@ -458,17 +481,94 @@ void getDifferenceImageGPUAsync(const MonoImage& image_1,
 
 void castGPUAsync(const DepthImage& image_in, MonoImage* image_out_ptr,
                   const CudaStream& cuda_stream);
+// Convert integer depth to meters, i.e. multiply by depth_scale_m. The output
+// is (re)allocated in the memory of the input if the sizes differ.
+void castGPUAsync(const DepthImageU16& image_in, const float depth_scale_m,
+                  DepthImage* image_out_ptr, const CudaStream& cuda_stream);
+
+// Convert tightly packed, interleaved 8-bit RGB pixels in device memory, e.g.
+// as output by an image decoder, to a color image with an alpha of 255. The
+// output is (re)allocated in device memory if the size differs.
+void colorImageFromRgbGPUAsync(const uint8_t* rgb_device, const int rows,
+                               const int cols, ColorImage* image_out_ptr,
+                               const CudaStream& cuda_stream);
+
+// The largest num_dilations supported by getDilatedInvalidDepthMaskGPUAsync().
+constexpr int kMaxNumFusedDilations = 32;
+
+// Get the mask of the pixels which are within num_dilations pixels (in each
+// direction) of an invalid pixel, i.e. a pixel with a depth below
+// invalid_threshold. Masked pixels are set to 255, others to 0. This is the
+// threshold followed by num_dilations 3x3 dilations with replicated borders
+// (see getInvalidDepthMaskAsync() and dilateMask3x3Async()), computed by a
+// single tiled kernel which keeps the intermediate results in shared memory.
+// The mask must have the size of the image. The threshold of an integer depth
+// image is in the units of the image.
+void getDilatedInvalidDepthMaskGPUAsync(const DepthImage& depth_image,
+                                        const float invalid_threshold,
+                                        const int num_dilations,
+                                        MonoImage* mask_ptr,
+                                        const CudaStream& cuda_stream);
+void getDilatedInvalidDepthMaskGPUAsync(const DepthImageU16& depth_image,
+                                        const uint16_t invalid_threshold,
+                                        const int num_dilations,
+                                        MonoImage* mask_ptr,
+                                        const CudaStream& cuda_stream);
 
 // Downscale an image by an integer factor. Does not perform any kind of
 // pre-processing so be prepared for aliasing effects.
 void naiveDownscaleGPUAsync(const MonoImage& image_in, const int factor,
                             MonoImage* image_out,
                             const CudaStream& cuda_stream);
+void naiveDownscaleGPUAsync(const DepthImage& image_in, const int factor,
+                            DepthImage* image_out,
+                            const CudaStream& cuda_stream);
+
+// Downscale a depth image by an integer factor, keeping the smallest valid
+// (positive) depth of each factor x factor patch of pixels, or zero if the
+// patch has no valid depth. Partial patches at the border are kept, i.e. the
+// output has ceil(rows / factor) x ceil(cols / factor) pixels (see
+// Camera::downscaled()). The nearest depth is conservative for integration:
+// nothing behind a thin foreground structure is carved. If the image has a
+// mask, the output mask takes the mask value of the pixel whose depth was
+// kept (and mask_out must not be null). Integer depth is converted to meters
+// with depth_scale_m.
+void minDownscaleGPUAsync(const MaskedDepthImageConstView& image_in,
+                          const int factor, DepthImage* image_out,
+                          MonoImage* mask_out, const CudaStream& cuda_stream);
+void minDownscaleGPUAsync(const MaskedDepthImageU16ConstView& image_in,
+                          const float depth_scale_m, const int factor,
+                          DepthImage* image_out, MonoImage* mask_out,
+                          const CudaStream& cuda_stream);
 
 // Upscale an image by an integer factor.
 void upscaleGPUAsync(const MonoImage& image_in, const int factor,
                      MonoImage* image_out, const CudaStream& cuda_stream);
 
+// Pad and/or crop an image to (desired_rows, desired_cols), keeping the input
+// centered. Each dimension is padded (with zeros) or cropped independently. If
+// the size difference in a dimension is odd, the extra pixel is taken from (or
+// added to) the bottom/right side.
+void padOrCropGPUAsync(const MonoImage& image_in, const int desired_rows,
+                       const int desired_cols, MonoImage* image_out,
+                       const CudaStream& cuda_stream);
+void padOrCropGPUAsync(const DepthImage& image_in, const int desired_rows,
+                       const int desired_cols, DepthImage* image_out,
+                       const CudaStream& cuda_stream);
+void padOrCropGPUAsync(const ColorImage& image_in, const int desired_rows,
+                       const int desired_cols, ColorImage* image_out,
+                       const CudaStream& cuda_stream);
+
+// Copy the region of an image within a bounding box (inclusive, x being the
+// column and y the row) to a (non-strided) output image.
+void cropGPUAsync(const DepthImage& image_in, const ImageBoundingBox& bbox,
+                  DepthImage* image_out, const CudaStream& cuda_stream);
+
+// Get the bounding box of the pixels with valid (positive) depth. The box is
+// empty if there is no such pixel. Blocks until the result is ready.
+ImageBoundingBox getValidDepthBoundingBoxGPU(const DepthImage& image,
+                                             const CudaStream& cuda_stream);
+
 }  // namespace image
 }  // namespace nvblox
 
@@ -0,0 +1,91 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "nvblox/core/cuda_stream.h"
+#include "nvblox/core/types.h"
+#include "nvblox/core/unified_vector.h"
+#include "nvblox/sensors/camera.h"
+
+namespace nvblox {
+
+/// How the rays in a table returned by CameraRayCache are scaled.
+enum class RayNormalization {
+  /// Unit length rays, for marching along the ray.
+  kUnitLength,
+  /// Rays with a z-component of one, such that depth * ray is the 3D point.
+  kUnitDepth
+};
+
+/// A table of ray directions in the camera frame.
+using RayTable = device_vector<Vector3f>;
+
+/// Keeps device-resident tables of the ray directions of a camera, such that
+/// kernels looking up the ray of a pixel do a single load rather than
+/// unprojecting through the intrinsics.
+///
+/// Tables are built on first request and kept for the most recently used
+/// kMaxNumTables (camera, subsampling factor, normalization) combinations.
+class CameraRayCache {
+ public:
+  /// The maximum number of tables kept at once.
+  static constexpr int kMaxNumTables = 8;
+
+  CameraRayCache() = default;
+  ~CameraRayCache() = default;
+
+  /// Returns the table of rays of a camera, building it if it's not cached.
+  ///
+  /// The table holds (camera.rows() / subsampling_factor) x
+  /// (camera.cols() / subsampling_factor) rays, stored row-major. Ray (r, c)
+  /// passes through the center of the subsampling_factor x subsampling_factor
+  /// pixel patch starting at pixel (r, c) * subsampling_factor. For a
+  /// subsampling factor of one, these are the rays of
+  /// Camera::vectorFromPixelIndices().
+  /// @param camera The camera.
+  /// @param subsampling_factor The number of pixels per ray along each axis.
+  /// @param normalization How the rays are scaled.
+  /// @param cuda_stream The stream on which the table is built.
+  /// @return The table. Holding on to it keeps it alive after eviction.
+  std::shared_ptr<const RayTable> getRays(const Camera& camera,
+                                          int subsampling_factor,
+                                          RayNormalization normalization,
+                                          const CudaStream& cuda_stream);
+
+  /// The number of tables currently cached.
+  size_t size() const { return entries_.size(); }
+
+  /// Drop all tables.
+  void clear() { entries_.clear(); }
+
+ private:
+  struct Entry {
+    Camera camera;
+    int subsampling_factor;
+    RayNormalization normalization;
+    std::shared_ptr<RayTable> rays;
+    uint64_t last_use;
+  };
+
+  uint64_t num_uses_ = 0;
+  std::vector<Entry> entries_;
+};
+
+}  // namespace nvblox
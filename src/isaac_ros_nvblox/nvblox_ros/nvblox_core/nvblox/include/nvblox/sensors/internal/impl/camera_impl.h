@@ -20,9 +20,26 @@ limitations under the License.
 namespace nvblox {
 
 Camera::Camera(float fu, float fv, float cu, float cv, int width, int height)
-    : fu_(fu), fv_(fv), cu_(cu), cv_(cv), width_(width), height_(height) {}
+    : fu_(fu),
+      fv_(fv),
+      cu_(cu),
+      cv_(cv),
+      width_(width),
+      height_(height),
+      model_(CameraModel::kPinhole),
+      distortion_{0.0f, 0.0f, 0.0f, 0.0f} {}
 Camera::Camera(float fu, float fv, int width, int height)
     : Camera(fu, fv, width / 2.0, height / 2.0, width, height) {}
+Camera::Camera(float fu, float fv, float cu, float cv, int width, int height,
+               const EquidistantDistortion& distortion)
+    : fu_(fu),
+      fv_(fv),
+      cu_(cu),
+      cv_(cv),
+      width_(width),
+      height_(height),
+      model_(CameraModel::kEquidistant),
+      distortion_(distortion) {}
 
 bool Camera::project(const Eigen::Vector3f& p_C, Eigen::Vector2f* u_C,
                      float min_depth) const {
@@ -31,7 +48,8 @@ bool Camera::project(const Eigen::Vector3f& p_C, Eigen::Vector2f* u_C,
     return false;
   }
 
-  // Apply intrinsics
+  // Apply distortion and intrinsics
+  *u_C = distortNormalizedCoordinates(*u_C);
   u_C->x() = u_C->x() * fu_ + cu_;
   u_C->y() = u_C->y() * fv_ + cv_;
 
@@ -53,6 +71,66 @@ bool Camera::projectToNormalizedCoordinates(const Eigen::Vector3f& p_C,
   }
 }
 
+Vector2f Camera::distortNormalizedCoordinates(const Vector2f& x_C) const {
+  if (model_ == CameraModel::kPinhole) {
+    return x_C;
+  }
+  // Distort the angle to the optical axis. The radius of the normalized
+  // coordinates is tan(theta).
+  const float r = x_C.norm();
+  constexpr float kMinRadius = 1e-8f;
+  if (r < kMinRadius) {
+    return x_C;
+  }
+  return x_C * (distortAngle(atanf(r)) / r);
+}
+
+Vector2f Camera::undistortNormalizedCoordinates(const Vector2f& x_d_C) const {
+  if (model_ == CameraModel::kPinhole) {
+    return x_d_C;
+  }
+  const float theta_d = x_d_C.norm();
+  constexpr float kMinRadius = 1e-8f;
+  if (theta_d < kMinRadius) {
+    return x_d_C;
+  }
+  // Invert the distortion polynomial with Newton's method, starting from the
+  // distorted angle.
+  float theta = fminf(theta_d, kMaxUndistortedTheta);
+  for (int i = 0; i < kNumUndistortionIterations; i++) {
+    const float step =
+        (distortAngle(theta) - theta_d) / distortAngleDerivative(theta);
+    theta = fminf(fmaxf(theta - step, 0.0f), kMaxUndistortedTheta);
+    constexpr float kConvergenceThreshold = 1e-7f;
+    if (fabsf(step) < kConvergenceThreshold) {
+      break;
+    }
+  }
+  return x_d_C * (tanf(theta) / theta_d);
+}
+
+float Camera::distortAngle(const float theta) const {
+  const float theta2 = theta * theta;
+  const float k1 = distortion_.k1;
+  const float k2 = distortion_.k2;
+  const float k3 = distortion_.k3;
+  const float k4 = distortion_.k4;
+  return theta *
+         (1.0f + theta2 * (k1 + theta2 * (k2 + theta2 * (k3 + theta2 * k4))));
+}
+
+float Camera::distortAngleDerivative(const float theta) const {
+  const float theta2 = theta * theta;
+  const float k1 = distortion_.k1;
+  const float k2 = distortion_.k2;
+  const float k3 = distortion_.k3;
+  const float k4 = distortion_.k4;
+  return 1.0f +
+         theta2 * (3.0f * k1 +
+                   theta2 * (5.0f * k2 +
+                             theta2 * (7.0f * k3 + theta2 * 9.0f * k4)));
+}
+
 float Camera::getDepth(const Vector3f& p_C) const { return p_C.z(); }
 
 Vector3f Camera::unprojectFromImagePlaneCoordinates(const Vector2f& u_C,
@@ -70,9 +148,14 @@ Vector3f Camera::vectorFromImagePlaneCoordinates(const Vector2f& u_C) const {
   // such that:
   // 0.0f < u_C[0] <= width
   // 0.0f < u_C[1] <= height
-  return Vector3f((u_C[0] - cu_) / fu_,  // NOLINT
-                  (u_C[1] - cv_) / fv_,  // NOLINT
-                  1.0f);
+  if (model_ == CameraModel::kPinhole) {
+    return Vector3f((u_C[0] - cu_) / fu_,  // NOLINT
+                    (u_C[1] - cv_) / fv_,  // NOLINT
+                    1.0f);
+  }
+  const Vector2f x_C = undistortNormalizedCoordinates(
+      Vector2f((u_C[0] - cu_) / fu_, (u_C[1] - cv_) / fv_));
+  return Vector3f(x_C.x(), x_C.y(), 1.0f);
 }
 
 Vector3f Camera::vectorFromPixelIndices(const Index2D& u_C) const {
@@ -92,4 +175,36 @@ Camera Camera::fromIntrinsicsMatrix(const Eigen::Matrix3f& mat, int width,
   return Camera(fu, fv, cu, cv, width, height);
 }
 
+bool Camera::hasSameDistortion(const Camera& other) const {
+  return model_ == other.model_ && distortion_.k1 == other.distortion_.k1 &&
+         distortion_.k2 == other.distortion_.k2 &&
+         distortion_.k3 == other.distortion_.k3 &&
+         distortion_.k4 == other.distortion_.k4;
+}
+
+Camera Camera::withIntrinsics(float fu, float fv, float cu, float cv,
+                              int width, int height) const {
+  Camera camera(fu, fv, cu, cv, width, height);
+  camera.model_ = model_;
+  camera.distortion_ = distortion_;
+  return camera;
+}
+
+Camera Camera::cropped(const ImageBoundingBox& bbox) const {
+  // Pixel (u, v) of the crop is pixel (u + min.x, v + min.y) of the image.
+  // The distortion acts on normalized coordinates, so it's unchanged.
+  return withIntrinsics(fu_, fv_, cu_ - bbox.min().x(),
+                        cv_ - bbox.min().y(),
+                        bbox.max().x() - bbox.min().x() + 1,
+                        bbox.max().y() - bbox.min().y() + 1);
+}
+
+Camera Camera::downscaled(int factor) const {
+  // The pixel coordinate u of the image is u / factor in the downscaled one.
+  const float inv_factor = 1.0f / static_cast<float>(factor);
+  return withIntrinsics(fu_ * inv_factor, fv_ * inv_factor, cu_ * inv_factor,
+                        cv_ * inv_factor, (width_ + factor - 1) / factor,
+                        (height_ + factor - 1) / factor);
+}
+
 }  // namespace nvblox
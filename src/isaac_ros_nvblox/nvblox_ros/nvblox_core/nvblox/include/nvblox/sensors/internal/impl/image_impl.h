@@ -124,6 +124,31 @@ void Image<ElementType>::copyFromAsync(const size_t rows, const size_t cols,
   ImageBase<ElementType>::data_ = owned_data_.data();
 }
 
+template <typename ElementType>
+void Image<ElementType>::copyFromHostAsync(const size_t rows, const size_t cols,
+                                           const ElementType* const buffer,
+                                           PinnedHostBufferPool* staging_pool,
+                                           const CudaStream& cuda_stream) {
+  copyFromHostAsync(rows, cols, cols, 1, buffer, staging_pool, cuda_stream);
+}
+
+template <typename ElementType>
+void Image<ElementType>::copyFromHostAsync(
+    const size_t rows, const size_t cols, const size_t stride_num_elements,
+    const size_t num_elements_per_pixel, const ElementType* const buffer,
+    PinnedHostBufferPool* staging_pool, const CudaStream& cuda_stream) {
+  CHECK_NOTNULL(staging_pool);
+  this->rows_ = rows;
+  this->cols_ = cols;
+  this->stride_num_elements_ = stride_num_elements;
+  this->num_elements_per_pixel_ = num_elements_per_pixel;
+
+  staging_pool->uploadAsync(
+      buffer, rows * stride_num_elements * num_elements_per_pixel,
+      &owned_data_, cuda_stream);
+  ImageBase<ElementType>::data_ = owned_data_.data();
+}
+
 template <typename ElementType>
 void Image<ElementType>::copyToAsync(ElementType* buffer,
                                      const CudaStream& cuda_stream) const {
@@ -102,6 +102,38 @@ int Lidar::cols() const { return num_azimuth_divisions_; }
 
 int Lidar::rows() const { return num_elevation_divisions_; }
 
+bool Lidar::approximate_projection() const { return approximate_projection_; }
+
+void Lidar::approximate_projection(bool approximate_projection) {
+  approximate_projection_ = approximate_projection;
+}
+
+float approximateAtan2(float y, float x) {
+  const float abs_x = fabsf(x);
+  const float abs_y = fabsf(y);
+  const float max_abs = fmaxf(abs_x, abs_y);
+  if (max_abs == 0.0f) {
+    return 0.0f;
+  }
+  // atan(t) for t in [0, 1].
+  const float t = fminf(abs_x, abs_y) / max_abs;
+  const float t2 = t * t;
+  float angle =
+      t * (0.99997726f +
+           t2 * (-0.33262347f +
+                 t2 * (0.19354346f +
+                       t2 * (-0.11643287f +
+                             t2 * (0.05265332f + t2 * -0.01172120f)))));
+  // Back to the full circle.
+  if (abs_y > abs_x) {
+    angle = static_cast<float>(M_PI_2) - angle;
+  }
+  if (x < 0.0f) {
+    angle = static_cast<float>(M_PI) - angle;
+  }
+  return copysignf(angle, y);
+}
+
 bool Lidar::isInValidRange(const Vector3f& p_C) const {
   const float r = p_C.norm();
   if (r < min_valid_range_m_ || r > max_valid_range_m_) {
@@ -117,9 +149,19 @@ bool Lidar::project(const Vector3f& p_C, Vector2f* u_C) const {
     return false;
   }
   // To spherical coordinates
-  const float r = p_C.norm();
-  const float polar_angle_rad = acos(p_C.z() / r);
-  const float azimuth_angle_rad = atan2(p_C.y(), p_C.x());
+  float polar_angle_rad;
+  float azimuth_angle_rad;
+  if (approximate_projection_) {
+    // The polar angle through the arctangent, as acos(z / r) has no cheap
+    // approximation near the poles.
+    const float r_xy = sqrtf(p_C.x() * p_C.x() + p_C.y() * p_C.y());
+    polar_angle_rad = approximateAtan2(r_xy, p_C.z());
+    azimuth_angle_rad = approximateAtan2(p_C.y(), p_C.x());
+  } else {
+    const float r = p_C.norm();
+    polar_angle_rad = acos(p_C.z() / r);
+    azimuth_angle_rad = atan2(p_C.y(), p_C.x());
+  }
 
   // To image plane coordinates
   float v_float =
@@ -0,0 +1,55 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#pragma once
+
+#include <memory>
+
+#include "nvblox/core/cuda_stream.h"
+#include "nvblox/sensors/image.h"
+
+namespace nvblox {
+
+/// Dilates masks with VPI on the PVA engine of Jetson devices, rather than on
+/// the GPU. Only functional if nvblox is built with USE_VPI, see
+/// isAvailable().
+class VpiMaskDilator {
+ public:
+  /// Whether nvblox was built with VPI support. Constructing a VpiMaskDilator
+  /// otherwise is an error.
+  /// @return True if VPI is available.
+  static bool isAvailable();
+
+  VpiMaskDilator();
+  ~VpiMaskDilator();
+
+  /// Dilates a mask N times with a 3x3 kernel, replicating the border. This
+  /// matches image::dilateMask3x3Async().
+  /// NOTE: This waits for the work already queued on the stream before
+  /// handing the mask over to VPI, and blocks until the result is copied
+  /// back. The GPU is left idle in the meantime.
+  /// @param num_dilations The number of times to apply the 3x3 dilation.
+  /// @param cuda_stream The stream the mask is produced and consumed on.
+  /// @param mask_ptr The mask (in device or unified memory), dilated in place.
+  void dilateMask3x3(const int num_dilations, const CudaStream& cuda_stream,
+                     MonoImage* mask_ptr);
+
+ private:
+  // Hides the VPI types, such that users don't need the VPI headers.
+  struct Impl;
+  std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace nvblox
@@ -106,6 +106,17 @@ class Lidar {
   __host__ __device__ inline int rows() const;
   __host__ __device__ inline int cols() const;
 
+  /// Whether project() approximates the azimuth and polar angles with a
+  /// polynomial arctangent (max. error ~1e-5 rad, well below a pixel of any
+  /// LiDAR) rather than calling atan2() and acos(). Projection is the
+  /// per-voxel hot path of LiDAR integration, which is bound by this
+  /// trigonometry on embedded GPUs. Not part of the intrinsics, i.e. ignored
+  /// by operator==.
+  __host__ __device__ inline bool approximate_projection() const;
+  /// See approximate_projection().
+  __host__ __device__ inline void approximate_projection(
+      bool approximate_projection);
+
   /// Equality
   __host__ inline friend bool operator==(const Lidar& lhs, const Lidar& rhs);
 
@@ -129,8 +140,15 @@ class Lidar {
   float azimuth_pixels_per_rad_;
   float rads_per_pixel_elevation_;
   float rads_per_pixel_azimuth_;
+
+  // Projection mode
+  bool approximate_projection_ = false;
 };
 
+/// Approximates atan2(y, x) with a minimax polynomial of the arctangent on
+/// [0, 1] and octant reduction. The max. error is ~1e-5 rad.
+__host__ __device__ inline float approximateAtan2(float y, float x);
+
 // Equality
 __host__ inline bool operator==(const Lidar& lhs, const Lidar& rhs);
 
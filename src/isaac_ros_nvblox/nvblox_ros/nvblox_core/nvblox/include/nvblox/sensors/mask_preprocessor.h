@@ -15,23 +15,33 @@ limitations under the License.
 */
 #pragma once
 
-#include <bitset>
 #include <memory>
 
 #include "nvblox/core/types.h"
+#include "nvblox/core/unified_vector.h"
 #include "nvblox/sensors/image.h"
-#include "nvblox/sensors/npp_image_operations.h"
 #include "nvblox/utils/logging.h"
 
 namespace nvblox {
 namespace image {
 
-/// Remove small connected components from mask image
+/// Remove small connected components from mask image.
+///
+/// Components are labeled on the GPU, such that the whole operation stays on
+/// the device and scales to high-resolution masks.
 class MaskPreprocessor {
  public:
-  MaskPreprocessor(std::shared_ptr<CudaStream> cuda_stream);
+  /// The factor by which masks are downsampled before processing by default.
+  static constexpr int kDefaultDownscaleFactor = 2;
 
-  /// Remove small connected components from mask image
+  /// @param cuda_stream       The stream on which to process.
+  /// @param downscale_factor  To decrease runtime, the incoming mask image is
+  ///                          downsampled with this factor before processing.
+  ///                          Pass 1 to process at full resolution.
+  MaskPreprocessor(std::shared_ptr<CudaStream> cuda_stream,
+                   int downscale_factor = kDefaultDownscaleFactor);
+
+  /// Remove small connected components from mask image. Blocks until done.
   ///
   /// @attention Resulting mask will be non-zero for active pixels, but not
   ///            necessarily 255.
@@ -43,19 +53,24 @@ class MaskPreprocessor {
                                       const int size_threshold,
                                       MonoImage* mask_out);
 
+  /// Same as removeSmallConnectedComponents(), but returns without waiting
+  /// for the work on the preprocessor's stream to finish.
+  void removeSmallConnectedComponentsAsync(const MonoImage& mask,
+                                           const int size_threshold,
+                                           MonoImage* mask_out);
+
  private:
-  // To decrease runtime, the incoming mask image will be downsampled with this
-  // factor before processing.
-  static constexpr int kDownScaleFactor = 2;
+  const int downscale_factor_;
 
   // buffers for temporary storage
   MonoImage mask_downscaled_{MemoryType::kDevice};
-  MonoImage mask_thresholded_host_{MemoryType::kHost};
-  MonoImage mask_upscaled_{MemoryType::kDevice};
+  MonoImage mask_cleaned_downscaled_{MemoryType::kDevice};
+  // Per-pixel component labels and per-label component sizes.
+  device_vector<int> labels_;
+  device_vector<int> component_sizes_;
 
-  // Cuda stream and context state
+  // Cuda stream
   std::shared_ptr<CudaStream> cuda_stream_;
-  NppStreamContext npp_stream_context_;
 };
 
 }  // namespace image
@@ -45,6 +45,13 @@ void getInvalidDepthMaskAsync(const DepthImage& depth_image,
                               MonoImage* mask_ptr,
                               const float invalid_threshold = 1e-2);
 
+/// @brief As above for an integer depth image. The threshold is in the units
+/// of the image.
+void getInvalidDepthMaskAsync(const DepthImageU16& depth_image,
+                              const NppStreamContext& npp_stream_context,
+                              MonoImage* mask_ptr,
+                              const uint16_t invalid_threshold);
+
 /// @brief Generates a new mask image which is a 3x3 dilation of the input mask.
 /// Note that we require that the output image is allocated and has the same
 /// size as the input.
@@ -66,6 +73,12 @@ void maskedSetAsync(const MonoImage& mask, const float value,
                     const NppStreamContext& npp_stream_context,
                     DepthImage* depth_image_ptr);
 
+/// @brief As above for an integer depth image. The value is in the units of
+/// the image.
+void maskedSetAsync(const MonoImage& mask, const uint16_t value,
+                    const NppStreamContext& npp_stream_context,
+                    DepthImageU16* depth_image_ptr);
+
 /// @brief Set all pixels strictly above a threshold to a given value
 /// Note that we require that the output image is allocated and has the same
 /// size as the input.
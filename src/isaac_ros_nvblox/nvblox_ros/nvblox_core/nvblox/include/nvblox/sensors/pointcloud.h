@@ -16,6 +16,7 @@ limitations under the License.
 #pragma once
 
 #include "nvblox/core/cuda_stream.h"
+#include "nvblox/core/pinned_host_buffer_pool.h"
 #include "nvblox/core/types.h"
 #include "nvblox/core/unified_vector.h"
 #include "nvblox/sensors/camera.h"
@@ -44,6 +45,16 @@ class Pointcloud {
   void copyFromAsync(const unified_vector<Vector3f>& points,
                      const CudaStream& cuda_stream);
 
+  /// Copy points in pageable host memory, staged through a pinned buffer from
+  /// staging_pool such that the upload is asynchronous on the stream. The
+  /// points may be modified as soon as the call returns.
+  void copyFromHostAsync(const std::vector<Vector3f>& points,
+                         PinnedHostBufferPool* staging_pool,
+                         const CudaStream& cuda_stream);
+  void copyFromHostAsync(const Vector3f* points, int num_points,
+                         PinnedHostBufferPool* staging_pool,
+                         const CudaStream& cuda_stream);
+
   /// Deep copy constructor (second can be used to transition memory type)
   /// Pointcloud(const Pointcloud& other);
   Pointcloud(const Pointcloud& other, MemoryType memory_type);
@@ -0,0 +1,94 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "nvblox/core/cuda_stream.h"
+#include "nvblox/core/types.h"
+#include "nvblox/core/unified_vector.h"
+#include "nvblox/sensors/camera.h"
+
+namespace nvblox {
+
+/// The per-block inputs to the priority computation.
+struct BlockPriorityInput {
+  /// The index of the block.
+  Index3D block_index;
+  /// How often the block was marked as a candidate (i.e. changed) since it
+  /// was last streamed.
+  int32_t num_updates;
+  /// The number of streaming rounds the block has been waiting for.
+  int32_t num_rounds_waiting;
+};
+
+/// The view used to prioritize blocks.
+struct BlockPriorityView {
+  /// The position of the robot. Closer blocks have higher priority.
+  Vector3f robot_position_m = Vector3f::Zero();
+  /// Whether the camera below is valid.
+  bool has_camera = false;
+  /// The camera. Blocks in the camera's frustum have higher priority.
+  Camera camera;
+  /// The pose of the layer in the camera frame.
+  Transform T_C_L = Transform::Identity();
+  /// Blocks further than this from the camera are not considered in view.
+  float max_view_distance_m = 10.0f;
+};
+
+/// The weights of the terms of the block priority. The priority of a block
+/// is:
+///   in_view * [block in view] + change * num_updates +
+///   staleness * num_rounds_waiting - distance * distance_to_robot_m
+/// By default, being in view is worth 100m of distance, and a block gains as
+/// much priority per change and per round waited as it loses per meter.
+struct BlockPriorityWeights {
+  float in_view = 100.0f;
+  float change = 1.0f;
+  float staleness = 1.0f;
+  /// Per meter.
+  float distance = 1.0f;
+};
+
+/// Computes the streaming priorities of blocks on the GPU.
+class BlockPriorityCalculatorGpu {
+ public:
+  BlockPriorityCalculatorGpu();
+  BlockPriorityCalculatorGpu(std::shared_ptr<CudaStream> cuda_stream);
+
+  /// Computes the priority of each block.
+  /// @param block_size_m  The size of the blocks.
+  /// @param view          The robot and camera view.
+  /// @param weights       The weights of the priority terms.
+  /// @param inputs        The blocks to prioritize.
+  /// @param priorities    Output. The priority of each block.
+  void computePriorities(const float block_size_m,
+                         const BlockPriorityView& view,
+                         const BlockPriorityWeights& weights,
+                         const std::vector<BlockPriorityInput>& inputs,
+                         std::vector<float>* priorities);
+
+ private:
+  std::shared_ptr<CudaStream> cuda_stream_;
+
+  // Scratch data.
+  device_vector<BlockPriorityInput> inputs_device_;
+  device_vector<float> priorities_device_;
+  host_vector<float> priorities_host_;
+};
+
+}  // namespace nvblox
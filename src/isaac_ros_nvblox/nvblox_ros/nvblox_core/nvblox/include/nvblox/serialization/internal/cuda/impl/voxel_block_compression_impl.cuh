@@ -0,0 +1,240 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#pragma once
+
+#include <cuda_runtime.h>
+
+#include "nvblox/core/internal/error_check.h"
+
+namespace nvblox {
+
+// The number of threads of the compression and hashing kernels. Blocks with
+// more voxels than a CUDA block can have threads are processed with several
+// voxels per thread.
+template <int kNumVoxels>
+constexpr int voxelBlockCompressionNumThreads() {
+  constexpr int kMaxThreadsPerBlock = 1024;
+  return (kNumVoxels < kMaxThreadsPerBlock) ? kNumVoxels : kMaxThreadsPerBlock;
+}
+
+// Compares the bytes of two voxels. Note that we compare bytes, rather than
+// using operator==, such that decompression recovers exactly the same bytes.
+template <typename VoxelType>
+__device__ inline bool areVoxelsBitwiseEqual(const VoxelType& voxel_1,
+                                             const VoxelType& voxel_2) {
+  const uint8_t* bytes_1 = reinterpret_cast<const uint8_t*>(&voxel_1);
+  const uint8_t* bytes_2 = reinterpret_cast<const uint8_t*>(&voxel_2);
+  for (int i = 0; i < static_cast<int>(sizeof(VoxelType)); i++) {
+    if (bytes_1[i] != bytes_2[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Kernel that compresses voxel blocks (see voxel_block_compression.h for the
+// format).
+//
+// Number of blocks:  Must equal the number of voxel blocks.
+// Number of threads: voxelBlockCompressionNumThreads<kNumVoxels>()
+//
+// @param block_ptrs   Pointers to the first voxel of each block. nullptr for
+//                     empty blocks.
+// @param offsets      Byte offsets of the blocks in compressed_output. Unused
+//                     if compressed_output is nullptr.
+// @param num_bytes    Output. If not nullptr, the compressed size of each
+//                     block.
+// @param compressed_output  Output. If not nullptr, the compressed blocks.
+template <typename VoxelType, int kNumVoxels>
+__global__ void compressVoxelBlocksKernel(const VoxelType** block_ptrs,
+                                          const int32_t* offsets,
+                                          int32_t* num_bytes,
+                                          uint8_t* compressed_output) {
+  constexpr int kWarpSize = 32;
+  constexpr int kNumThreads = voxelBlockCompressionNumThreads<kNumVoxels>();
+  constexpr int kNumVoxelsPerThread = kNumVoxels / kNumThreads;
+  constexpr int kNumWarps = kNumThreads / kWarpSize;
+  constexpr int kNumMaskWords = kNumVoxels / kWarpSize;
+  constexpr int kNumMaskBytes = kNumMaskWords * sizeof(uint32_t);
+  __shared__ uint32_t mask[kNumMaskWords];
+  __shared__ int32_t num_stored_voxels_before_word[kNumMaskWords];
+
+  const VoxelType* voxels = block_ptrs[blockIdx.x];
+  if (voxels == nullptr) {
+    if (num_bytes != nullptr && threadIdx.x == 0) {
+      num_bytes[blockIdx.x] = 0;
+    }
+    return;
+  }
+
+  // Store a voxel if it differs from the one before it. The threads of a
+  // warp handle consecutive voxels, such that each ballot yields one mask
+  // word.
+  const int warp_idx = threadIdx.x / kWarpSize;
+  const int lane_idx = threadIdx.x % kWarpSize;
+  for (int i = 0; i < kNumVoxelsPerThread; i++) {
+    const int voxel_idx = i * kNumThreads + threadIdx.x;
+    const bool is_stored =
+        (voxel_idx == 0) ||
+        !areVoxelsBitwiseEqual(voxels[voxel_idx], voxels[voxel_idx - 1]);
+    const uint32_t warp_mask = __ballot_sync(0xFFFFFFFF, is_stored);
+    if (lane_idx == 0) {
+      mask[i * kNumWarps + warp_idx] = warp_mask;
+    }
+  }
+  __syncthreads();
+
+  // The number of stored voxels before each mask word gives the position of
+  // the stored voxels in the output.
+  if (threadIdx.x == 0) {
+    int num_stored_voxels = 0;
+    for (int i = 0; i < kNumMaskWords; i++) {
+      num_stored_voxels_before_word[i] = num_stored_voxels;
+      num_stored_voxels += __popc(mask[i]);
+    }
+    if (num_bytes != nullptr) {
+      constexpr int kVoxelNumBytes = sizeof(VoxelType);
+      num_bytes[blockIdx.x] =
+          kNumMaskBytes + num_stored_voxels * kVoxelNumBytes;
+    }
+  }
+  if (compressed_output == nullptr) {
+    return;
+  }
+  __syncthreads();
+
+  // Write the mask and the stored voxels. Blocks are not necessarily aligned
+  // so we copy bytes.
+  uint8_t* block_output = compressed_output + offsets[blockIdx.x];
+  for (int word_idx = threadIdx.x; word_idx < kNumMaskWords;
+       word_idx += kNumThreads) {
+    memcpy(block_output + word_idx * sizeof(uint32_t), &mask[word_idx],
+           sizeof(uint32_t));
+  }
+  for (int i = 0; i < kNumVoxelsPerThread; i++) {
+    const int voxel_idx = i * kNumThreads + threadIdx.x;
+    const int word_idx = i * kNumWarps + warp_idx;
+    const uint32_t warp_mask = mask[word_idx];
+    if ((warp_mask >> lane_idx) & 1u) {
+      const int position = num_stored_voxels_before_word[word_idx] +
+                           __popc(warp_mask & ((1u << lane_idx) - 1u));
+      memcpy(block_output + kNumMaskBytes + position * sizeof(VoxelType),
+             &voxels[voxel_idx], sizeof(VoxelType));
+    }
+  }
+}
+
+// Kernel that hashes the voxels of blocks.
+//
+// Each voxel's bytes are hashed (FNV-1a) together with its index in the
+// block, and the voxel hashes are combined by XOR.
+//
+// Number of blocks:  Must equal the number of voxel blocks.
+// Number of threads: voxelBlockCompressionNumThreads<kNumVoxels>()
+//
+// @param block_ptrs   Pointers to the first voxel of each block. nullptr for
+//                     empty blocks.
+// @param hashes       Output. The hash of each block.
+template <typename VoxelType, int kNumVoxels>
+__global__ void hashVoxelBlocksKernel(const VoxelType** block_ptrs,
+                                      uint64_t* hashes) {
+  constexpr int kWarpSize = 32;
+  constexpr int kNumThreads = voxelBlockCompressionNumThreads<kNumVoxels>();
+  constexpr int kNumVoxelsPerThread = kNumVoxels / kNumThreads;
+  constexpr int kNumWarps = kNumThreads / kWarpSize;
+  constexpr uint64_t kFnvOffsetBasis = 14695981039346656037ull;
+  constexpr uint64_t kFnvPrime = 1099511628211ull;
+  __shared__ uint64_t warp_hashes[kNumWarps];
+
+  const VoxelType* voxels = block_ptrs[blockIdx.x];
+  if (voxels == nullptr) {
+    if (threadIdx.x == 0) {
+      hashes[blockIdx.x] = 0;
+    }
+    return;
+  }
+
+  // Hash the voxels of this thread, including their position such that the
+  // hash depends on the order of the voxels.
+  uint64_t hash = 0;
+  for (int i = 0; i < kNumVoxelsPerThread; i++) {
+    const int voxel_idx = i * kNumThreads + threadIdx.x;
+    uint64_t voxel_hash = kFnvOffsetBasis ^ static_cast<uint64_t>(voxel_idx);
+    voxel_hash *= kFnvPrime;
+    const uint8_t* bytes =
+        reinterpret_cast<const uint8_t*>(&voxels[voxel_idx]);
+    for (int j = 0; j < static_cast<int>(sizeof(VoxelType)); j++) {
+      voxel_hash ^= bytes[j];
+      voxel_hash *= kFnvPrime;
+    }
+    hash ^= voxel_hash;
+  }
+
+  // Combine within the warp, then across warps.
+  for (int offset = kWarpSize / 2; offset > 0; offset /= 2) {
+    hash ^= __shfl_xor_sync(0xFFFFFFFF, hash, offset);
+  }
+  const int warp_idx = threadIdx.x / kWarpSize;
+  const int lane_idx = threadIdx.x % kWarpSize;
+  if (lane_idx == 0) {
+    warp_hashes[warp_idx] = hash;
+  }
+  __syncthreads();
+  if (threadIdx.x == 0) {
+    uint64_t block_hash = 0;
+    for (int i = 0; i < kNumWarps; i++) {
+      block_hash ^= warp_hashes[i];
+    }
+    hashes[blockIdx.x] = block_hash;
+  }
+}
+
+template <typename VoxelType, int kNumVoxels>
+void compressVoxelBlocksAsync(const VoxelType** block_ptrs,
+                              const int num_blocks, const int32_t* offsets,
+                              int32_t* num_bytes, uint8_t* compressed_output,
+                              const CudaStream& cuda_stream) {
+  static_assert(kNumVoxels % 32 == 0,
+                "Compression needs a multiple of the warp size voxels per "
+                "block.");
+  if (num_blocks == 0) {
+    return;
+  }
+  constexpr int kNumThreads = voxelBlockCompressionNumThreads<kNumVoxels>();
+  compressVoxelBlocksKernel<VoxelType, kNumVoxels>
+      <<<num_blocks, kNumThreads, 0, cuda_stream>>>(block_ptrs,  // NOLINT
+                                                    offsets,     // NOLINT
+                                                    num_bytes,   // NOLINT
+                                                    compressed_output);
+  checkCudaErrors(cudaPeekAtLastError());
+}
+
+template <typename VoxelType, int kNumVoxels>
+void hashVoxelBlocksAsync(const VoxelType** block_ptrs, const int num_blocks,
+                          uint64_t* hashes, const CudaStream& cuda_stream) {
+  static_assert(kNumVoxels % 32 == 0,
+                "Hashing needs a multiple of the warp size voxels per block.");
+  if (num_blocks == 0) {
+    return;
+  }
+  constexpr int kNumThreads = voxelBlockCompressionNumThreads<kNumVoxels>();
+  hashVoxelBlocksKernel<VoxelType, kNumVoxels>
+      <<<num_blocks, kNumThreads, 0, cuda_stream>>>(block_ptrs,  // NOLINT
+                                                    hashes);
+  checkCudaErrors(cudaPeekAtLastError());
+}
+
+}  // namespace nvblox
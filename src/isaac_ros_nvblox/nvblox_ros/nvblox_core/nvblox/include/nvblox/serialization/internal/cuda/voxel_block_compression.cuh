@@ -0,0 +1,60 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#pragma once
+
+#include <cstdint>
+
+#include "nvblox/core/cuda_stream.h"
+
+namespace nvblox {
+
+/// Compresses voxel blocks on the GPU (see voxel_block_compression.h for the
+/// format). Blocks with more voxels than a CUDA block can have threads (e.g.
+/// 16x16x16 blocks) are processed with several voxels per thread.
+/// @tparam VoxelType The type of the voxels.
+/// @tparam kNumVoxels The number of voxels per block. Must be a multiple of
+/// the warp size.
+/// @param block_ptrs Pointers to the first voxel of each block (in device
+/// accessible memory). nullptr for empty blocks.
+/// @param num_blocks The number of blocks.
+/// @param offsets Byte offsets of the blocks in compressed_output. Unused if
+/// compressed_output is nullptr.
+/// @param num_bytes Output. If not nullptr, the compressed size of each block.
+/// @param compressed_output Output. If not nullptr, the compressed blocks.
+/// @param cuda_stream The stream on which to process the work.
+template <typename VoxelType, int kNumVoxels>
+void compressVoxelBlocksAsync(const VoxelType** block_ptrs,
+                              const int num_blocks, const int32_t* offsets,
+                              int32_t* num_bytes, uint8_t* compressed_output,
+                              const CudaStream& cuda_stream);
+
+/// Hashes the voxels of blocks on the GPU. See
+/// LayerCompressorGpuInternal::computeBlockHashes().
+/// @tparam VoxelType The type of the voxels.
+/// @tparam kNumVoxels The number of voxels per block. Must be a multiple of
+/// the warp size.
+/// @param block_ptrs Pointers to the first voxel of each block (in device
+/// accessible memory). nullptr for empty blocks.
+/// @param num_blocks The number of blocks.
+/// @param hashes Output. The hash of each block.
+/// @param cuda_stream The stream on which to process the work.
+template <typename VoxelType, int kNumVoxels>
+void hashVoxelBlocksAsync(const VoxelType** block_ptrs, const int num_blocks,
+                          uint64_t* hashes, const CudaStream& cuda_stream);
+
+}  // namespace nvblox
+
+#include "nvblox/serialization/internal/cuda/impl/voxel_block_compression_impl.cuh"
@@ -23,6 +23,20 @@ LayerSerializerGpu<LayerType>::serialize(
     const LayerType& layer,
     const std::vector<Index3D>& block_indices_to_serialize,
     const CudaStream& cuda_stream) {
+  serialized_layer_->block_indices = block_indices_to_serialize;
+  serialized_layer_->is_compressed = compress_blocks_;
+  if (compress_blocks_) {
+    serialized_layer_->voxels.clearNoDeallocate();
+    serialized_layer_->block_offsets.clearNoDeallocate();
+    compressor_.compress(layer, block_indices_to_serialize,
+                         serialized_layer_->compressed_blocks,
+                         serialized_layer_->compressed_block_offsets,
+                         cuda_stream);
+    return serialized_layer_;
+  }
+  serialized_layer_->compressed_blocks.clearNoDeallocate();
+  serialized_layer_->compressed_block_offsets.clearNoDeallocate();
+
   serializer_.serializeAsync(
       layer, block_indices_to_serialize, serialized_layer_->voxels,
       serialized_layer_->block_offsets,
@@ -35,10 +49,71 @@ LayerSerializerGpu<LayerType>::serialize(
       },
       cuda_stream);
 
-  serialized_layer_->block_indices = block_indices_to_serialize;
-
   cuda_stream.synchronize();
   return serialized_layer_;
 }
 
+template <class LayerType>
+std::vector<int32_t> LayerSerializerGpu<LayerType>::getCompressedBlockSizes(
+    const LayerType& layer, const std::vector<Index3D>& block_indices,
+    const CudaStream& cuda_stream) {
+  compressor_.computeCompressedSizes(layer, block_indices,
+                                     compressed_block_sizes_, cuda_stream);
+  return std::vector<int32_t>(compressed_block_sizes_.begin(),
+                              compressed_block_sizes_.end());
+}
+
+template <class LayerType>
+std::vector<uint64_t> LayerSerializerGpu<LayerType>::getBlockHashes(
+    const LayerType& layer, const std::vector<Index3D>& block_indices,
+    const CudaStream& cuda_stream) {
+  compressor_.computeBlockHashes(layer, block_indices, block_hashes_,
+                                 cuda_stream);
+  return std::vector<uint64_t>(block_hashes_.begin(), block_hashes_.end());
+}
+
+template <typename VoxelType, int kNumVoxels>
+bool decompressSerializedLayer(SerializedLayer<VoxelType>* serialized_layer) {
+  CHECK_NOTNULL(serialized_layer);
+  if (!serialized_layer->is_compressed) {
+    return true;
+  }
+  const size_t num_blocks = serialized_layer->block_indices.size();
+  const host_vector<int32_t>& compressed_offsets =
+      serialized_layer->compressed_block_offsets;
+  CHECK(compressed_offsets.empty() ||
+        compressed_offsets.size() == num_blocks + 1);
+
+  // Empty blocks have no voxels.
+  const CudaStreamOwning cuda_stream;
+  serialized_layer->block_offsets.resizeAsync(num_blocks + 1, cuda_stream);
+  cuda_stream.synchronize();
+  int32_t total_num_voxels = 0;
+  for (size_t i = 0; i < num_blocks; ++i) {
+    serialized_layer->block_offsets[i] = total_num_voxels;
+    if (!compressed_offsets.empty() &&
+        compressed_offsets[i + 1] > compressed_offsets[i]) {
+      total_num_voxels += kNumVoxels;
+    }
+  }
+  serialized_layer->block_offsets[num_blocks] = total_num_voxels;
+
+  serialized_layer->voxels.resizeAsync(total_num_voxels, cuda_stream);
+  cuda_stream.synchronize();
+  bool success = true;
+  for (size_t i = 0; i < num_blocks; ++i) {
+    const int32_t num_voxels = serialized_layer->block_offsets[i + 1] -
+                               serialized_layer->block_offsets[i];
+    if (num_voxels == 0) {
+      continue;
+    }
+    success &= decompressVoxelBlock<VoxelType, kNumVoxels>(
+        serialized_layer->compressed_blocks.data() + compressed_offsets[i],
+        compressed_offsets[i + 1] - compressed_offsets[i],
+        serialized_layer->voxels.data() + serialized_layer->block_offsets[i]);
+  }
+  serialized_layer->is_compressed = false;
+  return success;
+}
+
 }  // namespace nvblox
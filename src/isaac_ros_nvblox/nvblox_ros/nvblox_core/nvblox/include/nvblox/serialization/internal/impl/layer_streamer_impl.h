@@ -15,7 +15,9 @@ limitations under the License.
 */
 #include "nvblox/serialization/layer_streamer.h"
 
+#include <algorithm>
 #include <numeric>
+#include <type_traits>
 
 namespace nvblox {
 
@@ -47,6 +49,77 @@ void LayerStreamerBase<LayerType>::setExclusionFunctors(
   exclude_block_functors_ = exclude_block_functors;
 };
 
+template <class LayerType>
+void LayerStreamerBase<LayerType>::setupExclusionFunctors(
+    const BlockExclusionParams& block_exclusion_params) {
+  // If requested exclude blocks
+  std::vector<ExcludeBlockFunctor> exclusion_functors;
+  // Exclude based on height
+  if (block_exclusion_params.exclusion_height_m.has_value() &&
+      block_exclusion_params.block_size_m.has_value() &&
+      block_exclusion_params.exclusion_height_m.value() > 0.0) {
+    exclusion_functors.push_back(getExcludeAboveHeightFunctor(
+        block_exclusion_params.exclusion_height_m.value(),
+        block_exclusion_params.block_size_m.value()));
+  }
+  // Exclude based on radius
+  if (block_exclusion_params.block_size_m.has_value() &&
+      block_exclusion_params.exclusion_center_m.has_value() &&
+      block_exclusion_params.exclusion_radius_m.has_value() &&
+      block_exclusion_params.exclusion_radius_m.value() > 0.0) {
+    exclusion_functors.push_back(getExcludeOutsideRadiusFunctor(
+        block_exclusion_params.exclusion_radius_m.value(),
+        block_exclusion_params.exclusion_center_m.value(),
+        block_exclusion_params.block_size_m.value()));
+  }
+  setExclusionFunctors(exclusion_functors);
+}
+
+template <class LayerType>
+ExcludeBlockFunctor
+LayerStreamerBase<LayerType>::getExcludeAboveHeightFunctor(
+    const float exclusion_height_m, const float block_size_m) {
+  // Create a functor which returns true if a blocks minimum height is above
+  // a limit.
+  return [exclusion_height_m, block_size_m](const Index3D& idx) -> bool {
+    // Exclude block if it's low corner/plane is above the exclusion
+    // limit
+    const float low_z_m = static_cast<float>(idx.z()) * block_size_m;
+    return low_z_m > exclusion_height_m;
+  };
+}
+
+template <class LayerType>
+ExcludeBlockFunctor
+LayerStreamerBase<LayerType>::getExcludeOutsideRadiusFunctor(
+    const float exclude_blocks_radius_m, const Vector3f& center_m,
+    const float block_size_m) {
+  // Square the radius outside
+  const float exclude_blocks_radius_squared_m2 =
+      exclude_blocks_radius_m * exclude_blocks_radius_m;
+  // Create a functor which returns true if the block center is a greater radius
+  // from the passed center.
+  return [exclude_blocks_radius_squared_m2, center_m,
+          block_size_m](const Index3D& idx) -> bool {
+    // Calculate the blocks center position
+    const Vector3f block_center =
+        getCenterPositionFromBlockIndex(block_size_m, idx);
+    const float block_radius_squared_m2 =
+        (block_center - center_m).squaredNorm();
+    return block_radius_squared_m2 > exclude_blocks_radius_squared_m2;
+  };
+}
+
+template <class LayerType>
+ExcludeBlockFunctor
+LayerStreamerBase<LayerType>::getExcludeOutsideAabbFunctor(
+    const AxisAlignedBoundingBox& aabb_m, const float block_size_m) {
+  // Create a functor which returns true if the block doesn't touch the box.
+  return [aabb_m, block_size_m](const Index3D& idx) -> bool {
+    return !isBlockTouchedByBoundingBox(idx, block_size_m, aabb_m);
+  };
+}
+
 template <class LayerType>
 std::vector<Index3D> LayerStreamerBase<LayerType>::getNBlocks(
     const int num_blocks) {
@@ -74,8 +147,8 @@ std::vector<Index3D> LayerStreamerBase<LayerType>::getNBytesOfBlocks(
   // Define a functor that counts the number of bytes streamed so far.
   size_t num_bytes_streamed = 0;
   StreamStatusFunctor stream_n_bytes_functor =
-      [&num_bytes_streamed, num_bytes,
-       &layer](const Index3D& idx) -> StreamStatus {
+      [&num_bytes_streamed, num_bytes, &layer,
+       this](const Index3D& idx) -> StreamStatus {
     StreamStatus status;
     const typename LayerType::BlockType::ConstPtr block_ptr =
         layer.getBlockAtIndex(idx);
@@ -86,7 +159,11 @@ std::vector<Index3D> LayerStreamerBase<LayerType>::getNBytesOfBlocks(
               .streaming_limit_reached = false};
     }
     // The bytes that would be sent if we sent this block
-    num_bytes_streamed += sizeInBytes(block_ptr.get());
+    const auto compressed_num_bytes_it = compressed_block_num_bytes_.find(idx);
+    num_bytes_streamed +=
+        (compressed_num_bytes_it != compressed_block_num_bytes_.end())
+            ? compressed_num_bytes_it->second
+            : sizeInBytes(block_ptr.get());
     // If we have enough bandwidth send, otherwise stop streaming.
     const bool should_stream = num_bytes_streamed < num_bytes;
     return {.should_block_be_streamed = should_stream,
@@ -103,8 +180,212 @@ std::shared_ptr<const SerializedLayerType<LayerType>>
 LayerStreamerBase<LayerType>::getNBytesOfSerializedBlocks(
     const size_t num_bytes, const LayerType& layer,
     const CudaStream& cuda_stream) {
-  return serializer_.serialize(layer, getNBytesOfMeshBlocks(num_bytes, layer),
-                               cuda_stream);
+  prepareCandidatesForSerialization(layer, cuda_stream);
+  const std::vector<Index3D> block_indices =
+      getNBytesOfBlocks(num_bytes, layer);
+  finishCandidatesSerialization(block_indices);
+  return serializer_.serialize(layer, block_indices, cuda_stream);
+}
+
+template <class LayerType>
+bool LayerStreamerBase<LayerType>::skip_unchanged_blocks() const {
+  return skip_unchanged_blocks_;
+}
+
+template <class LayerType>
+void LayerStreamerBase<LayerType>::skip_unchanged_blocks(
+    bool skip_unchanged_blocks) {
+  skip_unchanged_blocks_ = skip_unchanged_blocks;
+}
+
+template <class LayerType>
+void LayerStreamerBase<LayerType>::clearPublishedBlockHashes() {
+  last_published_block_hashes_.clear();
+}
+
+template <class LayerType>
+int LayerStreamerBase<LayerType>::addRoi(const StreamingRoi& roi) {
+  const int roi_id = next_roi_id_++;
+  auto roi_state = std::make_unique<RoiState>();
+  setRoi(roi, roi_state.get());
+  rois_.emplace(roi_id, std::move(roi_state));
+  return roi_id;
+}
+
+template <class LayerType>
+void LayerStreamerBase<LayerType>::updateRoi(const int roi_id,
+                                             const StreamingRoi& roi) {
+  setRoi(roi, &getRoiState(roi_id));
+}
+
+template <class LayerType>
+void LayerStreamerBase<LayerType>::removeRoi(const int roi_id) {
+  CHECK_EQ(rois_.erase(roi_id), 1u) << "Unknown ROI: " << roi_id;
+}
+
+template <class LayerType>
+bool LayerStreamerBase<LayerType>::hasRoi(const int roi_id) const {
+  return rois_.count(roi_id) > 0;
+}
+
+template <class LayerType>
+int LayerStreamerBase<LayerType>::numRois() const {
+  return rois_.size();
+}
+
+template <class LayerType>
+int LayerStreamerBase<LayerType>::numRoiCandidates(const int roi_id) const {
+  return getRoiState(roi_id).index_set.size();
+}
+
+template <class LayerType>
+void LayerStreamerBase<LayerType>::markIndicesRoiCandidates(
+    const std::vector<Index3D>& block_indices) {
+  for (const auto& [roi_id, roi_state] : rois_) {
+    markIndicesRoiCandidates(roi_id, block_indices);
+  }
+}
+
+template <class LayerType>
+void LayerStreamerBase<LayerType>::markIndicesRoiCandidates(
+    const int roi_id, const std::vector<Index3D>& block_indices) {
+  RoiState& roi_state = getRoiState(roi_id);
+  // Only track the blocks inside of the ROI, such that the candidate set
+  // stays small.
+  for (const Index3D& block_index : block_indices) {
+    const bool exclude = std::any_of(
+        roi_state.exclude_block_functors.begin(),
+        roi_state.exclude_block_functors.end(),
+        [&block_index](const ExcludeBlockFunctor& exclude_block_functor) {
+          return exclude_block_functor(block_index);
+        });
+    if (!exclude) {
+      roi_state.index_set.insert(block_index);
+    }
+  }
+}
+
+template <class LayerType>
+std::vector<Index3D> LayerStreamerBase<LayerType>::getNBytesOfRoiBlocks(
+    const int roi_id, const size_t num_bytes, const LayerType& layer) {
+  RoiState& roi_state = getRoiState(roi_id);
+  swapRoiState(&roi_state);
+  const std::vector<Index3D> block_indices =
+      LayerStreamerBase<LayerType>::getNBytesOfBlocks(num_bytes, layer);
+  swapRoiState(&roi_state);
+  return block_indices;
+}
+
+template <class LayerType>
+std::shared_ptr<const SerializedLayerType<LayerType>>
+LayerStreamerBase<LayerType>::getNBytesOfSerializedRoiBlocks(
+    const int roi_id, const size_t num_bytes, const LayerType& layer,
+    const CudaStream& cuda_stream) {
+  RoiState& roi_state = getRoiState(roi_id);
+  swapRoiState(&roi_state);
+  prepareCandidatesForSerialization(layer, cuda_stream);
+  const std::vector<Index3D> block_indices =
+      LayerStreamerBase<LayerType>::getNBytesOfBlocks(num_bytes, layer);
+  finishCandidatesSerialization(block_indices);
+  swapRoiState(&roi_state);
+  if constexpr (std::is_same<SerializerType<LayerType>,
+                             LayerSerializerGpu<LayerType>>::value) {
+    roi_state.serializer.compress_blocks(serializer_.compress_blocks());
+  }
+  return roi_state.serializer.serialize(layer, block_indices, cuda_stream);
+}
+
+template <class LayerType>
+void LayerStreamerBase<LayerType>::setRoi(const StreamingRoi& roi,
+                                          RoiState* roi_state) {
+  CHECK_GT(roi.block_size_m, 0.0f);
+  roi_state->roi = roi;
+  roi_state->exclude_block_functors.clear();
+  if (roi.aabb_m.has_value()) {
+    roi_state->exclude_block_functors.push_back(
+        getExcludeOutsideAabbFunctor(roi.aabb_m.value(), roi.block_size_m));
+  }
+  if (roi.center_m.has_value() && roi.radius_m.has_value()) {
+    CHECK_GT(roi.radius_m.value(), 0.0f);
+    roi_state->exclude_block_functors.push_back(getExcludeOutsideRadiusFunctor(
+        roi.radius_m.value(), roi.center_m.value(), roi.block_size_m));
+  }
+}
+
+template <class LayerType>
+void LayerStreamerBase<LayerType>::swapRoiState(RoiState* roi_state) {
+  std::swap(index_set_, roi_state->index_set);
+  std::swap(exclude_block_functors_, roi_state->exclude_block_functors);
+  std::swap(last_published_block_hashes_,
+            roi_state->last_published_block_hashes);
+}
+
+template <class LayerType>
+typename LayerStreamerBase<LayerType>::RoiState&
+LayerStreamerBase<LayerType>::getRoiState(const int roi_id) {
+  auto it = rois_.find(roi_id);
+  CHECK(it != rois_.end()) << "Unknown ROI: " << roi_id;
+  return *it->second;
+}
+
+template <class LayerType>
+const typename LayerStreamerBase<LayerType>::RoiState&
+LayerStreamerBase<LayerType>::getRoiState(const int roi_id) const {
+  auto it = rois_.find(roi_id);
+  CHECK(it != rois_.end()) << "Unknown ROI: " << roi_id;
+  return *it->second;
+}
+
+template <class LayerType>
+void LayerStreamerBase<LayerType>::prepareCandidatesForSerialization(
+    const LayerType& layer, const CudaStream& cuda_stream) {
+  compressed_block_num_bytes_.clear();
+  candidate_block_hashes_.clear();
+  // Only voxel layers support compression and change detection.
+  if constexpr (std::is_same<SerializerType<LayerType>,
+                             LayerSerializerGpu<LayerType>>::value) {
+    // Drop candidates which are unchanged since they were last published.
+    if (skip_unchanged_blocks_) {
+      const std::vector<Index3D> candidate_indices(index_set_.begin(),
+                                                   index_set_.end());
+      const std::vector<uint64_t> hashes =
+          serializer_.getBlockHashes(layer, candidate_indices, cuda_stream);
+      for (size_t i = 0; i < candidate_indices.size(); ++i) {
+        const auto it = last_published_block_hashes_.find(candidate_indices[i]);
+        if (it != last_published_block_hashes_.end() &&
+            it->second == hashes[i]) {
+          index_set_.erase(candidate_indices[i]);
+        } else {
+          candidate_block_hashes_.emplace(candidate_indices[i], hashes[i]);
+        }
+      }
+    }
+
+    if (serializer_.compress_blocks()) {
+      const std::vector<Index3D> candidate_indices(index_set_.begin(),
+                                                   index_set_.end());
+      const std::vector<int32_t> compressed_sizes =
+          serializer_.getCompressedBlockSizes(layer, candidate_indices,
+                                              cuda_stream);
+      for (size_t i = 0; i < candidate_indices.size(); ++i) {
+        compressed_block_num_bytes_.emplace(candidate_indices[i],
+                                            compressed_sizes[i]);
+      }
+    }
+  }
+}
+
+template <class LayerType>
+void LayerStreamerBase<LayerType>::finishCandidatesSerialization(
+    const std::vector<Index3D>& streamed_block_indices) {
+  compressed_block_num_bytes_.clear();
+  for (const Index3D& block_index : streamed_block_indices) {
+    const auto it = candidate_block_hashes_.find(block_index);
+    if (it != candidate_block_hashes_.end()) {
+      last_published_block_hashes_[block_index] = it->second;
+    }
+  }
+  candidate_block_hashes_.clear();
 }
 
 template <class LayerType>
@@ -220,7 +501,7 @@ LayerStreamerBase<LayerType>::serializeAllBlocks(
 template <class LayerType>
 std::vector<Index3D> LayerStreamerOldestBlocks<LayerType>::getNBlocks(
     const int num_blocks, const BlockExclusionParams& block_exclusion_params) {
-  setupExclusionFunctors(block_exclusion_params);
+  LayerStreamerBase<LayerType>::setupExclusionFunctors(block_exclusion_params);
   const std::vector<Index3D> block_indices =
       LayerStreamerBase<LayerType>::getNBlocks(num_blocks);
   // Mark these blocks as streamed.
@@ -233,7 +514,7 @@ std::vector<Index3D> LayerStreamerOldestBlocks<LayerType>::getNBytesOfBlocks(
     const size_t num_bytes, const LayerType& layer,
     const BlockExclusionParams& block_exclusion_params) {
   // Calls the base class method, after setting up the exclusion functors.
-  setupExclusionFunctors(block_exclusion_params);
+  LayerStreamerBase<LayerType>::setupExclusionFunctors(block_exclusion_params);
   const std::vector<Index3D> block_indices =
       LayerStreamerBase<LayerType>::getNBytesOfBlocks(num_bytes, layer);
   // Mark these blocks as streamed.
@@ -247,9 +528,13 @@ LayerStreamerOldestBlocks<LayerType>::getNBytesOfSerializedBlocks(
     const size_t num_bytes, const LayerType& layer,
     const BlockExclusionParams& block_exclusion_params,
     const CudaStream& cuda_stream) {
+  LayerStreamerBase<LayerType>::prepareCandidatesForSerialization(
+      layer, cuda_stream);
+  const std::vector<Index3D> block_indices =
+      getNBytesOfBlocks(num_bytes, layer, block_exclusion_params);
+  LayerStreamerBase<LayerType>::finishCandidatesSerialization(block_indices);
   return LayerStreamerBase<LayerType>::serializer_.serialize(
-      layer, getNBytesOfBlocks(num_bytes, layer, block_exclusion_params),
-      cuda_stream);
+      layer, block_indices, cuda_stream);
 }
 
 template <class LayerType>
@@ -289,67 +574,6 @@ void LayerStreamerOldestBlocks<LayerType>::updateBlocksLastPublishIndex(
   CHECK_LT(publishing_index_, std::numeric_limits<int64_t>::max());
 }
 
-template <class LayerType>
-void LayerStreamerOldestBlocks<LayerType>::setupExclusionFunctors(
-    const BlockExclusionParams& block_exclusion_params) {
-  // If requested exclude blocks
-  std::vector<ExcludeBlockFunctor> exclusion_functors;
-  // Exclude based on height
-  if (block_exclusion_params.exclusion_height_m.has_value() &&
-      block_exclusion_params.block_size_m.has_value() &&
-      block_exclusion_params.exclusion_height_m.value() > 0.0) {
-    exclusion_functors.push_back(getExcludeAboveHeightFunctor(
-        block_exclusion_params.exclusion_height_m.value(),
-        block_exclusion_params.block_size_m.value()));
-  }
-  // Exclude based on radius
-  if (block_exclusion_params.block_size_m.has_value() &&
-      block_exclusion_params.exclusion_center_m.has_value() &&
-      block_exclusion_params.exclusion_radius_m.has_value() &&
-      block_exclusion_params.exclusion_radius_m.value() > 0.0) {
-    exclusion_functors.push_back(getExcludeOutsideRadiusFunctor(
-        block_exclusion_params.exclusion_radius_m.value(),
-        block_exclusion_params.exclusion_center_m.value(),
-        block_exclusion_params.block_size_m.value()));
-  }
-  LayerStreamerBase<LayerType>::setExclusionFunctors(exclusion_functors);
-}
-
-template <class LayerType>
-ExcludeBlockFunctor
-LayerStreamerOldestBlocks<LayerType>::getExcludeAboveHeightFunctor(
-    const float exclusion_height_m, const float block_size_m) {
-  // Create a functor which returns true if a blocks minimum height is above
-  // a limit.
-  return [exclusion_height_m, block_size_m](const Index3D& idx) -> bool {
-    // Exclude block if it's low corner/plane is above the exclusion
-    // limit
-    const float low_z_m = static_cast<float>(idx.z()) * block_size_m;
-    return low_z_m > exclusion_height_m;
-  };
-}
-
-template <class LayerType>
-ExcludeBlockFunctor
-LayerStreamerOldestBlocks<LayerType>::getExcludeOutsideRadiusFunctor(
-    const float exclude_blocks_radius_m, const Vector3f& center_m,
-    const float block_size_m) {
-  // Square the radius outside
-  const float exclude_blocks_radius_squared_m2 =
-      exclude_blocks_radius_m * exclude_blocks_radius_m;
-  // Create a functor which returns true if the block center is a greater radius
-  // from the passed center.
-  return [exclude_blocks_radius_squared_m2, center_m,
-          block_size_m](const Index3D& idx) -> bool {
-    // Calculate the blocks center position
-    const Vector3f block_center =
-        getCenterPositionFromBlockIndex(block_size_m, idx);
-    const float block_radius_squared_m2 =
-        (block_center - center_m).squaredNorm();
-    return block_radius_squared_m2 > exclude_blocks_radius_squared_m2;
-  };
-}
-
 template <class LayerType>
 std::shared_ptr<const SerializedLayerType<LayerType>>
 LayerStreamerOldestBlocks<LayerType>::estimateBandwidthAndSerialize(
@@ -390,4 +614,171 @@ LayerStreamerOldestBlocks<LayerType>::estimateBandwidthAndSerialize(
   return ret;
 }
 
+template <class LayerType>
+LayerStreamerViewPriority<LayerType>::LayerStreamerViewPriority(
+    const float block_size_m)
+    : block_size_m_(block_size_m) {
+  CHECK_GT(block_size_m_, 0.0f);
+}
+
+template <class LayerType>
+void LayerStreamerViewPriority<LayerType>::markIndicesCandidates(
+    const std::vector<Index3D>& block_indices) {
+  for (const Index3D& block_index : block_indices) {
+    auto it = block_changes_.find(block_index);
+    if (it == block_changes_.end()) {
+      it = block_changes_
+               .emplace(block_index,
+                        BlockChange{.num_updates = 0,
+                                    .first_candidate_round = streaming_round_})
+               .first;
+    }
+    ++it->second.num_updates;
+  }
+  LayerStreamerBase<LayerType>::markIndicesCandidates(block_indices);
+}
+
+template <class LayerType>
+void LayerStreamerViewPriority<LayerType>::setRobotPosition(
+    const Vector3f& robot_position_m) {
+  view_.robot_position_m = robot_position_m;
+}
+
+template <class LayerType>
+void LayerStreamerViewPriority<LayerType>::setCameraView(
+    const Camera& camera, const Transform& T_L_C) {
+  view_.has_camera = true;
+  view_.camera = camera;
+  view_.T_C_L = T_L_C.inverse();
+  view_.robot_position_m = T_L_C.translation();
+}
+
+template <class LayerType>
+void LayerStreamerViewPriority<LayerType>::clearCameraView() {
+  view_.has_camera = false;
+}
+
+template <class LayerType>
+std::vector<Index3D> LayerStreamerViewPriority<LayerType>::getNBlocks(
+    const int num_blocks) {
+  const std::vector<Index3D> block_indices =
+      LayerStreamerBase<LayerType>::getNBlocks(num_blocks);
+  updateChangeTracking();
+  return block_indices;
+}
+
+template <class LayerType>
+std::vector<Index3D> LayerStreamerViewPriority<LayerType>::getNBytesOfBlocks(
+    const size_t num_bytes, const LayerType& layer) {
+  const std::vector<Index3D> block_indices =
+      LayerStreamerBase<LayerType>::getNBytesOfBlocks(num_bytes, layer);
+  updateChangeTracking();
+  return block_indices;
+}
+
+template <class LayerType>
+std::shared_ptr<const SerializedLayerType<LayerType>>
+LayerStreamerViewPriority<LayerType>::getNBytesOfSerializedBlocks(
+    const size_t num_bytes, const LayerType& layer,
+    const CudaStream& cuda_stream) {
+  LayerStreamerBase<LayerType>::prepareCandidatesForSerialization(
+      layer, cuda_stream);
+  const std::vector<Index3D> block_indices =
+      getNBytesOfBlocks(num_bytes, layer);
+  LayerStreamerBase<LayerType>::finishCandidatesSerialization(block_indices);
+  return LayerStreamerBase<LayerType>::serializer_.serialize(
+      layer, block_indices, cuda_stream);
+}
+
+template <class LayerType>
+std::vector<float> LayerStreamerViewPriority<LayerType>::computePriorities(
+    const std::vector<Index3D>& block_indices) const {
+  std::vector<BlockPriorityInput> inputs;
+  inputs.reserve(block_indices.size());
+  for (const Index3D& block_index : block_indices) {
+    BlockPriorityInput input{.block_index = block_index,
+                             .num_updates = 0,
+                             .num_rounds_waiting = 0};
+    const auto it = block_changes_.find(block_index);
+    if (it != block_changes_.end()) {
+      input.num_updates = it->second.num_updates;
+      input.num_rounds_waiting = static_cast<int32_t>(
+          streaming_round_ - it->second.first_candidate_round);
+    }
+    inputs.push_back(input);
+  }
+  std::vector<float> priorities;
+  priority_calculator_.computePriorities(block_size_m_, view_, weights_,
+                                         inputs, &priorities);
+  return priorities;
+}
+
+template <class LayerType>
+void LayerStreamerViewPriority<LayerType>::updateChangeTracking() {
+  // Blocks that are no longer candidates were either streamed or dropped.
+  for (auto it = block_changes_.begin(); it != block_changes_.end();) {
+    if (LayerStreamerBase<LayerType>::index_set_.count(it->first) == 0) {
+      it = block_changes_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  ++streaming_round_;
+}
+
+template <class LayerType>
+float LayerStreamerViewPriority<LayerType>::in_view_weight() const {
+  return weights_.in_view;
+}
+
+template <class LayerType>
+void LayerStreamerViewPriority<LayerType>::in_view_weight(
+    float in_view_weight) {
+  weights_.in_view = in_view_weight;
+}
+
+template <class LayerType>
+float LayerStreamerViewPriority<LayerType>::change_weight() const {
+  return weights_.change;
+}
+
+template <class LayerType>
+void LayerStreamerViewPriority<LayerType>::change_weight(float change_weight) {
+  weights_.change = change_weight;
+}
+
+template <class LayerType>
+float LayerStreamerViewPriority<LayerType>::staleness_weight() const {
+  return weights_.staleness;
+}
+
+template <class LayerType>
+void LayerStreamerViewPriority<LayerType>::staleness_weight(
+    float staleness_weight) {
+  weights_.staleness = staleness_weight;
+}
+
+template <class LayerType>
+float LayerStreamerViewPriority<LayerType>::distance_weight() const {
+  return weights_.distance;
+}
+
+template <class LayerType>
+void LayerStreamerViewPriority<LayerType>::distance_weight(
+    float distance_weight) {
+  weights_.distance = distance_weight;
+}
+
+template <class LayerType>
+float LayerStreamerViewPriority<LayerType>::max_view_distance_m() const {
+  return view_.max_view_distance_m;
+}
+
+template <class LayerType>
+void LayerStreamerViewPriority<LayerType>::max_view_distance_m(
+    float max_view_distance_m) {
+  CHECK_GT(max_view_distance_m, 0.0f);
+  view_.max_view_distance_m = max_view_distance_m;
+}
+
 };  // namespace nvblox
@@ -0,0 +1,93 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#pragma once
+
+namespace nvblox {
+namespace mesh_compression {
+
+constexpr float kMaxQuantizedValue = 65535.0f;
+constexpr float kMaxSnorm8Value = 127.0f;
+
+__host__ __device__ inline uint16_t quantizeVertexCoordinate(
+    const float coordinate_m, const float block_size_m) {
+  const float normalized =
+      coordinate_m / (block_size_m * kQuantizedVertexRangeBlocks);
+  const float clamped = fminf(fmaxf(normalized, 0.0f), 1.0f);
+  return static_cast<uint16_t>(clamped * kMaxQuantizedValue + 0.5f);
+}
+
+__host__ __device__ inline float dequantizeVertexCoordinate(
+    const uint16_t quantized_coordinate, const float block_size_m) {
+  return static_cast<float>(quantized_coordinate) / kMaxQuantizedValue *
+         block_size_m * kQuantizedVertexRangeBlocks;
+}
+
+__host__ __device__ inline float signNotZero(const float value) {
+  return (value >= 0.0f) ? 1.0f : -1.0f;
+}
+
+__host__ __device__ inline uint8_t toSnorm8(const float value) {
+  const float clamped = fminf(fmaxf(value, -1.0f), 1.0f);
+  return static_cast<uint8_t>(
+      static_cast<int8_t>(roundf(clamped * kMaxSnorm8Value)));
+}
+
+__host__ __device__ inline float fromSnorm8(const uint8_t value) {
+  return fmaxf(static_cast<float>(static_cast<int8_t>(value)) /
+                   kMaxSnorm8Value,
+               -1.0f);
+}
+
+__host__ __device__ inline void encodeOctahedralNormal(
+    const Vector3f& normal, uint8_t* encoded_normal) {
+  const float l1_norm = fabsf(normal.x()) + fabsf(normal.y()) +
+                        fabsf(normal.z());
+  if (l1_norm <= 0.0f) {
+    // Degenerate normals are encoded as +z.
+    encoded_normal[0] = 0;
+    encoded_normal[1] = 0;
+    return;
+  }
+  // Project onto the octahedron |x| + |y| + |z| = 1, and fold the lower
+  // hemisphere over the diagonals.
+  float x = normal.x() / l1_norm;
+  float y = normal.y() / l1_norm;
+  if (normal.z() < 0.0f) {
+    const float folded_x = (1.0f - fabsf(y)) * signNotZero(x);
+    const float folded_y = (1.0f - fabsf(x)) * signNotZero(y);
+    x = folded_x;
+    y = folded_y;
+  }
+  encoded_normal[0] = toSnorm8(x);
+  encoded_normal[1] = toSnorm8(y);
+}
+
+__host__ __device__ inline Vector3f decodeOctahedralNormal(
+    const uint8_t* encoded_normal) {
+  float x = fromSnorm8(encoded_normal[0]);
+  float y = fromSnorm8(encoded_normal[1]);
+  const float z = 1.0f - fabsf(x) - fabsf(y);
+  if (z < 0.0f) {
+    const float unfolded_x = (1.0f - fabsf(y)) * signNotZero(x);
+    const float unfolded_y = (1.0f - fabsf(x)) * signNotZero(y);
+    x = unfolded_x;
+    y = unfolded_y;
+  }
+  return Vector3f(x, y, z).normalized();
+}
+
+}  // namespace mesh_compression
+}  // namespace nvblox
@@ -0,0 +1,62 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#pragma once
+
+#include <cstring>
+
+namespace nvblox {
+
+template <typename VoxelType, int kNumVoxels>
+bool decompressVoxelBlock(const uint8_t* compressed, const int num_bytes,
+                          VoxelType* voxels) {
+  static_assert(kNumVoxels % 32 == 0,
+                "The number of voxels must be a multiple of the mask word "
+                "size.");
+  constexpr int kNumMaskWords = kNumVoxels / 32;
+  constexpr int kNumMaskBytes = kNumMaskWords * sizeof(uint32_t);
+  constexpr int kVoxelNumBytes = sizeof(VoxelType);
+  if (num_bytes < kNumMaskBytes + kVoxelNumBytes ||
+      (num_bytes - kNumMaskBytes) % kVoxelNumBytes != 0) {
+    return false;
+  }
+  uint32_t mask[kNumMaskWords];
+  std::memcpy(mask, compressed, kNumMaskBytes);
+  const uint8_t* stored_voxels = compressed + kNumMaskBytes;
+  const int num_stored_voxels = (num_bytes - kNumMaskBytes) / kVoxelNumBytes;
+
+  // Walk the voxels, taking the next stored voxel where the mask bit is set,
+  // and repeating the previous one otherwise.
+  int num_read_voxels = 0;
+  for (int i = 0; i < kNumVoxels; i++) {
+    const bool is_stored = (mask[i / 32] >> (i % 32)) & 1u;
+    if (is_stored) {
+      if (num_read_voxels >= num_stored_voxels) {
+        return false;
+      }
+      std::memcpy(&voxels[i], stored_voxels + num_read_voxels * kVoxelNumBytes,
+                  kVoxelNumBytes);
+      num_read_voxels++;
+    } else {
+      if (i == 0) {
+        return false;
+      }
+      std::memcpy(&voxels[i], &voxels[i - 1], kVoxelNumBytes);
+    }
+  }
+  return num_read_voxels == num_stored_voxels;
+}
+
+}  // namespace nvblox
@@ -77,4 +77,34 @@ class LayerSerializerGpuInternal {
   host_vector<const T*> vector_ptrs_;
 };
 
+/// Class for copying many equally sized chunks from a contiguous host buffer
+/// into scattered device destinations, e.g. the voxels of loaded blocks.
+///
+/// Rather than issuing one small copy per chunk, the source is transferred in
+/// a few large copies into a device staging buffer. A kernel then scatters the
+/// chunks to their destinations. The source should preferably be pinned (or
+/// registered with cudaHostRegister) for the copies to reach full bandwidth.
+class ScatterCopierGpu {
+ public:
+  /// Largest number of bytes transferred to the device per copy.
+  static constexpr size_t kMaxNumBytesPerCopy = 64 * 1024 * 1024;
+
+  /// Copy chunk i of the source to destinations[i].
+  ///
+  /// @param source             Contiguous host buffer of
+  ///                           destinations.size() * num_bytes_per_chunk bytes.
+  /// @param num_bytes_per_chunk  Size of each chunk.
+  /// @param destinations       Device (or unified) destination pointers.
+  /// @param cuda_stream        Cuda stream. Synchronized before returning,
+  ///                           such that the source may be released.
+  void scatter(const Byte* source, size_t num_bytes_per_chunk,
+               const std::vector<Byte*>& destinations,
+               const CudaStream& cuda_stream);
+
+ private:
+  device_vector<Byte> staging_device_;
+  host_vector<Byte*> destinations_host_;
+  device_vector<Byte*> destinations_device_;
+};
+
 }  // namespace nvblox
@@ -0,0 +1,107 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "nvblox/core/cuda_stream.h"
+#include "nvblox/core/types.h"
+#include "nvblox/core/unified_vector.h"
+#include "nvblox/map/common_names.h"
+#include "nvblox/map/layer.h"
+
+namespace nvblox {
+
+/// Compressed voxel blocks are encoded as
+///    [ mask_0, ..., mask_w, v_0, ..., v_k ]
+/// where mask is a bitmask with one bit per voxel (in memory order), packed
+/// into w = kNumVoxels / 32 32-bit words, and v_0...v_k are the voxels with
+/// their bit set. A voxel's bit is set if it differs from the voxel before
+/// it. The first voxel is always stored. Runs of equal voxels, such as
+/// unobserved voxels or free space at the truncation distance, are therefore
+/// stored only once.
+///
+/// Empty (unallocated) blocks are encoded with zero bytes.
+
+/// Class for GPU compression of the voxel blocks of a layer.
+template <typename LayerType, typename VoxelType>
+class LayerCompressorGpuInternal {
+ public:
+  /// Computes the compressed size of blocks.
+  /// @param layer                       Layer containing the blocks
+  /// @param block_indices               Indices of the blocks
+  /// @param num_bytes_output            The number of bytes of each block
+  ///                                    after compression
+  /// @param cuda_stream                 Cuda stream. Will be synced.
+  void computeCompressedSizes(const LayerType& layer,
+                              const std::vector<Index3D>& block_indices,
+                              host_vector<int32_t>& num_bytes_output,
+                              const CudaStream& cuda_stream);
+
+  /// Compresses blocks into a contiguous buffer.
+  ///
+  /// Offsets (in bytes) of the compressed blocks are returned in the same
+  /// format as LayerSerializerGpuInternal::serializeAsync(), i.e. the size of
+  /// block n is offsets[n+1] - offsets[n].
+  /// @param layer                       Layer containing the blocks
+  /// @param block_indices               Indices of the blocks to compress
+  /// @param compressed_output           Resulting contiguous buffer
+  /// @param offsets_output              Resulting (byte) offsets
+  /// @param cuda_stream                 Cuda stream. Will be synced.
+  void compress(const LayerType& layer,
+                     const std::vector<Index3D>& block_indices,
+                     host_vector<uint8_t>& compressed_output,
+                     host_vector<int32_t>& offsets_output,
+                     const CudaStream& cuda_stream);
+
+  /// Computes a hash of the contents of blocks.
+  ///
+  /// Blocks with equal voxels (bytewise) have equal hashes, such that the
+  /// hash can be used to detect whether a block changed. Unallocated blocks
+  /// have hash zero.
+  /// @param layer                       Layer containing the blocks
+  /// @param block_indices               Indices of the blocks
+  /// @param hashes_output               The hash of each block
+  /// @param cuda_stream                 Cuda stream. Will be synced.
+  void computeBlockHashes(const LayerType& layer,
+                          const std::vector<Index3D>& block_indices,
+                          host_vector<uint64_t>& hashes_output,
+                          const CudaStream& cuda_stream);
+
+ private:
+  // Gathers the voxel pointers of the blocks. Unallocated blocks get nullptr.
+  void getBlockPtrs(const LayerType& layer,
+                    const std::vector<Index3D>& block_indices,
+                    const CudaStream& cuda_stream);
+
+  // Scratch data
+  host_vector<const VoxelType*> block_ptrs_;
+  host_vector<int32_t> num_bytes_;
+};
+
+/// Decompresses a single block compressed by LayerCompressorGpuInternal.
+/// @param compressed  The compressed block
+/// @param num_bytes   The size of the compressed block
+/// @param voxels      Output. Must have space for kNumVoxels voxels.
+/// @return False if the block is empty or malformed.
+template <typename VoxelType, int kNumVoxels>
+bool decompressVoxelBlock(const uint8_t* compressed, const int num_bytes,
+                          VoxelType* voxels);
+
+}  // namespace nvblox
+
+#include "nvblox/serialization/internal/impl/voxel_block_compression_impl.h"
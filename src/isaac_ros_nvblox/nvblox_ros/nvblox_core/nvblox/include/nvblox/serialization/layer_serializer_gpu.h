@@ -24,6 +24,7 @@ limitations under the License.
 #include "nvblox/map/common_names.h"
 #include "nvblox/map/layer.h"
 #include "nvblox/serialization/internal/serialization_gpu.h"
+#include "nvblox/serialization/internal/voxel_block_compression.h"
 
 namespace nvblox {
 
@@ -40,8 +41,32 @@ struct SerializedLayer {
   /// Get the first voxel of block i: voxels[block_offsets[i]]
   /// Get the size of block i: block_offsets[i+1] - block_offsets[i]
   host_vector<int32_t> block_offsets;
+
+  /// Whether the blocks are compressed. If so, voxels and block_offsets are
+  /// empty and the blocks are stored in compressed_blocks instead. See
+  /// decompressSerializedLayer().
+  bool is_compressed = false;
+
+  /// Compressed blocks (see voxel_block_compression.h for the format).
+  host_vector<uint8_t> compressed_blocks;
+
+  /// Store offset in bytes for each block in block_indices.
+  /// Get the size of compressed block i:
+  ///   compressed_block_offsets[i+1] - compressed_block_offsets[i]
+  host_vector<int32_t> compressed_block_offsets;
 };
 
+/// Decompress a serialized layer.
+///
+/// Fills voxels and block_offsets from the compressed blocks, such that the
+/// result is equivalent to an uncompressed serialization. Does nothing if the
+/// serialized layer is not compressed.
+/// @param serialized_layer The layer to decompress.
+/// @return False if any of the compressed blocks is malformed.
+template <typename VoxelType,
+          int kNumVoxels = VoxelBlock<VoxelType>::kNumVoxels>
+bool decompressSerializedLayer(SerializedLayer<VoxelType>* serialized_layer);
+
 using SerializedTsdfLayer = SerializedLayer<TsdfVoxel>;
 using SerializedColorLayer = SerializedLayer<ColorVoxel>;
 using SerializedOccupancyLayer = SerializedLayer<OccupancyVoxel>;
@@ -81,8 +106,49 @@ class LayerSerializerGpu {
     return serialized_layer_;
   }
 
+  /// Computes the size (in bytes) of the blocks once compressed.
+  ///
+  /// layer          Layer containing the blocks
+  /// block_indices  Block indices
+  /// cuda_stream    Cuda stream. Will be synced
+  /// @return The compressed size of each block. Zero for unallocated blocks.
+  std::vector<int32_t> getCompressedBlockSizes(
+      const LayerType& layer, const std::vector<Index3D>& block_indices,
+      const CudaStream& cuda_stream);
+
+  /// Computes hashes of the contents of blocks.
+  ///
+  /// Equal blocks have equal hashes. See
+  /// LayerCompressorGpuInternal::computeBlockHashes().
+  /// layer          Layer containing the blocks
+  /// block_indices  Block indices
+  /// cuda_stream    Cuda stream. Will be synced
+  /// @return The hash of each block. Zero for unallocated blocks.
+  std::vector<uint64_t> getBlockHashes(
+      const LayerType& layer, const std::vector<Index3D>& block_indices,
+      const CudaStream& cuda_stream);
+
+  /// A parameter getter
+  /// Whether serialize() compresses the voxel blocks. Compressed blocks store
+  /// runs of equal voxels once, which shrinks TSDF and occupancy blocks
+  /// considerably.
+  /// @returns whether blocks are compressed
+  bool compress_blocks() const { return compress_blocks_; }
+
+  /// A parameter setter
+  /// See compress_blocks()
+  /// @param compress_blocks whether to compress blocks
+  void compress_blocks(bool compress_blocks) {
+    compress_blocks_ = compress_blocks;
+  }
+
  private:
   LayerSerializerGpuInternal<LayerType, VoxelType> serializer_;
+  LayerCompressorGpuInternal<LayerType, VoxelType> compressor_;
+  host_vector<int32_t> compressed_block_sizes_;
+  host_vector<uint64_t> block_hashes_;
+
+  bool compress_blocks_ = false;
 
   std::shared_ptr<SerializedLayerType> serialized_layer_;
 };
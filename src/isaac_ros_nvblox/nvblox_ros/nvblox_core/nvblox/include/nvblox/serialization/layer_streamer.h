@@ -15,13 +15,17 @@ limitations under the License.
 */
 #pragma once
 
+#include <map>
 #include <memory>
 #include <optional>
 
 #include "nvblox/core/hash.h"
 #include "nvblox/core/parameter_tree.h"
 #include "nvblox/core/types.h"
+#include "nvblox/geometry/bounding_boxes.h"
 #include "nvblox/map/common_names.h"
+#include "nvblox/sensors/camera.h"
+#include "nvblox/serialization/internal/block_priority_gpu.h"
 #include "nvblox/serialization/internal/layer_streamer_traits.h"
 #include "nvblox/utils/rates.h"
 
@@ -41,6 +45,20 @@ struct BlockExclusionParams {
   std::optional<float> block_size_m = std::nullopt;
 };
 
+/// A region of interest (ROI) for layer streaming. A consumer subscribed to an
+/// ROI only receives the blocks inside of it.
+struct StreamingRoi {
+  /// If set, only blocks touched by this box are streamed.
+  std::optional<AxisAlignedBoundingBox> aabb_m = std::nullopt;
+  /// If set (together with radius_m), only blocks whose center is within
+  /// radius_m of this point are streamed.
+  std::optional<Vector3f> center_m = std::nullopt;
+  /// The radius (in meters) around center_m.
+  std::optional<float> radius_m = std::nullopt;
+  /// The block size of the streamed layer.
+  float block_size_m = 0.0f;
+};
+
 // A function which tell the class whether to exclude a block from
 // streaming
 using ExcludeBlockFunctor = std::function<bool(const Index3D&)>;
@@ -95,6 +113,10 @@ class LayerStreamerBase : public LayerStreamerInterface {
 
   /// @brief Returns highest priority serialized blocks up to N bytes
   ///
+  /// If the serializer compresses blocks, the budget counts compressed bytes.
+  /// If skip_unchanged_blocks() is set, candidates which did not change since
+  /// they were last returned by this function are dropped.
+  ///
   /// @param num_bytes The maximum number of bytes returned
   /// @param layer layer to serialize
   /// @param cuda_stream Cuda stream.
@@ -128,6 +150,97 @@ class LayerStreamerBase : public LayerStreamerInterface {
   void setExclusionFunctors(
       std::vector<ExcludeBlockFunctor> exclude_block_functors);
 
+  /// @brief Sets up the exclusion functors from exclusion params. We
+  /// (optionally) set up "blocks above height" and "blocks outside radius"
+  /// exclusion functors.
+  /// @param block_exclusion_params Specifies which blocks should be excluded
+  /// from streaming.
+  void setupExclusionFunctors(
+      const BlockExclusionParams& block_exclusion_params);
+
+  /// @brief Get the serializer, for example to change its parameters.
+  SerializerType<LayerType>& serializer() { return serializer_; }
+
+  /// @brief A parameter getter
+  /// Whether getNBytesOfSerializedBlocks() skips candidate blocks whose
+  /// contents are unchanged since they were last streamed. Changes are
+  /// detected by comparing hashes of the block contents. Only supported for
+  /// voxel layers.
+  /// @return whether unchanged blocks are skipped
+  bool skip_unchanged_blocks() const;
+
+  /// @brief A parameter setter
+  /// See skip_unchanged_blocks()
+  /// @param skip_unchanged_blocks whether to skip unchanged blocks
+  void skip_unchanged_blocks(bool skip_unchanged_blocks);
+
+  /// @brief Forget what was streamed, such that all candidates are streamed
+  /// again. For example when the receiver lost its map.
+  void clearPublishedBlockHashes();
+
+  /// @brief Adds a region of interest (ROI). Each ROI has its own candidates
+  /// (see markIndicesRoiCandidates()) and is streamed with its own byte
+  /// budget (see getNBytesOfSerializedRoiBlocks()), independently of the
+  /// candidates of the streamer itself.
+  /// @param roi The region.
+  /// @return The id of the ROI.
+  int addRoi(const StreamingRoi& roi);
+
+  /// @brief Changes the region of an ROI, for example to follow the robot.
+  /// Candidates outside of the new region are dropped when streaming.
+  /// @param roi_id The id returned by addRoi().
+  /// @param roi The new region.
+  void updateRoi(const int roi_id, const StreamingRoi& roi);
+
+  /// @brief Removes an ROI and its candidates.
+  /// @param roi_id The id returned by addRoi().
+  void removeRoi(const int roi_id);
+
+  /// @brief Whether an ROI with this id exists.
+  bool hasRoi(const int roi_id) const;
+
+  /// @brief The number of ROIs.
+  int numRois() const;
+
+  /// @brief The number of candidates of an ROI.
+  /// @param roi_id The id returned by addRoi().
+  int numRoiCandidates(const int roi_id) const;
+
+  /// @brief Marks these block indices as candidates of all ROIs containing
+  /// them. Doesn't touch the candidates of the streamer itself.
+  /// @param block_indices The indices of the candidate blocks
+  void markIndicesRoiCandidates(const std::vector<Index3D>& block_indices);
+
+  /// @brief Marks these block indices as candidates of a single ROI, for
+  /// example to send the existing map to a new ROI.
+  /// @param roi_id The id returned by addRoi().
+  /// @param block_indices The indices of the candidate blocks
+  void markIndicesRoiCandidates(const int roi_id,
+                                const std::vector<Index3D>& block_indices);
+
+  /// @brief Returns the highest priority candidates of an ROI up to N bytes
+  /// in size. See getNBytesOfBlocks().
+  /// @param roi_id The id returned by addRoi().
+  /// @param num_bytes The maximum number of bytes returned
+  /// @param layer The layer which will be streamed.
+  /// @return The list of highest priority block indices.
+  std::vector<Index3D> getNBytesOfRoiBlocks(const int roi_id,
+                                            const size_t num_bytes,
+                                            const LayerType& layer);
+
+  /// @brief Returns the highest priority serialized candidates of an ROI up
+  /// to N bytes. See getNBytesOfSerializedBlocks(). Each ROI has its own
+  /// serializer, so this doesn't invalidate getSerializedLayer().
+  /// @param roi_id The id returned by addRoi().
+  /// @param num_bytes The maximum number of bytes returned
+  /// @param layer layer to serialize
+  /// @param cuda_stream Cuda stream.
+  /// @return Serialized containing highest priority blocks of the ROI
+  std::shared_ptr<const SerializedLayerType<LayerType>>
+  getNBytesOfSerializedRoiBlocks(const int roi_id, const size_t num_bytes,
+                                 const LayerType& layer,
+                                 const CudaStream& cuda_stream);
+
  protected:
   // The function which determines a block's priority to be streamed.
   virtual std::vector<float> computePriorities(
@@ -151,6 +264,16 @@ class LayerStreamerBase : public LayerStreamerInterface {
   // A function that determines if a block should be streamed.
   using StreamStatusFunctor = std::function<StreamStatus(const Index3D&)>;
 
+  static ExcludeBlockFunctor getExcludeAboveHeightFunctor(
+      const float exclusion_height_m, const float block_size_m);
+
+  static ExcludeBlockFunctor getExcludeOutsideRadiusFunctor(
+      const float exclude_blocks_radius_m, const Vector3f& center_m,
+      const float block_size_m);
+
+  static ExcludeBlockFunctor getExcludeOutsideAabbFunctor(
+      const AxisAlignedBoundingBox& aabb_m, const float block_size_m);
+
   // A list of functors for testing blocks to be excluded from streaming
   // altogether.
   std::vector<ExcludeBlockFunctor> exclude_block_functors_;
@@ -167,8 +290,56 @@ class LayerStreamerBase : public LayerStreamerInterface {
   // not yet been streamed.
   Index3DSet index_set_;
 
+  // Called before selecting blocks for serialization. Drops unchanged
+  // candidates (if requested) and, if the serializer compresses blocks,
+  // computes the compressed sizes of the candidate blocks such that the byte
+  // budget counts compressed bytes.
+  void prepareCandidatesForSerialization(const LayerType& layer,
+                                         const CudaStream& cuda_stream);
+
+  // Called after selecting blocks for serialization. Records the hashes of
+  // the streamed blocks.
+  void finishCandidatesSerialization(
+      const std::vector<Index3D>& streamed_block_indices);
+
   // Handles serialization of the layer
   SerializerType<LayerType> serializer_;
+
+  // Compressed sizes (in bytes) of the candidate blocks. Empty unless
+  // compression is used. Used in place of the block sizes by
+  // getNBytesOfBlocks().
+  Index3DHashMapType<int32_t>::type compressed_block_num_bytes_;
+
+  // Change detection (see skip_unchanged_blocks()). The hashes of the blocks
+  // when they were last streamed, and of the current candidates.
+  bool skip_unchanged_blocks_ = false;
+  Index3DHashMapType<uint64_t>::type last_published_block_hashes_;
+  Index3DHashMapType<uint64_t>::type candidate_block_hashes_;
+
+  // What we track per ROI. Mirrors the candidate state of the streamer.
+  struct RoiState {
+    StreamingRoi roi;
+    std::vector<ExcludeBlockFunctor> exclude_block_functors;
+    Index3DSet index_set;
+    Index3DHashMapType<uint64_t>::type last_published_block_hashes;
+    SerializerType<LayerType> serializer;
+  };
+
+  // Sets the region of an ROI and creates its exclusion functors.
+  static void setRoi(const StreamingRoi& roi, RoiState* roi_state);
+
+  // Swaps the candidates, exclusion functors and published block hashes of
+  // the streamer with those of an ROI. Selecting blocks between two swaps
+  // therefore selects the blocks of the ROI.
+  void swapRoiState(RoiState* roi_state);
+
+  RoiState& getRoiState(const int roi_id);
+  const RoiState& getRoiState(const int roi_id) const;
+
+  // The ROIs by id. The states are heap allocated because serializers can't
+  // be moved.
+  std::map<int, std::unique_ptr<RoiState>> rois_;
+  int next_roi_id_ = 0;
 };
 
 /// @brief A concrete child class of LayerStreamerBase.
@@ -243,19 +414,6 @@ class LayerStreamerOldestBlocks : public LayerStreamerBase<_LayerType> {
   // been streamed.
   void updateBlocksLastPublishIndex(const std::vector<Index3D>& block_indices);
 
-  // Sets up the exclusion functors for this child class.
-  // For this child class we (optionally) set up "blocks above height" and
-  // "blocks outside radius" exclusion functors.
-  void setupExclusionFunctors(
-      const BlockExclusionParams& block_exclusion_params);
-
-  static ExcludeBlockFunctor getExcludeAboveHeightFunctor(
-      const float exclusion_height_m, const float block_size_m);
-
-  static ExcludeBlockFunctor getExcludeOutsideRadiusFunctor(
-      const float exclude_blocks_radius_m, const Vector3f& center_m,
-      const float block_size_m);
-
   // The counts up with each call to getNBlocks(). It is used to indicate
   // the "when" blocks are returned for streaming.
   int64_t publishing_index_ = 0;
@@ -263,6 +421,147 @@ class LayerStreamerOldestBlocks : public LayerStreamerBase<_LayerType> {
   BlockIndexToLastPublishedIndexMap last_published_map_;
 };
 
+/// @brief A concrete child class of LayerStreamerBase.
+///
+/// This class implements a computePriorities() function which prioritizes
+/// blocks that are close to the robot, that are in view of the camera and
+/// that changed a lot since they were last streamed. More precisely, the
+/// priority of a block is (see BlockPriorityWeights):
+///   in_view_weight * [block in camera view]
+///   + change_weight * (number of times marked since last streamed)
+///   + staleness_weight * (number of streaming rounds waited)
+///   - distance_weight * (distance to robot in meters)
+/// The staleness term ensures that far-away blocks are eventually streamed.
+/// Priorities are computed on the GPU.
+template <class _LayerType>
+class LayerStreamerViewPriority : public LayerStreamerBase<_LayerType> {
+ public:
+  using LayerType = _LayerType;
+
+  /// @brief Constructor
+  /// @param block_size_m The block size of the streamed layer.
+  explicit LayerStreamerViewPriority(const float block_size_m);
+  virtual ~LayerStreamerViewPriority() = default;
+
+  /// @brief Marks blocks as candidates for streaming. Each call counts as a
+  /// change of the block.
+  /// @param block_indices The candidate blocks.
+  void markIndicesCandidates(const std::vector<Index3D>& block_indices);
+
+  /// @brief Sets the position of the robot used for the distance term.
+  /// @param robot_position_m The robot position in the layer frame.
+  void setRobotPosition(const Vector3f& robot_position_m);
+
+  /// @brief Sets the camera used for the in-view term. Also sets the robot
+  /// position to the camera position.
+  /// @param camera The camera.
+  /// @param T_L_C The pose of the camera in the layer frame.
+  void setCameraView(const Camera& camera, const Transform& T_L_C);
+
+  /// @brief Removes the camera. The in-view term is not applied.
+  void clearCameraView();
+
+  /// @brief Returns the N highest priority blocks for publishing
+  /// @param num_blocks The number of blocks you want.
+  /// @return The list of block indices.
+  std::vector<Index3D> getNBlocks(const int num_blocks);
+
+  /// @brief Return N bytes of the highest priority blocks for publishing
+  /// @param num_bytes The number of bytes of blocks to stream
+  /// @param layer The layer containing the blocks
+  /// @return The list of block indices.
+  std::vector<Index3D> getNBytesOfBlocks(const size_t num_bytes,
+                                         const LayerType& layer);
+
+  /// @brief Returns highest priority serialized blocks up to N bytes
+  /// @param num_bytes The maximum number of bytes returned
+  /// @param layer layer to serialize
+  /// @param cuda_stream Cuda stream.
+  /// @return Serialized containing highest priority blocks
+  std::shared_ptr<const SerializedLayerType<LayerType>>
+  getNBytesOfSerializedBlocks(const size_t num_bytes, const LayerType& layer,
+                              const CudaStream& cuda_stream);
+
+  /// A parameter getter
+  /// The priority added to blocks in the camera view.
+  /// @returns the in-view weight
+  float in_view_weight() const;
+
+  /// A parameter setter
+  /// See in_view_weight().
+  /// @param in_view_weight The in-view weight.
+  void in_view_weight(float in_view_weight);
+
+  /// A parameter getter
+  /// The priority added each time a block is marked since it was last
+  /// streamed.
+  /// @returns the change weight
+  float change_weight() const;
+
+  /// A parameter setter
+  /// See change_weight().
+  /// @param change_weight The change weight.
+  void change_weight(float change_weight);
+
+  /// A parameter getter
+  /// The priority added for each streaming round a block waits.
+  /// @returns the staleness weight
+  float staleness_weight() const;
+
+  /// A parameter setter
+  /// See staleness_weight().
+  /// @param staleness_weight The staleness weight.
+  void staleness_weight(float staleness_weight);
+
+  /// A parameter getter
+  /// The priority subtracted per meter of distance to the robot.
+  /// @returns the distance weight
+  float distance_weight() const;
+
+  /// A parameter setter
+  /// See distance_weight().
+  /// @param distance_weight The distance weight.
+  void distance_weight(float distance_weight);
+
+  /// A parameter getter
+  /// Blocks further than this from the camera are not considered in view.
+  /// @returns the max view distance in meters
+  float max_view_distance_m() const;
+
+  /// A parameter setter
+  /// See max_view_distance_m().
+  /// @param max_view_distance_m The max view distance in meters.
+  void max_view_distance_m(float max_view_distance_m);
+
+ protected:
+  // Computes the priorities on the GPU.
+  virtual std::vector<float> computePriorities(
+      const std::vector<Index3D>& block_indices) const override;
+
+  // Called after blocks are selected. Resets the change tracking of blocks
+  // which are no longer candidates and starts the next streaming round.
+  void updateChangeTracking();
+
+  // What we track about each candidate.
+  struct BlockChange {
+    // The number of times the block was marked since last streamed.
+    int32_t num_updates = 0;
+    // The streaming round when the block became a candidate.
+    int64_t first_candidate_round = 0;
+  };
+  Index3DHashMapType<BlockChange>::type block_changes_;
+
+  // Counts up with each selection of blocks.
+  int64_t streaming_round_ = 0;
+
+  const float block_size_m_;
+  BlockPriorityView view_;
+  BlockPriorityWeights weights_;
+
+  // computePriorities() is const, but needs scratch space.
+  mutable BlockPriorityCalculatorGpu priority_calculator_;
+};
+
 constexpr float kLayerStreamerUnlimitedBandwidth = -1.0F;
 
 using MeshLayerStreamerOldestBlocks = LayerStreamerOldestBlocks<MeshLayer>;
@@ -274,5 +573,14 @@ using FreespaceLayerStreamerOldestBlocks =
     LayerStreamerOldestBlocks<FreespaceLayer>;
 using ColorLayerStreamerOldestBlocks = LayerStreamerOldestBlocks<ColorLayer>;
 
+using MeshLayerStreamerViewPriority = LayerStreamerViewPriority<MeshLayer>;
+using TsdfLayerStreamerViewPriority = LayerStreamerViewPriority<TsdfLayer>;
+using EsdfLayerStreamerViewPriority = LayerStreamerViewPriority<EsdfLayer>;
+using OccupancyLayerStreamerViewPriority =
+    LayerStreamerViewPriority<OccupancyLayer>;
+using FreespaceLayerStreamerViewPriority =
+    LayerStreamerViewPriority<FreespaceLayer>;
+using ColorLayerStreamerViewPriority = LayerStreamerViewPriority<ColorLayer>;
+
 }  // namespace nvblox
 #include "nvblox/serialization/internal/impl/layer_streamer_impl.h"
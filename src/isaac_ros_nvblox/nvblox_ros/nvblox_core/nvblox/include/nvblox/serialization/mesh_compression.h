@@ -0,0 +1,60 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#pragma once
+
+#include <cstdint>
+
+#include "nvblox/core/types.h"
+
+namespace nvblox {
+namespace mesh_compression {
+
+/// Quantized vertex coordinates span this many block sizes, starting at the
+/// block origin. Marching cubes places a block's vertices between the centers
+/// of its voxels and the voxels of the next block, i.e. at most 8.5 voxels
+/// (1.0625 blocks) from the block origin.
+constexpr float kQuantizedVertexRangeBlocks = 1.125f;
+
+/// Quantize a vertex coordinate to 16 bits.
+/// @param coordinate_m The vertex coordinate relative to the block
+/// origin.
+/// @param block_size_m The block size in meters.
+/// @return The quantized coordinate.
+__host__ __device__ inline uint16_t quantizeVertexCoordinate(
+    const float coordinate_m, const float block_size_m);
+
+/// Recover a vertex coordinate (relative to the block origin) from its
+/// quantized value. See quantizeVertexCoordinate().
+__host__ __device__ inline float dequantizeVertexCoordinate(
+    const uint16_t quantized_coordinate, const float block_size_m);
+
+/// Encode a unit normal in two bytes using the octahedral mapping. The
+/// bytes hold signed 8-bit values.
+/// @param normal The normal to encode. Need not be normalized.
+/// @param encoded_normal Output array of two bytes.
+__host__ __device__ inline void encodeOctahedralNormal(const Vector3f& normal,
+                                                       uint8_t* encoded_normal);
+
+/// Decode a normal encoded with encodeOctahedralNormal().
+/// @param encoded_normal Array of two bytes.
+/// @return The unit normal.
+__host__ __device__ inline Vector3f decodeOctahedralNormal(
+    const uint8_t* encoded_normal);
+
+}  // namespace mesh_compression
+}  // namespace nvblox
+
+#include "nvblox/serialization/internal/impl/mesh_compression_impl.h"
@@ -23,6 +23,7 @@ limitations under the License.
 #include "nvblox/core/unified_vector.h"
 #include "nvblox/map/common_names.h"
 #include "nvblox/map/layer.h"
+#include "nvblox/mesh/mesh_arena.h"
 #include "nvblox/serialization/internal/serialization_gpu.h"
 
 namespace nvblox {
@@ -34,6 +35,13 @@ struct SerializedMeshLayer {
   host_vector<Color> colors;
   host_vector<int> triangle_indices;
 
+  /// Optional compact encoding of the vertices and normals, only filled if
+  /// MeshSerializerGpu::compact_encoding() is set. See mesh_compression.h.
+  /// Vertices are stored as three 16-bit coordinates relative to their block
+  /// origin, normals as two octahedral-encoded bytes.
+  host_vector<uint16_t> quantized_vertices;
+  host_vector<uint8_t> encoded_normals;
+
   /// Offsets for each mesh block in the output vector.
   /// Size of offsets is num_blocks+1. The first element is always
   /// zero and the last element always equals the total size of the serialized
@@ -114,12 +122,76 @@ class MeshSerializerGpu {
       const std::vector<Index3D>& block_indices_to_serialize,
       const CudaStream& cuda_stream);
 
+  /// Serialize blocks stored in a mesh arena.
+  ///
+  /// The output is identical to serializing the same blocks from a mesh layer.
+  /// If all blocks of a compact arena are requested in arena order (see
+  /// MeshArena::getAllBlockIndices() and MeshArena::isCompact()), each output
+  /// vector is produced by a single contiguous copy. Otherwise, the requested
+  /// ranges are gathered on the GPU. Blocks not in the arena are serialized as
+  /// empty.
+  ///
+  /// @param mesh_arena                  Arena to serialize
+  /// @param block_indices_to_serialize  Requested block indices
+  /// @param cuda_stream                 Cuda stream
+  std::shared_ptr<const SerializedMeshLayer> serialize(
+      const MeshArena& mesh_arena,
+      const std::vector<Index3D>& block_indices_to_serialize,
+      const CudaStream& cuda_stream);
+
   /// Get the serialized mesh
   std::shared_ptr<const SerializedMeshLayer> getSerializedLayer() const {
     return serialized_mesh_;
   }
 
+  /// A parameter getter
+  /// Whether the serialized mesh additionally contains the compact
+  /// (quantized) encoding of the vertices and normals.
+  /// @returns whether the compact encoding is produced
+  bool compact_encoding() const { return compact_encoding_; }
+
+  /// A parameter setter
+  /// See compact_encoding().
+  /// @param compact_encoding whether to produce the compact encoding.
+  void compact_encoding(bool compact_encoding) {
+    compact_encoding_ = compact_encoding;
+  }
+
  private:
+  // Encode the vertices and normals of the requested blocks on the GPU.
+  void encodeCompactAsync(const MeshLayer& mesh_layer,
+                          const std::vector<Index3D>& block_indices,
+                          const CudaStream& cuda_stream);
+  void encodeCompactAsync(const MeshArena& mesh_arena,
+                          const std::vector<Index3D>& block_indices,
+                          const CudaStream& cuda_stream);
+
+  // Launch the encoding of the blocks staged in the scratch buffers below.
+  void launchEncodeCompactAsync(int32_t num_blocks, int32_t max_block_size,
+                                float block_size,
+                                const CudaStream& cuda_stream);
+
+  // Gather the arena ranges staged in the scratch buffers below.
+  template <typename T>
+  void gatherArenaRangesAsync(const T* arena_data,
+                              const host_vector<int32_t>& arena_offsets,
+                              const host_vector<int32_t>& output_offsets,
+                              int32_t max_block_size,
+                              host_vector<T>* output,
+                              const CudaStream& cuda_stream);
+
+  bool compact_encoding_ = false;
+
+  // Scratch data for the compact encoding.
+  host_vector<const Vector3f*> vertex_ptrs_;
+  host_vector<const Vector3f*> normal_ptrs_;
+  host_vector<Index3D> block_indices_host_;
+  host_vector<int32_t> compact_vertex_offsets_;
+
+  // Scratch data for serializing from an arena.
+  host_vector<int32_t> arena_vertex_offsets_;
+  host_vector<int32_t> arena_triangle_offsets_;
+
   LayerSerializerGpuInternal<MeshLayer, Vector3f> vertex_serializer_;
   LayerSerializerGpuInternal<MeshLayer, Color> color_serializer_;
   LayerSerializerGpuInternal<MeshLayer, int> triangle_index_serializer_;
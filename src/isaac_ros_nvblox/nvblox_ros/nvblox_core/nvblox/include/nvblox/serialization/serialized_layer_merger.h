@@ -0,0 +1,92 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "nvblox/core/cuda_stream.h"
+#include "nvblox/core/types.h"
+#include "nvblox/core/unified_vector.h"
+#include "nvblox/map/common_names.h"
+#include "nvblox/serialization/layer_serializer_gpu.h"
+
+namespace nvblox {
+
+/// Fuses serialized blocks, e.g. streamed from another robot through a
+/// LayerStreamer, into a local layer on the GPU.
+///
+/// TSDF voxels are fused by weighted averaging of the distances, with the
+/// weights summed up to a maximum weight. Occupancy voxels are fused by
+/// averaging the log-odds, where only one of the voxels was observed its
+/// log-odds are taken. Blocks which don't exist locally are allocated.
+///
+/// NOTE: The merger doesn't know which observations a local voxel already
+/// contains. Merging the same block repeatedly therefore pulls the local voxel
+/// towards the merged one, rather than counting the observations once. With
+/// the maximum weight this converges towards the peer's map for blocks only
+/// observed by the peer.
+class SerializedLayerMerger {
+ public:
+  SerializedLayerMerger(std::shared_ptr<CudaStream> cuda_stream =
+                            std::make_shared<CudaStreamOwning>());
+  virtual ~SerializedLayerMerger() = default;
+
+  /// Merge serialized TSDF blocks into a layer.
+  /// @param serialized_layer The (uncompressed) blocks to merge. Compressed
+  /// layers have to be decompressed with decompressSerializedLayer() first.
+  /// @param layer The layer to merge into.
+  /// @return The indices of the merged blocks.
+  std::vector<Index3D> merge(const SerializedTsdfLayer& serialized_layer,
+                             TsdfLayer* layer);
+
+  /// Merge serialized occupancy blocks into a layer.
+  /// @param serialized_layer The (uncompressed) blocks to merge.
+  /// @param layer The layer to merge into.
+  /// @return The indices of the merged blocks.
+  std::vector<Index3D> merge(const SerializedOccupancyLayer& serialized_layer,
+                             OccupancyLayer* layer);
+
+  /// A parameter getter
+  /// The maximum weight of merged TSDF voxels.
+  /// @returns the maximum weight
+  float max_tsdf_weight() const { return max_tsdf_weight_; }
+
+  /// A parameter setter
+  /// See max_tsdf_weight().
+  /// @param max_tsdf_weight the maximum weight
+  void max_tsdf_weight(float max_tsdf_weight);
+
+ private:
+  template <typename VoxelType>
+  std::vector<Index3D> mergeImpl(
+      const SerializedLayer<VoxelType>& serialized_layer,
+      VoxelBlockLayer<VoxelType>* layer,
+      device_vector<VoxelType>* voxels_device,
+      device_vector<VoxelBlock<VoxelType>*>* block_ptrs_device);
+
+  float max_tsdf_weight_ = 5.0f;
+
+  // Buffers
+  device_vector<TsdfVoxel> tsdf_voxels_device_;
+  device_vector<TsdfBlock*> tsdf_block_ptrs_device_;
+  device_vector<OccupancyVoxel> occupancy_voxels_device_;
+  device_vector<OccupancyBlock*> occupancy_block_ptrs_device_;
+
+  std::shared_ptr<CudaStream> cuda_stream_;
+};
+
+}  // namespace nvblox
@@ -18,6 +18,7 @@ limitations under the License.
 #include <numeric>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include <glog/logging.h>
 
@@ -94,6 +95,10 @@ class Delays {
   /// @return The average delay.
   static double getRollingMeanDelayInSeconds(const std::string& tag);
 
+  /// Gets a list of all delay tags that have been registered.
+  /// @return The list of tags.
+  static std::vector<std::string> getTags();
+
   /// Output interface. Prints a table of the delays of the ticked tags.
   /// @param out The stream to be printed to.
   static void Print(std::ostream& out);
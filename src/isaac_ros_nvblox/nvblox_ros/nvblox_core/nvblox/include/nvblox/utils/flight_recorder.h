@@ -0,0 +1,170 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace nvblox {
+namespace timing {
+
+/// The kinds of events kept by the FlightRecorder.
+enum class FlightRecorderEventType : uint8_t {
+  /// A stopped timer, with its start and duration.
+  kTimer,
+  /// A sampled value, e.g. a queue depth or a number of blocks.
+  kCounter,
+  /// Something that happened at a point in time, e.g. a rehash of the GPU
+  /// hash. Carries a value, e.g. the new capacity.
+  kInstant,
+};
+
+struct FlightRecorderEvent {
+  FlightRecorderEventType type = FlightRecorderEventType::kInstant;
+  /// A small id of the recording thread (not the OS thread id).
+  uint32_t thread_id = 0;
+  /// The Timing handle of the tag for timers, a FlightRecorder name handle
+  /// otherwise.
+  uint32_t name_handle = 0;
+  /// Nanoseconds since the epoch of the system clock (the clock of the
+  /// timers). The start for timers.
+  int64_t timestamp_ns = 0;
+  int64_t duration_ns = 0;
+  double value = 0.0;
+};
+
+/// Keeps the recent per-frame timings, counters (queue depths, block counts)
+/// and events (allocations, rehashes) in a ring buffer, such that a latency
+/// spike, which the aggregate timers average away, can be looked at after
+/// the fact.
+///
+/// Recording is lock-free: each event claims a slot of the ring with an
+/// atomic increment, and slots which are overwritten while being read are
+/// skipped by the reader. Disabled by default, in which case recording costs
+/// a relaxed atomic load (in TimerChrono::Stop() and the other hooks).
+///
+/// The events of the last window_seconds are written as a Chrome trace (the
+/// JSON trace event format, which ui.perfetto.dev and chrome://tracing open),
+/// either explicitly with dumpToFile(), or automatically by frameCompleted()
+/// when a frame's latency exceeds the threshold.
+class FlightRecorder {
+ public:
+  static constexpr size_t kDefaultCapacity = 1 << 16;
+
+  /// Start recording. The ring is allocated on the first call and kept after
+  /// disable(), such that recording threads never see it freed.
+  /// @param capacity The number of events kept, rounded up to a power of 2.
+  /// Only used on the first call.
+  static void enable(size_t capacity = kDefaultCapacity);
+  /// Stop recording. The recorded events are kept.
+  static void disable();
+  static bool isEnabled() { return enabled_.load(std::memory_order_relaxed); }
+
+  /// The events older than this (relative to the newest one) are left out of
+  /// the dumps. Default 10s.
+  static void setWindowSeconds(double window_seconds);
+  /// The frame latency above which frameCompleted() dumps a trace. Zero (the
+  /// default) disables the automatic dumps.
+  static void setLatencyThresholdSeconds(double latency_threshold_seconds);
+  /// The directory of the automatic dumps. Default ".".
+  static void setOutputDirectory(const std::string& output_directory);
+  /// The minimum time between two automatic dumps, such that a burst of slow
+  /// frames results in one trace. Default 10s.
+  static void setMinSecondsBetweenDumps(double min_seconds_between_dumps);
+
+  /// Record a stopped timer. Called by the timers.
+  static void recordTimer(size_t timer_handle, int64_t start_ns,
+                          int64_t duration_ns);
+  /// Record a value, e.g. a queue depth.
+  static void recordCounter(const std::string& name, double value);
+  /// Record an event, e.g. a rehash, with a value (e.g. the new capacity).
+  static void recordInstant(const std::string& name, double value = 0.0);
+
+  /// Record the latency of a frame (e.g. of an output with respect to its
+  /// input) and dump a trace if it exceeds the latency threshold. The dump is
+  /// written on a background thread.
+  /// @param name The name of the frame's output, used in the file name.
+  /// @param latency_seconds The latency of the frame.
+  /// @return True if a dump was started.
+  static bool frameCompleted(const std::string& name, double latency_seconds);
+
+  /// The recorded events of the window, ordered by time stamp.
+  static std::vector<FlightRecorderEvent> getEvents();
+  /// The recorded events of the window as a Chrome trace.
+  static std::string toChromeTrace();
+  /// Write the recorded events of the window as a Chrome trace.
+  /// @return False if the file couldn't be written.
+  static bool dumpToFile(const std::string& file_path);
+  /// The path of the last trace written by dumpToFile() or started by
+  /// frameCompleted(), empty if none.
+  static std::string lastDumpPath();
+  /// Wait for an automatic dump in progress.
+  static void waitForDump();
+
+  /// Remove all recorded events. Must not be called while other threads
+  /// record.
+  static void reset();
+
+ private:
+  struct Slot {
+    // Even and non-zero if the slot holds the event of write position
+    // (sequence / 2 - 1), odd while being written.
+    std::atomic<uint64_t> sequence{0};
+    FlightRecorderEvent event;
+  };
+
+  FlightRecorder() = default;
+  ~FlightRecorder();
+  static FlightRecorder& Instance();
+
+  static void record(FlightRecorderEvent event);
+  static uint32_t getNameHandle(const std::string& name);
+  static uint32_t getThreadId();
+  static int64_t nowNs();
+  std::vector<FlightRecorderEvent> snapshot();
+  std::string toChromeTrace(const std::vector<FlightRecorderEvent>& events);
+
+  // Read without locking by the hooks.
+  inline static std::atomic<bool> enabled_{false};
+
+  // Allocated once, never freed before exit.
+  std::unique_ptr<Slot[]> slots_;
+  std::atomic<Slot*> slots_ptr_{nullptr};
+  size_t capacity_mask_ = 0;
+  std::atomic<uint64_t> write_position_{0};
+
+  // Guards all of the below.
+  std::mutex mutex_;
+  std::vector<std::string> names_;
+  double window_seconds_ = 10.0;
+  double latency_threshold_seconds_ = 0.0;
+  std::string output_directory_ = ".";
+  double min_seconds_between_dumps_ = 10.0;
+  int64_t last_dump_ns_ = 0;
+  std::string last_dump_path_;
+
+  // Guards the thread writing the automatic dumps.
+  std::mutex dump_mutex_;
+  std::thread dump_thread_;
+};
+
+}  // namespace timing
+}  // namespace nvblox
@@ -0,0 +1,160 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#pragma once
+
+#include <cuda_runtime.h>
+
+#include <deque>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "nvblox/core/cuda_stream.h"
+
+namespace nvblox {
+namespace timing {
+
+/// Statistics of the GPU time spent in a stage over a rolling window.
+struct GpuTimingStats {
+  /// The number of samples in the window.
+  int num_samples = 0;
+  float mean_ms = 0.0f;
+  float p50_ms = 0.0f;
+  float p90_ms = 0.0f;
+  float p99_ms = 0.0f;
+  float max_ms = 0.0f;
+};
+
+/// Measures the GPU time of the work issued on a stream between Start() and
+/// Stop().
+///
+/// Unlike TimerChrono, which measures the host wall time, the GpuTimer records
+/// a pair of CUDA events on the stream. Their elapsed time is therefore the
+/// time the GPU spent on the work in between (including any gaps in which the
+/// stream was idle) and is independent of when the host synchronizes. The
+/// events are resolved asynchronously by GpuTiming, typically a few frames
+/// later, so timing never blocks the host.
+///
+/// Timers started while the stream is being captured into a CUDA graph are
+/// ignored, because events recorded during capture become graph nodes.
+class GpuTimer {
+ public:
+  GpuTimer(const std::string& tag, const CudaStream& cuda_stream,
+           bool constructStopped = false);
+  ~GpuTimer();
+
+  GpuTimer(const GpuTimer& other) = delete;
+  GpuTimer& operator=(const GpuTimer& other) = delete;
+
+  void Start();
+  void Stop();
+  bool IsTiming() const;
+
+ private:
+  size_t handle_;
+  const CudaStream& cuda_stream_;
+  cudaEvent_t start_event_ = nullptr;
+};
+
+/// Collects the samples of all GpuTimers.
+///
+/// Stopped timers are queued as pending until their stop event completed.
+/// Pending timers are resolved without blocking whenever a timer stops or the
+/// statistics are queried.
+class GpuTiming {
+ public:
+  /// Resolve the pending timers whose work has completed on the GPU. Never
+  /// blocks.
+  static void ResolvePending();
+
+  /// Block until all pending timers are resolved. Mostly useful for tests.
+  static void ResolveAll();
+
+  /// Statistics of a single tag. Zero samples if the tag is unknown.
+  /// @param tag The name of the timer.
+  /// @return The statistics over the rolling window.
+  static GpuTimingStats GetStats(const std::string& tag);
+
+  /// Statistics of all tags which have at least one sample.
+  /// @return The statistics by tag.
+  static std::map<std::string, GpuTimingStats> GetAllStats();
+
+  /// The number of timers whose events have not been resolved yet.
+  static size_t NumPending();
+
+  /// Output interface. Prints a table of the statistics of all tags.
+  /// @param out The stream to be printed to.
+  static void Print(std::ostream& out);
+  static std::string Print();
+
+  /// Clear the samples of all timers (pending timers are dropped).
+  static void Reset();
+
+  /// Enable or disable GPU timing at runtime. Disabled timers don't record any
+  /// events. Enabled by default.
+  static void SetEnabled(bool enabled);
+  static bool IsEnabled();
+
+  /// The number of samples per tag used to compute the statistics.
+  static constexpr int kWindowSize = 256;
+  /// The maximum number of pending timers. When exceeded (e.g. because
+  /// nothing queries the statistics) the oldest pending timers are dropped.
+  static constexpr size_t kMaxNumPending = 4096;
+
+ private:
+  friend class GpuTimer;
+
+  struct PendingTimer {
+    size_t handle;
+    cudaEvent_t start_event;
+    cudaEvent_t stop_event;
+  };
+
+  /// The most recent samples of a tag.
+  struct SampleWindow {
+    std::vector<float> samples_ms;
+    size_t num_added = 0;
+  };
+
+  static GpuTiming& Instance();
+
+  GpuTiming() = default;
+  ~GpuTiming();
+
+  size_t GetHandle(const std::string& tag);
+  // Take an event from the pool or create one. Caller holds mutex_.
+  cudaEvent_t AcquireEvent();
+  void AddPending(size_t handle, cudaEvent_t start_event,
+                  cudaEvent_t stop_event);
+  // Caller holds mutex_.
+  void ResolvePendingLocked(bool blocking);
+  void AddSample(size_t handle, float sample_ms);
+  static GpuTimingStats ComputeStats(const SampleWindow& window);
+
+  std::mutex mutex_;
+  bool enabled_ = true;
+  std::map<std::string, size_t> tag_map_;
+  std::vector<std::string> tags_;
+  std::vector<SampleWindow> windows_;
+  std::deque<PendingTimer> pending_;
+  // Events with timing enabled, reused across timers.
+  std::vector<cudaEvent_t> event_pool_;
+};
+
+}  // namespace timing
+}  // namespace nvblox
@@ -0,0 +1,161 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace nvblox {
+namespace timing {
+
+/// Labels of a metric sample, e.g. {{"tag", "mapper/integrate_depth"}}.
+using MetricLabels = std::vector<std::pair<std::string, std::string>>;
+
+/// Formats metrics in the OpenMetrics text format (which Prometheus scrapes).
+///
+/// Samples are grouped by metric family, so samples of a family can be added
+/// in any order. Metric names must match [a-zA-Z_:][a-zA-Z0-9_:]*, label
+/// values are escaped.
+class MetricsWriter {
+ public:
+  /// Add a sample of a gauge, i.e. a value which can go up and down.
+  void addGauge(const std::string& name, const std::string& help,
+                const MetricLabels& labels, double value);
+
+  /// Add a sample of a counter, i.e. a monotonically increasing total. The
+  /// sample is named "<name>_total".
+  void addCounter(const std::string& name, const std::string& help,
+                  const MetricLabels& labels, double value);
+
+  /// Add a sample of a histogram.
+  /// @param upper_bounds The (inclusive) upper bounds of the buckets. The last
+  /// one is infinity.
+  /// @param counts The number of observations per bucket (not cumulative).
+  /// @param sum The sum of all observations.
+  void addHistogram(const std::string& name, const std::string& help,
+                    const MetricLabels& labels,
+                    const std::vector<double>& upper_bounds,
+                    const std::vector<uint64_t>& counts, double sum);
+
+  /// The metrics in the OpenMetrics text format, terminated by "# EOF".
+  std::string str() const;
+
+ private:
+  struct Family {
+    std::string type;
+    std::string help;
+    std::vector<std::string> samples;
+  };
+  Family& getFamily(const std::string& name, const std::string& type,
+                    const std::string& help);
+
+  // Sorted by name, such that the output is deterministic.
+  std::map<std::string, Family> families_;
+};
+
+/// A registry of the metrics of nvblox, exported in the OpenMetrics format,
+/// see toOpenMetrics() and MetricsServer.
+///
+/// The timers, GPU timers, rates and delays are always exported. Other
+/// components add metrics either by setting gauges and incrementing counters,
+/// or by registering a collector which is only called when the metrics are
+/// exported, such that metrics which are expensive to compute cost nothing
+/// between scrapes.
+class Metrics {
+ public:
+  /// Called with a writer whenever the metrics are exported. Called on the
+  /// exporting thread, so it must be thread safe.
+  using Collector = std::function<void(MetricsWriter*)>;
+
+  /// Set the value of a gauge.
+  static void setGauge(const std::string& name, const std::string& help,
+                       const MetricLabels& labels, double value);
+
+  /// Add to the value of a counter (which starts at 0).
+  static void addToCounter(const std::string& name, const std::string& help,
+                           const MetricLabels& labels, double increment = 1.0);
+
+  /// Register a collector. Replaces an existing collector with the same key.
+  /// @param key Identifies the collector, see unregisterCollector().
+  static void registerCollector(const std::string& key, Collector collector);
+  /// Unregister a collector, e.g. before the object it captures is destroyed.
+  static void unregisterCollector(const std::string& key);
+
+  /// Write the samples of all timers, GPU timers, rates and delays.
+  static void writeTimingMetrics(MetricsWriter* writer);
+
+  /// All metrics in the OpenMetrics text format.
+  static std::string toOpenMetrics();
+
+  /// Clear all gauges, counters and collectors.
+  static void reset();
+
+ private:
+  struct Value {
+    std::string help;
+    double value;
+  };
+  using ValueMap = std::map<std::pair<std::string, MetricLabels>, Value>;
+
+  static Metrics& getInstance();
+
+  std::mutex mutex_;
+  ValueMap gauges_;
+  ValueMap counters_;
+  std::map<std::string, Collector> collectors_;
+};
+
+/// Serves the metrics over HTTP, such that they can be scraped (e.g. by
+/// Prometheus) without restarting the process. Each GET request of /metrics
+/// is answered with Metrics::toOpenMetrics() on a thread owned by the server,
+/// so the metrics cost nothing unless they're scraped.
+class MetricsServer {
+ public:
+  /// Start serving.
+  /// @param port The TCP port. 0 picks a free port, see port().
+  /// @param bind_address The IPv4 address to listen on.
+  explicit MetricsServer(int port,
+                         const std::string& bind_address = "0.0.0.0");
+  ~MetricsServer();
+
+  MetricsServer(const MetricsServer&) = delete;
+  MetricsServer& operator=(const MetricsServer&) = delete;
+
+  /// Whether the server is listening. False if e.g. the port was taken.
+  bool isRunning() const { return listen_fd_ >= 0; }
+
+  /// The port the server listens on.
+  int port() const { return port_; }
+
+ private:
+  void serve();
+  void handleConnection(int connection_fd);
+
+  int listen_fd_ = -1;
+  int port_ = 0;
+  std::atomic<bool> stop_{false};
+  std::thread thread_;
+};
+
+}  // namespace timing
+}  // namespace nvblox
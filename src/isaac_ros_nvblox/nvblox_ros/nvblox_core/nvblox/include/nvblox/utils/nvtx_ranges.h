@@ -15,7 +15,10 @@ limitations under the License.
 */
 #pragma once
 
+#include <cstdint>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 
 #include <nvtx3/nvToolsExt.h>
 
@@ -24,6 +27,52 @@ limitations under the License.
 namespace nvblox {
 namespace timing {
 
+/// Identifies an input frame, e.g. a depth image, such that the processing of
+/// the frame can be correlated across threads and queues in Nsight Systems.
+struct FrameId {
+  /// Where the frame comes from, e.g. the camera name. Empty if unset.
+  std::string source;
+  /// The number of the frame within its source.
+  uint64_t sequence = 0;
+
+  bool valid() const { return !source.empty(); }
+  /// "source#sequence"
+  std::string toString() const;
+};
+
+/// Hands out consecutive sequence numbers per source. Thread safe.
+class FrameIdGenerator {
+ public:
+  /// @param source The frame source, e.g. the camera name.
+  /// @return The next frame of the source. The first one has sequence 0.
+  FrameId next(const std::string& source);
+
+ private:
+  std::mutex mutex_;
+  std::unordered_map<std::string, uint64_t> next_sequences_;
+};
+
+/// The frame being processed by the calling thread. Invalid if none.
+const FrameId& currentFrameId();
+
+/// Sets the frame processed by the calling thread for the lifetime of the
+/// object, after which the previous frame is restored. The NvtxRanges (and
+/// therefore the timers) started in the meantime are tagged with the frame:
+/// their message gets a " [source#sequence]" suffix and their payload is the
+/// sequence number. Work handed to other threads should carry the frame over
+/// by constructing a ScopedFrameId with currentFrameId() on the new thread.
+class ScopedFrameId {
+ public:
+  explicit ScopedFrameId(const FrameId& frame_id);
+  ~ScopedFrameId();
+
+  ScopedFrameId(const ScopedFrameId& other) = delete;
+  ScopedFrameId& operator=(const ScopedFrameId& other) = delete;
+
+ private:
+  FrameId previous_frame_id_;
+};
+
 /// Instrument our timers with NvtxRanges, which can be visualized in Nsight
 /// Systems to aid with debugging and profiling.
 class NvtxRange {
@@ -46,6 +95,8 @@ class NvtxRange {
   void Init(const std::string& message, const uint32_t color);
 
   std::string tag_;
+  // The tag plus the frame (if any) of the last Start().
+  std::string message_;
   bool started_;
   nvtxEventAttributes_t event_attributes_;
   nvtxRangeId_t id_;
@@ -0,0 +1,45 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+namespace nvblox {
+
+/// A function processing the items [begin, end).
+using ParallelForChunkFunction =
+    std::function<void(const size_t begin, const size_t end)>;
+
+/// The number of threads used for a requested number of threads (see
+/// parallelFor()).
+/// @param num_threads The requested number. All hardware threads if zero or
+/// negative.
+/// @return The number of threads, at least one.
+int resolveNumCpuThreads(const int num_threads);
+
+/// Splits the items [0, num_items) into contiguous chunks, one per thread,
+/// and processes them concurrently. Returns once all chunks are processed.
+/// With a single thread (or item) the items are processed on the calling
+/// thread, without spawning any.
+/// @param num_items The number of items.
+/// @param num_threads The number of threads. All hardware threads if zero or
+/// negative.
+/// @param chunk_function Called once per chunk. Has to be thread-safe.
+void parallelFor(const size_t num_items, const int num_threads,
+                 const ParallelForChunkFunction& chunk_function);
+
+}  // namespace nvblox
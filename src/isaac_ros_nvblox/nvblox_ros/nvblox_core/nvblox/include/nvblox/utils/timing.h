@@ -35,10 +35,15 @@ limitations under the License.
 #pragma once
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <chrono>
+#include <cstdint>
 #include <limits>
 #include <map>
+#include <memory>
 #include <mutex>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -67,14 +72,7 @@ class Accumulator {
         max_(std::numeric_limits<T>::min()) {}
 
   void Add(T sample) {
-    if (window_samples_ < N) {
-      samples_[window_samples_++] = sample;
-      window_sum_ += sample;
-    } else {
-      T& oldest = samples_[window_samples_++ % N];
-      window_sum_ += sample - oldest;
-      oldest = sample;
-    }
+    AddToWindow(sample);
     sum_ += sample;
     ++totalsamples_;
     if (sample > max_) {
@@ -85,6 +83,23 @@ class Accumulator {
     }
   }
 
+  /// Add the samples of another accumulator. The totals, min and max are
+  /// exact. The window samples of the other accumulator are added after the
+  /// ones of this accumulator, so rolling statistics are only approximate if
+  /// both accumulators sampled the same period.
+  void Merge(const Accumulator& other) {
+    const int num_window_samples = other.WindowSamples();
+    const int oldest = (other.window_samples_ > N) ? other.window_samples_ % N
+                                                   : 0;
+    for (int i = 0; i < num_window_samples; ++i) {
+      AddToWindow(other.samples_[(oldest + i) % N]);
+    }
+    sum_ += other.sum_;
+    totalsamples_ += other.totalsamples_;
+    max_ = std::max(max_, other.max_);
+    min_ = std::min(min_, other.min_);
+  }
+
   int TotalSamples() const { return totalsamples_; }
 
   int WindowSamples() const { return std::min(window_samples_, N); }
@@ -115,6 +130,17 @@ class Accumulator {
   }
 
  private:
+  void AddToWindow(T sample) {
+    if (window_samples_ < N) {
+      samples_[window_samples_++] = sample;
+      window_sum_ += sample;
+    } else {
+      T& oldest = samples_[window_samples_++ % N];
+      window_sum_ += sample - oldest;
+      oldest = sample;
+    }
+  }
+
   int window_samples_;
   int totalsamples_;
   Total window_sum_;
@@ -124,11 +150,58 @@ class Accumulator {
   T samples_[N];
 };
 
+/// Counts samples per duration bucket, such that timers can be exported as
+/// histograms (see Metrics). The buckets grow exponentially from 10us.
+class DurationHistogram {
+ public:
+  /// The number of buckets, including the last one which has no upper bound.
+  static constexpr int kNumBuckets = 21;
+
+  /// The (inclusive) upper bound of a bucket: 10us * 2^bucket_idx. Infinite
+  /// for the last bucket.
+  static double UpperBoundSeconds(int bucket_idx);
+
+  void Add(double seconds) {
+    int bucket_idx = 0;
+    double upper_bound = kSmallestUpperBoundSeconds;
+    while (bucket_idx < kNumBuckets - 1 && seconds > upper_bound) {
+      upper_bound *= 2.0;
+      ++bucket_idx;
+    }
+    ++counts_[bucket_idx];
+  }
+
+  void Merge(const DurationHistogram& other) {
+    for (int i = 0; i < kNumBuckets; ++i) {
+      counts_[i] += other.counts_[i];
+    }
+  }
+
+  /// The number of samples in a bucket (not cumulative).
+  uint64_t Count(int bucket_idx) const { return counts_[bucket_idx]; }
+
+ private:
+  static constexpr double kSmallestUpperBoundSeconds = 1e-5;
+  std::array<uint64_t, kNumBuckets> counts_{};
+};
+
 struct TimerMapValue {
   TimerMapValue() {}
 
   /// Create an accumulator with specified window size.
   Accumulator<double, double, 50> acc_;
+  /// All samples, bucketed by duration.
+  DurationHistogram histogram_;
+};
+
+/// A snapshot of the samples of a timer, see Timing::GetAllStatistics().
+struct TimerStatistics {
+  std::string tag;
+  size_t num_samples = 0;
+  double total_seconds = 0.0;
+  double min_seconds = 0.0;
+  double max_seconds = 0.0;
+  DurationHistogram histogram;
 };
 
 /**
@@ -163,6 +236,8 @@ class TimerChrono {
 
   bool timing_;
   size_t handle_;
+  // Set by Timing::SetSubsystemEnabled(). Owned by the Timing singleton.
+  const std::atomic<bool>* enabled_;
 };
 
 class TimerNvtx {
@@ -180,6 +255,12 @@ class TimerNvtx {
   NvtxRange nvtx_range_;
 };
 
+/// Collects the samples of all timers.
+///
+/// Each thread records its samples into its own accumulators and caches the
+/// handles of the tags it used, such that starting and stopping a timer never
+/// waits on other threads. The accumulators of all threads are merged when
+/// queried, e.g. by Print().
 class Timing {
  public:
   typedef std::map<std::string, size_t> map_t;
@@ -204,23 +285,66 @@ class Timing {
   static void Print(std::ostream& out);
   static std::string Print();
   static std::string SecondsToTimeString(double seconds);
+  /// The statistics of all timers with samples, sorted by tag. Merges the
+  /// threads' samples once, so it's cheaper than querying each timer.
+  static std::vector<TimerStatistics> GetAllStatistics();
+  /// Clear the samples of all timers. The tags are kept.
   static void Reset();
   static const map_t& GetTimers() { return Instance().tagMap_; }
 
+  /// Enable or disable the timers of a subsystem at runtime. A subsystem is a
+  /// tag or a tag prefix up to a '/', e.g. "mapper" covers "mapper/*". Applies
+  /// to existing timers and to timers created later. Disabled timers don't
+  /// record any samples (their NVTX ranges are unaffected).
+  /// @param subsystem The tag or tag prefix.
+  /// @param enabled Whether the timers record samples.
+  static void SetSubsystemEnabled(std::string const& subsystem, bool enabled);
+  /// Whether the timer of a tag records samples. See SetSubsystemEnabled().
+  static bool IsEnabled(std::string const& tag);
+
  private:
+  typedef std::vector<TimerMapValue> list_t;
+
+  /// The accumulators of a single thread, indexed by handle.
+  struct ThreadTimers {
+    /// Only contended while merging.
+    std::mutex mutex;
+    list_t timers;
+  };
+
+  /// A handle together with its enabled flag.
+  struct HandleAndFlag {
+    size_t handle;
+    const std::atomic<bool>* enabled;
+  };
+
+  // Look up a tag in the calling thread's cache and only fall back to the
+  // (locked) tag map on a miss.
+  static HandleAndFlag GetCachedHandle(std::string const& tag);
+  static const std::atomic<bool>* GetEnabledFlag(size_t handle);
+  static ThreadTimers& GetThreadTimers();
+
   void AddTime(size_t handle, double seconds);
+  // Merge the accumulators of all threads.
+  TimerMapValue GetMerged(size_t handle);
+  list_t GetAllMerged();
+  bool IsTagEnabled(std::string const& tag) const;
 
   static Timing& Instance();
 
   Timing();
   ~Timing();
 
-  typedef std::vector<TimerMapValue> list_t;
-
-  list_t timers_;
   map_t tagMap_;
   size_t maxTagLength_;
+  // Guards all of the below (and tagMap_).
   std::mutex mutex_;
+  // Per handle. Pointers are stable as the flags are read without locking.
+  std::vector<std::unique_ptr<std::atomic<bool>>> enabled_;
+  std::set<std::string> disabled_subsystems_;
+  // Shared with the owning threads, such that samples of exited threads are
+  // kept.
+  std::vector<std::shared_ptr<ThreadTimers>> thread_timers_;
 };
 
 }  // namespace timing
@@ -0,0 +1,76 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "nvblox/core/cuda_device.h"
+
+#include <cuda_runtime.h>
+
+#include "nvblox/core/internal/error_check.h"
+
+namespace nvblox {
+
+int getNumCudaDevices() {
+  int num_devices = 0;
+  checkCudaErrors(cudaGetDeviceCount(&num_devices));
+  return num_devices;
+}
+
+int getCurrentCudaDevice() {
+  int device = 0;
+  checkCudaErrors(cudaGetDevice(&device));
+  return device;
+}
+
+int getCudaDeviceOfPointer(const void* ptr) {
+  cudaPointerAttributes attributes;
+  checkCudaErrors(cudaPointerGetAttributes(&attributes, ptr));
+  return (attributes.type == cudaMemoryTypeDevice) ? attributes.device : -1;
+}
+
+bool enablePeerAccess(int device, int peer_device) {
+  if (device == peer_device) {
+    return true;
+  }
+  int can_access_peer = 0;
+  checkCudaErrors(
+      cudaDeviceCanAccessPeer(&can_access_peer, device, peer_device));
+  if (!can_access_peer) {
+    return false;
+  }
+  ScopedCudaDevice scoped_device(device);
+  const cudaError_t status = cudaDeviceEnablePeerAccess(peer_device, 0);
+  if (status == cudaErrorPeerAccessAlreadyEnabled) {
+    // Clear the (non-sticky) error.
+    cudaGetLastError();
+    return true;
+  }
+  checkCudaErrors(status);
+  return true;
+}
+
+ScopedCudaDevice::ScopedCudaDevice(int device)
+    : previous_device_(getCurrentCudaDevice()) {
+  if (device != previous_device_) {
+    checkCudaErrors(cudaSetDevice(device));
+  }
+}
+
+ScopedCudaDevice::~ScopedCudaDevice() {
+  if (getCurrentCudaDevice() != previous_device_) {
+    checkCudaErrors(cudaSetDevice(previous_device_));
+  }
+}
+
+}  // namespace nvblox
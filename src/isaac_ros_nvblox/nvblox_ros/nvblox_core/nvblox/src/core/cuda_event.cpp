@@ -0,0 +1,51 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "nvblox/core/cuda_event.h"
+
+#include "nvblox/core/internal/error_check.h"
+#include "nvblox/core/sync_monitor.h"
+
+namespace nvblox {
+
+CudaEvent::CudaEvent() {
+  checkCudaErrors(cudaEventCreateWithFlags(&event_, cudaEventDisableTiming));
+}
+
+CudaEvent::~CudaEvent() { checkCudaErrors(cudaEventDestroy(event_)); }
+
+void CudaEvent::record(const CudaStream& cuda_stream) {
+  checkCudaErrors(cudaEventRecord(event_, cuda_stream));
+}
+
+void CudaEvent::synchronize() const {
+  NVBLOX_SYNC_MONITOR_RECORD(SyncEventType::kSynchronize);
+  checkCudaErrors(cudaEventSynchronize(event_));
+}
+
+bool CudaEvent::isReady() const {
+  const cudaError_t status = cudaEventQuery(event_);
+  if (status == cudaErrorNotReady) {
+    return false;
+  }
+  checkCudaErrors(status);
+  return true;
+}
+
+void CudaEvent::streamWait(const CudaStream& cuda_stream) const {
+  checkCudaErrors(cudaStreamWaitEvent(cuda_stream, event_, 0));
+}
+
+}  // namespace nvblox
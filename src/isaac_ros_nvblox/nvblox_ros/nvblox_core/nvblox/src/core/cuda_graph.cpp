@@ -0,0 +1,53 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "nvblox/core/cuda_graph.h"
+
+#include "nvblox/core/internal/error_check.h"
+
+namespace nvblox {
+
+CudaGraph::~CudaGraph() { reset(); }
+
+void CudaGraph::reset() {
+  if (graph_exec_ != nullptr) {
+    checkCudaErrors(cudaGraphExecDestroy(graph_exec_));
+    graph_exec_ = nullptr;
+  }
+  if (graph_ != nullptr) {
+    checkCudaErrors(cudaGraphDestroy(graph_));
+    graph_ = nullptr;
+  }
+}
+
+void CudaGraph::beginCapture(const CudaStream& cuda_stream) {
+  CHECK(cuda_stream.get() != nullptr)
+      << "The legacy default stream can not be captured.";
+  reset();
+  checkCudaErrors(
+      cudaStreamBeginCapture(cuda_stream, cudaStreamCaptureModeThreadLocal));
+}
+
+void CudaGraph::endCapture(const CudaStream& cuda_stream) {
+  checkCudaErrors(cudaStreamEndCapture(cuda_stream, &graph_));
+  checkCudaErrors(cudaGraphInstantiateWithFlags(&graph_exec_, graph_, 0));
+}
+
+void CudaGraph::launch(const CudaStream& cuda_stream) const {
+  CHECK(isInstantiated()) << "Trying to launch a graph before capturing it.";
+  checkCudaErrors(cudaGraphLaunch(graph_exec_, cuda_stream));
+}
+
+}  // namespace nvblox
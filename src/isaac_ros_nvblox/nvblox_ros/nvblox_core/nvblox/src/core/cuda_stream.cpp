@@ -19,10 +19,12 @@ limitations under the License.
 #include "glog/logging.h"
 
 #include "nvblox/core/internal/error_check.h"
+#include "nvblox/core/sync_monitor.h"
 
 namespace nvblox {
 
 void CudaStreamAsync::synchronize() const {
+  NVBLOX_SYNC_MONITOR_RECORD(SyncEventType::kSynchronize);
   checkCudaErrors(cudaStreamSynchronize(*stream_ptr_));
 }
 
@@ -31,24 +33,44 @@ CudaStreamOwning::~CudaStreamOwning() {
   checkCudaErrors(cudaStreamDestroy(stream_));
 }
 
-CudaStreamOwning::CudaStreamOwning(const unsigned int flags)
+CudaStreamOwning::CudaStreamOwning(const unsigned int flags,
+                                   const CudaStreamPriority priority)
     : CudaStreamAsync(&stream_) {
-  checkCudaErrors(cudaStreamCreateWithFlags(&stream_, flags));
+  if (priority == CudaStreamPriority::kDefault) {
+    checkCudaErrors(cudaStreamCreateWithFlags(&stream_, flags));
+    return;
+  }
+  // NOTE: In CUDA lower numbers mean greater priority.
+  int least_priority, greatest_priority;
+  checkCudaErrors(
+      cudaDeviceGetStreamPriorityRange(&least_priority, &greatest_priority));
+  const int cuda_priority = (priority == CudaStreamPriority::kHigh)
+                                ? greatest_priority
+                                : least_priority;
+  checkCudaErrors(cudaStreamCreateWithPriority(&stream_, flags, cuda_priority));
 }
 
 void DefaultStream::synchronize() const {
+  NVBLOX_SYNC_MONITOR_RECORD(SyncEventType::kSynchronize);
   checkCudaErrors(cudaStreamSynchronize(default_stream_));
 }
 
 std::shared_ptr<CudaStream> CudaStream::createCudaStream(
-    CudaStreamType stream_type) {
+    CudaStreamType stream_type, CudaStreamPriority priority) {
+  const bool is_default_stream =
+      stream_type == CudaStreamType::kLegacyDefault ||
+      stream_type == CudaStreamType::kPerThreadDefault;
+  LOG_IF(WARNING, is_default_stream && priority != CudaStreamPriority::kDefault)
+      << "The default streams have no priority. Ignoring priority "
+      << toString(priority) << " for stream type " << toString(stream_type);
   switch (stream_type) {
     case CudaStreamType::kLegacyDefault:
       return std::make_shared<DefaultStream>(cudaStreamLegacy);
     case CudaStreamType::kBlocking:
-      return std::make_shared<CudaStreamOwning>(cudaStreamDefault);
+      return std::make_shared<CudaStreamOwning>(cudaStreamDefault, priority);
     case CudaStreamType::kNonBlocking:
-      return std::make_shared<CudaStreamOwning>(cudaStreamNonBlocking);
+      return std::make_shared<CudaStreamOwning>(cudaStreamNonBlocking,
+                                                priority);
     case CudaStreamType::kPerThreadDefault:
       return std::make_shared<DefaultStream>(cudaStreamPerThread);
     default:
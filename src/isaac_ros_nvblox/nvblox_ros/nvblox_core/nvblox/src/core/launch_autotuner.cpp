@@ -0,0 +1,263 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "nvblox/core/launch_autotuner.h"
+
+#include <cuda_runtime.h>
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+#include "nvblox/core/cuda_device.h"
+#include "nvblox/core/internal/error_check.h"
+
+namespace nvblox {
+
+std::string getCudaDeviceModel(int device) {
+  cudaDeviceProp properties;
+  checkCudaErrors(cudaGetDeviceProperties(&properties, device));
+  // The model is used as a whitespace separated token in the cache file.
+  std::string name(properties.name);
+  std::replace(name.begin(), name.end(), ' ', '_');
+  std::stringstream model;
+  model << name << "_sm" << properties.major << properties.minor;
+  return model.str();
+}
+
+LaunchAutotuner& LaunchAutotuner::getInstance() {
+  static LaunchAutotuner autotuner;
+  return autotuner;
+}
+
+void LaunchAutotuner::launch(const std::string& kernel_name,
+                             const std::vector<int>& candidates,
+                             int default_candidate,
+                             const LaunchFunction& launch_function,
+                             const CudaStream& cuda_stream) {
+  CHECK(!candidates.empty());
+  bool tune = false;
+  int candidate = default_candidate;
+  Key key;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (tuning_enabled_ || !selected_candidates_.empty()) {
+      key = Key(getCurrentCudaDeviceModel(), kernel_name);
+      const auto selected_it = selected_candidates_.find(key);
+      // Ignore selected candidates which are no longer available, e.g. a
+      // cache from a build with other candidates.
+      if (selected_it != selected_candidates_.end() &&
+          std::find(candidates.begin(), candidates.end(),
+                    selected_it->second) != candidates.end()) {
+        candidate = selected_it->second;
+      } else {
+        tune = tuning_enabled_;
+      }
+    }
+  }
+  if (tune) {
+    launchTuning(key, candidates, launch_function, cuda_stream);
+  } else {
+    launch_function(candidate);
+  }
+}
+
+void LaunchAutotuner::launchTuning(const Key& key,
+                                   const std::vector<int>& candidates,
+                                   const LaunchFunction& launch_function,
+                                   const CudaStream& cuda_stream) {
+  // Pick the candidate with the fewest trials.
+  int candidate_idx = 0;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    TuningState& state = tuning_states_[key];
+    if (state.candidates != candidates) {
+      state.candidates = candidates;
+      state.total_ms.assign(candidates.size(), 0.0f);
+      state.num_trials.assign(candidates.size(), 0);
+    }
+    candidate_idx = std::distance(
+        state.num_trials.begin(),
+        std::min_element(state.num_trials.begin(), state.num_trials.end()));
+  }
+
+  // Time the launch.
+  cudaEvent_t start;
+  cudaEvent_t stop;
+  checkCudaErrors(cudaEventCreate(&start));
+  checkCudaErrors(cudaEventCreate(&stop));
+  checkCudaErrors(cudaEventRecord(start, cuda_stream));
+  launch_function(candidates[candidate_idx]);
+  checkCudaErrors(cudaEventRecord(stop, cuda_stream));
+  checkCudaErrors(cudaEventSynchronize(stop));
+  float elapsed_ms = 0.0f;
+  checkCudaErrors(cudaEventElapsedTime(&elapsed_ms, start, stop));
+  checkCudaErrors(cudaEventDestroy(start));
+  checkCudaErrors(cudaEventDestroy(stop));
+
+  std::string cache_file_path;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto state_it = tuning_states_.find(key);
+    if (state_it == tuning_states_.end() ||
+        state_it->second.candidates != candidates) {
+      // Tuning was restarted (or cleared) in the meantime.
+      return;
+    }
+    TuningState& state = state_it->second;
+    state.total_ms[candidate_idx] += elapsed_ms;
+    ++state.num_trials[candidate_idx];
+    if (*std::min_element(state.num_trials.begin(), state.num_trials.end()) <
+        num_trials_per_candidate_) {
+      return;
+    }
+    // All candidates are timed. Select the fastest on average.
+    int best_idx = 0;
+    for (size_t i = 1; i < candidates.size(); ++i) {
+      if (state.total_ms[i] / state.num_trials[i] <
+          state.total_ms[best_idx] / state.num_trials[best_idx]) {
+        best_idx = i;
+      }
+    }
+    LOG(INFO) << "Launch autotuning selected " << candidates[best_idx]
+              << " for " << key.second << " on " << key.first << " ("
+              << state.total_ms[best_idx] / state.num_trials[best_idx]
+              << " ms)";
+    selected_candidates_[key] = candidates[best_idx];
+    tuning_states_.erase(state_it);
+    cache_file_path = cache_file_path_;
+  }
+  if (!cache_file_path.empty()) {
+    saveCache(cache_file_path);
+  }
+}
+
+bool LaunchAutotuner::tuning_enabled() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return tuning_enabled_;
+}
+
+void LaunchAutotuner::tuning_enabled(bool tuning_enabled) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  tuning_enabled_ = tuning_enabled;
+}
+
+int LaunchAutotuner::num_trials_per_candidate() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return num_trials_per_candidate_;
+}
+
+void LaunchAutotuner::num_trials_per_candidate(int num_trials_per_candidate) {
+  CHECK_GT(num_trials_per_candidate, 0);
+  std::lock_guard<std::mutex> lock(mutex_);
+  num_trials_per_candidate_ = num_trials_per_candidate;
+}
+
+void LaunchAutotuner::setCacheFilePath(const std::string& cache_file_path) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (cache_file_path == cache_file_path_) {
+      return;
+    }
+    cache_file_path_ = cache_file_path;
+  }
+  if (!cache_file_path.empty() && std::ifstream(cache_file_path).good()) {
+    loadCache(cache_file_path);
+  }
+}
+
+bool LaunchAutotuner::loadCache(const std::string& path) {
+  std::ifstream file(path);
+  if (!file) {
+    LOG(WARNING) << "Could not open the launch autotuning cache " << path;
+    return false;
+  }
+  std::map<Key, int> loaded_candidates;
+  std::string line;
+  while (std::getline(file, line)) {
+    if (line.empty()) {
+      continue;
+    }
+    std::istringstream line_stream(line);
+    Key key;
+    int candidate;
+    if (!(line_stream >> key.first >> key.second >> candidate)) {
+      LOG(WARNING) << "Malformed line in the launch autotuning cache " << path
+                   << ": " << line;
+      return false;
+    }
+    loaded_candidates[key] = candidate;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (const auto& [key, candidate] : loaded_candidates) {
+    selected_candidates_[key] = candidate;
+  }
+  LOG(INFO) << "Loaded " << loaded_candidates.size()
+            << " launch configurations from " << path;
+  return true;
+}
+
+bool LaunchAutotuner::saveCache(const std::string& path) const {
+  std::stringstream contents;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& [key, candidate] : selected_candidates_) {
+      contents << key.first << " " << key.second << " " << candidate << "\n";
+    }
+  }
+  std::ofstream file(path);
+  if (!file) {
+    LOG(WARNING) << "Could not write the launch autotuning cache " << path;
+    return false;
+  }
+  file << contents.str();
+  return static_cast<bool>(file);
+}
+
+std::optional<int> LaunchAutotuner::getSelectedCandidate(
+    const std::string& device_model, const std::string& kernel_name) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto it = selected_candidates_.find(Key(device_model, kernel_name));
+  if (it == selected_candidates_.end()) {
+    return std::nullopt;
+  }
+  return it->second;
+}
+
+void LaunchAutotuner::setSelectedCandidate(const std::string& device_model,
+                                           const std::string& kernel_name,
+                                           int candidate) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  selected_candidates_[Key(device_model, kernel_name)] = candidate;
+}
+
+void LaunchAutotuner::clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  selected_candidates_.clear();
+  tuning_states_.clear();
+}
+
+std::string LaunchAutotuner::getCurrentCudaDeviceModel() {
+  const int device = getCurrentCudaDevice();
+  auto it = device_models_.find(device);
+  if (it == device_models_.end()) {
+    it = device_models_.emplace(device, getCudaDeviceModel(device)).first;
+  }
+  return it->second;
+}
+
+}  // namespace nvblox
@@ -0,0 +1,75 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "nvblox/core/memory_pool.h"
+
+#include <cuda_runtime.h>
+
+#include "nvblox/core/cuda_stream.h"
+#include "nvblox/core/internal/error_check.h"
+
+namespace nvblox {
+namespace {
+
+cudaMemPool_t getCurrentDeviceDefaultMemoryPool() {
+  int device;
+  checkCudaErrors(cudaGetDevice(&device));
+  cudaMemPool_t memory_pool;
+  checkCudaErrors(cudaDeviceGetDefaultMemPool(&memory_pool, device));
+  return memory_pool;
+}
+
+uint64_t getMemoryPoolAttribute(cudaMemPool_t memory_pool,
+                                cudaMemPoolAttr attribute) {
+  uint64_t value = 0;
+  checkCudaErrors(cudaMemPoolGetAttribute(memory_pool, attribute, &value));
+  return value;
+}
+
+}  // namespace
+
+void setDeviceMemoryPoolReleaseThreshold(uint64_t release_threshold_bytes) {
+  checkCudaErrors(cudaMemPoolSetAttribute(getCurrentDeviceDefaultMemoryPool(),
+                                          cudaMemPoolAttrReleaseThreshold,
+                                          &release_threshold_bytes));
+}
+
+uint64_t getDeviceMemoryPoolReleaseThreshold() {
+  return getMemoryPoolAttribute(getCurrentDeviceDefaultMemoryPool(),
+                                cudaMemPoolAttrReleaseThreshold);
+}
+
+DeviceMemoryPoolUsage getDeviceMemoryPoolUsage() {
+  const cudaMemPool_t memory_pool = getCurrentDeviceDefaultMemoryPool();
+  DeviceMemoryPoolUsage usage;
+  usage.reserved_bytes =
+      getMemoryPoolAttribute(memory_pool, cudaMemPoolAttrReservedMemCurrent);
+  usage.used_bytes =
+      getMemoryPoolAttribute(memory_pool, cudaMemPoolAttrUsedMemCurrent);
+  return usage;
+}
+
+void reserveDeviceMemoryPool(uint64_t num_bytes) {
+  if (num_bytes == 0) {
+    return;
+  }
+  CudaStreamOwning cuda_stream;
+  void* ptr = nullptr;
+  checkCudaErrors(cudaMallocAsync(&ptr, num_bytes, cuda_stream));
+  checkCudaErrors(cudaFreeAsync(ptr, cuda_stream));
+  cuda_stream.synchronize();
+}
+
+}  // namespace nvblox
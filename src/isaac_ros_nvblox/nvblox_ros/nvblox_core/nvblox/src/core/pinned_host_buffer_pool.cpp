@@ -0,0 +1,91 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "nvblox/core/pinned_host_buffer_pool.h"
+
+#include <algorithm>
+
+namespace nvblox {
+namespace {
+
+// Buffer sizes are rounded up, such that slightly varying sizes (e.g.
+// pointclouds) can recycle the same buffers.
+constexpr size_t kBufferSizeGranularityBytes = 1 << 16;
+
+size_t roundUpBufferSize(size_t num_bytes) {
+  return ((num_bytes + kBufferSizeGranularityBytes - 1) /
+          kBufferSizeGranularityBytes) *
+         kBufferSizeGranularityBytes;
+}
+
+}  // namespace
+
+PinnedHostBufferPool::PinnedHostBufferPool(size_t max_num_idle_buffers)
+    : max_num_idle_buffers_(max_num_idle_buffers) {}
+
+PinnedHostBufferPool::Buffer PinnedHostBufferPool::acquire(size_t num_bytes) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // Recycle the smallest free buffer which is large enough.
+    auto best_it = idle_buffers_.end();
+    for (auto it = idle_buffers_.begin(); it != idle_buffers_.end(); ++it) {
+      if (it->buffer.size_bytes >= num_bytes &&
+          (best_it == idle_buffers_.end() ||
+           it->buffer.size_bytes < best_it->buffer.size_bytes) &&
+          it->released_event->isReady()) {
+        best_it = it;
+      }
+    }
+    if (best_it != idle_buffers_.end()) {
+      Buffer buffer = std::move(best_it->buffer);
+      idle_buffers_.erase(best_it);
+      return buffer;
+    }
+  }
+  Buffer buffer;
+  buffer.size_bytes = roundUpBufferSize(num_bytes);
+  buffer.data = make_unified<uint8_t[]>(buffer.size_bytes, MemoryType::kHost);
+  return buffer;
+}
+
+void PinnedHostBufferPool::releaseAsync(Buffer buffer,
+                                        const CudaStream& cuda_stream) {
+  if (buffer.data == nullptr) {
+    return;
+  }
+  IdleBuffer idle_buffer{std::move(buffer), std::make_unique<CudaEvent>()};
+  idle_buffer.released_event->record(cuda_stream);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  idle_buffers_.push_back(std::move(idle_buffer));
+  // Free the oldest buffers beyond the limit. Only buffers which are no longer
+  // in use are freed, so the pool may temporarily hold more.
+  for (auto it = idle_buffers_.begin();
+       idle_buffers_.size() > max_num_idle_buffers_ &&
+       it != idle_buffers_.end();) {
+    if (it->released_event->isReady()) {
+      it = idle_buffers_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+size_t PinnedHostBufferPool::num_idle_buffers() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return idle_buffers_.size();
+}
+
+}  // namespace nvblox
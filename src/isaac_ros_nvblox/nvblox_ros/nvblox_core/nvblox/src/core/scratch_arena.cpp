@@ -0,0 +1,102 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "nvblox/core/scratch_arena.h"
+
+#include <algorithm>
+
+#include <cuda_runtime.h>
+
+#include "nvblox/core/internal/error_check.h"
+
+namespace nvblox {
+namespace {
+
+size_t roundUpToAlignment(size_t num_bytes) {
+  return ((num_bytes + ScratchArena::kAlignmentBytes - 1) /
+          ScratchArena::kAlignmentBytes) *
+         ScratchArena::kAlignmentBytes;
+}
+
+}  // namespace
+
+ScratchArena::~ScratchArena() {
+  // Chunks may still be in use by work on the stream. cudaFree() waits for
+  // the device, so it is safe here.
+  for (const Chunk& chunk : chunks_) {
+    checkCudaErrors(cudaFree(chunk.data));
+  }
+}
+
+void* ScratchArena::allocateBytesAsync(size_t num_bytes,
+                                       const CudaStream& cuda_stream) {
+  if (num_bytes == 0) {
+    return nullptr;
+  }
+  const size_t aligned_num_bytes = roundUpToAlignment(num_bytes);
+  if (chunks_.empty() || chunk_offset_bytes_ + aligned_num_bytes >
+                             chunks_.back().size_bytes) {
+    // Grow geometrically such that a frame only needs a few extra chunks.
+    addChunkAsync(std::max(aligned_num_bytes, capacity_bytes()), cuda_stream);
+  }
+  void* ptr = chunks_.back().data + chunk_offset_bytes_;
+  chunk_offset_bytes_ += aligned_num_bytes;
+  used_bytes_ += aligned_num_bytes;
+  peak_bytes_ = std::max(peak_bytes_, used_bytes_);
+  return ptr;
+}
+
+void ScratchArena::reset(const CudaStream& cuda_stream) {
+  if (chunks_.size() > 1) {
+    freeChunksAsync(cuda_stream);
+    addChunkAsync(peak_bytes_, cuda_stream);
+  }
+  chunk_offset_bytes_ = 0;
+  used_bytes_ = 0;
+}
+
+void ScratchArena::clearAndDeallocateAsync(const CudaStream& cuda_stream) {
+  freeChunksAsync(cuda_stream);
+  chunk_offset_bytes_ = 0;
+  used_bytes_ = 0;
+  peak_bytes_ = 0;
+}
+
+size_t ScratchArena::capacity_bytes() const {
+  size_t capacity_bytes = 0;
+  for (const Chunk& chunk : chunks_) {
+    capacity_bytes += chunk.size_bytes;
+  }
+  return capacity_bytes;
+}
+
+void ScratchArena::addChunkAsync(size_t size_bytes,
+                                 const CudaStream& cuda_stream) {
+  Chunk chunk;
+  checkCudaErrors(cudaMallocAsync(reinterpret_cast<void**>(&chunk.data),
+                                  size_bytes, cuda_stream));
+  chunk.size_bytes = size_bytes;
+  chunks_.push_back(chunk);
+  chunk_offset_bytes_ = 0;
+}
+
+void ScratchArena::freeChunksAsync(const CudaStream& cuda_stream) {
+  for (const Chunk& chunk : chunks_) {
+    checkCudaErrors(cudaFreeAsync(chunk.data, cuda_stream));
+  }
+  chunks_.clear();
+}
+
+}  // namespace nvblox
@@ -0,0 +1,165 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "nvblox/core/sync_monitor.h"
+
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+#include "nvblox/utils/timing.h"
+
+namespace nvblox {
+namespace {
+
+// The handles of the timers running on this thread, innermost last.
+thread_local std::vector<size_t> timer_handle_stack;
+
+bool isDefaultStream(cudaStream_t stream) {
+  return stream == 0 || stream == cudaStreamLegacy ||
+         stream == cudaStreamPerThread;
+}
+
+bool isPageableHostMemory(const void* ptr) {
+  if (ptr == nullptr) {
+    return false;
+  }
+  cudaPointerAttributes attributes;
+  if (cudaPointerGetAttributes(&attributes, ptr) != cudaSuccess) {
+    // Older runtimes report an error for unregistered memory. Clear it such
+    // that it isn't picked up by the next error check.
+    cudaGetLastError();
+    return true;
+  }
+  return attributes.type == cudaMemoryTypeUnregistered;
+}
+
+}  // namespace
+
+SyncMonitor& SyncMonitor::Instance() {
+  static SyncMonitor instance;
+  return instance;
+}
+
+std::string SyncMonitor::currentTag() {
+  if (timer_handle_stack.empty()) {
+    return "untagged";
+  }
+  return timing::Timing::GetTag(timer_handle_stack.back());
+}
+
+void SyncMonitor::record(SyncEventType event_type) {
+  const std::string tag = currentTag();
+  SyncMonitor& monitor = Instance();
+  LOG_IF(INFO, monitor.log_each_event_.load(std::memory_order_relaxed))
+      << "Sync event " << toString(event_type) << " at " << tag;
+  const int type_idx = static_cast<int>(event_type);
+  std::lock_guard<std::mutex> lock(monitor.mutex_);
+  ++monitor.frame_counts_[type_idx];
+  ++monitor.total_counts_[type_idx];
+  ++monitor.counts_per_tag_[tag][type_idx];
+}
+
+void SyncMonitor::recordCopy(const void* dst, const void* src,
+                             cudaStream_t stream) {
+  if (isDefaultStream(stream)) {
+    record(SyncEventType::kDefaultStreamCopy);
+  }
+  if (isPageableHostMemory(dst) || isPageableHostMemory(src)) {
+    record(SyncEventType::kPageableCopy);
+  }
+}
+
+SyncMonitor::Counts SyncMonitor::endFrame() {
+  Counts frame_counts;
+  {
+    std::lock_guard<std::mutex> lock(Instance().mutex_);
+    frame_counts = Instance().frame_counts_;
+    Instance().frame_counts_ = Counts{};
+  }
+  bool any_events = false;
+  std::stringstream ss;
+  for (int i = 0; i < kNumSyncEventTypes; ++i) {
+    any_events |= frame_counts[i] > 0;
+    ss << " " << toString(static_cast<SyncEventType>(i)) << ": "
+       << frame_counts[i];
+  }
+  LOG_IF(INFO, any_events) << "Sync events this frame:" << ss.str();
+  return frame_counts;
+}
+
+SyncMonitor::Counts SyncMonitor::frameCounts() {
+  std::lock_guard<std::mutex> lock(Instance().mutex_);
+  return Instance().frame_counts_;
+}
+
+SyncMonitor::Counts SyncMonitor::totalCounts() {
+  std::lock_guard<std::mutex> lock(Instance().mutex_);
+  return Instance().total_counts_;
+}
+
+std::map<std::string, SyncMonitor::Counts> SyncMonitor::countsPerTag() {
+  std::lock_guard<std::mutex> lock(Instance().mutex_);
+  return Instance().counts_per_tag_;
+}
+
+void SyncMonitor::setLogEachEvent(bool log_each_event) {
+  Instance().log_each_event_.store(log_each_event, std::memory_order_relaxed);
+}
+
+void SyncMonitor::reset() {
+  std::lock_guard<std::mutex> lock(Instance().mutex_);
+  Instance().frame_counts_ = Counts{};
+  Instance().total_counts_ = Counts{};
+  Instance().counts_per_tag_.clear();
+}
+
+std::string SyncMonitor::Print() {
+  const std::map<std::string, Counts> counts_per_tag = countsPerTag();
+  std::stringstream ss;
+  ss << "SyncMonitor\n-----------\n";
+  ss << std::setw(50) << std::left << "tag";
+  for (int i = 0; i < kNumSyncEventTypes; ++i) {
+    ss << "\t" << toString(static_cast<SyncEventType>(i));
+  }
+  ss << "\n";
+  for (const auto& [tag, counts] : counts_per_tag) {
+    ss << std::setw(50) << std::left << tag;
+    for (const uint64_t count : counts) {
+      ss << "\t" << count;
+    }
+    ss << "\n";
+  }
+  ss << "-----------\n";
+  return ss.str();
+}
+
+void SyncMonitor::pushTimerHandle(size_t timer_handle) {
+  timer_handle_stack.push_back(timer_handle);
+}
+
+void SyncMonitor::popTimerHandle(size_t timer_handle) {
+  // Timers aren't necessarily stopped in the reverse order of starting them,
+  // so remove the innermost entry of this timer.
+  for (auto it = timer_handle_stack.rbegin(); it != timer_handle_stack.rend();
+       ++it) {
+    if (*it == timer_handle) {
+      timer_handle_stack.erase(std::next(it).base());
+      return;
+    }
+  }
+}
+
+}  // namespace nvblox
@@ -0,0 +1,78 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "nvblox/core/unified_memory_hints.h"
+
+#include <cuda_runtime.h>
+
+#include "nvblox/core/internal/error_check.h"
+
+namespace nvblox {
+namespace {
+
+int getCurrentDevice() {
+  int device = 0;
+  checkCudaErrors(cudaGetDevice(&device));
+  return device;
+}
+
+int toCudaDevice(UnifiedMemoryLocation location) {
+  return (location == UnifiedMemoryLocation::kDevice) ? getCurrentDevice()
+                                                      : cudaCpuDeviceId;
+}
+
+}  // namespace
+
+bool unifiedMemoryHintsSupported() {
+  int concurrent_managed_access = 0;
+  checkCudaErrors(cudaDeviceGetAttribute(&concurrent_managed_access,
+                                         cudaDevAttrConcurrentManagedAccess,
+                                         getCurrentDevice()));
+  return concurrent_managed_access != 0;
+}
+
+void prefetchUnifiedMemoryAsync(const void* ptr, size_t num_bytes,
+                                UnifiedMemoryLocation location,
+                                const CudaStream& cuda_stream) {
+  if (ptr == nullptr || num_bytes == 0 || !unifiedMemoryHintsSupported()) {
+    return;
+  }
+  checkCudaErrors(cudaMemPrefetchAsync(ptr, num_bytes, toCudaDevice(location),
+                                       cuda_stream));
+}
+
+void adviseUnifiedMemoryPreferredLocation(const void* ptr, size_t num_bytes,
+                                          UnifiedMemoryLocation location) {
+  if (ptr == nullptr || num_bytes == 0 || !unifiedMemoryHintsSupported()) {
+    return;
+  }
+  checkCudaErrors(cudaMemAdvise(ptr, num_bytes,
+                                cudaMemAdviseSetPreferredLocation,
+                                toCudaDevice(location)));
+}
+
+void adviseUnifiedMemoryReadMostly(const void* ptr, size_t num_bytes,
+                                   bool read_mostly) {
+  if (ptr == nullptr || num_bytes == 0 || !unifiedMemoryHintsSupported()) {
+    return;
+  }
+  // The device argument is ignored for this advice.
+  checkCudaErrors(cudaMemAdvise(
+      ptr, num_bytes,
+      read_mostly ? cudaMemAdviseSetReadMostly : cudaMemAdviseUnsetReadMostly,
+      getCurrentDevice()));
+}
+
+}  // namespace nvblox
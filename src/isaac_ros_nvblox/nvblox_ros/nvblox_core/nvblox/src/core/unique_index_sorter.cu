@@ -0,0 +1,123 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "nvblox/core/internal/unique_index_sorter.h"
+
+#include <algorithm>
+
+#include <cub/device/device_radix_sort.cuh>
+#include <cub/device/device_select.cuh>
+#include <glog/logging.h>
+
+#include "nvblox/core/internal/error_check.h"
+#include "nvblox/core/internal/stream_ordered_allocator.h"
+
+namespace nvblox {
+
+constexpr uint64_t kKeyAxisMask =
+    (uint64_t{1} << UniqueIndexSorter::kKeyBitsPerAxis) - 1;
+
+__device__ inline uint64_t indexToKey(const Index3D& index) {
+  constexpr int kBits = UniqueIndexSorter::kKeyBitsPerAxis;
+  constexpr int kOffset = UniqueIndexSorter::kMaxAbsIndex;
+  const uint64_t x = static_cast<uint64_t>(index.x() + kOffset) & kKeyAxisMask;
+  const uint64_t y = static_cast<uint64_t>(index.y() + kOffset) & kKeyAxisMask;
+  const uint64_t z = static_cast<uint64_t>(index.z() + kOffset) & kKeyAxisMask;
+  return (x << (2 * kBits)) | (y << kBits) | z;
+}
+
+__device__ inline Index3D keyToIndex(const uint64_t key) {
+  constexpr int kBits = UniqueIndexSorter::kKeyBitsPerAxis;
+  constexpr int kOffset = UniqueIndexSorter::kMaxAbsIndex;
+  return Index3D(static_cast<int>((key >> (2 * kBits)) & kKeyAxisMask),
+                 static_cast<int>((key >> kBits) & kKeyAxisMask),
+                 static_cast<int>(key & kKeyAxisMask)) -
+         Index3D::Constant(kOffset);
+}
+
+__global__ void indicesToKeysKernel(const Index3D* indices,
+                                    const int num_indices, uint64_t* keys) {
+  const int i = blockIdx.x * blockDim.x + threadIdx.x;
+  if (i < num_indices) {
+    keys[i] = indexToKey(indices[i]);
+  }
+}
+
+// Number of threads: At least num_keys. Only the first num_keys are decoded.
+__global__ void keysToIndicesKernel(const uint64_t* keys, const int* num_keys,
+                                    Index3D* indices) {
+  const int i = blockIdx.x * blockDim.x + threadIdx.x;
+  if (i < *num_keys) {
+    indices[i] = keyToIndex(keys[i]);
+  }
+}
+
+void UniqueIndexSorter::sortAndTakeUnique(int num_indices,
+                                          device_vector<Index3D>* indices,
+                                          const CudaStream& cuda_stream) {
+  CHECK_NOTNULL(indices);
+  CHECK_LE(static_cast<size_t>(num_indices), indices->size());
+  if (num_indices == 0) {
+    indices->resizeAsync(0, cuda_stream);
+    return;
+  }
+  keys_.resizeAsync(num_indices, cuda_stream);
+  sorted_keys_.resizeAsync(num_indices, cuda_stream);
+
+  constexpr int kNumThreads = 256;
+  const int num_thread_blocks = (num_indices + kNumThreads - 1) / kNumThreads;
+  indicesToKeysKernel<<<num_thread_blocks, kNumThreads, 0, cuda_stream>>>(
+      indices->data(), num_indices, keys_.data());
+  checkCudaErrors(cudaPeekAtLastError());
+
+  // Query the temporary storage of both algorithms and share a single
+  // allocation.
+  constexpr int kBeginBit = 0;
+  constexpr int kEndBit = 3 * kKeyBitsPerAxis;
+  size_t sort_storage_bytes = 0;
+  checkCudaErrors(cub::DeviceRadixSort::SortKeys(
+      nullptr, sort_storage_bytes, keys_.data(), sorted_keys_.data(),
+      num_indices, kBeginBit, kEndBit, cuda_stream));
+  size_t unique_storage_bytes = 0;
+  checkCudaErrors(cub::DeviceSelect::Unique(
+      nullptr, unique_storage_bytes, sorted_keys_.data(), keys_.data(),
+      num_unique_device_.data(), num_indices, cuda_stream));
+  const size_t storage_bytes =
+      std::max(sort_storage_bytes, unique_storage_bytes);
+  StreamOrderedAllocator allocator(cuda_stream);
+  char* storage = allocator.allocate(storage_bytes);
+
+  // Sort, and write the unique keys back into the (unsorted) key buffer.
+  size_t storage_bytes_inout = storage_bytes;
+  checkCudaErrors(cub::DeviceRadixSort::SortKeys(
+      storage, storage_bytes_inout, keys_.data(), sorted_keys_.data(),
+      num_indices, kBeginBit, kEndBit, cuda_stream));
+  storage_bytes_inout = storage_bytes;
+  checkCudaErrors(cub::DeviceSelect::Unique(
+      storage, storage_bytes_inout, sorted_keys_.data(), keys_.data(),
+      num_unique_device_.data(), num_indices, cuda_stream));
+  allocator.deallocate(storage, storage_bytes);
+
+  // Decode without waiting for the number of unique keys.
+  keysToIndicesKernel<<<num_thread_blocks, kNumThreads, 0, cuda_stream>>>(
+      keys_.data(), num_unique_device_.data(), indices->data());
+  checkCudaErrors(cudaPeekAtLastError());
+
+  num_unique_host_.copyFromAsync(num_unique_device_, cuda_stream);
+  cuda_stream.synchronize();
+  indices->resizeAsync(num_unique_host_[0], cuda_stream);
+}
+
+}  // namespace nvblox
@@ -30,4 +30,8 @@ void warmupCuda() {
   checkCudaErrors(cudaDeviceSynchronize());
 }
 
+std::future<void> warmupCudaAsync() {
+  return std::async(std::launch::async, warmupCuda);
+}
+
 }  // namespace nvblox
\ No newline at end of file
@@ -86,6 +86,13 @@ void DynamicsDetection::computeDynamics(const DepthImage& depth_frame_C,
                                         const FreespaceLayer& freespace_layer_L,
                                         const Camera& camera,
                                         const Transform& T_L_C) {
+  computeDynamicsAsync(depth_frame_C, freespace_layer_L, camera, T_L_C);
+  synchronizeOutputs();
+}
+
+void DynamicsDetection::computeDynamicsAsync(
+    const DepthImage& depth_frame_C, const FreespaceLayer& freespace_layer_L,
+    const Camera& camera, const Transform& T_L_C) {
   const int rows = depth_frame_C.rows();
   const int cols = depth_frame_C.cols();
   prepareOutputs(depth_frame_C);
@@ -109,21 +116,40 @@ void DynamicsDetection::computeDynamics(const DepthImage& depth_frame_C,
       rows,                                  // NOLINT
       cols,                                  // NOLINT
       dynamic_points_counter_device_.get(),  // NOLINT
-      dynamic_points_device_.data(),         // NOLINT
+      dynamic_pointcloud_device_.dataPtr(),  // NOLINT
       dynamics_mask_.dataPtr(),              // NOLINT
       dynamics_overlay_.dataPtr());          // NOLINT
+  checkCudaErrors(cudaPeekAtLastError());
   dynamic_points_counter_device_.copyToAsync(dynamic_points_counter_host_,
                                              *cuda_stream_);
-  cuda_stream_->synchronize();
-  dynamic_points_device_.resizeAsync(*dynamic_points_counter_host_,
-                                     *cuda_stream_);
-  cuda_stream_->synchronize();
-  checkCudaErrors(cudaPeekAtLastError());
+  outputs_ready_event_.record(*cuda_stream_);
+  outputs_synchronized_ = false;
+}
+
+void DynamicsDetection::waitForOutputs(const CudaStream& cuda_stream) const {
+  outputs_ready_event_.streamWait(cuda_stream);
+}
+
+void DynamicsDetection::synchronizeOutputs() {
+  if (outputs_synchronized_) {
+    return;
+  }
+  outputs_ready_event_.synchronize();
+  // Shrinking doesn't reallocate, so this doesn't touch the device.
+  dynamic_pointcloud_device_.resizeAsync(*dynamic_points_counter_host_,
+                                         *cuda_stream_);
+  outputs_synchronized_ = true;
+}
+
+bool DynamicsDetection::outputsReady() const {
+  return outputs_ready_event_.isReady();
 }
 
 Eigen::Matrix3Xf DynamicsDetection::getDynamicPointsHost() {
+  synchronizeOutputs();
   // Copy to host.
-  dynamic_points_host_.copyFromAsync(dynamic_points_device_, *cuda_stream_);
+  dynamic_points_host_.copyFromAsync(dynamic_pointcloud_device_.points(),
+                                     *cuda_stream_);
   cuda_stream_->synchronize();
 
   // Convert to eigen.
@@ -132,9 +158,7 @@ Eigen::Matrix3Xf DynamicsDetection::getDynamicPointsHost() {
 }
 
 const Pointcloud& DynamicsDetection::getDynamicPointcloudDevice() {
-  dynamic_pointcloud_device_.copyFromAsync(dynamic_points_device_,
-                                           *cuda_stream_);
-  cuda_stream_->synchronize();
+  synchronizeOutputs();
   return dynamic_pointcloud_device_;
 }
 
@@ -167,9 +191,7 @@ void DynamicsDetection::prepareOutputs(const DepthImage& input_frame) {
   dynamic_points_counter_device_.setZeroAsync(*cuda_stream_);
 
   // Points
-  if (static_cast<size_t>(num_input_pixels) > dynamic_points_device_.size()) {
-    dynamic_points_device_.resizeAsync(num_input_pixels, *cuda_stream_);
-  }
+  dynamic_pointcloud_device_.resizeAsync(num_input_pixels, *cuda_stream_);
 }
 
 }  // namespace nvblox
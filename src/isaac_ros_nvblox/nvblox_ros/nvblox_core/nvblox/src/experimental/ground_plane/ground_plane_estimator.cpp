@@ -26,48 +26,50 @@ GroundPlaneEstimator::GroundPlaneEstimator(
 
 std::optional<Plane> GroundPlaneEstimator::computeGroundPlane(
     const TsdfLayer& tsdf_layer) {
-  if (std::optional<std::vector<Vector3f>> maybe_tsdf_zero_crossings =
-          tsdf_zero_crossings_extractor_.computeZeroCrossingsFromAboveOnGPU(
-              tsdf_layer)) {
-    tsdf_zero_crossings_ = maybe_tsdf_zero_crossings;
-  } else {
-    resetInternal();
-    return std::nullopt;
-  }
+  timing::Timer timer("ground_plane/compute_ground_plane");
+  tsdf_zero_crossings_extractor_.clearZeroCrossingsCache();
+  tsdf_zero_crossings_extractor_.updateZeroCrossingsCacheOnGPU(
+      tsdf_layer, tsdf_layer.getAllBlockIndices());
+  is_cache_initialized_ = true;
+  return fitToCachedCrossings();
+}
 
-  // Filter points outside of the specified range.
-  tsdf_zero_crossings_ground_candidates_ = getPointsWithinMinMaxZCPU(
-      tsdf_zero_crossings_.value(), ground_points_candidates_min_z_m_,
-      ground_points_candidates_max_z_m_);
+std::optional<Plane> GroundPlaneEstimator::computeGroundPlane(
+    const TsdfLayer& tsdf_layer, const std::vector<Index3D>& updated_blocks) {
+  if (!is_cache_initialized_) {
+    return computeGroundPlane(tsdf_layer);
+  }
+  timing::Timer timer("ground_plane/update_ground_plane");
+  tsdf_zero_crossings_extractor_.updateZeroCrossingsCacheOnGPU(tsdf_layer,
+                                                               updated_blocks);
+  return fitToCachedCrossings();
+}
 
-  // Copy to a device pointcloud
-  tsdf_zero_crossings_ground_candidates_point_cloud_.copyFromAsync(
-      tsdf_zero_crossings_ground_candidates_.value(), *cuda_stream_);
-  cuda_stream_->synchronize();
+void GroundPlaneEstimator::resetCache() { is_cache_initialized_ = false; }
 
+std::optional<Plane> GroundPlaneEstimator::fitToCachedCrossings() {
+  if (!tsdf_zero_crossings_extractor_.getCachedZeroCrossingsOnGPU(
+          ground_points_candidates_min_z_m_, ground_points_candidates_max_z_m_,
+          &tsdf_zero_crossings_ground_candidates_)) {
+    resetInternal();
+    return std::nullopt;
+  }
   if (std::optional<Plane> maybe_ground_plane = ransac_plane_fitter_.fit(
-          tsdf_zero_crossings_ground_candidates_point_cloud_)) {
+          tsdf_zero_crossings_ground_candidates_, ground_plane_)) {
     ground_plane_ = maybe_ground_plane;
   } else {
     resetInternal();
-    return std::nullopt;
   }
   return ground_plane_;
 }
 
 void GroundPlaneEstimator::resetInternal() {
-  tsdf_zero_crossings_ = std::nullopt;
-  tsdf_zero_crossings_ground_candidates_ = std::nullopt;
+  tsdf_zero_crossings_ground_candidates_.resizeAsync(0, *cuda_stream_);
   ground_plane_ = std::nullopt;
 }
 
-std::optional<std::vector<Vector3f>> GroundPlaneEstimator::tsdf_zero_crossings()
+const Pointcloud& GroundPlaneEstimator::tsdf_zero_crossings_ground_candidates()
     const {
-  return tsdf_zero_crossings_;
-};
-
-std::optional<std::vector<Vector3f>>
-GroundPlaneEstimator::tsdf_zero_crossings_ground_candidates() const {
   return tsdf_zero_crossings_ground_candidates_;
 }
 
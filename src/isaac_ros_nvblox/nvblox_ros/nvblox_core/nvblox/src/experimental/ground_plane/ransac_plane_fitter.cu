@@ -38,6 +38,8 @@ __global__ void initializeRandomStatesKernel(curandState* random_states,
 __global__ void ransacKernel(const Vector3f* point_cloud, size_t num_points,
                              int num_ransac_iterations,
                              float ransac_distance_threshold_m,
+                             const bool use_initial_plane,
+                             const Plane initial_plane,
                              const curandState* random_states,
                              float* costs_global, Plane* planes_global) {
   assert(num_points > 0);
@@ -47,21 +49,26 @@ __global__ void ransacKernel(const Vector3f* point_cloud, size_t num_points,
     return;
   }
 
-  curandState local_random_state = random_states[idx];
-
-  // Randomly select points
-  const int i1 = curand(&local_random_state) % num_points;
-  const int i2 = curand(&local_random_state) % num_points;
-  const int i3 = curand(&local_random_state) % num_points;
-
-  const Vector3f p1 = point_cloud[i1];
-  const Vector3f p2 = point_cloud[i2];
-  const Vector3f p3 = point_cloud[i3];
   Plane current_plane;
-  const bool plane_from_points_result =
-      Plane::planeFromPoints(p1, p2, p3, &current_plane);
-  if (!plane_from_points_result) {
-    return;
+  if (use_initial_plane && idx == 0) {
+    // Warm start: the first hypothesis is the initial plane.
+    current_plane = initial_plane;
+  } else {
+    curandState local_random_state = random_states[idx];
+
+    // Randomly select points
+    const int i1 = curand(&local_random_state) % num_points;
+    const int i2 = curand(&local_random_state) % num_points;
+    const int i3 = curand(&local_random_state) % num_points;
+
+    const Vector3f p1 = point_cloud[i1];
+    const Vector3f p2 = point_cloud[i2];
+    const Vector3f p3 = point_cloud[i3];
+    const bool plane_from_points_result =
+        Plane::planeFromPoints(p1, p2, p3, &current_plane);
+    if (!plane_from_points_result) {
+      return;
+    }
   }
   // Comput the rescending M-Esimator cost  as described in
   // https://www.robots.ox.ac.uk/~vgg/publications/2000/Torr00/torr00.pdf
@@ -85,7 +92,8 @@ __global__ void ransacKernel(const Vector3f* point_cloud, size_t num_points,
 RansacPlaneFitter::RansacPlaneFitter(std::shared_ptr<CudaStream> cuda_stream)
     : cuda_stream_(cuda_stream) {}
 
-std::optional<Plane> RansacPlaneFitter::fit(const Pointcloud& point_cloud) {
+std::optional<Plane> RansacPlaneFitter::fit(
+    const Pointcloud& point_cloud, const std::optional<Plane>& initial_plane) {
   // We need at least three points to form a plane. Exit early.
   if (point_cloud.size() < 3) {
     return std::nullopt;
@@ -118,7 +126,8 @@ std::optional<Plane> RansacPlaneFitter::fit(const Pointcloud& point_cloud) {
   // Run the kernel.
   ransacKernel<<<thread_blocks, threads_per_block, 0, *cuda_stream_>>>(
       point_cloud.dataConstPtr(), point_cloud.size(), num_ransac_iterations_,
-      ransac_distance_threshold_m_, random_states_device_.data(),
+      ransac_distance_threshold_m_, initial_plane.has_value(),
+      initial_plane.value_or(Plane()), random_states_device_.data(),
       costs_device_.data(), planes_device_.data());
   checkCudaErrors(cudaPeekAtLastError());
 
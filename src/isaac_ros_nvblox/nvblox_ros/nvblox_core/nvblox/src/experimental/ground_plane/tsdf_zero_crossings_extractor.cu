@@ -14,73 +14,155 @@ See the License for the specific language governing permissions and
 limitationj under the License.
 */
 #include <assert.h>
+#include <limits>
 
 #include "nvblox/core/indexing.h"
 #include "nvblox/core/types.h"
 #include "nvblox/experimental/ground_plane/tsdf_zero_crossings_extractor.h"
+#include "nvblox/map/internal/cuda/voxel_block_threads.cuh"
 
 namespace nvblox {
 
 __global__ void computeZeroCrossingsFromAboveKernel(
     const TsdfBlock** tsdf_blocks, const TsdfBlock** tsdf_blocks_above,
     float min_tsdf_weight, const float voxel_size,
-    const Index3D* block_indices_device, int max_crossings,
-    Vector3f* p_L_crossings, int* p_L_crossings_count) {
+    const Index3D* block_indices_device, const float min_z, const float max_z,
+    int max_crossings, Vector3f* p_L_crossings, int* p_L_crossings_count) {
   // Get the voxels for this thread-block, which could go over a VoxelBlock
   // boundary.
   const TsdfBlock* tsdf_block = tsdf_blocks[blockIdx.x];
   const TsdfBlock* tsdf_block_above = tsdf_blocks_above[blockIdx.x];
 
-  const TsdfVoxel* voxel_above = nullptr;
-  const TsdfVoxel* voxel_below = nullptr;
-  if (threadIdx.z < (TsdfBlock::kVoxelsPerSide - 1)) {
-    // We are within one block for both the above and below voxel.
-    voxel_above =
-        &tsdf_block->voxels[threadIdx.x][threadIdx.y][threadIdx.z + 1];
-    voxel_below = &tsdf_block->voxels[threadIdx.x][threadIdx.y][threadIdx.z];
-  }
-  if (threadIdx.z == (TsdfBlock::kVoxelsPerSide - 1)) {
-    // We need to check the boundary to the VoxelBlock above.
-    if (tsdf_block_above == nullptr) {
-      // If the block above is invalid/ No Block was initialized above the
-      // current one, skip.
-      return;
+  forEachVoxelInThread([&](const Index3D& voxel_index_below) {
+    const int x = voxel_index_below.x();
+    const int y = voxel_index_below.y();
+    const int z = voxel_index_below.z();
+    const TsdfVoxel* voxel_above = nullptr;
+    const TsdfVoxel* voxel_below = &tsdf_block->voxels[x][y][z];
+    if (z < (TsdfBlock::kVoxelsPerSide - 1)) {
+      // We are within one block for both the above and below voxel.
+      voxel_above = &tsdf_block->voxels[x][y][z + 1];
+    } else {
+      // We need to check the boundary to the VoxelBlock above.
+      if (tsdf_block_above == nullptr) {
+        // If the block above is invalid/ No Block was initialized above the
+        // current one, skip.
+        return;
+      }
+      voxel_above = &tsdf_block_above->voxels[x][y][0];
     }
-    voxel_above = &tsdf_block_above->voxels[threadIdx.x][threadIdx.y][0];
-    voxel_below = &tsdf_block->voxels[threadIdx.x][threadIdx.y][threadIdx.z];
-  }
 
-  const bool is_valid_weight_above = voxel_above->weight >= min_tsdf_weight;
-  const bool is_valid_weight_below = voxel_below->weight >= min_tsdf_weight;
-  if (is_valid_weight_above && is_valid_weight_below) {
+    const bool is_valid_weight_above = voxel_above->weight >= min_tsdf_weight;
+    const bool is_valid_weight_below = voxel_below->weight >= min_tsdf_weight;
+    if (!is_valid_weight_above || !is_valid_weight_below) {
+      return;
+    }
     // Check for positive to negative zero-crossing.
-    if (is_valid_weight_above && is_valid_weight_below) {
-      // Check for positive to negative zero-crossing.
+    if (voxel_above->distance > 0.0f && voxel_below->distance <= 0.0f) {
+      const float block_size = voxelSizeToBlockSize(voxel_size);
+      const Index3D block_idx = block_indices_device[blockIdx.x];
+      const Vector3f p_L_below = getCenterPositionFromBlockIndexAndVoxelIndex(
+          block_size, block_idx, voxel_index_below);
+
+      const float distance_at_vox_above = voxel_above->distance;
+      const float distance_at_vox_below = voxel_below->distance;
+      const float distance_m =
+          (-distance_at_vox_below * voxel_size) /
+          (distance_at_vox_above - distance_at_vox_below);
+      const auto p_L_crossing =
+          Vector3f(p_L_below.x(), p_L_below.y(), p_L_below.z() + distance_m);
+      // Only keep crossings within the requested height range.
+      if (!(p_L_crossing.z() >= min_z && p_L_crossing.z() <= max_z)) {
+        return;
+      }
+
+      // Atomically get the next available index in the global crossing
+      // array.
+      const int idx = atomicAdd(p_L_crossings_count, 1);
+      // Return as we would access invalid memory.
+      if (idx >= max_crossings) {
+        return;
+      }
+      p_L_crossings[idx] = p_L_crossing;
+    }
+  });
+}
+
+// Finds the topmost crossing from positive to negative of each voxel column of
+// a block. One thread-block per TSDF block, one thread per column. A nullptr
+// block (i.e. a block which was deallocated) has no crossings.
+__global__ void computeColumnZeroCrossingsFromAboveKernel(
+    const TsdfBlock** tsdf_blocks, const TsdfBlock** tsdf_blocks_above,
+    float min_tsdf_weight, const float voxel_size,
+    const Index3D* block_indices_device, const int* cache_slots,
+    Vector3f* cached_crossings, int* num_crossings) {
+  constexpr int kVoxelsPerSide = TsdfBlock::kVoxelsPerSide;
+  const TsdfBlock* tsdf_block = tsdf_blocks[blockIdx.x];
+  const TsdfBlock* tsdf_block_above = tsdf_blocks_above[blockIdx.x];
+
+  Vector3f p_L_crossing =
+      Vector3f::Constant(std::numeric_limits<float>::quiet_NaN());
+  bool found = false;
+  if (tsdf_block != nullptr) {
+    for (int z = kVoxelsPerSide - 1; z >= 0 && !found; z--) {
+      const TsdfVoxel* voxel_below =
+          &tsdf_block->voxels[threadIdx.x][threadIdx.y][z];
+      const TsdfVoxel* voxel_above = nullptr;
+      if (z < kVoxelsPerSide - 1) {
+        voxel_above = &tsdf_block->voxels[threadIdx.x][threadIdx.y][z + 1];
+      } else if (tsdf_block_above != nullptr) {
+        voxel_above = &tsdf_block_above->voxels[threadIdx.x][threadIdx.y][0];
+      } else {
+        continue;
+      }
+      if (voxel_above->weight < min_tsdf_weight ||
+          voxel_below->weight < min_tsdf_weight) {
+        continue;
+      }
       if (voxel_above->distance > 0.0f && voxel_below->distance <= 0.0f) {
         const float block_size = voxelSizeToBlockSize(voxel_size);
-        const Index3D block_idx = block_indices_device[blockIdx.x];
-        const Index3D voxel_index_below(threadIdx.x, threadIdx.y, threadIdx.z);
         const Vector3f p_L_below = getCenterPositionFromBlockIndexAndVoxelIndex(
-            block_size, block_idx, voxel_index_below);
-
+            block_size, block_indices_device[blockIdx.x],
+            Index3D(threadIdx.x, threadIdx.y, z));
         const float distance_at_vox_above = voxel_above->distance;
         const float distance_at_vox_below = voxel_below->distance;
         const float distance_m =
             (-distance_at_vox_below * voxel_size) /
             (distance_at_vox_above - distance_at_vox_below);
-        const auto p_L_crossing =
+        p_L_crossing =
             Vector3f(p_L_below.x(), p_L_below.y(), p_L_below.z() + distance_m);
-
-        // Atomically get the next available index in the global crossing array.
-        const int idx = atomicAdd(p_L_crossings_count, 1);
-        // Return as we would access invalid memory.
-        if (idx >= max_crossings) {
-          return;
-        }
-        p_L_crossings[idx] = p_L_crossing;
+        found = true;
       }
     }
   }
+  const int column_idx = threadIdx.x * kVoxelsPerSide + threadIdx.y;
+  cached_crossings[cache_slots[blockIdx.x] * kVoxelsPerSide * kVoxelsPerSide +
+                   column_idx] = p_L_crossing;
+  const int block_num_crossings = __syncthreads_count(found);
+  if (column_idx == 0) {
+    num_crossings[blockIdx.x] = block_num_crossings;
+  }
+}
+
+// Compacts the cached crossings within the height range into the output.
+__global__ void gatherCachedZeroCrossingsKernel(
+    const Vector3f* cached_crossings, int num_cached_crossings,
+    const float min_z, const float max_z, int max_crossings,
+    Vector3f* p_L_crossings, int* p_L_crossings_count) {
+  const int cache_idx = blockIdx.x * blockDim.x + threadIdx.x;
+  if (cache_idx >= num_cached_crossings) {
+    return;
+  }
+  const Vector3f p_L_crossing = cached_crossings[cache_idx];
+  // NaN crossings fail the comparisons.
+  if (!(p_L_crossing.z() >= min_z && p_L_crossing.z() <= max_z)) {
+    return;
+  }
+  const int idx = atomicAdd(p_L_crossings_count, 1);
+  if (idx >= max_crossings) {
+    return;
+  }
+  p_L_crossings[idx] = p_L_crossing;
 }
 
 TsdfZeroCrossingsExtractor::TsdfZeroCrossingsExtractor(
@@ -91,24 +173,78 @@ std::optional<std::vector<Vector3f>>
 TsdfZeroCrossingsExtractor::computeZeroCrossingsFromAboveOnGPU(
     const TsdfLayer& tsdf_layer) {
   timing::Timer timer("ground_plane/compute_zero_crossings_from_above_on_gpu");
+  if (tsdf_layer.numAllocatedBlocks() == 0) {
+    return std::nullopt;
+  }
   resetAndAllocateCrossingBuffers();
+  if (static_cast<size_t>(max_crossings_) >=
+      p_L_crossings_global_device_.size()) {
+    p_L_crossings_global_device_.resizeAsync(max_crossings_, *cuda_stream_);
+  }
+  constexpr float kMaxValue = std::numeric_limits<float>::max();
+  const int num_crossings = computeZeroCrossingsOfBlocksOnGPU(
+      tsdf_layer, tsdf_layer.getAllBlockIndices(), -kMaxValue, kMaxValue,
+      p_L_crossings_global_device_.data());
+  if (num_crossings < 0) {
+    return std::nullopt;
+  }
+  p_L_crossings_global_device_.resizeAsync(num_crossings, *cuda_stream_);
+  timer.Stop();
+  return p_L_crossings_global_device_.toVectorAsync(*cuda_stream_);
+}
 
-  const auto block_ptrs_host = tsdf_layer.getAllBlockPointers();
-  block_ptrs_device_.copyFromAsync(block_ptrs_host, *cuda_stream_);
+bool TsdfZeroCrossingsExtractor::computeZeroCrossingsFromAboveOnGPU(
+    const TsdfLayer& tsdf_layer, const std::vector<Index3D>& block_indices,
+    const float min_z, const float max_z, Pointcloud* p_L_crossings) {
+  CHECK_NOTNULL(p_L_crossings);
+  timing::Timer timer(
+      "ground_plane/compute_zero_crossings_from_above_in_range_on_gpu");
+  resetAndAllocateCrossingBuffers();
 
-  const auto block_indices_host = tsdf_layer.getAllBlockIndices();
-  block_indices_device_.copyFromAsync(block_indices_host, *cuda_stream_);
+  // Skip the blocks which can't contain crossings in the height range. The
+  // crossings of a block lie between its lowest voxel center and the lowest
+  // voxel center of the block above.
+  const float block_size = voxelSizeToBlockSize(tsdf_layer.voxel_size());
+  std::vector<Index3D> block_indices_in_range;
+  block_indices_in_range.reserve(block_indices.size());
+  for (const Index3D& block_index : block_indices) {
+    const float block_min_z = block_index.z() * block_size;
+    const float block_max_z =
+        block_min_z + block_size + tsdf_layer.voxel_size();
+    if (block_min_z <= max_z && block_max_z >= min_z) {
+      block_indices_in_range.push_back(block_index);
+    }
+  }
 
-  constexpr int kVoxelsPerSide = TsdfBlock::kVoxelsPerSide;
-  const dim3 threads_per_block(kVoxelsPerSide, kVoxelsPerSide, kVoxelsPerSide);
-  const int num_blocks = tsdf_layer.numAllocatedBlocks();
+  // The crossings are written directly into the output pointcloud.
+  p_L_crossings->resizeAsync(max_crossings_, *cuda_stream_);
+  const int num_crossings = computeZeroCrossingsOfBlocksOnGPU(
+      tsdf_layer, block_indices_in_range, min_z, max_z,
+      p_L_crossings->dataPtr());
+  if (num_crossings < 0) {
+    p_L_crossings->resizeAsync(0, *cuda_stream_);
+    return false;
+  }
+  p_L_crossings->resizeAsync(num_crossings, *cuda_stream_);
+  timer.Stop();
+  return true;
+}
+
+int TsdfZeroCrossingsExtractor::computeZeroCrossingsOfBlocksOnGPU(
+    const TsdfLayer& tsdf_layer, const std::vector<Index3D>& block_indices,
+    const float min_z, const float max_z, Vector3f* p_L_crossings) {
+  const int num_blocks = block_indices.size();
   if (num_blocks == 0) {
-    return std::nullopt;
+    return 0;
   }
 
-  // Collect the respective blocks above
+  // Collect the blocks and the respective blocks above
+  std::vector<const TsdfBlock*> block_ptrs_host;
   std::vector<const TsdfBlock*> block_above_ptrs_host;
-  for (const Index3D& idx : block_indices_host) {
+  block_ptrs_host.reserve(num_blocks);
+  block_above_ptrs_host.reserve(num_blocks);
+  for (const Index3D& idx : block_indices) {
+    block_ptrs_host.push_back(tsdf_layer.getBlockAtIndex(idx).get());
     const auto block_above_ptr_host =
         tsdf_layer.getBlockAtIndex(idx + Index3D(0, 0, 1));
     if (block_above_ptr_host) {
@@ -117,21 +253,22 @@ TsdfZeroCrossingsExtractor::computeZeroCrossingsFromAboveOnGPU(
       block_above_ptrs_host.push_back(nullptr);
     }
   }
+  CHECK(std::find(block_ptrs_host.begin(), block_ptrs_host.end(), nullptr) ==
+        block_ptrs_host.end())
+      << "Requested zero crossings of a block which is not allocated.";
+  block_ptrs_device_.copyFromAsync(block_ptrs_host, *cuda_stream_);
   block_ptrs_above_device_.copyFromAsync(block_above_ptrs_host, *cuda_stream_);
+  block_indices_device_.copyFromAsync(block_indices, *cuda_stream_);
 
+  const dim3 threads_per_block = voxelBlockThreadsPerBlock();
   computeZeroCrossingsFromAboveKernel<<<num_blocks, threads_per_block, 0,
                                         *cuda_stream_>>>(
       block_ptrs_device_.data(), block_ptrs_above_device_.data(),
       min_tsdf_weight_, tsdf_layer.voxel_size(), block_indices_device_.data(),
-      max_crossings_, p_L_crossings_global_device_.data(),
+      min_z, max_z, max_crossings_, p_L_crossings,
       p_L_crossings_count_device_.get());
   p_L_crossings_count_device_.copyToAsync(p_L_crossings_count_host_,
                                           *cuda_stream_);
-
-  cuda_stream_->synchronize();
-  p_L_crossings_global_device_.resizeAsync(*p_L_crossings_count_host_,
-                                           *cuda_stream_);
-
   cuda_stream_->synchronize();
   checkCudaErrors(cudaPeekAtLastError());
 
@@ -139,10 +276,135 @@ TsdfZeroCrossingsExtractor::computeZeroCrossingsFromAboveOnGPU(
   // reach the max capacity. Let the caller decide what to do in this case.
   if (*p_L_crossings_count_host_ >= max_crossings_) {
     LOG(WARNING) << "Maximum number of crossings reached.";
-    return std::nullopt;
+    return -1;
+  }
+  return *p_L_crossings_count_host_;
+}
+
+void TsdfZeroCrossingsExtractor::updateZeroCrossingsCacheOnGPU(
+    const TsdfLayer& tsdf_layer, const std::vector<Index3D>& updated_blocks) {
+  timing::Timer timer("ground_plane/update_zero_crossings_cache_on_gpu");
+  constexpr int kVoxelsPerSide = TsdfBlock::kVoxelsPerSide;
+  constexpr int kColumnsPerBlock = kVoxelsPerSide * kVoxelsPerSide;
+
+  // The crossings at the top of a block depend on the block above.
+  Index3DSet blocks_to_update;
+  for (const Index3D& block_index : updated_blocks) {
+    blocks_to_update.insert(block_index);
+    blocks_to_update.insert(block_index - Index3D(0, 0, 1));
+  }
+  // Not all deallocations are reported as updates (e.g. from decay), so we
+  // also check the cached blocks.
+  for (const auto& [block_index, slot] : cache_slot_of_block_) {
+    if (!tsdf_layer.isBlockAllocated(block_index)) {
+      blocks_to_update.insert(block_index);
+    }
+  }
+
+  // Assign a cache slot to each block. Blocks which were deallocated keep
+  // their slot such that it gets cleared by the kernel.
+  std::vector<const TsdfBlock*> block_ptrs_host;
+  std::vector<const TsdfBlock*> block_above_ptrs_host;
+  std::vector<Index3D> block_indices_host;
+  std::vector<int> cache_slots_host;
+  for (const Index3D& block_index : blocks_to_update) {
+    const auto block_ptr = tsdf_layer.getBlockAtIndex(block_index);
+    auto slot_it = cache_slot_of_block_.find(block_index);
+    if (!block_ptr && slot_it == cache_slot_of_block_.end()) {
+      continue;
+    }
+    if (slot_it == cache_slot_of_block_.end()) {
+      int slot = num_cache_slots_;
+      if (free_cache_slots_.empty()) {
+        ++num_cache_slots_;
+      } else {
+        slot = free_cache_slots_.back();
+        free_cache_slots_.pop_back();
+      }
+      slot_it = cache_slot_of_block_.emplace(block_index, slot).first;
+    }
+    const auto block_above_ptr =
+        tsdf_layer.getBlockAtIndex(block_index + Index3D(0, 0, 1));
+    block_ptrs_host.push_back(block_ptr.get());
+    block_above_ptrs_host.push_back(block_above_ptr.get());
+    block_indices_host.push_back(block_index);
+    cache_slots_host.push_back(slot_it->second);
+  }
+  const int num_blocks = block_indices_host.size();
+  if (num_blocks == 0) {
+    return;
+  }
+
+  // Growing the cache keeps the cached crossings.
+  cached_crossings_device_.resizeAsync(num_cache_slots_ * kColumnsPerBlock,
+                                       *cuda_stream_);
+  block_ptrs_device_.copyFromAsync(block_ptrs_host, *cuda_stream_);
+  block_ptrs_above_device_.copyFromAsync(block_above_ptrs_host, *cuda_stream_);
+  block_indices_device_.copyFromAsync(block_indices_host, *cuda_stream_);
+  cache_slots_device_.copyFromAsync(cache_slots_host, *cuda_stream_);
+  cache_num_crossings_device_.resizeAsync(num_blocks, *cuda_stream_);
+
+  const dim3 threads_per_block(kVoxelsPerSide, kVoxelsPerSide);
+  computeColumnZeroCrossingsFromAboveKernel<<<num_blocks, threads_per_block, 0,
+                                              *cuda_stream_>>>(
+      block_ptrs_device_.data(), block_ptrs_above_device_.data(),
+      min_tsdf_weight_, tsdf_layer.voxel_size(), block_indices_device_.data(),
+      cache_slots_device_.data(), cached_crossings_device_.data(),
+      cache_num_crossings_device_.data());
+  checkCudaErrors(cudaPeekAtLastError());
+  cache_num_crossings_host_.copyFromAsync(cache_num_crossings_device_,
+                                          *cuda_stream_);
+  cuda_stream_->synchronize();
+
+  // Release the slots of the blocks without crossings. Their columns were
+  // set to NaN by the kernel.
+  for (int i = 0; i < num_blocks; i++) {
+    if (cache_num_crossings_host_[i] == 0) {
+      cache_slot_of_block_.erase(block_indices_host[i]);
+      free_cache_slots_.push_back(cache_slots_host[i]);
+    }
   }
-  timer.Stop();
-  return p_L_crossings_global_device_.toVectorAsync(*cuda_stream_);
+}
+
+bool TsdfZeroCrossingsExtractor::getCachedZeroCrossingsOnGPU(
+    const float min_z, const float max_z, Pointcloud* p_L_crossings) {
+  CHECK_NOTNULL(p_L_crossings);
+  timing::Timer timer("ground_plane/get_cached_zero_crossings_on_gpu");
+  const int num_cached_crossings = cached_crossings_device_.size();
+  if (num_cached_crossings == 0) {
+    p_L_crossings->resizeAsync(0, *cuda_stream_);
+    return true;
+  }
+  resetAndAllocateCrossingBuffers();
+  p_L_crossings->resizeAsync(max_crossings_, *cuda_stream_);
+
+  constexpr int kNumThreads = 512;
+  const int num_thread_blocks =
+      (num_cached_crossings + kNumThreads - 1) / kNumThreads;
+  gatherCachedZeroCrossingsKernel<<<num_thread_blocks, kNumThreads, 0,
+                                    *cuda_stream_>>>(
+      cached_crossings_device_.data(), num_cached_crossings, min_z, max_z,
+      max_crossings_, p_L_crossings->dataPtr(),
+      p_L_crossings_count_device_.get());
+  checkCudaErrors(cudaPeekAtLastError());
+  p_L_crossings_count_device_.copyToAsync(p_L_crossings_count_host_,
+                                          *cuda_stream_);
+  cuda_stream_->synchronize();
+
+  if (*p_L_crossings_count_host_ >= max_crossings_) {
+    LOG(WARNING) << "Maximum number of crossings reached.";
+    p_L_crossings->resizeAsync(0, *cuda_stream_);
+    return false;
+  }
+  p_L_crossings->resizeAsync(*p_L_crossings_count_host_, *cuda_stream_);
+  return true;
+}
+
+void TsdfZeroCrossingsExtractor::clearZeroCrossingsCache() {
+  cached_crossings_device_.clearNoDeallocate();
+  cache_slot_of_block_.clear();
+  free_cache_slots_.clear();
+  num_cache_slots_ = 0;
 }
 
 void TsdfZeroCrossingsExtractor::resetAndAllocateCrossingBuffers() {
@@ -152,11 +414,6 @@ void TsdfZeroCrossingsExtractor::resetAndAllocateCrossingBuffers() {
     p_L_crossings_count_host_ = make_unified<int>(MemoryType::kHost);
   }
   p_L_crossings_count_device_.setZeroAsync(*cuda_stream_);
-
-  if (static_cast<size_t>(max_crossings_) >=
-      p_L_crossings_global_device_.size()) {
-    p_L_crossings_global_device_.resizeAsync(max_crossings_, *cuda_stream_);
-  }
 }
 
 void TsdfZeroCrossingsExtractor::max_crossings(int max_crossings) {
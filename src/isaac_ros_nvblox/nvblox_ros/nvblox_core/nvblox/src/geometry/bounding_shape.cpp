@@ -63,4 +63,21 @@ bool BoundingShape::touchesBlock(const Index3D& block_index,
   }
 }
 
+AxisAlignedBoundingBox BoundingShape::boundingBox() const {
+  switch (type_) {
+    case ShapeType::kSphere: {
+      const Vector3f radius = Vector3f::Constant(union_.sphere_.radius());
+      return AxisAlignedBoundingBox(union_.sphere_.center() - radius,
+                                    union_.sphere_.center() + radius);
+    }
+    case ShapeType::kAABB: {
+      return union_.aabb_;
+    }
+    default: {
+      LOG(FATAL) << "ShapeType not implemented: " << type_;
+      return AxisAlignedBoundingBox();
+    }
+  }
+}
+
 }  // namespace nvblox
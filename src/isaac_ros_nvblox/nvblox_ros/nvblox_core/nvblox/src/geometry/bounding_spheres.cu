@@ -0,0 +1,64 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "nvblox/geometry/bounding_spheres.h"
+
+#include "nvblox/core/internal/error_check.h"
+
+namespace nvblox {
+
+// Matches isBlockOutsideRadius(): a block is outside if the distance from the
+// center to its bounding box exceeds the radius.
+__global__ void flagBlocksOutsideRadiusKernel(int num_blocks,
+                                              const Index3D* blocks,
+                                              float block_size, Vector3f center,
+                                              float radius,
+                                              bool* is_outside_radius) {
+  const int idx = threadIdx.x + blockIdx.x * blockDim.x;
+  if (idx >= num_blocks) {
+    return;
+  }
+  float squared_distance = 0.0f;
+  for (int i = 0; i < 3; i++) {
+    const float box_min = static_cast<float>(blocks[idx][i]) * block_size;
+    const float box_max = box_min + block_size;
+    if (center[i] < box_min) {
+      squared_distance += (box_min - center[i]) * (box_min - center[i]);
+    } else if (center[i] > box_max) {
+      squared_distance += (center[i] - box_max) * (center[i] - box_max);
+    }
+  }
+  is_outside_radius[idx] = sqrtf(squared_distance) > radius;
+}
+
+void flagBlocksOutsideRadiusOnGpuAsync(const device_vector<Index3D>& blocks,
+                                       float block_size, const Vector3f& center,
+                                       float radius,
+                                       device_vector<bool>* is_outside_radius,
+                                       const CudaStream& cuda_stream) {
+  CHECK_NOTNULL(is_outside_radius);
+  is_outside_radius->resizeAsync(blocks.size(), cuda_stream);
+  if (blocks.empty()) {
+    return;
+  }
+  constexpr int kNumThreads = 512;
+  const int num_blocks = blocks.size() / kNumThreads + 1;
+  flagBlocksOutsideRadiusKernel<<<num_blocks, kNumThreads, 0, cuda_stream>>>(
+      blocks.size(), blocks.data(), block_size, center, radius,
+      is_outside_radius->data());
+  checkCudaErrors(cudaPeekAtLastError());
+}
+
+}  // namespace nvblox
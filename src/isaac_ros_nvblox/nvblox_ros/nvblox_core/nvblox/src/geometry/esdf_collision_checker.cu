@@ -0,0 +1,113 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "nvblox/geometry/esdf_collision_checker.h"
+
+#include "nvblox/core/internal/error_check.h"
+#include "nvblox/gpu_hash/internal/cuda/gpu_indexing.cuh"
+#include "nvblox/utils/timing.h"
+
+namespace nvblox {
+
+// Returns the signed distance (in meters) at a point, from the closest voxel.
+__device__ inline float getEsdfDistance(
+    const Index3DDeviceHashMapType<EsdfBlock>& block_hash, const Vector3f& p_L,
+    float block_size, float voxel_size, float unobserved_distance_m) {
+  EsdfVoxel* voxel_ptr;
+  if (!getVoxelAtPosition<EsdfVoxel>(block_hash, p_L, block_size,
+                                     &voxel_ptr) ||
+      !voxel_ptr->observed) {
+    return unobserved_distance_m;
+  }
+  const float distance_m = voxel_size * sqrtf(voxel_ptr->squared_distance_vox);
+  return voxel_ptr->is_inside ? -distance_m : distance_m;
+}
+
+// Number of threads needed: one per capsule
+__global__ void computeClearancesKernel(
+    int num_capsules, const CollisionCapsule* capsules,
+    Index3DDeviceHashMapType<EsdfBlock> block_hash, float block_size,
+    float voxel_size, float unobserved_distance_m, float* clearances_m) {
+  const int idx = threadIdx.x + blockIdx.x * blockDim.x;
+  if (idx >= num_capsules) {
+    return;
+  }
+  const CollisionCapsule capsule = capsules[idx];
+
+  // Sample the axis of the capsule at (at most) voxel spacing.
+  const Vector3f axis = capsule.end - capsule.start;
+  const int num_steps = static_cast<int>(ceilf(axis.norm() / voxel_size));
+  const float step_size = 1.0f / static_cast<float>(max(num_steps, 1));
+  float min_distance_m = getEsdfDistance(block_hash, capsule.start, block_size,
+                                         voxel_size, unobserved_distance_m);
+  for (int i = 1; i <= num_steps; i++) {
+    const Vector3f p_L = capsule.start + (i * step_size) * axis;
+    min_distance_m =
+        fminf(min_distance_m, getEsdfDistance(block_hash, p_L, block_size,
+                                              voxel_size, unobserved_distance_m));
+  }
+  clearances_m[idx] = min_distance_m - capsule.radius;
+}
+
+EsdfCollisionChecker::EsdfCollisionChecker()
+    : EsdfCollisionChecker(std::make_shared<CudaStreamOwning>()) {}
+
+EsdfCollisionChecker::EsdfCollisionChecker(
+    std::shared_ptr<CudaStream> cuda_stream)
+    : cuda_stream_(cuda_stream) {}
+
+void EsdfCollisionChecker::computeClearances(
+    const std::vector<CollisionCapsule>& capsules, const EsdfLayer& esdf_layer,
+    std::vector<float>* clearances_m_ptr) {
+  CHECK_NOTNULL(clearances_m_ptr);
+  capsules_device_.copyFromAsync(capsules, *cuda_stream_);
+  computeClearancesAsync(capsules_device_, esdf_layer, &clearances_device_);
+  *clearances_m_ptr = clearances_device_.toVectorAsync(*cuda_stream_);
+  cuda_stream_->synchronize();
+}
+
+void EsdfCollisionChecker::computeClearancesAsync(
+    const device_vector<CollisionCapsule>& capsules,
+    const EsdfLayer& esdf_layer, device_vector<float>* clearances_m_ptr) {
+  CHECK_NOTNULL(clearances_m_ptr);
+  CHECK(esdf_layer.memory_type() != MemoryType::kHost)
+      << "Collision checking requires a GPU accessible ESDF layer.";
+  timing::Timer timer("collision_checker/compute_clearances");
+
+  const int num_capsules = capsules.size();
+  clearances_m_ptr->resizeAsync(num_capsules, *cuda_stream_);
+  if (num_capsules == 0) {
+    return;
+  }
+
+  constexpr int kNumThreads = 512;
+  const int num_blocks = num_capsules / kNumThreads + 1;
+  computeClearancesKernel<<<num_blocks, kNumThreads, 0, *cuda_stream_>>>(
+      num_capsules, capsules.data(),
+      esdf_layer.getGpuLayerView(*cuda_stream_).getHash().impl_,
+      esdf_layer.block_size(), esdf_layer.voxel_size(), unobserved_distance_m_,
+      clearances_m_ptr->data());
+  checkCudaErrors(cudaPeekAtLastError());
+}
+
+float EsdfCollisionChecker::unobserved_distance_m() const {
+  return unobserved_distance_m_;
+}
+
+void EsdfCollisionChecker::unobserved_distance_m(float unobserved_distance_m) {
+  unobserved_distance_m_ = unobserved_distance_m;
+}
+
+}  // namespace nvblox
@@ -15,6 +15,8 @@ limitations under the License.
 */
 #include "nvblox/geometry/workspace_bounds.h"
 
+#include "nvblox/core/indexing.h"
+
 namespace nvblox {
 
 bool applyWorkspaceBounds(const AxisAlignedBoundingBox& input_aabb,
@@ -60,4 +62,27 @@ bool applyWorkspaceBounds(const AxisAlignedBoundingBox& input_aabb,
   return !output_aabb->isEmpty();
 }
 
+std::optional<size_t> getMaxNumBlocksInWorkspace(
+    const WorkspaceBoundsType bounds_type,
+    const Vector3f& workspace_bounds_min_corner,
+    const Vector3f& workspace_bounds_max_corner, const float block_size) {
+  if (bounds_type != WorkspaceBoundsType::kBoundingBox) {
+    return std::nullopt;
+  }
+  if ((workspace_bounds_max_corner.array() <
+       workspace_bounds_min_corner.array())
+          .any()) {
+    return 0;
+  }
+  // Same blocks as getBlockIndicesTouchedByBoundingBox().
+  const Index3D num_blocks =
+      getBlockIndexFromPositionInLayer(block_size,
+                                       workspace_bounds_max_corner) -
+      getBlockIndexFromPositionInLayer(block_size,
+                                       workspace_bounds_min_corner) +
+      Index3D::Ones();
+  return static_cast<size_t>(num_blocks.x()) * num_blocks.y() *
+         num_blocks.z();
+}
+
 }  // namespace nvblox
@@ -28,8 +28,10 @@ namespace nvblox {
 template class GPULayerView<TsdfBlock>;
 template class GPULayerView<FreespaceBlock>;
 template class GPULayerView<EsdfBlock>;
+template class GPULayerView<CompactEsdfBlock>;
 template class GPULayerView<ColorBlock>;
 template class GPULayerView<OccupancyBlock>;
+template class GPULayerView<LabelBlock>;
 template class GPULayerView<MeshBlock>;
 
 }  // namespace nvblox
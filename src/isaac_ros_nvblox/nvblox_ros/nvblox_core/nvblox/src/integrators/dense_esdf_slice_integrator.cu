@@ -0,0 +1,461 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "nvblox/integrators/dense_esdf_slice_integrator.h"
+
+#include <climits>
+
+#include "nvblox/geometry/bounding_boxes.h"
+#include "nvblox/integrators/esdf_slicer.h"
+#include "nvblox/gpu_hash/internal/cuda/gpu_hash_interface.cuh"
+#include "nvblox/utils/gpu_timing.h"
+#include "nvblox/utils/timing.h"
+
+namespace nvblox {
+
+// The state of a voxel column after collapsing it to a pixel.
+enum ColumnState : uint8_t { kUnobserved = 0, kFree = 1, kObstacle = 2 };
+
+// Accumulates a column of TSDF voxels by tracking the minimum distance.
+struct TsdfColumnCollapser {
+  __device__ void addVoxel(const TsdfVoxel& voxel) {
+    if (voxel.weight >= min_weight) {
+      observed = true;
+      min_distance = fminf(min_distance, voxel.distance);
+    }
+  }
+  __device__ ColumnState state() const {
+    if (!observed) {
+      return kUnobserved;
+    }
+    return (min_distance <= 0.0f) ? kObstacle : kFree;
+  }
+
+  float min_weight;
+  bool observed = false;
+  float min_distance = 1e6f;
+};
+
+// Accumulates a column of occupancy voxels by tracking the maximum log odds.
+struct OccupancyColumnCollapser {
+  __device__ void addVoxel(const OccupancyVoxel& voxel) {
+    constexpr float kEps = 1e-4;
+    if (fabsf(voxel.log_odds) > kEps) {
+      observed = true;
+      max_log_odds = fmaxf(max_log_odds, voxel.log_odds);
+    }
+  }
+  __device__ ColumnState state() const {
+    if (!observed) {
+      return kUnobserved;
+    }
+    return (max_log_odds > occupied_threshold_log_odds) ? kObstacle : kFree;
+  }
+
+  float occupied_threshold_log_odds;
+  bool observed = false;
+  float max_log_odds = -1e6f;
+};
+
+template <typename BlockType, typename CollapserType>
+__global__ void collapseColumnsKernel(
+    const Index3DDeviceHashMapType<BlockType> block_hash,
+    AxisAlignedBoundingBox aabb, float block_size, int min_block_idx_z,
+    int min_voxel_idx_z, int max_block_idx_z, int max_voxel_idx_z,
+    CollapserType collapser, int rows, int cols, uint8_t* column_states) {
+  const int pixel_col = blockIdx.x * blockDim.x + threadIdx.x;
+  const int pixel_row = blockIdx.y * blockDim.y + threadIdx.y;
+  if (pixel_col >= cols || pixel_row >= rows) {
+    return;
+  }
+  constexpr int kVoxelsPerSide = BlockType::kVoxelsPerSide;
+  const float voxel_size = block_size / kVoxelsPerSide;
+
+  // Get voxel centers by adding half a voxel size.
+  const Vector3f voxel_position(
+      aabb.min().x() + voxel_size / 2.0f + voxel_size * pixel_col,
+      aabb.min().y() + voxel_size / 2.0f + voxel_size * pixel_row, 0.0f);
+  Index3D block_index, voxel_index;
+  getBlockAndVoxelIndexFromPositionInLayer(block_size, voxel_position,
+                                           &block_index, &voxel_index);
+
+  // Walk up the column, looking up each block once.
+  for (int block_idx_z = min_block_idx_z; block_idx_z <= max_block_idx_z;
+       block_idx_z++) {
+    block_index.z() = block_idx_z;
+    auto it = block_hash.find(block_index);
+    if (it == block_hash.end()) {
+      continue;
+    }
+    const BlockType* block_ptr = it->second;
+    const int start_voxel_idx_z =
+        (block_idx_z == min_block_idx_z) ? min_voxel_idx_z : 0;
+    const int end_voxel_idx_z = (block_idx_z == max_block_idx_z)
+                                    ? max_voxel_idx_z
+                                    : kVoxelsPerSide - 1;
+    for (int voxel_idx_z = start_voxel_idx_z; voxel_idx_z <= end_voxel_idx_z;
+         voxel_idx_z++) {
+      collapser.addVoxel(
+          block_ptr->voxels[voxel_index.x()][voxel_index.y()][voxel_idx_z]);
+    }
+  }
+  column_states[pixel_row * cols + pixel_col] = collapser.state();
+}
+
+__global__ void initializeSeedsKernel(const uint8_t* column_states, int numel,
+                                      int* obstacle_seeds, int* free_seeds) {
+  const int idx = blockIdx.x * blockDim.x + threadIdx.x;
+  if (idx >= numel) {
+    return;
+  }
+  obstacle_seeds[idx] = (column_states[idx] == kObstacle) ? idx : -1;
+  free_seeds[idx] = (column_states[idx] == kFree) ? idx : -1;
+}
+
+__device__ inline int squaredPixelDistance(int idx, int row, int col,
+                                           int cols) {
+  const int d_row = idx / cols - row;
+  const int d_col = idx % cols - col;
+  return d_row * d_row + d_col * d_col;
+}
+
+__global__ void jumpFloodKernel(const int* seeds_in, int rows, int cols,
+                                int step, int* seeds_out) {
+  const int col = blockIdx.x * blockDim.x + threadIdx.x;
+  const int row = blockIdx.y * blockDim.y + threadIdx.y;
+  if (col >= cols || row >= rows) {
+    return;
+  }
+  int best_seed = seeds_in[row * cols + col];
+  int best_squared_distance =
+      (best_seed >= 0) ? squaredPixelDistance(best_seed, row, col, cols)
+                       : INT_MAX;
+  for (int d_row = -step; d_row <= step; d_row += step) {
+    for (int d_col = -step; d_col <= step; d_col += step) {
+      const int neighbor_row = row + d_row;
+      const int neighbor_col = col + d_col;
+      if (neighbor_row < 0 || neighbor_row >= rows || neighbor_col < 0 ||
+          neighbor_col >= cols) {
+        continue;
+      }
+      const int seed = seeds_in[neighbor_row * cols + neighbor_col];
+      if (seed < 0) {
+        continue;
+      }
+      const int squared_distance = squaredPixelDistance(seed, row, col, cols);
+      if (squared_distance < best_squared_distance) {
+        best_seed = seed;
+        best_squared_distance = squared_distance;
+      }
+    }
+  }
+  seeds_out[row * cols + col] = best_seed;
+}
+
+__global__ void seedsToDistanceKernel(const uint8_t* column_states,
+                                      const int* obstacle_seeds,
+                                      const int* free_seeds, int rows,
+                                      int cols, float voxel_size,
+                                      float max_distance_m,
+                                      float unobserved_value, float* image) {
+  const int col = blockIdx.x * blockDim.x + threadIdx.x;
+  const int row = blockIdx.y * blockDim.y + threadIdx.y;
+  if (col >= cols || row >= rows) {
+    return;
+  }
+  const int idx = row * cols + col;
+  const uint8_t state = column_states[idx];
+  if (state == kUnobserved) {
+    image::access(row, col, cols, image) = unobserved_value;
+    return;
+  }
+  // Free pixels measure to the nearest obstacle. Obstacle pixels measure to
+  // the nearest free pixel, minus one voxel, such that obstacle pixels on the
+  // boundary have zero distance (like sites in the 3D ESDF).
+  const int seed = (state == kFree) ? obstacle_seeds[idx] : free_seeds[idx];
+  float distance = max_distance_m;
+  if (seed >= 0) {
+    distance = voxel_size * sqrtf(static_cast<float>(
+                                squaredPixelDistance(seed, row, col, cols)));
+  }
+  if (state == kObstacle) {
+    distance = -fminf(distance - voxel_size, max_distance_m);
+  } else {
+    distance = fminf(distance, max_distance_m);
+  }
+  image::access(row, col, cols, image) = distance;
+}
+
+DenseEsdfSliceIntegrator::DenseEsdfSliceIntegrator()
+    : DenseEsdfSliceIntegrator(std::make_shared<CudaStreamOwning>()) {}
+
+DenseEsdfSliceIntegrator::DenseEsdfSliceIntegrator(
+    std::shared_ptr<CudaStream> cuda_stream)
+    : cuda_stream_(cuda_stream) {}
+
+AxisAlignedBoundingBox DenseEsdfSliceIntegrator::getAabbOfLayerInSlice(
+    const TsdfLayer& layer) const {
+  return getAabbOfLayerInSliceTemplate(layer);
+}
+
+AxisAlignedBoundingBox DenseEsdfSliceIntegrator::getAabbOfLayerInSlice(
+    const OccupancyLayer& layer) const {
+  return getAabbOfLayerInSliceTemplate(layer);
+}
+
+void DenseEsdfSliceIntegrator::integrateSlice(
+    const TsdfLayer& layer, const AxisAlignedBoundingBox& aabb,
+    float unobserved_value, Image<float>* output_image) {
+  integrateSliceTemplate(layer, aabb, unobserved_value, output_image);
+}
+
+void DenseEsdfSliceIntegrator::integrateSlice(
+    const OccupancyLayer& layer, const AxisAlignedBoundingBox& aabb,
+    float unobserved_value, Image<float>* output_image) {
+  integrateSliceTemplate(layer, aabb, unobserved_value, output_image);
+}
+
+template <typename LayerType>
+AxisAlignedBoundingBox DenseEsdfSliceIntegrator::getAabbOfLayerInSliceTemplate(
+    const LayerType& layer) const {
+  const int min_block_idx_z =
+      getBlockAndVoxelIndexFrom1DPositionInLayer(layer.block_size(),
+                                                 esdf_slice_min_height_)
+          .first;
+  const int max_block_idx_z =
+      getBlockAndVoxelIndexFrom1DPositionInLayer(layer.block_size(),
+                                                 esdf_slice_max_height_)
+          .first;
+  AxisAlignedBoundingBox aabb;
+  aabb.setEmpty();
+  for (const Index3D& block_index : layer.getAllBlockIndicesCached()) {
+    if (block_index.z() < min_block_idx_z ||
+        block_index.z() > max_block_idx_z) {
+      continue;
+    }
+    aabb.extend(getAABBOfBlock(layer.block_size(), block_index));
+  }
+  if (!aabb.isEmpty()) {
+    aabb.min().z() = esdf_slice_min_height_;
+    aabb.max().z() = esdf_slice_max_height_;
+  }
+  return aabb;
+}
+
+TsdfColumnCollapser getColumnCollapser(const TsdfLayer&, float min_weight,
+                                       float) {
+  TsdfColumnCollapser collapser;
+  collapser.min_weight = min_weight;
+  return collapser;
+}
+
+OccupancyColumnCollapser getColumnCollapser(const OccupancyLayer&, float,
+                                            float occupied_threshold_log_odds) {
+  OccupancyColumnCollapser collapser;
+  collapser.occupied_threshold_log_odds = occupied_threshold_log_odds;
+  return collapser;
+}
+
+template <typename LayerType>
+void DenseEsdfSliceIntegrator::integrateSliceTemplate(
+    const LayerType& layer, const AxisAlignedBoundingBox& aabb,
+    float unobserved_value, Image<float>* output_image) {
+  CHECK_NOTNULL(output_image);
+  CHECK(output_image->memory_type() == MemoryType::kDevice ||
+        output_image->memory_type() == MemoryType::kUnified)
+      << "Output needs to be accessible on device";
+  if (aabb.isEmpty()) {
+    return;
+  }
+  timing::Timer slice_timer("dense_esdf_slice/integrate");
+  timing::GpuTimer slice_gpu_timer("dense_esdf_slice/integrate", *cuda_stream_);
+
+  const float block_size = layer.block_size();
+  const float voxel_size = layer.voxel_size();
+  const Index2D image_size = EsdfSlicer::getSliceImageSize(aabb, voxel_size);
+  const int rows = image_size[0];
+  const int cols = image_size[1];
+  const int numel = rows * cols;
+  output_image->resizeAsync(rows, cols, *cuda_stream_);
+  if (numel <= 0) {
+    return;
+  }
+  column_states_.resizeAsync(numel, *cuda_stream_);
+  obstacle_seeds_.resizeAsync(numel, *cuda_stream_);
+  free_seeds_.resizeAsync(numel, *cuda_stream_);
+  seeds_scratch_.resizeAsync(numel, *cuda_stream_);
+
+  // Collapse the columns in the slice height range to obstacle pixels.
+  timing::Timer collapse_timer("dense_esdf_slice/integrate/collapse");
+  const auto [min_block_idx_z, min_voxel_idx_z] =
+      getBlockAndVoxelIndexFrom1DPositionInLayer(block_size,
+                                                 esdf_slice_min_height_);
+  const auto [max_block_idx_z, max_voxel_idx_z] =
+      getBlockAndVoxelIndexFrom1DPositionInLayer(block_size,
+                                                 esdf_slice_max_height_);
+  typename LayerType::GPULayerViewType& gpu_layer_view =
+      layer.getGpuLayerView(*cuda_stream_);
+
+  const auto collapser = getColumnCollapser(layer, tsdf_min_weight_,
+                                            occupied_threshold_log_odds_);
+
+  constexpr int kThreadDim = 16;
+  const dim3 num_blocks(cols / kThreadDim + 1, rows / kThreadDim + 1);
+  const dim3 num_threads(kThreadDim, kThreadDim);
+  collapseColumnsKernel<<<num_blocks, num_threads, 0, *cuda_stream_>>>(
+      gpu_layer_view.getHash().impl_,  // NOLINT
+      aabb,                            // NOLINT
+      block_size,                      // NOLINT
+      min_block_idx_z,                 // NOLINT
+      min_voxel_idx_z,                 // NOLINT
+      max_block_idx_z,                 // NOLINT
+      max_voxel_idx_z,                 // NOLINT
+      collapser,                       // NOLINT
+      rows,                            // NOLINT
+      cols,                            // NOLINT
+      column_states_.data());
+  checkCudaErrors(cudaPeekAtLastError());
+
+  constexpr int kNumThreads = 512;
+  initializeSeedsKernel<<<numel / kNumThreads + 1, kNumThreads, 0,
+                          *cuda_stream_>>>(column_states_.data(),   // NOLINT
+                                           numel,                   // NOLINT
+                                           obstacle_seeds_.data(),  // NOLINT
+                                           free_seeds_.data());
+  checkCudaErrors(cudaPeekAtLastError());
+  collapse_timer.Stop();
+
+  // Distance transform to the nearest obstacle and nearest free pixel.
+  timing::Timer flood_timer("dense_esdf_slice/integrate/jump_flood");
+  const int* obstacle_seeds =
+      jumpFlood(rows, cols, &obstacle_seeds_, &seeds_scratch_);
+  // NOTE: The scratch buffer may hold the obstacle seeds now, so we use the
+  // other buffer as scratch for the second flood.
+  device_vector<int>* second_scratch_ptr =
+      (obstacle_seeds == seeds_scratch_.data()) ? &obstacle_seeds_
+                                                : &seeds_scratch_;
+  const int* free_seeds =
+      jumpFlood(rows, cols, &free_seeds_, second_scratch_ptr);
+  flood_timer.Stop();
+
+  seedsToDistanceKernel<<<num_blocks, num_threads, 0, *cuda_stream_>>>(
+      column_states_.data(),     // NOLINT
+      obstacle_seeds,            // NOLINT
+      free_seeds,                // NOLINT
+      rows,                      // NOLINT
+      cols,                      // NOLINT
+      voxel_size,                // NOLINT
+      max_esdf_distance_m_,      // NOLINT
+      unobserved_value,          // NOLINT
+      output_image->dataPtr());  // NOLINT
+  cuda_stream_->synchronize();
+  checkCudaErrors(cudaPeekAtLastError());
+}
+
+const int* DenseEsdfSliceIntegrator::jumpFlood(
+    int rows, int cols, device_vector<int>* seeds_ptr,
+    device_vector<int>* scratch_ptr) {
+  int* seeds_in = seeds_ptr->data();
+  int* seeds_out = scratch_ptr->data();
+
+  // Start with half the largest image dimension (rounded up to a power of
+  // two) and halve the step down to a single pixel. The final extra single
+  // pixel pass (JFA+1) removes most of the remaining errors of the
+  // approximation.
+  int step = 1;
+  while (step < std::max(rows, cols)) {
+    step *= 2;
+  }
+  constexpr int kThreadDim = 16;
+  const dim3 num_blocks(cols / kThreadDim + 1, rows / kThreadDim + 1);
+  const dim3 num_threads(kThreadDim, kThreadDim);
+  bool extra_pass_done = false;
+  while (!extra_pass_done) {
+    if (step > 1) {
+      step /= 2;
+    } else {
+      extra_pass_done = true;
+    }
+    jumpFloodKernel<<<num_blocks, num_threads, 0, *cuda_stream_>>>(
+        seeds_in, rows, cols, step, seeds_out);
+    checkCudaErrors(cudaPeekAtLastError());
+    std::swap(seeds_in, seeds_out);
+  }
+  return seeds_in;
+}
+
+float DenseEsdfSliceIntegrator::esdf_slice_min_height() const {
+  return esdf_slice_min_height_;
+}
+
+void DenseEsdfSliceIntegrator::esdf_slice_min_height(
+    float esdf_slice_min_height) {
+  esdf_slice_min_height_ = esdf_slice_min_height;
+}
+
+float DenseEsdfSliceIntegrator::esdf_slice_max_height() const {
+  return esdf_slice_max_height_;
+}
+
+void DenseEsdfSliceIntegrator::esdf_slice_max_height(
+    float esdf_slice_max_height) {
+  esdf_slice_max_height_ = esdf_slice_max_height;
+}
+
+float DenseEsdfSliceIntegrator::max_esdf_distance_m() const {
+  return max_esdf_distance_m_;
+}
+
+void DenseEsdfSliceIntegrator::max_esdf_distance_m(float max_esdf_distance_m) {
+  CHECK_GT(max_esdf_distance_m, 0.0f);
+  max_esdf_distance_m_ = max_esdf_distance_m;
+}
+
+float DenseEsdfSliceIntegrator::min_weight() const { return tsdf_min_weight_; }
+
+void DenseEsdfSliceIntegrator::min_weight(float min_weight) {
+  CHECK_GE(min_weight, 0.0f);
+  tsdf_min_weight_ = min_weight;
+}
+
+float DenseEsdfSliceIntegrator::occupied_threshold() const {
+  return probabilityFromLogOdds(occupied_threshold_log_odds_);
+}
+
+void DenseEsdfSliceIntegrator::occupied_threshold(float occupied_threshold) {
+  CHECK_GE(occupied_threshold, 0.0f);
+  CHECK_LE(occupied_threshold, 1.0f);
+  occupied_threshold_log_odds_ = logOddsFromProbability(occupied_threshold);
+}
+
+parameters::ParameterTreeNode DenseEsdfSliceIntegrator::getParameterTree(
+    const std::string& name_remap) const {
+  using parameters::ParameterTreeNode;
+  const std::string name =
+      (name_remap.empty()) ? "dense_esdf_slice_integrator" : name_remap;
+  return ParameterTreeNode(
+      name, {
+                ParameterTreeNode("esdf_slice_min_height:",
+                                  esdf_slice_min_height_),
+                ParameterTreeNode("esdf_slice_max_height:",
+                                  esdf_slice_max_height_),
+                ParameterTreeNode("max_esdf_distance_m:", max_esdf_distance_m_),
+                ParameterTreeNode("tsdf_min_weight:", tsdf_min_weight_),
+                ParameterTreeNode("occupied_threshold_log_odds:",
+                                  occupied_threshold_log_odds_),
+            });
+}
+
+}  // namespace nvblox
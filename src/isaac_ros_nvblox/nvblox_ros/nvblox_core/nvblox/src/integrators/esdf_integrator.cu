@@ -17,18 +17,23 @@ limitations under the License.
 
 #include <assert.h>
 
-#include "thrust/sort.h"
-#include "thrust/unique.h"
+#include <cooperative_groups.h>
 
+#include "cub/block/block_discontinuity.cuh"
 #include "cub/block/block_radix_sort.cuh"
+#include "cub/block/block_scan.cuh"
 #include "nvblox/core/internal/cuda/atomic_float.cuh"
 #include "nvblox/core/internal/cuda/device_function_utils.cuh"
+#include "nvblox/core/launch_autotuner.h"
 #include "nvblox/geometry/bounding_boxes.h"
 #include "nvblox/geometry/bounding_spheres.h"
+#include "nvblox/gpu_hash/internal/cuda/block_neighbor_table.cuh"
 #include "nvblox/gpu_hash/internal/cuda/gpu_hash_interface.cuh"
 #include "nvblox/gpu_hash/internal/cuda/gpu_indexing.cuh"
 #include "nvblox/gpu_hash/internal/cuda/gpu_set.cuh"
 #include "nvblox/integrators/internal/cuda/esdf_integrator_slicing.cuh"
+#include "nvblox/map/internal/cuda/voxel_block_threads.cuh"
+#include "nvblox/utils/gpu_timing.h"
 #include "nvblox/utils/timing.h"
 
 namespace nvblox {
@@ -39,6 +44,12 @@ EsdfIntegrator::EsdfIntegrator()
 EsdfIntegrator::EsdfIntegrator(std::shared_ptr<CudaStream> cuda_stream)
     : cuda_stream_(cuda_stream) {}
 
+void EsdfIntegrator::cuda_stream(std::shared_ptr<CudaStream> cuda_stream) {
+  CHECK(cuda_stream != nullptr);
+  cuda_stream_->synchronize();
+  cuda_stream_ = cuda_stream;
+}
+
 float EsdfIntegrator::max_esdf_distance_m() const {
   return max_esdf_distance_m_;
 }
@@ -74,6 +85,19 @@ void EsdfIntegrator::occupied_threshold(float occupied_threshold) {
   occupied_threshold_log_odds_ = logOddsFromProbability(occupied_threshold);
 }
 
+bool EsdfIntegrator::use_persistent_kernel() const {
+  return use_persistent_kernel_;
+}
+
+void EsdfIntegrator::use_persistent_kernel(bool use_persistent_kernel) {
+  if (use_persistent_kernel && !isPersistentKernelSupported()) {
+    LOG(WARNING) << "The GPU doesn't support cooperative launches. Keeping "
+                    "one ESDF kernel launch per wavefront.";
+    return;
+  }
+  use_persistent_kernel_ = use_persistent_kernel;
+}
+
 parameters::ParameterTreeNode EsdfIntegrator::getParameterTree(
     const std::string& name_remap) const {
   using parameters::ParameterTreeNode;
@@ -95,21 +119,66 @@ parameters::ParameterTreeNode EsdfIntegrator::getParameterTree(
                             slice_height_above_plane_m_),
           ParameterTreeNode("slice_height_thickness_m:",
                             slice_height_thickness_m_),
+          ParameterTreeNode("use_persistent_kernel:", use_persistent_kernel_),
       });
 }
 
 __device__ bool isVoxelFreespace(const FreespaceBlock* freespace_block_ptr,
-                                 const dim3& voxel_index) {
+                                 const Index3D& voxel_index) {
   if (freespace_block_ptr == nullptr) {
     return false;
   } else {
     const FreespaceVoxel* freespace_voxel_ptr =
         &freespace_block_ptr
-             ->voxels[voxel_index.x][voxel_index.y][voxel_index.z];
+             ->voxels[voxel_index.x()][voxel_index.y()][voxel_index.z()];
     return freespace_voxel_ptr->is_high_confidence_freespace;
   }
 }
 
+#ifdef NVBLOX_HALF_PRECISION_TSDF
+// Half-precision TSDF voxels can't use atomicMinFloat() so we CAS the whole
+// (32 bit) voxel instead.
+__device__ void atomicMinTsdfDistance(TsdfVoxel* voxel, float distance) {
+  static_assert(sizeof(TsdfVoxel) == sizeof(unsigned int));
+  unsigned int* address = reinterpret_cast<unsigned int*>(voxel);
+  unsigned int old_value = *address;
+  unsigned int assumed_value;
+  do {
+    assumed_value = old_value;
+    TsdfVoxel new_voxel = *reinterpret_cast<TsdfVoxel*>(&assumed_value);
+    if (new_voxel.distance <= distance) {
+      return;
+    }
+    new_voxel.distance = distance;
+    old_value = atomicCAS(address, assumed_value,
+                          *reinterpret_cast<unsigned int*>(&new_voxel));
+  } while (assumed_value != old_value);
+}
+#endif
+
+#ifdef NVBLOX_QUANTIZED_OCCUPANCY
+// Quantized occupancy voxels can't use atomicMaxFloat() so we CAS the whole
+// (16 bit) voxel instead. The fixed point value is ordered like the log-odds.
+__device__ void atomicMaxLogOdds(OccupancyVoxel* voxel,
+                                 const QuantizedLogOdds log_odds) {
+  static_assert(sizeof(OccupancyVoxel) == sizeof(unsigned short));
+  unsigned short* address = reinterpret_cast<unsigned short*>(voxel);
+  unsigned short old_value = *address;
+  unsigned short assumed_value;
+  do {
+    assumed_value = old_value;
+    OccupancyVoxel new_voxel =
+        *reinterpret_cast<OccupancyVoxel*>(&assumed_value);
+    if (new_voxel.log_odds.raw() >= log_odds.raw()) {
+      return;
+    }
+    new_voxel.log_odds = log_odds;
+    old_value = atomicCAS(address, assumed_value,
+                          *reinterpret_cast<unsigned short*>(&new_voxel));
+  } while (assumed_value != old_value);
+}
+#endif
+
 struct TsdfSiteFunctor {
   __device__ bool isVoxelObserved(const TsdfVoxel& tsdf_voxel) const {
     return tsdf_voxel.weight >= min_weight;
@@ -130,7 +199,11 @@ struct TsdfSiteFunctor {
       // Ignore voxels that are marked as freespace.
       return;
     }
+#ifdef NVBLOX_HALF_PRECISION_TSDF
+    atomicMinTsdfDistance(current_value, tsdf_voxel.distance);
+#else
     atomicMinFloat(&current_value->distance, tsdf_voxel.distance);
+#endif
   }
 
   float min_weight;
@@ -161,17 +234,79 @@ struct OccupancySiteFunctor {
       // Ignore voxels that are marked as freespace.
       return;
     }
+#ifdef NVBLOX_QUANTIZED_OCCUPANCY
+    atomicMaxLogOdds(current_voxel, occupancy_voxel.log_odds);
+#else
     atomicMaxFloat(&current_voxel->log_odds, occupancy_voxel.log_odds);
+#endif
   }
 
   float occupied_threshold_log_odds;
 };
 
-__device__ void clearVoxelDevice(EsdfVoxel* voxel,
+// Accessors that allow the kernels below to operate on both the full
+// EsdfVoxel and on the packed CompactEsdfVoxel.
+__device__ inline Index3D getParentDirection(const EsdfVoxel& voxel) {
+  return voxel.parent_direction;
+}
+__device__ inline Index3D getParentDirection(const CompactEsdfVoxel& voxel) {
+  return voxel.parent_direction();
+}
+__device__ inline void setParentDirection(const Index3D& parent_direction,
+                                          EsdfVoxel* voxel) {
+  voxel->parent_direction = parent_direction;
+}
+__device__ inline void setParentDirection(const Index3D& parent_direction,
+                                          CompactEsdfVoxel* voxel) {
+  voxel->parent_direction(parent_direction);
+}
+__device__ inline bool hasParentDirection(const EsdfVoxel& voxel) {
+  return voxel.parent_direction != Index3D::Zero();
+}
+__device__ inline bool hasParentDirection(const CompactEsdfVoxel& voxel) {
+  return voxel.has_parent_direction();
+}
+__device__ inline bool isInside(const EsdfVoxel& voxel) {
+  return voxel.is_inside;
+}
+__device__ inline bool isInside(const CompactEsdfVoxel& voxel) {
+  return voxel.is_inside();
+}
+__device__ inline void setIsInside(bool is_inside, EsdfVoxel* voxel) {
+  voxel->is_inside = is_inside;
+}
+__device__ inline void setIsInside(bool is_inside, CompactEsdfVoxel* voxel) {
+  voxel->is_inside(is_inside);
+}
+__device__ inline bool isObserved(const EsdfVoxel& voxel) {
+  return voxel.observed;
+}
+__device__ inline bool isObserved(const CompactEsdfVoxel& voxel) {
+  return voxel.observed();
+}
+__device__ inline void setObserved(bool observed, EsdfVoxel* voxel) {
+  voxel->observed = observed;
+}
+__device__ inline void setObserved(bool observed, CompactEsdfVoxel* voxel) {
+  voxel->observed(observed);
+}
+__device__ inline bool isSite(const EsdfVoxel& voxel) { return voxel.is_site; }
+__device__ inline bool isSite(const CompactEsdfVoxel& voxel) {
+  return voxel.is_site();
+}
+__device__ inline void setIsSite(bool is_site, EsdfVoxel* voxel) {
+  voxel->is_site = is_site;
+}
+__device__ inline void setIsSite(bool is_site, CompactEsdfVoxel* voxel) {
+  voxel->is_site(is_site);
+}
+
+template <typename EsdfVoxelType>
+__device__ void clearVoxelDevice(EsdfVoxelType* voxel,
                                  float max_squared_esdf_distance_vox) {
-  voxel->parent_direction.setZero();
+  setParentDirection(Index3D::Zero(), voxel);
   voxel->squared_distance_vox = max_squared_esdf_distance_vox;
-  voxel->is_site = false;
+  setIsSite(false, voxel);
 }
 
 template <typename T>
@@ -217,16 +352,25 @@ Plane checkForVerticalPlane(const Plane& ground_plane) {
 
 }  // namespace
 
-template <typename LayerType>
+template <typename LayerType, typename EsdfLayerType>
 void EsdfIntegrator::integrateBlocksTemplate(
     const LayerType& layer, const std::vector<Index3D>& block_indices,
-    EsdfLayer* esdf_layer, const FreespaceLayer* freespace_layer_ptr) {
+    EsdfLayerType* esdf_layer, const FreespaceLayer* freespace_layer_ptr) {
   timing::Timer esdf_timer("esdf/integrate");
 
   if (block_indices.empty()) {
     return;
   }
 
+  if constexpr (std::is_same<EsdfLayerType, CompactEsdfLayer>::value) {
+    // Parent directions are bounded by the maximum ESDF distance, so we only
+    // have to check that this distance fits in the packed representation.
+    CHECK_LE(max_esdf_distance_m_ / esdf_layer->voxel_size(),
+             static_cast<float>(CompactEsdfVoxel::kMaxParentOffsetVox))
+        << "max_esdf_distance_m is too large (in voxels) to be represented "
+           "in a CompactEsdfLayer.";
+  }
+
   timing::Timer allocate_timer("esdf/integrate/allocate");
   // First, allocate all the destination blocks.
   allocateBlocksOnCPU(block_indices, esdf_layer);
@@ -280,6 +424,27 @@ void EsdfIntegrator::integrateBlocks(const OccupancyLayer& occupancy_layer,
                                           esdf_layer);
 }
 
+void EsdfIntegrator::integrateBlocks(const TsdfLayer& tsdf_layer,
+                                     const std::vector<Index3D>& block_indices,
+                                     CompactEsdfLayer* esdf_layer) {
+  integrateBlocksTemplate<TsdfLayer>(tsdf_layer, block_indices, esdf_layer);
+}
+
+void EsdfIntegrator::integrateBlocks(const TsdfLayer& tsdf_layer,
+                                     const FreespaceLayer& freespace_layer,
+                                     const std::vector<Index3D>& block_indices,
+                                     CompactEsdfLayer* esdf_layer) {
+  integrateBlocksTemplate<TsdfLayer>(tsdf_layer, block_indices, esdf_layer,
+                                     &freespace_layer);
+}
+
+void EsdfIntegrator::integrateBlocks(const OccupancyLayer& occupancy_layer,
+                                     const std::vector<Index3D>& block_indices,
+                                     CompactEsdfLayer* esdf_layer) {
+  integrateBlocksTemplate<OccupancyLayer>(occupancy_layer, block_indices,
+                                          esdf_layer);
+}
+
 template <typename LayerType, typename SliceDescriptionType>
 void EsdfIntegrator::integrateSliceTemplate(
     const LayerType& layer, const std::vector<Index3D>& block_indices,
@@ -388,8 +553,77 @@ void EsdfIntegrator::integrateSlice(const OccupancyLayer& occupancy_layer,
                                          slice_description, esdf_layer);
 }
 
+template <typename LayerType>
+void EsdfIntegrator::integrateSlicesTemplate(
+    const LayerType& layer, const std::vector<Index3D>& block_indices,
+    const std::vector<EsdfSliceSpec>& slice_specs,
+    const std::vector<EsdfLayer*>& esdf_layers,
+    const FreespaceLayer* freespace_layer_ptr) {
+  CHECK_EQ(slice_specs.size(), esdf_layers.size());
+  CHECK_LE(slice_specs.size(), static_cast<size_t>(kMaxNumSlices));
+  timing::Timer esdf_timer("esdf/integrate_slices");
+
+  if (block_indices.empty() || slice_specs.empty()) {
+    return;
+  }
+
+  timing::Timer mark_timer("esdf/integrate_slices/mark_sites");
+  // Mark the sites of all slices in a single pass over the input layer.
+  std::vector<std::vector<Index3D>> updated_blocks_per_slice;
+  std::vector<std::vector<Index3D>> cleared_blocks_per_slice;
+  markSitesInSlices(layer, block_indices, slice_specs, freespace_layer_ptr,
+                    esdf_layers, &updated_blocks_per_slice,
+                    &cleared_blocks_per_slice);
+  mark_timer.Stop();
+
+  // The propagation is done per output layer.
+  timing::Timer compute_timer("esdf/integrate_slices/compute");
+  for (size_t i = 0; i < slice_specs.size(); i++) {
+    cleared_block_indices_device_.clearNoDeallocate();
+    if (!cleared_blocks_per_slice[i].empty()) {
+      clearAllInvalid(cleared_blocks_per_slice[i], esdf_layers[i],
+                      &cleared_block_indices_device_);
+      cuda_stream_->synchronize();
+    }
+    updated_indices_device_.copyFromAsync(updated_blocks_per_slice[i],
+                                          *cuda_stream_);
+    computeEsdf(updated_indices_device_, esdf_layers[i]);
+    if (!cleared_block_indices_device_.empty()) {
+      computeEsdf(cleared_block_indices_device_, esdf_layers[i]);
+    }
+  }
+  compute_timer.Stop();
+}
+
+void EsdfIntegrator::integrateSlices(
+    const TsdfLayer& tsdf_layer, const std::vector<Index3D>& block_indices,
+    const std::vector<EsdfSliceSpec>& slice_specs,
+    const std::vector<EsdfLayer*>& esdf_layers) {
+  integrateSlicesTemplate<TsdfLayer>(tsdf_layer, block_indices, slice_specs,
+                                     esdf_layers);
+}
+
+void EsdfIntegrator::integrateSlices(
+    const TsdfLayer& tsdf_layer, const FreespaceLayer& freespace_layer,
+    const std::vector<Index3D>& block_indices,
+    const std::vector<EsdfSliceSpec>& slice_specs,
+    const std::vector<EsdfLayer*>& esdf_layers) {
+  integrateSlicesTemplate<TsdfLayer>(tsdf_layer, block_indices, slice_specs,
+                                     esdf_layers, &freespace_layer);
+}
+
+void EsdfIntegrator::integrateSlices(
+    const OccupancyLayer& occupancy_layer,
+    const std::vector<Index3D>& block_indices,
+    const std::vector<EsdfSliceSpec>& slice_specs,
+    const std::vector<EsdfLayer*>& esdf_layers) {
+  integrateSlicesTemplate<OccupancyLayer>(occupancy_layer, block_indices,
+                                          slice_specs, esdf_layers);
+}
+
+template <typename EsdfLayerType>
 void EsdfIntegrator::allocateBlocksOnCPU(
-    const std::vector<Index3D>& block_indices, EsdfLayer* esdf_layer) {
+    const std::vector<Index3D>& block_indices, EsdfLayerType* esdf_layer) {
   // We want to allocate all ESDF layer blocks and copy over the sites.
   for (const Index3D& block_index : block_indices) {
     esdf_layer->allocateBlockAtIndexAsync(block_index, *cuda_stream_);
@@ -398,14 +632,14 @@ void EsdfIntegrator::allocateBlocksOnCPU(
 
 // The function looks at the current value of the input TSDF/Occupancy voxel
 // and the currect value of the pass ESDF voxel and updates it.
-template <typename VoxelType, typename SiteFunctorType>
+template <typename VoxelType, typename SiteFunctorType, typename EsdfVoxelType>
 __device__ void updateEsdfVoxelToChanges(
     const VoxelType* voxel_ptr,                 // NOLINT
     const bool is_observed,                     // NOLINT
     const bool is_freespace,                    // NOLINT
     const SiteFunctorType& site_functor,        // NOLINT
     const float max_squared_esdf_distance_vox,  // NOLINT
-    EsdfVoxel* esdf_voxel_ptr,                  // NOLINT
+    EsdfVoxelType* esdf_voxel_ptr,              // NOLINT
     bool* cleared,                              // NOLINT
     bool* updated) {
   if (is_observed) {
@@ -418,31 +652,31 @@ __device__ void updateEsdfVoxelToChanges(
         is_inside && site_functor.isVoxelNearSurface(*voxel_ptr);
 
     // Handle flips in "is_inside"
-    if (esdf_voxel_ptr->is_inside && is_inside == false) {
+    if (isInside(*esdf_voxel_ptr) && is_inside == false) {
       clearVoxelDevice(esdf_voxel_ptr, max_squared_esdf_distance_vox);
       *cleared = true;
     }
-    esdf_voxel_ptr->is_inside = is_inside;
+    setIsInside(is_inside, esdf_voxel_ptr);
 
     if (is_site) {
-      if (esdf_voxel_ptr->is_site) {
+      if (isSite(*esdf_voxel_ptr)) {
         // Ok whatever. Add to the site list.
         // Its existing values are fine.
         *updated = true;
       } else {
         // Wasn't a site before, is now.
-        esdf_voxel_ptr->is_site = true;
+        setIsSite(true, esdf_voxel_ptr);
         esdf_voxel_ptr->squared_distance_vox = 0.0f;
-        esdf_voxel_ptr->parent_direction.setZero();
+        setParentDirection(Index3D::Zero(), esdf_voxel_ptr);
         *updated = true;
       }
     } else {
       // Here we have to double-check what's going on.
       // If it was a site before, and isn't anymore, we have to clear it.
-      if (esdf_voxel_ptr->is_site) {
+      if (isSite(*esdf_voxel_ptr)) {
         clearVoxelDevice(esdf_voxel_ptr, max_squared_esdf_distance_vox);
         *cleared = true;
-      } else if (!esdf_voxel_ptr->observed) {
+      } else if (!isObserved(*esdf_voxel_ptr)) {
         // This is a brand new voxel.
         clearVoxelDevice(esdf_voxel_ptr, max_squared_esdf_distance_vox);
       } else if (esdf_voxel_ptr->squared_distance_vox <= 1e-4) {
@@ -452,34 +686,34 @@ __device__ void updateEsdfVoxelToChanges(
         *cleared = true;
       }
     }
-    esdf_voxel_ptr->observed = true;
+    setObserved(true, esdf_voxel_ptr);
   } else {
     clearVoxelDevice(esdf_voxel_ptr, max_squared_esdf_distance_vox);
     *cleared = true;
-    esdf_voxel_ptr->observed = false;
+    setObserved(false, esdf_voxel_ptr);
   }
 }
 
 // Mark sites to lower & clear.
-// Block size MUST be voxels_per_side x voxels_per_side x voxel_per_size.
+// Block size MUST be voxelBlockThreadsPerBlock().
 // Grid size can be anything.
-template <typename BlockType, typename SiteFunctorType>
+template <typename BlockType, typename SiteFunctorType, typename EsdfBlockType>
 __global__ void markAllSitesKernel(
     int num_blocks, Index3D* block_indices,
     const Index3DDeviceHashMapType<BlockType> input_layer_block_hash,
     const Index3DDeviceHashMapType<FreespaceBlock> freespace_block_hash,
-    Index3DDeviceHashMapType<EsdfBlock> esdf_block_hash,
+    Index3DDeviceHashMapType<EsdfBlockType> esdf_block_hash,
     const SiteFunctorType site_functor, float max_squared_esdf_distance_vox,
     Index3D* updated_vec, int* updated_vec_size, Index3D* to_clear_vec,
     int* to_clear_vec_size) {
-  dim3 voxel_index = threadIdx;
   int block_idx = blockIdx.x;
 
   using VoxelType = typename BlockType::VoxelType;
+  using EsdfVoxelType = typename EsdfBlockType::VoxelType;
 
   __shared__ BlockType* block_ptr;
   __shared__ FreespaceBlock* freespace_block_ptr;
-  __shared__ EsdfBlock* esdf_block;
+  __shared__ EsdfBlockType* esdf_block;
   __shared__ bool updated;
   __shared__ bool cleared;
   __syncthreads();
@@ -513,19 +747,23 @@ __global__ void markAllSitesKernel(
     return;
   }
 
-  // Get the correct voxel for this index.
-  const VoxelType* voxel_ptr =
-      &block_ptr->voxels[voxel_index.x][voxel_index.y][voxel_index.z];
-  EsdfVoxel* esdf_voxel_ptr =
-      &esdf_block->voxels[voxel_index.x][voxel_index.y][voxel_index.z];
+  forEachVoxelInThread([&](const Index3D& voxel_index) {
+    // Get the correct voxel for this index.
+    const VoxelType* voxel_ptr =
+        &block_ptr->voxels[voxel_index.x()][voxel_index.y()][voxel_index.z()];
+    EsdfVoxelType* esdf_voxel_ptr =
+        &esdf_block
+             ->voxels[voxel_index.x()][voxel_index.y()][voxel_index.z()];
 
-  const bool is_observed = site_functor.isVoxelObserved(*voxel_ptr);
-  const bool is_freespace = isVoxelFreespace(freespace_block_ptr, voxel_index);
+    const bool is_observed = site_functor.isVoxelObserved(*voxel_ptr);
+    const bool is_freespace =
+        isVoxelFreespace(freespace_block_ptr, voxel_index);
 
-  // Update the ESDF voxel based on changes to the input layer.
-  updateEsdfVoxelToChanges(voxel_ptr, is_observed, is_freespace, site_functor,
-                           max_squared_esdf_distance_vox, esdf_voxel_ptr,
-                           &cleared, &updated);
+    // Update the ESDF voxel based on changes to the input layer.
+    updateEsdfVoxelToChanges(voxel_ptr, is_observed, is_freespace,
+                             site_functor, max_squared_esdf_distance_vox,
+                             esdf_voxel_ptr, &cleared, &updated);
+  });
   __syncthreads();
   // Now output the updated and cleared.
   // Do this once per block.
@@ -539,9 +777,11 @@ __global__ void markAllSitesKernel(
   }
 }
 
+template <typename EsdfBlockType>
 __device__ void sweepSingleBand(Index3D voxel_index, int sweep_axis,
                                 float max_squared_esdf_distance_vox,
-                                EsdfBlock* esdf_block) {
+                                EsdfBlockType* esdf_block) {
+  using EsdfVoxelType = typename EsdfBlockType::VoxelType;
   constexpr int kVoxelsPerSide = VoxelBlock<bool>::kVoxelsPerSide;
   Index3D last_site;
   bool site_found;
@@ -562,14 +802,14 @@ __device__ void sweepSingleBand(Index3D voxel_index, int sweep_axis,
     for (voxel_index(sweep_axis) = start_voxel;
          voxel_index(sweep_axis) != end_voxel;
          voxel_index(sweep_axis) += direction) {
-      EsdfVoxel* esdf_voxel =
+      EsdfVoxelType* esdf_voxel =
           &esdf_block
                ->voxels[voxel_index.x()][voxel_index.y()][voxel_index.z()];
-      if (!esdf_voxel->observed) {
+      if (!isObserved(*esdf_voxel)) {
         continue;
       }
       // If this voxel is itself a site, then mark this for future voxels.
-      if (esdf_voxel->is_site) {
+      if (isSite(*esdf_voxel)) {
         last_site = voxel_index;
         site_found = true;
       } else if (!site_found) {
@@ -577,7 +817,7 @@ __device__ void sweepSingleBand(Index3D voxel_index, int sweep_axis,
         // then if this voxel is valid we set it as the site.
         if (esdf_voxel->squared_distance_vox < max_squared_esdf_distance_vox) {
           site_found = true;
-          last_site = esdf_voxel->parent_direction + voxel_index;
+          last_site = getParentDirection(*esdf_voxel) + voxel_index;
         }
       } else {
         // If we've found the site, then should just decide what to do
@@ -587,43 +827,45 @@ __device__ void sweepSingleBand(Index3D voxel_index, int sweep_axis,
         // Either it hasn't been set at all or it's closer to the site
         // than to its current value.
         if (esdf_voxel->squared_distance_vox > potential_distance) {
-          esdf_voxel->parent_direction = potential_direction;
+          setParentDirection(potential_direction, esdf_voxel);
           esdf_voxel->squared_distance_vox = potential_distance;
         } else if (esdf_voxel->squared_distance_vox <
                    max_squared_esdf_distance_vox) {
           // If the current value is a better site, then set it as a site.
-          last_site = esdf_voxel->parent_direction + voxel_index;
+          last_site = getParentDirection(*esdf_voxel) + voxel_index;
         }
       }
     }
   }
 }
 
-__device__ bool updateSingleNeighbor(const EsdfBlock* esdf_block,
+template <typename EsdfBlockType>
+__device__ bool updateSingleNeighbor(const EsdfBlockType* esdf_block,
                                      const Index3D& voxel_index,
                                      const Index3D& neighbor_voxel_index,
                                      const int axis, const int direction,
                                      const float max_squared_esdf_distance_vox,
-                                     EsdfBlock* neighbor_block) {
-  const EsdfVoxel* esdf_voxel =
+                                     EsdfBlockType* neighbor_block) {
+  using EsdfVoxelType = typename EsdfBlockType::VoxelType;
+  const EsdfVoxelType* esdf_voxel =
       &esdf_block->voxels[voxel_index.x()][voxel_index.y()][voxel_index.z()];
-  EsdfVoxel* neighbor_voxel =
+  EsdfVoxelType* neighbor_voxel =
       &neighbor_block
            ->voxels[neighbor_voxel_index.x()][neighbor_voxel_index.y()]
                    [neighbor_voxel_index.z()];
-  if (!esdf_voxel->observed || !neighbor_voxel->observed ||
-      neighbor_voxel->is_site ||
+  if (!isObserved(*esdf_voxel) || !isObserved(*neighbor_voxel) ||
+      isSite(*neighbor_voxel) ||
       esdf_voxel->squared_distance_vox >= max_squared_esdf_distance_vox) {
     return false;
   }
   // Determine if we can update this.
-  Eigen::Vector3i potential_direction = esdf_voxel->parent_direction;
+  Eigen::Vector3i potential_direction = getParentDirection(*esdf_voxel);
   potential_direction(axis) -= direction;
   float potential_distance = potential_direction.squaredNorm();
   // TODO: might be some concurrency issues here, have to be a bit careful
   // on the corners/edges.
   if (neighbor_voxel->squared_distance_vox > potential_distance) {
-    neighbor_voxel->parent_direction = potential_direction;
+    setParentDirection(potential_direction, neighbor_voxel);
     // Cache at global level (cache in L2 and below, not L1). We do not expect
     // L1 cache level reuse.
     __stcg(&neighbor_voxel->squared_distance_vox, potential_distance);
@@ -632,26 +874,28 @@ __device__ bool updateSingleNeighbor(const EsdfBlock* esdf_block,
   return false;
 }
 
-__device__ bool clearSingleNeighbor(const EsdfBlock* esdf_block,
+template <typename EsdfBlockType>
+__device__ bool clearSingleNeighbor(const EsdfBlockType* esdf_block,
                                     const Index3D& voxel_index,
                                     const Index3D& neighbor_voxel_index,
                                     int axis, int direction,
                                     float max_squared_esdf_distance_vox,
-                                    EsdfBlock* neighbor_block) {
-  const EsdfVoxel* esdf_voxel =
+                                    EsdfBlockType* neighbor_block) {
+  using EsdfVoxelType = typename EsdfBlockType::VoxelType;
+  const EsdfVoxelType* esdf_voxel =
       &esdf_block->voxels[voxel_index.x()][voxel_index.y()][voxel_index.z()];
-  EsdfVoxel* neighbor_voxel =
+  EsdfVoxelType* neighbor_voxel =
       &neighbor_block
            ->voxels[neighbor_voxel_index.x()][neighbor_voxel_index.y()]
                    [neighbor_voxel_index.z()];
 
   if (esdf_voxel->squared_distance_vox < max_squared_esdf_distance_vox ||
-      !esdf_voxel->observed || neighbor_voxel->is_site ||
+      !isObserved(*esdf_voxel) || isSite(*neighbor_voxel) ||
       neighbor_voxel->squared_distance_vox >= max_squared_esdf_distance_vox) {
     return false;
   }
   // Determine if we can update this.
-  Index3D parent_voxel_dir = neighbor_voxel->parent_direction;
+  Index3D parent_voxel_dir = getParentDirection(*neighbor_voxel);
   if ((direction > 0 && parent_voxel_dir(axis) > 0) ||
       (direction < 0 && parent_voxel_dir(axis) < 0)) {
     return false;
@@ -675,11 +919,11 @@ TsdfSiteFunctor EsdfIntegrator::getSiteFunctor(const TsdfLayer& layer) {
   return functor;
 }
 
-template <typename LayerType>
+template <typename LayerType, typename EsdfLayerType>
 void EsdfIntegrator::markAllSites(const LayerType& layer,
                                   const std::vector<Index3D>& block_indices,
                                   const FreespaceLayer* freespace_layer_ptr,
-                                  EsdfLayer* esdf_layer,
+                                  EsdfLayerType* esdf_layer,
                                   device_vector<Index3D>* blocks_with_sites,
                                   device_vector<Index3D>* cleared_blocks) {
   CHECK_NOTNULL(esdf_layer);
@@ -703,7 +947,7 @@ void EsdfIntegrator::markAllSites(const LayerType& layer,
   updated_counter_device_.setZeroAsync(*cuda_stream_);
   cleared_counter_device_.setZeroAsync(*cuda_stream_);
 
-  GPULayerView<EsdfBlock>& esdf_layer_view =
+  GPULayerView<typename EsdfLayerType::BlockType>& esdf_layer_view =
       esdf_layer->getGpuLayerView(*cuda_stream_);
   GPULayerView<typename LayerType::BlockType>& input_layer_view =
       layer.getGpuLayerView(*cuda_stream_);
@@ -719,8 +963,7 @@ void EsdfIntegrator::markAllSites(const LayerType& layer,
 
   // Call the kernel.
   int dim_block = num_blocks;
-  constexpr int kVoxelsPerSide = EsdfBlock::kVoxelsPerSide;
-  dim3 dim_threads(kVoxelsPerSide, kVoxelsPerSide, kVoxelsPerSide);
+  const dim3 dim_threads = voxelBlockThreadsPerBlock();
   // Call kernel, passing functor
   markAllSitesKernel<<<dim_block, dim_threads, 0, *cuda_stream_>>>(
       num_blocks, block_indices_device_.data(),  // NOLINT
@@ -871,7 +1114,7 @@ __global__ void markSitesInSliceKernel(
       if (site_functor.isVoxelObserved(*voxel_ptr)) {
         observed[voxel_idx_x][voxel_idx_y] = true;
         const bool is_freespace = isVoxelFreespace(
-            freespace_block_ptr, dim3(voxel_idx_x, voxel_idx_y, i));
+            freespace_block_ptr, Index3D(voxel_idx_x, voxel_idx_y, i));
         site_functor.updateSquashedExtremumAtomic(
             *voxel_ptr, is_freespace, &voxel_slice[voxel_idx_x][voxel_idx_y]);
       }
@@ -1059,6 +1302,295 @@ void EsdfIntegrator::markSitesInSlice(
   pack_out_timer.Stop();
 }
 
+// The height ranges and output locations of the slices processed by
+// markSitesInSlicesKernel(). Passed to the kernel by value.
+struct SliceSpecsDevice {
+  int num_slices;
+  // Inclusive height range of each slice, as global z voxel indices (i.e.
+  // block_idx_z * kVoxelsPerSide + voxel_idx_z).
+  int min_voxel_idx_z[EsdfIntegrator::kMaxNumSlices];
+  int max_voxel_idx_z[EsdfIntegrator::kMaxNumSlices];
+  // Location of the output slice in its layer.
+  int output_block_idx_z[EsdfIntegrator::kMaxNumSlices];
+  int output_voxel_idx_z[EsdfIntegrator::kMaxNumSlices];
+  Index3DDeviceHashMapType<EsdfBlock>
+      esdf_block_hashes[EsdfIntegrator::kMaxNumSlices];
+};
+
+// Same as markSitesInSliceKernel() but squashes each voxel column into the
+// slices of all specs whose height range it falls into, such that the input
+// layer is read only once. The thread z index spans the union of the height
+// ranges.
+template <typename BlockType, typename SiteFunctorType>
+__global__ void markSitesInSlicesKernel(
+    const Index3D* column_block_indices,
+    const Index3DDeviceHashMapType<BlockType> input_layer_block_hash,
+    const Index3DDeviceHashMapType<FreespaceBlock> freespace_block_hash,
+    const SliceSpecsDevice slice_specs, const SiteFunctorType site_functor,
+    float max_squared_esdf_distance_vox, int min_block_idx_z, int num_columns,
+    Index3D* updated_vec, int* updated_vec_sizes, Index3D* to_clear_vec,
+    int* to_clear_vec_sizes) {
+  const int voxel_idx_x = threadIdx.x;
+  const int voxel_idx_y = threadIdx.y;
+  const int vertical_block_idx_offset = threadIdx.z;
+  const int column_idx = blockIdx.x;
+
+  using VoxelType = typename BlockType::VoxelType;
+  constexpr int kVoxelsPerSide = BlockType::kVoxelsPerSide;
+  constexpr int kMaxNumSlices = EsdfIntegrator::kMaxNumSlices;
+
+  __shared__ bool observed[kMaxNumSlices][kVoxelsPerSide][kVoxelsPerSide];
+  __shared__ typename SharedVoxel<VoxelType>::type
+      voxel_slices[kMaxNumSlices][kVoxelsPerSide][kVoxelsPerSide];
+  __shared__ EsdfBlock* esdf_block_ptrs[kMaxNumSlices];
+  __shared__ bool updated[kMaxNumSlices], cleared[kMaxNumSlices];
+
+  // Initialize the squashed slices once for each voxel in the x/y plane.
+  if (vertical_block_idx_offset == 0) {
+    for (int i = 0; i < slice_specs.num_slices; i++) {
+      observed[i][voxel_idx_x][voxel_idx_y] = false;
+      if constexpr (std::is_same<TsdfVoxel, VoxelType>::value) {
+        voxel_slices[i][voxel_idx_x][voxel_idx_y].distance =
+            2 * max_squared_esdf_distance_vox;
+      } else if constexpr (std::is_same<OccupancyVoxel, VoxelType>::value) {
+        voxel_slices[i][voxel_idx_x][voxel_idx_y].log_odds = 0.0f;
+      } else {
+        static_assert(conditional_false<BlockType>::value,
+                      "Slicing not specialized to LayerType yet.");
+      }
+    }
+  }
+  const Index3D column_block_index = column_block_indices[column_idx];
+  callWithFirstThreadInEachBlock([&]() {
+    for (int i = 0; i < slice_specs.num_slices; i++) {
+      updated[i] = false;
+      cleared[i] = false;
+      esdf_block_ptrs[i] = nullptr;
+      const Index3D esdf_block_index(column_block_index.x(),
+                                     column_block_index.y(),
+                                     slice_specs.output_block_idx_z[i]);
+      auto it = slice_specs.esdf_block_hashes[i].find(esdf_block_index);
+      if (it != slice_specs.esdf_block_hashes[i].end()) {
+        esdf_block_ptrs[i] = it->second;
+      }
+    }
+  });
+
+  __syncthreads();
+
+  // Get the block in the vertical column depending on the current offset.
+  Index3D block_in_column_index = column_block_index;
+  block_in_column_index.z() = min_block_idx_z + vertical_block_idx_offset;
+
+  const BlockType* block_in_column_ptr = nullptr;
+  auto it = input_layer_block_hash.find(block_in_column_index);
+  if (it != input_layer_block_hash.end()) {
+    block_in_column_ptr = it->second;
+  }
+  const FreespaceBlock* freespace_block_ptr = nullptr;
+  if (!freespace_block_hash.empty()) {
+    auto freespace_it = freespace_block_hash.find(block_in_column_index);
+    if (freespace_it != freespace_block_hash.end()) {
+      freespace_block_ptr = freespace_it->second;
+    }
+  }
+
+  if (block_in_column_ptr != nullptr) {
+    for (int i = 0; i < kVoxelsPerSide; i++) {
+      const VoxelType* voxel_ptr =
+          &block_in_column_ptr->voxels[voxel_idx_x][voxel_idx_y][i];
+      if (!site_functor.isVoxelObserved(*voxel_ptr)) {
+        continue;
+      }
+      const bool is_freespace = isVoxelFreespace(
+          freespace_block_ptr, Index3D(voxel_idx_x, voxel_idx_y, i));
+      // Accumulate the voxel into every slice containing it.
+      const int voxel_idx_z = block_in_column_index.z() * kVoxelsPerSide + i;
+      for (int slice_idx = 0; slice_idx < slice_specs.num_slices;
+           slice_idx++) {
+        if (voxel_idx_z < slice_specs.min_voxel_idx_z[slice_idx] ||
+            voxel_idx_z > slice_specs.max_voxel_idx_z[slice_idx]) {
+          continue;
+        }
+        observed[slice_idx][voxel_idx_x][voxel_idx_y] = true;
+        site_functor.updateSquashedExtremumAtomic(
+            *voxel_ptr, is_freespace,
+            &voxel_slices[slice_idx][voxel_idx_x][voxel_idx_y]);
+      }
+    }
+  }
+
+  __syncthreads();
+
+  // Update the output voxel of each slice.
+  if (vertical_block_idx_offset == 0) {
+    // NOTE: As in markSitesInSliceKernel(), freespace is handled in the
+    // squashing.
+    constexpr bool kNotFreespace = false;
+    for (int i = 0; i < slice_specs.num_slices; i++) {
+      if (esdf_block_ptrs[i] == nullptr) {
+        continue;
+      }
+      const VoxelType* voxel_ptr = &voxel_slices[i][voxel_idx_x][voxel_idx_y];
+      EsdfVoxel* esdf_voxel_ptr =
+          &esdf_block_ptrs[i]->voxels[voxel_idx_x][voxel_idx_y]
+                                     [slice_specs.output_voxel_idx_z[i]];
+      updateEsdfVoxelToChanges(voxel_ptr,
+                               observed[i][voxel_idx_x][voxel_idx_y],
+                               kNotFreespace, site_functor,
+                               max_squared_esdf_distance_vox, esdf_voxel_ptr,
+                               &cleared[i], &updated[i]);
+    }
+  }
+
+  __syncthreads();
+  // Output the updated and cleared blocks of each slice.
+  if (voxel_idx_x == 0 && voxel_idx_y == 0 && vertical_block_idx_offset == 0) {
+    for (int i = 0; i < slice_specs.num_slices; i++) {
+      const Index3D esdf_block_index(column_block_index.x(),
+                                     column_block_index.y(),
+                                     slice_specs.output_block_idx_z[i]);
+      if (updated[i]) {
+        updated_vec[i * num_columns + atomicAdd(&updated_vec_sizes[i], 1)] =
+            esdf_block_index;
+      }
+      if (cleared[i]) {
+        to_clear_vec[i * num_columns + atomicAdd(&to_clear_vec_sizes[i], 1)] =
+            esdf_block_index;
+      }
+    }
+  }
+}
+
+template <typename LayerType>
+void EsdfIntegrator::markSitesInSlices(
+    const LayerType& input_layer, const std::vector<Index3D>& block_indices,
+    const std::vector<EsdfSliceSpec>& slice_specs,
+    const FreespaceLayer* freespace_layer_ptr,
+    const std::vector<EsdfLayer*>& esdf_layers,
+    std::vector<std::vector<Index3D>>* updated_blocks_per_slice,
+    std::vector<std::vector<Index3D>>* cleared_blocks_per_slice) {
+  CHECK_NOTNULL(updated_blocks_per_slice);
+  CHECK_NOTNULL(cleared_blocks_per_slice);
+  const int num_slices = static_cast<int>(slice_specs.size());
+  updated_blocks_per_slice->assign(num_slices, std::vector<Index3D>());
+  cleared_blocks_per_slice->assign(num_slices, std::vector<Index3D>());
+
+  const float voxel_size = input_layer.voxel_size();
+  const float block_size = input_layer.block_size();
+  const float max_esdf_distance_vox = max_esdf_distance_m_ / voxel_size;
+  const float max_squared_esdf_distance_vox =
+      max_esdf_distance_vox * max_esdf_distance_vox;
+  constexpr int kVoxelsPerSide = EsdfBlock::kVoxelsPerSide;
+
+  // One column per x,y block index (with the z index set to zero).
+  Index3DSet column_block_indices_set;
+  for (const Index3D& block_index : block_indices) {
+    column_block_indices_set.insert(
+        Index3D(block_index.x(), block_index.y(), 0));
+  }
+  const int num_columns = static_cast<int>(column_block_indices_set.size());
+  block_indices_host_.resizeAsync(num_columns, *cuda_stream_);
+  cuda_stream_->synchronize();
+  int column_idx = 0;
+  for (const Index3D& block_index : column_block_indices_set) {
+    block_indices_host_[column_idx++] = block_index;
+  }
+  block_indices_device_.copyFromAsync(block_indices_host_, *cuda_stream_);
+
+  // Describe the slices and allocate the output blocks of each slice.
+  SliceSpecsDevice slice_specs_device;
+  slice_specs_device.num_slices = num_slices;
+  int min_block_idx_z = std::numeric_limits<int>::max();
+  int max_block_idx_z = std::numeric_limits<int>::lowest();
+  for (int i = 0; i < num_slices; i++) {
+    CHECK_NOTNULL(esdf_layers[i]);
+    const ColumnBounds column_bounds =
+        ConstantZColumnBoundsGetter(slice_specs[i].min_height_m,
+                                    slice_specs[i].max_height_m, block_size)
+            .getColumnBounds(Index2D::Zero(), Index2D::Zero());
+    slice_specs_device.min_voxel_idx_z[i] =
+        column_bounds.min_block_idx_z() * kVoxelsPerSide +
+        column_bounds.min_voxel_idx_z();
+    slice_specs_device.max_voxel_idx_z[i] =
+        column_bounds.max_block_idx_z() * kVoxelsPerSide +
+        column_bounds.max_voxel_idx_z();
+    min_block_idx_z =
+        std::min(min_block_idx_z, column_bounds.min_block_idx_z());
+    max_block_idx_z =
+        std::max(max_block_idx_z, column_bounds.max_block_idx_z());
+
+    std::tie(slice_specs_device.output_block_idx_z[i],
+             slice_specs_device.output_voxel_idx_z[i]) =
+        getBlockAndVoxelIndexFrom1DPositionInLayer(
+            block_size, slice_specs[i].output_height_m);
+    for (const Index3D& block_index : column_block_indices_set) {
+      esdf_layers[i]->allocateBlockAtIndexAsync(
+          Index3D(block_index.x(), block_index.y(),
+                  slice_specs_device.output_block_idx_z[i]),
+          *cuda_stream_);
+    }
+    slice_specs_device.esdf_block_hashes[i] =
+        esdf_layers[i]->getGpuLayerView(*cuda_stream_).getHash().impl_;
+  }
+
+  // Outputs, num_columns entries per slice.
+  slices_updated_indices_device_.resizeAsync(num_slices * num_columns,
+                                             *cuda_stream_);
+  slices_to_clear_indices_device_.resizeAsync(num_slices * num_columns,
+                                              *cuda_stream_);
+  slices_counters_device_.resizeAsync(2 * num_slices, *cuda_stream_);
+  slices_counters_device_.setZeroAsync(*cuda_stream_);
+
+  using BlockType = typename LayerType::BlockType;
+  GPULayerView<BlockType>& input_layer_view =
+      input_layer.getGpuLayerView(*cuda_stream_);
+  Index3DDeviceHashMapType<FreespaceBlock> freespace_hash_map;
+  if (freespace_layer_ptr != nullptr) {
+    freespace_hash_map =
+        freespace_layer_ptr->getGpuLayerView(*cuda_stream_).getHash().impl_;
+  }
+  auto site_functor = getSiteFunctor(input_layer);
+
+  const int num_blocks_in_vertical_column =
+      max_block_idx_z - min_block_idx_z + 1;
+  dim3 dim_threads(kVoxelsPerSide, kVoxelsPerSide,
+                   num_blocks_in_vertical_column);
+  markSitesInSlicesKernel<BlockType>
+      <<<num_columns, dim_threads, 0, *cuda_stream_>>>(
+          block_indices_device_.data(),               // NOLINT
+          input_layer_view.getHash().impl_,           // NOLINT
+          freespace_hash_map,                         // NOLINT
+          slice_specs_device,                         // NOLINT
+          site_functor,                               // NOLINT
+          max_squared_esdf_distance_vox,              // NOLINT
+          min_block_idx_z,                            // NOLINT
+          num_columns,                                // NOLINT
+          slices_updated_indices_device_.data(),      // NOLINT
+          slices_counters_device_.data(),             // NOLINT
+          slices_to_clear_indices_device_.data(),     // NOLINT
+          slices_counters_device_.data() + num_slices);
+  checkCudaErrors(cudaPeekAtLastError());
+
+  // Split the outputs per slice.
+  timing::Timer pack_out_timer("esdf/integrate_slices/mark_sites/pack_out");
+  slices_counters_host_.copyFromAsync(slices_counters_device_, *cuda_stream_);
+  const std::vector<Index3D> updated_indices =
+      slices_updated_indices_device_.toVectorAsync(*cuda_stream_);
+  const std::vector<Index3D> to_clear_indices =
+      slices_to_clear_indices_device_.toVectorAsync(*cuda_stream_);
+  cuda_stream_->synchronize();
+  for (int i = 0; i < num_slices; i++) {
+    const auto updated_begin = updated_indices.begin() + i * num_columns;
+    (*updated_blocks_per_slice)[i].assign(
+        updated_begin, updated_begin + slices_counters_host_[i]);
+    const auto to_clear_begin = to_clear_indices.begin() + i * num_columns;
+    (*cleared_blocks_per_slice)[i].assign(
+        to_clear_begin, to_clear_begin + slices_counters_host_[num_slices + i]);
+  }
+  pack_out_timer.Stop();
+}
+
 __forceinline__ __host__ __device__ void getDirectionAndVoxelIndicesFromThread(
     const dim3 thread_index, Index3D* block_direction, Index3D* voxel_index,
     Index3D* neighbor_voxel_index, int* axis, int* direction) {
@@ -1097,10 +1629,11 @@ __forceinline__ __host__ __device__ void getDirectionAndVoxelIndicesFromThread(
 // lookup (block_hash.find(index)) and stores the resulting block
 // pointer in an array.
 // This kernel also initializes counters to 0.
+template <typename EsdfBlockType>
 __global__ void getBlockPtr(
     const int kNumNeighbors, const int num_blocks,
-    const Index3DDeviceHashMapType<EsdfBlock> block_hash,
-    const Index3D* block_indices, EsdfBlock** block_ptr, int* counters) {
+    const Index3DDeviceHashMapType<EsdfBlockType> block_hash,
+    const Index3D* block_indices, EsdfBlockType** block_ptr, int* counters) {
   int flat_tid = blockIdx.x * blockDim.x + threadIdx.x;
   if (flat_tid >= num_blocks * (1 + kNumNeighbors)) {
     return;
@@ -1132,10 +1665,12 @@ __global__ void getBlockPtr(
 
 // Thread size MUST be 8x8x6, 8x8 being the side of the cube, and 6 being the
 // number of neighbors considered per block. Block size can be whatever.
+template <typename EsdfBlockType>
 __global__ void updateNeighborBandsKernel(
-    int i, int num_blocks, Index3DDeviceHashMapType<EsdfBlock> block_hash,
+    int i, int num_blocks, Index3DDeviceHashMapType<EsdfBlockType> block_hash,
     float max_squared_esdf_distance_vox, Index3D* block_indices,
-    EsdfBlock** block_pointers, Index3D* output_vector, int* updated_size) {
+    EsdfBlockType** block_pointers, Index3D* output_vector,
+    int* updated_size) {
   // Luckily the direction is the same for all processed blocks by this thread.
 
   __shared__ bool block_updated;
@@ -1144,9 +1679,9 @@ __global__ void updateNeighborBandsKernel(
   for (int block_idx = blockIdx.x; block_idx < num_blocks;
        block_idx += gridDim.x) {
     // Get the current block for this... block.
-    EsdfBlock* block_ptr = block_pointers[block_idx];
+    EsdfBlockType* block_ptr = block_pointers[block_idx];
     // Get the neighbor block for this thread.
-    EsdfBlock* neighbor_block_ptr =
+    EsdfBlockType* neighbor_block_ptr =
         block_pointers[block_idx + (i + 1) * num_blocks];
     // This block doesn't exist. Who knows why. This shouldn't happen.
     if (block_ptr == nullptr || neighbor_block_ptr == nullptr) {
@@ -1279,19 +1814,46 @@ __global__ void sortUniqueKernel(Index3D* indices, int* counters) {
   }
 }
 
+// The number of indices sortUniqueKernel() handles in a single thread block.
+// How these are split into threads and items per thread is tuned by the
+// LaunchAutotuner.
+constexpr int kSortUniqueMaxNumIndices = 512;
+
+template <int kNumThreads>
+void launchSortUniqueKernel(Index3D* indices, int* counters,
+                            const CudaStream& cuda_stream) {
+  static_assert(kSortUniqueMaxNumIndices % kNumThreads == 0);
+  sortUniqueKernel<kNumThreads, kSortUniqueMaxNumIndices / kNumThreads>
+      <<<1, kNumThreads, 0, cuda_stream>>>(indices, counters);
+}
+
 void EsdfIntegrator::sortAndTakeUniqueIndices(
     device_vector<Index3D>* block_indices) {
-  constexpr int kNumThreads = 128;
-  constexpr int kNumItemsPerThread = 4;
-
   // speculatively launch this kernel with the assumption that
-  // block_indices->size() < kNumThreads * kNumItemsPerThread
-  sortUniqueKernel<kNumThreads, kNumItemsPerThread>
-      <<<1, kNumThreads, 0, *cuda_stream_>>>(
-          block_indices->data(),  // NOLINT
-          counter_buffer_device_
-              .data());  // 0th element has block_indices->size(),
-                         // and the 1st element is for the new size
+  // block_indices->size() < kSortUniqueMaxNumIndices
+  // NOTE: The 0th element of the counters has block_indices->size(), and the
+  // 1st element is for the new size.
+  const auto launch_kernel = [&](int num_threads) {
+    Index3D* indices = block_indices->data();
+    int* counters = counter_buffer_device_.data();
+    switch (num_threads) {
+      case 64:
+        launchSortUniqueKernel<64>(indices, counters, *cuda_stream_);
+        break;
+      case 256:
+        launchSortUniqueKernel<256>(indices, counters, *cuda_stream_);
+        break;
+      case 512:
+        launchSortUniqueKernel<512>(indices, counters, *cuda_stream_);
+        break;
+      default:
+        launchSortUniqueKernel<128>(indices, counters, *cuda_stream_);
+        break;
+    }
+  };
+  LaunchAutotuner::getInstance().launch("esdf_integrator/sort_unique",
+                                        {64, 128, 256, 512}, 128,
+                                        launch_kernel, *cuda_stream_);
 
   counter_buffer_host_.copyFromAsync(counter_buffer_device_, *cuda_stream_);
   cuda_stream_->synchronize();
@@ -1299,29 +1861,17 @@ void EsdfIntegrator::sortAndTakeUniqueIndices(
   if (counter_buffer_host_[1] != -1) {  // assumption was true
     block_indices->resizeAsync(counter_buffer_host_[1], *cuda_stream_);
   } else {
-    // block_indices->size() >= kNumThreads * kNumItemsPerThread
-    block_indices->resizeAsync(counter_buffer_host_[0], *cuda_stream_);
-    if (counter_buffer_host_[0] == 0) {
-      return;
-    }
-    // sort vertices to bring duplicates together
-    thrust::sort(thrust::device.on(*cuda_stream_), block_indices->begin(),
-                 block_indices->end(), VectorCompare<Index3D>());
-
-    // Find unique vertices and erase redundancies. The iterator will point to
-    // the new last index.
-    auto iterator =
-        thrust::unique(thrust::device.on(*cuda_stream_), block_indices->begin(),
-                       block_indices->end());
-
-    // Figure out the new size.
-    size_t new_size = iterator - block_indices->begin();
-    block_indices->resizeAsync(new_size, *cuda_stream_);
+    // block_indices->size() >= kSortUniqueMaxNumIndices. Fall back to a
+    // device-wide radix sort and unique, which scales to full-map updates.
+    timing::Timer sort_timer("esdf/integrate/compute/sort_unique_device");
+    unique_index_sorter_.sortAndTakeUnique(counter_buffer_host_[0],
+                                           block_indices, *cuda_stream_);
   }
 }
 
+template <typename EsdfLayerType>
 void EsdfIntegrator::updateNeighborBands(
-    device_vector<Index3D>* block_indices, EsdfLayer* esdf_layer,
+    device_vector<Index3D>* block_indices, EsdfLayerType* esdf_layer,
     float max_squared_esdf_distance_vox,
     device_vector<Index3D>* updated_block_indices) {
   if (block_indices->empty()) {
@@ -1338,7 +1888,7 @@ void EsdfIntegrator::updateNeighborBands(
       block_indices->size() * kUpdatedBlockMultiple, *cuda_stream_);
 
   timing::Timer gpu_view("esdf/integrate/compute/neighbor_bands/gpu_view");
-  GPULayerView<EsdfBlock>& gpu_layer_view =
+  GPULayerView<typename EsdfLayerType::BlockType>& gpu_layer_view =
       esdf_layer->getGpuLayerView(*cuda_stream_);
   gpu_view.Stop();
 
@@ -1359,12 +1909,13 @@ void EsdfIntegrator::updateNeighborBands(
   if (temp_storage_size >= 64) {
     num_ctas = (temp_storage_size + 63) / 64;
   }
-  temp_block_pointers_.resizeAsync(temp_storage_size, *cuda_stream_);
+  auto* temp_block_pointers = getTempBlockPointers(*esdf_layer);
+  temp_block_pointers->resizeAsync(temp_storage_size, *cuda_stream_);
   getBlockPtr<<<num_ctas, 64, 0, *cuda_stream_>>>(
       kNumNeighbors, block_indices->size(),  // NOLINT
       gpu_layer_view.getHash().impl_,        // NOLINT
       block_indices->data(),                 // NOLINT
-      temp_block_pointers_.data(),
+      temp_block_pointers->data(),
       counter_buffer_device_.data());  // to initalize it; merged operation
 
   for (int i = 0; i < kNumNeighbors; i++) {
@@ -1373,7 +1924,7 @@ void EsdfIntegrator::updateNeighborBands(
         gpu_layer_view.getHash().impl_,  // NOLINT
         max_squared_esdf_distance_vox,   // NOLINT
         block_indices->data(),           // NOLINT
-        temp_block_pointers_.data(),
+        temp_block_pointers->data(),
         updated_block_indices->data(),  // NOLINT
         counter_buffer_device_.data());
   }
@@ -1387,14 +1938,15 @@ void EsdfIntegrator::updateNeighborBands(
 
 /// Thread size MUST be 8x8xN (where N is a number of blocks up to ???), block
 /// size can be anything.
+template <typename EsdfBlockType>
 __global__ void sweepBlockBandKernel(
-    int num_blocks, Index3DDeviceHashMapType<EsdfBlock> block_hash,
+    int num_blocks, Index3DDeviceHashMapType<EsdfBlockType> block_hash,
     float max_squared_esdf_distance_vox, Index3D* block_indices) {
   // We go one axis at a time, syncing threads in between.
   dim3 thread_index = threadIdx;
   thread_index.z = 0;
 
-  __shared__ EsdfBlock* esdf_block;
+  __shared__ EsdfBlockType* esdf_block;
 
   for (int block_idx = blockIdx.x * blockDim.z + threadIdx.z;
        block_idx < num_blocks; block_idx += gridDim.x * blockDim.z) {
@@ -1430,19 +1982,22 @@ __global__ void sweepBlockBandKernel(
   }
 }
 
+template <typename EsdfLayerType>
 void EsdfIntegrator::sweepBlockBandAsync(device_vector<Index3D>* block_indices,
-                                         EsdfLayer* esdf_layer,
+                                         EsdfLayerType* esdf_layer,
                                          float max_squared_esdf_distance_vox) {
   if (block_indices->empty()) {
     return;
   }
   timing::Timer sweep_timer("esdf/integrate/compute/sweep");
+  timing::GpuTimer sweep_gpu_timer("esdf/integrate/compute/sweep",
+                                   *cuda_stream_);
 
   // Caching.
   constexpr int kVoxelsPerSide = VoxelBlock<bool>::kVoxelsPerSide;
   const int num_blocks = block_indices->size();
 
-  GPULayerView<EsdfBlock>& gpu_layer_view =
+  GPULayerView<typename EsdfLayerType::BlockType>& gpu_layer_view =
       esdf_layer->getGpuLayerView(*cuda_stream_);
 
   // Call the kernel.
@@ -1462,8 +2017,285 @@ void EsdfIntegrator::sweepBlockBandAsync(device_vector<Index3D>* block_indices,
   checkCudaErrors(cudaPeekAtLastError());
 }
 
+// Sentinel of an empty slot in the set of blocks reached by a wavefront. Never
+// a packed block index, because these leave the top bit zero.
+constexpr uint64_t kEmptyWavefrontSetKey = ~0ull;
+
+// Packs a block index into 63 bits, 21 (signed) bits per axis.
+__device__ inline uint64_t packBlockIndex(const Index3D& block_index) {
+  constexpr int64_t kOffset = 1 << 20;
+  constexpr uint64_t kMask = (1ull << 21) - 1;
+  return ((static_cast<uint64_t>(block_index.x() + kOffset) & kMask) << 42) |
+         ((static_cast<uint64_t>(block_index.y() + kOffset) & kMask) << 21) |
+         (static_cast<uint64_t>(block_index.z() + kOffset) & kMask);
+}
+
+// Inserts a block into an open-addressing set. Returns the slot if the block
+// was inserted, and -1 if it already was in the set.
+__device__ inline int insertIntoWavefrontSet(const Index3D& block_index,
+                                             uint64_t* set_keys,
+                                             const int set_capacity) {
+  const uint64_t key = packBlockIndex(block_index);
+  // Fibonacci hashing. The capacity is a power of two.
+  int slot = static_cast<int>((key * 0x9E3779B97F4A7C15ull) >> 32) &
+             (set_capacity - 1);
+  while (true) {
+    const unsigned long long previous_key =
+        atomicCAS(reinterpret_cast<unsigned long long*>(&set_keys[slot]),
+                  kEmptyWavefrontSetKey, key);
+    if (previous_key == kEmptyWavefrontSetKey) {
+      return slot;
+    }
+    if (previous_key == key) {
+      return -1;
+    }
+    slot = (slot + 1) & (set_capacity - 1);
+  }
+}
+
+// Sweeps a single block along all three axes. Called by all threads of a
+// thread block.
+template <typename EsdfBlockType>
+__device__ void sweepBlockBands(const float max_squared_esdf_distance_vox,
+                                EsdfBlockType* esdf_block) {
+  Index3D voxel_index(0, threadIdx.x, threadIdx.y);
+  sweepSingleBand(voxel_index, 0, max_squared_esdf_distance_vox, esdf_block);
+  __syncthreads();
+  voxel_index << threadIdx.x, 0, threadIdx.y;
+  sweepSingleBand(voxel_index, 1, max_squared_esdf_distance_vox, esdf_block);
+  __syncthreads();
+  voxel_index << threadIdx.x, threadIdx.y, 0;
+  sweepSingleBand(voxel_index, 2, max_squared_esdf_distance_vox, esdf_block);
+  __syncthreads();
+}
+
+// Runs the whole propagation of computeEsdf() in a single launch. Each
+// wavefront does the same as an updateNeighborBands() and
+// sweepBlockBandAsync() pair, separated by grid-wide syncs rather than kernel
+// launches. The blocks reached by a wavefront are deduplicated on the fly by
+// inserting them into a set, rather than by sorting.
+// - queues: Two queues of (up to) queue_capacity blocks, the first one holding
+//   the blocks with sites on entry.
+// - queue_sizes: The sizes of the two queues.
+// - block_pointers: 2 * queue_capacity pointers to the blocks in the queues,
+//   followed by kNumNeighbors * queue_capacity pointers to their neighbors.
+// - set_keys: The wavefront set, all kEmptyWavefrontSetKey on entry. Left
+//   empty on exit.
+// - set_slots: The set slot of each block of the next queue.
+// Call Requirements
+// - Cooperative launch, i.e. all thread blocks must be resident.
+// - #Threads: kVoxelsPerSide x kVoxelsPerSide.
+template <typename EsdfBlockType>
+__global__ void propagateEsdfPersistentKernel(
+    const Index3DDeviceHashMapType<EsdfBlockType> block_hash,
+    const float max_squared_esdf_distance_vox, const int queue_capacity,
+    Index3D* queues, int* queue_sizes, EsdfBlockType** block_pointers,
+    uint64_t* set_keys, int* set_slots, const int set_capacity) {
+  constexpr int kNumNeighbors = 6;
+  cooperative_groups::grid_group grid = cooperative_groups::this_grid();
+  const bool is_first_thread = threadIdx.x == 0 && threadIdx.y == 0;
+  EsdfBlockType** neighbor_pointers = block_pointers + 2 * queue_capacity;
+  __shared__ EsdfBlockType* esdf_block;
+  __shared__ bool block_updated;
+
+  // Look up and sweep the blocks with sites.
+  for (int i = blockIdx.x; i < queue_sizes[0]; i += gridDim.x) {
+    if (is_first_thread) {
+      esdf_block = nullptr;
+      auto it = block_hash.find(queues[i]);
+      if (it != block_hash.end()) {
+        esdf_block = it->second;
+      }
+      block_pointers[i] = esdf_block;
+    }
+    __syncthreads();
+    if (esdf_block != nullptr) {
+      sweepBlockBands(max_squared_esdf_distance_vox, esdf_block);
+    }
+    __syncthreads();
+  }
+  grid.sync();
+
+  int current = 0;
+  while (queue_sizes[current] > 0) {
+    const int next = 1 - current;
+    const int num_blocks = queue_sizes[current];
+    const Index3D* frontier = queues + current * queue_capacity;
+    EsdfBlockType** frontier_pointers =
+        block_pointers + current * queue_capacity;
+    Index3D* next_frontier = queues + next * queue_capacity;
+    EsdfBlockType** next_frontier_pointers =
+        block_pointers + next * queue_capacity;
+
+    // Look up the neighbors of the wavefront once.
+    for (int i = grid.thread_rank(); i < num_blocks * kNumNeighbors;
+         i += grid.size()) {
+      const int neighbor = i / num_blocks;
+      Index3D block_direction = Index3D::Zero();
+      block_direction(neighbor / 2) = neighbor % 2 ? -1 : 1;
+      auto it = block_hash.find(frontier[i % num_blocks] + block_direction);
+      neighbor_pointers[i] = (it != block_hash.end()) ? it->second : nullptr;
+    }
+    if (grid.thread_rank() == 0) {
+      queue_sizes[next] = 0;
+    }
+    grid.sync();
+
+    // Copy across the block boundaries, one direction at a time such that no
+    // two blocks write the same neighbor concurrently.
+    for (int neighbor = 0; neighbor < kNumNeighbors; neighbor++) {
+      for (int i = blockIdx.x; i < num_blocks; i += gridDim.x) {
+        EsdfBlockType* block_ptr = frontier_pointers[i];
+        EsdfBlockType* neighbor_block_ptr =
+            neighbor_pointers[neighbor * num_blocks + i];
+        if (block_ptr == nullptr || neighbor_block_ptr == nullptr) {
+          continue;
+        }
+        if (is_first_thread) {
+          block_updated = false;
+        }
+        __syncthreads();
+
+        dim3 specific_thread = threadIdx;
+        specific_thread.z = neighbor;
+        Index3D block_direction, voxel_index, neighbor_voxel_index;
+        int axis, direction;
+        getDirectionAndVoxelIndicesFromThread(
+            specific_thread, &block_direction, &voxel_index,
+            &neighbor_voxel_index, &axis, &direction);
+        if (updateSingleNeighbor(block_ptr, voxel_index, neighbor_voxel_index,
+                                 axis, direction,
+                                 max_squared_esdf_distance_vox,
+                                 neighbor_block_ptr)) {
+          block_updated = true;
+        }
+        __syncthreads();
+        if (is_first_thread && block_updated) {
+          const Index3D neighbor_index = frontier[i] + block_direction;
+          const int slot =
+              insertIntoWavefrontSet(neighbor_index, set_keys, set_capacity);
+          if (slot >= 0) {
+            const int queue_idx = atomicAdd(&queue_sizes[next], 1);
+            next_frontier[queue_idx] = neighbor_index;
+            next_frontier_pointers[queue_idx] = neighbor_block_ptr;
+            set_slots[queue_idx] = slot;
+          }
+        }
+      }
+      grid.sync();
+    }
+
+    // Sweep the blocks reached by the wavefront, and empty the set for the
+    // next one.
+    const int num_next_blocks = queue_sizes[next];
+    for (int i = grid.thread_rank(); i < num_next_blocks; i += grid.size()) {
+      set_keys[set_slots[i]] = kEmptyWavefrontSetKey;
+    }
+    for (int i = blockIdx.x; i < num_next_blocks; i += gridDim.x) {
+      sweepBlockBands(max_squared_esdf_distance_vox,
+                      next_frontier_pointers[i]);
+    }
+    grid.sync();
+    current = next;
+  }
+}
+
+bool EsdfIntegrator::isPersistentKernelSupported() {
+  int device;
+  checkCudaErrors(cudaGetDevice(&device));
+  int supports_cooperative_launch = 0;
+  checkCudaErrors(cudaDeviceGetAttribute(&supports_cooperative_launch,
+                                         cudaDevAttrCooperativeLaunch, device));
+  return supports_cooperative_launch != 0;
+}
+
+template <typename EsdfLayerType>
+void EsdfIntegrator::propagateEsdfPersistent(
+    const device_vector<Index3D>& blocks_with_sites, EsdfLayerType* esdf_layer,
+    const float max_squared_esdf_distance_vox) {
+  using EsdfBlockType = typename EsdfLayerType::BlockType;
+  constexpr int kNumNeighbors = 6;
+  constexpr int kVoxelsPerSide = VoxelBlock<bool>::kVoxelsPerSide;
+  timing::Timer timer("esdf/integrate/compute/persistent");
+  timing::GpuTimer gpu_timer("esdf/integrate/compute/persistent",
+                             *cuda_stream_);
+
+  // Every block in a queue is a distinct, allocated block, so the queues are
+  // bounded by the size of the layer.
+  const int queue_capacity =
+      std::max(static_cast<int>(esdf_layer->numAllocatedBlocks()),
+               static_cast<int>(blocks_with_sites.size()));
+  int set_capacity = 1;
+  while (set_capacity < 2 * queue_capacity) {
+    set_capacity *= 2;
+  }
+  if (persistent_queues_device_.size() <
+      static_cast<size_t>(2 * queue_capacity)) {
+    persistent_queues_device_.resizeAsync(2 * queue_capacity, *cuda_stream_);
+    persistent_set_slots_device_.resizeAsync(queue_capacity, *cuda_stream_);
+  }
+  if (persistent_set_keys_device_.size() != static_cast<size_t>(set_capacity)) {
+    // The kernel leaves the set empty, so it only needs to be initialized
+    // when reallocated.
+    persistent_set_keys_device_.resizeAsync(set_capacity, *cuda_stream_);
+    checkCudaErrors(cudaMemsetAsync(persistent_set_keys_device_.data(), 0xFF,
+                                    set_capacity * sizeof(uint64_t),
+                                    *cuda_stream_));
+  }
+  auto* block_pointers = getTempBlockPointers(*esdf_layer);
+  block_pointers->resizeAsync((2 + kNumNeighbors) * queue_capacity,
+                              *cuda_stream_);
+
+  // The first queue starts out with the blocks with sites.
+  checkCudaErrors(cudaMemcpyAsync(
+      persistent_queues_device_.data(), blocks_with_sites.data(),
+      blocks_with_sites.size() * sizeof(Index3D), cudaMemcpyDefault,
+      *cuda_stream_));
+  counter_buffer_host_[0] = blocks_with_sites.size();
+  counter_buffer_host_[1] = 0;
+  counter_buffer_device_.copyFromAsync(counter_buffer_host_, *cuda_stream_);
+
+  // Launch as many thread blocks as can be resident at once.
+  const dim3 num_threads(kVoxelsPerSide, kVoxelsPerSide, 1);
+  int device;
+  checkCudaErrors(cudaGetDevice(&device));
+  int num_multiprocessors;
+  checkCudaErrors(cudaDeviceGetAttribute(
+      &num_multiprocessors, cudaDevAttrMultiProcessorCount, device));
+  int num_blocks_per_multiprocessor;
+  checkCudaErrors(cudaOccupancyMaxActiveBlocksPerMultiprocessor(
+      &num_blocks_per_multiprocessor,
+      propagateEsdfPersistentKernel<EsdfBlockType>,
+      num_threads.x * num_threads.y, 0));
+  const dim3 num_thread_blocks(
+      std::max(num_blocks_per_multiprocessor * num_multiprocessors, 1));
+
+  GPULayerView<EsdfBlockType>& gpu_layer_view =
+      esdf_layer->getGpuLayerView(*cuda_stream_);
+  Index3DDeviceHashMapType<EsdfBlockType> block_hash =
+      gpu_layer_view.getHash().impl_;
+  float max_squared_distance = max_squared_esdf_distance_vox;
+  int capacity = queue_capacity;
+  Index3D* queues = persistent_queues_device_.data();
+  int* queue_sizes = counter_buffer_device_.data();
+  EsdfBlockType** block_pointers_ptr = block_pointers->data();
+  uint64_t* set_keys = persistent_set_keys_device_.data();
+  int* set_slots = persistent_set_slots_device_.data();
+  void* kernel_args[] = {&block_hash,  &max_squared_distance,
+                         &capacity,    &queues,
+                         &queue_sizes, &block_pointers_ptr,
+                         &set_keys,    &set_slots,
+                         &set_capacity};
+  checkCudaErrors(cudaLaunchCooperativeKernel(
+      reinterpret_cast<void*>(propagateEsdfPersistentKernel<EsdfBlockType>),
+      num_thread_blocks, num_threads, kernel_args, 0, *cuda_stream_));
+  checkCudaErrors(cudaPeekAtLastError());
+}
+
+template <typename EsdfLayerType>
 void EsdfIntegrator::computeEsdf(
-    const device_vector<Index3D>& blocks_with_sites, EsdfLayer* esdf_layer) {
+    const device_vector<Index3D>& blocks_with_sites,
+    EsdfLayerType* esdf_layer) {
   CHECK_NOTNULL(esdf_layer);
 
   if (blocks_with_sites.size() == 0) {
@@ -1476,6 +2308,12 @@ void EsdfIntegrator::computeEsdf(
   const float max_squared_esdf_distance_vox =
       max_esdf_distance_vox * max_esdf_distance_vox;
 
+  if (use_persistent_kernel_) {
+    propagateEsdfPersistent(blocks_with_sites, esdf_layer,
+                            max_squared_esdf_distance_vox);
+    return;
+  }
+
   // First we go over all of the blocks with sites.
   // We compute all the proximal sites inside the block first.
   block_indices_device_.copyFromAsync(blocks_with_sites, *cuda_stream_);
@@ -1519,16 +2357,20 @@ __device__ void getBlockAndVoxelIndexFromOffset(const Index3D& block_index,
   }
 }
 
+// The neighbor_table holds the FullBlockNeighborhood of each block, such
+// that parents in neighboring blocks are found without probing the hash.
+template <typename EsdfBlockType>
 __global__ void clearAllInvalidKernel(
-    Index3D* block_indices, Index3DDeviceHashMapType<EsdfBlock> block_hash,
+    Index3D* block_indices, Index3DDeviceHashMapType<EsdfBlockType> block_hash,
+    const EsdfBlockType* const* neighbor_table,
     float max_squared_esdf_distance_vox, Index3D* output_vector,
     int* updated_size) {
+  using EsdfVoxelType = typename EsdfBlockType::VoxelType;
   __shared__ int block_updated;
   // Allow block size to be whatever.
-  __shared__ EsdfBlock* block_ptr;
+  __shared__ EsdfBlockType* block_ptr;
   // Get the current block for this... block.
   Index3D block_index = block_indices[blockIdx.x];
-  Index3D voxel_index = Index3D(threadIdx.x, threadIdx.y, threadIdx.z);
   if (threadIdx.x == 0 && threadIdx.y == 0 && threadIdx.z == 0) {
     block_ptr = nullptr;
     auto it = block_hash.find(block_index);
@@ -1543,40 +2385,49 @@ __global__ void clearAllInvalidKernel(
     return;
   }
 
-  // Now for our specific voxel we should look up its parent and see if it's
-  // still there.
-  EsdfVoxel* esdf_voxel =
-      &block_ptr->voxels[voxel_index.x()][voxel_index.y()][voxel_index.z()];
-
-  if (esdf_voxel->observed && !esdf_voxel->is_site &&
-      esdf_voxel->parent_direction != Index3D::Zero()) {
-    Index3D neighbor_block_index, neighbor_voxel_index;
-    getBlockAndVoxelIndexFromOffset(
-        block_index, voxel_index, esdf_voxel->parent_direction,
-        &neighbor_block_index, &neighbor_voxel_index);
-
-    EsdfVoxel* neighbor_voxel = nullptr;
-    if (neighbor_block_index == block_index) {
-      neighbor_voxel =
-          &block_ptr->voxels[neighbor_voxel_index.x()][neighbor_voxel_index.y()]
-                            [neighbor_voxel_index.z()];
-    } else {
-      // Get the neighboring block.
-      auto it = block_hash.find(neighbor_block_index);
-      if (it != block_hash.end()) {
+  forEachVoxelInThread([&](const Index3D& voxel_index) {
+    // Now for our specific voxel we should look up its parent and see if it's
+    // still there.
+    EsdfVoxelType* esdf_voxel =
+        &block_ptr->voxels[voxel_index.x()][voxel_index.y()][voxel_index.z()];
+
+    if (isObserved(*esdf_voxel) && !isSite(*esdf_voxel) &&
+        hasParentDirection(*esdf_voxel)) {
+      Index3D neighbor_block_index, neighbor_voxel_index;
+      getBlockAndVoxelIndexFromOffset(
+          block_index, voxel_index, getParentDirection(*esdf_voxel),
+          &neighbor_block_index, &neighbor_voxel_index);
+
+      const EsdfVoxelType* neighbor_voxel = nullptr;
+      const Index3D block_offset = neighbor_block_index - block_index;
+      const EsdfBlockType* neighbor_block_ptr = nullptr;
+      if (FullBlockNeighborhood::isInNeighborhood(block_offset)) {
+        const int neighbor_idx =
+            FullBlockNeighborhood::indexFromOffset(block_offset);
+        neighbor_block_ptr =
+            neighbor_table[blockIdx.x * FullBlockNeighborhood::kNumNeighbors +
+                           neighbor_idx];
+      } else {
+        // Parents further away are rare, so we probe the hash for them.
+        auto it = block_hash.find(neighbor_block_index);
+        if (it != block_hash.end()) {
+          neighbor_block_ptr = it->second;
+        }
+      }
+      if (neighbor_block_ptr != nullptr) {
         neighbor_voxel =
-            &it->second
+            &neighbor_block_ptr
                  ->voxels[neighbor_voxel_index.x()][neighbor_voxel_index.y()]
                          [neighbor_voxel_index.z()];
       }
+      if (neighbor_voxel == nullptr || !isSite(*neighbor_voxel)) {
+        // Clear this voxel.
+        setParentDirection(Index3D::Zero(), esdf_voxel);
+        esdf_voxel->squared_distance_vox = max_squared_esdf_distance_vox;
+        block_updated = true;
+      }
     }
-    if (neighbor_voxel == nullptr || !neighbor_voxel->is_site) {
-      // Clear this voxel.
-      esdf_voxel->parent_direction.setZero();
-      esdf_voxel->squared_distance_vox = max_squared_esdf_distance_vox;
-      block_updated = true;
-    }
-  }
+  });
   __syncthreads();
   if ((threadIdx.x == 0 && threadIdx.y == 0 && threadIdx.z == 0) &&
       block_updated) {
@@ -1584,8 +2435,9 @@ __global__ void clearAllInvalidKernel(
   }
 }
 
+template <typename EsdfLayerType>
 void EsdfIntegrator::clearAllInvalid(
-    const std::vector<Index3D>& blocks_to_clear, EsdfLayer* esdf_layer,
+    const std::vector<Index3D>& blocks_to_clear, EsdfLayerType* esdf_layer,
     device_vector<Index3D>* updated_blocks) {
   if (blocks_to_clear.size() == 0) {
     return;
@@ -1611,7 +2463,7 @@ void EsdfIntegrator::clearAllInvalid(
   temp_indices_device_.copyFromAsync(temp_indices_host_, *cuda_stream_);
 
   // Get the hash map of the whole ESDF map.
-  GPULayerView<EsdfBlock>& gpu_layer_view =
+  GPULayerView<typename EsdfLayerType::BlockType>& gpu_layer_view =
       esdf_layer->getGpuLayerView(*cuda_stream_);
 
   // Create an output variable.
@@ -1625,12 +2477,17 @@ void EsdfIntegrator::clearAllInvalid(
   updated_blocks->resizeAsync(temp_indices_device_.size(), *cuda_stream_);
 
   // Call a kernel.
-  dim3 dim_threads(kVoxelsPerSide, kVoxelsPerSide, kVoxelsPerSide);
+  const dim3 dim_threads = voxelBlockThreadsPerBlock();
   if (temp_indices_device_.size() > 0) {
+    auto* neighbor_table = getTempNeighborTable(*esdf_layer);
+    buildBlockNeighborTableAsync(
+        temp_indices_device_.size(), temp_indices_device_.data(),
+        gpu_layer_view.getHash().impl_, neighbor_table, *cuda_stream_);
     clearAllInvalidKernel<<<temp_indices_device_.size(), dim_threads, 0,
                             *cuda_stream_>>>(
         temp_indices_device_.data(),     // NOLINT
         gpu_layer_view.getHash().impl_,  // NOLINT
+        neighbor_table->data(),          // NOLINT
         max_squared_esdf_distance_vox,   // NOLINT
         updated_blocks->data(),          // NOLINT
         updated_counter_device_.get());
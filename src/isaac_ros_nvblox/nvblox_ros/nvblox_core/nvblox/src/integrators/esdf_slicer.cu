@@ -15,6 +15,8 @@ limitations under the License.
 */
 #include "nvblox/integrators/esdf_slicer.h"
 
+#include <algorithm>
+
 #include "nvblox/geometry/bounding_boxes.h"
 #include "nvblox/gpu_hash/internal/cuda/gpu_hash_interface.cuh"
 #include "nvblox/utils/timing.h"
@@ -34,10 +36,11 @@ __global__ void populateSliceFromLayerKernel(
   }
 
   // Figure out where this pixel should map to.
-  // Get voxel centers by adding half a voxel size.
+  // Get pixel centers by adding half a pixel size. These are the voxel centers
+  // unless the layer is coarser than the slice.
   Vector3f voxel_position(
-      aabb.min().x() + voxel_size / 2.0f + resolution * pixel_col,
-      aabb.min().y() + voxel_size / 2.0f + resolution * pixel_row,
+      aabb.min().x() + resolution / 2.0f + resolution * pixel_col,
+      aabb.min().y() + resolution / 2.0f + resolution * pixel_row,
       slice_height);
 
   Index3D block_index, voxel_index;
@@ -91,7 +94,7 @@ AxisAlignedBoundingBox EsdfSlicer::getAabbOfLayerAtHeight(
   // Get a bounding box for the whole layer
   AxisAlignedBoundingBox aabb;
   aabb.setEmpty();
-  for (const Index3D& block_index : layer.getAllBlockIndices()) {
+  for (const Index3D& block_index : layer.getAllBlockIndicesCached()) {
     // Skip all other heights of block.
     if (block_index.z() != desired_z_block_index.z()) {
       continue;
@@ -113,6 +116,34 @@ AxisAlignedBoundingBox EsdfSlicer::getCombinedAabbOfLayersAtHeight(
   return aabb_1.merged(aabb_2);
 }
 
+AxisAlignedBoundingBox EsdfSlicer::getAabbAroundPosition(
+    const Vector3f& center, const float side_length_m, const float voxel_size,
+    const float slice_height) {
+  CHECK_GT(side_length_m, 0.0f);
+  CHECK_GT(voxel_size, 0.0f);
+  // The same number of voxels at every position.
+  const int num_voxels =
+      static_cast<int>(std::ceil(side_length_m / voxel_size));
+  const Vector2f min_xy =
+      ((center.head<2>() / voxel_size).array() - num_voxels / 2.0f)
+          .floor()
+          .matrix() *
+      voxel_size;
+  const Vector2f max_xy = min_xy + Vector2f::Constant(num_voxels * voxel_size);
+  return AxisAlignedBoundingBox(Vector3f(min_xy.x(), min_xy.y(), slice_height),
+                                Vector3f(max_xy.x(), max_xy.y(), slice_height));
+}
+
+Index2D EsdfSlicer::getSliceImageSize(const AxisAlignedBoundingBox& aabb,
+                                      const float voxel_size) {
+  // Tolerate rounding errors in AABBs which are multiples of the voxel size,
+  // which would otherwise add a column or row depending on where they are.
+  constexpr float kToleranceVox = 1e-3f;
+  const Vector3f size_vox = aabb.sizes() / voxel_size;
+  return Index2D(static_cast<int>(std::ceil(size_vox.y() - kToleranceVox)),
+                 static_cast<int>(std::ceil(size_vox.x() - kToleranceVox)));
+}
+
 void EsdfSlicer::sliceLayerToDistanceImage(const EsdfLayer& layer,
                                            float slice_height,
                                            float unobserved_value,
@@ -127,13 +158,10 @@ void EsdfSlicer::sliceLayerToDistanceImage(const EsdfLayer& layer,
   constexpr int kVoxelsPerSide = VoxelBlock<EsdfVoxel>::kVoxelsPerSide;
   const float voxel_size = block_size / kVoxelsPerSide;
 
-  Vector3f bounding_size = aabb.sizes();
-  // Width = cols, height = rows
-  int width = static_cast<int>(std::ceil(bounding_size.x() / voxel_size));
-  int height = static_cast<int>(std::ceil(bounding_size.y() / voxel_size));
+  const Index2D image_size = getSliceImageSize(aabb, voxel_size);
 
   // Create an image on the device to fit the aabb.
-  Image<float> image(height, width, MemoryType::kDevice);
+  Image<float> image(image_size[0], image_size[1], MemoryType::kDevice);
 
   // Fill in the float image.
   populateSliceFromLayer(layer, aabb, slice_height, unobserved_value,
@@ -149,13 +177,23 @@ void EsdfSlicer::sliceLayersToCombinedDistanceImage(
     float unobserved_value, const AxisAlignedBoundingBox& aabb,
     Image<float>* output_image) {
   CHECK_NOTNULL(output_image);
-  CHECK_EQ(layer_1.voxel_size(), layer_2.voxel_size());
-
-  Image<float> slice_image_1(MemoryType::kDevice);
-  sliceLayerToDistanceImage(layer_1, layer_1_slice_height, unobserved_value,
-                            aabb, &slice_image_1);
-  sliceLayerToDistanceImage(layer_2, layer_2_slice_height, unobserved_value,
-                            aabb, output_image);
+  if (aabb.isEmpty()) {
+    return;
+  }
+  timing::Timer slice_layers_timer("/esdf_slicer/slice_layers");
+
+  // The layers may have different voxel sizes (e.g. a coarse foreground
+  // layer). The slice has the resolution of the finer layer, and the coarser
+  // layer is sampled at its pixels.
+  const float resolution = std::min(layer_1.voxel_size(), layer_2.voxel_size());
+  const Index2D image_size = getSliceImageSize(aabb, resolution);
+  Image<float> slice_image_1(image_size[0], image_size[1], MemoryType::kDevice);
+  Image<float> slice_image_2(image_size[0], image_size[1], MemoryType::kDevice);
+  populateSliceFromLayer(layer_1, aabb, layer_1_slice_height, unobserved_value,
+                         resolution, &slice_image_1);
+  populateSliceFromLayer(layer_2, aabb, layer_2_slice_height, unobserved_value,
+                         resolution, &slice_image_2);
+  *output_image = std::move(slice_image_2);
 
   // Get the minimal distance between the two slices
   image::elementWiseMinInPlaceGPUAsync(slice_image_1, output_image,
@@ -173,10 +211,9 @@ void EsdfSlicer::populateSliceFromLayer(const EsdfLayer& layer,
       << "Output needs to be accessible on device";
   // NOTE(alexmillane): At the moment we assume that the image is pre-allocated
   // to be the right size.
-  CHECK_EQ(output_image->rows(),
-           static_cast<int>(std::ceil(aabb.sizes().y() / resolution)));
-  CHECK_EQ(output_image->cols(),
-           static_cast<int>(std::ceil(aabb.sizes().x() / resolution)));
+  const Index2D image_size = getSliceImageSize(aabb, resolution);
+  CHECK_EQ(output_image->rows(), image_size[0]);
+  CHECK_EQ(output_image->cols(), image_size[1]);
   if (output_image->numel() <= 0) {
     return;
   }
@@ -15,14 +15,21 @@ limitations under the License.
 */
 #include "nvblox/integrators/freespace_integrator.h"
 
+#include "nvblox/core/hash.h"
 #include "nvblox/gpu_hash/internal/cuda/gpu_hash_interface.cuh"
 #include "nvblox/gpu_hash/internal/cuda/gpu_indexing.cuh"
 #include "nvblox/integrators/internal/cuda/projective_integrators_common.cuh"
 #include "nvblox/integrators/internal/integrators_common.h"
+#include "nvblox/utils/gpu_timing.h"
 #include "nvblox/utils/timing.h"
 
 namespace nvblox {
 
+// The freespace kernels use one thread and one shared memory voxel per (padded)
+// voxel of a block. This only fits within the CUDA limits for 8x8x8 blocks,
+// so the freespace integrator is unavailable for other block sizes.
+#if NVBLOX_VOXELS_PER_SIDE == 8
+
 constexpr int kMaxPaddingSize = 1;
 constexpr int kMaxNumThreads1D =
     TsdfBlock::kVoxelsPerSide + 2 * kMaxPaddingSize;
@@ -238,8 +245,8 @@ __device__ bool isVoxelFree(const FreespaceVoxel& freespace_voxel,
                             Time min_duration_since_occupied_for_freespace_ms) {
   return tsdf_voxel.weight > 1e-6 &&
          (freespace_voxel.last_occupied_timestamp_ms != Time(0)) &&
-         freespace_voxel.last_occupied_timestamp_ms <=
-             current_time_ms - min_duration_since_occupied_for_freespace_ms;
+         freespace_voxel.timeSinceLastOccupied(current_time_ms) >=
+             min_duration_since_occupied_for_freespace_ms;
 }
 // Return true if all voxels in a neighborhood are free.
 template <int PaddingSize>
@@ -299,6 +306,7 @@ __global__ void __launch_bounds__(kMaxPaddedKernelThreadNum)
         const Camera camera, const Transform T_C_L,
         DepthImageConstView depth_image, float max_view_distance_m,
         float truncation_distance_m, float block_size_m,
+        const int* in_view_mask_indices, const VoxelBlockMask* in_view_masks,
         Index3DDeviceHashMapType<FreespaceBlock> freespace_block_hash) {
   // This kernel implements the freespace update as described in the
   // dynablox paper (https://ieeexplore.ieee.org/document/10218983).
@@ -348,10 +356,20 @@ __global__ void __launch_bounds__(kMaxPaddedKernelThreadNum)
   bool update_voxel = true;
   if (do_viewpoint_exclusion) {
     assert(depth_image.dataConstPtr() != nullptr);
-    const bool in_view = doesVoxelHaveDepthMeasurement(
-        block_index, voxel_index, camera, depth_image.dataConstPtr(),
-        depth_image.rows(), depth_image.cols(), T_C_L, block_size_m,
-        max_view_distance_m, truncation_distance_m);
+    // Use the view test precomputed during TSDF integration, if available.
+    // The masks only cover the voxels inside the block, so padded voxels are
+    // always projected.
+    const int mask_index =
+        (in_view_masks != nullptr) ? in_view_mask_indices[blockIdx.x] : -1;
+    bool in_view;
+    if (mask_index >= 0 && tsdf_block_padded.isWithinBlockBounds(voxel_index)) {
+      in_view = in_view_masks[mask_index].isSet(voxelBlockMaskBit(voxel_index));
+    } else {
+      in_view = doesVoxelHaveDepthMeasurement(
+          block_index, voxel_index, camera, depth_image.dataConstPtr(),
+          depth_image.rows(), depth_image.cols(), T_C_L, block_size_m,
+          max_view_distance_m, truncation_distance_m);
+    }
     // If not in view, don't run updates.
     if (!in_view) {
       update_voxel = false;
@@ -384,8 +402,7 @@ __global__ void __launch_bounds__(kMaxPaddedKernelThreadNum)
       // Note: We use the last_occupied_timestamp_ms from the last update here
       // to start counting the consecutive_occupancy_duration_ms from 0 ms when
       // a voxel was seen occupied. Dynablox Eq. (9)
-      if (current_update_time_ms -
-              freespace_voxel->last_occupied_timestamp_ms <=
+      if (freespace_voxel->timeSinceLastOccupied(current_update_time_ms) <=
           max_unobserved_to_keep_consecutive_occupancy_ms) {
         // Voxel was occupied lately
         freespace_voxel->consecutive_occupancy_duration_ms +=
@@ -451,6 +468,67 @@ __global__ void __launch_bounds__(kMaxPaddedKernelThreadNum)
   }
 }
 
+// Return true if the freespace update below leaves the voxel unchanged, and
+// keeps doing so until the TSDF marks the voxel occupied again:
+// * Voxel is initialized and high confidence freespace
+// * Consecutive occupancy is reset, and stays reset because the voxel hasn't
+//   been occupied for max_unobserved_to_keep_consecutive_occupancy_ms
+// * The reset threshold isn't reached by a reset consecutive occupancy
+// * The corresponding TSDF voxel is not occupied
+__device__ bool isVoxelSettled(
+    const FreespaceVoxel& freespace_voxel, const TsdfVoxel& tsdf_voxel,
+    Time current_time_ms, float max_tsdf_distance_for_occupancy_m,
+    Time max_unobserved_to_keep_consecutive_occupancy_ms,
+    Time min_consecutive_occupancy_duration_for_reset_ms) {
+  return freespace_voxel.is_high_confidence_freespace &&
+         (freespace_voxel.last_occupied_timestamp_ms != Time(0)) &&
+         static_cast<Time>(freespace_voxel.consecutive_occupancy_duration_ms) ==
+             Time(0) &&
+         freespace_voxel.timeSinceLastOccupied(current_time_ms) >
+             max_unobserved_to_keep_consecutive_occupancy_ms &&
+         min_consecutive_occupancy_duration_for_reset_ms > Time(0) &&
+         tsdf_voxel.distance > max_tsdf_distance_for_occupancy_m;
+}
+
+// Kernel flagging the blocks which are not settled, i.e. which have a voxel
+// that the freespace update could change.
+// Expected launch parameters:
+//   num_blocks: Number of blocks to check
+//   num_threads_per_block: dim3(a, a, a) where a = voxels_per_side
+__global__ void flagBlocksToUpdateKernel(
+    const Index3DDeviceHashMapType<TsdfBlock> tsdf_block_hash,
+    const Index3DDeviceHashMapType<FreespaceBlock> freespace_block_hash,
+    const Index3D* block_indices, float max_tsdf_distance_for_occupancy_m,
+    Time max_unobserved_to_keep_consecutive_occupancy_ms,
+    Time min_consecutive_occupancy_duration_for_reset_ms,
+    Time current_update_time_ms, bool* update_flags) {
+  __shared__ const TsdfBlock* tsdf_block_ptr;
+  __shared__ const FreespaceBlock* freespace_block_ptr;
+  if (threadIdx.x == 0 && threadIdx.y == 0 && threadIdx.z == 0) {
+    const Index3D& block_index = block_indices[blockIdx.x];
+    tsdf_block_ptr = getBlockPtr(tsdf_block_hash, block_index);
+    freespace_block_ptr = getBlockPtr(freespace_block_hash, block_index);
+  }
+  __syncthreads();
+
+  // NOTE: Same voxel order as in the update kernel.
+  bool is_settled = false;
+  if (tsdf_block_ptr != nullptr && freespace_block_ptr != nullptr) {
+    is_settled = isVoxelSettled(
+        freespace_block_ptr->voxels[threadIdx.z][threadIdx.y][threadIdx.x],
+        tsdf_block_ptr->voxels[threadIdx.z][threadIdx.y][threadIdx.x],
+        current_update_time_ms, max_tsdf_distance_for_occupancy_m,
+        max_unobserved_to_keep_consecutive_occupancy_ms,
+        min_consecutive_occupancy_duration_for_reset_ms);
+  }
+  const bool is_block_settled = __syncthreads_and(is_settled);
+  if (threadIdx.x == 0 && threadIdx.y == 0 && threadIdx.z == 0) {
+    update_flags[blockIdx.x] = !is_block_settled;
+  }
+}
+
+#endif  // NVBLOX_VOXELS_PER_SIDE == 8
+
 FreespaceIntegrator::FreespaceIntegrator()
     : FreespaceIntegrator(std::make_shared<CudaStreamOwning>()) {}
 
@@ -492,6 +570,10 @@ Time FreespaceIntegrator::min_consecutive_occupancy_duration_for_reset_ms()
 
 void FreespaceIntegrator::min_consecutive_occupancy_duration_for_reset_ms(
     Time value) {
+#ifdef NVBLOX_COMPACT_FREESPACE_VOXEL
+  // Longer durations saturate, such that the reset would never happen.
+  CHECK_LE(value, Time(CompactDuration::kMaxValue));
+#endif
   min_consecutive_occupancy_duration_for_reset_ms_ = value;
 }
 
@@ -503,6 +585,29 @@ void FreespaceIntegrator::check_neighborhood(bool value) {
   check_neighborhood_ = value;
 }
 
+bool FreespaceIntegrator::skip_settled_blocks() const {
+  return skip_settled_blocks_;
+}
+
+void FreespaceIntegrator::skip_settled_blocks(bool value) {
+  skip_settled_blocks_ = value;
+}
+
+size_t FreespaceIntegrator::num_skipped_blocks() const {
+  return num_skipped_blocks_;
+}
+
+ScratchArena* FreespaceIntegrator::scratch_arena() const {
+  return scratch_arena_;
+}
+
+void FreespaceIntegrator::scratch_arena(ScratchArena* scratch_arena) {
+  scratch_arena_ = scratch_arena;
+  if (scratch_arena_ != nullptr) {
+    in_view_mask_indices_device_.clearAndDeallocateAsync(*cuda_stream_);
+  }
+}
+
 parameters::ParameterTreeNode FreespaceIntegrator::getParameterTree(
     const std::string& name_remap) const {
   const std::string name =
@@ -526,9 +631,12 @@ parameters::ParameterTreeNode FreespaceIntegrator::getParameterTree(
                             min_consecutive_occupancy_duration_for_reset_ms_,
                             time_to_string),
           ParameterTreeNode("check_neighborhood:", check_neighborhood_),
+          ParameterTreeNode("skip_settled_blocks:", skip_settled_blocks_),
       });
 }
 
+#if NVBLOX_VOXELS_PER_SIDE == 8
+
 // This function just:
 // - Returns a bool indicating if viewpoint exclusion should be run, and
 // - breaks apart the viewpoint into types which can be passed to the kernel,
@@ -574,7 +682,7 @@ auto get_viewpoint_or_defaults(
 void FreespaceIntegrator::launchNonPaddedKernel(
     Time update_time_ms, const TsdfLayer& tsdf_layer,
     const std::optional<ViewBasedInclusionData>& maybe_view,
-    FreespaceLayer* freespace_layer_ptr) {
+    const VoxelBlockMask* in_view_masks, FreespaceLayer* freespace_layer_ptr) {
   const dim3 kThreadsPerBlock(TsdfBlock::kVoxelsPerSide,
                               TsdfBlock::kVoxelsPerSide,
                               TsdfBlock::kVoxelsPerSide);
@@ -605,6 +713,8 @@ void FreespaceIntegrator::launchNonPaddedKernel(
           T_L_C.inverse(),                                            // NOLINT
           depth_image, max_view_distance_m, truncation_distance_m,    // NOLINT
           freespace_layer_ptr->block_size(),                          // NOLINT
+          in_view_mask_indices_device_ptr_,                           // NOLINT
+          in_view_masks,                                              // NOLINT
           freespace_layer_ptr->getGpuLayerView(*cuda_stream_).getHash().impl_);
   checkCudaErrors(cudaPeekAtLastError());
 }
@@ -612,7 +722,7 @@ void FreespaceIntegrator::launchNonPaddedKernel(
 void FreespaceIntegrator::launchPaddedKernel(
     Time update_time_ms, const TsdfLayer& tsdf_layer,
     const std::optional<ViewBasedInclusionData>& maybe_view,
-    FreespaceLayer* freespace_layer_ptr) {
+    const VoxelBlockMask* in_view_masks, FreespaceLayer* freespace_layer_ptr) {
   constexpr int kPaddingSize = 1;
   constexpr int kNumThreads1D = TsdfBlock::kVoxelsPerSide + 2 * kPaddingSize;
   const dim3 kThreadsPerBlock(kNumThreads1D, kNumThreads1D, kNumThreads1D);
@@ -645,6 +755,8 @@ void FreespaceIntegrator::launchPaddedKernel(
           max_view_distance_m,                                        // NOLINT
           truncation_distance_m,                                      // NOLINT
           freespace_layer_ptr->block_size(),                          // NOLINT
+          in_view_mask_indices_device_ptr_,                           // NOLINT
+          in_view_masks,                                              // NOLINT
           freespace_layer_ptr->getGpuLayerView(*cuda_stream_)
               .getHash()
               .impl_  // NOLINT
@@ -652,11 +764,116 @@ void FreespaceIntegrator::launchPaddedKernel(
   checkCudaErrors(cudaPeekAtLastError());
 }
 
+void FreespaceIntegrator::removeSettledBlocks(
+    Time update_time_ms, const TsdfLayer& tsdf_layer,
+    const FreespaceLayer& freespace_layer) {
+  const int num_blocks = block_indices_to_update_device_.size();
+  update_flags_device_.resizeAsync(num_blocks, *cuda_stream_);
+  const dim3 kThreadsPerBlock(TsdfBlock::kVoxelsPerSide,
+                              TsdfBlock::kVoxelsPerSide,
+                              TsdfBlock::kVoxelsPerSide);
+  flagBlocksToUpdateKernel<<<num_blocks, kThreadsPerBlock, 0, *cuda_stream_>>>(
+      tsdf_layer.getGpuLayerView(*cuda_stream_).getHash().impl_,
+      freespace_layer.getGpuLayerView(*cuda_stream_).getHash().impl_,
+      block_indices_to_update_device_.data(),
+      max_tsdf_distance_for_occupancy_m_,
+      max_unobserved_to_keep_consecutive_occupancy_ms_,
+      min_consecutive_occupancy_duration_for_reset_ms_, update_time_ms,
+      update_flags_device_.data());
+  checkCudaErrors(cudaPeekAtLastError());
+  update_flags_host_.copyFromAsync(update_flags_device_, *cuda_stream_);
+  cuda_stream_->synchronize();
+
+  // Compact the remaining blocks in place.
+  size_t num_remaining_blocks = 0;
+  for (size_t i = 0; i < update_flags_host_.size(); i++) {
+    if (update_flags_host_[i]) {
+      block_indices_to_update_host_[num_remaining_blocks++] =
+          block_indices_to_update_host_[i];
+    }
+  }
+  num_skipped_blocks_ = update_flags_host_.size() - num_remaining_blocks;
+  if (num_skipped_blocks_ == 0) {
+    return;
+  }
+  block_indices_to_update_host_.resizeAsync(num_remaining_blocks,
+                                            *cuda_stream_);
+  block_indices_to_update_device_.copyFromAsync(block_indices_to_update_host_,
+                                                *cuda_stream_);
+}
+
+#else  // NVBLOX_VOXELS_PER_SIDE == 8
+
+void FreespaceIntegrator::launchNonPaddedKernel(
+    Time, const TsdfLayer&, const std::optional<ViewBasedInclusionData>&,
+    const VoxelBlockMask*, FreespaceLayer*) {
+  LOG(FATAL) << "The freespace integrator requires 8x8x8 voxel blocks.";
+}
+
+void FreespaceIntegrator::launchPaddedKernel(
+    Time, const TsdfLayer&, const std::optional<ViewBasedInclusionData>&,
+    const VoxelBlockMask*, FreespaceLayer*) {
+  LOG(FATAL) << "The freespace integrator requires 8x8x8 voxel blocks.";
+}
+
+void FreespaceIntegrator::removeSettledBlocks(Time, const TsdfLayer&,
+                                              const FreespaceLayer&) {
+  LOG(FATAL) << "The freespace integrator requires 8x8x8 voxel blocks.";
+}
+
+#endif  // NVBLOX_VOXELS_PER_SIDE == 8
+
+const VoxelBlockMask* FreespaceIntegrator::prepareInViewMasks(
+    const std::optional<ViewBasedInclusionData>& view,
+    const std::optional<InViewVoxelMasks>& in_view_voxel_masks) {
+  in_view_mask_indices_device_ptr_ = nullptr;
+  if (!view.has_value() || !in_view_voxel_masks.has_value()) {
+    return nullptr;
+  }
+  const std::vector<Index3D>& mask_block_indices =
+      *CHECK_NOTNULL(in_view_voxel_masks.value().block_indices);
+  const device_vector<VoxelBlockMask>& masks_device =
+      *CHECK_NOTNULL(in_view_voxel_masks.value().masks_device);
+  if (mask_block_indices.empty() ||
+      mask_block_indices.size() != masks_device.size()) {
+    return nullptr;
+  }
+
+  Index3DHashMapType<int>::type mask_index_map;
+  mask_index_map.reserve(mask_block_indices.size());
+  for (size_t i = 0; i < mask_block_indices.size(); i++) {
+    mask_index_map.emplace(mask_block_indices[i], static_cast<int>(i));
+  }
+  in_view_mask_indices_host_.resizeAsync(block_indices_to_update_host_.size(),
+                                         *cuda_stream_);
+  // Wait for a (potential) reallocation before writing on the host.
+  cuda_stream_->synchronize();
+  for (size_t i = 0; i < block_indices_to_update_host_.size(); i++) {
+    const auto it = mask_index_map.find(block_indices_to_update_host_[i]);
+    in_view_mask_indices_host_[i] =
+        (it != mask_index_map.end()) ? it->second : -1;
+  }
+  if (scratch_arena_ != nullptr) {
+    in_view_mask_indices_device_ptr_ = scratch_arena_->allocateAsync<int>(
+        in_view_mask_indices_host_.size(), *cuda_stream_);
+    checkCudaErrors(cudaMemcpyAsync(
+        in_view_mask_indices_device_ptr_, in_view_mask_indices_host_.data(),
+        sizeof(int) * in_view_mask_indices_host_.size(),
+        cudaMemcpyHostToDevice, *cuda_stream_));
+  } else {
+    in_view_mask_indices_device_.copyFromAsync(in_view_mask_indices_host_,
+                                               *cuda_stream_);
+    in_view_mask_indices_device_ptr_ = in_view_mask_indices_device_.data();
+  }
+  return masks_device.data();
+}
+
 void FreespaceIntegrator::updateFreespaceLayer(
     const std::vector<Index3D>& block_indices_to_update, Time update_time_ms,
     const TsdfLayer& tsdf_layer,
     const std::optional<ViewBasedInclusionData>& view,
-    FreespaceLayer* freespace_layer_ptr) {
+    FreespaceLayer* freespace_layer_ptr,
+    const std::optional<InViewVoxelMasks>& in_view_voxel_masks) {
   timing::Timer integration_timer("freespace/integrate");
 
   // Check inputs
@@ -675,6 +892,8 @@ void FreespaceIntegrator::updateFreespaceLayer(
   allocate_timer.Stop();
 
   timing::Timer update_timer("freespace/integrate/update_blocks");
+  timing::GpuTimer update_gpu_timer("freespace/integrate/update_blocks",
+                                    *cuda_stream_);
 
   // Expand the buffers when needed
   if (num_block_to_update > block_indices_to_update_device_.capacity()) {
@@ -688,10 +907,24 @@ void FreespaceIntegrator::updateFreespaceLayer(
                                 &block_indices_to_update_host_,
                                 &block_indices_to_update_device_);
 
+  // Skip the blocks the update would leave unchanged.
+  num_skipped_blocks_ = 0;
+  if (skip_settled_blocks_) {
+    removeSettledBlocks(update_time_ms, tsdf_layer, *freespace_layer_ptr);
+  }
+  if (block_indices_to_update_host_.empty()) {
+    last_update_time_ms_ = update_time_ms;
+    return;
+  }
+
+  const VoxelBlockMask* in_view_masks =
+      prepareInViewMasks(view, in_view_voxel_masks);
+
   if (check_neighborhood_) {
-    launchPaddedKernel(update_time_ms, tsdf_layer, view, freespace_layer_ptr);
+    launchPaddedKernel(update_time_ms, tsdf_layer, view, in_view_masks,
+                       freespace_layer_ptr);
   } else {
-    launchNonPaddedKernel(update_time_ms, tsdf_layer, view,
+    launchNonPaddedKernel(update_time_ms, tsdf_layer, view, in_view_masks,
                           freespace_layer_ptr);
   }
 
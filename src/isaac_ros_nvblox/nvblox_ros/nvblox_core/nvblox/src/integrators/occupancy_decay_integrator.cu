@@ -148,6 +148,19 @@ void OccupancyDecayIntegrator::decay_to_free(bool decay_to_free) {
   }
 }
 
+bool OccupancyDecayIntegrator::skip_inactive_blocks() const {
+  return decayer_.skip_fully_decayed_blocks();
+}
+
+void OccupancyDecayIntegrator::skip_inactive_blocks(bool skip_inactive_blocks) {
+  decayer_.skip_fully_decayed_blocks(skip_inactive_blocks);
+}
+
+void OccupancyDecayIntegrator::markBlocksAsActive(
+    const std::vector<Index3D>& block_indices) {
+  decayer_.markBlocksAsActive(block_indices);
+}
+
 parameters::ParameterTreeNode OccupancyDecayIntegrator::getParameterTree(
     const std::string& name_remap) const {
   using parameters::ParameterTreeNode;
@@ -159,6 +172,8 @@ parameters::ParameterTreeNode OccupancyDecayIntegrator::getParameterTree(
              ParameterTreeNode("occupied_space_decay_log_odds:",
                                occupied_space_decay_log_odds_),
              ParameterTreeNode("decay_to_log_odds_:", decay_to_log_odds_),
+             ParameterTreeNode("skip_inactive_blocks:",
+                               decayer_.skip_fully_decayed_blocks()),
              DecayIntegratorBase::getParameterTree()});
 }
 
@@ -0,0 +1,460 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "nvblox/integrators/pointcloud_tsdf_integrator.h"
+
+#include <algorithm>
+
+#include "nvblox/core/indexing.h"
+#include "nvblox/gpu_hash/internal/cuda/gpu_set.cuh"
+#include "nvblox/integrators/internal/cuda/impl/projective_integrator_impl.cuh"
+#include "nvblox/integrators/internal/integrators_common.h"
+#include "nvblox/map/internal/cuda/voxel_block_threads.cuh"
+#include "nvblox/rays/ray_caster.h"
+#include "nvblox/utils/timing.h"
+
+namespace nvblox {
+
+namespace {
+
+constexpr int kThreadsPerThreadBlock = 256;
+constexpr int kNumVoxelsPerBlock = TsdfBlock::kNumVoxels;
+
+// The initial capacity of the blocks-in-view set. The set is grown if a
+// pointcloud touches more blocks.
+constexpr size_t kInitialBlocksInViewSetSize = 1 << 14;
+
+// Lexicographic ordering of block indices, used to binary search the blocks
+// being integrated on the GPU.
+__host__ __device__ inline bool indexLessThan(const Index3D& a,
+                                              const Index3D& b) {
+  if (a.x() != b.x()) {
+    return a.x() < b.x();
+  }
+  if (a.y() != b.y()) {
+    return a.y() < b.y();
+  }
+  return a.z() < b.z();
+}
+
+// Returns the position of block_idx in the sorted block_indices or -1 if the
+// block is not present.
+__device__ inline int findBlock(const Index3D& block_idx,
+                                const Index3D* block_indices, int num_blocks) {
+  int low = 0;
+  int high = num_blocks - 1;
+  while (low <= high) {
+    const int mid = (low + high) / 2;
+    if (indexLessThan(block_indices[mid], block_idx)) {
+      low = mid + 1;
+    } else if (indexLessThan(block_idx, block_indices[mid])) {
+      high = mid - 1;
+    } else {
+      return mid;
+    }
+  }
+  return -1;
+}
+
+// Computes the ray of a point in the layer frame. Returns false for points
+// which can't be integrated.
+__device__ inline bool getRay(const Vector3f& p_S, const Transform& T_L_S,
+                              float truncation_distance_m,
+                              float max_integration_distance_m,
+                              Vector3f* direction_L, float* range_m,
+                              Vector3f* ray_end_L) {
+  const float range = p_S.norm();
+  if (!isfinite(range) || range <= 0.0f) {
+    return false;
+  }
+  *range_m = range;
+  *direction_L = T_L_S.linear() * (p_S / range);
+  // Rays extend past the point by the truncation distance, such that the
+  // negative band behind the surface is observed, but never past the maximum
+  // integration distance.
+  const float ray_length_m =
+      fmin(range + truncation_distance_m, max_integration_distance_m);
+  *ray_end_L = T_L_S.translation() + ray_length_m * (*direction_L);
+  return true;
+}
+
+__global__ void getBlocksAlongRaysKernel(
+    const Vector3f* points_S, const int num_points, const Transform T_L_S,
+    const float block_size, const float truncation_distance_m,
+    const float max_integration_distance_m, Index3DDeviceSetType block_set,
+    int* num_failed_insertions) {
+  const int point_idx = blockIdx.x * blockDim.x + threadIdx.x;
+  if (point_idx >= num_points) {
+    return;
+  }
+  Vector3f direction_L, ray_end_L;
+  float range_m;
+  if (!getRay(points_S[point_idx], T_L_S, truncation_distance_m,
+              max_integration_distance_m, &direction_L, &range_m,
+              &ray_end_L)) {
+    return;
+  }
+  RayCaster ray_caster(T_L_S.translation(), ray_end_L, block_size);
+  Index3D block_idx;
+  while (ray_caster.nextRayIndex(&block_idx)) {
+    const auto result = block_set.insert(block_idx);
+    // An insertion fails (rather than finding the existing block) if the set
+    // is full.
+    if (!result.second && result.first == block_set.end()) {
+      atomicAdd(num_failed_insertions, 1);
+    }
+  }
+}
+
+__global__ void accumulateObservationsAlongRaysKernel(
+    const Vector3f* points_S, const int num_points, const Transform T_L_S,
+    const float block_size, const float truncation_distance_m,
+    const float max_integration_distance_m,
+    const WeightingFunction weighting_function, const Index3D* block_indices,
+    const int num_blocks, TsdfObservationSum* observation_sums) {
+  const int point_idx = blockIdx.x * blockDim.x + threadIdx.x;
+  if (point_idx >= num_points) {
+    return;
+  }
+  Vector3f direction_L, ray_end_L;
+  float range_m;
+  if (!getRay(points_S[point_idx], T_L_S, truncation_distance_m,
+              max_integration_distance_m, &direction_L, &range_m,
+              &ray_end_L)) {
+    return;
+  }
+  const Vector3f& origin_L = T_L_S.translation();
+  const float voxel_size = block_size / TsdfBlock::kVoxelsPerSide;
+
+  // Consecutive voxels along a ray mostly share a block, so we cache the last
+  // looked up block.
+  Index3D last_block_idx(0, 0, 0);
+  int last_block_position = -1;
+  bool have_last_block = false;
+
+  RayCaster ray_caster(origin_L, ray_end_L, voxel_size);
+  Index3D global_voxel_idx;
+  while (ray_caster.nextRayIndex(&global_voxel_idx)) {
+    const Vector3f p_voxel_center_L =
+        (global_voxel_idx.cast<float>() + Vector3f::Constant(0.5f)) *
+        voxel_size;
+    // Distance along the ray and to the surface.
+    const float voxel_range_m = (p_voxel_center_L - origin_L).dot(direction_L);
+    if (voxel_range_m > max_integration_distance_m) {
+      break;
+    }
+    const float voxel_to_surface_distance = range_m - voxel_range_m;
+    if (voxel_to_surface_distance < -truncation_distance_m) {
+      break;
+    }
+    const float measurement_weight = weighting_function(
+        range_m, voxel_range_m, truncation_distance_m);
+    if (measurement_weight <= 0.0f) {
+      continue;
+    }
+
+    Index3D block_idx, voxel_idx;
+    getBlockAndVoxelIndexFromPositionInLayer(block_size, p_voxel_center_L,
+                                             &block_idx, &voxel_idx);
+    if (!have_last_block || block_idx != last_block_idx) {
+      last_block_idx = block_idx;
+      last_block_position = findBlock(block_idx, block_indices, num_blocks);
+      have_last_block = true;
+    }
+    if (last_block_position < 0) {
+      continue;
+    }
+
+    // NOTE: Observations in front of the surface are clipped to the
+    // truncation distance before being summed, such that the many rays
+    // passing through free space don't dominate the voxels' average.
+    const float distance = fmin(voxel_to_surface_distance,
+                                truncation_distance_m);
+    TsdfObservationSum* sum =
+        &observation_sums[last_block_position * kNumVoxelsPerBlock +
+                          voxelBlockMaskBit(voxel_idx)];
+    atomicAdd(&sum->weighted_distance, measurement_weight * distance);
+    atomicAdd(&sum->weight, measurement_weight);
+  }
+}
+
+__global__ void fuseObservationsKernel(
+    const TsdfObservationSum* observation_sums,
+    const float truncation_distance_m, const float max_weight,
+    TsdfBlock** block_ptrs, VoxelBlockMask* updated_voxel_masks) {
+  forEachVoxelInThread([&](const Index3D& voxel_idx) {
+    const TsdfObservationSum sum =
+        observation_sums[blockIdx.x * kNumVoxelsPerBlock +
+                         voxelBlockMaskBit(voxel_idx)];
+    if (sum.weight <= 0.0f) {
+      return;
+    }
+    TsdfVoxel* voxel_ptr =
+        &block_ptrs[blockIdx.x]
+             ->voxels[voxel_idx.x()][voxel_idx.y()][voxel_idx.z()];
+    const TsdfVoxel voxel_before = *voxel_ptr;
+    const float voxel_distance_current = voxel_before.distance;
+    const float voxel_weight_current = voxel_before.weight;
+
+    // Fuse. This is the same update as the ProjectiveTsdfIntegrator, with all
+    // of this frame's observations of the voxel applied at once.
+    float fused_distance = (sum.weighted_distance +
+                            voxel_distance_current * voxel_weight_current) /
+                           (sum.weight + voxel_weight_current);
+
+    // Clip
+    if (fused_distance > 0.0f) {
+      fused_distance = fmin(truncation_distance_m, fused_distance);
+    } else {
+      fused_distance = fmax(-truncation_distance_m, fused_distance);
+    }
+    voxel_ptr->distance = fused_distance;
+    voxel_ptr->weight = fmin(sum.weight + voxel_weight_current, max_weight);
+
+    flagVoxelIfSurfaceChanged(voxel_before, *voxel_ptr, voxel_idx,
+                              updated_voxel_masks);
+  });
+}
+
+}  // namespace
+
+PointcloudTsdfIntegrator::PointcloudTsdfIntegrator()
+    : PointcloudTsdfIntegrator(std::make_shared<CudaStreamOwning>()) {}
+
+PointcloudTsdfIntegrator::PointcloudTsdfIntegrator(
+    std::shared_ptr<CudaStream> cuda_stream)
+    : blocks_in_view_set_size_(kInitialBlocksInViewSetSize),
+      blocks_in_view_set_(
+          std::make_unique<Index3DDeviceSet>(blocks_in_view_set_size_)),
+      cuda_stream_(cuda_stream) {}
+
+PointcloudTsdfIntegrator::~PointcloudTsdfIntegrator() {
+  // NOTE: Defined here because Index3DDeviceSet is only forward declared in
+  // the header.
+}
+
+void PointcloudTsdfIntegrator::integrateFrame(
+    const Pointcloud& pointcloud_S, const Transform& T_L_S, TsdfLayer* layer,
+    std::vector<Index3D>* updated_blocks,
+    std::vector<VoxelBlockMask>* updated_voxel_masks) {
+  CHECK_NOTNULL(layer);
+  timing::Timer integration_timer("pointcloud_tsdf/integrate");
+  if (updated_blocks != nullptr) {
+    updated_blocks->clear();
+  }
+  if (updated_voxel_masks != nullptr) {
+    updated_voxel_masks->clear();
+  }
+  if (pointcloud_S.empty()) {
+    return;
+  }
+
+  // Kernels read the points directly, so host points are staged on the GPU.
+  const Vector3f* points_S_device = pointcloud_S.dataConstPtr();
+  if (pointcloud_S.memory_type() == MemoryType::kHost) {
+    points_device_.copyFromAsync(pointcloud_S, *cuda_stream_);
+    points_S_device = points_device_.dataConstPtr();
+  }
+
+  const float block_size = layer->block_size();
+  const float truncation_distance_m =
+      get_truncation_distance_m(layer->voxel_size());
+
+  // Find and allocate the blocks touched by the rays.
+  timing::Timer blocks_in_view_timer("pointcloud_tsdf/get_blocks_in_view");
+  std::vector<Index3D> block_indices =
+      getBlocksAlongRays(T_L_S, points_S_device, pointcloud_S.size(),
+                         block_size, truncation_distance_m);
+  blocks_in_view_timer.Stop();
+  if (block_indices.empty()) {
+    return;
+  }
+
+  timing::Timer allocate_blocks_timer("pointcloud_tsdf/allocate_blocks");
+  allocateBlocksWhereRequired(block_indices, layer, *cuda_stream_);
+  allocate_blocks_timer.Stop();
+
+  timing::Timer transfer_blocks_timer("pointcloud_tsdf/transfer_blocks");
+  transferBlockPointersToDevice<TsdfBlock>(block_indices, *cuda_stream_, layer,
+                                           &block_ptrs_host_,
+                                           &block_ptrs_device_);
+  transferBlocksIndicesToDevice(block_indices, *cuda_stream_,
+                                &block_indices_host_, &block_indices_device_);
+  transfer_blocks_timer.Stop();
+
+  // Update the voxels along the rays.
+  timing::Timer update_blocks_timer("pointcloud_tsdf/update_blocks");
+  accumulateObservationsAlongRays(T_L_S, points_S_device, pointcloud_S.size(),
+                                  block_size, truncation_distance_m);
+  fuseObservations(truncation_distance_m, updated_voxel_masks != nullptr);
+  update_blocks_timer.Stop();
+
+  if (updated_blocks != nullptr) {
+    *updated_blocks = block_indices;
+  }
+  if (updated_voxel_masks != nullptr) {
+    *updated_voxel_masks =
+        updated_voxel_masks_device_.toVectorAsync(*cuda_stream_);
+  }
+  cuda_stream_->synchronize();
+}
+
+std::vector<Index3D> PointcloudTsdfIntegrator::getBlocksAlongRays(
+    const Transform& T_L_S, const Vector3f* points_S_device,
+    const int num_points, const float block_size,
+    const float truncation_distance_m) {
+  const int num_thread_blocks =
+      (num_points + kThreadsPerThreadBlock - 1) / kThreadsPerThreadBlock;
+  while (true) {
+    blocks_in_view_set_->clear();
+    num_failed_insertions_device_.setZeroAsync(*cuda_stream_);
+    getBlocksAlongRaysKernel<<<num_thread_blocks, kThreadsPerThreadBlock, 0,
+                               *cuda_stream_>>>(
+        points_S_device,              // NOLINT
+        num_points,                   // NOLINT
+        T_L_S,                        // NOLINT
+        block_size,                   // NOLINT
+        truncation_distance_m,        // NOLINT
+        max_integration_distance_m_,  // NOLINT
+        blocks_in_view_set_->set,     // NOLINT
+        num_failed_insertions_device_.get());
+    checkCudaErrors(cudaPeekAtLastError());
+    num_failed_insertions_device_.copyToAsync(num_failed_insertions_host_,
+                                              *cuda_stream_);
+    cuda_stream_->synchronize();
+    if (*num_failed_insertions_host_ == 0) {
+      break;
+    }
+    // The set was full. Grow it and cast the rays again.
+    blocks_in_view_set_size_ *= 2;
+    LOG(INFO) << "Growing the pointcloud blocks-in-view set to "
+              << blocks_in_view_set_size_ << " blocks.";
+    blocks_in_view_set_->resize(blocks_in_view_set_size_);
+  }
+
+  std::vector<Index3D> block_indices;
+  copySetToVector(blocks_in_view_set_->set, &block_indices);
+  std::sort(block_indices.begin(), block_indices.end(), indexLessThan);
+  return block_indices;
+}
+
+void PointcloudTsdfIntegrator::accumulateObservationsAlongRays(
+    const Transform& T_L_S, const Vector3f* points_S_device,
+    const int num_points, const float block_size,
+    const float truncation_distance_m) {
+  const int num_blocks = block_indices_device_.size();
+  observation_sums_device_.resizeAsync(num_blocks * kNumVoxelsPerBlock,
+                                       *cuda_stream_);
+  observation_sums_device_.setZeroAsync(*cuda_stream_);
+
+  const int num_thread_blocks =
+      (num_points + kThreadsPerThreadBlock - 1) / kThreadsPerThreadBlock;
+  accumulateObservationsAlongRaysKernel<<<num_thread_blocks,
+                                          kThreadsPerThreadBlock, 0,
+                                          *cuda_stream_>>>(
+      points_S_device,                              // NOLINT
+      num_points,                                   // NOLINT
+      T_L_S,                                        // NOLINT
+      block_size,                                   // NOLINT
+      truncation_distance_m,                        // NOLINT
+      max_integration_distance_m_,                  // NOLINT
+      WeightingFunction(weighting_function_type_),  // NOLINT
+      block_indices_device_.data(),                 // NOLINT
+      num_blocks,                                   // NOLINT
+      observation_sums_device_.data());
+  checkCudaErrors(cudaPeekAtLastError());
+}
+
+void PointcloudTsdfIntegrator::fuseObservations(
+    const float truncation_distance_m, const bool compute_updated_voxel_masks) {
+  const int num_blocks = block_ptrs_device_.size();
+  VoxelBlockMask* updated_voxel_masks = nullptr;
+  if (compute_updated_voxel_masks) {
+    updated_voxel_masks_device_.resizeAsync(num_blocks, *cuda_stream_);
+    updated_voxel_masks_device_.setZeroAsync(*cuda_stream_);
+    updated_voxel_masks = updated_voxel_masks_device_.data();
+  }
+  const dim3 kThreadsPerBlock = voxelBlockThreadsPerBlock();
+  fuseObservationsKernel<<<num_blocks, kThreadsPerBlock, 0, *cuda_stream_>>>(
+      observation_sums_device_.data(),  // NOLINT
+      truncation_distance_m,            // NOLINT
+      max_weight_,                      // NOLINT
+      block_ptrs_device_.data(),        // NOLINT
+      updated_voxel_masks);
+  checkCudaErrors(cudaPeekAtLastError());
+}
+
+float PointcloudTsdfIntegrator::truncation_distance_vox() const {
+  return truncation_distance_vox_;
+}
+
+void PointcloudTsdfIntegrator::truncation_distance_vox(
+    float truncation_distance_vox) {
+  CHECK_GT(truncation_distance_vox, 0.0f);
+  truncation_distance_vox_ = truncation_distance_vox;
+}
+
+float PointcloudTsdfIntegrator::max_integration_distance_m() const {
+  return max_integration_distance_m_;
+}
+
+void PointcloudTsdfIntegrator::max_integration_distance_m(
+    float max_integration_distance_m) {
+  CHECK_GT(max_integration_distance_m, 0.0f);
+  max_integration_distance_m_ = max_integration_distance_m;
+}
+
+float PointcloudTsdfIntegrator::max_weight() const { return max_weight_; }
+
+void PointcloudTsdfIntegrator::max_weight(float max_weight) {
+  CHECK_GT(max_weight, 0.0f);
+  max_weight_ = max_weight;
+}
+
+WeightingFunctionType PointcloudTsdfIntegrator::weighting_function_type()
+    const {
+  return weighting_function_type_;
+}
+
+void PointcloudTsdfIntegrator::weighting_function_type(
+    WeightingFunctionType weighting_function_type) {
+  weighting_function_type_ = weighting_function_type;
+}
+
+float PointcloudTsdfIntegrator::get_truncation_distance_m(
+    float voxel_size) const {
+  return truncation_distance_vox_ * voxel_size;
+}
+
+parameters::ParameterTreeNode PointcloudTsdfIntegrator::getParameterTree(
+    const std::string& name_remap) const {
+  using parameters::ParameterTreeNode;
+  const std::string name =
+      (name_remap.empty()) ? "pointcloud_tsdf_integrator" : name_remap;
+  std::function<std::string(const WeightingFunctionType&)>
+      weighting_function_to_string =
+          [](const WeightingFunctionType& w) { return to_string(w); };
+  return ParameterTreeNode(
+      name, {ParameterTreeNode("truncation_distance_vox:",
+                               truncation_distance_vox_),
+             ParameterTreeNode("max_integration_distance_m:",
+                               max_integration_distance_m_),
+             ParameterTreeNode("max_weight:", max_weight_),
+             ParameterTreeNode("weighting_function_type:",
+                               weighting_function_type_,
+                               weighting_function_to_string)});
+}
+
+}  // namespace nvblox
@@ -21,6 +21,7 @@ limitations under the License.
 #include "nvblox/integrators/projective_color_integrator.h"
 #include "nvblox/integrators/projective_integrator_params.h"
 #include "nvblox/interpolation/interpolation_2d.h"
+#include "nvblox/map/internal/cuda/voxel_block_threads.cuh"
 #include "nvblox/utils/timing.h"
 
 namespace nvblox {
@@ -72,18 +73,76 @@ void ProjectiveColorIntegrator::integrateFrame(
       max_integration_distance_m_ + truncation_distance_m);
   blocks_in_view_timer.Stop();
 
+  block_indices = reduceAndAllocateBlocksInView(block_indices, tsdf_layer,
+                                                color_layer);
+  if (block_indices.empty()) {
+    return;
+  }
+
+  // Get preallocated space for the synthetic depth image
+  const SphereTracer::SubsampledImageSize image_size =
+      sphere_tracer_.getSubsampledImageSize(
+          camera, sphere_tracing_ray_subsampling_factor_);
+  DepthImage* synthetic_depth_image = synthetic_depth_images_.get(
+      image_size.rows, image_size.cols, MemoryType::kDevice);
+
+  // Create a synthetic depth image
+  timing::Timer sphere_trace_timer("color/integrate/sphere_trace");
+  sphere_tracer_.renderImageOnGPU(
+      camera, T_L_C, tsdf_layer, truncation_distance_m, synthetic_depth_image,
+      MemoryType::kDevice, sphere_tracing_ray_subsampling_factor_);
+  sphere_trace_timer.Stop();
+
+  updateBlocks(block_indices, color_frame, *synthetic_depth_image, T_L_C,
+               camera, tsdf_layer, color_layer, updated_blocks);
+}
+
+void ProjectiveColorIntegrator::integrateFrame(
+    const ColorImage& color_frame, const DepthImage& depth_frame,
+    const Transform& T_L_C, const Camera& camera, const TsdfLayer& tsdf_layer,
+    const std::vector<Index3D>& block_indices_in_view, ColorLayer* color_layer,
+    std::vector<Index3D>* updated_blocks) {
+  timing::Timer color_timer("color/integrate_with_depth");
+  CHECK_NOTNULL(color_layer);
+  CHECK_EQ(tsdf_layer.block_size(), color_layer->block_size());
+  // The update kernel looks up the depth at the color pixel divided by the
+  // subsampling factor.
+  CHECK_GT(depth_frame.rows(), 0);
+  CHECK_GT(depth_frame.cols(), 0);
+  const int depth_subsampling_factor = color_frame.rows() / depth_frame.rows();
+  CHECK_GT(depth_subsampling_factor, 0);
+  CHECK_EQ(depth_frame.rows() * depth_subsampling_factor, color_frame.rows());
+  CHECK_EQ(depth_frame.cols() * depth_subsampling_factor, color_frame.cols());
+
+  // The real depth frame takes the place of the synthetic depth image.
+  const std::vector<Index3D> block_indices = reduceAndAllocateBlocksInView(
+      block_indices_in_view, tsdf_layer, color_layer);
+  if (block_indices.empty()) {
+    return;
+  }
+  updateBlocks(block_indices, color_frame, depth_frame, T_L_C, camera,
+               tsdf_layer, color_layer, updated_blocks);
+}
+
+std::vector<Index3D> ProjectiveColorIntegrator::reduceAndAllocateBlocksInView(
+    const std::vector<Index3D>& block_indices_in_view,
+    const TsdfLayer& tsdf_layer, ColorLayer* color_layer) {
+  const float truncation_distance_m =
+      truncation_distance_vox_ * tsdf_layer.voxel_size();
+
   // Check which of these blocks are:
   // - Allocated in the TSDF, and
-  // - have at least a single voxel within the truncation band
+  // - have at least a single voxel within the truncation band (which, if
+  //   surface_only_allocation() is set, must also be observed)
   // This is because:
   // - We don't allocate new geometry here, we just color existing geometry
   // - We don't color freespace.
   timing::Timer blocks_in_band_timer(
       "color/integrate/reduce_to_blocks_in_band");
-  block_indices = reduceBlocksToThoseInTruncationBand(block_indices, tsdf_layer,
-                                                      truncation_distance_m);
+  std::vector<Index3D> block_indices = reduceBlocksToThoseInTruncationBand(
+      block_indices_in_view, tsdf_layer, truncation_distance_m);
   if (block_indices.empty()) {
-    return;
+    return block_indices;
   }
   blocks_in_band_timer.Stop();
 
@@ -94,21 +153,14 @@ void ProjectiveColorIntegrator::integrateFrame(
   timing::Timer allocate_blocks_timer("color/integrate/allocate_blocks");
   allocateBlocksWhereRequired(block_indices, color_layer, *cuda_stream_);
   allocate_blocks_timer.Stop();
+  return block_indices;
+}
 
-  // Get preallocated space for the synthetic depth image
-  const SphereTracer::SubsampledImageSize image_size =
-      sphere_tracer_.getSubsampledImageSize(
-          camera, sphere_tracing_ray_subsampling_factor_);
-  DepthImage* synthetic_depth_image = synthetic_depth_images_.get(
-      image_size.rows, image_size.cols, MemoryType::kDevice);
-
-  // Create a synthetic depth image
-  timing::Timer sphere_trace_timer("color/integrate/sphere_trace");
-  sphere_tracer_.renderImageOnGPU(
-      camera, T_L_C, tsdf_layer, truncation_distance_m, synthetic_depth_image,
-      MemoryType::kDevice, sphere_tracing_ray_subsampling_factor_);
-  sphere_trace_timer.Stop();
-
+void ProjectiveColorIntegrator::updateBlocks(
+    const std::vector<Index3D>& block_indices, const ColorImage& color_frame,
+    const DepthImage& depth_frame, const Transform& T_L_C, const Camera& camera,
+    const TsdfLayer& tsdf_layer, ColorLayer* color_layer,
+    std::vector<Index3D>* updated_blocks) {
   timing::Timer transfer_blocks_timer("color/integrate/transfer_blocks");
   transferBlockPointersToDevice<ColorBlock>(block_indices, *cuda_stream_,
                                             color_layer, &block_ptrs_host_,
@@ -126,7 +178,7 @@ void ProjectiveColorIntegrator::integrateFrame(
 
   // Calling the GPU to do the updates
   timing::Timer update_blocks_timer("color/integrate/update_blocks");
-  integrateBlocks(*synthetic_depth_image, color_frame, T_C_L, camera,
+  integrateBlocks(depth_frame, color_frame, T_C_L, camera,
                   update_functor_device.get(), color_layer);
 
   if (updated_blocks != nullptr) {
@@ -171,6 +223,23 @@ void ProjectiveColorIntegrator::weighting_function_type(
   weighting_function_type_ = weighting_function_type;
 }
 
+bool ProjectiveColorIntegrator::surface_only_allocation() const {
+  return surface_only_allocation_;
+}
+
+void ProjectiveColorIntegrator::surface_only_allocation(
+    bool surface_only_allocation) {
+  surface_only_allocation_ = surface_only_allocation;
+}
+
+bool ProjectiveColorIntegrator::reuse_depth_frame() const {
+  return reuse_depth_frame_;
+}
+
+void ProjectiveColorIntegrator::reuse_depth_frame(bool reuse_depth_frame) {
+  reuse_depth_frame_ = reuse_depth_frame;
+}
+
 const ViewCalculator& ProjectiveColorIntegrator::view_calculator() const {
   return view_calculator_;
 }
@@ -199,6 +268,9 @@ parameters::ParameterTreeNode ProjectiveColorIntegrator::getParameterTree(
                 ParameterTreeNode(
                     "weighting_function_type:", weighting_function_type_,
                     weighting_function_to_string),
+                ParameterTreeNode("surface_only_allocation:",
+                                  surface_only_allocation_),
+                ParameterTreeNode("reuse_depth_frame:", reuse_depth_frame_),
                 ProjectiveIntegrator<ColorVoxel>::getParameterTree(),
                 view_calculator_.getParameterTree(),
             });
@@ -296,7 +368,7 @@ __device__ inline bool updateVoxel(const Color color_measured,
 
 __global__ void checkBlocksInTruncationBand(
     const VoxelBlock<TsdfVoxel>** block_device_ptrs,
-    const float truncation_distance_m,
+    const float truncation_distance_m, const bool only_observed_voxels,
     bool* contains_truncation_band_device_ptr) {
   // A single thread in each block initializes the output to 0
   if (threadIdx.x == 0 && threadIdx.y == 0 && threadIdx.z == 0) {
@@ -304,18 +376,22 @@ __global__ void checkBlocksInTruncationBand(
   }
   __syncthreads();
 
-  // Get the Voxel we'll check in this thread
-  const TsdfVoxel voxel = block_device_ptrs[blockIdx.x]
-                              ->voxels[threadIdx.z][threadIdx.y][threadIdx.x];
-
-  // If this voxel in the truncation band, write the flag to say that the
-  // block should be processed. NOTE(alexmillane): There will be collision on
-  // write here. However, from my reading, all threads' writes will result in
-  // a single write to global memory. Because we only write a single value (1)
-  // it doesn't matter which thread "wins".
-  if (std::abs(voxel.distance) <= truncation_distance_m) {
-    contains_truncation_band_device_ptr[blockIdx.x] = true;
-  }
+  forEachVoxelInThread([&](const Index3D& voxel_idx) {
+    // Get the Voxel we'll check in this thread
+    const TsdfVoxel voxel =
+        block_device_ptrs[blockIdx.x]
+            ->voxels[voxel_idx.x()][voxel_idx.y()][voxel_idx.z()];
+
+    // If this voxel in the truncation band, write the flag to say that the
+    // block should be processed. NOTE(alexmillane): There will be collision
+    // on write here. However, from my reading, all threads' writes will
+    // result in a single write to global memory. Because we only write a
+    // single value (1) it doesn't matter which thread "wins".
+    const bool is_observed = !only_observed_voxels || (voxel.weight > 0.0f);
+    if (is_observed && std::abs(voxel.distance) <= truncation_distance_m) {
+      contains_truncation_band_device_ptr[blockIdx.x] = true;
+    }
+  });
 }
 
 std::vector<Index3D>
@@ -364,13 +440,13 @@ ProjectiveColorIntegrator::reduceBlocksToThoseInTruncationBand(
 
   // Do the check on GPU
   // Kernel call - One ThreadBlock launched per VoxelBlock
-  constexpr int kVoxelsPerSide = VoxelBlock<bool>::kVoxelsPerSide;
-  const dim3 kThreadsPerBlock(kVoxelsPerSide, kVoxelsPerSide, kVoxelsPerSide);
+  const dim3 kThreadsPerBlock = voxelBlockThreadsPerBlock();
   const int num_thread_blocks = num_blocks;
   // clang-format off
   checkBlocksInTruncationBand<<<num_thread_blocks, kThreadsPerBlock, 0, *cuda_stream_>>>(
       truncation_band_block_ptrs_device_.data(),
       truncation_distance_m,
+      surface_only_allocation_,
       block_in_truncation_band_device_.data());
   // clang-format on
   checkCudaErrors(cudaPeekAtLastError());
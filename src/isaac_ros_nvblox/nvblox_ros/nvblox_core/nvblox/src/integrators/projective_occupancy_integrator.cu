@@ -99,6 +99,19 @@ void ProjectiveOccupancyIntegrator::integrateFrame(
       layer, updated_blocks);
 }
 
+void ProjectiveOccupancyIntegrator::integrateFrame(
+    const MaskedDepthImageConstView& depth_frame,
+    const MonoImageConstView& label_image, const Transform& T_L_C,
+    const Camera& camera, OccupancyLayer* layer, LabelLayer* label_layer,
+    std::vector<Index3D>* updated_blocks) {
+  setFunctorParameters(layer->voxel_size());
+  ProjectiveIntegrator<OccupancyVoxel>::integrateFrame(
+      depth_frame, label_image, T_L_C, camera,
+      update_functor_host_ptr_.cloneAsync(MemoryType::kDevice, *cuda_stream_)
+          .get(),
+      layer, label_layer, updated_blocks);
+}
+
 void ProjectiveOccupancyIntegrator::integrateFrame(
     const MaskedDepthImageConstView& depth_frame, const Transform& T_L_C,
     const Lidar& lidar, OccupancyLayer* layer,
@@ -111,6 +124,31 @@ void ProjectiveOccupancyIntegrator::integrateFrame(
       layer, updated_blocks);
 }
 
+void ProjectiveOccupancyIntegrator::integrateFrames(
+    const std::vector<MaskedDepthImageConstView>& depth_frames,
+    const std::vector<Transform>& T_L_C_vec,
+    const std::vector<Camera>& cameras, OccupancyLayer* layer,
+    std::vector<Index3D>* updated_blocks) {
+  setFunctorParameters(layer->voxel_size());
+  ProjectiveIntegrator<OccupancyVoxel>::integrateFrames(
+      depth_frames, T_L_C_vec, cameras,
+      update_functor_host_ptr_.cloneAsync(MemoryType::kDevice, *cuda_stream_)
+          .get(),
+      layer, updated_blocks);
+}
+
+void ProjectiveOccupancyIntegrator::integrateFrames(
+    const std::vector<MaskedDepthImageConstView>& depth_frames,
+    const std::vector<Transform>& T_L_C_vec, const std::vector<Lidar>& lidars,
+    OccupancyLayer* layer, std::vector<Index3D>* updated_blocks) {
+  setFunctorParameters(layer->voxel_size());
+  ProjectiveIntegrator<OccupancyVoxel>::integrateFrames(
+      depth_frames, T_L_C_vec, lidars,
+      update_functor_host_ptr_.cloneAsync(MemoryType::kDevice, *cuda_stream_)
+          .get(),
+      layer, updated_blocks);
+}
+
 void ProjectiveOccupancyIntegrator::setFunctorParameters(
     const float voxel_size) {
   update_functor_host_ptr_->free_region_log_odds_ = free_region_log_odds_;
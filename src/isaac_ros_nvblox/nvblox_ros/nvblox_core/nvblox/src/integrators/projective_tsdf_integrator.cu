@@ -30,6 +30,16 @@ struct UpdateTsdfVoxelFunctor {
   __device__ bool operator()(const float surface_depth_measured,
                              const float voxel_depth_m, const bool is_masked,
                              TsdfVoxel* voxel_ptr) {
+    return update(surface_depth_measured, voxel_depth_m, is_masked,
+                  weighting_function_, voxel_ptr);
+  }
+
+  // The update, with the weights computed by weighting_function.
+  template <typename WeightingFunctionT>
+  __device__ bool update(const float surface_depth_measured,
+                         const float voxel_depth_m, const bool is_masked,
+                         const WeightingFunctionT& weighting_function,
+                         TsdfVoxel* voxel_ptr) const {
     // Ignore invalid (negative) depth measurements.
     if (surface_depth_measured <= 0.F) {
       if (invalid_depth_decay_factor_ >= 0.F) {
@@ -66,7 +76,7 @@ struct UpdateTsdfVoxelFunctor {
     // https://docs.nvidia.com/cuda/cuda-math-api/group__CUDA__MATH__SINGLE.html#group__CUDA__MATH__SINGLE
 
     // Get the weight of this observation from the sensor model.
-    const float measurement_weight = weighting_function_(
+    const float measurement_weight = weighting_function(
         surface_depth_measured, voxel_depth_m, truncation_distance_m_);
 
     // Fuse
@@ -98,6 +108,33 @@ struct UpdateTsdfVoxelFunctor {
       kProjectiveIntegratorWeightingModeParamDesc.default_value;
 };
 
+// The update functor with the weighting function fixed at compile time.
+// Integrating with this functor removes the switch over the weighting type
+// from the inner loop of the integration kernels.
+template <WeightingFunctionType kWeightingType>
+struct FixedWeightingUpdateTsdfVoxelFunctor {
+  __device__ bool operator()(const float surface_depth_measured,
+                             const float voxel_depth_m, const bool is_masked,
+                             TsdfVoxel* voxel_ptr) const {
+    return functor.update(surface_depth_measured, voxel_depth_m, is_masked,
+                          FixedWeightingFunction<kWeightingType>(), voxel_ptr);
+  }
+
+  UpdateTsdfVoxelFunctor functor;
+};
+
+// Copies a (trivially copyable) functor to a new device allocation.
+template <typename FunctorType>
+unified_ptr<FunctorType> copyFunctorToDevice(const FunctorType& functor,
+                                             const CudaStream& cuda_stream) {
+  unified_ptr<FunctorType> functor_device =
+      make_unified_async<FunctorType>(MemoryType::kDevice, cuda_stream);
+  // NOTE: A copy from pageable memory returns once the source is staged, so
+  // the functor may be a temporary.
+  functor_device.copyFromAsync(&functor, 1, cuda_stream);
+  return functor_device;
+}
+
 ProjectiveTsdfIntegrator::ProjectiveTsdfIntegrator()
     : ProjectiveTsdfIntegrator(std::make_shared<CudaStreamOwning>()) {}
 
@@ -114,8 +151,9 @@ ProjectiveTsdfIntegrator::~ProjectiveTsdfIntegrator() {
   // the destructor is.
 }
 
-unified_ptr<UpdateTsdfVoxelFunctor>
-ProjectiveTsdfIntegrator::getTsdfUpdateFunctorOnDevice(float voxel_size) {
+template <typename IntegrateFunction>
+void ProjectiveTsdfIntegrator::integrateWithUpdateFunctor(
+    float voxel_size, IntegrateFunction integrate) {
   // Set the update function params
   // NOTE(alex.millane): We do this with every frame integration to avoid
   // bug-prone logic for detecting when params have changed etc.
@@ -126,35 +164,107 @@ ProjectiveTsdfIntegrator::getTsdfUpdateFunctorOnDevice(float voxel_size) {
       invalid_depth_decay_factor();
   update_functor_host_ptr_->weighting_function_ =
       WeightingFunction(weighting_function_type_);
-  // Transfer to the device
-  return update_functor_host_ptr_.cloneAsync(MemoryType::kDevice,
-                                             *cuda_stream_);
+
+  // The weighting type is fixed by the integrator configuration. For the
+  // common weighting types we transfer a functor with the weighting fixed at
+  // compile time, such that the integration kernels get instantiated without
+  // a runtime switch over the weighting type in their inner loop.
+  const UpdateTsdfVoxelFunctor& functor = *update_functor_host_ptr_;
+  switch (weighting_function_type_) {
+    case WeightingFunctionType::kConstantWeight:
+      integrate(copyFunctorToDevice(
+                    FixedWeightingUpdateTsdfVoxelFunctor<
+                        WeightingFunctionType::kConstantWeight>{functor},
+                    *cuda_stream_)
+                    .get());
+      break;
+    case WeightingFunctionType::kInverseSquareWeight:
+      integrate(copyFunctorToDevice(
+                    FixedWeightingUpdateTsdfVoxelFunctor<
+                        WeightingFunctionType::kInverseSquareWeight>{functor},
+                    *cuda_stream_)
+                    .get());
+      break;
+    default:
+      integrate(update_functor_host_ptr_
+                    .cloneAsync(MemoryType::kDevice, *cuda_stream_)
+                    .get());
+      break;
+  }
 }
 
 void ProjectiveTsdfIntegrator::integrateFrame(
     const MaskedDepthImageConstView& depth_frame, const Transform& T_L_C,
     const Camera& camera, TsdfLayer* layer,
-    std::vector<Index3D>* updated_blocks) {
-  // Get the update functor on the device
-  unified_ptr<UpdateTsdfVoxelFunctor> update_functor_device_ptr =
-      getTsdfUpdateFunctorOnDevice(layer->voxel_size());
-  // Integrate
-  ProjectiveIntegrator<TsdfVoxel>::integrateFrame(
-      depth_frame, T_L_C, camera, update_functor_device_ptr.get(), layer,
-      updated_blocks);
+    std::vector<Index3D>* updated_blocks,
+    std::vector<VoxelBlockMask>* updated_voxel_masks) {
+  integrateWithUpdateFunctor(layer->voxel_size(), [&](auto* op) {
+    this->ProjectiveIntegrator<TsdfVoxel>::integrateFrame(
+        depth_frame, T_L_C, camera, op, layer, updated_blocks,
+        updated_voxel_masks);
+  });
+}
+
+void ProjectiveTsdfIntegrator::integrateFrame(
+    const MaskedDepthImageConstView& depth_frame,
+    const MonoImageConstView& label_image, const Transform& T_L_C,
+    const Camera& camera, TsdfLayer* layer, LabelLayer* label_layer,
+    std::vector<Index3D>* updated_blocks,
+    std::vector<VoxelBlockMask>* updated_voxel_masks) {
+  integrateWithUpdateFunctor(layer->voxel_size(), [&](auto* op) {
+    this->ProjectiveIntegrator<TsdfVoxel>::integrateFrame(
+        depth_frame, label_image, T_L_C, camera, op, layer, label_layer,
+        updated_blocks, updated_voxel_masks);
+  });
+}
+
+void ProjectiveTsdfIntegrator::integrateFrame(
+    const MaskedDepthImageU16ConstView& depth_frame, const float depth_scale_m,
+    const Transform& T_L_C, const Camera& camera, TsdfLayer* layer,
+    std::vector<Index3D>* updated_blocks,
+    std::vector<VoxelBlockMask>* updated_voxel_masks) {
+  integrateWithUpdateFunctor(layer->voxel_size(), [&](auto* op) {
+    this->ProjectiveIntegrator<TsdfVoxel>::integrateFrame(
+        depth_frame, depth_scale_m, T_L_C, camera, op, layer, updated_blocks,
+        updated_voxel_masks);
+  });
 }
 
 void ProjectiveTsdfIntegrator::integrateFrame(
     const MaskedDepthImageConstView& depth_frame, const Transform& T_L_C,
     const Lidar& lidar, TsdfLayer* layer,
-    std::vector<Index3D>* updated_blocks) {
-  // Get the update functor on the device
-  unified_ptr<UpdateTsdfVoxelFunctor> update_functor_device_ptr =
-      getTsdfUpdateFunctorOnDevice(layer->voxel_size());
-  // Integrate
-  ProjectiveIntegrator<TsdfVoxel>::integrateFrame(
-      depth_frame, T_L_C, lidar, update_functor_device_ptr.get(), layer,
-      updated_blocks);
+    std::vector<Index3D>* updated_blocks,
+    std::vector<VoxelBlockMask>* updated_voxel_masks) {
+  integrateWithUpdateFunctor(layer->voxel_size(), [&](auto* op) {
+    this->ProjectiveIntegrator<TsdfVoxel>::integrateFrame(
+        depth_frame, T_L_C, lidar, op, layer, updated_blocks,
+        updated_voxel_masks);
+  });
+}
+
+void ProjectiveTsdfIntegrator::integrateFrames(
+    const std::vector<MaskedDepthImageConstView>& depth_frames,
+    const std::vector<Transform>& T_L_C_vec,
+    const std::vector<Camera>& cameras, TsdfLayer* layer,
+    std::vector<Index3D>* updated_blocks,
+    std::vector<VoxelBlockMask>* updated_voxel_masks) {
+  integrateWithUpdateFunctor(layer->voxel_size(), [&](auto* op) {
+    this->ProjectiveIntegrator<TsdfVoxel>::integrateFrames(
+        depth_frames, T_L_C_vec, cameras, op, layer, updated_blocks,
+        updated_voxel_masks);
+  });
+}
+
+void ProjectiveTsdfIntegrator::integrateFrames(
+    const std::vector<MaskedDepthImageConstView>& depth_frames,
+    const std::vector<Transform>& T_L_C_vec, const std::vector<Lidar>& lidars,
+    TsdfLayer* layer, std::vector<Index3D>* updated_blocks,
+    std::vector<VoxelBlockMask>* updated_voxel_masks) {
+  integrateWithUpdateFunctor(layer->voxel_size(), [&](auto* op) {
+    this->ProjectiveIntegrator<TsdfVoxel>::integrateFrames(
+        depth_frames, T_L_C_vec, lidars, op, layer, updated_blocks,
+        updated_voxel_masks);
+  });
 }
 
 float ProjectiveTsdfIntegrator::max_weight() const { return max_weight_; }
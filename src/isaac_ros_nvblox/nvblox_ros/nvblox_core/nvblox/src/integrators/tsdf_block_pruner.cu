@@ -0,0 +1,128 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "nvblox/integrators/tsdf_block_pruner.h"
+
+#include "nvblox/core/internal/error_check.h"
+#include "nvblox/utils/timing.h"
+
+namespace nvblox {
+
+// One thread block per TSDF block. A block is kept if any of its voxels is
+// observed (and, optionally, lies within the truncation band).
+__global__ void flagBlocksToKeepKernel(const TsdfBlock* const* block_ptrs,
+                                       float min_weight,
+                                       bool prune_outside_truncation_band,
+                                       float truncation_distance_m,
+                                       bool* keep_block) {
+  const TsdfVoxel* voxels = &block_ptrs[blockIdx.x]->voxels[0][0][0];
+  bool keep = false;
+  for (int i = threadIdx.x; i < TsdfBlock::kNumVoxels && !keep;
+       i += blockDim.x) {
+    const float weight = voxels[i].weight;
+    const float distance = voxels[i].distance;
+    keep = weight >= min_weight && (!prune_outside_truncation_band ||
+                                    fabsf(distance) < truncation_distance_m);
+  }
+  keep = __syncthreads_or(keep);
+  if (threadIdx.x == 0) {
+    keep_block[blockIdx.x] = keep;
+  }
+}
+
+TsdfBlockPruner::TsdfBlockPruner()
+    : TsdfBlockPruner(std::make_shared<CudaStreamOwning>()) {}
+
+TsdfBlockPruner::TsdfBlockPruner(std::shared_ptr<CudaStream> cuda_stream)
+    : cuda_stream_(cuda_stream) {}
+
+std::vector<Index3D> TsdfBlockPruner::getBlocksToPrune(
+    const TsdfLayer& layer, float truncation_distance_m) {
+  timing::Timer timer("tsdf/prune/get_blocks_to_prune");
+  const std::vector<Index3D>& block_indices = layer.getAllBlockIndicesCached();
+  if (block_indices.empty()) {
+    return std::vector<Index3D>();
+  }
+  const device_vector<TsdfBlock*>& block_ptrs =
+      layer.getAllBlockPointersOnGpu(*cuda_stream_);
+  CHECK_EQ(block_ptrs.size(), block_indices.size());
+  keep_block_device_.resizeAsync(block_indices.size(), *cuda_stream_);
+
+  constexpr int kNumThreads = 128;
+  flagBlocksToKeepKernel<<<block_indices.size(), kNumThreads, 0,
+                           *cuda_stream_>>>(
+      block_ptrs.data(), min_weight_, prune_outside_truncation_band_,
+      truncation_distance_m, keep_block_device_.data());
+  checkCudaErrors(cudaPeekAtLastError());
+  keep_block_host_.copyFromAsync(keep_block_device_, *cuda_stream_);
+  cuda_stream_->synchronize();
+
+  std::vector<Index3D> blocks_to_prune;
+  for (size_t i = 0; i < block_indices.size(); i++) {
+    if (!keep_block_host_[i]) {
+      blocks_to_prune.push_back(block_indices[i]);
+    }
+  }
+  return blocks_to_prune;
+}
+
+void TsdfBlockPruner::registerIntegration() {
+  ++num_integrations_since_pruning_;
+}
+
+bool TsdfBlockPruner::isPruningDue() {
+  if (period_ <= 0 || num_integrations_since_pruning_ < period_) {
+    return false;
+  }
+  num_integrations_since_pruning_ = 0;
+  return true;
+}
+
+int TsdfBlockPruner::period() const { return period_; }
+
+void TsdfBlockPruner::period(const int period) {
+  CHECK_GE(period, 0);
+  period_ = period;
+}
+
+float TsdfBlockPruner::min_weight() const { return min_weight_; }
+
+void TsdfBlockPruner::min_weight(const float min_weight) {
+  CHECK_GE(min_weight, 0.f);
+  min_weight_ = min_weight;
+}
+
+bool TsdfBlockPruner::prune_outside_truncation_band() const {
+  return prune_outside_truncation_band_;
+}
+
+void TsdfBlockPruner::prune_outside_truncation_band(
+    const bool prune_outside_truncation_band) {
+  prune_outside_truncation_band_ = prune_outside_truncation_band;
+}
+
+parameters::ParameterTreeNode TsdfBlockPruner::getParameterTree(
+    const std::string& name_remap) const {
+  using parameters::ParameterTreeNode;
+  const std::string name =
+      (name_remap.empty()) ? "tsdf_block_pruner" : name_remap;
+  return ParameterTreeNode(
+      name, {ParameterTreeNode("period:", period_),
+             ParameterTreeNode("min_weight:", min_weight_),
+             ParameterTreeNode("prune_outside_truncation_band:",
+                               prune_outside_truncation_band_)});
+}
+
+}  // namespace nvblox
@@ -17,6 +17,9 @@ limitations under the License.
 
 #include <nvblox/integrators/internal/cuda/impl/decayer_impl.cuh>
 
+#include <cmath>
+#include <map>
+
 namespace nvblox {
 
 float TsdfDecayIntegrator::decay_factor() const { return decay_factor_; }
@@ -55,6 +58,22 @@ void TsdfDecayIntegrator::free_distance_vox(const float free_distance_vox) {
   free_distance_vox_ = free_distance_vox;
 }
 
+bool TsdfDecayIntegrator::lazy_decay() const { return lazy_decay_; }
+
+void TsdfDecayIntegrator::lazy_decay(const bool lazy_decay) {
+  lazy_decay_ = lazy_decay;
+}
+
+int TsdfDecayIntegrator::lazy_decay_compaction_period() const {
+  return lazy_decay_compaction_period_;
+}
+
+void TsdfDecayIntegrator::lazy_decay_compaction_period(
+    const int lazy_decay_compaction_period) {
+  CHECK_GT(lazy_decay_compaction_period, 0);
+  lazy_decay_compaction_period_ = lazy_decay_compaction_period;
+}
+
 struct TsdfDecayFunctor {
   __host__ __device__ TsdfDecayFunctor(float decay_factor,
                                        float decayed_weight_threshold,
@@ -153,6 +172,93 @@ std::vector<Index3D> TsdfDecayIntegrator::decay(
                         cuda_stream);
 }
 
+void TsdfDecayIntegrator::addPendingDecayStep() { ++num_decay_steps_; }
+
+bool TsdfDecayIntegrator::isCompactionDue() const {
+  return (num_decay_steps_ - last_compaction_step_) >=
+         lazy_decay_compaction_period_;
+}
+
+int TsdfDecayIntegrator::numPendingDecaySteps(
+    const Index3D& block_index) const {
+  const auto it = last_decay_step_per_block_.find(block_index);
+  const int last_decay_step = (it != last_decay_step_per_block_.end())
+                                  ? it->second
+                                  : last_compaction_step_;
+  return num_decay_steps_ - last_decay_step;
+}
+
+void TsdfDecayIntegrator::applyPendingDecay(
+    TsdfLayer* layer_ptr, const std::vector<Index3D>& block_indices,
+    const CudaStream& cuda_stream) {
+  CHECK_NOTNULL(layer_ptr);
+  std::vector<Index3D> allocated_block_indices;
+  allocated_block_indices.reserve(block_indices.size());
+  for (const Index3D& block_index : block_indices) {
+    if (layer_ptr->isBlockAllocated(block_index)) {
+      allocated_block_indices.push_back(block_index);
+    }
+  }
+  // The blocks are about to be observed, so we don't deallocate them.
+  constexpr bool kDeallocateDecayedBlocks = false;
+  decayByPendingSteps(layer_ptr, allocated_block_indices,
+                      kDeallocateDecayedBlocks, cuda_stream);
+  markBlocksAsDecayed(block_indices);
+}
+
+void TsdfDecayIntegrator::markBlocksAsDecayed(
+    const std::vector<Index3D>& block_indices) {
+  for (const Index3D& block_index : block_indices) {
+    last_decay_step_per_block_[block_index] = num_decay_steps_;
+  }
+}
+
+std::vector<Index3D> TsdfDecayIntegrator::applyAllPendingDecay(
+    TsdfLayer* layer_ptr, const CudaStream& cuda_stream) {
+  CHECK_NOTNULL(layer_ptr);
+  const std::vector<Index3D> deallocated_blocks =
+      decayByPendingSteps(layer_ptr, layer_ptr->getAllBlockIndices(),
+                          deallocate_decayed_blocks_, cuda_stream);
+  // All blocks are now up to date.
+  last_decay_step_per_block_.clear();
+  last_compaction_step_ = num_decay_steps_;
+  return deallocated_blocks;
+}
+
+std::vector<Index3D> TsdfDecayIntegrator::decayByPendingSteps(
+    TsdfLayer* layer_ptr, const std::vector<Index3D>& block_indices,
+    const bool deallocate_decayed_blocks, const CudaStream& cuda_stream) {
+  // Group the blocks by the number of pending steps. Decaying n times by the
+  // decay factor is the same as decaying once by its n-th power, so each group
+  // is decayed in a single pass. Blocks are usually observed regularly, such
+  // that there are only a few groups.
+  std::map<int, std::vector<Index3D>> block_indices_by_num_steps;
+  for (const Index3D& block_index : block_indices) {
+    const int num_steps = numPendingDecaySteps(block_index);
+    if (num_steps > 0) {
+      block_indices_by_num_steps[num_steps].push_back(block_index);
+    }
+  }
+
+  const float free_distance_m = free_distance_vox_ * layer_ptr->voxel_size();
+  std::vector<Index3D> deallocated_blocks;
+  for (const auto& [num_steps, block_indices_to_decay] :
+       block_indices_by_num_steps) {
+    TsdfDecayFunctor voxel_decayer(std::pow(decay_factor_, num_steps),
+                                   decayed_weight_threshold_,
+                                   set_free_distance_on_decayed_,
+                                   free_distance_m);
+    const std::vector<Index3D> deallocated_blocks_group =
+        decayer_.decayBlocks(layer_ptr, block_indices_to_decay, voxel_decayer,
+                             deallocate_decayed_blocks, std::nullopt,
+                             cuda_stream);
+    deallocated_blocks.insert(deallocated_blocks.end(),
+                              deallocated_blocks_group.begin(),
+                              deallocated_blocks_group.end());
+  }
+  return deallocated_blocks;
+}
+
 parameters::ParameterTreeNode TsdfDecayIntegrator::getParameterTree(
     const std::string& name_remap) const {
   using parameters::ParameterTreeNode;
@@ -165,6 +271,9 @@ parameters::ParameterTreeNode TsdfDecayIntegrator::getParameterTree(
        ParameterTreeNode("set_free_distance_on_decayed:",
                          set_free_distance_on_decayed_),
        ParameterTreeNode("free_distance_vox:", free_distance_vox_),
+       ParameterTreeNode("lazy_decay:", lazy_decay_),
+       ParameterTreeNode("lazy_decay_compaction_period:",
+                         lazy_decay_compaction_period_),
        DecayIntegratorBase::getParameterTree()});
 }
 
@@ -13,6 +13,8 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License.
 */
+#include <array>
+
 #include "nvblox/core/hash.h"
 #include "nvblox/core/indexing.h"
 #include "nvblox/core/types.h"
@@ -20,6 +22,7 @@ limitations under the License.
 #include "nvblox/geometry/bounding_boxes.h"
 #include "nvblox/integrators/view_calculator.h"
 #include "nvblox/rays/ray_caster.h"
+#include "nvblox/utils/gpu_timing.h"
 #include "nvblox/utils/timing.h"
 
 namespace nvblox {
@@ -77,6 +80,15 @@ void ViewCalculator::workspace_bounds_max_corner_m(
   workspace_bounds_max_height_m_ = workspace_bounds_max_corner_m.z();
 }
 
+bool ViewCalculator::hierarchical_planes_culling() const {
+  return hierarchical_planes_culling_;
+}
+
+void ViewCalculator::hierarchical_planes_culling(
+    bool hierarchical_planes_culling) {
+  hierarchical_planes_culling_ = hierarchical_planes_culling;
+}
+
 bool ViewCalculator::cache_last_viewpoint() const {
   return cache_last_viewpoint_;
 }
@@ -115,6 +127,33 @@ void ViewCalculator::set_viewpoint_cache(
   }
 }
 
+const DepthPyramid* ViewCalculator::depth_pyramid() const {
+  return depth_pyramid_;
+}
+
+void ViewCalculator::depth_pyramid(const DepthPyramid* depth_pyramid) {
+  depth_pyramid_ = depth_pyramid;
+}
+
+ScratchArena* ViewCalculator::scratch_arena() const { return scratch_arena_; }
+
+void ViewCalculator::scratch_arena(ScratchArena* scratch_arena) {
+  scratch_arena_ = scratch_arena;
+  if (scratch_arena_ != nullptr) {
+    aabb_device_buffer_.clearAndDeallocateAsync(*cuda_stream_);
+  }
+}
+
+std::shared_ptr<CameraRayCache> ViewCalculator::camera_ray_cache() const {
+  return camera_ray_cache_;
+}
+
+void ViewCalculator::camera_ray_cache(
+    std::shared_ptr<CameraRayCache> camera_ray_cache) {
+  CHECK(camera_ray_cache);
+  camera_ray_cache_ = camera_ray_cache;
+}
+
 parameters::ParameterTreeNode ViewCalculator::getParameterTree(
     const std::string& name_remap) const {
   using parameters::ParameterTreeNode;
@@ -145,6 +184,8 @@ parameters::ParameterTreeNode ViewCalculator::getParameterTree(
                             workspace_bounds_min_corner_y_m_),
           ParameterTreeNode("workspace_bounds_max_corner_y_m",
                             workspace_bounds_max_corner_y_m_),
+          ParameterTreeNode("hierarchical_planes_culling",
+                            hierarchical_planes_culling_),
       });
 }
 
@@ -171,12 +212,51 @@ __host__ __device__ inline Index3D aabbLinearIndexToLayerIndex(
 __device__ void setIndexUpdated(const Index3D& index_to_update,
                                 const Index3D& aabb_min,
                                 const Index3D& aabb_size, bool* aabb_updated) {
-  const size_t linear_size = aabb_size.x() * aabb_size.y() * aabb_size.z();
-  const size_t lin_idx =
-      layerIndexToAabbLinearIndex(index_to_update, aabb_min, aabb_size);
-  if (lin_idx < linear_size) {
-    aabb_updated[lin_idx] = true;
+  // NOTE: We check each axis separately. Checking only the linear index would
+  // let indices outside the AABB (e.g. x < aabb_min.x()) wrap around into a
+  // valid linear index and mark blocks that are not in view.
+  const Index3D index_shifted = index_to_update - aabb_min;
+  if ((index_shifted.array() < 0).any() ||
+      (index_shifted.array() >= aabb_size.array()).any()) {
+    return;
   }
+  aabb_updated[layerIndexToAabbLinearIndex(index_to_update, aabb_min,
+                                           aabb_size)] = true;
+}
+
+// Clip the segment start + t * (end - start), t in [0, 1], against the box
+// [box_min, box_max] (slab test). Returns false if the segment misses the box,
+// otherwise the clipped parameter range is returned in t_min and t_max.
+__host__ __device__ inline bool clipSegmentToBox(const Vector3f& start,
+                                                 const Vector3f& end,
+                                                 const Vector3f& box_min,
+                                                 const Vector3f& box_max,
+                                                 float* t_min, float* t_max) {
+  const Vector3f direction = end - start;
+  *t_min = 0.0f;
+  *t_max = 1.0f;
+  for (int i = 0; i < 3; i++) {
+    if (direction[i] == 0.0f) {
+      if (start[i] < box_min[i] || start[i] > box_max[i]) {
+        return false;
+      }
+      continue;
+    }
+    const float inv_direction = 1.0f / direction[i];
+    float t_0 = (box_min[i] - start[i]) * inv_direction;
+    float t_1 = (box_max[i] - start[i]) * inv_direction;
+    if (t_0 > t_1) {
+      const float tmp = t_0;
+      t_0 = t_1;
+      t_1 = tmp;
+    }
+    *t_min = fmaxf(*t_min, t_0);
+    *t_max = fminf(*t_max, t_1);
+    if (*t_min > *t_max) {
+      return false;
+    }
+  }
+  return true;
 }
 
 // Version producing: std::vector<Index3D>
@@ -192,14 +272,55 @@ void convertAabbUpdatedToVector(const host_vector<bool>& aabb_updated,
   }
 }
 
-template <typename SensorType>
+namespace {
+
+// Returns the rays through the pixel centers of the camera, or nullptr if the
+// camera doesn't match the image.
+std::shared_ptr<const RayTable> getPixelRays(const Camera& camera, int rows,
+                                             int cols, CameraRayCache* cache,
+                                             const CudaStream& cuda_stream) {
+  if (camera.rows() != rows || camera.cols() != cols) {
+    return nullptr;
+  }
+  return cache->getRays(camera, 1, RayNormalization::kUnitDepth, cuda_stream);
+}
+
+// Lidar rays are not tabulated.
+std::shared_ptr<const RayTable> getPixelRays(const Lidar&, int, int,
+                                             CameraRayCache*,
+                                             const CudaStream&) {
+  return nullptr;
+}
+
+// Returns the level of the depth pyramid matching the raycasting subsampling,
+// or zero if the pyramid can't be used for this image.
+int getPyramidLevel(const DepthPyramid* depth_pyramid, const float* image,
+                    int rows, int cols, int raycast_subsampling_factor) {
+  if (depth_pyramid == nullptr ||
+      !depth_pyramid->isBuiltFrom(image, rows, cols)) {
+    return 0;
+  }
+  return DepthPyramid::levelForSubsamplingFactor(raycast_subsampling_factor);
+}
+
+// The pyramid is built from metric depth, so doesn't apply to integer images.
+int getPyramidLevel(const DepthPyramid*, const uint16_t*, int, int, int) {
+  return 0;
+}
+
+}  // namespace
+
+template <typename SensorType, typename DepthElementType>
 __global__ void combinedBlockIndicesInImageKernel(
-    const Transform T_L_C, const SensorType camera, const float* image,
-    int rows, int cols, const float block_size,
+    const Transform T_L_C, const SensorType camera,
+    const DepthElementType* image, const float depth_scale_m, int rows,
+    int cols, const float block_size,
     const float max_integration_distance_m,
     const float max_integration_distance_behind_surface_m,
-    int raycast_subsampling_factor, const Index3D aabb_min,
-    const Index3D aabb_size, bool* aabb_updated) {
+    int raycast_subsampling_factor, const Vector3f* pixel_rays_C,
+    const DepthPyramidCell* pyramid_cells, const int pyramid_rows,
+    const int pyramid_cols, const Index3D aabb_min, const Index3D aabb_size,
+    bool* aabb_updated) {
   // First, figure out which pixel we're in.
   const int ray_idx_col = blockIdx.x * blockDim.x + threadIdx.x;
   const int ray_idx_row = blockIdx.y * blockDim.y + threadIdx.y;
@@ -220,8 +341,24 @@ __global__ void combinedBlockIndicesInImageKernel(
     }
   }
 
-  // Look up the pixel we care about.
-  float depth = image::access<float>(pixel_row, pixel_col, cols, image);
+  // Look up the depth we care about. With a depth pyramid, we use the max
+  // depth of the patch of pixels this ray represents, such that the blocks
+  // seen by the skipped pixels are covered by the ray too. Edge rays,
+  // beyond the pyramid, use their pixel.
+  float depth;
+  if (pyramid_cells != nullptr && ray_idx_row < pyramid_rows &&
+      ray_idx_col < pyramid_cols) {
+    const DepthPyramidCell cell =
+        pyramid_cells[ray_idx_row * pyramid_cols + ray_idx_col];
+    if (cell.num_valid == 0) {
+      return;
+    }
+    depth = cell.max_depth;
+  } else {
+    depth = static_cast<float>(image::access<DepthElementType>(
+                pixel_row, pixel_col, cols, image)) *
+            depth_scale_m;
+  }
   if (depth <= 0.0f) {
     return;
   }
@@ -229,41 +366,65 @@ __global__ void combinedBlockIndicesInImageKernel(
     depth = max_integration_distance_m;
   }
 
-  // Ok now project this thing into space.
-  Vector3f p_C = (depth + max_integration_distance_behind_surface_m) *
-                 camera.vectorFromPixelIndices(Index2D(pixel_col, pixel_row));
+  // Ok now project this thing into space. Use the precomputed ray if we have
+  // one.
+  const Vector3f ray_C =
+      pixel_rays_C != nullptr
+          ? pixel_rays_C[pixel_row * cols + pixel_col]
+          : camera.vectorFromPixelIndices(Index2D(pixel_col, pixel_row));
+  Vector3f p_C = (depth + max_integration_distance_behind_surface_m) * ray_C;
   Vector3f p_L = T_L_C * p_C;
 
+  // Clip the ray to the AABB (which is already clipped to the workspace
+  // bounds). We work in units of blocks, i.e. the AABB spans
+  // [aabb_min, aabb_min + aabb_size]. Rays which only pass through space
+  // outside of the AABB don't touch any block we care about.
+  const Vector3f start_B = T_L_C.translation() / block_size;
+  const Vector3f end_B = p_L / block_size;
+  const Vector3f aabb_min_B = aabb_min.cast<float>();
+  const Vector3f aabb_max_B = (aabb_min + aabb_size).cast<float>();
+  float t_min, t_max;
+  if (!clipSegmentToBox(start_B, end_B, aabb_min_B, aabb_max_B, &t_min,
+                        &t_max)) {
+    return;
+  }
+
   // Now we have the position of the thing in space. Now we need the block
   // index.
   Index3D block_index = getBlockIndexFromPositionInLayer(block_size, p_L);
   setIndexUpdated(block_index, aabb_min, aabb_size, aabb_updated);
 
   // Ok raycast to the correct point in the block.
-  RayCaster raycaster(T_L_C.translation() / block_size, p_L / block_size);
+  const Vector3f direction_B = end_B - start_B;
+  RayCaster raycaster(start_B + t_min * direction_B,
+                      start_B + t_max * direction_B);
   Index3D ray_index = Index3D::Zero();
   while (raycaster.nextRayIndex(&ray_index)) {
     setIndexUpdated(ray_index, aabb_min, aabb_size, aabb_updated);
   }
 }
 
-template <typename SensorType>
+template <typename SensorType, typename DepthFrameType>
 std::vector<Index3D> ViewCalculator::getBlocksInImageViewRaycastTemplate(
-    const MaskedDepthImageConstView& depth_frame, const Transform& T_L_C,
-    const SensorType& camera, const float block_size,
+    const DepthFrameType& depth_frame, const float depth_scale_m,
+    const Transform& T_L_C, const SensorType& camera, const float block_size,
     const float max_integration_distance_behind_surface_m,
     const float max_integration_distance_m) {
   timing::Timer total_timer("view_calculator/raycast");
   // Check cache
   CHECK_NOTNULL(raycasting_viewpoint_cache_);
+  const ViewpointCache::ViewExtent view_extent{
+      block_size, max_integration_distance_m,
+      max_integration_distance_behind_surface_m};
   if (cache_last_viewpoint_) {
-    if (auto cached_result =
-            raycasting_viewpoint_cache_->getCachedResult(T_L_C, camera);
+    if (auto cached_result = raycasting_viewpoint_cache_->getCachedResult(
+            T_L_C, camera, view_extent);
         cached_result.has_value()) {
       return cached_result.value();
     }
   }
 
+  timing::GpuTimer raycast_gpu_timer("view_calculator/raycast", *cuda_stream_);
   timing::Timer setup_timer("view_calculator/raycast/setup");
 
   // Aight so first we have to get the AABB of this guy.
@@ -290,30 +451,41 @@ std::vector<Index3D> ViewCalculator::getBlocksInImageViewRaycastTemplate(
 
   // A 3D grid of bools, one for each block in the AABB, which indicates if it
   // is in the view. The 3D grid is represented as a flat vector.
-  if (aabb_linear_size > aabb_device_buffer_.capacity()) {
+  if (aabb_linear_size > aabb_host_buffer_.capacity()) {
     constexpr float kBufferExpansionFactor = 1.5f;
     const int new_size =
         static_cast<int>(kBufferExpansionFactor * aabb_linear_size);
-    aabb_device_buffer_.reserveAsync(new_size, *cuda_stream_);
+    if (scratch_arena_ == nullptr) {
+      aabb_device_buffer_.reserveAsync(new_size, *cuda_stream_);
+    }
     aabb_host_buffer_.reserveAsync(new_size, *cuda_stream_);
   }
 
-  aabb_device_buffer_.resizeAsync(aabb_linear_size, *cuda_stream_);
-  aabb_device_buffer_.setZeroAsync(*cuda_stream_);
+  bool* aabb_device_ptr = nullptr;
+  if (scratch_arena_ != nullptr) {
+    aabb_device_ptr =
+        scratch_arena_->allocateAsync<bool>(aabb_linear_size, *cuda_stream_);
+  } else {
+    aabb_device_buffer_.resizeAsync(aabb_linear_size, *cuda_stream_);
+    aabb_device_ptr = aabb_device_buffer_.data();
+  }
+  checkCudaErrors(cudaMemsetAsync(aabb_device_ptr, 0,
+                                  sizeof(bool) * aabb_linear_size,
+                                  *cuda_stream_));
   aabb_host_buffer_.resizeAsync(aabb_linear_size, *cuda_stream_);
 
   setup_timer.Stop();
 
   // Raycast
-  getBlocksByRaycastingPixelsAsync(T_L_C, camera, depth_frame, block_size,
-                                   max_integration_distance_behind_surface_m,
-                                   max_integration_distance_m, min_index,
-                                   aabb_size, aabb_device_buffer_.data());
+  getBlocksByRaycastingPixelsAsync(
+      T_L_C, camera, depth_frame, depth_scale_m, block_size,
+      max_integration_distance_behind_surface_m, max_integration_distance_m,
+      min_index, aabb_size, aabb_device_ptr);
 
   // Output vector.
   timing::Timer output_timer("view_calculator/raycast/output");
   checkCudaErrors(cudaMemcpyAsync(
-      aabb_host_buffer_.data(), aabb_device_buffer_.data(),
+      aabb_host_buffer_.data(), aabb_device_ptr,
       sizeof(bool) * aabb_linear_size, cudaMemcpyDeviceToHost, *cuda_stream_));
   cuda_stream_->synchronize();
   checkCudaErrors(cudaPeekAtLastError());
@@ -324,7 +496,7 @@ std::vector<Index3D> ViewCalculator::getBlocksInImageViewRaycastTemplate(
 
   // Cache
   if (cache_last_viewpoint_) {
-    raycasting_viewpoint_cache_->storeResultInCache(T_L_C, camera,
+    raycasting_viewpoint_cache_->storeResultInCache(T_L_C, camera, view_extent,
                                                     output_vector);
   }
   return output_vector;
@@ -337,7 +509,18 @@ std::vector<Index3D> ViewCalculator::getBlocksInImageViewRaycast(
     const float max_integration_distance_behind_surface_m,
     const float max_integration_distance_m) {
   return getBlocksInImageViewRaycastTemplate(
-      depth_frame, T_L_C, camera, block_size,
+      depth_frame, 1.0f, T_L_C, camera, block_size,
+      max_integration_distance_behind_surface_m, max_integration_distance_m);
+}
+
+// Camera (integer depth)
+std::vector<Index3D> ViewCalculator::getBlocksInImageViewRaycast(
+    const MaskedDepthImageU16ConstView& depth_frame, const float depth_scale_m,
+    const Transform& T_L_C, const Camera& camera, const float block_size,
+    const float max_integration_distance_behind_surface_m,
+    const float max_integration_distance_m) {
+  return getBlocksInImageViewRaycastTemplate(
+      depth_frame, depth_scale_m, T_L_C, camera, block_size,
       max_integration_distance_behind_surface_m, max_integration_distance_m);
 }
 
@@ -348,14 +531,15 @@ std::vector<Index3D> ViewCalculator::getBlocksInImageViewRaycast(
     const float max_integration_distance_behind_surface_m,
     const float max_integration_distance_m) {
   return getBlocksInImageViewRaycastTemplate(
-      depth_frame, T_L_C, lidar, block_size,
+      depth_frame, 1.0f, T_L_C, lidar, block_size,
       max_integration_distance_behind_surface_m, max_integration_distance_m);
 }
 
-template <typename SensorType>
+template <typename SensorType, typename DepthFrameType>
 void ViewCalculator::getBlocksByRaycastingPixelsAsync(
     const Transform& T_L_C, const SensorType& camera,
-    const MaskedDepthImageConstView& depth_frame, float block_size,
+    const DepthFrameType& depth_frame, const float depth_scale_m,
+    float block_size,
     const float max_integration_distance_behind_surface_m,
     const float max_integration_distance_m, const Index3D& min_index,
     const Index3D& aabb_size, bool* aabb_updated_cuda) {
@@ -379,16 +563,88 @@ void ViewCalculator::getBlocksByRaycastingPixelsAsync(
   dim3 block_dim(rounded_cols, rounded_rows);
   dim3 thread_dim(kThreadDim, kThreadDim);
 
+  // The per-pixel rays (only available for cameras).
+  const std::shared_ptr<const RayTable> pixel_rays_C =
+      getPixelRays(camera, depth_frame.rows(), depth_frame.cols(),
+                   camera_ray_cache_.get(), *cuda_stream_);
+
+  // The max depth per ray, if a pyramid of this image is available.
+  const int pyramid_level =
+      getPyramidLevel(depth_pyramid_, depth_frame.dataConstPtr(),
+                      depth_frame.rows(), depth_frame.cols(),
+                      static_cast<int>(raycast_subsampling_factor_));
+  const DepthPyramidCell* pyramid_cells =
+      pyramid_level > 0 ? depth_pyramid_->cellsDevicePtr(pyramid_level)
+                        : nullptr;
+  const int pyramid_rows =
+      pyramid_level > 0 ? depth_pyramid_->rows(pyramid_level) : 0;
+  const int pyramid_cols =
+      pyramid_level > 0 ? depth_pyramid_->cols(pyramid_level) : 0;
+
   combinedBlockIndicesInImageKernel<<<block_dim, thread_dim, 0,
                                       *cuda_stream_>>>(
-      T_L_C, camera, depth_frame.dataConstPtr(), depth_frame.rows(),
-      depth_frame.cols(), block_size, max_integration_distance_m,
-      max_integration_distance_behind_surface_m, raycast_subsampling_factor_,
-      min_index, aabb_size, aabb_updated_cuda);
+      T_L_C, camera, depth_frame.dataConstPtr(), depth_scale_m,
+      depth_frame.rows(), depth_frame.cols(), block_size,
+      max_integration_distance_m, max_integration_distance_behind_surface_m,
+      raycast_subsampling_factor_,
+      pixel_rays_C ? pixel_rays_C->data() : nullptr, pyramid_cells,
+      pyramid_rows, pyramid_cols, min_index, aabb_size, aabb_updated_cuda);
   checkCudaErrors(cudaPeekAtLastError());
   combined_kernel_timer.Stop();
 }
 
+namespace {
+
+// The frustum test of getBlocksInViewPlanes() accepts a block if its center
+// p_C lies in front of the camera and projects into the (normalized) viewport.
+// For p_C.z() > 0 this is the intersection of five half-spaces through the
+// camera center, and we represent it by these half-spaces, such that we can
+// classify a group of block centers by the corners of their bounding box.
+class ViewportHalfSpaces {
+ public:
+  // The classification of a group of points.
+  enum class Result { kOutside, kInside, kIntersecting };
+
+  ViewportHalfSpaces(const CameraViewport& normalized_viewport,
+                     float min_distance) {
+    const Vector2f& min = normalized_viewport.min();
+    const Vector2f& max = normalized_viewport.max();
+    normals_[0] = Vector3f(1.0f, 0.0f, -min.x());
+    normals_[1] = Vector3f(-1.0f, 0.0f, max.x());
+    normals_[2] = Vector3f(0.0f, 1.0f, -min.y());
+    normals_[3] = Vector3f(0.0f, -1.0f, max.y());
+    normals_[4] = Vector3f(0.0f, 0.0f, 1.0f);
+    offsets_ = {0.0f, 0.0f, 0.0f, 0.0f, -min_distance};
+  }
+
+  // Classify all points in the convex hull of the passed (camera frame)
+  // points. Points within kTolerance of a boundary are treated as
+  // intersecting, such that the result is never less conservative than testing
+  // each point.
+  Result classify(const std::array<Vector3f, 8>& corners_C) const {
+    constexpr float kTolerance = 1e-3f;
+    bool all_inside = true;
+    for (size_t i = 0; i < normals_.size(); i++) {
+      bool all_outside_of_plane = true;
+      for (const Vector3f& corner_C : corners_C) {
+        const float signed_distance = normals_[i].dot(corner_C) + offsets_[i];
+        all_outside_of_plane &= (signed_distance < -kTolerance);
+        all_inside &= (signed_distance > kTolerance);
+      }
+      if (all_outside_of_plane) {
+        return Result::kOutside;
+      }
+    }
+    return all_inside ? Result::kInside : Result::kIntersecting;
+  }
+
+ private:
+  std::array<Vector3f, 5> normals_;
+  std::array<float, 5> offsets_;
+};
+
+}  // namespace
+
 std::vector<Index3D> ViewCalculator::getBlocksInViewPlanes(
     const Transform& T_L_C, const Camera& camera, const float block_size,
     const float max_distance) {
@@ -396,9 +652,10 @@ std::vector<Index3D> ViewCalculator::getBlocksInViewPlanes(
   timing::Timer("view_calculator/get_blocks_in_view_planes");
   // Check cache
   CHECK_NOTNULL(planes_viewpoint_cache_);
+  const ViewpointCache::ViewExtent view_extent{block_size, max_distance};
   if (cache_last_viewpoint_) {
-    if (auto cached_result =
-            planes_viewpoint_cache_->getCachedResult(T_L_C, camera);
+    if (auto cached_result = planes_viewpoint_cache_->getCachedResult(
+            T_L_C, camera, view_extent);
         cached_result.has_value()) {
       return cached_result.value();
     }
@@ -425,9 +682,6 @@ std::vector<Index3D> ViewCalculator::getBlocksInViewPlanes(
     return std::vector<Index3D>();
   }
 
-  const std::vector<Index3D> block_indices_in_aabb =
-      getBlockIndicesTouchedByBoundingBox(block_size, aabb_L);
-
   // Get the 2D viewport of the camera. We use normalized image
   // coordinates rather than pixels to avoid having to apply the
   // camera intrinsics to each point we want to check. A small margin
@@ -443,8 +697,7 @@ std::vector<Index3D> ViewCalculator::getBlocksInViewPlanes(
   const Eigen::Matrix3f rotation_C_L = T_C_L.rotation();
   const Eigen::Vector3f translation_C_L = T_C_L.translation();
 
-  std::vector<Index3D> block_indices_in_frustum;
-  for (const Index3D& block_index : block_indices_in_aabb) {
+  auto is_block_in_view = [&](const Index3D& block_index) {
     // Transform the block center into camera frame
     const Eigen::Vector3f p3d_layer =
         getCenterPositionFromBlockIndex(block_size, block_index);
@@ -456,22 +709,107 @@ std::vector<Index3D> ViewCalculator::getBlocksInViewPlanes(
       camera.projectToNormalizedCoordinates(p3d_cam, &p2d_normalized_cam);
 
       // Check if the projected point is inside the viewport
-      if (normalized_viewport.contains(p2d_normalized_cam)) {
+      return normalized_viewport.contains(p2d_normalized_cam);
+    }
+    return false;
+  };
+
+  std::vector<Index3D> block_indices_in_frustum;
+  if (!hierarchical_planes_culling_) {
+    const std::vector<Index3D> block_indices_in_aabb =
+        getBlockIndicesTouchedByBoundingBox(block_size, aabb_L);
+    for (const Index3D& block_index : block_indices_in_aabb) {
+      if (is_block_in_view(block_index)) {
         block_indices_in_frustum.push_back(block_index);
       }
     }
+  } else {
+    // Test groups of kGroupSize^3 blocks at once. Groups entirely outside the
+    // view are skipped, groups entirely inside are accepted as a whole, and
+    // only the blocks of the remaining groups are tested one by one.
+    constexpr int kGroupSize = 4;
+    const ViewportHalfSpaces half_spaces(normalized_viewport, kMinDistance);
+    const Index3D aabb_min_index =
+        getBlockIndexFromPositionInLayer(block_size, aabb_L.min());
+    const Index3D aabb_max_index =
+        getBlockIndexFromPositionInLayer(block_size, aabb_L.max());
+    Index3D group_min;
+    for (group_min.x() = aabb_min_index.x();
+         group_min.x() <= aabb_max_index.x(); group_min.x() += kGroupSize) {
+      for (group_min.y() = aabb_min_index.y();
+           group_min.y() <= aabb_max_index.y(); group_min.y() += kGroupSize) {
+        for (group_min.z() = aabb_min_index.z();
+             group_min.z() <= aabb_max_index.z();
+             group_min.z() += kGroupSize) {
+          const Index3D group_max =
+              (group_min + Index3D::Constant(kGroupSize - 1))
+                  .cwiseMin(aabb_max_index);
+
+          // The bounding box of the block centers of the group.
+          const Vector3f min_center_L =
+              getCenterPositionFromBlockIndex(block_size, group_min);
+          const Vector3f max_center_L =
+              getCenterPositionFromBlockIndex(block_size, group_max);
+          std::array<Vector3f, 8> corners_C;
+          for (int i = 0; i < 8; i++) {
+            const Vector3f corner_L((i & 1) ? max_center_L.x()
+                                            : min_center_L.x(),
+                                    (i & 2) ? max_center_L.y()
+                                            : min_center_L.y(),
+                                    (i & 4) ? max_center_L.z()
+                                            : min_center_L.z());
+            corners_C[i] = rotation_C_L * corner_L + translation_C_L;
+          }
+          const ViewportHalfSpaces::Result result =
+              half_spaces.classify(corners_C);
+          if (result == ViewportHalfSpaces::Result::kOutside) {
+            continue;
+          }
+
+          Index3D block_index;
+          for (block_index.x() = group_min.x();
+               block_index.x() <= group_max.x(); block_index.x()++) {
+            for (block_index.y() = group_min.y();
+                 block_index.y() <= group_max.y(); block_index.y()++) {
+              for (block_index.z() = group_min.z();
+                   block_index.z() <= group_max.z(); block_index.z()++) {
+                if (result == ViewportHalfSpaces::Result::kInside ||
+                    is_block_in_view(block_index)) {
+                  block_indices_in_frustum.push_back(block_index);
+                }
+              }
+            }
+          }
+        }
+      }
+    }
   }
   // Cache
   if (cache_last_viewpoint_) {
-    planes_viewpoint_cache_->storeResultInCache(T_L_C, camera,
+    planes_viewpoint_cache_->storeResultInCache(T_L_C, camera, view_extent,
                                                 block_indices_in_frustum);
   }
   return block_indices_in_frustum;
 }
 
+namespace {
+
+bool areViewExtentsEqual(const ViewpointCache::ViewExtent& extent_1,
+                         const ViewpointCache::ViewExtent& extent_2) {
+  return extent_1.block_size == extent_2.block_size &&
+         extent_1.max_distance_m == extent_2.max_distance_m &&
+         extent_1.max_distance_behind_surface_m ==
+             extent_2.max_distance_behind_surface_m;
+}
+
+}  // namespace
+
 std::optional<std::vector<Index3D>> ViewpointCache::getCachedResult(
-    const Transform& T_L_C, const Camera& camera) const {
+    const Transform& T_L_C, const Camera& camera,
+    const ViewExtent& extent) const {
+  std::lock_guard<std::mutex> lock(mutex_);
   CHECK_EQ(camera_cache_.size(), pose_cache_.size());
+  CHECK_EQ(camera_cache_.size(), extent_cache_.size());
   CHECK_EQ(camera_cache_.size(), blocks_in_view_cache_.size());
 
   if (pose_cache_.empty() || camera_cache_.empty()) {
@@ -479,11 +817,12 @@ std::optional<std::vector<Index3D>> ViewpointCache::getCachedResult(
   }
 
   // Iterate through the cache and check if anything fits the
-  // current pose and camera.
+  // current pose, camera and extent.
   bool cache_hit = false;
   size_t cache_hit_idx = 0;
   for (size_t i = 0; i < camera_cache_.size(); i++) {
-    if (areCamerasEqual(camera, camera_cache_[i], T_L_C, pose_cache_[i])) {
+    if (areViewExtentsEqual(extent, extent_cache_[i]) &&
+        areCamerasEqual(camera, camera_cache_[i], T_L_C, pose_cache_[i])) {
       cache_hit = true;
       cache_hit_idx = i;
       break;
@@ -498,19 +837,23 @@ std::optional<std::vector<Index3D>> ViewpointCache::getCachedResult(
 }
 
 std::optional<std::vector<Index3D>> ViewpointCache::getCachedResult(
-    const Transform& T_L_C, const Lidar& lidar) const {
+    const Transform& T_L_C, const Lidar& lidar,
+    const ViewExtent& extent) const {
+  std::lock_guard<std::mutex> lock(mutex_);
   CHECK_EQ(lidar_cache_.size(), pose_cache_.size());
+  CHECK_EQ(lidar_cache_.size(), extent_cache_.size());
   CHECK_EQ(lidar_cache_.size(), blocks_in_view_cache_.size());
   if (pose_cache_.empty() || lidar_cache_.empty()) {
     return std::nullopt;
   }
 
   // Iterate through the cache and check if anything fits the current
-  // pose and lidar.
+  // pose, lidar and extent.
   bool cache_hit = false;
   size_t cache_hit_idx = 0;
   for (size_t i = 0; i < lidar_cache_.size(); i++) {
-    if (areLidarsEqual(lidar, lidar_cache_[i], T_L_C, pose_cache_[i])) {
+    if (areViewExtentsEqual(extent, extent_cache_[i]) &&
+        areLidarsEqual(lidar, lidar_cache_[i], T_L_C, pose_cache_[i])) {
       cache_hit = true;
       cache_hit_idx = i;
       break;
@@ -525,34 +868,42 @@ std::optional<std::vector<Index3D>> ViewpointCache::getCachedResult(
 }
 
 void ViewpointCache::storeResultInCache(
-    const Transform& T_L_C, const Camera& camera,
+    const Transform& T_L_C, const Camera& camera, const ViewExtent& extent,
     const std::vector<Index3D>& blocks_in_view) {
+  std::lock_guard<std::mutex> lock(mutex_);
   CHECK_EQ(camera_cache_.size(), pose_cache_.size());
+  CHECK_EQ(camera_cache_.size(), extent_cache_.size());
   CHECK_EQ(camera_cache_.size(), blocks_in_view_cache_.size());
   if (camera_cache_.size() == kMaxCacheSize) {
     // Remove the oldest element.
     pose_cache_.pop_back();
     camera_cache_.pop_back();
+    extent_cache_.pop_back();
     blocks_in_view_cache_.pop_back();
   }
   pose_cache_.push_front(T_L_C);
   camera_cache_.push_front(camera);
+  extent_cache_.push_front(extent);
   blocks_in_view_cache_.push_front(blocks_in_view);
 }
 
 void ViewpointCache::storeResultInCache(
-    const Transform& T_L_C, const Lidar& lidar,
+    const Transform& T_L_C, const Lidar& lidar, const ViewExtent& extent,
     const std::vector<Index3D>& blocks_in_view) {
+  std::lock_guard<std::mutex> lock(mutex_);
   CHECK_EQ(lidar_cache_.size(), pose_cache_.size());
+  CHECK_EQ(lidar_cache_.size(), extent_cache_.size());
   CHECK_EQ(lidar_cache_.size(), blocks_in_view_cache_.size());
   if (lidar_cache_.size() == kMaxCacheSize) {
     // Remove the oldest element.
     pose_cache_.pop_back();
     lidar_cache_.pop_back();
+    extent_cache_.pop_back();
     blocks_in_view_cache_.pop_back();
   }
   pose_cache_.push_front(T_L_C);
   lidar_cache_.push_front(lidar);
+  extent_cache_.push_front(extent);
   blocks_in_view_cache_.push_front(blocks_in_view);
 }
 
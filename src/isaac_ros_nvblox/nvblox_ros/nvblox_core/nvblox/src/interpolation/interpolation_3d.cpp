@@ -27,15 +27,9 @@ bool interpolateOnCPU(const Vector3f& p_L, const TsdfLayer& layer,
         layer.memory_type() == MemoryType::kUnified)
       << "For CPU-based interpolation, the layer must be CPU accessible (ie "
          "MemoryType::kUnified).";
-  auto get_distance_lambda = [](const TsdfVoxel& voxel) -> float {
-    return voxel.distance;
-  };
-  constexpr float kMinWeight = 1e-4;
-  auto voxel_valid_lambda = [](const TsdfVoxel& voxel) -> bool {
-    return voxel.weight > kMinWeight;
-  };
+  using Member = internal::InterpolatedMember<TsdfVoxel>;
   return internal::interpolateMemberOnCPU<TsdfVoxel>(
-      p_L, layer, get_distance_lambda, voxel_valid_lambda, distance_ptr);
+      p_L, layer, Member::get, Member::isValid, distance_ptr);
 }
 
 bool interpolateOnCPU(const Vector3f& p_L, const EsdfLayer& layer,
@@ -45,14 +39,9 @@ bool interpolateOnCPU(const Vector3f& p_L, const EsdfLayer& layer,
         layer.memory_type() == MemoryType::kUnified)
       << "For CPU-based interpolation, the layer must be CPU accessible (ie "
          "MemoryType::kUnified).";
-  auto get_distance_lambda = [](const EsdfVoxel& voxel) -> float {
-    return std::sqrt(voxel.squared_distance_vox);
-  };
-  auto voxel_valid_lambda = [](const EsdfVoxel& voxel) -> bool {
-    return voxel.observed;
-  };
+  using Member = internal::InterpolatedMember<EsdfVoxel>;
   return internal::interpolateMemberOnCPU<EsdfVoxel>(
-      p_L, layer, get_distance_lambda, voxel_valid_lambda, distance_ptr);
+      p_L, layer, Member::get, Member::isValid, distance_ptr);
 }
 
 bool interpolateOnCPU(const Vector3f& p_L, const OccupancyLayer& layer,
@@ -62,12 +51,9 @@ bool interpolateOnCPU(const Vector3f& p_L, const OccupancyLayer& layer,
         layer.memory_type() == MemoryType::kUnified)
       << "For CPU-based interpolation, the layer must be CPU accessible (ie "
          "MemoryType::kUnified).";
-  auto get_probability_lambda = [](const OccupancyVoxel& voxel) -> float {
-    return probabilityFromLogOdds(voxel.log_odds);
-  };
-  auto voxel_valid_lambda = [](const OccupancyVoxel&) -> bool { return true; };
+  using Member = internal::InterpolatedMember<OccupancyVoxel>;
   return internal::interpolateMemberOnCPU<OccupancyVoxel>(
-      p_L, layer, get_probability_lambda, voxel_valid_lambda, probability_ptr);
+      p_L, layer, Member::get, Member::isValid, probability_ptr);
 }
 
 namespace internal {
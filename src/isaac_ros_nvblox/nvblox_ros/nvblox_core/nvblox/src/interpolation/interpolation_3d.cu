@@ -0,0 +1,227 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "nvblox/interpolation/interpolation_3d.h"
+
+#include "nvblox/core/internal/error_check.h"
+#include "nvblox/gpu_hash/internal/cuda/gpu_indexing.cuh"
+#include "nvblox/utils/timing.h"
+
+namespace nvblox {
+namespace interpolation {
+namespace internal {
+
+// Voxel accessors matching the lambdas used in interpolateOnCPU().
+struct TsdfDistanceAccessor {
+  __device__ float value(const TsdfVoxel& voxel) const {
+    return voxel.distance;
+  }
+  __device__ bool isValid(const TsdfVoxel& voxel) const {
+    constexpr float kMinWeight = 1e-4;
+    return voxel.weight > kMinWeight;
+  }
+};
+
+struct EsdfDistanceAccessor {
+  __device__ float value(const EsdfVoxel& voxel) const {
+    return sqrtf(voxel.squared_distance_vox);
+  }
+  __device__ bool isValid(const EsdfVoxel& voxel) const {
+    return voxel.observed;
+  }
+};
+
+struct OccupancyProbabilityAccessor {
+  __device__ float value(const OccupancyVoxel& voxel) const {
+    return probabilityFromLogOdds(voxel.log_odds);
+  }
+  __device__ bool isValid(const OccupancyVoxel&) const { return true; }
+};
+
+template <typename VoxelType, typename AccessorType>
+__global__ void interpolateKernel(
+    int num_points, Index3DDeviceHashMapType<VoxelBlock<VoxelType>> block_hash,
+    float block_size, float voxel_size, AccessorType accessor,
+    const Vector3f* points_L, float* values, Vector3f* gradients,
+    bool* success_flags) {
+  const int idx = threadIdx.x + blockIdx.x * blockDim.x;
+  if (idx >= num_points) {
+    return;
+  }
+  const Vector3f p_L = points_L[idx];
+
+  // Get the low-side voxel: ie the voxel whose midpoint lies on the low side of
+  // the query point. See getSurroundingVoxels3D().
+  const float half_voxel_size = voxel_size * 0.5f;
+  Index3D low_block_idx;
+  Index3D low_voxel_idx;
+  getBlockAndVoxelIndexFromPositionInLayer(
+      block_size, p_L - half_voxel_size * Vector3f::Ones(), &low_block_idx,
+      &low_voxel_idx);
+  const Vector3f p_corner_L =
+      getPositionFromBlockIndexAndVoxelIndex(block_size, low_block_idx,
+                                             low_voxel_idx) +
+      half_voxel_size * Vector3f::Ones();
+  const Vector3f offset = (p_L - p_corner_L) / voxel_size;
+
+  // Get the values of the 8 surrounding voxels. Neighbouring voxels usually
+  // share a block, so we only go to the hash when the block changes.
+  float corner_values[2][2][2];
+  Index3D cached_block_idx = low_block_idx;
+  const VoxelBlock<VoxelType>* cached_block_ptr =
+      getBlockPtr(block_hash, low_block_idx);
+  for (int x = 0; x < 2; x++) {
+    for (int y = 0; y < 2; y++) {
+      for (int z = 0; z < 2; z++) {
+        Index3D voxel_idx = low_voxel_idx + Index3D(x, y, z);
+        Index3D block_idx = low_block_idx;
+        for (int i = 0; i < 3; i++) {
+          if (voxel_idx[i] == VoxelBlock<VoxelType>::kVoxelsPerSide) {
+            voxel_idx[i] = 0;
+            ++block_idx[i];
+          }
+        }
+        if (block_idx != cached_block_idx) {
+          cached_block_idx = block_idx;
+          cached_block_ptr = getBlockPtr(block_hash, block_idx);
+        }
+        if (cached_block_ptr == nullptr) {
+          success_flags[idx] = false;
+          return;
+        }
+        const VoxelType& voxel =
+            cached_block_ptr
+                ->voxels[voxel_idx.x()][voxel_idx.y()][voxel_idx.z()];
+        if (!accessor.isValid(voxel)) {
+          success_flags[idx] = false;
+          return;
+        }
+        corner_values[x][y][z] = accessor.value(voxel);
+      }
+    }
+  }
+
+  // Trilinear interpolation.
+  const float dx = offset.x();
+  const float dy = offset.y();
+  const float dz = offset.z();
+  const float c00 =
+      corner_values[0][0][0] * (1.0f - dx) + corner_values[1][0][0] * dx;
+  const float c01 =
+      corner_values[0][0][1] * (1.0f - dx) + corner_values[1][0][1] * dx;
+  const float c10 =
+      corner_values[0][1][0] * (1.0f - dx) + corner_values[1][1][0] * dx;
+  const float c11 =
+      corner_values[0][1][1] * (1.0f - dx) + corner_values[1][1][1] * dx;
+  const float c0 = c00 * (1.0f - dy) + c10 * dy;
+  const float c1 = c01 * (1.0f - dy) + c11 * dy;
+  values[idx] = c0 * (1.0f - dz) + c1 * dz;
+  success_flags[idx] = true;
+
+  // The analytical derivative of the above, converted from per-voxel to
+  // per-meter.
+  if (gradients != nullptr) {
+    Vector3f gradient;
+    gradient.x() = ((corner_values[1][0][0] - corner_values[0][0][0]) *
+                        (1.0f - dy) * (1.0f - dz) +
+                    (corner_values[1][1][0] - corner_values[0][1][0]) * dy *
+                        (1.0f - dz) +
+                    (corner_values[1][0][1] - corner_values[0][0][1]) *
+                        (1.0f - dy) * dz +
+                    (corner_values[1][1][1] - corner_values[0][1][1]) * dy *
+                        dz);
+    gradient.y() = (c10 - c00) * (1.0f - dz) + (c11 - c01) * dz;
+    gradient.z() = c1 - c0;
+    gradients[idx] = gradient / voxel_size;
+  }
+}
+
+template <typename VoxelType, typename AccessorType>
+void interpolateOnGPUAsync(const device_vector<Vector3f>& points_L,
+                           const VoxelBlockLayer<VoxelType>& layer,
+                           AccessorType accessor,
+                           device_vector<float>* values_ptr,
+                           device_vector<Vector3f>* gradients_ptr,
+                           device_vector<bool>* success_flags_ptr,
+                           const CudaStream& cuda_stream) {
+  CHECK_NOTNULL(values_ptr);
+  CHECK_NOTNULL(success_flags_ptr);
+  CHECK(layer.memory_type() != MemoryType::kHost)
+      << "For GPU-based interpolation, the layer must be GPU accessible (ie "
+         "MemoryType::kDevice or MemoryType::kUnified).";
+  timing::Timer timer("interpolation/interpolate_on_gpu");
+
+  const int num_points = points_L.size();
+  values_ptr->resizeAsync(num_points, cuda_stream);
+  success_flags_ptr->resizeAsync(num_points, cuda_stream);
+  if (gradients_ptr != nullptr) {
+    gradients_ptr->resizeAsync(num_points, cuda_stream);
+  }
+  if (num_points == 0) {
+    return;
+  }
+
+  constexpr int kNumThreads = 512;
+  const int num_blocks = num_points / kNumThreads + 1;
+  interpolateKernel<VoxelType, AccessorType>
+      <<<num_blocks, kNumThreads, 0, cuda_stream>>>(
+          num_points, layer.getGpuLayerView(cuda_stream).getHash().impl_,
+          layer.block_size(), layer.voxel_size(), accessor, points_L.data(),
+          values_ptr->data(),
+          (gradients_ptr != nullptr) ? gradients_ptr->data() : nullptr,
+          success_flags_ptr->data());
+  checkCudaErrors(cudaPeekAtLastError());
+}
+
+}  // namespace internal
+
+void interpolateOnGPUAsync(const device_vector<Vector3f>& points_L,
+                           const TsdfLayer& layer,
+                           device_vector<float>* distances_ptr,
+                           device_vector<Vector3f>* gradients_ptr,
+                           device_vector<bool>* success_flags_ptr,
+                           const CudaStream& cuda_stream) {
+  internal::interpolateOnGPUAsync(points_L, layer,
+                                  internal::TsdfDistanceAccessor(),
+                                  distances_ptr, gradients_ptr,
+                                  success_flags_ptr, cuda_stream);
+}
+
+void interpolateOnGPUAsync(const device_vector<Vector3f>& points_L,
+                           const EsdfLayer& layer,
+                           device_vector<float>* distances_ptr,
+                           device_vector<Vector3f>* gradients_ptr,
+                           device_vector<bool>* success_flags_ptr,
+                           const CudaStream& cuda_stream) {
+  internal::interpolateOnGPUAsync(points_L, layer,
+                                  internal::EsdfDistanceAccessor(),
+                                  distances_ptr, gradients_ptr,
+                                  success_flags_ptr, cuda_stream);
+}
+
+void interpolateOnGPUAsync(const device_vector<Vector3f>& points_L,
+                           const OccupancyLayer& layer,
+                           device_vector<float>* probabilities_ptr,
+                           device_vector<Vector3f>* gradients_ptr,
+                           device_vector<bool>* success_flags_ptr,
+                           const CudaStream& cuda_stream) {
+  internal::interpolateOnGPUAsync(points_L, layer,
+                                  internal::OccupancyProbabilityAccessor(),
+                                  probabilities_ptr, gradients_ptr,
+                                  success_flags_ptr, cuda_stream);
+}
+
+}  // namespace interpolation
+}  // namespace nvblox
@@ -15,13 +15,16 @@ limitations under the License.
 */
 #include "nvblox/utils/logging.h"
 
+#include "nvblox/map_saving/internal/binary_map_serializer.h"
+#include "nvblox/map_saving/internal/checkpoint_log.h"
 #include "nvblox/map_saving/internal/serializer.h"
 
 namespace nvblox {
 namespace io {
 
 bool writeLayerCakeToFile(const std::string& filename, const LayerCake& cake,
-                          const CudaStream& cuda_stream) {
+                          const CudaStream& cuda_stream, bool compress_blocks,
+                          bool store_derived_layers) {
   registerCommonTypes();
 
   // Truncate and overwrite by default.
@@ -32,14 +35,39 @@ bool writeLayerCakeToFile(const std::string& filename, const LayerCake& cake,
     return false;
   }
 
+  if (compress_blocks) {
+    serializer.block_compression(BlockCompression::kVoxelRuns);
+  }
+  serializer.store_derived_layers(store_derived_layers);
   bool status = serializer.writeLayerCake(cake, cuda_stream);
   serializer.close();
   return status;
 }
 
+bool writeLayerCakeToBinaryFile(const std::string& filename,
+                                const LayerCake& cake,
+                                const CudaStream& cuda_stream) {
+  BinaryMapSerializer serializer;
+  return serializer.writeLayerCake(filename, cake, cuda_stream);
+}
+
 LayerCake loadLayerCakeFromFile(const std::string& filename,
-                                MemoryType memory_type) {
+                                MemoryType memory_type,
+                                bool* derived_layers_consistent) {
   registerCommonTypes();
+  if (derived_layers_consistent != nullptr) {
+    *derived_layers_consistent = false;
+  }
+
+  if (BinaryMapSerializer::isBinaryMapFile(filename)) {
+    BinaryMapSerializer serializer;
+    return serializer.loadLayerCake(filename, memory_type,
+                                    CudaStreamOwning());
+  }
+  if (CheckpointLog::isCheckpointLogFile(filename)) {
+    return CheckpointLog::loadLayerCake(filename, memory_type,
+                                        CudaStreamOwning());
+  }
 
   Serializer serializer(filename, std::ios::in);
 
@@ -49,6 +77,11 @@ LayerCake loadLayerCakeFromFile(const std::string& filename,
   }
 
   LayerCake cake = serializer.loadLayerCake(memory_type, CudaStreamOwning());
+  if (derived_layers_consistent != nullptr) {
+    *derived_layers_consistent =
+        serializer.isConsistentDerivedLayer<EsdfLayer>() &&
+        serializer.isConsistentDerivedLayer<MeshLayer>();
+  }
   serializer.close();
   return cake;
 }
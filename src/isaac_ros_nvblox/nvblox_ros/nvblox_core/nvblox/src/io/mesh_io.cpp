@@ -15,21 +15,109 @@ limitations under the License.
 */
 #include "nvblox/io/mesh_io.h"
 
+#include <fstream>
+#include <future>
+#include <utility>
 #include <vector>
 
+#include "nvblox/core/internal/error_check.h"
 #include "nvblox/io/ply_writer.h"
-#include "nvblox/mesh/mesh.h"
+#include "nvblox/utils/parallel_for.h"
+#include "nvblox/utils/timing.h"
 
 namespace nvblox {
 namespace io {
+namespace {
 
-bool outputMeshLayerToPly(const BlockLayer<MeshBlock>& layer,
-                          const std::string& filename) {
-  // TODO: doesn't support intensity yet!!!!
-  const Mesh mesh = Mesh::fromLayer(layer, CudaStreamOwning());
+// The maximum number of vertices (or triangle indices) staged at once,
+// unless a single block has more.
+constexpr size_t kMaxNumElementsPerChunk = 1 << 18;
+
+// Splits the blocks into chunks of consecutive blocks [begin, end), each
+// holding at most kMaxNumElementsPerChunk elements.
+// @param offsets The index of the first element of each block, followed by
+// the total number of elements.
+std::vector<std::pair<size_t, size_t>> splitIntoChunks(
+    const std::vector<size_t>& offsets) {
+  std::vector<std::pair<size_t, size_t>> chunks;
+  const size_t num_blocks = offsets.size() - 1;
+  size_t begin = 0;
+  while (begin < num_blocks) {
+    size_t end = begin + 1;
+    while (end < num_blocks &&
+           offsets[end + 1] - offsets[begin] <= kMaxNumElementsPerChunk) {
+      ++end;
+    }
+    chunks.emplace_back(begin, end);
+    begin = end;
+  }
+  return chunks;
+}
+
+// Copies one of the vectors of the blocks [begin, end) back to back into
+// host staging memory.
+template <typename T>
+void stageChunkAsync(const std::vector<MeshBlock::ConstPtr>& blocks,
+                     const size_t begin, const size_t end,
+                     unified_vector<T> MeshBlock::*member,
+                     const std::vector<size_t>& offsets,
+                     unified_vector<T>* staging_ptr,
+                     const CudaStream& cuda_stream) {
+  staging_ptr->resizeAsync(offsets[end] - offsets[begin], cuda_stream);
+  for (size_t i = begin; i < end; i++) {
+    const unified_vector<T>& block_vector = (*blocks[i]).*member;
+    if (block_vector.size() == 0) {
+      continue;
+    }
+    checkCudaErrors(cudaMemcpyAsync(
+        staging_ptr->data() + (offsets[i] - offsets[begin]),
+        block_vector.data(), block_vector.size() * sizeof(T),
+        cudaMemcpyDefault, cuda_stream));
+  }
+}
+
+// Writes buffers to a file on a separate thread, such that the next one can
+// be packed meanwhile.
+class AsyncBufferWriter {
+ public:
+  explicit AsyncBufferWriter(std::ofstream* file_ptr) : file_ptr_(file_ptr) {}
+  ~AsyncBufferWriter() { wait(); }
+
+  // The buffer to pack the next chunk into. Not in use by a pending write.
+  std::vector<uint8_t>* nextBuffer() { return &buffers_[next_buffer_idx_]; }
+
+  // Writes the buffer returned by nextBuffer().
+  void writeAsync() {
+    wait();
+    const std::vector<uint8_t>* buffer_ptr = &buffers_[next_buffer_idx_];
+    pending_write_ = std::async(std::launch::async, [this, buffer_ptr]() {
+      file_ptr_->write(reinterpret_cast<const char*>(buffer_ptr->data()),
+                       buffer_ptr->size());
+    });
+    next_buffer_idx_ = 1 - next_buffer_idx_;
+  }
+
+  // Blocks until the pending write (if any) completed.
+  void wait() {
+    if (pending_write_.valid()) {
+      pending_write_.get();
+    }
+  }
+
+ private:
+  std::ofstream* file_ptr_;
+  std::vector<uint8_t> buffers_[2];
+  int next_buffer_idx_ = 0;
+  std::future<void> pending_write_;
+};
+
+}  // namespace
 
+bool outputMeshToPly(const Mesh& mesh, const std::string& filename,
+                     PlyFormat format) {
+  // TODO: doesn't support intensity yet!!!!
   // Create the ply writer object
-  io::PlyWriter writer(filename);
+  io::PlyWriter writer(filename, format);
   writer.setPoints(&mesh.vertices);
   writer.setTriangles(&mesh.triangles);
   if (mesh.normals.size() > 0) {
@@ -41,10 +129,123 @@ bool outputMeshLayerToPly(const BlockLayer<MeshBlock>& layer,
   return writer.write();
 }
 
+bool outputMeshLayerToPly(const BlockLayer<MeshBlock>& layer,
+                          const std::string& filename) {
+  return outputMeshToPly(Mesh::fromLayer(layer, CudaStreamOwning()), filename);
+}
+
 bool outputMeshLayerToPly(const BlockLayer<MeshBlock>& layer,
                           const char* filename) {
   return outputMeshLayerToPly(layer, std::string(filename));
 }
 
+bool outputMeshLayerToBinaryPly(const BlockLayer<MeshBlock>& layer,
+                                const std::string& filename,
+                                const CudaStream& cuda_stream,
+                                int num_threads) {
+  timing::Timer timer("io/output_mesh_layer_to_binary_ply");
+  // Gather the (non-empty) blocks, and where their data goes in the file.
+  std::vector<MeshBlock::ConstPtr> blocks;
+  std::vector<size_t> vertex_offsets = {0};
+  std::vector<size_t> triangle_offsets = {0};
+  PlyHeader header;
+  header.has_normals = true;
+  header.has_colors = true;
+  header.has_triangles = true;
+  for (const Index3D& index : layer.getAllBlockIndices()) {
+    MeshBlock::ConstPtr block = layer.getBlockAtIndex(index);
+    if (block == nullptr || block->vertices.size() == 0) {
+      continue;
+    }
+    header.has_normals &= block->normals.size() == block->vertices.size();
+    header.has_colors &= block->colors.size() == block->vertices.size();
+    vertex_offsets.push_back(vertex_offsets.back() + block->vertices.size());
+    triangle_offsets.push_back(triangle_offsets.back() +
+                               block->triangles.size());
+    blocks.push_back(std::move(block));
+  }
+  header.num_vertices = vertex_offsets.back();
+  header.num_triangles = triangle_offsets.back() / 3;
+  if (header.num_vertices == 0) {
+    LOG(ERROR) << "No points added, nothing to output.";
+    return false;
+  }
+
+  std::ofstream file(filename,
+                     std::ios::out | std::ios::trunc | std::ios::binary);
+  if (!file) {
+    LOG(WARNING) << "Could not open file for PLY output.";
+    return false;
+  }
+  writePlyHeader(header, PlyFormat::kBinaryLittleEndian, &file);
+
+  // Pinned staging memory, reused by all chunks.
+  unified_vector<Vector3f> vertices(MemoryType::kHost);
+  unified_vector<Vector3f> normals(MemoryType::kHost);
+  unified_vector<Color> colors(MemoryType::kHost);
+  unified_vector<int> triangles(MemoryType::kHost);
+  AsyncBufferWriter writer(&file);
+
+  // All vertices come first.
+  const size_t vertex_size = binaryPlyVertexSize(header);
+  for (const auto& chunk : splitIntoChunks(vertex_offsets)) {
+    const size_t begin = chunk.first;
+    const size_t end = chunk.second;
+    stageChunkAsync(blocks, begin, end, &MeshBlock::vertices, vertex_offsets,
+                    &vertices, cuda_stream);
+    if (header.has_normals) {
+      stageChunkAsync(blocks, begin, end, &MeshBlock::normals, vertex_offsets,
+                      &normals, cuda_stream);
+    }
+    if (header.has_colors) {
+      stageChunkAsync(blocks, begin, end, &MeshBlock::colors, vertex_offsets,
+                      &colors, cuda_stream);
+    }
+    cuda_stream.synchronize();
+    std::vector<uint8_t>* buffer_ptr = writer.nextBuffer();
+    buffer_ptr->resize(vertices.size() * vertex_size);
+    parallelFor(vertices.size(), num_threads,
+                [&](const size_t chunk_begin, const size_t chunk_end) {
+                  for (size_t i = chunk_begin; i < chunk_end; i++) {
+                    packBinaryPlyVertex(
+                        header, vertices[i],
+                        header.has_normals ? &normals[i] : nullptr, nullptr,
+                        header.has_colors ? &colors[i] : nullptr,
+                        buffer_ptr->data() + i * vertex_size);
+                  }
+                });
+    writer.writeAsync();
+  }
+
+  // Then the triangles, whose vertex indices are offset by the vertices of
+  // the preceding blocks.
+  for (const auto& chunk : splitIntoChunks(triangle_offsets)) {
+    const size_t begin = chunk.first;
+    const size_t end = chunk.second;
+    stageChunkAsync(blocks, begin, end, &MeshBlock::triangles,
+                    triangle_offsets, &triangles, cuda_stream);
+    cuda_stream.synchronize();
+    std::vector<uint8_t>* buffer_ptr = writer.nextBuffer();
+    buffer_ptr->resize(triangles.size() / 3 * kBinaryPlyTriangleSize);
+    const size_t first_index = triangle_offsets[begin];
+    parallelFor(end - begin, num_threads,
+                [&](const size_t chunk_begin, const size_t chunk_end) {
+                  for (size_t i = begin + chunk_begin; i < begin + chunk_end;
+                       i++) {
+                    for (size_t t = triangle_offsets[i] - first_index;
+                         t < triangle_offsets[i + 1] - first_index; t += 3) {
+                      packBinaryPlyTriangle(
+                          triangles.data() + t,
+                          static_cast<int>(vertex_offsets[i]),
+                          buffer_ptr->data() + t / 3 * kBinaryPlyTriangleSize);
+                    }
+                  }
+                });
+    writer.writeAsync();
+  }
+  writer.wait();
+  return static_cast<bool>(file);
+}
+
 }  // namespace io
 }  // namespace nvblox
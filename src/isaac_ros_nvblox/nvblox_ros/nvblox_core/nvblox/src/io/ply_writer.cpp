@@ -17,6 +17,8 @@ limitations under the License.
 
 #include "nvblox/io/ply_writer.h"
 
+#include <cstring>
+
 namespace nvblox {
 namespace io {
 
@@ -47,51 +49,144 @@ bool PlyWriter::write() {
   }
   // Triangles can be whatever size they like.
 
-  // Output the header first.
-  writeHeader();
-
-  // Then output all the points.
-  writePoints();
+  const PlyHeader ply_header = header();
+  writePlyHeader(ply_header, format_, &file_);
+  if (format_ == PlyFormat::kBinaryLittleEndian) {
+    writePointsBinary(ply_header);
+    writeTrianglesBinary();
+  } else {
+    // Then output all the points.
+    writePoints();
+
+    // Then triangles.
+    writeTriangles();
+  }
 
-  // Then triangles.
-  writeTriangles();
+  return static_cast<bool>(file_);
+}
 
-  return true;
+PlyHeader PlyWriter::header() const {
+  PlyHeader ply_header;
+  ply_header.num_vertices = points_->size();
+  ply_header.has_normals = normals_ != nullptr;
+  ply_header.has_intensities = intensities_ != nullptr;
+  ply_header.has_colors = colors_ != nullptr;
+  ply_header.has_triangles = triangles_ != nullptr;
+  ply_header.num_triangles = triangles_ ? triangles_->size() / 3 : 0;
+  return ply_header;
 }
 
-void PlyWriter::writeHeader() {
-  file_ << "ply" << std::endl;
-  file_ << "format ascii 1.0" << std::endl;
-  file_ << "element vertex " << points_->size() << std::endl;
-  file_ << "property float x" << std::endl;
-  file_ << "property float y" << std::endl;
-  file_ << "property float z" << std::endl;
+void writePlyHeader(const PlyHeader& header, PlyFormat format,
+                    std::ostream* out) {
+  CHECK_NOTNULL(out);
+  std::ostream& file = *out;
+  file << "ply" << std::endl;
+  if (format == PlyFormat::kBinaryLittleEndian) {
+    file << "format binary_little_endian 1.0" << std::endl;
+  } else {
+    file << "format ascii 1.0" << std::endl;
+  }
+  file << "element vertex " << header.num_vertices << std::endl;
+  file << "property float x" << std::endl;
+  file << "property float y" << std::endl;
+  file << "property float z" << std::endl;
 
-  if (normals_) {
+  if (header.has_normals) {
     // TODO: should this be normal_x or nx?
-    file_ << "property float nx" << std::endl;
-    file_ << "property float ny" << std::endl;
-    file_ << "property float nz" << std::endl;
+    file << "property float nx" << std::endl;
+    file << "property float ny" << std::endl;
+    file << "property float nz" << std::endl;
   }
 
-  if (intensities_) {
-    file_ << "property float intensity" << std::endl;
+  if (header.has_intensities) {
+    file << "property float intensity" << std::endl;
   }
 
-  if (colors_) {
-    file_ << "property uchar red" << std::endl;
-    file_ << "property uchar green" << std::endl;
-    file_ << "property uchar blue" << std::endl;
+  if (header.has_colors) {
+    file << "property uchar red" << std::endl;
+    file << "property uchar green" << std::endl;
+    file << "property uchar blue" << std::endl;
   }
 
-  if (triangles_) {
+  if (header.has_triangles) {
     // TODO: check if "vertex_index" or "vertex_indices"
-    file_ << "element face " << triangles_->size() / 3 << std::endl;
-    file_ << "property list uchar int vertex_indices"
-          << std::endl;  // pcl-1.7(ros::kinetic) breaks ply convention by not
-                         // using "vertex_index"
+    file << "element face " << header.num_triangles << std::endl;
+    file << "property list uchar int vertex_indices"
+         << std::endl;  // pcl-1.7(ros::kinetic) breaks ply convention by not
+                        // using "vertex_index"
+  }
+  file << "end_header" << std::endl;
+}
+
+size_t binaryPlyVertexSize(const PlyHeader& header) {
+  size_t size = 3 * sizeof(float);
+  if (header.has_normals) {
+    size += 3 * sizeof(float);
+  }
+  if (header.has_intensities) {
+    size += sizeof(float);
+  }
+  if (header.has_colors) {
+    size += 3 * sizeof(uint8_t);
+  }
+  return size;
+}
+
+// NOTE: The values are copied as they are, which matches the file format on
+// the (little-endian) platforms we support.
+void packBinaryPlyVertex(const PlyHeader& header, const Vector3f& point,
+                         const Vector3f* normal, const float* intensity,
+                         const Color* color, uint8_t* dst) {
+  std::memcpy(dst, point.data(), 3 * sizeof(float));
+  dst += 3 * sizeof(float);
+  if (header.has_normals) {
+    std::memcpy(dst, normal->data(), 3 * sizeof(float));
+    dst += 3 * sizeof(float);
+  }
+  if (header.has_intensities) {
+    std::memcpy(dst, intensity, sizeof(float));
+    dst += sizeof(float);
+  }
+  if (header.has_colors) {
+    dst[0] = color->r;
+    dst[1] = color->g;
+    dst[2] = color->b;
+  }
+}
+
+void packBinaryPlyTriangle(const int* triangle, int vertex_offset,
+                           uint8_t* dst) {
+  dst[0] = 3;
+  for (int j = 0; j < 3; j++) {
+    const int vertex_index = triangle[j] + vertex_offset;
+    std::memcpy(dst + 1 + j * sizeof(int), &vertex_index, sizeof(int));
+  }
+}
+
+void PlyWriter::writePointsBinary(const PlyHeader& header) {
+  const size_t vertex_size = binaryPlyVertexSize(header);
+  std::vector<uint8_t> buffer(points_->size() * vertex_size);
+  for (size_t i = 0; i < points_->size(); i++) {
+    packBinaryPlyVertex(header, (*points_)[i],
+                        normals_ ? &(*normals_)[i] : nullptr,
+                        intensities_ ? &(*intensities_)[i] : nullptr,
+                        colors_ ? &(*colors_)[i] : nullptr,
+                        buffer.data() + i * vertex_size);
+  }
+  file_.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+}
+
+void PlyWriter::writeTrianglesBinary() {
+  if (triangles_ == nullptr) {
+    return;
+  }
+  const size_t num_triangles = triangles_->size() / 3;
+  std::vector<uint8_t> buffer(num_triangles * kBinaryPlyTriangleSize);
+  for (size_t i = 0; i < num_triangles; i++) {
+    packBinaryPlyTriangle(triangles_->data() + 3 * i, 0,
+                          buffer.data() + i * kBinaryPlyTriangleSize);
   }
-  file_ << "end_header" << std::endl;
+  file_.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
 }
 
 void PlyWriter::writePoints() {
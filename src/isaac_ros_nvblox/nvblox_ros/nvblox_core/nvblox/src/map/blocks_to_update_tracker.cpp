@@ -19,7 +19,8 @@ namespace nvblox {
 
 /// Safety vent if size is growing too much. This should not happen as long as
 /// the indices are consumed.
-void clearIfTooLarge(Index3DSet& set, const std::string& name) {
+template <typename IndexCollectionType>
+void clearIfTooLarge(IndexCollectionType& set, const std::string& name) {
   constexpr size_t kMaxSize = 100'000;
   if (set.size() > kMaxSize) {
     LOG(ERROR) << "IndexSet " << name << " is too large: " << set.size()
@@ -31,21 +32,61 @@ void clearIfTooLarge(Index3DSet& set, const std::string& name) {
 
 void BlocksToUpdateTracker::addBlocksToUpdate(
     const std::vector<Index3D>& blocks_to_update) {
+  VoxelBlockMask all_voxels;
+  all_voxels.setAll();
+  addBlocksToUpdate(blocks_to_update, std::vector<VoxelBlockMask>(
+                                          blocks_to_update.size(), all_voxels));
+}
+
+void BlocksToUpdateTracker::addBlocksToUpdate(
+    const std::vector<Index3D>& blocks_to_update,
+    const std::vector<VoxelBlockMask>& updated_voxel_masks) {
+  CHECK_EQ(blocks_to_update.size(), updated_voxel_masks.size());
   // Function definition to update blocks.
-  auto funct = [&](const std::vector<Index3D> vec) -> void {
+  auto funct = [&](const std::vector<Index3D> vec,
+                   const std::vector<VoxelBlockMask> masks) -> void {
     esdf_blocks_to_update_.insert(vec.begin(), vec.end());
     mesh_blocks_to_update_.insert(vec.begin(), vec.end());
     layer_streamer_blocks_to_update_.insert(vec.begin(), vec.end());
+    if (track_checkpoint_blocks_) {
+      checkpoint_blocks_to_update_.insert(vec.begin(), vec.end());
+    }
+    if (track_ground_plane_blocks_) {
+      ground_plane_blocks_to_update_.insert(vec.begin(), vec.end());
+    }
 
     if (hasFreespaceLayer(projective_layer_type_)) {
       freespace_blocks_to_update_.insert(vec.begin(), vec.end());
     }
+
+    for (size_t i = 0; i < vec.size(); i++) {
+      if (masks[i].any()) {
+        mesh_changed_voxel_masks_[vec[i]] |= masks[i];
+      }
+    }
   };
 
   clearIfTooLarge(esdf_blocks_to_update_, "esdf");
   clearIfTooLarge(mesh_blocks_to_update_, "mesh");
   clearIfTooLarge(layer_streamer_blocks_to_update_, "layer_streamer");
   clearIfTooLarge(freespace_blocks_to_update_, "freespace");
+  clearIfTooLarge(mesh_changed_voxel_masks_, "mesh_changed_voxel_masks");
+
+  // Synchronize (wait for other async calls to finish) and
+  // then call the update function asynchronous.
+  future_.wait();
+  future_ = std::async(std::launch::async, funct, blocks_to_update,
+                       updated_voxel_masks);
+}
+
+void BlocksToUpdateTracker::addColorBlocksToUpdate(
+    const std::vector<Index3D>& blocks_to_update) {
+  // Function definition to update blocks.
+  auto funct = [&](const std::vector<Index3D> vec) -> void {
+    mesh_color_blocks_to_update_.insert(vec.begin(), vec.end());
+  };
+
+  clearIfTooLarge(mesh_color_blocks_to_update_, "mesh_color");
 
   // Synchronize (wait for other async calls to finish) and
   // then call the update function asynchronous.
@@ -60,7 +101,16 @@ void BlocksToUpdateTracker::removeBlocksToUpdate(
     for (const Index3D& idx : vec) {
       esdf_blocks_to_update_.erase(idx);
       mesh_blocks_to_update_.erase(idx);
+      mesh_changed_voxel_masks_.erase(idx);
+      mesh_color_blocks_to_update_.erase(idx);
       layer_streamer_blocks_to_update_.erase(idx);
+      // Removed blocks have to be removed from the checkpoint as well.
+      if (track_checkpoint_blocks_) {
+        checkpoint_blocks_to_update_.insert(idx);
+      }
+      if (track_ground_plane_blocks_) {
+        ground_plane_blocks_to_update_.insert(idx);
+      }
 
       if (hasFreespaceLayer(projective_layer_type_)) {
         freespace_blocks_to_update_.erase(idx);
@@ -91,12 +141,59 @@ std::vector<Index3D> BlocksToUpdateTracker::getBlocksToUpdate(
     case BlocksToUpdateType::kLayerStreamer:
       return {layer_streamer_blocks_to_update_.begin(),
               layer_streamer_blocks_to_update_.end()};
+    case BlocksToUpdateType::kCheckpoint:
+      return {checkpoint_blocks_to_update_.begin(),
+              checkpoint_blocks_to_update_.end()};
+    case BlocksToUpdateType::kGroundPlane:
+      return {ground_plane_blocks_to_update_.begin(),
+              ground_plane_blocks_to_update_.end()};
+    case BlocksToUpdateType::kMeshColor:
+      return {mesh_color_blocks_to_update_.begin(),
+              mesh_color_blocks_to_update_.end()};
     default:
       LOG(FATAL) << "BlocksToUpdateType not implemented";
       break;
   }
 }
 
+std::vector<Index3D> BlocksToUpdateTracker::getMeshBlocksToRemesh() const {
+  // Synchronize (wait for async calls modifying the update sets to finish).
+  future_.wait();
+
+  constexpr int kVoxelsPerSide = VoxelBlock<bool>::kVoxelsPerSide;
+  Index3DSet blocks_to_remesh;
+  for (const auto& [block_idx, mask] : mesh_changed_voxel_masks_) {
+    blocks_to_remesh.insert(block_idx);
+
+    // The cube at a voxel spans the voxel and its neighbors in the positive
+    // directions. Changed voxels on the lower faces of the block therefore
+    // also affect cubes of the neighboring blocks below. We encode these
+    // neighbors by bit i of the offset code being a step of -1 along axis i.
+    bool is_neighbor_affected[8] = {false};
+    for (int bit = 0; bit < VoxelBlock<bool>::kNumVoxels; bit++) {
+      if (!mask.isSet(bit)) {
+        continue;
+      }
+      const int x = bit / (kVoxelsPerSide * kVoxelsPerSide);
+      const int y = (bit / kVoxelsPerSide) % kVoxelsPerSide;
+      const int z = bit % kVoxelsPerSide;
+      const int lower_faces = (x == 0) | ((y == 0) << 1) | ((z == 0) << 2);
+      for (int code = 1; code < 8; code++) {
+        if ((code & lower_faces) == code) {
+          is_neighbor_affected[code] = true;
+        }
+      }
+    }
+    for (int code = 1; code < 8; code++) {
+      if (is_neighbor_affected[code]) {
+        blocks_to_remesh.insert(block_idx - Index3D(code & 1, (code >> 1) & 1,
+                                                    (code >> 2) & 1));
+      }
+    }
+  }
+  return {blocks_to_remesh.begin(), blocks_to_remesh.end()};
+}
+
 void BlocksToUpdateTracker::markBlocksAsUpdated(
     BlocksToUpdateType blocks_to_update_type) {
   // Function definition to mark blocks as updated.
@@ -107,6 +204,7 @@ void BlocksToUpdateTracker::markBlocksAsUpdated(
         break;
       case BlocksToUpdateType::kMesh:
         mesh_blocks_to_update_.clear();
+        mesh_changed_voxel_masks_.clear();
         break;
       case BlocksToUpdateType::kFreespace:
         freespace_blocks_to_update_.clear();
@@ -114,6 +212,15 @@ void BlocksToUpdateTracker::markBlocksAsUpdated(
       case BlocksToUpdateType::kLayerStreamer:
         layer_streamer_blocks_to_update_.clear();
         break;
+      case BlocksToUpdateType::kCheckpoint:
+        checkpoint_blocks_to_update_.clear();
+        break;
+      case BlocksToUpdateType::kGroundPlane:
+        ground_plane_blocks_to_update_.clear();
+        break;
+      case BlocksToUpdateType::kMeshColor:
+        mesh_color_blocks_to_update_.clear();
+        break;
       default:
         LOG(FATAL) << "BlocksToUpdateType not implemented";
         break;
@@ -126,4 +233,30 @@ void BlocksToUpdateTracker::markBlocksAsUpdated(
   future_ = std::async(std::launch::async, funct, blocks_to_update_type);
 }
 
+void BlocksToUpdateTracker::trackCheckpointBlocks(
+    bool track_checkpoint_blocks) {
+  auto funct = [&](bool track) -> void {
+    track_checkpoint_blocks_ = track;
+    checkpoint_blocks_to_update_.clear();
+  };
+
+  // Synchronize (wait for other async calls to finish) and
+  // then call the function asynchronous.
+  future_.wait();
+  future_ = std::async(std::launch::async, funct, track_checkpoint_blocks);
+}
+
+void BlocksToUpdateTracker::trackGroundPlaneBlocks(
+    bool track_ground_plane_blocks) {
+  auto funct = [&](bool track) -> void {
+    track_ground_plane_blocks_ = track;
+    ground_plane_blocks_to_update_.clear();
+  };
+
+  // Synchronize (wait for other async calls to finish) and
+  // then call the function asynchronous.
+  future_.wait();
+  future_ = std::async(std::launch::async, funct, track_ground_plane_blocks);
+}
+
 }  // namespace nvblox
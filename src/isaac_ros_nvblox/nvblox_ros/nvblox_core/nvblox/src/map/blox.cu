@@ -20,23 +20,23 @@ namespace nvblox {
 
 // Must be called with:
 // - a single block
-// - one thread per voxel
+// - kVoxelsPerSide x kVoxelsPerSide x kThreadBlockDepth threads
 __global__ void setColorBlockGray(ColorBlock* block_device_ptr) {
-  ColorVoxel* voxel_ptr =
-      &block_device_ptr->voxels[threadIdx.z][threadIdx.y][threadIdx.x];
-  // NOTE(dtingdahl): This is identical to the CPU initialization defined in
-  // voxels.h
-  voxel_ptr->color.r = 127;
-  voxel_ptr->color.g = 127;
-  voxel_ptr->color.b = 127;
-  voxel_ptr->color.a = 255;
-  voxel_ptr->weight = 0.0f;
+  for (int x = threadIdx.z; x < ColorBlock::kVoxelsPerSide; x += blockDim.z) {
+    ColorVoxel* voxel_ptr =
+        &block_device_ptr->voxels[x][threadIdx.y][threadIdx.x];
+    // NOTE(dtingdahl): This is identical to the CPU initialization defined in
+    // voxels.h
+    voxel_ptr->color = Color::Gray();
+    voxel_ptr->weight = 0.0f;
+  }
 }
 
 void setColorBlockGrayOnGPUAsync(ColorBlock* block_device_ptr,
                                  const CudaStream& cuda_stream) {
   constexpr int kVoxelsPerSide = VoxelBlock<bool>::kVoxelsPerSide;
-  const dim3 kThreadsPerBlock(kVoxelsPerSide, kVoxelsPerSide, kVoxelsPerSide);
+  const dim3 kThreadsPerBlock(kVoxelsPerSide, kVoxelsPerSide,
+                              VoxelBlock<bool>::kThreadBlockDepth);
   setColorBlockGray<<<1, kThreadsPerBlock, 0, cuda_stream>>>(block_device_ptr);
   checkCudaErrors(cudaPeekAtLastError());
 }
@@ -46,8 +46,10 @@ __global__ void initializeBlocksKernel(BlockType** block_ptrs, int num_blocks) {
   const int block_idx = blockIdx.x;
 
   if (block_idx < num_blocks) {
-    block_ptrs[block_idx]->voxels[threadIdx.z][threadIdx.y][threadIdx.x] =
-        BlockType::VoxelType();
+    for (int x = threadIdx.z; x < BlockType::kVoxelsPerSide; x += blockDim.z) {
+      block_ptrs[block_idx]->voxels[x][threadIdx.y][threadIdx.x] =
+          BlockType::VoxelType();
+    }
   }
 }
 
@@ -61,7 +63,7 @@ void initializeBlocksAsync(host_vector<BlockType*>& blocks,
 
   const dim3 threads_per_block = {BlockType::kVoxelsPerSide,
                                   BlockType::kVoxelsPerSide,
-                                  BlockType::kVoxelsPerSide};
+                                  BlockType::kThreadBlockDepth};
   const int num_blocks = blocks.size();
 
   initializeBlocksKernel<BlockType>
@@ -69,6 +71,44 @@ void initializeBlocksAsync(host_vector<BlockType*>& blocks,
                                                           blocks.size());
 }
 
+// Must be called with:
+// - one thread block per copied block
+template <typename WordType>
+__global__ void copyBlocksKernel(const void* const* src_blocks,
+                                 void* const* dst_blocks,
+                                 const int num_words_per_block) {
+  const WordType* src = static_cast<const WordType*>(src_blocks[blockIdx.x]);
+  WordType* dst = static_cast<WordType*>(dst_blocks[blockIdx.x]);
+  for (int i = threadIdx.x; i < num_words_per_block; i += blockDim.x) {
+    dst[i] = src[i];
+  }
+}
+
+void copyBlocksAsync(const device_vector<const void*>& src_blocks,
+                     const device_vector<void*>& dst_blocks,
+                     const size_t num_bytes_per_block,
+                     const CudaStream& cuda_stream) {
+  CHECK_EQ(src_blocks.size(), dst_blocks.size());
+  if (src_blocks.empty()) {
+    return;
+  }
+  constexpr int kThreadsPerBlock = 256;
+  const int num_blocks = src_blocks.size();
+  // Blocks are (at least) word aligned. Copy words where the block size
+  // allows for it.
+  if (num_bytes_per_block % sizeof(uint32_t) == 0) {
+    const int num_words = num_bytes_per_block / sizeof(uint32_t);
+    copyBlocksKernel<uint32_t>
+        <<<num_blocks, kThreadsPerBlock, 0, cuda_stream>>>(
+            src_blocks.data(), dst_blocks.data(), num_words);
+  } else {
+    copyBlocksKernel<uint8_t>
+        <<<num_blocks, kThreadsPerBlock, 0, cuda_stream>>>(
+            src_blocks.data(), dst_blocks.data(), num_bytes_per_block);
+  }
+  checkCudaErrors(cudaPeekAtLastError());
+}
+
 // Specialization for meshblock
 template <>
 void initializeBlocksAsync(host_vector<MeshBlock*>& blocks,
@@ -98,5 +138,11 @@ template void initializeBlocksAsync<FreespaceBlock>(
 template void initializeBlocksAsync<EsdfBlock>(host_vector<EsdfBlock*>& blocks,
                                                const CudaStream& cuda_stream,
                                                const MemoryType memory_type);
+template void initializeBlocksAsync<CompactEsdfBlock>(
+    host_vector<CompactEsdfBlock*>& blocks, const CudaStream& cuda_stream,
+    const MemoryType memory_type);
+template void initializeBlocksAsync<LabelBlock>(
+    host_vector<LabelBlock*>& blocks, const CudaStream& cuda_stream,
+    const MemoryType memory_type);
 
 }  // namespace nvblox
@@ -0,0 +1,220 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "nvblox/map/gpu_blocks_to_update_tracker.h"
+
+#include "nvblox/core/internal/error_check.h"
+#include "nvblox/gpu_hash/internal/cuda/gpu_set.cuh"
+
+namespace nvblox {
+
+namespace {
+
+constexpr int kThreadsPerBlock = 256;
+
+int numThreadBlocks(int num_blocks) {
+  return (num_blocks + kThreadsPerBlock - 1) / kThreadsPerBlock;
+}
+
+}  // namespace
+
+__global__ void insertBlocksKernel(const Index3D* block_indices,
+                                   const int num_blocks,
+                                   Index3DDeviceSetType set) {
+  const int idx = blockIdx.x * blockDim.x + threadIdx.x;
+  if (idx < num_blocks) {
+    set.insert(block_indices[idx]);
+  }
+}
+
+__global__ void eraseBlocksKernel(const Index3D* block_indices,
+                                  const int num_blocks,
+                                  Index3DDeviceSetType set) {
+  const int idx = blockIdx.x * blockDim.x + threadIdx.x;
+  if (idx < num_blocks) {
+    set.erase(block_indices[idx]);
+  }
+}
+
+GpuBlocksToUpdateTracker::GpuBlocksToUpdateTracker(
+    ProjectiveLayerType projective_layer_type)
+    : projective_layer_type_(projective_layer_type) {
+  for (int i = 0; i < kNumTypes; ++i) {
+    sets_[i] = std::make_unique<Index3DDeviceSet>(kInitialCapacity);
+    capacities_[i] = kInitialCapacity;
+    max_sizes_[i] = 0;
+  }
+}
+
+// Defined here, where Index3DDeviceSet is complete.
+GpuBlocksToUpdateTracker::~GpuBlocksToUpdateTracker() = default;
+
+bool GpuBlocksToUpdateTracker::isTracked(BlocksToUpdateType type) const {
+  switch (type) {
+    case BlocksToUpdateType::kFreespace:
+      return hasFreespaceLayer(projective_layer_type_);
+    case BlocksToUpdateType::kCheckpoint:
+      return track_checkpoint_blocks_;
+    case BlocksToUpdateType::kGroundPlane:
+      return track_ground_plane_blocks_;
+    default:
+      return true;
+  }
+}
+
+void GpuBlocksToUpdateTracker::reserveForInsertion(
+    int type_idx, size_t num_blocks, const CudaStream& cuda_stream) {
+  // Keep the load factor of the sets at most 1/2.
+  constexpr size_t kMaxLoadFactorInverse = 2;
+  if ((max_sizes_[type_idx] + num_blocks) * kMaxLoadFactorInverse <=
+      capacities_[type_idx]) {
+    max_sizes_[type_idx] += num_blocks;
+    return;
+  }
+  // Refresh the upper bound with the actual size.
+  cuda_stream.synchronize();
+  Index3DDeviceSet& set = *sets_[type_idx];
+  max_sizes_[type_idx] = set.set.size() + num_blocks;
+  if (max_sizes_[type_idx] * kMaxLoadFactorInverse <= capacities_[type_idx]) {
+    return;
+  }
+  // Grow the set and re-insert its blocks.
+  copySetToDeviceVectorAsync(set.set, &grow_buffer_, cuda_stream);
+  cuda_stream.synchronize();
+  while (max_sizes_[type_idx] * kMaxLoadFactorInverse >
+         capacities_[type_idx]) {
+    capacities_[type_idx] *= 2;
+  }
+  set.resize(capacities_[type_idx]);
+  if (!grow_buffer_.empty()) {
+    insertBlocksKernel<<<numThreadBlocks(grow_buffer_.size()),
+                         kThreadsPerBlock, 0, cuda_stream>>>(
+        grow_buffer_.data(), grow_buffer_.size(), set.set);
+    checkCudaErrors(cudaPeekAtLastError());
+  }
+}
+
+void GpuBlocksToUpdateTracker::insertBlocksAsync(
+    int type_idx, const Index3D* blocks, int num_blocks,
+    const CudaStream& cuda_stream) {
+  reserveForInsertion(type_idx, num_blocks, cuda_stream);
+  insertBlocksKernel<<<numThreadBlocks(num_blocks), kThreadsPerBlock, 0,
+                       cuda_stream>>>(blocks, num_blocks, sets_[type_idx]->set);
+  checkCudaErrors(cudaPeekAtLastError());
+}
+
+void GpuBlocksToUpdateTracker::addBlocksToUpdateAsync(
+    const Index3D* blocks_to_update, int num_blocks,
+    const CudaStream& cuda_stream) {
+  if (num_blocks == 0) {
+    return;
+  }
+  CHECK_NOTNULL(blocks_to_update);
+  for (int i = 0; i < kNumTypes; ++i) {
+    const BlocksToUpdateType type = static_cast<BlocksToUpdateType>(i);
+    // Color blocks are only added by addColorBlocksToUpdateAsync().
+    if (!isTracked(type) || type == BlocksToUpdateType::kMeshColor) {
+      continue;
+    }
+    insertBlocksAsync(i, blocks_to_update, num_blocks, cuda_stream);
+  }
+}
+
+void GpuBlocksToUpdateTracker::addBlocksToUpdateAsync(
+    const device_vector<Index3D>& blocks_to_update,
+    const CudaStream& cuda_stream) {
+  addBlocksToUpdateAsync(blocks_to_update.data(), blocks_to_update.size(),
+                         cuda_stream);
+}
+
+void GpuBlocksToUpdateTracker::addColorBlocksToUpdateAsync(
+    const device_vector<Index3D>& blocks_to_update,
+    const CudaStream& cuda_stream) {
+  if (blocks_to_update.empty()) {
+    return;
+  }
+  insertBlocksAsync(static_cast<int>(BlocksToUpdateType::kMeshColor),
+                    blocks_to_update.data(), blocks_to_update.size(),
+                    cuda_stream);
+}
+
+void GpuBlocksToUpdateTracker::removeBlocksToUpdateAsync(
+    const device_vector<Index3D>& blocks_to_remove,
+    const CudaStream& cuda_stream) {
+  if (blocks_to_remove.empty()) {
+    return;
+  }
+  const int num_blocks = blocks_to_remove.size();
+  for (int i = 0; i < kNumTypes; ++i) {
+    const BlocksToUpdateType type = static_cast<BlocksToUpdateType>(i);
+    if (!isTracked(type)) {
+      continue;
+    }
+    // Removed blocks have to be removed from the checkpoint (and the ground
+    // plane) as well.
+    if (type == BlocksToUpdateType::kCheckpoint ||
+        type == BlocksToUpdateType::kGroundPlane) {
+      insertBlocksAsync(i, blocks_to_remove.data(), num_blocks, cuda_stream);
+    } else {
+      eraseBlocksKernel<<<numThreadBlocks(num_blocks), kThreadsPerBlock, 0,
+                          cuda_stream>>>(blocks_to_remove.data(), num_blocks,
+                                         sets_[i]->set);
+      checkCudaErrors(cudaPeekAtLastError());
+    }
+  }
+}
+
+void GpuBlocksToUpdateTracker::getBlocksToUpdateAsync(
+    BlocksToUpdateType blocks_to_update_type,
+    device_vector<Index3D>* blocks_to_update, const CudaStream& cuda_stream) {
+  CHECK_NOTNULL(blocks_to_update);
+  copySetToDeviceVectorAsync(
+      sets_[static_cast<int>(blocks_to_update_type)]->set, blocks_to_update,
+      cuda_stream);
+}
+
+std::vector<Index3D> GpuBlocksToUpdateTracker::getBlocksToUpdate(
+    BlocksToUpdateType blocks_to_update_type, const CudaStream& cuda_stream) {
+  device_vector<Index3D> blocks_to_update_device;
+  getBlocksToUpdateAsync(blocks_to_update_type, &blocks_to_update_device,
+                         cuda_stream);
+  std::vector<Index3D> blocks_to_update =
+      blocks_to_update_device.toVectorAsync(cuda_stream);
+  cuda_stream.synchronize();
+  return blocks_to_update;
+}
+
+void GpuBlocksToUpdateTracker::markBlocksAsUpdated(
+    BlocksToUpdateType blocks_to_update_type, const CudaStream& cuda_stream) {
+  const int type_idx = static_cast<int>(blocks_to_update_type);
+  // The set is cleared on the default stream.
+  cuda_stream.synchronize();
+  sets_[type_idx]->clear();
+  max_sizes_[type_idx] = 0;
+}
+
+void GpuBlocksToUpdateTracker::trackCheckpointBlocks(
+    bool track_checkpoint_blocks, const CudaStream& cuda_stream) {
+  track_checkpoint_blocks_ = track_checkpoint_blocks;
+  markBlocksAsUpdated(BlocksToUpdateType::kCheckpoint, cuda_stream);
+}
+
+void GpuBlocksToUpdateTracker::trackGroundPlaneBlocks(
+    bool track_ground_plane_blocks, const CudaStream& cuda_stream) {
+  track_ground_plane_blocks_ = track_ground_plane_blocks;
+  markBlocksAsUpdated(BlocksToUpdateType::kGroundPlane, cuda_stream);
+}
+
+}  // namespace nvblox
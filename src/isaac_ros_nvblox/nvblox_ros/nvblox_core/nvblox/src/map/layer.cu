@@ -14,15 +14,58 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "nvblox/map/internal/cuda/impl/layer_impl.cuh"
+#include "nvblox/map/common_names.h"
 #include "nvblox/map/layer.h"
 
 namespace nvblox {
 
+template void BlockLayer<TsdfBlock>::allocateBlocksAtIndicesOnGpuAsync(
+    const device_vector<Index3D>& indices, const CudaStream& cuda_stream);
+template void BlockLayer<TsdfBlock>::getBlockPointersOnGpuAsync(
+    const device_vector<Index3D>& indices,
+    device_vector<TsdfBlock*>* block_ptrs, const CudaStream& cuda_stream);
+
+template void BlockLayer<OccupancyBlock>::allocateBlocksAtIndicesOnGpuAsync(
+    const device_vector<Index3D>& indices, const CudaStream& cuda_stream);
+template void BlockLayer<OccupancyBlock>::getBlockPointersOnGpuAsync(
+    const device_vector<Index3D>& indices,
+    device_vector<OccupancyBlock*>* block_ptrs, const CudaStream& cuda_stream);
+
+template void BlockLayer<FreespaceBlock>::allocateBlocksAtIndicesOnGpuAsync(
+    const device_vector<Index3D>& indices, const CudaStream& cuda_stream);
+template void BlockLayer<FreespaceBlock>::getBlockPointersOnGpuAsync(
+    const device_vector<Index3D>& indices,
+    device_vector<FreespaceBlock*>* block_ptrs, const CudaStream& cuda_stream);
+
+template void BlockLayer<ColorBlock>::allocateBlocksAtIndicesOnGpuAsync(
+    const device_vector<Index3D>& indices, const CudaStream& cuda_stream);
+template void BlockLayer<ColorBlock>::getBlockPointersOnGpuAsync(
+    const device_vector<Index3D>& indices,
+    device_vector<ColorBlock*>* block_ptrs, const CudaStream& cuda_stream);
+
+template void BlockLayer<EsdfBlock>::allocateBlocksAtIndicesOnGpuAsync(
+    const device_vector<Index3D>& indices, const CudaStream& cuda_stream);
+template void BlockLayer<EsdfBlock>::getBlockPointersOnGpuAsync(
+    const device_vector<Index3D>& indices,
+    device_vector<EsdfBlock*>* block_ptrs, const CudaStream& cuda_stream);
+
+template void BlockLayer<CompactEsdfBlock>::allocateBlocksAtIndicesOnGpuAsync(
+    const device_vector<Index3D>& indices, const CudaStream& cuda_stream);
+template void BlockLayer<CompactEsdfBlock>::getBlockPointersOnGpuAsync(
+    const device_vector<Index3D>& indices,
+    device_vector<CompactEsdfBlock*>* block_ptrs,
+    const CudaStream& cuda_stream);
+
 template void VoxelBlockLayer<EsdfVoxel>::getVoxelsGPU(
     const device_vector<Vector3f>& positions_L,
     device_vector<EsdfVoxel>* voxels_ptr,
     device_vector<bool>* success_flags_ptr) const;
 
+template void VoxelBlockLayer<CompactEsdfVoxel>::getVoxelsGPU(
+    const device_vector<Vector3f>& positions_L,
+    device_vector<CompactEsdfVoxel>* voxels_ptr,
+    device_vector<bool>* success_flags_ptr) const;
+
 template void VoxelBlockLayer<TsdfVoxel>::getVoxelsGPU(
     const device_vector<Vector3f>& positions_L,
     device_vector<TsdfVoxel>* voxels_ptr,
@@ -0,0 +1,201 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "nvblox/map/layer_ipc.h"
+
+#include <algorithm>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "nvblox/core/internal/error_check.h"
+#include "nvblox/map/common_names.h"
+#include "nvblox/utils/timing.h"
+
+namespace nvblox {
+
+namespace {
+
+// Alignment of the blocks within an export buffer.
+constexpr uint64_t kBlocksAlignmentBytes = 256;
+
+uint64_t blocksOffsetBytes(const int64_t capacity) {
+  const uint64_t indices_bytes = capacity * sizeof(Index3D);
+  return (indices_bytes + kBlocksAlignmentBytes - 1) / kBlocksAlignmentBytes *
+         kBlocksAlignmentBytes;
+}
+
+}  // namespace
+
+// Copies one block per thread block, in 32-bit words.
+template <typename BlockType>
+__global__ void gatherBlocksKernel(const BlockType* const* block_ptrs,
+                                   BlockType* blocks_out) {
+  constexpr int kNumWords = sizeof(BlockType) / sizeof(int32_t);
+  const int32_t* src = reinterpret_cast<const int32_t*>(block_ptrs[blockIdx.x]);
+  int32_t* dst = reinterpret_cast<int32_t*>(blocks_out + blockIdx.x);
+  for (int i = threadIdx.x; i < kNumWords; i += blockDim.x) {
+    dst[i] = src[i];
+  }
+}
+
+template <typename BlockType>
+LayerIpcExporter<BlockType>::~LayerIpcExporter() {
+  for (ExportBuffer& buffer : buffers_) {
+    if (buffer.buffer_device != nullptr) {
+      checkCudaErrors(cudaFree(buffer.buffer_device));
+    }
+  }
+}
+
+template <typename BlockType>
+void LayerIpcExporter<BlockType>::reserve(const int64_t num_blocks,
+                                          ExportBuffer* buffer) {
+  if (buffer->capacity >= num_blocks && buffer->buffer_device != nullptr) {
+    return;
+  }
+  if (buffer->buffer_device != nullptr) {
+    // Clients have to open the new handle returned by the export.
+    checkCudaErrors(cudaFree(buffer->buffer_device));
+  }
+  // Grow geometrically, such that a growing map is rarely reallocated.
+  buffer->capacity = std::max<int64_t>(
+      {num_blocks, 2 * buffer->capacity, int64_t{1024}});
+  const uint64_t num_bytes = blocksOffsetBytes(buffer->capacity) +
+                             buffer->capacity * sizeof(BlockType);
+  // Memory from cudaMallocAsync() can't be exported through cudaIpc.
+  checkCudaErrors(cudaMalloc(&buffer->buffer_device, num_bytes));
+  checkCudaErrors(
+      cudaIpcGetMemHandle(&buffer->mem_handle, buffer->buffer_device));
+}
+
+template <typename BlockType>
+LayerIpcHandle LayerIpcExporter<BlockType>::exportLayer(
+    const BlockLayer<BlockType>& layer, const CudaStream& cuda_stream) {
+  static_assert(std::is_trivially_copyable<BlockType>::value,
+                "Only blocks of plain data can be exported.");
+  static_assert(sizeof(BlockType) % sizeof(int32_t) == 0,
+                "Blocks are copied in 32-bit words.");
+  CHECK(layer.memory_type() != MemoryType::kHost)
+      << "Only layers in device-accessible memory can be exported.";
+  timing::Timer timer("layer_ipc/export");
+
+  const device_vector<Index3D>& block_indices =
+      layer.getAllBlockIndicesOnGpu(cuda_stream);
+  const device_vector<BlockType*>& block_ptrs =
+      layer.getAllBlockPointersOnGpu(cuda_stream);
+  const int64_t num_blocks = block_indices.size();
+
+  ExportBuffer& buffer = buffers_[generation_ % buffers_.size()];
+  reserve(num_blocks, &buffer);
+  const uint64_t blocks_offset_bytes = blocksOffsetBytes(buffer.capacity);
+  uint8_t* base = static_cast<uint8_t*>(buffer.buffer_device);
+
+  if (num_blocks > 0) {
+    checkCudaErrors(cudaMemcpyAsync(base, block_indices.data(),
+                                    num_blocks * sizeof(Index3D),
+                                    cudaMemcpyDeviceToDevice, cuda_stream));
+    constexpr int kNumThreads = 256;
+    gatherBlocksKernel<BlockType><<<num_blocks, kNumThreads, 0, cuda_stream>>>(
+        block_ptrs.data(),
+        reinterpret_cast<BlockType*>(base + blocks_offset_bytes));
+    checkCudaErrors(cudaPeekAtLastError());
+  }
+  cuda_stream.synchronize();
+
+  LayerIpcHandle handle;
+  handle.mem_handle = buffer.mem_handle;
+  handle.generation = ++generation_;
+  handle.num_blocks = num_blocks;
+  handle.blocks_offset_bytes = blocks_offset_bytes;
+  handle.block_size_bytes = sizeof(BlockType);
+  handle.block_size = layer.block_size();
+  return handle;
+}
+
+template <typename BlockType>
+const void* LayerIpcExporter<BlockType>::latestBufferDevice() const {
+  if (generation_ == 0) {
+    return nullptr;
+  }
+  return buffers_[(generation_ - 1) % buffers_.size()].buffer_device;
+}
+
+template <typename BlockType>
+LayerIpcClient<BlockType>::LayerIpcClient(const LayerIpcHandle& handle,
+                                          const CudaStream& cuda_stream)
+    : handle_(handle) {
+  checkCudaErrors(cudaIpcOpenMemHandle(&buffer_device_, handle.mem_handle,
+                                       cudaIpcMemLazyEnablePeerAccess));
+  gpu_layer_view_ = buildGpuLayerView(handle, buffer_device_, cuda_stream);
+}
+
+template <typename BlockType>
+LayerIpcClient<BlockType>::~LayerIpcClient() {
+  // The hash must not outlive the blocks it points to.
+  gpu_layer_view_.reset();
+  if (buffer_device_ != nullptr) {
+    checkCudaErrors(cudaIpcCloseMemHandle(buffer_device_));
+  }
+}
+
+template <typename BlockType>
+std::unique_ptr<GPULayerView<BlockType>>
+LayerIpcClient<BlockType>::buildGpuLayerView(const LayerIpcHandle& handle,
+                                             const void* buffer_device,
+                                             const CudaStream& cuda_stream) {
+  CHECK_EQ(handle.block_size_bytes, sizeof(BlockType))
+      << "The snapshot was exported with a different block type.";
+  CHECK_NOTNULL(buffer_device);
+  const uint8_t* base = static_cast<const uint8_t*>(buffer_device);
+
+  std::vector<Index3D> block_indices(handle.num_blocks);
+  if (handle.num_blocks > 0) {
+    checkCudaErrors(cudaMemcpyAsync(block_indices.data(), base,
+                                    handle.num_blocks * sizeof(Index3D),
+                                    cudaMemcpyDeviceToHost, cuda_stream));
+    cuda_stream.synchronize();
+  }
+
+  // The hash only hands out const access to the blocks through the client.
+  BlockType* blocks = reinterpret_cast<BlockType*>(
+      const_cast<uint8_t*>(base + handle.blocks_offset_bytes));
+  std::vector<thrust::pair<Index3D, BlockType*>> blocks_to_insert;
+  blocks_to_insert.reserve(handle.num_blocks);
+  for (int64_t i = 0; i < handle.num_blocks; ++i) {
+    blocks_to_insert.emplace_back(block_indices[i], blocks + i);
+  }
+
+  auto gpu_layer_view = std::make_unique<GPULayerView<BlockType>>(
+      std::max<size_t>(handle.num_blocks,
+                       GPULayerView<BlockType>::kDefaultCapacity));
+  gpu_layer_view->insertBlocksAsync(blocks_to_insert, cuda_stream);
+  gpu_layer_view->flushCache(cuda_stream);
+  return gpu_layer_view;
+}
+
+template class LayerIpcExporter<TsdfBlock>;
+template class LayerIpcExporter<EsdfBlock>;
+template class LayerIpcExporter<ColorBlock>;
+template class LayerIpcExporter<OccupancyBlock>;
+template class LayerIpcExporter<FreespaceBlock>;
+
+template class LayerIpcClient<TsdfBlock>;
+template class LayerIpcClient<EsdfBlock>;
+template class LayerIpcClient<ColorBlock>;
+template class LayerIpcClient<OccupancyBlock>;
+template class LayerIpcClient<FreespaceBlock>;
+
+}  // namespace nvblox
@@ -0,0 +1,160 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "nvblox/map/multi_layer_query.h"
+
+#include "nvblox/core/indexing.h"
+#include "nvblox/core/internal/error_check.h"
+#include "nvblox/gpu_hash/internal/cuda/gpu_hash_interface.cuh"
+#include "nvblox/map/common_names.h"
+#include "nvblox/utils/timing.h"
+
+namespace nvblox {
+
+// The GPU hash of one queried layer, and where to write its voxels. Layers
+// not queried have null outputs.
+template <typename VoxelType>
+struct LayerQueryTarget {
+  Index3DDeviceHashMapType<VoxelBlock<VoxelType>> block_hash;
+  VoxelType* voxels = nullptr;
+  bool* success_flags = nullptr;
+
+  __device__ void query(const int idx, const Index3D& block_idx,
+                        const Index3D& voxel_idx) const {
+    if (voxels == nullptr) {
+      return;
+    }
+    const auto it = block_hash.find(block_idx);
+    if (it == block_hash.end()) {
+      success_flags[idx] = false;
+      return;
+    }
+    success_flags[idx] = true;
+    voxels[idx] =
+        it->second->voxels[voxel_idx.x()][voxel_idx.y()][voxel_idx.z()];
+  }
+};
+
+__global__ void queryLayersKernel(
+    const int num_queries, const float block_size,
+    const Vector3f* query_locations_ptr,
+    const LayerQueryTarget<TsdfVoxel> tsdf_target,
+    const LayerQueryTarget<EsdfVoxel> esdf_target,
+    const LayerQueryTarget<ColorVoxel> color_target,
+    const LayerQueryTarget<OccupancyVoxel> occupancy_target,
+    const LayerQueryTarget<FreespaceVoxel> freespace_target) {
+  const int idx = threadIdx.x + blockIdx.x * blockDim.x;
+  if (idx >= num_queries) {
+    return;
+  }
+  // Resolve the indices once for all layers.
+  Index3D block_idx;
+  Index3D voxel_idx;
+  getBlockAndVoxelIndexFromPositionInLayer(
+      block_size, query_locations_ptr[idx], &block_idx, &voxel_idx);
+  tsdf_target.query(idx, block_idx, voxel_idx);
+  esdf_target.query(idx, block_idx, voxel_idx);
+  color_target.query(idx, block_idx, voxel_idx);
+  occupancy_target.query(idx, block_idx, voxel_idx);
+  freespace_target.query(idx, block_idx, voxel_idx);
+}
+
+// Sets up the query of a layer if it's requested and in the cake, and
+// otherwise empties its outputs. Returns the block size of the layer queried
+// or a negative value.
+template <typename LayerType>
+float prepareLayerQuery(
+    const LayerCake& layers, const int num_queries, const bool is_requested,
+    device_vector<typename LayerType::VoxelType>* voxels,
+    device_vector<bool>* success_flags, const CudaStream& cuda_stream,
+    LayerQueryTarget<typename LayerType::VoxelType>* target) {
+  if (!is_requested || !layers.exists<LayerType>()) {
+    voxels->resizeAsync(0, cuda_stream);
+    success_flags->resizeAsync(0, cuda_stream);
+    return -1.0f;
+  }
+  const LayerType& layer = layers.get<LayerType>();
+  voxels->resizeAsync(num_queries, cuda_stream);
+  success_flags->resizeAsync(num_queries, cuda_stream);
+  target->block_hash = layer.getGpuLayerView(cuda_stream).getHash().impl_;
+  target->voxels = voxels->data();
+  target->success_flags = success_flags->data();
+  return layer.block_size();
+}
+
+void queryLayersGPU(const LayerCake& layers,
+                    const device_vector<Vector3f>& positions_L,
+                    const LayerTypeBitMask layer_type_bitmask,
+                    MultiLayerQueryResults* results,
+                    const CudaStream& cuda_stream) {
+  CHECK_NOTNULL(results);
+  timing::Timer timer("map/query_layers");
+  const int num_queries = positions_L.size();
+
+  LayerQueryTarget<TsdfVoxel> tsdf_target;
+  LayerQueryTarget<EsdfVoxel> esdf_target;
+  LayerQueryTarget<ColorVoxel> color_target;
+  LayerQueryTarget<OccupancyVoxel> occupancy_target;
+  LayerQueryTarget<FreespaceVoxel> freespace_target;
+  const float block_sizes[] = {
+      prepareLayerQuery<TsdfLayer>(
+          layers, num_queries, layer_type_bitmask & LayerType::kTsdf,
+          &results->tsdf_voxels, &results->tsdf_success_flags, cuda_stream,
+          &tsdf_target),
+      prepareLayerQuery<EsdfLayer>(
+          layers, num_queries, layer_type_bitmask & LayerType::kEsdf,
+          &results->esdf_voxels, &results->esdf_success_flags, cuda_stream,
+          &esdf_target),
+      prepareLayerQuery<ColorLayer>(
+          layers, num_queries, layer_type_bitmask & LayerType::kColor,
+          &results->color_voxels, &results->color_success_flags, cuda_stream,
+          &color_target),
+      prepareLayerQuery<OccupancyLayer>(
+          layers, num_queries, layer_type_bitmask & LayerType::kOccupancy,
+          &results->occupancy_voxels, &results->occupancy_success_flags,
+          cuda_stream, &occupancy_target),
+      prepareLayerQuery<FreespaceLayer>(
+          layers, num_queries, layer_type_bitmask & LayerType::kFreespace,
+          &results->freespace_voxels, &results->freespace_success_flags,
+          cuda_stream, &freespace_target),
+  };
+
+  // All queried layers have to agree on the block index of a point.
+  float block_size = -1.0f;
+  for (const float layer_block_size : block_sizes) {
+    if (layer_block_size <= 0.0f) {
+      continue;
+    }
+    if (block_size > 0.0f) {
+      CHECK_EQ(layer_block_size, block_size)
+          << "Queried layers have to have the same block size.";
+    }
+    block_size = layer_block_size;
+  }
+  if (block_size <= 0.0f || num_queries == 0) {
+    cuda_stream.synchronize();
+    return;
+  }
+
+  constexpr int kNumThreads = 512;
+  const int num_blocks = num_queries / kNumThreads + 1;
+  queryLayersKernel<<<num_blocks, kNumThreads, 0, cuda_stream>>>(
+      num_queries, block_size, positions_L.data(), tsdf_target, esdf_target,
+      color_target, occupancy_target, freespace_target);
+  checkCudaErrors(cudaPeekAtLastError());
+  cuda_stream.synchronize();
+}
+
+}  // namespace nvblox
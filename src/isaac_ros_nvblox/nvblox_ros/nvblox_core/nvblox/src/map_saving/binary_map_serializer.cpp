@@ -0,0 +1,504 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "nvblox/map_saving/internal/binary_map_serializer.h"
+
+#include <cuda_runtime.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <vector>
+
+#include "nvblox/map_saving/internal/common_types.h"
+#include "nvblox/utils/logging.h"
+
+namespace nvblox {
+
+namespace {
+
+constexpr char kMagic[8] = {'N', 'V', 'B', 'L', 'X', 'M', 'A', 'P'};
+constexpr size_t kMaxLayerNameLength = 64;
+constexpr size_t kSectionAlignment = 8;
+
+struct BinaryMapHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t num_layers;
+  uint64_t layer_table_offset;
+};
+
+struct BinaryMapLayerEntry {
+  char name[kMaxLayerNameLength];
+  float block_size;
+  uint32_t reserved;
+  uint64_t num_blocks;
+  uint64_t num_bytes_per_block;
+  uint64_t indices_offset;
+  uint64_t payload_offset;
+};
+
+// Pad the stream with zeros up to the next section boundary.
+void alignStream(std::ofstream* stream) {
+  const uint64_t position = stream->tellp();
+  const uint64_t remainder = position % kSectionAlignment;
+  if (remainder != 0) {
+    const char zeros[kSectionAlignment] = {0};
+    stream->write(zeros, kSectionAlignment - remainder);
+  }
+}
+
+}  // namespace
+
+// A read-only memory mapping of a file. If the whole file is going to be
+// transferred, the mapping is registered with CUDA (if possible) such that
+// host to device copies run at full bandwidth.
+class MappedFile {
+ public:
+  MappedFile(const std::string& filename, bool register_with_cuda) {
+    const int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+      return;
+    }
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) == 0 && file_stat.st_size > 0) {
+      void* data = mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE,
+                        fd, 0);
+      if (data != MAP_FAILED) {
+        data_ = static_cast<const Byte*>(data);
+        size_ = file_stat.st_size;
+      }
+    }
+    // The mapping stays valid after closing the file.
+    ::close(fd);
+    if (data_ == nullptr) {
+      return;
+    }
+    if (!register_with_cuda) {
+      madvise(const_cast<Byte*>(data_), size_, MADV_RANDOM);
+      return;
+    }
+    madvise(const_cast<Byte*>(data_), size_, MADV_SEQUENTIAL);
+    // Fall back to pageable copies if pinning fails.
+    is_registered_ = cudaHostRegister(const_cast<Byte*>(data_), size_,
+                                      cudaHostRegisterReadOnly) == cudaSuccess;
+    if (!is_registered_) {
+      // Clear the error such that it is not picked up elsewhere.
+      cudaGetLastError();
+    }
+  }
+
+  ~MappedFile() {
+    if (data_ == nullptr) {
+      return;
+    }
+    if (is_registered_) {
+      checkCudaErrors(cudaHostUnregister(const_cast<Byte*>(data_)));
+    }
+    munmap(const_cast<Byte*>(data_), size_);
+  }
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  bool valid() const { return data_ != nullptr; }
+  const Byte* data() const { return data_; }
+  size_t size() const { return size_; }
+
+ private:
+  const Byte* data_ = nullptr;
+  size_t size_ = 0;
+  bool is_registered_ = false;
+};
+
+namespace {
+
+// Check the header and read the layer table. Checks that all sections lie
+// within the file.
+bool readLayerTable(const MappedFile& file, const std::string& filename,
+                    std::vector<BinaryMapLayerEntry>* entries) {
+  if (!file.valid() || file.size() < sizeof(BinaryMapHeader)) {
+    LOG(ERROR) << "Could not map file for reading: " << filename;
+    return false;
+  }
+  BinaryMapHeader header;
+  std::memcpy(&header, file.data(), sizeof(header));
+  if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+      header.version != BinaryMapSerializer::kVersion) {
+    LOG(ERROR) << "Not a binary map file of version "
+               << BinaryMapSerializer::kVersion << ": " << filename;
+    return false;
+  }
+  if (header.layer_table_offset > file.size() ||
+      header.num_layers > (file.size() - header.layer_table_offset) /
+                              sizeof(BinaryMapLayerEntry)) {
+    LOG(ERROR) << "Binary map file is truncated: " << filename;
+    return false;
+  }
+  entries->resize(header.num_layers);
+  for (uint32_t i = 0; i < header.num_layers; ++i) {
+    BinaryMapLayerEntry& entry = (*entries)[i];
+    std::memcpy(&entry,
+                file.data() + header.layer_table_offset +
+                    i * sizeof(BinaryMapLayerEntry),
+                sizeof(entry));
+    entry.name[kMaxLayerNameLength - 1] = '\0';
+    const uint64_t indices_size = entry.num_blocks * 3 * sizeof(int32_t);
+    const uint64_t payload_size = entry.num_blocks * entry.num_bytes_per_block;
+    if (entry.indices_offset > file.size() ||
+        indices_size > file.size() - entry.indices_offset ||
+        entry.payload_offset > file.size() ||
+        payload_size > file.size() - entry.payload_offset) {
+      LOG(ERROR) << "Binary map file is truncated: " << filename;
+      return false;
+    }
+  }
+  return true;
+}
+
+std::vector<Index3D> readIndexTable(const MappedFile& file,
+                                    const BinaryMapLayerEntry& entry) {
+  std::vector<Index3D> indices(entry.num_blocks);
+  const Byte* index_table = file.data() + entry.indices_offset;
+  for (uint64_t block_idx = 0; block_idx < entry.num_blocks; ++block_idx) {
+    int32_t xyz[3];
+    std::memcpy(xyz, index_table + block_idx * sizeof(xyz), sizeof(xyz));
+    indices[block_idx] = Index3D(xyz[0], xyz[1], xyz[2]);
+  }
+  return indices;
+}
+
+// Create an empty layer for a layer entry. Returns nullptr if the layer type
+// can't be loaded from binary files.
+std::shared_ptr<BaseLayer> constructLayer(const BinaryMapLayerEntry& entry,
+                                          MemoryType memory_type) {
+  const LayerSerializationFunctions layer_functions =
+      LayerTypeRegister::getSerializationFunctions(entry.name);
+  if (layer_functions.construct_layer == nullptr ||
+      layer_functions.allocate_blocks == nullptr) {
+    LOG(WARNING) << "Do not have deserialization functions for " << entry.name
+                 << ".";
+    return nullptr;
+  }
+  LayerParameterStruct layer_params;
+  layer_params.float_params.emplace("block_size", entry.block_size);
+  return layer_functions.construct_layer(memory_type, layer_params);
+}
+
+}  // namespace
+
+BinaryMapSerializer::BinaryMapSerializer() { registerCommonTypes(); }
+
+bool BinaryMapSerializer::isBinaryMapFile(const std::string& filename) {
+  std::ifstream file(filename, std::ios::in | std::ios::binary);
+  char magic[sizeof(kMagic)];
+  if (!file.read(magic, sizeof(magic))) {
+    return false;
+  }
+  return std::memcmp(magic, kMagic, sizeof(kMagic)) == 0;
+}
+
+bool BinaryMapSerializer::writeLayerCake(const std::string& filename,
+                                         const LayerCake& cake,
+                                         const CudaStream& cuda_stream) {
+  std::ofstream file(filename,
+                     std::ios::out | std::ios::trunc | std::ios::binary);
+  if (!file) {
+    LOG(ERROR) << "Could not open file for writing: " << filename;
+    return false;
+  }
+
+  // The header is written again at the end, once the table offset is known.
+  BinaryMapHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+  std::vector<BinaryMapLayerEntry> entries;
+  for (const auto& type_index_and_layer : cake.get_layers()) {
+    const std::string layer_name =
+        LayerTypeRegister::getLayerName(type_index_and_layer.first);
+    if (layer_name.empty()) {
+      LOG(ERROR) << "Unrecognized layer type, can't serialize: "
+                 << type_index_and_layer.first.name();
+      continue;
+    }
+    const LayerSerializationFunctions layer_functions =
+        LayerTypeRegister::getSerializationFunctions(layer_name);
+    if (layer_functions.serialize_params == nullptr ||
+        layer_functions.get_data_indices == nullptr ||
+        layer_functions.serialize_data_batch == nullptr) {
+      LOG(WARNING) << "Layer type does not support binary serialization: "
+                   << layer_name;
+      continue;
+    }
+    const BaseLayer* layer = type_index_and_layer.second.get();
+    const LayerParameterStruct params = layer_functions.serialize_params(layer);
+    const auto block_size_it = params.float_params.find("block_size");
+    if (block_size_it == params.float_params.end() ||
+        layer_name.size() >= kMaxLayerNameLength) {
+      LOG(WARNING) << "Can't serialize layer to binary file: " << layer_name;
+      continue;
+    }
+
+    BinaryMapLayerEntry entry;
+    std::memset(&entry, 0, sizeof(entry));
+    std::memcpy(entry.name, layer_name.data(), layer_name.size());
+    entry.block_size = block_size_it->second;
+
+    // Index table.
+    const std::vector<Index3D> indices =
+        layer_functions.get_data_indices(layer);
+    entry.num_blocks = indices.size();
+    alignStream(&file);
+    entry.indices_offset = file.tellp();
+    for (const Index3D& index : indices) {
+      const int32_t xyz[3] = {index.x(), index.y(), index.z()};
+      file.write(reinterpret_cast<const char*>(xyz), sizeof(xyz));
+    }
+
+    // Voxel payload, in the order of the index table.
+    alignStream(&file);
+    entry.payload_offset = file.tellp();
+    auto write_data = [&file, &entry](const Index3D&, const Byte* data,
+                                      size_t num_bytes) -> bool {
+      if (entry.num_bytes_per_block == 0) {
+        entry.num_bytes_per_block = num_bytes;
+      }
+      if (num_bytes != entry.num_bytes_per_block) {
+        LOG(ERROR) << "Binary map files require blocks of equal size.";
+        return false;
+      }
+      return static_cast<bool>(
+          file.write(reinterpret_cast<const char*>(data), num_bytes));
+    };
+    if (!layer_functions.serialize_data_batch(layer, indices, write_data,
+                                              cuda_stream)) {
+      LOG(ERROR) << "Failed to serialize layer: " << layer_name;
+      return false;
+    }
+    entries.push_back(entry);
+  }
+
+  // Layer table, then the completed header.
+  alignStream(&file);
+  header.num_layers = entries.size();
+  header.layer_table_offset = file.tellp();
+  file.write(reinterpret_cast<const char*>(entries.data()),
+             entries.size() * sizeof(BinaryMapLayerEntry));
+  file.seekp(0);
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  file.close();
+  if (!file) {
+    LOG(ERROR) << "Failed to write file: " << filename;
+    return false;
+  }
+  return true;
+}
+
+LayerCake BinaryMapSerializer::loadLayerCake(const std::string& filename,
+                                             MemoryType memory_type,
+                                             const CudaStream& cuda_stream) {
+  MappedFile file(filename, true);
+  std::vector<BinaryMapLayerEntry> entries;
+  if (!readLayerTable(file, filename, &entries)) {
+    return LayerCake();
+  }
+
+  using TypeIndexAndLayerPtr =
+      std::pair<std::type_index, std::shared_ptr<BaseLayer>>;
+  std::vector<TypeIndexAndLayerPtr> layers;
+  float voxel_size = 0.0f;
+  for (const BinaryMapLayerEntry& entry : entries) {
+    std::shared_ptr<BaseLayer> layer = constructLayer(entry, memory_type);
+    if (!layer) {
+      continue;
+    }
+
+    // Allocate all blocks, then copy the voxels straight from the mapping.
+    std::vector<Byte*> block_data;
+    if (!LayerTypeRegister::getSerializationFunctions(entry.name)
+             .allocate_blocks(readIndexTable(file, entry),
+                              entry.num_bytes_per_block, layer.get(),
+                              &block_data, cuda_stream)) {
+      LOG(ERROR) << "Failed to allocate blocks of layer: " << entry.name;
+      return LayerCake();
+    }
+    scatter_copier_.scatter(file.data() + entry.payload_offset,
+                            entry.num_bytes_per_block, block_data,
+                            cuda_stream);
+
+    // NOTE: we check that all loaded layers have the same voxel size.
+    const float new_voxel_size =
+        entry.block_size / VoxelBlock<bool>::kVoxelsPerSide;
+    CHECK(voxel_size == 0.0f || voxel_size == new_voxel_size);
+    voxel_size = new_voxel_size;
+
+    layers.push_back(
+        {LayerTypeRegister::getLayerTypeIndex(entry.name), std::move(layer)});
+  }
+
+  LayerCake cake(voxel_size);
+  for (auto&& type_index_lay_pair : layers) {
+    cake.insert(type_index_lay_pair.first,
+                std::move(type_index_lay_pair.second));
+  }
+  return cake;
+}
+
+LazyBinaryMapLoader::LazyBinaryMapLoader() { registerCommonTypes(); }
+
+LazyBinaryMapLoader::~LazyBinaryMapLoader() = default;
+
+bool LazyBinaryMapLoader::open(const std::string& filename) {
+  layers_.clear();
+  file_ = std::make_unique<MappedFile>(filename, false);
+  std::vector<BinaryMapLayerEntry> entries;
+  if (!readLayerTable(*file_, filename, &entries)) {
+    file_.reset();
+    return false;
+  }
+  for (const BinaryMapLayerEntry& entry : entries) {
+    if (!layers_.empty() && entry.block_size != layers_[0].block_size) {
+      LOG(ERROR) << "All layers must have the same block size: " << filename;
+      close();
+      return false;
+    }
+    UnloadedLayer layer;
+    layer.name = entry.name;
+    layer.block_size = entry.block_size;
+    layer.num_bytes_per_block = entry.num_bytes_per_block;
+    layer.payload = file_->data() + entry.payload_offset;
+    const std::vector<Index3D> indices = readIndexTable(*file_, entry);
+    for (size_t block_idx = 0; block_idx < indices.size(); ++block_idx) {
+      layer.unloaded_blocks.emplace(indices[block_idx], block_idx);
+    }
+    layers_.push_back(std::move(layer));
+  }
+  return true;
+}
+
+void LazyBinaryMapLoader::close() {
+  layers_.clear();
+  file_.reset();
+}
+
+bool LazyBinaryMapLoader::valid() const { return file_ != nullptr; }
+
+LayerCake LazyBinaryMapLoader::createLayerCake(MemoryType memory_type) const {
+  if (layers_.empty()) {
+    return LayerCake();
+  }
+  LayerCake cake(layers_[0].block_size / VoxelBlock<bool>::kVoxelsPerSide);
+  for (const UnloadedLayer& unloaded_layer : layers_) {
+    BinaryMapLayerEntry entry;
+    std::memset(&entry, 0, sizeof(entry));
+    std::memcpy(entry.name, unloaded_layer.name.data(),
+                unloaded_layer.name.size());
+    entry.block_size = unloaded_layer.block_size;
+    std::shared_ptr<BaseLayer> layer = constructLayer(entry, memory_type);
+    if (layer) {
+      cake.insert(LayerTypeRegister::getLayerTypeIndex(unloaded_layer.name),
+                  std::move(layer));
+    }
+  }
+  return cake;
+}
+
+std::vector<Index3D> LazyBinaryMapLoader::loadBlocks(
+    const std::vector<Index3D>& indices, LayerCake* cake,
+    const CudaStream& cuda_stream) {
+  CHECK_NOTNULL(cake);
+  Index3DSet loaded_indices;
+  for (UnloadedLayer& unloaded_layer : layers_) {
+    // Gather the blocks still on disk into a contiguous buffer.
+    std::vector<Index3D> layer_indices;
+    std::vector<uint64_t> block_ids;
+    for (const Index3D& index : indices) {
+      auto it = unloaded_layer.unloaded_blocks.find(index);
+      if (it != unloaded_layer.unloaded_blocks.end()) {
+        layer_indices.push_back(index);
+        block_ids.push_back(it->second);
+        unloaded_layer.unloaded_blocks.erase(it);
+      }
+    }
+    const auto layer_it = cake->get_layers().find(
+        LayerTypeRegister::getLayerTypeIndex(unloaded_layer.name));
+    if (layer_indices.empty() || layer_it == cake->get_layers().end()) {
+      continue;
+    }
+    const size_t num_bytes = unloaded_layer.num_bytes_per_block;
+    staging_host_.resizeAsync(layer_indices.size() * num_bytes, cuda_stream);
+    cuda_stream.synchronize();
+    for (size_t i = 0; i < block_ids.size(); ++i) {
+      std::memcpy(staging_host_.data() + i * num_bytes,
+                  unloaded_layer.payload + block_ids[i] * num_bytes,
+                  num_bytes);
+    }
+
+    std::vector<Byte*> block_data;
+    if (!LayerTypeRegister::getSerializationFunctions(unloaded_layer.name)
+             .allocate_blocks(layer_indices, num_bytes,
+                              layer_it->second.get(), &block_data,
+                              cuda_stream)) {
+      LOG(ERROR) << "Failed to allocate blocks of layer: "
+                 << unloaded_layer.name;
+      continue;
+    }
+    scatter_copier_.scatter(staging_host_.data(), num_bytes, block_data,
+                            cuda_stream);
+    loaded_indices.insert(layer_indices.begin(), layer_indices.end());
+  }
+  return std::vector<Index3D>(loaded_indices.begin(), loaded_indices.end());
+}
+
+void LazyBinaryMapLoader::discardBlocks(const std::vector<Index3D>& indices) {
+  for (UnloadedLayer& unloaded_layer : layers_) {
+    for (const Index3D& index : indices) {
+      unloaded_layer.unloaded_blocks.erase(index);
+    }
+  }
+}
+
+std::vector<Index3D> LazyBinaryMapLoader::getUnloadedBlockIndices() const {
+  Index3DSet unloaded_indices;
+  for (const UnloadedLayer& unloaded_layer : layers_) {
+    for (const auto& index_and_block_id : unloaded_layer.unloaded_blocks) {
+      unloaded_indices.insert(index_and_block_id.first);
+    }
+  }
+  return std::vector<Index3D>(unloaded_indices.begin(),
+                              unloaded_indices.end());
+}
+
+size_t LazyBinaryMapLoader::numUnloadedBlocks() const {
+  size_t num_blocks = 0;
+  for (const UnloadedLayer& unloaded_layer : layers_) {
+    num_blocks = std::max(num_blocks, unloaded_layer.unloaded_blocks.size());
+  }
+  return num_blocks;
+}
+
+float LazyBinaryMapLoader::block_size() const {
+  return layers_.empty() ? 0.0f : layers_[0].block_size;
+}
+
+}  // namespace nvblox
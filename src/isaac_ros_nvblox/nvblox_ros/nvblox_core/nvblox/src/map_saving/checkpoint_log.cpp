@@ -0,0 +1,602 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "nvblox/map_saving/internal/checkpoint_log.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <memory>
+
+#include "nvblox/map_saving/internal/common_types.h"
+#include "nvblox/serialization/internal/serialization_gpu.h"
+#include "nvblox/utils/logging.h"
+
+namespace nvblox {
+
+namespace {
+
+constexpr char kMagic[8] = {'N', 'V', 'B', 'L', 'X', 'L', 'O', 'G'};
+constexpr uint32_t kSegmentMagic = 0x4753564e;  // "NVSG"
+constexpr uint32_t kCommitMagic = 0x4d43564e;   // "NVCM"
+constexpr size_t kMaxLayerNameLength = 64;
+
+struct LogHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t reserved;
+};
+
+struct SegmentHeader {
+  uint32_t magic;
+  uint32_t num_layers;
+};
+
+struct LayerHeader {
+  char name[kMaxLayerNameLength];
+  float block_size;
+  uint32_t reserved;
+  uint64_t num_records;
+};
+
+struct RecordHeader {
+  int32_t index[3];
+  uint32_t num_bytes;
+};
+
+// The segment size makes the trailer independent of the segment position, such
+// that committed segments can be moved to another file during compaction.
+struct CommitTrailer {
+  uint32_t magic;
+  uint32_t reserved;
+  uint64_t segment_num_bytes;
+};
+
+// A change to the index, applied once its segment is committed.
+struct IndexUpdate {
+  std::string layer_name;
+  float block_size;
+  Index3D index;
+  CheckpointLog::BlockRecord record;
+};
+
+bool writeBytes(std::FILE* file, const void* data, size_t num_bytes) {
+  return num_bytes == 0 || std::fwrite(data, 1, num_bytes, file) == num_bytes;
+}
+
+bool readBytes(std::FILE* file, void* data, size_t num_bytes) {
+  return num_bytes == 0 || std::fread(data, 1, num_bytes, file) == num_bytes;
+}
+
+// Flush to the OS and then to disk.
+bool syncFile(std::FILE* file) {
+  return std::fflush(file) == 0 && fsync(fileno(file)) == 0;
+}
+
+bool writeLogHeader(std::FILE* file) {
+  LogHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = CheckpointLog::kVersion;
+  return writeBytes(file, &header, sizeof(header));
+}
+
+void applyUpdates(const std::vector<IndexUpdate>& updates,
+                  CheckpointLog::LogIndex* index) {
+  for (const IndexUpdate& update : updates) {
+    CheckpointLog::LayerIndex& layer_index = (*index)[update.layer_name];
+    layer_index.block_size = update.block_size;
+    if (update.record.num_bytes == 0) {
+      layer_index.blocks.erase(update.index);
+    } else {
+      layer_index.blocks[update.index] = update.record;
+    }
+  }
+}
+
+// Read the committed segments of a log into an index. Reading stops at the
+// first incomplete segment.
+// @param file The log, positioned anywhere.
+// @param index The resulting index.
+// @param committed_num_bytes The end of the last committed segment.
+// @return False if the file is not a checkpoint log.
+bool readLogIndex(std::FILE* file, CheckpointLog::LogIndex* index,
+                  uint64_t* committed_num_bytes) {
+  index->clear();
+  LogHeader header;
+  if (fseeko(file, 0, SEEK_SET) != 0 ||
+      !readBytes(file, &header, sizeof(header)) ||
+      std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+      header.version != CheckpointLog::kVersion) {
+    return false;
+  }
+  *committed_num_bytes = sizeof(header);
+
+  while (true) {
+    const uint64_t segment_offset = *committed_num_bytes;
+    SegmentHeader segment_header;
+    if (!readBytes(file, &segment_header, sizeof(segment_header)) ||
+        segment_header.magic != kSegmentMagic) {
+      break;
+    }
+    std::vector<IndexUpdate> updates;
+    bool segment_complete = true;
+    for (uint32_t i = 0; i < segment_header.num_layers && segment_complete;
+         ++i) {
+      LayerHeader layer_header;
+      if (!readBytes(file, &layer_header, sizeof(layer_header))) {
+        segment_complete = false;
+        break;
+      }
+      layer_header.name[kMaxLayerNameLength - 1] = '\0';
+      for (uint64_t r = 0; r < layer_header.num_records; ++r) {
+        RecordHeader record_header;
+        if (!readBytes(file, &record_header, sizeof(record_header))) {
+          segment_complete = false;
+          break;
+        }
+        const uint64_t payload_offset = ftello(file);
+        if (fseeko(file, record_header.num_bytes, SEEK_CUR) != 0) {
+          segment_complete = false;
+          break;
+        }
+        updates.push_back(
+            {layer_header.name, layer_header.block_size,
+             Index3D(record_header.index[0], record_header.index[1],
+                     record_header.index[2]),
+             {payload_offset, record_header.num_bytes}});
+      }
+    }
+    CommitTrailer trailer;
+    if (!segment_complete || !readBytes(file, &trailer, sizeof(trailer)) ||
+        trailer.magic != kCommitMagic ||
+        trailer.segment_num_bytes !=
+            static_cast<uint64_t>(ftello(file)) - segment_offset) {
+      break;
+    }
+    applyUpdates(updates, index);
+    *committed_num_bytes = ftello(file);
+  }
+  return true;
+}
+
+// Copy a range of bytes between files.
+bool copyBytes(std::FILE* from, uint64_t offset, uint64_t num_bytes,
+               std::FILE* to, std::vector<Byte>* buffer) {
+  constexpr uint64_t kMaxNumBytesPerCopy = 16 * 1024 * 1024;
+  if (fseeko(from, offset, SEEK_SET) != 0) {
+    return false;
+  }
+  while (num_bytes > 0) {
+    const uint64_t num_bytes_to_copy = std::min(num_bytes, kMaxNumBytesPerCopy);
+    buffer->resize(num_bytes_to_copy);
+    if (!readBytes(from, buffer->data(), num_bytes_to_copy) ||
+        !writeBytes(to, buffer->data(), num_bytes_to_copy)) {
+      return false;
+    }
+    num_bytes -= num_bytes_to_copy;
+  }
+  return true;
+}
+
+}  // namespace
+
+CheckpointLog::CheckpointLog() { registerCommonTypes(); }
+
+CheckpointLog::~CheckpointLog() { close(); }
+
+bool CheckpointLog::open(const std::string& filename) {
+  close();
+  file_ = std::fopen(filename.c_str(), "w+b");
+  if (file_ == nullptr) {
+    LOG(ERROR) << "Could not open file for writing: " << filename;
+    return false;
+  }
+  if (!writeLogHeader(file_) || !syncFile(file_)) {
+    LOG(ERROR) << "Could not write to file: " << filename;
+    close();
+    return false;
+  }
+  filename_ = filename;
+  num_bytes_ = sizeof(LogHeader);
+  return true;
+}
+
+void CheckpointLog::close() {
+  waitForCompaction();
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (file_ != nullptr) {
+    std::fclose(file_);
+    file_ = nullptr;
+  }
+  filename_.clear();
+  index_.clear();
+  num_bytes_ = 0;
+}
+
+bool CheckpointLog::valid() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return file_ != nullptr;
+}
+
+bool CheckpointLog::appendCheckpoint(const LayerCake& cake,
+                                     const std::vector<Index3D>& changed_blocks,
+                                     const CudaStream& cuda_stream) {
+  bool success;
+  bool needs_compaction;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (file_ == nullptr) {
+      return false;
+    }
+    success = appendSegment(cake, changed_blocks, cuda_stream);
+    uint64_t num_live_bytes = 0;
+    for (const auto& name_and_layer_index : index_) {
+      for (const auto& index_and_record : name_and_layer_index.second.blocks) {
+        num_live_bytes += index_and_record.second.num_bytes;
+      }
+    }
+    needs_compaction = compaction_ratio_ > 1.0f &&
+                       num_bytes_ > compaction_ratio_ * num_live_bytes;
+  }
+  if (success && needs_compaction) {
+    compactAsync();
+  }
+  return success;
+}
+
+bool CheckpointLog::appendFullCheckpoint(const LayerCake& cake,
+                                         const CudaStream& cuda_stream) {
+  Index3DSet all_blocks;
+  for (const auto& type_index_and_layer : cake.get_layers()) {
+    const LayerSerializationFunctions layer_functions =
+        LayerTypeRegister::getSerializationFunctions(
+            LayerTypeRegister::getLayerName(type_index_and_layer.first));
+    if (layer_functions.get_data_indices != nullptr) {
+      const std::vector<Index3D> indices =
+          layer_functions.get_data_indices(type_index_and_layer.second.get());
+      all_blocks.insert(indices.begin(), indices.end());
+    }
+  }
+  return appendCheckpoint(
+      cake, std::vector<Index3D>(all_blocks.begin(), all_blocks.end()),
+      cuda_stream);
+}
+
+bool CheckpointLog::appendSegment(const LayerCake& cake,
+                                  const std::vector<Index3D>& changed_blocks,
+                                  const CudaStream& cuda_stream) {
+  struct LayerToWrite {
+    std::string name;
+    float block_size;
+    const BaseLayer* layer;
+    LayerSerializationFunctions functions;
+  };
+  std::vector<LayerToWrite> layers;
+  for (const auto& type_index_and_layer : cake.get_layers()) {
+    const std::string layer_name =
+        LayerTypeRegister::getLayerName(type_index_and_layer.first);
+    const LayerSerializationFunctions layer_functions =
+        LayerTypeRegister::getSerializationFunctions(layer_name);
+    if (layer_name.empty() || layer_name.size() >= kMaxLayerNameLength ||
+        layer_functions.serialize_params == nullptr ||
+        layer_functions.serialize_data_batch == nullptr) {
+      continue;
+    }
+    const LayerParameterStruct params =
+        layer_functions.serialize_params(type_index_and_layer.second.get());
+    const auto block_size_it = params.float_params.find("block_size");
+    if (block_size_it == params.float_params.end()) {
+      continue;
+    }
+    layers.push_back({layer_name, block_size_it->second,
+                      type_index_and_layer.second.get(), layer_functions});
+  }
+
+  // Overwrite any previously failed segment.
+  const uint64_t segment_offset = num_bytes_;
+  if (fseeko(file_, segment_offset, SEEK_SET) != 0) {
+    return false;
+  }
+  const SegmentHeader segment_header{kSegmentMagic,
+                                     static_cast<uint32_t>(layers.size())};
+  bool success = writeBytes(file_, &segment_header, sizeof(segment_header));
+
+  std::vector<IndexUpdate> updates;
+  for (const LayerToWrite& layer : layers) {
+    if (!success) {
+      break;
+    }
+    LayerHeader layer_header;
+    std::memset(&layer_header, 0, sizeof(layer_header));
+    std::memcpy(layer_header.name, layer.name.data(), layer.name.size());
+    layer_header.block_size = layer.block_size;
+    layer_header.num_records = changed_blocks.size();
+    success = writeBytes(file_, &layer_header, sizeof(layer_header));
+
+    // Blocks which are not allocated serialize to zero bytes, which records
+    // their removal.
+    auto write_data = [&](const Index3D& index, const Byte* data,
+                          size_t num_bytes) -> bool {
+      const RecordHeader record_header{{index.x(), index.y(), index.z()},
+                                       static_cast<uint32_t>(num_bytes)};
+      if (!writeBytes(file_, &record_header, sizeof(record_header))) {
+        return false;
+      }
+      const uint64_t payload_offset = ftello(file_);
+      updates.push_back({layer.name,
+                         layer.block_size,
+                         index,
+                         {payload_offset, static_cast<uint32_t>(num_bytes)}});
+      return writeBytes(file_, data, num_bytes);
+    };
+    success = success && layer.functions.serialize_data_batch(
+                             layer.layer, changed_blocks, write_data,
+                             cuda_stream);
+  }
+
+  // The segment is only valid once the trailer is on disk.
+  if (success) {
+    const CommitTrailer trailer{
+        kCommitMagic, 0,
+        static_cast<uint64_t>(ftello(file_)) + sizeof(CommitTrailer) -
+            segment_offset};
+    success = writeBytes(file_, &trailer, sizeof(trailer)) && syncFile(file_);
+  }
+  if (!success) {
+    LOG(ERROR) << "Failed to write checkpoint to: " << filename_;
+    return false;
+  }
+  num_bytes_ = ftello(file_);
+  // Drop the remains of a previously failed, longer segment.
+  if (ftruncate(fileno(file_), num_bytes_) != 0) {
+    LOG(WARNING) << "Failed to truncate: " << filename_;
+  }
+  applyUpdates(updates, &index_);
+  return true;
+}
+
+void CheckpointLog::compactAsync() {
+  if (compaction_future_.valid() &&
+      compaction_future_.wait_for(std::chrono::seconds(0)) !=
+          std::future_status::ready) {
+    return;
+  }
+  compaction_future_ = std::async(std::launch::async, [this]() { compact(); });
+}
+
+void CheckpointLog::waitForCompaction() const {
+  if (compaction_future_.valid()) {
+    compaction_future_.wait();
+  }
+}
+
+void CheckpointLog::compact() {
+  // Take a snapshot of the live blocks. Checkpoints appended while the
+  // snapshot is rewritten are copied over at the end.
+  LogIndex snapshot;
+  uint64_t snapshot_num_bytes;
+  std::string filename;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (file_ == nullptr) {
+      return;
+    }
+    snapshot = index_;
+    snapshot_num_bytes = num_bytes_;
+    filename = filename_;
+  }
+
+  const std::string compacted_filename = filename + ".compacting";
+  std::FILE* in = std::fopen(filename.c_str(), "rb");
+  std::FILE* out = std::fopen(compacted_filename.c_str(), "wb");
+  auto abort_compaction = [&]() {
+    LOG(WARNING) << "Failed to compact: " << filename;
+    if (in != nullptr) {
+      std::fclose(in);
+    }
+    if (out != nullptr) {
+      std::fclose(out);
+      std::remove(compacted_filename.c_str());
+    }
+  };
+  if (in == nullptr || out == nullptr || !writeLogHeader(out)) {
+    abort_compaction();
+    return;
+  }
+
+  // Write all live blocks as a single segment.
+  const uint64_t segment_offset = sizeof(LogHeader);
+  const SegmentHeader segment_header{kSegmentMagic,
+                                     static_cast<uint32_t>(snapshot.size())};
+  bool success = writeBytes(out, &segment_header, sizeof(segment_header));
+  std::vector<Byte> buffer;
+  for (const auto& [layer_name, layer_index] : snapshot) {
+    LayerHeader layer_header;
+    std::memset(&layer_header, 0, sizeof(layer_header));
+    std::memcpy(layer_header.name, layer_name.data(), layer_name.size());
+    layer_header.block_size = layer_index.block_size;
+    layer_header.num_records = layer_index.blocks.size();
+    success = success && writeBytes(out, &layer_header, sizeof(layer_header));
+    for (const auto& [index, record] : layer_index.blocks) {
+      const RecordHeader record_header{{index.x(), index.y(), index.z()},
+                                       record.num_bytes};
+      success = success &&
+                writeBytes(out, &record_header, sizeof(record_header)) &&
+                copyBytes(in, record.payload_offset, record.num_bytes, out,
+                          &buffer);
+    }
+  }
+  if (success) {
+    const CommitTrailer trailer{
+        kCommitMagic, 0,
+        static_cast<uint64_t>(ftello(out)) + sizeof(CommitTrailer) -
+            segment_offset};
+    success = writeBytes(out, &trailer, sizeof(trailer));
+  }
+  if (!success) {
+    abort_compaction();
+    return;
+  }
+
+  // Copy the checkpoints appended in the meantime and swap the files.
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (file_ == nullptr || filename_ != filename ||
+      !copyBytes(in, snapshot_num_bytes, num_bytes_ - snapshot_num_bytes, out,
+                 &buffer) ||
+      !syncFile(out)) {
+    abort_compaction();
+    return;
+  }
+  std::fclose(in);
+  std::fclose(out);
+  if (std::rename(compacted_filename.c_str(), filename.c_str()) != 0) {
+    LOG(WARNING) << "Failed to replace: " << filename;
+    std::remove(compacted_filename.c_str());
+    return;
+  }
+  std::fclose(file_);
+  file_ = std::fopen(filename.c_str(), "r+b");
+  if (file_ == nullptr || !readLogIndex(file_, &index_, &num_bytes_)) {
+    LOG(ERROR) << "Failed to reopen compacted checkpoint log: " << filename;
+    if (file_ != nullptr) {
+      std::fclose(file_);
+      file_ = nullptr;
+    }
+  }
+}
+
+uint64_t CheckpointLog::num_bytes() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return num_bytes_;
+}
+
+uint64_t CheckpointLog::num_live_bytes() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  uint64_t num_live_bytes = 0;
+  for (const auto& name_and_layer_index : index_) {
+    for (const auto& index_and_record : name_and_layer_index.second.blocks) {
+      num_live_bytes += index_and_record.second.num_bytes;
+    }
+  }
+  return num_live_bytes;
+}
+
+bool CheckpointLog::isCheckpointLogFile(const std::string& filename) {
+  std::FILE* file = std::fopen(filename.c_str(), "rb");
+  if (file == nullptr) {
+    return false;
+  }
+  char magic[sizeof(kMagic)];
+  const bool is_log = readBytes(file, magic, sizeof(magic)) &&
+                      std::memcmp(magic, kMagic, sizeof(kMagic)) == 0;
+  std::fclose(file);
+  return is_log;
+}
+
+LayerCake CheckpointLog::loadLayerCake(const std::string& filename,
+                                       MemoryType memory_type,
+                                       const CudaStream& cuda_stream) {
+  registerCommonTypes();
+  std::FILE* file = std::fopen(filename.c_str(), "rb");
+  LogIndex index;
+  uint64_t committed_num_bytes;
+  if (file == nullptr ||
+      !readLogIndex(file, &index, &committed_num_bytes)) {
+    LOG(ERROR) << "Could not read checkpoint log: " << filename;
+    if (file != nullptr) {
+      std::fclose(file);
+    }
+    return LayerCake();
+  }
+
+  float voxel_size = 0.0f;
+  host_vector<Byte> staging;
+  ScatterCopierGpu scatter_copier;
+  using TypeIndexAndLayerPtr =
+      std::pair<std::type_index, std::shared_ptr<BaseLayer>>;
+  std::vector<TypeIndexAndLayerPtr> layers;
+  for (const auto& [layer_name, layer_index] : index) {
+    const LayerSerializationFunctions layer_functions =
+        LayerTypeRegister::getSerializationFunctions(layer_name);
+    if (layer_functions.construct_layer == nullptr ||
+        layer_functions.allocate_blocks == nullptr) {
+      LOG(WARNING) << "Do not have deserialization functions for " << layer_name
+                   << ".";
+      continue;
+    }
+    LayerParameterStruct layer_params;
+    layer_params.float_params.emplace("block_size", layer_index.block_size);
+    std::shared_ptr<BaseLayer> layer =
+        layer_functions.construct_layer(memory_type, layer_params);
+
+    // Read the payloads in file order, into a contiguous buffer.
+    std::vector<std::pair<Index3D, BlockRecord>> records(
+        layer_index.blocks.begin(), layer_index.blocks.end());
+    std::sort(records.begin(), records.end(),
+              [](const auto& a, const auto& b) {
+                return a.second.payload_offset < b.second.payload_offset;
+              });
+    const size_t num_bytes_per_block =
+        records.empty() ? 0 : records[0].second.num_bytes;
+    std::vector<Index3D> indices;
+    indices.reserve(records.size());
+    staging.resizeAsync(records.size() * num_bytes_per_block, cuda_stream);
+    cuda_stream.synchronize();
+    bool success = true;
+    for (size_t i = 0; i < records.size() && success; ++i) {
+      indices.push_back(records[i].first);
+      success = records[i].second.num_bytes == num_bytes_per_block &&
+                fseeko(file, records[i].second.payload_offset, SEEK_SET) ==
+                    0 &&
+                readBytes(file, staging.data() + i * num_bytes_per_block,
+                          num_bytes_per_block);
+    }
+    std::vector<Byte*> block_data;
+    success = success &&
+              (records.empty() ||
+               layer_functions.allocate_blocks(indices, num_bytes_per_block,
+                                               layer.get(), &block_data,
+                                               cuda_stream));
+    if (!success) {
+      LOG(ERROR) << "Failed to load layer " << layer_name
+                 << " from checkpoint log: " << filename;
+      std::fclose(file);
+      return LayerCake();
+    }
+    scatter_copier.scatter(staging.data(), num_bytes_per_block, block_data,
+                           cuda_stream);
+
+    // NOTE: we check that all loaded layers have the same voxel size.
+    const float new_voxel_size =
+        layer_index.block_size / VoxelBlock<bool>::kVoxelsPerSide;
+    CHECK(voxel_size == 0.0f || voxel_size == new_voxel_size);
+    voxel_size = new_voxel_size;
+    layers.push_back(
+        {LayerTypeRegister::getLayerTypeIndex(layer_name), std::move(layer)});
+  }
+  std::fclose(file);
+
+  LayerCake cake(voxel_size);
+  for (auto&& type_index_lay_pair : layers) {
+    cake.insert(type_index_lay_pair.first,
+                std::move(type_index_lay_pair.second));
+  }
+  return cake;
+}
+
+}  // namespace nvblox
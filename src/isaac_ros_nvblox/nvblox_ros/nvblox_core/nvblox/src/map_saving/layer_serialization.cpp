@@ -0,0 +1,122 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "nvblox/map_saving/internal/layer_serialization.h"
+
+#include <cstring>
+
+namespace nvblox {
+namespace {
+
+// The sizes of the vectors of a serialized mesh block.
+struct MeshBlockHeader {
+  uint32_t num_vertices;
+  uint32_t num_normals;
+  uint32_t num_colors;
+  uint32_t num_triangles;
+};
+
+template <typename T>
+void appendVector(const unified_vector<T>& vector,
+                  const CudaStream& cuda_stream, std::vector<Byte>* bytes) {
+  const size_t offset = bytes->size();
+  bytes->resize(offset + vector.size() * sizeof(T));
+  if (!vector.empty()) {
+    checkCudaErrors(cudaMemcpyAsync(bytes->data() + offset, vector.data(),
+                                    vector.size() * sizeof(T),
+                                    cudaMemcpyDefault, cuda_stream));
+  }
+}
+
+template <typename T>
+const Byte* readVector(const Byte* data, const uint32_t num_elements,
+                       const CudaStream& cuda_stream,
+                       unified_vector<T>* vector) {
+  vector->copyFromAsync(reinterpret_cast<const T*>(data), num_elements,
+                        cuda_stream);
+  return data + num_elements * sizeof(T);
+}
+
+}  // namespace
+
+LayerParameterStruct serializeLayerParameters(const MeshLayer& layer) {
+  LayerParameterStruct params;
+  params.float_params.emplace("block_size", layer.block_size());
+  return params;
+}
+
+std::vector<Index3D> getLayerDataIndices(const MeshLayer& layer) {
+  return layer.getAllBlockIndices();
+}
+
+std::vector<Byte> serializeLayerDataAtIndex(const MeshLayer& layer,
+                                            const Index3D& index,
+                                            const CudaStream& cuda_stream) {
+  MeshBlock::ConstPtr block = layer.getBlockAtIndex(index);
+  if (block == nullptr) {
+    return std::vector<Byte>();
+  }
+  const MeshBlockHeader header{static_cast<uint32_t>(block->vertices.size()),
+                               static_cast<uint32_t>(block->normals.size()),
+                               static_cast<uint32_t>(block->colors.size()),
+                               static_cast<uint32_t>(block->triangles.size())};
+  std::vector<Byte> bytes(sizeof(header));
+  std::memcpy(bytes.data(), &header, sizeof(header));
+  appendVector(block->vertices, cuda_stream, &bytes);
+  appendVector(block->normals, cuda_stream, &bytes);
+  appendVector(block->colors, cuda_stream, &bytes);
+  appendVector(block->triangles, cuda_stream, &bytes);
+  // The copies write to the returned bytes.
+  cuda_stream.synchronize();
+  return bytes;
+}
+
+std::unique_ptr<MeshLayer> deserializeMeshLayerParameters(
+    MemoryType memory_type, const LayerParameterStruct& params) {
+  auto it = params.float_params.find("block_size");
+  if (it == params.float_params.end()) {
+    return std::unique_ptr<MeshLayer>();
+  }
+  return std::make_unique<MeshLayer>(it->second, memory_type);
+}
+
+void addDataToLayer(const Index3D& index, const std::vector<Byte>& data,
+                    MeshLayer* layer, const CudaStream& cuda_stream) {
+  CHECK_NOTNULL(layer);
+  MeshBlockHeader header;
+  if (data.size() < sizeof(header)) {
+    LOG(ERROR) << "Malformed mesh block at index: " << index.transpose();
+    return;
+  }
+  std::memcpy(&header, data.data(), sizeof(header));
+  const size_t expected_size =
+      sizeof(header) + header.num_vertices * sizeof(Vector3f) +
+      header.num_normals * sizeof(Vector3f) +
+      header.num_colors * sizeof(Color) + header.num_triangles * sizeof(int);
+  if (data.size() != expected_size) {
+    LOG(ERROR) << "Malformed mesh block at index: " << index.transpose();
+    return;
+  }
+  MeshBlock::Ptr block = layer->allocateBlockAtIndexAsync(index, cuda_stream);
+  const Byte* ptr = data.data() + sizeof(header);
+  ptr = readVector(ptr, header.num_vertices, cuda_stream, &block->vertices);
+  ptr = readVector(ptr, header.num_normals, cuda_stream, &block->normals);
+  ptr = readVector(ptr, header.num_colors, cuda_stream, &block->colors);
+  readVector(ptr, header.num_triangles, cuda_stream, &block->triangles);
+  // The data goes out of scope.
+  cuda_stream.synchronize();
+}
+
+}  // namespace nvblox
@@ -14,6 +14,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include <stdio.h>
+#include <algorithm>
 #include <vector>
 #include "nvblox/utils/logging.h"
 
@@ -21,6 +22,43 @@ limitations under the License.
 
 namespace nvblox {
 
+namespace {
+
+// The values stored under "compression" in the layer metadata table.
+constexpr char kCompressionParamName[] = "compression";
+constexpr char kCompressionNone[] = "none";
+constexpr char kCompressionVoxelRuns[] = "voxel_runs";
+
+// Stored in the metadata table of derived layers: the fingerprint of the
+// TSDF they were computed from.
+constexpr char kTsdfFingerprintParamName[] = "tsdf_fingerprint";
+
+// FNV-1a hash of a stored block and its index. The hashes of the blocks of a
+// layer are summed, such that its fingerprint doesn't depend on the order
+// the blocks are written or read in.
+uint64_t hashBlockData(const Index3D& index, const Byte* data,
+                       size_t num_bytes) {
+  constexpr uint64_t kFnvOffsetBasis = 14695981039346656037ull;
+  constexpr uint64_t kFnvPrime = 1099511628211ull;
+  uint64_t hash = kFnvOffsetBasis;
+  auto hash_bytes = [&hash](const Byte* bytes, size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+      hash ^= bytes[i];
+      hash *= kFnvPrime;
+    }
+  };
+  hash_bytes(reinterpret_cast<const Byte*>(index.data()), sizeof(Index3D));
+  hash_bytes(data, num_bytes);
+  return hash;
+}
+
+// Layers computed from the TSDF, see Serializer::store_derived_layers().
+bool isDerivedLayer(const std::type_index& type_index) {
+  return type_index == typeid(EsdfLayer) || type_index == typeid(MeshLayer);
+}
+
+}  // namespace
+
 Serializer::Serializer() {
   // Common types are automatically registered.
   registerCommonTypes();
@@ -43,9 +81,19 @@ bool Serializer::open(const std::string& filename,
 
 LayerCake Serializer::loadLayerCake(MemoryType memory_type,
                                     const CudaStream& cuda_stream) {
-  // Get all the layers that are in here.
+  consistent_derived_layers_.clear();
+
+  // Get all the layers that are in here. The TSDF is loaded before the
+  // derived layers, which are checked against its fingerprint.
   std::vector<std::string> layer_names;
   getLayerNames(&layer_names);
+  std::stable_partition(layer_names.begin(), layer_names.end(),
+                        [](const std::string& layer_name) {
+                          return !isDerivedLayer(
+                              LayerTypeRegister::getLayerTypeIndex(layer_name));
+                        });
+  bool tsdf_loaded = false;
+  uint64_t tsdf_fingerprint = 0;
 
   using TypeIndexAndLayerPtr =
       std::pair<std::type_index, std::shared_ptr<BaseLayer>>;
@@ -73,6 +121,38 @@ LayerCake Serializer::loadLayerCake(MemoryType memory_type,
     LayerParameterStruct layer_params;
     getLayerParameters(layer_name, &layer_params);
 
+    // Derived layers stored along with another TSDF are stale. Files written
+    // without derived layers may still hold an ESDF, which isn't tagged.
+    auto fingerprint_it =
+        layer_params.string_params.find(kTsdfFingerprintParamName);
+    const bool has_fingerprint =
+        fingerprint_it != layer_params.string_params.end();
+    if (has_fingerprint &&
+        (!tsdf_loaded ||
+         fingerprint_it->second != std::to_string(tsdf_fingerprint))) {
+      LOG(WARNING) << "Skipping layer " << layer_name
+                   << " as it was computed from a different TSDF.";
+      continue;
+    }
+
+    // Files written before compression was supported don't have the
+    // parameter and are uncompressed.
+    LayerSerializationFunctions::AddDataToLayerFunction add_data =
+        layer_functions.add_data;
+    auto compression_it =
+        layer_params.string_params.find(kCompressionParamName);
+    if (compression_it != layer_params.string_params.end() &&
+        compression_it->second != kCompressionNone) {
+      if (compression_it->second == kCompressionVoxelRuns &&
+          layer_functions.add_compressed_data != nullptr) {
+        add_data = layer_functions.add_compressed_data;
+      } else {
+        LOG(WARNING) << "Can't decompress layer " << layer_name
+                     << " with compression: " << compression_it->second;
+        continue;
+      }
+    }
+
     // Create the layer object.
     std::shared_ptr<BaseLayer> layer;
     layer = layer_functions.construct_layer(memory_type, layer_params);
@@ -81,10 +161,22 @@ LayerCake Serializer::loadLayerCake(MemoryType memory_type,
     std::vector<Index3D> data_indices;
     getDataIndices(layer_name, &data_indices);
 
+    const bool is_tsdf = type_index == typeid(TsdfLayer);
+    uint64_t data_fingerprint = 0;
     for (const Index3D& index : data_indices) {
       std::vector<Byte> data;
       getDataAtIndex(layer_name, index, &data);
-      layer_functions.add_data(index, data, layer.get(), cuda_stream);
+      if (is_tsdf) {
+        data_fingerprint += hashBlockData(index, data.data(), data.size());
+      }
+      add_data(index, data, layer.get(), cuda_stream);
+    }
+    if (is_tsdf) {
+      tsdf_loaded = true;
+      tsdf_fingerprint = data_fingerprint;
+    }
+    if (has_fingerprint) {
+      consistent_derived_layers_.insert(type_index);
     }
 
     // If the layer has a block size, then set the layer cake to the correct
@@ -117,17 +209,18 @@ bool Serializer::writeLayerCake(const LayerCake& cake,
   const std::unordered_map<std::type_index, std::shared_ptr<BaseLayer>>&
       layer_map = cake.get_layers();
 
-  // For each layer, figure out the type, then serialize the parameters, then
-  // finally the data.
-  for (auto it = layer_map.begin(); it != layer_map.end(); it++) {
-    // First get the name of the layer.
-    std::string layer_name = LayerTypeRegister::getLayerName(it->first);
-    if (layer_name.empty()) {
-      LOG(ERROR) << "Unrecognized layer type, can't serialize: "
-                 << it->first.name();
-      continue;
-    }
-
+  // The write-ahead log avoids writing every page twice. We switch back to
+  // the default journal at the end, such that the file is self-contained.
+  sqlite_.setJournalMode("WAL");
+  bool success = true;
+
+  // Serialize the parameters, then the data of a layer. Layers we don't know
+  // how to serialize are skipped.
+  auto write_layer = [&](const std::string& layer_name,
+                         const BaseLayer* layer,
+                         BlockCompression block_compression,
+                         const LayerParameterStruct& extra_params,
+                         uint64_t* data_fingerprint) -> bool {
     // Get all of the functions we need.
     LayerSerializationFunctions layer_functions =
         LayerTypeRegister::getSerializationFunctions(layer_name);
@@ -136,7 +229,13 @@ bool Serializer::writeLayerCake(const LayerCake& cake,
     if (layer_functions.serialize_params == nullptr ||
         layer_functions.get_data_indices == nullptr ||
         layer_functions.serialize_data == nullptr) {
-      continue;
+      return true;
+    }
+
+    // Fall back to raw blocks for layers which can't be compressed.
+    if (layer_functions.serialize_compressed_data_batch == nullptr ||
+        layer_functions.add_compressed_data == nullptr) {
+      block_compression = BlockCompression::kNone;
     }
 
     // Create the layer tables.
@@ -144,28 +243,131 @@ bool Serializer::writeLayerCake(const LayerCake& cake,
 
     // Populate the layer metadata table.
     LayerParameterStruct param_struct =
-        layer_functions.serialize_params(it->second.get());
+        layer_functions.serialize_params(layer);
+    param_struct.string_params.insert(extra_params.string_params.begin(),
+                                      extra_params.string_params.end());
     param_struct.string_params["type"] = layer_name;
+    param_struct.string_params[kCompressionParamName] =
+        (block_compression == BlockCompression::kVoxelRuns)
+            ? kCompressionVoxelRuns
+            : kCompressionNone;
     setLayerParameters(layer_name, param_struct);
 
     // Populate the blocks.
-    // Get a list of all the blocks.
-    std::vector<Index3D> data_indices =
-        layer_functions.get_data_indices(it->second.get());
-
-    // Batching these into a transaction is needed for performance reasons.
-    sqlite_.runStatement("BEGIN TRANSACTION;");
-    for (const Index3D& index : data_indices) {
-      // Get the byte string for this data.
-      std::vector<Byte> data_bytes =
-          layer_functions.serialize_data(it->second.get(), index, cuda_stream);
+    return addAllLayerData(layer_name, layer_functions, layer, cuda_stream,
+                           block_compression, data_fingerprint);
+  };
+
+  // For each layer, figure out the type, then write it. The derived layers
+  // are written last, tagged with the fingerprint of the TSDF.
+  std::vector<std::pair<std::string, const BaseLayer*>> derived_layers;
+  bool tsdf_written = false;
+  uint64_t tsdf_fingerprint = 0;
+  for (auto it = layer_map.begin(); it != layer_map.end(); it++) {
+    // First get the name of the layer.
+    std::string layer_name = LayerTypeRegister::getLayerName(it->first);
+    if (layer_name.empty()) {
+      LOG(ERROR) << "Unrecognized layer type, can't serialize: "
+                 << it->first.name();
+      continue;
+    }
 
-      addLayerData(layer_name, index, data_bytes);
+    if (isDerivedLayer(it->first) && store_derived_layers_) {
+      derived_layers.push_back({layer_name, it->second.get()});
+      continue;
     }
-    sqlite_.runStatement("END TRANSACTION;");
+    // The mesh is only useful together with the fingerprint.
+    if (it->first == typeid(MeshLayer)) {
+      continue;
+    }
+    const bool is_tsdf = it->first == typeid(TsdfLayer);
+    success &= write_layer(layer_name, it->second.get(), block_compression_,
+                           LayerParameterStruct(),
+                           is_tsdf ? &tsdf_fingerprint : nullptr);
+    tsdf_written |= is_tsdf;
   }
 
-  return true;
+  LayerParameterStruct derived_params;
+  if (tsdf_written) {
+    derived_params.string_params[kTsdfFingerprintParamName] =
+        std::to_string(tsdf_fingerprint);
+  }
+  for (const auto& [layer_name, layer] : derived_layers) {
+    success &= write_layer(layer_name, layer, BlockCompression::kVoxelRuns,
+                           derived_params, nullptr);
+  }
+
+  sqlite_.setJournalMode("DELETE");
+  return success;
+}
+
+void Serializer::block_compression(BlockCompression block_compression) {
+  block_compression_ = block_compression;
+}
+
+BlockCompression Serializer::block_compression() const {
+  return block_compression_;
+}
+
+void Serializer::store_derived_layers(bool store_derived_layers) {
+  store_derived_layers_ = store_derived_layers;
+}
+
+bool Serializer::store_derived_layers() const { return store_derived_layers_; }
+
+bool Serializer::addAllLayerData(
+    const std::string& layer_name,
+    const LayerSerializationFunctions& layer_functions,
+    const BaseLayer* layer, const CudaStream& cuda_stream,
+    BlockCompression block_compression, uint64_t* data_fingerprint) {
+  if (data_fingerprint != nullptr) {
+    *data_fingerprint = 0;
+  }
+
+  // Get a list of all the blocks.
+  const std::vector<Index3D> data_indices =
+      layer_functions.get_data_indices(layer);
+
+  // Batching these into a transaction is needed for performance reasons.
+  if (!sqlite_.runStatement("BEGIN TRANSACTION;")) {
+    return false;
+  }
+  std::string sql_statement = "INSERT INTO " + layerDataTableName(layer_name) +
+                              " (index_x, index_y, index_z, data) VALUES "
+                              "(?,?,?,?)";
+  bool success = sqlite_.prepareStatement(sql_statement);
+  if (success) {
+    auto write_data = [this, data_fingerprint](const Index3D& index,
+                                               const Byte* data,
+                                               size_t num_bytes) -> bool {
+      if (data_fingerprint != nullptr) {
+        *data_fingerprint += hashBlockData(index, data, num_bytes);
+      }
+      return sqlite_.runPreparedStatement({index.x(), index.y(), index.z()},
+                                          data, num_bytes);
+    };
+    if (block_compression == BlockCompression::kVoxelRuns) {
+      CHECK(layer_functions.serialize_compressed_data_batch != nullptr);
+      success = layer_functions.serialize_compressed_data_batch(
+          layer, data_indices, write_data, cuda_stream);
+    } else if (layer_functions.serialize_data_batch != nullptr) {
+      success = layer_functions.serialize_data_batch(layer, data_indices,
+                                                     write_data, cuda_stream);
+    } else {
+      for (const Index3D& index : data_indices) {
+        // Get the byte string for this data.
+        const std::vector<Byte> data_bytes =
+            layer_functions.serialize_data(layer, index, cuda_stream);
+        if (!write_data(index, data_bytes.data(), data_bytes.size())) {
+          success = false;
+          break;
+        }
+      }
+    }
+    sqlite_.finalizePreparedStatement();
+  }
+  success &= sqlite_.runStatement("END TRANSACTION;");
+  return success;
 }
 
 /// Close the file.
@@ -14,6 +14,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include <sqlite3.h>
+#include <strings.h>
 #include <cstdio>
 #include <fstream>
 #include <vector>
@@ -24,6 +25,7 @@ limitations under the License.
 namespace nvblox {
 
 SqliteDatabase::~SqliteDatabase() {
+  finalizePreparedStatement();
   if (db_ != nullptr) {
     close();
   }
@@ -60,6 +62,7 @@ bool SqliteDatabase::open(const std::string& filename,
 
 /// Close the file.
 bool SqliteDatabase::close() {
+  finalizePreparedStatement();
   int status = sqlite3_close_v2(db_);
   db_ = nullptr;
   return status == SQLITE_OK;
@@ -106,6 +109,63 @@ bool SqliteDatabase::runStatementWithBlob(const std::string& sql_query,
   return retval;
 }
 
+bool SqliteDatabase::prepareStatement(const std::string& sql_query) {
+  finalizePreparedStatement();
+  int status = sqlite3_prepare_v2(db_, sql_query.c_str(), -1,
+                                  &prepared_statement_, 0);
+  if (status != SQLITE_OK) {
+    LOG(ERROR) << "Preparing query failed: " << sqlite3_errmsg(db_)
+               << "\nQuery: " << sql_query;
+    finalizePreparedStatement();
+    return false;
+  }
+  return true;
+}
+
+bool SqliteDatabase::runPreparedStatement(const std::vector<int>& int_params,
+                                          const Byte* blob,
+                                          size_t blob_size) {
+  if (prepared_statement_ == nullptr) {
+    LOG(ERROR) << "No prepared statement to run.";
+    return false;
+  }
+  // Parameter indexing starts at 1.
+  int param_idx = 1;
+  for (const int param : int_params) {
+    sqlite3_bind_int(prepared_statement_, param_idx++, param);
+  }
+  sqlite3_bind_blob(prepared_statement_, param_idx, blob, blob_size,
+                    SQLITE_STATIC);
+
+  bool retval = true;
+  if (sqlite3_step(prepared_statement_) != SQLITE_DONE) {
+    LOG(ERROR) << "Query execution failed: " << sqlite3_errmsg(db_);
+    retval = false;
+  }
+  // Get ready for the next run.
+  sqlite3_reset(prepared_statement_);
+  sqlite3_clear_bindings(prepared_statement_);
+  return retval;
+}
+
+void SqliteDatabase::finalizePreparedStatement() {
+  if (prepared_statement_ != nullptr) {
+    sqlite3_finalize(prepared_statement_);
+    prepared_statement_ = nullptr;
+  }
+}
+
+bool SqliteDatabase::setJournalMode(const std::string& journal_mode) {
+  // The pragma returns the resulting mode.
+  std::string resulting_mode;
+  if (!runSingleQueryString("PRAGMA journal_mode=" + journal_mode + ";",
+                            &resulting_mode)) {
+    return false;
+  }
+  // In-memory databases, for example, only support the "memory" mode.
+  return strcasecmp(resulting_mode.c_str(), journal_mode.c_str()) == 0;
+}
+
 bool SqliteDatabase::runSingleQueryString(const std::string& sql_query,
                                           std::string* result) {
   bool retval = true;
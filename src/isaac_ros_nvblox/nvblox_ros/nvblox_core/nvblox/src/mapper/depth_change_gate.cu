@@ -0,0 +1,119 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "nvblox/mapper/depth_change_gate.h"
+
+#include "nvblox/core/internal/error_check.h"
+#include "nvblox/utils/timing.h"
+
+namespace nvblox {
+
+// Copies the depth of the changed pixels and invalidates the unchanged ones.
+// A pixel is unchanged if both it and the rendered surface have valid depth,
+// differing by at most min_residual_m. The rendered image may be subsampled,
+// each of its pixels then covers a patch of the depth frame. One thread per
+// pixel, laid out as in countChangedPixelsKernel().
+__global__ void gateUnchangedPixelsKernel(DepthImageConstView depth_frame,
+                                          DepthImageConstView rendered_depth,
+                                          float min_residual_m,
+                                          DepthImageView gated_depth) {
+  const int row_idx = blockIdx.x * blockDim.x + threadIdx.x;
+  const int col_idx = blockIdx.y * blockDim.y + threadIdx.y;
+  if (row_idx >= depth_frame.rows() || col_idx >= depth_frame.cols()) {
+    return;
+  }
+  const float depth = depth_frame(row_idx, col_idx);
+  const int rendered_row_idx =
+      (row_idx * rendered_depth.rows()) / depth_frame.rows();
+  const int rendered_col_idx =
+      (col_idx * rendered_depth.cols()) / depth_frame.cols();
+  const float surface_depth =
+      rendered_depth(rendered_row_idx, rendered_col_idx);
+  const bool is_unchanged = depth > 0.0f && surface_depth > 0.0f &&
+                            fabsf(depth - surface_depth) <= min_residual_m;
+  gated_depth(row_idx, col_idx) = is_unchanged ? 0.0f : depth;
+}
+
+DepthChangeGate::DepthChangeGate(std::shared_ptr<CudaStream> cuda_stream)
+    : sphere_tracer_(cuda_stream), cuda_stream_(cuda_stream) {}
+
+bool DepthChangeGate::gateFrame(const DepthImageConstView& depth_frame,
+                                const Transform& T_L_C, const Camera& camera,
+                                const TsdfLayer& tsdf_layer,
+                                const float truncation_distance_m) {
+  // Periodically, and while there's nothing to compare against, frames are
+  // integrated in full.
+  const bool is_full_frame =
+      num_frames_since_full_frame_ < 0 ||
+      ++num_frames_since_full_frame_ >= full_frame_period_;
+  if (is_full_frame || tsdf_layer.numAllocatedBlocks() == 0) {
+    if (is_full_frame) {
+      num_frames_since_full_frame_ = 0;
+    }
+    return false;
+  }
+  timing::Timer timer("depth_change_gate/gate_frame");
+
+  // The sphere tracer requires the image size to be divisible by the
+  // subsampling factor.
+  const int subsampling_factor =
+      (camera.width() % render_subsampling_factor_ == 0 &&
+       camera.height() % render_subsampling_factor_ == 0)
+          ? render_subsampling_factor_
+          : 1;
+  sphere_tracer_.renderImageOnGPU(camera, T_L_C, tsdf_layer,
+                                  truncation_distance_m, &rendered_depth_,
+                                  MemoryType::kDevice, subsampling_factor);
+
+  if (gated_depth_.rows() != depth_frame.rows() ||
+      gated_depth_.cols() != depth_frame.cols()) {
+    gated_depth_ =
+        DepthImage(depth_frame.rows(), depth_frame.cols(), MemoryType::kDevice);
+  }
+  constexpr int kThreadsPerBlockInEachDimension = 8;
+  const dim3 block_shape(kThreadsPerBlockInEachDimension,
+                         kThreadsPerBlockInEachDimension);
+  const dim3 grid_shape(
+      depth_frame.rows() / kThreadsPerBlockInEachDimension + 1,
+      depth_frame.cols() / kThreadsPerBlockInEachDimension + 1);
+  gateUnchangedPixelsKernel<<<grid_shape, block_shape, 0, *cuda_stream_>>>(
+      depth_frame,                           // NOLINT
+      DepthImageConstView(rendered_depth_),  // NOLINT
+      min_residual_m_,                       // NOLINT
+      DepthImageView(gated_depth_));
+  checkCudaErrors(cudaPeekAtLastError());
+  ++num_gated_frames_;
+  return true;
+}
+
+void DepthChangeGate::reset() { num_frames_since_full_frame_ = -1; }
+
+void DepthChangeGate::min_residual_m(float min_residual_m) {
+  CHECK_GE(min_residual_m, 0.0f);
+  min_residual_m_ = min_residual_m;
+}
+
+void DepthChangeGate::full_frame_period(int full_frame_period) {
+  CHECK_GE(full_frame_period, 1);
+  full_frame_period_ = full_frame_period;
+}
+
+void DepthChangeGate::render_subsampling_factor(
+    int render_subsampling_factor) {
+  CHECK_GE(render_subsampling_factor, 1);
+  render_subsampling_factor_ = render_subsampling_factor;
+}
+
+}  // namespace nvblox
@@ -0,0 +1,131 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "nvblox/mapper/depth_frame_gate.h"
+
+#include "nvblox/core/internal/error_check.h"
+
+namespace nvblox {
+
+// Counts the pixels whose depth changed by more than max_depth_change_m, or
+// which changed between valid (positive) and invalid depth. One thread per
+// pixel, laid out as in differenceImageKernel().
+__global__ void countChangedPixelsKernel(DepthImageConstView depth_frame,
+                                         DepthImageConstView keyframe,
+                                         float max_depth_change_m,
+                                         int* num_changed_pixels) {
+  const int row_idx = blockIdx.x * blockDim.x + threadIdx.x;
+  const int col_idx = blockIdx.y * blockDim.y + threadIdx.y;
+  if (row_idx >= depth_frame.rows() || col_idx >= depth_frame.cols()) {
+    return;
+  }
+  const float depth = depth_frame(row_idx, col_idx);
+  const float keyframe_depth = keyframe(row_idx, col_idx);
+  const bool is_valid = depth > 0.0f;
+  const bool was_valid = keyframe_depth > 0.0f;
+  if (is_valid != was_valid ||
+      (is_valid && fabsf(depth - keyframe_depth) > max_depth_change_m)) {
+    atomicAdd(num_changed_pixels, 1);
+  }
+}
+
+DepthFrameGate::DepthFrameGate(std::shared_ptr<CudaStream> cuda_stream)
+    : cuda_stream_(cuda_stream) {}
+
+bool DepthFrameGate::isRedundant(const DepthImageConstView& depth_frame,
+                                 const Transform& T_L_C) {
+  const bool is_comparable = T_L_keyframe_.has_value() &&
+                             keyframe_depth_.rows() == depth_frame.rows() &&
+                             keyframe_depth_.cols() == depth_frame.cols();
+  if (!is_comparable) {
+    setKeyframe(depth_frame, T_L_C);
+    return false;
+  }
+
+  // The pose is checked first as it is free.
+  const Transform T_keyframe_C = T_L_keyframe_->inverse() * T_L_C;
+  const float translation_m = T_keyframe_C.translation().norm();
+  const float rotation_rad = Eigen::AngleAxisf(T_keyframe_C.rotation()).angle();
+  if (translation_m > max_translation_m_ || rotation_rad > max_rotation_rad_) {
+    setKeyframe(depth_frame, T_L_C);
+    return false;
+  }
+
+  const int num_changed_pixels = countChangedPixels(depth_frame);
+  if (num_changed_pixels >
+      max_changed_pixel_fraction_ * static_cast<float>(depth_frame.numel())) {
+    setKeyframe(depth_frame, T_L_C);
+    return false;
+  }
+  ++num_redundant_frames_;
+  return true;
+}
+
+void DepthFrameGate::reset() { T_L_keyframe_.reset(); }
+
+void DepthFrameGate::setKeyframe(const DepthImageConstView& depth_frame,
+                                 const Transform& T_L_C) {
+  keyframe_depth_.copyFromAsync(depth_frame, *cuda_stream_);
+  T_L_keyframe_ = T_L_C;
+}
+
+int DepthFrameGate::countChangedPixels(
+    const DepthImageConstView& depth_frame) {
+  if (changed_pixels_device_ == nullptr || changed_pixels_host_ == nullptr) {
+    changed_pixels_device_ = make_unified<int>(MemoryType::kDevice);
+    changed_pixels_host_ = make_unified<int>(MemoryType::kHost);
+  }
+  changed_pixels_device_.setZeroAsync(*cuda_stream_);
+
+  constexpr int kThreadsPerBlockInEachDimension = 8;
+  const dim3 block_shape(kThreadsPerBlockInEachDimension,
+                         kThreadsPerBlockInEachDimension);
+  const dim3 grid_shape(
+      depth_frame.rows() / kThreadsPerBlockInEachDimension + 1,
+      depth_frame.cols() / kThreadsPerBlockInEachDimension + 1);
+  countChangedPixelsKernel<<<grid_shape, block_shape, 0, *cuda_stream_>>>(
+      depth_frame,                           // NOLINT
+      DepthImageConstView(keyframe_depth_),  // NOLINT
+      max_depth_change_m_,                   // NOLINT
+      changed_pixels_device_.get());
+  checkCudaErrors(cudaPeekAtLastError());
+  changed_pixels_device_.copyToAsync(changed_pixels_host_, *cuda_stream_);
+  cuda_stream_->synchronize();
+  return *changed_pixels_host_;
+}
+
+void DepthFrameGate::max_translation_m(float max_translation_m) {
+  CHECK_GE(max_translation_m, 0.0f);
+  max_translation_m_ = max_translation_m;
+}
+
+void DepthFrameGate::max_rotation_rad(float max_rotation_rad) {
+  CHECK_GE(max_rotation_rad, 0.0f);
+  max_rotation_rad_ = max_rotation_rad;
+}
+
+void DepthFrameGate::max_depth_change_m(float max_depth_change_m) {
+  CHECK_GE(max_depth_change_m, 0.0f);
+  max_depth_change_m_ = max_depth_change_m;
+}
+
+void DepthFrameGate::max_changed_pixel_fraction(
+    float max_changed_pixel_fraction) {
+  CHECK_GE(max_changed_pixel_fraction, 0.0f);
+  CHECK_LE(max_changed_pixel_fraction, 1.0f);
+  max_changed_pixel_fraction_ = max_changed_pixel_fraction;
+}
+
+}  // namespace nvblox
@@ -15,16 +15,70 @@ limitations under the License.
 */
 #include "nvblox/mapper/mapper.h"
 
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <future>
+#include <thread>
+
+#include "nvblox/core/memory_pool.h"
 #include "nvblox/geometry/bounding_boxes.h"
 #include "nvblox/geometry/bounding_spheres.h"
+#include "nvblox/geometry/workspace_bounds.h"
 #include "nvblox/io/layer_cake_io.h"
 #include "nvblox/io/mesh_io.h"
 #include "nvblox/io/pointcloud_io.h"
 #include "nvblox/mapper/internal/mapper_common.h"
+#include "nvblox/utils/flight_recorder.h"
+#include "nvblox/utils/flight_recorder.h"
 #include "nvblox/utils/rates.h"
+#include "nvblox/utils/timing.h"
 
 namespace nvblox {
 
+namespace {
+
+// Copies the blocks at the passed indices from one layer into another. Blocks
+// missing in the source are cleared in the destination.
+template <typename LayerType>
+void copyBlocksAsync(const LayerType& source,
+                     const std::vector<Index3D>& block_indices,
+                     LayerType* destination, const CudaStream& cuda_stream) {
+  for (const Index3D& block_index : block_indices) {
+    auto source_block = source.getBlockAtIndex(block_index);
+    if (source_block == nullptr) {
+      destination->clearBlock(block_index);
+      continue;
+    }
+    auto destination_block =
+        destination->allocateBlockAtIndexAsync(block_index, cuda_stream);
+    checkCudaErrors(cudaMemcpyAsync(
+        destination_block->voxels, source_block->voxels,
+        sizeof(source_block->voxels), cudaMemcpyDefault, cuda_stream));
+  }
+}
+
+bool isSameCamera(const Camera& lhs, const Camera& rhs) {
+  return lhs.fu() == rhs.fu() && lhs.fv() == rhs.fv() &&
+         lhs.cu() == rhs.cu() && lhs.cv() == rhs.cv() &&
+         lhs.width() == rhs.width() && lhs.height() == rhs.height() &&
+         lhs.hasSameDistortion(rhs);
+}
+
+// Copy blocks between the layers of a type in two cakes, if both have one.
+template <typename LayerType>
+void copyBlocksIfLayerExists(const std::vector<Index3D>& block_indices,
+                             const LayerCake& from, LayerCake* to,
+                             const CudaStream& cuda_stream) {
+  const LayerType* from_layer = from.getConstPtr<LayerType>();
+  LayerType* to_layer = to->getPtr<LayerType>();
+  if (from_layer != nullptr && to_layer != nullptr) {
+    to_layer->copyBlocksFromAsync(*from_layer, block_indices, cuda_stream);
+  }
+}
+
+}  // namespace
+
 Mapper::Mapper(float voxel_size_m, MemoryType memory_type,
                ProjectiveLayerType projective_layer_type,
                std::shared_ptr<CudaStream> cuda_stream)
@@ -34,14 +88,21 @@ Mapper::Mapper(float voxel_size_m, MemoryType memory_type,
       projective_layer_type_(projective_layer_type),
       tsdf_integrator_(cuda_stream),
       lidar_tsdf_integrator_(cuda_stream),
+      lidar_pointcloud_tsdf_integrator_(cuda_stream),
       freespace_integrator_(cuda_stream),
       occupancy_integrator_(cuda_stream),
       lidar_occupancy_integrator_(cuda_stream),
+      tsdf_block_pruner_(cuda_stream),
       tsdf_shape_clearer_(cuda_stream),
       color_integrator_(cuda_stream),
       mesh_integrator_(cuda_stream),
       esdf_integrator_(cuda_stream),
+      dense_esdf_slice_integrator_(cuda_stream),
+      collision_checker_(cuda_stream),
+      serialized_layer_merger_(cuda_stream),
       depth_preprocessor_(cuda_stream),
+      depth_frame_gate_(cuda_stream),
+      depth_change_gate_(cuda_stream),
       blocks_to_update_tracker_(projective_layer_type) {
   layers_ =
       LayerCake::create<TsdfLayer, ColorLayer, FreespaceLayer, OccupancyLayer,
@@ -54,6 +115,8 @@ Mapper::Mapper(float voxel_size_m, MemoryType memory_type,
                        &color_integrator_);
   // Make the LiDAR integrators share the same viewpoint cache
   shareViewpointCaches(&lidar_tsdf_integrator_, &lidar_occupancy_integrator_);
+  shareScratchArena();
+  shareCameraRayCache();
 }
 
 Mapper::Mapper(const std::string& map_filepath, MemoryType memory_type,
@@ -62,23 +125,92 @@ Mapper::Mapper(const std::string& map_filepath, MemoryType memory_type,
       memory_type_(memory_type),
       tsdf_integrator_(cuda_stream),
       lidar_tsdf_integrator_(cuda_stream),
+      lidar_pointcloud_tsdf_integrator_(cuda_stream),
       freespace_integrator_(cuda_stream),
       occupancy_integrator_(cuda_stream),
       lidar_occupancy_integrator_(cuda_stream),
+      tsdf_block_pruner_(cuda_stream),
       tsdf_shape_clearer_(cuda_stream),
       color_integrator_(cuda_stream),
       mesh_integrator_(cuda_stream),
       esdf_integrator_(cuda_stream),
+      dense_esdf_slice_integrator_(cuda_stream),
+      collision_checker_(cuda_stream),
+      serialized_layer_merger_(cuda_stream),
       depth_preprocessor_(cuda_stream),
+      depth_frame_gate_(cuda_stream),
+      depth_change_gate_(cuda_stream),
       blocks_to_update_tracker_(kDefaultProjectiveLayerType) {
+  shareScratchArena();
+  shareCameraRayCache();
   loadMap(map_filepath);
 }
 
+void Mapper::shareScratchArena() {
+  // NOTE: The ESDF integrator is left out as it may run on its own stream.
+  tsdf_integrator_.view_calculator().scratch_arena(&scratch_arena_);
+  lidar_tsdf_integrator_.view_calculator().scratch_arena(&scratch_arena_);
+  occupancy_integrator_.view_calculator().scratch_arena(&scratch_arena_);
+  lidar_occupancy_integrator_.view_calculator().scratch_arena(&scratch_arena_);
+  color_integrator_.view_calculator().scratch_arena(&scratch_arena_);
+  freespace_integrator_.scratch_arena(&scratch_arena_);
+}
+
+void Mapper::build_depth_pyramid(const bool build_depth_pyramid) {
+  build_depth_pyramid_ = build_depth_pyramid;
+  // Only the camera integrators raycast the frames the pyramid is built from.
+  const DepthPyramid* depth_pyramid =
+      build_depth_pyramid_ ? &depth_pyramid_ : nullptr;
+  tsdf_integrator_.view_calculator().depth_pyramid(depth_pyramid);
+  occupancy_integrator_.view_calculator().depth_pyramid(depth_pyramid);
+}
+
+void Mapper::shareCameraRayCache() {
+  tsdf_integrator_.view_calculator().camera_ray_cache(camera_ray_cache_);
+  occupancy_integrator_.view_calculator().camera_ray_cache(camera_ray_cache_);
+  color_integrator_.view_calculator().camera_ray_cache(camera_ray_cache_);
+  color_integrator_.sphere_tracer().camera_ray_cache(camera_ray_cache_);
+}
+
 void Mapper::setMapperParams(const MapperParams& params) {
   // ======= MAPPER =======
   // depth preprocessing
   do_depth_preprocessing(params.do_depth_preprocessing);
   depth_preprocessing_num_dilations(params.depth_preprocessing_num_dilations);
+  use_cuda_graphs(params.use_cuda_graphs);
+  use_vpi_depth_preprocessing(params.use_vpi_depth_preprocessing);
+  skip_redundant_depth_frames(params.skip_redundant_depth_frames);
+  build_depth_pyramid(params.build_depth_pyramid);
+  depth_frame_gate().max_translation_m(
+      params.depth_frame_gate_params.depth_frame_gate_max_translation_m);
+  depth_frame_gate().max_rotation_rad(
+      params.depth_frame_gate_params.depth_frame_gate_max_rotation_rad);
+  depth_frame_gate().max_depth_change_m(
+      params.depth_frame_gate_params.depth_frame_gate_max_depth_change_m);
+  depth_frame_gate().max_changed_pixel_fraction(
+      params.depth_frame_gate_params
+          .depth_frame_gate_max_changed_pixel_fraction);
+  gate_unchanged_depth_pixels(params.gate_unchanged_depth_pixels);
+  depth_change_gate().min_residual_m(
+      params.depth_change_gate_params.depth_change_gate_min_residual_m);
+  depth_change_gate().full_frame_period(
+      params.depth_change_gate_params.depth_change_gate_full_frame_period);
+  depth_change_gate().render_subsampling_factor(
+      params.depth_change_gate_params
+          .depth_change_gate_render_subsampling_factor);
+  concurrent_layer_serialization(params.concurrent_layer_serialization);
+  mesh_streaming_max_bytes_per_publish(
+      params.mesh_streaming_max_bytes_per_publish);
+  mesh_streaming_distance_weight(params.mesh_streaming_distance_weight);
+  mesh_streaming_staleness_weight(params.mesh_streaming_staleness_weight);
+  compress_saved_maps(params.compress_saved_maps);
+  save_derived_layers(params.save_derived_layers);
+  esdf_window_half_extent_m(params.esdf_window_half_extent_m);
+  memory_pressure_watermark(params.memory_pressure_watermark);
+  memory_pressure_keep_radius_m(params.memory_pressure_keep_radius_m);
+  memory_pressure_page_out(params.memory_pressure_page_out);
+  morton_ordered_blocks(params.morton_ordered_blocks);
+  block_relayout_allocation_fraction(params.block_relayout_allocation_fraction);
 
   // ======= ESDF INTEGRATOR =======
   esdf_integrator().esdf_slice_min_height(
@@ -91,12 +223,22 @@ void Mapper::setMapperParams(const MapperParams& params) {
       params.esdf_integrator_params.slice_height_above_plane_m);
   esdf_integrator().slice_height_thickness_m(
       params.esdf_integrator_params.slice_height_thickness_m);
+  esdf_integrator().use_persistent_kernel(
+      params.esdf_integrator_params.esdf_integrator_use_persistent_kernel);
   esdf_integrator().max_esdf_distance_m(
       params.esdf_integrator_params.esdf_integrator_max_distance_m);
   esdf_integrator().min_weight(
       params.esdf_integrator_params.esdf_integrator_min_weight);
   esdf_integrator().max_site_distance_vox(
       params.esdf_integrator_params.esdf_integrator_max_site_distance_vox);
+  dense_esdf_slice_integrator().esdf_slice_min_height(
+      params.esdf_integrator_params.esdf_slice_min_height);
+  dense_esdf_slice_integrator().esdf_slice_max_height(
+      params.esdf_integrator_params.esdf_slice_max_height);
+  dense_esdf_slice_integrator().max_esdf_distance_m(
+      params.esdf_integrator_params.esdf_integrator_max_distance_m);
+  dense_esdf_slice_integrator().min_weight(
+      params.esdf_integrator_params.esdf_integrator_min_weight);
 
   // Decay
   exclude_last_view_from_decay(params.exclude_last_view_from_decay);
@@ -115,6 +257,9 @@ void Mapper::setMapperParams(const MapperParams& params) {
   lidar_tsdf_integrator().max_integration_distance_m(
       params.projective_integrator_params
           .lidar_projective_integrator_max_integration_distance_m);
+  lidar_pointcloud_tsdf_integrator().max_integration_distance_m(
+      params.projective_integrator_params
+          .lidar_projective_integrator_max_integration_distance_m);
   lidar_occupancy_integrator().max_integration_distance_m(
       params.projective_integrator_params
           .lidar_projective_integrator_max_integration_distance_m);
@@ -128,6 +273,9 @@ void Mapper::setMapperParams(const MapperParams& params) {
   lidar_tsdf_integrator().truncation_distance_vox(
       params.projective_integrator_params
           .projective_integrator_truncation_distance_vox);
+  lidar_pointcloud_tsdf_integrator().truncation_distance_vox(
+      params.projective_integrator_params
+          .projective_integrator_truncation_distance_vox);
   lidar_occupancy_integrator().truncation_distance_vox(
       params.projective_integrator_params
           .projective_integrator_truncation_distance_vox);
@@ -136,13 +284,38 @@ void Mapper::setMapperParams(const MapperParams& params) {
       params.projective_integrator_params.projective_integrator_weighting_mode);
   color_integrator().weighting_function_type(
       params.projective_integrator_params.projective_integrator_weighting_mode);
+  lidar_pointcloud_tsdf_integrator().weighting_function_type(
+      params.projective_integrator_params.projective_integrator_weighting_mode);
   // max weight
   tsdf_integrator().max_weight(
       params.projective_integrator_params.projective_integrator_max_weight);
   lidar_tsdf_integrator().max_weight(
       params.projective_integrator_params.projective_integrator_max_weight);
+  lidar_pointcloud_tsdf_integrator().max_weight(
+      params.projective_integrator_params.projective_integrator_max_weight);
   color_integrator().max_weight(
       params.projective_integrator_params.projective_integrator_max_weight);
+  // color allocation
+  color_integrator().surface_only_allocation(
+      params.projective_integrator_params
+          .projective_color_integrator_surface_only_allocation);
+  color_integrator().reuse_depth_frame(
+      params.projective_integrator_params
+          .projective_color_integrator_reuse_depth_frame);
+  // lidar projection
+  lidar_tsdf_integrator().lidar_approximate_projection(
+      params.projective_integrator_params
+          .lidar_projective_integrator_approximate_projection);
+  lidar_occupancy_integrator().lidar_approximate_projection(
+      params.projective_integrator_params
+          .lidar_projective_integrator_approximate_projection);
+  // camera frame subsampling
+  tsdf_integrator().integration_subsampling_factor(
+      params.projective_integrator_params
+          .projective_integrator_subsampling_factor);
+  occupancy_integrator().integration_subsampling_factor(
+      params.projective_integrator_params
+          .projective_integrator_subsampling_factor);
   // invalid depth decay
   tsdf_integrator().invalid_depth_decay_factor(
       params.projective_integrator_params
@@ -184,6 +357,8 @@ void Mapper::setMapperParams(const MapperParams& params) {
       Vector3f(params.view_calculator_params.workspace_bounds_max_corner_x_m,
                params.view_calculator_params.workspace_bounds_max_corner_y_m,
                params.view_calculator_params.workspace_bounds_max_height_m));
+  tsdf_integrator().view_calculator().hierarchical_planes_culling(
+      params.view_calculator_params.hierarchical_planes_culling);
   color_integrator().view_calculator().raycast_subsampling_factor(
       params.view_calculator_params.raycast_subsampling_factor);
   color_integrator().view_calculator().workspace_bounds_type(
@@ -196,12 +371,18 @@ void Mapper::setMapperParams(const MapperParams& params) {
       Vector3f(params.view_calculator_params.workspace_bounds_max_corner_x_m,
                params.view_calculator_params.workspace_bounds_max_corner_y_m,
                params.view_calculator_params.workspace_bounds_max_height_m));
+  color_integrator().view_calculator().hierarchical_planes_culling(
+      params.view_calculator_params.hierarchical_planes_culling);
 
   // ======= MESH INTEGRATOR =======
   mesh_integrator().min_weight(
       params.mesh_integrator_params.mesh_integrator_min_weight);
   mesh_integrator().weld_vertices(
       params.mesh_integrator_params.mesh_integrator_weld_vertices);
+  mesh_integrator().fused_meshing(
+      params.mesh_integrator_params.mesh_integrator_fused_meshing);
+  mesh_integrator().num_cpu_threads(
+      params.mesh_integrator_params.mesh_integrator_num_cpu_threads);
 
   // ======= DECAY INTEGRATOR (TSDF/OCCUPANCY)=======
   tsdf_decay_integrator().deallocate_decayed_blocks(
@@ -220,6 +401,19 @@ void Mapper::setMapperParams(const MapperParams& params) {
       params.tsdf_decay_integrator_params.tsdf_set_free_distance_on_decayed);
   tsdf_decay_integrator().free_distance_vox(
       params.tsdf_decay_integrator_params.tsdf_decayed_free_distance_vox);
+  tsdf_decay_integrator().lazy_decay(
+      params.tsdf_decay_integrator_params.tsdf_lazy_decay);
+  tsdf_decay_integrator().lazy_decay_compaction_period(
+      params.tsdf_decay_integrator_params.tsdf_lazy_decay_compaction_period);
+
+  // ======= TSDF BLOCK PRUNER =======
+  tsdf_block_pruner().period(
+      params.tsdf_block_pruner_params.tsdf_block_pruning_period);
+  tsdf_block_pruner().min_weight(
+      params.tsdf_block_pruner_params.tsdf_block_pruning_min_weight);
+  tsdf_block_pruner().prune_outside_truncation_band(
+      params.tsdf_block_pruner_params
+          .tsdf_block_pruning_prune_outside_truncation_band);
 
   // ======= OCCUPANCY DECAY INTEGRATOR =======
   occupancy_decay_integrator().free_region_decay_probability(
@@ -229,6 +423,9 @@ void Mapper::setMapperParams(const MapperParams& params) {
           .occupied_region_decay_probability);
   occupancy_decay_integrator().decay_to_free(
       params.occupancy_decay_integrator_params.occupancy_decay_to_free);
+  occupancy_decay_integrator().skip_inactive_blocks(
+      params.occupancy_decay_integrator_params
+          .occupancy_decay_skip_inactive_blocks);
 
   // ======= FREESPACE INTEGRATOR =======
   freespace_integrator().max_tsdf_distance_for_occupancy_m(
@@ -244,25 +441,168 @@ void Mapper::setMapperParams(const MapperParams& params) {
           .min_consecutive_occupancy_duration_for_reset_ms);
   freespace_integrator().check_neighborhood(
       params.freespace_integrator_params.check_neighborhood);
+  freespace_integrator().skip_settled_blocks(
+      params.freespace_integrator_params.skip_settled_blocks);
+
+  // Preallocate once the workspace bounds are known.
+  preallocate_blocks(params.preallocate_blocks);
+  preallocateBlocks();
+}
+
+void Mapper::reserveBlocks(size_t num_blocks) {
+  timing::Timer timer("mapper/reserve_blocks");
+  const auto reserve = [this, num_blocks](auto* layer_ptr) {
+    if (layer_ptr != nullptr) {
+      layer_ptr->reserve(num_blocks, *cuda_stream_);
+    }
+  };
+  reserve(layers_.getPtr<TsdfLayer>());
+  reserve(layers_.getPtr<OccupancyLayer>());
+  reserve(layers_.getPtr<FreespaceLayer>());
+  reserve(layers_.getPtr<ColorLayer>());
+  reserve(layers_.getPtr<EsdfLayer>());
+  reserve(layers_.getPtr<MeshLayer>());
+}
+
+void Mapper::morton_ordered_blocks(const bool morton_ordered_blocks) {
+  morton_ordered_blocks_ = morton_ordered_blocks;
+  const auto set_order = [morton_ordered_blocks](auto* layer_ptr) {
+    if (layer_ptr != nullptr) {
+      layer_ptr->morton_ordered_block_lists(morton_ordered_blocks);
+    }
+  };
+  set_order(layers_.getPtr<TsdfLayer>());
+  set_order(layers_.getPtr<OccupancyLayer>());
+  set_order(layers_.getPtr<FreespaceLayer>());
+  set_order(layers_.getPtr<ColorLayer>());
+  set_order(layers_.getPtr<EsdfLayer>());
+  set_order(layers_.getPtr<MeshLayer>());
+}
+
+void Mapper::relayoutBlocks() {
+  timing::Timer timer("mapper/relayout_blocks");
+  // Mesh blocks aren't trivially copyable and keep their layout. The ESDF
+  // layer keeps its layout too: it may be written by the ESDF thread (see
+  // updateEsdfFromSnapshot()) while this runs on the integration thread.
+  const auto relayout = [this](auto* layer_ptr) {
+    if (layer_ptr != nullptr) {
+      layer_ptr->relayoutBlocksAsync(*cuda_stream_);
+    }
+  };
+  relayout(layers_.getPtr<TsdfLayer>());
+  relayout(layers_.getPtr<OccupancyLayer>());
+  relayout(layers_.getPtr<FreespaceLayer>());
+  relayout(layers_.getPtr<ColorLayer>());
+}
+
+void Mapper::relayoutBlocksIfDue() {
+  if (!morton_ordered_blocks_) {
+    return;
+  }
+  const int num_allocated_blocks =
+      hasTsdfLayer(projective_layer_type_)
+          ? layers_.get<TsdfLayer>().numAllocatedBlocks()
+          : layers_.get<OccupancyLayer>().numAllocatedBlocks();
+  const int num_allocations =
+      hasTsdfLayer(projective_layer_type_)
+          ? layers_.get<TsdfLayer>().numAllocationsSinceRelayout()
+          : layers_.get<OccupancyLayer>().numAllocationsSinceRelayout();
+  if (num_allocated_blocks > 0 &&
+      num_allocations >
+          block_relayout_allocation_fraction_ * num_allocated_blocks) {
+    relayoutBlocks();
+  }
+}
+
+void Mapper::recordBlockCounts(size_t num_updated_blocks) const {
+  if (!timing::FlightRecorder::isEnabled()) {
+    return;
+  }
+  const int num_allocated_blocks =
+      hasTsdfLayer(projective_layer_type_)
+          ? layers_.get<TsdfLayer>().numAllocatedBlocks()
+          : layers_.get<OccupancyLayer>().numAllocatedBlocks();
+  timing::FlightRecorder::recordCounter("mapper/num_updated_blocks",
+                                        num_updated_blocks);
+  timing::FlightRecorder::recordCounter("mapper/num_allocated_blocks",
+                                        num_allocated_blocks);
+}
+
+void Mapper::preallocateBlocks() {
+  if (!preallocate_blocks_) {
+    return;
+  }
+  // Make space for the whole workspace or for the whole (loaded) map,
+  // whichever is larger.
+  const ViewCalculator& view_calculator = tsdf_integrator_.view_calculator();
+  const std::optional<size_t> num_blocks_in_workspace =
+      getMaxNumBlocksInWorkspace(
+          view_calculator.workspace_bounds_type(),
+          view_calculator.workspace_bounds_min_corner_m(),
+          view_calculator.workspace_bounds_max_corner_m(),
+          voxel_size_m_ * TsdfBlock::kVoxelsPerSide);
+  const int num_projective_blocks =
+      hasTsdfLayer(projective_layer_type_)
+          ? layers_.get<TsdfLayer>().numAllocatedBlocks()
+          : layers_.get<OccupancyLayer>().numAllocatedBlocks();
+  const size_t num_blocks =
+      std::max(num_blocks_in_workspace.value_or(0),
+               static_cast<size_t>(num_projective_blocks +
+                                   numPagedOutBlocks() +
+                                   numUnloadedMapBlocks()));
+  if (num_blocks > 0) {
+    LOG(INFO) << "Preallocating the layers for " << num_blocks << " blocks.";
+    reserveBlocks(num_blocks);
+  }
+}
+
+void Mapper::use_cuda_graphs(const bool use_cuda_graphs) {
+  depth_preprocessor_.use_cuda_graph(use_cuda_graphs);
+  for (DepthStagingLane& lane : depth_staging_lanes_) {
+    lane.depth_preprocessor->use_cuda_graph(use_cuda_graphs);
+  }
+}
+
+bool Mapper::use_vpi_depth_preprocessing() const {
+  return depth_preprocessor_.backend() == DepthPreprocessingBackend::kVpi;
+}
+
+void Mapper::use_vpi_depth_preprocessing(
+    const bool use_vpi_depth_preprocessing) {
+  const DepthPreprocessingBackend backend =
+      use_vpi_depth_preprocessing ? DepthPreprocessingBackend::kVpi
+                                  : DepthPreprocessingBackend::kCuda;
+  depth_preprocessor_.backend(backend);
+  for (DepthStagingLane& lane : depth_staging_lanes_) {
+    lane.depth_preprocessor->backend(backend);
+  }
 }
 
 const DepthImage& Mapper::preprocessDepthImageAsync(
     const DepthImageConstView& depth_image) {
+  return preprocessDepthImageAsync(depth_image,
+                                   preprocessed_depth_image_.get());
+}
+
+const DepthImage& Mapper::preprocessDepthImageAsync(
+    const DepthImageConstView& depth_image,
+    DepthImage* preprocessed_depth_image) {
+  CHECK_NOTNULL(preprocessed_depth_image);
   // NOTE(alexmillane): We return a const reference to an image, to
   // avoid reallocating.
   // Copy in the depth image
-  preprocessed_depth_image_->copyFromAsync(depth_image, *cuda_stream_);
+  preprocessed_depth_image->copyFromAsync(depth_image, *cuda_stream_);
   // Dilate the invalid regions
   if (depth_preprocessing_num_dilations_ > 0) {
     depth_preprocessor_.dilateInvalidRegionsAsync(
-        depth_preprocessing_num_dilations_, preprocessed_depth_image_.get());
+        depth_preprocessing_num_dilations_, preprocessed_depth_image);
   } else {
     LOG(WARNING) << "You requested preprocessing, but requested "
                  << depth_preprocessing_num_dilations_
                  << "invalid region dilations. Currenly dilation is the only "
                     "preprocessing step, so doing nothing.";
   }
-  return *preprocessed_depth_image_;
+  return *preprocessed_depth_image;
 }
 
 void Mapper::integrateDepth(const DepthImage& depth_frame,
@@ -272,8 +612,10 @@ void Mapper::integrateDepth(const DepthImage& depth_frame,
 
 void Mapper::integrateDepth(const MaskedDepthImageConstView& depth_frame,
                             const Transform& T_L_C, const Camera& camera) {
-  CHECK(projective_layer_type_ != ProjectiveLayerType::kNone)
-      << "You are trying to update on an inexistent projective layer.";
+  if (skip_redundant_depth_frames_ &&
+      depth_frame_gate_.isRedundant(depth_frame, T_L_C)) {
+    return;
+  }
   // If requested, we perform preprocessing of the depth image. At the moment
   // this is just (optional) dilation of the invalid regions.
   MaskedDepthImageConstView depth_image_for_integration = depth_frame;
@@ -281,56 +623,380 @@ void Mapper::integrateDepth(const MaskedDepthImageConstView& depth_frame,
     depth_image_for_integration = MaskedDepthImageConstView(
         preprocessDepthImageAsync(depth_frame), depth_frame.mask());
   }
+  integratePreprocessedDepth(depth_image_for_integration, T_L_C, camera);
+}
+
+void Mapper::integrateDepth(const MaskedDepthImageConstView& depth_frame,
+                            const MonoImageConstView& label_image,
+                            const Transform& T_L_C, const Camera& camera) {
+  // Frames carrying labels are never skipped as redundant, the labels may
+  // differ.
+  MaskedDepthImageConstView depth_image_for_integration = depth_frame;
+  if (do_depth_preprocessing_) {
+    depth_image_for_integration = MaskedDepthImageConstView(
+        preprocessDepthImageAsync(depth_frame), depth_frame.mask());
+  }
+  if (label_layer_ == nullptr) {
+    label_layer_ = std::make_unique<LabelLayer>(voxel_size_m_, memory_type_);
+  }
+  integratePreprocessedDepth(depth_image_for_integration, T_L_C, camera,
+                             &label_image);
+}
+
+void Mapper::stageDepthAsync(const MaskedDepthImageConstView& depth_frame,
+                             const Transform& T_L_C, const Camera& camera,
+                             int staging_lane) {
+  CHECK_LT(num_staged_depth_frames_, kMaxNumStagedDepthFrames)
+      << "Call integrateStagedDepth() before staging more depth frames.";
+  CHECK_GE(staging_lane, 0);
+  if (staged_depth_frames_.empty()) {
+    for (int i = 0; i < kMaxNumStagedDepthFrames; i++) {
+      staged_depth_frames_.push_back(std::make_unique<StagedDepthFrame>());
+    }
+  }
+  while (static_cast<int>(depth_staging_lanes_.size()) <= staging_lane) {
+    DepthStagingLane lane;
+    lane.cuda_stream =
+        CudaStream::createCudaStream(CudaStreamType::kNonBlocking);
+    lane.depth_preprocessor =
+        std::make_unique<DepthPreprocessor>(lane.cuda_stream);
+    lane.depth_preprocessor->use_cuda_graph(use_cuda_graphs());
+    lane.depth_preprocessor->backend(depth_preprocessor_.backend());
+    depth_staging_lanes_.push_back(std::move(lane));
+  }
+  const CudaStream& staging_cuda_stream =
+      *depth_staging_lanes_[staging_lane].cuda_stream;
+  DepthPreprocessor& staging_depth_preprocessor =
+      *depth_staging_lanes_[staging_lane].depth_preprocessor;
+  StagedDepthFrame& frame = *staged_depth_frames_[next_staged_depth_frame_idx_];
+
+  // The buffers may still be in use by the integration of an earlier frame.
+  frame.integrated_event.streamWait(staging_cuda_stream);
+
+  // Copy in the frame and (if requested) preprocess it. This is the same as
+  // preprocessDepthImageAsync(), but on the staging stream.
+  frame.depth_image.copyFromAsync(depth_frame, staging_cuda_stream);
+  frame.has_mask = depth_frame.mask().dataConstPtr() != nullptr;
+  if (frame.has_mask) {
+    frame.mask.copyFromAsync(depth_frame.mask(), staging_cuda_stream);
+  }
+  if (do_depth_preprocessing_ && depth_preprocessing_num_dilations_ > 0) {
+    staging_depth_preprocessor.invalid_depth_threshold(
+        depth_preprocessor_.invalid_depth_threshold());
+    staging_depth_preprocessor.invalid_depth_value(
+        depth_preprocessor_.invalid_depth_value());
+    staging_depth_preprocessor.dilateInvalidRegionsAsync(
+        depth_preprocessing_num_dilations_, &frame.depth_image);
+  }
+  frame.T_L_C = T_L_C;
+  frame.camera = camera;
+  frame.staged_event.record(staging_cuda_stream);
+
+  next_staged_depth_frame_idx_ =
+      (next_staged_depth_frame_idx_ + 1) % kMaxNumStagedDepthFrames;
+  ++num_staged_depth_frames_;
+}
+
+void Mapper::integrateStagedDepth() {
+  CHECK_GT(num_staged_depth_frames_, 0) << "No depth frame staged.";
+  const int frame_idx = (next_staged_depth_frame_idx_ -
+                         num_staged_depth_frames_ + kMaxNumStagedDepthFrames) %
+                        kMaxNumStagedDepthFrames;
+  StagedDepthFrame& frame = *staged_depth_frames_[frame_idx];
+
+  // Order the integration after the staging, without blocking the host.
+  frame.staged_event.streamWait(*cuda_stream_);
+  const MaskedDepthImageConstView depth_image_for_integration =
+      frame.has_mask
+          ? MaskedDepthImageConstView(frame.depth_image, frame.mask)
+          : MaskedDepthImageConstView(frame.depth_image);
+  integratePreprocessedDepth(depth_image_for_integration, frame.T_L_C,
+                             frame.camera);
+  frame.integrated_event.record(*cuda_stream_);
+  --num_staged_depth_frames_;
+}
+
+void Mapper::integratePreprocessedDepth(
+    const MaskedDepthImageConstView& depth_image_for_integration,
+    const Transform& T_L_C, const Camera& camera,
+    const MonoImageConstView* label_image) {
+  CHECK(projective_layer_type_ != ProjectiveLayerType::kNone)
+      << "You are trying to update on an inexistent projective layer.";
+  // A new frame: temporaries of the previous one are no longer needed.
+  scratch_arena_.reset(*cuda_stream_);
+  // Optionally only integrate the pixels which changed w.r.t. the
+  // reconstruction. The consumers of the frame other than the integrator
+  // (color, decay exclusion) keep using the full frame. Frames carrying
+  // labels are never gated, the labels may differ.
+  MaskedDepthImageConstView gated_depth_image = depth_image_for_integration;
+  if (gate_unchanged_depth_pixels_ && hasTsdfLayer(projective_layer_type_) &&
+      label_image == nullptr &&
+      depth_change_gate_.gateFrame(
+          depth_image_for_integration, T_L_C, camera, tsdf_layer(),
+          tsdf_integrator_.get_truncation_distance_m(voxel_size_m_))) {
+    const DepthImage& gated_depth = depth_change_gate_.gated_depth();
+    gated_depth_image =
+        depth_image_for_integration.mask().dataConstPtr() != nullptr
+            ? MaskedDepthImageConstView(gated_depth,
+                                        depth_image_for_integration.mask())
+            : MaskedDepthImageConstView(gated_depth);
+  }
+  // One pyramid per frame, shared by the consumers of the frame.
+  if (build_depth_pyramid_) {
+    depth_pyramid_.buildAsync(gated_depth_image, *cuda_stream_);
+  }
+  // Restore any paged out (or not yet loaded) blocks that are about to be
+  // observed.
+  if (numPagedOutBlocks() > 0 || numUnloadedMapBlocks() > 0) {
+    pageInBlocksInView(T_L_C, camera);
+  }
 
   // Call the integrator.
   std::vector<Index3D> updated_blocks;
+  std::optional<std::vector<VoxelBlockMask>> updated_voxel_masks;
   if (hasTsdfLayer(projective_layer_type_)) {
-    tsdf_integrator_.integrateFrame(
-        MaskedDepthImageConstView(depth_image_for_integration), T_L_C, camera,
-        layers_.getPtr<TsdfLayer>(), &updated_blocks);
+    applyPendingTsdfDecay(T_L_C, camera);
+    // Let the integration record the voxels in view for the freespace update.
+    const bool record_in_view = hasFreespaceLayer(projective_layer_type_);
+    tsdf_integrator_.in_view_occlusion_distance_m(
+        record_in_view ? std::optional<float>(freespaceOcclusionDistanceM())
+                       : std::nullopt);
+    updated_voxel_masks.emplace();
+    if (label_image != nullptr) {
+      tsdf_integrator_.integrateFrame(
+          depth_image_for_integration, *label_image, T_L_C, camera,
+          layers_.getPtr<TsdfLayer>(), label_layer_.get(), &updated_blocks,
+          &updated_voxel_masks.value());
+    } else {
+      tsdf_integrator_.integrateFrame(
+          gated_depth_image, T_L_C, camera, layers_.getPtr<TsdfLayer>(),
+          &updated_blocks, &updated_voxel_masks.value());
+    }
+    if (record_in_view) {
+      last_in_view_frame_ =
+          InViewFrame{gated_depth_image.dataConstPtr(), T_L_C, camera,
+                      updated_blocks};
+    }
+    if (color_integrator_.reuse_depth_frame()) {
+      storeColorDepthFrame(depth_image_for_integration, T_L_C, camera,
+                           updated_blocks);
+    }
 
     layers_.getPtr<TsdfLayer>()->updateGpuHash(*cuda_stream_);
   } else if (projective_layer_type_ == ProjectiveLayerType::kOccupancy) {
-    occupancy_integrator_.integrateFrame(
-        depth_image_for_integration, T_L_C, camera,
-        layers_.getPtr<OccupancyLayer>(), &updated_blocks);
+    if (label_image != nullptr) {
+      occupancy_integrator_.integrateFrame(
+          depth_image_for_integration, *label_image, T_L_C, camera,
+          layers_.getPtr<OccupancyLayer>(), label_layer_.get(),
+          &updated_blocks);
+    } else {
+      occupancy_integrator_.integrateFrame(
+          depth_image_for_integration, T_L_C, camera,
+          layers_.getPtr<OccupancyLayer>(), &updated_blocks);
+    }
 
     layers_.getPtr<OccupancyLayer>()->updateGpuHash(*cuda_stream_);
   }
 
   // Save the viewpoint for use in viewpoint exclusion.
   if (exclude_last_view_from_decay_) {
-    if (!last_depth_image_.has_value()) {
-      LOG(INFO) << "Allocating space for last depth image";
-      last_depth_image_ =
-          DepthImage(depth_image_for_integration.rows(),
-                     depth_image_for_integration.cols(), MemoryType::kDevice);
-    } else {
-      last_depth_image_.value().resizeAsync(depth_image_for_integration.rows(),
-                                            depth_image_for_integration.cols(),
-                                            *cuda_stream_);
+    storeLastDepthView(depth_image_for_integration, T_L_C, camera);
+  }
+
+  addIntegratedBlocksToUpdate(updated_blocks, updated_voxel_masks);
+  pruneTsdfBlocksIfDue();
+  relayoutBlocksIfDue();
+  recordBlockCounts(updated_blocks.size());
+}
+
+void Mapper::integrateDepth(
+    const std::vector<MaskedDepthImageConstView>& depth_frames,
+    const std::vector<Transform>& T_L_C_vec,
+    const std::vector<Camera>& cameras) {
+  CHECK(projective_layer_type_ != ProjectiveLayerType::kNone)
+      << "You are trying to update on an inexistent projective layer.";
+  CHECK_EQ(depth_frames.size(), T_L_C_vec.size());
+  CHECK_EQ(depth_frames.size(), cameras.size());
+  if (depth_frames.empty()) {
+    return;
+  }
+  scratch_arena_.reset(*cuda_stream_);
+
+  // Preprocess each frame into its own buffer, such that all frames are
+  // alive during the batched integration.
+  std::vector<MaskedDepthImageConstView> depth_images_for_integration =
+      depth_frames;
+  if (do_depth_preprocessing_) {
+    while (batch_preprocessed_depth_images_.size() < depth_frames.size()) {
+      batch_preprocessed_depth_images_.push_back(
+          std::make_unique<DepthImage>(MemoryType::kDevice));
     }
+    for (size_t i = 0; i < depth_frames.size(); i++) {
+      depth_images_for_integration[i] = MaskedDepthImageConstView(
+          preprocessDepthImageAsync(depth_frames[i],
+                                    batch_preprocessed_depth_images_[i].get()),
+          depth_frames[i].mask());
+    }
+  }
 
-    // NOTE(alexmillane): We could get rid this copy by using a double buffer.
-    last_depth_image_.value().copyFromAsync(depth_image_for_integration,
-                                            *cuda_stream_);
-    last_depth_camera_ = camera;
-    last_depth_T_L_C_ = T_L_C;
+  // Restore any paged out (or not yet loaded) blocks that are about to be
+  // observed.
+  for (size_t i = 0; i < depth_frames.size() &&
+                     (numPagedOutBlocks() > 0 || numUnloadedMapBlocks() > 0);
+       i++) {
+    pageInBlocksInView(T_L_C_vec[i], cameras[i]);
   }
 
-  blocks_to_update_tracker_.addBlocksToUpdate(updated_blocks);
+  // Call the integrator.
+  std::vector<Index3D> updated_blocks;
+  std::optional<std::vector<VoxelBlockMask>> updated_voxel_masks;
+  if (hasTsdfLayer(projective_layer_type_)) {
+    for (size_t i = 0; i < depth_frames.size(); i++) {
+      applyPendingTsdfDecay(T_L_C_vec[i], cameras[i]);
+    }
+    last_in_view_frame_.reset();
+    last_color_depth_frame_.reset();
+    updated_voxel_masks.emplace();
+    tsdf_integrator_.integrateFrames(
+        depth_images_for_integration, T_L_C_vec, cameras,
+        layers_.getPtr<TsdfLayer>(), &updated_blocks,
+        &updated_voxel_masks.value());
+
+    layers_.getPtr<TsdfLayer>()->updateGpuHash(*cuda_stream_);
+  } else if (projective_layer_type_ == ProjectiveLayerType::kOccupancy) {
+    occupancy_integrator_.integrateFrames(
+        depth_images_for_integration, T_L_C_vec, cameras,
+        layers_.getPtr<OccupancyLayer>(), &updated_blocks);
+
+    layers_.getPtr<OccupancyLayer>()->updateGpuHash(*cuda_stream_);
+  }
+
+  // Only the last view of the batch is excluded from decay. This matches
+  // the behaviour of integrating the frames one by one.
+  if (exclude_last_view_from_decay_) {
+    storeLastDepthView(depth_images_for_integration.back(), T_L_C_vec.back(),
+                       cameras.back());
+  }
+
+  addIntegratedBlocksToUpdate(updated_blocks, updated_voxel_masks);
+  pruneTsdfBlocksIfDue();
+  relayoutBlocksIfDue();
+  recordBlockCounts(updated_blocks.size());
+}
+
+void Mapper::applyPendingTsdfDecay(const Transform& T_L_C,
+                                   const Camera& camera) {
+  if (!tsdf_decay_integrator_.lazy_decay()) {
+    return;
+  }
+  const std::vector<Index3D> blocks_in_view =
+      tsdf_integrator_.view_calculator().getBlocksInViewPlanes(
+          T_L_C, camera, layers_.get<TsdfLayer>().block_size(),
+          tsdf_integrator_.max_integration_distance_m() +
+              tsdf_integrator_.get_truncation_distance_m(voxel_size_m_));
+  tsdf_decay_integrator_.applyPendingDecay(layers_.getPtr<TsdfLayer>(),
+                                           blocks_in_view, *cuda_stream_);
+}
+
+void Mapper::applyPendingTsdfDecay(const AxisAlignedBoundingBox& aabb) {
+  if (!tsdf_decay_integrator_.lazy_decay()) {
+    return;
+  }
+  tsdf_decay_integrator_.applyPendingDecay(
+      layers_.getPtr<TsdfLayer>(),
+      getAllocatedBlocksWithinAABB(layers_.get<TsdfLayer>(), aabb),
+      *cuda_stream_);
+}
+
+void Mapper::storeLastDepthView(const DepthImageConstView& depth_image,
+                                const Transform& T_L_C, const Camera& camera) {
+  if (!last_depth_image_.has_value()) {
+    LOG(INFO) << "Allocating space for last depth image";
+    last_depth_image_ =
+        DepthImage(depth_image.rows(), depth_image.cols(), MemoryType::kDevice);
+  } else {
+    last_depth_image_.value().resizeAsync(depth_image.rows(),
+                                          depth_image.cols(), *cuda_stream_);
+  }
+
+  // NOTE(alexmillane): We could get rid this copy by using a double buffer.
+  last_depth_image_.value().copyFromAsync(depth_image, *cuda_stream_);
+  last_depth_camera_ = camera;
+  last_depth_T_L_C_ = T_L_C;
+}
+
+void Mapper::storeColorDepthFrame(const DepthImageConstView& depth_image,
+                                  const Transform& T_L_C, const Camera& camera,
+                                  const std::vector<Index3D>& block_indices) {
+  if (!last_color_depth_frame_.has_value()) {
+    last_color_depth_frame_.emplace();
+  }
+  ColorDepthFrame& frame = last_color_depth_frame_.value();
+  frame.depth_image.resizeAsync(depth_image.rows(), depth_image.cols(),
+                                *cuda_stream_);
+  frame.depth_image.copyFromAsync(depth_image, *cuda_stream_);
+  frame.T_L_C = T_L_C;
+  frame.camera = camera;
+  frame.block_indices = block_indices;
+}
+
+bool Mapper::canReuseDepthFrameForColor(const ColorImage& color_frame,
+                                        const Transform& T_L_C,
+                                        const Camera& camera) const {
+  if (!color_integrator_.reuse_depth_frame() ||
+      !last_color_depth_frame_.has_value()) {
+    return false;
+  }
+  // The color integration looks up the depth at the color pixel divided by an
+  // integer factor. So the depth camera has to be the color camera, scaled by
+  // that factor.
+  constexpr float kPoseTolerance = 1e-4f;
+  constexpr float kIntrinsicsTolerancePx = 1e-2f;
+  const ColorDepthFrame& frame = last_color_depth_frame_.value();
+  const int depth_rows = frame.depth_image.rows();
+  const int depth_cols = frame.depth_image.cols();
+  if (depth_rows <= 0 || color_frame.rows() % depth_rows != 0) {
+    return false;
+  }
+  const int factor = color_frame.rows() / depth_rows;
+  if (depth_cols * factor != color_frame.cols()) {
+    return false;
+  }
+  const float scale = static_cast<float>(factor);
+  return T_L_C.isApprox(frame.T_L_C, kPoseTolerance) &&
+         frame.camera.hasSameDistortion(camera) &&
+         std::abs(frame.camera.fu() * scale - camera.fu()) <
+             kIntrinsicsTolerancePx &&
+         std::abs(frame.camera.fv() * scale - camera.fv()) <
+             kIntrinsicsTolerancePx &&
+         std::abs(frame.camera.cu() * scale - camera.cu()) <
+             kIntrinsicsTolerancePx &&
+         std::abs(frame.camera.cv() * scale - camera.cv()) <
+             kIntrinsicsTolerancePx;
 }
 
 void Mapper::integrateLidarDepth(const DepthImage& depth_frame,
                                  const Transform& T_L_C, const Lidar& lidar) {
   CHECK(projective_layer_type_ != ProjectiveLayerType::kNone)
       << "You are trying to update on an inexistent projective layer.";
+  scratch_arena_.reset(*cuda_stream_);
   // Call the integrator.
   std::vector<Index3D> updated_blocks;
+  std::optional<std::vector<VoxelBlockMask>> updated_voxel_masks;
   if (hasTsdfLayer(projective_layer_type_)) {
-    lidar_tsdf_integrator_.integrateFrame(depth_frame, T_L_C, lidar,
-                                          layers_.getPtr<TsdfLayer>(),
-                                          &updated_blocks);
+    applyPendingTsdfDecay(lidar.getViewAABB(
+        T_L_C, 0.0f,
+        lidar_tsdf_integrator_.max_integration_distance_m() +
+            lidar_tsdf_integrator_.get_truncation_distance_m(voxel_size_m_)));
+    last_in_view_frame_.reset();
+    updated_voxel_masks.emplace();
+    lidar_tsdf_integrator_.integrateFrame(
+        depth_frame, T_L_C, lidar, layers_.getPtr<TsdfLayer>(),
+        &updated_blocks, &updated_voxel_masks.value());
+    if (tsdf_decay_integrator_.lazy_decay()) {
+      // Newly allocated blocks were not caught up above.
+      tsdf_decay_integrator_.markBlocksAsDecayed(updated_blocks);
+    }
 
     layers_.getPtr<TsdfLayer>()->updateGpuHash(*cuda_stream_);
   } else if (projective_layer_type_ == ProjectiveLayerType::kOccupancy) {
@@ -341,22 +1007,144 @@ void Mapper::integrateLidarDepth(const DepthImage& depth_frame,
     layers_.getPtr<OccupancyLayer>()->updateGpuHash(*cuda_stream_);
   }
 
-  blocks_to_update_tracker_.addBlocksToUpdate(updated_blocks);
+  addIntegratedBlocksToUpdate(updated_blocks, updated_voxel_masks);
+}
+
+void Mapper::integrateLidarDepth(
+    const std::vector<MaskedDepthImageConstView>& depth_frames,
+    const std::vector<Transform>& T_L_C_vec,
+    const std::vector<Lidar>& lidars) {
+  CHECK(projective_layer_type_ != ProjectiveLayerType::kNone)
+      << "You are trying to update on an inexistent projective layer.";
+  CHECK_EQ(depth_frames.size(), T_L_C_vec.size());
+  CHECK_EQ(depth_frames.size(), lidars.size());
+  if (depth_frames.empty()) {
+    return;
+  }
+  scratch_arena_.reset(*cuda_stream_);
+  // Call the integrator.
+  std::vector<Index3D> updated_blocks;
+  std::optional<std::vector<VoxelBlockMask>> updated_voxel_masks;
+  if (hasTsdfLayer(projective_layer_type_)) {
+    for (size_t i = 0; i < depth_frames.size(); i++) {
+      applyPendingTsdfDecay(lidars[i].getViewAABB(
+          T_L_C_vec[i], 0.0f,
+          lidar_tsdf_integrator_.max_integration_distance_m() +
+              lidar_tsdf_integrator_.get_truncation_distance_m(
+                  voxel_size_m_)));
+    }
+    last_in_view_frame_.reset();
+    updated_voxel_masks.emplace();
+    lidar_tsdf_integrator_.integrateFrames(
+        depth_frames, T_L_C_vec, lidars, layers_.getPtr<TsdfLayer>(),
+        &updated_blocks, &updated_voxel_masks.value());
+    if (tsdf_decay_integrator_.lazy_decay()) {
+      // Newly allocated blocks were not caught up above.
+      tsdf_decay_integrator_.markBlocksAsDecayed(updated_blocks);
+    }
+
+    layers_.getPtr<TsdfLayer>()->updateGpuHash(*cuda_stream_);
+  } else if (projective_layer_type_ == ProjectiveLayerType::kOccupancy) {
+    lidar_occupancy_integrator_.integrateFrames(
+        depth_frames, T_L_C_vec, lidars, layers_.getPtr<OccupancyLayer>(),
+        &updated_blocks);
+
+    layers_.getPtr<OccupancyLayer>()->updateGpuHash(*cuda_stream_);
+  }
+
+  addIntegratedBlocksToUpdate(updated_blocks, updated_voxel_masks);
+}
+
+void Mapper::integrateLidarPointcloud(const Pointcloud& pointcloud_S,
+                                      const Transform& T_L_S) {
+  CHECK(hasTsdfLayer(projective_layer_type_))
+      << "Pointcloud integration is only supported for TSDF layers.";
+  // Call the integrator.
+  std::vector<Index3D> updated_blocks;
+  std::optional<std::vector<VoxelBlockMask>> updated_voxel_masks;
+  // The pointcloud carries no sensor model, so we catch up the cube around
+  // the sensor which contains all rays.
+  const float max_ray_length_m =
+      lidar_pointcloud_tsdf_integrator_.max_integration_distance_m() +
+      lidar_pointcloud_tsdf_integrator_.get_truncation_distance_m(
+          voxel_size_m_);
+  applyPendingTsdfDecay(AxisAlignedBoundingBox(
+      T_L_S.translation() - Vector3f::Constant(max_ray_length_m),
+      T_L_S.translation() + Vector3f::Constant(max_ray_length_m)));
+  last_in_view_frame_.reset();
+  updated_voxel_masks.emplace();
+  lidar_pointcloud_tsdf_integrator_.integrateFrame(
+      pointcloud_S, T_L_S, layers_.getPtr<TsdfLayer>(), &updated_blocks,
+      &updated_voxel_masks.value());
+  if (tsdf_decay_integrator_.lazy_decay()) {
+    // Newly allocated blocks were not caught up above.
+    tsdf_decay_integrator_.markBlocksAsDecayed(updated_blocks);
+  }
+
+  layers_.getPtr<TsdfLayer>()->updateGpuHash(*cuda_stream_);
+
+  addIntegratedBlocksToUpdate(updated_blocks, updated_voxel_masks);
+}
+
+void Mapper::addIntegratedBlocksToUpdate(
+    const std::vector<Index3D>& updated_blocks,
+    const std::optional<std::vector<VoxelBlockMask>>& updated_voxel_masks) {
+  if (projective_layer_type_ == ProjectiveLayerType::kOccupancy) {
+    occupancy_decay_integrator_.markBlocksAsActive(updated_blocks);
+  }
+  if (updated_voxel_masks.has_value()) {
+    blocks_to_update_tracker_.addBlocksToUpdate(updated_blocks,
+                                                updated_voxel_masks.value());
+  } else {
+    blocks_to_update_tracker_.addBlocksToUpdate(updated_blocks);
+  }
 }
 
 void Mapper::integrateColor(const ColorImage& color_frame,
                             const Transform& T_L_C, const Camera& camera) {
   // Color is only integrated for Tsdf layers (not for occupancy)
   if (hasTsdfLayer(projective_layer_type_)) {
-    color_integrator_.integrateFrame(color_frame, T_L_C, camera,
-                                     layers_.get<TsdfLayer>(),
-                                     layers_.getPtr<ColorLayer>());
+    scratch_arena_.reset(*cuda_stream_);
+    std::vector<Index3D> updated_blocks;
+    if (canReuseDepthFrameForColor(color_frame, T_L_C, camera)) {
+      // Occlusions are resolved with the integrated depth frame, rather than
+      // a depth image sphere traced from the TSDF.
+      const ColorDepthFrame& frame = last_color_depth_frame_.value();
+      color_integrator_.integrateFrame(
+          color_frame, frame.depth_image, T_L_C, camera,
+          layers_.get<TsdfLayer>(), frame.block_indices,
+          layers_.getPtr<ColorLayer>(), &updated_blocks);
+    } else {
+      color_integrator_.integrateFrame(
+          color_frame, T_L_C, camera, layers_.get<TsdfLayer>(),
+          layers_.getPtr<ColorLayer>(), &updated_blocks);
+    }
 
     layers_.getPtr<ColorLayer>()->updateGpuHash(*cuda_stream_);
+    // The mesh of these blocks has to be recolored.
+    blocks_to_update_tracker_.addColorBlocksToUpdate(updated_blocks);
   }
 }
 
 void Mapper::decayTsdf() {
+  // In lazy mode we only record the decay step. The accumulated decay is
+  // applied to blocks when they're next integrated and to all blocks at
+  // compaction, which is also where fully decayed blocks are deallocated.
+  if (tsdf_decay_integrator_.lazy_decay()) {
+    tsdf_decay_integrator_.addPendingDecayStep();
+    if (!tsdf_decay_integrator_.isCompactionDue()) {
+      return;
+    }
+    blocks_to_update_tracker_.addBlocksToUpdate(
+        layers_.get<TsdfLayer>().getAllBlockIndices());
+    const std::vector<Index3D> deallocated_blocks =
+        tsdf_decay_integrator_.applyAllPendingDecay(
+            layers_.getPtr<TsdfLayer>(), *cuda_stream_);
+    clearBlocksInLayers(deallocated_blocks);
+    layers_.getPtr<TsdfLayer>()->updateGpuHash(*cuda_stream_);
+    return;
+  }
+
   // TODO(remos): In the future we could exclude the blocks not decayed, from
   // the blocks requiring an update.
   const std::vector<Index3D> all_blocks =
@@ -388,6 +1176,38 @@ void Mapper::decayTsdf() {
   layers_.getPtr<TsdfLayer>()->updateGpuHash(*cuda_stream_);
 }
 
+std::vector<Index3D> Mapper::pruneTsdfBlocks() {
+  CHECK(hasTsdfLayer(projective_layer_type_))
+      << "Pruning is only supported for TSDF layers.";
+  timing::Timer timer("mapper/prune_tsdf_blocks");
+  const std::vector<Index3D> pruned_blocks =
+      tsdf_block_pruner_.getBlocksToPrune(
+          layers_.get<TsdfLayer>(),
+          tsdf_integrator_.get_truncation_distance_m(voxel_size_m_));
+  if (pruned_blocks.empty()) {
+    return pruned_blocks;
+  }
+  // The pruned blocks are returned to the memory pool, and removed from the
+  // GPU hash, in one batch.
+  layers_.getPtr<TsdfLayer>()->clearBlocksAsync(pruned_blocks, *cuda_stream_);
+  clearBlocksInIntegrationLayers(pruned_blocks);
+  // The ESDF layer may be in use by the ESDF thread (see
+  // updateEsdfFromSnapshot()), so the ESDF update removes its blocks.
+  queueEsdfBlockRemovals(pruned_blocks);
+  layers_.getPtr<TsdfLayer>()->updateGpuHash(*cuda_stream_);
+  return pruned_blocks;
+}
+
+void Mapper::pruneTsdfBlocksIfDue() {
+  if (!hasTsdfLayer(projective_layer_type_)) {
+    return;
+  }
+  tsdf_block_pruner_.registerIntegration();
+  if (tsdf_block_pruner_.isPruningDue()) {
+    pruneTsdfBlocks();
+  }
+}
+
 void Mapper::decayOccupancy() {
   // TODO(remos): In the future we could exclude the blocks not decayed, from
   // the blocks requiring an update.
@@ -434,26 +1254,41 @@ void Mapper::updateFreespace(Time update_time_ms, const Transform& T_L_C,
                              const Camera& camera,
                              const DepthImage& depth_frame,
                              UpdateFullLayer update_full_layer) {
+  // If this is the view we just integrated, the TSDF integration already
+  // computed which voxels are in view and we don't re-project them.
+  std::optional<InViewVoxelMasks> in_view_voxel_masks;
+  if (last_in_view_frame_.has_value() &&
+      last_in_view_frame_->depth_image_ptr == depth_frame.dataConstPtr() &&
+      last_in_view_frame_->T_L_C.matrix() == T_L_C.matrix() &&
+      isSameCamera(last_in_view_frame_->camera, camera)) {
+    in_view_voxel_masks =
+        InViewVoxelMasks{&last_in_view_frame_->block_indices,
+                         &tsdf_integrator_.in_view_voxel_masks()};
+  }
+
+  updateFreespace(update_time_ms,
+                  ViewBasedInclusionData(
+                      T_L_C, camera, &depth_frame,
+                      tsdf_integrator_.max_integration_distance_m(),
+                      freespaceOcclusionDistanceM()),
+                  update_full_layer, in_view_voxel_masks);
+}
+
+float Mapper::freespaceOcclusionDistanceM() const {
   // The freespace integrator only updates voxel that are in view and within the
   // negative truncation distance. Due to noisy depth measurements, a voxel
   // might occasionaly end up on the "wrong" side of the truncation distance
   // and would thus not be updated. To mitigate the effect of this on/off
   // switching, we inflate the truncation distance.
   constexpr float kTruncationDistanceMultipler = 2.F;
-
-  updateFreespace(
-      update_time_ms,
-      ViewBasedInclusionData(
-          T_L_C, camera, &depth_frame,
-          tsdf_integrator_.max_integration_distance_m(),
-          kTruncationDistanceMultipler *
-              tsdf_integrator_.get_truncation_distance_m(voxel_size_m_)),
-      update_full_layer);
+  return kTruncationDistanceMultipler *
+         tsdf_integrator_.get_truncation_distance_m(voxel_size_m_);
 }
 
 void Mapper::updateFreespace(
     Time update_time_ms, std::optional<ViewBasedInclusionData> view_to_update,
-    UpdateFullLayer update_full_layer) {
+    UpdateFullLayer update_full_layer,
+    const std::optional<InViewVoxelMasks>& in_view_voxel_masks) {
   CHECK(hasFreespaceLayer(projective_layer_type_))
       << "Trying to update the freespace layer while it is not enabled.";
 
@@ -464,7 +1299,7 @@ void Mapper::updateFreespace(
   // Call the integrator.
   freespace_integrator_.updateFreespaceLayer(
       blocks_to_update, update_time_ms, layers_.get<TsdfLayer>(),
-      view_to_update, layers_.getPtr<FreespaceLayer>());
+      view_to_update, layers_.getPtr<FreespaceLayer>(), in_view_voxel_masks);
 
   // Mark blocks as updated
   blocks_to_update_tracker_.markBlocksAsUpdated(BlocksToUpdateType::kFreespace);
@@ -480,15 +1315,53 @@ void Mapper::updateMesh(UpdateFullLayer update_full_layer) {
     std::vector<Index3D> blocks_to_update =
         getBlocksToUpdate(BlocksToUpdateType::kMesh, update_full_layer);
 
-    // Call the integrator.
-    mesh_integrator_.integrateBlocksGPU(layers_.get<TsdfLayer>(),
-                                        blocks_to_update,
-                                        layers_.getPtr<MeshLayer>());
+    // Only blocks containing changed voxels need their geometry re-extracted.
+    std::vector<Index3D> blocks_to_remesh =
+        (update_full_layer == UpdateFullLayer::kYes)
+            ? blocks_to_update
+            : blocks_to_update_tracker_.getMeshBlocksToRemesh();
+
+    // The mesh stream reads the TSDF and color written on the mapper stream.
+    const bool separate_mesh_stream =
+        mesh_integrator_.cuda_stream() != cuda_stream_;
+    if (separate_mesh_stream) {
+      mesh_input_event_.record(*cuda_stream_);
+      mesh_input_event_.streamWait(*mesh_integrator_.cuda_stream());
+    }
+
+    // Call the integrator. The re-meshed blocks are colored while meshing.
+    mesh_integrator_.integrateBlocksGPU(
+        layers_.get<TsdfLayer>(), blocks_to_remesh,
+        layers_.getPtr<MeshLayer>(), &layers_.get<ColorLayer>());
+
+    // Blocks keeping their geometry only need recoloring if their colors
+    // changed.
+    if (update_full_layer == UpdateFullLayer::kNo) {
+      const Index3DSet remeshed_blocks(blocks_to_remesh.begin(),
+                                       blocks_to_remesh.end());
+      const std::vector<Index3D> blocks_with_new_colors =
+          blocks_to_update_tracker_.getBlocksToUpdate(
+              BlocksToUpdateType::kMeshColor);
+      std::vector<Index3D> blocks_to_recolor;
+      for (const Index3D& block_idx : blocks_with_new_colors) {
+        if (remeshed_blocks.count(block_idx) == 0) {
+          blocks_to_recolor.push_back(block_idx);
+        }
+      }
+      mesh_integrator_.colorMesh(layers_.get<ColorLayer>(), blocks_to_recolor,
+                                 layers_.getPtr<MeshLayer>());
+    }
 
-    mesh_integrator_.colorMesh(layers_.get<ColorLayer>(), blocks_to_update,
-                               layers_.getPtr<MeshLayer>());
+    // Later writes to the inputs (and reads of the mesh) on the mapper stream
+    // wait for the meshing.
+    if (separate_mesh_stream) {
+      mesh_output_event_.record(*mesh_integrator_.cuda_stream());
+      mesh_output_event_.streamWait(*cuda_stream_);
+    }
 
     blocks_to_update_tracker_.markBlocksAsUpdated(BlocksToUpdateType::kMesh);
+    blocks_to_update_tracker_.markBlocksAsUpdated(
+        BlocksToUpdateType::kMeshColor);
   }
 }
 
@@ -497,50 +1370,171 @@ void Mapper::updateEsdf(UpdateFullLayer update_full_layer) {
                                         "the ESDF to 2d *or* 3d. Not both.";
   esdf_mode_ = EsdfMode::k3D;
 
+  clearEsdfBlocks(takeQueuedEsdfBlockRemovals(), *cuda_stream_);
+
   // Get the esdf blocks that need an update
   std::vector<Index3D> blocks_to_update =
       getBlocksToUpdate(BlocksToUpdateType::kEsdf, update_full_layer);
 
-  if (projective_layer_type_ == ProjectiveLayerType::kTsdfWithFreespace) {
-    // Passing a freespace layer to the integrator for checking if
-    // candidate esdf sites fall into freespace
-    esdf_integrator_.integrateBlocks(
-        layers_.get<TsdfLayer>(), layers_.get<FreespaceLayer>(),
-        blocks_to_update, layers_.getPtr<EsdfLayer>());
-  } else if (projective_layer_type_ == ProjectiveLayerType::kTsdf) {
-    esdf_integrator_.integrateBlocks(layers_.get<TsdfLayer>(), blocks_to_update,
-                                     layers_.getPtr<EsdfLayer>());
-  } else if (projective_layer_type_ == ProjectiveLayerType::kOccupancy) {
-    esdf_integrator_.integrateBlocks(layers_.get<OccupancyLayer>(),
-                                     blocks_to_update,
-                                     layers_.getPtr<EsdfLayer>());
-  }
+  integrateEsdfBlocks(blocks_to_update);
 
   // Mark blocks as updated
   blocks_to_update_tracker_.markBlocksAsUpdated(BlocksToUpdateType::kEsdf);
 }
 
-void Mapper::updateEsdfSlice(UpdateFullLayer update_full_layer,
-                             std::optional<Plane> ground_plane) {
-  CHECK(esdf_mode_ != EsdfMode::k3D) << "Currently, we limit computation of "
+void Mapper::updateEsdfInWindow(const Vector3f& window_center) {
+  CHECK(esdf_mode_ != EsdfMode::k2D) << "Currently, we limit computation of "
                                         "the ESDF to 2d *or* 3d. Not both.";
-  esdf_mode_ = EsdfMode::k2D;
+  esdf_mode_ = EsdfMode::k3D;
 
-  // Get the esdf blocks that need an update
-  std::vector<Index3D> blocks_to_update =
-      getBlocksToUpdate(BlocksToUpdateType::kEsdf, update_full_layer);
+  const Vector3f half_extent = Vector3f::Constant(esdf_window_half_extent_m_);
+  const AxisAlignedBoundingBox window(window_center - half_extent,
+                                      window_center + half_extent);
+  const float block_size = layers_.get<EsdfLayer>().block_size();
+
+  // Blocks that need an update and lie within the window.
+  Index3DSet blocks_to_update_set;
+  for (const Index3D& block_index :
+       getBlocksToUpdate(BlocksToUpdateType::kEsdf, UpdateFullLayer::kNo)) {
+    if (isBlockTouchedByBoundingBox(block_index, block_size, window)) {
+      blocks_to_update_set.insert(block_index);
+    }
+  }
 
-  if (ground_plane) {
-    if (projective_layer_type_ == ProjectiveLayerType::kTsdfWithFreespace) {
-      // Passing a freespace layer to the integrator for checking if
-      // candidate esdf sites fall into freespace
-      esdf_integrator_.integrateSlice(
-          layers_.get<TsdfLayer>(), layers_.get<FreespaceLayer>(),
-          blocks_to_update, ground_plane.value(), layers_.getPtr<EsdfLayer>());
-    } else if (projective_layer_type_ == ProjectiveLayerType::kTsdf) {
-      esdf_integrator_.integrateSlice(layers_.get<TsdfLayer>(),
-                                      blocks_to_update, ground_plane.value(),
-                                      layers_.getPtr<EsdfLayer>());
+  // Blocks that entered the window since the last call have no valid ESDF, so
+  // they are recomputed whether or not they changed.
+  const std::vector<Index3D> blocks_in_window =
+      hasTsdfLayer(projective_layer_type_)
+          ? getAllocatedBlocksWithinAABB(layers_.get<TsdfLayer>(), window)
+          : getAllocatedBlocksWithinAABB(layers_.get<OccupancyLayer>(),
+                                         window);
+  for (const Index3D& block_index : blocks_in_window) {
+    if (!last_esdf_window_ ||
+        !isBlockTouchedByBoundingBox(block_index, block_size,
+                                     last_esdf_window_.value())) {
+      blocks_to_update_set.insert(block_index);
+    }
+  }
+
+  // Blocks that left the window, or were pruned, are removed from the ESDF.
+  std::vector<Index3D> blocks_to_clear = takeQueuedEsdfBlockRemovals();
+  for (const Index3D& block_index :
+       layers_.get<EsdfLayer>().getAllBlockIndicesCached()) {
+    if (!isBlockTouchedByBoundingBox(block_index, block_size, window)) {
+      blocks_to_clear.push_back(block_index);
+    }
+  }
+  layers_.getPtr<EsdfLayer>()->clearBlocksAsync(blocks_to_clear,
+                                                *cuda_stream_);
+
+  integrateEsdfBlocks(std::vector<Index3D>(blocks_to_update_set.begin(),
+                                           blocks_to_update_set.end()));
+
+  // Blocks outside the window which required an update are recomputed once
+  // they enter the window, so we can mark all of them as updated.
+  blocks_to_update_tracker_.markBlocksAsUpdated(BlocksToUpdateType::kEsdf);
+  last_esdf_window_ = window;
+}
+
+void Mapper::snapshotEsdfInput(UpdateFullLayer update_full_layer) {
+  CHECK(esdf_mode_ != EsdfMode::k2D) << "Currently, we limit computation of "
+                                        "the ESDF to 2d *or* 3d. Not both.";
+  esdf_mode_ = EsdfMode::k3D;
+
+  const std::vector<Index3D> blocks_to_update =
+      getBlocksToUpdate(BlocksToUpdateType::kEsdf, update_full_layer);
+  if (blocks_to_update.empty()) {
+    return;
+  }
+
+  timing::Timer timer("mapper/snapshot_esdf_input");
+  std::lock_guard<std::mutex> lock(esdf_snapshot_mutex_);
+  if (!pending_esdf_snapshot_) {
+    pending_esdf_snapshot_ = std::make_unique<EsdfInputSnapshot>();
+    pending_esdf_snapshot_->layers =
+        LayerCake::create<TsdfLayer, FreespaceLayer, OccupancyLayer>(
+            voxel_size_m_, memory_type_);
+  }
+  LayerCake& snapshot_layers = pending_esdf_snapshot_->layers;
+  if (hasTsdfLayer(projective_layer_type_)) {
+    copyBlocksAsync(layers_.get<TsdfLayer>(), blocks_to_update,
+                    snapshot_layers.getPtr<TsdfLayer>(), *cuda_stream_);
+  } else {
+    copyBlocksAsync(layers_.get<OccupancyLayer>(), blocks_to_update,
+                    snapshot_layers.getPtr<OccupancyLayer>(), *cuda_stream_);
+  }
+  if (hasFreespaceLayer(projective_layer_type_)) {
+    copyBlocksAsync(layers_.get<FreespaceLayer>(), blocks_to_update,
+                    snapshot_layers.getPtr<FreespaceLayer>(), *cuda_stream_);
+  }
+  pending_esdf_snapshot_->block_indices.insert(blocks_to_update.begin(),
+                                               blocks_to_update.end());
+  // Blocks which were reallocated since they were pruned stay in the ESDF.
+  for (const Index3D& block_index : blocks_to_update) {
+    queued_esdf_block_removals_.erase(block_index);
+  }
+  esdf_snapshot_event_.record(*cuda_stream_);
+
+  // The snapshot now owns the update of these blocks.
+  blocks_to_update_tracker_.markBlocksAsUpdated(BlocksToUpdateType::kEsdf);
+}
+
+void Mapper::updateEsdfFromSnapshot() {
+  bool has_snapshot = false;
+  {
+    std::lock_guard<std::mutex> lock(esdf_snapshot_mutex_);
+    if (pending_esdf_snapshot_ &&
+        !pending_esdf_snapshot_->block_indices.empty()) {
+      std::swap(pending_esdf_snapshot_, active_esdf_snapshot_);
+      esdf_snapshot_event_.streamWait(*esdf_integrator_.cuda_stream());
+      has_snapshot = true;
+    }
+  }
+  const std::vector<Index3D> blocks_to_clear = takeQueuedEsdfBlockRemovals();
+
+  if (has_snapshot) {
+    const std::vector<Index3D> blocks_to_update(
+        active_esdf_snapshot_->block_indices.begin(),
+        active_esdf_snapshot_->block_indices.end());
+    integrateEsdfBlocks(blocks_to_update, active_esdf_snapshot_->layers);
+
+    // Release the copied blocks, such that the snapshot only ever holds the
+    // blocks of a single update.
+    active_esdf_snapshot_->block_indices.clear();
+    active_esdf_snapshot_->layers.getPtr<TsdfLayer>()->clear();
+    active_esdf_snapshot_->layers.getPtr<FreespaceLayer>()->clear();
+    active_esdf_snapshot_->layers.getPtr<OccupancyLayer>()->clear();
+  }
+
+  // Pruned blocks are removed after the update, as the snapshot may have been
+  // taken before they were pruned.
+  layers_.getPtr<EsdfLayer>()->clearBlocksAsync(
+      blocks_to_clear, *esdf_integrator_.cuda_stream());
+}
+
+void Mapper::updateEsdfSlice(UpdateFullLayer update_full_layer,
+                             std::optional<Plane> ground_plane) {
+  CHECK(esdf_mode_ != EsdfMode::k3D) << "Currently, we limit computation of "
+                                        "the ESDF to 2d *or* 3d. Not both.";
+  esdf_mode_ = EsdfMode::k2D;
+
+  clearEsdfBlocks(takeQueuedEsdfBlockRemovals(), *cuda_stream_);
+
+  // Get the esdf blocks that need an update
+  std::vector<Index3D> blocks_to_update =
+      getBlocksToUpdate(BlocksToUpdateType::kEsdf, update_full_layer);
+
+  if (ground_plane) {
+    if (projective_layer_type_ == ProjectiveLayerType::kTsdfWithFreespace) {
+      // Passing a freespace layer to the integrator for checking if
+      // candidate esdf sites fall into freespace
+      esdf_integrator_.integrateSlice(
+          layers_.get<TsdfLayer>(), layers_.get<FreespaceLayer>(),
+          blocks_to_update, ground_plane.value(), layers_.getPtr<EsdfLayer>());
+    } else if (projective_layer_type_ == ProjectiveLayerType::kTsdf) {
+      esdf_integrator_.integrateSlice(layers_.get<TsdfLayer>(),
+                                      blocks_to_update, ground_plane.value(),
+                                      layers_.getPtr<EsdfLayer>());
 
     } else if (projective_layer_type_ == ProjectiveLayerType::kOccupancy) {
       esdf_integrator_.integrateSlice(layers_.get<OccupancyLayer>(),
@@ -568,18 +1562,78 @@ void Mapper::updateEsdfSlice(UpdateFullLayer update_full_layer,
   blocks_to_update_tracker_.markBlocksAsUpdated(BlocksToUpdateType::kEsdf);
 }
 
+void Mapper::computeDenseEsdfSlice(float unobserved_value,
+                                   Image<float>* slice_image_ptr,
+                                   AxisAlignedBoundingBox* aabb_ptr) {
+  CHECK_NOTNULL(slice_image_ptr);
+  CHECK_NOTNULL(aabb_ptr);
+  if (hasTsdfLayer(projective_layer_type_)) {
+    *aabb_ptr = dense_esdf_slice_integrator_.getAabbOfLayerInSlice(
+        layers_.get<TsdfLayer>());
+    dense_esdf_slice_integrator_.integrateSlice(
+        layers_.get<TsdfLayer>(), *aabb_ptr, unobserved_value, slice_image_ptr);
+  } else {
+    *aabb_ptr = dense_esdf_slice_integrator_.getAabbOfLayerInSlice(
+        layers_.get<OccupancyLayer>());
+    dense_esdf_slice_integrator_.integrateSlice(
+        layers_.get<OccupancyLayer>(), *aabb_ptr, unobserved_value,
+        slice_image_ptr);
+  }
+}
+
+void Mapper::computeClearances(const std::vector<CollisionCapsule>& capsules,
+                               std::vector<float>* clearances_m_ptr) {
+  CHECK_NOTNULL(clearances_m_ptr);
+  collision_checker_.computeClearances(capsules, esdf_layer(),
+                                       clearances_m_ptr);
+}
+
+namespace {
+
+// Gets the blocks of a layer which are outside a radius. The blocks are
+// tested on the GPU over the layer's device block list, and only the flags
+// are copied back.
+template <typename LayerType>
+std::vector<Index3D> getLayerBlocksOutsideRadius(
+    const LayerType& layer, const Vector3f& center, float radius,
+    device_vector<bool>* flags_device, host_vector<bool>* flags_host,
+    const CudaStream& cuda_stream) {
+  const std::vector<Index3D>& block_indices = layer.getAllBlockIndicesCached();
+  if (block_indices.empty()) {
+    return std::vector<Index3D>();
+  }
+  flagBlocksOutsideRadiusOnGpuAsync(layer.getAllBlockIndicesOnGpu(cuda_stream),
+                                    layer.block_size(), center, radius,
+                                    flags_device, cuda_stream);
+  flags_host->copyFromAsync(*flags_device, cuda_stream);
+  cuda_stream.synchronize();
+  std::vector<Index3D> blocks_outside_radius;
+  for (size_t i = 0; i < block_indices.size(); i++) {
+    if ((*flags_host)[i]) {
+      blocks_outside_radius.push_back(block_indices[i]);
+    }
+  }
+  return blocks_outside_radius;
+}
+
+}  // namespace
+
 void Mapper::clearOutsideRadius(const Vector3f& center, float radius) {
   std::vector<Index3D> block_indices_for_deletion;
+  // The cleared blocks are returned to the memory pool, and removed from the
+  // GPU hash, in one batch.
   if (hasTsdfLayer(projective_layer_type_)) {
-    block_indices_for_deletion = getBlocksOutsideRadius(
-        layers_.get<TsdfLayer>().getAllBlockIndices(),
-        layers_.get<TsdfLayer>().block_size(), center, radius);
+    block_indices_for_deletion = getLayerBlocksOutsideRadius(
+        layers_.get<TsdfLayer>(), center, radius,
+        &blocks_outside_radius_device_, &blocks_outside_radius_host_,
+        *cuda_stream_);
     layers_.getPtr<TsdfLayer>()->clearBlocksAsync(block_indices_for_deletion,
                                                   *cuda_stream_);
   } else if (projective_layer_type_ == ProjectiveLayerType::kOccupancy) {
-    block_indices_for_deletion = getBlocksOutsideRadius(
-        layers_.get<OccupancyLayer>().getAllBlockIndices(),
-        layers_.get<OccupancyLayer>().block_size(), center, radius);
+    block_indices_for_deletion = getLayerBlocksOutsideRadius(
+        layers_.get<OccupancyLayer>(), center, radius,
+        &blocks_outside_radius_device_, &blocks_outside_radius_host_,
+        *cuda_stream_);
     layers_.getPtr<OccupancyLayer>()->clearBlocksAsync(
         block_indices_for_deletion, *cuda_stream_);
   }
@@ -587,6 +1641,274 @@ void Mapper::clearOutsideRadius(const Vector3f& center, float radius) {
   // Clear the blocks that got deallocated in the tsdf/occupancy layer also in
   // the esdf, freespace and mesh layers.
   clearBlocksInLayers(block_indices_for_deletion);
+
+  // Blocks of a lazily loaded map outside the radius are never loaded.
+  if (numUnloadedMapBlocks() > 0) {
+    lazy_map_loader_->discardBlocks(getBlocksOutsideRadius(
+        lazy_map_loader_->getUnloadedBlockIndices(),
+        lazy_map_loader_->block_size(), center, radius));
+  }
+}
+
+void Mapper::clearBlocks(const std::vector<Index3D>& block_indices) {
+  if (hasTsdfLayer(projective_layer_type_)) {
+    layers_.getPtr<TsdfLayer>()->clearBlocksAsync(block_indices,
+                                                  *cuda_stream_);
+  } else if (projective_layer_type_ == ProjectiveLayerType::kOccupancy) {
+    layers_.getPtr<OccupancyLayer>()->clearBlocksAsync(block_indices,
+                                                       *cuda_stream_);
+  }
+  clearBlocksInLayers(block_indices);
+}
+
+size_t MapperMemoryUsage::deviceBytesInUse() const {
+  size_t idle_bytes = device_memory_pool.idle_bytes();
+  for (const auto& [name, layer_usage] : layers) {
+    if (layer_usage.memory_type == MemoryType::kDevice) {
+      idle_bytes += layer_usage.blocks.idle_bytes();
+    }
+  }
+  const size_t device_used_bytes = device_total_bytes - device_free_bytes;
+  return (device_used_bytes > idle_bytes) ? device_used_bytes - idle_bytes : 0;
+}
+
+float MapperMemoryUsage::devicePressure() const {
+  if (device_total_bytes == 0) {
+    return 0.0f;
+  }
+  return static_cast<float>(deviceBytesInUse()) /
+         static_cast<float>(device_total_bytes);
+}
+
+void MapperMemoryUsage::writeMetrics(const std::string& mapper_name,
+                                     timing::MetricsWriter* writer) const {
+  CHECK_NOTNULL(writer);
+  const timing::MetricLabels mapper_labels = {{"mapper", mapper_name}};
+  for (const auto& [name, layer_usage] : layers) {
+    const timing::MetricLabels labels = {{"mapper", mapper_name},
+                                         {"layer", name}};
+    writer->addGauge("nvblox_layer_block_allocated_bytes",
+                     "Bytes allocated by the block pool of a layer.", labels,
+                     layer_usage.blocks.allocated_bytes);
+    writer->addGauge("nvblox_layer_block_used_bytes",
+                     "Bytes of the block pool of a layer in use.", labels,
+                     layer_usage.blocks.used_bytes);
+    writer->addGauge("nvblox_layer_gpu_hash_allocated_bytes",
+                     "Bytes allocated by the GPU hash of a layer.", labels,
+                     layer_usage.gpu_hash.allocated_bytes);
+    writer->addGauge("nvblox_layer_paged_out_bytes",
+                     "Host bytes of the paged out blocks of a layer.", labels,
+                     layer_usage.paged_out_bytes);
+
+    const GPUHashStatistics& hash = layer_usage.gpu_hash_statistics;
+    writer->addCounter("nvblox_gpu_hash_inserted_blocks",
+                       "Blocks inserted into the GPU hash of a layer.", labels,
+                       hash.num_inserted_blocks);
+    writer->addCounter("nvblox_gpu_hash_removed_blocks",
+                       "Blocks removed from the GPU hash of a layer.", labels,
+                       hash.num_removed_blocks);
+    writer->addCounter("nvblox_gpu_hash_synchronous_rehashes",
+                       "Rehashes of the GPU hash which blocked the caller.",
+                       labels, hash.num_synchronous_rehashes);
+    writer->addCounter("nvblox_gpu_hash_staged_rehashes",
+                       "Rehashes of the GPU hash in the background.", labels,
+                       hash.num_staged_rehashes);
+    writer->addCounter("nvblox_gpu_hash_rehash_seconds",
+                       "Host time blocked by rehashes of the GPU hash.",
+                       labels, hash.total_rehash_seconds);
+    writer->addGauge("nvblox_gpu_hash_load_factor",
+                     "The load factor of the GPU hash after the last flush.",
+                     labels,
+                     hash.load_factor_history.empty()
+                         ? 0.0
+                         : hash.load_factor_history.back());
+    writer->addGauge("nvblox_gpu_hash_mean_probe_length",
+                     "The mean sampled probe length of the GPU hash.", labels,
+                     hash.meanProbeLength());
+  }
+  writer->addGauge("nvblox_scratch_arena_allocated_bytes",
+                   "Bytes allocated by the integrators' scratch arena.",
+                   mapper_labels, scratch_arena.allocated_bytes);
+  writer->addGauge("nvblox_device_memory_pool_allocated_bytes",
+                   "Bytes allocated by the device's default memory pool.",
+                   mapper_labels, device_memory_pool.allocated_bytes);
+  writer->addGauge("nvblox_device_memory_pool_used_bytes",
+                   "Bytes of the device's default memory pool in use.",
+                   mapper_labels, device_memory_pool.used_bytes);
+  writer->addGauge("nvblox_device_bytes_in_use",
+                   "Device memory in use which the mapper can't recover.",
+                   mapper_labels, deviceBytesInUse());
+  writer->addGauge("nvblox_device_free_bytes",
+                   "Free device memory as reported by the driver.",
+                   mapper_labels, device_free_bytes);
+}
+
+MapperMemoryUsage Mapper::memoryUsage() const {
+  MapperMemoryUsage usage;
+  const auto add_layer = [&usage](const std::string& name,
+                                   const auto* layer_ptr) {
+    if (layer_ptr != nullptr) {
+      usage.layers.emplace_back(name, layer_ptr->memoryUsage());
+    }
+  };
+  add_layer("tsdf", layers_.getConstPtr<TsdfLayer>());
+  add_layer("occupancy", layers_.getConstPtr<OccupancyLayer>());
+  add_layer("freespace", layers_.getConstPtr<FreespaceLayer>());
+  add_layer("color", layers_.getConstPtr<ColorLayer>());
+  add_layer("esdf", layers_.getConstPtr<EsdfLayer>());
+  add_layer("mesh", layers_.getConstPtr<MeshLayer>());
+
+  usage.scratch_arena.allocated_bytes = scratch_arena_.capacity_bytes();
+  usage.scratch_arena.used_bytes = scratch_arena_.used_bytes();
+
+  const DeviceMemoryPoolUsage pool_usage = getDeviceMemoryPoolUsage();
+  usage.device_memory_pool.allocated_bytes = pool_usage.reserved_bytes;
+  usage.device_memory_pool.used_bytes = pool_usage.used_bytes;
+
+  checkCudaErrors(
+      cudaMemGetInfo(&usage.device_free_bytes, &usage.device_total_bytes));
+  return usage;
+}
+
+bool Mapper::relieveMemoryPressure(const Vector3f& center) {
+  if (memory_pressure_watermark_ >= 1.0f) {
+    return false;
+  }
+  const float pressure = memoryUsage().devicePressure();
+  if (pressure <= memory_pressure_watermark_) {
+    return false;
+  }
+  LOG(WARNING) << "Device memory pressure " << pressure << " exceeds "
+               << memory_pressure_watermark_ << ". "
+               << (memory_pressure_page_out_ ? "Paging out" : "Clearing")
+               << " the map outside " << memory_pressure_keep_radius_m_
+               << "m.";
+  if (memory_pressure_page_out_) {
+    pageOutOutsideRadius(center, memory_pressure_keep_radius_m_);
+  } else {
+    clearOutsideRadius(center, memory_pressure_keep_radius_m_);
+  }
+  return true;
+}
+
+void Mapper::pageOutOutsideRadius(const Vector3f& center, float radius) {
+  std::vector<Index3D> block_indices_for_paging;
+  if (hasTsdfLayer(projective_layer_type_)) {
+    block_indices_for_paging = layers_.getPtr<TsdfLayer>()->pageOutBlocks(
+        getBlocksOutsideRadius(layers_.get<TsdfLayer>().getAllBlockIndices(),
+                               layers_.get<TsdfLayer>().block_size(), center,
+                               radius),
+        *cuda_stream_);
+    layers_.getPtr<ColorLayer>()->pageOutBlocks(block_indices_for_paging,
+                                                *cuda_stream_);
+  } else if (projective_layer_type_ == ProjectiveLayerType::kOccupancy) {
+    block_indices_for_paging = layers_.getPtr<OccupancyLayer>()->pageOutBlocks(
+        getBlocksOutsideRadius(
+            layers_.get<OccupancyLayer>().getAllBlockIndices(),
+            layers_.get<OccupancyLayer>().block_size(), center, radius),
+        *cuda_stream_);
+  }
+  if (hasFreespaceLayer(projective_layer_type_)) {
+    layers_.getPtr<FreespaceLayer>()->pageOutBlocks(block_indices_for_paging,
+                                                    *cuda_stream_);
+  }
+
+  // The mesh and esdf are recomputed when the blocks get paged in again, so we
+  // just clear them. The already paged out layers are unaffected.
+  clearBlocksInLayers(block_indices_for_paging);
+}
+
+std::vector<Index3D> Mapper::pageInBlocksInView(const Transform& T_L_C,
+                                                const Camera& camera) {
+  float max_distance_m = 0.0f;
+  AxisAlignedBoundingBox paged_out_aabb;
+  if (hasTsdfLayer(projective_layer_type_)) {
+    max_distance_m = tsdf_integrator_.max_integration_distance_m() +
+                     tsdf_integrator_.get_truncation_distance_m(voxel_size_m_);
+    paged_out_aabb = layers_.get<TsdfLayer>().pagedOutBlocksAABB();
+  } else if (projective_layer_type_ == ProjectiveLayerType::kOccupancy) {
+    max_distance_m =
+        occupancy_integrator_.max_integration_distance_m() +
+        occupancy_integrator_.get_truncation_distance_m(voxel_size_m_);
+    paged_out_aabb = layers_.get<OccupancyLayer>().pagedOutBlocksAABB();
+  }
+  // Skip the frustum pass if no paged out block can be in view.
+  if (numUnloadedMapBlocks() == 0 &&
+      !camera.getViewAABB(T_L_C, 0.0f, max_distance_m)
+           .intersects(paged_out_aabb)) {
+    return {};
+  }
+
+  std::vector<Index3D> blocks_in_view;
+  if (hasTsdfLayer(projective_layer_type_)) {
+    blocks_in_view = tsdf_integrator_.view_calculator().getBlocksInViewPlanes(
+        T_L_C, camera, layers_.get<TsdfLayer>().block_size(), max_distance_m);
+  } else if (projective_layer_type_ == ProjectiveLayerType::kOccupancy) {
+    blocks_in_view =
+        occupancy_integrator_.view_calculator().getBlocksInViewPlanes(
+            T_L_C, camera, layers_.get<OccupancyLayer>().block_size(),
+            max_distance_m);
+  }
+  if (numUnloadedMapBlocks() > 0) {
+    loadMapBlocks(blocks_in_view);
+  }
+
+  std::vector<Index3D> paged_in_blocks;
+  if (hasTsdfLayer(projective_layer_type_)) {
+    paged_in_blocks = layers_.getPtr<TsdfLayer>()->pageInBlocks(
+        blocks_in_view, *cuda_stream_);
+    layers_.getPtr<ColorLayer>()->pageInBlocks(paged_in_blocks,
+                                               *cuda_stream_);
+  } else if (projective_layer_type_ == ProjectiveLayerType::kOccupancy) {
+    paged_in_blocks = layers_.getPtr<OccupancyLayer>()->pageInBlocks(
+        blocks_in_view, *cuda_stream_);
+    occupancy_decay_integrator_.markBlocksAsActive(paged_in_blocks);
+  }
+  if (hasFreespaceLayer(projective_layer_type_)) {
+    layers_.getPtr<FreespaceLayer>()->pageInBlocks(paged_in_blocks,
+                                                   *cuda_stream_);
+  }
+  blocks_to_update_tracker_.addBlocksToUpdate(paged_in_blocks);
+  return paged_in_blocks;
+}
+
+int Mapper::numPagedOutBlocks() const {
+  if (hasTsdfLayer(projective_layer_type_)) {
+    return layers_.get<TsdfLayer>().numPagedOutBlocks();
+  } else if (projective_layer_type_ == ProjectiveLayerType::kOccupancy) {
+    return layers_.get<OccupancyLayer>().numPagedOutBlocks();
+  }
+  return 0;
+}
+
+std::vector<Index3D> Mapper::loadMapBlocksInRadius(const Vector3f& center,
+                                                   float radius) {
+  if (numUnloadedMapBlocks() == 0) {
+    return std::vector<Index3D>();
+  }
+  return loadMapBlocks(getBlocksWithinRadius(
+      lazy_map_loader_->getUnloadedBlockIndices(),
+      lazy_map_loader_->block_size(), center, radius));
+}
+
+int Mapper::numUnloadedMapBlocks() const {
+  if (!lazy_map_loader_) {
+    return 0;
+  }
+  return lazy_map_loader_->numUnloadedBlocks();
+}
+
+std::vector<Index3D> Mapper::loadMapBlocks(
+    const std::vector<Index3D>& indices) {
+  CHECK(lazy_map_loader_);
+  const std::vector<Index3D> loaded_blocks =
+      lazy_map_loader_->loadBlocks(indices, &layers_, *cuda_stream_);
+  blocks_to_update_tracker_.addBlocksToUpdate(loaded_blocks);
+  // Release the file once the whole map is resident.
+  if (lazy_map_loader_->numUnloadedBlocks() == 0) {
+    lazy_map_loader_.reset();
+  }
+  return loaded_blocks;
 }
 
 void Mapper::markUnobservedTsdfFreeInsideRadius(const Vector3f& center,
@@ -599,6 +1921,7 @@ void Mapper::markUnobservedTsdfFreeInsideRadius(const Vector3f& center,
   } else if (projective_layer_type_ == ProjectiveLayerType::kOccupancy) {
     occupancy_integrator_.markUnobservedFreeInsideRadius(
         center, radius, layers_.getPtr<OccupancyLayer>(), &updated_blocks);
+    occupancy_decay_integrator_.markBlocksAsActive(updated_blocks);
   }
 
   blocks_to_update_tracker_.addBlocksToUpdate(updated_blocks);
@@ -618,6 +1941,19 @@ std::vector<Index3D> Mapper::getClearedBlocks(
   return cleared_blocks_vec;
 }
 
+void Mapper::trackGroundPlaneBlocks(bool track_ground_plane_blocks) {
+  blocks_to_update_tracker_.trackGroundPlaneBlocks(track_ground_plane_blocks);
+}
+
+std::vector<Index3D> Mapper::getGroundPlaneBlocksToUpdate() {
+  std::vector<Index3D> blocks_to_update =
+      blocks_to_update_tracker_.getBlocksToUpdate(
+          BlocksToUpdateType::kGroundPlane);
+  blocks_to_update_tracker_.markBlocksAsUpdated(
+      BlocksToUpdateType::kGroundPlane);
+  return blocks_to_update;
+}
+
 std::vector<Index3D> Mapper::getBlocksToUpdate(
     BlocksToUpdateType blocks_to_update_type,
     UpdateFullLayer update_full_layer) const {
@@ -632,10 +1968,48 @@ std::vector<Index3D> Mapper::getBlocksToUpdate(
   }
 }
 
+void Mapper::integrateEsdfBlocks(
+    const std::vector<Index3D>& blocks_to_update) {
+  // The input layers are written on the mapper stream.
+  if (esdf_integrator_.cuda_stream() != cuda_stream_) {
+    esdf_input_event_.record(*cuda_stream_);
+    esdf_input_event_.streamWait(*esdf_integrator_.cuda_stream());
+  }
+  integrateEsdfBlocks(blocks_to_update, layers_);
+}
+
+void Mapper::integrateEsdfBlocks(const std::vector<Index3D>& blocks_to_update,
+                                 const LayerCake& input_layers) {
+  if (projective_layer_type_ == ProjectiveLayerType::kTsdfWithFreespace) {
+    // Passing a freespace layer to the integrator for checking if
+    // candidate esdf sites fall into freespace
+    esdf_integrator_.integrateBlocks(
+        input_layers.get<TsdfLayer>(), input_layers.get<FreespaceLayer>(),
+        blocks_to_update, layers_.getPtr<EsdfLayer>());
+  } else if (projective_layer_type_ == ProjectiveLayerType::kTsdf) {
+    esdf_integrator_.integrateBlocks(input_layers.get<TsdfLayer>(),
+                                     blocks_to_update,
+                                     layers_.getPtr<EsdfLayer>());
+  } else if (projective_layer_type_ == ProjectiveLayerType::kOccupancy) {
+    esdf_integrator_.integrateBlocks(input_layers.get<OccupancyLayer>(),
+                                     blocks_to_update,
+                                     layers_.getPtr<EsdfLayer>());
+  }
+}
+
 void Mapper::clearBlocksInLayers(const std::vector<Index3D>& blocks_to_clear) {
+  clearBlocksInIntegrationLayers(blocks_to_clear);
+  clearEsdfBlocks(blocks_to_clear, *cuda_stream_);
+}
+
+void Mapper::clearBlocksInIntegrationLayers(
+    const std::vector<Index3D>& blocks_to_clear) {
   // Clear the mesh and color blocks.
   layers_.getPtr<ColorLayer>()->clearBlocksAsync(blocks_to_clear,
                                                  *cuda_stream_);
+  if (label_layer_ != nullptr) {
+    label_layer_->clearBlocksAsync(blocks_to_clear, *cuda_stream_);
+  }
   if (hasTsdfLayer(projective_layer_type_)) {
     layers_.getPtr<MeshLayer>()->clearBlocksAsync(blocks_to_clear,
                                                   *cuda_stream_);
@@ -646,11 +2020,20 @@ void Mapper::clearBlocksInLayers(const std::vector<Index3D>& blocks_to_clear) {
                                                        *cuda_stream_);
   }
 
-  // Clear the blocks in the esdf layer.
+  // We don't need to update the deallocated blocks.
+  blocks_to_update_tracker_.removeBlocksToUpdate(blocks_to_clear);
+
+  // We need to keep track of cleared blocks to delete them in our
+  // visualizer.
+  cleared_blocks_.insert(blocks_to_clear.begin(), blocks_to_clear.end());
+}
+
+void Mapper::clearEsdfBlocks(const std::vector<Index3D>& blocks_to_clear,
+                             const CudaStream& cuda_stream) {
   if (esdf_mode_ == EsdfMode::k3D) {
     // In the 3D case this is easy.
     layers_.getPtr<EsdfLayer>()->clearBlocksAsync(blocks_to_clear,
-                                                  *cuda_stream_);
+                                                  cuda_stream);
   } else {
     // In the 2D case we need to check if an occupancy/tsdf block is left in the
     // vertical column (z-axis) for every 2d esdf block.
@@ -705,29 +2088,54 @@ void Mapper::clearBlocksInLayers(const std::vector<Index3D>& blocks_to_clear) {
         // No corresponding projective block found. So let's clear this esdf
         // block.
         layers_.getPtr<EsdfLayer>()->clearBlockAsync(esdf_block_index,
-                                                     *cuda_stream_);
+                                                     cuda_stream);
       }
     }
   }
+}
 
-  // We don't need to update the deallocated blocks.
-  blocks_to_update_tracker_.removeBlocksToUpdate(blocks_to_clear);
+void Mapper::queueEsdfBlockRemovals(const std::vector<Index3D>& block_indices) {
+  std::lock_guard<std::mutex> lock(esdf_snapshot_mutex_);
+  queued_esdf_block_removals_.insert(block_indices.begin(),
+                                     block_indices.end());
+}
 
-  // We need to keep track of cleared blocks to delete them in our
-  // visualizer.
-  cleared_blocks_.insert(blocks_to_clear.begin(), blocks_to_clear.end());
+std::vector<Index3D> Mapper::takeQueuedEsdfBlockRemovals() {
+  std::lock_guard<std::mutex> lock(esdf_snapshot_mutex_);
+  std::vector<Index3D> block_indices(queued_esdf_block_removals_.begin(),
+                                     queued_esdf_block_removals_.end());
+  queued_esdf_block_removals_.clear();
+  return block_indices;
 }
 
 bool Mapper::saveLayerCake(const std::string& filename) const {
-  return io::writeLayerCakeToFile(filename, layers_, *cuda_stream_);
+  // Stale derived layers would be restored as if they matched the TSDF.
+  bool store_derived_layers = save_derived_layers_;
+  if (store_derived_layers &&
+      (!blocks_to_update_tracker_.getBlocksToUpdate(BlocksToUpdateType::kEsdf)
+            .empty() ||
+       !blocks_to_update_tracker_.getBlocksToUpdate(BlocksToUpdateType::kMesh)
+            .empty())) {
+    LOG(WARNING) << "Not storing the ESDF and mesh in " << filename
+                 << " as they aren't up to date with the TSDF.";
+    store_derived_layers = false;
+  }
+  return io::writeLayerCakeToFile(filename, layers_, *cuda_stream_,
+                                  compress_saved_maps_, store_derived_layers);
 }
 
 bool Mapper::saveLayerCake(const char* filename) const {
   return saveLayerCake(std::string(filename));
 }
 
+bool Mapper::saveLayerCakeBinary(const std::string& filename) const {
+  return io::writeLayerCakeToBinaryFile(filename, layers_, *cuda_stream_);
+}
+
 bool Mapper::loadMap(const std::string& filename) {
-  LayerCake new_cake = io::loadLayerCakeFromFile(filename, memory_type_);
+  bool derived_layers_consistent = false;
+  LayerCake new_cake = io::loadLayerCakeFromFile(filename, memory_type_,
+                                                 &derived_layers_consistent);
   // Will return an empty cake if anything went wrong.
   if (new_cake.empty()) {
     LOG(ERROR) << "Failed to load map from file: " << filename;
@@ -750,19 +2158,204 @@ bool Mapper::loadMap(const std::string& filename) {
 
   // Now we're happy, let's swap the cakes.
   layers_ = std::move(new_cake);
+  lazy_map_loader_.reset();
+  resetCheckpoint();
   blocks_to_update_tracker_.markBlocksAsUpdated(BlocksToUpdateType::kEsdf);
 
+  // The mesh is only stored along with the TSDF it was computed from.
+  // Otherwise we have to add a new mesh layer.
+  if (!derived_layers_consistent) {
+    std::unique_ptr<MeshLayer> mesh(new MeshLayer(
+        layers_.getPtr<TsdfLayer>()->block_size(), memory_type_));
+    layers_.insert(typeid(MeshLayer), std::move(mesh));
+  }
+  // The loaded layers take over the block order of the mapper.
+  morton_ordered_blocks(morton_ordered_blocks_);
+  preallocateBlocks();
+  if (derived_layers_consistent) {
+    blocks_to_update_tracker_.markBlocksAsUpdated(BlocksToUpdateType::kMesh);
+    blocks_to_update_tracker_.markBlocksAsUpdated(
+        BlocksToUpdateType::kMeshColor);
+  } else {
+    updateMesh(UpdateFullLayer::kYes);
+  }
+
+  return true;
+}
+
+bool Mapper::loadMap(const char* filename) {
+  return loadMap(std::string(filename));
+}
+
+bool Mapper::saveCheckpoint(const std::string& filename) {
+  timing::Timer timer("mapper/save_checkpoint");
+  // Start a new log with a full checkpoint. Changes are tracked from here on.
+  if (!checkpoint_log_ || checkpoint_log_->filename() != filename) {
+    auto checkpoint_log = std::make_unique<CheckpointLog>();
+    if (!checkpoint_log->open(filename)) {
+      return false;
+    }
+    blocks_to_update_tracker_.trackCheckpointBlocks(true);
+    if (!checkpoint_log->appendFullCheckpoint(layers_, *cuda_stream_)) {
+      resetCheckpoint();
+      return false;
+    }
+    checkpoint_log_ = std::move(checkpoint_log);
+    return true;
+  }
+
+  std::vector<Index3D> changed_blocks =
+      blocks_to_update_tracker_.getBlocksToUpdate(
+          BlocksToUpdateType::kCheckpoint);
+  blocks_to_update_tracker_.markBlocksAsUpdated(
+      BlocksToUpdateType::kCheckpoint);
+  // Paged out blocks would be recorded as removed. They are marked for update
+  // again, and therefore checkpointed, when they are paged in.
+  if (numPagedOutBlocks() > 0) {
+    auto is_paged_out = [this](const Index3D& index) {
+      if (hasTsdfLayer(projective_layer_type_)) {
+        return layers_.get<TsdfLayer>().isBlockPagedOut(index);
+      }
+      return layers_.get<OccupancyLayer>().isBlockPagedOut(index);
+    };
+    changed_blocks.erase(std::remove_if(changed_blocks.begin(),
+                                        changed_blocks.end(), is_paged_out),
+                         changed_blocks.end());
+  }
+  if (!checkpoint_log_->appendCheckpoint(layers_, changed_blocks,
+                                         *cuda_stream_)) {
+    // The changes are lost from the tracker, so start over next time.
+    resetCheckpoint();
+    return false;
+  }
+  return true;
+}
+
+void Mapper::resetCheckpoint() {
+  checkpoint_log_.reset();
+  blocks_to_update_tracker_.trackCheckpointBlocks(false);
+}
+
+bool Mapper::loadMapLazy(const std::string& filename) {
+  auto loader = std::make_unique<LazyBinaryMapLoader>();
+  if (!loader->open(filename)) {
+    LOG(ERROR) << "Failed to open map for lazy loading: " << filename
+               << ". Lazy loading requires a map saved with "
+                  "saveLayerCakeBinary().";
+    return false;
+  }
+  LayerCake new_cake = loader->createLayerCake(memory_type_);
+  if (new_cake.getPtr<TsdfLayer>() == nullptr) {
+    LOG(ERROR) << "No TSDF layer could be loaded from file: " << filename
+               << ". Aborting loading.";
+    return false;
+  }
+  if (new_cake.voxel_size() != voxel_size_m_) {
+    LOG(INFO) << "Setting the voxel size from the loaded map as: "
+              << new_cake.voxel_size();
+    voxel_size_m_ = new_cake.voxel_size();
+  }
+  layers_ = std::move(new_cake);
+  lazy_map_loader_ = std::move(loader);
+  resetCheckpoint();
+
   // We can't serialize mesh layers yet so we have to add a new mesh layer.
   std::unique_ptr<MeshLayer> mesh(
       new MeshLayer(layers_.getPtr<TsdfLayer>()->block_size(), memory_type_));
   layers_.insert(typeid(MeshLayer), std::move(mesh));
-  updateMesh(UpdateFullLayer::kYes);
-
+  // The loaded layers take over the block order of the mapper.
+  morton_ordered_blocks(morton_ordered_blocks_);
+  preallocateBlocks();
   return true;
 }
 
-bool Mapper::loadMap(const char* filename) {
-  return loadMap(std::string(filename));
+void Mapper::loadMapInBackground(const std::string& filename) {
+  // Wait for any previous load, its map is discarded.
+  if (background_map_future_.valid()) {
+    background_map_future_.wait();
+  }
+  background_map_.reset();
+  background_map_blocks_to_merge_.clear();
+  const MemoryType memory_type = memory_type_;
+  background_map_future_ =
+      std::async(std::launch::async, [filename, memory_type]() {
+        timing::Timer timer("mapper/load_map_in_background");
+        return io::loadLayerCakeFromFile(filename, memory_type);
+      });
+}
+
+std::vector<Index3D> Mapper::mergeBackgroundLoadedMapBlocks(
+    int max_num_blocks) {
+  CHECK_GE(max_num_blocks, 0);
+  // Pick up the map once it's loaded.
+  if (background_map_future_.valid()) {
+    if (background_map_future_.wait_for(std::chrono::seconds(0)) !=
+        std::future_status::ready) {
+      return std::vector<Index3D>();
+    }
+    auto loaded_map =
+        std::make_unique<LayerCake>(background_map_future_.get());
+    if (loaded_map->empty()) {
+      LOG(ERROR) << "Failed to load map in the background.";
+    } else if (loaded_map->voxel_size() != voxel_size_m_) {
+      LOG(ERROR) << "Can't merge a map with voxel size "
+                 << loaded_map->voxel_size() << " into a map with voxel size "
+                 << voxel_size_m_ << ". Discarding the loaded map.";
+    } else if (hasTsdfLayer(projective_layer_type_) &&
+               loaded_map->exists<TsdfLayer>()) {
+      background_map_blocks_to_merge_ =
+          loaded_map->get<TsdfLayer>().getAllBlockIndices();
+      background_map_ = std::move(loaded_map);
+    } else if (projective_layer_type_ == ProjectiveLayerType::kOccupancy &&
+               loaded_map->exists<OccupancyLayer>()) {
+      background_map_blocks_to_merge_ =
+          loaded_map->get<OccupancyLayer>().getAllBlockIndices();
+      background_map_ = std::move(loaded_map);
+    } else {
+      LOG(ERROR) << "The map loaded in the background has no layer of the "
+                    "projective layer type of the mapper.";
+    }
+  }
+  if (!background_map_) {
+    return std::vector<Index3D>();
+  }
+
+  // Take the next blocks, skipping those already observed live.
+  std::vector<Index3D> blocks_to_merge;
+  while (!background_map_blocks_to_merge_.empty() &&
+         static_cast<int>(blocks_to_merge.size()) < max_num_blocks) {
+    const Index3D block_index = background_map_blocks_to_merge_.back();
+    background_map_blocks_to_merge_.pop_back();
+    const bool is_observed_live =
+        hasTsdfLayer(projective_layer_type_)
+            ? tsdf_layer().isBlockAllocated(block_index)
+            : occupancy_layer().isBlockAllocated(block_index);
+    if (!is_observed_live) {
+      blocks_to_merge.push_back(block_index);
+    }
+  }
+
+  timing::Timer timer("mapper/merge_background_loaded_map");
+  copyBlocksIfLayerExists<TsdfLayer>(blocks_to_merge, *background_map_,
+                                     &layers_, *cuda_stream_);
+  copyBlocksIfLayerExists<OccupancyLayer>(
+      blocks_to_merge, *background_map_, &layers_, *cuda_stream_);
+  copyBlocksIfLayerExists<ColorLayer>(blocks_to_merge, *background_map_,
+                                      &layers_, *cuda_stream_);
+  copyBlocksIfLayerExists<FreespaceLayer>(
+      blocks_to_merge, *background_map_, &layers_, *cuda_stream_);
+  cuda_stream_->synchronize();
+  blocks_to_update_tracker_.addBlocksToUpdate(blocks_to_merge);
+
+  // Release the loaded map once it's merged.
+  if (background_map_blocks_to_merge_.empty()) {
+    background_map_.reset();
+  }
+  return blocks_to_merge;
+}
+
+bool Mapper::isLoadingMapInBackground() const {
+  return background_map_future_.valid() || background_map_ != nullptr;
 }
 
 bool Mapper::saveMeshAsPly(const std::string& filepath) const {
@@ -785,6 +2378,102 @@ bool Mapper::saveFreespaceAsPly(const std::string& filename) const {
   return io::outputVoxelLayerToPly(freespace_layer(), filename);
 }
 
+namespace {
+
+// Produces a host copy of a layer, as it was when captured.
+template <typename LayerType>
+using HostLayerFactory =
+    std::function<std::shared_ptr<LayerType>(const CudaStream&)>;
+
+// Captures a layer for writing it out on another thread. Layers with
+// trivially copyable blocks are snapshotted, such that their blocks are only
+// copied by the factory (i.e. on the writing thread). Others are copied to
+// the host right away.
+template <typename LayerType>
+HostLayerFactory<LayerType> captureLayer(const LayerType& layer,
+                                         const CudaStream& cuda_stream) {
+  const float voxel_size = layer.voxel_size();
+  if constexpr (std::is_trivially_copyable<
+                    typename LayerType::BlockType>::value) {
+    auto snapshot = layer.snapshot(cuda_stream);
+    return [snapshot, voxel_size](const CudaStream& cuda_stream) {
+      auto host_layer =
+          std::make_shared<LayerType>(voxel_size, MemoryType::kHost);
+      snapshot.copyToLayer(host_layer.get(), cuda_stream);
+      return host_layer;
+    };
+  } else {
+    auto host_layer =
+        std::make_shared<LayerType>(voxel_size, MemoryType::kHost);
+    host_layer->copyFromAsync(layer, cuda_stream);
+    cuda_stream.synchronize();
+    return [host_layer](const CudaStream&) { return host_layer; };
+  }
+}
+
+// Captures a layer of the cake (see captureLayer()), and returns a function
+// adding the host copy to another cake. Does nothing if the layer doesn't
+// exist.
+template <typename LayerType>
+std::function<void(LayerCake*, const CudaStream&)> captureCakeLayer(
+    const LayerCake& cake, const CudaStream& cuda_stream) {
+  const LayerType* layer_ptr = cake.getConstPtr<LayerType>();
+  if (layer_ptr == nullptr) {
+    return [](LayerCake*, const CudaStream&) {};
+  }
+  HostLayerFactory<LayerType> factory = captureLayer(*layer_ptr, cuda_stream);
+  return [factory](LayerCake* cake_ptr, const CudaStream& cuda_stream) {
+    cake_ptr->insert(typeid(LayerType), factory(cuda_stream));
+  };
+}
+
+}  // namespace
+
+std::future<bool> Mapper::saveLayerCakeAsync(
+    const std::string& filename) const {
+  // The layers serialized by saveLayerCake().
+  const std::vector<std::function<void(LayerCake*, const CudaStream&)>>
+      captured_layers = {
+          captureCakeLayer<TsdfLayer>(layers_, *cuda_stream_),
+          captureCakeLayer<ColorLayer>(layers_, *cuda_stream_),
+          captureCakeLayer<OccupancyLayer>(layers_, *cuda_stream_),
+          captureCakeLayer<EsdfLayer>(layers_, *cuda_stream_)};
+  const float voxel_size_m = voxel_size_m_;
+  const bool compress_blocks = compress_saved_maps_;
+  return std::async(std::launch::async, [=]() {
+    timing::Timer timer("mapper/save_layer_cake_async");
+    CudaStreamOwning cuda_stream;
+    LayerCake cake(voxel_size_m);
+    for (const auto& add_captured_layer : captured_layers) {
+      add_captured_layer(&cake, cuda_stream);
+    }
+    return io::writeLayerCakeToFile(filename, cake, cuda_stream,
+                                    compress_blocks);
+  });
+}
+
+std::future<bool> Mapper::saveMeshAsPlyAsync(
+    const std::string& filename) const {
+  // Mesh blocks can't be snapshotted, but combining the mesh on the host is
+  // fast compared to writing it out.
+  auto mesh =
+      std::make_shared<Mesh>(Mesh::fromLayer(mesh_layer(), *cuda_stream_));
+  return std::async(std::launch::async, [mesh, filename]() {
+    timing::Timer timer("mapper/save_mesh_as_ply_async");
+    return io::outputMeshToPly(*mesh, filename);
+  });
+}
+
+std::future<bool> Mapper::saveEsdfAsPlyAsync(
+    const std::string& filename) const {
+  HostLayerFactory<EsdfLayer> factory =
+      captureLayer(esdf_layer(), *cuda_stream_);
+  return std::async(std::launch::async, [factory, filename]() {
+    timing::Timer timer("mapper/save_esdf_as_ply_async");
+    return io::outputVoxelLayerToPly(*factory(CudaStreamOwning()), filename);
+  });
+}
+
 parameters::ParameterTreeNode Mapper::getParameterTree(
     const std::string& name_remap) const {
   using parameters::ParameterTreeNode;
@@ -798,17 +2487,66 @@ parameters::ParameterTreeNode Mapper::getParameterTree(
        ParameterTreeNode("do_depth_preprocessing", do_depth_preprocessing_),
        ParameterTreeNode("depth_preprocessing_num_dilations",
                          depth_preprocessing_num_dilations_),
+       ParameterTreeNode("use_cuda_graphs", use_cuda_graphs()),
+       ParameterTreeNode("use_vpi_depth_preprocessing",
+                         use_vpi_depth_preprocessing()),
+       ParameterTreeNode("skip_redundant_depth_frames",
+                         skip_redundant_depth_frames_),
+       ParameterTreeNode("build_depth_pyramid", build_depth_pyramid_),
+       ParameterTreeNode("depth_frame_gate_max_translation_m",
+                         depth_frame_gate_.max_translation_m()),
+       ParameterTreeNode("depth_frame_gate_max_rotation_rad",
+                         depth_frame_gate_.max_rotation_rad()),
+       ParameterTreeNode("depth_frame_gate_max_depth_change_m",
+                         depth_frame_gate_.max_depth_change_m()),
+       ParameterTreeNode("depth_frame_gate_max_changed_pixel_fraction",
+                         depth_frame_gate_.max_changed_pixel_fraction()),
+       ParameterTreeNode("gate_unchanged_depth_pixels",
+                         gate_unchanged_depth_pixels_),
+       ParameterTreeNode("depth_change_gate_min_residual_m",
+                         depth_change_gate_.min_residual_m()),
+       ParameterTreeNode("depth_change_gate_full_frame_period",
+                         depth_change_gate_.full_frame_period()),
+       ParameterTreeNode("depth_change_gate_render_subsampling_factor",
+                         depth_change_gate_.render_subsampling_factor()),
+       ParameterTreeNode("concurrent_layer_serialization",
+                         concurrent_layer_serialization_),
+       ParameterTreeNode("mesh_streaming_max_bytes_per_publish",
+                         mesh_streaming_max_bytes_per_publish_),
+       ParameterTreeNode("mesh_streaming_distance_weight",
+                         mesh_streaming_distance_weight_),
+       ParameterTreeNode("mesh_streaming_staleness_weight",
+                         mesh_streaming_staleness_weight_),
+       ParameterTreeNode("compress_saved_maps", compress_saved_maps_),
+       ParameterTreeNode("save_derived_layers", save_derived_layers_),
+       ParameterTreeNode("preallocate_blocks", preallocate_blocks_),
+       ParameterTreeNode("esdf_window_half_extent_m",
+                         esdf_window_half_extent_m_),
+       ParameterTreeNode("memory_pressure_watermark",
+                         memory_pressure_watermark_),
+       ParameterTreeNode("memory_pressure_keep_radius_m",
+                         memory_pressure_keep_radius_m_),
+       ParameterTreeNode("memory_pressure_page_out",
+                         memory_pressure_page_out_),
+       ParameterTreeNode("morton_ordered_blocks", morton_ordered_blocks_),
+       ParameterTreeNode("block_relayout_allocation_fraction",
+                         block_relayout_allocation_fraction_),
        ParameterTreeNode("exclude_last_view_from_decay",
                          exclude_last_view_from_decay_),
        tsdf_integrator_.getParameterTree("camera_tsdf_integrator"),
        lidar_tsdf_integrator_.getParameterTree("lidar_tsdf_integrator"),
+       lidar_pointcloud_tsdf_integrator_.getParameterTree(
+           "lidar_pointcloud_tsdf_integrator"),
        color_integrator_.getParameterTree(),
        occupancy_integrator_.getParameterTree("camera_occupancy_integrator"),
        lidar_occupancy_integrator_.getParameterTree(
            "lidar_occupancy_integrator"),
-       esdf_integrator_.getParameterTree(), mesh_integrator_.getParameterTree(),
+       esdf_integrator_.getParameterTree(),
+       dense_esdf_slice_integrator_.getParameterTree(),
+       mesh_integrator_.getParameterTree(),
        occupancy_decay_integrator_.getParameterTree(),
        tsdf_decay_integrator_.getParameterTree(),
+       tsdf_block_pruner_.getParameterTree(),
        freespace_integrator_.getParameterTree()});
 }
 
@@ -817,9 +2555,78 @@ std::string Mapper::getParametersAsString() const {
 }
 
 std::shared_ptr<const SerializedMeshLayer> Mapper::serializedMeshLayer() {
+  if (mesh_streaming_max_bytes_per_publish_ > 0) {
+    return prioritizedMeshStreamer().getSerializedLayer();
+  }
   return layer_streamers_.getSerializedLayer<MeshLayer>();
 }
 
+void Mapper::mesh_streaming_max_bytes_per_publish(
+    const int mesh_streaming_max_bytes_per_publish) {
+  CHECK_GE(mesh_streaming_max_bytes_per_publish, 0);
+  mesh_streaming_max_bytes_per_publish_ = mesh_streaming_max_bytes_per_publish;
+}
+
+void Mapper::mesh_streaming_distance_weight(
+    const float mesh_streaming_distance_weight) {
+  mesh_streaming_distance_weight_ = mesh_streaming_distance_weight;
+  if (prioritized_mesh_streamer_) {
+    prioritized_mesh_streamer_->distance_weight(mesh_streaming_distance_weight);
+  }
+}
+
+void Mapper::mesh_streaming_staleness_weight(
+    const float mesh_streaming_staleness_weight) {
+  mesh_streaming_staleness_weight_ = mesh_streaming_staleness_weight;
+  if (prioritized_mesh_streamer_) {
+    prioritized_mesh_streamer_->staleness_weight(
+        mesh_streaming_staleness_weight);
+  }
+}
+
+int Mapper::addMeshStreamingRoi(const StreamingRoi& roi) {
+  StreamingRoi mesh_roi = roi;
+  mesh_roi.block_size_m = mesh_layer().block_size();
+  LayerStreamerOldestBlocks<MeshLayer>* streamer =
+      layer_streamers_.getPtr<MeshLayer>();
+  const int roi_id = streamer->addRoi(mesh_roi);
+  // Send the existing map in the ROI.
+  streamer->markIndicesRoiCandidates(roi_id,
+                                     mesh_layer().getAllBlockIndices());
+  return roi_id;
+}
+
+void Mapper::updateMeshStreamingRoi(const int roi_id,
+                                    const StreamingRoi& roi) {
+  StreamingRoi mesh_roi = roi;
+  mesh_roi.block_size_m = mesh_layer().block_size();
+  layer_streamers_.getPtr<MeshLayer>()->updateRoi(roi_id, mesh_roi);
+}
+
+void Mapper::removeMeshStreamingRoi(const int roi_id) {
+  layer_streamers_.getPtr<MeshLayer>()->removeRoi(roi_id);
+}
+
+std::shared_ptr<const SerializedMeshLayer> Mapper::serializeMeshStreamingRoi(
+    const int roi_id, const size_t num_bytes) {
+  timing::Timer timer("mapper/serialize_mesh_streaming_roi");
+  return layer_streamers_.getPtr<MeshLayer>()->getNBytesOfSerializedRoiBlocks(
+      roi_id, num_bytes, mesh_layer(), *cuda_stream_);
+}
+
+MeshLayerStreamerViewPriority& Mapper::prioritizedMeshStreamer() {
+  if (!prioritized_mesh_streamer_) {
+    prioritized_mesh_streamer_ =
+        std::make_unique<MeshLayerStreamerViewPriority>(
+            mesh_layer().block_size());
+    prioritized_mesh_streamer_->distance_weight(
+        mesh_streaming_distance_weight_);
+    prioritized_mesh_streamer_->staleness_weight(
+        mesh_streaming_staleness_weight_);
+  }
+  return *prioritized_mesh_streamer_;
+}
+
 std::shared_ptr<const SerializedTsdfLayer> Mapper::serializedTsdfLayer() {
   return layer_streamers_.getSerializedLayer<TsdfLayer>();
 }
@@ -834,6 +2641,28 @@ Mapper::serializedFreespaceLayer() {
   return layer_streamers_.getSerializedLayer<FreespaceLayer>();
 }
 
+std::vector<Index3D> Mapper::mergeSerializedTsdfLayer(
+    const SerializedTsdfLayer& serialized_layer) {
+  CHECK(projective_layer_type_ != ProjectiveLayerType::kOccupancy)
+      << "Merging TSDF blocks requires a mapper with a TSDF layer.";
+  serialized_layer_merger_.max_tsdf_weight(tsdf_integrator_.max_weight());
+  const std::vector<Index3D> merged_blocks = serialized_layer_merger_.merge(
+      serialized_layer, layers_.getPtr<TsdfLayer>());
+  blocks_to_update_tracker_.addBlocksToUpdate(merged_blocks);
+  return merged_blocks;
+}
+
+std::vector<Index3D> Mapper::mergeSerializedOccupancyLayer(
+    const SerializedOccupancyLayer& serialized_layer) {
+  CHECK(projective_layer_type_ == ProjectiveLayerType::kOccupancy)
+      << "Merging occupancy blocks requires a mapper with an occupancy layer.";
+  const std::vector<Index3D> merged_blocks = serialized_layer_merger_.merge(
+      serialized_layer, layers_.getPtr<OccupancyLayer>());
+  occupancy_decay_integrator_.markBlocksAsActive(merged_blocks);
+  blocks_to_update_tracker_.addBlocksToUpdate(merged_blocks);
+  return merged_blocks;
+}
+
 std::shared_ptr<const SerializedEsdfLayer> Mapper::serializedEsdfLayer() {
   return layer_streamers_.getSerializedLayer<EsdfLayer>();
 }
@@ -845,7 +2674,8 @@ std::shared_ptr<const SerializedColorLayer> Mapper::serializedColorLayer() {
 void Mapper::serializeColorTsdfAndFreespaceLayers(
     const std::vector<Index3D>& blocks_to_serialize,
     const LayerTypeBitMask layer_type_bitmask, const float bandwidth_limit_mbps,
-    const BlockExclusionParams& exclusion_params) {
+    const BlockExclusionParams& exclusion_params,
+    const CudaStream& cuda_stream) {
   // Color layer doesn't contain any geometry. Therefore we first need to
   // serialize the TSDF layer and make sure that the color layer is serialized
   // with the same block indices.
@@ -854,11 +2684,11 @@ void Mapper::serializeColorTsdfAndFreespaceLayers(
   // Serialize TSDF
   layer_streamers_.estimateBandwidthAndSerialize(
       tsdf_layer(), blocks_to_serialize, "tsdf", exclusion_params,
-      bandwidth_limit_mbps, *cuda_stream_);
+      bandwidth_limit_mbps, cuda_stream);
 
   // Serialize color
   layer_streamers_.serializeAllBlocks(
-      color_layer(), serializedTsdfLayer()->block_indices, *cuda_stream_);
+      color_layer(), serializedTsdfLayer()->block_indices, cuda_stream);
   CHECK_EQ(serializedTsdfLayer()->block_indices.size(),
            serializedColorLayer()->block_indices.size());
 
@@ -866,12 +2696,37 @@ void Mapper::serializeColorTsdfAndFreespaceLayers(
   if (projective_layer_type() == ProjectiveLayerType::kTsdfWithFreespace &&
       layer_type_bitmask & LayerType::kFreespace) {
     layer_streamers_.serializeAllBlocks(
-        freespace_layer(), serializedTsdfLayer()->block_indices, *cuda_stream_);
+        freespace_layer(), serializedTsdfLayer()->block_indices, cuda_stream);
     CHECK_EQ(serializedFreespaceLayer()->block_indices.size(),
              serializedColorLayer()->block_indices.size());
   }
 }
 
+void Mapper::serializePrioritizedMeshBlocks(
+    const std::vector<Index3D>& blocks_to_serialize,
+    const BlockExclusionParams& exclusion_params,
+    const CudaStream& cuda_stream) {
+  timing::Timer timer("mapper/serialize_prioritized_mesh_blocks");
+  MeshLayerStreamerViewPriority& streamer = prioritizedMeshStreamer();
+  // Blocks which are not streamed in this call stay candidates, gaining
+  // priority with each call they wait.
+  streamer.markIndicesCandidates(blocks_to_serialize);
+  if (exclusion_params.exclusion_center_m.has_value()) {
+    streamer.setRobotPosition(exclusion_params.exclusion_center_m.value());
+  }
+  streamer.setupExclusionFunctors(exclusion_params);
+  streamer.getNBytesOfSerializedBlocks(
+      static_cast<size_t>(mesh_streaming_max_bytes_per_publish_), mesh_layer(),
+      cuda_stream);
+}
+
+void Mapper::queryLayers(const device_vector<Vector3f>& positions_L,
+                         const LayerTypeBitMask layer_type_bitmask,
+                         MultiLayerQueryResults* results) const {
+  queryLayersGPU(layers_, positions_L, layer_type_bitmask, results,
+                 *cuda_stream_);
+}
+
 void Mapper::serializeSelectedLayers(
     const LayerTypeBitMask layer_type_bitmask, const float bandwidth_limit_mbps,
     const BlockExclusionParams& exclusion_params) {
@@ -882,46 +2737,103 @@ void Mapper::serializeSelectedLayers(
       blocks_to_update_tracker_.getBlocksToUpdate(
           BlocksToUpdateType::kLayerStreamer);
 
+  // The mesh streaming ROIs track their candidates independently of the
+  // layers selected for streaming.
+  layer_streamers_.getPtr<MeshLayer>()->markIndicesRoiCandidates(
+      blocks_to_serialize);
+
+  // Collect the serialization of each layer as a task, such that the tasks can
+  // be run in sequence or concurrently.
+  using SerializationTask = std::function<void(const CudaStream&)>;
+  std::vector<SerializationTask> tasks;
+
   // Color layer is handled separately since we also need to serialize geometry
   // blocks in order to visualize it.
   if (layer_type_bitmask & LayerType::kColor) {
-    serializeColorTsdfAndFreespaceLayers(
-        blocks_to_serialize, layer_type_bitmask, bandwidth_limit_mbps,
-        exclusion_params);
+    // The color and freespace layers use the TSDF blocks, so this is a single
+    // task.
+    tasks.push_back([&](const CudaStream& cuda_stream) {
+      serializeColorTsdfAndFreespaceLayers(
+          blocks_to_serialize, layer_type_bitmask, bandwidth_limit_mbps,
+          exclusion_params, cuda_stream);
+    });
   } else {
     // Mesh
     if (layer_type_bitmask & LayerType::kMesh) {
-      layer_streamers_.estimateBandwidthAndSerialize(
-          mesh_layer(), blocks_to_serialize, "mesh", exclusion_params,
-          bandwidth_limit_mbps, *cuda_stream_);
+      if (mesh_streaming_max_bytes_per_publish_ > 0) {
+        tasks.push_back([&](const CudaStream& cuda_stream) {
+          serializePrioritizedMeshBlocks(blocks_to_serialize, exclusion_params,
+                                         cuda_stream);
+        });
+      } else {
+        tasks.push_back([&](const CudaStream& cuda_stream) {
+          layer_streamers_.estimateBandwidthAndSerialize(
+              mesh_layer(), blocks_to_serialize, "mesh", exclusion_params,
+              bandwidth_limit_mbps, cuda_stream);
+        });
+      }
     }
 
     // TSDF layer
     if (layer_type_bitmask & LayerType::kTsdf) {
-      layer_streamers_.estimateBandwidthAndSerialize(
-          tsdf_layer(), blocks_to_serialize, "tsdf", exclusion_params,
-          bandwidth_limit_mbps, *cuda_stream_);
+      tasks.push_back([&](const CudaStream& cuda_stream) {
+        layer_streamers_.estimateBandwidthAndSerialize(
+            tsdf_layer(), blocks_to_serialize, "tsdf", exclusion_params,
+            bandwidth_limit_mbps, cuda_stream);
+      });
     }
 
     // ESDF layer
     if (layer_type_bitmask & LayerType::kEsdf) {
-      layer_streamers_.estimateBandwidthAndSerialize(
-          esdf_layer(), blocks_to_serialize, "esdf", exclusion_params,
-          bandwidth_limit_mbps, *cuda_stream_);
+      tasks.push_back([&](const CudaStream& cuda_stream) {
+        layer_streamers_.estimateBandwidthAndSerialize(
+            esdf_layer(), blocks_to_serialize, "esdf", exclusion_params,
+            bandwidth_limit_mbps, cuda_stream);
+      });
     }
 
     // Occupancy layer
     if (layer_type_bitmask & LayerType::kOccupancy) {
-      layer_streamers_.estimateBandwidthAndSerialize(
-          occupancy_layer(), blocks_to_serialize, "occupancy", exclusion_params,
-          bandwidth_limit_mbps, *cuda_stream_);
+      tasks.push_back([&](const CudaStream& cuda_stream) {
+        layer_streamers_.estimateBandwidthAndSerialize(
+            occupancy_layer(), blocks_to_serialize, "occupancy",
+            exclusion_params, bandwidth_limit_mbps, cuda_stream);
+      });
     }
 
     // Freespace layer
     if (layer_type_bitmask & LayerType::kFreespace) {
-      layer_streamers_.estimateBandwidthAndSerialize(
-          freespace_layer(), blocks_to_serialize, "freespace", exclusion_params,
-          bandwidth_limit_mbps, *cuda_stream_);
+      tasks.push_back([&](const CudaStream& cuda_stream) {
+        layer_streamers_.estimateBandwidthAndSerialize(
+            freespace_layer(), blocks_to_serialize, "freespace",
+            exclusion_params, bandwidth_limit_mbps, cuda_stream);
+      });
+    }
+  }
+
+  if (concurrent_layer_serialization_ && tasks.size() > 1) {
+    timing::Timer timer("mapper/serialize_selected_layers/concurrent");
+    // Each layer streamer synchronizes its stream (possibly several times).
+    // We therefore run each task on its own thread and stream, such that the
+    // waits of one layer don't hold up the others.
+    while (serialization_cuda_streams_.size() < tasks.size()) {
+      serialization_cuda_streams_.push_back(
+          std::make_shared<CudaStreamOwning>());
+    }
+    // The serialization streams have to wait for the mapper work.
+    serialization_start_event_.record(*cuda_stream_);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < tasks.size(); ++i) {
+      const CudaStream& task_stream = *serialization_cuda_streams_[i];
+      serialization_start_event_.streamWait(task_stream);
+      threads.push_back(std::thread(
+          [&task = tasks[i], &task_stream]() { task(task_stream); }));
+    }
+    std::for_each(threads.begin(), threads.end(),
+                  [](std::thread& t) { t.join(); });
+  } else {
+    for (const SerializationTask& task : tasks) {
+      task(*cuda_stream_);
     }
   }
 
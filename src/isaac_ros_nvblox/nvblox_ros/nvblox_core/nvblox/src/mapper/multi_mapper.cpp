@@ -15,6 +15,7 @@ limitations under the License.
 */
 #include "nvblox/mapper/multi_mapper.h"
 
+#include "nvblox/core/cuda_device.h"
 #include "nvblox/geometry/bounding_spheres.h"
 #include "nvblox/io/layer_cake_io.h"
 #include "nvblox/mapper/internal/mapper_common.h"
@@ -62,10 +63,16 @@ ProjectiveLayerType findForegroundLayerType(MappingType mapping_type) {
 
 MultiMapper::MultiMapper(float voxel_size_m, MappingType mapping_type,
                          EsdfMode esdf_mode, MemoryType memory_type,
-                         std::shared_ptr<CudaStream> cuda_stream)
+                         std::shared_ptr<CudaStream> cuda_stream,
+                         std::optional<int> foreground_cuda_device)
     : mapping_type_(mapping_type),
       esdf_mode_(esdf_mode),
-      dynamic_detector_(cuda_stream),
+      voxel_size_m_(voxel_size_m),
+      memory_type_(memory_type),
+      foreground_memory_type_(memory_type),
+      dynamic_detector_(std::make_shared<CudaStreamOwning>()),
+      foreground_cuda_device_(
+          foreground_cuda_device.value_or(getCurrentCudaDevice())),
       mask_preprocessor_(cuda_stream),
       ground_plane_estimator_(cuda_stream),
       cuda_stream_(cuda_stream) {
@@ -75,17 +82,53 @@ MultiMapper::MultiMapper(float voxel_size_m, MappingType mapping_type,
   //   layer)
   const ProjectiveLayerType background_layer_type =
       findBackgroundLayerType(mapping_type);
-  const ProjectiveLayerType foreground_layer_type =
-      findForegroundLayerType(mapping_type);
 
   // Note that we're creating new cuda streams for the two mappers so we can
   // parallelize work on the GPU.
   background_mapper_ =
       std::make_shared<Mapper>(voxel_size_m, memory_type, background_layer_type,
                                std::make_shared<CudaStreamOwning>());
-  foreground_mapper_ =
-      std::make_shared<Mapper>(voxel_size_m, memory_type, foreground_layer_type,
-                               std::make_shared<CudaStreamOwning>());
+  const int primary_cuda_device = getCurrentCudaDevice();
+  if (foreground_cuda_device_ != primary_cuda_device) {
+    CHECK_LT(foreground_cuda_device_, getNumCudaDevices())
+        << "Requested foreground CUDA device does not exist.";
+    // The foreground mapper reads the input frames from the primary device.
+    // Without peer access this still works (with unified addressing) but
+    // the accesses are staged through the host.
+    if (!enablePeerAccess(foreground_cuda_device_, primary_cuda_device) ||
+        !enablePeerAccess(primary_cuda_device, foreground_cuda_device_)) {
+      LOG(WARNING) << "CUDA devices " << primary_cuda_device << " and "
+                   << foreground_cuda_device_
+                   << " don't support peer access. Running the foreground "
+                      "mapper on another device will be slow.";
+    }
+  }
+  createForegroundMapper(voxel_size_m, memory_type);
+}
+
+MultiMapper::~MultiMapper() {
+  if (foreground_worker_.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(foreground_work_mutex_);
+      stop_foreground_worker_ = true;
+    }
+    foreground_work_condition_.notify_all();
+    foreground_worker_.join();
+  }
+}
+
+void MultiMapper::createForegroundMapper(float voxel_size_m,
+                                         MemoryType memory_type) {
+  {
+    ScopedCudaDevice scoped_device(foreground_cuda_device_);
+    foreground_mapper_ = std::make_shared<Mapper>(
+        voxel_size_m, memory_type, findForegroundLayerType(mapping_type_),
+        std::make_shared<CudaStreamOwning>());
+    if (foreground_mapper_params_) {
+      foreground_mapper_->setMapperParams(foreground_mapper_params_.value());
+    }
+  }
+  foreground_memory_type_ = memory_type;
 
   // NOTE(alexmillane): Right now we don't consider the mask state when
   // determining the blocks in view in the integrators. For this reason we're
@@ -93,7 +136,8 @@ MultiMapper::MultiMapper(float voxel_size_m, MappingType mapping_type,
   // provides a significant performance boost. However, if the situation changes
   // in the future, and we start to consider the masks for viewpoint
   // calculations, we should not share caches, because it will lead to incorrect
-  // results.
+  // results. Mappers of different voxel sizes can share caches too, as the
+  // cached views are keyed by block size.
 
   // Make the camera integrators share the same viewpoint cache.
   shareViewpointCaches(&foreground_mapper_->tsdf_integrator(),       // NOLINT
@@ -113,6 +157,28 @@ MultiMapper::MultiMapper(float voxel_size_m, MappingType mapping_type,
 void MultiMapper::setMultiMapperParams(
     const MultiMapperParams& multi_mapper_params) {
   params_ = multi_mapper_params;
+  const float foreground_voxel_size_m =
+      params_.foreground_voxel_size_m > 0.0f
+          ? params_.foreground_voxel_size_m.get()
+          : voxel_size_m_;
+  const MemoryType foreground_memory_type =
+      params_.foreground_use_device_memory ? MemoryType::kDevice
+                                           : memory_type_;
+  if (foreground_voxel_size_m != foreground_mapper_->voxel_size_m() ||
+      foreground_memory_type != foreground_memory_type_) {
+    CHECK_GE(foreground_voxel_size_m, voxel_size_m_)
+        << "The foreground mapper can't be finer than the background mapper.";
+    LOG_IF(WARNING, foreground_mapper_->occupancy_layer().numAllocatedBlocks() >
+                        0)
+        << "Changing the foreground voxel size or memory type drops the "
+           "foreground map.";
+    createForegroundMapper(foreground_voxel_size_m, foreground_memory_type);
+  }
+  // The ground plane is updated from the background blocks changed since the
+  // last update. (Re)starting tracking invalidates the cached crossings.
+  background_mapper_->trackGroundPlaneBlocks(
+      params_.use_ground_plane_estimation);
+  ground_plane_estimator().resetCache();
   ground_plane_estimator().ground_points_candidates_min_z_m(
       params_.ground_plane_estimator_params.ground_points_candidates_min_z_m);
   ground_plane_estimator().ground_points_candidates_max_z_m(
@@ -128,6 +194,8 @@ void MultiMapper::setMapperParams(
     const std::optional<MapperParams>& foreground_mapper_params) {
   background_mapper_->setMapperParams(background_mapper_params);
   if (foreground_mapper_params) {
+    foreground_mapper_params_ = foreground_mapper_params;
+    ScopedCudaDevice scoped_device(foreground_cuda_device_);
     foreground_mapper_->setMapperParams(foreground_mapper_params.value());
   }
 }
@@ -172,35 +240,25 @@ void MultiMapper::integrateDepth(const DepthImage& depth_frame,
     {  // Block 1
       timing::Timer timer("multi_mapper/integrate_depth/dynamic_block1");
 
-      // TODO(dtingdahl) Reduce overhead by recycling threads instead of
-      // re-creating them.
-      std::vector<std::thread> threads;
-
-      // Integrate TSDF
-      threads.push_back(std::thread([&]() {
-        background_mapper_->integrateDepth(depth_frame, T_L_CD, depth_camera);
-      }));
-
       // Compute dynamic mask. Note that we're using the freespace layer
       // computed during the previous update. This should be fine since the
-      // freespace layer is designed to reacting slow to changes.
-      threads.push_back(std::thread([&]() {
-        dynamic_detector_.computeDynamics(depth_frame,
-                                          background_mapper_->freespace_layer(),
-                                          depth_camera, T_L_CD);
-      }));
-
-      // sync threads
-      std::for_each(threads.begin(), threads.end(),
-                    [](std::thread& t) { t.join(); });
-      threads.clear();
+      // freespace layer is designed to reacting slow to changes. The
+      // detection runs asynchronously on its own stream, overlapping with the
+      // TSDF integration below.
+      dynamic_detector_.computeDynamicsAsync(
+          depth_frame, background_mapper_->freespace_layer(), depth_camera,
+          T_L_CD);
+
+      // Integrate TSDF
+      background_mapper_->integrateDepth(depth_frame, T_L_CD, depth_camera);
     }
 
     {  // Block 2 (This block is launched synchronously since there is ony one
        // call)
       timing::Timer timer("multi_mapper/integrate_depth/dynamic_block2");
 
-      // Update dynamic mask
+      // Update dynamic mask, once the detection is done.
+      dynamic_detector_.waitForOutputs(*cuda_stream_);
       const MonoImage& dynamic_mask = dynamic_detector_.getDynamicMaskImage();
 
       // Remove small components (assumed to be noise) from the mask
@@ -211,28 +269,23 @@ void MultiMapper::integrateDepth(const DepthImage& depth_frame,
       } else {
         cleaned_dynamic_mask_.copyFromAsync(dynamic_mask, *cuda_stream_);
       }
+      // Block 3 reads the cleaned mask and writes the freespace layer read by
+      // the detection on other streams.
+      cuda_stream_->synchronize();
     }
 
-    // Block 3
+    // Block 3: update the freespace and the (foreground) occupancy.
     timing::Timer timer("multi_mapper/integrate_depth/dynamic_block3");
-    std::vector<std::thread> threads;
-
-    // Update occupancy
-    threads.push_back(std::thread([&]() {
-      foreground_mapper_->integrateDepth(
-          MaskedDepthImageConstView(depth_frame, cleaned_dynamic_mask_), T_L_CD,
-          depth_camera);
-    }));
-
-    // Update freespace.
-    threads.push_back(std::thread([&]() {  // NOLINT
-      background_mapper_->updateFreespace(update_time_ms.value(), T_L_CD,
-                                          depth_camera, depth_frame);
-    }));
-
-    // sync threads
-    std::for_each(threads.begin(), threads.end(),
-                  [](std::thread& t) { t.join(); });
+    runOnBothMappers(
+        [&]() {
+          background_mapper_->updateFreespace(update_time_ms.value(), T_L_CD,
+                                              depth_camera, depth_frame);
+        },
+        [&]() {
+          foreground_mapper_->integrateDepth(
+              MaskedDepthImageConstView(depth_frame, cleaned_dynamic_mask_),
+              T_L_CD, depth_camera);
+        });
   }
 }
 
@@ -259,11 +312,42 @@ void MultiMapper::integrateDepth(const DepthImage& depth_frame,
       &depth_frame_background_, &depth_frame_foreground_,
       &foreground_depth_overlay_);
 
+  const std::optional<ForegroundDepthFrame> foreground_frame =
+      getForegroundDepthFrameForIntegration(depth_camera);
+
   // Integrate the frames to the respective layer cake
-  background_mapper_->integrateDepth(depth_frame_background_, T_L_CD,
-                                     depth_camera);
-  foreground_mapper_->integrateDepth(depth_frame_foreground_, T_L_CD,
-                                     depth_camera);
+  runOnBothMappers(
+      [&]() {
+        background_mapper_->integrateDepth(depth_frame_background_, T_L_CD,
+                                           depth_camera);
+      },
+      [&]() {
+        if (foreground_frame) {
+          foreground_mapper_->integrateDepth(*foreground_frame->depth_frame,
+                                             T_L_CD, foreground_frame->camera);
+        }
+      });
+}
+
+std::optional<MultiMapper::ForegroundDepthFrame>
+MultiMapper::getForegroundDepthFrameForIntegration(const Camera& depth_camera) {
+  if (!params_.crop_foreground_depth_to_mask) {
+    return ForegroundDepthFrame{&depth_frame_foreground_, depth_camera};
+  }
+  // Unmasked pixels have invalid depth in the foreground frame. They don't
+  // update the foreground layer, so we can skip them altogether, including
+  // the blocks only they see.
+  const ImageBoundingBox bbox = image::getValidDepthBoundingBoxGPU(
+      depth_frame_foreground_, *cuda_stream_);
+  if (bbox.isEmpty()) {
+    return std::nullopt;
+  }
+  image::cropGPUAsync(depth_frame_foreground_, bbox,
+                      &depth_frame_foreground_cropped_, *cuda_stream_);
+  // The foreground mapper integrates on its own stream.
+  cuda_stream_->synchronize();
+  return ForegroundDepthFrame{&depth_frame_foreground_cropped_,
+                              depth_camera.cropped(bbox)};
 }
 
 void MultiMapper::integrateDepth(
@@ -285,6 +369,59 @@ void MultiMapper::integrateDepth(
                  depth_camera, detection_boxes_camera);
 }
 
+void MultiMapper::integrateDepthAndColor(
+    const DepthImage& depth_frame, const ColorImage& color_frame,
+    const MonoImage& mask, const Transform& T_L_CD, const Transform& T_L_C,
+    const Transform& T_CM_CD, const Camera& depth_camera,
+    const Camera& color_camera) {
+  CHECK(isHumanMapping(mapping_type_))
+      << "Passing a mask to integrateDepthAndColor is only valid for human "
+         "mapping.";
+  if (mapping_type_ == MappingType::kHumanWithStaticOccupancy) {
+    // Color integration is only implemented for static tsdf.
+    integrateDepth(depth_frame, mask, T_L_CD, T_CM_CD, depth_camera,
+                   color_camera);
+    return;
+  }
+
+  // Remove small components (assumed to be noise) from the mask
+  if (params_.remove_small_connected_components) {
+    mask_preprocessor_.removeSmallConnectedComponents(
+        mask, params_.connected_mask_component_size_threshold,
+        &cleaned_semantic_mask_);
+  } else {
+    cleaned_semantic_mask_.copyFromAsync(mask, *cuda_stream_);
+  }
+  // Split into foreground and background depth and color frames
+  image_masker_.splitImagesOnGPU(
+      depth_frame, color_frame, cleaned_semantic_mask_, T_CM_CD, depth_camera,
+      color_camera, &depth_frame_background_, &depth_frame_foreground_,
+      &color_frame_background_, &color_frame_foreground_,
+      &foreground_depth_overlay_, &foreground_color_overlay_);
+
+  const std::optional<ForegroundDepthFrame> foreground_frame =
+      getForegroundDepthFrameForIntegration(depth_camera);
+
+  // Integrate the frames to the respective layer cake
+  runOnBothMappers(
+      [&]() {
+        background_mapper_->integrateDepth(depth_frame_background_, T_L_CD,
+                                           depth_camera);
+        background_mapper_->integrateColor(color_frame_background_, T_L_C,
+                                           color_camera);
+      },
+      [&]() {
+        if (foreground_frame) {
+          foreground_mapper_->integrateDepth(*foreground_frame->depth_frame,
+                                             T_L_CD, foreground_frame->camera);
+        }
+        if (!params_.foreground_occupancy_only) {
+          foreground_mapper_->integrateColor(color_frame_foreground_, T_L_C,
+                                             color_camera);
+        }
+      });
+}
+
 void MultiMapper::integrateColor(const ColorImage& color_frame,
                                  const Transform& T_L_C, const Camera& camera) {
   // TODO(remos): For kDynamic we should split the image and only integrate
@@ -322,25 +459,87 @@ void MultiMapper::integrateColor(const ColorImage& color_frame,
       &color_frame_foreground_, &foreground_color_overlay_);
 
   // Integrate the frames to the respective layer cake
-  foreground_mapper_->integrateColor(color_frame_foreground_, T_L_C, camera);
-  background_mapper_->integrateColor(color_frame_background_, T_L_C, camera);
+  runOnBothMappers(
+      [&]() {
+        background_mapper_->integrateColor(color_frame_background_, T_L_C,
+                                           camera);
+      },
+      [&]() {
+        if (!params_.foreground_occupancy_only) {
+          foreground_mapper_->integrateColor(color_frame_foreground_, T_L_C,
+                                             camera);
+        }
+      });
 }
 
 void MultiMapper::updateEsdf() {
   std::optional<Plane> maybe_ground_plane = std::nullopt;
   if (params_.use_ground_plane_estimation) {
     // We compute the ground plane on the static map to reuse on the dynamic
-    // map.
+    // map. Only the crossings of the blocks changed since the last update are
+    // recomputed.
     const TsdfLayer& tsdf_layer = background_mapper_->tsdf_layer();
-    maybe_ground_plane = ground_plane_estimator_.computeGroundPlane(tsdf_layer);
+    maybe_ground_plane = ground_plane_estimator_.computeGroundPlane(
+        tsdf_layer, background_mapper_->getGroundPlaneBlocksToUpdate());
   }
 
-  updateEsdfOfMapper(background_mapper_, maybe_ground_plane);
-  if (foreground_mapper_->projective_layer_type() !=
+  if (foreground_mapper_->projective_layer_type() ==
       ProjectiveLayerType::kNone) {
     // Only update the foreground mapper in case we run dynamics or human
     // detection
-    updateEsdfOfMapper(foreground_mapper_, maybe_ground_plane);
+    updateEsdfOfMapper(background_mapper_, maybe_ground_plane);
+    return;
+  }
+  runOnBothMappers(
+      [&]() { updateEsdfOfMapper(background_mapper_, maybe_ground_plane); },
+      [&]() { updateEsdfOfMapper(foreground_mapper_, maybe_ground_plane); });
+}
+
+void MultiMapper::runOnBothMappers(
+    const std::function<void()>& background_work,
+    const std::function<void()>& foreground_work) {
+  if (!parallel_mapper_updates_) {
+    background_work();
+    ScopedCudaDevice scoped_device(foreground_cuda_device_);
+    foreground_work();
+    return;
+  }
+  if (!foreground_worker_.joinable()) {
+    foreground_worker_ = std::thread(&MultiMapper::runForegroundWorker, this);
+  }
+  // Carry the frame over to the worker.
+  const timing::FrameId frame_id = timing::currentFrameId();
+  const std::function<void()> foreground_work_in_frame = [&]() {
+    timing::ScopedFrameId scoped_frame_id(frame_id);
+    foreground_work();
+  };
+  {
+    std::lock_guard<std::mutex> lock(foreground_work_mutex_);
+    foreground_work_ = &foreground_work_in_frame;
+  }
+  foreground_work_condition_.notify_all();
+  background_work();
+  // The worker resets the work once it's done.
+  std::unique_lock<std::mutex> lock(foreground_work_mutex_);
+  foreground_work_condition_.wait(lock,
+                                  [this]() { return !foreground_work_; });
+}
+
+void MultiMapper::runForegroundWorker() {
+  ScopedCudaDevice scoped_device(foreground_cuda_device_);
+  std::unique_lock<std::mutex> lock(foreground_work_mutex_);
+  while (true) {
+    foreground_work_condition_.wait(lock, [this]() {
+      return foreground_work_ || stop_foreground_worker_;
+    });
+    if (stop_foreground_worker_) {
+      return;
+    }
+    lock.unlock();
+    (*foreground_work_)();
+    lock.lock();
+    foreground_work_ = nullptr;
+    foreground_work_condition_.notify_all();
   }
 }
 
@@ -379,6 +578,7 @@ const ColorImage& MultiMapper::getLastColorFrameMaskOverlay() {
   return foreground_color_overlay_;
 }
 const ColorImage& MultiMapper::getLastDynamicFrameMaskOverlay() {
+  dynamic_detector_.synchronizeOutputs();
   return dynamic_detector_.getDynamicOverlayImage();
 }
 const Pointcloud& MultiMapper::getLastDynamicPointcloud() {
@@ -407,6 +607,14 @@ parameters::ParameterTreeNode MultiMapper::getParameterTree(
   return ParameterTreeNode(
       name, {ParameterTreeNode("connected_mask_component_size_threshold",
                                params_.connected_mask_component_size_threshold),
+             ParameterTreeNode("crop_foreground_depth_to_mask",
+                               params_.crop_foreground_depth_to_mask),
+             ParameterTreeNode("foreground_voxel_size_m",
+                               params_.foreground_voxel_size_m),
+             ParameterTreeNode("foreground_occupancy_only",
+                               params_.foreground_occupancy_only),
+             ParameterTreeNode("foreground_use_device_memory",
+                               params_.foreground_use_device_memory),
              background_mapper_->getParameterTree("background_mapper"),
              foreground_mapper_->getParameterTree("foreground_mapper"),
              image_masker_.getParameterTree(),
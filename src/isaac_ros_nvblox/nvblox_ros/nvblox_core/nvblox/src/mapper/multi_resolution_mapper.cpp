@@ -0,0 +1,182 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "nvblox/mapper/multi_resolution_mapper.h"
+
+#include "nvblox/geometry/bounding_spheres.h"
+
+namespace nvblox {
+
+MultiResolutionMapper::MultiResolutionMapper(
+    float voxel_size_m, int coarse_voxel_size_factor,
+    ProjectiveLayerType projective_layer_type, MemoryType memory_type,
+    std::shared_ptr<CudaStream> cuda_stream)
+    : cuda_stream_(cuda_stream) {
+  CHECK_GT(coarse_voxel_size_factor, 0);
+  // Note that we're creating new cuda streams for the two mappers so we can
+  // parallelize work on the GPU.
+  fine_mapper_ = std::make_shared<Mapper>(voxel_size_m, memory_type,
+                                          projective_layer_type,
+                                          std::make_shared<CudaStreamOwning>());
+  coarse_mapper_ = std::make_shared<Mapper>(
+      voxel_size_m * coarse_voxel_size_factor, memory_type,
+      projective_layer_type, std::make_shared<CudaStreamOwning>());
+  setIntegrationDistances();
+}
+
+void MultiResolutionMapper::setMultiResolutionMapperParams(
+    const MultiResolutionMapperParams& params) {
+  CHECK_GT(params.fine_level_max_integration_distance_m, 0.0f);
+  CHECK_GT(params.coarse_level_max_integration_distance_m, 0.0f);
+  CHECK_GT(params.coarse_level_depth_downscale_factor, 0);
+  CHECK_GT(params.fine_level_coarsening_max_second_difference_m, 0.0f);
+  params_ = params;
+  setIntegrationDistances();
+}
+
+void MultiResolutionMapper::setMapperParams(
+    const MapperParams& fine_mapper_params,
+    const std::optional<MapperParams>& coarse_mapper_params) {
+  fine_mapper_->setMapperParams(fine_mapper_params);
+  coarse_mapper_->setMapperParams(
+      coarse_mapper_params.value_or(fine_mapper_params));
+  setIntegrationDistances();
+}
+
+void MultiResolutionMapper::setIntegrationDistances() {
+  const float fine_distance_m = params_.fine_level_max_integration_distance_m;
+  fine_mapper_->tsdf_integrator().max_integration_distance_m(fine_distance_m);
+  fine_mapper_->occupancy_integrator().max_integration_distance_m(
+      fine_distance_m);
+  fine_mapper_->color_integrator().max_integration_distance_m(fine_distance_m);
+
+  const float coarse_distance_m =
+      params_.coarse_level_max_integration_distance_m;
+  coarse_mapper_->tsdf_integrator().max_integration_distance_m(
+      coarse_distance_m);
+  coarse_mapper_->occupancy_integrator().max_integration_distance_m(
+      coarse_distance_m);
+}
+
+Camera MultiResolutionMapper::getDownscaledCamera(const Camera& camera,
+                                                  int factor) {
+  CHECK_GT(factor, 0);
+  // Pixel i of the downscaled image is pixel (i * factor) of the full image.
+  // Matching the pixel centers gives u' = (u - 0.5) / factor + 0.5.
+  const float inv_factor = 1.0f / static_cast<float>(factor);
+  return camera.withIntrinsics(camera.fu() * inv_factor,
+                               camera.fv() * inv_factor,
+                               (camera.cu() - 0.5f) * inv_factor + 0.5f,
+                               (camera.cv() - 0.5f) * inv_factor + 0.5f,
+                               camera.width() / factor,
+                               camera.height() / factor);
+}
+
+void MultiResolutionMapper::integrateDepth(const DepthImage& depth_frame,
+                                           const Transform& T_L_C,
+                                           const Camera& camera) {
+  fine_mapper_->integrateDepth(depth_frame, T_L_C, camera);
+
+  const int factor = params_.coarse_level_depth_downscale_factor;
+  if (factor == 1) {
+    coarse_mapper_->integrateDepth(depth_frame, T_L_C, camera);
+    return;
+  }
+  image::naiveDownscaleGPUAsync(depth_frame, factor, &depth_frame_coarse_,
+                                *cuda_stream_);
+  cuda_stream_->synchronize();
+  coarse_mapper_->integrateDepth(depth_frame_coarse_, T_L_C,
+                                 getDownscaledCamera(camera, factor));
+}
+
+void MultiResolutionMapper::integrateColor(const ColorImage& color_frame,
+                                           const Transform& T_L_C,
+                                           const Camera& camera) {
+  fine_mapper_->integrateColor(color_frame, T_L_C, camera);
+}
+
+void MultiResolutionMapper::updateEsdf() {
+  fine_mapper_->updateEsdf();
+  coarse_mapper_->updateEsdf();
+}
+
+void MultiResolutionMapper::updateEsdfSlice() {
+  fine_mapper_->updateEsdfSlice();
+  coarse_mapper_->updateEsdfSlice();
+}
+
+void MultiResolutionMapper::updateMesh() {
+  fine_mapper_->updateMesh();
+  coarse_mapper_->updateMesh();
+}
+
+std::vector<Index3D> MultiResolutionMapper::coarsenFineLevel(
+    const Vector3f& robot_position_L) {
+  if (!params_.coarsen_fine_level ||
+      !fine_mapper_->layers().exists<TsdfLayer>() ||
+      !coarse_mapper_->layers().exists<TsdfLayer>()) {
+    return {};
+  }
+  // Only blocks which the fine level no longer integrates are candidates.
+  // Blocks that come back in range are re-allocated by the fine level.
+  const TsdfLayer& fine_tsdf = fine_mapper_->tsdf_layer();
+  const TsdfLayer& coarse_tsdf = coarse_mapper_->tsdf_layer();
+  const std::vector<Index3D> out_of_range_blocks = getBlocksOutsideRadius(
+      fine_tsdf.getAllBlockIndices(), fine_tsdf.block_size(), robot_position_L,
+      params_.fine_level_max_integration_distance_m);
+
+  // Never drop fine data where the coarse level has nothing to fall back to.
+  std::vector<Index3D> candidate_blocks;
+  candidate_blocks.reserve(out_of_range_blocks.size());
+  for (const Index3D& block_idx : out_of_range_blocks) {
+    const Vector3f block_center_L =
+        getCenterPositionFromBlockIndex(fine_tsdf.block_size(), block_idx);
+    if (coarse_tsdf.getBlockAtPosition(block_center_L)) {
+      candidate_blocks.push_back(block_idx);
+    }
+  }
+
+  const std::vector<Index3D> smooth_blocks =
+      getSmoothFineBlocks(candidate_blocks);
+  fine_mapper_->clearBlocks(smooth_blocks);
+  return smooth_blocks;
+}
+
+parameters::ParameterTreeNode MultiResolutionMapper::getParameterTree(
+    const std::string& name_remap) const {
+  using parameters::ParameterTreeNode;
+  const std::string name =
+      (name_remap.empty()) ? "multi_resolution_mapper" : name_remap;
+  return ParameterTreeNode(
+      name,
+      {ParameterTreeNode("fine_level_max_integration_distance_m",
+                         params_.fine_level_max_integration_distance_m),
+       ParameterTreeNode("coarse_level_max_integration_distance_m",
+                         params_.coarse_level_max_integration_distance_m),
+       ParameterTreeNode("coarse_level_depth_downscale_factor",
+                         params_.coarse_level_depth_downscale_factor),
+       ParameterTreeNode("coarsen_fine_level", params_.coarsen_fine_level),
+       ParameterTreeNode(
+           "fine_level_coarsening_max_second_difference_m",
+           params_.fine_level_coarsening_max_second_difference_m),
+       fine_mapper_->getParameterTree("fine_mapper"),
+       coarse_mapper_->getParameterTree("coarse_mapper")});
+}
+
+std::string MultiResolutionMapper::getParametersAsString() const {
+  return parameterTreeToString(getParameterTree());
+}
+
+}  // namespace nvblox
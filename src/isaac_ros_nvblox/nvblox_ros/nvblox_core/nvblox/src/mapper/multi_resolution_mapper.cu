@@ -0,0 +1,187 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "nvblox/mapper/multi_resolution_mapper.h"
+
+#include "nvblox/core/internal/error_check.h"
+#include "nvblox/integrators/internal/integrators_common.h"
+#include "nvblox/interpolation/interpolation_3d.h"
+#include "nvblox/map/internal/cuda/voxel_block_threads.cuh"
+
+namespace nvblox {
+
+// Picks the fine result where it exists, and otherwise the coarse one.
+__global__ void combineLevelsKernel(int num_points,
+                                    const float* fine_distances_vox,
+                                    const bool* fine_success_flags,
+                                    float fine_voxel_size_m,
+                                    const float* coarse_distances_vox,
+                                    const bool* coarse_success_flags,
+                                    float coarse_voxel_size_m,
+                                    float* distances_m, bool* success_flags) {
+  const int idx = threadIdx.x + blockIdx.x * blockDim.x;
+  if (idx >= num_points) {
+    return;
+  }
+  if (fine_success_flags[idx]) {
+    distances_m[idx] = fine_distances_vox[idx] * fine_voxel_size_m;
+    success_flags[idx] = true;
+  } else if (coarse_success_flags[idx]) {
+    distances_m[idx] = coarse_distances_vox[idx] * coarse_voxel_size_m;
+    success_flags[idx] = true;
+  } else {
+    distances_m[idx] = 0.0f;
+    success_flags[idx] = false;
+  }
+}
+
+// Whether the TSDF is (approximately) linear around a voxel along one axis.
+// Triples including unobserved or truncated voxels don't constrain the
+// surface and are skipped.
+__device__ inline bool isSecondDifferenceSmall(const TsdfVoxel& previous,
+                                               const TsdfVoxel& current,
+                                               const TsdfVoxel& next,
+                                               float min_weight,
+                                               float max_distance_m,
+                                               float max_second_difference_m) {
+  const TsdfVoxel* voxels[3] = {&previous, &current, &next};
+  for (const TsdfVoxel* voxel : voxels) {
+    if (voxel->weight < min_weight ||
+        fabsf(voxel->distance) >= max_distance_m) {
+      return true;
+    }
+  }
+  return fabsf(previous.distance + next.distance - 2.0f * current.distance) <=
+         max_second_difference_m;
+}
+
+// Checks one block per thread block. A block is smooth if the second
+// difference of the TSDF along all axes is small at all interior voxels.
+__global__ void checkBlocksSmoothKernel(const TsdfBlock** blocks,
+                                        float min_weight, float max_distance_m,
+                                        float max_second_difference_m,
+                                        bool* is_smooth) {
+  __shared__ bool block_is_smooth;
+  if (threadIdx.x == 0 && threadIdx.y == 0 && threadIdx.z == 0) {
+    block_is_smooth = true;
+  }
+  __syncthreads();
+
+  constexpr int kVoxelsPerSide = TsdfBlock::kVoxelsPerSide;
+  const TsdfBlock* block = blocks[blockIdx.x];
+  forEachVoxelInThread([&](const Index3D& voxel_idx) {
+    for (int axis = 0; axis < 3; axis++) {
+      if (voxel_idx[axis] == 0 || voxel_idx[axis] == kVoxelsPerSide - 1) {
+        continue;
+      }
+      Index3D previous_idx = voxel_idx;
+      previous_idx[axis] -= 1;
+      Index3D next_idx = voxel_idx;
+      next_idx[axis] += 1;
+      if (!isSecondDifferenceSmall(
+              block->voxels[previous_idx.x()][previous_idx.y()]
+                           [previous_idx.z()],
+              block->voxels[voxel_idx.x()][voxel_idx.y()][voxel_idx.z()],
+              block->voxels[next_idx.x()][next_idx.y()][next_idx.z()],
+              min_weight, max_distance_m, max_second_difference_m)) {
+        // Benign race: all writers write false.
+        block_is_smooth = false;
+      }
+    }
+  });
+
+  __syncthreads();
+  if (threadIdx.x == 0 && threadIdx.y == 0 && threadIdx.z == 0) {
+    is_smooth[blockIdx.x] = block_is_smooth;
+  }
+}
+
+std::vector<Index3D> MultiResolutionMapper::getSmoothFineBlocks(
+    const std::vector<Index3D>& block_indices) {
+  if (block_indices.empty()) {
+    return {};
+  }
+  const TsdfLayer& fine_tsdf = fine_mapper_->tsdf_layer();
+  const int num_blocks = block_indices.size();
+  fine_block_ptrs_device_.copyFromAsync(
+      getBlockPtrsFromIndices(block_indices, fine_tsdf), *cuda_stream_);
+  fine_block_is_smooth_device_.resizeAsync(num_blocks, *cuda_stream_);
+
+  // Voxels close to the truncation distance are often clipped and hence
+  // not linear in the distance to the surface.
+  constexpr float kTruncationMargin = 0.99f;
+  const float max_distance_m =
+      kTruncationMargin *
+      fine_mapper_->tsdf_integrator().get_truncation_distance_m(
+          fine_tsdf.voxel_size());
+  checkBlocksSmoothKernel<<<num_blocks, voxelBlockThreadsPerBlock(), 0,
+                            *cuda_stream_>>>(
+      fine_block_ptrs_device_.data(),                         // NOLINT
+      fine_mapper_->esdf_integrator().min_weight(),           // NOLINT
+      max_distance_m,                                         // NOLINT
+      params_.fine_level_coarsening_max_second_difference_m,  // NOLINT
+      fine_block_is_smooth_device_.data());
+  checkCudaErrors(cudaPeekAtLastError());
+  fine_block_is_smooth_host_.copyFromAsync(fine_block_is_smooth_device_,
+                                           *cuda_stream_);
+  cuda_stream_->synchronize();
+
+  std::vector<Index3D> smooth_blocks;
+  for (int i = 0; i < num_blocks; i++) {
+    if (fine_block_is_smooth_host_[i]) {
+      smooth_blocks.push_back(block_indices[i]);
+    }
+  }
+  return smooth_blocks;
+}
+
+void MultiResolutionMapper::getEsdfDistances(
+    const device_vector<Vector3f>& points_L, device_vector<float>* distances_m,
+    device_vector<bool>* success_flags) {
+  CHECK_NOTNULL(distances_m);
+  CHECK_NOTNULL(success_flags);
+  const int num_points = points_L.size();
+  distances_m->resizeAsync(num_points, *cuda_stream_);
+  success_flags->resizeAsync(num_points, *cuda_stream_);
+  if (num_points == 0) {
+    cuda_stream_->synchronize();
+    return;
+  }
+
+  // Look up all points in both levels.
+  interpolation::interpolateOnGPUAsync(points_L, fine_mapper_->esdf_layer(),
+                                       &fine_distances_vox_, nullptr,
+                                       &fine_success_flags_, *cuda_stream_);
+  interpolation::interpolateOnGPUAsync(
+      points_L, coarse_mapper_->esdf_layer(), &coarse_distances_vox_, nullptr,
+      &coarse_success_flags_, *cuda_stream_);
+
+  constexpr int kNumThreads = 512;
+  const int num_blocks = num_points / kNumThreads + 1;
+  combineLevelsKernel<<<num_blocks, kNumThreads, 0, *cuda_stream_>>>(
+      num_points,                                 // NOLINT
+      fine_distances_vox_.data(),                 // NOLINT
+      fine_success_flags_.data(),                 // NOLINT
+      fine_mapper_->esdf_layer().voxel_size(),    // NOLINT
+      coarse_distances_vox_.data(),               // NOLINT
+      coarse_success_flags_.data(),               // NOLINT
+      coarse_mapper_->esdf_layer().voxel_size(),  // NOLINT
+      distances_m->data(),                        // NOLINT
+      success_flags->data());
+  checkCudaErrors(cudaPeekAtLastError());
+  cuda_stream_->synchronize();
+}
+
+}  // namespace nvblox
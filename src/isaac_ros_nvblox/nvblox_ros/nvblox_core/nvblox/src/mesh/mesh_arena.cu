@@ -0,0 +1,317 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "nvblox/mesh/mesh_arena.h"
+
+#include <algorithm>
+
+#include "nvblox/core/internal/error_check.h"
+
+namespace nvblox {
+
+// Kernel that copies the mesh of several blocks into ranges of the shared
+// buffers.
+//
+// Number of blocks:  Must equal num_blocks.
+// Number of threads: Can be any positive value.
+//
+// @param num_blocks    Number of mesh blocks to copy
+// @param sources       The blocks to copy. Null normals/colors are replaced by
+//                      defaults. Size: num_blocks
+// @param destinations  The output range of each block. Size: num_blocks
+// @param vertices      Output shared vertices
+// @param normals       Output shared normals
+// @param colors        Output shared colors
+// @param triangles     Output shared triangle indices
+__global__ void copyBlocksToArenaKernel(const int num_blocks,
+                                        const CudaMeshBlock* sources,
+                                        const MeshArenaRange* destinations,
+                                        Vector3f* vertices,
+                                        Vector3f* normals,
+                                        Color* colors,
+                                        int* triangles) {
+  const int block_index = blockIdx.x;
+  if (block_index >= num_blocks) {
+    return;
+  }
+  const CudaMeshBlock& source = sources[block_index];
+  const MeshArenaRange& destination = destinations[block_index];
+
+  for (int i = threadIdx.x; i < source.vertices_size; i += blockDim.x) {
+    const int output_index = destination.vertex_offset + i;
+    vertices[output_index] = source.vertices[i];
+    normals[output_index] =
+        (source.normals != nullptr) ? source.normals[i] : Vector3f::Zero();
+    colors[output_index] =
+        (source.colors != nullptr) ? source.colors[i] : Color::Gray();
+  }
+  for (int i = threadIdx.x; i < source.triangles_size; i += blockDim.x) {
+    triangles[destination.triangle_offset + i] = source.triangles[i];
+  }
+}
+
+MeshArena::MeshArena() : MeshArena(std::make_shared<CudaStreamOwning>()) {}
+
+MeshArena::MeshArena(std::shared_ptr<CudaStream> cuda_stream)
+    : cuda_stream_(cuda_stream) {}
+
+void MeshArena::max_wasted_fraction(float max_wasted_fraction) {
+  CHECK_GE(max_wasted_fraction, 0.0f);
+  CHECK_LE(max_wasted_fraction, 1.0f);
+  max_wasted_fraction_ = max_wasted_fraction;
+}
+
+void MeshArena::updateBlocks(const MeshLayer& mesh_layer,
+                             const std::vector<Index3D>& block_indices) {
+  block_size_ = mesh_layer.block_size();
+  // Wait for any previous use of the staging buffers to finish.
+  cuda_stream_->synchronize();
+  source_blocks_.clearNoDeallocate();
+  destination_ranges_.clearNoDeallocate();
+
+  int32_t max_block_size = 0;
+  for (const Index3D& block_index : block_indices) {
+    const MeshBlock::ConstPtr block = mesh_layer.getBlockAtIndex(block_index);
+    auto it = ranges_.find(block_index);
+    if (block == nullptr || block->vertices.empty()) {
+      if (it != ranges_.end()) {
+        releaseRange(it->second);
+        ranges_.erase(it);
+      }
+      continue;
+    }
+
+    CudaMeshBlock source(const_cast<MeshBlock*>(block.get()));
+    if (block->normals.size() != block->vertices.size()) {
+      source.normals = nullptr;
+    }
+    if (block->colors.size() != block->vertices.size()) {
+      source.colors = nullptr;
+    }
+
+    // Use the current range if the block fits, otherwise append.
+    MeshArenaRange range;
+    if (it != ranges_.end()) {
+      range = it->second;
+      releaseRange(range);
+    }
+    if (range.vertex_capacity < source.vertices_size ||
+        range.triangle_capacity < source.triangles_size) {
+      range.vertex_offset = vertex_end_;
+      range.vertex_capacity = source.vertices_size;
+      range.triangle_offset = triangle_end_;
+      range.triangle_capacity = source.triangles_size;
+      vertex_end_ += source.vertices_size;
+      triangle_end_ += source.triangles_size;
+    }
+    range.num_vertices = source.vertices_size;
+    range.num_triangle_indices = source.triangles_size;
+    num_used_vertices_ += range.num_vertices;
+    num_used_triangle_indices_ += range.num_triangle_indices;
+    ranges_[block_index] = range;
+
+    source_blocks_.push_back(source, *cuda_stream_);
+    destination_ranges_.push_back(range, *cuda_stream_);
+    max_block_size = std::max(
+        max_block_size, std::max(source.vertices_size, source.triangles_size));
+  }
+
+  reserveBuffers(vertex_end_, triangle_end_);
+
+  const int num_blocks = source_blocks_.size();
+  constexpr int kMaxNumThreads = 512;
+  const int num_threads = std::min(max_block_size, kMaxNumThreads);
+  if (num_blocks > 0 && num_threads > 0) {
+    copyBlocksToArenaKernel<<<num_blocks, num_threads, 0, *cuda_stream_>>>(
+        num_blocks,                  // NOLINT
+        source_blocks_.data(),       // NOLINT
+        destination_ranges_.data(),  // NOLINT
+        vertices_.data(),            // NOLINT
+        normals_.data(),             // NOLINT
+        colors_.data(),              // NOLINT
+        triangles_.data());          // NOLINT
+    checkCudaErrors(cudaPeekAtLastError());
+  }
+  cuda_stream_->synchronize();
+
+  const int32_t num_wasted_vertices = vertex_end_ - num_used_vertices_;
+  if (num_wasted_vertices > max_wasted_fraction_ * vertex_end_) {
+    compact();
+  }
+}
+
+void MeshArena::removeBlocks(const std::vector<Index3D>& block_indices) {
+  for (const Index3D& block_index : block_indices) {
+    auto it = ranges_.find(block_index);
+    if (it != ranges_.end()) {
+      releaseRange(it->second);
+      ranges_.erase(it);
+    }
+  }
+}
+
+void MeshArena::compact() {
+  const std::vector<Index3D> block_indices = getAllBlockIndices();
+
+  cuda_stream_->synchronize();
+  source_blocks_.clearNoDeallocate();
+  destination_ranges_.clearNoDeallocate();
+
+  // Pack the blocks in their current order, such that ranges only ever move
+  // towards the start of the buffers.
+  int32_t vertex_offset = 0;
+  int32_t triangle_offset = 0;
+  int32_t max_block_size = 0;
+  for (const Index3D& block_index : block_indices) {
+    MeshArenaRange& range = ranges_[block_index];
+    CudaMeshBlock source;
+    source.vertices = vertices_.data() + range.vertex_offset;
+    source.normals = normals_.data() + range.vertex_offset;
+    source.colors = colors_.data() + range.vertex_offset;
+    source.triangles = triangles_.data() + range.triangle_offset;
+    source.vertices_size = range.num_vertices;
+    source.triangles_size = range.num_triangle_indices;
+
+    range.vertex_offset = vertex_offset;
+    range.vertex_capacity = range.num_vertices;
+    range.triangle_offset = triangle_offset;
+    range.triangle_capacity = range.num_triangle_indices;
+    vertex_offset += range.num_vertices;
+    triangle_offset += range.num_triangle_indices;
+
+    source_blocks_.push_back(source, *cuda_stream_);
+    destination_ranges_.push_back(range, *cuda_stream_);
+    max_block_size =
+        std::max(max_block_size,
+                 std::max(range.num_vertices, range.num_triangle_indices));
+  }
+
+  // The copy goes to a second set of buffers, as the ranges may overlap.
+  compacted_vertices_.resizeAsync(vertex_offset, *cuda_stream_);
+  compacted_normals_.resizeAsync(vertex_offset, *cuda_stream_);
+  compacted_colors_.resizeAsync(vertex_offset, *cuda_stream_);
+  compacted_triangles_.resizeAsync(triangle_offset, *cuda_stream_);
+
+  const int num_blocks = source_blocks_.size();
+  constexpr int kMaxNumThreads = 512;
+  const int num_threads = std::min(max_block_size, kMaxNumThreads);
+  if (num_blocks > 0 && num_threads > 0) {
+    copyBlocksToArenaKernel<<<num_blocks, num_threads, 0, *cuda_stream_>>>(
+        num_blocks,                    // NOLINT
+        source_blocks_.data(),         // NOLINT
+        destination_ranges_.data(),    // NOLINT
+        compacted_vertices_.data(),    // NOLINT
+        compacted_normals_.data(),     // NOLINT
+        compacted_colors_.data(),      // NOLINT
+        compacted_triangles_.data());  // NOLINT
+    checkCudaErrors(cudaPeekAtLastError());
+  }
+  cuda_stream_->synchronize();
+
+  std::swap(vertices_, compacted_vertices_);
+  std::swap(normals_, compacted_normals_);
+  std::swap(colors_, compacted_colors_);
+  std::swap(triangles_, compacted_triangles_);
+  vertex_end_ = vertex_offset;
+  triangle_end_ = triangle_offset;
+}
+
+void MeshArena::clear() {
+  ranges_.clear();
+  vertex_end_ = 0;
+  triangle_end_ = 0;
+  num_used_vertices_ = 0;
+  num_used_triangle_indices_ = 0;
+  vertices_.clearNoDeallocate();
+  normals_.clearNoDeallocate();
+  colors_.clearNoDeallocate();
+  triangles_.clearNoDeallocate();
+}
+
+bool MeshArena::copyBlockTo(const Index3D& block_index,
+                            MeshBlock* mesh_block) const {
+  CHECK_NOTNULL(mesh_block);
+  MeshArenaRange range;
+  if (!getRange(block_index, &range)) {
+    return false;
+  }
+  mesh_block->vertices.copyFromAsync(vertices_.data() + range.vertex_offset,
+                                     range.num_vertices, *cuda_stream_);
+  mesh_block->normals.copyFromAsync(normals_.data() + range.vertex_offset,
+                                    range.num_vertices, *cuda_stream_);
+  mesh_block->colors.copyFromAsync(colors_.data() + range.vertex_offset,
+                                   range.num_vertices, *cuda_stream_);
+  mesh_block->triangles.copyFromAsync(
+      triangles_.data() + range.triangle_offset, range.num_triangle_indices,
+      *cuda_stream_);
+  cuda_stream_->synchronize();
+  return true;
+}
+
+bool MeshArena::getRange(const Index3D& block_index,
+                         MeshArenaRange* range) const {
+  CHECK_NOTNULL(range);
+  const auto it = ranges_.find(block_index);
+  if (it == ranges_.end()) {
+    return false;
+  }
+  *range = it->second;
+  return true;
+}
+
+std::vector<Index3D> MeshArena::getAllBlockIndices() const {
+  std::vector<Index3D> block_indices;
+  block_indices.reserve(ranges_.size());
+  for (const auto& index_and_range : ranges_) {
+    block_indices.push_back(index_and_range.first);
+  }
+  std::sort(block_indices.begin(), block_indices.end(),
+            [this](const Index3D& a, const Index3D& b) {
+              return ranges_.at(a).vertex_offset < ranges_.at(b).vertex_offset;
+            });
+  return block_indices;
+}
+
+bool MeshArena::isCompact() const {
+  return num_used_vertices_ == vertex_end_ &&
+         num_used_triangle_indices_ == triangle_end_;
+}
+
+void MeshArena::releaseRange(const MeshArenaRange& range) {
+  num_used_vertices_ -= range.num_vertices;
+  num_used_triangle_indices_ -= range.num_triangle_indices;
+}
+
+void MeshArena::reserveBuffers(int32_t num_vertices,
+                               int32_t num_triangle_indices) {
+  // Grow geometrically such that appending is amortized.
+  constexpr int32_t kGrowthFactor = 2;
+  if (static_cast<size_t>(num_vertices) > vertices_.capacity()) {
+    const size_t capacity = kGrowthFactor * num_vertices;
+    vertices_.reserveAsync(capacity, *cuda_stream_);
+    normals_.reserveAsync(capacity, *cuda_stream_);
+    colors_.reserveAsync(capacity, *cuda_stream_);
+  }
+  if (static_cast<size_t>(num_triangle_indices) > triangles_.capacity()) {
+    triangles_.reserveAsync(kGrowthFactor * num_triangle_indices,
+                            *cuda_stream_);
+  }
+  vertices_.resizeAsync(num_vertices, *cuda_stream_);
+  normals_.resizeAsync(num_vertices, *cuda_stream_);
+  colors_.resizeAsync(num_vertices, *cuda_stream_);
+  triangles_.resizeAsync(num_triangle_indices, *cuda_stream_);
+}
+
+}  // namespace nvblox
@@ -0,0 +1,322 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "nvblox/mesh/mesh_decimator.h"
+
+#include <cmath>
+
+#include "nvblox/core/indexing.h"
+#include "nvblox/utils/timing.h"
+
+namespace nvblox {
+
+namespace {
+
+// A block's vertices lie between the centers of its first voxel and the
+// center of the first voxel of the next block, i.e. in [0.5, 8.5] voxels from
+// the block origin. The maximum extent therefore is 8.5 voxels.
+constexpr float kBlockVertexExtentVox =
+    VoxelBlock<bool>::kVoxelsPerSide + 0.5f;
+
+// The number of cells per side of the grid covering a block's vertices.
+__host__ __device__ inline int cellsPerSide(int lod_level) {
+  return static_cast<int>(kBlockVertexExtentVox / (1 << lod_level)) + 1;
+}
+
+// At level 1 the grid is the largest.
+constexpr int kMaxNumCells = 5 * 5 * 5;
+
+__device__ inline int getCellIndex(const Vector3f& vertex,
+                                   const Vector3f& block_origin,
+                                   const float cell_size,
+                                   const int cells_per_side) {
+  const Vector3f p_cell = (vertex - block_origin) / cell_size;
+  int linear_index = 0;
+  for (int i = 0; i < 3; i++) {
+    const int cell_idx =
+        min(max(static_cast<int>(floorf(p_cell[i])), 0), cells_per_side - 1);
+    linear_index = linear_index * cells_per_side + cell_idx;
+  }
+  return linear_index;
+}
+
+// Call with:
+// - One threadBlock per mesh block
+__global__ void decimateMeshBlocksKernel(const CudaMeshBlock* input_blocks,
+                                         const Vector3f* block_origins,
+                                         const int* lod_levels,
+                                         const float voxel_size,
+                                         CudaMeshBlock* output_blocks) {
+  __shared__ int cell_num_vertices[kMaxNumCells];
+  __shared__ int cell_output_vertex[kMaxNumCells];
+  __shared__ float cell_normal_sum[kMaxNumCells][3];
+  __shared__ int cell_color_sum[kMaxNumCells][4];
+  __shared__ int num_output_vertices;
+  __shared__ int num_output_triangle_indices;
+
+  const CudaMeshBlock& input = input_blocks[blockIdx.x];
+  CudaMeshBlock& output = output_blocks[blockIdx.x];
+  const Vector3f block_origin = block_origins[blockIdx.x];
+  const int lod_level = lod_levels[blockIdx.x];
+  const float cell_size = voxel_size * (1 << lod_level);
+  const int cells_per_side = cellsPerSide(lod_level);
+  const int num_cells = cells_per_side * cells_per_side * cells_per_side;
+  const bool has_colors = input.colors != nullptr;
+
+  for (int cell = threadIdx.x; cell < num_cells; cell += blockDim.x) {
+    cell_num_vertices[cell] = 0;
+    for (int i = 0; i < 3; i++) {
+      cell_normal_sum[cell][i] = 0.0f;
+    }
+    for (int i = 0; i < 4; i++) {
+      cell_color_sum[cell][i] = 0;
+    }
+  }
+  __syncthreads();
+
+  // Accumulate the vertices falling into each cell.
+  for (int v = threadIdx.x; v < input.vertices_size; v += blockDim.x) {
+    const int cell = getCellIndex(input.vertices[v], block_origin, cell_size,
+                                  cells_per_side);
+    atomicAdd(&cell_num_vertices[cell], 1);
+    for (int i = 0; i < 3; i++) {
+      atomicAdd(&cell_normal_sum[cell][i], input.normals[v][i]);
+    }
+    if (has_colors) {
+      const Color& color = input.colors[v];
+      atomicAdd(&cell_color_sum[cell][0], color.r);
+      atomicAdd(&cell_color_sum[cell][1], color.g);
+      atomicAdd(&cell_color_sum[cell][2], color.b);
+      atomicAdd(&cell_color_sum[cell][3], color.a);
+    }
+  }
+  __syncthreads();
+
+  // Assign an output vertex to each occupied cell. The grid is small, so we
+  // simply do this serially.
+  if (threadIdx.x == 0) {
+    int num_vertices = 0;
+    for (int cell = 0; cell < num_cells; cell++) {
+      cell_output_vertex[cell] =
+          (cell_num_vertices[cell] > 0) ? num_vertices++ : -1;
+    }
+    num_output_vertices = num_vertices;
+    num_output_triangle_indices = 0;
+  }
+  __syncthreads();
+
+  // Write the output vertices, placed at the cell centers.
+  for (int cell = threadIdx.x; cell < num_cells; cell += blockDim.x) {
+    const int v = cell_output_vertex[cell];
+    if (v < 0) {
+      continue;
+    }
+    const Vector3f cell_idx(cell / (cells_per_side * cells_per_side),
+                            (cell / cells_per_side) % cells_per_side,
+                            cell % cells_per_side);
+    output.vertices[v] =
+        block_origin + (cell_idx + Vector3f::Constant(0.5f)) * cell_size;
+    const Vector3f normal(cell_normal_sum[cell][0], cell_normal_sum[cell][1],
+                          cell_normal_sum[cell][2]);
+    const float normal_length = normal.norm();
+    output.normals[v] = (normal_length > 0.0f) ? normal / normal_length
+                                               : Vector3f(0.0f, 0.0f, 1.0f);
+    if (has_colors) {
+      const int n = cell_num_vertices[cell];
+      output.colors[v] = Color(cell_color_sum[cell][0] / n,
+                               cell_color_sum[cell][1] / n,
+                               cell_color_sum[cell][2] / n,
+                               cell_color_sum[cell][3] / n);
+    }
+  }
+
+  // Remap the triangles. Triangles with two or more corners in the same cell
+  // are degenerate and dropped.
+  const int num_triangles = input.triangles_size / 3;
+  for (int t = threadIdx.x; t < num_triangles; t += blockDim.x) {
+    int corners[3];
+    for (int i = 0; i < 3; i++) {
+      const Vector3f& vertex = input.vertices[input.triangles[3 * t + i]];
+      corners[i] = cell_output_vertex[getCellIndex(vertex, block_origin,
+                                                   cell_size, cells_per_side)];
+    }
+    if (corners[0] == corners[1] || corners[1] == corners[2] ||
+        corners[2] == corners[0]) {
+      continue;
+    }
+    const int output_idx = atomicAdd(&num_output_triangle_indices, 3);
+    for (int i = 0; i < 3; i++) {
+      output.triangles[output_idx + i] = corners[i];
+    }
+  }
+  __syncthreads();
+
+  if (threadIdx.x == 0) {
+    output.vertices_size = num_output_vertices;
+    output.triangles_size = num_output_triangle_indices;
+  }
+}
+
+}  // namespace
+
+MeshDecimator::MeshDecimator()
+    : MeshDecimator(std::make_shared<CudaStreamOwning>()) {}
+
+MeshDecimator::MeshDecimator(std::shared_ptr<CudaStream> cuda_stream)
+    : cuda_stream_(cuda_stream) {}
+
+void MeshDecimator::decimateBlocks(const MeshLayer& mesh_layer,
+                                   const std::vector<Index3D>& block_indices,
+                                   const std::vector<int>& lod_levels,
+                                   MeshLayer* decimated_mesh_layer) {
+  CHECK_NOTNULL(decimated_mesh_layer);
+  CHECK_EQ(block_indices.size(), lod_levels.size());
+  CHECK_NEAR(mesh_layer.block_size(), decimated_mesh_layer->block_size(),
+             1e-4);
+  timing::Timer decimate_timer("mesh/decimate");
+
+  const float block_size = mesh_layer.block_size();
+  const float voxel_size = block_size / VoxelBlock<bool>::kVoxelsPerSide;
+
+  // Allocate the output blocks, and stage the ones which need decimation.
+  std::vector<CudaMeshBlock> input_blocks_host;
+  std::vector<CudaMeshBlock> output_blocks_host;
+  std::vector<Vector3f> block_origins_host;
+  std::vector<int> lod_levels_host;
+  std::vector<MeshBlock::Ptr> output_block_ptrs;
+  for (size_t i = 0; i < block_indices.size(); i++) {
+    const MeshBlock::ConstPtr input_block =
+        mesh_layer.getBlockAtIndex(block_indices[i]);
+    if (input_block == nullptr || input_block->size() == 0) {
+      MeshBlock::Ptr stale_block =
+          decimated_mesh_layer->getBlockAtIndex(block_indices[i]);
+      if (stale_block != nullptr) {
+        stale_block->clear();
+      }
+      continue;
+    }
+    MeshBlock::Ptr output_block =
+        decimated_mesh_layer->allocateBlockAtIndexAsync(block_indices[i],
+                                                        *cuda_stream_);
+    const int lod_level = std::min(lod_levels[i], kMaxLodLevel);
+    if (lod_level <= 0) {
+      output_block->copyFromAsync(*input_block, *cuda_stream_);
+      continue;
+    }
+
+    // Decimation never increases the number of vertices or triangles.
+    const bool has_colors =
+        input_block->colors.size() == input_block->vertices.size();
+    output_block->vertices.resizeAsync(input_block->vertices.size(),
+                                       *cuda_stream_);
+    output_block->normals.resizeAsync(input_block->vertices.size(),
+                                      *cuda_stream_);
+    output_block->triangles.resizeAsync(input_block->triangles.size(),
+                                        *cuda_stream_);
+    output_block->colors.resizeAsync(
+        has_colors ? input_block->vertices.size() : 0, *cuda_stream_);
+
+    // NOTE: The input block is only read by the kernel.
+    CudaMeshBlock input_cuda_block(const_cast<MeshBlock*>(input_block.get()));
+    CudaMeshBlock output_cuda_block(output_block.get());
+    if (!has_colors) {
+      input_cuda_block.colors = nullptr;
+      output_cuda_block.colors = nullptr;
+    }
+    input_blocks_host.push_back(input_cuda_block);
+    output_blocks_host.push_back(output_cuda_block);
+    block_origins_host.push_back(
+        getPositionFromBlockIndex(block_size, block_indices[i]));
+    lod_levels_host.push_back(lod_level);
+    output_block_ptrs.push_back(output_block);
+  }
+  if (output_block_ptrs.empty()) {
+    cuda_stream_->synchronize();
+    return;
+  }
+
+  // Kernel
+  input_blocks_device_.copyFromAsync(input_blocks_host, *cuda_stream_);
+  output_blocks_device_.copyFromAsync(output_blocks_host, *cuda_stream_);
+  block_origins_device_.copyFromAsync(block_origins_host, *cuda_stream_);
+  lod_levels_device_.copyFromAsync(lod_levels_host, *cuda_stream_);
+  constexpr int kNumThreads = 256;
+  const int num_thread_blocks = output_block_ptrs.size();
+  decimateMeshBlocksKernel<<<num_thread_blocks, kNumThreads, 0,
+                             *cuda_stream_>>>(
+      input_blocks_device_.data(),    // NOLINT
+      block_origins_device_.data(),   // NOLINT
+      lod_levels_device_.data(),      // NOLINT
+      voxel_size,                     // NOLINT
+      output_blocks_device_.data());  // NOLINT
+  checkCudaErrors(cudaPeekAtLastError());
+
+  // Shrink the output blocks to the decimated sizes.
+  output_blocks_host = output_blocks_device_.toVectorAsync(*cuda_stream_);
+  cuda_stream_->synchronize();
+  for (size_t i = 0; i < output_block_ptrs.size(); i++) {
+    MeshBlock* output_block = output_block_ptrs[i].get();
+    const int num_vertices = output_blocks_host[i].vertices_size;
+    output_block->vertices.resizeAsync(num_vertices, *cuda_stream_);
+    output_block->normals.resizeAsync(num_vertices, *cuda_stream_);
+    if (output_block->colors.size() > 0) {
+      output_block->colors.resizeAsync(num_vertices, *cuda_stream_);
+    }
+    output_block->triangles.resizeAsync(output_blocks_host[i].triangles_size,
+                                        *cuda_stream_);
+  }
+  cuda_stream_->synchronize();
+}
+
+void MeshDecimator::decimateBlocksForViewer(
+    const MeshLayer& mesh_layer, const std::vector<Index3D>& block_indices,
+    const Vector3f& viewer_position, MeshLayer* decimated_mesh_layer) {
+  std::vector<int> lod_levels;
+  lod_levels.reserve(block_indices.size());
+  for (const Index3D& block_index : block_indices) {
+    lod_levels.push_back(
+        getLodLevel(block_index, mesh_layer.block_size(), viewer_position));
+  }
+  decimateBlocks(mesh_layer, block_indices, lod_levels, decimated_mesh_layer);
+}
+
+int MeshDecimator::getLodLevel(const Index3D& block_index, float block_size,
+                               const Vector3f& viewer_position) const {
+  const Vector3f block_center =
+      getPositionFromBlockIndex(block_size, block_index) +
+      Vector3f::Constant(0.5f * block_size);
+  const float distance_m = (block_center - viewer_position).norm();
+  if (distance_m < full_resolution_distance_m_) {
+    return 0;
+  }
+  const int lod_level =
+      static_cast<int>(std::log2(distance_m / full_resolution_distance_m_)) +
+      1;
+  return std::min(lod_level, max_lod_level_);
+}
+
+void MeshDecimator::full_resolution_distance_m(
+    float full_resolution_distance_m) {
+  CHECK_GT(full_resolution_distance_m, 0.0f);
+  full_resolution_distance_m_ = full_resolution_distance_m;
+}
+
+void MeshDecimator::max_lod_level(int max_lod_level) {
+  CHECK_GE(max_lod_level, 0);
+  CHECK_LE(max_lod_level, kMaxLodLevel);
+  max_lod_level_ = max_lod_level;
+}
+
+}  // namespace nvblox
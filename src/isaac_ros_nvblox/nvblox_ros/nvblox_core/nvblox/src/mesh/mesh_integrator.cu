@@ -21,17 +21,30 @@ limitations under the License.
 #include <thrust/sort.h>
 #include <thrust/unique.h>
 
+#include "nvblox/gpu_hash/internal/cuda/block_neighbor_table.cuh"
 #include "nvblox/integrators/internal/integrators_common.h"
 #include "nvblox/map/accessors.h"
 #include "nvblox/map/common_names.h"
+#include "nvblox/map/internal/cuda/voxel_block_threads.cuh"
 #include "nvblox/mesh/internal/cuda/marching_cubes.cuh"
 #include "nvblox/mesh/internal/impl/marching_cubes_table.h"
 #include "nvblox/mesh/internal/marching_cubes.h"
 #include "nvblox/mesh/mesh_integrator.h"
+#include "nvblox/utils/gpu_timing.h"
+#include "nvblox/utils/parallel_for.h"
 #include "nvblox/utils/timing.h"
 
 namespace nvblox {
 
+// The block and its 7 positive neighbors, which contain the corners of the
+// cubes of the block (see marching_cubes::neighborIndexFromDirection()).
+struct MarchingCubesNeighborhood {
+  static constexpr int kNumNeighbors = 8;
+  __host__ __device__ static Index3D offsetFromIndex(const int index) {
+    return marching_cubes::directionFromNeighborIndex(index);
+  }
+};
+
 MeshIntegrator::MeshIntegrator()
     : MeshIntegrator(std::make_shared<CudaStreamOwning>()) {}
 
@@ -44,6 +57,12 @@ MeshIntegrator::MeshIntegrator(std::shared_ptr<CudaStream> cuda_stream)
   // clang-format on
 }
 
+void MeshIntegrator::cuda_stream(std::shared_ptr<CudaStream> cuda_stream) {
+  CHECK(cuda_stream != nullptr);
+  cuda_stream_->synchronize();
+  cuda_stream_ = cuda_stream;
+}
+
 // Return all indices that exists in layer
 std::vector<Index3D> getIndicesInLayer(
     const std::vector<Index3D>& block_indices_in, const TsdfLayer& layer) {
@@ -60,7 +79,7 @@ std::vector<Index3D> getIndicesInLayer(
 bool MeshIntegrator::integrateBlocksGPU(
     const TsdfLayer& distance_layer,
     const std::vector<Index3D>& block_indices_in,
-    BlockLayer<MeshBlock>* mesh_layer) {
+    BlockLayer<MeshBlock>* mesh_layer, const ColorLayer* color_layer) {
   timing::Timer mesh_timer("mesh/gpu/integrate");
   const std::vector<Index3D> block_indices =
       getIndicesInLayer(block_indices_in, distance_layer);
@@ -82,6 +101,19 @@ bool MeshIntegrator::integrateBlocksGPU(
     }
   }
 
+  // The fused kernel checks meshability itself.
+  if (fused_meshing_) {
+    timing::Timer mesh_blocks_timer("mesh/gpu/mesh_blocks_fused");
+    timing::GpuTimer mesh_blocks_gpu_timer("mesh/gpu/mesh_blocks_fused",
+                                           *cuda_stream_);
+    meshBlocksFusedGPU(distance_layer, block_indices,
+                       cutoff_distance_vox_ * voxel_size, mesh_layer,
+                       color_layer);
+    mesh_blocks_gpu_timer.Stop();
+    mesh_blocks_timer.Stop();
+    return true;
+  }
+
   // First create a list of meshable blocks.
   std::vector<Index3D> meshable_blocks;
   timing::Timer meshable_timer("mesh/gpu/get_meshable");
@@ -91,9 +123,17 @@ bool MeshIntegrator::integrateBlocksGPU(
 
   // Then get all the candidates and mesh each block.
   timing::Timer mesh_blocks_timer("mesh/gpu/mesh_blocks");
+  timing::GpuTimer mesh_blocks_gpu_timer("mesh/gpu/mesh_blocks",
+                                         *cuda_stream_);
   meshBlocksGPU(distance_layer, meshable_blocks, mesh_layer);
+  mesh_blocks_gpu_timer.Stop();
   mesh_blocks_timer.Stop();
 
+  if (color_layer != nullptr) {
+    timing::Timer color_timer("mesh/gpu/color");
+    colorMeshGPU(*color_layer, meshable_blocks, mesh_layer);
+  }
+
   return true;
 }
 
@@ -120,47 +160,65 @@ bool MeshIntegrator::integrateBlocksCPU(
   const float block_size = distance_layer.block_size();
   const float voxel_size = distance_layer.voxel_size();
 
-  // For each block...
-  for (const Index3D& block_index : block_indices) {
-    // Get the block.
-    VoxelBlock<TsdfVoxel>::ConstPtr block =
-        distance_layer.getBlockAtIndex(block_index);
-
-    // Check meshability - basically if this contains anything near the
-    // border.
-    if (!isBlockMeshable(block, voxel_size * 2)) {
-      continue;
-    }
-
-    // Get all the neighbor blocks.
-    std::vector<VoxelBlock<TsdfVoxel>::ConstPtr> neighbor_blocks(8);
-    for (int i = 0; i < 8; i++) {
-      Index3D neighbor_index =
-          block_index + marching_cubes::directionFromNeighborIndex(i);
-      neighbor_blocks[i] = distance_layer.getBlockAtIndex(neighbor_index);
-    }
-
-    // Get all the potential triangles:
-    std::vector<marching_cubes::PerVoxelMarchingCubesResults>
-        triangle_candidates;
-    getTriangleCandidatesInBlock(block, neighbor_blocks, block_index,
-                                 block_size, &triangle_candidates);
+  // The blocks are meshed in parallel, so bring the CPU hash up to date before
+  // the concurrent lookups.
+  distance_layer.syncCpuHash();
+
+  // For each block, get all the potential triangles.
+  std::vector<std::vector<marching_cubes::PerVoxelMarchingCubesResults>>
+      triangle_candidates(block_indices.size());
+  parallelFor(
+      block_indices.size(), num_cpu_threads_,
+      [&](size_t begin, size_t end) {
+        for (size_t block_num = begin; block_num < end; ++block_num) {
+          const Index3D& block_index = block_indices[block_num];
+          // Get the block.
+          VoxelBlock<TsdfVoxel>::ConstPtr block =
+              distance_layer.getBlockAtIndex(block_index);
+
+          // Check meshability - basically if this contains anything near the
+          // border.
+          if (!isBlockMeshable(block, voxel_size * 2)) {
+            continue;
+          }
+
+          // Get all the neighbor blocks.
+          std::vector<VoxelBlock<TsdfVoxel>::ConstPtr> neighbor_blocks(8);
+          for (int i = 0; i < 8; i++) {
+            Index3D neighbor_index =
+                block_index + marching_cubes::directionFromNeighborIndex(i);
+            neighbor_blocks[i] = distance_layer.getBlockAtIndex(neighbor_index);
+          }
+
+          getTriangleCandidatesInBlock(block, neighbor_blocks, block_index,
+                                       block_size,
+                                       &triangle_candidates[block_num]);
+        }
+      });
 
-    if (triangle_candidates.size() <= 0) {
+  // Allocate the mesh blocks. This modifies the mesh layer so is done serially.
+  std::vector<MeshBlock::Ptr> mesh_blocks(block_indices.size());
+  for (size_t block_num = 0; block_num < block_indices.size(); ++block_num) {
+    if (triangle_candidates[block_num].empty()) {
       continue;
     }
-
-    // Allocate the mesh block.
-    MeshBlock::Ptr mesh_block =
-        mesh_layer->allocateBlockAtIndexAsync(block_index, *cuda_stream_);
-
-    // Then actually calculate the triangles.
-    for (const marching_cubes::PerVoxelMarchingCubesResults& candidate :
-         triangle_candidates) {
-      marching_cubes::meshCube(candidate, mesh_block.get());
-    }
+    mesh_blocks[block_num] = mesh_layer->allocateBlockAtIndexAsync(
+        block_indices[block_num], *cuda_stream_);
   }
 
+  // Then actually calculate the triangles. Each thread writes to its own
+  // mesh blocks only.
+  parallelFor(block_indices.size(), num_cpu_threads_,
+              [&](size_t begin, size_t end) {
+                for (size_t block_num = begin; block_num < end; ++block_num) {
+                  for (const marching_cubes::PerVoxelMarchingCubesResults&
+                           candidate : triangle_candidates[block_num]) {
+                    marching_cubes::meshCube(candidate,
+                                             mesh_blocks[block_num].get());
+                  }
+                }
+              });
+
   return true;
 }
 
@@ -293,32 +351,34 @@ bool MeshIntegrator::getTriangleCandidatesAroundVoxel(
 
 // Takes in a vector of blocks, and outputs an integer true if that block is
 // meshable.
-// Block size MUST be voxels_per_side x voxels_per_side x voxel_per_size.
+// Block size MUST be voxelBlockThreadsPerBlock().
 // Grid size can be anything.
 __global__ void isBlockMeshableKernel(int num_blocks,
                                       const VoxelBlock<TsdfVoxel>** blocks,
                                       float cutoff_distance, float min_weight,
                                       bool* meshable) {
-  dim3 voxel_index = threadIdx;
   // This for loop allows us to have fewer threadblocks than there are
   // blocks in this computation. We assume the threadblock size is constant
   // though to make our lives easier.
   for (int block_index = blockIdx.x; block_index < num_blocks;
        block_index += gridDim.x) {
-    // Get the correct voxel for this index.
-    const TsdfVoxel& voxel =
-        blocks[block_index]
-            ->voxels[voxel_index.z][voxel_index.y][voxel_index.x];
-    if (fabs(voxel.distance) <= cutoff_distance && voxel.weight >= min_weight) {
-      meshable[block_index] = true;
-    }
+    forEachVoxelInThread([&](const Index3D& voxel_index) {
+      // Get the correct voxel for this index.
+      const TsdfVoxel& voxel =
+          blocks[block_index]
+              ->voxels[voxel_index.x()][voxel_index.y()][voxel_index.z()];
+      if (fabs(voxel.distance) <= cutoff_distance &&
+          voxel.weight >= min_weight) {
+        meshable[block_index] = true;
+      }
+    });
   }
 }
 
 // Takes in a set of blocks arranged in neighbor sets and their relative
 // positions, then finds vertex candidates, and finally creates the output
 // meshes for them.
-// Block size MUST be voxels_per_side x voxels_per_side x voxel_per_size.
+// Block size MUST be voxelBlockThreadsPerBlock().
 // Grid size can be anything.
 __global__ void meshBlocksCalculateTableIndicesKernel(
     int num_blocks, const VoxelBlock<TsdfVoxel>** blocks,
@@ -330,17 +390,12 @@ __global__ void meshBlocksCalculateTableIndicesKernel(
       kVoxelsPerSide * kVoxelsPerSide * kVoxelsPerSide;
   constexpr int kCubeNeighbors = 8;
 
-  const dim3 voxel_index = dim3(threadIdx.z, threadIdx.y, threadIdx.x);
-
-  const int linear_thread_idx =
-      threadIdx.x +
-      kVoxelsPerSide * (threadIdx.y + kVoxelsPerSide * threadIdx.z);
+  const bool is_first_thread =
+      threadIdx.x == 0 && threadIdx.y == 0 && threadIdx.z == 0;
 
   // Preallocate a half voxel size.
   const Vector3f half_voxel(0.5f, 0.5f, 0.5f);
 
-  marching_cubes::PerVoxelMarchingCubesResults marching_cubes_results_local;
-
   // This for loop allows us to have fewer threadblocks than there are
   // blocks in this computation. We assume the threadblock size is constant
   // though to make our lives easier.
@@ -348,7 +403,7 @@ __global__ void meshBlocksCalculateTableIndicesKernel(
        block_index += gridDim.x) {
     // Initialize the calculated output size for this block.
     __shared__ int mesh_block_size;
-    if (linear_thread_idx == 0) {
+    if (is_first_thread) {
       mesh_block_size = 0;
     }
     __syncthreads();
@@ -356,65 +411,66 @@ __global__ void meshBlocksCalculateTableIndicesKernel(
     // Getting the block pointer is complicated now so let's just get it.
     const VoxelBlock<TsdfVoxel>* block = blocks[block_index * kCubeNeighbors];
 
-    // Get the linear index of the this voxel in this block
-    const int vertex_neighbor_idx =
-        block_index * kVoxelsPerBlock + linear_thread_idx;
-
-    // Check all 8 neighbors.
-    bool skip_voxel = false;
-    for (unsigned int i = 0; i < 8; ++i) {
-      Index3D corner_index(
-          voxel_index.x + marching_cubes::kCornerIndexOffsets[i][0],
-          voxel_index.y + marching_cubes::kCornerIndexOffsets[i][1],
-          voxel_index.z + marching_cubes::kCornerIndexOffsets[i][2]);
-      Index3D block_offset(0, 0, 0);
-      bool search_neighbor = false;
-      // Are we in bounds? If not, have to get a neighbor.
-      // The neighbor should correspond to the index in neighbor blocks.
-      for (int j = 0; j < 3; j++) {
-        if (corner_index[j] >= kVoxelsPerSide) {
-          // Here the index is too much.
-          corner_index(j) -= kVoxelsPerSide;
-          block_offset(j) = 1;
-          search_neighbor = true;
+    forEachVoxelInThread([&](const Index3D& voxel_index) {
+      marching_cubes::PerVoxelMarchingCubesResults
+          marching_cubes_results_local;
+
+      // Get the linear index of the this voxel in this block
+      const int linear_voxel_idx =
+          voxel_index.z() +
+          kVoxelsPerSide * (voxel_index.y() + kVoxelsPerSide * voxel_index.x());
+      const int vertex_neighbor_idx =
+          block_index * kVoxelsPerBlock + linear_voxel_idx;
+
+      // Check all 8 neighbors.
+      for (unsigned int i = 0; i < 8; ++i) {
+        Index3D corner_index(
+            voxel_index.x() + marching_cubes::kCornerIndexOffsets[i][0],
+            voxel_index.y() + marching_cubes::kCornerIndexOffsets[i][1],
+            voxel_index.z() + marching_cubes::kCornerIndexOffsets[i][2]);
+        Index3D block_offset(0, 0, 0);
+        bool search_neighbor = false;
+        // Are we in bounds? If not, have to get a neighbor.
+        // The neighbor should correspond to the index in neighbor blocks.
+        for (int j = 0; j < 3; j++) {
+          if (corner_index[j] >= kVoxelsPerSide) {
+            // Here the index is too much.
+            corner_index(j) -= kVoxelsPerSide;
+            block_offset(j) = 1;
+            search_neighbor = true;
+          }
         }
-      }
 
-      const TsdfVoxel* voxel = nullptr;
-      // Don't look for neighbors for now.
-      if (search_neighbor) {
-        int neighbor_index =
-            marching_cubes::neighborIndexFromDirection(block_offset);
-        const VoxelBlock<TsdfVoxel>* neighbor_block =
-            blocks[block_index * kCubeNeighbors + neighbor_index];
-        if (neighbor_block == nullptr) {
-          skip_voxel = true;
-          break;
+        const TsdfVoxel* voxel = nullptr;
+        // Don't look for neighbors for now.
+        if (search_neighbor) {
+          int neighbor_index =
+              marching_cubes::neighborIndexFromDirection(block_offset);
+          const VoxelBlock<TsdfVoxel>* neighbor_block =
+              blocks[block_index * kCubeNeighbors + neighbor_index];
+          if (neighbor_block == nullptr) {
+            return;
+          }
+          voxel = &neighbor_block->voxels[corner_index.x()][corner_index.y()]
+                                         [corner_index.z()];
+        } else {
+          voxel = &block->voxels[corner_index.x()][corner_index.y()]
+                                [corner_index.z()];
+        }
+        // If any of the neighbors are not observed, this can't be a mesh
+        // triangle.
+        if (voxel->weight < min_weight) {
+          return;
         }
-        voxel =
-            &neighbor_block
-                 ->voxels[corner_index.x()][corner_index.y()][corner_index.z()];
-      } else {
-        voxel =
-            &block
-                 ->voxels[corner_index.x()][corner_index.y()][corner_index.z()];
-      }
-      // If any of the neighbors are not observed, this can't be a mesh
-      // triangle.
-      if (voxel->weight < min_weight) {
-        skip_voxel = true;
-        break;
-      }
 
-      // Calculate the position of this voxel.
-      marching_cubes_results_local.vertex_sdf[i] = voxel->distance;
-      marching_cubes_results_local.vertex_coords[i] =
-          block_positions[block_index] +
-          voxel_size * (corner_index.cast<float>() + half_voxel +
-                        (kVoxelsPerSide * block_offset).cast<float>());
-    }
+        // Calculate the position of this voxel.
+        marching_cubes_results_local.vertex_sdf[i] = voxel->distance;
+        marching_cubes_results_local.vertex_coords[i] =
+            block_positions[block_index] +
+            voxel_size * (corner_index.cast<float>() + half_voxel +
+                          (kVoxelsPerSide * block_offset).cast<float>());
+      }
 
-    if (!skip_voxel) {
       // If we've made it this far, this needs to be meshed.
       marching_cubes_results_local.contains_mesh = true;
 
@@ -431,11 +487,11 @@ __global__ void meshBlocksCalculateTableIndicesKernel(
       // Write out to global memory
       marching_cubes_results[vertex_neighbor_idx] =
           marching_cubes_results_local;
-    }
+    });
 
     // Writing the shared variable block size to global memory (per block)
     __syncthreads();
-    if (linear_thread_idx == 0) {
+    if (is_first_thread) {
       mesh_block_sizes[block_index] = mesh_block_size;
     }
   }
@@ -446,10 +502,8 @@ __global__ void meshBlocksCalculateVerticesKernel(
     const marching_cubes::PerVoxelMarchingCubesResults* marching_cubes_results,
     const int* mesh_block_sizes, CudaMeshBlock* mesh_blocks) {
   constexpr int kVoxelsPerSide = VoxelBlock<TsdfVoxel>::kVoxelsPerSide;
-
-  const int linear_thread_idx =
-      threadIdx.x +
-      kVoxelsPerSide * (threadIdx.y + kVoxelsPerSide * threadIdx.z);
+  constexpr int kVoxelsPerBlock =
+      kVoxelsPerSide * kVoxelsPerSide * kVoxelsPerSide;
 
   // This for loop allows us to have fewer threadblocks than there are
   // blocks in this computation. We assume the threadblock size is constant
@@ -458,25 +512,84 @@ __global__ void meshBlocksCalculateVerticesKernel(
        block_index += gridDim.x) {
     // If this block contains a mesh
     if (mesh_block_sizes[block_index] > 0) {
-      // Get the linear index of the this voxel in this block
-      constexpr int kVoxelsPerBlock =
-          kVoxelsPerSide * kVoxelsPerSide * kVoxelsPerSide;
-      const int vertex_neighbor_idx =
-          block_index * kVoxelsPerBlock + linear_thread_idx;
-
-      // If this voxel contains a mesh
-      if (marching_cubes_results[vertex_neighbor_idx].contains_mesh) {
-        // Convert the marching cube table index into vertex coordinates
-        marching_cubes::calculateVertices(
-            marching_cubes_results[vertex_neighbor_idx],
-            &mesh_blocks[block_index]);
-      }
+      forEachVoxelInThread([&](const Index3D& voxel_index) {
+        // Get the linear index of the this voxel in this block
+        const int linear_voxel_idx =
+            voxel_index.z() +
+            kVoxelsPerSide *
+                (voxel_index.y() + kVoxelsPerSide * voxel_index.x());
+        const int vertex_neighbor_idx =
+            block_index * kVoxelsPerBlock + linear_voxel_idx;
+
+        // If this voxel contains a mesh
+        if (marching_cubes_results[vertex_neighbor_idx].contains_mesh) {
+          // Convert the marching cube table index into vertex coordinates
+          marching_cubes::calculateVertices(
+              marching_cubes_results[vertex_neighbor_idx],
+              &mesh_blocks[block_index]);
+        }
+      });
     }
   }
 }
 
 // Wrappers
 
+void MeshIntegrator::getBlockNeighborhoodsAsync(
+    const TsdfLayer& distance_layer,
+    const std::vector<Index3D>& block_indices) {
+  const float block_size = distance_layer.block_size();
+
+  // Block pointers are actually a 2D array of also the neighbor block pointers
+  // The neighbors CAN be null so they need to be checked.
+  transferBlocksIndicesToDevice(block_indices, *cuda_stream_,
+                                &block_indices_host_, &block_indices_device_);
+  buildBlockNeighborTableAsync<MarchingCubesNeighborhood>(
+      block_indices.size(), block_indices_device_.data(),
+      distance_layer.getGpuLayerView(*cuda_stream_).getHash().impl_,
+      &block_ptrs_device_, *cuda_stream_);
+
+  block_positions_host_.resizeAsync(block_indices.size(), *cuda_stream_);
+  cuda_stream_->synchronize();
+  for (size_t i = 0; i < block_indices.size(); i++) {
+    block_positions_host_[i] =
+        getPositionFromBlockIndex(block_size, block_indices[i]);
+  }
+  block_positions_device_.copyFromAsync(block_positions_host_, *cuda_stream_);
+}
+
+MeshBlock* MeshIntegrator::allocateMeshBlockAsync(
+    const Index3D& block_index, size_t num_vertices,
+    size_t num_triangle_indices, BlockLayer<MeshBlock>* mesh_layer) {
+  MeshBlock::Ptr output_block =
+      mesh_layer->allocateBlockAtIndexAsync(block_index, *cuda_stream_);
+  if (output_block == nullptr) {
+    return nullptr;
+  }
+  // Grow the vector with a growth factor and a minimum allocation to avoid
+  // repeated reallocation
+  const size_t num_elements = std::max(num_vertices, num_triangle_indices);
+  if (num_elements > output_block->capacity()) {
+    constexpr size_t kMinimumMeshBlockTrianglesPerVoxel = 1;
+    constexpr size_t kMinimumMeshBlockVertices =
+        TsdfBlock::kNumVoxels * kMinimumMeshBlockTrianglesPerVoxel * 3;
+    constexpr size_t kMeshBlockOverallocationFactor = 2;
+    const int num_vertices_to_allocate =
+        std::max(kMinimumMeshBlockVertices,
+                 num_elements * kMeshBlockOverallocationFactor);
+    output_block->vertices.reserveAsync(num_vertices_to_allocate,
+                                        *cuda_stream_);
+    output_block->normals.reserveAsync(num_vertices_to_allocate,
+                                       *cuda_stream_);
+    output_block->triangles.reserveAsync(num_vertices_to_allocate,
+                                         *cuda_stream_);
+  }
+  output_block->vertices.resizeAsync(num_vertices, *cuda_stream_);
+  output_block->normals.resizeAsync(num_vertices, *cuda_stream_);
+  output_block->triangles.resizeAsync(num_triangle_indices, *cuda_stream_);
+  return output_block.get();
+}
+
 void MeshIntegrator::getMeshableBlocksGPU(
     const TsdfLayer& distance_layer, const std::vector<Index3D>& block_indices,
     float cutoff_distance, std::vector<Index3D>* meshable_blocks) {
@@ -485,11 +598,10 @@ void MeshIntegrator::getMeshableBlocksGPU(
     return;
   }
 
-  constexpr int kVoxelsPerSide = VoxelBlock<TsdfVoxel>::kVoxelsPerSide;
   // One block per block, 1 thread per pixel. :)
   // Dim block can be smaller, but dim_threads must be the same.
   int dim_block = block_indices.size();
-  dim3 dim_threads(kVoxelsPerSide, kVoxelsPerSide, kVoxelsPerSide);
+  dim3 dim_threads = voxelBlockThreadsPerBlock();
 
   // Collect all the meshable blocks as raw pointers.
   // Get all the block pointers and positions.
@@ -531,46 +643,22 @@ void MeshIntegrator::meshBlocksGPU(const TsdfLayer& distance_layer,
   }
   timing::Timer mesh_prep_timer("mesh/gpu/mesh_blocks/prep");
   constexpr int kVoxelsPerSide = VoxelBlock<TsdfVoxel>::kVoxelsPerSide;
-  constexpr int kCubeNeighbors = 8;
 
   // One block per block, 1 thread per voxel. :)
   // Dim block can be smaller, but dim_threads must be the same.
   int dim_block = block_indices.size();
-  dim3 dim_threads(kVoxelsPerSide, kVoxelsPerSide, kVoxelsPerSide);
+  dim3 dim_threads = voxelBlockThreadsPerBlock();
 
-  // Get the block and voxel size.
-  const float block_size = distance_layer.block_size();
+  // Get the voxel size.
   const float voxel_size = distance_layer.voxel_size();
 
   // Get all the block pointers and positions.
-  // Block pointers are actually a 2D array of also the neighbor block pointers
-  // The neighbors CAN be null so they need to be checked.
-  block_ptrs_host_.resizeAsync(block_indices.size() * kCubeNeighbors,
-                               *cuda_stream_);
-  block_positions_host_.resizeAsync(block_indices.size(), *cuda_stream_);
-  cuda_stream_->synchronize();
-  for (size_t i = 0; i < block_indices.size(); i++) {
-    block_ptrs_host_[i * kCubeNeighbors] =
-        distance_layer.getBlockAtIndex(block_indices[i]).get();
-    for (size_t j = 1; j < kCubeNeighbors; j++) {
-      // Get the pointers to all the neighbors as well.
-      block_ptrs_host_[i * kCubeNeighbors + j] =
-          distance_layer
-              .getBlockAtIndex(block_indices[i] +
-                               marching_cubes::directionFromNeighborIndex(j))
-              .get();
-    }
-    block_positions_host_[i] =
-        getPositionFromBlockIndex(block_size, block_indices[i]);
-  }
+  getBlockNeighborhoodsAsync(distance_layer, block_indices);
 
   // Create an output mesh blocks vector..
   mesh_blocks_host_.resizeAsync(block_indices.size(), *cuda_stream_);
   mesh_blocks_host_.setZeroAsync(*cuda_stream_);
 
-  block_ptrs_device_.copyFromAsync(block_ptrs_host_, *cuda_stream_);
-  block_positions_device_.copyFromAsync(block_positions_host_, *cuda_stream_);
-
   // Allocate working space
   constexpr int kNumVoxelsPerBlock =
       kVoxelsPerSide * kVoxelsPerSide * kVoxelsPerSide;
@@ -607,32 +695,12 @@ void MeshIntegrator::meshBlocksGPU(const TsdfLayer& distance_layer,
     const size_t num_vertices = mesh_block_sizes_host_[i];
 
     if (num_vertices > 0) {
-      MeshBlock::Ptr output_block = mesh_layer->allocateBlockAtIndexAsync(
-          block_indices[i], *cuda_stream_);
+      MeshBlock* output_block = allocateMeshBlockAsync(
+          block_indices[i], num_vertices, num_vertices, mesh_layer);
       if (output_block == nullptr) {
         continue;
       }
-      // Grow the vector with a growth factor and a minimum allocation to avoid
-      // repeated reallocation
-      if (num_vertices > output_block->capacity()) {
-        constexpr size_t kMinimumMeshBlockTrianglesPerVoxel = 1;
-        constexpr size_t kMinimumMeshBlockVertices =
-            kNumVoxelsPerBlock * kMinimumMeshBlockTrianglesPerVoxel * 3;
-        constexpr size_t kMeshBlockOverallocationFactor = 2;
-        const int num_vertices_to_allocate =
-            std::max(kMinimumMeshBlockVertices,
-                     num_vertices * kMeshBlockOverallocationFactor);
-        output_block->vertices.reserveAsync(num_vertices_to_allocate,
-                                            *cuda_stream_);
-        output_block->normals.reserveAsync(num_vertices_to_allocate,
-                                           *cuda_stream_);
-        output_block->triangles.reserveAsync(num_vertices_to_allocate,
-                                             *cuda_stream_);
-      }
-      output_block->vertices.resizeAsync(num_vertices, *cuda_stream_);
-      output_block->normals.resizeAsync(num_vertices, *cuda_stream_);
-      output_block->triangles.resizeAsync(num_vertices, *cuda_stream_);
-      mesh_blocks_host_[i] = CudaMeshBlock(output_block.get());
+      mesh_blocks_host_[i] = CudaMeshBlock(output_block);
     }
   }
   mesh_blocks_device_.copyFromAsync(mesh_blocks_host_, *cuda_stream_);
@@ -815,6 +883,8 @@ parameters::ParameterTreeNode MeshIntegrator::getParameterTree(
                 ParameterTreeNode("min_weight:", min_weight_),
                 ParameterTreeNode("cutoff_distance_vox:", cutoff_distance_vox_),
                 ParameterTreeNode("weld_vertices:", weld_vertices_),
+                ParameterTreeNode("fused_meshing:", fused_meshing_),
+                ParameterTreeNode("num_cpu_threads:", num_cpu_threads_),
             });
 }
 
@@ -0,0 +1,588 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <cuda_runtime.h>
+#include <glog/logging.h>
+
+#include "cub/block/block_scan.cuh"
+
+#include "nvblox/core/internal/error_check.h"
+#include "nvblox/map/internal/cuda/voxel_block_threads.cuh"
+#include "nvblox/mesh/internal/cuda/marching_cubes.cuh"
+#include "nvblox/mesh/internal/cuda/mesh_coloring.cuh"
+#include "nvblox/mesh/internal/impl/marching_cubes_table.h"
+#include "nvblox/mesh/internal/marching_cubes.h"
+#include "nvblox/mesh/mesh_integrator.h"
+#include "nvblox/utils/timing.h"
+
+namespace nvblox {
+
+// Fused marching cubes
+//
+// A single kernel meshes each block (one thread block per TSDF block, one
+// thread per cube) in the following steps, separated by block-wide barriers
+// rather than by kernel launches and host synchronizations:
+// 1. Meshability: The block is skipped if no voxel is close to the surface.
+// 2. Classification: Each cube looks up its marching cubes table index.
+// 3. Welding (optional): Each triangle vertex lies on a voxel grid edge. Each
+//    edge is owned by a single cube of the block and the cubes using an edge
+//    mark it at its owner. This gives the number of unique vertices per cube.
+// 4. Prefix sums: Warp-based block scans of the per-cube vertex and triangle
+//    counts give each cube its output offsets. The block claims space for its
+//    mesh in the staging arena with a single atomic.
+// 5. Emission: Cubes write their vertices and triangles into the arena.
+// The output order follows the scan, such that meshing is deterministic
+// (up to the summation order of welded normals).
+
+constexpr int kFusedVoxelsPerSide = TsdfBlock::kVoxelsPerSide;
+constexpr int kFusedThreadBlockDepth = TsdfBlock::kThreadBlockDepth;
+// The cubes processed by each thread, see forEachVoxelInThread().
+constexpr int kFusedVoxelsPerThread =
+    kFusedVoxelsPerSide / kFusedThreadBlockDepth;
+constexpr int kFusedCubeNeighbors = 8;
+
+__device__ inline int linearCubeIndex(const Index3D& voxel_index) {
+  return voxel_index.z() +
+         kFusedVoxelsPerSide *
+             (voxel_index.y() + kFusedVoxelsPerSide * voxel_index.x());
+}
+
+// Gets a voxel by its index relative to the block, in
+// [0, kVoxelsPerSide]^3. Voxels outside the block are looked up in the
+// (positive) neighbors, which may be missing.
+__device__ inline const TsdfVoxel* getVoxelInNeighborhood(
+    const TsdfBlock* const* neighborhood, Index3D voxel_index) {
+  Index3D block_offset(0, 0, 0);
+  for (int i = 0; i < 3; i++) {
+    if (voxel_index[i] >= kFusedVoxelsPerSide) {
+      voxel_index[i] -= kFusedVoxelsPerSide;
+      block_offset[i] = 1;
+    }
+  }
+  const TsdfBlock* block =
+      neighborhood[marching_cubes::neighborIndexFromDirection(block_offset)];
+  if (block == nullptr) {
+    return nullptr;
+  }
+  return &block->voxels[voxel_index.x()][voxel_index.y()][voxel_index.z()];
+}
+
+__device__ inline Vector3f getVoxelCenterInNeighborhood(
+    const Vector3f& block_position, const Index3D& voxel_index,
+    const float voxel_size) {
+  return block_position +
+         voxel_size * (voxel_index.cast<float>() + Vector3f(0.5f, 0.5f, 0.5f));
+}
+
+// Loads the corners of the cube at a voxel.
+// @return False if a corner is missing or unobserved, i.e. the cube is not
+// meshed.
+__device__ bool loadCube(const TsdfBlock* const* neighborhood,
+                         const Vector3f& block_position,
+                         const Index3D& voxel_index, const float voxel_size,
+                         const float min_weight,
+                         marching_cubes::PerVoxelMarchingCubesResults* cube) {
+  for (int i = 0; i < 8; i++) {
+    const Index3D corner_index =
+        voxel_index + Index3D(marching_cubes::kCornerIndexOffsets[i][0],
+                              marching_cubes::kCornerIndexOffsets[i][1],
+                              marching_cubes::kCornerIndexOffsets[i][2]);
+    const TsdfVoxel* voxel = getVoxelInNeighborhood(neighborhood, corner_index);
+    if (voxel == nullptr || voxel->weight < min_weight) {
+      return false;
+    }
+    cube->vertex_sdf[i] = voxel->distance;
+    cube->vertex_coords[i] =
+        getVoxelCenterInNeighborhood(block_position, corner_index, voxel_size);
+  }
+  cube->contains_mesh = true;
+  cube->marching_cubes_table_index =
+      marching_cubes::calculateVertexConfiguration(cube->vertex_sdf);
+  return true;
+}
+
+// The corner of a cube edge closest to the cube origin, and the edge's axis.
+__device__ inline void getEdgeStartAndAxis(const int edge, Index3D* start,
+                                           int* axis) {
+  const uint8_t* corner_0 =
+      marching_cubes::kCornerIndexOffsets[marching_cubes::kEdgeIndexPairs
+                                              [edge][0]];
+  const uint8_t* corner_1 =
+      marching_cubes::kCornerIndexOffsets[marching_cubes::kEdgeIndexPairs
+                                              [edge][1]];
+  for (int i = 0; i < 3; i++) {
+    (*start)[i] = min(corner_0[i], corner_1[i]);
+    if (corner_0[i] != corner_1[i]) {
+      *axis = i;
+    }
+  }
+}
+
+__device__ inline int getEdgeFromStartAndAxis(const Index3D& start,
+                                              const int axis) {
+  for (int edge = 0; edge < 12; edge++) {
+    Index3D edge_start;
+    int edge_axis;
+    getEdgeStartAndAxis(edge, &edge_start, &edge_axis);
+    if (edge_axis == axis && edge_start == start) {
+      return edge;
+    }
+  }
+  return -1;
+}
+
+// Finds the cube owning an edge of a cube. This is the cube starting at the
+// edge start or, for edges on the positive faces of the block, the closest
+// cube inside the block.
+// @param voxel_index The cube.
+// @param edge The edge, in the cube's numbering.
+// @param owner_index The linear index of the owner.
+// @param owner_edge The edge, in the owner's numbering.
+__device__ inline void getEdgeOwner(const Index3D& voxel_index, const int edge,
+                                    int* owner_index, int* owner_edge) {
+  Index3D start;
+  int axis;
+  getEdgeStartAndAxis(edge, &start, &axis);
+  start += voxel_index;
+  Index3D owner;
+  for (int i = 0; i < 3; i++) {
+    owner[i] = min(start[i], kFusedVoxelsPerSide - 1);
+  }
+  *owner_index = linearCubeIndex(owner);
+  *owner_edge = getEdgeFromStartAndAxis(start - owner, axis);
+}
+
+// The index of the (welded) vertex on an edge of a cube. Owners number their
+// vertices in the order of their edges.
+__device__ inline int getWeldedVertexIndex(const Index3D& voxel_index,
+                                           const int edge,
+                                           const unsigned int* edge_masks,
+                                           const int* vertex_starts) {
+  int owner_index;
+  int owner_edge;
+  getEdgeOwner(voxel_index, edge, &owner_index, &owner_edge);
+  return vertex_starts[owner_index] +
+         __popc(edge_masks[owner_index] & ((1u << owner_edge) - 1u));
+}
+
+// Meshes blocks into a staging arena.
+//
+// Number of blocks:  One per TSDF block.
+// Number of threads: voxelBlockThreadsPerBlock()
+//
+// @param neighborhoods      Pointers to each block and its 7 positive
+//                           neighbors (see neighborIndexFromDirection()).
+//                           Size: 8 * num_blocks
+// @param block_positions    The position of each block. Size: num_blocks
+// @param voxel_size         The voxel size
+// @param min_weight         The minimum weight of voxels to mesh
+// @param cutoff_distance    The distance within which a block has to have a
+//                           voxel to be meshed
+// @param vertex_capacity    Size of the staged vertices and normals
+// @param triangle_capacity  Size of the staged triangles
+// @param vertices           Output staged vertices
+// @param normals            Output staged normals. Not normalized if welding.
+// @param triangles          Output staged triangle indices, local to a block
+// @param ends               Output number of staged vertices and triangle
+//                           indices. Must be zero on launch. Size: 2
+// @param ranges             Output range of each block in the staging arena.
+//                           Only the sizes are valid if the arena is too
+//                           small. Size: num_blocks
+template <bool kWeldVertices>
+__global__ void meshBlocksFusedKernel(
+    const TsdfBlock** neighborhoods, const Vector3f* block_positions,
+    const float voxel_size, const float min_weight,
+    const float cutoff_distance, const int vertex_capacity,
+    const int triangle_capacity, Vector3f* vertices, Vector3f* normals,
+    int* triangles, int* ends, MeshArenaRange* ranges) {
+  typedef cub::BlockScan<int, kFusedVoxelsPerSide, cub::BLOCK_SCAN_WARP_SCANS,
+                         kFusedVoxelsPerSide, kFusedThreadBlockDepth>
+      BlockScanT;
+  __shared__ typename BlockScanT::TempStorage scan_storage;
+  __shared__ int output_offsets[2];
+  // Welding only: The edges of each cube with a vertex, and the index of the
+  // first of these vertices.
+  constexpr int kNumWeldingCubes = kWeldVertices ? TsdfBlock::kNumVoxels : 1;
+  __shared__ unsigned int edge_masks[kNumWeldingCubes];
+  __shared__ int welded_vertex_starts[kNumWeldingCubes];
+
+  const int block_index = blockIdx.x;
+  const TsdfBlock* const* neighborhood =
+      neighborhoods + block_index * kFusedCubeNeighbors;
+  const Vector3f block_position = block_positions[block_index];
+  const bool is_first_thread =
+      threadIdx.x == 0 && threadIdx.y == 0 && threadIdx.z == 0;
+
+  Index3D voxel_indices[kFusedVoxelsPerThread];
+  for (int k = 0; k < kFusedVoxelsPerThread; k++) {
+    voxel_indices[k] = Index3D(threadIdx.z + k * kFusedThreadBlockDepth,
+                               threadIdx.y, threadIdx.x);
+  }
+
+  // 1. Skip blocks without voxels close to the surface.
+  bool thread_is_meshable = false;
+  for (int k = 0; k < kFusedVoxelsPerThread; k++) {
+    const TsdfVoxel& voxel =
+        neighborhood[0]->voxels[voxel_indices[k].x()][voxel_indices[k].y()]
+                               [voxel_indices[k].z()];
+    const float distance = voxel.distance;
+    if (fabs(distance) <= cutoff_distance && voxel.weight >= min_weight) {
+      thread_is_meshable = true;
+    }
+  }
+  if (!__syncthreads_or(thread_is_meshable)) {
+    if (is_first_thread) {
+      ranges[block_index] = MeshArenaRange();
+    }
+    return;
+  }
+
+  // 2. Classify the cubes.
+  uint8_t table_indices[kFusedVoxelsPerThread];
+  int num_triangle_indices[kFusedVoxelsPerThread];
+  int num_vertices[kFusedVoxelsPerThread];
+  marching_cubes::PerVoxelMarchingCubesResults cube;
+  for (int k = 0; k < kFusedVoxelsPerThread; k++) {
+    table_indices[k] = 0;
+    if (loadCube(neighborhood, block_position, voxel_indices[k], voxel_size,
+                 min_weight, &cube)) {
+      table_indices[k] = cube.marching_cubes_table_index;
+    }
+    num_triangle_indices[k] =
+        3 * marching_cubes::kNumTrianglesTable[table_indices[k]];
+    num_vertices[k] = num_triangle_indices[k];
+  }
+
+  // 3. Mark the edges with a vertex at their owners.
+  if constexpr (kWeldVertices) {
+    for (int k = 0; k < kFusedVoxelsPerThread; k++) {
+      edge_masks[linearCubeIndex(voxel_indices[k])] = 0;
+    }
+    __syncthreads();
+    for (int k = 0; k < kFusedVoxelsPerThread; k++) {
+      const int8_t* table_row =
+          marching_cubes::kTriangleTable[table_indices[k]];
+      for (int i = 0; i < num_triangle_indices[k]; i++) {
+        int owner_index;
+        int owner_edge;
+        getEdgeOwner(voxel_indices[k], table_row[i], &owner_index,
+                     &owner_edge);
+        atomicOr(&edge_masks[owner_index], 1u << owner_edge);
+      }
+    }
+    __syncthreads();
+    for (int k = 0; k < kFusedVoxelsPerThread; k++) {
+      num_vertices[k] = __popc(edge_masks[linearCubeIndex(voxel_indices[k])]);
+    }
+  }
+
+  // 4. Compute the output offsets of the cubes and claim space in the arena.
+  int vertex_starts[kFusedVoxelsPerThread];
+  int triangle_starts[kFusedVoxelsPerThread];
+  int block_num_vertices;
+  int block_num_triangle_indices;
+  BlockScanT(scan_storage)
+      .ExclusiveSum(num_vertices, vertex_starts, block_num_vertices);
+  __syncthreads();
+  BlockScanT(scan_storage)
+      .ExclusiveSum(num_triangle_indices, triangle_starts,
+                    block_num_triangle_indices);
+  if (is_first_thread) {
+    MeshArenaRange range;
+    if (block_num_triangle_indices > 0) {
+      range.vertex_offset = atomicAdd(&ends[0], block_num_vertices);
+      range.triangle_offset = atomicAdd(&ends[1], block_num_triangle_indices);
+    }
+    range.num_vertices = block_num_vertices;
+    range.vertex_capacity = block_num_vertices;
+    range.num_triangle_indices = block_num_triangle_indices;
+    range.triangle_capacity = block_num_triangle_indices;
+    ranges[block_index] = range;
+    output_offsets[0] = range.vertex_offset;
+    output_offsets[1] = range.triangle_offset;
+  }
+  __syncthreads();
+  const int vertex_offset = output_offsets[0];
+  const int triangle_offset = output_offsets[1];
+  if (block_num_triangle_indices == 0 ||
+      vertex_offset + block_num_vertices > vertex_capacity ||
+      triangle_offset + block_num_triangle_indices > triangle_capacity) {
+    // Nothing to output, or the arena is too small. In the latter case the
+    // host grows the arena and meshes again.
+    return;
+  }
+
+  // 5. Emit the mesh.
+  if constexpr (!kWeldVertices) {
+    // Three vertices per triangle, as in the separate passes.
+    CudaMeshBlock output;
+    output.vertices = vertices + vertex_offset;
+    output.normals = normals + vertex_offset;
+    output.triangles = triangles + triangle_offset;
+    for (int k = 0; k < kFusedVoxelsPerThread; k++) {
+      if (num_triangle_indices[k] > 0 &&
+          loadCube(neighborhood, block_position, voxel_indices[k], voxel_size,
+                   min_weight, &cube)) {
+        cube.vertex_vector_start_index = vertex_starts[k];
+        marching_cubes::calculateVertices(cube, &output);
+      }
+    }
+  } else {
+    // Owners write their vertices, welded normals start at zero.
+    for (int k = 0; k < kFusedVoxelsPerThread; k++) {
+      const int cube_index = linearCubeIndex(voxel_indices[k]);
+      welded_vertex_starts[cube_index] = vertex_starts[k];
+      unsigned int edge_mask = edge_masks[cube_index];
+      int vertex_index = vertex_offset + vertex_starts[k];
+      while (edge_mask != 0) {
+        const int edge = __ffs(edge_mask) - 1;
+        edge_mask &= edge_mask - 1;
+        Index3D start;
+        int axis;
+        getEdgeStartAndAxis(edge, &start, &axis);
+        start += voxel_indices[k];
+        Index3D end = start;
+        end[axis] += 1;
+        // Both voxels exist and are observed, as the edge is part of a
+        // meshed cube.
+        const TsdfVoxel* start_voxel =
+            getVoxelInNeighborhood(neighborhood, start);
+        const TsdfVoxel* end_voxel = getVoxelInNeighborhood(neighborhood, end);
+        vertices[vertex_index] = marching_cubes::interpolateVertex(
+            getVoxelCenterInNeighborhood(block_position, start, voxel_size),
+            getVoxelCenterInNeighborhood(block_position, end, voxel_size),
+            start_voxel->distance, end_voxel->distance);
+        normals[vertex_index] = Vector3f::Zero();
+        ++vertex_index;
+      }
+    }
+    __syncthreads();
+
+    // Cubes write their triangles and add the (area weighted) face normals
+    // to their vertices.
+    for (int k = 0; k < kFusedVoxelsPerThread; k++) {
+      const int8_t* table_row =
+          marching_cubes::kTriangleTable[table_indices[k]];
+      int triangle_index = triangle_offset + triangle_starts[k];
+      for (int i = 0; i < num_triangle_indices[k]; i += 3) {
+        // Same winding as marching_cubes::calculateVertices().
+        int triangle[3];
+        for (int j = 0; j < 3; j++) {
+          triangle[j] =
+              getWeldedVertexIndex(voxel_indices[k], table_row[i + 2 - j],
+                                   edge_masks, welded_vertex_starts);
+          triangles[triangle_index + j] = triangle[j];
+        }
+        const Vector3f& p0 = vertices[vertex_offset + triangle[0]];
+        const Vector3f& p1 = vertices[vertex_offset + triangle[1]];
+        const Vector3f& p2 = vertices[vertex_offset + triangle[2]];
+        const Vector3f face_normal = (p1 - p0).cross(p2 - p0);
+        for (int j = 0; j < 3; j++) {
+          Vector3f& normal = normals[vertex_offset + triangle[j]];
+          atomicAdd(&normal.x(), face_normal.x());
+          atomicAdd(&normal.y(), face_normal.y());
+          atomicAdd(&normal.z(), face_normal.z());
+        }
+        triangle_index += 3;
+      }
+    }
+  }
+}
+
+// Copies the meshes from the staging arena into the mesh blocks.
+//
+// Number of blocks:  One per mesh block.
+// Number of threads: Can be any positive value.
+//
+// @param ranges             The range of each block in the arena.
+// @param vertices           Staged vertices
+// @param normals            Staged normals
+// @param triangles          Staged triangle indices
+// @param normalize_normals  Whether to normalize the staged normals.
+// @param color_blocks       The color block co-located with each mesh block
+//                           (which may be null), or null to not color the
+//                           mesh blocks.
+// @param block_positions    The position of each block.
+// @param voxel_size         The voxel size
+// @param default_color      The color of blocks without a color block.
+// @param mesh_blocks        The output blocks. Blocks without vertices are
+//                           skipped.
+__global__ void copyStagedMeshesToBlocksKernel(
+    const MeshArenaRange* ranges, const Vector3f* vertices,
+    const Vector3f* normals, const int* triangles,
+    const bool normalize_normals, const ColorBlock* const* color_blocks,
+    const Vector3f* block_positions, const float voxel_size,
+    const Color default_color, CudaMeshBlock* mesh_blocks) {
+  const MeshArenaRange& range = ranges[blockIdx.x];
+  CudaMeshBlock& mesh_block = mesh_blocks[blockIdx.x];
+  if (mesh_block.vertices_size == 0) {
+    return;
+  }
+  const ColorBlock* color_block =
+      color_blocks != nullptr ? color_blocks[blockIdx.x] : nullptr;
+  const Vector3f block_position = block_positions[blockIdx.x];
+  for (int i = threadIdx.x; i < range.num_vertices; i += blockDim.x) {
+    const Vector3f& vertex = vertices[range.vertex_offset + i];
+    mesh_block.vertices[i] = vertex;
+    const Vector3f& normal = normals[range.vertex_offset + i];
+    mesh_block.normals[i] = normalize_normals ? normal.normalized() : normal;
+    // The colors are looked up while the vertex is at hand, which saves
+    // coloring the blocks in a separate pass.
+    if (color_blocks != nullptr) {
+      mesh_block.colors[i] = getClosestVoxelColorInBlock(
+          color_block, block_position, vertex, voxel_size, default_color);
+    }
+  }
+  for (int i = threadIdx.x; i < range.num_triangle_indices; i += blockDim.x) {
+    mesh_block.triangles[i] = triangles[range.triangle_offset + i];
+  }
+}
+
+void MeshIntegrator::meshBlocksFusedGPU(
+    const TsdfLayer& distance_layer, const std::vector<Index3D>& block_indices,
+    float cutoff_distance, BlockLayer<MeshBlock>* mesh_layer,
+    const ColorLayer* color_layer) {
+  if (block_indices.empty()) {
+    return;
+  }
+  timing::Timer prep_timer("mesh/gpu/mesh_blocks_fused/prep");
+  const int num_blocks = block_indices.size();
+
+  // Get all the block pointers and positions.
+  getBlockNeighborhoodsAsync(distance_layer, block_indices);
+
+  // Start with room for a plane through each block. The arena grows if the
+  // mesh turns out to be larger.
+  constexpr int kInitialStagedElementsPerBlock =
+      6 * kFusedVoxelsPerSide * kFusedVoxelsPerSide;
+  const int initial_staged_elements =
+      num_blocks * kInitialStagedElementsPerBlock;
+  if (staged_vertices_.size() < static_cast<size_t>(initial_staged_elements)) {
+    staged_vertices_.resizeAsync(initial_staged_elements, *cuda_stream_);
+    staged_normals_.resizeAsync(initial_staged_elements, *cuda_stream_);
+  }
+  if (staged_triangles_.size() <
+      static_cast<size_t>(initial_staged_elements)) {
+    staged_triangles_.resizeAsync(initial_staged_elements, *cuda_stream_);
+  }
+  staged_ranges_device_.resizeAsync(num_blocks, *cuda_stream_);
+  staged_ends_device_.resizeAsync(2, *cuda_stream_);
+  mesh_blocks_host_.resizeAsync(num_blocks, *cuda_stream_);
+  mesh_blocks_host_.setZeroAsync(*cuda_stream_);
+  if (color_layer != nullptr) {
+    CHECK_EQ(color_layer->block_size(), mesh_layer->block_size());
+    color_block_ptrs_host_.resizeAsync(num_blocks, *cuda_stream_);
+    color_block_ptrs_host_.setZeroAsync(*cuda_stream_);
+  }
+  prep_timer.Stop();
+
+  // Mesh into the staging arena.
+  timing::Timer kernel_timer("mesh/gpu/mesh_blocks_fused/kernel");
+  while (true) {
+    const int vertex_capacity = staged_vertices_.size();
+    const int triangle_capacity = staged_triangles_.size();
+    staged_ends_device_.setZeroAsync(*cuda_stream_);
+    if (weld_vertices_) {
+      meshBlocksFusedKernel<true>
+          <<<num_blocks, voxelBlockThreadsPerBlock(), 0, *cuda_stream_>>>(
+              block_ptrs_device_.data(), block_positions_device_.data(),
+              distance_layer.voxel_size(), min_weight_, cutoff_distance,
+              vertex_capacity, triangle_capacity, staged_vertices_.data(),
+              staged_normals_.data(), staged_triangles_.data(),
+              staged_ends_device_.data(), staged_ranges_device_.data());
+    } else {
+      meshBlocksFusedKernel<false>
+          <<<num_blocks, voxelBlockThreadsPerBlock(), 0, *cuda_stream_>>>(
+              block_ptrs_device_.data(), block_positions_device_.data(),
+              distance_layer.voxel_size(), min_weight_, cutoff_distance,
+              vertex_capacity, triangle_capacity, staged_vertices_.data(),
+              staged_normals_.data(), staged_triangles_.data(),
+              staged_ends_device_.data(), staged_ranges_device_.data());
+    }
+    checkCudaErrors(cudaPeekAtLastError());
+
+    // The only wait on the GPU before output: the mesh sizes.
+    staged_ends_host_.copyFromAsync(staged_ends_device_, *cuda_stream_);
+    staged_ranges_host_.copyFromAsync(staged_ranges_device_, *cuda_stream_);
+    cuda_stream_->synchronize();
+    const int num_staged_vertices = staged_ends_host_[0];
+    const int num_staged_triangle_indices = staged_ends_host_[1];
+    if (num_staged_vertices <= vertex_capacity &&
+        num_staged_triangle_indices <= triangle_capacity) {
+      break;
+    }
+
+    // The arena was too small. Grow it and mesh again. Since the sizes are
+    // now known, this happens at most once per call.
+    constexpr int kStagingGrowthFactor = 2;
+    VLOG(1) << "Growing the mesh staging arena to "
+            << kStagingGrowthFactor * num_staged_vertices << " vertices.";
+    if (num_staged_vertices > vertex_capacity) {
+      staged_vertices_.resizeAsync(kStagingGrowthFactor * num_staged_vertices,
+                                   *cuda_stream_);
+      staged_normals_.resizeAsync(kStagingGrowthFactor * num_staged_vertices,
+                                  *cuda_stream_);
+    }
+    if (num_staged_triangle_indices > triangle_capacity) {
+      staged_triangles_.resizeAsync(
+          kStagingGrowthFactor * num_staged_triangle_indices, *cuda_stream_);
+    }
+  }
+  kernel_timer.Stop();
+
+  // Allocate mesh blocks
+  timing::Timer allocation_timer(
+      "mesh/gpu/mesh_blocks_fused/block_allocation");
+  for (int i = 0; i < num_blocks; i++) {
+    const MeshArenaRange& range = staged_ranges_host_[i];
+    if (range.num_triangle_indices == 0) {
+      continue;
+    }
+    MeshBlock* output_block =
+        allocateMeshBlockAsync(block_indices[i], range.num_vertices,
+                               range.num_triangle_indices, mesh_layer);
+    if (output_block == nullptr) {
+      continue;
+    }
+    if (color_layer != nullptr) {
+      output_block->expandColorsToMatchVerticesAsync(*cuda_stream_);
+      color_block_ptrs_host_[i] =
+          color_layer->getBlockAtIndex(block_indices[i]).get();
+    }
+    mesh_blocks_host_[i] = CudaMeshBlock(output_block);
+  }
+  mesh_blocks_device_.copyFromAsync(mesh_blocks_host_, *cuda_stream_);
+  if (color_layer != nullptr) {
+    color_block_ptrs_device_.copyFromAsync(color_block_ptrs_host_,
+                                           *cuda_stream_);
+  }
+  allocation_timer.Stop();
+
+  // Copy the staged meshes into the blocks.
+  timing::Timer copy_timer("mesh/gpu/mesh_blocks_fused/copy_to_blocks");
+  constexpr int kNumThreads = 128;
+  copyStagedMeshesToBlocksKernel<<<num_blocks, kNumThreads, 0,
+                                   *cuda_stream_>>>(
+      staged_ranges_device_.data(), staged_vertices_.data(),
+      staged_normals_.data(), staged_triangles_.data(), weld_vertices_,
+      color_layer != nullptr ? color_block_ptrs_device_.data() : nullptr,
+      block_positions_device_.data(), distance_layer.voxel_size(),
+      default_mesh_color_, mesh_blocks_device_.data());
+  checkCudaErrors(cudaPeekAtLastError());
+  cuda_stream_->synchronize();
+  copy_timer.Stop();
+}
+
+}  // namespace nvblox
@@ -0,0 +1,418 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "nvblox/primitives/scene_renderer_gpu.h"
+
+#include <cfloat>
+
+#include "nvblox/core/indexing.h"
+#include "nvblox/core/internal/error_check.h"
+#include "nvblox/geometry/bounding_boxes.h"
+#include "nvblox/integrators/internal/integrators_common.h"
+#include "nvblox/map/internal/cuda/voxel_block_threads.cuh"
+#include "nvblox/utils/timing.h"
+
+namespace nvblox {
+namespace primitives {
+namespace {
+
+// The functions below are GPU versions of the methods of the Primitives. See
+// primitives.cpp for references.
+
+__device__ inline float getDistanceToPoint(const PrimitiveDescriptor& primitive,
+                                           const Vector3f& point) {
+  const Vector3f& center = primitive.center;
+  switch (primitive.type) {
+    case Primitive::Type::kSphere:
+      return (center - point).norm() - primitive.parameters.x();
+    case Primitive::Type::kCube: {
+      const Vector3f half_size = primitive.parameters / 2.0f;
+      const Vector3f below = center - half_size - point;
+      const Vector3f above = point - center - half_size;
+      const float distance =
+          below.cwiseMax(above).cwiseMax(Vector3f::Zero()).norm();
+      // Basically 0... Means it's inside!
+      if (distance < Primitive::kEpsilon) {
+        return below.cwiseMax(above).maxCoeff();
+      }
+      return distance;
+    }
+    case Primitive::Type::kPlane: {
+      const Vector3f& normal = primitive.parameters;
+      return normal.dot(point) - normal.dot(center) / normal.norm();
+    }
+    case Primitive::Type::kCylinder: {
+      const float radius = primitive.parameters.x();
+      const float height = primitive.parameters.y();
+      const float min_z_limit = center.z() - height / 2.0f;
+      const float max_z_limit = center.z() + height / 2.0f;
+      const float squared_distance_xy =
+          (point.head<2>() - center.head<2>()).squaredNorm();
+      if (point.z() >= min_z_limit && point.z() <= max_z_limit) {
+        return sqrtf(squared_distance_xy) - radius;
+      }
+      const float distance_z = (point.z() > max_z_limit)
+                                   ? point.z() - max_z_limit
+                                   : point.z() - min_z_limit;
+      return sqrtf(fmaxf(squared_distance_xy - radius * radius, 0.0f) +
+                   distance_z * distance_z);
+    }
+    default:
+      return FLT_MAX;
+  }
+}
+
+__device__ inline bool getSphereIntersection(const Vector3f& center,
+                                             const float radius,
+                                             const Vector3f& ray_origin,
+                                             const Vector3f& ray_direction,
+                                             float* intersect_dist) {
+  const Vector3f origin_to_center = ray_origin - center;
+  const float direction_dot = ray_direction.dot(origin_to_center);
+  const float under_square_root = direction_dot * direction_dot -
+                                  origin_to_center.squaredNorm() +
+                                  radius * radius;
+  // No real roots = no intersection.
+  if (under_square_root < 0.0f) {
+    return false;
+  }
+  *intersect_dist = -direction_dot - sqrtf(under_square_root);
+  return true;
+}
+
+__device__ inline bool getCubeIntersection(const Vector3f& center,
+                                           const Vector3f& size,
+                                           const Vector3f& ray_origin,
+                                           const Vector3f& ray_direction,
+                                           float* intersect_dist) {
+  const Vector3f inv_dir = ray_direction.cwiseInverse();
+  const Vector3f bounds[2] = {center - size / 2.0f, center + size / 2.0f};
+  float tmin = -FLT_MAX;
+  float tmax = FLT_MAX;
+  for (int i = 0; i < 3; ++i) {
+    const int sign = inv_dir[i] < 0.0f;
+    const float t_min_axis = (bounds[sign][i] - ray_origin[i]) * inv_dir[i];
+    const float t_max_axis =
+        (bounds[1 - sign][i] - ray_origin[i]) * inv_dir[i];
+    if ((tmin > t_max_axis) || (t_min_axis > tmax)) {
+      return false;
+    }
+    tmin = fmaxf(tmin, t_min_axis);
+    tmax = fminf(tmax, t_max_axis);
+  }
+  *intersect_dist = (tmin < 0.0f) ? tmax : tmin;
+  return true;
+}
+
+__device__ inline bool getPlaneIntersection(const Vector3f& center,
+                                            const Vector3f& normal,
+                                            const Vector3f& ray_origin,
+                                            const Vector3f& ray_direction,
+                                            float* intersect_dist) {
+  const float denominator = ray_direction.dot(normal);
+  if (fabsf(denominator) < Primitive::kEpsilon) {
+    // Lines are parallel, no intersection.
+    return false;
+  }
+  *intersect_dist = (center - ray_origin).dot(normal) / denominator;
+  return true;
+}
+
+__device__ inline bool getCylinderIntersection(const Vector3f& center,
+                                               const float radius,
+                                               const float height,
+                                               const Vector3f& ray_origin,
+                                               const Vector3f& ray_direction,
+                                               const float max_dist,
+                                               float* intersect_dist) {
+  const Vector3f vector_E = ray_origin - center;
+  const Vector3f& vector_D = ray_direction;
+  const float a = vector_D.x() * vector_D.x() + vector_D.y() * vector_D.y();
+  const float b =
+      2.0f * vector_E.x() * vector_D.x() + 2.0f * vector_E.y() * vector_D.y();
+  const float c = vector_E.x() * vector_E.x() + vector_E.y() * vector_E.y() -
+                  radius * radius;
+  // Make sure we don't divide by 0.
+  if (fabsf(a) < Primitive::kEpsilon) {
+    return false;
+  }
+  const float under_square_root = b * b - 4.0f * a * c;
+  if (under_square_root < 0.0f) {
+    return false;
+  }
+  float t1 = -1.0f;
+  float t2 = -1.0f;
+  if (under_square_root <= Primitive::kEpsilon) {
+    t1 = -b / (2.0f * a);
+  } else {
+    t1 = (-b + sqrtf(under_square_root)) / (2.0f * a);
+    t2 = (-b - sqrtf(under_square_root)) / (2.0f * a);
+  }
+
+  // The mantle hits, then the end caps.
+  float t = max_dist;
+  bool valid = false;
+  auto add_candidate = [&t, &valid](const float candidate) {
+    valid = true;
+    t = fminf(t, candidate);
+  };
+  const float z1 = vector_E.z() + t1 * vector_D.z();
+  const float z2 = vector_E.z() + t2 * vector_D.z();
+  if (t1 >= 0.0f && z1 >= -height / 2.0f && z1 <= height / 2.0f) {
+    add_candidate(t1);
+  }
+  if (t2 >= 0.0f && z2 >= -height / 2.0f && z2 <= height / 2.0f) {
+    add_candidate(t2);
+  }
+  if (fabsf(vector_D.z()) > Primitive::kEpsilon) {
+    const float t3 = (-height / 2.0f - vector_E.z()) / vector_D.z();
+    const float t4 = (height / 2.0f - vector_E.z()) / vector_D.z();
+    if (t3 >= 0.0f && (vector_E + t3 * vector_D).head<2>().norm() < radius) {
+      add_candidate(t3);
+    }
+    if (t4 >= 0.0f && (vector_E + t4 * vector_D).head<2>().norm() < radius) {
+      add_candidate(t4);
+    }
+  }
+  if (!valid || t >= max_dist) {
+    return false;
+  }
+  *intersect_dist = t;
+  return true;
+}
+
+// Returns whether the ray hits the primitive in [0, max_dist].
+__device__ inline bool getRayIntersection(const PrimitiveDescriptor& primitive,
+                                          const Vector3f& ray_origin,
+                                          const Vector3f& ray_direction,
+                                          const float max_dist,
+                                          float* intersect_dist) {
+  bool intersects = false;
+  switch (primitive.type) {
+    case Primitive::Type::kSphere:
+      intersects = getSphereIntersection(primitive.center,
+                                         primitive.parameters.x(), ray_origin,
+                                         ray_direction, intersect_dist);
+      break;
+    case Primitive::Type::kCube:
+      intersects = getCubeIntersection(primitive.center, primitive.parameters,
+                                       ray_origin, ray_direction,
+                                       intersect_dist);
+      break;
+    case Primitive::Type::kPlane:
+      intersects = getPlaneIntersection(primitive.center, primitive.parameters,
+                                        ray_origin, ray_direction,
+                                        intersect_dist);
+      break;
+    case Primitive::Type::kCylinder:
+      intersects = getCylinderIntersection(
+          primitive.center, primitive.parameters.x(), primitive.parameters.y(),
+          ray_origin, ray_direction, max_dist, intersect_dist);
+      break;
+    default:
+      break;
+  }
+  return intersects && *intersect_dist >= 0.0f && *intersect_dist <= max_dist;
+}
+
+__global__ void generateDepthImageKernel(const PrimitiveDescriptor* primitives,
+                                         const int num_primitives,
+                                         const Camera camera,
+                                         const Transform T_S_C,
+                                         const float max_dist,
+                                         const float invalid_depth,
+                                         const int stride_num_elements,
+                                         float* depth_image) {
+  const int col = blockIdx.x * blockDim.x + threadIdx.x;
+  const int row = blockIdx.y * blockDim.y + threadIdx.y;
+  if (col >= camera.width() || row >= camera.height()) {
+    return;
+  }
+  // Get the ray going through this pixel.
+  const Vector3f ray_origin = T_S_C.translation();
+  const Vector3f ray_direction =
+      T_S_C.linear() *
+      camera.vectorFromPixelIndices(Index2D(col, row)).normalized();
+  // Get the first intersection of the ray.
+  bool ray_valid = false;
+  float ray_dist = max_dist;
+  for (int i = 0; i < num_primitives; ++i) {
+    float primitive_dist;
+    if (getRayIntersection(primitives[i], ray_origin, ray_direction, max_dist,
+                           &primitive_dist) &&
+        (!ray_valid || primitive_dist < ray_dist)) {
+      ray_valid = true;
+      ray_dist = primitive_dist;
+    }
+  }
+  // The depth is the z coordinate of the intersection in the camera frame.
+  const Vector3f ray_direction_C = T_S_C.linear().transpose() * ray_direction;
+  depth_image[row * stride_num_elements + col] =
+      ray_valid ? ray_dist * ray_direction_C.z() : invalid_depth;
+}
+
+__global__ void generateTsdfLayerKernel(const PrimitiveDescriptor* primitives,
+                                        const int num_primitives,
+                                        const Index3D* block_indices,
+                                        const float block_size,
+                                        const Vector3f aabb_min,
+                                        const Vector3f aabb_max,
+                                        const float max_dist,
+                                        TsdfBlock** block_ptrs) {
+  const Index3D block_idx = block_indices[blockIdx.x];
+  forEachVoxelInThread([&](const Index3D& voxel_idx) {
+    const Vector3f position = getCenterPositionFromBlockIndexAndVoxelIndex(
+        block_size, block_idx, voxel_idx);
+    if ((position.array() < aabb_min.array()).any() ||
+        (position.array() > aabb_max.array()).any()) {
+      return;
+    }
+    // Positive distances are truncated by starting at max_dist, negative
+    // ones explicitly.
+    float distance = max_dist;
+    for (int i = 0; i < num_primitives; ++i) {
+      distance = fminf(distance, getDistanceToPoint(primitives[i], position));
+    }
+    TsdfVoxel* voxel = &block_ptrs[blockIdx.x]
+                            ->voxels[voxel_idx.x()][voxel_idx.y()]
+                                    [voxel_idx.z()];
+    voxel->distance = fmaxf(distance, -max_dist);
+    // Just to make sure it gets visualized/meshed/etc.
+    voxel->weight = 1.0f;
+  });
+}
+
+}  // namespace
+
+std::vector<PrimitiveDescriptor> getPrimitiveDescriptors(const Scene& scene) {
+  std::vector<PrimitiveDescriptor> descriptors;
+  descriptors.reserve(scene.getPrimitives().size());
+  for (const std::unique_ptr<Primitive>& primitive : scene.getPrimitives()) {
+    PrimitiveDescriptor descriptor{primitive->getType(),
+                                   primitive->getCenter(), Vector3f::Zero()};
+    switch (primitive->getType()) {
+      case Primitive::Type::kSphere:
+        descriptor.parameters.x() =
+            static_cast<const Sphere*>(primitive.get())->getRadius();
+        break;
+      case Primitive::Type::kCube:
+        descriptor.parameters =
+            static_cast<const Cube*>(primitive.get())->getSize();
+        break;
+      case Primitive::Type::kPlane:
+        descriptor.parameters =
+            static_cast<const Plane*>(primitive.get())->getNormal();
+        break;
+      case Primitive::Type::kCylinder: {
+        const Cylinder* cylinder =
+            static_cast<const Cylinder*>(primitive.get());
+        descriptor.parameters.x() = cylinder->getRadius();
+        descriptor.parameters.y() = cylinder->getHeight();
+        break;
+      }
+      default:
+        LOG(FATAL) << "Primitive type not recognized.";
+        break;
+    }
+    descriptors.push_back(descriptor);
+  }
+  return descriptors;
+}
+
+SceneRendererGpu::SceneRendererGpu()
+    : SceneRendererGpu(std::make_shared<CudaStreamOwning>()) {}
+
+SceneRendererGpu::SceneRendererGpu(std::shared_ptr<CudaStream> cuda_stream)
+    : cuda_stream_(cuda_stream) {}
+
+void SceneRendererGpu::setScene(const Scene& scene) {
+  primitives_host_.copyFromAsync(getPrimitiveDescriptors(scene),
+                                 *cuda_stream_);
+  primitives_device_.copyFromAsync(primitives_host_, *cuda_stream_);
+  aabb_ = scene.aabb();
+  cuda_stream_->synchronize();
+}
+
+void SceneRendererGpu::generateDepthImageFromScene(const Camera& camera,
+                                                   const Transform& T_S_C,
+                                                   float max_dist,
+                                                   DepthImage* depth_frame,
+                                                   const float invalid_depth) {
+  timing::Timer timer("scene_renderer_gpu/generate_depth_image");
+  CHECK_NOTNULL(depth_frame);
+  CHECK(depth_frame->memory_type() != MemoryType::kHost)
+      << "For GPU scene generation the DepthImage must be GPU accessible "
+         "(MemoryType::kDevice or MemoryType::kUnified).";
+  CHECK_EQ(depth_frame->rows(), camera.height());
+  CHECK_EQ(depth_frame->cols(), camera.width());
+
+  constexpr int kThreadsPerBlockDim = 16;
+  const dim3 threads_per_block(kThreadsPerBlockDim, kThreadsPerBlockDim);
+  const dim3 num_blocks(
+      (camera.width() + kThreadsPerBlockDim - 1) / kThreadsPerBlockDim,
+      (camera.height() + kThreadsPerBlockDim - 1) / kThreadsPerBlockDim);
+  generateDepthImageKernel<<<num_blocks, threads_per_block, 0,
+                             *cuda_stream_>>>(
+      primitives_device_.data(),           // NOLINT
+      primitives_device_.size(),           // NOLINT
+      camera,                              // NOLINT
+      T_S_C,                               // NOLINT
+      max_dist,                            // NOLINT
+      invalid_depth,                       // NOLINT
+      depth_frame->stride_num_elements(),  // NOLINT
+      depth_frame->dataPtr());             // NOLINT
+  cuda_stream_->synchronize();
+  checkCudaErrors(cudaPeekAtLastError());
+}
+
+void SceneRendererGpu::generateLayerFromScene(float max_dist,
+                                              TsdfLayer* layer) {
+  timing::Timer timer("scene_renderer_gpu/generate_layer");
+  CHECK_NOTNULL(layer);
+  CHECK(layer->memory_type() != MemoryType::kHost)
+      << "For GPU scene generation the layer must be GPU accessible "
+         "(MemoryType::kDevice or MemoryType::kUnified).";
+
+  // First allocate all the blocks within the AABB.
+  const std::vector<Index3D> block_indices =
+      getBlockIndicesTouchedByBoundingBox(layer->block_size(), aabb_);
+  if (block_indices.empty()) {
+    return;
+  }
+  layer->allocateBlocksAtIndices(block_indices, *cuda_stream_);
+  block_ptrs_host_.copyFromAsync(
+      getBlockPtrsFromIndices(block_indices, layer, *cuda_stream_),
+      *cuda_stream_);
+  block_ptrs_device_.copyFromAsync(block_ptrs_host_, *cuda_stream_);
+  block_indices_host_.copyFromAsync(block_indices, *cuda_stream_);
+  block_indices_device_.copyFromAsync(block_indices_host_, *cuda_stream_);
+
+  const dim3 kThreadsPerBlock = voxelBlockThreadsPerBlock();
+  generateTsdfLayerKernel<<<block_indices.size(), kThreadsPerBlock, 0,
+                            *cuda_stream_>>>(
+      primitives_device_.data(),     // NOLINT
+      primitives_device_.size(),     // NOLINT
+      block_indices_device_.data(),  // NOLINT
+      layer->block_size(),           // NOLINT
+      aabb_.min(),                   // NOLINT
+      aabb_.max(),                   // NOLINT
+      max_dist,                      // NOLINT
+      block_ptrs_device_.data());    // NOLINT
+  cuda_stream_->synchronize();
+  checkCudaErrors(cudaPeekAtLastError());
+}
+
+}  // namespace primitives
+}  // namespace nvblox
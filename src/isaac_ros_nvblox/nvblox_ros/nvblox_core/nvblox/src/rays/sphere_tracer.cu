@@ -17,6 +17,9 @@ limitations under the License.
 #include <thrust/device_new.h>
 #include <thrust/device_ptr.h>
 
+#include <algorithm>
+
+#include "nvblox/core/internal/cuda/atomic_float.cuh"
 #include "nvblox/gpu_hash/internal/cuda/gpu_hash_interface.cuh"
 #include "nvblox/gpu_hash/internal/cuda/gpu_indexing.cuh"
 #include "nvblox/rays/sphere_tracer.h"
@@ -29,6 +32,29 @@ __device__ inline bool isTsdfVoxelValid(const TsdfVoxel& voxel) {
   return voxel.weight > kMinWeight;
 }
 
+// The distance along the ray from p_L = ray(t) to the boundary of the block
+// containing p_L.
+__device__ inline float distanceToBlockExit(const Ray& ray, float t,
+                                            float block_size_m) {
+  constexpr float kMinDirection = 1e-6f;
+  const Vector3f p_L = ray.pointAt(t);
+  const Index3D block_index =
+      getBlockIndexFromPositionInLayer(block_size_m, p_L);
+  // For a normalized direction the exit distance is at most the block
+  // diagonal, so this is an upper bound.
+  float distance = 2.0f * block_size_m;
+  for (int i = 0; i < 3; i++) {
+    const float direction = ray.direction()(i);
+    if (fabsf(direction) > kMinDirection) {
+      const int boundary_index =
+          (direction > 0.0f) ? block_index(i) + 1 : block_index(i);
+      const float boundary = static_cast<float>(boundary_index) * block_size_m;
+      distance = fminf(distance, (boundary - p_L(i)) / direction);
+    }
+  }
+  return distance;
+}
+
 __device__ thrust::pair<float, bool> cast(
     const Ray& ray,                                         // NOLINT
     const Index3DDeviceHashMapType<TsdfBlock>& block_hash,  // NOLINT
@@ -36,7 +62,9 @@ __device__ thrust::pair<float, bool> cast(
     float block_size_m,                                     // NOLINT
     int maximum_steps,                                      // NOLINT
     float maximum_ray_length_m,                             // NOLINT
-    float surface_distance_epsilon_m) {
+    float surface_distance_epsilon_m,                       // NOLINT
+    bool skip_unallocated_blocks,                           // NOLINT
+    float t_start = 0.0f) {
   // -------------------------------------------------------------------------
   // Approach: Step along the ray until we find the surface, or fail to find a
   // zero crossing.
@@ -48,7 +76,10 @@ __device__ thrust::pair<float, bool> cast(
 
   // t captures the parameter scaling along ray.direction. We assume
   // that the ray is normalized which such that t has units meters.
-  float t = 0.0f;
+  // A t_start > 0 is a warm start from a guess of the surface position,
+  // expected to be in front of the surface.
+  float t = t_start;
+  const bool warm_start = t_start > 0.0f;
   for (int i = 0; (i < maximum_steps) && (t < maximum_ray_length_m); i++) {
     // Current point to sample
     const Vector3f p_L = ray.origin() + t * ray.direction();
@@ -59,13 +90,22 @@ __device__ thrust::pair<float, bool> cast(
 
     // Try to get a distance from the layer.
     // If we can't get a distance, let's see what to do...
-    if (!getVoxelAtPosition(block_hash, p_L, block_size_m, &voxel_ptr) ||
-        !isTsdfVoxelValid(*voxel_ptr)) {
+    const bool block_allocated =
+        getVoxelAtPosition(block_hash, p_L, block_size_m, &voxel_ptr);
+    if (!block_allocated || !isTsdfVoxelValid(*voxel_ptr)) {
       // 1) We weren't in observed space before this, let's step through this
       // (unobserved) shit and hope to hit something allocated.
       if (first_valid_distance == FirstDistanceType::kNotYetKnown) {
         // step forward by the truncation distance
         step = truncation_distance_m;
+        // An unallocated block contains no surface, so we may jump to where
+        // the ray leaves it. The small extra distance ensures we land in the
+        // next block.
+        if (!block_allocated && skip_unallocated_blocks) {
+          constexpr float kBlockExitEpsilon = 1e-3f;
+          step = fmaxf(step, distanceToBlockExit(ray, t, block_size_m) +
+                                 kBlockExitEpsilon * block_size_m);
+        }
       }
       // 2) We were in observed space, now we've left it... let's kill this
       // ray, it's risky to continue.
@@ -83,6 +123,10 @@ __device__ thrust::pair<float, bool> cast(
       if (first_valid_distance == FirstDistanceType::kNotYetKnown) {
         if (voxel_ptr->distance >= 0.0f) {
           first_valid_distance = FirstDistanceType::kPositive;
+        } else if (warm_start) {
+          // We started behind a surface, so the guess was wrong. Let the
+          // caller fall back to a full march.
+          return {t, false};
         } else {
           first_valid_distance = FirstDistanceType::kNegative;
         }
@@ -140,13 +184,15 @@ __global__ void sphereTracingKernel(
     float block_size_m,                              // NOLINT
     int maximum_steps,                               // NOLINT
     float maximum_ray_length_m,                      // NOLINT
-    float surface_distance_epsilon_m) {
+    float surface_distance_epsilon_m,                // NOLINT
+    bool skip_unallocated_blocks) {
   const int idx = threadIdx.x + blockIdx.x * blockDim.x;
   if (idx != 0) return;
 
   thrust::pair<float, bool> res =
       cast(ray, block_hash, truncation_distance_m, block_size_m, maximum_steps,
-           maximum_ray_length_m, surface_distance_epsilon_m);
+           maximum_ray_length_m, surface_distance_epsilon_m,
+           skip_unallocated_blocks);
 
   *t = res.first;
   *success_flag = res.second;
@@ -162,7 +208,8 @@ __global__ void sphereTracingKernel(
     float block_size_m,                              // NOLINT
     int maximum_steps,                               // NOLINT
     float maximum_ray_length_m,                      // NOLINT
-    float surface_distance_epsilon_m) {
+    float surface_distance_epsilon_m,                // NOLINT
+    bool skip_unallocated_blocks) {
   // Extract a ray
   // NOTE(alexmillane): We expect this kernel to be called with sufficient
   // threads.
@@ -175,7 +222,8 @@ __global__ void sphereTracingKernel(
   // Cast
   const thrust::pair<float, bool> result =
       cast(ray_L, block_hash, truncation_distance_m, block_size_m,
-           maximum_steps, maximum_ray_length_m, surface_distance_epsilon_m);
+           maximum_steps, maximum_ray_length_m, surface_distance_epsilon_m,
+           skip_unallocated_blocks);
 
   // Reconstruct the 3D point
   if (!result.second) {
@@ -189,19 +237,94 @@ __global__ void sphereTracingKernel(
   success_flags[ray_idx] = result.second;
 }
 
-__global__ void sphereTracingKernel(
-    const Camera camera,                             // NOLINT
-    const Transform T_L_C,                           // NOLINT
-    Index3DDeviceHashMapType<TsdfBlock> block_hash,  // NOLINT
-    float* image,                                    // NOLINT
-    float truncation_distance_m,                     // NOLINT
-    float block_size_m,                              // NOLINT
-    int maximum_steps,                               // NOLINT
-    float maximum_ray_length_m,                      // NOLINT
-    float surface_distance_epsilon_m,                // NOLINT
-    int ray_subsampling_factor) {
-  const int ray_col_idx = threadIdx.x + blockIdx.x * blockDim.x;
-  const int ray_row_idx = threadIdx.y + blockIdx.y * blockDim.y;
+// Marks pixels of the start depth image without a reprojected depth.
+constexpr float kNoStartDepth = 1e10f;
+
+__global__ void initializeStartDepthKernel(const int rows, const int cols,
+                                           float* image) {
+  const int col_idx = threadIdx.x + blockIdx.x * blockDim.x;
+  const int row_idx = threadIdx.y + blockIdx.y * blockDim.y;
+  if ((row_idx >= rows) || (col_idx >= cols)) {
+    return;
+  }
+  image::access(row_idx, col_idx, cols, image) = kNoStartDepth;
+}
+
+// Forward-projects each (valid) pixel of the previously rendered depth image
+// into the current view, keeping the closest depth landing in each pixel.
+__global__ void reprojectDepthKernel(
+    const Camera previous_camera,         // NOLINT
+    const float* previous_depth_image,    // NOLINT
+    int previous_ray_subsampling_factor,  // NOLINT
+    const Transform T_C_Cprevious,        // NOLINT
+    const Camera camera,                  // NOLINT
+    int ray_subsampling_factor,           // NOLINT
+    float* start_depth_image) {
+  const int col_idx = threadIdx.x + blockIdx.x * blockDim.x;
+  const int row_idx = threadIdx.y + blockIdx.y * blockDim.y;
+  const int previous_rows =
+      previous_camera.rows() / previous_ray_subsampling_factor;
+  const int previous_cols =
+      previous_camera.cols() / previous_ray_subsampling_factor;
+  if ((row_idx >= previous_rows) || (col_idx >= previous_cols)) {
+    return;
+  }
+  const float previous_depth =
+      image::access(row_idx, col_idx, previous_cols, previous_depth_image);
+  if (previous_depth <= 0.0f) {
+    return;
+  }
+
+  // The point where the previous ray (through the patch center) hit.
+  constexpr float kHalf = 1.0f / 2.0f;
+  const Vector2f previous_pixel_coords =
+      (Index2D(col_idx, row_idx) * previous_ray_subsampling_factor)
+          .cast<float>() +
+      kHalf * static_cast<float>(previous_ray_subsampling_factor) *
+          Vector2f::Ones();
+  const Vector3f p_Cprevious =
+      previous_camera.unprojectFromImagePlaneCoordinates(previous_pixel_coords,
+                                                         previous_depth);
+
+  // Project into the current view.
+  const Vector3f p_C = T_C_Cprevious * p_Cprevious;
+  Vector2f u_C;
+  if (!camera.project(p_C, &u_C)) {
+    return;
+  }
+  const int rows = camera.rows() / ray_subsampling_factor;
+  const int cols = camera.cols() / ray_subsampling_factor;
+  const Index2D ray_indices =
+      (u_C / static_cast<float>(ray_subsampling_factor))
+          .array()
+          .floor()
+          .cast<int>();
+  if ((ray_indices.x() < 0) || (ray_indices.x() >= cols) ||
+      (ray_indices.y() < 0) || (ray_indices.y() >= rows)) {
+    return;
+  }
+  atomicMinFloat(
+      &image::access(ray_indices.y(), ray_indices.x(), cols, start_depth_image),
+      p_C.z());
+}
+
+// Renders the depth of a single (possibly subsampled) pixel.
+__device__ void renderDepthPixel(
+    const Camera& camera,                                   // NOLINT
+    const Vector3f* rays_C,                                 // NOLINT
+    const Transform& T_L_C,                                 // NOLINT
+    const Index3DDeviceHashMapType<TsdfBlock>& block_hash,  // NOLINT
+    float* image,                                           // NOLINT
+    float truncation_distance_m,                            // NOLINT
+    float block_size_m,                                     // NOLINT
+    int maximum_steps,                                      // NOLINT
+    float maximum_ray_length_m,                             // NOLINT
+    float surface_distance_epsilon_m,                       // NOLINT
+    bool skip_unallocated_blocks,                           // NOLINT
+    int ray_subsampling_factor,                             // NOLINT
+    const float* start_depth_image,                         // NOLINT
+    int ray_row_idx,                                        // NOLINT
+    int ray_col_idx) {
   // Note: we ensure that this division works cleanly before getting here.
   const int ray_rows = camera.rows() / ray_subsampling_factor;
   const int ray_cols = camera.cols() / ray_subsampling_factor;
@@ -209,23 +332,33 @@ __global__ void sphereTracingKernel(
     return;
   }
 
-  // Get the image-plane coordinates of where this ray should pass such that it
-  // is in the center of the patch it will represent.
-  constexpr float kHalf = 1.0f / 2.0f;
-  const Index2D ray_indices(ray_col_idx, ray_row_idx);
-  const Vector2f pixel_coords =
-      (ray_indices * ray_subsampling_factor).cast<float>() +
-      kHalf * static_cast<float>(ray_subsampling_factor) * Vector2f::Ones();
-
-  // Get the ray going through this pixel (in layer coordinate)
-  const Vector3f ray_direction_C =
-      camera.vectorFromImagePlaneCoordinates(pixel_coords).normalized();
+  // Get the ray going through the center of the patch this ray represents
+  // (see CameraRayCache), and rotate it into the layer.
+  const Vector3f ray_direction_C = rays_C[ray_row_idx * ray_cols + ray_col_idx];
   const Ray ray_L(T_L_C.translation(), T_L_C.linear() * ray_direction_C);
 
-  // Cast the ray into the layer
-  thrust::pair<float, bool> t_optional =
-      cast(ray_L, block_hash, truncation_distance_m, block_size_m,
-           maximum_steps, maximum_ray_length_m, surface_distance_epsilon_m);
+  // Cast the ray into the layer. If we have a guess of the surface depth, we
+  // first cast from one truncation distance in front of it, and only do a
+  // full march if that fails.
+  thrust::pair<float, bool> t_optional = {0.0f, false};
+  if (start_depth_image != nullptr) {
+    const float start_depth =
+        image::access(ray_row_idx, ray_col_idx, ray_cols, start_depth_image);
+    if (start_depth < kNoStartDepth) {
+      const float t_start = fmaxf(
+          start_depth / ray_direction_C.z() - truncation_distance_m, 0.0f);
+      t_optional =
+          cast(ray_L, block_hash, truncation_distance_m, block_size_m,
+               maximum_steps, maximum_ray_length_m, surface_distance_epsilon_m,
+               skip_unallocated_blocks, t_start);
+    }
+  }
+  if (!t_optional.second) {
+    t_optional =
+        cast(ray_L, block_hash, truncation_distance_m, block_size_m,
+             maximum_steps, maximum_ray_length_m, surface_distance_epsilon_m,
+             skip_unallocated_blocks);
+  }
 
   // If success, write depth to image, otherwise write -1.
   if (t_optional.second == true) {
@@ -236,8 +369,54 @@ __global__ void sphereTracingKernel(
   }
 }
 
+__global__ void sphereTracingKernel(
+    const Camera camera,                             // NOLINT
+    const Vector3f* rays_C,                          // NOLINT
+    const Transform T_L_C,                           // NOLINT
+    Index3DDeviceHashMapType<TsdfBlock> block_hash,  // NOLINT
+    float* image,                                    // NOLINT
+    float truncation_distance_m,                     // NOLINT
+    float block_size_m,                              // NOLINT
+    int maximum_steps,                               // NOLINT
+    float maximum_ray_length_m,                      // NOLINT
+    float surface_distance_epsilon_m,                // NOLINT
+    bool skip_unallocated_blocks,                    // NOLINT
+    int ray_subsampling_factor,                      // NOLINT
+    const float* start_depth_image) {
+  const int ray_col_idx = threadIdx.x + blockIdx.x * blockDim.x;
+  const int ray_row_idx = threadIdx.y + blockIdx.y * blockDim.y;
+  renderDepthPixel(camera, rays_C, T_L_C, block_hash, image,
+                   truncation_distance_m, block_size_m, maximum_steps,
+                   maximum_ray_length_m, surface_distance_epsilon_m,
+                   skip_unallocated_blocks, ray_subsampling_factor,
+                   start_depth_image, ray_row_idx, ray_col_idx);
+}
+
+// Multi-view version. The z dimension of the grid indexes the view, and the
+// x/y dimensions cover the largest image.
+__global__ void sphereTracingMultiViewKernel(
+    const SphereTracingView* views,                  // NOLINT
+    Index3DDeviceHashMapType<TsdfBlock> block_hash,  // NOLINT
+    float truncation_distance_m,                     // NOLINT
+    float block_size_m,                              // NOLINT
+    int maximum_steps,                               // NOLINT
+    float maximum_ray_length_m,                      // NOLINT
+    float surface_distance_epsilon_m,                // NOLINT
+    bool skip_unallocated_blocks,                    // NOLINT
+    int ray_subsampling_factor) {
+  const int ray_col_idx = threadIdx.x + blockIdx.x * blockDim.x;
+  const int ray_row_idx = threadIdx.y + blockIdx.y * blockDim.y;
+  const SphereTracingView& view = views[blockIdx.z];
+  renderDepthPixel(view.camera, view.rays_C, view.T_L_C, block_hash, view.depth,
+                   truncation_distance_m, block_size_m, maximum_steps,
+                   maximum_ray_length_m, surface_distance_epsilon_m,
+                   skip_unallocated_blocks, ray_subsampling_factor,
+                   nullptr, ray_row_idx, ray_col_idx);
+}
+
 __global__ void sphereTracingKernelWithColor(
     const Camera camera,                                    // NOLINT
+    const Vector3f* rays_C,                                 // NOLINT
     const Transform T_L_C,                                  // NOLINT
     Index3DDeviceHashMapType<TsdfBlock> tsdf_block_hash,    // NOLINT
     Index3DDeviceHashMapType<ColorBlock> color_block_hash,  // NOLINT
@@ -248,6 +427,7 @@ __global__ void sphereTracingKernelWithColor(
     int maximum_steps,                 // NOLINT
     float maximum_ray_length_m,        // NOLINT
     float surface_distance_epsilon_m,  // NOLINT
+    bool skip_unallocated_blocks,      // NOLINT
     int ray_subsampling_factor) {
   const int ray_col_idx = threadIdx.x + blockIdx.x * blockDim.x;
   const int ray_row_idx = threadIdx.y + blockIdx.y * blockDim.y;
@@ -258,23 +438,16 @@ __global__ void sphereTracingKernelWithColor(
     return;
   }
 
-  // Get the image-plane coordinates of where this ray should pass such that it
-  // is in the center of the patch it will represent.
-  constexpr float kHalf = 1.0f / 2.0f;
-  const Index2D ray_indices(ray_col_idx, ray_row_idx);
-  const Vector2f pixel_coords =
-      (ray_indices * ray_subsampling_factor).cast<float>() +
-      kHalf * static_cast<float>(ray_subsampling_factor) * Vector2f::Ones();
-
-  // Get the ray going through this pixel (in layer coordinate)
-  const Vector3f ray_direction_C =
-      camera.vectorFromImagePlaneCoordinates(pixel_coords).normalized();
+  // Get the ray going through the center of the patch this ray represents
+  // (see CameraRayCache), and rotate it into the layer.
+  const Vector3f ray_direction_C = rays_C[ray_row_idx * ray_cols + ray_col_idx];
   const Ray ray_L(T_L_C.translation(), T_L_C.linear() * ray_direction_C);
 
   // Cast the ray into the TSDF layer
   thrust::pair<float, bool> t_optional =
       cast(ray_L, tsdf_block_hash, truncation_distance_m, block_size_m,
-           maximum_steps, maximum_ray_length_m, surface_distance_epsilon_m);
+           maximum_steps, maximum_ray_length_m, surface_distance_epsilon_m,
+           skip_unallocated_blocks);
 
   // If success, write depth to image, and look up the color. Otherwise write
   // -1, and a black color.
@@ -332,6 +505,33 @@ void SphereTracer::surface_distance_epsilon_vox(
   surface_distance_epsilon_vox_ = surface_distance_epsilon_vox;
 }
 
+bool SphereTracer::reproject_previous_render() const {
+  return reproject_previous_render_;
+}
+
+void SphereTracer::reproject_previous_render(bool reproject_previous_render) {
+  reproject_previous_render_ = reproject_previous_render;
+  has_previous_render_ = false;
+}
+
+bool SphereTracer::skip_unallocated_blocks() const {
+  return skip_unallocated_blocks_;
+}
+
+void SphereTracer::skip_unallocated_blocks(bool skip_unallocated_blocks) {
+  skip_unallocated_blocks_ = skip_unallocated_blocks;
+}
+
+std::shared_ptr<CameraRayCache> SphereTracer::camera_ray_cache() const {
+  return camera_ray_cache_;
+}
+
+void SphereTracer::camera_ray_cache(
+    std::shared_ptr<CameraRayCache> camera_ray_cache) {
+  CHECK(camera_ray_cache);
+  camera_ray_cache_ = camera_ray_cache;
+}
+
 SphereTracer::SubsampledImageSize SphereTracer::getSubsampledImageSize(
     const Camera& camera, const int subsampling_factor) const {
   return SubsampledImageSize(camera.height() / subsampling_factor,
@@ -366,7 +566,8 @@ bool SphereTracer::castOnGPU(const Ray& ray, const TsdfLayer& tsdf_layer,
       tsdf_layer.block_size(),         // NOLINT
       maximum_steps_,                  // NOLINT
       maximum_ray_length_m_,           // NOLINT
-      surface_distance_epsilon_m);
+      surface_distance_epsilon_m,      // NOLINT
+      skip_unallocated_blocks_);
 
   // GPU -> CPU
   checkCudaErrors(cudaMemcpyAsync(t, t_device, sizeof(float),
@@ -469,9 +670,20 @@ void SphereTracer::renderImageOnGPU(const Camera& camera,
       depth_ptr->cols() / kThreadsPerThreadBlock.x + 1,  // NOLINT
       depth_ptr->rows() / kThreadsPerThreadBlock.y + 1,  // NOLINT
       1);
+  // Warm start the rays from the previous render (if requested and present).
+  const float* start_depth_ptr = nullptr;
+  if (reproject_previous_render_ && has_previous_render_) {
+    reprojectPreviousRender(camera, T_L_C, ray_subsampling_factor);
+    start_depth_ptr = start_depth_image_.dataConstPtr();
+  }
+  const std::shared_ptr<const RayTable> rays_C =
+      camera_ray_cache_->getRays(camera, ray_subsampling_factor,
+                             RayNormalization::kUnitLength, *cuda_stream_);
+
   sphereTracingKernel<<<num_blocks, kThreadsPerThreadBlock, 0,
                         *cuda_stream_>>>(
       camera,                          // NOLINT
+      rays_C->data(),                  // NOLINT
       T_L_C,                           // NOLINT
       gpu_layer_view.getHash().impl_,  // NOLINT
       depth_ptr->dataPtr(),            // NOLINT
@@ -480,6 +692,172 @@ void SphereTracer::renderImageOnGPU(const Camera& camera,
       maximum_steps_,                  // NOLINT
       maximum_ray_length_m_,           // NOLINT
       surface_distance_epsilon_m,      // NOLINT
+      skip_unallocated_blocks_,        // NOLINT
+      ray_subsampling_factor,          // NOLINT
+      start_depth_ptr);
+  checkCudaErrors(cudaPeekAtLastError());
+
+  // Store this render for reprojection into the next one.
+  if (reproject_previous_render_) {
+    previous_depth_image_.copyFromAsync(*depth_ptr, *cuda_stream_);
+    previous_camera_ = camera;
+    previous_T_L_C_ = T_L_C;
+    previous_ray_subsampling_factor_ = ray_subsampling_factor;
+    has_previous_render_ = true;
+  }
+  cuda_stream_->synchronize();
+  checkCudaErrors(cudaPeekAtLastError());
+}
+
+void SphereTracer::reprojectPreviousRender(const Camera& camera,
+                                           const Transform& T_L_C,
+                                           const int ray_subsampling_factor) {
+  const SubsampledImageSize image_size =
+      getSubsampledImageSize(camera, ray_subsampling_factor);
+  if (start_depth_image_.rows() != image_size.rows ||
+      start_depth_image_.cols() != image_size.cols) {
+    start_depth_image_ =
+        DepthImage(image_size.rows, image_size.cols, MemoryType::kDevice);
+  }
+  constexpr dim3 kThreadsPerThreadBlock(8, 8, 1);
+  const dim3 num_blocks(
+      image_size.cols / kThreadsPerThreadBlock.x + 1,  // NOLINT
+      image_size.rows / kThreadsPerThreadBlock.y + 1,  // NOLINT
+      1);
+  initializeStartDepthKernel<<<num_blocks, kThreadsPerThreadBlock, 0,
+                               *cuda_stream_>>>(
+      start_depth_image_.rows(),  // NOLINT
+      start_depth_image_.cols(),  // NOLINT
+      start_depth_image_.dataPtr());
+  checkCudaErrors(cudaPeekAtLastError());
+
+  const dim3 num_blocks_previous(
+      previous_depth_image_.cols() / kThreadsPerThreadBlock.x + 1,  // NOLINT
+      previous_depth_image_.rows() / kThreadsPerThreadBlock.y + 1,  // NOLINT
+      1);
+  reprojectDepthKernel<<<num_blocks_previous, kThreadsPerThreadBlock, 0,
+                         *cuda_stream_>>>(
+      previous_camera_,                      // NOLINT
+      previous_depth_image_.dataConstPtr(),  // NOLINT
+      previous_ray_subsampling_factor_,      // NOLINT
+      T_L_C.inverse() * previous_T_L_C_,     // NOLINT
+      camera,                                // NOLINT
+      ray_subsampling_factor,                // NOLINT
+      start_depth_image_.dataPtr());
+  checkCudaErrors(cudaPeekAtLastError());
+}
+
+void SphereTracer::renderImagesOnGPU(
+    const std::vector<Camera>& cameras,
+    const std::vector<Transform>& T_L_C_vec, const TsdfLayer& tsdf_layer,
+    const float truncation_distance_m,
+    const std::vector<DepthImage*>& depth_ptrs,
+    const MemoryType output_image_memory_type,
+    const int ray_subsampling_factor) {
+  CHECK_EQ(cameras.size(), depth_ptrs.size());
+  CHECK(output_image_memory_type != MemoryType::kHost);
+
+  // If we get a request for a different size image, reallocate.
+  std::vector<DepthImageView> depth_views;
+  depth_views.reserve(depth_ptrs.size());
+  for (size_t i = 0; i < depth_ptrs.size(); i++) {
+    DepthImage* depth_ptr = CHECK_NOTNULL(depth_ptrs[i]);
+    const SubsampledImageSize image_size =
+        getSubsampledImageSize(cameras[i], ray_subsampling_factor);
+    if (depth_ptr->width() != image_size.cols ||
+        depth_ptr->height() != image_size.rows ||
+        depth_ptr->memory_type() != output_image_memory_type) {
+      LOG(INFO) << "Allocating output space for sphere tracing";
+      *depth_ptr = DepthImage(image_size.rows, image_size.cols,
+                              output_image_memory_type);
+    }
+    depth_views.emplace_back(*depth_ptr);
+  }
+
+  std::vector<DepthImageView*> depth_view_ptrs;
+  depth_view_ptrs.reserve(depth_views.size());
+  for (DepthImageView& depth_view : depth_views) {
+    depth_view_ptrs.push_back(&depth_view);
+  }
+  renderImagesOnGPU(cameras, T_L_C_vec, tsdf_layer, truncation_distance_m,
+                    depth_view_ptrs, ray_subsampling_factor);
+}
+
+void SphereTracer::renderImagesOnGPU(
+    const std::vector<Camera>& cameras,
+    const std::vector<Transform>& T_L_C_vec, const TsdfLayer& tsdf_layer,
+    const float truncation_distance_m,
+    const std::vector<DepthImageView*>& depth_ptrs,
+    const int ray_subsampling_factor) {
+  CHECK_EQ(cameras.size(), T_L_C_vec.size());
+  CHECK_EQ(cameras.size(), depth_ptrs.size());
+
+  // Collect the views, skipping those with incorrectly sized outputs.
+  views_host_.clearNoDeallocate();
+  std::vector<std::shared_ptr<const RayTable>> rays_C;
+  int max_rows = 0;
+  int max_cols = 0;
+  for (size_t i = 0; i < cameras.size(); i++) {
+    DepthImageView* depth_ptr = CHECK_NOTNULL(depth_ptrs[i]);
+    CHECK_NOTNULL(depth_ptr->dataPtr());
+    CHECK_EQ(cameras[i].width() % ray_subsampling_factor, 0);
+    CHECK_EQ(cameras[i].height() % ray_subsampling_factor, 0);
+    const SubsampledImageSize image_size =
+        getSubsampledImageSize(cameras[i], ray_subsampling_factor);
+    if (depth_ptr->cols() != image_size.cols ||
+        depth_ptr->rows() != image_size.rows) {
+      LOG(WARNING) << "Attemped to sphere trace with incorrectly sized output "
+                      "images. Skipping view "
+                   << i;
+      continue;
+    }
+    SphereTracingView view;
+    view.camera = cameras[i];
+    view.T_L_C = T_L_C_vec[i];
+    view.depth = depth_ptr->dataPtr();
+    rays_C.push_back(camera_ray_cache_->getRays(
+        cameras[i], ray_subsampling_factor, RayNormalization::kUnitLength,
+        *cuda_stream_));
+    view.rays_C = rays_C.back()->data();
+    views_host_.push_back(view, *cuda_stream_);
+    max_rows = std::max(max_rows, image_size.rows);
+    max_cols = std::max(max_cols, image_size.cols);
+  }
+  if (views_host_.empty()) {
+    return;
+  }
+
+  // Get the GPU hash
+  timing::Timer hash_transfer_timer(
+      "color/integrate/sphere_trace/hash_transfer");
+  GPULayerView<TsdfBlock>& gpu_layer_view =
+      tsdf_layer.getGpuLayerView(*cuda_stream_);
+  hash_transfer_timer.Stop();
+  views_device_.copyFromAsync(views_host_, *cuda_stream_);
+
+  // Get metric surface distance epsilon
+  const float surface_distance_epsilon_m =
+      surface_distance_epsilon_vox_ * tsdf_layer.voxel_size();
+
+  // Kernel
+  // Call params
+  // - 1 thread per pixel
+  // - 8 x 8 threads per thread block
+  // - N x M x num_views thread blocks get 1 thread per pixel of each view
+  constexpr dim3 kThreadsPerThreadBlock(8, 8, 1);
+  const dim3 num_blocks(max_cols / kThreadsPerThreadBlock.x + 1,  // NOLINT
+                        max_rows / kThreadsPerThreadBlock.y + 1,  // NOLINT
+                        views_host_.size());
+  sphereTracingMultiViewKernel<<<num_blocks, kThreadsPerThreadBlock, 0,
+                                 *cuda_stream_>>>(
+      views_device_.data(),            // NOLINT
+      gpu_layer_view.getHash().impl_,  // NOLINT
+      truncation_distance_m,           // NOLINT
+      tsdf_layer.block_size(),         // NOLINT
+      maximum_steps_,                  // NOLINT
+      maximum_ray_length_m_,           // NOLINT
+      surface_distance_epsilon_m,      // NOLINT
+      skip_unallocated_blocks_,        // NOLINT
       ray_subsampling_factor);
   cuda_stream_->synchronize();
   checkCudaErrors(cudaPeekAtLastError());
@@ -535,9 +913,13 @@ void SphereTracer::renderRgbdImageOnGPU(
   const dim3 num_blocks(image_width / kThreadsPerThreadBlock.y + 1,   // NOLINT
                         image_height / kThreadsPerThreadBlock.x + 1,  // NOLINT
                         1);
+  const std::shared_ptr<const RayTable> rays_C =
+      camera_ray_cache_->getRays(camera, ray_subsampling_factor,
+                             RayNormalization::kUnitLength, *cuda_stream_);
   sphereTracingKernelWithColor<<<num_blocks, kThreadsPerThreadBlock, 0,
                                  *cuda_stream_>>>(
       camera,                                // NOLINT
+      rays_C->data(),                        // NOLINT
       T_L_C,                                 // NOLINT
       tsdf_gpu_layer_view.getHash().impl_,   // NOLINT
       color_gpu_layer_view.getHash().impl_,  // NOLINT
@@ -548,6 +930,7 @@ void SphereTracer::renderRgbdImageOnGPU(
       maximum_steps_,                        // NOLINT
       maximum_ray_length_m_,                 // NOLINT
       surface_distance_epsilon_m,            // NOLINT
+      skip_unallocated_blocks_,              // NOLINT
       ray_subsampling_factor);
   cuda_stream_->synchronize();
   checkCudaErrors(cudaPeekAtLastError());
@@ -635,7 +1018,8 @@ std::pair<device_vector<Vector3f>, device_vector<bool>> SphereTracer::castOnGPU(
       tsdf_layer.block_size(),         // NOLINT
       maximum_steps_,                  // NOLINT
       maximum_ray_length_m_,           // NOLINT
-      surface_distance_epsilon_m);
+      surface_distance_epsilon_m,      // NOLINT
+      skip_unallocated_blocks_);
   cuda_stream_->synchronize();
   checkCudaErrors(cudaPeekAtLastError());
 
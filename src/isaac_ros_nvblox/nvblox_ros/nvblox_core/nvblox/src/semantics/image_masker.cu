@@ -25,27 +25,22 @@ __device__ inline void copyToMaskedOutput(
       image::access(row_idx, col_idx, cols, input);
 }
 
-__global__ void splitColorImageKernel(const Color* input, const uint8_t* mask,
-                                      const int rows, const int cols,
-                                      const Color masked_image_invalid_pixel,
-                                      const Color unmasked_image_invalid_pixel,
-                                      Color* unmasked_output,
-                                      Color* masked_output,
-                                      Color* masked_depth_overlay = nullptr) {
-  // Each thread does a single pixel
-  const int col_idx = threadIdx.x + blockIdx.x * blockDim.x;
-  const int row_idx = threadIdx.y + blockIdx.y * blockDim.y;
-  if ((row_idx >= rows) || (col_idx >= cols)) {
-    return;
-  }
-
-  // Assuming that the mask lies directly on top of the input image
+// Splits a single pixel of a color image, assuming that the mask lies directly
+// on top of the color image.
+__device__ inline void splitColorPixel(const int row_idx, const int col_idx,
+                                       const Color* input, const uint8_t* mask,
+                                       const int cols,
+                                       const Color masked_image_invalid_pixel,
+                                       const Color unmasked_image_invalid_pixel,
+                                       Color* unmasked_output,
+                                       Color* masked_output,
+                                       Color* masked_color_overlay) {
   const bool is_masked = image::access(row_idx, col_idx, cols, mask);
 
   // Overlay the mask onto the color image as debug output
-  if (masked_depth_overlay) {
+  if (masked_color_overlay) {
     const Color input_color = image::access(row_idx, col_idx, cols, input);
-    image::access(row_idx, col_idx, cols, masked_depth_overlay) = Color(
+    image::access(row_idx, col_idx, cols, masked_color_overlay) = Color(
         fmax(input_color.r, is_masked * 255u), input_color.g, input_color.b);
   }
 
@@ -60,6 +55,24 @@ __global__ void splitColorImageKernel(const Color* input, const uint8_t* mask,
   }
 }
 
+__global__ void splitColorImageKernel(const Color* input, const uint8_t* mask,
+                                      const int rows, const int cols,
+                                      const Color masked_image_invalid_pixel,
+                                      const Color unmasked_image_invalid_pixel,
+                                      Color* unmasked_output,
+                                      Color* masked_output,
+                                      Color* masked_depth_overlay = nullptr) {
+  // Each thread does a single pixel
+  const int col_idx = threadIdx.x + blockIdx.x * blockDim.x;
+  const int row_idx = threadIdx.y + blockIdx.y * blockDim.y;
+  if ((row_idx >= rows) || (col_idx >= cols)) {
+    return;
+  }
+  splitColorPixel(row_idx, col_idx, input, mask, cols,
+                  masked_image_invalid_pixel, unmasked_image_invalid_pixel,
+                  unmasked_output, masked_output, masked_depth_overlay);
+}
+
 __global__ void initializeImageKernel(const float value, const int rows,
                                       const int cols, float* image) {
   // Each thread does a single pixel on the depth input image
@@ -119,19 +132,16 @@ __global__ void getMinimumDepthKernel(const float* depth_input,
   }
 }
 
-__global__ void splitDepthImageKernel(
-    const float* depth_input, const uint8_t* mask, const Transform T_CM_CD,
-    const Camera depth_camera, const Camera mask_camera,
-    const float occlusion_threshold_m, const float masked_image_invalid_pixel,
+// Splits a single pixel of a depth image according to a mask image taking
+// occlusion into account.
+__device__ inline void splitDepthPixel(
+    const int row_idx, const int col_idx, const float* depth_input,
+    const uint8_t* mask, const Transform& T_CM_CD, const Camera& depth_camera,
+    const Camera& mask_camera, const float occlusion_threshold_m,
+    const float masked_image_invalid_pixel,
     const float unmasked_image_invalid_pixel, const float* min_depth_image,
     float* unmasked_depth_output, float* masked_depth_output,
-    Color* masked_depth_overlay = nullptr) {
-  // Each thread does a single pixel on the depth input image
-  const int col_idx = threadIdx.x + blockIdx.x * blockDim.x;
-  const int row_idx = threadIdx.y + blockIdx.y * blockDim.y;
-  if ((row_idx >= depth_camera.rows()) || (col_idx >= depth_camera.cols())) {
-    return;
-  }
+    Color* masked_depth_overlay) {
   const float depth =
       image::access(row_idx, col_idx, depth_camera.cols(), depth_input);
 
@@ -196,6 +206,60 @@ __global__ void splitDepthImageKernel(
   }
 }
 
+__global__ void splitDepthImageKernel(
+    const float* depth_input, const uint8_t* mask, const Transform T_CM_CD,
+    const Camera depth_camera, const Camera mask_camera,
+    const float occlusion_threshold_m, const float masked_image_invalid_pixel,
+    const float unmasked_image_invalid_pixel, const float* min_depth_image,
+    float* unmasked_depth_output, float* masked_depth_output,
+    Color* masked_depth_overlay = nullptr) {
+  // Each thread does a single pixel on the depth input image
+  const int col_idx = threadIdx.x + blockIdx.x * blockDim.x;
+  const int row_idx = threadIdx.y + blockIdx.y * blockDim.y;
+  if ((row_idx >= depth_camera.rows()) || (col_idx >= depth_camera.cols())) {
+    return;
+  }
+  splitDepthPixel(row_idx, col_idx, depth_input, mask, T_CM_CD, depth_camera,
+                  mask_camera, occlusion_threshold_m,
+                  masked_image_invalid_pixel, unmasked_image_invalid_pixel,
+                  min_depth_image, unmasked_depth_output, masked_depth_output,
+                  masked_depth_overlay);
+}
+
+// Splits the depth and the color image in a single pass. Each thread does a
+// single pixel of the depth image and a single pixel of the color image (which
+// lies on the mask image), such that both share a launch and a single read of
+// each input.
+__global__ void splitDepthAndColorImageKernel(
+    const float* depth_input, const Color* color_input, const uint8_t* mask,
+    const Transform T_CM_CD, const Camera depth_camera,
+    const Camera mask_camera, const float occlusion_threshold_m,
+    const float depth_masked_image_invalid_pixel,
+    const float depth_unmasked_image_invalid_pixel,
+    const Color color_masked_image_invalid_pixel,
+    const Color color_unmasked_image_invalid_pixel,
+    const float* min_depth_image, float* unmasked_depth_output,
+    float* masked_depth_output, Color* unmasked_color_output,
+    Color* masked_color_output, Color* masked_depth_overlay,
+    Color* masked_color_overlay) {
+  const int col_idx = threadIdx.x + blockIdx.x * blockDim.x;
+  const int row_idx = threadIdx.y + blockIdx.y * blockDim.y;
+  if ((row_idx < depth_camera.rows()) && (col_idx < depth_camera.cols())) {
+    splitDepthPixel(row_idx, col_idx, depth_input, mask, T_CM_CD, depth_camera,
+                    mask_camera, occlusion_threshold_m,
+                    depth_masked_image_invalid_pixel,
+                    depth_unmasked_image_invalid_pixel, min_depth_image,
+                    unmasked_depth_output, masked_depth_output,
+                    masked_depth_overlay);
+  }
+  if ((row_idx < mask_camera.rows()) && (col_idx < mask_camera.cols())) {
+    splitColorPixel(row_idx, col_idx, color_input, mask, mask_camera.cols(),
+                    color_masked_image_invalid_pixel,
+                    color_unmasked_image_invalid_pixel, unmasked_color_output,
+                    masked_color_output, masked_color_overlay);
+  }
+}
+
 inline Color* getOverlayDataPtr(ColorImage* overlay_image) {
   if (overlay_image) {
     return overlay_image->dataPtr();
@@ -248,6 +312,17 @@ static void allocateOutput(const ImageType& input, ImageType* unmasked_output,
         (input.cols() == masked_output->cols()));
 }
 
+// Kernel call params
+// - 1 thread per pixel
+// - 8 x 8 threads per thread block
+// - N x M thread blocks get 1 thread per pixel
+constexpr dim3 kThreadsPerThreadBlock(8, 8, 1);
+
+static dim3 getNumBlocks(const int rows, const int cols) {
+  return dim3(cols / kThreadsPerThreadBlock.x + 1,
+              rows / kThreadsPerThreadBlock.y + 1, 1);
+}
+
 template <typename ElementType>
 static void splitImageOnGPUTemplate(
     const Image<ElementType>& input, const MonoImage& mask,
@@ -259,18 +334,8 @@ static void splitImageOnGPUTemplate(
 
   allocateOutput(input, unmasked_output, masked_output, masked_color_overlay);
 
-  // Kernel
-  // Call params
-  // - 1 thread per pixel
-  // - 8 x 8 threads per thread block
-  // - N x M thread blocks get 1 thread per pixel
-  constexpr dim3 kThreadsPerThreadBlock(8, 8, 1);
-  const dim3 num_blocks(input.cols() / kThreadsPerThreadBlock.x + 1,  // NOLINT
-                        input.rows() / kThreadsPerThreadBlock.y + 1,  // NOLINT
-                        1);
-
-  splitColorImageKernel<<<num_blocks, kThreadsPerThreadBlock, 0,
-                          cuda_stream>>>(
+  splitColorImageKernel<<<getNumBlocks(input.rows(), input.cols()),
+                          kThreadsPerThreadBlock, 0, cuda_stream>>>(
       input.dataConstPtr(),                      // NOLINT
       mask.dataConstPtr(),                       // NOLINT
       input.rows(),                              // NOLINT
@@ -296,13 +361,11 @@ void ImageMasker::splitImageOnGPU(const ColorImage& color_input,
       masked_color_overlay, *cuda_stream_);
 }
 
-void ImageMasker::splitImageOnGPU(
-    const DepthImage& depth_input, const MonoImage& mask,
-    const Transform& T_CM_CD, const Camera& depth_camera,
-    const Camera& mask_camera, DepthImage* unmasked_depth_output,
-    DepthImage* masked_depth_output, ColorImage* masked_depth_overlay) {
-  timing::Timer image_masking_timer("image_masker/split_depth_image");
-
+void ImageMasker::computeMinimumDepthImageAsync(const DepthImage& depth_input,
+                                                const MonoImage& mask,
+                                                const Transform& T_CM_CD,
+                                                const Camera& depth_camera,
+                                                const Camera& mask_camera) {
   // First check if images and cameras have the same dimensions and are not
   // empty (depth_input is checked in allocateOutput)
   CHECK_GT(mask.rows(), 0);
@@ -312,21 +375,6 @@ void ImageMasker::splitImageOnGPU(
   CHECK((mask.rows() == mask_camera.rows()) &&
         (mask.cols() == mask_camera.cols()));
 
-  allocateOutput(depth_input, unmasked_depth_output, masked_depth_output,
-                 masked_depth_overlay);
-  // Allocate output images if required
-
-  // Kernel call params
-  // - 1 thread per pixel
-  // - 8 x 8 threads per thread block
-  // - N x M thread blocks get 1 thread per pixel
-  constexpr dim3 kThreadsPerThreadBlock(8, 8, 1);
-  const dim3 num_blocks_depth(depth_input.cols() / kThreadsPerThreadBlock.x + 1,
-                              depth_input.rows() / kThreadsPerThreadBlock.y + 1,
-                              1);
-  const dim3 num_blocks_mask(mask.cols() / kThreadsPerThreadBlock.x + 1,
-                             mask.rows() / kThreadsPerThreadBlock.y + 1, 1);
-
   // Initialize the minimum depth image
   if ((mask.rows() != min_depth_image_.rows()) ||
       (mask.cols() != min_depth_image_.cols()) ||
@@ -335,8 +383,8 @@ void ImageMasker::splitImageOnGPU(
     min_depth_image_ = DepthImage(mask.rows(), mask.cols(), mask.memory_type());
   }
   constexpr float kMaxValue = std::numeric_limits<float>::max();
-  initializeImageKernel<<<num_blocks_mask, kThreadsPerThreadBlock, 0,
-                          *cuda_stream_>>>(
+  initializeImageKernel<<<getNumBlocks(mask.rows(), mask.cols()),
+                          kThreadsPerThreadBlock, 0, *cuda_stream_>>>(
       kMaxValue,                    // NOLINT
       min_depth_image_.rows(),      // NOLINT
       min_depth_image_.cols(),      // NOLINT
@@ -345,16 +393,30 @@ void ImageMasker::splitImageOnGPU(
   // Find the minimal depth values seen from the mask camera
   constexpr uint8_t kPatchSize = 5;
   getMinimumDepthKernel<kPatchSize>
-      <<<num_blocks_depth, kThreadsPerThreadBlock, 0, *cuda_stream_>>>(
+      <<<getNumBlocks(depth_input.rows(), depth_input.cols()),
+         kThreadsPerThreadBlock, 0, *cuda_stream_>>>(
           depth_input.dataConstPtr(),   // NOLINT
           T_CM_CD,                      // NOLINT
           depth_camera,                 // NOLINT
           mask_camera,                  // NOLINT
           min_depth_image_.dataPtr());  // NOLINT
+}
+
+void ImageMasker::splitImageOnGPU(
+    const DepthImage& depth_input, const MonoImage& mask,
+    const Transform& T_CM_CD, const Camera& depth_camera,
+    const Camera& mask_camera, DepthImage* unmasked_depth_output,
+    DepthImage* masked_depth_output, ColorImage* masked_depth_overlay) {
+  timing::Timer image_masking_timer("image_masker/split_depth_image");
+
+  computeMinimumDepthImageAsync(depth_input, mask, T_CM_CD, depth_camera,
+                                mask_camera);
+  allocateOutput(depth_input, unmasked_depth_output, masked_depth_output,
+                 masked_depth_overlay);
 
   // Split the depth image according to the mask considering occlusion.
-  splitDepthImageKernel<<<num_blocks_depth, kThreadsPerThreadBlock, 0,
-                          *cuda_stream_>>>(
+  splitDepthImageKernel<<<getNumBlocks(depth_input.rows(), depth_input.cols()),
+                          kThreadsPerThreadBlock, 0, *cuda_stream_>>>(
       depth_input.dataConstPtr(),                // NOLINT
       mask.dataConstPtr(),                       // NOLINT
       T_CM_CD,                                   // NOLINT
@@ -373,6 +435,53 @@ void ImageMasker::splitImageOnGPU(
   image_masking_timer.Stop();
 }
 
+void ImageMasker::splitImagesOnGPU(
+    const DepthImage& depth_input, const ColorImage& color_input,
+    const MonoImage& mask, const Transform& T_CM_CD,
+    const Camera& depth_camera, const Camera& mask_camera,
+    DepthImage* unmasked_depth_output, DepthImage* masked_depth_output,
+    ColorImage* unmasked_color_output, ColorImage* masked_color_output,
+    ColorImage* masked_depth_overlay, ColorImage* masked_color_overlay) {
+  timing::Timer image_masking_timer("image_masker/split_depth_and_color_image");
+  CHECK((color_input.rows() == mask.rows()) &&
+        (color_input.cols() == mask.cols()));
+
+  computeMinimumDepthImageAsync(depth_input, mask, T_CM_CD, depth_camera,
+                                mask_camera);
+  allocateOutput(depth_input, unmasked_depth_output, masked_depth_output,
+                 masked_depth_overlay);
+  allocateOutput(color_input, unmasked_color_output, masked_color_output,
+                 masked_color_overlay);
+
+  // One thread per pixel of the larger of the two images.
+  const int rows = std::max(depth_input.rows(), color_input.rows());
+  const int cols = std::max(depth_input.cols(), color_input.cols());
+  splitDepthAndColorImageKernel<<<getNumBlocks(rows, cols),
+                                  kThreadsPerThreadBlock, 0, *cuda_stream_>>>(
+      depth_input.dataConstPtr(),                // NOLINT
+      color_input.dataConstPtr(),                // NOLINT
+      mask.dataConstPtr(),                       // NOLINT
+      T_CM_CD,                                   // NOLINT
+      depth_camera,                              // NOLINT
+      mask_camera,                               // NOLINT
+      occlusion_threshold_m_,                    // NOLINT
+      depth_masked_image_invalid_pixel_,         // NOLINT
+      depth_unmasked_image_invalid_pixel_,       // NOLINT
+      color_masked_image_invalid_pixel_,         // NOLINT
+      color_unmasked_image_invalid_pixel_,       // NOLINT
+      min_depth_image_.dataConstPtr(),           // NOLINT
+      unmasked_depth_output->dataPtr(),          // NOLINT
+      masked_depth_output->dataPtr(),            // NOLINT
+      unmasked_color_output->dataPtr(),          // NOLINT
+      masked_color_output->dataPtr(),            // NOLINT
+      getOverlayDataPtr(masked_depth_overlay),   // NOLINT
+      getOverlayDataPtr(masked_color_overlay));  // NOLINT
+
+  cuda_stream_->synchronize();
+  checkCudaErrors(cudaPeekAtLastError());
+  image_masking_timer.Stop();
+}
+
 float ImageMasker::occlusion_threshold_m() const {
   return occlusion_threshold_m_;
 }
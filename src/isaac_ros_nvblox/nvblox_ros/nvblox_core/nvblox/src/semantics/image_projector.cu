@@ -5,6 +5,9 @@
 #include <thrust/unique.h>
 
 #include "nvblox/core/hash.h"
+#include "nvblox/core/indexing.h"
+#include "nvblox/core/internal/stream_ordered_allocator.h"
+#include "nvblox/gpu_hash/internal/cuda/gpu_set.cuh"
 #include "nvblox/semantics/image_projector.h"
 
 namespace nvblox {
@@ -16,7 +19,12 @@ DepthImageBackProjector::DepthImageBackProjector(
     std::shared_ptr<CudaStream> cuda_stream)
     : cuda_stream_(cuda_stream) {}
 
-__global__ void projectImageKernel(const Camera camera, const float* image,
+DepthImageBackProjector::~DepthImageBackProjector() {
+  // NOTE: Defined here because Index3DDeviceSet is only forward declared in
+  // the header.
+}
+
+__global__ void projectImageKernel(const Vector3f* rays_C, const float* image,
                                    const int rows, const int cols,
                                    const float max_back_projection_distance_m,
                                    Vector3f* pointcloud, int* pointcloud_size) {
@@ -32,10 +40,8 @@ __global__ void projectImageKernel(const Camera camera, const float* image,
     return;
   }
 
-  Index2D u_C(col_idx, row_idx);
-
   // Unproject from the image.
-  const Vector3f p_C = camera.unprojectFromPixelIndices(u_C, depth);
+  const Vector3f p_C = depth * rays_C[row_idx * cols + col_idx];
 
   // Insert into the pointcloud.
   pointcloud[atomicAdd(pointcloud_size, 1)] = p_C;
@@ -58,6 +64,12 @@ void DepthImageBackProjector::backProjectOnGPU(
   }
   pointcloud_size_device_.setZero();
 
+  // The rays through the pixel centers.
+  CHECK_EQ(camera.rows(), image.rows());
+  CHECK_EQ(camera.cols(), image.cols());
+  const std::shared_ptr<const RayTable> rays_C = camera_ray_cache_->getRays(
+      camera, 1, RayNormalization::kUnitDepth, *cuda_stream_);
+
   // Call params
   // - 1 thread per pixel
   // - 8 x 8 threads per thread block
@@ -66,7 +78,7 @@ void DepthImageBackProjector::backProjectOnGPU(
   const dim3 num_blocks(image.cols() / kThreadsPerThreadBlock.x + 1,
                         image.rows() / kThreadsPerThreadBlock.y + 1, 1);
   projectImageKernel<<<num_blocks, kThreadsPerThreadBlock, 0, *cuda_stream_>>>(
-      camera, image.dataConstPtr(), image.rows(), image.cols(),
+      rays_C->data(), image.dataConstPtr(), image.rows(), image.cols(),
       max_back_projection_distance_m, pointcloud_C_ptr->dataPtr(),
       pointcloud_size_device_.get());
   checkCudaErrors(cudaPeekAtLastError());
@@ -77,6 +89,196 @@ void DepthImageBackProjector::backProjectOnGPU(
   pointcloud_C_ptr->resize(*pointcloud_size_host_);
 }
 
+// Call params
+// - 1 thread per pixel of the largest image in x and y.
+// - 1 frame per thread block in z.
+template <typename FrameViewType>
+__device__ inline bool backProjectBatchPixel(const FrameViewType* frames,
+                                             const float max_distance_m,
+                                             Vector3f* p_L) {
+  const FrameViewType& frame = frames[blockIdx.z];
+  const int col_idx = threadIdx.x + blockIdx.x * blockDim.x;
+  const int row_idx = threadIdx.y + blockIdx.y * blockDim.y;
+  if ((row_idx >= frame.rows) || (col_idx >= frame.cols)) {
+    return false;
+  }
+  const float depth =
+      image::access(row_idx, col_idx, frame.cols, frame.depth_image);
+  if (depth <= 0.0f || depth > max_distance_m) {
+    return false;
+  }
+  *p_L = frame.T_L_C * (depth * frame.rays_C[row_idx * frame.cols + col_idx]);
+  return true;
+}
+
+template <typename FrameViewType>
+__global__ void projectImageBatchKernel(const FrameViewType* frames,
+                                        const float max_distance_m,
+                                        Vector3f* const* pointclouds,
+                                        int* pointcloud_sizes) {
+  Vector3f p_L;
+  if (!backProjectBatchPixel(frames, max_distance_m, &p_L)) {
+    return;
+  }
+  const int frame_idx = blockIdx.z;
+  pointclouds[frame_idx][atomicAdd(&pointcloud_sizes[frame_idx], 1)] = p_L;
+}
+
+template <typename FrameViewType>
+__global__ void projectImageBatchToVoxelCentersKernel(
+    const FrameViewType* frames, const float max_distance_m,
+    const float voxel_size, Index3DDeviceSetType voxel_set,
+    Vector3f* voxel_centers, int* num_voxel_centers) {
+  Vector3f p_L;
+  if (!backProjectBatchPixel(frames, max_distance_m, &p_L)) {
+    return;
+  }
+  const Index3D voxel_idx =
+      (p_L / voxel_size).array().floor().cast<int>().matrix();
+  // Only the thread which inserts a voxel outputs it. The set has room for
+  // all pixels, such that insertions can't fail.
+  if (voxel_set.insert(voxel_idx).second) {
+    voxel_centers[atomicAdd(num_voxel_centers, 1)] =
+        (voxel_idx.cast<float>().array() + 0.5f) * voxel_size;
+  }
+}
+
+namespace {
+
+constexpr dim3 kBatchThreadsPerThreadBlock(8, 8, 1);
+
+dim3 getBatchNumBlocks(const Index2D& max_image_size, const int num_frames) {
+  return dim3(max_image_size.y() / kBatchThreadsPerThreadBlock.x + 1,
+              max_image_size.x() / kBatchThreadsPerThreadBlock.y + 1,
+              num_frames);
+}
+
+}  // namespace
+
+Index2D DepthImageBackProjector::prepareBatch(
+    const std::vector<BackProjectionFrame>& frames) {
+  Index2D max_image_size(0, 0);
+  frame_views_host_.resizeAsync(frames.size(), *cuda_stream_);
+  batch_rays_C_.clear();
+  for (size_t i = 0; i < frames.size(); i++) {
+    const BackProjectionFrame& frame = frames[i];
+    CHECK_NOTNULL(frame.depth_image);
+    CHECK_NOTNULL(frame.camera);
+    CHECK_EQ(frame.camera->rows(), frame.depth_image->rows());
+    CHECK_EQ(frame.camera->cols(), frame.depth_image->cols());
+    batch_rays_C_.push_back(camera_ray_cache_->getRays(
+        *frame.camera, 1, RayNormalization::kUnitDepth, *cuda_stream_));
+    FrameView& view = frame_views_host_[i];
+    view.rays_C = batch_rays_C_.back()->data();
+    view.depth_image = frame.depth_image->dataConstPtr();
+    view.rows = frame.depth_image->rows();
+    view.cols = frame.depth_image->cols();
+    view.T_L_C = frame.T_L_C;
+    max_image_size = max_image_size.cwiseMax(Index2D(view.rows, view.cols));
+  }
+  frame_views_device_.copyFromAsync(frame_views_host_, *cuda_stream_);
+  return max_image_size;
+}
+
+void DepthImageBackProjector::backProjectBatchOnGPU(
+    const std::vector<BackProjectionFrame>& frames,
+    const std::vector<Pointcloud*>& pointclouds_L,
+    const float max_back_projection_distance_m) {
+  CHECK_EQ(frames.size(), pointclouds_L.size());
+  if (frames.empty()) {
+    return;
+  }
+
+  // Create the max number of output points.
+  pointcloud_ptrs_host_.resizeAsync(frames.size(), *cuda_stream_);
+  for (size_t i = 0; i < frames.size(); i++) {
+    Pointcloud* pointcloud_L = CHECK_NOTNULL(pointclouds_L[i]);
+    CHECK(pointcloud_L->memory_type() == MemoryType::kDevice ||
+          pointcloud_L->memory_type() == MemoryType::kUnified);
+    CHECK_NOTNULL(frames[i].depth_image);
+    pointcloud_L->resizeAsync(frames[i].depth_image->numel(), *cuda_stream_);
+    pointcloud_ptrs_host_[i] = pointcloud_L->dataPtr();
+  }
+  pointcloud_ptrs_device_.copyFromAsync(pointcloud_ptrs_host_, *cuda_stream_);
+
+  // Reset the counters.
+  pointcloud_sizes_device_.resizeAsync(frames.size(), *cuda_stream_);
+  pointcloud_sizes_device_.setZeroAsync(*cuda_stream_);
+
+  const Index2D max_image_size = prepareBatch(frames);
+  projectImageBatchKernel<<<getBatchNumBlocks(max_image_size, frames.size()),
+                            kBatchThreadsPerThreadBlock, 0, *cuda_stream_>>>(
+      frame_views_device_.data(),      // NOLINT
+      max_back_projection_distance_m,  // NOLINT
+      pointcloud_ptrs_device_.data(),  // NOLINT
+      pointcloud_sizes_device_.data());
+  checkCudaErrors(cudaPeekAtLastError());
+
+  pointcloud_sizes_host_.copyFromAsync(pointcloud_sizes_device_,
+                                       *cuda_stream_);
+  cuda_stream_->synchronize();
+  for (size_t i = 0; i < frames.size(); i++) {
+    pointclouds_L[i]->resize(pointcloud_sizes_host_[i]);
+  }
+}
+
+void DepthImageBackProjector::backProjectBatchToVoxelCentersOnGPU(
+    const std::vector<BackProjectionFrame>& frames, float voxel_size,
+    Pointcloud* voxel_center_pointcloud_L,
+    const float max_back_projection_distance_m) {
+  CHECK_NOTNULL(voxel_center_pointcloud_L);
+  CHECK(voxel_center_pointcloud_L->memory_type() == MemoryType::kDevice ||
+        voxel_center_pointcloud_L->memory_type() == MemoryType::kUnified);
+  CHECK_GT(voxel_size, 0.0f);
+  if (frames.empty()) {
+    voxel_center_pointcloud_L->resize(0);
+    return;
+  }
+
+  // Each pixel adds at most one voxel.
+  int num_pixels = 0;
+  for (const BackProjectionFrame& frame : frames) {
+    CHECK_NOTNULL(frame.depth_image);
+    num_pixels += frame.depth_image->numel();
+  }
+  voxel_center_pointcloud_L->resizeAsync(num_pixels, *cuda_stream_);
+  if (num_pixels == 0) {
+    return;
+  }
+  // NOTE: Index3DDeviceSet::resize() compares to the number of elements
+  // rather than the capacity, so we track the capacity here to reuse the set.
+  if (!voxel_set_ || voxel_set_capacity_ < num_pixels) {
+    voxel_set_.reset();
+    voxel_set_ = std::make_unique<Index3DDeviceSet>(num_pixels);
+    voxel_set_capacity_ = num_pixels;
+  } else {
+    voxel_set_->clear();
+  }
+
+  // Reset the counter.
+  if (pointcloud_size_device_ == nullptr || pointcloud_size_host_ == nullptr) {
+    pointcloud_size_device_ = make_unified<int>(MemoryType::kDevice);
+    pointcloud_size_host_ = make_unified<int>(MemoryType::kHost);
+  }
+  pointcloud_size_device_.setZero();
+
+  const Index2D max_image_size = prepareBatch(frames);
+  projectImageBatchToVoxelCentersKernel<<<
+      getBatchNumBlocks(max_image_size, frames.size()),
+      kBatchThreadsPerThreadBlock, 0, *cuda_stream_>>>(
+      frame_views_device_.data(),            // NOLINT
+      max_back_projection_distance_m,        // NOLINT
+      voxel_size,                            // NOLINT
+      voxel_set_->set,                       // NOLINT
+      voxel_center_pointcloud_L->dataPtr(),  // NOLINT
+      pointcloud_size_device_.get());
+  checkCudaErrors(cudaPeekAtLastError());
+
+  pointcloud_size_device_.copyToAsync(pointcloud_size_host_, *cuda_stream_);
+  cuda_stream_->synchronize();
+  voxel_center_pointcloud_L->resize(*pointcloud_size_host_);
+}
+
 struct GetVoxelCenter {
   const float voxel_size;
 
@@ -105,15 +307,17 @@ void DepthImageBackProjector::pointcloudToVoxelCentersOnGPU(
                     voxel_center_pointcloud_L->points().begin(),
                     GetVoxelCenter(voxel_size));
 
-  // Sort points to bring duplicates together.
-  thrust::sort(thrust::device.on(*cuda_stream_),
+  // Sort points to bring duplicates together. The temporary storage of the
+  // sort is allocated from the stream-ordered memory pool.
+  StreamOrderedAllocator allocator(*cuda_stream_);
+  thrust::sort(streamOrderedPolicy(allocator, *cuda_stream_),
                voxel_center_pointcloud_L->points().begin(),
                voxel_center_pointcloud_L->points().end(),
                VectorCompare<Vector3f>());
 
   // Find unique points and erase redundancies. The iterator will point to
   // the new last index.
-  auto iterator = thrust::unique(thrust::device.on(*cuda_stream_),
+  auto iterator = thrust::unique(streamOrderedPolicy(allocator, *cuda_stream_),
                                  voxel_center_pointcloud_L->points().begin(),
                                  voxel_center_pointcloud_L->points().end());
 
@@ -25,6 +25,11 @@ std::ostream& operator<<(std::ostream& os, const Camera& camera) {
      << "\tcv: " << camera.cv() << "\n"
      << "\twidth: " << camera.width() << "\n"
      << "\theight: " << camera.height() << "\n";
+  if (camera.model() == CameraModel::kEquidistant) {
+    os << "\tequidistant distortion: " << camera.distortion().k1 << ", "
+       << camera.distortion().k2 << ", " << camera.distortion().k3 << ", "
+       << camera.distortion().k4 << "\n";
+  }
   return os;
 }
 
@@ -44,6 +49,7 @@ bool areCamerasEqual(const Camera& camera_1, const Camera& camera_2,
   same_intrinsics &= std::abs(camera_1.cv() - camera_2.cv()) <= 0.1;
   same_intrinsics &= camera_1.width() == camera_2.width();
   same_intrinsics &= camera_1.height() == camera_2.height();
+  same_intrinsics &= camera_1.hasSameDistortion(camera_2);
 
   return same_extrinsics && same_intrinsics;
 }
@@ -78,16 +84,15 @@ Frustum Camera::getViewFrustum(const Transform& T_L_C, const float min_depth,
 
 Eigen::Matrix<float, 8, 3> Camera::getViewCorners(const float min_depth,
                                                   const float max_depth) const {
-  // Rays through the corners of the image plane
+  // Rays through the corners of the viewport. For a pinhole camera these are
+  // the corners of the image plane, for a distorted camera the frustum
+  // encloses the (curved) undistorted image border.
   // Clockwise from the top left corner of the image.
-  const Vector3f ray_0_C =
-      vectorFromImagePlaneCoordinates(Vector2f(0.0f, 0.0f));  // NOLINT
-  const Vector3f ray_1_C =
-      vectorFromImagePlaneCoordinates(Vector2f(width_, 0.0f));  // NOLINT
-  const Vector3f ray_2_C =
-      vectorFromImagePlaneCoordinates(Vector2f(width_, height_));  // NOLINT
-  const Vector3f ray_3_C =
-      vectorFromImagePlaneCoordinates(Vector2f(0.0f, height_));  // NOLINT
+  const CameraViewport viewport = getNormalizedViewport();
+  const Vector3f ray_0_C(viewport.min().x(), viewport.min().y(), 1.0f);
+  const Vector3f ray_1_C(viewport.max().x(), viewport.min().y(), 1.0f);
+  const Vector3f ray_2_C(viewport.max().x(), viewport.max().y(), 1.0f);
+  const Vector3f ray_3_C(viewport.min().x(), viewport.max().y(), 1.0f);
 
   // True bounding box from the 3D points
   Eigen::Matrix<float, 8, 3> corners_C;
@@ -112,7 +117,27 @@ CameraViewport Camera::getNormalizedViewport(const float margin_pixels) const {
       vectorFromImagePlaneCoordinates({-margin_pixels, -margin_pixels});
   const Eigen::Vector3f max_coord = vectorFromImagePlaneCoordinates(
       {width() + margin_pixels, height() + margin_pixels});
-  return CameraViewport(min_coord.head<2>(), max_coord.head<2>());
+  if (model_ == CameraModel::kPinhole) {
+    return CameraViewport(min_coord.head<2>(), max_coord.head<2>());
+  }
+
+  // The undistorted image border is curved, and its extremes aren't
+  // necessarily at the corners, so we bound samples along it.
+  constexpr int kNumSamplesPerEdge = 64;
+  const Vector2f min_pixel(-margin_pixels, -margin_pixels);
+  const Vector2f max_pixel(width() + margin_pixels, height() + margin_pixels);
+  CameraViewport viewport;
+  for (int i = 0; i <= kNumSamplesPerEdge; i++) {
+    const float t = static_cast<float>(i) / kNumSamplesPerEdge;
+    const float u = min_pixel.x() + t * (max_pixel.x() - min_pixel.x());
+    const float v = min_pixel.y() + t * (max_pixel.y() - min_pixel.y());
+    for (const Vector2f& u_C :
+         {Vector2f(u, min_pixel.y()), Vector2f(u, max_pixel.y()),
+          Vector2f(min_pixel.x(), v), Vector2f(max_pixel.x(), v)}) {
+      viewport.extend(vectorFromImagePlaneCoordinates(u_C).head<2>());
+    }
+  }
+  return viewport;
 }
 
 // Frustum definitions.
@@ -0,0 +1,98 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "nvblox/sensors/internal/camera_ray_cache.h"
+
+#include <glog/logging.h>
+
+#include <algorithm>
+
+#include "nvblox/core/internal/error_check.h"
+
+namespace nvblox {
+
+// Number of blocks: enough that there's one thread per ray.
+// Number of threads: any.
+// @param camera The camera.
+// @param subsampling_factor The number of pixels per ray along each axis.
+// @param normalization How the rays are scaled.
+// @param rows The number of rows of rays.
+// @param cols The number of columns of rays.
+// @param rays The output table.
+__global__ void buildRayTableKernel(const Camera camera,
+                                    const int subsampling_factor,
+                                    const RayNormalization normalization,
+                                    const int rows, const int cols,
+                                    Vector3f* rays) {
+  const int ray_idx = blockIdx.x * blockDim.x + threadIdx.x;
+  if (ray_idx >= rows * cols) {
+    return;
+  }
+  // The ray passes through the center of the patch of pixels it represents.
+  const Index2D ray_indices(ray_idx % cols, ray_idx / cols);
+  const Vector2f pixel_coords =
+      (ray_indices * subsampling_factor).cast<float>() +
+      0.5f * static_cast<float>(subsampling_factor) * Vector2f::Ones();
+  const Vector3f ray = camera.vectorFromImagePlaneCoordinates(pixel_coords);
+  rays[ray_idx] =
+      normalization == RayNormalization::kUnitLength ? ray.normalized() : ray;
+}
+
+std::shared_ptr<const RayTable> CameraRayCache::getRays(
+    const Camera& camera, int subsampling_factor,
+    RayNormalization normalization, const CudaStream& cuda_stream) {
+  CHECK_GT(subsampling_factor, 0);
+  ++num_uses_;
+
+  // Intrinsics are compared exactly, as any change changes the rays.
+  for (Entry& entry : entries_) {
+    if (entry.subsampling_factor == subsampling_factor &&
+        entry.normalization == normalization &&
+        entry.camera.fu() == camera.fu() && entry.camera.fv() == camera.fv() &&
+        entry.camera.cu() == camera.cu() && entry.camera.cv() == camera.cv() &&
+        entry.camera.width() == camera.width() &&
+        entry.camera.height() == camera.height() &&
+        entry.camera.hasSameDistortion(camera)) {
+      entry.last_use = num_uses_;
+      return entry.rays;
+    }
+  }
+
+  // Make space by evicting the least recently used table.
+  if (entries_.size() >= static_cast<size_t>(kMaxNumTables)) {
+    entries_.erase(std::min_element(entries_.begin(), entries_.end(),
+                                    [](const Entry& a, const Entry& b) {
+                                      return a.last_use < b.last_use;
+                                    }));
+  }
+
+  const int rows = camera.rows() / subsampling_factor;
+  const int cols = camera.cols() / subsampling_factor;
+  auto rays = std::make_shared<RayTable>();
+  rays->resizeAsync(rows * cols, cuda_stream);
+  if (rows * cols > 0) {
+    constexpr int kNumThreadsPerBlock = 256;
+    const int num_blocks =
+        (rows * cols + kNumThreadsPerBlock - 1) / kNumThreadsPerBlock;
+    buildRayTableKernel<<<num_blocks, kNumThreadsPerBlock, 0, cuda_stream>>>(
+        camera, subsampling_factor, normalization, rows, cols, rays->data());
+    checkCudaErrors(cudaPeekAtLastError());
+  }
+  entries_.push_back(
+      {camera, subsampling_factor, normalization, rays, num_uses_});
+  return rays;
+}
+
+}  // namespace nvblox
@@ -15,6 +15,10 @@ limitations under the License.
 */
 #include "nvblox/sensors/depth_preprocessing.h"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
 namespace nvblox {
 
 /// Reallocates an output image to be the same size as the input image.
@@ -41,6 +45,8 @@ DepthPreprocessor::DepthPreprocessor(std::shared_ptr<CudaStream> cuda_stream)
   npp_stream_context_ = image::getNppStreamContext(*cuda_stream_);
 }
 
+DepthPreprocessor::~DepthPreprocessor() = default;
+
 float DepthPreprocessor::invalid_depth_threshold() const {
   return invalid_depth_threshold_;
 }
@@ -57,8 +63,62 @@ void DepthPreprocessor::invalid_depth_value(float invalid_depth_value) {
   invalid_depth_value_ = invalid_depth_value;
 };
 
+bool DepthPreprocessor::use_cuda_graph() const { return use_cuda_graph_; }
+
+void DepthPreprocessor::use_cuda_graph(bool use_cuda_graph) {
+  use_cuda_graph_ = use_cuda_graph;
+}
+
+DepthPreprocessingBackend DepthPreprocessor::backend() const {
+  return vpi_mask_dilator_ ? DepthPreprocessingBackend::kVpi
+                           : DepthPreprocessingBackend::kCuda;
+}
+
+void DepthPreprocessor::backend(DepthPreprocessingBackend backend) {
+  if (backend == DepthPreprocessingBackend::kCuda) {
+    vpi_mask_dilator_.reset();
+    return;
+  }
+  if (!VpiMaskDilator::isAvailable()) {
+    LOG(WARNING) << "nvblox was built without VPI support (USE_VPI). Keeping "
+                    "the CUDA depth preprocessing.";
+    return;
+  }
+  if (!vpi_mask_dilator_) {
+    vpi_mask_dilator_ = std::make_unique<VpiMaskDilator>();
+  }
+}
+
 void DepthPreprocessor::dilateInvalidRegionsAsync(const int num_dilations,
                                                   DepthImage* depth_image_ptr) {
+  dilateInvalidRegionsTemplateAsync(num_dilations, invalid_depth_threshold_,
+                                    invalid_depth_value_, depth_image_ptr);
+}
+
+void DepthPreprocessor::dilateInvalidRegionsAsync(
+    const int num_dilations, const float depth_scale_m,
+    DepthImageU16* depth_image_ptr) {
+  CHECK_GT(depth_scale_m, 0.0f);
+  // A pixel is invalid if value * scale < threshold, i.e. (for integer
+  // values) if value < ceil(threshold / scale).
+  constexpr float kMaxValue = std::numeric_limits<uint16_t>::max();
+  const float threshold =
+      std::clamp(std::ceil(invalid_depth_threshold_ / depth_scale_m), 0.0f,
+                 kMaxValue);
+  const float value = std::clamp(
+      std::round(invalid_depth_value_ / depth_scale_m), 0.0f, kMaxValue);
+  dilateInvalidRegionsTemplateAsync(num_dilations,
+                                    static_cast<uint16_t>(threshold),
+                                    static_cast<uint16_t>(value),
+                                    depth_image_ptr);
+}
+
+template <typename ImageType>
+void DepthPreprocessor::dilateInvalidRegionsTemplateAsync(
+    const int num_dilations,
+    const typename ImageType::ElementType invalid_depth_threshold,
+    const typename ImageType::ElementType invalid_depth_value,
+    ImageType* depth_image_ptr) {
   CHECK_NOTNULL(depth_image_ptr);
   CHECK_GE(num_dilations, 0);
   CHECK_GE(depth_image_ptr->rows(), 3);
@@ -67,15 +127,97 @@ void DepthPreprocessor::dilateInvalidRegionsAsync(const int num_dilations,
   if (num_dilations == 0) {
     LOG(WARNING) << "Request to dilate 0 times. Doing nothing.";
   }
-  // Allocate image space if required
+  // Allocate image space if required. Captured graphs refer to the scratch
+  // images, so they're invalidated by a reallocation.
+  if (depth_image_ptr->rows() != mask_.rows() ||
+      depth_image_ptr->cols() != mask_.cols()) {
+    dilation_graphs_.clear();
+    next_dilation_graph_idx_ = 0;
+  }
   reallocateImageToSameSizeIfRequired(*depth_image_ptr, &mask_);
   reallocateImageToSameSizeIfRequired(*depth_image_ptr, &mask_dilated_tmp_);
 
+  // The VPI backend synchronizes the stream, which can't be captured.
+  if (!use_cuda_graph_ || vpi_mask_dilator_ ||
+      cuda_stream_->get() == nullptr) {
+    launchDilationKernelsAsync(num_dilations, invalid_depth_threshold,
+                               invalid_depth_value, depth_image_ptr);
+    return;
+  }
+
+  // Replay the dilation if we've captured it before, otherwise capture it.
+  const DilationGraph* dilation_graph = findDilationGraph(
+      num_dilations, depth_image_ptr->dataConstPtr(), depth_image_ptr->rows(),
+      depth_image_ptr->cols(), invalid_depth_threshold, invalid_depth_value);
+  if (dilation_graph == nullptr) {
+    auto new_graph = std::make_unique<DilationGraph>();
+    new_graph->depth_image_ptr = depth_image_ptr->dataConstPtr();
+    new_graph->rows = depth_image_ptr->rows();
+    new_graph->cols = depth_image_ptr->cols();
+    new_graph->num_dilations = num_dilations;
+    new_graph->invalid_depth_threshold = invalid_depth_threshold;
+    new_graph->invalid_depth_value = invalid_depth_value;
+    new_graph->graph.beginCapture(*cuda_stream_);
+    launchDilationKernelsAsync(num_dilations, invalid_depth_threshold,
+                               invalid_depth_value, depth_image_ptr);
+    new_graph->graph.endCapture(*cuda_stream_);
+    dilation_graph = new_graph.get();
+    if (static_cast<int>(dilation_graphs_.size()) < kMaxNumDilationGraphs) {
+      dilation_graphs_.push_back(std::move(new_graph));
+    } else {
+      dilation_graphs_[next_dilation_graph_idx_] = std::move(new_graph);
+      next_dilation_graph_idx_ =
+          (next_dilation_graph_idx_ + 1) % kMaxNumDilationGraphs;
+    }
+  }
+  dilation_graph->graph.launch(*cuda_stream_);
+}
+
+const DepthPreprocessor::DilationGraph* DepthPreprocessor::findDilationGraph(
+    const int num_dilations, const void* depth_image_ptr, const int rows,
+    const int cols, const float invalid_depth_threshold,
+    const float invalid_depth_value) const {
+  for (const auto& dilation_graph : dilation_graphs_) {
+    if (dilation_graph->depth_image_ptr == depth_image_ptr &&
+        dilation_graph->rows == rows && dilation_graph->cols == cols &&
+        dilation_graph->num_dilations == num_dilations &&
+        dilation_graph->invalid_depth_threshold == invalid_depth_threshold &&
+        dilation_graph->invalid_depth_value == invalid_depth_value) {
+      return dilation_graph.get();
+    }
+  }
+  return nullptr;
+}
+
+template <typename ImageType>
+void DepthPreprocessor::launchDilationKernelsAsync(
+    const int num_dilations,
+    const typename ImageType::ElementType invalid_depth_threshold,
+    const typename ImageType::ElementType invalid_depth_value,
+    ImageType* depth_image_ptr) {
+  // Threshold and dilate in a single kernel, such that the intermediate masks
+  // never leave shared memory.
+  if (!vpi_mask_dilator_ && num_dilations <= image::kMaxNumFusedDilations) {
+    image::getDilatedInvalidDepthMaskGPUAsync(*depth_image_ptr,
+                                              invalid_depth_threshold,
+                                              num_dilations, &mask_,
+                                              *cuda_stream_);
+    image::maskedSetAsync(mask_, invalid_depth_value, npp_stream_context_,
+                          depth_image_ptr);
+    return;
+  }
+
   // Get the invalid region mask
   image::getInvalidDepthMaskAsync(*depth_image_ptr, npp_stream_context_, &mask_,
-                                  invalid_depth_threshold_);
+                                  invalid_depth_threshold);
 
   // Dilate the number of times requested
+  if (vpi_mask_dilator_) {
+    vpi_mask_dilator_->dilateMask3x3(num_dilations, *cuda_stream_, &mask_);
+    image::maskedSetAsync(mask_, invalid_depth_value, npp_stream_context_,
+                          depth_image_ptr);
+    return;
+  }
   MonoImage* dilation_in_ptr = &mask_;
   MonoImage* dilation_out_ptr = &mask_dilated_tmp_;
   for (int i = 0; i < num_dilations; i++) {
@@ -87,7 +229,7 @@ void DepthPreprocessor::dilateInvalidRegionsAsync(const int num_dilations,
   std::swap(dilation_in_ptr, dilation_out_ptr);
 
   // Set the masked regions invalid
-  image::maskedSetAsync(*dilation_out_ptr, invalid_depth_value_,
+  image::maskedSetAsync(*dilation_out_ptr, invalid_depth_value,
                         npp_stream_context_, depth_image_ptr);
 }
 
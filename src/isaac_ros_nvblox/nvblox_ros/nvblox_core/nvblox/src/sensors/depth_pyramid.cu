@@ -0,0 +1,217 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "nvblox/sensors/depth_pyramid.h"
+
+#include <glog/logging.h>
+
+#include "nvblox/core/internal/error_check.h"
+
+namespace nvblox {
+
+namespace {
+
+// Each thread block reduces a tile of kTileSize x kTileSize pixels to a single
+// cell of the coarsest level. Each thread computes one cell of the first
+// level from 2x2 pixels.
+constexpr int kTileSize = 1 << DepthPyramid::kNumLevels;
+constexpr int kNumThreadsPerTileSide = kTileSize / 2;
+
+// The output of the pyramid kernel, passed by value.
+struct DepthPyramidLevels {
+  DepthPyramidCell* cells[DepthPyramid::kNumLevels];
+  int rows[DepthPyramid::kNumLevels];
+  int cols[DepthPyramid::kNumLevels];
+};
+
+__host__ __device__ inline DepthPyramidCell mergeCells(
+    const DepthPyramidCell& cell_1, const DepthPyramidCell& cell_2) {
+  if (cell_1.num_valid == 0) {
+    return cell_2;
+  }
+  if (cell_2.num_valid == 0) {
+    return cell_1;
+  }
+  return DepthPyramidCell{fminf(cell_1.min_depth, cell_2.min_depth),
+                          fmaxf(cell_1.max_depth, cell_2.max_depth),
+                          cell_1.num_valid + cell_2.num_valid};
+}
+
+__device__ inline DepthPyramidCell pixelCell(const float* depth_image,
+                                             const int row, const int col,
+                                             const int rows, const int cols) {
+  if (row >= rows || col >= cols) {
+    return DepthPyramidCell{0.0f, 0.0f, 0};
+  }
+  const float depth = depth_image[row * cols + col];
+  if (depth <= 0.0f) {
+    return DepthPyramidCell{0.0f, 0.0f, 0};
+  }
+  return DepthPyramidCell{depth, depth, 1};
+}
+
+// Number of blocks: one per kTileSize x kTileSize tile of the image.
+// Number of threads: kNumThreadsPerTileSide x kNumThreadsPerTileSide.
+__global__ void buildDepthPyramidKernel(const float* depth_image,
+                                        const int rows, const int cols,
+                                        DepthPyramidLevels levels) {
+  __shared__ DepthPyramidCell tile[kNumThreadsPerTileSide]
+                                  [kNumThreadsPerTileSide];
+
+  // Level 1: each thread reduces 2x2 pixels.
+  const int tx = threadIdx.x;
+  const int ty = threadIdx.y;
+  const int row_1 = blockIdx.y * kNumThreadsPerTileSide + ty;
+  const int col_1 = blockIdx.x * kNumThreadsPerTileSide + tx;
+  DepthPyramidCell cell = pixelCell(depth_image, 2 * row_1, 2 * col_1, rows,
+                                    cols);
+  cell = mergeCells(
+      cell, pixelCell(depth_image, 2 * row_1, 2 * col_1 + 1, rows, cols));
+  cell = mergeCells(
+      cell, pixelCell(depth_image, 2 * row_1 + 1, 2 * col_1, rows, cols));
+  cell = mergeCells(
+      cell, pixelCell(depth_image, 2 * row_1 + 1, 2 * col_1 + 1, rows, cols));
+  if (row_1 < levels.rows[0] && col_1 < levels.cols[0]) {
+    levels.cells[0][row_1 * levels.cols[0] + col_1] = cell;
+  }
+  tile[ty][tx] = cell;
+
+  // Higher levels: the threads at the corner of each 2x2 group of cells of the
+  // level below reduce the group in shared memory.
+  for (int level_idx = 1; level_idx < DepthPyramid::kNumLevels; ++level_idx) {
+    __syncthreads();
+    const int stride = 1 << level_idx;
+    const int half_stride = stride / 2;
+    const bool is_reducing = (tx % stride == 0) && (ty % stride == 0);
+    if (is_reducing) {
+      cell = mergeCells(
+          mergeCells(tile[ty][tx], tile[ty][tx + half_stride]),
+          mergeCells(tile[ty + half_stride][tx],
+                     tile[ty + half_stride][tx + half_stride]));
+    }
+    __syncthreads();
+    if (is_reducing) {
+      tile[ty][tx] = cell;
+      const int cells_per_tile_side = kNumThreadsPerTileSide / stride;
+      const int row = blockIdx.y * cells_per_tile_side + ty / stride;
+      const int col = blockIdx.x * cells_per_tile_side + tx / stride;
+      if (row < levels.rows[level_idx] && col < levels.cols[level_idx]) {
+        levels.cells[level_idx][row * levels.cols[level_idx] + col] = cell;
+      }
+    }
+  }
+}
+
+// One thread per cell.
+__global__ void cellsMinDepthKernel(const DepthPyramidCell* cells,
+                                    const int num_cells, float* min_depths) {
+  const int idx = blockIdx.x * blockDim.x + threadIdx.x;
+  if (idx < num_cells) {
+    min_depths[idx] = cells[idx].min_depth;
+  }
+}
+
+}  // namespace
+
+void DepthPyramid::buildAsync(const DepthImageConstView& depth_image,
+                              const CudaStream& cuda_stream) {
+  CHECK_GT(depth_image.rows(), 0);
+  CHECK_GT(depth_image.cols(), 0);
+  source_ptr_ = depth_image.dataConstPtr();
+  source_rows_ = depth_image.rows();
+  source_cols_ = depth_image.cols();
+
+  DepthPyramidLevels levels;
+  for (int level_idx = 0; level_idx < kNumLevels; ++level_idx) {
+    const int factor = 1 << (level_idx + 1);
+    level_rows_[level_idx] = (source_rows_ + factor - 1) / factor;
+    level_cols_[level_idx] = (source_cols_ + factor - 1) / factor;
+    levels_[level_idx].resizeAsync(
+        static_cast<size_t>(level_rows_[level_idx]) * level_cols_[level_idx],
+        cuda_stream);
+    levels.cells[level_idx] = levels_[level_idx].data();
+    levels.rows[level_idx] = level_rows_[level_idx];
+    levels.cols[level_idx] = level_cols_[level_idx];
+  }
+
+  const dim3 num_threads(kNumThreadsPerTileSide, kNumThreadsPerTileSide);
+  const dim3 num_blocks(level_cols_[kNumLevels - 1],
+                        level_rows_[kNumLevels - 1]);
+  buildDepthPyramidKernel<<<num_blocks, num_threads, 0, cuda_stream>>>(
+      source_ptr_, source_rows_, source_cols_, levels);
+  checkCudaErrors(cudaPeekAtLastError());
+}
+
+int DepthPyramid::levelForSubsamplingFactor(int subsampling_factor) {
+  for (int level = 1; level <= kNumLevels; ++level) {
+    if (subsampling_factor == (1 << level)) {
+      return level;
+    }
+  }
+  return 0;
+}
+
+int DepthPyramid::checkedLevelIndex(int level) const {
+  CHECK(!empty()) << "The depth pyramid hasn't been built.";
+  CHECK_GE(level, 1);
+  CHECK_LE(level, kNumLevels);
+  return level - 1;
+}
+
+int DepthPyramid::rows(int level) const {
+  return level_rows_[checkedLevelIndex(level)];
+}
+
+int DepthPyramid::cols(int level) const {
+  return level_cols_[checkedLevelIndex(level)];
+}
+
+const DepthPyramidCell* DepthPyramid::cellsDevicePtr(int level) const {
+  return levels_[checkedLevelIndex(level)].data();
+}
+
+std::vector<DepthPyramidCell> DepthPyramid::levelToHost(
+    int level, const CudaStream& cuda_stream) const {
+  std::vector<DepthPyramidCell> cells =
+      levels_[checkedLevelIndex(level)].toVectorAsync(cuda_stream);
+  cuda_stream.synchronize();
+  return cells;
+}
+
+void DepthPyramid::minDepthToImageAsync(int level, DepthImage* image_out,
+                                        const CudaStream& cuda_stream) const {
+  CHECK_NOTNULL(image_out);
+  const int level_idx = checkedLevelIndex(level);
+  image_out->resizeAsync(level_rows_[level_idx], level_cols_[level_idx],
+                         cuda_stream);
+  CHECK_EQ(image_out->stride_num_elements(), image_out->cols());
+  const int num_cells = level_rows_[level_idx] * level_cols_[level_idx];
+  constexpr int kNumThreads = 512;
+  const int num_blocks = (num_cells + kNumThreads - 1) / kNumThreads;
+  cellsMinDepthKernel<<<num_blocks, kNumThreads, 0, cuda_stream>>>(
+      levels_[level_idx].data(), num_cells, image_out->dataPtr());
+  checkCudaErrors(cudaPeekAtLastError());
+}
+
+DepthPyramidCell DepthPyramid::getImageCell(
+    const CudaStream& cuda_stream) const {
+  DepthPyramidCell image_cell{0.0f, 0.0f, 0};
+  for (const DepthPyramidCell& cell : levelToHost(kNumLevels, cuda_stream)) {
+    image_cell = mergeCells(image_cell, cell);
+  }
+  return image_cell;
+}
+
+}  // namespace nvblox
@@ -293,8 +293,20 @@ __device__ OutputType elementCast(const InputType input) {
   return static_cast<OutputType>(input);
 }
 
-template <typename InputImageType, typename OutputImageType>
+struct depth_scale_functor {
+  depth_scale_functor(float depth_scale_m) : depth_scale_m_(depth_scale_m) {}
+
+  __device__ float operator()(const uint16_t& pixel_value) const {
+    return static_cast<float>(pixel_value) * depth_scale_m_;
+  }
+
+  const float depth_scale_m_;
+};
+
+template <typename InputImageType, typename OutputImageType,
+          typename CastFunctor>
 void castTemplateAsync(const InputImageType& image_in,
+                       const CastFunctor& functor,
                        OutputImageType* image_out_ptr,
                        const CudaStream& cuda_stream) {
   CHECK(image_in.memory_type() == MemoryType::kDevice ||
@@ -315,20 +327,158 @@ void castTemplateAsync(const InputImageType& image_in,
       image_out_ptr->dataPtr());
   thrust::transform(thrust::device.on(cuda_stream), dev_input_ptr,
                     dev_input_ptr + (image_in.rows() * image_in.cols()),
-                    dev_output_ptr,
-                    cast_functor<OutputElementType, InputElementType>());
+                    dev_output_ptr, functor);
+}
+
+template <typename InputImageType, typename OutputImageType>
+void castTemplateAsync(const InputImageType& image_in,
+                       OutputImageType* image_out_ptr,
+                       const CudaStream& cuda_stream) {
+  using OutputElementType = typename OutputImageType::ElementType;
+  using InputElementType = typename InputImageType::ElementType;
+  castTemplateAsync(image_in,
+                    cast_functor<OutputElementType, InputElementType>(),
+                    image_out_ptr, cuda_stream);
+}
+
+__global__ void colorImageFromRgbKernel(const uint8_t* rgb, const int rows,
+                                        const int cols, Color* color_out) {
+  const int col = blockIdx.x * blockDim.x + threadIdx.x;
+  const int row = blockIdx.y * blockDim.y + threadIdx.y;
+  if (row < rows && col < cols) {
+    const int lin_idx = row * cols + col;
+    const uint8_t* pixel = rgb + 3 * lin_idx;
+    color_out[lin_idx] = Color(pixel[0], pixel[1], pixel[2], 255);
+  }
+}
+
+// Threshold and dilate a depth image in one pass. Each thread block computes
+// a tile of the mask. It reads the invalid flags of the tile plus a halo of
+// num_dilations pixels (clamped to the image, which replicates the border)
+// into shared memory and applies the (2 * num_dilations + 1)^2 square as a
+// horizontal and a vertical pass.
+//  n_threads: kDilationTileCols x kDilationTileRows
+//  n_blocks: one per tile
+//  shared memory: see dilationSharedMemoryBytes()
+constexpr int kDilationTileCols = 32;
+constexpr int kDilationTileRows = 16;
+
+size_t dilationSharedMemoryBytes(const int num_dilations) {
+  const int halo_rows = kDilationTileRows + 2 * num_dilations;
+  const int halo_cols = kDilationTileCols + 2 * num_dilations;
+  return halo_rows * halo_cols + halo_rows * kDilationTileCols;
+}
+
+template <typename ElementType>
+__global__ void dilatedInvalidDepthMaskKernel(
+    ImageView<const ElementType> depth_image,
+    const ElementType invalid_threshold, const int num_dilations,
+    MonoImageView mask) {
+  extern __shared__ uint8_t dilation_shared_memory[];
+  const int halo_rows = kDilationTileRows + 2 * num_dilations;
+  const int halo_cols = kDilationTileCols + 2 * num_dilations;
+  uint8_t* is_invalid = dilation_shared_memory;
+  uint8_t* is_invalid_dilated_horizontally =
+      dilation_shared_memory + halo_rows * halo_cols;
+
+  const int tile_row = blockIdx.y * kDilationTileRows;
+  const int tile_col = blockIdx.x * kDilationTileCols;
+  const int thread_idx = threadIdx.y * blockDim.x + threadIdx.x;
+  const int num_threads = blockDim.x * blockDim.y;
+
+  // Threshold the tile and its halo.
+  for (int i = thread_idx; i < halo_rows * halo_cols; i += num_threads) {
+    const int row = min(max(tile_row - num_dilations + i / halo_cols, 0),
+                        depth_image.rows() - 1);
+    const int col = min(max(tile_col - num_dilations + i % halo_cols, 0),
+                        depth_image.cols() - 1);
+    is_invalid[i] = depth_image(row, col) < invalid_threshold;
+  }
+  __syncthreads();
+
+  // Dilate the rows, including those of the halo.
+  for (int i = thread_idx; i < halo_rows * kDilationTileCols;
+       i += num_threads) {
+    const uint8_t* row_start =
+        is_invalid + (i / kDilationTileCols) * halo_cols +
+        i % kDilationTileCols;
+    uint8_t any_invalid = 0;
+    for (int k = 0; k <= 2 * num_dilations; ++k) {
+      any_invalid |= row_start[k];
+    }
+    is_invalid_dilated_horizontally[i] = any_invalid;
+  }
+  __syncthreads();
+
+  // Dilate the columns.
+  const int row = tile_row + threadIdx.y;
+  const int col = tile_col + threadIdx.x;
+  if (row >= mask.rows() || col >= mask.cols()) {
+    return;
+  }
+  uint8_t any_invalid = 0;
+  for (int k = 0; k <= 2 * num_dilations; ++k) {
+    any_invalid |= is_invalid_dilated_horizontally[(threadIdx.y + k) *
+                                                       kDilationTileCols +
+                                                   threadIdx.x];
+  }
+  mask(row, col) = any_invalid ? 255 : 0;
+}
+
+template <typename ElementType>
+void getDilatedInvalidDepthMaskGPUAsyncTemplate(
+    const Image<ElementType>& depth_image, const ElementType invalid_threshold,
+    const int num_dilations, MonoImage* mask_ptr,
+    const CudaStream& cuda_stream) {
+  CHECK_NOTNULL(mask_ptr);
+  CHECK_GE(num_dilations, 0);
+  CHECK_LE(num_dilations, kMaxNumFusedDilations);
+  CHECK_EQ(depth_image.rows(), mask_ptr->rows());
+  CHECK_EQ(depth_image.cols(), mask_ptr->cols());
+  if (depth_image.numel() == 0) {
+    return;
+  }
+  const dim3 num_threads(kDilationTileCols, kDilationTileRows);
+  const dim3 num_blocks(
+      (depth_image.cols() + kDilationTileCols - 1) / kDilationTileCols,
+      (depth_image.rows() + kDilationTileRows - 1) / kDilationTileRows);
+  dilatedInvalidDepthMaskKernel<ElementType>
+      <<<num_blocks, num_threads, dilationSharedMemoryBytes(num_dilations),
+         cuda_stream>>>(ImageView<const ElementType>(depth_image),
+                        invalid_threshold, num_dilations,
+                        MonoImageView(*mask_ptr));
+  checkCudaErrors(cudaPeekAtLastError());
+}
+
+void getDilatedInvalidDepthMaskGPUAsync(const DepthImage& depth_image,
+                                        const float invalid_threshold,
+                                        const int num_dilations,
+                                        MonoImage* mask_ptr,
+                                        const CudaStream& cuda_stream) {
+  getDilatedInvalidDepthMaskGPUAsyncTemplate(
+      depth_image, invalid_threshold, num_dilations, mask_ptr, cuda_stream);
+}
+
+void getDilatedInvalidDepthMaskGPUAsync(const DepthImageU16& depth_image,
+                                        const uint16_t invalid_threshold,
+                                        const int num_dilations,
+                                        MonoImage* mask_ptr,
+                                        const CudaStream& cuda_stream) {
+  getDilatedInvalidDepthMaskGPUAsyncTemplate(
+      depth_image, invalid_threshold, num_dilations, mask_ptr, cuda_stream);
 }
 
-// Copy every second pixel from image_in to image_out
+// Copy every factor-th pixel from image_in to image_out
 //
 // @param image_in Input image
-// @param image_out Output image. Must be half the size of image_in (rounding
-// downwards)
+// @param image_out Output image. Must be 1/factor the size of image_in
+// (rounding downwards)
 //  n_threads: <= image_out.cols()
 //  n_blocks: = image_out.rows()
-__global__ void naiveDownscaleKernel(MonoImageConstView image_in,
+template <typename ElementType>
+__global__ void naiveDownscaleKernel(ImageView<const ElementType> image_in,
                                      const int factor,
-                                     MonoImageView image_out) {
+                                     ImageView<ElementType> image_out) {
   assert(image_out.rows() == image_in.rows() / factor);
   assert(image_out.cols() == image_in.cols() / factor);
 
@@ -342,27 +492,132 @@ __global__ void naiveDownscaleKernel(MonoImageConstView image_in,
   }
 }
 
-void naiveDownscaleGPUAsync(const MonoImage& image_in, const int factor,
-                            MonoImage* image_out,
-                            const CudaStream& cuda_stream) {
+template <typename ElementType>
+void naiveDownscaleGPUAsyncTemplate(const Image<ElementType>& image_in,
+                                    const int factor,
+                                    Image<ElementType>* image_out,
+                                    const CudaStream& cuda_stream) {
+  CHECK_NOTNULL(image_out);
   const int new_rows = image_in.rows() / factor;
   const int new_cols = image_in.cols() / factor;
 
   // Only non-strided data supported
   CHECK_EQ(image_in.stride_num_elements(), image_in.cols());
-  CHECK_EQ(image_out->stride_num_elements(), image_out->cols());
   CHECK_GT(new_rows, 0);
   CHECK_GT(new_cols, 0);
 
   image_out->resizeAsync(new_rows, new_cols, cuda_stream);
+  CHECK_EQ(image_out->stride_num_elements(), image_out->cols());
 
   constexpr int kMaxNumThreadsPerBlock = 1024;
   const int num_blocks = new_rows;
   const int num_threads_per_block =
       std::min(kMaxNumThreadsPerBlock, image_out->cols());
 
-  naiveDownscaleKernel<<<num_blocks, num_threads_per_block, 0, cuda_stream>>>(
-      image_in, factor, *image_out);
+  naiveDownscaleKernel<ElementType>
+      <<<num_blocks, num_threads_per_block, 0, cuda_stream>>>(
+          ImageView<const ElementType>(image_in), factor,
+          ImageView<ElementType>(*image_out));
+  checkCudaErrors(cudaPeekAtLastError());
+}
+
+void naiveDownscaleGPUAsync(const MonoImage& image_in, const int factor,
+                            MonoImage* image_out,
+                            const CudaStream& cuda_stream) {
+  naiveDownscaleGPUAsyncTemplate(image_in, factor, image_out, cuda_stream);
+}
+
+void naiveDownscaleGPUAsync(const DepthImage& image_in, const int factor,
+                            DepthImage* image_out,
+                            const CudaStream& cuda_stream) {
+  naiveDownscaleGPUAsyncTemplate(image_in, factor, image_out, cuda_stream);
+}
+
+// One thread per output pixel.
+template <typename DepthElementType>
+__global__ void minDownscaleKernel(
+    MaskedImageView<const DepthElementType> image_in,
+    const float depth_scale_m, const int factor, DepthImageView image_out,
+    uint8_t* mask_out) {
+  const int row = blockIdx.y * blockDim.y + threadIdx.y;
+  const int col = blockIdx.x * blockDim.x + threadIdx.x;
+  if (row >= image_out.rows() || col >= image_out.cols()) {
+    return;
+  }
+  const int row_end = min((row + 1) * factor, image_in.rows());
+  const int col_end = min((col + 1) * factor, image_in.cols());
+  float min_depth = 0.0f;
+  bool min_depth_is_masked = true;
+  for (int in_row = row * factor; in_row < row_end; ++in_row) {
+    for (int in_col = col * factor; in_col < col_end; ++in_col) {
+      const float depth =
+          static_cast<float>(image_in(in_row, in_col)) * depth_scale_m;
+      if (depth > 0.0f && (min_depth <= 0.0f || depth < min_depth)) {
+        min_depth = depth;
+        min_depth_is_masked = image_in.isMasked(in_row, in_col);
+      }
+    }
+  }
+  image_out(row, col) = min_depth;
+  if (mask_out != nullptr) {
+    // Patches without valid depth take the mask of their first pixel.
+    if (min_depth <= 0.0f) {
+      min_depth_is_masked = image_in.isMasked(row * factor, col * factor);
+    }
+    mask_out[row * image_out.cols() + col] =
+        min_depth_is_masked ? kMaskedValue : 0;
+  }
+}
+
+template <typename DepthElementType>
+void minDownscaleGPUAsyncTemplate(
+    const MaskedImageView<const DepthElementType>& image_in,
+    const float depth_scale_m, const int factor, DepthImage* image_out,
+    MonoImage* mask_out, const CudaStream& cuda_stream) {
+  CHECK_NOTNULL(image_out);
+  CHECK_GT(factor, 0);
+  const bool has_mask = image_in.mask().dataConstPtr() != nullptr;
+  CHECK(!has_mask || mask_out != nullptr)
+      << "The image has a mask, so the downscaled mask is needed.";
+  const int new_rows = (image_in.rows() + factor - 1) / factor;
+  const int new_cols = (image_in.cols() + factor - 1) / factor;
+  CHECK_GT(new_rows, 0);
+  CHECK_GT(new_cols, 0);
+
+  image_out->resizeAsync(new_rows, new_cols, cuda_stream);
+  CHECK_EQ(image_out->stride_num_elements(), image_out->cols());
+  uint8_t* mask_out_ptr = nullptr;
+  if (has_mask) {
+    mask_out->resizeAsync(new_rows, new_cols, cuda_stream);
+    CHECK_EQ(mask_out->stride_num_elements(), mask_out->cols());
+    mask_out_ptr = mask_out->dataPtr();
+  }
+
+  constexpr int kThreadsPerBlockSide = 16;
+  const dim3 num_threads(kThreadsPerBlockSide, kThreadsPerBlockSide);
+  const dim3 num_blocks(
+      (new_cols + kThreadsPerBlockSide - 1) / kThreadsPerBlockSide,
+      (new_rows + kThreadsPerBlockSide - 1) / kThreadsPerBlockSide);
+  minDownscaleKernel<DepthElementType>
+      <<<num_blocks, num_threads, 0, cuda_stream>>>(
+          image_in, depth_scale_m, factor, DepthImageView(*image_out),
+          mask_out_ptr);
+  checkCudaErrors(cudaPeekAtLastError());
+}
+
+void minDownscaleGPUAsync(const MaskedDepthImageConstView& image_in,
+                          const int factor, DepthImage* image_out,
+                          MonoImage* mask_out, const CudaStream& cuda_stream) {
+  minDownscaleGPUAsyncTemplate(image_in, 1.0f, factor, image_out, mask_out,
+                               cuda_stream);
+}
+
+void minDownscaleGPUAsync(const MaskedDepthImageU16ConstView& image_in,
+                          const float depth_scale_m, const int factor,
+                          DepthImage* image_out, MonoImage* mask_out,
+                          const CudaStream& cuda_stream) {
+  minDownscaleGPUAsyncTemplate(image_in, depth_scale_m, factor, image_out,
+                               mask_out, cuda_stream);
 }
 
 __global__ void upscaleKernel(MonoImageConstView image_in, const int factor,
@@ -402,10 +657,196 @@ void upscaleGPUAsync(const MonoImage& image_in, const int factor,
       image_in, factor, *image_out);
 }
 
+template <typename ElementType>
+__global__ void padOrCropKernel(ImageView<const ElementType> image_in,
+                                const int row_offset, const int col_offset,
+                                ImageView<ElementType> image_out) {
+  const int row = blockIdx.x;
+  const int col_start = threadIdx.x;
+  if (row >= image_out.rows()) {
+    return;
+  }
+  // The input row this output row is taken from. Out of bounds means padding.
+  const int row_in = row + row_offset;
+  const bool row_in_bounds = row_in >= 0 && row_in < image_in.rows();
+  for (int col = col_start; col < image_out.cols(); col += blockDim.x) {
+    const int col_in = col + col_offset;
+    if (row_in_bounds && col_in >= 0 && col_in < image_in.cols()) {
+      image_out(row, col) = image_in(row_in, col_in);
+    } else {
+      image_out(row, col) = ElementType{};
+    }
+  }
+}
+
+template <typename ElementType>
+void padOrCropGPUAsyncTemplate(const Image<ElementType>& image_in,
+                               const int desired_rows, const int desired_cols,
+                               Image<ElementType>* image_out,
+                               const CudaStream& cuda_stream) {
+  CHECK_NOTNULL(image_out);
+  CHECK_GT(desired_rows, 0);
+  CHECK_GT(desired_cols, 0);
+  CHECK_NE(image_in.dataConstPtr(), image_out->dataConstPtr())
+      << "Padding/cropping in place is not supported.";
+
+  image_out->resizeAsync(desired_rows, desired_cols, cuda_stream);
+
+  // Positive offsets crop, negative offsets pad. Truncation towards zero puts
+  // the odd pixel (if any) at the bottom/right.
+  const int row_offset = (image_in.rows() - desired_rows) / 2;
+  const int col_offset = (image_in.cols() - desired_cols) / 2;
+
+  constexpr int kMaxNumThreadsPerBlock = 1024;
+  const int num_blocks = desired_rows;
+  const int num_threads_per_block =
+      std::min(kMaxNumThreadsPerBlock, desired_cols);
+
+  padOrCropKernel<ElementType>
+      <<<num_blocks, num_threads_per_block, 0, cuda_stream>>>(
+          ImageView<const ElementType>(image_in), row_offset, col_offset,
+          ImageView<ElementType>(*image_out));
+  checkCudaErrors(cudaPeekAtLastError());
+}
+
+void padOrCropGPUAsync(const MonoImage& image_in, const int desired_rows,
+                       const int desired_cols, MonoImage* image_out,
+                       const CudaStream& cuda_stream) {
+  padOrCropGPUAsyncTemplate(image_in, desired_rows, desired_cols, image_out,
+                            cuda_stream);
+}
+
+void padOrCropGPUAsync(const DepthImage& image_in, const int desired_rows,
+                       const int desired_cols, DepthImage* image_out,
+                       const CudaStream& cuda_stream) {
+  padOrCropGPUAsyncTemplate(image_in, desired_rows, desired_cols, image_out,
+                            cuda_stream);
+}
+
+void padOrCropGPUAsync(const ColorImage& image_in, const int desired_rows,
+                       const int desired_cols, ColorImage* image_out,
+                       const CudaStream& cuda_stream) {
+  padOrCropGPUAsyncTemplate(image_in, desired_rows, desired_cols, image_out,
+                            cuda_stream);
+}
+
+void cropGPUAsync(const DepthImage& image_in, const ImageBoundingBox& bbox,
+                  DepthImage* image_out, const CudaStream& cuda_stream) {
+  CHECK_NOTNULL(image_out);
+  CHECK(!bbox.isEmpty());
+  CHECK(bbox.min().x() >= 0 && bbox.max().x() < image_in.cols());
+  CHECK(bbox.min().y() >= 0 && bbox.max().y() < image_in.rows());
+  CHECK_NE(image_in.dataConstPtr(), image_out->dataConstPtr())
+      << "Cropping in place is not supported.";
+
+  const int cropped_rows = bbox.max().y() - bbox.min().y() + 1;
+  const int cropped_cols = bbox.max().x() - bbox.min().x() + 1;
+  image_out->resizeAsync(cropped_rows, cropped_cols, cuda_stream);
+
+  constexpr int kMaxNumThreadsPerBlock = 1024;
+  const int num_blocks = cropped_rows;
+  const int num_threads_per_block =
+      std::min(kMaxNumThreadsPerBlock, cropped_cols);
+
+  padOrCropKernel<float><<<num_blocks, num_threads_per_block, 0, cuda_stream>>>(
+      DepthImageConstView(image_in), bbox.min().y(), bbox.min().x(),
+      DepthImageView(*image_out));
+  checkCudaErrors(cudaPeekAtLastError());
+}
+
+// One thread block per row. Each block reduces its row to the range of valid
+// columns, then updates the global bounds atomically.
+__global__ void validDepthBoundingBoxKernel(DepthImageConstView image,
+                                            int* min_col, int* min_row,
+                                            int* max_col, int* max_row) {
+  const int row = blockIdx.x;
+  if (row >= image.rows()) {
+    return;
+  }
+  __shared__ int row_min_col;
+  __shared__ int row_max_col;
+  if (threadIdx.x == 0) {
+    row_min_col = image.cols();
+    row_max_col = -1;
+  }
+  __syncthreads();
+
+  for (int col = threadIdx.x; col < image.cols(); col += blockDim.x) {
+    if (image(row, col) > 0.0f) {
+      atomicMin(&row_min_col, col);
+      atomicMax(&row_max_col, col);
+    }
+  }
+  __syncthreads();
+
+  if (threadIdx.x == 0 && row_max_col >= 0) {
+    atomicMin(min_col, row_min_col);
+    atomicMax(max_col, row_max_col);
+    atomicMin(min_row, row);
+    atomicMax(max_row, row);
+  }
+}
+
+ImageBoundingBox getValidDepthBoundingBoxGPU(const DepthImage& image,
+                                             const CudaStream& cuda_stream) {
+  if (image.rows() == 0 || image.cols() == 0) {
+    return ImageBoundingBox();
+  }
+  // Min col, min row, max col, max row.
+  device_vector<int> bounds_device;
+  bounds_device.copyFromAsync(
+      std::vector<int>{image.cols(), image.rows(), -1, -1}, cuda_stream);
+
+  constexpr int kMaxNumThreadsPerBlock = 1024;
+  const int num_threads_per_block =
+      std::min(kMaxNumThreadsPerBlock, image.cols());
+  validDepthBoundingBoxKernel<<<image.rows(), num_threads_per_block, 0,
+                                cuda_stream>>>(
+      DepthImageConstView(image),  // NOLINT
+      bounds_device.data(),        // NOLINT
+      bounds_device.data() + 1,    // NOLINT
+      bounds_device.data() + 2,    // NOLINT
+      bounds_device.data() + 3);
+  checkCudaErrors(cudaPeekAtLastError());
+  const std::vector<int> bounds = bounds_device.toVectorAsync(cuda_stream);
+  cuda_stream.synchronize();
+
+  if (bounds[2] < 0) {
+    return ImageBoundingBox();
+  }
+  return ImageBoundingBox(Index2D(bounds[0], bounds[1]),
+                          Index2D(bounds[2], bounds[3]));
+}
+
 void castGPUAsync(const DepthImage& image_in, MonoImage* image_out_ptr,
                   const CudaStream& cuda_stream) {
   castTemplateAsync(image_in, image_out_ptr, cuda_stream);
 }
 
+void castGPUAsync(const DepthImageU16& image_in, const float depth_scale_m,
+                  DepthImage* image_out_ptr, const CudaStream& cuda_stream) {
+  castTemplateAsync(image_in, depth_scale_functor(depth_scale_m),
+                    image_out_ptr, cuda_stream);
+}
+
+void colorImageFromRgbGPUAsync(const uint8_t* rgb_device, const int rows,
+                               const int cols, ColorImage* image_out_ptr,
+                               const CudaStream& cuda_stream) {
+  CHECK_NOTNULL(rgb_device);
+  CHECK_NOTNULL(image_out_ptr);
+  if (image_out_ptr->rows() != rows || image_out_ptr->cols() != cols ||
+      image_out_ptr->memory_type() == MemoryType::kHost) {
+    *image_out_ptr = ColorImage(rows, cols, MemoryType::kDevice);
+  }
+  constexpr int kThreadsPerBlockDim = 16;
+  const dim3 num_threads_per_block(kThreadsPerBlockDim, kThreadsPerBlockDim);
+  const dim3 num_blocks(cols / kThreadsPerBlockDim + 1,
+                        rows / kThreadsPerBlockDim + 1);
+  colorImageFromRgbKernel<<<num_blocks, num_threads_per_block, 0,
+                            cuda_stream>>>(rgb_device, rows, cols,
+                                           image_out_ptr->dataPtr());
+  checkCudaErrors(cudaPeekAtLastError());
+}
+
 }  // namespace image
 }  // namespace nvblox
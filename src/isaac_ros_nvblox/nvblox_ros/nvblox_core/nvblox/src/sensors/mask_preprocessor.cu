@@ -0,0 +1,207 @@
+/*
+Copyright 2023 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "nvblox/sensors/mask_preprocessor.h"
+
+#include "nvblox/core/internal/error_check.h"
+#include "nvblox/utils/timing.h"
+
+namespace nvblox {
+namespace image {
+
+// Connected-component labeling on the GPU, using union-find with label
+// equivalence (see Playne & Hawick, "A New Algorithm for Parallel
+// Connected-Component Labelling on GPUs", 2018). Each active pixel is labeled
+// with the linear index of the root pixel of its component.
+//  1. Every active pixel starts as its own root.
+//  2. Every active pixel is merged with its active west and north neighbors.
+//  3. Labels are flattened to point directly at their root, and the pixels of
+//     each component are counted at the root.
+//  4. Pixels of components below the size threshold are cleared.
+// All steps are launched on the same stream without host synchronization.
+
+// Label of pixels which are not part of any component.
+constexpr int kBackgroundLabel = -1;
+
+__device__ int findRoot(const int* labels, int index) {
+  int parent = labels[index];
+  while (parent != index) {
+    index = parent;
+    parent = labels[index];
+  }
+  return index;
+}
+
+// Merge the trees containing a and b, attaching the larger root to the
+// smaller. Retries until the merge is not lost to a concurrent merge.
+__device__ void unite(int* labels, int a, int b) {
+  bool done = false;
+  while (!done) {
+    a = findRoot(labels, a);
+    b = findRoot(labels, b);
+    if (a < b) {
+      const int old = atomicMin(&labels[b], a);
+      done = (old == b);
+      b = old;
+    } else if (b < a) {
+      const int old = atomicMin(&labels[a], b);
+      done = (old == a);
+      a = old;
+    } else {
+      done = true;
+    }
+  }
+}
+
+__global__ void initLabelsKernel(MonoImageConstView mask, int* labels) {
+  const int row = blockIdx.x;
+  if (row >= mask.rows()) {
+    return;
+  }
+  for (int col = threadIdx.x; col < mask.cols(); col += blockDim.x) {
+    const int index = row * mask.cols() + col;
+    labels[index] = mask(row, col) > 0 ? index : kBackgroundLabel;
+  }
+}
+
+__global__ void mergeLabelsKernel(MonoImageConstView mask, int* labels) {
+  const int row = blockIdx.x;
+  if (row >= mask.rows()) {
+    return;
+  }
+  for (int col = threadIdx.x; col < mask.cols(); col += blockDim.x) {
+    if (mask(row, col) == 0) {
+      continue;
+    }
+    const int index = row * mask.cols() + col;
+    // 4-connectivity, like the previous CPU implementation.
+    if (col > 0 && mask(row, col - 1) > 0) {
+      unite(labels, index, index - 1);
+    }
+    if (row > 0 && mask(row - 1, col) > 0) {
+      unite(labels, index, index - mask.cols());
+    }
+  }
+}
+
+__global__ void flattenAndCountKernel(const int num_pixels, int* labels,
+                                      int* component_sizes) {
+  const int index = blockIdx.x * blockDim.x + threadIdx.x;
+  if (index >= num_pixels || labels[index] == kBackgroundLabel) {
+    return;
+  }
+  const int root = findRoot(labels, index);
+  labels[index] = root;
+  atomicAdd(&component_sizes[root], 1);
+}
+
+__global__ void removeSmallComponentsKernel(const int* labels,
+                                            const int* component_sizes,
+                                            const int size_threshold,
+                                            MonoImageView mask_out) {
+  const int row = blockIdx.x;
+  if (row >= mask_out.rows()) {
+    return;
+  }
+  for (int col = threadIdx.x; col < mask_out.cols(); col += blockDim.x) {
+    const int label = labels[row * mask_out.cols() + col];
+    const bool keep =
+        label != kBackgroundLabel && component_sizes[label] >= size_threshold;
+    mask_out(row, col) = keep ? 255 : 0;
+  }
+}
+
+MaskPreprocessor::MaskPreprocessor(std::shared_ptr<CudaStream> cuda_stream,
+                                   int downscale_factor)
+    : downscale_factor_(downscale_factor), cuda_stream_(cuda_stream) {
+  CHECK_GE(downscale_factor_, 1);
+}
+
+void MaskPreprocessor::removeSmallConnectedComponents(const MonoImage& mask_in,
+                                                      const int size_threshold,
+                                                      MonoImage* mask_out) {
+  removeSmallConnectedComponentsAsync(mask_in, size_threshold, mask_out);
+  cuda_stream_->synchronize();
+}
+
+void MaskPreprocessor::removeSmallConnectedComponentsAsync(
+    const MonoImage& mask_in, const int size_threshold, MonoImage* mask_out) {
+  timing::Timer remove_small_connected_components_timer(
+      "image/remove_small_connected_components");
+
+  // Simply copy the output if threshold is zero.
+  if (size_threshold <= 0) {
+    mask_out->copyFromAsync(mask_in, *cuda_stream_);
+    return;
+  }
+
+  // Allocate output mask if required,
+  CHECK_GT(mask_in.rows(), 0);
+  CHECK_GT(mask_in.cols(), 0);
+  mask_out->resizeAsync(mask_in.rows(), mask_in.cols(), *cuda_stream_);
+
+  // Optionally downscale to save processing time in the coming steps.
+  const MonoImage* mask_to_label = &mask_in;
+  MonoImage* mask_labeled = mask_out;
+  int size_threshold_scaled = size_threshold;
+  if (downscale_factor_ > 1) {
+    naiveDownscaleGPUAsync(mask_in, downscale_factor_, &mask_downscaled_,
+                           *cuda_stream_);
+    mask_cleaned_downscaled_.resizeAsync(
+        mask_downscaled_.rows(), mask_downscaled_.cols(), *cuda_stream_);
+    mask_to_label = &mask_downscaled_;
+    mask_labeled = &mask_cleaned_downscaled_;
+    size_threshold_scaled =
+        size_threshold / (downscale_factor_ * downscale_factor_);
+  }
+
+  // Only non-strided data supported
+  CHECK_EQ(mask_to_label->stride_num_elements(), mask_to_label->cols());
+  CHECK_EQ(mask_labeled->stride_num_elements(), mask_labeled->cols());
+
+  const int num_pixels = mask_to_label->numel();
+  labels_.resizeAsync(num_pixels, *cuda_stream_);
+  component_sizes_.resizeAsync(num_pixels, *cuda_stream_);
+  component_sizes_.setZeroAsync(*cuda_stream_);
+
+  constexpr int kMaxNumThreadsPerBlock = 1024;
+  const int num_row_blocks = mask_to_label->rows();
+  const int num_threads_per_row_block =
+      std::min(kMaxNumThreadsPerBlock, mask_to_label->cols());
+  const int num_pixel_blocks =
+      (num_pixels + kMaxNumThreadsPerBlock - 1) / kMaxNumThreadsPerBlock;
+
+  initLabelsKernel<<<num_row_blocks, num_threads_per_row_block, 0,
+                     *cuda_stream_>>>(*mask_to_label, labels_.data());
+  mergeLabelsKernel<<<num_row_blocks, num_threads_per_row_block, 0,
+                      *cuda_stream_>>>(*mask_to_label, labels_.data());
+  flattenAndCountKernel<<<num_pixel_blocks, kMaxNumThreadsPerBlock, 0,
+                          *cuda_stream_>>>(num_pixels, labels_.data(),
+                                           component_sizes_.data());
+  removeSmallComponentsKernel<<<num_row_blocks, num_threads_per_row_block, 0,
+                                *cuda_stream_>>>(
+      labels_.data(), component_sizes_.data(), size_threshold_scaled,
+      *mask_labeled);
+  checkCudaErrors(cudaPeekAtLastError());
+
+  // Finally, upscale to original resolution.
+  if (downscale_factor_ > 1) {
+    image::upscaleGPUAsync(mask_cleaned_downscaled_, downscale_factor_,
+                           mask_out, *cuda_stream_);
+  }
+}
+
+}  // namespace image
+}  // namespace nvblox
@@ -74,6 +74,29 @@ void getInvalidDepthMaskAsync(const DepthImage& depth_image,
       ));
 }
 
+void getInvalidDepthMaskAsync(const DepthImageU16& depth_image,
+                              const NppStreamContext& npp_stream_context,
+                              MonoImage* mask_ptr,
+                              const uint16_t invalid_threshold) {
+  CHECK_NOTNULL(mask_ptr);
+  CHECK_EQ(depth_image.rows(), mask_ptr->rows());
+  CHECK_EQ(depth_image.cols(), mask_ptr->cols());
+  // ROI is the whole image
+  const NppiSize roi_size{.width = depth_image.cols(),
+                          .height = depth_image.rows()};
+
+  checkNppErrors(nppiCompareC_16u_C1R_Ctx(
+      depth_image.dataConstPtr(),             // pSrc
+      depth_image.cols() * sizeof(uint16_t),  // nSrcStep
+      invalid_threshold,                      // nConstant
+      mask_ptr->dataPtr(),                    // pDst
+      mask_ptr->cols() * sizeof(uint8_t),     // nDstStep
+      roi_size,                               // oSizeROI
+      NPP_CMP_LESS,                           // eComparisonOperation
+      npp_stream_context                      // nppStreamCtx
+      ));
+}
+
 void dilateMask3x3Async(const MonoImage& mask_image,
                         const NppStreamContext& npp_stream_context,
                         MonoImage* mask_dilated_ptr) {
@@ -117,6 +140,26 @@ void maskedSetAsync(const MonoImage& mask, const float value,
       ));
 }
 
+void maskedSetAsync(const MonoImage& mask, const uint16_t value,
+                    const NppStreamContext& npp_stream_context,
+                    DepthImageU16* depth_image_ptr) {
+  CHECK_NOTNULL(depth_image_ptr);
+  CHECK_EQ(depth_image_ptr->rows(), mask.rows());
+  CHECK_EQ(depth_image_ptr->cols(), mask.cols());
+  // Work on the whole image
+  const NppiSize roi_size{.width = depth_image_ptr->cols(),
+                          .height = depth_image_ptr->rows()};
+  checkNppErrors(nppiSet_16u_C1MR_Ctx(
+      value,                                       // nValue,
+      depth_image_ptr->dataPtr(),                  // pDst,
+      depth_image_ptr->cols() * sizeof(uint16_t),  // nDstStep,
+      roi_size,                                    // oSizeROI,
+      mask.dataConstPtr(),                         // pMask,
+      mask.cols() * sizeof(uint8_t),               // nMaskStep,
+      npp_stream_context                           // nppStreamCtx
+      ));
+}
+
 void setGreaterThanThresholdToValue(const MonoImage& image,
                                     const uint8_t threshold,
                                     const uint8_t value,
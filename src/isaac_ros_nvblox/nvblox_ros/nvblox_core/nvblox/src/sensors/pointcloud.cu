@@ -27,6 +27,19 @@ void Pointcloud::copyFromAsync(const unified_vector<Vector3f>& points,
   points_.copyFromAsync(points, cuda_stream);
 }
 
+void Pointcloud::copyFromHostAsync(const std::vector<Vector3f>& points,
+                                   PinnedHostBufferPool* staging_pool,
+                                   const CudaStream& cuda_stream) {
+  copyFromHostAsync(points.data(), points.size(), staging_pool, cuda_stream);
+}
+
+void Pointcloud::copyFromHostAsync(const Vector3f* points, int num_points,
+                                   PinnedHostBufferPool* staging_pool,
+                                   const CudaStream& cuda_stream) {
+  CHECK_NOTNULL(staging_pool)->uploadAsync(points, num_points, &points_,
+                                           cuda_stream);
+}
+
 // Pointcloud operations
 
 __global__ void transformPointcloudKernel(const Transform T_out_in,
@@ -0,0 +1,166 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "nvblox/sensors/internal/vpi_mask_dilator.h"
+
+#include <glog/logging.h>
+
+#ifdef NVBLOX_WITH_VPI
+#include <vpi/Image.h>
+#include <vpi/Status.h>
+#include <vpi/Stream.h>
+#include <vpi/algo/MorphologicalOperations.h>
+#endif
+
+#include "nvblox/core/internal/error_check.h"
+
+namespace nvblox {
+
+#ifdef NVBLOX_WITH_VPI
+
+namespace {
+
+// The PVA engine is otherwise idle while mapping. It supports 3x3 morphology
+// on 8-bit images.
+constexpr uint64_t kVpiBackend = VPI_BACKEND_PVA;
+
+// A 3x3 kernel of ones, i.e. a max filter over the neighbourhood.
+constexpr int kKernelSize = 3;
+constexpr int8_t kDilationKernel[kKernelSize * kKernelSize] = {1, 1, 1, 1, 1,
+                                                              1, 1, 1, 1};
+
+void checkVpiStatus(const VPIStatus status, const char* const func,
+                    const char* const file, const int line) {
+  if (status != VPI_SUCCESS) {
+    char message[VPI_MAX_STATUS_MESSAGE_LENGTH];
+    vpiGetLastStatusMessage(message, sizeof(message));
+    LOG(FATAL) << "VPI error = " << vpiStatusGetName(status) << " at " << file
+               << ":" << line << " '" << func << "': " << message;
+  }
+}
+
+#define checkVpiErrors(val) checkVpiStatus((val), #val, __FILE__, __LINE__)
+
+}  // namespace
+
+struct VpiMaskDilator::Impl {
+  Impl() { checkVpiErrors(vpiStreamCreate(kVpiBackend, &vpi_stream)); }
+  ~Impl() {
+    destroyImages();
+    vpiStreamDestroy(vpi_stream);
+  }
+
+  void destroyImages() {
+    for (VPIImage& image : images) {
+      vpiImageDestroy(image);
+      image = nullptr;
+    }
+  }
+
+  void allocateImagesIfRequired(const int new_rows, const int new_cols) {
+    if (new_rows == rows && new_cols == cols) {
+      return;
+    }
+    LOG(INFO) << "Allocating VPI images for mask dilation";
+    destroyImages();
+    for (VPIImage& image : images) {
+      checkVpiErrors(vpiImageCreate(new_cols, new_rows, VPI_IMAGE_FORMAT_U8,
+                                    kVpiBackend | VPI_BACKEND_CUDA, &image));
+    }
+    rows = new_rows;
+    cols = new_cols;
+  }
+
+  // Copies between a (dense) mask and a VPI image, on the CUDA stream. The
+  // image is locked for the duration of the copy, so this synchronizes.
+  void copyToImage(const MonoImage& mask, const CudaStream& cuda_stream,
+                   VPIImage image) {
+    VPIImageData data;
+    checkVpiErrors(vpiImageLockData(image, VPI_LOCK_WRITE,
+                                    VPI_IMAGE_BUFFER_CUDA_PITCH_LINEAR, &data));
+    const VPIImagePlanePitchLinear& plane = data.buffer.pitch.planes[0];
+    checkCudaErrors(cudaMemcpy2DAsync(
+        plane.data, plane.pitchBytes, mask.dataConstPtr(),
+        mask.cols() * sizeof(uint8_t), mask.cols() * sizeof(uint8_t),
+        mask.rows(), cudaMemcpyDefault, cuda_stream));
+    cuda_stream.synchronize();
+    checkVpiErrors(vpiImageUnlock(image));
+  }
+  void copyFromImage(VPIImage image, const CudaStream& cuda_stream,
+                     MonoImage* mask_ptr) {
+    VPIImageData data;
+    checkVpiErrors(vpiImageLockData(image, VPI_LOCK_READ,
+                                    VPI_IMAGE_BUFFER_CUDA_PITCH_LINEAR, &data));
+    const VPIImagePlanePitchLinear& plane = data.buffer.pitch.planes[0];
+    checkCudaErrors(cudaMemcpy2DAsync(
+        mask_ptr->dataPtr(), mask_ptr->cols() * sizeof(uint8_t), plane.data,
+        plane.pitchBytes, mask_ptr->cols() * sizeof(uint8_t), mask_ptr->rows(),
+        cudaMemcpyDefault, cuda_stream));
+    cuda_stream.synchronize();
+    checkVpiErrors(vpiImageUnlock(image));
+  }
+
+  VPIStream vpi_stream = nullptr;
+  // Double buffer for the repeated dilations.
+  VPIImage images[2] = {nullptr, nullptr};
+  int rows = 0;
+  int cols = 0;
+};
+
+bool VpiMaskDilator::isAvailable() { return true; }
+
+VpiMaskDilator::VpiMaskDilator() : impl_(std::make_unique<Impl>()) {}
+
+void VpiMaskDilator::dilateMask3x3(const int num_dilations,
+                                   const CudaStream& cuda_stream,
+                                   MonoImage* mask_ptr) {
+  CHECK_NOTNULL(mask_ptr);
+  CHECK_GE(num_dilations, 0);
+  if (num_dilations == 0) {
+    return;
+  }
+  impl_->allocateImagesIfRequired(mask_ptr->rows(), mask_ptr->cols());
+  impl_->copyToImage(*mask_ptr, cuda_stream, impl_->images[0]);
+  for (int i = 0; i < num_dilations; i++) {
+    checkVpiErrors(vpiSubmitDilate(
+        impl_->vpi_stream, kVpiBackend, impl_->images[i % 2],
+        impl_->images[(i + 1) % 2], kDilationKernel, kKernelSize, kKernelSize,
+        VPI_BORDER_CLAMP));
+  }
+  checkVpiErrors(vpiStreamSync(impl_->vpi_stream));
+  impl_->copyFromImage(impl_->images[num_dilations % 2], cuda_stream,
+                       mask_ptr);
+}
+
+#else  // NVBLOX_WITH_VPI
+
+struct VpiMaskDilator::Impl {};
+
+bool VpiMaskDilator::isAvailable() { return false; }
+
+VpiMaskDilator::VpiMaskDilator() {
+  LOG(FATAL) << "nvblox was built without VPI support. Rebuild with "
+                "USE_VPI=ON to use the VPI mask dilation.";
+}
+
+void VpiMaskDilator::dilateMask3x3(const int, const CudaStream&, MonoImage*) {
+  LOG(FATAL) << "nvblox was built without VPI support.";
+}
+
+#endif  // NVBLOX_WITH_VPI
+
+VpiMaskDilator::~VpiMaskDilator() = default;
+
+}  // namespace nvblox
@@ -0,0 +1,117 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "nvblox/serialization/internal/block_priority_gpu.h"
+
+#include "nvblox/core/indexing.h"
+#include "nvblox/core/internal/error_check.h"
+
+namespace nvblox {
+
+// Whether a block (approximated by its bounding sphere) intersects the view
+// frustum of the camera.
+__device__ inline bool isBlockInView(const Vector3f& block_center_L,
+                                     const float block_radius_m,
+                                     const BlockPriorityView& view) {
+  const Vector3f block_center_C = view.T_C_L * block_center_L;
+  const float depth = block_center_C.z();
+  if (depth < -block_radius_m ||
+      depth > view.max_view_distance_m + block_radius_m) {
+    return false;
+  }
+  // Blocks which contain the camera are in view.
+  if (depth <= block_radius_m) {
+    return block_center_C.norm() <= block_radius_m;
+  }
+  // Project the center and grow the image by the projected block radius.
+  const Camera& camera = view.camera;
+  const Vector2f x_C = camera.distortNormalizedCoordinates(
+      Vector2f(block_center_C.x() / depth, block_center_C.y() / depth));
+  const float u = camera.fu() * x_C.x() + camera.cu();
+  const float v = camera.fv() * x_C.y() + camera.cv();
+  const float margin_u = camera.fu() * block_radius_m / depth;
+  const float margin_v = camera.fv() * block_radius_m / depth;
+  return (u >= -margin_u) && (u <= camera.width() + margin_u) &&
+         (v >= -margin_v) && (v <= camera.height() + margin_v);
+}
+
+__global__ void computeBlockPrioritiesKernel(
+    const BlockPriorityInput* inputs, const int num_blocks,
+    const float block_size_m, const BlockPriorityView view,
+    const BlockPriorityWeights weights, float* priorities) {
+  const int idx = blockIdx.x * blockDim.x + threadIdx.x;
+  if (idx >= num_blocks) {
+    return;
+  }
+  const BlockPriorityInput& input = inputs[idx];
+  const Vector3f block_center_L =
+      getCenterPositionFromBlockIndex(block_size_m, input.block_index);
+
+  float priority = weights.change * static_cast<float>(input.num_updates) +
+                   weights.staleness *
+                       static_cast<float>(input.num_rounds_waiting) -
+                   weights.distance *
+                       (block_center_L - view.robot_position_m).norm();
+  if (view.has_camera) {
+    // Half the block diagonal.
+    constexpr float kHalfSqrt3 = 0.866025f;
+    const float block_radius_m = kHalfSqrt3 * block_size_m;
+    if (isBlockInView(block_center_L, block_radius_m, view)) {
+      priority += weights.in_view;
+    }
+  }
+  priorities[idx] = priority;
+}
+
+BlockPriorityCalculatorGpu::BlockPriorityCalculatorGpu()
+    : BlockPriorityCalculatorGpu(std::make_shared<CudaStreamOwning>()) {}
+
+BlockPriorityCalculatorGpu::BlockPriorityCalculatorGpu(
+    std::shared_ptr<CudaStream> cuda_stream)
+    : cuda_stream_(cuda_stream) {}
+
+void BlockPriorityCalculatorGpu::computePriorities(
+    const float block_size_m, const BlockPriorityView& view,
+    const BlockPriorityWeights& weights,
+    const std::vector<BlockPriorityInput>& inputs,
+    std::vector<float>* priorities) {
+  CHECK_NOTNULL(priorities);
+  CHECK_GT(block_size_m, 0.0f);
+  priorities->clear();
+  if (inputs.empty()) {
+    return;
+  }
+  const int num_blocks = inputs.size();
+  inputs_device_.copyFromAsync(inputs.data(), inputs.size(), *cuda_stream_);
+  priorities_device_.resizeAsync(num_blocks, *cuda_stream_);
+
+  constexpr int kNumThreads = 512;
+  const int num_thread_blocks = (num_blocks + kNumThreads - 1) / kNumThreads;
+  computeBlockPrioritiesKernel<<<num_thread_blocks, kNumThreads, 0,
+                                 *cuda_stream_>>>(
+      inputs_device_.data(),       // NOLINT
+      num_blocks,                  // NOLINT
+      block_size_m,                // NOLINT
+      view,                        // NOLINT
+      weights,                     // NOLINT
+      priorities_device_.data());  // NOLINT
+  checkCudaErrors(cudaPeekAtLastError());
+
+  priorities_host_.copyFromAsync(priorities_device_, *cuda_stream_);
+  cuda_stream_->synchronize();
+  priorities->assign(priorities_host_.begin(), priorities_host_.end());
+}
+
+}  // namespace nvblox
@@ -20,10 +20,88 @@ limitations under the License.
 #include <string>
 
 #include "glog/logging.h"
+#include "nvblox/core/indexing.h"
 #include "nvblox/core/internal/error_check.h"
+#include "nvblox/serialization/mesh_compression.h"
 
 namespace nvblox {
 
+// Kernel that quantizes the vertices and encodes the normals of several mesh
+// blocks into contiguous buffers.
+//
+// Number of blocks:  Must equal num_blocks.
+// Number of threads: Can be any positive value.
+//
+// @param num_blocks          Number of mesh blocks to encode
+// @param vertices            Vertices of each block. Size: num_blocks
+// @param normals             Normals of each block (nullptr if the block has no
+//                            normals). Size: num_blocks
+// @param offsets             Output offsets (in vertices). Size: num_blocks+1
+// @param block_indices       Index of each block. Size: num_blocks
+// @param block_size          Size of the blocks in meters
+// @param quantized_vertices  Output, three coordinates per vertex
+// @param encoded_normals     Output, two bytes per vertex
+void __global__ encodeCompactMeshKernel(const int32_t num_blocks,
+                                        const Vector3f** vertices,
+                                        const Vector3f** normals,
+                                        const int32_t* offsets,
+                                        const Index3D* block_indices,
+                                        const float block_size,
+                                        uint16_t* quantized_vertices,
+                                        uint8_t* encoded_normals) {
+  const int32_t block_index = blockIdx.x;
+  if (block_index >= num_blocks) {
+    return;
+  }
+  const int32_t offset = offsets[block_index];
+  const int32_t num_vertices = offsets[block_index + 1] - offset;
+  const Vector3f block_origin =
+      getPositionFromBlockIndex(block_size, block_indices[block_index]);
+
+  for (int32_t i = threadIdx.x; i < num_vertices; i += blockDim.x) {
+    const Vector3f p_vertex_B = vertices[block_index][i] - block_origin;
+    const int32_t output_index = offset + i;
+    for (int axis = 0; axis < 3; axis++) {
+      quantized_vertices[3 * output_index + axis] =
+          mesh_compression::quantizeVertexCoordinate(p_vertex_B[axis],
+                                                     block_size);
+    }
+    const Vector3f normal = (normals[block_index] != nullptr)
+                                ? normals[block_index][i]
+                                : Vector3f::Zero();
+    mesh_compression::encodeOctahedralNormal(
+        normal, &encoded_normals[2 * output_index]);
+  }
+}
+
+// Kernel that gathers ranges of a mesh arena buffer into a contiguous buffer.
+//
+// Number of blocks:  Must equal num_ranges.
+// Number of threads: Can be any positive value.
+//
+// @param num_ranges      Number of ranges to gather
+// @param arena_data      The arena buffer
+// @param arena_offsets   Start of each range in the arena. Size: num_ranges
+// @param output_offsets  Output offsets. Size: num_ranges+1
+// @param output          Resulting buffer
+template <typename T>
+void __global__ gatherArenaRangesKernel(const int32_t num_ranges,
+                                        const T* arena_data,
+                                        const int32_t* arena_offsets,
+                                        const int32_t* output_offsets,
+                                        T* output) {
+  const int32_t range_index = blockIdx.x;
+  if (range_index >= num_ranges) {
+    return;
+  }
+  const int32_t output_offset = output_offsets[range_index];
+  const int32_t num_elements = output_offsets[range_index + 1] - output_offset;
+  const T* range_data = arena_data + arena_offsets[range_index];
+  for (int32_t i = threadIdx.x; i < num_elements; i += blockDim.x) {
+    output[output_offset + i] = range_data[i];
+  }
+}
+
 std::shared_ptr<const SerializedMeshLayer> MeshSerializerGpu::serialize(
     const MeshLayer& mesh_layer,
     const std::vector<Index3D>& block_indices_to_serialize,
@@ -37,6 +115,13 @@ std::shared_ptr<const SerializedMeshLayer> MeshSerializerGpu::serialize(
       },
       cuda_stream);
 
+  if (compact_encoding_) {
+    encodeCompactAsync(mesh_layer, block_indices_to_serialize, cuda_stream);
+  } else {
+    serialized_mesh_->quantized_vertices.clearNoDeallocate();
+    serialized_mesh_->encoded_normals.clearNoDeallocate();
+  }
+
   color_serializer_.serializeAsync(
       mesh_layer, block_indices_to_serialize, serialized_mesh_->colors,
       serialized_mesh_->vertex_block_offsets,
@@ -64,6 +149,212 @@ std::shared_ptr<const SerializedMeshLayer> MeshSerializerGpu::serialize(
   return serialized_mesh_;
 }
 
+std::shared_ptr<const SerializedMeshLayer> MeshSerializerGpu::serialize(
+    const MeshArena& mesh_arena,
+    const std::vector<Index3D>& block_indices_to_serialize,
+    const CudaStream& cuda_stream) {
+  const size_t num_blocks = block_indices_to_serialize.size();
+  serialized_mesh_->vertex_block_offsets.resizeAsync(num_blocks + 1,
+                                                     cuda_stream);
+  serialized_mesh_->triangle_index_block_offsets.resizeAsync(num_blocks + 1,
+                                                             cuda_stream);
+  arena_vertex_offsets_.resizeAsync(num_blocks, cuda_stream);
+  arena_triangle_offsets_.resizeAsync(num_blocks, cuda_stream);
+  // Wait for any previous use of the output and scratch buffers to finish.
+  cuda_stream.synchronize();
+
+  // Compute the output layout. The requested blocks are contiguous in the
+  // arena if each starts where the previous ended.
+  int32_t total_num_vertices = 0;
+  int32_t total_num_triangle_indices = 0;
+  int32_t max_block_size = 0;
+  bool is_contiguous = mesh_arena.isCompact() &&
+                       (num_blocks == mesh_arena.numBlocks());
+  for (size_t i = 0; i < num_blocks; ++i) {
+    MeshArenaRange range;
+    if (!mesh_arena.getRange(block_indices_to_serialize[i], &range)) {
+      // Blocks not in the arena are serialized as empty.
+      range = MeshArenaRange();
+      is_contiguous = false;
+    }
+    is_contiguous = is_contiguous &&
+                    (range.vertex_offset == total_num_vertices) &&
+                    (range.triangle_offset == total_num_triangle_indices);
+    arena_vertex_offsets_[i] = range.vertex_offset;
+    arena_triangle_offsets_[i] = range.triangle_offset;
+    serialized_mesh_->vertex_block_offsets[i] = total_num_vertices;
+    serialized_mesh_->triangle_index_block_offsets[i] =
+        total_num_triangle_indices;
+    total_num_vertices += range.num_vertices;
+    total_num_triangle_indices += range.num_triangle_indices;
+    max_block_size =
+        std::max(max_block_size,
+                 std::max(range.num_vertices, range.num_triangle_indices));
+  }
+  serialized_mesh_->vertex_block_offsets[num_blocks] = total_num_vertices;
+  serialized_mesh_->triangle_index_block_offsets[num_blocks] =
+      total_num_triangle_indices;
+
+  serialized_mesh_->vertices.resizeAsync(total_num_vertices, cuda_stream);
+  serialized_mesh_->colors.resizeAsync(total_num_vertices, cuda_stream);
+  serialized_mesh_->triangle_indices.resizeAsync(total_num_triangle_indices,
+                                                 cuda_stream);
+  if (is_contiguous) {
+    if (total_num_vertices > 0) {
+      checkCudaErrors(cudaMemcpyAsync(
+          serialized_mesh_->vertices.data(), mesh_arena.vertices().data(),
+          sizeof(Vector3f) * total_num_vertices, cudaMemcpyDefault,
+          cuda_stream));
+      checkCudaErrors(cudaMemcpyAsync(
+          serialized_mesh_->colors.data(), mesh_arena.colors().data(),
+          sizeof(Color) * total_num_vertices, cudaMemcpyDefault,
+          cuda_stream));
+    }
+    if (total_num_triangle_indices > 0) {
+      checkCudaErrors(cudaMemcpyAsync(
+          serialized_mesh_->triangle_indices.data(),
+          mesh_arena.triangles().data(),
+          sizeof(int) * total_num_triangle_indices, cudaMemcpyDefault,
+          cuda_stream));
+    }
+  } else {
+    gatherArenaRangesAsync(mesh_arena.vertices().data(), arena_vertex_offsets_,
+                           serialized_mesh_->vertex_block_offsets,
+                           max_block_size, &serialized_mesh_->vertices,
+                           cuda_stream);
+    gatherArenaRangesAsync(mesh_arena.colors().data(), arena_vertex_offsets_,
+                           serialized_mesh_->vertex_block_offsets,
+                           max_block_size, &serialized_mesh_->colors,
+                           cuda_stream);
+    gatherArenaRangesAsync(mesh_arena.triangles().data(),
+                           arena_triangle_offsets_,
+                           serialized_mesh_->triangle_index_block_offsets,
+                           max_block_size, &serialized_mesh_->triangle_indices,
+                           cuda_stream);
+  }
+
+  if (compact_encoding_) {
+    encodeCompactAsync(mesh_arena, block_indices_to_serialize, cuda_stream);
+  } else {
+    serialized_mesh_->quantized_vertices.clearNoDeallocate();
+    serialized_mesh_->encoded_normals.clearNoDeallocate();
+  }
+
+  serialized_mesh_->block_indices = block_indices_to_serialize;
+
+  cuda_stream.synchronize();
+
+  return serialized_mesh_;
+}
+
+template <typename T>
+void MeshSerializerGpu::gatherArenaRangesAsync(
+    const T* arena_data, const host_vector<int32_t>& arena_offsets,
+    const host_vector<int32_t>& output_offsets, int32_t max_block_size,
+    host_vector<T>* output, const CudaStream& cuda_stream) {
+  constexpr int32_t kMaxNumThreads = 1024;
+  const int32_t num_threads = std::min(max_block_size, kMaxNumThreads);
+  const int32_t num_ranges = arena_offsets.size();
+  if (num_threads > 0 && num_ranges > 0) {
+    gatherArenaRangesKernel<<<num_ranges, num_threads, 0, cuda_stream>>>(
+        num_ranges,             // NOLINT
+        arena_data,             // NOLINT
+        arena_offsets.data(),   // NOLINT
+        output_offsets.data(),  // NOLINT
+        output->data());        // NOLINT
+  }
+  checkCudaErrors(cudaPeekAtLastError());
+}
+
+void MeshSerializerGpu::encodeCompactAsync(
+    const MeshLayer& mesh_layer, const std::vector<Index3D>& block_indices,
+    const CudaStream& cuda_stream) {
+  const size_t num_blocks = block_indices.size();
+  vertex_ptrs_.resizeAsync(num_blocks, cuda_stream);
+  normal_ptrs_.resizeAsync(num_blocks, cuda_stream);
+  block_indices_host_.resizeAsync(num_blocks, cuda_stream);
+  compact_vertex_offsets_.resizeAsync(num_blocks + 1, cuda_stream);
+  // Wait for any previous use of the scratch buffers to finish.
+  cuda_stream.synchronize();
+
+  // The layout matches the serialized vertices.
+  int32_t total_num_vertices = 0;
+  int32_t max_block_size = 0;
+  for (size_t i = 0; i < num_blocks; ++i) {
+    const MeshBlock* block = mesh_layer.getBlockAtIndex(block_indices[i]).get();
+    const int32_t num_vertices = block->vertices.size();
+    vertex_ptrs_[i] = block->vertices.data();
+    // Blocks without a normal per vertex get default normals.
+    normal_ptrs_[i] = (block->normals.size() == block->vertices.size())
+                          ? block->normals.data()
+                          : nullptr;
+    block_indices_host_[i] = block_indices[i];
+    compact_vertex_offsets_[i] = total_num_vertices;
+    total_num_vertices += num_vertices;
+    max_block_size = std::max(max_block_size, num_vertices);
+  }
+  compact_vertex_offsets_[num_blocks] = total_num_vertices;
+
+  launchEncodeCompactAsync(num_blocks, max_block_size, mesh_layer.block_size(),
+                           cuda_stream);
+}
+
+void MeshSerializerGpu::encodeCompactAsync(
+    const MeshArena& mesh_arena, const std::vector<Index3D>& block_indices,
+    const CudaStream& cuda_stream) {
+  const size_t num_blocks = block_indices.size();
+  vertex_ptrs_.resizeAsync(num_blocks, cuda_stream);
+  normal_ptrs_.resizeAsync(num_blocks, cuda_stream);
+  block_indices_host_.resizeAsync(num_blocks, cuda_stream);
+  compact_vertex_offsets_.resizeAsync(num_blocks + 1, cuda_stream);
+  // Wait for any previous use of the scratch buffers to finish.
+  cuda_stream.synchronize();
+
+  // The arena always stores a normal per vertex.
+  int32_t total_num_vertices = 0;
+  int32_t max_block_size = 0;
+  for (size_t i = 0; i < num_blocks; ++i) {
+    MeshArenaRange range;
+    if (!mesh_arena.getRange(block_indices[i], &range)) {
+      range = MeshArenaRange();
+    }
+    vertex_ptrs_[i] = mesh_arena.vertices().data() + range.vertex_offset;
+    normal_ptrs_[i] = mesh_arena.normals().data() + range.vertex_offset;
+    block_indices_host_[i] = block_indices[i];
+    compact_vertex_offsets_[i] = total_num_vertices;
+    total_num_vertices += range.num_vertices;
+    max_block_size = std::max(max_block_size, range.num_vertices);
+  }
+  compact_vertex_offsets_[num_blocks] = total_num_vertices;
+
+  launchEncodeCompactAsync(num_blocks, max_block_size, mesh_arena.block_size(),
+                           cuda_stream);
+}
+
+void MeshSerializerGpu::launchEncodeCompactAsync(
+    int32_t num_blocks, int32_t max_block_size, float block_size,
+    const CudaStream& cuda_stream) {
+  const int32_t total_num_vertices = compact_vertex_offsets_[num_blocks];
+  serialized_mesh_->quantized_vertices.resizeAsync(3 * total_num_vertices,
+                                                   cuda_stream);
+  serialized_mesh_->encoded_normals.resizeAsync(2 * total_num_vertices,
+                                                cuda_stream);
+  constexpr int32_t kMaxNumThreads = 1024;
+  const int32_t num_threads = std::min(max_block_size, kMaxNumThreads);
+  if (num_threads > 0 && num_blocks > 0) {
+    encodeCompactMeshKernel<<<num_blocks, num_threads, 0, cuda_stream>>>(
+        num_blocks,                                   // NOLINT
+        vertex_ptrs_.data(),                          // NOLINT
+        normal_ptrs_.data(),                          // NOLINT
+        compact_vertex_offsets_.data(),               // NOLINT
+        block_indices_host_.data(),                   // NOLINT
+        block_size,                                   // NOLINT
+        serialized_mesh_->quantized_vertices.data(),  // NOLINT
+        serialized_mesh_->encoded_normals.data());    // NOLINT
+  }
+  checkCudaErrors(cudaPeekAtLastError());
+}
+
 MeshSerializerGpu::MeshSerializerGpu()
     : serialized_mesh_(std::make_shared<SerializedMeshLayer>()) {}
 
@@ -16,11 +16,13 @@ limitations under the License.
 
 #include "nvblox/serialization/internal/serialization_gpu.h"
 
+#include <algorithm>
 #include <cuda_runtime.h>
 #include <string>
 
 #include "glog/logging.h"
 #include "nvblox/core/internal/error_check.h"
+#include "nvblox/utils/gpu_timing.h"
 
 namespace nvblox {
 
@@ -62,6 +64,35 @@ void __global__ SerializeVectorsKernel(const int32_t num_vectors,
   }
 }
 
+// Kernel that copies equally sized chunks of a contiguous buffer to
+// scattered destinations.
+//
+// Number of blocks:  Must equal num_chunks.
+// Number of threads: Can be any positive value.
+//
+// @param num_chunks           Number of chunks to copy.
+// @param num_words_per_chunk  Size of a chunk in units of WordType.
+// @param source               Contiguous source buffer.
+// @param destinations         Destination of each chunk. Size: num_chunks
+template <typename WordType>
+void __global__ ScatterChunksKernel(const int32_t num_chunks,
+                                    const int32_t num_words_per_chunk,
+                                    const WordType* source,
+                                    Byte** destinations) {
+  const int32_t chunk_index = blockIdx.x;
+  if (chunk_index >= num_chunks) {
+    return;
+  }
+  const WordType* chunk_source =
+      source + static_cast<size_t>(chunk_index) * num_words_per_chunk;
+  WordType* chunk_destination =
+      reinterpret_cast<WordType*>(destinations[chunk_index]);
+  for (int32_t index = threadIdx.x; index < num_words_per_chunk;
+       index += blockDim.x) {
+    chunk_destination[index] = chunk_source[index];
+  }
+}
+
 template <typename LayerType, typename T>
 void LayerSerializerGpuInternal<LayerType, T>::serializeAsync(
     const LayerType& layer,
@@ -111,6 +142,8 @@ void LayerSerializerGpuInternal<LayerType, T>::serializeAsync(
   // Run serialization.
   serialized_output.resizeAsync(total_num_elements, cuda_stream);
   if (num_threads > 0 && num_cuda_blocks > 0) {
+    timing::GpuTimer serialize_gpu_timer("serialization/serialize_vectors",
+                                         cuda_stream);
     SerializeVectorsKernel<<<num_cuda_blocks, num_threads, 0, cuda_stream>>>(
         block_indices_to_serialize.size(), vector_ptrs_.data(),
         offsets_output.data(), serialized_output.data());
@@ -119,6 +152,64 @@ void LayerSerializerGpuInternal<LayerType, T>::serializeAsync(
   checkCudaErrors(cudaPeekAtLastError());
 }
 
+void ScatterCopierGpu::scatter(const Byte* source,
+                               size_t num_bytes_per_chunk,
+                               const std::vector<Byte*>& destinations,
+                               const CudaStream& cuda_stream) {
+  if (destinations.empty() || num_bytes_per_chunk == 0) {
+    return;
+  }
+  const size_t num_chunks_per_copy =
+      std::max<size_t>(1, kMaxNumBytesPerCopy / num_bytes_per_chunk);
+  staging_device_.resizeAsync(num_chunks_per_copy * num_bytes_per_chunk,
+                              cuda_stream);
+
+  // Copy 4-byte words if the chunks allow it.
+  const bool use_words = (num_bytes_per_chunk % sizeof(uint32_t)) == 0;
+  constexpr int32_t kMaxNumThreads = 512;
+
+  for (size_t start = 0; start < destinations.size();
+       start += num_chunks_per_copy) {
+    const size_t num_chunks =
+        std::min(num_chunks_per_copy, destinations.size() - start);
+
+    // The host buffers are reused, so the previous copy must have finished.
+    cuda_stream.synchronize();
+    destinations_host_.resizeAsync(num_chunks, cuda_stream);
+    std::copy(destinations.begin() + start,
+              destinations.begin() + start + num_chunks,
+              destinations_host_.begin());
+    destinations_device_.copyFromAsync(destinations_host_, cuda_stream);
+    checkCudaErrors(cudaMemcpyAsync(
+        staging_device_.data(), source + start * num_bytes_per_chunk,
+        num_chunks * num_bytes_per_chunk, cudaMemcpyHostToDevice,
+        cuda_stream));
+
+    if (use_words) {
+      const int32_t num_words = num_bytes_per_chunk / sizeof(uint32_t);
+      const int32_t num_threads = std::min(num_words, kMaxNumThreads);
+      ScatterChunksKernel<uint32_t><<<num_chunks,   // NOLINT
+                                      num_threads,  // NOLINT
+                                      0,            // NOLINT
+                                      cuda_stream>>>(
+          num_chunks, num_words,
+          reinterpret_cast<const uint32_t*>(staging_device_.data()),
+          destinations_device_.data());
+    } else {
+      const int32_t num_bytes = num_bytes_per_chunk;
+      const int32_t num_threads = std::min(num_bytes, kMaxNumThreads);
+      ScatterChunksKernel<Byte><<<num_chunks,   // NOLINT
+                                  num_threads,  // NOLINT
+                                  0,            // NOLINT
+                                  cuda_stream>>>(
+          num_chunks, num_bytes, staging_device_.data(),
+          destinations_device_.data());
+    }
+    checkCudaErrors(cudaPeekAtLastError());
+  }
+  cuda_stream.synchronize();
+}
+
 // Instantiation of serialize function for TSDF layer
 template void LayerSerializerGpuInternal<TsdfLayer, TsdfVoxel>::serializeAsync(
     const TsdfLayer& layer,
@@ -0,0 +1,128 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "nvblox/serialization/serialized_layer_merger.h"
+
+#include "nvblox/core/internal/error_check.h"
+#include "nvblox/utils/timing.h"
+
+namespace nvblox {
+
+__device__ inline void fuseVoxel(const TsdfVoxel& other_voxel,
+                                 const float max_weight, TsdfVoxel* voxel) {
+  const float other_weight = other_voxel.weight;
+  const float weight = voxel->weight;
+  const float fused_weight = weight + other_weight;
+  if (fused_weight <= 0.0f) {
+    return;
+  }
+  voxel->distance =
+      (weight * voxel->distance + other_weight * other_voxel.distance) /
+      fused_weight;
+  voxel->weight = fminf(fused_weight, max_weight);
+}
+
+__device__ inline void fuseVoxel(const OccupancyVoxel& other_voxel,
+                                 const float, OccupancyVoxel* voxel) {
+  const float other_log_odds = other_voxel.log_odds;
+  const float log_odds = voxel->log_odds;
+  if (other_log_odds == 0.0f) {
+    // The other voxel was not observed.
+    return;
+  }
+  voxel->log_odds =
+      (log_odds == 0.0f) ? other_log_odds : 0.5f * (log_odds + other_log_odds);
+}
+
+// One thread-block per merged block, threads striding over its voxels.
+template <typename VoxelType>
+__global__ void fuseSerializedBlocksKernel(
+    const VoxelType* serialized_voxels, const float max_weight,
+    VoxelBlock<VoxelType>** blocks) {
+  constexpr int kNumVoxels = VoxelBlock<VoxelType>::kNumVoxels;
+  const VoxelType* block_serialized_voxels =
+      serialized_voxels + static_cast<size_t>(blockIdx.x) * kNumVoxels;
+  VoxelType* block_voxels = &blocks[blockIdx.x]->voxels[0][0][0];
+  for (int i = threadIdx.x; i < kNumVoxels; i += blockDim.x) {
+    fuseVoxel(block_serialized_voxels[i], max_weight, &block_voxels[i]);
+  }
+}
+
+SerializedLayerMerger::SerializedLayerMerger(
+    std::shared_ptr<CudaStream> cuda_stream)
+    : cuda_stream_(cuda_stream) {}
+
+std::vector<Index3D> SerializedLayerMerger::merge(
+    const SerializedTsdfLayer& serialized_layer, TsdfLayer* layer) {
+  return mergeImpl(serialized_layer, layer, &tsdf_voxels_device_,
+                   &tsdf_block_ptrs_device_);
+}
+
+std::vector<Index3D> SerializedLayerMerger::merge(
+    const SerializedOccupancyLayer& serialized_layer, OccupancyLayer* layer) {
+  return mergeImpl(serialized_layer, layer, &occupancy_voxels_device_,
+                   &occupancy_block_ptrs_device_);
+}
+
+template <typename VoxelType>
+std::vector<Index3D> SerializedLayerMerger::mergeImpl(
+    const SerializedLayer<VoxelType>& serialized_layer,
+    VoxelBlockLayer<VoxelType>* layer, device_vector<VoxelType>* voxels_device,
+    device_vector<VoxelBlock<VoxelType>*>* block_ptrs_device) {
+  CHECK_NOTNULL(layer);
+  CHECK(layer->memory_type() != MemoryType::kHost);
+  CHECK(!serialized_layer.is_compressed)
+      << "Decompress the layer with decompressSerializedLayer() first.";
+  timing::Timer timer("serialized_layer_merger/merge");
+  constexpr int kNumVoxels = VoxelBlock<VoxelType>::kNumVoxels;
+
+  const std::vector<Index3D>& block_indices = serialized_layer.block_indices;
+  const int num_blocks = block_indices.size();
+  if (num_blocks == 0) {
+    return {};
+  }
+  // The kernel relies on the serialized blocks being full and contiguous.
+  CHECK_EQ(serialized_layer.block_offsets.size(),
+           static_cast<size_t>(num_blocks + 1));
+  for (int i = 0; i <= num_blocks; i++) {
+    CHECK_EQ(serialized_layer.block_offsets[i], i * kNumVoxels)
+        << "Merging requires blocks of " << kNumVoxels << " voxels.";
+  }
+
+  // Get or allocate the local blocks.
+  layer->allocateBlocksAtIndices(block_indices, *cuda_stream_);
+  std::vector<VoxelBlock<VoxelType>*> block_ptrs;
+  block_ptrs.reserve(num_blocks);
+  for (const Index3D& block_index : block_indices) {
+    block_ptrs.push_back(layer->getBlockAtIndex(block_index).get());
+  }
+
+  voxels_device->copyFromAsync(serialized_layer.voxels, *cuda_stream_);
+  block_ptrs_device->copyFromAsync(block_ptrs, *cuda_stream_);
+
+  constexpr int kNumThreads = kNumVoxels;
+  fuseSerializedBlocksKernel<<<num_blocks, kNumThreads, 0, *cuda_stream_>>>(
+      voxels_device->data(), max_tsdf_weight_, block_ptrs_device->data());
+  checkCudaErrors(cudaPeekAtLastError());
+  cuda_stream_->synchronize();
+  return block_indices;
+}
+
+void SerializedLayerMerger::max_tsdf_weight(float max_tsdf_weight) {
+  CHECK_GT(max_tsdf_weight, 0.0f);
+  max_tsdf_weight_ = max_tsdf_weight;
+}
+
+}  // namespace nvblox
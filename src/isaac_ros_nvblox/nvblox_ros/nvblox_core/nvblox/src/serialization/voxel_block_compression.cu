@@ -0,0 +1,108 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "nvblox/serialization/internal/voxel_block_compression.h"
+
+#include "glog/logging.h"
+#include "nvblox/serialization/internal/cuda/voxel_block_compression.cuh"
+
+namespace nvblox {
+
+template <typename LayerType, typename VoxelType>
+void LayerCompressorGpuInternal<LayerType, VoxelType>::getBlockPtrs(
+    const LayerType& layer, const std::vector<Index3D>& block_indices,
+    const CudaStream& cuda_stream) {
+  block_ptrs_.resizeAsync(block_indices.size(), cuda_stream);
+  cuda_stream.synchronize();
+  for (size_t i = 0; i < block_indices.size(); ++i) {
+    const auto block = layer.getBlockAtIndex(block_indices[i]);
+    block_ptrs_[i] = block ? &block->voxels[0][0][0] : nullptr;
+  }
+}
+
+template <typename LayerType, typename VoxelType>
+void LayerCompressorGpuInternal<LayerType, VoxelType>::computeCompressedSizes(
+    const LayerType& layer, const std::vector<Index3D>& block_indices,
+    host_vector<int32_t>& num_bytes_output, const CudaStream& cuda_stream) {
+  constexpr int kNumVoxels = LayerType::BlockType::kNumVoxels;
+  num_bytes_output.resizeAsync(block_indices.size(), cuda_stream);
+  if (block_indices.empty()) {
+    return;
+  }
+  getBlockPtrs(layer, block_indices, cuda_stream);
+
+  compressVoxelBlocksAsync<VoxelType, kNumVoxels>(
+      block_ptrs_.data(), block_indices.size(), nullptr,
+      num_bytes_output.data(), nullptr, cuda_stream);
+  cuda_stream.synchronize();
+}
+
+template <typename LayerType, typename VoxelType>
+void LayerCompressorGpuInternal<LayerType, VoxelType>::compress(
+    const LayerType& layer, const std::vector<Index3D>& block_indices,
+    host_vector<uint8_t>& compressed_output,
+    host_vector<int32_t>& offsets_output, const CudaStream& cuda_stream) {
+  constexpr int kNumVoxels = LayerType::BlockType::kNumVoxels;
+  compressed_output.clearNoDeallocate();
+  offsets_output.clearNoDeallocate();
+  if (block_indices.empty()) {
+    return;
+  }
+
+  // First pass: The size of each block, such that we know where to write it.
+  computeCompressedSizes(layer, block_indices, num_bytes_, cuda_stream);
+  offsets_output.resizeAsync(block_indices.size() + 1, cuda_stream);
+  cuda_stream.synchronize();
+  int32_t total_num_bytes = 0;
+  for (size_t i = 0; i < block_indices.size(); ++i) {
+    offsets_output[i] = total_num_bytes;
+    total_num_bytes += num_bytes_[i];
+  }
+  offsets_output[block_indices.size()] = total_num_bytes;
+
+  // Second pass: Write the compressed blocks.
+  compressed_output.resizeAsync(total_num_bytes, cuda_stream);
+  if (total_num_bytes > 0) {
+    compressVoxelBlocksAsync<VoxelType, kNumVoxels>(
+        block_ptrs_.data(), block_indices.size(), offsets_output.data(),
+        nullptr, compressed_output.data(), cuda_stream);
+  }
+  cuda_stream.synchronize();
+}
+
+template <typename LayerType, typename VoxelType>
+void LayerCompressorGpuInternal<LayerType, VoxelType>::computeBlockHashes(
+    const LayerType& layer, const std::vector<Index3D>& block_indices,
+    host_vector<uint64_t>& hashes_output, const CudaStream& cuda_stream) {
+  constexpr int kNumVoxels = LayerType::BlockType::kNumVoxels;
+  hashes_output.resizeAsync(block_indices.size(), cuda_stream);
+  if (block_indices.empty()) {
+    return;
+  }
+  getBlockPtrs(layer, block_indices, cuda_stream);
+
+  hashVoxelBlocksAsync<VoxelType, kNumVoxels>(
+      block_ptrs_.data(), block_indices.size(), hashes_output.data(),
+      cuda_stream);
+  cuda_stream.synchronize();
+}
+
+template class LayerCompressorGpuInternal<TsdfLayer, TsdfVoxel>;
+template class LayerCompressorGpuInternal<ColorLayer, ColorVoxel>;
+template class LayerCompressorGpuInternal<OccupancyLayer, OccupancyVoxel>;
+template class LayerCompressorGpuInternal<FreespaceLayer, FreespaceVoxel>;
+template class LayerCompressorGpuInternal<EsdfLayer, EsdfVoxel>;
+
+}  // namespace nvblox
@@ -62,9 +62,14 @@ DelayTicker& Delays::getTicker(const std::string& tag) {
 
 void Delays::tick(const std::string& tag, const Time reference_timestamp_ns,
                   const Time delayed_timestamp_ns) {
-  DelayTicker& ticker = getInstance().getTicker(tag);
+  // See Rates::tick().
+  thread_local std::unordered_map<std::string, DelayTicker*> ticker_cache;
+  auto it = ticker_cache.find(tag);
+  if (it == ticker_cache.end()) {
+    it = ticker_cache.emplace(tag, &getTicker(tag)).first;
+  }
   std::lock_guard<std::mutex> lock(getInstance().mutex_);
-  ticker.tick(reference_timestamp_ns, delayed_timestamp_ns);
+  it->second->tick(reference_timestamp_ns, delayed_timestamp_ns);
 }
 
 bool Delays::exists(const std::string& tag) {
@@ -91,6 +96,17 @@ std::string Delays::delayToString(double delay_s) {
   return buffer;
 }
 
+std::vector<std::string> Delays::getTags() {
+  Delays& delays = getInstance();
+  std::lock_guard<std::mutex> lock(delays.mutex_);
+  std::vector<std::string> tags;
+  tags.reserve(delays.tickers_.size());
+  for (const auto& [tag, ticker] : delays.tickers_) {
+    tags.push_back(tag);
+  }
+  return tags;
+}
+
 void Delays::Print(std::ostream& out) {
   out << "\nNVBlox Delays\n";
   out << "namespace/tag - NumSamples (Window Length) - Mean Delay (seconds) \n";
@@ -0,0 +1,420 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "nvblox/utils/flight_recorder.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <unordered_map>
+
+#include "nvblox/utils/logging.h"
+#include "nvblox/utils/timing.h"
+
+namespace nvblox {
+namespace timing {
+namespace {
+
+constexpr double kMicrosecondsPerNanosecond = 1e-3;
+
+// Escapes a string for a JSON string literal.
+std::string escapeJson(const std::string& str) {
+  std::string escaped;
+  escaped.reserve(str.size());
+  for (const char c : str) {
+    if (c == '"' || c == '\\') {
+      escaped += '\\';
+      escaped += c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      char buffer[8];
+      snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+      escaped += buffer;
+    } else {
+      escaped += c;
+    }
+  }
+  return escaped;
+}
+
+// Keeps file names portable, e.g. for output names containing a '/'.
+std::string sanitizeFileName(const std::string& name) {
+  std::string sanitized = name;
+  for (char& c : sanitized) {
+    if (!std::isalnum(static_cast<unsigned char>(c)) && c != '-' && c != '_') {
+      c = '_';
+    }
+  }
+  return sanitized;
+}
+
+bool writeFile(const std::string& file_path, const std::string& contents) {
+  std::ofstream file(file_path);
+  file << contents;
+  file.close();
+  if (!file) {
+    LOG(WARNING) << "Failed to write the flight recorder trace to "
+                 << file_path;
+    return false;
+  }
+  LOG(INFO) << "Wrote the flight recorder trace to " << file_path;
+  return true;
+}
+
+}  // namespace
+
+FlightRecorder& FlightRecorder::Instance() {
+  static FlightRecorder instance;
+  return instance;
+}
+
+FlightRecorder::~FlightRecorder() {
+  enabled_.store(false, std::memory_order_relaxed);
+  std::lock_guard<std::mutex> lock(dump_mutex_);
+  if (dump_thread_.joinable()) {
+    dump_thread_.join();
+  }
+}
+
+void FlightRecorder::enable(size_t capacity) {
+  CHECK_GT(capacity, 0u);
+  FlightRecorder& instance = Instance();
+  {
+    std::lock_guard<std::mutex> lock(instance.mutex_);
+    if (!instance.slots_) {
+      size_t rounded_capacity = 1;
+      while (rounded_capacity < capacity) {
+        rounded_capacity *= 2;
+      }
+      instance.slots_ = std::make_unique<Slot[]>(rounded_capacity);
+      instance.capacity_mask_ = rounded_capacity - 1;
+      instance.slots_ptr_.store(instance.slots_.get(),
+                                std::memory_order_release);
+    }
+  }
+  enabled_.store(true, std::memory_order_relaxed);
+}
+
+void FlightRecorder::disable() {
+  enabled_.store(false, std::memory_order_relaxed);
+}
+
+void FlightRecorder::setWindowSeconds(double window_seconds) {
+  CHECK_GT(window_seconds, 0.0);
+  std::lock_guard<std::mutex> lock(Instance().mutex_);
+  Instance().window_seconds_ = window_seconds;
+}
+
+void FlightRecorder::setLatencyThresholdSeconds(
+    double latency_threshold_seconds) {
+  CHECK_GE(latency_threshold_seconds, 0.0);
+  std::lock_guard<std::mutex> lock(Instance().mutex_);
+  Instance().latency_threshold_seconds_ = latency_threshold_seconds;
+}
+
+void FlightRecorder::setOutputDirectory(const std::string& output_directory) {
+  std::lock_guard<std::mutex> lock(Instance().mutex_);
+  Instance().output_directory_ = output_directory;
+}
+
+void FlightRecorder::setMinSecondsBetweenDumps(
+    double min_seconds_between_dumps) {
+  CHECK_GE(min_seconds_between_dumps, 0.0);
+  std::lock_guard<std::mutex> lock(Instance().mutex_);
+  Instance().min_seconds_between_dumps_ = min_seconds_between_dumps;
+}
+
+int64_t FlightRecorder::nowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+uint32_t FlightRecorder::getThreadId() {
+  static std::atomic<uint32_t> next_thread_id{0};
+  thread_local const uint32_t thread_id =
+      next_thread_id.fetch_add(1, std::memory_order_relaxed);
+  return thread_id;
+}
+
+uint32_t FlightRecorder::getNameHandle(const std::string& name) {
+  // Handles are never invalidated, so each thread can keep its own cache.
+  thread_local std::unordered_map<std::string, uint32_t> handle_cache;
+  auto cache_it = handle_cache.find(name);
+  if (cache_it != handle_cache.end()) {
+    return cache_it->second;
+  }
+  FlightRecorder& instance = Instance();
+  std::lock_guard<std::mutex> lock(instance.mutex_);
+  auto it = std::find(instance.names_.begin(), instance.names_.end(), name);
+  const uint32_t handle = static_cast<uint32_t>(it - instance.names_.begin());
+  if (it == instance.names_.end()) {
+    instance.names_.push_back(name);
+  }
+  handle_cache.emplace(name, handle);
+  return handle;
+}
+
+void FlightRecorder::record(FlightRecorderEvent event) {
+  FlightRecorder& instance = Instance();
+  Slot* slots = instance.slots_ptr_.load(std::memory_order_acquire);
+  if (slots == nullptr) {
+    return;
+  }
+  event.thread_id = getThreadId();
+  const uint64_t position =
+      instance.write_position_.fetch_add(1, std::memory_order_relaxed);
+  Slot& slot = slots[position & instance.capacity_mask_];
+  // A seqlock: readers discard the slot if the sequence changed (or is odd)
+  // while they copied the event.
+  slot.sequence.store(2 * position + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.event = event;
+  slot.sequence.store(2 * position + 2, std::memory_order_release);
+}
+
+void FlightRecorder::recordTimer(size_t timer_handle, int64_t start_ns,
+                                 int64_t duration_ns) {
+  if (!isEnabled()) {
+    return;
+  }
+  FlightRecorderEvent event;
+  event.type = FlightRecorderEventType::kTimer;
+  event.name_handle = static_cast<uint32_t>(timer_handle);
+  event.timestamp_ns = start_ns;
+  event.duration_ns = duration_ns;
+  record(event);
+}
+
+void FlightRecorder::recordCounter(const std::string& name, double value) {
+  if (!isEnabled()) {
+    return;
+  }
+  FlightRecorderEvent event;
+  event.type = FlightRecorderEventType::kCounter;
+  event.name_handle = getNameHandle(name);
+  event.timestamp_ns = nowNs();
+  event.value = value;
+  record(event);
+}
+
+void FlightRecorder::recordInstant(const std::string& name, double value) {
+  if (!isEnabled()) {
+    return;
+  }
+  FlightRecorderEvent event;
+  event.type = FlightRecorderEventType::kInstant;
+  event.name_handle = getNameHandle(name);
+  event.timestamp_ns = nowNs();
+  event.value = value;
+  record(event);
+}
+
+bool FlightRecorder::frameCompleted(const std::string& name,
+                                    double latency_seconds) {
+  if (!isEnabled()) {
+    return false;
+  }
+  recordCounter(name + "/latency_ms", latency_seconds * 1e3);
+
+  FlightRecorder& instance = Instance();
+  const int64_t now_ns = nowNs();
+  std::string file_path;
+  {
+    std::lock_guard<std::mutex> lock(instance.mutex_);
+    if (instance.latency_threshold_seconds_ <= 0.0 ||
+        latency_seconds <= instance.latency_threshold_seconds_) {
+      return false;
+    }
+    if (instance.last_dump_ns_ > 0 &&
+        static_cast<double>(now_ns - instance.last_dump_ns_) * 1e-9 <
+            instance.min_seconds_between_dumps_) {
+      return false;
+    }
+    instance.last_dump_ns_ = now_ns;
+    file_path = instance.output_directory_ + "/nvblox_flight_recorder_" +
+                std::to_string(now_ns / 1000000) + "_" +
+                sanitizeFileName(name) + ".json";
+    instance.last_dump_path_ = file_path;
+  }
+  LOG(WARNING) << "Latency of " << name << " of " << latency_seconds * 1e3
+               << "ms exceeds the flight recorder threshold. Dumping a trace.";
+
+  // Only taking the snapshot is on the calling thread.
+  std::vector<FlightRecorderEvent> events = instance.snapshot();
+  std::lock_guard<std::mutex> lock(instance.dump_mutex_);
+  if (instance.dump_thread_.joinable()) {
+    instance.dump_thread_.join();
+  }
+  instance.dump_thread_ =
+      std::thread([file_path, events = std::move(events)]() {
+        writeFile(file_path, Instance().toChromeTrace(events));
+      });
+  return true;
+}
+
+void FlightRecorder::waitForDump() {
+  FlightRecorder& instance = Instance();
+  std::lock_guard<std::mutex> lock(instance.dump_mutex_);
+  if (instance.dump_thread_.joinable()) {
+    instance.dump_thread_.join();
+  }
+}
+
+std::vector<FlightRecorderEvent> FlightRecorder::snapshot() {
+  std::vector<FlightRecorderEvent> events;
+  const Slot* slots = slots_ptr_.load(std::memory_order_acquire);
+  if (slots == nullptr) {
+    return events;
+  }
+  events.reserve(capacity_mask_ + 1);
+  for (size_t i = 0; i <= capacity_mask_; ++i) {
+    const Slot& slot = slots[i];
+    const uint64_t sequence_before =
+        slot.sequence.load(std::memory_order_acquire);
+    if (sequence_before == 0 || sequence_before % 2 == 1) {
+      continue;
+    }
+    const FlightRecorderEvent event = slot.event;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.sequence.load(std::memory_order_relaxed) == sequence_before) {
+      events.push_back(event);
+    }
+  }
+  if (events.empty()) {
+    return events;
+  }
+
+  // Only keep the window up to the newest event.
+  auto end_ns = [](const FlightRecorderEvent& event) {
+    return event.timestamp_ns + event.duration_ns;
+  };
+  int64_t newest_ns = 0;
+  for (const FlightRecorderEvent& event : events) {
+    newest_ns = std::max(newest_ns, end_ns(event));
+  }
+  double window_seconds;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    window_seconds = window_seconds_;
+  }
+  const int64_t oldest_ns =
+      newest_ns - static_cast<int64_t>(window_seconds * 1e9);
+  events.erase(std::remove_if(events.begin(), events.end(),
+                              [&](const FlightRecorderEvent& event) {
+                                return end_ns(event) < oldest_ns;
+                              }),
+               events.end());
+  std::sort(events.begin(), events.end(),
+            [](const FlightRecorderEvent& a, const FlightRecorderEvent& b) {
+              return a.timestamp_ns < b.timestamp_ns;
+            });
+  return events;
+}
+
+std::vector<FlightRecorderEvent> FlightRecorder::getEvents() {
+  return Instance().snapshot();
+}
+
+std::string FlightRecorder::toChromeTrace(
+    const std::vector<FlightRecorderEvent>& events) {
+  // Resolve each name once.
+  std::unordered_map<uint32_t, std::string> timer_tags;
+  std::vector<std::string> names;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    names = names_;
+  }
+  for (const FlightRecorderEvent& event : events) {
+    if (event.type == FlightRecorderEventType::kTimer &&
+        timer_tags.count(event.name_handle) == 0) {
+      timer_tags[event.name_handle] =
+          escapeJson(Timing::GetTag(event.name_handle));
+    }
+  }
+  for (std::string& name : names) {
+    name = escapeJson(name);
+  }
+
+  std::stringstream ss;
+  ss.precision(3);
+  ss << std::fixed;
+  ss << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+     << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"args\":"
+        "{\"name\":\"nvblox\"}}";
+  for (const FlightRecorderEvent& event : events) {
+    const bool is_timer = event.type == FlightRecorderEventType::kTimer;
+    const std::string& name =
+        is_timer ? timer_tags[event.name_handle] : names[event.name_handle];
+    ss << ",\n{\"name\":\"" << name << "\",\"cat\":\"nvblox\",\"pid\":0,"
+       << "\"tid\":" << event.thread_id << ",\"ts\":"
+       << static_cast<double>(event.timestamp_ns) * kMicrosecondsPerNanosecond;
+    switch (event.type) {
+      case FlightRecorderEventType::kTimer:
+        ss << ",\"ph\":\"X\",\"dur\":"
+           << static_cast<double>(event.duration_ns) *
+                  kMicrosecondsPerNanosecond;
+        break;
+      case FlightRecorderEventType::kCounter:
+        ss << ",\"ph\":\"C\",\"args\":{\"value\":" << event.value << "}";
+        break;
+      case FlightRecorderEventType::kInstant:
+        ss << ",\"ph\":\"i\",\"s\":\"t\",\"args\":{\"value\":" << event.value
+           << "}";
+        break;
+    }
+    ss << "}";
+  }
+  ss << "\n]}\n";
+  return ss.str();
+}
+
+std::string FlightRecorder::toChromeTrace() {
+  return Instance().toChromeTrace(Instance().snapshot());
+}
+
+bool FlightRecorder::dumpToFile(const std::string& file_path) {
+  const bool success = writeFile(file_path, toChromeTrace());
+  if (success) {
+    std::lock_guard<std::mutex> lock(Instance().mutex_);
+    Instance().last_dump_path_ = file_path;
+  }
+  return success;
+}
+
+std::string FlightRecorder::lastDumpPath() {
+  std::lock_guard<std::mutex> lock(Instance().mutex_);
+  return Instance().last_dump_path_;
+}
+
+void FlightRecorder::reset() {
+  FlightRecorder& instance = Instance();
+  waitForDump();
+  Slot* slots = instance.slots_ptr_.load(std::memory_order_acquire);
+  if (slots != nullptr) {
+    for (size_t i = 0; i <= instance.capacity_mask_; ++i) {
+      slots[i].sequence.store(0, std::memory_order_relaxed);
+    }
+  }
+  instance.write_position_.store(0, std::memory_order_relaxed);
+  std::lock_guard<std::mutex> lock(instance.mutex_);
+  instance.last_dump_ns_ = 0;
+  instance.last_dump_path_.clear();
+}
+
+}  // namespace timing
+}  // namespace nvblox
@@ -0,0 +1,296 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "nvblox/utils/gpu_timing.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+#include <glog/logging.h>
+
+#include "nvblox/core/internal/error_check.h"
+
+namespace nvblox {
+namespace timing {
+
+namespace {
+
+// Whether the stream is currently being captured into a CUDA graph.
+bool isCapturing(const CudaStream& cuda_stream) {
+  cudaStreamCaptureStatus status = cudaStreamCaptureStatusNone;
+  checkCudaErrors(cudaStreamIsCapturing(cuda_stream, &status));
+  return status != cudaStreamCaptureStatusNone;
+}
+
+// Nearest-rank percentile of sorted samples.
+float percentile(const std::vector<float>& sorted_samples, float fraction) {
+  const size_t rank = static_cast<size_t>(
+      std::ceil(fraction * static_cast<float>(sorted_samples.size())));
+  return sorted_samples[std::clamp<size_t>(rank, 1, sorted_samples.size()) -
+                        1];
+}
+
+}  // namespace
+
+GpuTimer::GpuTimer(const std::string& tag, const CudaStream& cuda_stream,
+                   bool constructStopped)
+    : handle_(GpuTiming::Instance().GetHandle(tag)),
+      cuda_stream_(cuda_stream) {
+  if (!constructStopped) {
+    Start();
+  }
+}
+
+GpuTimer::~GpuTimer() {
+  if (IsTiming()) {
+    Stop();
+  }
+}
+
+void GpuTimer::Start() {
+  GpuTiming& instance = GpuTiming::Instance();
+  if (!instance.IsEnabled() || isCapturing(cuda_stream_)) {
+    start_event_ = nullptr;
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(instance.mutex_);
+    start_event_ = instance.AcquireEvent();
+  }
+  checkCudaErrors(cudaEventRecord(start_event_, cuda_stream_));
+}
+
+void GpuTimer::Stop() {
+  if (!IsTiming()) {
+    return;
+  }
+  GpuTiming& instance = GpuTiming::Instance();
+  cudaEvent_t stop_event;
+  {
+    std::lock_guard<std::mutex> lock(instance.mutex_);
+    stop_event = instance.AcquireEvent();
+  }
+  checkCudaErrors(cudaEventRecord(stop_event, cuda_stream_));
+  instance.AddPending(handle_, start_event_, stop_event);
+  start_event_ = nullptr;
+}
+
+bool GpuTimer::IsTiming() const { return start_event_ != nullptr; }
+
+GpuTiming& GpuTiming::Instance() {
+  static GpuTiming gpu_timing;
+  return gpu_timing;
+}
+
+GpuTiming::~GpuTiming() {
+  // The CUDA context may already be torn down at static destruction, so
+  // errors are ignored here.
+  for (const PendingTimer& pending : pending_) {
+    cudaEventDestroy(pending.start_event);
+    cudaEventDestroy(pending.stop_event);
+  }
+  for (cudaEvent_t event : event_pool_) {
+    cudaEventDestroy(event);
+  }
+}
+
+size_t GpuTiming::GetHandle(const std::string& tag) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = tag_map_.find(tag);
+  if (it != tag_map_.end()) {
+    return it->second;
+  }
+  const size_t handle = tags_.size();
+  tag_map_.emplace(tag, handle);
+  tags_.push_back(tag);
+  windows_.emplace_back();
+  return handle;
+}
+
+cudaEvent_t GpuTiming::AcquireEvent() {
+  if (!event_pool_.empty()) {
+    cudaEvent_t event = event_pool_.back();
+    event_pool_.pop_back();
+    return event;
+  }
+  cudaEvent_t event;
+  checkCudaErrors(cudaEventCreateWithFlags(&event, cudaEventDefault));
+  return event;
+}
+
+void GpuTiming::AddPending(size_t handle, cudaEvent_t start_event,
+                           cudaEvent_t stop_event) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  pending_.push_back({handle, start_event, stop_event});
+  ResolvePendingLocked(false);
+  while (pending_.size() > kMaxNumPending) {
+    // Re-recording an event which has not completed yet is allowed, so the
+    // events can be returned to the pool straight away.
+    event_pool_.push_back(pending_.front().start_event);
+    event_pool_.push_back(pending_.front().stop_event);
+    pending_.pop_front();
+  }
+}
+
+void GpuTiming::ResolvePendingLocked(bool blocking) {
+  // Timers on different streams may complete out of order, so all pending
+  // timers are checked rather than just the oldest.
+  auto it = pending_.begin();
+  while (it != pending_.end()) {
+    if (blocking) {
+      checkCudaErrors(cudaEventSynchronize(it->stop_event));
+    } else {
+      const cudaError_t status = cudaEventQuery(it->stop_event);
+      if (status == cudaErrorNotReady) {
+        ++it;
+        continue;
+      }
+      checkCudaErrors(status);
+    }
+    float elapsed_ms = 0.0f;
+    checkCudaErrors(
+        cudaEventElapsedTime(&elapsed_ms, it->start_event, it->stop_event));
+    AddSample(it->handle, elapsed_ms);
+    event_pool_.push_back(it->start_event);
+    event_pool_.push_back(it->stop_event);
+    it = pending_.erase(it);
+  }
+}
+
+void GpuTiming::AddSample(size_t handle, float sample_ms) {
+  CHECK_LT(handle, windows_.size());
+  SampleWindow& window = windows_[handle];
+  if (window.samples_ms.size() < static_cast<size_t>(kWindowSize)) {
+    window.samples_ms.push_back(sample_ms);
+  } else {
+    window.samples_ms[window.num_added % kWindowSize] = sample_ms;
+  }
+  ++window.num_added;
+}
+
+GpuTimingStats GpuTiming::ComputeStats(const SampleWindow& window) {
+  GpuTimingStats stats;
+  if (window.samples_ms.empty()) {
+    return stats;
+  }
+  std::vector<float> sorted_samples = window.samples_ms;
+  std::sort(sorted_samples.begin(), sorted_samples.end());
+  float sum_ms = 0.0f;
+  for (const float sample_ms : sorted_samples) {
+    sum_ms += sample_ms;
+  }
+  stats.num_samples = static_cast<int>(sorted_samples.size());
+  stats.mean_ms = sum_ms / static_cast<float>(sorted_samples.size());
+  stats.p50_ms = percentile(sorted_samples, 0.5f);
+  stats.p90_ms = percentile(sorted_samples, 0.9f);
+  stats.p99_ms = percentile(sorted_samples, 0.99f);
+  stats.max_ms = sorted_samples.back();
+  return stats;
+}
+
+void GpuTiming::ResolvePending() {
+  std::lock_guard<std::mutex> lock(Instance().mutex_);
+  Instance().ResolvePendingLocked(false);
+}
+
+void GpuTiming::ResolveAll() {
+  std::lock_guard<std::mutex> lock(Instance().mutex_);
+  Instance().ResolvePendingLocked(true);
+}
+
+GpuTimingStats GpuTiming::GetStats(const std::string& tag) {
+  GpuTiming& instance = Instance();
+  std::lock_guard<std::mutex> lock(instance.mutex_);
+  instance.ResolvePendingLocked(false);
+  auto it = instance.tag_map_.find(tag);
+  if (it == instance.tag_map_.end()) {
+    return GpuTimingStats();
+  }
+  return ComputeStats(instance.windows_[it->second]);
+}
+
+std::map<std::string, GpuTimingStats> GpuTiming::GetAllStats() {
+  GpuTiming& instance = Instance();
+  std::lock_guard<std::mutex> lock(instance.mutex_);
+  instance.ResolvePendingLocked(false);
+  std::map<std::string, GpuTimingStats> all_stats;
+  for (const auto& [tag, handle] : instance.tag_map_) {
+    if (!instance.windows_[handle].samples_ms.empty()) {
+      all_stats.emplace(tag, ComputeStats(instance.windows_[handle]));
+    }
+  }
+  return all_stats;
+}
+
+size_t GpuTiming::NumPending() {
+  std::lock_guard<std::mutex> lock(Instance().mutex_);
+  return Instance().pending_.size();
+}
+
+void GpuTiming::Print(std::ostream& out) {
+  const std::map<std::string, GpuTimingStats> all_stats = GetAllStats();
+  size_t max_tag_length = 0;
+  for (const auto& [tag, stats] : all_stats) {
+    max_tag_length = std::max(max_tag_length, tag.size());
+  }
+  out << "\nNVBlox GPU Timing (ms)\n";
+  out << "namespace/tag - NumSamples (Window Length) - Mean - P50 - P90 - P99 "
+         "- Max\n";
+  out << "-----------\n";
+  for (const auto& [tag, stats] : all_stats) {
+    out.width(static_cast<std::streamsize>(max_tag_length));
+    out.setf(std::ios::left, std::ios::adjustfield);
+    out << tag << "\t";
+    out.width(7);
+    out << stats.num_samples << "\t" << std::fixed << std::setprecision(3)
+        << stats.mean_ms << "\t" << stats.p50_ms << "\t" << stats.p90_ms
+        << "\t" << stats.p99_ms << "\t" << stats.max_ms << std::endl;
+  }
+  out << "-----------\n";
+}
+
+std::string GpuTiming::Print() {
+  std::stringstream ss;
+  Print(ss);
+  return ss.str();
+}
+
+void GpuTiming::Reset() {
+  GpuTiming& instance = Instance();
+  std::lock_guard<std::mutex> lock(instance.mutex_);
+  for (const PendingTimer& pending : instance.pending_) {
+    instance.event_pool_.push_back(pending.start_event);
+    instance.event_pool_.push_back(pending.stop_event);
+  }
+  instance.pending_.clear();
+  for (SampleWindow& window : instance.windows_) {
+    window = SampleWindow();
+  }
+}
+
+void GpuTiming::SetEnabled(bool enabled) {
+  std::lock_guard<std::mutex> lock(Instance().mutex_);
+  Instance().enabled_ = enabled;
+}
+
+bool GpuTiming::IsEnabled() {
+  std::lock_guard<std::mutex> lock(Instance().mutex_);
+  return Instance().enabled_;
+}
+
+}  // namespace timing
+}  // namespace nvblox
@@ -0,0 +1,402 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "nvblox/utils/metrics.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <sstream>
+
+#include "nvblox/utils/delays.h"
+#include "nvblox/utils/gpu_timing.h"
+#include "nvblox/utils/logging.h"
+#include "nvblox/utils/rates.h"
+#include "nvblox/utils/timing.h"
+
+namespace nvblox {
+namespace timing {
+namespace {
+
+std::string formatValue(double value) {
+  if (std::isnan(value)) {
+    return "NaN";
+  }
+  if (std::isinf(value)) {
+    return value > 0 ? "+Inf" : "-Inf";
+  }
+  std::ostringstream ss;
+  ss.precision(10);
+  ss << value;
+  return ss.str();
+}
+
+std::string escapeLabelValue(const std::string& value) {
+  std::string escaped;
+  escaped.reserve(value.size());
+  for (const char c : value) {
+    if (c == '\\' || c == '"') {
+      escaped += '\\';
+      escaped += c;
+    } else if (c == '\n') {
+      escaped += "\\n";
+    } else {
+      escaped += c;
+    }
+  }
+  return escaped;
+}
+
+std::string formatSample(const std::string& name, const MetricLabels& labels,
+                         double value) {
+  std::string sample = name;
+  if (!labels.empty()) {
+    sample += '{';
+    for (size_t i = 0; i < labels.size(); ++i) {
+      if (i > 0) {
+        sample += ',';
+      }
+      sample += labels[i].first + "=\"" + escapeLabelValue(labels[i].second) +
+                "\"";
+    }
+    sample += '}';
+  }
+  return sample + " " + formatValue(value) + "\n";
+}
+
+MetricLabels withLabel(MetricLabels labels, const std::string& name,
+                       const std::string& value) {
+  labels.emplace_back(name, value);
+  return labels;
+}
+
+// Write a whole buffer to a socket, giving up if the peer goes away.
+void sendAll(int fd, const std::string& data) {
+  size_t num_sent = 0;
+  while (num_sent < data.size()) {
+    const ssize_t ret = send(fd, data.data() + num_sent,
+                             data.size() - num_sent, MSG_NOSIGNAL);
+    if (ret <= 0) {
+      return;
+    }
+    num_sent += static_cast<size_t>(ret);
+  }
+}
+
+std::string httpResponse(const std::string& status,
+                         const std::string& content_type,
+                         const std::string& body) {
+  std::ostringstream ss;
+  ss << "HTTP/1.1 " << status << "\r\n"
+     << "Content-Type: " << content_type << "\r\n"
+     << "Content-Length: " << body.size() << "\r\n"
+     << "Connection: close\r\n\r\n"
+     << body;
+  return ss.str();
+}
+
+}  // namespace
+
+MetricsWriter::Family& MetricsWriter::getFamily(const std::string& name,
+                                                const std::string& type,
+                                                const std::string& help) {
+  Family& family = families_[name];
+  if (family.type.empty()) {
+    family.type = type;
+    family.help = help;
+  }
+  CHECK_EQ(family.type, type) << "Metric " << name << " has multiple types.";
+  return family;
+}
+
+void MetricsWriter::addGauge(const std::string& name, const std::string& help,
+                             const MetricLabels& labels, double value) {
+  getFamily(name, "gauge", help)
+      .samples.push_back(formatSample(name, labels, value));
+}
+
+void MetricsWriter::addCounter(const std::string& name,
+                               const std::string& help,
+                               const MetricLabels& labels, double value) {
+  getFamily(name, "counter", help)
+      .samples.push_back(formatSample(name + "_total", labels, value));
+}
+
+void MetricsWriter::addHistogram(const std::string& name,
+                                 const std::string& help,
+                                 const MetricLabels& labels,
+                                 const std::vector<double>& upper_bounds,
+                                 const std::vector<uint64_t>& counts,
+                                 double sum) {
+  CHECK_EQ(upper_bounds.size(), counts.size());
+  CHECK(!upper_bounds.empty() && std::isinf(upper_bounds.back()));
+  Family& family = getFamily(name, "histogram", help);
+  // Buckets are cumulative in the exposition format.
+  uint64_t cumulative_count = 0;
+  for (size_t i = 0; i < counts.size(); ++i) {
+    cumulative_count += counts[i];
+    family.samples.push_back(
+        formatSample(name + "_bucket",
+                     withLabel(labels, "le", formatValue(upper_bounds[i])),
+                     static_cast<double>(cumulative_count)));
+  }
+  family.samples.push_back(formatSample(
+      name + "_count", labels, static_cast<double>(cumulative_count)));
+  family.samples.push_back(formatSample(name + "_sum", labels, sum));
+}
+
+std::string MetricsWriter::str() const {
+  std::string text;
+  for (const auto& [name, family] : families_) {
+    text += "# TYPE " + name + " " + family.type + "\n";
+    if (!family.help.empty()) {
+      text += "# HELP " + name + " " + family.help + "\n";
+    }
+    for (const std::string& sample : family.samples) {
+      text += sample;
+    }
+  }
+  return text + "# EOF\n";
+}
+
+Metrics& Metrics::getInstance() {
+  static Metrics metrics;
+  return metrics;
+}
+
+void Metrics::setGauge(const std::string& name, const std::string& help,
+                       const MetricLabels& labels, double value) {
+  Metrics& metrics = getInstance();
+  std::lock_guard<std::mutex> lock(metrics.mutex_);
+  metrics.gauges_[{name, labels}] = {help, value};
+}
+
+void Metrics::addToCounter(const std::string& name, const std::string& help,
+                           const MetricLabels& labels, double increment) {
+  CHECK_GE(increment, 0.0) << "Counters can't decrease.";
+  Metrics& metrics = getInstance();
+  std::lock_guard<std::mutex> lock(metrics.mutex_);
+  auto it = metrics.counters_.try_emplace({name, labels}, Value{help, 0.0});
+  it.first->second.value += increment;
+}
+
+void Metrics::registerCollector(const std::string& key, Collector collector) {
+  Metrics& metrics = getInstance();
+  std::lock_guard<std::mutex> lock(metrics.mutex_);
+  metrics.collectors_[key] = std::move(collector);
+}
+
+void Metrics::unregisterCollector(const std::string& key) {
+  Metrics& metrics = getInstance();
+  std::lock_guard<std::mutex> lock(metrics.mutex_);
+  metrics.collectors_.erase(key);
+}
+
+void Metrics::writeTimingMetrics(MetricsWriter* writer) {
+  CHECK_NOTNULL(writer);
+  std::vector<double> upper_bounds(DurationHistogram::kNumBuckets);
+  for (int i = 0; i < DurationHistogram::kNumBuckets; ++i) {
+    upper_bounds[i] = DurationHistogram::UpperBoundSeconds(i);
+  }
+  std::vector<uint64_t> counts(DurationHistogram::kNumBuckets);
+  for (const TimerStatistics& statistics : Timing::GetAllStatistics()) {
+    const MetricLabels labels = {{"tag", statistics.tag}};
+    for (int i = 0; i < DurationHistogram::kNumBuckets; ++i) {
+      counts[i] = statistics.histogram.Count(i);
+    }
+    writer->addHistogram("nvblox_timer_seconds",
+                         "Host wall time of the timed sections.", labels,
+                         upper_bounds, counts, statistics.total_seconds);
+    writer->addGauge("nvblox_timer_max_seconds",
+                     "The longest sample of the timed sections.", labels,
+                     statistics.max_seconds);
+  }
+
+  constexpr double kSecondsPerMs = 1e-3;
+  for (const auto& [tag, stats] : GpuTiming::GetAllStats()) {
+    const std::string help =
+        "GPU time of the timed sections over a rolling window.";
+    const MetricLabels labels = {{"tag", tag}};
+    const std::vector<std::pair<std::string, float>> statistics = {
+        {"mean", stats.mean_ms}, {"p50", stats.p50_ms}, {"p90", stats.p90_ms},
+        {"p99", stats.p99_ms},   {"max", stats.max_ms}};
+    for (const auto& [statistic, value_ms] : statistics) {
+      writer->addGauge("nvblox_gpu_timer_window_seconds", help,
+                       withLabel(labels, "statistic", statistic),
+                       value_ms * kSecondsPerMs);
+    }
+  }
+
+  for (const std::string& tag : Rates::getTags()) {
+    writer->addGauge("nvblox_rate_hz",
+                     "The rate of the ticked events over a rolling window.",
+                     {{"tag", tag}}, Rates::getMeanRateHz(tag));
+  }
+  for (const std::string& tag : Delays::getTags()) {
+    writer->addGauge("nvblox_delay_seconds",
+                     "The mean delay of the ticked events over a rolling "
+                     "window.",
+                     {{"tag", tag}}, Delays::getRollingMeanDelayInSeconds(tag));
+  }
+}
+
+std::string Metrics::toOpenMetrics() {
+  MetricsWriter writer;
+  writeTimingMetrics(&writer);
+
+  Metrics& metrics = getInstance();
+  std::map<std::string, Collector> collectors;
+  {
+    std::lock_guard<std::mutex> lock(metrics.mutex_);
+    for (const auto& [name_and_labels, value] : metrics.gauges_) {
+      writer.addGauge(name_and_labels.first, value.help,
+                      name_and_labels.second, value.value);
+    }
+    for (const auto& [name_and_labels, value] : metrics.counters_) {
+      writer.addCounter(name_and_labels.first, value.help,
+                        name_and_labels.second, value.value);
+    }
+    collectors = metrics.collectors_;
+  }
+  // Collectors are called without holding the lock, such that they can set
+  // gauges themselves.
+  for (const auto& [key, collector] : collectors) {
+    collector(&writer);
+  }
+  return writer.str();
+}
+
+void Metrics::reset() {
+  Metrics& metrics = getInstance();
+  std::lock_guard<std::mutex> lock(metrics.mutex_);
+  metrics.gauges_.clear();
+  metrics.counters_.clear();
+  metrics.collectors_.clear();
+}
+
+MetricsServer::MetricsServer(int port, const std::string& bind_address) {
+  CHECK_GE(port, 0);
+  listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+  if (listen_fd_ < 0) {
+    LOG(ERROR) << "Failed to create the metrics socket: "
+               << std::strerror(errno);
+    return;
+  }
+  const int reuse_address = 1;
+  setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &reuse_address,
+             sizeof(reuse_address));
+
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(static_cast<uint16_t>(port));
+  constexpr int kBacklog = 8;
+  if (inet_pton(AF_INET, bind_address.c_str(), &address.sin_addr) != 1 ||
+      bind(listen_fd_, reinterpret_cast<sockaddr*>(&address),
+           sizeof(address)) < 0 ||
+      listen(listen_fd_, kBacklog) < 0) {
+    LOG(ERROR) << "Failed to serve metrics on " << bind_address << ":" << port
+               << ": " << std::strerror(errno);
+    close(listen_fd_);
+    listen_fd_ = -1;
+    return;
+  }
+  socklen_t address_length = sizeof(address);
+  getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&address),
+              &address_length);
+  port_ = ntohs(address.sin_port);
+  thread_ = std::thread(&MetricsServer::serve, this);
+  LOG(INFO) << "Serving metrics on http://" << bind_address << ":" << port_
+            << "/metrics";
+}
+
+MetricsServer::~MetricsServer() {
+  stop_ = true;
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+  if (listen_fd_ >= 0) {
+    close(listen_fd_);
+  }
+}
+
+void MetricsServer::serve() {
+  // Poll with a timeout, such that we notice when we're stopped.
+  constexpr int kPollTimeoutMs = 100;
+  while (!stop_) {
+    pollfd poll_fd{listen_fd_, POLLIN, 0};
+    if (poll(&poll_fd, 1, kPollTimeoutMs) <= 0) {
+      continue;
+    }
+    const int connection_fd = accept(listen_fd_, nullptr, nullptr);
+    if (connection_fd < 0) {
+      continue;
+    }
+    handleConnection(connection_fd);
+    close(connection_fd);
+  }
+}
+
+void MetricsServer::handleConnection(int connection_fd) {
+  // Don't let a stalled client block the server.
+  timeval timeout{};
+  timeout.tv_sec = 1;
+  setsockopt(connection_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout,
+             sizeof(timeout));
+
+  // We only need the request line, but read the whole header such that the
+  // client doesn't see a reset connection.
+  constexpr size_t kMaxRequestSize = 8192;
+  std::string request;
+  char buffer[1024];
+  while (request.find("\r\n\r\n") == std::string::npos &&
+         request.size() < kMaxRequestSize) {
+    const ssize_t num_received = recv(connection_fd, buffer, sizeof(buffer), 0);
+    if (num_received <= 0) {
+      break;
+    }
+    request.append(buffer, static_cast<size_t>(num_received));
+  }
+
+  std::istringstream request_line(request.substr(0, request.find("\r\n")));
+  std::string method;
+  std::string target;
+  request_line >> method >> target;
+  const std::string path = target.substr(0, target.find('?'));
+
+  constexpr char kTextContentType[] = "text/plain; charset=utf-8";
+  if (method != "GET") {
+    sendAll(connection_fd, httpResponse("405 Method Not Allowed",
+                                        kTextContentType, "Use GET.\n"));
+  } else if (path != "/metrics" && path != "/") {
+    sendAll(connection_fd,
+            httpResponse("404 Not Found", kTextContentType, "Not found.\n"));
+  } else {
+    sendAll(connection_fd,
+            httpResponse("200 OK",
+                         "application/openmetrics-text; version=1.0.0; "
+                         "charset=utf-8",
+                         Metrics::toOpenMetrics()));
+  }
+}
+
+}  // namespace timing
+}  // namespace nvblox
@@ -22,6 +22,28 @@ limitations under the License.
 namespace nvblox {
 namespace timing {
 
+namespace {
+thread_local FrameId current_frame_id;
+}  // namespace
+
+std::string FrameId::toString() const {
+  return source + "#" + std::to_string(sequence);
+}
+
+FrameId FrameIdGenerator::next(const std::string& source) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return FrameId{source, next_sequences_[source]++};
+}
+
+const FrameId& currentFrameId() { return current_frame_id; }
+
+ScopedFrameId::ScopedFrameId(const FrameId& frame_id)
+    : previous_frame_id_(current_frame_id) {
+  current_frame_id = frame_id;
+}
+
+ScopedFrameId::~ScopedFrameId() { current_frame_id = previous_frame_id_; }
+
 uint32_t colorToUint32(const Color& color) {
   return 0xFF << 24 |                            // NOLINT
          static_cast<uint32_t>(color.r) << 16 |  // NOLINT
@@ -58,6 +80,17 @@ NvtxRange::~NvtxRange() { Stop(); }
 
 void NvtxRange::Start() {
   started_ = true;
+  // The frame is picked up at the start, such that ranges constructed ahead
+  // of time are tagged with the frame they end up timing.
+  if (current_frame_id.valid()) {
+    message_ = tag_ + " [" + current_frame_id.toString() + "]";
+    event_attributes_.payloadType = NVTX_PAYLOAD_TYPE_UNSIGNED_INT64;
+    event_attributes_.payload.ullValue = current_frame_id.sequence;
+  } else {
+    message_ = tag_;
+    event_attributes_.payloadType = NVTX_PAYLOAD_UNKNOWN;
+  }
+  event_attributes_.message.ascii = message_.c_str();
   id_ = nvtxRangeStartEx(&event_attributes_);
 }
 
@@ -80,7 +113,8 @@ void NvtxRange::Init(const std::string& message, const uint32_t color) {
   event_attributes_.colorType = NVTX_COLOR_ARGB;
   event_attributes_.color = color;
   event_attributes_.messageType = NVTX_MESSAGE_TYPE_ASCII;
-  event_attributes_.message.ascii = tag_.c_str();
+  message_ = tag_;
+  event_attributes_.message.ascii = message_.c_str();
 }
 
 void mark(const std::string& message, const uint32_t color) {
@@ -91,7 +125,13 @@ void mark(const std::string& message, const uint32_t color) {
   event_attributes.colorType = NVTX_COLOR_ARGB;
   event_attributes.color = color;
   event_attributes.messageType = NVTX_MESSAGE_TYPE_ASCII;
-  event_attributes.message.ascii = message.c_str();
+  std::string tagged_message = message;
+  if (current_frame_id.valid()) {
+    tagged_message += " [" + current_frame_id.toString() + "]";
+    event_attributes.payloadType = NVTX_PAYLOAD_TYPE_UNSIGNED_INT64;
+    event_attributes.payload.ullValue = current_frame_id.sequence;
+  }
+  event_attributes.message.ascii = tagged_message.c_str();
   nvtxMarkEx(&event_attributes);
 }
 
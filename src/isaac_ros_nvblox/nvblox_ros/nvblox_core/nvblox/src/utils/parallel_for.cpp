@@ -0,0 +1,56 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "nvblox/utils/parallel_for.h"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+namespace nvblox {
+
+int resolveNumCpuThreads(const int num_threads) {
+  if (num_threads > 0) {
+    return num_threads;
+  }
+  // hardware_concurrency() may return zero if unknown.
+  return std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+}
+
+void parallelFor(const size_t num_items, const int num_threads,
+                 const ParallelForChunkFunction& chunk_function) {
+  if (num_items == 0) {
+    return;
+  }
+  const size_t num_chunks = std::min(
+      static_cast<size_t>(resolveNumCpuThreads(num_threads)), num_items);
+  if (num_chunks == 1) {
+    chunk_function(0, num_items);
+    return;
+  }
+  // The calling thread processes the first chunk itself.
+  const size_t chunk_size = (num_items + num_chunks - 1) / num_chunks;
+  std::vector<std::thread> threads;
+  threads.reserve(num_chunks - 1);
+  for (size_t begin = chunk_size; begin < num_items; begin += chunk_size) {
+    const size_t end = std::min(begin + chunk_size, num_items);
+    threads.push_back(std::thread(chunk_function, begin, end));
+  }
+  chunk_function(0, std::min(chunk_size, num_items));
+  std::for_each(threads.begin(), threads.end(),
+                [](std::thread& t) { t.join(); });
+}
+
+}  // namespace nvblox
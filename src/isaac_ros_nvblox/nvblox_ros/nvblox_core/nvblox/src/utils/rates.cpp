@@ -73,9 +73,15 @@ Ticker& Rates::getTicker(const std::string& tag) {
 }
 
 void Rates::tick(const std::string& tag) {
-  Ticker& ticker = getInstance().getTicker(tag);
+  // Tickers are never removed and their addresses are stable, so each thread
+  // can cache them and only lock the map on the first tick of a tag.
+  thread_local std::unordered_map<std::string, Ticker*> ticker_cache;
+  auto it = ticker_cache.find(tag);
+  if (it == ticker_cache.end()) {
+    it = ticker_cache.emplace(tag, &getTicker(tag)).first;
+  }
   std::lock_guard<std::mutex> lock(getInstance().mutex_);
-  ticker.tick(getInstance().get_timestamp_ns_functor_);
+  it->second->tick(getInstance().get_timestamp_ns_functor_);
 }
 
 void Rates::setGetTimestampFunctor(
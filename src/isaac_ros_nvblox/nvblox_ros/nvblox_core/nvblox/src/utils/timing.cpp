@@ -37,12 +37,15 @@ limitations under the License.
 
 #include <math.h>
 #include <stdio.h>
+#include "nvblox/core/sync_monitor.h"
+#include "nvblox/utils/flight_recorder.h"
 #include "nvblox/utils/logging.h"
 
 #include <algorithm>
 #include <ostream>
 #include <sstream>
 #include <string>
+#include <unordered_map>
 
 namespace nvblox {
 
@@ -50,6 +53,13 @@ namespace timing {
 
 const double kNumSecondsPerNanosecond = 1.e-9;
 
+double DurationHistogram::UpperBoundSeconds(int bucket_idx) {
+  if (bucket_idx >= kNumBuckets - 1) {
+    return std::numeric_limits<double>::infinity();
+  }
+  return kSmallestUpperBoundSeconds * static_cast<double>(1 << bucket_idx);
+}
+
 Timing& Timing::Instance() {
   static Timing t;
   return t;
@@ -61,21 +71,53 @@ Timing::~Timing() {}
 
 // Static functions to query the timers:
 size_t Timing::GetHandle(std::string const& tag) {
-  std::lock_guard<std::mutex> lock(Instance().mutex_);
+  return GetCachedHandle(tag).handle;
+}
+
+Timing::HandleAndFlag Timing::GetCachedHandle(std::string const& tag) {
+  // Handles are never invalidated, so each thread can keep its own cache.
+  thread_local std::unordered_map<std::string, HandleAndFlag> handle_cache;
+  auto cache_it = handle_cache.find(tag);
+  if (cache_it != handle_cache.end()) {
+    return cache_it->second;
+  }
+
+  Timing& instance = Instance();
+  std::lock_guard<std::mutex> lock(instance.mutex_);
   // Search for an existing tag.
-  map_t::iterator i = Instance().tagMap_.find(tag);
-  if (i == Instance().tagMap_.end()) {
+  map_t::iterator i = instance.tagMap_.find(tag);
+  size_t handle;
+  if (i == instance.tagMap_.end()) {
     // If it is not there, create a tag.
-    size_t handle = Instance().timers_.size();
-    Instance().tagMap_[tag] = handle;
-    Instance().timers_.push_back(TimerMapValue());
+    handle = instance.enabled_.size();
+    instance.tagMap_[tag] = handle;
+    instance.enabled_.push_back(
+        std::make_unique<std::atomic<bool>>(instance.IsTagEnabled(tag)));
     // Track the maximum tag length to help printing a table of timing values
     // later.
-    Instance().maxTagLength_ = std::max(Instance().maxTagLength_, tag.size());
-    return handle;
+    instance.maxTagLength_ = std::max(instance.maxTagLength_, tag.size());
   } else {
-    return i->second;
+    handle = i->second;
   }
+  const HandleAndFlag handle_and_flag{handle, instance.enabled_[handle].get()};
+  handle_cache.emplace(tag, handle_and_flag);
+  return handle_and_flag;
+}
+
+const std::atomic<bool>* Timing::GetEnabledFlag(size_t handle) {
+  std::lock_guard<std::mutex> lock(Instance().mutex_);
+  CHECK_LT(handle, Instance().enabled_.size());
+  return Instance().enabled_[handle].get();
+}
+
+Timing::ThreadTimers& Timing::GetThreadTimers() {
+  thread_local std::shared_ptr<ThreadTimers> thread_timers = [] {
+    auto timers = std::make_shared<ThreadTimers>();
+    std::lock_guard<std::mutex> lock(Instance().mutex_);
+    Instance().thread_timers_.push_back(timers);
+    return timers;
+  }();
+  return *thread_timers;
 }
 
 std::string Timing::GetTag(size_t handle) {
@@ -91,14 +133,49 @@ std::string Timing::GetTag(size_t handle) {
   return tag;
 }
 
+void Timing::SetSubsystemEnabled(std::string const& subsystem, bool enabled) {
+  Timing& instance = Instance();
+  std::lock_guard<std::mutex> lock(instance.mutex_);
+  if (enabled) {
+    instance.disabled_subsystems_.erase(subsystem);
+  } else {
+    instance.disabled_subsystems_.insert(subsystem);
+  }
+  for (const auto& [tag, handle] : instance.tagMap_) {
+    instance.enabled_[handle]->store(instance.IsTagEnabled(tag),
+                                     std::memory_order_relaxed);
+  }
+}
+
+bool Timing::IsEnabled(std::string const& tag) {
+  std::lock_guard<std::mutex> lock(Instance().mutex_);
+  return Instance().IsTagEnabled(tag);
+}
+
+bool Timing::IsTagEnabled(std::string const& tag) const {
+  // Check the tag and each of its prefixes ending before a '/'.
+  for (size_t end = tag.find('/'); end != std::string::npos;
+       end = tag.find('/', end + 1)) {
+    if (disabled_subsystems_.count(tag.substr(0, end)) > 0) {
+      return false;
+    }
+  }
+  return disabled_subsystems_.count(tag) == 0;
+}
+
 // Class functions used for timing.
 TimerChrono::TimerChrono(size_t handle, bool constructStopped)
-    : timing_(false), handle_(handle) {
+    : timing_(false),
+      handle_(handle),
+      enabled_(Timing::GetEnabledFlag(handle)) {
   if (!constructStopped) Start();
 }
 
 TimerChrono::TimerChrono(std::string const& tag, bool constructStopped)
-    : timing_(false), handle_(Timing::GetHandle(tag)) {
+    : timing_(false) {
+  const Timing::HandleAndFlag handle_and_flag = Timing::GetCachedHandle(tag);
+  handle_ = handle_and_flag.handle;
+  enabled_ = handle_and_flag.enabled;
   if (!constructStopped) Start();
 }
 
@@ -107,22 +184,37 @@ TimerChrono::~TimerChrono() {
 }
 
 void TimerChrono::Start() {
-  timing_ = true;
-  time_ = std::chrono::system_clock::now();
+  timing_ = enabled_->load(std::memory_order_relaxed);
+  if (timing_) {
+    time_ = std::chrono::system_clock::now();
+#ifdef NVBLOX_SYNC_MONITOR
+    SyncMonitor::pushTimerHandle(handle_);
+#endif
+  }
 }
 
 void TimerChrono::Stop() {
   if (timing_) {
     std::chrono::time_point<std::chrono::system_clock> now =
         std::chrono::system_clock::now();
-    double dt =
-        static_cast<double>(
-            std::chrono::duration_cast<std::chrono::nanoseconds>(now - time_)
-                .count()) *
-        kNumSecondsPerNanosecond;
+    const int64_t dt_ns =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(now - time_)
+            .count();
+    double dt = static_cast<double>(dt_ns) * kNumSecondsPerNanosecond;
 
     Timing::Instance().AddTime(handle_, dt);
+    if (FlightRecorder::isEnabled()) {
+      FlightRecorder::recordTimer(
+          handle_,
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+              time_.time_since_epoch())
+              .count(),
+          dt_ns);
+    }
     timing_ = false;
+#ifdef NVBLOX_SYNC_MONITOR
+    SyncMonitor::popTimerHandle(handle_);
+#endif
   }
 }
 
@@ -149,55 +241,80 @@ void TimerNvtx::Stop() {
 bool TimerNvtx::IsTiming() const { return timer_.IsTiming(); }
 
 void Timing::AddTime(size_t handle, double seconds) {
-  std::lock_guard<std::mutex> lock(Instance().mutex_);
-  timers_[handle].acc_.Add(seconds);
+  ThreadTimers& thread_timers = GetThreadTimers();
+  std::lock_guard<std::mutex> lock(thread_timers.mutex);
+  if (handle >= thread_timers.timers.size()) {
+    thread_timers.timers.resize(handle + 1);
+  }
+  thread_timers.timers[handle].acc_.Add(seconds);
+  thread_timers.timers[handle].histogram_.Add(seconds);
+}
+
+TimerMapValue Timing::GetMerged(size_t handle) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  TimerMapValue merged;
+  for (const auto& thread_timers : thread_timers_) {
+    std::lock_guard<std::mutex> thread_lock(thread_timers->mutex);
+    if (handle < thread_timers->timers.size()) {
+      merged.acc_.Merge(thread_timers->timers[handle].acc_);
+      merged.histogram_.Merge(thread_timers->timers[handle].histogram_);
+    }
+  }
+  return merged;
+}
+
+Timing::list_t Timing::GetAllMerged() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  list_t merged(enabled_.size());
+  for (const auto& thread_timers : thread_timers_) {
+    std::lock_guard<std::mutex> thread_lock(thread_timers->mutex);
+    for (size_t handle = 0; handle < thread_timers->timers.size(); ++handle) {
+      merged[handle].acc_.Merge(thread_timers->timers[handle].acc_);
+      merged[handle].histogram_.Merge(thread_timers->timers[handle].histogram_);
+    }
+  }
+  return merged;
 }
 
 double Timing::GetTotalSeconds(size_t handle) {
-  std::lock_guard<std::mutex> lock(Instance().mutex_);
-  return Instance().timers_[handle].acc_.Sum();
+  return Instance().GetMerged(handle).acc_.Sum();
 }
 double Timing::GetTotalSeconds(std::string const& tag) {
   return GetTotalSeconds(GetHandle(tag));
 }
 double Timing::GetMeanSeconds(size_t handle) {
-  std::lock_guard<std::mutex> lock(Instance().mutex_);
-  return Instance().timers_[handle].acc_.Mean();
+  return Instance().GetMerged(handle).acc_.Mean();
 }
 double Timing::GetMeanSeconds(std::string const& tag) {
   return GetMeanSeconds(GetHandle(tag));
 }
 size_t Timing::GetNumSamples(size_t handle) {
-  return Instance().timers_[handle].acc_.TotalSamples();
+  return Instance().GetMerged(handle).acc_.TotalSamples();
 }
 size_t Timing::GetNumSamples(std::string const& tag) {
   return GetNumSamples(GetHandle(tag));
 }
 double Timing::GetVarianceSeconds(size_t handle) {
-  std::lock_guard<std::mutex> lock(Instance().mutex_);
-  return Instance().timers_[handle].acc_.LazyVariance();
+  return Instance().GetMerged(handle).acc_.LazyVariance();
 }
 double Timing::GetVarianceSeconds(std::string const& tag) {
   return GetVarianceSeconds(GetHandle(tag));
 }
 double Timing::GetMinSeconds(size_t handle) {
-  std::lock_guard<std::mutex> lock(Instance().mutex_);
-  return Instance().timers_[handle].acc_.Min();
+  return Instance().GetMerged(handle).acc_.Min();
 }
 double Timing::GetMinSeconds(std::string const& tag) {
   return GetMinSeconds(GetHandle(tag));
 }
 double Timing::GetMaxSeconds(size_t handle) {
-  std::lock_guard<std::mutex> lock(Instance().mutex_);
-  return Instance().timers_[handle].acc_.Max();
+  return Instance().GetMerged(handle).acc_.Max();
 }
 double Timing::GetMaxSeconds(std::string const& tag) {
   return GetMaxSeconds(GetHandle(tag));
 }
 
 double Timing::GetHz(size_t handle) {
-  std::lock_guard<std::mutex> lock(Instance().mutex_);
-  const double rolling_mean = Instance().timers_[handle].acc_.RollingMean();
+  const double rolling_mean = Instance().GetMerged(handle).acc_.RollingMean();
   CHECK_GT(rolling_mean, 0.0);
   return 1.0 / rolling_mean;
 }
@@ -211,7 +328,10 @@ std::string Timing::SecondsToTimeString(double seconds) {
 }
 
 void Timing::Print(std::ostream& out) {
-  map_t& tagMap = Instance().tagMap_;
+  // Merge once rather than for each printed statistic.
+  const list_t timers = Instance().GetAllMerged();
+  std::lock_guard<std::mutex> lock(Instance().mutex_);
+  const map_t& tagMap = Instance().tagMap_;
 
   if (tagMap.empty()) {
     return;
@@ -222,23 +342,27 @@ void Timing::Print(std::ostream& out) {
          "[Min,Max]\n";
   out << "-----------\n";
   for (typename map_t::value_type t : tagMap) {
-    size_t i = t.second;
+    // Tags created after merging have no samples yet.
+    if (t.second >= timers.size()) {
+      continue;
+    }
+    const auto& acc = timers[t.second].acc_;
     out.width((std::streamsize)Instance().maxTagLength_);
     out.setf(std::ios::left, std::ios::adjustfield);
     out << t.first << "\t";
     out.width(7);
 
     out.setf(std::ios::right, std::ios::adjustfield);
-    out << GetNumSamples(i) << "\t";
-    if (GetNumSamples(i) > 0) {
-      out << SecondsToTimeString(GetTotalSeconds(i)) << "\t";
-      double meansec = GetMeanSeconds(i);
-      double stddev = sqrt(GetVarianceSeconds(i));
+    out << acc.TotalSamples() << "\t";
+    if (acc.TotalSamples() > 0) {
+      out << SecondsToTimeString(acc.Sum()) << "\t";
+      double meansec = acc.Mean();
+      double stddev = sqrt(acc.LazyVariance());
       out << "(" << SecondsToTimeString(meansec) << " +- ";
       out << SecondsToTimeString(stddev) << ")\t";
 
-      double minsec = GetMinSeconds(i);
-      double maxsec = GetMaxSeconds(i);
+      double minsec = acc.Min();
+      double maxsec = acc.Max();
 
       // The min or max are out of bounds.
       out << "[" << SecondsToTimeString(minsec) << ","
@@ -248,6 +372,27 @@ void Timing::Print(std::ostream& out) {
   }
   out << "-----------\n";
 }
+std::vector<TimerStatistics> Timing::GetAllStatistics() {
+  const list_t timers = Instance().GetAllMerged();
+  std::lock_guard<std::mutex> lock(Instance().mutex_);
+  std::vector<TimerStatistics> all_statistics;
+  for (const auto& [tag, handle] : Instance().tagMap_) {
+    if (handle >= timers.size() || timers[handle].acc_.TotalSamples() == 0) {
+      continue;
+    }
+    const TimerMapValue& timer = timers[handle];
+    TimerStatistics statistics;
+    statistics.tag = tag;
+    statistics.num_samples = timer.acc_.TotalSamples();
+    statistics.total_seconds = timer.acc_.Sum();
+    statistics.min_seconds = timer.acc_.Min();
+    statistics.max_seconds = timer.acc_.Max();
+    statistics.histogram = timer.histogram_;
+    all_statistics.push_back(statistics);
+  }
+  return all_statistics;
+}
+
 std::string Timing::Print() {
   std::stringstream ss;
   Print(ss);
@@ -256,7 +401,10 @@ std::string Timing::Print() {
 
 void Timing::Reset() {
   std::lock_guard<std::mutex> lock(Instance().mutex_);
-  Instance().tagMap_.clear();
+  for (const auto& thread_timers : Instance().thread_timers_) {
+    std::lock_guard<std::mutex> thread_lock(thread_timers->mutex);
+    thread_timers->timers.clear();
+  }
 }
 
 }  // namespace timing
@@ -181,19 +181,27 @@ void benchmarkRemoveSmallConnectedComponents(benchmark::State& state) {
                   static_cast<test_utils::MaskImageType>(state.range(0)));
   MonoImage mask_out(mask.rows(), mask.cols(), MemoryType::kDevice);
   image::MaskPreprocessor mask_preprocessor(
-      std::make_shared<CudaStreamOwning>());
+      std::make_shared<CudaStreamOwning>(), state.range(1));
 
   for (auto _ : state) {
     mask_preprocessor.removeSmallConnectedComponents(mask, 10000, &mask_out);
   }
 }
+// Mask type and downscale factor.
+void removeSmallConnectedComponentsArgs(benchmark::internal::Benchmark* b) {
+  for (const auto type : {test_utils::MaskImageType::kFromDisk,
+                          test_utils::MaskImageType::kEverythingZero,
+                          test_utils::MaskImageType::kEverythingFilled,
+                          test_utils::MaskImageType::kGrid,
+                          test_utils::MaskImageType::kTwoSquares}) {
+    for (const int64_t downscale_factor : {1, 2}) {
+      b->Args({static_cast<int64_t>(type), downscale_factor});
+    }
+  }
+}
 BENCHMARK(benchmarkRemoveSmallConnectedComponents)
     ->Unit(benchmark::kMillisecond)
-    ->Arg(static_cast<int64_t>(test_utils::MaskImageType::kFromDisk))
-    ->Arg(static_cast<int64_t>(test_utils::MaskImageType::kEverythingZero))
-    ->Arg(static_cast<int64_t>(test_utils::MaskImageType::kEverythingFilled))
-    ->Arg(static_cast<int64_t>(test_utils::MaskImageType::kGrid))
-    ->Arg(static_cast<int64_t>(test_utils::MaskImageType::kTwoSquares));
+    ->Apply(removeSmallConnectedComponentsArgs);
 
 void benchmarkMonoImageGpuToCpuRoundtrip(benchmark::State& state) {
   const int32_t width = state.range(0);
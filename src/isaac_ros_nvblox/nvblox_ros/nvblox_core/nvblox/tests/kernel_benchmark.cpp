@@ -0,0 +1,381 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+// Microbenchmarks of the individual GPU hot paths.
+//
+// Unlike benchmark.cpp, which times whole mapper calls on a dataset frame,
+// each benchmark here isolates a single stage on synthetic data, swept over
+// block counts or image resolutions. Besides the wall time per iteration, the
+// GPU time of the stage (see timing::GpuTimer) is reported as the "gpu_ms"
+// counter where available.
+//
+// To record results which can be compared across releases and GPUs, run
+//   nvblox_kernel_benchmark --benchmark_out=results.json
+//                           --benchmark_out_format=json
+// The GPU name and compute capability are stored in the JSON context.
+
+#include <benchmark/benchmark.h>
+#include <glog/logging.h>
+
+#include <cmath>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "nvblox/core/cuda_stream.h"
+#include "nvblox/core/internal/error_check.h"
+#include "nvblox/core/internal/warmup_cuda.h"
+#include "nvblox/integrators/esdf_integrator.h"
+#include "nvblox/integrators/freespace_integrator.h"
+#include "nvblox/integrators/projective_tsdf_integrator.h"
+#include "nvblox/map/accessors.h"
+#include "nvblox/map/common_names.h"
+#include "nvblox/map/layer.h"
+#include "nvblox/mesh/mesh_integrator.h"
+#include "nvblox/primitives/scene.h"
+#include "nvblox/rays/sphere_tracer.h"
+#include "nvblox/sensors/camera.h"
+#include "nvblox/serialization/layer_serializer_gpu.h"
+#include "nvblox/tests/gpu_layer_utils.h"
+#include "nvblox/utils/gpu_timing.h"
+
+namespace nvblox {
+
+constexpr float kVoxelSize = 0.1f;
+constexpr float kTruncationDistanceM = 4.0f * kVoxelSize;
+// The height of the synthetic scenes in blocks.
+constexpr int kSceneHeightBlocks = 4;
+
+// Prevent GLOG from being initialized more than once
+std::once_flag init_flag;
+
+void initialize() {
+  std::call_once(init_flag, []() {
+    google::InitGoogleLogging("nvblox_kernel_benchmark");
+    warmupCuda();
+    int device = 0;
+    checkCudaErrors(cudaGetDevice(&device));
+    cudaDeviceProp properties;
+    checkCudaErrors(cudaGetDeviceProperties(&properties, device));
+    benchmark::AddCustomContext("gpu", properties.name);
+    benchmark::AddCustomContext("compute_capability",
+                                std::to_string(properties.major) + "." +
+                                    std::to_string(properties.minor));
+  });
+  timing::GpuTiming::Reset();
+}
+
+// Report the mean GPU time of a stage over the benchmark's iterations.
+void addGpuTimeCounter(const std::string& gpu_timer_tag,
+                       benchmark::State* state) {
+  timing::GpuTiming::ResolveAll();
+  const timing::GpuTimingStats stats =
+      timing::GpuTiming::GetStats(gpu_timer_tag);
+  if (stats.num_samples > 0) {
+    state->counters["gpu_ms"] = stats.mean_ms;
+  }
+}
+
+// A box of side_length_blocks x side_length_blocks x kSceneHeightBlocks
+// blocks, containing a ground plane and a sphere surrounded by walls.
+primitives::Scene createScene(int side_length_blocks) {
+  const float block_size = voxelSizeToBlockSize(kVoxelSize);
+  const float half_side_m = 0.5f * side_length_blocks * block_size;
+  const float height_m = kSceneHeightBlocks * block_size;
+  primitives::Scene scene;
+  scene.aabb() =
+      AxisAlignedBoundingBox(Vector3f(-half_side_m, -half_side_m, 0.0f),
+                             Vector3f(half_side_m, half_side_m, height_m));
+  scene.addGroundLevel(0.5f * kVoxelSize);
+  scene.addPrimitive(std::make_unique<primitives::Sphere>(
+      Vector3f(0.0f, 0.0f, 0.5f * height_m), 0.4f * height_m));
+  scene.addPlaneBoundaries(-half_side_m + kVoxelSize, half_side_m - kVoxelSize,
+                           -half_side_m + kVoxelSize,
+                           half_side_m - kVoxelSize);
+  return scene;
+}
+
+// A device TSDF layer of the scene above.
+std::unique_ptr<TsdfLayer> createTsdfLayer(int side_length_blocks) {
+  TsdfLayer tsdf_layer_unified(kVoxelSize, MemoryType::kUnified);
+  createScene(side_length_blocks)
+      .generateLayerFromScene(kTruncationDistanceM, &tsdf_layer_unified);
+  // The scene sets the distance only. Mark all voxels as observed.
+  callFunctionOnAllVoxels<TsdfVoxel>(
+      &tsdf_layer_unified,
+      [](const Index3D&, const Index3D&, TsdfVoxel* voxel) {
+        voxel->weight = 1.0f;
+      });
+  auto tsdf_layer =
+      std::make_unique<TsdfLayer>(kVoxelSize, MemoryType::kDevice);
+  tsdf_layer->copyFrom(tsdf_layer_unified);
+  return tsdf_layer;
+}
+
+// A camera looking at the scene center from the edge of the scene.
+Transform getCameraPose(int side_length_blocks) {
+  const float block_size = voxelSizeToBlockSize(kVoxelSize);
+  const float distance_m = 0.4f * side_length_blocks * block_size;
+  Transform T_S_C = Transform::Identity();
+  // The camera has its z axis pointing towards the origin (see
+  // sphere_benchmark.cpp).
+  T_S_C.prerotate(Eigen::AngleAxisf(M_PI, Vector3f::UnitZ()) *
+                  Eigen::Quaternionf(0.5, 0.5, 0.5, 0.5));
+  T_S_C.pretranslate(
+      Vector3f(distance_m, 0.0f, 0.5f * kSceneHeightBlocks * block_size));
+  return T_S_C;
+}
+
+Camera createCamera(int width, int height) {
+  // A 90 degree horizontal field of view at all resolutions.
+  const float focal_length = 0.5f * width;
+  return Camera(focal_length, focal_length, 0.5f * width, 0.5f * height,
+                width, height);
+}
+
+std::vector<Index3D> getBlockIndicesInCube(int num_blocks) {
+  const int side_length = static_cast<int>(std::ceil(std::cbrt(num_blocks)));
+  std::vector<Index3D> block_indices;
+  block_indices.reserve(num_blocks);
+  for (int i = 0; i < num_blocks; ++i) {
+    block_indices.emplace_back(i % side_length, (i / side_length) % side_length,
+                               i / (side_length * side_length));
+  }
+  return block_indices;
+}
+
+// Sweeps over the scene side length in blocks (i.e. block counts between 256
+// and 16384)
+void sceneSizes(benchmark::internal::Benchmark* benchmark) {
+  for (int side_length_blocks : {8, 16, 32, 64}) {
+    benchmark->Arg(side_length_blocks);
+  }
+}
+
+// Sweeps over image resolutions (width, height).
+void imageResolutions(benchmark::internal::Benchmark* benchmark) {
+  benchmark->Args({320, 240});
+  benchmark->Args({640, 480});
+  benchmark->Args({1280, 720});
+  benchmark->Args({1920, 1080});
+}
+
+void benchmarkGpuHashInsert(benchmark::State& state) {
+  initialize();
+  const std::vector<Index3D> block_indices =
+      getBlockIndicesInCube(state.range(0));
+  CudaStreamOwning cuda_stream;
+  TsdfLayer layer(kVoxelSize, MemoryType::kDevice);
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    layer.clear();
+    layer.getGpuLayerView(cuda_stream);
+    cuda_stream.synchronize();
+    state.ResumeTiming();
+
+    // Allocation inserts into the CPU hash, the GPU layer view update then
+    // inserts the new blocks into the GPU hash.
+    layer.allocateBlocksAtIndices(block_indices, cuda_stream);
+    layer.getGpuLayerView(cuda_stream);
+    cuda_stream.synchronize();
+  }
+  state.counters["num_blocks"] = block_indices.size();
+}
+BENCHMARK(benchmarkGpuHashInsert)
+    ->RangeMultiplier(8)
+    ->Range(1 << 9, 1 << 15)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+void benchmarkGpuHashLookup(benchmark::State& state) {
+  initialize();
+  const std::vector<Index3D> block_indices =
+      getBlockIndicesInCube(state.range(0));
+  CudaStreamOwning cuda_stream;
+  TsdfLayer layer(kVoxelSize, MemoryType::kDevice);
+  layer.allocateBlocksAtIndices(block_indices, cuda_stream);
+  const GPULayerView<TsdfBlock>& gpu_layer_view =
+      layer.getGpuLayerView(cuda_stream);
+  cuda_stream.synchronize();
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        test_utils::getContainsFlags(gpu_layer_view, block_indices));
+  }
+  state.counters["num_blocks"] = block_indices.size();
+}
+BENCHMARK(benchmarkGpuHashLookup)
+    ->RangeMultiplier(8)
+    ->Range(1 << 9, 1 << 15)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+void benchmarkIntegrateTsdf(benchmark::State& state) {
+  initialize();
+  constexpr int kSideLengthBlocks = 32;
+  const Camera camera = createCamera(state.range(0), state.range(1));
+  const Transform T_S_C = getCameraPose(kSideLengthBlocks);
+  DepthImage depth_frame(camera.height(), camera.width(), MemoryType::kUnified);
+  createScene(kSideLengthBlocks)
+      .generateDepthImageFromScene(camera, T_S_C, 100.0f, &depth_frame);
+
+  auto cuda_stream = std::make_shared<CudaStreamOwning>();
+  ProjectiveTsdfIntegrator integrator(cuda_stream);
+  integrator.truncation_distance_vox(kTruncationDistanceM / kVoxelSize);
+  TsdfLayer layer(kVoxelSize, MemoryType::kDevice);
+  // Allocate the blocks in view up front, such that the benchmark measures
+  // the steady state.
+  integrator.integrateFrame(depth_frame, T_S_C, camera, &layer);
+
+  for (auto _ : state) {
+    integrator.integrateFrame(depth_frame, T_S_C, camera, &layer);
+    cuda_stream->synchronize();
+  }
+  state.counters["num_blocks"] = layer.numAllocatedBlocks();
+  addGpuTimeCounter("tsdf/integrate/update_blocks", &state);
+}
+BENCHMARK(benchmarkIntegrateTsdf)
+    ->Apply(imageResolutions)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+void benchmarkUpdateFreespace(benchmark::State& state) {
+  initialize();
+  const std::unique_ptr<TsdfLayer> tsdf_layer =
+      createTsdfLayer(state.range(0));
+  const std::vector<Index3D> block_indices = tsdf_layer->getAllBlockIndices();
+  auto cuda_stream = std::make_shared<CudaStreamOwning>();
+  FreespaceIntegrator integrator(cuda_stream);
+  FreespaceLayer freespace_layer(kVoxelSize, MemoryType::kDevice);
+
+  int64_t update_time_ms = 0;
+  for (auto _ : state) {
+    update_time_ms += 100;
+    integrator.updateFreespaceLayer(block_indices, Time(update_time_ms),
+                                    *tsdf_layer, std::nullopt,
+                                    &freespace_layer);
+    cuda_stream->synchronize();
+  }
+  state.counters["num_blocks"] = block_indices.size();
+  addGpuTimeCounter("freespace/integrate/update_blocks", &state);
+}
+BENCHMARK(benchmarkUpdateFreespace)
+    ->Apply(sceneSizes)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+void benchmarkIntegrateEsdf(benchmark::State& state) {
+  initialize();
+  const std::unique_ptr<TsdfLayer> tsdf_layer =
+      createTsdfLayer(state.range(0));
+  const std::vector<Index3D> block_indices = tsdf_layer->getAllBlockIndices();
+  auto cuda_stream = std::make_shared<CudaStreamOwning>();
+  EsdfIntegrator integrator(cuda_stream);
+  integrator.max_esdf_distance_m(2.0f);
+  integrator.min_weight(0.5f);
+  EsdfLayer esdf_layer(kVoxelSize, MemoryType::kDevice);
+
+  // Marking the sites and the sweeps are not exposed separately. Their split
+  // is visible in the CPU timers ("esdf/integrate/mark_sites" and
+  // "esdf/integrate/compute") and in the GPU time of the sweeps.
+  for (auto _ : state) {
+    state.PauseTiming();
+    esdf_layer.clear();
+    cuda_stream->synchronize();
+    state.ResumeTiming();
+
+    integrator.integrateBlocks(*tsdf_layer, block_indices, &esdf_layer);
+    cuda_stream->synchronize();
+  }
+  state.counters["num_blocks"] = block_indices.size();
+  addGpuTimeCounter("esdf/integrate/compute/sweep", &state);
+}
+BENCHMARK(benchmarkIntegrateEsdf)
+    ->Apply(sceneSizes)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+void benchmarkMarchingCubes(benchmark::State& state) {
+  initialize();
+  const std::unique_ptr<TsdfLayer> tsdf_layer =
+      createTsdfLayer(state.range(0));
+  const std::vector<Index3D> block_indices = tsdf_layer->getAllBlockIndices();
+  auto cuda_stream = std::make_shared<CudaStreamOwning>();
+  MeshIntegrator integrator(cuda_stream);
+  MeshLayer mesh_layer(tsdf_layer->block_size(), MemoryType::kDevice);
+
+  for (auto _ : state) {
+    integrator.integrateBlocksGPU(*tsdf_layer, block_indices, &mesh_layer);
+    cuda_stream->synchronize();
+  }
+  state.counters["num_blocks"] = block_indices.size();
+  addGpuTimeCounter("mesh/gpu/mesh_blocks", &state);
+}
+BENCHMARK(benchmarkMarchingCubes)
+    ->Apply(sceneSizes)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+void benchmarkSerializeTsdf(benchmark::State& state) {
+  initialize();
+  const std::unique_ptr<TsdfLayer> tsdf_layer =
+      createTsdfLayer(state.range(0));
+  const std::vector<Index3D> block_indices = tsdf_layer->getAllBlockIndices();
+  CudaStreamOwning cuda_stream;
+  TsdfLayerSerializerGpu serializer;
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        serializer.serialize(*tsdf_layer, block_indices, cuda_stream));
+  }
+  state.counters["num_blocks"] = block_indices.size();
+  state.SetBytesProcessed(state.iterations() * block_indices.size() *
+                          sizeof(TsdfBlock));
+  addGpuTimeCounter("serialization/serialize_vectors", &state);
+}
+BENCHMARK(benchmarkSerializeTsdf)
+    ->Apply(sceneSizes)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+void benchmarkSphereTracing(benchmark::State& state) {
+  initialize();
+  constexpr int kSideLengthBlocks = 32;
+  const std::unique_ptr<TsdfLayer> tsdf_layer =
+      createTsdfLayer(kSideLengthBlocks);
+  const Camera camera = createCamera(state.range(0), state.range(1));
+  const Transform T_S_C = getCameraPose(kSideLengthBlocks);
+  auto cuda_stream = std::make_shared<CudaStreamOwning>();
+  SphereTracer sphere_tracer(cuda_stream);
+  DepthImage depth_image(MemoryType::kDevice);
+
+  for (auto _ : state) {
+    sphere_tracer.renderImageOnGPU(camera, T_S_C, *tsdf_layer,
+                                   kTruncationDistanceM, &depth_image);
+    cuda_stream->synchronize();
+  }
+  state.counters["num_pixels"] = camera.width() * camera.height();
+}
+BENCHMARK(benchmarkSphereTracing)
+    ->Apply(imageResolutions)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+}  // namespace nvblox
+
+BENCHMARK_MAIN();
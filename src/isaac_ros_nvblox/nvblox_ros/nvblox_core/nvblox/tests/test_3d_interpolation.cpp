@@ -282,6 +282,171 @@ TEST(InterpolatorTest, PrimitivesInterpolationTest) {
   }
 }
 
+TEST(InterpolatorTest, GpuInterpolationMatchesCpu) {
+  // Sphere in a box
+  primitives::Scene scene;
+  scene.aabb() = AxisAlignedBoundingBox(Vector3f(-5.0f, -5.0f, 0.0f),
+                                        Vector3f(5.0f, 5.0f, 5.0f));
+  scene.addGroundLevel(0.0f);
+  scene.addCeiling(5.0f);
+  scene.addPrimitive(
+      std::make_unique<primitives::Sphere>(Vector3f(0.0f, 0.0f, 2.0f), 2.0f));
+  scene.addPlaneBoundaries(-5.0f, 5.0f, -5.0f, 5.0f);
+
+  constexpr float kVoxelSize_m = 0.2;
+  TsdfLayer layer(kVoxelSize_m, MemoryType::kUnified);
+  constexpr float kTruncationDistanceMeters = 10;
+  scene.generateLayerFromScene(kTruncationDistanceMeters, &layer);
+
+  constexpr int kNumPointsToTest = 1000;
+  std::vector<Vector3f> p_L_vec(kNumPointsToTest);
+  std::generate(p_L_vec.begin(), p_L_vec.end(), []() {
+    return Vector3f(test_utils::randomFloatInRange(-5.0f, 5.0f),
+                    test_utils::randomFloatInRange(-5.0f, 5.0f),
+                    test_utils::randomFloatInRange(0.0f, 5.0f));
+  });
+
+  // CPU
+  std::vector<float> cpu_distances;
+  std::vector<bool> cpu_success_flags;
+  interpolation::interpolateOnCPU(p_L_vec, layer, &cpu_distances,
+                                  &cpu_success_flags);
+
+  // GPU
+  CudaStreamOwning cuda_stream;
+  device_vector<Vector3f> p_L_device;
+  p_L_device.copyFromAsync(p_L_vec, cuda_stream);
+  device_vector<float> gpu_distances_device;
+  device_vector<Vector3f> gpu_gradients_device;
+  device_vector<bool> gpu_success_flags_device;
+  interpolation::interpolateOnGPUAsync(
+      p_L_device, layer, &gpu_distances_device, &gpu_gradients_device,
+      &gpu_success_flags_device, cuda_stream);
+  const std::vector<float> gpu_distances =
+      gpu_distances_device.toVectorAsync(cuda_stream);
+  const std::vector<bool> gpu_success_flags =
+      gpu_success_flags_device.toVectorAsync(cuda_stream);
+  cuda_stream.synchronize();
+
+  int num_success = 0;
+  for (size_t i = 0; i < p_L_vec.size(); i++) {
+    EXPECT_EQ(cpu_success_flags[i], gpu_success_flags[i]);
+    if (cpu_success_flags[i] && gpu_success_flags[i]) {
+      EXPECT_NEAR(cpu_distances[i], gpu_distances[i], 1e-4);
+      ++num_success;
+    }
+  }
+  EXPECT_GT(num_success, 0);
+}
+
+TEST(InterpolatorTest, BatchInterpolationMatchesPerPoint) {
+  // Sphere in a box
+  primitives::Scene scene;
+  scene.aabb() = AxisAlignedBoundingBox(Vector3f(-5.0f, -5.0f, 0.0f),
+                                        Vector3f(5.0f, 5.0f, 5.0f));
+  scene.addGroundLevel(0.0f);
+  scene.addCeiling(5.0f);
+  scene.addPrimitive(
+      std::make_unique<primitives::Sphere>(Vector3f(0.0f, 0.0f, 2.0f), 2.0f));
+  scene.addPlaneBoundaries(-5.0f, 5.0f, -5.0f, 5.0f);
+
+  constexpr float kVoxelSize_m = 0.2;
+  TsdfLayer layer(kVoxelSize_m, MemoryType::kUnified);
+  constexpr float kTruncationDistanceMeters = 10;
+  scene.generateLayerFromScene(kTruncationDistanceMeters, &layer);
+
+  // Some of the points lie outside the layer, where interpolation fails.
+  constexpr int kNumPointsToTest = 1000;
+  std::vector<Vector3f> p_L_vec(kNumPointsToTest);
+  std::generate(p_L_vec.begin(), p_L_vec.end(), []() {
+    return Vector3f(test_utils::randomFloatInRange(-6.0f, 6.0f),
+                    test_utils::randomFloatInRange(-6.0f, 6.0f),
+                    test_utils::randomFloatInRange(-1.0f, 6.0f));
+  });
+
+  std::vector<float> distances;
+  std::vector<bool> success_flags;
+  interpolation::interpolateOnCPU(p_L_vec, layer, &distances, &success_flags);
+
+  constexpr int kNumThreads = 4;
+  for (const int num_threads : {1, kNumThreads}) {
+    std::vector<float> batch_distances;
+    std::vector<bool> batch_success_flags;
+    interpolation::interpolateBatchOnCPU(p_L_vec, layer, &batch_distances,
+                                         &batch_success_flags, num_threads);
+    ASSERT_EQ(batch_distances.size(), p_L_vec.size());
+    ASSERT_EQ(batch_success_flags.size(), p_L_vec.size());
+    int num_success = 0;
+    for (size_t i = 0; i < p_L_vec.size(); i++) {
+      EXPECT_EQ(batch_success_flags[i], success_flags[i]);
+      if (batch_success_flags[i] && success_flags[i]) {
+        EXPECT_NEAR(batch_distances[i], distances[i], 1e-4);
+        ++num_success;
+      }
+    }
+    EXPECT_GT(num_success, 0);
+    EXPECT_LT(num_success, kNumPointsToTest);
+  }
+}
+
+TEST(InterpolatorTest, GpuInterpolationGradient) {
+  constexpr float kVoxelSize = 0.5f;
+  EsdfLayer layer(kVoxelSize, MemoryType::kUnified);
+
+  // Fill two neighbouring blocks such that distance increases with x.
+  for (int i = 0; i < 2; i++) {
+    EsdfBlock::Ptr block_ptr = layer.allocateBlockAtIndex(Index3D(i, 0, 0));
+    fillVoxelsWithIndices(block_ptr.get(), kXAxisIndex,
+                          i * EsdfBlock::kVoxelsPerSide);
+  }
+
+  // Query points spanning the block boundary.
+  const float block_size = layer.block_size();
+  const std::vector<Vector3f> p_L_vec = {
+      Vector3f(0.5f * block_size, 0.5f * block_size, 0.5f * block_size),
+      Vector3f(block_size, 0.3f * block_size, 0.7f * block_size),
+      Vector3f(1.5f * block_size, 0.6f * block_size, 0.2f * block_size)};
+
+  CudaStreamOwning cuda_stream;
+  device_vector<Vector3f> p_L_device;
+  p_L_device.copyFromAsync(p_L_vec, cuda_stream);
+  device_vector<float> distances_device;
+  device_vector<Vector3f> gradients_device;
+  device_vector<bool> success_flags_device;
+  interpolation::interpolateOnGPUAsync(p_L_device, layer, &distances_device,
+                                       &gradients_device,
+                                       &success_flags_device, cuda_stream);
+  const std::vector<float> distances =
+      distances_device.toVectorAsync(cuda_stream);
+  const std::vector<Vector3f> gradients =
+      gradients_device.toVectorAsync(cuda_stream);
+  const std::vector<bool> success_flags =
+      success_flags_device.toVectorAsync(cuda_stream);
+  cuda_stream.synchronize();
+
+  // The distance (in voxels) is the x-index of the voxel, so it increases by
+  // one per voxel along x.
+  for (size_t i = 0; i < p_L_vec.size(); i++) {
+    ASSERT_TRUE(success_flags[i]);
+    const float expected_distance = p_L_vec[i].x() / kVoxelSize - 0.5f;
+    EXPECT_NEAR(distances[i], expected_distance, kFloatEpsilon * 10);
+    EXPECT_NEAR(gradients[i].x(), 1.0f / kVoxelSize, kFloatEpsilon * 10);
+    EXPECT_NEAR(gradients[i].y(), 0.0f, kFloatEpsilon * 10);
+    EXPECT_NEAR(gradients[i].z(), 0.0f, kFloatEpsilon * 10);
+  }
+
+  // Outside the allocated blocks interpolation fails.
+  p_L_device.copyFromAsync(std::vector<Vector3f>{Vector3f(-1.0f, 0.f, 0.f)},
+                           cuda_stream);
+  interpolation::interpolateOnGPUAsync(p_L_device, layer, &distances_device,
+                                       nullptr, &success_flags_device,
+                                       cuda_stream);
+  const std::vector<bool> outside_success_flags =
+      success_flags_device.toVectorAsync(cuda_stream);
+  cuda_stream.synchronize();
+  EXPECT_FALSE(outside_success_flags[0]);
+}
+
 int main(int argc, char** argv) {
   FLAGS_alsologtostderr = true;
   google::InitGoogleLogging(argv[0]);
@@ -124,9 +124,36 @@ TEST_P(LoaderParameterizedTest, ImageLoaderObject) {
               kTolerance);
 }
 
-// TODO(dtingdahl) Re-enable multi-threading when it is supported again
 INSTANTIATE_TEST_CASE_P(LoaderTests, LoaderParameterizedTest,
-                        ::testing::Values(LoaderType::kSingleThreaded));
+                        ::testing::Values(LoaderType::kSingleThreaded,
+                                          LoaderType::kMultiThreaded));
+
+TEST_F(Dataset3DMatchTest, MultiThreadedLoaderMatchesSingleThreaded) {
+  // Few threads and a short queue, such that images are decoded out of order
+  // and some are decoded into recycled pinned buffers.
+  constexpr int seq_id = 1;
+  constexpr int kNumThreads = 2;
+  constexpr int kPrefetchQueueSize = 2;
+  auto index_to_path = [this](int image_idx) {
+    return datasets::threedmatch::internal::getPathForDepthImage(
+        base_path_, seq_id, image_idx);
+  };
+  datasets::ImageLoader<DepthImage> single_threaded_loader(index_to_path);
+  datasets::MultiThreadedImageLoader<DepthImage> multi_threaded_loader(
+      index_to_path, kNumThreads, kPrefetchQueueSize);
+
+  DepthImage expected(MemoryType::kUnified);
+  DepthImage loaded(MemoryType::kUnified);
+  while (single_threaded_loader.getNextImage(&expected)) {
+    ASSERT_TRUE(multi_threaded_loader.getNextImage(&loaded));
+    ASSERT_EQ(loaded.rows(), expected.rows());
+    ASSERT_EQ(loaded.cols(), expected.cols());
+    for (int i = 0; i < expected.numel(); i++) {
+      EXPECT_EQ(loaded(i), expected(i));
+    }
+  }
+  EXPECT_FALSE(multi_threaded_loader.getNextImage(&loaded));
+}
 
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
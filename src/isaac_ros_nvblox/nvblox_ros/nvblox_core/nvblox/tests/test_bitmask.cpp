@@ -70,6 +70,36 @@ TEST(BitMask, BooleanAnd) {
   EXPECT_EQ(mask & TestEnum::kBit3, 0);
 }
 
+TEST(FixedSizeBitMask, SetAndClear) {
+  FixedSizeBitMask<100> mask;
+  EXPECT_FALSE(mask.any());
+  mask.set(0);
+  mask.set(33);
+  mask.set(99);
+  EXPECT_TRUE(mask.any());
+  for (int i = 0; i < 100; i++) {
+    EXPECT_EQ(mask.isSet(i), i == 0 || i == 33 || i == 99);
+  }
+  mask.clear();
+  EXPECT_FALSE(mask.any());
+}
+
+TEST(FixedSizeBitMask, SetAllAndOr) {
+  FixedSizeBitMask<100> mask1;
+  FixedSizeBitMask<100> mask2;
+  for (int i = 0; i < 100; i++) {
+    if (i % 2 == 0) {
+      mask1.set(i);
+    } else {
+      mask2.set(i);
+    }
+  }
+  mask1 |= mask2;
+  FixedSizeBitMask<100> mask_all;
+  mask_all.setAll();
+  EXPECT_EQ(mask1, mask_all);
+}
+
 }  // namespace nvblox
 int main(int argc, char** argv) {
   FLAGS_alsologtostderr = true;
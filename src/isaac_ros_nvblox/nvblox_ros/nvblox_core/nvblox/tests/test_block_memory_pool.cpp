@@ -15,6 +15,8 @@ limitations under the License.
 */
 #include <gtest/gtest.h>
 
+#include <vector>
+
 #include "nvblox/map/common_names.h"
 #include "nvblox/map/internal/block_memory_pool.h"
 
@@ -43,6 +45,66 @@ TEST(BlockMemoryPool, pushAndPop) {
   ASSERT_EQ(popped_block.get(), repopped_block.get());
 }
 
+TEST(BlockMemoryPool, slabPopBeyondCapacity) {
+  BlockMemoryPool<TsdfBlock> pool(MemoryType::kDevice, kInitialCapacity,
+                                  BlockAllocationMode::kSlab);
+  EXPECT_EQ(pool.num_allocated_blocks(), static_cast<int>(kInitialCapacity));
+
+  std::vector<TsdfBlock::Ptr> blocks;
+  for (size_t i = 0; i < 2 * kInitialCapacity; ++i) {
+    blocks.push_back(pool.popBlock(CudaStreamOwning()));
+    ASSERT_TRUE(blocks.back() != nullptr);
+    EXPECT_TRUE(blocks.back().is_alias());
+    // The pool is expanded before it runs empty.
+    EXPECT_GT(pool.num_free_blocks(), 0);
+  }
+  EXPECT_GT(pool.num_allocated_blocks(),
+            static_cast<int>(2 * kInitialCapacity));
+}
+
+TEST(BlockMemoryPool, slabBlocksAreInitialized) {
+  CudaStreamOwning cuda_stream;
+  BlockMemoryPool<ColorBlock> pool(MemoryType::kDevice, kInitialCapacity,
+                                   BlockAllocationMode::kSlab);
+  for (size_t i = 0; i < 2 * kInitialCapacity; ++i) {
+    auto block = pool.popBlock(cuda_stream);
+    auto block_host = block.cloneAsync(MemoryType::kHost, cuda_stream);
+    cuda_stream.synchronize();
+    for (auto it = block_host->cbegin(); it != block_host->cend(); ++it) {
+      EXPECT_EQ(Color(it->color), Color::Gray());
+      EXPECT_EQ(static_cast<float>(it->weight), 0.0f);
+    }
+  }
+}
+
+TEST(BlockMemoryPool, slabBlocksOutliveThePool) {
+  TsdfBlock::Ptr block;
+  {
+    BlockMemoryPool<TsdfBlock> pool(MemoryType::kHost, kInitialCapacity,
+                                    BlockAllocationMode::kSlab);
+    block = pool.popBlock(CudaStreamOwning());
+  }
+  // The slab is freed once the last block is gone.
+  block->voxels[0][0][0].weight = 1.0f;
+  EXPECT_EQ(block->voxels[0][0][0].weight, 1.0f);
+}
+
+TEST(BlockMemoryPool, switchAllocationMode) {
+  BlockMemoryPool<TsdfBlock> pool(MemoryType::kHost, 1);
+  auto per_block = pool.popBlock(CudaStreamOwning());
+  EXPECT_FALSE(per_block.is_alias());
+
+  pool.allocation_mode(BlockAllocationMode::kSlab);
+  auto slab_block = pool.popBlock(CudaStreamOwning());
+  EXPECT_TRUE(slab_block.is_alias());
+
+  // Blocks of both kinds are recycled.
+  pool.pushBlock(per_block);
+  pool.pushBlock(slab_block);
+  EXPECT_EQ(pool.popBlock(CudaStreamOwning()).get(), slab_block.get());
+  EXPECT_EQ(pool.popBlock(CudaStreamOwning()).get(), per_block.get());
+}
+
 int main(int argc, char** argv) {
   FLAGS_alsologtostderr = true;
   google::InitGoogleLogging(argv[0]);
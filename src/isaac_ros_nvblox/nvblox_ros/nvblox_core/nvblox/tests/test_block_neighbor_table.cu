@@ -0,0 +1,92 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+
+#include "nvblox/gpu_hash/internal/cuda/block_neighbor_table.cuh"
+#include "nvblox/map/common_names.h"
+#include "nvblox/map/layer.h"
+
+using namespace nvblox;
+
+TEST(BlockNeighborTableTest, OffsetsRoundTrip) {
+  for (int i = 0; i < FullBlockNeighborhood::kNumNeighbors; i++) {
+    const Index3D offset = FullBlockNeighborhood::offsetFromIndex(i);
+    EXPECT_TRUE(FullBlockNeighborhood::isInNeighborhood(offset));
+    EXPECT_EQ(FullBlockNeighborhood::indexFromOffset(offset), i);
+  }
+  EXPECT_EQ(FullBlockNeighborhood::offsetFromIndex(
+                FullBlockNeighborhood::kCenterIndex),
+            Index3D::Zero());
+  EXPECT_FALSE(FullBlockNeighborhood::isInNeighborhood(Index3D(2, 0, 0)));
+  EXPECT_FALSE(FullBlockNeighborhood::isInNeighborhood(Index3D(0, 0, -2)));
+}
+
+TEST(BlockNeighborTableTest, TableMatchesLayer) {
+  // A sparse set of blocks, such that some neighbors are missing.
+  TsdfLayer tsdf_layer(0.1f, MemoryType::kUnified);
+  for (int x = 0; x < 4; x++) {
+    for (int y = 0; y < 4; y++) {
+      if ((x + y) % 3 != 0) {
+        tsdf_layer.allocateBlockAtIndex(Index3D(x, y, 0));
+      }
+    }
+  }
+  const std::vector<Index3D> block_indices = tsdf_layer.getAllBlockIndices();
+  ASSERT_GT(block_indices.size(), 0);
+
+  CudaStreamOwning cuda_stream;
+  device_vector<Index3D> block_indices_device;
+  block_indices_device.copyFromAsync(block_indices, cuda_stream);
+  device_vector<const TsdfBlock*> neighbor_table;
+  buildBlockNeighborTableAsync(
+      block_indices.size(), block_indices_device.data(),
+      tsdf_layer.getGpuLayerView(cuda_stream).getHash().impl_,
+      &neighbor_table, cuda_stream);
+  const std::vector<const TsdfBlock*> neighbor_table_host =
+      neighbor_table.toVectorAsync(cuda_stream);
+  cuda_stream.synchronize();
+
+  ASSERT_EQ(neighbor_table_host.size(),
+            block_indices.size() * FullBlockNeighborhood::kNumNeighbors);
+  int num_missing_neighbors = 0;
+  for (size_t i = 0; i < block_indices.size(); i++) {
+    for (int j = 0; j < FullBlockNeighborhood::kNumNeighbors; j++) {
+      const TsdfBlock* expected_ptr =
+          tsdf_layer
+              .getBlockAtIndex(block_indices[i] +
+                               FullBlockNeighborhood::offsetFromIndex(j))
+              .get();
+      EXPECT_EQ(neighbor_table_host[i * FullBlockNeighborhood::kNumNeighbors +
+                                    j],
+                expected_ptr);
+      if (expected_ptr == nullptr) {
+        ++num_missing_neighbors;
+      }
+    }
+    EXPECT_EQ(neighbor_table_host[i * FullBlockNeighborhood::kNumNeighbors +
+                                  FullBlockNeighborhood::kCenterIndex],
+              tsdf_layer.getBlockAtIndex(block_indices[i]).get());
+  }
+  EXPECT_GT(num_missing_neighbors, 0);
+}
+
+int main(int argc, char** argv) {
+  FLAGS_alsologtostderr = true;
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,173 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+
+#include "nvblox/map/blocks_to_update_tracker.h"
+
+namespace nvblox {
+
+bool contains(const std::vector<Index3D>& indices, const Index3D& idx) {
+  return std::find(indices.begin(), indices.end(), idx) != indices.end();
+}
+
+TEST(BlocksToUpdateTrackerTest, UnchangedBlocksAreNotRemeshed) {
+  BlocksToUpdateTracker tracker(ProjectiveLayerType::kTsdf);
+  const std::vector<Index3D> blocks = {Index3D(0, 0, 0), Index3D(5, 5, 5)};
+  tracker.addBlocksToUpdate(blocks, std::vector<VoxelBlockMask>(2));
+
+  // The blocks still need an update (e.g. for coloring), but no re-meshing.
+  EXPECT_EQ(tracker.getBlocksToUpdate(BlocksToUpdateType::kMesh).size(), 2);
+  EXPECT_TRUE(tracker.getMeshBlocksToRemesh().empty());
+
+  // Blocks added without masks are fully changed.
+  tracker.addBlocksToUpdate({Index3D(1, 1, 1)});
+  const std::vector<Index3D> blocks_to_remesh =
+      tracker.getMeshBlocksToRemesh();
+  EXPECT_TRUE(contains(blocks_to_remesh, Index3D(1, 1, 1)));
+  EXPECT_FALSE(contains(blocks_to_remesh, Index3D(0, 0, 0)));
+  EXPECT_FALSE(contains(blocks_to_remesh, Index3D(5, 5, 5)));
+
+  // Marking as updated clears the changes.
+  tracker.markBlocksAsUpdated(BlocksToUpdateType::kMesh);
+  EXPECT_TRUE(tracker.getMeshBlocksToRemesh().empty());
+}
+
+TEST(BlocksToUpdateTrackerTest, CheckpointBlocks) {
+  BlocksToUpdateTracker tracker(ProjectiveLayerType::kTsdf);
+
+  // Not tracked by default.
+  tracker.addBlocksToUpdate({Index3D(0, 0, 0)});
+  EXPECT_TRUE(tracker.getBlocksToUpdate(BlocksToUpdateType::kCheckpoint)
+                  .empty());
+
+  // Both updated and removed blocks are checkpoint blocks.
+  tracker.trackCheckpointBlocks(true);
+  tracker.addBlocksToUpdate({Index3D(1, 1, 1)});
+  tracker.removeBlocksToUpdate({Index3D(2, 2, 2)});
+  std::vector<Index3D> checkpoint_blocks =
+      tracker.getBlocksToUpdate(BlocksToUpdateType::kCheckpoint);
+  EXPECT_EQ(checkpoint_blocks.size(), 2);
+  EXPECT_TRUE(contains(checkpoint_blocks, Index3D(1, 1, 1)));
+  EXPECT_TRUE(contains(checkpoint_blocks, Index3D(2, 2, 2)));
+  EXPECT_FALSE(contains(tracker.getBlocksToUpdate(BlocksToUpdateType::kEsdf),
+                        Index3D(2, 2, 2)));
+
+  tracker.markBlocksAsUpdated(BlocksToUpdateType::kCheckpoint);
+  EXPECT_TRUE(tracker.getBlocksToUpdate(BlocksToUpdateType::kCheckpoint)
+                  .empty());
+}
+
+TEST(BlocksToUpdateTrackerTest, GroundPlaneBlocks) {
+  BlocksToUpdateTracker tracker(ProjectiveLayerType::kTsdf);
+
+  // Not tracked by default.
+  tracker.addBlocksToUpdate({Index3D(0, 0, 0)});
+  EXPECT_TRUE(tracker.getBlocksToUpdate(BlocksToUpdateType::kGroundPlane)
+                  .empty());
+
+  // Both updated and removed blocks are ground plane blocks.
+  tracker.trackGroundPlaneBlocks(true);
+  tracker.addBlocksToUpdate({Index3D(1, 1, 1)});
+  tracker.removeBlocksToUpdate({Index3D(2, 2, 2)});
+  std::vector<Index3D> ground_plane_blocks =
+      tracker.getBlocksToUpdate(BlocksToUpdateType::kGroundPlane);
+  EXPECT_EQ(ground_plane_blocks.size(), 2);
+  EXPECT_TRUE(contains(ground_plane_blocks, Index3D(1, 1, 1)));
+  EXPECT_TRUE(contains(ground_plane_blocks, Index3D(2, 2, 2)));
+
+  // Independent of the other types.
+  tracker.markBlocksAsUpdated(BlocksToUpdateType::kEsdf);
+  EXPECT_EQ(tracker.getBlocksToUpdate(BlocksToUpdateType::kGroundPlane).size(),
+            2);
+  tracker.markBlocksAsUpdated(BlocksToUpdateType::kGroundPlane);
+  EXPECT_TRUE(tracker.getBlocksToUpdate(BlocksToUpdateType::kGroundPlane)
+                  .empty());
+}
+
+TEST(BlocksToUpdateTrackerTest, MeshColorBlocks) {
+  BlocksToUpdateTracker tracker(ProjectiveLayerType::kTsdf);
+
+  // Geometry updates don't need recoloring on their own.
+  tracker.addBlocksToUpdate({Index3D(0, 0, 0)});
+  EXPECT_TRUE(
+      tracker.getBlocksToUpdate(BlocksToUpdateType::kMeshColor).empty());
+
+  // Color updates only need recoloring.
+  tracker.addColorBlocksToUpdate({Index3D(1, 1, 1), Index3D(2, 2, 2)});
+  std::vector<Index3D> color_blocks =
+      tracker.getBlocksToUpdate(BlocksToUpdateType::kMeshColor);
+  EXPECT_EQ(color_blocks.size(), 2);
+  EXPECT_TRUE(contains(color_blocks, Index3D(1, 1, 1)));
+  EXPECT_FALSE(contains(tracker.getBlocksToUpdate(BlocksToUpdateType::kMesh),
+                        Index3D(1, 1, 1)));
+
+  // Removed blocks no longer need recoloring.
+  tracker.removeBlocksToUpdate({Index3D(2, 2, 2)});
+  color_blocks = tracker.getBlocksToUpdate(BlocksToUpdateType::kMeshColor);
+  EXPECT_EQ(color_blocks.size(), 1);
+  EXPECT_FALSE(contains(color_blocks, Index3D(2, 2, 2)));
+
+  tracker.markBlocksAsUpdated(BlocksToUpdateType::kMeshColor);
+  EXPECT_TRUE(
+      tracker.getBlocksToUpdate(BlocksToUpdateType::kMeshColor).empty());
+}
+
+TEST(BlocksToUpdateTrackerTest, NeighborsOfChangedFaceVoxels) {
+  BlocksToUpdateTracker tracker(ProjectiveLayerType::kTsdf);
+
+  // A voxel in the interior of the block only affects the block itself.
+  VoxelBlockMask interior_mask;
+  interior_mask.set(voxelBlockMaskBit(Index3D(3, 3, 3)));
+  tracker.addBlocksToUpdate({Index3D(0, 0, 0)}, {interior_mask});
+  std::vector<Index3D> blocks_to_remesh = tracker.getMeshBlocksToRemesh();
+  ASSERT_EQ(blocks_to_remesh.size(), 1);
+  EXPECT_EQ(blocks_to_remesh[0], Index3D(0, 0, 0));
+  tracker.markBlocksAsUpdated(BlocksToUpdateType::kMesh);
+
+  // A voxel on the lower x-face and the lower y-face (but not z) affects the
+  // neighbors below in x, y and xy.
+  VoxelBlockMask edge_mask;
+  edge_mask.set(voxelBlockMaskBit(Index3D(0, 0, 3)));
+  tracker.addBlocksToUpdate({Index3D(0, 0, 0)}, {edge_mask});
+  blocks_to_remesh = tracker.getMeshBlocksToRemesh();
+  EXPECT_EQ(blocks_to_remesh.size(), 4);
+  EXPECT_TRUE(contains(blocks_to_remesh, Index3D(0, 0, 0)));
+  EXPECT_TRUE(contains(blocks_to_remesh, Index3D(-1, 0, 0)));
+  EXPECT_TRUE(contains(blocks_to_remesh, Index3D(0, -1, 0)));
+  EXPECT_TRUE(contains(blocks_to_remesh, Index3D(-1, -1, 0)));
+  tracker.markBlocksAsUpdated(BlocksToUpdateType::kMesh);
+
+  // A voxel on the upper faces does not affect any neighbors.
+  VoxelBlockMask upper_mask;
+  upper_mask.set(voxelBlockMaskBit(Index3D(7, 7, 7)));
+  tracker.addBlocksToUpdate({Index3D(0, 0, 0)}, {upper_mask});
+  blocks_to_remesh = tracker.getMeshBlocksToRemesh();
+  EXPECT_EQ(blocks_to_remesh.size(), 1);
+}
+
+}  // namespace nvblox
+
+int main(int argc, char** argv) {
+  FLAGS_alsologtostderr = true;
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -104,6 +104,28 @@ TEST(BoundingSpheresTest, BlocksOutside) {
   EXPECT_EQ(result.size(), 0);
 }
 
+TEST(BoundingSpheresTest, BlocksOutsideOnGpu) {
+  const std::vector<Index3D> cube_indices = get3x3CubeOfBlocks();
+  const CudaStreamOwning cuda_stream;
+  device_vector<Index3D> cube_indices_device;
+  cube_indices_device.copyFromAsync(cube_indices, cuda_stream);
+
+  const Vector3f center(0.5f, 0.5f, 0.5f);
+  for (const float radius : {0.45f, 0.55f, 1.0f, 2.0f}) {
+    device_vector<bool> is_outside_device;
+    flagBlocksOutsideRadiusOnGpuAsync(cube_indices_device, 1.0f, center,
+                                      radius, &is_outside_device, cuda_stream);
+    host_vector<bool> is_outside;
+    is_outside.copyFromAsync(is_outside_device, cuda_stream);
+    cuda_stream.synchronize();
+    ASSERT_EQ(is_outside.size(), cube_indices.size());
+    for (size_t i = 0; i < cube_indices.size(); i++) {
+      EXPECT_EQ(is_outside[i],
+                isBlockOutsideRadius(cube_indices[i], 1.0f, center, radius));
+    }
+  }
+}
+
 int main(int argc, char** argv) {
   FLAGS_alsologtostderr = true;
   google::InitGoogleLogging(argv[0]);
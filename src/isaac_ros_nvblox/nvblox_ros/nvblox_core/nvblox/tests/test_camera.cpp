@@ -381,6 +381,138 @@ TEST(CameraTest, CameraViewport) {
               kFloatEpsilon);
 }
 
+TEST(CameraTest, CroppedCamera) {
+  const Camera camera = getTestCamera();
+  const ImageBoundingBox bbox(Index2D(100, 50), Index2D(219, 149));
+  const Camera cropped_camera = camera.cropped(bbox);
+  EXPECT_EQ(cropped_camera.width(), 120);
+  EXPECT_EQ(cropped_camera.height(), 100);
+
+  // A point projects to the same pixel, shifted by the crop origin.
+  const Vector3f p_C(-1.1f, -0.9f, 2.0f);
+  Vector2f u_C;
+  Vector2f u_cropped_C;
+  ASSERT_TRUE(camera.project(p_C, &u_C));
+  ASSERT_TRUE(cropped_camera.project(p_C, &u_cropped_C));
+  EXPECT_NEAR(u_cropped_C.x(), u_C.x() - bbox.min().x(), kFloatEpsilon);
+  EXPECT_NEAR(u_cropped_C.y(), u_C.y() - bbox.min().y(), kFloatEpsilon);
+}
+
+TEST(CameraTest, DownscaledCamera) {
+  const Camera camera = getTestCamera();
+  constexpr int kFactor = 4;
+  const Camera downscaled_camera = camera.downscaled(kFactor);
+  EXPECT_EQ(downscaled_camera.width(),
+            (camera.width() + kFactor - 1) / kFactor);
+  EXPECT_EQ(downscaled_camera.height(),
+            (camera.height() + kFactor - 1) / kFactor);
+
+  // A point projects into the pixel covering its full resolution pixel.
+  const Vector3f p_C(-1.1f, -0.9f, 2.0f);
+  Vector2f u_C;
+  Vector2f u_downscaled_C;
+  ASSERT_TRUE(camera.project(p_C, &u_C));
+  ASSERT_TRUE(downscaled_camera.project(p_C, &u_downscaled_C));
+  EXPECT_NEAR(u_downscaled_C.x(), u_C.x() / kFactor, kFloatEpsilon);
+  EXPECT_NEAR(u_downscaled_C.y(), u_C.y() / kFactor, kFloatEpsilon);
+}
+
+Camera getTestEquidistantCamera() {
+  // A wide angle lens with a ~130 degree diagonal field of view.
+  constexpr float fu = 350;
+  constexpr float fv = 350;
+  constexpr int width = 640;
+  constexpr int height = 480;
+  constexpr float cu = 321.3f;
+  constexpr float cv = 238.7f;
+  return Camera(fu, fv, cu, cv, width, height,
+                EquidistantDistortion{-0.013f, 0.012f, -0.004f, 0.0005f});
+}
+
+TEST(CameraTest, EquidistantUnProjection) {
+  std::srand(0);
+  const Camera camera = getTestEquidistantCamera();
+  EXPECT_EQ(camera.model(), CameraModel::kEquidistant);
+
+  constexpr int kNumPointsToTest = 1000;
+  for (int i = 0; i < kNumPointsToTest; i++) {
+    auto vector_image_point_pair = getRandomVisibleRayAndImagePoint(camera);
+    const Vector2f u_C_in = vector_image_point_pair.second;
+    const float depth = test_utils::randomFloatInRange(0.1f, 10.0f);
+
+    const Vector3f p_C =
+        camera.unprojectFromImagePlaneCoordinates(u_C_in, depth);
+    EXPECT_NEAR(p_C.z(), depth, kFloatEpsilon);
+
+    Vector2f u_C_out;
+    EXPECT_TRUE(camera.project(p_C, &u_C_out));
+    constexpr float kPixelEpsilon = 1e-2;
+    EXPECT_NEAR(u_C_in.x(), u_C_out.x(), kPixelEpsilon);
+    EXPECT_NEAR(u_C_in.y(), u_C_out.y(), kPixelEpsilon);
+  }
+}
+
+TEST(CameraTest, EquidistantDistortion) {
+  const Camera camera = getTestEquidistantCamera();
+  // The equidistant model images a ray at angle theta at radius
+  // theta_d(theta), rather than tan(theta).
+  const float theta = 1.0f;
+  const Vector2f x_C(std::tan(theta), 0.0f);
+  const EquidistantDistortion& k = camera.distortion();
+  const float theta_d =
+      theta * (1.0f + k.k1 * std::pow(theta, 2) + k.k2 * std::pow(theta, 4) +
+               k.k3 * std::pow(theta, 6) + k.k4 * std::pow(theta, 8));
+  const Vector2f x_d_C = camera.distortNormalizedCoordinates(x_C);
+  EXPECT_NEAR(x_d_C.x(), theta_d, kFloatEpsilon);
+  EXPECT_NEAR(x_d_C.y(), 0.0f, kFloatEpsilon);
+  const Vector2f x_C_out = camera.undistortNormalizedCoordinates(x_d_C);
+  EXPECT_NEAR(x_C_out.x(), x_C.x(), kFloatEpsilon);
+
+  // Pinhole cameras aren't distorted.
+  const Camera pinhole_camera = getTestCamera();
+  EXPECT_EQ(pinhole_camera.model(), CameraModel::kPinhole);
+  EXPECT_TRUE(pinhole_camera.distortNormalizedCoordinates(x_C).isApprox(x_C));
+  EXPECT_FALSE(pinhole_camera.hasSameDistortion(camera));
+}
+
+TEST(CameraTest, EquidistantViewport) {
+  const Camera camera = getTestEquidistantCamera();
+  const CameraViewport viewport = camera.getNormalizedViewport();
+  const Frustum frustum =
+      camera.getViewFrustum(Transform::Identity(), 0.1f, 10.0f);
+
+  // All pixels are in the viewport and the frustum.
+  for (int row = 0; row < camera.rows(); row += 8) {
+    for (int col = 0; col < camera.cols(); col += 8) {
+      const Vector3f ray_C = camera.vectorFromPixelIndices(Index2D(col, row));
+      EXPECT_TRUE(viewport.contains(ray_C.head<2>()));
+      EXPECT_TRUE(frustum.isPointInView(5.0f * ray_C));
+    }
+  }
+  // The field of view is wider than the one of a pinhole camera with the same
+  // intrinsics.
+  const CameraViewport pinhole_viewport =
+      getTestCamera().getNormalizedViewport();
+  EXPECT_GT(viewport.max().x(), pinhole_viewport.max().x());
+}
+
+TEST(CameraTest, EquidistantCroppedAndDownscaledCamera) {
+  const Camera camera = getTestEquidistantCamera();
+  const Camera cropped_camera =
+      camera.cropped(ImageBoundingBox(Index2D(100, 50), Index2D(219, 149)));
+  const Camera downscaled_camera = camera.downscaled(2);
+  EXPECT_TRUE(cropped_camera.hasSameDistortion(camera));
+  EXPECT_TRUE(downscaled_camera.hasSameDistortion(camera));
+
+  const Vector3f p_C(-0.3f, -0.2f, 2.0f);
+  Vector2f u_C;
+  Vector2f u_downscaled_C;
+  ASSERT_TRUE(camera.project(p_C, &u_C));
+  ASSERT_TRUE(downscaled_camera.project(p_C, &u_downscaled_C));
+  EXPECT_NEAR(u_downscaled_C.x(), u_C.x() / 2, kFloatEpsilon);
+  EXPECT_NEAR(u_downscaled_C.y(), u_C.y() / 2, kFloatEpsilon);
+}
+
 int main(int argc, char** argv) {
   FLAGS_alsologtostderr = true;
   google::InitGoogleLogging(argv[0]);
@@ -0,0 +1,136 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "nvblox/core/cuda_stream.h"
+#include "nvblox/sensors/camera.h"
+#include "nvblox/sensors/internal/camera_ray_cache.h"
+
+using namespace nvblox;
+
+constexpr float kFloatEpsilon = 1e-5;
+
+std::vector<Vector3f> toStdVector(const RayTable& rays,
+                                  const CudaStream& cuda_stream) {
+  std::vector<Vector3f> output = rays.toVectorAsync(cuda_stream);
+  cuda_stream.synchronize();
+  return output;
+}
+
+TEST(CameraRayCacheTest, RaysMatchCamera) {
+  const Camera camera(300.0f, 310.0f, 160.0f, 118.0f, 320, 240);
+  CudaStreamOwning cuda_stream;
+  CameraRayCache cache;
+
+  // Full resolution, unit depth rays are those of vectorFromPixelIndices().
+  const std::vector<Vector3f> pixel_rays = toStdVector(
+      *cache.getRays(camera, 1, RayNormalization::kUnitDepth, cuda_stream),
+      cuda_stream);
+  ASSERT_EQ(pixel_rays.size(), camera.rows() * camera.cols());
+  for (int row = 0; row < camera.rows(); row++) {
+    for (int col = 0; col < camera.cols(); col++) {
+      const Vector3f expected =
+          camera.vectorFromPixelIndices(Index2D(col, row));
+      const Vector3f& ray = pixel_rays[row * camera.cols() + col];
+      EXPECT_NEAR((ray - expected).norm(), 0.0f, kFloatEpsilon);
+    }
+  }
+
+  // Subsampled unit length rays pass through the patch centers.
+  constexpr int kSubsamplingFactor = 4;
+  const std::vector<Vector3f> patch_rays =
+      toStdVector(*cache.getRays(camera, kSubsamplingFactor,
+                                 RayNormalization::kUnitLength, cuda_stream),
+                  cuda_stream);
+  const int rows = camera.rows() / kSubsamplingFactor;
+  const int cols = camera.cols() / kSubsamplingFactor;
+  ASSERT_EQ(patch_rays.size(), rows * cols);
+  for (int row = 0; row < rows; row++) {
+    for (int col = 0; col < cols; col++) {
+      const Vector2f u_C(col * kSubsamplingFactor + kSubsamplingFactor / 2,
+                         row * kSubsamplingFactor + kSubsamplingFactor / 2);
+      const Vector3f expected =
+          camera.vectorFromImagePlaneCoordinates(u_C).normalized();
+      const Vector3f& ray = patch_rays[row * cols + col];
+      EXPECT_NEAR(ray.norm(), 1.0f, kFloatEpsilon);
+      EXPECT_NEAR((ray - expected).norm(), 0.0f, kFloatEpsilon);
+    }
+  }
+}
+
+TEST(CameraRayCacheTest, TablesAreReused) {
+  const Camera camera(300.0f, 300.0f, 160.0f, 120.0f, 320, 240);
+  CudaStreamOwning cuda_stream;
+  CameraRayCache cache;
+
+  const auto rays_1 =
+      cache.getRays(camera, 1, RayNormalization::kUnitDepth, cuda_stream);
+  const auto rays_2 =
+      cache.getRays(camera, 1, RayNormalization::kUnitDepth, cuda_stream);
+  EXPECT_EQ(rays_1.get(), rays_2.get());
+  EXPECT_EQ(cache.size(), 1);
+
+  // Any change to the request gives a new table.
+  const auto rays_3 =
+      cache.getRays(camera, 2, RayNormalization::kUnitDepth, cuda_stream);
+  const auto rays_4 =
+      cache.getRays(camera, 1, RayNormalization::kUnitLength, cuda_stream);
+  const auto rays_5 =
+      cache.getRays(Camera(301.0f, 300.0f, 160.0f, 120.0f, 320, 240), 1,
+                    RayNormalization::kUnitDepth, cuda_stream);
+  EXPECT_NE(rays_1.get(), rays_3.get());
+  EXPECT_NE(rays_1.get(), rays_4.get());
+  EXPECT_NE(rays_1.get(), rays_5.get());
+  EXPECT_EQ(cache.size(), 4);
+}
+
+TEST(CameraRayCacheTest, LeastRecentlyUsedIsEvicted) {
+  CudaStreamOwning cuda_stream;
+  CameraRayCache cache;
+  const Camera first_camera(300.0f, 300.0f, 8.0f, 8.0f, 16, 16);
+  const auto first_rays = cache.getRays(first_camera, 1,
+                                        RayNormalization::kUnitDepth,
+                                        cuda_stream);
+  for (int i = 1; i <= CameraRayCache::kMaxNumTables; i++) {
+    // Keep using the first camera, such that others are evicted.
+    cache.getRays(first_camera, 1, RayNormalization::kUnitDepth, cuda_stream);
+    cache.getRays(Camera(300.0f + i, 300.0f, 8.0f, 8.0f, 16, 16), 1,
+                  RayNormalization::kUnitDepth, cuda_stream);
+    EXPECT_LE(cache.size(), CameraRayCache::kMaxNumTables);
+  }
+  EXPECT_EQ(cache.size(), CameraRayCache::kMaxNumTables);
+  EXPECT_EQ(
+      cache.getRays(first_camera, 1, RayNormalization::kUnitDepth, cuda_stream)
+          .get(),
+      first_rays.get());
+
+  // Evicted tables stay valid while held.
+  const std::vector<Vector3f> rays = toStdVector(*first_rays, cuda_stream);
+  EXPECT_EQ(rays.size(), 16 * 16);
+  cache.clear();
+  EXPECT_EQ(cache.size(), 0);
+  EXPECT_EQ(toStdVector(*first_rays, cuda_stream).size(), 16 * 16);
+}
+
+int main(int argc, char** argv) {
+  FLAGS_alsologtostderr = true;
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -89,6 +89,7 @@ class TestProjectiveColorIntegratorGPU : public ProjectiveColorIntegrator {
  public:
   TestProjectiveColorIntegratorGPU() : ProjectiveColorIntegrator() {}
   FRIEND_TEST(ColorIntegrationTest, TruncationBandTest);
+  FRIEND_TEST(ColorIntegrationTest, SurfaceOnlyAllocation);
 };
 
 bool colorsEqualIgnoreAlpha(const Color& color_1, const Color& color_2) {
@@ -168,6 +169,10 @@ TEST_F(ColorIntegrationTest, GettersAndSetters) {
       WeightingFunctionType::kInverseSquareWeight);
   EXPECT_EQ(color_integrator.weighting_function_type(),
             WeightingFunctionType::kInverseSquareWeight);
+  color_integrator.surface_only_allocation(true);
+  EXPECT_TRUE(color_integrator.surface_only_allocation());
+  color_integrator.reuse_depth_frame(true);
+  EXPECT_TRUE(color_integrator.reuse_depth_frame());
 }
 
 TEST_F(ColorIntegrationTest, TruncationBandTest) {
@@ -222,6 +227,44 @@ TEST_F(ColorIntegrationTest, TruncationBandTest) {
   }
 }
 
+TEST_F(ColorIntegrationTest, SurfaceOnlyAllocation) {
+  TestProjectiveColorIntegratorGPU integrator;
+  constexpr float kTestDistance = voxel_size_m_;
+
+  // A freshly allocated TSDF block is unobserved, and all its voxels have zero
+  // distance.
+  TsdfLayer tsdf_layer(voxel_size_m_, MemoryType::kUnified);
+  const Index3D unobserved_block_index(0, 0, 0);
+  tsdf_layer.allocateBlockAtIndex(unobserved_block_index);
+  // An observed block with a single voxel on the surface.
+  const Index3D observed_block_index(1, 0, 0);
+  auto observed_block = tsdf_layer.allocateBlockAtIndex(observed_block_index);
+  for (int x = 0; x < TsdfBlock::kVoxelsPerSide; x++) {
+    for (int y = 0; y < TsdfBlock::kVoxelsPerSide; y++) {
+      for (int z = 0; z < TsdfBlock::kVoxelsPerSide; z++) {
+        observed_block->voxels[x][y][z].distance = 10.0f * kTestDistance;
+        observed_block->voxels[x][y][z].weight = 1.0f;
+      }
+    }
+  }
+  observed_block->voxels[0][0][0].distance = 0.0f;
+
+  const std::vector<Index3D> block_indices = {unobserved_block_index,
+                                              observed_block_index};
+  EXPECT_EQ(integrator
+                .reduceBlocksToThoseInTruncationBand(block_indices, tsdf_layer,
+                                                     kTestDistance)
+                .size(),
+            2);
+
+  integrator.surface_only_allocation(true);
+  const std::vector<Index3D> surface_indices =
+      integrator.reduceBlocksToThoseInTruncationBand(block_indices, tsdf_layer,
+                                                     kTestDistance);
+  ASSERT_EQ(surface_indices.size(), 1);
+  EXPECT_EQ(surface_indices[0], observed_block_index);
+}
+
 TEST_F(ColorIntegrationTest, IntegrateColorToGroundTruthDistanceField) {
   // Create an integrator.
   ProjectiveColorIntegrator color_integrator;
@@ -502,6 +545,75 @@ TEST_F(ColorIntegrationTest, OcclusionTesting) {
   }
 }
 
+TEST_F(ColorIntegrationTest, OcclusionTestingWithDepthFrame) {
+  primitives::Scene scene_3;
+
+  // Scene: Two spheres, one occluded by the other.
+  scene_3.aabb() = AxisAlignedBoundingBox(Vector3f(-5.0f, -5.0f, -5.0f),
+                                          Vector3f(15.0f, 15.0f, 5.0f));
+  constexpr float kSphereRadiusTest = 2.0f;
+
+  const Vector3f center_1(5.0f, 0.0f, 0.0f);
+  const Vector3f center_2(10.0f, 0.0f, 0.0f);
+
+  scene_3.addPrimitive(
+      std::make_unique<primitives::Sphere>(center_1, kSphereRadiusTest));
+  scene_3.addPrimitive(
+      std::make_unique<primitives::Sphere>(center_2, kSphereRadiusTest));
+  scene_3.generateLayerFromScene(truncation_distance_m_, &gt_layer_);
+
+  // Viewpoint
+  Transform T_S_C = Transform::Identity();
+  T_S_C.prerotate(
+      Eigen::Quaternionf(Eigen::AngleAxisf(M_PI / 2, Vector3f::UnitY())));
+
+  // The depth frame integrated from the same viewpoint, at half the color
+  // resolution.
+  constexpr int kDepthSubsampling = 2;
+  const Camera depth_camera(fu_ / kDepthSubsampling, fv_ / kDepthSubsampling,
+                            cu_ / kDepthSubsampling, cv_ / kDepthSubsampling,
+                            width_ / kDepthSubsampling,
+                            height_ / kDepthSubsampling);
+  constexpr float kMaxProjectionDist = 20.0f;
+  DepthImage depth_frame(depth_camera.height(), depth_camera.width(),
+                         MemoryType::kUnified);
+  scene_3.generateDepthImageFromScene(depth_camera, T_S_C, kMaxProjectionDist,
+                                      &depth_frame);
+
+  // Integrate a color image, using the depth frame instead of sphere tracing.
+  ProjectiveColorIntegrator color_integrator;
+  ColorLayer color_layer(voxel_size_m_, MemoryType::kDevice);
+
+  const auto color_1 = Color::Red();
+  const auto image_1 = generateSolidColorImage(color_1, height_, width_);
+
+  std::vector<Index3D> updated_blocks;
+  color_integrator.integrateFrame(image_1, depth_frame, T_S_C, camera_,
+                                  gt_layer_, gt_layer_.getAllBlockIndices(),
+                                  &color_layer, &updated_blocks);
+  EXPECT_GT(updated_blocks.size(), 0);
+
+  ColorLayer color_layer_host(voxel_size_m_, MemoryType::kHost);
+  color_layer_host.copyFrom(color_layer);
+
+  // Check front sphere (observed voxels red)
+  const float sphere_1_observed_ratio =
+      checkSphereColor(color_layer_host, center_1, kSphereRadius, color_1);
+  EXPECT_GT(sphere_1_observed_ratio, 0.2);
+
+  // Check back sphere (no observed voxels)
+  const std::vector<Eigen::Vector3f> sphere_points =
+      getPointsOnASphere(kSphereRadius, center_2);
+  for (const Vector3f& p : sphere_points) {
+    const ColorVoxel* color_voxel;
+    const bool block_allocated =
+        getVoxelAtPosition<ColorVoxel>(color_layer_host, p, &color_voxel);
+    if (block_allocated) {
+      EXPECT_EQ(color_voxel->weight, 0.0f);
+    }
+  }
+}
+
 TEST_F(ColorIntegrationTest, WeightingFunction) {
   // Integrator
   ProjectiveColorIntegrator integrator;
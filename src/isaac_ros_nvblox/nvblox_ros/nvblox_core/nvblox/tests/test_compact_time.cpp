@@ -0,0 +1,86 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include "nvblox/core/compact_time.h"
+#include "nvblox/map/voxels.h"
+
+namespace nvblox {
+
+TEST(CompactTimestamp, ElapsedTime) {
+  // A realistic (epoch based) timestamp, which doesn't fit into 32 bits.
+  const Time start_time_ms(1'700'000'000'000);
+  const CompactTimestamp timestamp(start_time_ms);
+  EXPECT_EQ(timestamp.elapsedSince(start_time_ms), Time(0));
+  EXPECT_EQ(timestamp.elapsedSince(start_time_ms + Time(1234)), Time(1234));
+  EXPECT_EQ(timestamp, start_time_ms);
+  EXPECT_NE(timestamp, start_time_ms + Time(1));
+}
+
+TEST(CompactTimestamp, ElapsedTimeAcrossWrap) {
+  // The lower 32 bits wrap between the timestamp and the current time.
+  const Time wrap_time_ms(int64_t(1) << 40);
+  const CompactTimestamp timestamp(wrap_time_ms - Time(100));
+  EXPECT_EQ(timestamp.elapsedSince(wrap_time_ms + Time(50)), Time(150));
+}
+
+TEST(CompactTimestamp, ZeroIsReserved) {
+  EXPECT_EQ(CompactTimestamp(Time(0)).raw(), 0u);
+  EXPECT_EQ(CompactTimestamp(Time(0)), Time(0));
+  // Other times with zero lower bits are not mistaken for zero.
+  const Time wrap_time_ms(int64_t(1) << 32);
+  const CompactTimestamp timestamp(wrap_time_ms);
+  EXPECT_NE(timestamp, Time(0));
+  EXPECT_EQ(timestamp.raw(), 1u);
+}
+
+TEST(CompactDuration, Saturates) {
+  CompactDuration duration(Time(1000));
+  EXPECT_EQ(static_cast<Time>(duration), Time(1000));
+  duration += Time(500);
+  EXPECT_EQ(static_cast<Time>(duration), Time(1500));
+  EXPECT_TRUE(duration >= Time(1500));
+  EXPECT_TRUE(duration < Time(1501));
+  duration += Time(CompactDuration::kMaxValue);
+  EXPECT_EQ(static_cast<Time>(duration), Time(CompactDuration::kMaxValue));
+  duration = Time(-10);
+  EXPECT_EQ(static_cast<Time>(duration), Time(0));
+}
+
+TEST(CompactTime, FreespaceVoxelSize) {
+#ifdef NVBLOX_COMPACT_FREESPACE_VOXEL
+  EXPECT_EQ(sizeof(FreespaceVoxel), 8);
+#else
+  EXPECT_EQ(sizeof(FreespaceVoxel), 24);
+#endif
+  FreespaceVoxel voxel;
+  EXPECT_EQ(voxel.last_occupied_timestamp_ms, Time(0));
+  EXPECT_FALSE(voxel.is_high_confidence_freespace);
+  voxel.last_occupied_timestamp_ms = Time(2000);
+  EXPECT_EQ(voxel.timeSinceLastOccupied(Time(2500)), Time(500));
+}
+
+}  // namespace nvblox
+
+int main(int argc, char** argv) {
+  FLAGS_alsologtostderr = true;
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
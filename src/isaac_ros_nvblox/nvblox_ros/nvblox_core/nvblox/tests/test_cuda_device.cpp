@@ -0,0 +1,117 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+
+#include "nvblox/core/cuda_device.h"
+#include "nvblox/map/common_names.h"
+#include "nvblox/map/layer.h"
+#include "nvblox/mapper/multi_mapper.h"
+
+using namespace nvblox;
+
+TEST(CudaDeviceTest, ScopedDeviceRestoresDevice) {
+  const int device = getCurrentCudaDevice();
+  const int other_device = getNumCudaDevices() - 1;
+  {
+    ScopedCudaDevice scoped_device(other_device);
+    EXPECT_EQ(getCurrentCudaDevice(), other_device);
+    // Nesting
+    {
+      ScopedCudaDevice nested_scoped_device(device);
+      EXPECT_EQ(getCurrentCudaDevice(), device);
+    }
+    EXPECT_EQ(getCurrentCudaDevice(), other_device);
+  }
+  EXPECT_EQ(getCurrentCudaDevice(), device);
+}
+
+TEST(CudaDeviceTest, PeerAccessToSelf) {
+  const int device = getCurrentCudaDevice();
+  EXPECT_TRUE(enablePeerAccess(device, device));
+}
+
+void setDistances(TsdfLayer* layer, const Index3D& block_index,
+                  float distance) {
+  auto block = layer->allocateBlockAtIndex(block_index);
+  for (int x = 0; x < TsdfBlock::kVoxelsPerSide; x++) {
+    for (int y = 0; y < TsdfBlock::kVoxelsPerSide; y++) {
+      for (int z = 0; z < TsdfBlock::kVoxelsPerSide; z++) {
+        block->voxels[x][y][z].distance = distance;
+      }
+    }
+  }
+}
+
+void testCopyBlocks(int source_device) {
+  constexpr float kVoxelSize = 0.1f;
+  std::unique_ptr<TsdfLayer> source_layer;
+  {
+    ScopedCudaDevice scoped_device(source_device);
+    source_layer =
+        std::make_unique<TsdfLayer>(kVoxelSize, MemoryType::kUnified);
+    setDistances(source_layer.get(), Index3D(0, 0, 0), 1.0f);
+    setDistances(source_layer.get(), Index3D(1, 0, 0), 2.0f);
+  }
+
+  TsdfLayer layer(kVoxelSize, MemoryType::kUnified);
+  setDistances(&layer, Index3D(0, 0, 0), -1.0f);
+  setDistances(&layer, Index3D(2, 0, 0), -2.0f);
+
+  // Copy an existing, a new and a missing block.
+  CudaStreamOwning cuda_stream;
+  layer.copyBlocksFromAsync(
+      *source_layer, {Index3D(0, 0, 0), Index3D(1, 0, 0), Index3D(3, 0, 0)},
+      cuda_stream);
+  cuda_stream.synchronize();
+
+  EXPECT_EQ(layer.numAllocatedBlocks(), 3);
+  EXPECT_FALSE(layer.isBlockAllocated(Index3D(3, 0, 0)));
+  EXPECT_EQ(layer.getBlockAtIndex(Index3D(0, 0, 0))->voxels[1][2][3].distance,
+            1.0f);
+  EXPECT_EQ(layer.getBlockAtIndex(Index3D(1, 0, 0))->voxels[1][2][3].distance,
+            2.0f);
+  EXPECT_EQ(layer.getBlockAtIndex(Index3D(2, 0, 0))->voxels[1][2][3].distance,
+            -2.0f);
+}
+
+TEST(CudaDeviceTest, CopyBlocks) { testCopyBlocks(getCurrentCudaDevice()); }
+
+TEST(CudaDeviceTest, CopyBlocksAcrossDevices) {
+  if (getNumCudaDevices() < 2) {
+    GTEST_SKIP() << "Requires two CUDA devices.";
+  }
+  enablePeerAccess(0, 1);
+  testCopyBlocks(1);
+}
+
+TEST(CudaDeviceTest, MultiMapperForegroundOnOtherDevice) {
+  const int foreground_device = getNumCudaDevices() - 1;
+  MultiMapper multi_mapper(0.05f, MappingType::kDynamic, EsdfMode::k2D,
+                           MemoryType::kDevice,
+                           std::make_shared<CudaStreamOwning>(),
+                           foreground_device);
+  EXPECT_EQ(multi_mapper.foreground_cuda_device(), foreground_device);
+  // The primary device is unchanged.
+  EXPECT_EQ(getCurrentCudaDevice(), 0);
+}
+
+int main(int argc, char** argv) {
+  FLAGS_alsologtostderr = true;
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
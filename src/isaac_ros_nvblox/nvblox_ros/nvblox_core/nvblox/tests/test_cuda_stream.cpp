@@ -57,6 +57,31 @@ TEST(CudaStreamTest, OwningStreamTest) {
   // with the CUDA runtime API.
 }
 
+TEST(CudaStreamTest, PriorityStreamTest) {
+  int least_priority, greatest_priority;
+  checkCudaErrors(
+      cudaDeviceGetStreamPriorityRange(&least_priority, &greatest_priority));
+
+  auto high_priority = CudaStream::createCudaStream(
+      CudaStreamType::kNonBlocking, CudaStreamPriority::kHigh);
+  auto low_priority = CudaStream::createCudaStream(CudaStreamType::kBlocking,
+                                                   CudaStreamPriority::kLow);
+  CudaStreamOwning default_priority;
+
+  int priority;
+  checkCudaErrors(cudaStreamGetPriority(*high_priority, &priority));
+  EXPECT_EQ(priority, greatest_priority);
+  checkCudaErrors(cudaStreamGetPriority(*low_priority, &priority));
+  EXPECT_EQ(priority, least_priority);
+  checkCudaErrors(cudaStreamGetPriority(default_priority, &priority));
+  EXPECT_EQ(priority, 0);
+
+  auto int_ptr = make_unified<int>(MemoryType::kUnified, 0);
+  test_utils::incrementOnStream(int_ptr.get(), high_priority.get());
+  test_utils::incrementOnStream(int_ptr.get(), low_priority.get());
+  EXPECT_EQ(*int_ptr, 2);
+}
+
 TEST(CudaStreamTest, NonOwningStreamTest) {
   // Setting up a raw CUDA stream
   cudaStream_t raw_cuda_stream;
@@ -0,0 +1,193 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+#include "nvblox/utils/logging.h"
+
+#include "nvblox/integrators/dense_esdf_slice_integrator.h"
+#include "nvblox/integrators/esdf_integrator.h"
+#include "nvblox/integrators/esdf_slicer.h"
+#include "nvblox/map/accessors.h"
+#include "nvblox/map/common_names.h"
+#include "nvblox/primitives/scene.h"
+#include "nvblox/tests/utils.h"
+
+using namespace nvblox;
+
+constexpr float kVoxelSizeM = 0.05f;
+constexpr float kUnobservedValue = -1000.0f;
+
+class DenseEsdfSliceIntegratorTest : public ::testing::Test {
+ protected:
+  DenseEsdfSliceIntegratorTest()
+      : tsdf_layer_(kVoxelSizeM, MemoryType::kUnified) {
+    integrator_.esdf_slice_min_height(0.0f);
+    integrator_.esdf_slice_max_height(0.3f);
+  }
+
+  // Allocates a block with all voxels observed and free.
+  TsdfBlock* allocateFreeBlock(const Index3D& block_index) {
+    TsdfBlock* block_ptr = tsdf_layer_.allocateBlockAtIndex(block_index).get();
+    callFunctionOnAllVoxels<TsdfVoxel>(
+        block_ptr, [](const Index3D&, TsdfVoxel* voxel) {
+          voxel->distance = 1.0f;
+          voxel->weight = 1.0f;
+        });
+    return block_ptr;
+  }
+
+  DenseEsdfSliceIntegrator integrator_;
+  TsdfLayer tsdf_layer_;
+};
+
+TEST_F(DenseEsdfSliceIntegratorTest, ExactDistanceToObstacles) {
+  // A 4x4 block (32x32 voxel) patch of freespace with two obstacle columns.
+  constexpr int kNumBlocksPerSide = 4;
+  for (int x = 0; x < kNumBlocksPerSide; x++) {
+    for (int y = 0; y < kNumBlocksPerSide; y++) {
+      allocateFreeBlock(Index3D(x, y, 0));
+    }
+  }
+  const std::vector<Index2D> obstacles = {Index2D(3, 5), Index2D(20, 27)};
+  for (const Index2D& obstacle : obstacles) {
+    constexpr int kVoxelsPerSide = TsdfBlock::kVoxelsPerSide;
+    TsdfBlock::Ptr block_ptr = tsdf_layer_.getBlockAtIndex(
+        Index3D(obstacle.x() / kVoxelsPerSide, obstacle.y() / kVoxelsPerSide,
+                0));
+    // Only a single voxel in the height range is an obstacle.
+    block_ptr
+        ->voxels[obstacle.x() % kVoxelsPerSide][obstacle.y() % kVoxelsPerSide]
+                [2]
+        .distance = -0.01f;
+  }
+  // An obstacle above the slice is ignored.
+  tsdf_layer_.getBlockAtIndex(Index3D(0, 0, 0))->voxels[0][0][7].distance =
+      -0.01f;
+
+  const AxisAlignedBoundingBox aabb =
+      integrator_.getAabbOfLayerInSlice(tsdf_layer_);
+  Image<float> slice_image(MemoryType::kDevice);
+  integrator_.integrateSlice(tsdf_layer_, aabb, kUnobservedValue,
+                             &slice_image);
+  constexpr int kNumVoxelsPerSide =
+      kNumBlocksPerSide * TsdfBlock::kVoxelsPerSide;
+  ASSERT_EQ(slice_image.rows(), kNumVoxelsPerSide);
+  ASSERT_EQ(slice_image.cols(), kNumVoxelsPerSide);
+
+  Image<float> slice_image_host(MemoryType::kHost);
+  slice_image_host.copyFrom(slice_image);
+  for (int row = 0; row < kNumVoxelsPerSide; row++) {
+    for (int col = 0; col < kNumVoxelsPerSide; col++) {
+      float expected_distance = integrator_.max_esdf_distance_m();
+      for (const Index2D& obstacle : obstacles) {
+        const float distance =
+            kVoxelSizeM *
+            Vector2f(static_cast<float>(col - obstacle.x()),
+                     static_cast<float>(row - obstacle.y()))
+                .norm();
+        expected_distance = std::min(expected_distance, distance);
+      }
+      EXPECT_NEAR(slice_image_host(row, col), expected_distance, 1e-4)
+          << "row: " << row << " col: " << col;
+    }
+  }
+}
+
+TEST_F(DenseEsdfSliceIntegratorTest, UnobservedColumns) {
+  allocateFreeBlock(Index3D(0, 0, 0));
+  allocateFreeBlock(Index3D(2, 0, 0));
+  // An allocated block with zero weight.
+  tsdf_layer_.allocateBlockAtIndex(Index3D(1, 0, 0));
+
+  const AxisAlignedBoundingBox aabb =
+      integrator_.getAabbOfLayerInSlice(tsdf_layer_);
+  Image<float> slice_image(MemoryType::kUnified);
+  integrator_.integrateSlice(tsdf_layer_, aabb, kUnobservedValue,
+                             &slice_image);
+  constexpr int kVoxelsPerSide = TsdfBlock::kVoxelsPerSide;
+  ASSERT_EQ(slice_image.rows(), kVoxelsPerSide);
+  ASSERT_EQ(slice_image.cols(), 3 * kVoxelsPerSide);
+  for (int row = 0; row < slice_image.rows(); row++) {
+    for (int col = 0; col < slice_image.cols(); col++) {
+      const bool observed = (col / kVoxelsPerSide) != 1;
+      // Without obstacles, observed pixels are at the maximum distance.
+      EXPECT_EQ(slice_image(row, col), observed
+                                           ? integrator_.max_esdf_distance_m()
+                                           : kUnobservedValue);
+    }
+  }
+}
+
+TEST_F(DenseEsdfSliceIntegratorTest, MatchesBlockSparseSlice) {
+  // A sphere in a box.
+  primitives::Scene scene;
+  scene.aabb() = AxisAlignedBoundingBox(Vector3f(-4.0f, -4.0f, -1.0f),
+                                        Vector3f(4.0f, 4.0f, 2.0f));
+  scene.addGroundLevel(-0.5f);
+  scene.addPrimitive(std::make_unique<primitives::Sphere>(
+      Vector3f(0.5f, -0.5f, 0.0f), 1.0f));
+  scene.addPlaneBoundaries(-3.0f, 3.0f, -3.0f, 3.0f);
+  constexpr float kTruncationDistanceM = 4 * kVoxelSizeM;
+  scene.generateLayerFromScene(kTruncationDistanceM, &tsdf_layer_);
+
+  // Reference: the 2D ESDF through the ESDF layer.
+  EsdfIntegrator esdf_integrator;
+  esdf_integrator.esdf_slice_min_height(integrator_.esdf_slice_min_height());
+  esdf_integrator.esdf_slice_max_height(integrator_.esdf_slice_max_height());
+  esdf_integrator.esdf_slice_height(integrator_.esdf_slice_min_height());
+  EsdfLayer esdf_layer(kVoxelSizeM, MemoryType::kUnified);
+  esdf_integrator.integrateSlice(tsdf_layer_, tsdf_layer_.getAllBlockIndices(),
+                                 &esdf_layer);
+  const AxisAlignedBoundingBox aabb =
+      integrator_.getAabbOfLayerInSlice(tsdf_layer_);
+  EsdfSlicer esdf_slicer;
+  Image<float> reference_image(MemoryType::kUnified);
+  esdf_slicer.sliceLayerToDistanceImage(esdf_layer,
+                                        esdf_integrator.esdf_slice_height(),
+                                        kUnobservedValue, aabb,
+                                        &reference_image);
+
+  Image<float> slice_image(MemoryType::kUnified);
+  integrator_.integrateSlice(tsdf_layer_, aabb, kUnobservedValue,
+                             &slice_image);
+  ASSERT_EQ(slice_image.rows(), reference_image.rows());
+  ASSERT_EQ(slice_image.cols(), reference_image.cols());
+
+  int num_compared = 0;
+  int num_matching = 0;
+  for (int row = 0; row < slice_image.rows(); row++) {
+    for (int col = 0; col < slice_image.cols(); col++) {
+      const float reference = reference_image(row, col);
+      const float distance = slice_image(row, col);
+      if (reference > 0.0f &&
+          reference < esdf_integrator.max_esdf_distance_m()) {
+        ++num_compared;
+        if (std::abs(reference - distance) <= kVoxelSizeM) {
+          ++num_matching;
+        }
+      }
+    }
+  }
+  EXPECT_GT(num_compared, 0);
+  EXPECT_GT(static_cast<float>(num_matching) / num_compared, 0.99f);
+}
+
+int main(int argc, char** argv) {
+  FLAGS_alsologtostderr = true;
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,175 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+
+#include "nvblox/mapper/depth_change_gate.h"
+#include "nvblox/mapper/mapper.h"
+#include "nvblox/primitives/scene.h"
+#include "nvblox/tests/utils.h"
+
+using namespace nvblox;
+
+class DepthChangeGateTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    // A camera looking at a wall 2m in front.
+    depth_frame_ = DepthImage(kHeight, kWidth, MemoryType::kUnified);
+    for (int row = 0; row < kHeight; row++) {
+      for (int col = 0; col < kWidth; col++) {
+        depth_frame_(row, col) = kWallDepthM;
+      }
+    }
+    T_L_C_ = Transform::Identity();
+  }
+
+  // Counts the valid pixels of the gated frame, in the columns [col_begin,
+  // col_end).
+  int numValidGatedPixels(const DepthChangeGate& gate, int col_begin,
+                          int col_end) {
+    DepthImage gated_depth(MemoryType::kUnified);
+    gated_depth.copyFrom(gate.gated_depth());
+    int num_valid_pixels = 0;
+    for (int row = 0; row < kHeight; row++) {
+      for (int col = col_begin; col < col_end; col++) {
+        num_valid_pixels += gated_depth(row, col) > 0.0f;
+      }
+    }
+    return num_valid_pixels;
+  }
+
+  static constexpr int kWidth = 64;
+  static constexpr int kHeight = 48;
+  static constexpr float kWallDepthM = 2.0f;
+  static constexpr float kVoxelSizeM = 0.05f;
+  const Camera camera_{50.0f,         50.0f,  kWidth / 2.0f,
+                       kHeight / 2.0f, kWidth, kHeight};
+  DepthImage depth_frame_{MemoryType::kUnified};
+  Transform T_L_C_;
+  std::shared_ptr<CudaStream> cuda_stream_ =
+      std::make_shared<CudaStreamOwning>();
+};
+
+TEST_F(DepthChangeGateTest, GateUnchangedPixels) {
+  // The reconstruction of the wall.
+  constexpr float kTruncationDistanceM = 4.0f * kVoxelSizeM;
+  primitives::Scene scene;
+  scene.aabb() = AxisAlignedBoundingBox(Vector3f(-3.0f, -3.0f, -1.0f),
+                                        Vector3f(3.0f, 3.0f, 3.0f));
+  scene.addPrimitive(std::make_unique<primitives::Plane>(
+      Vector3f(0.0f, 0.0f, kWallDepthM), Vector3f(0.0f, 0.0f, -1.0f)));
+  TsdfLayer tsdf_layer(kVoxelSizeM, MemoryType::kUnified);
+  scene.generateLayerFromScene(kTruncationDistanceM, &tsdf_layer);
+
+  DepthChangeGate gate(cuda_stream_);
+  gate.full_frame_period(3);
+  gate.min_residual_m(2.0f * kVoxelSizeM);
+
+  // The first frame is a full frame.
+  EXPECT_FALSE(gate.gateFrame(depth_frame_, T_L_C_, camera_, tsdf_layer,
+                              kTruncationDistanceM));
+
+  // A person walking in, covering a tenth of the image. Only the pixels of
+  // the person are kept, the wall agrees with the reconstruction.
+  DepthImage changed_frame(MemoryType::kUnified);
+  changed_frame.copyFrom(depth_frame_);
+  constexpr int kNumChangedCols = kWidth / 10;
+  for (int row = 0; row < kHeight; row++) {
+    for (int col = 0; col < kNumChangedCols; col++) {
+      changed_frame(row, col) = 1.0f;
+    }
+  }
+  EXPECT_TRUE(gate.gateFrame(changed_frame, T_L_C_, camera_, tsdf_layer,
+                             kTruncationDistanceM));
+  EXPECT_EQ(numValidGatedPixels(gate, 0, kNumChangedCols),
+            kHeight * kNumChangedCols);
+  // Allow for a few rays not converging at the wall.
+  EXPECT_LT(numValidGatedPixels(gate, kNumChangedCols, kWidth),
+            kHeight * kWidth / 100);
+
+  // Invalid depth stays invalid.
+  DepthImage invalid_frame(kHeight, kWidth, MemoryType::kUnified);
+  invalid_frame.setZeroAsync(*cuda_stream_);
+  cuda_stream_->synchronize();
+  EXPECT_TRUE(gate.gateFrame(invalid_frame, T_L_C_, camera_, tsdf_layer,
+                             kTruncationDistanceM));
+  EXPECT_EQ(numValidGatedPixels(gate, 0, kWidth), 0);
+  EXPECT_EQ(gate.num_gated_frames(), 2);
+
+  // Every third frame is a full frame.
+  EXPECT_FALSE(gate.gateFrame(depth_frame_, T_L_C_, camera_, tsdf_layer,
+                              kTruncationDistanceM));
+  EXPECT_TRUE(gate.gateFrame(depth_frame_, T_L_C_, camera_, tsdf_layer,
+                             kTruncationDistanceM));
+
+  // After a reset, the next frame is a full frame.
+  gate.reset();
+  EXPECT_FALSE(gate.gateFrame(depth_frame_, T_L_C_, camera_, tsdf_layer,
+                              kTruncationDistanceM));
+  EXPECT_EQ(gate.num_gated_frames(), 3);
+}
+
+TEST_F(DepthChangeGateTest, MapperSkipsUnchangedPixels) {
+  Mapper mapper(kVoxelSizeM, MemoryType::kUnified);
+  MapperParams params;
+  params.gate_unchanged_depth_pixels = true;
+  params.depth_change_gate_params.depth_change_gate_min_residual_m =
+      2.0f * kVoxelSizeM;
+  mapper.setMapperParams(params);
+
+  const auto total_weight = [&mapper]() {
+    float weight = 0.0f;
+    const TsdfLayer& tsdf_layer = mapper.tsdf_layer();
+    for (const Index3D& block_idx : tsdf_layer.getAllBlockIndices()) {
+      const TsdfBlock::ConstPtr block = tsdf_layer.getBlockAtIndex(block_idx);
+      for (int x = 0; x < TsdfBlock::kVoxelsPerSide; x++) {
+        for (int y = 0; y < TsdfBlock::kVoxelsPerSide; y++) {
+          for (int z = 0; z < TsdfBlock::kVoxelsPerSide; z++) {
+            weight += block->voxels[x][y][z].weight;
+          }
+        }
+      }
+    }
+    return weight;
+  };
+
+  // The first frame is integrated in full.
+  mapper.integrateDepth(depth_frame_, T_L_C_, camera_);
+  const float weight_after_first_frame = total_weight();
+  EXPECT_GT(weight_after_first_frame, 0.0f);
+
+  // The second frame re-observes the same wall, so (almost) nothing is
+  // integrated.
+  mapper.integrateDepth(depth_frame_, T_L_C_, camera_);
+  EXPECT_EQ(mapper.depth_change_gate().num_gated_frames(), 1);
+  const float weight_after_gated_frame = total_weight();
+
+  // Without gating, the frame is integrated in full.
+  mapper.gate_unchanged_depth_pixels(false);
+  mapper.integrateDepth(depth_frame_, T_L_C_, camera_);
+  EXPECT_EQ(mapper.depth_change_gate().num_gated_frames(), 1);
+  const float weight_after_full_frame = total_weight();
+  EXPECT_GT(weight_after_full_frame, weight_after_gated_frame);
+  EXPECT_LT(weight_after_gated_frame - weight_after_first_frame,
+            0.1f * (weight_after_full_frame - weight_after_gated_frame));
+}
+
+int main(int argc, char** argv) {
+  FLAGS_alsologtostderr = true;
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
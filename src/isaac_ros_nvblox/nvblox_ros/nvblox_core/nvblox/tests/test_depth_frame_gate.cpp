@@ -0,0 +1,142 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+
+#include "nvblox/mapper/depth_frame_gate.h"
+#include "nvblox/mapper/mapper.h"
+#include "nvblox/tests/utils.h"
+
+using namespace nvblox;
+
+class DepthFrameGateTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    // A camera looking at a wall 2m in front.
+    depth_frame_ = DepthImage(kHeight, kWidth, MemoryType::kUnified);
+    for (int row = 0; row < kHeight; row++) {
+      for (int col = 0; col < kWidth; col++) {
+        depth_frame_(row, col) = 2.0f;
+      }
+    }
+    T_L_C_ = Transform::Identity();
+  }
+
+  static constexpr int kWidth = 64;
+  static constexpr int kHeight = 48;
+  DepthImage depth_frame_{MemoryType::kUnified};
+  Transform T_L_C_;
+  std::shared_ptr<CudaStream> cuda_stream_ =
+      std::make_shared<CudaStreamOwning>();
+};
+
+TEST_F(DepthFrameGateTest, RedundantFrames) {
+  DepthFrameGate gate(cuda_stream_);
+
+  // The first frame is never redundant, the same frame again always is.
+  EXPECT_FALSE(gate.isRedundant(depth_frame_, T_L_C_));
+  EXPECT_TRUE(gate.isRedundant(depth_frame_, T_L_C_));
+
+  // Small motion and depth noise are redundant.
+  Transform T_L_C_moved = T_L_C_;
+  T_L_C_moved.translation() = Vector3f(0.5f * gate.max_translation_m(), 0, 0);
+  DepthImage noisy_frame(MemoryType::kUnified);
+  noisy_frame.copyFrom(depth_frame_);
+  noisy_frame(0, 0) += 0.5f * gate.max_depth_change_m();
+  EXPECT_TRUE(gate.isRedundant(noisy_frame, T_L_C_moved));
+  EXPECT_EQ(gate.num_redundant_frames(), 2);
+
+  // Translation, rotation and depth change each make a frame non-redundant.
+  T_L_C_moved.translation() = Vector3f(2.0f * gate.max_translation_m(), 0, 0);
+  EXPECT_FALSE(gate.isRedundant(depth_frame_, T_L_C_moved));
+  EXPECT_TRUE(gate.isRedundant(depth_frame_, T_L_C_moved));
+
+  Transform T_L_C_rotated = T_L_C_moved;
+  T_L_C_rotated.rotate(
+      Eigen::AngleAxisf(2.0f * gate.max_rotation_rad(), Vector3f::UnitZ()));
+  EXPECT_FALSE(gate.isRedundant(depth_frame_, T_L_C_rotated));
+  EXPECT_TRUE(gate.isRedundant(depth_frame_, T_L_C_rotated));
+
+  // A person walking in, covering a tenth of the image.
+  DepthImage changed_frame(MemoryType::kUnified);
+  changed_frame.copyFrom(depth_frame_);
+  for (int row = 0; row < kHeight; row++) {
+    for (int col = 0; col < kWidth / 10; col++) {
+      changed_frame(row, col) = 1.0f;
+    }
+  }
+  EXPECT_FALSE(gate.isRedundant(changed_frame, T_L_C_rotated));
+  EXPECT_TRUE(gate.isRedundant(changed_frame, T_L_C_rotated));
+  // Depth becoming invalid counts as a change too.
+  for (int row = 0; row < kHeight; row++) {
+    for (int col = 0; col < kWidth / 10; col++) {
+      changed_frame(row, col) = 0.0f;
+    }
+  }
+  EXPECT_FALSE(gate.isRedundant(changed_frame, T_L_C_rotated));
+
+  // After a reset, the next frame becomes the keyframe.
+  gate.reset();
+  EXPECT_FALSE(gate.isRedundant(changed_frame, T_L_C_rotated));
+}
+
+TEST_F(DepthFrameGateTest, MapperSkipsRedundantFrames) {
+  constexpr float kVoxelSizeM = 0.05f;
+  const Camera camera(50.0f, 50.0f, kWidth / 2.0f, kHeight / 2.0f, kWidth,
+                      kHeight);
+  Mapper mapper(kVoxelSizeM, MemoryType::kUnified);
+  MapperParams params;
+  params.skip_redundant_depth_frames = true;
+  mapper.setMapperParams(params);
+
+  const auto total_weight = [&mapper]() {
+    float weight = 0.0f;
+    const TsdfLayer& tsdf_layer = mapper.tsdf_layer();
+    for (const Index3D& block_idx : tsdf_layer.getAllBlockIndices()) {
+      const TsdfBlock::ConstPtr block = tsdf_layer.getBlockAtIndex(block_idx);
+      for (int x = 0; x < TsdfBlock::kVoxelsPerSide; x++) {
+        for (int y = 0; y < TsdfBlock::kVoxelsPerSide; y++) {
+          for (int z = 0; z < TsdfBlock::kVoxelsPerSide; z++) {
+            weight += block->voxels[x][y][z].weight;
+          }
+        }
+      }
+    }
+    return weight;
+  };
+
+  mapper.integrateDepth(depth_frame_, T_L_C_, camera);
+  const float weight_after_first_frame = total_weight();
+  EXPECT_GT(weight_after_first_frame, 0.0f);
+
+  // Integrating the same frame again is skipped: the weights don't change.
+  mapper.integrateDepth(depth_frame_, T_L_C_, camera);
+  EXPECT_EQ(mapper.depth_frame_gate().num_redundant_frames(), 1);
+  EXPECT_EQ(total_weight(), weight_after_first_frame);
+
+  // Without skipping, the frame is integrated.
+  mapper.skip_redundant_depth_frames(false);
+  mapper.integrateDepth(depth_frame_, T_L_C_, camera);
+  EXPECT_EQ(mapper.depth_frame_gate().num_redundant_frames(), 1);
+  EXPECT_GT(total_weight(), weight_after_first_frame);
+}
+
+int main(int argc, char** argv) {
+  FLAGS_alsologtostderr = true;
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
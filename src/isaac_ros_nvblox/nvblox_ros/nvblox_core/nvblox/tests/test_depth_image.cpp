@@ -16,6 +16,7 @@ limitations under the License.
 #include <gtest/gtest.h>
 
 #include "nvblox/core/types.h"
+#include "nvblox/core/unified_vector.h"
 #include "nvblox/interpolation/interpolation_2d.h"
 #include "nvblox/sensors/image.h"
 #include "nvblox/tests/gpu_image_routines.h"
@@ -320,6 +321,54 @@ TEST_F(DepthImageTest, ImageCast) {
   EXPECT_EQ(image_out(1, 1), 4);
 }
 
+TEST_F(DepthImageTest, ImageCastU16ToMeters) {
+  DepthImageU16 image(2, 2, MemoryType::kUnified);
+  image(0, 0) = 0;
+  image(0, 1) = 1000;
+  image(1, 0) = 1500;
+  image(1, 1) = 65535;
+
+  DepthImage image_out(MemoryType::kUnified);
+  const CudaStreamOwning cuda_stream;
+  image::castGPUAsync(image, 1.0f / 1000.0f, &image_out, cuda_stream);
+  cuda_stream.synchronize();
+
+  EXPECT_NEAR(image_out(0, 0), 0.0f, kFloatEpsilon);
+  EXPECT_NEAR(image_out(0, 1), 1.0f, kFloatEpsilon);
+  EXPECT_NEAR(image_out(1, 0), 1.5f, kFloatEpsilon);
+  EXPECT_NEAR(image_out(1, 1), 65.535f, 1e-4f);
+}
+
+TEST_F(DepthImageTest, ColorImageFromRgb) {
+  constexpr int kRows = 3;
+  constexpr int kCols = 17;
+  unified_vector<uint8_t> rgb(kRows * kCols * 3, MemoryType::kUnified);
+  for (size_t i = 0; i < rgb.size(); ++i) {
+    rgb[i] = static_cast<uint8_t>(i % 251);
+  }
+
+  ColorImage image_out(MemoryType::kDevice);
+  const CudaStreamOwning cuda_stream;
+  image::colorImageFromRgbGPUAsync(rgb.data(), kRows, kCols, &image_out,
+                                   cuda_stream);
+  ColorImage image_out_host(MemoryType::kHost);
+  image_out_host.copyFromAsync(image_out, cuda_stream);
+  cuda_stream.synchronize();
+
+  ASSERT_EQ(image_out_host.rows(), kRows);
+  ASSERT_EQ(image_out_host.cols(), kCols);
+  for (int row = 0; row < kRows; ++row) {
+    for (int col = 0; col < kCols; ++col) {
+      const size_t lin_idx = 3 * (row * kCols + col);
+      const Color& color = image_out_host(row, col);
+      EXPECT_EQ(color.r, rgb[lin_idx]);
+      EXPECT_EQ(color.g, rgb[lin_idx + 1]);
+      EXPECT_EQ(color.b, rgb[lin_idx + 2]);
+      EXPECT_EQ(color.a, 255);
+    }
+  }
+}
+
 TEST_F(DepthImageTest, ImageView) {
   // Mock a external image buffer
   const int image_buffer[] = {1, 2, 3, 4};
@@ -522,6 +571,84 @@ TEST_F(DepthImageTest, ResizeSmaller) {
   EXPECT_EQ(depth_frame_.dataPtr(), old_data_ptr);
 }
 
+TEST_F(DepthImageTest, ValidDepthBoundingBoxAndCrop) {
+  CudaStreamOwning cuda_stream;
+  setImageConstantOnCpu(-1.0f, &depth_frame_);
+  EXPECT_TRUE(
+      image::getValidDepthBoundingBoxGPU(depth_frame_, cuda_stream).isEmpty());
+
+  // A valid region, with each pixel storing its linear index.
+  const ImageBoundingBox expected_bbox(Index2D(100, 50), Index2D(219, 149));
+  for (int row = expected_bbox.min().y(); row <= expected_bbox.max().y();
+       row++) {
+    for (int col = expected_bbox.min().x(); col <= expected_bbox.max().x();
+         col++) {
+      depth_frame_(row, col) = static_cast<float>(row * cols_ + col);
+    }
+  }
+  const ImageBoundingBox bbox =
+      image::getValidDepthBoundingBoxGPU(depth_frame_, cuda_stream);
+  EXPECT_EQ(bbox.min(), expected_bbox.min());
+  EXPECT_EQ(bbox.max(), expected_bbox.max());
+
+  DepthImage cropped(MemoryType::kUnified);
+  image::cropGPUAsync(depth_frame_, bbox, &cropped, cuda_stream);
+  cuda_stream.synchronize();
+  ASSERT_EQ(cropped.rows(), 100);
+  ASSERT_EQ(cropped.cols(), 120);
+  for (int row = 0; row < cropped.rows(); row++) {
+    for (int col = 0; col < cropped.cols(); col++) {
+      EXPECT_EQ(cropped(row, col),
+                depth_frame_(row + bbox.min().y(), col + bbox.min().x()));
+    }
+  }
+}
+
+TEST(DepthImageMinDownscaleTest, MaskAndIntegerDepth) {
+  CudaStreamOwning cuda_stream;
+  // A 3x5 image downscaled by 2, such that the last row and column of
+  // pixels form partial patches.
+  constexpr int kRows = 3;
+  constexpr int kCols = 5;
+  constexpr int kFactor = 2;
+  DepthImageU16 depth_mm(kRows, kCols, MemoryType::kUnified);
+  MonoImage mask(kRows, kCols, MemoryType::kUnified);
+  for (int row = 0; row < kRows; row++) {
+    for (int col = 0; col < kCols; col++) {
+      depth_mm(row, col) = 1000 + 100 * row + col;
+      mask(row, col) = 0;
+    }
+  }
+  // Patch (0, 0): the nearest depth is invalid, the next nearest is masked.
+  depth_mm(0, 0) = 0;
+  depth_mm(0, 1) = 500;
+  mask(0, 1) = image::kMaskedValue;
+  // Patch (0, 1): no valid depth.
+  depth_mm(0, 2) = depth_mm(0, 3) = depth_mm(1, 2) = depth_mm(1, 3) = 0;
+
+  DepthImage downscaled(MemoryType::kUnified);
+  MonoImage downscaled_mask(MemoryType::kUnified);
+  constexpr float kDepthScaleM = 1e-3f;
+  image::minDownscaleGPUAsync(MaskedDepthImageU16ConstView(depth_mm, mask),
+                              kDepthScaleM, kFactor, &downscaled,
+                              &downscaled_mask, cuda_stream);
+  cuda_stream.synchronize();
+  ASSERT_EQ(downscaled.rows(), 2);
+  ASSERT_EQ(downscaled.cols(), 3);
+  ASSERT_EQ(downscaled_mask.rows(), 2);
+  ASSERT_EQ(downscaled_mask.cols(), 3);
+
+  EXPECT_NEAR(downscaled(0, 0), 0.5f, 1e-6f);
+  EXPECT_EQ(downscaled_mask(0, 0), image::kMaskedValue);
+  EXPECT_EQ(downscaled(0, 1), 0.0f);
+  EXPECT_EQ(downscaled_mask(0, 1), 0);
+  // The partial patches only cover the pixels inside the image.
+  EXPECT_NEAR(downscaled(0, 2), 1.004f, 1e-6f);
+  EXPECT_NEAR(downscaled(1, 0), 1.200f, 1e-6f);
+  EXPECT_NEAR(downscaled(1, 2), 1.204f, 1e-6f);
+  EXPECT_EQ(downscaled_mask(1, 2), 0);
+}
+
 int main(int argc, char** argv) {
   FLAGS_alsologtostderr = true;
   google::InitGoogleLogging(argv[0]);
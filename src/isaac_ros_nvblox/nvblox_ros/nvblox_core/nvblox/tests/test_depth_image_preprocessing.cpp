@@ -15,6 +15,8 @@ limitations under the License.
 */
 #include <gtest/gtest.h>
 
+#include <cmath>
+
 #include "nvblox/datasets/3dmatch.h"
 #include "nvblox/io/image_io.h"
 #include "nvblox/sensors/depth_preprocessing.h"
@@ -182,6 +184,87 @@ TEST_F(DepthImagePreprocessing, DilationNumberTests) {
   }
 }
 
+TEST_F(DepthImagePreprocessing, CudaGraphMatchesDirectLaunch) {
+  constexpr int kNumDilations = 2;
+  DepthPreprocessor graph_preprocessor(cuda_stream_);
+  graph_preprocessor.use_cuda_graph(true);
+  EXPECT_TRUE(graph_preprocessor.use_cuda_graph());
+
+  // Dilate into the same buffer a few times, such that the first call
+  // captures the graph and subsequent calls replay it.
+  DepthImage depth_image_direct{MemoryType::kUnified};
+  DepthImage depth_image_graph{MemoryType::kUnified};
+  for (int i = 0; i < 3; i++) {
+    depth_image_direct.copyFromAsync(depth_frame_, *cuda_stream_);
+    depth_image_graph.copyFromAsync(depth_frame_, *cuda_stream_);
+    depth_preprocessor_ptr_->dilateInvalidRegionsAsync(kNumDilations,
+                                                       &depth_image_direct);
+    graph_preprocessor.dilateInvalidRegionsAsync(kNumDilations,
+                                                 &depth_image_graph);
+    cuda_stream_->synchronize();
+    checkCudaErrors(cudaPeekAtLastError());
+
+    for (int pixel_idx = 0; pixel_idx < depth_frame_.numel(); pixel_idx++) {
+      EXPECT_EQ(depth_image_direct(pixel_idx), depth_image_graph(pixel_idx));
+    }
+  }
+}
+
+TEST_F(DepthImagePreprocessing, VpiBackendMatchesCuda) {
+  constexpr int kNumDilations = 3;
+  DepthPreprocessor vpi_preprocessor(cuda_stream_);
+  EXPECT_EQ(vpi_preprocessor.backend(), DepthPreprocessingBackend::kCuda);
+  vpi_preprocessor.backend(DepthPreprocessingBackend::kVpi);
+  if (!VpiMaskDilator::isAvailable()) {
+    // Without VPI we stay on the CUDA backend.
+    EXPECT_EQ(vpi_preprocessor.backend(), DepthPreprocessingBackend::kCuda);
+    return;
+  }
+  EXPECT_EQ(vpi_preprocessor.backend(), DepthPreprocessingBackend::kVpi);
+
+  DepthImage depth_image_cuda{MemoryType::kUnified};
+  DepthImage depth_image_vpi{MemoryType::kUnified};
+  depth_image_cuda.copyFromAsync(depth_frame_, *cuda_stream_);
+  depth_image_vpi.copyFromAsync(depth_frame_, *cuda_stream_);
+  depth_preprocessor_ptr_->dilateInvalidRegionsAsync(kNumDilations,
+                                                     &depth_image_cuda);
+  vpi_preprocessor.dilateInvalidRegionsAsync(kNumDilations, &depth_image_vpi);
+  cuda_stream_->synchronize();
+  checkCudaErrors(cudaPeekAtLastError());
+
+  for (int pixel_idx = 0; pixel_idx < depth_frame_.numel(); pixel_idx++) {
+    EXPECT_EQ(depth_image_cuda(pixel_idx), depth_image_vpi(pixel_idx));
+  }
+}
+
+TEST_F(DepthImagePreprocessing, IntegerDepthMatchesFloat) {
+  constexpr int kNumDilations = 2;
+  constexpr float kDepthScaleM = 1e-3f;
+  // The test frame in millimeters, and its (exact) float equivalent.
+  DepthImageU16 depth_image_mm(depth_frame_.rows(), depth_frame_.cols(),
+                               MemoryType::kUnified);
+  DepthImage depth_image_m(depth_frame_.rows(), depth_frame_.cols(),
+                           MemoryType::kUnified);
+  for (int i = 0; i < depth_frame_.numel(); i++) {
+    depth_image_mm(i) =
+        static_cast<uint16_t>(std::round(depth_frame_(i) / kDepthScaleM));
+    depth_image_m(i) = static_cast<float>(depth_image_mm(i)) * kDepthScaleM;
+  }
+
+  depth_preprocessor_ptr_->dilateInvalidRegionsAsync(kNumDilations,
+                                                     &depth_image_m);
+  depth_preprocessor_ptr_->dilateInvalidRegionsAsync(
+      kNumDilations, kDepthScaleM, &depth_image_mm);
+  cuda_stream_->synchronize();
+  checkCudaErrors(cudaPeekAtLastError());
+
+  for (int i = 0; i < depth_frame_.numel(); i++) {
+    constexpr float kEps = 1e-6;
+    EXPECT_NEAR(static_cast<float>(depth_image_mm(i)) * kDepthScaleM,
+                depth_image_m(i), kEps);
+  }
+}
+
 int main(int argc, char** argv) {
   FLAGS_alsologtostderr = true;
   google::InitGoogleLogging(argv[0]);
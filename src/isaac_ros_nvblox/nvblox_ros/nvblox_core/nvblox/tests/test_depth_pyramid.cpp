@@ -0,0 +1,194 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <set>
+#include <vector>
+
+#include "nvblox/core/cuda_stream.h"
+#include "nvblox/integrators/view_calculator.h"
+#include "nvblox/sensors/depth_pyramid.h"
+#include "nvblox/tests/utils.h"
+
+using namespace nvblox;
+
+namespace {
+
+// A depth image with a given fraction of invalid pixels.
+DepthImage getRandomDepthImage(const int rows, const int cols,
+                               const float invalid_fraction) {
+  DepthImage depth_image(rows, cols, MemoryType::kUnified);
+  for (int row = 0; row < rows; row++) {
+    for (int col = 0; col < cols; col++) {
+      depth_image(row, col) = test_utils::randomFloatInRange(0.0f, 1.0f) <
+                                      invalid_fraction
+                                  ? 0.0f
+                                  : test_utils::randomFloatInRange(0.5f, 8.0f);
+    }
+  }
+  return depth_image;
+}
+
+// Reduces the patch of pixels of a cell on the CPU.
+DepthPyramidCell getCellOnCpu(const DepthImage& depth_image, const int level,
+                              const int cell_row, const int cell_col) {
+  const int factor = 1 << level;
+  DepthPyramidCell cell{0.0f, 0.0f, 0};
+  for (int row = cell_row * factor;
+       row < std::min((cell_row + 1) * factor, depth_image.rows()); row++) {
+    for (int col = cell_col * factor;
+         col < std::min((cell_col + 1) * factor, depth_image.cols()); col++) {
+      const float depth = depth_image(row, col);
+      if (depth <= 0.0f) {
+        continue;
+      }
+      cell.min_depth = cell.num_valid == 0 ? depth
+                                           : std::min(cell.min_depth, depth);
+      cell.max_depth = std::max(cell.max_depth, depth);
+      ++cell.num_valid;
+    }
+  }
+  return cell;
+}
+
+}  // namespace
+
+TEST(DepthPyramidTest, LevelsMatchCpuReduction) {
+  // A size which isn't a multiple of the tile size, such that there are
+  // partial cells at the border.
+  constexpr int kRows = 67;
+  constexpr int kCols = 101;
+  const DepthImage depth_image = getRandomDepthImage(kRows, kCols, 0.3f);
+
+  CudaStreamOwning cuda_stream;
+  DepthPyramid depth_pyramid;
+  EXPECT_TRUE(depth_pyramid.empty());
+  depth_pyramid.buildAsync(depth_image, cuda_stream);
+  EXPECT_TRUE(depth_pyramid.isBuiltFrom(depth_image.dataConstPtr(), kRows,
+                                        kCols));
+
+  for (int level = 1; level <= DepthPyramid::kNumLevels; level++) {
+    const int factor = 1 << level;
+    EXPECT_EQ(DepthPyramid::levelForSubsamplingFactor(factor), level);
+    ASSERT_EQ(depth_pyramid.rows(level), (kRows + factor - 1) / factor);
+    ASSERT_EQ(depth_pyramid.cols(level), (kCols + factor - 1) / factor);
+    const std::vector<DepthPyramidCell> cells =
+        depth_pyramid.levelToHost(level, cuda_stream);
+    for (int row = 0; row < depth_pyramid.rows(level); row++) {
+      for (int col = 0; col < depth_pyramid.cols(level); col++) {
+        const DepthPyramidCell& cell =
+            cells[row * depth_pyramid.cols(level) + col];
+        const DepthPyramidCell expected =
+            getCellOnCpu(depth_image, level, row, col);
+        EXPECT_EQ(cell.num_valid, expected.num_valid);
+        EXPECT_EQ(cell.min_depth, expected.min_depth);
+        EXPECT_EQ(cell.max_depth, expected.max_depth);
+      }
+    }
+  }
+  EXPECT_EQ(DepthPyramid::levelForSubsamplingFactor(1), 0);
+  EXPECT_EQ(DepthPyramid::levelForSubsamplingFactor(3), 0);
+
+  // The image cell is the reduction of all pixels.
+  const DepthPyramidCell image_cell = depth_pyramid.getImageCell(cuda_stream);
+  int num_valid = 0;
+  for (int i = 0; i < depth_image.numel(); i++) {
+    num_valid += depth_image(i) > 0.0f ? 1 : 0;
+  }
+  EXPECT_EQ(image_cell.num_valid, num_valid);
+}
+
+TEST(DepthPyramidTest, MinDepthImageMatchesMinDownscale) {
+  constexpr int kRows = 67;
+  constexpr int kCols = 101;
+  const DepthImage depth_image = getRandomDepthImage(kRows, kCols, 0.3f);
+
+  CudaStreamOwning cuda_stream;
+  DepthPyramid depth_pyramid;
+  depth_pyramid.buildAsync(depth_image, cuda_stream);
+
+  for (int level = 1; level <= DepthPyramid::kNumLevels; level++) {
+    const int factor = 1 << level;
+    DepthImage from_pyramid(MemoryType::kUnified);
+    depth_pyramid.minDepthToImageAsync(level, &from_pyramid, cuda_stream);
+    DepthImage downscaled(MemoryType::kUnified);
+    image::minDownscaleGPUAsync(MaskedDepthImageConstView(depth_image),
+                                factor, &downscaled, nullptr, cuda_stream);
+    cuda_stream.synchronize();
+    ASSERT_EQ(from_pyramid.rows(), depth_pyramid.rows(level));
+    ASSERT_EQ(from_pyramid.cols(), depth_pyramid.cols(level));
+    ASSERT_EQ(downscaled.rows(), from_pyramid.rows());
+    ASSERT_EQ(downscaled.cols(), from_pyramid.cols());
+    for (int row = 0; row < from_pyramid.rows(); row++) {
+      for (int col = 0; col < from_pyramid.cols(); col++) {
+        const float expected =
+            getCellOnCpu(depth_image, level, row, col).min_depth;
+        EXPECT_EQ(from_pyramid(row, col), expected);
+        EXPECT_EQ(downscaled(row, col), expected);
+      }
+    }
+  }
+}
+
+TEST(DepthPyramidTest, RaycastingWithPyramidCoversPixelRays) {
+  constexpr float kFu = 300.0f;
+  constexpr int kWidth = 160;
+  constexpr int kHeight = 120;
+  const Camera camera(kFu, kFu, kWidth / 2.0f, kHeight / 2.0f, kWidth,
+                      kHeight);
+  const DepthImage depth_image = getRandomDepthImage(kHeight, kWidth, 0.5f);
+
+  CudaStreamOwning cuda_stream;
+  DepthPyramid depth_pyramid;
+  depth_pyramid.buildAsync(depth_image, cuda_stream);
+
+  constexpr float kBlockSize = 0.4f;
+  constexpr float kBehindSurfaceM = 0.2f;
+  constexpr float kMaxDistanceM = 10.0f;
+  ViewCalculator view_calculator;
+  view_calculator.cache_last_viewpoint(false);
+  view_calculator.raycast_subsampling_factor(4);
+  const std::vector<Index3D> blocks_pixel_rays =
+      view_calculator.getBlocksInImageViewRaycast(
+          depth_image, Transform::Identity(), camera, kBlockSize,
+          kBehindSurfaceM, kMaxDistanceM);
+  view_calculator.depth_pyramid(&depth_pyramid);
+  const std::vector<Index3D> blocks_pyramid =
+      view_calculator.getBlocksInImageViewRaycast(
+          depth_image, Transform::Identity(), camera, kBlockSize,
+          kBehindSurfaceM, kMaxDistanceM);
+
+  // The rays are the same, but cast at least as far.
+  auto index_less = [](const Index3D& a, const Index3D& b) {
+    return std::lexicographical_compare(a.data(), a.data() + 3, b.data(),
+                                        b.data() + 3);
+  };
+  const std::set<Index3D, decltype(index_less)> pyramid_set(
+      blocks_pyramid.begin(), blocks_pyramid.end(), index_less);
+  EXPECT_GT(blocks_pixel_rays.size(), 0);
+  for (const Index3D& block_index : blocks_pixel_rays) {
+    EXPECT_EQ(pyramid_set.count(block_index), 1);
+  }
+}
+
+int main(int argc, char** argv) {
+  google::InitGoogleLogging(argv[0]);
+  FLAGS_alsologtostderr = true;
+  google::InstallFailureSignalHandler();
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -131,6 +131,28 @@ TEST_F(DynamicsTester, PrimitiveScene) {
     EXPECT_TRUE(on_cube_boundary);
   }
 
+  // The asynchronous detection produces the same outputs.
+  DynamicsDetection async_detector(std::make_shared<CudaStreamOwning>());
+  async_detector.computeDynamicsAsync(depth_frame_cube_C, freespace_layer_L,
+                                      camera_, T_L_C);
+  auto consumer_stream = std::make_shared<CudaStreamOwning>();
+  async_detector.waitForOutputs(*consumer_stream);
+  MonoImage async_mask(MemoryType::kHost);
+  async_mask.copyFromAsync(async_detector.getDynamicMaskImage(),
+                           *consumer_stream);
+  consumer_stream->synchronize();
+  EXPECT_TRUE(async_detector.outputsReady());
+  EXPECT_EQ(async_detector.getDynamicPointcloudDevice().size(),
+            dynamic_points_cube.cols());
+  EXPECT_EQ(async_detector.getDynamicPointsHost().cols(),
+            dynamic_points_cube.cols());
+  MonoImage mask(MemoryType::kHost);
+  mask.copyFrom(detector.getDynamicMaskImage());
+  ASSERT_EQ(mask.numel(), async_mask.numel());
+  for (int i = 0; i < mask.numel(); i++) {
+    EXPECT_EQ(mask(i), async_mask(i));
+  }
+
   if (FLAGS_nvblox_test_file_output) {
     io::writeToPng("depth_image_C.png", depth_frame_C);
     io::writeToPng("depth_frame_cube_C.png", depth_frame_cube_C);
@@ -551,6 +551,93 @@ TEST_P(EsdfIntegratorTest, SingleEsdfTestGPU) {
   std::cout << timing::Timing::Print();
 }
 
+TEST_P(EsdfIntegratorTest, CompactEsdfMatchesFullEsdf) {
+  static_assert(sizeof(CompactEsdfVoxel) == 8);
+
+  // Create a scene that's just an object.
+  addParameterizedObstacleToScene(GetParam());
+
+  // Generate a TSDF
+  scene_.generateLayerFromScene(4 * voxel_size_, tsdf_layer_.get());
+
+  // Integrate the same blocks into a full and a compact ESDF layer.
+  std::vector<Index3D> block_indices = tsdf_layer_->getAllBlockIndices();
+  esdf_integrator_.integrateBlocks(*tsdf_layer_, block_indices,
+                                   esdf_layer_.get());
+  CompactEsdfLayer compact_esdf_layer(voxel_size_, MemoryType::kUnified);
+  esdf_integrator_.integrateBlocks(*tsdf_layer_, block_indices,
+                                   &compact_esdf_layer);
+
+  // The two layers should be identical voxel-by-voxel.
+  EXPECT_EQ(esdf_layer_->numAllocatedBlocks(),
+            compact_esdf_layer.numAllocatedBlocks());
+  int num_compared = 0;
+  callFunctionOnAllVoxels<EsdfVoxel>(
+      *esdf_layer_, [&](const Index3D& block_index, const Index3D& voxel_index,
+                        const EsdfVoxel* voxel) {
+        const CompactEsdfVoxel* compact_voxel =
+            getVoxelAtBlockAndVoxelIndex<CompactEsdfVoxel>(
+                compact_esdf_layer, block_index, voxel_index);
+        ASSERT_NE(compact_voxel, nullptr);
+        const EsdfVoxel expanded_voxel = compact_voxel->toEsdfVoxel();
+        EXPECT_EQ(voxel->observed, expanded_voxel.observed);
+        EXPECT_EQ(voxel->is_inside, expanded_voxel.is_inside);
+        EXPECT_EQ(voxel->is_site, expanded_voxel.is_site);
+        EXPECT_NEAR(voxel->squared_distance_vox,
+                    expanded_voxel.squared_distance_vox, kFloatEpsilon);
+        EXPECT_EQ(voxel->parent_direction, expanded_voxel.parent_direction);
+        ++num_compared;
+      });
+  EXPECT_GT(num_compared, 0);
+}
+
+TEST_P(EsdfIntegratorTest, PersistentKernelMatchesLaunchLoop) {
+  if (!EsdfIntegrator::isPersistentKernelSupported()) {
+    GTEST_SKIP() << "The GPU doesn't support cooperative launches.";
+  }
+  // Create a scene that's just an object.
+  addParameterizedObstacleToScene(GetParam());
+
+  // Generate a TSDF
+  scene_.generateLayerFromScene(4 * voxel_size_, tsdf_layer_.get());
+
+  // Integrate the same blocks with both propagation schemes.
+  std::vector<Index3D> block_indices = tsdf_layer_->getAllBlockIndices();
+  esdf_integrator_.integrateBlocks(*tsdf_layer_, block_indices,
+                                   esdf_layer_.get());
+  EsdfIntegrator persistent_esdf_integrator;
+  persistent_esdf_integrator.max_esdf_distance_m(max_distance_);
+  persistent_esdf_integrator.min_weight(1.0f);
+  persistent_esdf_integrator.use_persistent_kernel(true);
+  EXPECT_TRUE(persistent_esdf_integrator.use_persistent_kernel());
+  EsdfLayer persistent_esdf_layer(voxel_size_, MemoryType::kUnified);
+  persistent_esdf_integrator.integrateBlocks(*tsdf_layer_, block_indices,
+                                             &persistent_esdf_layer);
+
+  // The wavefronts are the same sets of blocks, so the two layers should be
+  // identical voxel-by-voxel.
+  EXPECT_EQ(esdf_layer_->numAllocatedBlocks(),
+            persistent_esdf_layer.numAllocatedBlocks());
+  int num_compared = 0;
+  callFunctionOnAllVoxels<EsdfVoxel>(
+      *esdf_layer_, [&](const Index3D& block_index, const Index3D& voxel_index,
+                        const EsdfVoxel* voxel) {
+        const EsdfVoxel* persistent_voxel =
+            getVoxelAtBlockAndVoxelIndex<EsdfVoxel>(persistent_esdf_layer,
+                                                    block_index, voxel_index);
+        ASSERT_NE(persistent_voxel, nullptr);
+        EXPECT_EQ(voxel->observed, persistent_voxel->observed);
+        EXPECT_EQ(voxel->is_site, persistent_voxel->is_site);
+        EXPECT_EQ(voxel->squared_distance_vox,
+                  persistent_voxel->squared_distance_vox);
+        EXPECT_EQ(voxel->parent_direction, persistent_voxel->parent_direction);
+        ++num_compared;
+      });
+  EXPECT_GT(num_compared, 0);
+  EXPECT_TRUE(validateEsdf(persistent_esdf_layer,
+                           max_squared_distance_vox(voxel_size_)));
+}
+
 TEST_P(EsdfIntegratorTest, OccupancySingleEsdfTestGPU) {
   // Create a scene that's just an object.
   addParameterizedObstacleToScene(GetParam());
@@ -804,6 +891,57 @@ TEST_P(EsdfIntegratorTest, sliceLayerToDistanceImage_emptyLayer) {
   EXPECT_EQ(slice_image.width(), 0);
   EXPECT_EQ(slice_image.height(), 0);
 }
+TEST_P(EsdfIntegratorTest, sliceLayerToDistanceImage_aroundPosition) {
+  addParameterizedObstacleToScene(GetParam());
+  scene_.generateLayerFromScene(4 * voxel_size_, tsdf_layer_.get());
+  esdf_integrator_.integrateBlocks(
+      *tsdf_layer_, tsdf_layer_->getAllBlockIndices(), esdf_layer_.get());
+
+  // Reference: The slice of the whole layer.
+  constexpr float kSliceHeight = 1.0f;
+  constexpr float kUnobservedValue = -1000.0f;
+  const AxisAlignedBoundingBox layer_aabb =
+      esdf_slicer_.getAabbOfLayerAtHeight(*esdf_layer_, kSliceHeight);
+  Image<float> layer_slice(MemoryType::kUnified);
+  esdf_slicer_.sliceLayerToDistanceImage(*esdf_layer_, kSliceHeight,
+                                         kUnobservedValue, layer_aabb,
+                                         &layer_slice);
+
+  // Slices around several positions have the same size, and match the
+  // reference where they overlap it.
+  constexpr float kSideLengthM = 3.0f;
+  const int expected_size =
+      static_cast<int>(std::ceil(kSideLengthM / voxel_size_));
+  for (const Vector3f& center :
+       {Vector3f(0.0f, 0.0f, 0.0f), Vector3f(1.03f, -2.71f, 0.5f),
+        Vector3f(-4.45f, 3.33f, 1.0f), Vector3f(40.0f, 40.0f, 1.0f)}) {
+    const AxisAlignedBoundingBox aabb = EsdfSlicer::getAabbAroundPosition(
+        center, kSideLengthM, voxel_size_, kSliceHeight);
+    EXPECT_TRUE(aabb.contains(Vector3f(center.x(), center.y(), kSliceHeight)));
+    Image<float> slice(MemoryType::kUnified);
+    esdf_slicer_.sliceLayerToDistanceImage(
+        *esdf_layer_, kSliceHeight, kUnobservedValue, aabb, &slice);
+    ASSERT_EQ(slice.rows(), expected_size);
+    ASSERT_EQ(slice.cols(), expected_size);
+
+    const int row_offset = static_cast<int>(
+        std::round((aabb.min().y() - layer_aabb.min().y()) / voxel_size_));
+    const int col_offset = static_cast<int>(
+        std::round((aabb.min().x() - layer_aabb.min().x()) / voxel_size_));
+    for (int row = 0; row < slice.rows(); row++) {
+      for (int col = 0; col < slice.cols(); col++) {
+        const int layer_row = row + row_offset;
+        const int layer_col = col + col_offset;
+        if (layer_row >= 0 && layer_row < layer_slice.rows() &&
+            layer_col >= 0 && layer_col < layer_slice.cols()) {
+          EXPECT_EQ(slice(row, col), layer_slice(layer_row, layer_col));
+        } else {
+          EXPECT_EQ(slice(row, col), kUnobservedValue);
+        }
+      }
+    }
+  }
+}
 TEST_P(EsdfIntegratorTest, IncrementalTsdfAndEsdfWithObjectRemovalGPU) {
   constexpr float kTrajectoryRadius = 4.0f;
   constexpr float kTrajectoryHeight = 2.0f;
@@ -574,6 +574,73 @@ TEST_P(ParameterizedEsdfIntegratorSlicingTest, TestScene) {
   }
 }
 
+TEST_F(EsdfIntegratorSlicingTest, MultipleSlicesMatchSingleSlices) {
+  // Sphere in a box.
+  primitives::Scene scene;
+  scene.aabb() = AxisAlignedBoundingBox(Vector3f(-5.0f, -5.0f, 0.0f),
+                                        Vector3f(5.0f, 5.0f, 5.0f));
+  scene.addGroundLevel(0.0f);
+  scene.addCeiling(5.0f);
+  scene.addPrimitive(
+      std::make_unique<primitives::Sphere>(Vector3f(0.0f, 0.0f, 2.0f), 2.0f));
+  scene.addPlaneBoundaries(-5.0f, 5.0f, -5.0f, 5.0f);
+  constexpr float kTruncationDistanceM = 4.0f * kVoxelSizeM;
+  scene.generateLayerFromScene(kTruncationDistanceM, &tsdf_layer_);
+  const std::vector<Index3D> blocks_to_update =
+      tsdf_layer_.getAllBlockIndices();
+
+  // Overlapping slices at different heights.
+  const std::vector<EsdfSliceSpec> slice_specs = {
+      {.min_height_m = 0.2f, .max_height_m = 0.6f, .output_height_m = 0.4f},
+      {.min_height_m = 0.5f, .max_height_m = 1.5f, .output_height_m = 1.0f},
+      {.min_height_m = 1.9f, .max_height_m = 2.1f, .output_height_m = 2.0f}};
+
+  // All slices in a single pass.
+  std::vector<std::unique_ptr<EsdfLayer>> multi_layers;
+  std::vector<EsdfLayer*> multi_layer_ptrs;
+  for (size_t i = 0; i < slice_specs.size(); i++) {
+    multi_layers.push_back(
+        std::make_unique<EsdfLayer>(kVoxelSizeM, MemoryType::kUnified));
+    multi_layer_ptrs.push_back(multi_layers.back().get());
+  }
+  esdf_integrator_.integrateSlices(tsdf_layer_, blocks_to_update, slice_specs,
+                                   multi_layer_ptrs);
+
+  // Compare against the slices computed one at a time.
+  for (size_t i = 0; i < slice_specs.size(); i++) {
+    EsdfLayer single_layer(kVoxelSizeM, MemoryType::kUnified);
+    TestEsdfIntegrator single_integrator(cuda_stream_ptr_);
+    single_integrator.esdf_slice_min_height(slice_specs[i].min_height_m);
+    single_integrator.esdf_slice_max_height(slice_specs[i].max_height_m);
+    single_integrator.esdf_slice_height(slice_specs[i].output_height_m);
+    single_integrator.integrateSlice(tsdf_layer_, blocks_to_update,
+                                     &single_layer);
+
+    EXPECT_EQ(single_layer.numAllocatedBlocks(),
+              multi_layers[i]->numAllocatedBlocks());
+    int num_observed = 0;
+    callFunctionOnAllVoxels<EsdfVoxel>(
+        single_layer, [&](const Index3D& block_index,
+                          const Index3D& voxel_index, const EsdfVoxel* voxel) {
+          const auto multi_block =
+              multi_layers[i]->getBlockAtIndex(block_index);
+          ASSERT_TRUE(multi_block);
+          const EsdfVoxel& multi_voxel =
+              multi_block->voxels[voxel_index.x()][voxel_index.y()]
+                                 [voxel_index.z()];
+          EXPECT_EQ(voxel->observed, multi_voxel.observed);
+          EXPECT_EQ(voxel->is_site, multi_voxel.is_site);
+          EXPECT_EQ(voxel->is_inside, multi_voxel.is_inside);
+          if (voxel->observed) {
+            EXPECT_NEAR(voxel->squared_distance_vox,
+                        multi_voxel.squared_distance_vox, 1e-4f);
+            ++num_observed;
+          }
+        });
+    EXPECT_GT(num_observed, 0);
+  }
+}
+
 INSTANTIATE_TEST_CASE_P(EsdfIntegratorSlicingTests,
                         ParameterizedEsdfIntegratorSlicingTest,
                         ::testing::Values(SliceType::kHeightBased,
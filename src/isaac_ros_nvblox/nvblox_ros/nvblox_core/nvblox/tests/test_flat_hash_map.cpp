@@ -0,0 +1,131 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+
+#include <random>
+
+#include "nvblox/core/flat_hash_map.h"
+#include "nvblox/core/hash.h"
+#include "nvblox/map/common_names.h"
+#include "nvblox/map/layer.h"
+
+using namespace nvblox;
+
+TEST(FlatHashMapTest, MatchesUnorderedMap) {
+  // A small range of indices, such that there are many repeated insertions
+  // and erasures of the same keys.
+  std::mt19937 rng(0);
+  std::uniform_int_distribution<int> coordinate(-10, 10);
+  std::uniform_int_distribution<int> operation(0, 3);
+
+  Index3DFlatHashMap<int> map;
+  Index3DHashMapType<int>::type reference;
+  constexpr int kNumOperations = 200000;
+  for (int i = 0; i < kNumOperations; i++) {
+    const Index3D index(coordinate(rng), coordinate(rng), coordinate(rng));
+    switch (operation(rng)) {
+      case 0:
+      case 1: {
+        const auto inserted = map.emplace(index, i);
+        const auto reference_inserted = reference.emplace(index, i);
+        ASSERT_EQ(inserted.second, reference_inserted.second);
+        ASSERT_EQ(inserted.first->second, reference_inserted.first->second);
+        break;
+      }
+      case 2:
+        ASSERT_EQ(map.erase(index), reference.erase(index));
+        break;
+      default: {
+        const auto it = map.find(index);
+        const auto reference_it = reference.find(index);
+        ASSERT_EQ(it == map.end(), reference_it == reference.end());
+        if (it != map.end()) {
+          ASSERT_EQ(it->second, reference_it->second);
+        }
+        break;
+      }
+    }
+    ASSERT_EQ(map.size(), reference.size());
+  }
+
+  // Iteration visits each entry once.
+  size_t num_visited = 0;
+  for (const auto& kv : map) {
+    ASSERT_EQ(reference.count(kv.first), 1);
+    EXPECT_EQ(reference.at(kv.first), kv.second);
+    ++num_visited;
+  }
+  EXPECT_EQ(num_visited, reference.size());
+
+  map.clear();
+  EXPECT_TRUE(map.empty());
+  EXPECT_TRUE(map.find(Index3D(0, 0, 0)) == map.end());
+}
+
+TEST(FlatHashMapTest, EraseByIteratorAndSubscript) {
+  Index3DFlatHashMap<int> map;
+  map.reserve(100);
+  for (int i = 0; i < 100; i++) {
+    map[Index3D(i, -i, 2 * i)] = i;
+  }
+  EXPECT_EQ(map.size(), 100);
+  EXPECT_EQ(map[Index3D(7, -7, 14)], 7);
+
+  // Erase the even entries while iterating.
+  for (auto it = map.begin(); it != map.end();) {
+    it = (it->second % 2 == 0) ? map.erase(it) : it + 1;
+  }
+  EXPECT_EQ(map.size(), 50);
+  for (int i = 0; i < 100; i++) {
+    EXPECT_EQ(map.count(Index3D(i, -i, 2 * i)), i % 2);
+  }
+
+  // Indices beyond the packed range still compare on the full index.
+  constexpr int kFar = 1 << 21;
+  map[Index3D(kFar, 0, 0)] = -1;
+  map[Index3D(0, 0, 0)] = -2;
+  EXPECT_EQ(map[Index3D(kFar, 0, 0)], -1);
+  EXPECT_EQ(map[Index3D(0, 0, 0)], -2);
+}
+
+TEST(FlatHashMapTest, LayerAllocationAndClearing) {
+  TsdfLayer layer(0.1f, MemoryType::kHost);
+  for (int i = 0; i < 1000; i++) {
+    layer.allocateBlockAtIndex(Index3D(i % 10, (i / 10) % 10, i / 100));
+  }
+  EXPECT_EQ(layer.numAllocatedBlocks(), 1000);
+  for (int x = 0; x < 10; x += 2) {
+    for (int y = 0; y < 10; y++) {
+      for (int z = 0; z < 10; z++) {
+        EXPECT_TRUE(layer.clearBlock(Index3D(x, y, z)));
+      }
+    }
+  }
+  EXPECT_EQ(layer.numAllocatedBlocks(), 500);
+  for (const Index3D& index : layer.getAllBlockIndices()) {
+    EXPECT_EQ(index.x() % 2, 1);
+    EXPECT_NE(layer.getBlockAtIndex(index), nullptr);
+  }
+  EXPECT_EQ(layer.getBlockAtIndex(Index3D(0, 0, 0)), nullptr);
+}
+
+int main(int argc, char** argv) {
+  google::InitGoogleLogging(argv[0]);
+  FLAGS_alsologtostderr = true;
+  google::InstallFailureSignalHandler();
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,170 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "nvblox/utils/flight_recorder.h"
+#include "nvblox/utils/logging.h"
+#include "nvblox/utils/timing.h"
+
+using namespace nvblox;
+using namespace nvblox::timing;
+
+class FlightRecorderTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    FlightRecorder::enable(1024);
+    FlightRecorder::reset();
+    FlightRecorder::setWindowSeconds(10.0);
+    FlightRecorder::setLatencyThresholdSeconds(0.0);
+    FlightRecorder::setMinSecondsBetweenDumps(0.0);
+    FlightRecorder::setOutputDirectory(::testing::TempDir());
+  }
+  void TearDown() override {
+    FlightRecorder::waitForDump();
+    FlightRecorder::disable();
+  }
+};
+
+std::string readFile(const std::string& file_path) {
+  std::ifstream file(file_path);
+  std::stringstream ss;
+  ss << file.rdbuf();
+  return ss.str();
+}
+
+TEST_F(FlightRecorderTest, RecordsTimersCountersAndInstants) {
+  { Timer timer("flight_recorder_test/timer"); }
+  FlightRecorder::recordCounter("flight_recorder_test/queue_depth", 3.0);
+  FlightRecorder::recordInstant("flight_recorder_test/rehash", 512.0);
+
+  const std::vector<FlightRecorderEvent> events = FlightRecorder::getEvents();
+  ASSERT_EQ(events.size(), 3u);
+  EXPECT_EQ(events[0].type, FlightRecorderEventType::kTimer);
+  EXPECT_EQ(events[0].name_handle,
+            Timing::GetHandle("flight_recorder_test/timer"));
+  EXPECT_GE(events[0].duration_ns, 0);
+  EXPECT_EQ(events[1].type, FlightRecorderEventType::kCounter);
+  EXPECT_EQ(events[1].value, 3.0);
+  EXPECT_EQ(events[2].type, FlightRecorderEventType::kInstant);
+  EXPECT_EQ(events[2].value, 512.0);
+
+  const std::string trace = FlightRecorder::toChromeTrace();
+  EXPECT_NE(trace.find("\"traceEvents\""), std::string::npos);
+  EXPECT_NE(trace.find("{\"name\":\"flight_recorder_test/timer\""),
+            std::string::npos);
+  EXPECT_NE(trace.find("\"ph\":\"X\""), std::string::npos);
+  EXPECT_NE(trace.find("\"ph\":\"C\""), std::string::npos);
+  EXPECT_NE(trace.find("\"ph\":\"i\""), std::string::npos);
+  EXPECT_NE(trace.find("\"value\":512.000"), std::string::npos);
+}
+
+TEST_F(FlightRecorderTest, DisabledRecordsNothing) {
+  FlightRecorder::disable();
+  { Timer timer("flight_recorder_test/timer"); }
+  FlightRecorder::recordCounter("flight_recorder_test/queue_depth", 3.0);
+  EXPECT_TRUE(FlightRecorder::getEvents().empty());
+  EXPECT_FALSE(FlightRecorder::frameCompleted("slice", 1.0));
+}
+
+TEST_F(FlightRecorderTest, KeepsTheNewestEvents) {
+  // The ring holds 1024 events.
+  for (int i = 0; i < 3000; ++i) {
+    FlightRecorder::recordCounter("flight_recorder_test/counter", i);
+  }
+  const std::vector<FlightRecorderEvent> events = FlightRecorder::getEvents();
+  ASSERT_EQ(events.size(), 1024u);
+  EXPECT_EQ(events.back().value, 2999.0);
+  EXPECT_EQ(events.front().value, 3000.0 - 1024.0);
+}
+
+TEST_F(FlightRecorderTest, Window) {
+  FlightRecorder::setWindowSeconds(0.05);
+  FlightRecorder::recordCounter("flight_recorder_test/old", 1.0);
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  FlightRecorder::recordCounter("flight_recorder_test/new", 2.0);
+  const std::vector<FlightRecorderEvent> events = FlightRecorder::getEvents();
+  ASSERT_EQ(events.size(), 1u);
+  EXPECT_EQ(events[0].value, 2.0);
+}
+
+TEST_F(FlightRecorderTest, ConcurrentRecording) {
+  constexpr int kNumThreads = 4;
+  constexpr int kNumEventsPerThread = 200;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads.emplace_back([]() {
+      for (int j = 0; j < kNumEventsPerThread; ++j) {
+        FlightRecorder::recordCounter("flight_recorder_test/counter", j);
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  const std::vector<FlightRecorderEvent> events = FlightRecorder::getEvents();
+  EXPECT_EQ(events.size(), kNumThreads * kNumEventsPerThread);
+}
+
+TEST_F(FlightRecorderTest, DumpOnLatencySpike) {
+  FlightRecorder::setLatencyThresholdSeconds(0.1);
+  FlightRecorder::setMinSecondsBetweenDumps(100.0);
+  { Timer timer("flight_recorder_test/timer"); }
+
+  // Below the threshold.
+  EXPECT_FALSE(FlightRecorder::frameCompleted("slice", 0.05));
+  EXPECT_TRUE(FlightRecorder::lastDumpPath().empty());
+
+  // Above.
+  EXPECT_TRUE(FlightRecorder::frameCompleted("static/slice", 0.2));
+  FlightRecorder::waitForDump();
+  const std::string dump_path = FlightRecorder::lastDumpPath();
+  EXPECT_NE(dump_path.find("static_slice.json"), std::string::npos);
+  const std::string trace = readFile(dump_path);
+  EXPECT_NE(trace.find("flight_recorder_test/timer"), std::string::npos);
+  EXPECT_NE(trace.find("static/slice/latency_ms"), std::string::npos);
+  unlink(dump_path.c_str());
+
+  // Rate limited.
+  EXPECT_FALSE(FlightRecorder::frameCompleted("static/slice", 0.3));
+}
+
+TEST_F(FlightRecorderTest, DumpToFile) {
+  FlightRecorder::recordInstant("flight_recorder_test/\"quoted\"");
+  const std::string dump_path =
+      ::testing::TempDir() + "/flight_recorder_test.json";
+  ASSERT_TRUE(FlightRecorder::dumpToFile(dump_path));
+  EXPECT_EQ(FlightRecorder::lastDumpPath(), dump_path);
+  EXPECT_NE(readFile(dump_path).find("flight_recorder_test/\\\"quoted\\\""),
+            std::string::npos);
+  unlink(dump_path.c_str());
+  EXPECT_FALSE(FlightRecorder::dumpToFile("/nonexistent/directory/x.json"));
+}
+
+int main(int argc, char** argv) {
+  FLAGS_alsologtostderr = true;
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -389,6 +389,170 @@ TEST_F(FreespaceIntegratorTest, ViewExclusion) {
   EXPECT_GT(num_non_freespace_voxels, 0);
 }
 
+TEST_F(FreespaceIntegratorTest, InViewMasksMatchProjection) {
+  // The in-view masks recorded during TSDF integration should lead to the
+  // same freespace update as projecting the voxels into the view.
+  constexpr float kPlaneDistance = 2.0f;
+  scene_.addPrimitive(std::make_unique<primitives::Plane>(
+      Vector3f(kPlaneDistance, 0.0, 0.0), Vector3f(-1, 0, 0)));
+  Eigen::Quaternionf rotation_base(0.5, 0.5, 0.5, 0.5);
+  Transform T_L_C = Transform::Identity();
+  T_L_C.prerotate(rotation_base);
+  DepthImage depth_frame(camera_.height(), camera_.width(),
+                         MemoryType::kUnified);
+  scene_.generateDepthImageFromScene(camera_, T_L_C, 2.0f * kPlaneDistance,
+                                     &depth_frame);
+
+  // Integrate and record the voxels in view.
+  TsdfLayer tsdf_layer(voxel_size_m_, MemoryType::kUnified);
+  ProjectiveTsdfIntegrator tsdf_integrator;
+  const float occlusion_distance_m =
+      2.0f * tsdf_integrator.get_truncation_distance_m(voxel_size_m_);
+  tsdf_integrator.in_view_occlusion_distance_m(occlusion_distance_m);
+  std::vector<Index3D> updated_blocks;
+  tsdf_integrator.integrateFrame(depth_frame, T_L_C, camera_, &tsdf_layer,
+                                 &updated_blocks);
+  ASSERT_GT(updated_blocks.size(), 0);
+  EXPECT_EQ(tsdf_integrator.in_view_voxel_masks().size(),
+            updated_blocks.size());
+
+  const ViewBasedInclusionData view(
+      T_L_C, camera_, &depth_frame,
+      tsdf_integrator.max_integration_distance_m(), occlusion_distance_m);
+  const InViewVoxelMasks in_view_voxel_masks{
+      &updated_blocks, &tsdf_integrator.in_view_voxel_masks()};
+
+  // Update two freespace layers, with and without the masks.
+  for (const bool check_neighborhood : {false, true}) {
+    FreespaceLayer freespace_layer_projected(voxel_size_m_,
+                                             MemoryType::kUnified);
+    FreespaceLayer freespace_layer_masked(voxel_size_m_, MemoryType::kUnified);
+    FreespaceIntegrator freespace_integrator_projected;
+    FreespaceIntegrator freespace_integrator_masked;
+    freespace_integrator_projected.check_neighborhood(check_neighborhood);
+    freespace_integrator_masked.check_neighborhood(check_neighborhood);
+    const Time time_step_ms =
+        freespace_integrator_projected
+            .min_duration_since_occupied_for_freespace_ms();
+    const Time start_time_ms{42};
+    for (int i = 0; i < 3; i++) {
+      const Time update_time_ms = start_time_ms + i * time_step_ms;
+      freespace_integrator_projected.updateFreespaceLayer(
+          updated_blocks, update_time_ms, tsdf_layer, view,
+          &freespace_layer_projected);
+      freespace_integrator_masked.updateFreespaceLayer(
+          updated_blocks, update_time_ms, tsdf_layer, view,
+          &freespace_layer_masked, in_view_voxel_masks);
+    }
+
+    int num_freespace_voxels = 0;
+    callFunctionOnAllVoxels<FreespaceVoxel>(
+        freespace_layer_projected,
+        [&](const Index3D& block_idx, const Index3D& voxel_idx,
+            const FreespaceVoxel* voxel_projected) {
+          const FreespaceVoxel& voxel_masked =
+              freespace_layer_masked.getBlockAtIndex(block_idx)
+                  ->voxels[voxel_idx.x()][voxel_idx.y()][voxel_idx.z()];
+          EXPECT_EQ(voxel_projected->last_occupied_timestamp_ms,
+                    voxel_masked.last_occupied_timestamp_ms);
+          EXPECT_EQ(voxel_projected->consecutive_occupancy_duration_ms,
+                    voxel_masked.consecutive_occupancy_duration_ms);
+          EXPECT_EQ(voxel_projected->is_high_confidence_freespace,
+                    voxel_masked.is_high_confidence_freespace);
+          if (voxel_projected->is_high_confidence_freespace) {
+            ++num_freespace_voxels;
+          }
+        });
+    EXPECT_GT(num_freespace_voxels, 0);
+  }
+}
+
+void expectFreespaceLayersEqual(const FreespaceLayer& freespace_layer_1,
+                                const FreespaceLayer& freespace_layer_2) {
+  EXPECT_EQ(freespace_layer_1.numAllocatedBlocks(),
+            freespace_layer_2.numAllocatedBlocks());
+  callFunctionOnAllVoxels<FreespaceVoxel>(
+      freespace_layer_1,
+      [&](const Index3D& block_idx, const Index3D& voxel_idx,
+          const FreespaceVoxel* voxel_1) {
+        ASSERT_TRUE(freespace_layer_2.isBlockAllocated(block_idx));
+        const FreespaceVoxel& voxel_2 =
+            freespace_layer_2.getBlockAtIndex(block_idx)
+                ->voxels[voxel_idx.x()][voxel_idx.y()][voxel_idx.z()];
+        EXPECT_EQ(voxel_1->last_occupied_timestamp_ms,
+                  voxel_2.last_occupied_timestamp_ms);
+        EXPECT_EQ(voxel_1->consecutive_occupancy_duration_ms,
+                  voxel_2.consecutive_occupancy_duration_ms);
+        EXPECT_EQ(voxel_1->is_high_confidence_freespace,
+                  voxel_2.is_high_confidence_freespace);
+      });
+}
+
+TEST_F(FreespaceIntegratorTest, SkipSettledBlocks) {
+  // Skipping settled blocks should not change the freespace layer, also not
+  // once a surface appears in the settled freespace.
+  constexpr float kPlaneDistance = 2.0f;
+  scene_.addPrimitive(std::make_unique<primitives::Plane>(
+      Vector3f(kPlaneDistance, 0.0, 0.0), Vector3f(-1, 0, 0)));
+  Eigen::Quaternionf rotation_base(0.5, 0.5, 0.5, 0.5);
+  Transform T_L_C = Transform::Identity();
+  T_L_C.prerotate(rotation_base);
+  DepthImage depth_frame(camera_.height(), camera_.width(),
+                         MemoryType::kUnified);
+  scene_.generateDepthImageFromScene(camera_, T_L_C, 2.0f * kPlaneDistance,
+                                     &depth_frame);
+
+  TsdfLayer tsdf_layer(voxel_size_m_, MemoryType::kUnified);
+  ProjectiveTsdfIntegrator tsdf_integrator;
+  std::vector<Index3D> updated_blocks;
+  tsdf_integrator.integrateFrame(depth_frame, T_L_C, camera_, &tsdf_layer,
+                                 &updated_blocks);
+  ASSERT_GT(updated_blocks.size(), 0);
+
+  FreespaceLayer freespace_layer_all(voxel_size_m_, MemoryType::kUnified);
+  FreespaceLayer freespace_layer_skipped(voxel_size_m_, MemoryType::kUnified);
+  FreespaceIntegrator freespace_integrator_all;
+  FreespaceIntegrator freespace_integrator_skipped;
+  freespace_integrator_all.skip_settled_blocks(false);
+  EXPECT_TRUE(freespace_integrator_skipped.skip_settled_blocks());
+  const Time time_step_ms =
+      freespace_integrator_all.min_duration_since_occupied_for_freespace_ms();
+  Time update_time_ms{42};
+  auto update_both = [&]() {
+    freespace_integrator_all.updateFreespaceLayer(
+        updated_blocks, update_time_ms, tsdf_layer, std::nullopt,
+        &freespace_layer_all);
+    freespace_integrator_skipped.updateFreespaceLayer(
+        updated_blocks, update_time_ms, tsdf_layer, std::nullopt,
+        &freespace_layer_skipped);
+    update_time_ms += time_step_ms;
+  };
+
+  // The blocks in front of the plane settle once they're freespace.
+  constexpr int kNumUpdates = 4;
+  for (int i = 0; i < kNumUpdates; i++) {
+    update_both();
+  }
+  EXPECT_EQ(freespace_integrator_all.num_skipped_blocks(), 0u);
+  EXPECT_GT(freespace_integrator_skipped.num_skipped_blocks(), 0);
+  EXPECT_LT(freespace_integrator_skipped.num_skipped_blocks(),
+            updated_blocks.size());
+  expectFreespaceLayersEqual(freespace_layer_all, freespace_layer_skipped);
+
+  // Move the plane closer, into the settled freespace.
+  scene_.clear();
+  scene_.addPrimitive(std::make_unique<primitives::Plane>(
+      Vector3f(kPlaneDistance / 2.0f, 0.0, 0.0), Vector3f(-1, 0, 0)));
+  scene_.generateDepthImageFromScene(camera_, T_L_C, 2.0f * kPlaneDistance,
+                                     &depth_frame);
+  for (int i = 0; i < kNumUpdates; i++) {
+    tsdf_integrator.integrateFrame(depth_frame, T_L_C, camera_, &tsdf_layer,
+                                   &updated_blocks);
+    update_both();
+  }
+  expectFreespaceLayersEqual(freespace_layer_all, freespace_layer_skipped);
+}
+
 int main(int argc, char** argv) {
   FLAGS_alsologtostderr = true;
   google::InitGoogleLogging(argv[0]);
@@ -14,8 +14,10 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include <gtest/gtest.h>
+#include <algorithm>
 #include <string>
 
+#include "nvblox/core/hash.h"
 #include "nvblox/core/indexing.h"
 #include "nvblox/core/internal/warmup_cuda.h"
 #include "nvblox/core/types.h"
@@ -434,6 +436,85 @@ TEST_F(FrustumTest, ViewpointCache) {
   EXPECT_EQ(blocks_in_view_1.size(), blocks_in_view_2.size());
 }
 
+TEST_F(FrustumTest, ViewpointCacheKeyedOnViewExtent) {
+  // Two view calculators sharing a cache, as the TSDF and color integrators
+  // of a mapper do.
+  auto viewpoint_cache = std::make_shared<ViewpointCache>();
+  ViewCalculator view_calculator_1;
+  ViewCalculator view_calculator_2;
+  view_calculator_1.set_viewpoint_cache(
+      viewpoint_cache, ViewCalculator::CalculationType::kPlanes);
+  view_calculator_2.set_viewpoint_cache(
+      viewpoint_cache, ViewCalculator::CalculationType::kPlanes);
+
+  const Transform T_L_C = Transform::Identity();
+  constexpr float kShortDistance = 2.0f;
+  constexpr float kLongDistance = 5.0f;
+  const std::vector<Index3D> blocks_short =
+      view_calculator_1.getBlocksInViewPlanes(T_L_C, *camera_, block_size_,
+                                              kShortDistance);
+
+  // The same viewpoint with a longer distance must not hit the cached result.
+  const std::vector<Index3D> blocks_long =
+      view_calculator_2.getBlocksInViewPlanes(T_L_C, *camera_, block_size_,
+                                              kLongDistance);
+  EXPECT_GT(blocks_short.size(), 0);
+  EXPECT_GT(blocks_long.size(), blocks_short.size());
+
+  // Both views are now cached, for either view calculator.
+  EXPECT_TRUE(viewpoint_cache
+                  ->getCachedResult(T_L_C, *camera_,
+                                    {block_size_, kShortDistance})
+                  .has_value());
+  EXPECT_EQ(view_calculator_2
+                .getBlocksInViewPlanes(T_L_C, *camera_, block_size_,
+                                       kShortDistance)
+                .size(),
+            blocks_short.size());
+  EXPECT_EQ(view_calculator_1
+                .getBlocksInViewPlanes(T_L_C, *camera_, block_size_,
+                                       kLongDistance)
+                .size(),
+            blocks_long.size());
+}
+
+TEST_F(FrustumTest, HierarchicalPlanesCulling) {
+  // A long range view, such that most of the groups of blocks are far from the
+  // frustum boundary.
+  constexpr float kMaxDistance = 20.0f;
+
+  ViewCalculator hierarchical_view_calculator;
+  hierarchical_view_calculator.cache_last_viewpoint(false);
+  hierarchical_view_calculator.hierarchical_planes_culling(true);
+  EXPECT_FALSE(view_calculator_.hierarchical_planes_culling());
+
+  // Some arbitrary poses.
+  std::vector<Transform> poses;
+  poses.push_back(Transform::Identity());
+  Transform T_L_C = Transform::Identity();
+  T_L_C.prerotate(Eigen::Quaternionf(0.5, 0.5, 0.5, 0.5));
+  T_L_C.pretranslate(Vector3f(1.3f, -0.7f, 0.4f));
+  poses.push_back(T_L_C);
+  T_L_C.prerotate(
+      Eigen::AngleAxisf(0.3f, Vector3f(0.2f, 1.0f, 0.5f).normalized()));
+  poses.push_back(T_L_C);
+
+  for (const Transform& pose : poses) {
+    std::vector<Index3D> blocks_flat = view_calculator_.getBlocksInViewPlanes(
+        pose, *camera_, block_size_, kMaxDistance);
+    std::vector<Index3D> blocks_hierarchical =
+        hierarchical_view_calculator.getBlocksInViewPlanes(
+            pose, *camera_, block_size_, kMaxDistance);
+
+    // Same set of blocks, possibly in a different order.
+    EXPECT_GT(blocks_flat.size(), 0);
+    std::sort(blocks_flat.begin(), blocks_flat.end(), VectorCompare<Index3D>());
+    std::sort(blocks_hierarchical.begin(), blocks_hierarchical.end(),
+              VectorCompare<Index3D>());
+    EXPECT_EQ(blocks_flat, blocks_hierarchical);
+  }
+}
+
 int main(int argc, char** argv) {
   google::InitGoogleLogging(argv[0]);
   FLAGS_alsologtostderr = true;
@@ -179,6 +179,35 @@ TEST(FuserTest, CommandLineFlags) {
                    .deallocate_decayed_blocks());
 }
 
+TEST(FuserTest, OutputPathSuffix) {
+  Fuser fuser;
+  fuser.mesh_output_path_ = "/tmp/outputs/mesh.ply";
+  fuser.map_output_path_ = "./map";
+  fuser.dynamic_overlay_path_ = "/tmp/overlays.d/";
+  fuser.timing_output_path_ = "timings.txt";
+  fuser.appendOutputPathSuffix("_3");
+  EXPECT_EQ(fuser.mesh_output_path_, "/tmp/outputs/mesh_3.ply");
+  EXPECT_EQ(fuser.map_output_path_, "./map_3");
+  EXPECT_EQ(fuser.dynamic_overlay_path_, "/tmp/overlays.d/_3");
+  // Unset paths stay unset, and the timings are shared.
+  EXPECT_TRUE(fuser.esdf_output_path_.empty());
+  EXPECT_EQ(fuser.timing_output_path_, "timings.txt");
+}
+
+TEST(FuserTest, NumConcurrentSequences) {
+  BatchFuserParams params;
+  params.device_memory_per_sequence_bytes = 100;
+  // Limited by device memory.
+  EXPECT_EQ(getNumConcurrentSequences(params, 10, 450), 4);
+  // Limited by the number of sequences.
+  EXPECT_EQ(getNumConcurrentSequences(params, 2, 450), 2);
+  // Limited by the params.
+  params.max_concurrent_sequences = 3;
+  EXPECT_EQ(getNumConcurrentSequences(params, 10, 450), 3);
+  // Always at least one.
+  EXPECT_EQ(getNumConcurrentSequences(params, 10, 50), 1);
+}
+
 int main(int argc, char** argv) {
   FLAGS_alsologtostderr = true;
   google::InitGoogleLogging(argv[0]);
@@ -0,0 +1,119 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+
+#include "nvblox/map/gpu_blocks_to_update_tracker.h"
+
+namespace nvblox {
+
+std::vector<Index3D> sorted(std::vector<Index3D> indices) {
+  std::sort(indices.begin(), indices.end(),
+            [](const Index3D& a, const Index3D& b) {
+              return std::lexicographical_compare(a.data(), a.data() + 3,
+                                                  b.data(), b.data() + 3);
+            });
+  return indices;
+}
+
+TEST(GpuBlocksToUpdateTrackerTest, AddRemoveAndMark) {
+  CudaStreamOwning cuda_stream;
+  GpuBlocksToUpdateTracker tracker(ProjectiveLayerType::kTsdf);
+  tracker.trackCheckpointBlocks(true, cuda_stream);
+
+  device_vector<Index3D> blocks_device;
+  blocks_device.copyFromAsync(
+      std::vector<Index3D>{Index3D(0, 0, 0), Index3D(1, 2, 3),
+                           Index3D(0, 0, 0)},
+      cuda_stream);
+  tracker.addBlocksToUpdateAsync(blocks_device, cuda_stream);
+
+  const std::vector<Index3D> expected = {Index3D(0, 0, 0), Index3D(1, 2, 3)};
+  EXPECT_EQ(sorted(tracker.getBlocksToUpdate(BlocksToUpdateType::kEsdf,
+                                             cuda_stream)),
+            expected);
+  EXPECT_EQ(sorted(tracker.getBlocksToUpdate(BlocksToUpdateType::kMesh,
+                                             cuda_stream)),
+            expected);
+  // No freespace layer, and ground plane blocks are not tracked.
+  EXPECT_TRUE(
+      tracker.getBlocksToUpdate(BlocksToUpdateType::kFreespace, cuda_stream)
+          .empty());
+  EXPECT_TRUE(
+      tracker.getBlocksToUpdate(BlocksToUpdateType::kGroundPlane, cuda_stream)
+          .empty());
+
+  // Removed blocks leave the sets, but stay checkpoint blocks.
+  device_vector<Index3D> removed_device;
+  removed_device.copyFromAsync(std::vector<Index3D>{Index3D(1, 2, 3)},
+                               cuda_stream);
+  tracker.removeBlocksToUpdateAsync(removed_device, cuda_stream);
+  EXPECT_EQ(
+      tracker.getBlocksToUpdate(BlocksToUpdateType::kEsdf, cuda_stream),
+      std::vector<Index3D>{Index3D(0, 0, 0)});
+  EXPECT_EQ(sorted(tracker.getBlocksToUpdate(BlocksToUpdateType::kCheckpoint,
+                                             cuda_stream)),
+            expected);
+
+  // Marking one type as updated leaves the others.
+  tracker.markBlocksAsUpdated(BlocksToUpdateType::kEsdf, cuda_stream);
+  EXPECT_TRUE(
+      tracker.getBlocksToUpdate(BlocksToUpdateType::kEsdf, cuda_stream)
+          .empty());
+  EXPECT_EQ(
+      tracker.getBlocksToUpdate(BlocksToUpdateType::kMesh, cuda_stream),
+      std::vector<Index3D>{Index3D(0, 0, 0)});
+}
+
+TEST(GpuBlocksToUpdateTrackerTest, GrowBeyondInitialCapacity) {
+  CudaStreamOwning cuda_stream;
+  GpuBlocksToUpdateTracker tracker(ProjectiveLayerType::kTsdfWithFreespace);
+
+  // Add many more blocks than initially fit, in several batches.
+  constexpr int kNumBatches = 10;
+  const int kBlocksPerBatch = GpuBlocksToUpdateTracker::kInitialCapacity;
+  for (int batch = 0; batch < kNumBatches; ++batch) {
+    std::vector<Index3D> blocks;
+    for (int i = 0; i < kBlocksPerBatch; ++i) {
+      blocks.push_back(Index3D(i, batch, 0));
+    }
+    device_vector<Index3D> blocks_device;
+    blocks_device.copyFromAsync(blocks, cuda_stream);
+    tracker.addBlocksToUpdateAsync(blocks_device, cuda_stream);
+    cuda_stream.synchronize();
+  }
+  EXPECT_EQ(
+      tracker.getBlocksToUpdate(BlocksToUpdateType::kFreespace, cuda_stream)
+          .size(),
+      kNumBatches * kBlocksPerBatch);
+  EXPECT_EQ(
+      tracker.getBlocksToUpdate(BlocksToUpdateType::kLayerStreamer, cuda_stream)
+          .size(),
+      kNumBatches * kBlocksPerBatch);
+}
+
+}  // namespace nvblox
+
+int main(int argc, char** argv) {
+  FLAGS_alsologtostderr = true;
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
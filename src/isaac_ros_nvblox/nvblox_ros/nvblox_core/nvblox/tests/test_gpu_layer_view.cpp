@@ -218,6 +218,91 @@ TEST(GpuHashTest, InsertAndRemove) {
   CHECK_EQ(gpu_layer.size(), blocks_to_insert.size() - blocks_to_remove.size());
 }
 
+// Grow the hash in the background and check that it keeps its content.
+TEST(GpuHashTest, StagedGrowth) {
+  constexpr int kInitialCapacity = 100;
+  GPULayerView<TsdfBlock> gpu_layer(kInitialCapacity);
+  const size_t initial_capacity = gpu_layer.capacity();
+
+  // Fill up just beyond the staged growth threshold. This starts the growth
+  // but doesn't yet change the hash.
+  const float growth_threshold =
+      gpu_layer.staged_growth_load_factor() * initial_capacity;
+  const int num_blocks_first = static_cast<int>(std::ceil(growth_threshold)) + 1;
+  gpu_layer.insertBlocksAsync(getBlocks(num_blocks_first, 0),
+                              CudaStreamOwning());
+  gpu_layer.flushCache(CudaStreamOwning());
+  EXPECT_TRUE(gpu_layer.isGrowing());
+  EXPECT_EQ(gpu_layer.capacity(), initial_capacity);
+
+  // The next modification swaps in the grown hash.
+  gpu_layer.removeBlocksAsync({Index3D{0, 0, 0}}, CudaStreamOwning());
+  gpu_layer.insertBlocksAsync(getBlocks(1, num_blocks_first),
+                              CudaStreamOwning());
+  gpu_layer.flushCache(CudaStreamOwning());
+  EXPECT_FALSE(gpu_layer.isGrowing());
+  EXPECT_GT(gpu_layer.capacity(), initial_capacity);
+  EXPECT_EQ(gpu_layer.size(), static_cast<size_t>(num_blocks_first));
+
+  std::vector<Index3D> indices;
+  for (int i = 0; i <= num_blocks_first; ++i) {
+    indices.push_back(Index3D{i, 0, 0});
+  }
+  const std::vector<bool> flags =
+      test_utils::getContainsFlags(gpu_layer, indices);
+  EXPECT_FALSE(flags[0]);
+  for (size_t i = 1; i < flags.size(); ++i) {
+    EXPECT_TRUE(flags[i]);
+  }
+}
+
+TEST(GpuHashTest, Statistics) {
+  constexpr int kInitialCapacity = 10;
+  constexpr int kNumBlocks = 1000;
+  GPULayerView<TsdfBlock> gpu_layer(kInitialCapacity);
+  gpu_layer.insertBlocksAsync(getBlocks(kNumBlocks, 0), CudaStreamOwning());
+  gpu_layer.flushCache(CudaStreamOwning());
+
+  const GPUHashStatistics& statistics = gpu_layer.statistics();
+  EXPECT_EQ(statistics.num_inserted_blocks, static_cast<uint64_t>(kNumBlocks));
+  EXPECT_EQ(statistics.num_flushes, 1u);
+  // The flush doesn't fit the initial capacity.
+  EXPECT_GE(statistics.num_synchronous_rehashes, 1u);
+  EXPECT_GT(statistics.max_rehash_seconds, 0.0);
+  ASSERT_EQ(statistics.load_factor_history.size(), 1u);
+  EXPECT_FLOAT_EQ(statistics.load_factor_history.back(),
+                  gpu_layer.loadFactor());
+  EXPECT_EQ(statistics.peak_load_factor, gpu_layer.loadFactor());
+
+  // Not sampled yet with the default period.
+  EXPECT_EQ(statistics.numProbeLengthSamples(), 0u);
+  gpu_layer.sampleProbeLengths(CudaStreamOwning());
+  EXPECT_GT(statistics.numProbeLengthSamples(), 0u);
+  EXPECT_LE(statistics.numProbeLengthSamples(),
+            static_cast<uint64_t>(kNumBlocks));
+  EXPECT_GE(statistics.meanProbeLength(), 1.0f);
+
+  gpu_layer.removeBlocksAsync({Index3D{0, 0, 0}}, CudaStreamOwning());
+  gpu_layer.flushCache(CudaStreamOwning());
+  EXPECT_EQ(statistics.num_removed_blocks, 1u);
+  EXPECT_EQ(statistics.num_flushes, 2u);
+
+  gpu_layer.reset();
+  EXPECT_EQ(gpu_layer.statistics().num_inserted_blocks, 0u);
+  EXPECT_EQ(gpu_layer.statistics().numProbeLengthSamples(), 0u);
+}
+
+TEST(GpuHashTest, PeriodicProbeLengthSampling) {
+  GPULayerView<TsdfBlock> gpu_layer;
+  gpu_layer.probe_length_sampling_period(2);
+  gpu_layer.insertBlocksAsync(getBlocks(10, 0), CudaStreamOwning());
+  gpu_layer.flushCache(CudaStreamOwning());
+  EXPECT_EQ(gpu_layer.statistics().numProbeLengthSamples(), 0u);
+  gpu_layer.insertBlocksAsync(getBlocks(10, 10), CudaStreamOwning());
+  gpu_layer.flushCache(CudaStreamOwning());
+  EXPECT_GT(gpu_layer.statistics().numProbeLengthSamples(), 0u);
+}
+
 int main(int argc, char** argv) {
   FLAGS_alsologtostderr = true;
   google::InitGoogleLogging(argv[0]);
@@ -0,0 +1,140 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include "nvblox/core/cuda_stream.h"
+#include "nvblox/core/internal/error_check.h"
+#include "nvblox/core/unified_vector.h"
+#include "nvblox/utils/gpu_timing.h"
+
+using namespace nvblox;
+
+class GpuTimingTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    timing::GpuTiming::SetEnabled(true);
+    timing::GpuTiming::Reset();
+    buffer_.resizeAsync(kNumBytes, stream_);
+  }
+
+  // Issue some work on the stream.
+  void issueWork() {
+    checkCudaErrors(
+        cudaMemsetAsync(buffer_.data(), 0, buffer_.size(), stream_));
+  }
+
+  static constexpr size_t kNumBytes = 1 << 20;
+  CudaStreamOwning stream_;
+  device_vector<uint8_t> buffer_;
+};
+
+TEST_F(GpuTimingTest, RecordsSamples) {
+  const std::string tag = "test/records_samples";
+  constexpr int kNumTimers = 10;
+  for (int i = 0; i < kNumTimers; ++i) {
+    timing::GpuTimer timer(tag, stream_);
+    issueWork();
+  }
+  timing::GpuTiming::ResolveAll();
+  EXPECT_EQ(timing::GpuTiming::NumPending(), 0u);
+
+  const timing::GpuTimingStats stats = timing::GpuTiming::GetStats(tag);
+  EXPECT_EQ(stats.num_samples, kNumTimers);
+  EXPECT_GE(stats.mean_ms, 0.0f);
+  EXPECT_LE(stats.p50_ms, stats.p90_ms);
+  EXPECT_LE(stats.p90_ms, stats.p99_ms);
+  EXPECT_LE(stats.p99_ms, stats.max_ms);
+  EXPECT_LE(stats.mean_ms, stats.max_ms);
+  EXPECT_EQ(timing::GpuTiming::GetAllStats().count(tag), 1u);
+}
+
+TEST_F(GpuTimingTest, ResolvesWithoutBlocking) {
+  const std::string tag = "test/resolves_without_blocking";
+  {
+    timing::GpuTimer timer(tag, stream_);
+    issueWork();
+  }
+  // Once the stream is done the timer resolves on the next query.
+  stream_.synchronize();
+  EXPECT_EQ(timing::GpuTiming::GetStats(tag).num_samples, 1);
+  EXPECT_EQ(timing::GpuTiming::NumPending(), 0u);
+}
+
+TEST_F(GpuTimingTest, WindowIsBounded) {
+  const std::string tag = "test/window_is_bounded";
+  for (int i = 0; i < timing::GpuTiming::kWindowSize + 10; ++i) {
+    timing::GpuTimer timer(tag, stream_);
+  }
+  timing::GpuTiming::ResolveAll();
+  EXPECT_EQ(timing::GpuTiming::GetStats(tag).num_samples,
+            timing::GpuTiming::kWindowSize);
+}
+
+TEST_F(GpuTimingTest, StopAndRestart) {
+  const std::string tag = "test/stop_and_restart";
+  timing::GpuTimer timer(tag, stream_, true);
+  EXPECT_FALSE(timer.IsTiming());
+  timer.Start();
+  EXPECT_TRUE(timer.IsTiming());
+  issueWork();
+  timer.Stop();
+  EXPECT_FALSE(timer.IsTiming());
+  timer.Start();
+  issueWork();
+  timer.Stop();
+  timing::GpuTiming::ResolveAll();
+  EXPECT_EQ(timing::GpuTiming::GetStats(tag).num_samples, 2);
+}
+
+TEST_F(GpuTimingTest, Disabled) {
+  const std::string tag = "test/disabled";
+  timing::GpuTiming::SetEnabled(false);
+  {
+    timing::GpuTimer timer(tag, stream_);
+    EXPECT_FALSE(timer.IsTiming());
+    issueWork();
+  }
+  timing::GpuTiming::SetEnabled(true);
+  timing::GpuTiming::ResolveAll();
+  EXPECT_EQ(timing::GpuTiming::GetStats(tag).num_samples, 0);
+}
+
+TEST_F(GpuTimingTest, IgnoredDuringGraphCapture) {
+  const std::string tag = "test/graph_capture";
+  stream_.synchronize();
+  checkCudaErrors(
+      cudaStreamBeginCapture(stream_, cudaStreamCaptureModeThreadLocal));
+  {
+    timing::GpuTimer timer(tag, stream_);
+    EXPECT_FALSE(timer.IsTiming());
+    issueWork();
+  }
+  cudaGraph_t graph;
+  checkCudaErrors(cudaStreamEndCapture(stream_, &graph));
+  checkCudaErrors(cudaGraphDestroy(graph));
+  timing::GpuTiming::ResolveAll();
+  EXPECT_EQ(timing::GpuTiming::GetStats(tag).num_samples, 0);
+}
+
+int main(int argc, char** argv) {
+  google::InitGoogleLogging(argv[0]);
+  FLAGS_alsologtostderr = true;
+  google::InstallFailureSignalHandler();
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
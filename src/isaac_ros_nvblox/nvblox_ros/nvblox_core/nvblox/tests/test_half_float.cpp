@@ -0,0 +1,74 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include "nvblox/core/half_float.h"
+#include "nvblox/map/voxels.h"
+
+namespace nvblox {
+
+TEST(HalfFloat, RoundTrip) {
+  // Exactly representable values survive the round trip.
+  for (const float value : {0.0f, 1.0f, -1.0f, 0.5f, -0.25f, 5.0f}) {
+    const HalfFloat half(value);
+    EXPECT_EQ(static_cast<float>(half), value);
+  }
+  // Typical TSDF distances keep roughly 3 significant digits.
+  constexpr float kDistance = 0.1234f;
+  EXPECT_NEAR(static_cast<float>(HalfFloat(kDistance)), kDistance, 1e-4f);
+}
+
+TEST(HalfFloat, Saturates) {
+  const HalfFloat large(1e6f);
+  EXPECT_EQ(static_cast<float>(large), HalfFloat::kMaxValue);
+  const HalfFloat small(-1e6f);
+  EXPECT_EQ(static_cast<float>(small), -HalfFloat::kMaxValue);
+}
+
+TEST(HalfFloat, Arithmetic) {
+  HalfFloat value = 1.0f;
+  value += 2.0f;
+  EXPECT_EQ(static_cast<float>(value), 3.0f);
+  value *= 0.5f;
+  EXPECT_EQ(static_cast<float>(value), 1.5f);
+  value -= 0.5f;
+  EXPECT_EQ(static_cast<float>(value), 1.0f);
+  value /= 4.0f;
+  EXPECT_EQ(static_cast<float>(value), 0.25f);
+}
+
+TEST(HalfFloat, TsdfVoxelSize) {
+#ifdef NVBLOX_HALF_PRECISION_TSDF
+  EXPECT_EQ(sizeof(TsdfVoxel), 4);
+#else
+  EXPECT_EQ(sizeof(TsdfVoxel), 8);
+#endif
+  TsdfVoxel voxel;
+  EXPECT_EQ(voxel.distance, 0.0f);
+  EXPECT_EQ(voxel.weight, 0.0f);
+}
+
+}  // namespace nvblox
+
+int main(int argc, char** argv) {
+  FLAGS_alsologtostderr = true;
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -150,6 +150,68 @@ TEST_P(ParameterizedImageMaskerTest, RandomMask) {
   }
 }
 
+TEST_P(ParameterizedImageMaskerTest, FusedSplitMatchesSeparateSplits) {
+  std::srand(0);
+  const int rows = 480;
+  const int cols = 640;
+  const int size_addon = GetParam();
+  DepthImage depth(rows, cols, MemoryType::kUnified);
+  ColorImage color(rows + size_addon, cols + size_addon, MemoryType::kUnified);
+  MonoImage mask(rows + size_addon, cols + size_addon, MemoryType::kUnified);
+  const Camera depth_camera = getTestCamera(cols, rows);
+  const Camera mask_camera =
+      getTestCamera(cols + size_addon, rows + size_addon);
+
+  // Random depth, with some invalid pixels, color and mask.
+  for (int i = 0; i < depth.numel(); i++) {
+    depth(i) = (std::rand() % 10 == 0)
+                   ? std::numeric_limits<float>::infinity()
+                   : 0.5f + static_cast<float>(std::rand() % 100) / 10.0f;
+  }
+  for (int i = 0; i < mask.numel(); i++) {
+    mask(i) = std::rand() % 2;
+    color(i) = Color(std::rand() % 256, std::rand() % 256, std::rand() % 256);
+  }
+
+  // Offset cameras, such that the occlusion test matters.
+  Transform T_CM_CD = Transform::Identity();
+  T_CM_CD.pretranslate(Vector3f(0.1, 0.05, 0.0));
+
+  ImageMasker image_masker;
+  DepthImage unmasked_depth(MemoryType::kDevice);
+  DepthImage masked_depth(MemoryType::kDevice);
+  ColorImage unmasked_color(MemoryType::kDevice);
+  ColorImage masked_color(MemoryType::kDevice);
+  ColorImage depth_overlay(MemoryType::kDevice);
+  ColorImage color_overlay(MemoryType::kDevice);
+  image_masker.splitImageOnGPU(depth, mask, T_CM_CD, depth_camera, mask_camera,
+                               &unmasked_depth, &masked_depth, &depth_overlay);
+  image_masker.splitImageOnGPU(color, mask, &unmasked_color, &masked_color,
+                               &color_overlay);
+
+  DepthImage unmasked_depth_fused(MemoryType::kDevice);
+  DepthImage masked_depth_fused(MemoryType::kDevice);
+  ColorImage unmasked_color_fused(MemoryType::kDevice);
+  ColorImage masked_color_fused(MemoryType::kDevice);
+  ColorImage depth_overlay_fused(MemoryType::kDevice);
+  ColorImage color_overlay_fused(MemoryType::kDevice);
+  image_masker.splitImagesOnGPU(
+      depth, color, mask, T_CM_CD, depth_camera, mask_camera,
+      &unmasked_depth_fused, &masked_depth_fused, &unmasked_color_fused,
+      &masked_color_fused, &depth_overlay_fused, &color_overlay_fused);
+
+  for (int i = 0; i < depth.numel(); i++) {
+    EXPECT_EQ(unmasked_depth(i), unmasked_depth_fused(i));
+    EXPECT_EQ(masked_depth(i), masked_depth_fused(i));
+    EXPECT_EQ(depth_overlay(i), depth_overlay_fused(i));
+  }
+  for (int i = 0; i < color.numel(); i++) {
+    EXPECT_EQ(unmasked_color(i), unmasked_color_fused(i));
+    EXPECT_EQ(masked_color(i), masked_color_fused(i));
+    EXPECT_EQ(color_overlay(i), color_overlay_fused(i));
+  }
+}
+
 // We test the cases where the mask resolution is bigger, smaller and equal to
 // the depth resolution
 INSTANTIATE_TEST_CASE_P(ParameterizedImageMaskerTests,
@@ -1,5 +1,7 @@
 #include <gtest/gtest.h>
 
+#include <algorithm>
+
 #include "nvblox/io/image_io.h"
 #include "nvblox/io/pointcloud_io.h"
 #include "nvblox/primitives/primitives.h"
@@ -114,6 +116,99 @@ TEST(ImageProjectorTest, BackProjection) {
   }
 }
 
+namespace {
+
+std::vector<Vector3f> sortedPoints(std::vector<Vector3f> points) {
+  std::sort(points.begin(), points.end(),
+            [](const Vector3f& a, const Vector3f& b) {
+              return std::lexicographical_compare(a.data(), a.data() + 3,
+                                                  b.data(), b.data() + 3);
+            });
+  return points;
+}
+
+}  // namespace
+
+TEST(ImageProjectorTest, BatchBackProjectionMatchesSingleImages) {
+  // Two cameras of different sizes and poses.
+  const Camera camera_1(100.0f, 100.0f, 32.0f, 24.0f, 64, 48);
+  const Camera camera_2(50.0f, 50.0f, 16.0f, 12.0f, 32, 24);
+  DepthImage depth_image_1(48, 64, MemoryType::kUnified);
+  DepthImage depth_image_2(24, 32, MemoryType::kUnified);
+  for (int row = 0; row < 48; row++) {
+    for (int col = 0; col < 64; col++) {
+      depth_image_1(row, col) = 1.0f + 0.01f * col;
+    }
+  }
+  for (int row = 0; row < 24; row++) {
+    for (int col = 0; col < 32; col++) {
+      // Some invalid and some too distant pixels.
+      depth_image_2(row, col) = (col < 4) ? 0.0f : (row < 2 ? 50.0f : 2.0f);
+    }
+  }
+  Transform T_L_C1 = Transform::Identity();
+  Transform T_L_C2 = Transform::Identity();
+  T_L_C2.prerotate(Eigen::AngleAxisf(0.5f, Vector3f::UnitZ()));
+  T_L_C2.pretranslate(Vector3f(1.0f, -2.0f, 0.5f));
+  const std::vector<BackProjectionFrame> frames = {
+      {&depth_image_1, &camera_1, T_L_C1}, {&depth_image_2, &camera_2, T_L_C2}};
+  constexpr float kMaxDistance = 10.0f;
+
+  DepthImageBackProjector image_back_projector;
+  Pointcloud pointcloud_1_L(MemoryType::kUnified);
+  Pointcloud pointcloud_2_L(MemoryType::kUnified);
+  image_back_projector.backProjectBatchOnGPU(
+      frames, {&pointcloud_1_L, &pointcloud_2_L}, kMaxDistance);
+
+  // Compare to back projecting the images one by one.
+  std::vector<Vector3f> all_points_L;
+  const std::vector<Pointcloud*> batch_pointclouds = {&pointcloud_1_L,
+                                                      &pointcloud_2_L};
+  for (size_t i = 0; i < frames.size(); i++) {
+    Pointcloud pointcloud_C(MemoryType::kUnified);
+    image_back_projector.backProjectOnGPU(
+        *frames[i].depth_image, *frames[i].camera, &pointcloud_C, kMaxDistance);
+    std::vector<Vector3f> expected_points_L;
+    for (const Vector3f& p_C : pointcloud_C.points()) {
+      expected_points_L.push_back(frames[i].T_L_C * p_C);
+    }
+    const std::vector<Vector3f> points_L =
+        sortedPoints(batch_pointclouds[i]->points().toVectorAsync(
+            CudaStreamOwning()));
+    expected_points_L = sortedPoints(expected_points_L);
+    ASSERT_EQ(points_L.size(), expected_points_L.size());
+    for (size_t j = 0; j < points_L.size(); j++) {
+      EXPECT_LT((points_L[j] - expected_points_L[j]).norm(), 1e-4f);
+    }
+    all_points_L.insert(all_points_L.end(), expected_points_L.begin(),
+                        expected_points_L.end());
+  }
+  EXPECT_EQ(pointcloud_1_L.size(), 48 * 64);
+  EXPECT_EQ(pointcloud_2_L.size(), 22 * 28);
+
+  // The deduplicated voxel centers of all images match those of the merged
+  // pointcloud.
+  constexpr float kVoxelSize = 0.1f;
+  CudaStreamOwning cuda_stream;
+  Pointcloud all_pointcloud_L(MemoryType::kUnified);
+  all_pointcloud_L.copyFromAsync(all_points_L, cuda_stream);
+  cuda_stream.synchronize();
+  Pointcloud expected_voxel_centers_L(MemoryType::kUnified);
+  image_back_projector.pointcloudToVoxelCentersOnGPU(
+      all_pointcloud_L, kVoxelSize, &expected_voxel_centers_L);
+  Pointcloud voxel_centers_L(MemoryType::kUnified);
+  image_back_projector.backProjectBatchToVoxelCentersOnGPU(
+      frames, kVoxelSize, &voxel_centers_L, kMaxDistance);
+  const std::vector<Vector3f> voxel_centers =
+      sortedPoints(voxel_centers_L.points().toVectorAsync(CudaStreamOwning()));
+  const std::vector<Vector3f> expected_voxel_centers = sortedPoints(
+      expected_voxel_centers_L.points().toVectorAsync(CudaStreamOwning()));
+  ASSERT_EQ(voxel_centers.size(), expected_voxel_centers.size());
+  for (size_t i = 0; i < voxel_centers.size(); i++) {
+    EXPECT_LT((voxel_centers[i] - expected_voxel_centers[i]).norm(), 1e-4f);
+  }
+}
+
 int main(int argc, char** argv) {
   FLAGS_alsologtostderr = true;
   google::InitGoogleLogging(argv[0]);
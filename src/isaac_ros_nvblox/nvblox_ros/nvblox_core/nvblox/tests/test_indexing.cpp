@@ -15,6 +15,8 @@ limitations under the License.
 */
 #include <gtest/gtest.h>
 
+#include <algorithm>
+
 #include "nvblox/core/indexing.h"
 #include "nvblox/core/types.h"
 #include "nvblox/map/layer.h"
@@ -203,6 +205,40 @@ TEST_F(IndexingTest, ZIndexing) {
   }
 }
 
+TEST(IndexingTest, MortonCode) {
+  EXPECT_EQ(getMortonCodeFromBlockIndex(Index3D(0, 0, 0)) ^
+                getMortonCodeFromBlockIndex(Index3D(1, 0, 0)),
+            0b001);
+  EXPECT_EQ(getMortonCodeFromBlockIndex(Index3D(0, 0, 0)) ^
+                getMortonCodeFromBlockIndex(Index3D(0, 1, 0)),
+            0b010);
+  EXPECT_EQ(getMortonCodeFromBlockIndex(Index3D(0, 0, 0)) ^
+                getMortonCodeFromBlockIndex(Index3D(0, 0, 1)),
+            0b100);
+
+  // The order is preserved along each axis, also for negative indices.
+  for (int i = -10; i < 10; ++i) {
+    EXPECT_LT(getMortonCodeFromBlockIndex(Index3D(i, 2, -3)),
+              getMortonCodeFromBlockIndex(Index3D(i + 1, 2, -3)));
+    EXPECT_LT(getMortonCodeFromBlockIndex(Index3D(5, i, -3)),
+              getMortonCodeFromBlockIndex(Index3D(5, i + 1, -3)));
+    EXPECT_LT(getMortonCodeFromBlockIndex(Index3D(5, 2, i)),
+              getMortonCodeFromBlockIndex(Index3D(5, 2, i + 1)));
+  }
+
+  // The eight blocks of an aligned 2x2x2 cube are consecutive.
+  std::vector<uint64_t> codes;
+  for (int x = 2; x < 4; ++x) {
+    for (int y = -2; y < 0; ++y) {
+      for (int z = 4; z < 6; ++z) {
+        codes.push_back(getMortonCodeFromBlockIndex(Index3D(x, y, z)));
+      }
+    }
+  }
+  std::sort(codes.begin(), codes.end());
+  EXPECT_EQ(codes.back() - codes.front(), 7);
+}
+
 int main(int argc, char** argv) {
   google::InitGoogleLogging(argv[0]);
   FLAGS_alsologtostderr = true;
@@ -0,0 +1,123 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+
+#include "nvblox/mapper/mapper.h"
+#include "nvblox/utils/logging.h"
+
+using namespace nvblox;
+
+constexpr int kNumRows = 120;
+constexpr int kNumCols = 160;
+constexpr float kVoxelSizeM = 0.1f;
+
+Camera getTestCamera() {
+  return Camera(100.0f, 100.0f, kNumCols / 2.0f, kNumRows / 2.0f, kNumCols,
+                kNumRows);
+}
+
+template <typename T>
+void fill(ImageBase<T>* image, const T value) {
+  for (int y = 0; y < image->rows(); ++y) {
+    for (int x = 0; x < image->cols(); ++x) {
+      (*image)(y, x) = value;
+    }
+  }
+}
+
+LabelVoxel getLabelVoxel(const Mapper& mapper, const Vector3f& p_L) {
+  const auto [voxel, found] = mapper.label_layer().getVoxel(p_L);
+  EXPECT_TRUE(found);
+  return voxel;
+}
+
+TEST(LabelIntegrationTest, VoteSaturatesAndDecays) {
+  LabelVoxel voxel;
+  EXPECT_FALSE(voxel.has_label());
+  for (int i = 0; i < 2 * LabelVoxel::kMaxConfidence; ++i) {
+    voxel.observeLabel(3);
+  }
+  EXPECT_EQ(voxel.label(), 3);
+  EXPECT_EQ(voxel.confidence(), LabelVoxel::kMaxConfidence);
+  EXPECT_EQ(sizeof(LabelVoxel), 1);
+
+  // Another label has to outvote the current one before taking over.
+  for (int i = 0; i < LabelVoxel::kMaxConfidence; ++i) {
+    voxel.observeLabel(5);
+  }
+  EXPECT_FALSE(voxel.has_label());
+  voxel.observeLabel(5);
+  EXPECT_EQ(voxel.label(), 5);
+  EXPECT_EQ(voxel.confidence(), 1);
+
+  // Labels which don't fit are ignored.
+  voxel.observeLabel(LabelVoxel::kNumLabels);
+  EXPECT_EQ(voxel.label(), 5);
+  EXPECT_EQ(voxel.confidence(), 1);
+
+  // Free space clears the label.
+  voxel.observeFree();
+  EXPECT_FALSE(voxel.has_label());
+  EXPECT_EQ(voxel.label(), 0);
+}
+
+TEST(LabelIntegrationTest, LabelsFollowSurface) {
+  const Camera camera = getTestCamera();
+  Mapper mapper(kVoxelSizeM, MemoryType::kUnified);
+  EXPECT_FALSE(mapper.hasLabelLayer());
+
+  // A wall at 2m. The labels have half the resolution of the depth.
+  DepthImage depth(kNumRows, kNumCols, MemoryType::kUnified);
+  fill(&depth, 2.0f);
+  MonoImage mask(kNumRows, kNumCols, MemoryType::kUnified);
+  fill<uint8_t>(&mask, 255);
+  MonoImage labels(kNumRows / 2, kNumCols / 2, MemoryType::kUnified);
+  fill<uint8_t>(&labels, 7);
+  mapper.integrateDepth(MaskedDepthImageConstView(depth, mask), labels,
+                        Transform::Identity(), camera);
+  ASSERT_TRUE(mapper.hasLabelLayer());
+  EXPECT_EQ(mapper.label_layer().numAllocatedBlocks(),
+            mapper.tsdf_layer().numAllocatedBlocks());
+
+  const Vector3f p_surface_L(0.05f, 0.05f, 1.95f);
+  const Vector3f p_free_L(0.05f, 0.05f, 1.05f);
+  EXPECT_TRUE(getLabelVoxel(mapper, p_surface_L).has_label());
+  EXPECT_EQ(getLabelVoxel(mapper, p_surface_L).label(), 7);
+  EXPECT_FALSE(getLabelVoxel(mapper, p_free_L).has_label());
+
+  // Unmasked pixels don't vote for labels.
+  MonoImage empty_mask(kNumRows, kNumCols, MemoryType::kUnified);
+  fill<uint8_t>(&empty_mask, 0);
+  fill<uint8_t>(&labels, 2);
+  mapper.integrateDepth(MaskedDepthImageConstView(depth, empty_mask), labels,
+                        Transform::Identity(), camera);
+  EXPECT_EQ(getLabelVoxel(mapper, p_surface_L).label(), 7);
+
+  // Moving the wall backwards frees the labeled voxels.
+  fill(&depth, 4.0f);
+  mapper.integrateDepth(MaskedDepthImageConstView(depth, mask), labels,
+                        Transform::Identity(), camera);
+  EXPECT_FALSE(getLabelVoxel(mapper, p_surface_L).has_label());
+  EXPECT_EQ(getLabelVoxel(mapper, Vector3f(0.05f, 0.05f, 3.95f)).label(), 2);
+}
+
+int main(int argc, char** argv) {
+  FLAGS_alsologtostderr = true;
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
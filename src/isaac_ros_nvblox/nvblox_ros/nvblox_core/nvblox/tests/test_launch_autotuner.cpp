@@ -0,0 +1,175 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "nvblox/core/cuda_device.h"
+#include "nvblox/core/internal/error_check.h"
+#include "nvblox/core/launch_autotuner.h"
+#include "nvblox/core/unified_vector.h"
+#include "nvblox/integrators/projective_tsdf_integrator.h"
+#include "nvblox/map/accessors.h"
+#include "nvblox/primitives/scene.h"
+
+using namespace nvblox;
+
+class LaunchAutotunerTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    autotuner_.clear();
+    autotuner_.tuning_enabled(false);
+    autotuner_.setCacheFilePath("");
+  }
+  void TearDown() override { SetUp(); }
+
+  LaunchAutotuner& autotuner_ = LaunchAutotuner::getInstance();
+};
+
+TEST_F(LaunchAutotunerTest, DefaultWithoutTuning) {
+  CudaStreamOwning cuda_stream;
+  std::vector<int> launched;
+  autotuner_.launch(
+      "test/kernel", {1, 2, 3}, 2,
+      [&](int candidate) { launched.push_back(candidate); }, cuda_stream);
+  EXPECT_EQ(launched, std::vector<int>({2}));
+  const std::string model = getCudaDeviceModel(getCurrentCudaDevice());
+  EXPECT_FALSE(autotuner_.getSelectedCandidate(model, "test/kernel"));
+}
+
+TEST_F(LaunchAutotunerTest, SelectsFastestCandidate) {
+  constexpr int kNumTrials = 3;
+  autotuner_.tuning_enabled(true);
+  autotuner_.num_trials_per_candidate(kNumTrials);
+
+  // The work of the launches grows with the candidate.
+  CudaStreamOwning cuda_stream;
+  device_vector<uint8_t> buffer(64 * 1024 * 1024);
+  const std::vector<int> candidates = {1, 1024, 64 * 1024 * 1024};
+  std::vector<int> launched;
+  const auto launch_function = [&](int candidate) {
+    launched.push_back(candidate);
+    checkCudaErrors(
+        cudaMemsetAsync(buffer.data(), 0, candidate, cuda_stream));
+  };
+  for (size_t i = 0; i < kNumTrials * candidates.size(); ++i) {
+    autotuner_.launch("test/kernel", candidates, candidates.back(),
+                      launch_function, cuda_stream);
+  }
+  // Every candidate was tried the same number of times.
+  for (const int candidate : candidates) {
+    EXPECT_EQ(std::count(launched.begin(), launched.end(), candidate),
+              kNumTrials);
+  }
+  const std::optional<int> selected = autotuner_.getSelectedCandidate(
+      getCudaDeviceModel(getCurrentCudaDevice()), "test/kernel");
+  ASSERT_TRUE(selected.has_value());
+  EXPECT_NE(*selected, candidates.back());
+
+  // Further launches use the selected candidate.
+  launched.clear();
+  autotuner_.launch("test/kernel", candidates, candidates.back(),
+                    launch_function, cuda_stream);
+  EXPECT_EQ(launched, std::vector<int>({*selected}));
+}
+
+TEST_F(LaunchAutotunerTest, IgnoresUnavailableCandidate) {
+  const std::string model = getCudaDeviceModel(getCurrentCudaDevice());
+  autotuner_.setSelectedCandidate(model, "test/kernel", 7);
+  CudaStreamOwning cuda_stream;
+  std::vector<int> launched;
+  autotuner_.launch(
+      "test/kernel", {1, 2}, 2,
+      [&](int candidate) { launched.push_back(candidate); }, cuda_stream);
+  EXPECT_EQ(launched, std::vector<int>({2}));
+}
+
+TEST_F(LaunchAutotunerTest, CacheRoundTrip) {
+  const std::string cache_path = "./launch_autotuner_test_cache.txt";
+  autotuner_.setSelectedCandidate("Model_A_sm87", "test/kernel_a", 64);
+  autotuner_.setSelectedCandidate("Model_B_sm86", "test/kernel_a", 256);
+  autotuner_.setSelectedCandidate("Model_B_sm86", "test/kernel_b", 4);
+  ASSERT_TRUE(autotuner_.saveCache(cache_path));
+
+  autotuner_.clear();
+  EXPECT_FALSE(
+      autotuner_.getSelectedCandidate("Model_A_sm87", "test/kernel_a"));
+  ASSERT_TRUE(autotuner_.loadCache(cache_path));
+  EXPECT_EQ(autotuner_.getSelectedCandidate("Model_A_sm87", "test/kernel_a"),
+            64);
+  EXPECT_EQ(autotuner_.getSelectedCandidate("Model_B_sm86", "test/kernel_a"),
+            256);
+  EXPECT_EQ(autotuner_.getSelectedCandidate("Model_B_sm86", "test/kernel_b"),
+            4);
+  std::remove(cache_path.c_str());
+}
+
+TEST_F(LaunchAutotunerTest, TsdfIntegrationIndependentOfThreadBlockDepth) {
+  constexpr float kVoxelSizeM = 0.1f;
+  primitives::Scene scene;
+  scene.addPrimitive(std::make_unique<primitives::Plane>(
+      Vector3f(0.0f, 0.0f, 2.0f), Vector3f(0.0f, 0.0f, -1.0f)));
+  const Camera camera(300, 300, 320, 240, 640, 480);
+  const Transform T_S_C = Transform::Identity();
+  DepthImage depth_frame(camera.height(), camera.width(),
+                         MemoryType::kUnified);
+  scene.generateDepthImageFromScene(camera, T_S_C, 10.0f, &depth_frame);
+
+  const auto integrate = [&](int thread_block_depth) {
+    autotuner_.setSelectedCandidate(getCudaDeviceModel(getCurrentCudaDevice()),
+                                    "tsdf/integrate_blocks/camera",
+                                    thread_block_depth);
+    auto layer = std::make_unique<TsdfLayer>(kVoxelSizeM, MemoryType::kHost);
+    ProjectiveTsdfIntegrator integrator;
+    integrator.integrateFrame(depth_frame, T_S_C, camera, layer.get());
+    return layer;
+  };
+
+  const std::unique_ptr<TsdfLayer> reference_layer =
+      integrate(TsdfBlock::kThreadBlockDepth);
+  ASSERT_GT(reference_layer->numAllocatedBlocks(), 0);
+  for (int depth = TsdfBlock::kThreadBlockDepth / 2; depth >= 1; depth /= 2) {
+    const std::unique_ptr<TsdfLayer> layer = integrate(depth);
+    ASSERT_EQ(layer->numAllocatedBlocks(),
+              reference_layer->numAllocatedBlocks());
+    int num_different_voxels = 0;
+    callFunctionOnAllVoxels<TsdfVoxel>(
+        *layer, [&](const Index3D& block_index, const Index3D& voxel_index,
+                    const TsdfVoxel* voxel) {
+          const TsdfVoxel& reference_voxel =
+              reference_layer->getBlockAtIndex(block_index)
+                  ->voxels[voxel_index.x()][voxel_index.y()][voxel_index.z()];
+          if (voxel->distance != reference_voxel.distance ||
+              voxel->weight != reference_voxel.weight) {
+            ++num_different_voxels;
+          }
+        });
+    EXPECT_EQ(num_different_voxels, 0) << "Thread block depth " << depth;
+  }
+}
+
+int main(int argc, char** argv) {
+  FLAGS_alsologtostderr = true;
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -15,6 +15,7 @@ limitations under the License.
 */
 #include <gtest/gtest.h>
 
+#include "nvblox/core/internal/error_check.h"
 #include "nvblox/core/types.h"
 #include "nvblox/map/common_names.h"
 #include "nvblox/map/layer.h"
@@ -343,6 +344,37 @@ TEST(VoxelLayerTest, CopyVoxelsToHostFromUnified) {
   EXPECT_EQ(res.first.distance, 1.0f);
 }
 
+TEST(VoxelLayerTest, PrefetchUnifiedBlocks) {
+  constexpr float voxel_size_m = 1.0;
+  TsdfLayer tsdf_layer(voxel_size_m, MemoryType::kUnified);
+  const std::vector<Index3D> block_indices = {
+      Index3D(0, 0, 0), Index3D(1, 0, 0), Index3D(0, 0, 0)};
+  for (const Index3D& block_index : block_indices) {
+    test_utils::setTsdfBlockVoxelsConstant(
+        1.0f, tsdf_layer.allocateBlockAtIndex(block_index));
+  }
+
+  // Prefetching (including duplicate and non-allocated blocks) keeps the
+  // contents.
+  CudaStreamOwning cuda_stream;
+  std::vector<Index3D> indices_to_prefetch = block_indices;
+  indices_to_prefetch.push_back(Index3D(5, 5, 5));
+  tsdf_layer.prefetchBlocksAsync(indices_to_prefetch,
+                                 UnifiedMemoryLocation::kDevice, cuda_stream);
+  cuda_stream.synchronize();
+  const auto res = tsdf_layer.getVoxel(Vector3f(1.5f, 0.0f, 0.0f));
+  EXPECT_TRUE(res.second);
+  EXPECT_EQ(res.first.distance, 1.0f);
+
+  tsdf_layer.prefetchBlocksAsync(block_indices, UnifiedMemoryLocation::kHost,
+                                 cuda_stream);
+  cuda_stream.synchronize();
+  EXPECT_EQ(tsdf_layer.getBlockAtIndex(Index3D(0, 0, 0))
+                ->voxels[0][0][0]
+                .distance,
+            1.0f);
+}
+
 TEST(VoxelLayerTest, CopyLayerTest) {
   constexpr float voxel_size_m = 0.1f;
 
@@ -383,6 +415,175 @@ TEST(VoxelLayerTest, CopyLayerTest) {
   }
 }
 
+TEST(VoxelLayerTest, CopyManyDeviceBlocks) {
+  // Copies between device layers go through a single batched kernel.
+  constexpr float voxel_size_m = 0.1f;
+  constexpr int kNumBlocks = 1000;
+  TsdfLayer tsdf_layer(voxel_size_m, MemoryType::kDevice);
+  std::vector<Index3D> all_blocks;
+  for (int i = 0; i < kNumBlocks; ++i) {
+    all_blocks.push_back(Index3D(i, i % 7, -i));
+    auto block_ptr = tsdf_layer.allocateBlockAtIndex(all_blocks.back());
+    test_utils::setTsdfBlockVoxelsConstant(static_cast<float>(i), block_ptr);
+  }
+
+  CudaStreamOwning cuda_stream;
+  TsdfLayer tsdf_layer_copy(voxel_size_m, MemoryType::kDevice);
+  tsdf_layer_copy.copyFromAsync(tsdf_layer, cuda_stream);
+  // Only copy every other block into a second layer.
+  TsdfLayer tsdf_layer_partial_copy(voxel_size_m, MemoryType::kUnified);
+  std::vector<Index3D> some_blocks;
+  for (int i = 0; i < kNumBlocks; i += 2) {
+    some_blocks.push_back(all_blocks[i]);
+  }
+  tsdf_layer_partial_copy.copyBlocksFromAsync(tsdf_layer, some_blocks,
+                                              cuda_stream);
+  cuda_stream.synchronize();
+  EXPECT_EQ(tsdf_layer_copy.numAllocatedBlocks(), kNumBlocks);
+  EXPECT_EQ(tsdf_layer_partial_copy.numAllocatedBlocks(), kNumBlocks / 2);
+
+  TsdfLayer tsdf_layer_host(voxel_size_m, MemoryType::kHost);
+  tsdf_layer_host.copyFrom(tsdf_layer_copy);
+  for (int i = 0; i < kNumBlocks; ++i) {
+    auto block_ptr = tsdf_layer_host.getBlockAtIndex(all_blocks[i]);
+    ASSERT_TRUE(block_ptr);
+    EXPECT_NEAR(block_ptr->voxels[1][2][3].distance, static_cast<float>(i),
+                1e-4f);
+    auto partial_block_ptr =
+        tsdf_layer_partial_copy.getBlockAtIndex(all_blocks[i]);
+    if (i % 2 == 0) {
+      ASSERT_TRUE(partial_block_ptr);
+      EXPECT_NEAR(partial_block_ptr->voxels[7][0][5].distance,
+                  static_cast<float>(i), 1e-4f);
+    } else {
+      EXPECT_FALSE(partial_block_ptr);
+    }
+  }
+
+  // Clear all blocks in one batch, the GPU hash follows.
+  tsdf_layer_copy.clearBlocksAsync(all_blocks, cuda_stream);
+  EXPECT_EQ(tsdf_layer_copy.numAllocatedBlocks(), 0);
+  EXPECT_EQ(tsdf_layer_copy.getGpuLayerView(cuda_stream).size(), 0);
+}
+
+TEST(VoxelLayerTest, CachedBlockLists) {
+  constexpr float voxel_size_m = 0.1f;
+  TsdfLayer tsdf_layer(voxel_size_m, MemoryType::kDevice);
+  tsdf_layer.allocateBlockAtIndex(Index3D(0, 0, 0));
+  tsdf_layer.allocateBlockAtIndex(Index3D(1, 0, 0));
+
+  // The lists are only rebuilt on (de)allocation.
+  const uint64_t generation = tsdf_layer.allocation_generation();
+  const std::vector<Index3D>* indices = &tsdf_layer.getAllBlockIndicesCached();
+  EXPECT_EQ(indices->size(), 2);
+  tsdf_layer.allocateBlockAtIndex(Index3D(0, 0, 0));
+  tsdf_layer.getBlockAtIndex(Index3D(1, 0, 0));
+  EXPECT_EQ(tsdf_layer.allocation_generation(), generation);
+  EXPECT_EQ(&tsdf_layer.getAllBlockIndicesCached(), indices);
+
+  tsdf_layer.allocateBlockAtIndex(Index3D(2, 0, 0));
+  EXPECT_GT(tsdf_layer.allocation_generation(), generation);
+  EXPECT_EQ(tsdf_layer.getAllBlockIndicesCached().size(), 3);
+  tsdf_layer.clearBlock(Index3D(0, 0, 0));
+  const std::vector<Index3D>& cached_indices =
+      tsdf_layer.getAllBlockIndicesCached();
+  const std::vector<TsdfBlock*>& cached_ptrs =
+      tsdf_layer.getAllBlockPointersCached();
+  ASSERT_EQ(cached_indices.size(), 2);
+  ASSERT_EQ(cached_ptrs.size(), 2);
+  for (size_t i = 0; i < cached_indices.size(); ++i) {
+    EXPECT_EQ(tsdf_layer.getBlockAtIndex(cached_indices[i]).get(),
+              cached_ptrs[i]);
+  }
+
+  // The device lists mirror the host lists.
+  CudaStreamOwning cuda_stream;
+  host_vector<Index3D> indices_host;
+  host_vector<TsdfBlock*> ptrs_host;
+  indices_host.copyFromAsync(tsdf_layer.getAllBlockIndicesOnGpu(cuda_stream),
+                             cuda_stream);
+  ptrs_host.copyFromAsync(tsdf_layer.getAllBlockPointersOnGpu(cuda_stream),
+                          cuda_stream);
+  cuda_stream.synchronize();
+  ASSERT_EQ(indices_host.size(), 2);
+  ASSERT_EQ(ptrs_host.size(), 2);
+  for (size_t i = 0; i < cached_indices.size(); ++i) {
+    EXPECT_EQ(indices_host[i], cached_indices[i]);
+    EXPECT_EQ(ptrs_host[i], cached_ptrs[i]);
+  }
+}
+
+TEST(VoxelLayerTest, MortonOrderedBlockLists) {
+  constexpr float voxel_size_m = 0.1f;
+  TsdfLayer tsdf_layer(voxel_size_m, MemoryType::kUnified);
+  for (int x = -3; x < 3; ++x) {
+    for (int y = -3; y < 3; ++y) {
+      for (int z = -3; z < 3; ++z) {
+        tsdf_layer.allocateBlockAtIndex(Index3D(x, y, z));
+      }
+    }
+  }
+  tsdf_layer.morton_ordered_block_lists(true);
+  const std::vector<Index3D>& indices = tsdf_layer.getAllBlockIndicesCached();
+  const std::vector<TsdfBlock*>& ptrs = tsdf_layer.getAllBlockPointersCached();
+  ASSERT_EQ(indices.size(), 6 * 6 * 6);
+  for (size_t i = 0; i < indices.size(); ++i) {
+    if (i > 0) {
+      EXPECT_LT(getMortonCodeFromBlockIndex(indices[i - 1]),
+                getMortonCodeFromBlockIndex(indices[i]));
+    }
+    EXPECT_EQ(tsdf_layer.getBlockAtIndex(indices[i]).get(), ptrs[i]);
+  }
+}
+
+TEST(VoxelLayerTest, RelayoutBlocks) {
+  constexpr float voxel_size_m = 0.1f;
+  TsdfLayer tsdf_layer(voxel_size_m, MemoryType::kUnified);
+  tsdf_layer.morton_ordered_block_lists(true);
+  // Allocate in reverse order, such that the blocks are laid out against the
+  // Morton order.
+  constexpr int kNumBlocksPerSide = 4;
+  for (int x = kNumBlocksPerSide - 1; x >= 0; --x) {
+    for (int y = kNumBlocksPerSide - 1; y >= 0; --y) {
+      for (int z = kNumBlocksPerSide - 1; z >= 0; --z) {
+        TsdfBlock::Ptr block =
+            tsdf_layer.allocateBlockAtIndex(Index3D(x, y, z));
+        block->voxels[0][0][0].distance = x * 100.f + y * 10.f + z;
+      }
+    }
+  }
+  EXPECT_EQ(tsdf_layer.numAllocationsSinceRelayout(), 64);
+
+  CudaStreamOwning cuda_stream;
+  tsdf_layer.relayoutBlocksAsync(cuda_stream);
+  cuda_stream.synchronize();
+  EXPECT_EQ(tsdf_layer.numAllocationsSinceRelayout(), 0);
+  EXPECT_EQ(tsdf_layer.numAllocatedBlocks(), 64);
+
+  // The blocks are in memory in Morton order and kept their data.
+  const std::vector<Index3D>& indices = tsdf_layer.getAllBlockIndicesCached();
+  const std::vector<TsdfBlock*>& ptrs = tsdf_layer.getAllBlockPointersCached();
+  for (size_t i = 0; i < indices.size(); ++i) {
+    if (i > 0) {
+      EXPECT_LT(ptrs[i - 1], ptrs[i]);
+    }
+    EXPECT_EQ(tsdf_layer.getBlockAtIndex(indices[i]).get(), ptrs[i]);
+    const Index3D& index = indices[i];
+    EXPECT_EQ(static_cast<float>(ptrs[i]->voxels[0][0][0].distance),
+              index.x() * 100.f + index.y() * 10.f + index.z());
+  }
+  test_utils::checkGpuAndCpuHashesEqual(tsdf_layer);
+
+  // The replaced blocks go back to the memory pool on the next allocation,
+  // once their copies completed.
+  constexpr int kNumBlocks =
+      kNumBlocksPerSide * kNumBlocksPerSide * kNumBlocksPerSide;
+  const int num_free_blocks = tsdf_layer.memory_pool().num_free_blocks();
+  tsdf_layer.allocateBlockAtIndex(Index3D(kNumBlocksPerSide, 0, 0));
+  EXPECT_EQ(tsdf_layer.memory_pool().num_free_blocks(),
+            num_free_blocks + kNumBlocks - 1);
+}
+
 TEST(VoxelLayerTest, ClearBlocks) {
   constexpr float voxel_size_m = 0.1f;
 
@@ -429,6 +630,169 @@ TEST(VoxelLayerTest, AllocateMultipleBlocks) {
   EXPECT_TRUE(tsdf_layer.isBlockAllocated(idx_3));
 }
 
+TEST(VoxelLayerTest, PageBlocksOutAndIn) {
+  constexpr float voxel_size_m = 0.1f;
+  TsdfLayer tsdf_layer(voxel_size_m, MemoryType::kDevice);
+  CudaStreamOwning cuda_stream;
+
+  const std::vector<Index3D> all_blocks{Index3D(0, 0, 0), Index3D(1, 1, 1),
+                                        Index3D(1, 2, 3)};
+  for (const Index3D& block_index : all_blocks) {
+    auto block_ptr = tsdf_layer.allocateBlockAtIndex(block_index);
+    test_utils::setTsdfBlockVoxelsConstant(block_index.norm(), block_ptr);
+  }
+
+  // Page out two blocks (and one which doesn't exist).
+  const std::vector<Index3D> paged_out = tsdf_layer.pageOutBlocks(
+      {Index3D(1, 1, 1), Index3D(1, 2, 3), Index3D(5, 5, 5)}, cuda_stream);
+  EXPECT_EQ(paged_out.size(), 2);
+  EXPECT_EQ(tsdf_layer.numAllocatedBlocks(), 1);
+  EXPECT_EQ(tsdf_layer.numPagedOutBlocks(), 2);
+  EXPECT_FALSE(tsdf_layer.isBlockAllocated(Index3D(1, 1, 1)));
+  EXPECT_TRUE(tsdf_layer.isBlockPagedOut(Index3D(1, 1, 1)));
+  EXPECT_EQ(tsdf_layer.getGpuLayerView(cuda_stream).size(), 1);
+  const float block_size = tsdf_layer.block_size();
+  EXPECT_TRUE(tsdf_layer.pagedOutBlocksAABB().isApprox(AxisAlignedBoundingBox(
+      Vector3f::Ones() * block_size, Vector3f(2.f, 3.f, 4.f) * block_size)));
+
+  // Paging in a single block shrinks the AABB to the remaining one.
+  EXPECT_EQ(tsdf_layer.pageInBlocks({Index3D(1, 1, 1)}, cuda_stream).size(), 1);
+  EXPECT_TRUE(tsdf_layer.pagedOutBlocksAABB().isApprox(AxisAlignedBoundingBox(
+      Vector3f(1.f, 2.f, 3.f) * block_size,
+      Vector3f(2.f, 3.f, 4.f) * block_size)));
+
+  // Page them back in.
+  const std::vector<Index3D> paged_in =
+      tsdf_layer.pageInBlocks(tsdf_layer.getAllPagedOutBlockIndices(),
+                              cuda_stream);
+  EXPECT_EQ(paged_in.size(), 1);
+  EXPECT_EQ(tsdf_layer.numAllocatedBlocks(), 3);
+  EXPECT_EQ(tsdf_layer.numPagedOutBlocks(), 0);
+  EXPECT_TRUE(tsdf_layer.pagedOutBlocksAABB().isEmpty());
+  EXPECT_EQ(tsdf_layer.getGpuLayerView(cuda_stream).size(), 3);
+  // Paging in doesn't synchronize the stream.
+  cuda_stream.synchronize();
+
+  // Check that the data survived the round trip.
+  TsdfLayer tsdf_layer_host(voxel_size_m, MemoryType::kHost);
+  tsdf_layer_host.copyFrom(tsdf_layer);
+  for (const Index3D& block_index : all_blocks) {
+    auto block_ptr = tsdf_layer_host.getBlockAtIndex(block_index);
+    ASSERT_TRUE(block_ptr);
+    for (const TsdfVoxel& voxel : *block_ptr) {
+      EXPECT_NEAR(voxel.distance, static_cast<float>(block_index.norm()),
+                  1e-4f);
+    }
+  }
+}
+
+TEST(VoxelLayerTest, SnapshotIsCopyOnWrite) {
+  constexpr float voxel_size_m = 0.1f;
+  TsdfLayer tsdf_layer(voxel_size_m, MemoryType::kUnified);
+  CudaStreamOwning cuda_stream;
+
+  const std::vector<Index3D> all_blocks{Index3D(0, 0, 0), Index3D(1, 1, 1),
+                                        Index3D(1, 2, 3)};
+  for (const Index3D& block_index : all_blocks) {
+    auto block_ptr = tsdf_layer.allocateBlockAtIndex(block_index);
+    test_utils::setTsdfBlockVoxelsConstant(1.0f, block_ptr);
+  }
+  EXPECT_FALSE(tsdf_layer.hasSnapshots());
+
+  BlockLayerSnapshot<TsdfBlock> snapshot = tsdf_layer.snapshot(cuda_stream);
+  ASSERT_TRUE(snapshot.valid());
+  EXPECT_TRUE(tsdf_layer.hasSnapshots());
+  EXPECT_EQ(snapshot.numBlocks(), 3);
+  EXPECT_EQ(snapshot.numCopiedBlocks(), 0);
+
+  // Write one block, free another and add a new one.
+  test_utils::setTsdfBlockVoxelsConstant(
+      2.0f, tsdf_layer.getBlockAtIndex(Index3D(0, 0, 0)));
+  tsdf_layer.clearBlock(Index3D(1, 1, 1));
+  tsdf_layer.allocateBlockAtIndex(Index3D(5, 5, 5));
+  EXPECT_EQ(snapshot.numCopiedBlocks(), 2);
+
+  // The snapshot still sees the layer as it was.
+  EXPECT_EQ(snapshot.numBlocks(), 3);
+  EXPECT_FALSE(snapshot.hasBlock(Index3D(5, 5, 5)));
+  TsdfBlock block;
+  EXPECT_FALSE(snapshot.copyBlockToHost(Index3D(5, 5, 5), &block, cuda_stream));
+  for (const Index3D& block_index : all_blocks) {
+    ASSERT_TRUE(snapshot.copyBlockToHost(block_index, &block, cuda_stream));
+    for (const TsdfVoxel& voxel : block) {
+      EXPECT_EQ(voxel.distance, 1.0f);
+    }
+  }
+
+  // The layer stops tracking the snapshot once it's released.
+  snapshot = BlockLayerSnapshot<TsdfBlock>();
+  EXPECT_FALSE(tsdf_layer.hasSnapshots());
+}
+
+TEST(VoxelLayerTest, SnapshotCopiesOnWriteStream) {
+  constexpr float voxel_size_m = 0.1f;
+  TsdfLayer tsdf_layer(voxel_size_m, MemoryType::kUnified);
+  CudaStreamOwning cuda_stream;
+  const Index3D block_index(0, 0, 0);
+  test_utils::setTsdfBlockVoxelsConstant(
+      1.0f, tsdf_layer.allocateBlockAtIndex(block_index));
+
+  BlockLayerSnapshot<TsdfBlock> snapshot = tsdf_layer.snapshot(cuda_stream);
+  TsdfBlock::Ptr block_ptr =
+      tsdf_layer.getBlockAtIndexAsync(block_index, cuda_stream);
+  ASSERT_TRUE(block_ptr);
+  EXPECT_EQ(snapshot.numCopiedBlocks(), 1);
+  // Overwrite the block on the same stream, behind the copy.
+  checkCudaErrors(cudaMemsetAsync(block_ptr.get(), 0, sizeof(TsdfBlock),
+                                  cuda_stream));
+  EXPECT_EQ(tsdf_layer.getAllBlockPointersAsync(cuda_stream).size(), 1);
+
+  TsdfBlock block;
+  CudaStreamOwning reader_stream;
+  ASSERT_TRUE(snapshot.copyBlockToHost(block_index, &block, reader_stream));
+  for (const TsdfVoxel& voxel : block) {
+    EXPECT_EQ(voxel.distance, 1.0f);
+  }
+  cuda_stream.synchronize();
+  EXPECT_EQ(tsdf_layer.getBlockAtIndex(block_index)->voxels[0][0][0].distance,
+            0.0f);
+}
+
+TEST(VoxelLayerTest, AllocateBlocksOnGpu) {
+  constexpr float voxel_size_m = 0.1f;
+  TsdfLayer tsdf_layer(voxel_size_m, MemoryType::kDevice);
+  CudaStreamOwning cuda_stream;
+  tsdf_layer.allocateBlockAtIndex(Index3D(0, 0, 0));
+
+  // Includes an already allocated block and a duplicate.
+  const std::vector<Index3D> indices{Index3D(0, 0, 0), Index3D(1, 0, 0),
+                                     Index3D(2, 0, 0), Index3D(1, 0, 0)};
+  device_vector<Index3D> indices_device;
+  indices_device.copyFromAsync(indices, cuda_stream);
+  tsdf_layer.allocateBlocksAtIndicesOnGpuAsync(indices_device, cuda_stream);
+
+  device_vector<TsdfBlock*> block_ptrs_device;
+  tsdf_layer.getBlockPointersOnGpuAsync(indices_device, &block_ptrs_device,
+                                        cuda_stream);
+  const std::vector<TsdfBlock*> block_ptrs =
+      block_ptrs_device.toVectorAsync(cuda_stream);
+  cuda_stream.synchronize();
+
+  // The CPU hash is brought up to date on access.
+  EXPECT_EQ(tsdf_layer.numAllocatedBlocks(), 3);
+  for (size_t i = 0; i < indices.size(); i++) {
+    auto block_ptr = tsdf_layer.getBlockAtIndex(indices[i]);
+    ASSERT_TRUE(block_ptr);
+    EXPECT_EQ(block_ptrs[i], block_ptr.get());
+  }
+  EXPECT_EQ(tsdf_layer.getGpuLayerView(cuda_stream).size(), 3);
+
+  // The blocks behave like CPU-allocated ones afterwards.
+  tsdf_layer.clearBlock(Index3D(1, 0, 0));
+  EXPECT_EQ(tsdf_layer.numAllocatedBlocks(), 2);
+  EXPECT_EQ(tsdf_layer.getGpuLayerView(cuda_stream).size(), 2);
+}
+
 TEST(LayerTest, IsLayerTrait) {
   // NOTE(alexmillane): For some reason be have to assign to an intermediate
   // value for EXPECT_TRUE
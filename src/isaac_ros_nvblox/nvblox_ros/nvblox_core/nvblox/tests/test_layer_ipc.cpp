@@ -0,0 +1,140 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+
+#include "nvblox/map/accessors.h"
+#include "nvblox/map/common_names.h"
+#include "nvblox/map/layer_ipc.h"
+#include "nvblox/primitives/primitives.h"
+#include "nvblox/primitives/scene.h"
+#include "nvblox/tests/gpu_layer_utils.h"
+#include "nvblox/tests/utils.h"
+
+using namespace nvblox;
+
+// A CUDA IPC handle can't be opened in the process which exported it, so the
+// tests build the client-side hash over the exporter's own buffer.
+class TestLayerIpcClient : public LayerIpcClient<TsdfBlock> {
+ public:
+  using LayerIpcClient<TsdfBlock>::buildGpuLayerView;
+};
+
+class LayerIpcTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    primitives::Scene scene;
+    scene.aabb() = AxisAlignedBoundingBox(Vector3f(-2.0f, -2.0f, 0.0f),
+                                          Vector3f(2.0f, 2.0f, 2.0f));
+    scene.addGroundLevel(0.0f);
+    scene.addPrimitive(std::make_unique<primitives::Sphere>(
+        Vector3f(0.0f, 0.0f, 1.0f), 0.5f));
+    constexpr float kMaxDistance = 1.0f;
+    scene.generateLayerFromScene(kMaxDistance, &tsdf_layer_);
+
+    p_L_vec_.resize(kNumPoints);
+    std::generate(p_L_vec_.begin(), p_L_vec_.end(), []() {
+      return test_utils::getRandomVector3fInRange(Vector3f(-2.0f, -2.0f, 0.0f),
+                                                  Vector3f(2.0f, 2.0f, 2.0f));
+    });
+  }
+
+  // Checks that the blocks behind a hash match the layer at the test points.
+  void expectViewMatchesLayer(const GPULayerView<TsdfBlock>& gpu_layer_view) {
+    host_vector<TsdfVoxel> voxels;
+    host_vector<bool> flags;
+    test_utils::getVoxelsAtPositionsOnGPU(gpu_layer_view, p_L_vec_, &voxels,
+                                          &flags, tsdf_layer_.block_size());
+    ASSERT_EQ(voxels.size(), p_L_vec_.size());
+    for (size_t i = 0; i < p_L_vec_.size(); ++i) {
+      const TsdfVoxel* voxel_ptr = nullptr;
+      const bool in_layer =
+          getVoxelAtPosition(tsdf_layer_, p_L_vec_[i], &voxel_ptr);
+      EXPECT_EQ(flags[i], in_layer);
+      if (in_layer && flags[i]) {
+        EXPECT_EQ(voxels[i].distance, voxel_ptr->distance);
+        EXPECT_EQ(voxels[i].weight, voxel_ptr->weight);
+      }
+    }
+  }
+
+  static constexpr int kNumPoints = 1000;
+  TsdfLayer tsdf_layer_{0.05f, MemoryType::kUnified};
+  std::vector<Vector3f> p_L_vec_;
+  CudaStreamOwning cuda_stream_;
+};
+
+TEST_F(LayerIpcTest, ExportedSnapshotMatchesLayer) {
+  LayerIpcExporter<TsdfBlock> exporter;
+  EXPECT_EQ(exporter.latestBufferDevice(), nullptr);
+
+  const LayerIpcHandle handle = exporter.exportLayer(tsdf_layer_, cuda_stream_);
+  EXPECT_EQ(handle.generation, 1u);
+  EXPECT_EQ(handle.num_blocks, static_cast<int64_t>(tsdf_layer_.size()));
+  EXPECT_EQ(handle.block_size_bytes, sizeof(TsdfBlock));
+  EXPECT_EQ(handle.block_size, tsdf_layer_.block_size());
+
+  auto gpu_layer_view = TestLayerIpcClient::buildGpuLayerView(
+      handle, exporter.latestBufferDevice(), cuda_stream_);
+  EXPECT_EQ(gpu_layer_view->size(), tsdf_layer_.size());
+  expectViewMatchesLayer(*gpu_layer_view);
+}
+
+TEST_F(LayerIpcTest, SnapshotSurvivesNextExport) {
+  LayerIpcExporter<TsdfBlock> exporter;
+  const LayerIpcHandle first_handle =
+      exporter.exportLayer(tsdf_layer_, cuda_stream_);
+  const void* first_buffer = exporter.latestBufferDevice();
+  auto first_view = TestLayerIpcClient::buildGpuLayerView(
+      first_handle, first_buffer, cuda_stream_);
+
+  // Change the layer and export it again. The first snapshot isn't touched.
+  const Index3D new_block_idx(100, 100, 100);
+  tsdf_layer_.allocateBlockAtIndex(new_block_idx);
+  const LayerIpcHandle second_handle =
+      exporter.exportLayer(tsdf_layer_, cuda_stream_);
+  EXPECT_EQ(second_handle.generation, 2u);
+  EXPECT_EQ(second_handle.num_blocks, first_handle.num_blocks + 1);
+  EXPECT_NE(exporter.latestBufferDevice(), first_buffer);
+
+  const std::vector<bool> first_flags =
+      test_utils::getContainsFlags(*first_view, {new_block_idx});
+  EXPECT_FALSE(first_flags[0]);
+  expectViewMatchesLayer(*first_view);
+
+  auto second_view = TestLayerIpcClient::buildGpuLayerView(
+      second_handle, exporter.latestBufferDevice(), cuda_stream_);
+  const std::vector<bool> second_flags =
+      test_utils::getContainsFlags(*second_view, {new_block_idx});
+  EXPECT_TRUE(second_flags[0]);
+}
+
+TEST_F(LayerIpcTest, EmptyLayer) {
+  TsdfLayer empty_layer(0.05f, MemoryType::kDevice);
+  LayerIpcExporter<TsdfBlock> exporter;
+  const LayerIpcHandle handle = exporter.exportLayer(empty_layer, cuda_stream_);
+  EXPECT_EQ(handle.num_blocks, 0);
+  auto gpu_layer_view = TestLayerIpcClient::buildGpuLayerView(
+      handle, exporter.latestBufferDevice(), cuda_stream_);
+  EXPECT_EQ(gpu_layer_view->size(), 0u);
+}
+
+int main(int argc, char** argv) {
+  FLAGS_alsologtostderr = true;
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -93,6 +93,70 @@ TEST_F(LayerSerializerGpuTestFixture, serializeEmptyLayer) {
   EXPECT_EQ(serialized_tsdf->voxels.size(), 0);
 }
 
+TEST_F(LayerSerializerGpuTestFixture, compressedRoundTrip) {
+  std::vector<Index3D> block_indices = tsdf_layer_.getAllBlockIndices();
+  // An unallocated block should be serialized as an empty block.
+  block_indices.push_back(Index3D(1000, 1000, 1000));
+
+  TsdfLayerSerializerGpu serializer;
+  auto serialized_tsdf =
+      serializer.serialize(tsdf_layer_, block_indices, CudaStreamOwning());
+  const size_t uncompressed_num_bytes =
+      serialized_tsdf->voxels.size() * sizeof(TsdfVoxel);
+
+  TsdfLayerSerializerGpu compressing_serializer;
+  compressing_serializer.compress_blocks(true);
+  std::shared_ptr<const SerializedTsdfLayer> result =
+      compressing_serializer.serialize(tsdf_layer_, block_indices,
+                                       CudaStreamOwning());
+  EXPECT_TRUE(result->is_compressed);
+  EXPECT_EQ(result->voxels.size(), 0);
+  ASSERT_EQ(result->compressed_block_offsets.size(), block_indices.size() + 1);
+
+  // Away from the plane, the truncated distances are runs of equal voxels.
+  const size_t compressed_num_bytes = result->compressed_blocks.size();
+  std::cout << "uncompressed bytes: " << uncompressed_num_bytes
+            << ", compressed bytes: " << compressed_num_bytes << std::endl;
+  EXPECT_LT(compressed_num_bytes, uncompressed_num_bytes);
+
+  // The compressed sizes match the serialized ones.
+  const std::vector<int32_t> compressed_sizes =
+      compressing_serializer.getCompressedBlockSizes(tsdf_layer_, block_indices,
+                                                     CudaStreamOwning());
+  ASSERT_EQ(compressed_sizes.size(), block_indices.size());
+  for (size_t i = 0; i < block_indices.size(); ++i) {
+    EXPECT_EQ(compressed_sizes[i], result->compressed_block_offsets[i + 1] -
+                                       result->compressed_block_offsets[i]);
+  }
+  EXPECT_EQ(compressed_sizes.back(), 0);
+
+  // Decompressing gives back the uncompressed serialization.
+  const CudaStreamOwning cuda_stream;
+  SerializedTsdfLayer compressed_tsdf;
+  compressed_tsdf.block_indices = result->block_indices;
+  compressed_tsdf.is_compressed = true;
+  compressed_tsdf.compressed_blocks.copyFromAsync(result->compressed_blocks,
+                                                  cuda_stream);
+  compressed_tsdf.compressed_block_offsets.copyFromAsync(
+      result->compressed_block_offsets, cuda_stream);
+  cuda_stream.synchronize();
+  EXPECT_TRUE(decompressSerializedLayer(&compressed_tsdf));
+  EXPECT_FALSE(compressed_tsdf.is_compressed);
+  ASSERT_EQ(compressed_tsdf.block_offsets.size(),
+            serialized_tsdf->block_offsets.size());
+  for (size_t i = 0; i < serialized_tsdf->block_offsets.size(); ++i) {
+    EXPECT_EQ(compressed_tsdf.block_offsets[i],
+              serialized_tsdf->block_offsets[i]);
+  }
+  ASSERT_EQ(compressed_tsdf.voxels.size(), serialized_tsdf->voxels.size());
+  for (size_t i = 0; i < serialized_tsdf->voxels.size(); ++i) {
+    EXPECT_EQ(compressed_tsdf.voxels[i].distance,
+              serialized_tsdf->voxels[i].distance);
+    EXPECT_EQ(compressed_tsdf.voxels[i].weight,
+              serialized_tsdf->voxels[i].weight);
+  }
+}
+
 int main(int argc, char** argv) {
   google::InitGoogleLogging(argv[0]);
   FLAGS_alsologtostderr = true;
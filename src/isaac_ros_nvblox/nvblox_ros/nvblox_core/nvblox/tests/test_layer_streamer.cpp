@@ -1,3 +1,4 @@
+#include <limits>
 #include <numeric>
 
 #include <gtest/gtest.h>
@@ -248,6 +249,55 @@ TEST(TsdfLayerStreamerOldestBlocks, SerializeNBytes) {
   EXPECT_LE(serialized_size, bytes_to_serialize);
 }
 
+TEST(TsdfLayerStreamerOldestBlocks, SkipUnchangedBlocks) {
+  // Create a TSDF layer
+  primitives::Scene scene = test_utils::getSphereInBox();
+  constexpr float kVoxelSizeM = 0.05;
+  constexpr int kMaxDistVox = 4;
+  constexpr float kMaxDistM = static_cast<float>(kMaxDistVox) * kVoxelSizeM;
+  TsdfLayer tsdf_layer(kVoxelSizeM, MemoryType::kUnified);
+  scene.generateLayerFromScene(kMaxDistM, &tsdf_layer);
+  const std::vector<Index3D> all_block_indices =
+      tsdf_layer.getAllBlockIndices();
+  ASSERT_GT(all_block_indices.size(), 1);
+
+  TsdfLayerStreamerOldestBlocks layer_streamer;
+  layer_streamer.skip_unchanged_blocks(true);
+  constexpr int kAllBytes = std::numeric_limits<int>::max();
+  CudaStreamOwning cuda_stream;
+
+  // First time around, everything is streamed.
+  layer_streamer.markIndicesCandidates(all_block_indices);
+  auto serialized_layer = layer_streamer.getNBytesOfSerializedBlocks(
+      kAllBytes, tsdf_layer, BlockExclusionParams(), cuda_stream);
+  EXPECT_EQ(serialized_layer->block_indices.size(), all_block_indices.size());
+
+  // Nothing changed, so nothing is streamed.
+  layer_streamer.markIndicesCandidates(all_block_indices);
+  serialized_layer = layer_streamer.getNBytesOfSerializedBlocks(
+      kAllBytes, tsdf_layer, BlockExclusionParams(), cuda_stream);
+  EXPECT_EQ(serialized_layer->block_indices.size(), 0);
+  EXPECT_EQ(layer_streamer.numCandidates(), 0);
+
+  // Change a single voxel in one block. Only that block is streamed.
+  const Index3D changed_block_index = all_block_indices.front();
+  TsdfBlock::Ptr block = tsdf_layer.getBlockAtIndex(changed_block_index);
+  ASSERT_TRUE(block);
+  block->voxels[1][2][3].weight += 1.0f;
+  layer_streamer.markIndicesCandidates(all_block_indices);
+  serialized_layer = layer_streamer.getNBytesOfSerializedBlocks(
+      kAllBytes, tsdf_layer, BlockExclusionParams(), cuda_stream);
+  ASSERT_EQ(serialized_layer->block_indices.size(), 1);
+  EXPECT_EQ(serialized_layer->block_indices[0], changed_block_index);
+
+  // After forgetting what was published, everything is streamed again.
+  layer_streamer.clearPublishedBlockHashes();
+  layer_streamer.markIndicesCandidates(all_block_indices);
+  serialized_layer = layer_streamer.getNBytesOfSerializedBlocks(
+      kAllBytes, tsdf_layer, BlockExclusionParams(), cuda_stream);
+  EXPECT_EQ(serialized_layer->block_indices.size(), all_block_indices.size());
+}
+
 TEST(MeshLayerStreamerOldestBlocks, StreamNBytes) {
   // Create a test scene and mesh it
   primitives::Scene scene = test_utils::getSphereInBox();
@@ -477,6 +527,182 @@ TYPED_TEST(LayerStreamerOldestBlocksTestFixture, ExcludeBlocksOutsideRadius) {
   EXPECT_EQ(layer_streamer.numCandidates(), 0);
 }
 
+TEST(TsdfLayerStreamerViewPriority, CloseBlocksFirst) {
+  constexpr float kBlockSizeM = 1.0f;
+  TsdfLayerStreamerViewPriority layer_streamer(kBlockSizeM);
+  // A line of blocks, marked in reverse order.
+  constexpr int kNumBlocks = 10;
+  std::vector<Index3D> block_indices;
+  for (int i = kNumBlocks - 1; i >= 0; --i) {
+    block_indices.push_back(Index3D(i, 0, 0));
+  }
+  layer_streamer.markIndicesCandidates(block_indices);
+  layer_streamer.setRobotPosition(Vector3f::Zero());
+
+  // The closest blocks are streamed first.
+  constexpr int kNumRequested = 3;
+  const std::vector<Index3D> streamed =
+      layer_streamer.getNBlocks(kNumRequested);
+  ASSERT_EQ(streamed.size(), kNumRequested);
+  for (int i = 0; i < kNumRequested; ++i) {
+    EXPECT_EQ(streamed[i], Index3D(i, 0, 0));
+  }
+  EXPECT_EQ(layer_streamer.numCandidates(), kNumBlocks - kNumRequested);
+}
+
+TEST(TsdfLayerStreamerViewPriority, BlocksInViewFirst) {
+  constexpr float kBlockSizeM = 1.0f;
+  TsdfLayerStreamerViewPriority layer_streamer(kBlockSizeM);
+  // A block in front of the camera and a closer block behind it.
+  const Index3D block_in_front(0, 0, 5);
+  const Index3D block_behind(0, 0, -3);
+
+  // Without a camera, the closer block goes first.
+  layer_streamer.markIndicesCandidates({block_behind, block_in_front});
+  layer_streamer.setRobotPosition(Vector3f::Zero());
+  std::vector<Index3D> streamed = layer_streamer.getNBlocks(1);
+  ASSERT_EQ(streamed.size(), 1);
+  EXPECT_EQ(streamed[0], block_behind);
+
+  // A camera at the origin looking down the z-axis sees the block in front.
+  layer_streamer.clear();
+  layer_streamer.markIndicesCandidates({block_behind, block_in_front});
+  const Camera camera(100.0f, 100.0f, 50.0f, 50.0f, 100, 100);
+  layer_streamer.setCameraView(camera, Transform::Identity());
+  streamed = layer_streamer.getNBlocks(1);
+  ASSERT_EQ(streamed.size(), 1);
+  EXPECT_EQ(streamed[0], block_in_front);
+
+  // Without the camera, the order is by distance again.
+  layer_streamer.markIndicesCandidates({block_in_front});
+  layer_streamer.clearCameraView();
+  streamed = layer_streamer.getNBlocks(1);
+  ASSERT_EQ(streamed.size(), 1);
+  EXPECT_EQ(streamed[0], block_behind);
+}
+
+TEST(TsdfLayerStreamerViewPriority, ChangedAndStaleBlocks) {
+  constexpr float kBlockSizeM = 1.0f;
+  TsdfLayerStreamerViewPriority layer_streamer(kBlockSizeM);
+  layer_streamer.setRobotPosition(Vector3f::Zero());
+  layer_streamer.staleness_weight(0.0f);
+
+  // A far block which changed often beats a close block which changed once.
+  const Index3D close_block(1, 0, 0);
+  const Index3D far_block(5, 0, 0);
+  constexpr int kNumChanges = 10;
+  for (int i = 0; i < kNumChanges; ++i) {
+    layer_streamer.markIndicesCandidates({far_block});
+  }
+  layer_streamer.markIndicesCandidates({close_block});
+  std::vector<Index3D> streamed = layer_streamer.getNBlocks(1);
+  ASSERT_EQ(streamed.size(), 1);
+  EXPECT_EQ(streamed[0], far_block);
+  streamed = layer_streamer.getNBlocks(1);
+  ASSERT_EQ(streamed.size(), 1);
+  EXPECT_EQ(streamed[0], close_block);
+
+  // With staleness, a far block waiting long enough beats new close blocks.
+  layer_streamer.staleness_weight(1.0f);
+  layer_streamer.change_weight(0.0f);
+  const Index3D very_far_block(20, 0, 0);
+  layer_streamer.markIndicesCandidates({very_far_block});
+  bool very_far_block_streamed = false;
+  for (int round = 0; round < 30 && !very_far_block_streamed; ++round) {
+    layer_streamer.markIndicesCandidates({close_block});
+    streamed = layer_streamer.getNBlocks(1);
+    ASSERT_EQ(streamed.size(), 1);
+    very_far_block_streamed = streamed[0] == very_far_block;
+  }
+  EXPECT_TRUE(very_far_block_streamed);
+}
+
+TEST(TsdfLayerStreamerOldestBlocks, RegionsOfInterest) {
+  primitives::Scene scene = test_utils::getSphereInBox();
+  constexpr float kVoxelSizeM = 0.05;
+  constexpr float kMaxDistM = 4.0f * kVoxelSizeM;
+  TsdfLayer tsdf_layer(kVoxelSizeM, MemoryType::kUnified);
+  scene.generateLayerFromScene(kMaxDistM, &tsdf_layer);
+  const std::vector<Index3D> all_block_indices =
+      tsdf_layer.getAllBlockIndices();
+  const float block_size_m = tsdf_layer.block_size();
+
+  TsdfLayerStreamerOldestBlocks layer_streamer;
+  const AxisAlignedBoundingBox aabb_m(Vector3f(-1.0f, -1.0f, 0.0f),
+                                      Vector3f(1.0f, 1.0f, 1.0f));
+  const int aabb_roi_id = layer_streamer.addRoi(
+      StreamingRoi{.aabb_m = aabb_m, .block_size_m = block_size_m});
+  const Vector3f center_m(2.0f, 2.0f, 1.0f);
+  constexpr float kRadiusM = 1.5f;
+  const int radius_roi_id = layer_streamer.addRoi(
+      StreamingRoi{.center_m = center_m,
+                   .radius_m = kRadiusM,
+                   .block_size_m = block_size_m});
+  EXPECT_EQ(layer_streamer.numRois(), 2);
+
+  // ROI candidates are separate from the candidates of the streamer.
+  layer_streamer.markIndicesRoiCandidates(all_block_indices);
+  EXPECT_EQ(layer_streamer.numCandidates(), 0);
+  const int num_aabb_candidates =
+      layer_streamer.numRoiCandidates(aabb_roi_id);
+  const int num_radius_candidates =
+      layer_streamer.numRoiCandidates(radius_roi_id);
+  EXPECT_GT(num_aabb_candidates, 0);
+  EXPECT_GT(num_radius_candidates, 0);
+  EXPECT_LT(num_aabb_candidates, static_cast<int>(all_block_indices.size()));
+  EXPECT_LT(num_radius_candidates, static_cast<int>(all_block_indices.size()));
+
+  // Each ROI only streams blocks inside of it.
+  constexpr size_t kAllBytes = std::numeric_limits<size_t>::max();
+  CudaStreamOwning cuda_stream;
+  auto serialized_aabb = layer_streamer.getNBytesOfSerializedRoiBlocks(
+      aabb_roi_id, kAllBytes, tsdf_layer, cuda_stream);
+  EXPECT_EQ(static_cast<int>(serialized_aabb->block_indices.size()),
+            num_aabb_candidates);
+  for (const Index3D& block_index : serialized_aabb->block_indices) {
+    EXPECT_TRUE(isBlockTouchedByBoundingBox(block_index, block_size_m, aabb_m));
+  }
+  EXPECT_EQ(layer_streamer.numRoiCandidates(aabb_roi_id), 0);
+
+  // An ROI has its own byte budget and serializer. Its budget only allows
+  // half of the blocks.
+  const size_t half_bytes = num_radius_candidates / 2 * sizeof(TsdfBlock);
+  auto serialized_radius = layer_streamer.getNBytesOfSerializedRoiBlocks(
+      radius_roi_id, half_bytes, tsdf_layer, cuda_stream);
+  EXPECT_GT(serialized_radius->block_indices.size(), 0);
+  EXPECT_LT(static_cast<int>(serialized_radius->block_indices.size()),
+            num_radius_candidates);
+  for (const Index3D& block_index : serialized_radius->block_indices) {
+    const Vector3f block_center_m =
+        getCenterPositionFromBlockIndex(block_size_m, block_index);
+    EXPECT_LE((block_center_m - center_m).norm(), kRadiusM);
+  }
+  EXPECT_EQ(static_cast<int>(serialized_aabb->block_indices.size()),
+            num_aabb_candidates);
+  EXPECT_GT(layer_streamer.numRoiCandidates(radius_roi_id), 0);
+
+  // Moving the ROI away drops the remaining candidates.
+  layer_streamer.updateRoi(radius_roi_id,
+                           StreamingRoi{.center_m = Vector3f(100.0f, 0, 0),
+                                        .radius_m = kRadiusM,
+                                        .block_size_m = block_size_m});
+  serialized_radius = layer_streamer.getNBytesOfSerializedRoiBlocks(
+      radius_roi_id, kAllBytes, tsdf_layer, cuda_stream);
+  EXPECT_EQ(serialized_radius->block_indices.size(), 0);
+  EXPECT_EQ(layer_streamer.numRoiCandidates(radius_roi_id), 0);
+
+  // The streamer itself is unaffected.
+  layer_streamer.markIndicesCandidates(all_block_indices);
+  auto serialized_layer = layer_streamer.getNBytesOfSerializedBlocks(
+      kAllBytes, tsdf_layer, BlockExclusionParams(), cuda_stream);
+  EXPECT_EQ(serialized_layer->block_indices.size(), all_block_indices.size());
+
+  layer_streamer.removeRoi(aabb_roi_id);
+  EXPECT_FALSE(layer_streamer.hasRoi(aabb_roi_id));
+  EXPECT_TRUE(layer_streamer.hasRoi(radius_roi_id));
+  EXPECT_EQ(layer_streamer.numRois(), 1);
+}
+
 int main(int argc, char** argv) {
   google::InitGoogleLogging(argv[0]);
   FLAGS_alsologtostderr = true;
@@ -252,6 +252,51 @@ TEST_F(LayerToUnifiedGridTest, CopyLayerWithConversion) {
       [](const float& value) -> float { return value; });
 }
 
+TEST(DenseGridGradientsTest, LinearField) {
+  // A distance field which increases linearly along each axis.
+  constexpr float kVoxelSize = 0.1f;
+  const Vector3f kSlope(1.0f, -2.0f, 0.5f);
+  constexpr float kUnobservedValue = -1000.0f;
+  const Index3D aabb_min(-2, 0, 3);
+  const Index3D aabb_size(4, 5, 6);
+  Unified3DGrid<float> distance_grid(MemoryType::kUnified);
+  distance_grid.setAABB(aabb_min, aabb_size);
+  for (int x = 0; x < aabb_size.x(); x++) {
+    for (int y = 0; y < aabb_size.y(); y++) {
+      for (int z = 0; z < aabb_size.z(); z++) {
+        const Index3D idx = aabb_min + Index3D(x, y, z);
+        distance_grid(idx) = kVoxelSize * kSlope.dot(idx.cast<float>());
+      }
+    }
+  }
+  // An unobserved cell. Its neighbours fall back to one-sided differences.
+  const Index3D unobserved_idx = aabb_min + Index3D(1, 2, 3);
+  distance_grid(unobserved_idx) = kUnobservedValue;
+
+  CudaStreamOwning cuda_stream;
+  Unified3DGrid<Vector3f> gradient_grid(MemoryType::kUnified);
+  denseGridGradientsAsync(distance_grid, kVoxelSize, kUnobservedValue,
+                          &gradient_grid, cuda_stream);
+  cuda_stream.synchronize();
+  EXPECT_EQ(gradient_grid.min_index(), aabb_min);
+  EXPECT_EQ(gradient_grid.aabb_size(), aabb_size);
+
+  // The gradient of a linear field is its slope everywhere, also at the
+  // borders and next to the unobserved cell.
+  constexpr float kEps = 1e-4f;
+  for (int x = 0; x < aabb_size.x(); x++) {
+    for (int y = 0; y < aabb_size.y(); y++) {
+      for (int z = 0; z < aabb_size.z(); z++) {
+        const Index3D idx = aabb_min + Index3D(x, y, z);
+        const Vector3f expected_gradient =
+            (idx == unobserved_idx) ? Vector3f::Zero() : kSlope;
+        EXPECT_NEAR((gradient_grid(idx) - expected_gradient).norm(), 0.0f,
+                    kEps);
+      }
+    }
+  }
+}
+
 int main(int argc, char** argv) {
   FLAGS_alsologtostderr = true;
   google::InitGoogleLogging(argv[0]);
@@ -351,6 +351,65 @@ TEST_P(ParameterizedLidarTest, RandomPixelRoundTrips) {
   }
 }
 
+TEST_P(ParameterizedLidarTest, ApproximateProjectionRoundTrips) {
+  std::srand(0);
+
+  const auto params = GetParam();
+  const int num_azimuth_divisions = std::get<0>(params);
+  const int num_elevation_divisions = std::get<1>(params);
+  const float vertical_fov_deg = std::get<2>(params);
+  const float vertical_fov_rad = vertical_fov_deg * M_PI / 180.0f;
+  const float min_valid_range_m = 0.0f;
+  const float max_valid_range_m = 100.0f;
+
+  Lidar lidar(num_azimuth_divisions, num_elevation_divisions, min_valid_range_m,
+              max_valid_range_m, vertical_fov_rad);
+  Lidar approximate_lidar = lidar;
+  approximate_lidar.approximate_projection(true);
+  EXPECT_FALSE(lidar.approximate_projection());
+  EXPECT_TRUE(approximate_lidar.approximate_projection());
+
+  // Stay clear of the azimuth wrap-around, where either projection may land
+  // on the other side of the image.
+  constexpr float kBorderPx = 0.01f;
+  const int kNumberOfPointsToTest = 10000;
+  for (int i = 0; i < kNumberOfPointsToTest; i++) {
+    const Vector2f u_C(
+        test_utils::randomFloatInRange(
+            kBorderPx, static_cast<float>(num_azimuth_divisions) - kBorderPx),
+        test_utils::randomFloatInRange(
+            0.0f, static_cast<float>(num_elevation_divisions)));
+    const Vector3f p_C = lidar.vectorFromImagePlaneCoordinates(u_C) *
+                         test_utils::randomFloatInRange(0.1f, 10.0f);
+    Vector2f u_C_exact(0.F, 0.F);
+    Vector2f u_C_approximate(0.F, 0.F);
+    EXPECT_TRUE(lidar.project(p_C, &u_C_exact));
+    EXPECT_TRUE(approximate_lidar.project(p_C, &u_C_approximate));
+    // The approximation error is a small fraction of a pixel.
+    constexpr float kAllowableProjectionDifference = 0.001;
+    EXPECT_NEAR((u_C_approximate - u_C).cwiseAbs().maxCoeff(), 0.0f,
+                kAllowableProjectionDifference);
+    EXPECT_NEAR((u_C_approximate - u_C_exact).cwiseAbs().maxCoeff(), 0.0f,
+                kAllowableProjectionDifference);
+  }
+}
+
+TEST_F(LidarTest, ApproximateAtan2Error) {
+  std::srand(0);
+  constexpr float kMaxErrorRad = 1e-5f;
+  const int kNumberOfPointsToTest = 100000;
+  for (int i = 0; i < kNumberOfPointsToTest; i++) {
+    const float x = test_utils::randomFloatInRange(-10.0f, 10.0f);
+    const float y = test_utils::randomFloatInRange(-10.0f, 10.0f);
+    EXPECT_NEAR(approximateAtan2(y, x), std::atan2(y, x), kMaxErrorRad);
+  }
+  // The axes.
+  EXPECT_NEAR(approximateAtan2(0.0f, 1.0f), 0.0f, kMaxErrorRad);
+  EXPECT_NEAR(approximateAtan2(1.0f, 0.0f), M_PI_2, kMaxErrorRad);
+  EXPECT_NEAR(approximateAtan2(-1.0f, 0.0f), -M_PI_2, kMaxErrorRad);
+  EXPECT_NEAR(approximateAtan2(0.0f, 0.0f), 0.0f, kMaxErrorRad);
+}
+
 // Helper for generating test points.
 Vector3f sphericalToCartesianCoordinates(float pol, float az, float r) {
   return Vector3f(r * sin(pol) * cos(az), r * sin(pol) * sin(az), r * cos(pol));
@@ -16,6 +16,7 @@ limitations under the License.
 #include <gtest/gtest.h>
 
 #include "nvblox/core/types.h"
+#include "nvblox/integrators/pointcloud_tsdf_integrator.h"
 #include "nvblox/integrators/projective_tsdf_integrator.h"
 #include "nvblox/integrators/view_calculator.h"
 #include "nvblox/io/csv.h"
@@ -244,6 +245,135 @@ TEST_F(LidarIntegrationTest, SurroundingSphere) {
   }
 }
 
+TEST_F(LidarIntegrationTest, BatchedIntegrationMatchesSequential) {
+  // A sphere seen by two (translated) LiDARs, as two scans.
+  const float sphere_radius = 10.0;
+  const Eigen::MatrixX3f pointcloud =
+      generateSpherePointcloud(num_azimuth_divisions, num_elevation_divisions,
+                               vertical_fov_rad, sphere_radius);
+  const DepthImage depth_image = depthImageFromPointcloud(pointcloud, lidar);
+  Transform T_L_C_1 = Transform::Identity();
+  Transform T_L_C_2 = Transform::Identity();
+  T_L_C_2.translation() = Vector3f(1.0f, -0.5f, 0.0f);
+
+  // Sequential integration
+  const float voxel_size = 0.1f;
+  ProjectiveTsdfIntegrator tsdf_integrator;
+  tsdf_integrator.max_integration_distance_m(sphere_radius + 5.0f);
+  TsdfLayer layer_sequential(voxel_size, MemoryType::kUnified);
+  tsdf_integrator.integrateFrame(depth_image, T_L_C_1, lidar,
+                                 &layer_sequential);
+  tsdf_integrator.integrateFrame(depth_image, T_L_C_2, lidar,
+                                 &layer_sequential);
+
+  // Batched integration
+  TsdfLayer layer_batched(voxel_size, MemoryType::kUnified);
+  std::vector<Index3D> updated_blocks;
+  tsdf_integrator.integrateFrames(
+      {MaskedDepthImageConstView(depth_image),
+       MaskedDepthImageConstView(depth_image)},
+      {T_L_C_1, T_L_C_2}, {lidar, lidar}, &layer_batched, &updated_blocks);
+
+  // Same blocks, same voxels.
+  EXPECT_GT(updated_blocks.size(), 0);
+  EXPECT_EQ(layer_batched.numAllocatedBlocks(),
+            layer_sequential.numAllocatedBlocks());
+  int num_voxels_compared = 0;
+  callFunctionOnAllVoxels<TsdfVoxel>(
+      layer_sequential,
+      [&](const Index3D& block_index, const Index3D& voxel_index,
+          const TsdfVoxel* voxel) -> void {
+        const auto block_ptr = layer_batched.getBlockAtIndex(block_index);
+        ASSERT_NE(block_ptr, nullptr);
+        const TsdfVoxel& voxel_batched =
+            block_ptr->voxels[voxel_index.x()][voxel_index.y()]
+                             [voxel_index.z()];
+        EXPECT_NEAR(voxel->distance, voxel_batched.distance, kFloatEpsilon);
+        EXPECT_NEAR(voxel->weight, voxel_batched.weight, kFloatEpsilon);
+        ++num_voxels_compared;
+      });
+  EXPECT_GT(num_voxels_compared, 0);
+}
+
+TEST_F(LidarIntegrationTest, PointcloudSurroundingSphere) {
+  // Generate data
+  const float sphere_radius = 10.0;
+  const Eigen::MatrixX3f pointcloud_mat =
+      generateSpherePointcloud(num_azimuth_divisions, num_elevation_divisions,
+                               vertical_fov_rad, sphere_radius);
+  std::vector<Vector3f> points;
+  for (int idx = 0; idx < pointcloud_mat.rows(); idx++) {
+    points.push_back(pointcloud_mat.row(idx));
+  }
+  CudaStreamOwning cuda_stream;
+  Pointcloud pointcloud(MemoryType::kDevice);
+  pointcloud.copyFromAsync(points, cuda_stream);
+  cuda_stream.synchronize();
+
+  // Pose: Shifted from the center of the sphere, such that the rays aren't
+  // aligned with the grid.
+  Transform T_L_S = Transform::Identity();
+  T_L_S.translate(Vector3f(0.23f, -0.11f, 0.07f));
+
+  // Integrate into a layer
+  const float voxel_size = 0.1f;
+  TsdfLayer layer(voxel_size, MemoryType::kDevice);
+
+  PointcloudTsdfIntegrator tsdf_integrator;
+  tsdf_integrator.max_integration_distance_m(sphere_radius + 5.0f);
+  std::vector<Index3D> updated_blocks;
+  std::vector<VoxelBlockMask> updated_voxel_masks;
+  tsdf_integrator.integrateFrame(pointcloud, T_L_S, &layer, &updated_blocks,
+                                 &updated_voxel_masks);
+  EXPECT_GT(updated_blocks.size(), 0);
+  EXPECT_EQ(updated_blocks.size(), updated_voxel_masks.size());
+  EXPECT_EQ(static_cast<int>(updated_blocks.size()),
+            layer.numAllocatedBlocks());
+
+  // The rays end the truncation distance behind the surface, so no block may
+  // lie entirely outside of that.
+  const float block_size = voxelSizeToBlockSize(voxel_size);
+  const float truncation_distance_m =
+      tsdf_integrator.get_truncation_distance_m(voxel_size);
+  const Vector3f& p_center = T_L_S.translation();
+  for (const Index3D& block_index : updated_blocks) {
+    const Vector3f p_low = getPositionFromBlockIndex(block_size, block_index);
+    const Vector3f p_high = p_low + Vector3f::Constant(block_size);
+    const Vector3f p_closest = p_center.cwiseMax(p_low).cwiseMin(p_high);
+    EXPECT_LT((p_closest - p_center).norm(),
+              sphere_radius + truncation_distance_m + kFloatEpsilon);
+  }
+
+  // Check all observed TSDF voxels have close to the distance they should. The
+  // rays don't pass exactly through the voxel centers, so the projective
+  // distance is slightly off the euclidean one.
+  constexpr float kDistanceTolerance = 0.01f;
+  int num_observed_voxels = 0;
+  int num_surface_voxels = 0;
+  auto lambda = [&](const Index3D& block_index, const Index3D& voxel_index,
+                    const TsdfVoxel* voxel) {
+    if (voxel->weight > 0.0f) {
+      const Vector3f p_L = getCenterPositionFromBlockIndexAndVoxelIndex(
+          block_size, block_index, voxel_index);
+      float gt_distance = sphere_radius - (p_L - p_center).norm();
+      gt_distance = std::min(gt_distance, truncation_distance_m);
+      gt_distance = std::max(gt_distance, -truncation_distance_m);
+      EXPECT_NEAR(gt_distance, voxel->distance, kDistanceTolerance);
+      ++num_observed_voxels;
+      if (std::abs(gt_distance) < voxel_size) {
+        ++num_surface_voxels;
+      }
+    }
+  };
+  callFunctionOnAllVoxels<TsdfVoxel>(layer, lambda);
+  EXPECT_GT(num_observed_voxels, 0);
+  EXPECT_GT(num_surface_voxels, 0);
+
+  // Fusing the same scan again must leave the distances unchanged.
+  tsdf_integrator.integrateFrame(pointcloud, T_L_S, &layer);
+  callFunctionOnAllVoxels<TsdfVoxel>(layer, lambda);
+}
+
 int main(int argc, char** argv) {
   FLAGS_alsologtostderr = true;
   google::InitGoogleLogging(argv[0]);
@@ -14,10 +14,14 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include <gflags/gflags.h>
+#include <algorithm>
+#include <future>
 #include <gtest/gtest.h>
+#include <thread>
 #include "nvblox/utils/logging.h"
 
 #include "nvblox/core/types.h"
+#include "nvblox/geometry/bounding_boxes.h"
 #include "nvblox/geometry/bounding_spheres.h"
 #include "nvblox/io/image_io.h"
 #include "nvblox/io/mesh_io.h"
@@ -123,6 +127,594 @@ TEST(MapperTest, ClearOutsideSphere) {
   }
 }
 
+TEST(MapperTest, MemoryPressure) {
+  const Vector3f sphere_center(0.0f, 0.0f, 5.0f);
+  const float sphere_radius = 2.0f;
+  primitives::Scene scene = getSphereInABoxScene(sphere_center, sphere_radius);
+
+  constexpr float voxel_size_m = 0.1;
+  Mapper mapper(voxel_size_m, MemoryType::kDevice);
+  TsdfLayer tsdf_layer_host(voxel_size_m, MemoryType::kHost);
+  scene.generateLayerFromScene(1.0, &tsdf_layer_host);
+  mapper.tsdf_layer().copyFrom(tsdf_layer_host);
+  const int num_allocated_blocks_before_clear =
+      mapper.tsdf_layer().numAllocatedBlocks();
+  EXPECT_GT(num_allocated_blocks_before_clear, 0);
+
+  // The TSDF blocks in use are accounted for.
+  const MapperMemoryUsage usage = mapper.memoryUsage();
+  const auto tsdf_usage_it =
+      std::find_if(usage.layers.begin(), usage.layers.end(),
+                   [](const auto& kv) { return kv.first == "tsdf"; });
+  ASSERT_NE(tsdf_usage_it, usage.layers.end());
+  const LayerMemoryUsage& tsdf_usage = tsdf_usage_it->second;
+  EXPECT_EQ(tsdf_usage.memory_type, MemoryType::kDevice);
+  EXPECT_GE(tsdf_usage.blocks.used_bytes,
+            num_allocated_blocks_before_clear * sizeof(TsdfBlock));
+  EXPECT_GE(tsdf_usage.blocks.allocated_bytes, tsdf_usage.blocks.used_bytes);
+  EXPECT_GT(usage.device_total_bytes, 0);
+  EXPECT_GT(usage.deviceBytesInUse(), 0);
+  EXPECT_LE(usage.devicePressure(), 1.0f);
+
+  // Disabled by default.
+  EXPECT_FALSE(mapper.relieveMemoryPressure(sphere_center));
+  EXPECT_EQ(mapper.tsdf_layer().numAllocatedBlocks(),
+            num_allocated_blocks_before_clear);
+
+  // A watermark below the current pressure clears outside the keep radius.
+  mapper.memory_pressure_watermark(1e-6f);
+  mapper.memory_pressure_keep_radius_m(sphere_radius);
+  EXPECT_TRUE(mapper.relieveMemoryPressure(sphere_center));
+  EXPECT_GT(mapper.tsdf_layer().numAllocatedBlocks(), 0);
+  EXPECT_LT(mapper.tsdf_layer().numAllocatedBlocks(),
+            num_allocated_blocks_before_clear);
+
+  // The cleared blocks are idle in the pool.
+  const MemoryUsage tsdf_pool_usage =
+      mapper.tsdf_layer().memory_pool().memoryUsage();
+  EXPECT_GT(tsdf_pool_usage.idle_bytes(), 0);
+}
+
+TEST(MapperTest, PreallocateBlocksInWorkspace) {
+  constexpr float voxel_size_m = 0.1;
+  Mapper mapper(voxel_size_m, MemoryType::kDevice);
+  const size_t num_default_blocks =
+      mapper.tsdf_layer().memory_pool().num_allocated_blocks();
+
+  MapperParams params;
+  params.preallocate_blocks = true;
+  params.view_calculator_params.workspace_bounds_type =
+      WorkspaceBoundsType::kBoundingBox;
+  params.view_calculator_params.workspace_bounds_min_corner_x_m = -10.0f;
+  params.view_calculator_params.workspace_bounds_min_corner_y_m = -10.0f;
+  params.view_calculator_params.workspace_bounds_min_height_m = 0.0f;
+  params.view_calculator_params.workspace_bounds_max_corner_x_m = 10.0f;
+  params.view_calculator_params.workspace_bounds_max_corner_y_m = 10.0f;
+  params.view_calculator_params.workspace_bounds_max_height_m = 2.0f;
+  mapper.setMapperParams(params);
+
+  const size_t num_blocks_in_workspace =
+      getMaxNumBlocksInWorkspace(WorkspaceBoundsType::kBoundingBox,
+                                 Vector3f(-10.0f, -10.0f, 0.0f),
+                                 Vector3f(10.0f, 10.0f, 2.0f),
+                                 mapper.tsdf_layer().block_size())
+          .value();
+  ASSERT_GT(num_blocks_in_workspace, num_default_blocks);
+  EXPECT_GE(static_cast<size_t>(
+                mapper.tsdf_layer().memory_pool().num_allocated_blocks()),
+            num_blocks_in_workspace);
+  EXPECT_GE(static_cast<size_t>(
+                mapper.esdf_layer().memory_pool().num_allocated_blocks()),
+            num_blocks_in_workspace);
+
+  // The GPU hash fits the whole workspace without (staged) growth.
+  const auto& gpu_layer_view =
+      mapper.tsdf_layer().getGpuLayerView(CudaStreamOwning());
+  EXPECT_LE(num_blocks_in_workspace,
+            gpu_layer_view.staged_growth_load_factor() *
+                gpu_layer_view.capacity());
+}
+
+TEST(MapperTest, LazyMapLoading) {
+  const Vector3f sphere_center(0.0f, 0.0f, 5.0f);
+  const float sphere_radius = 2.0f;
+  primitives::Scene scene = getSphereInABoxScene(sphere_center, sphere_radius);
+
+  constexpr float voxel_size_m = 0.1;
+  Mapper mapper(voxel_size_m, MemoryType::kDevice);
+  TsdfLayer tsdf_layer_host(voxel_size_m, MemoryType::kHost);
+  scene.generateLayerFromScene(1.0, &tsdf_layer_host);
+  mapper.tsdf_layer().copyFrom(tsdf_layer_host);
+  const std::string filename = "lazy_map_test.nvblx";
+  ASSERT_TRUE(mapper.saveLayerCakeBinary(filename));
+
+  // Opening the map lazily loads no blocks.
+  Mapper lazy_mapper(voxel_size_m, MemoryType::kDevice);
+  ASSERT_TRUE(lazy_mapper.loadMapLazy(filename));
+  const int num_blocks = tsdf_layer_host.numAllocatedBlocks();
+  EXPECT_EQ(lazy_mapper.numUnloadedMapBlocks(), num_blocks);
+  EXPECT_EQ(lazy_mapper.tsdf_layer().numAllocatedBlocks(), 0);
+
+  // Load the region around the sphere.
+  const std::vector<Index3D> loaded_blocks =
+      lazy_mapper.loadMapBlocksInRadius(sphere_center, sphere_radius);
+  EXPECT_GT(loaded_blocks.size(), 0);
+  EXPECT_LT(loaded_blocks.size(), num_blocks);
+  EXPECT_EQ(lazy_mapper.tsdf_layer().numAllocatedBlocks(),
+            loaded_blocks.size());
+  EXPECT_EQ(lazy_mapper.numUnloadedMapBlocks(),
+            num_blocks - loaded_blocks.size());
+
+  // The loaded blocks match the saved ones.
+  TsdfLayer loaded_layer_host(voxel_size_m, MemoryType::kHost);
+  loaded_layer_host.copyFrom(lazy_mapper.tsdf_layer());
+  for (const Index3D& index : loaded_blocks) {
+    auto block = loaded_layer_host.getBlockAtIndex(index);
+    auto expected_block = tsdf_layer_host.getBlockAtIndex(index);
+    ASSERT_NE(block, nullptr);
+    ASSERT_NE(expected_block, nullptr);
+    EXPECT_EQ(block->voxels[1][2][3].distance,
+              expected_block->voxels[1][2][3].distance);
+    EXPECT_EQ(block->voxels[1][2][3].weight,
+              expected_block->voxels[1][2][3].weight);
+  }
+
+  // Loading again is a no-op.
+  EXPECT_TRUE(
+      lazy_mapper.loadMapBlocksInRadius(sphere_center, sphere_radius).empty());
+
+  // Clearing outside the radius discards the remaining blocks on disk.
+  lazy_mapper.clearOutsideRadius(sphere_center, sphere_radius);
+  EXPECT_EQ(lazy_mapper.numUnloadedMapBlocks(), 0);
+  EXPECT_EQ(lazy_mapper.tsdf_layer().numAllocatedBlocks(),
+            loaded_blocks.size());
+}
+
+TEST(MapperTest, BackgroundMapLoading) {
+  const Vector3f sphere_center(0.0f, 0.0f, 5.0f);
+  const float sphere_radius = 2.0f;
+  primitives::Scene scene = getSphereInABoxScene(sphere_center, sphere_radius);
+
+  constexpr float voxel_size_m = 0.1;
+  Mapper mapper(voxel_size_m, MemoryType::kDevice);
+  TsdfLayer tsdf_layer_host(voxel_size_m, MemoryType::kHost);
+  scene.generateLayerFromScene(1.0, &tsdf_layer_host);
+  mapper.tsdf_layer().copyFrom(tsdf_layer_host);
+  const std::string filename = "background_map_test.nvblx";
+  ASSERT_TRUE(mapper.saveLayerCakeBinary(filename));
+
+  // A live map which already observed the area around the sphere center.
+  Mapper live_mapper(voxel_size_m, MemoryType::kDevice);
+  live_mapper.markUnobservedTsdfFreeInsideRadius(sphere_center, 0.5f);
+  const std::vector<Index3D> live_blocks =
+      live_mapper.tsdf_layer().getAllBlockIndices();
+  ASSERT_GT(live_blocks.size(), 0);
+
+  // Merge the loaded map in batches.
+  live_mapper.loadMapInBackground(filename);
+  EXPECT_TRUE(live_mapper.isLoadingMapInBackground());
+  constexpr int kMaxNumBlocksPerMerge = 10;
+  std::vector<Index3D> merged_blocks;
+  while (live_mapper.isLoadingMapInBackground()) {
+    const std::vector<Index3D> merged =
+        live_mapper.mergeBackgroundLoadedMapBlocks(kMaxNumBlocksPerMerge);
+    EXPECT_LE(merged.size(), kMaxNumBlocksPerMerge);
+    merged_blocks.insert(merged_blocks.end(), merged.begin(), merged.end());
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  // All blocks of the map are present, and the live blocks weren't merged.
+  for (const Index3D& index : tsdf_layer_host.getAllBlockIndices()) {
+    EXPECT_TRUE(live_mapper.tsdf_layer().isBlockAllocated(index));
+  }
+  for (const Index3D& index : live_blocks) {
+    EXPECT_EQ(std::find(merged_blocks.begin(), merged_blocks.end(), index),
+              merged_blocks.end());
+  }
+  EXPECT_TRUE(live_mapper.mergeBackgroundLoadedMapBlocks(1).empty());
+}
+
+TEST(MapperTest, IncrementalCheckpoints) {
+  const Vector3f sphere_center(0.0f, 0.0f, 5.0f);
+  const float sphere_radius = 2.0f;
+  primitives::Scene scene = getSphereInABoxScene(sphere_center, sphere_radius);
+
+  constexpr float voxel_size_m = 0.1;
+  Mapper mapper(voxel_size_m, MemoryType::kDevice);
+  TsdfLayer tsdf_layer_host(voxel_size_m, MemoryType::kHost);
+  scene.generateLayerFromScene(1.0, &tsdf_layer_host);
+  mapper.tsdf_layer().copyFrom(tsdf_layer_host);
+  const std::string filename = "checkpoint_test.nvblx";
+  ASSERT_TRUE(mapper.saveCheckpoint(filename));
+
+  // Add blocks far away and remove blocks outside the sphere.
+  const Vector3f new_center(30.0f, 0.0f, 0.0f);
+  mapper.markUnobservedTsdfFreeInsideRadius(new_center, 1.0f);
+  mapper.clearOutsideRadius(sphere_center, sphere_radius);
+  mapper.markUnobservedTsdfFreeInsideRadius(new_center, 1.0f);
+  ASSERT_TRUE(mapper.saveCheckpoint(filename));
+
+  // The reloaded map contains the latest blocks only.
+  LayerCake cake = io::loadLayerCakeFromFile(filename, MemoryType::kHost);
+  ASSERT_TRUE(cake.exists<TsdfLayer>());
+  const TsdfLayer& reloaded_layer = cake.get<TsdfLayer>();
+  EXPECT_EQ(reloaded_layer.numAllocatedBlocks(),
+            mapper.tsdf_layer().numAllocatedBlocks());
+  for (const Index3D& index : mapper.tsdf_layer().getAllBlockIndices()) {
+    EXPECT_TRUE(reloaded_layer.isBlockAllocated(index));
+  }
+  EXPECT_TRUE(reloaded_layer.isBlockAllocated(getBlockIndexFromPositionInLayer(
+      reloaded_layer.block_size(), new_center)));
+}
+
+TEST(MapperTest, SaveMapWhileMapping) {
+  const Vector3f sphere_center(0.0f, 0.0f, 5.0f);
+  const float sphere_radius = 2.0f;
+  primitives::Scene scene = getSphereInABoxScene(sphere_center, sphere_radius);
+
+  constexpr float voxel_size_m = 0.1;
+  Mapper mapper(voxel_size_m, MemoryType::kDevice);
+  TsdfLayer tsdf_layer_host(voxel_size_m, MemoryType::kHost);
+  scene.generateLayerFromScene(1.0, &tsdf_layer_host);
+  mapper.tsdf_layer().copyFrom(tsdf_layer_host);
+  mapper.updateEsdf(UpdateFullLayer::kYes);
+  mapper.updateMesh(UpdateFullLayer::kYes);
+  const std::string filename = "save_map_async_test.nvblx";
+  std::future<bool> map_saved = mapper.saveLayerCakeAsync(filename);
+  std::future<bool> esdf_saved =
+      mapper.saveEsdfAsPlyAsync("save_map_async_test_esdf.ply");
+  std::future<bool> mesh_saved =
+      mapper.saveMeshAsPlyAsync("save_map_async_test_mesh.ply");
+
+  // Keep changing the map while it's written.
+  const int num_blocks = tsdf_layer_host.numAllocatedBlocks();
+  mapper.clearOutsideRadius(sphere_center, sphere_radius);
+  mapper.markUnobservedTsdfFreeInsideRadius(Vector3f(30.0f, 0.0f, 0.0f), 1.0f);
+  ASSERT_TRUE(map_saved.get());
+  EXPECT_TRUE(esdf_saved.get());
+  EXPECT_TRUE(mesh_saved.get());
+
+  // The file holds the map as it was when saving started.
+  LayerCake cake = io::loadLayerCakeFromFile(filename, MemoryType::kHost);
+  ASSERT_TRUE(cake.exists<TsdfLayer>());
+  const TsdfLayer& reloaded_layer = cake.get<TsdfLayer>();
+  EXPECT_EQ(reloaded_layer.numAllocatedBlocks(), num_blocks);
+  for (const Index3D& index : tsdf_layer_host.getAllBlockIndices()) {
+    auto block = reloaded_layer.getBlockAtIndex(index);
+    auto expected_block = tsdf_layer_host.getBlockAtIndex(index);
+    ASSERT_NE(block, nullptr);
+    EXPECT_EQ(block->voxels[1][2][3].distance,
+              expected_block->voxels[1][2][3].distance);
+  }
+  EXPECT_TRUE(cake.exists<EsdfLayer>());
+  EXPECT_FALSE(mapper.tsdf_layer().hasSnapshots());
+}
+
+TEST(MapperTest, StagedDepthMatchesDirectIntegration) {
+  // Create a scene with a sphere
+  const Vector3f sphere_center(0.0f, 0.0f, 5.0f);
+  const float sphere_radius = 2.0f;
+  primitives::Scene scene = getSphereInABoxScene(sphere_center, sphere_radius);
+
+  constexpr int width = 320;
+  constexpr int height = 240;
+  const Camera camera(300.0f, 300.0f, width / 2.0f, height / 2.0f, width,
+                      height);
+
+  // Two views of the sphere from either side.
+  std::vector<Transform> T_S_C_vec(2, Transform::Identity());
+  T_S_C_vec[0].pretranslate(Vector3f(0.0f, -1.0f, 0.5f));
+  T_S_C_vec[1].pretranslate(Vector3f(0.0f, 1.0f, 0.5f));
+  std::vector<DepthImage> depth_frames;
+  for (const Transform& T_S_C : T_S_C_vec) {
+    depth_frames.emplace_back(height, width, MemoryType::kUnified);
+    scene.generateDepthImageFromScene(camera, T_S_C, 20.0f,
+                                      &depth_frames.back());
+  }
+
+  constexpr float voxel_size_m = 0.1;
+  Mapper mapper_direct(voxel_size_m, MemoryType::kDevice);
+  Mapper mapper_staged(voxel_size_m, MemoryType::kDevice);
+  for (Mapper* mapper : {&mapper_direct, &mapper_staged}) {
+    mapper->do_depth_preprocessing(true);
+    mapper->depth_preprocessing_num_dilations(2);
+  }
+
+  for (size_t i = 0; i < depth_frames.size(); i++) {
+    mapper_direct.integrateDepth(depth_frames[i], T_S_C_vec[i], camera);
+  }
+
+  // Stage both frames before integrating any of them, on a lane per frame
+  // as for two cameras.
+  for (size_t i = 0; i < depth_frames.size(); i++) {
+    mapper_staged.stageDepthAsync(MaskedDepthImageConstView(depth_frames[i]),
+                                  T_S_C_vec[i], camera, i);
+  }
+  EXPECT_EQ(mapper_staged.numStagedDepthFrames(), 2);
+  while (mapper_staged.numStagedDepthFrames() > 0) {
+    mapper_staged.integrateStagedDepth();
+  }
+
+  // The resulting maps should be identical.
+  TsdfLayer tsdf_direct(voxel_size_m, MemoryType::kHost);
+  TsdfLayer tsdf_staged(voxel_size_m, MemoryType::kHost);
+  tsdf_direct.copyFrom(mapper_direct.tsdf_layer());
+  tsdf_staged.copyFrom(mapper_staged.tsdf_layer());
+  EXPECT_GT(tsdf_direct.numAllocatedBlocks(), 0);
+  ASSERT_EQ(tsdf_direct.numAllocatedBlocks(), tsdf_staged.numAllocatedBlocks());
+  for (const Index3D& block_idx : tsdf_direct.getAllBlockIndices()) {
+    const auto block_direct = tsdf_direct.getBlockAtIndex(block_idx);
+    const auto block_staged = tsdf_staged.getBlockAtIndex(block_idx);
+    ASSERT_TRUE(block_staged);
+    for (int x = 0; x < TsdfBlock::kVoxelsPerSide; x++) {
+      for (int y = 0; y < TsdfBlock::kVoxelsPerSide; y++) {
+        for (int z = 0; z < TsdfBlock::kVoxelsPerSide; z++) {
+          EXPECT_EQ(block_direct->voxels[x][y][z].distance,
+                    block_staged->voxels[x][y][z].distance);
+          EXPECT_EQ(block_direct->voxels[x][y][z].weight,
+                    block_staged->voxels[x][y][z].weight);
+        }
+      }
+    }
+  }
+}
+
+TEST(MapperTest, ComputeClearances) {
+  // Create a scene with a sphere
+  const Vector3f sphere_center(0.0f, 0.0f, 5.0f);
+  const float sphere_radius = 2.0f;
+  primitives::Scene scene = getSphereInABoxScene(sphere_center, sphere_radius);
+
+  constexpr float voxel_size_m = 0.1;
+  Mapper mapper(voxel_size_m, MemoryType::kDevice);
+  TsdfLayer tsdf_layer_host(voxel_size_m, MemoryType::kHost);
+  scene.generateLayerFromScene(1.0, &tsdf_layer_host);
+  mapper.tsdf_layer().copyFrom(tsdf_layer_host);
+  mapper.updateEsdf(UpdateFullLayer::kYes);
+
+  const Vector3f x_offset(1.0f, 0.0f, 0.0f);
+  const std::vector<CollisionCapsule> capsules = {
+      // A sphere 0.2m clear of the sphere's surface.
+      CollisionCapsule(sphere_center + 2.5f * x_offset, 0.3f),
+      // A sphere overlapping the sphere's surface.
+      CollisionCapsule(sphere_center + 2.1f * x_offset, 0.5f),
+      // A capsule starting in free space and ending on the sphere's surface.
+      CollisionCapsule(sphere_center + 3.0f * x_offset,
+                       sphere_center + 2.0f * x_offset, 0.1f),
+      // A sphere in unallocated space.
+      CollisionCapsule(Vector3f(100.0f, 0.0f, 0.0f), 0.1f)};
+  std::vector<float> clearances_m;
+  mapper.computeClearances(capsules, &clearances_m);
+  ASSERT_EQ(clearances_m.size(), capsules.size());
+
+  EXPECT_NEAR(clearances_m[0], 0.2f, 1.5f * voxel_size_m);
+  EXPECT_LT(clearances_m[1], 0.0f);
+  EXPECT_LT(clearances_m[2], 0.0f);
+  // Unobserved space is treated as occupied by default.
+  EXPECT_NEAR(clearances_m[3], -0.1f, 1e-6);
+}
+
+TEST(MapperTest, QueryLayers) {
+  // Create a scene with a sphere
+  const Vector3f sphere_center(0.0f, 0.0f, 5.0f);
+  const float sphere_radius = 2.0f;
+  primitives::Scene scene = getSphereInABoxScene(sphere_center, sphere_radius);
+
+  constexpr float voxel_size_m = 0.1;
+  Mapper mapper(voxel_size_m, MemoryType::kDevice);
+  TsdfLayer tsdf_layer_host(voxel_size_m, MemoryType::kHost);
+  scene.generateLayerFromScene(1.0, &tsdf_layer_host);
+  mapper.tsdf_layer().copyFrom(tsdf_layer_host);
+  mapper.updateEsdf(UpdateFullLayer::kYes);
+
+  // Points around the sphere's surface, and one in unallocated space.
+  std::vector<Vector3f> positions_L;
+  for (int i = 0; i < 100; i++) {
+    positions_L.push_back(sphere_center +
+                          (sphere_radius + 0.01f * i) * Vector3f::UnitX());
+  }
+  positions_L.push_back(Vector3f(100.0f, 0.0f, 0.0f));
+  device_vector<Vector3f> positions_L_device;
+  positions_L_device.copyFromAsync(positions_L, CudaStreamOwning());
+
+  MultiLayerQueryResults results;
+  mapper.queryLayers(positions_L_device,
+                     LayerTypeBitMask(LayerType::kTsdf) | LayerType::kEsdf,
+                     &results);
+  ASSERT_EQ(results.tsdf_voxels.size(), positions_L.size());
+  ASSERT_EQ(results.esdf_voxels.size(), positions_L.size());
+  EXPECT_EQ(results.color_voxels.size(), 0u);
+  EXPECT_EQ(results.occupancy_voxels.size(), 0u);
+  EXPECT_EQ(results.freespace_voxels.size(), 0u);
+
+  // Compare to querying the layers one by one.
+  CudaStreamOwning cuda_stream;
+  device_vector<TsdfVoxel> tsdf_voxels;
+  device_vector<bool> tsdf_success_flags;
+  mapper.tsdf_layer().getVoxelsGPU(positions_L_device, &tsdf_voxels,
+                                   &tsdf_success_flags, &cuda_stream);
+  device_vector<EsdfVoxel> esdf_voxels;
+  device_vector<bool> esdf_success_flags;
+  mapper.esdf_layer().getVoxelsGPU(positions_L_device, &esdf_voxels,
+                                   &esdf_success_flags, &cuda_stream);
+
+  const std::vector<TsdfVoxel> tsdf_voxels_expected =
+      tsdf_voxels.toVectorAsync(cuda_stream);
+  const std::vector<EsdfVoxel> esdf_voxels_expected =
+      esdf_voxels.toVectorAsync(cuda_stream);
+  const std::vector<bool> tsdf_success_flags_expected =
+      tsdf_success_flags.toVectorAsync(cuda_stream);
+  const std::vector<bool> esdf_success_flags_expected =
+      esdf_success_flags.toVectorAsync(cuda_stream);
+  const std::vector<TsdfVoxel> tsdf_voxels_queried =
+      results.tsdf_voxels.toVectorAsync(cuda_stream);
+  const std::vector<EsdfVoxel> esdf_voxels_queried =
+      results.esdf_voxels.toVectorAsync(cuda_stream);
+  const std::vector<bool> tsdf_success_flags_queried =
+      results.tsdf_success_flags.toVectorAsync(cuda_stream);
+  const std::vector<bool> esdf_success_flags_queried =
+      results.esdf_success_flags.toVectorAsync(cuda_stream);
+  cuda_stream.synchronize();
+
+  EXPECT_EQ(tsdf_success_flags_queried, tsdf_success_flags_expected);
+  EXPECT_EQ(esdf_success_flags_queried, esdf_success_flags_expected);
+  EXPECT_FALSE(tsdf_success_flags_queried.back());
+  for (size_t i = 0; i + 1 < positions_L.size(); i++) {
+    ASSERT_TRUE(tsdf_success_flags_queried[i]);
+    EXPECT_EQ(tsdf_voxels_queried[i].distance,
+              tsdf_voxels_expected[i].distance);
+    EXPECT_EQ(tsdf_voxels_queried[i].weight, tsdf_voxels_expected[i].weight);
+    EXPECT_EQ(esdf_voxels_queried[i].squared_distance_vox,
+              esdf_voxels_expected[i].squared_distance_vox);
+  }
+}
+
+TEST(MapperTest, UpdateEsdfInWindow) {
+  // Create a scene with a sphere
+  const Vector3f sphere_center(0.0f, 0.0f, 5.0f);
+  const float sphere_radius = 2.0f;
+  primitives::Scene scene = getSphereInABoxScene(sphere_center, sphere_radius);
+
+  constexpr float voxel_size_m = 0.1;
+  Mapper mapper(voxel_size_m, MemoryType::kDevice);
+  TsdfLayer tsdf_layer_host(voxel_size_m, MemoryType::kHost);
+  scene.generateLayerFromScene(1.0, &tsdf_layer_host);
+  mapper.tsdf_layer().copyFrom(tsdf_layer_host);
+  mapper.esdf_window_half_extent_m(1.5f);
+
+  // Two query points 0.5m from the sphere's surface on either side.
+  const Vector3f x_offset(2.5f, 0.0f, 0.0f);
+  const std::vector<Vector3f> query_points = {sphere_center + x_offset,
+                                              sphere_center - x_offset};
+  const float block_size = mapper.esdf_layer().block_size();
+
+  for (size_t i = 0; i < query_points.size(); ++i) {
+    mapper.updateEsdfInWindow(query_points[i]);
+    const Vector3f half_extent =
+        Vector3f::Constant(mapper.esdf_window_half_extent_m());
+    const AxisAlignedBoundingBox window(query_points[i] - half_extent,
+                                        query_points[i] + half_extent);
+
+    // The ESDF is limited to the window.
+    const std::vector<Index3D> esdf_blocks =
+        mapper.esdf_layer().getAllBlockIndices();
+    EXPECT_GT(esdf_blocks.size(), 0);
+    EXPECT_LT(esdf_blocks.size(), mapper.tsdf_layer().numAllocatedBlocks());
+    for (const Index3D& block_index : esdf_blocks) {
+      EXPECT_TRUE(isBlockTouchedByBoundingBox(block_index, block_size, window));
+    }
+
+    // The ESDF at the window center is computed, the one of the previous
+    // window center cleared.
+    std::vector<EsdfVoxel> voxels;
+    std::vector<bool> success_flags;
+    mapper.esdf_layer().getVoxels(query_points, &voxels, &success_flags);
+    ASSERT_TRUE(success_flags[i]);
+    EXPECT_TRUE(voxels[i].observed);
+    EXPECT_NEAR(std::sqrt(voxels[i].squared_distance_vox) * voxel_size_m, 0.5f,
+                1.5f * voxel_size_m);
+    if (i > 0) {
+      EXPECT_FALSE(success_flags[i - 1]);
+    }
+  }
+}
+
+TEST(MapperTest, UpdateEsdfFromSnapshot) {
+  // Create a scene with a sphere
+  const Vector3f sphere_center(0.0f, 0.0f, 5.0f);
+  const float sphere_radius = 2.0f;
+  primitives::Scene scene = getSphereInABoxScene(sphere_center, sphere_radius);
+
+  constexpr float voxel_size_m = 0.1;
+  TsdfLayer tsdf_layer_host(voxel_size_m, MemoryType::kHost);
+  scene.generateLayerFromScene(1.0, &tsdf_layer_host);
+
+  // The reference ESDF, computed directly.
+  Mapper reference_mapper(voxel_size_m, MemoryType::kDevice);
+  reference_mapper.tsdf_layer().copyFrom(tsdf_layer_host);
+  reference_mapper.updateEsdf(UpdateFullLayer::kYes);
+
+  // The ESDF computed from a snapshot, on its own thread and stream. The TSDF
+  // is cleared after taking the snapshot, which must not affect the ESDF.
+  Mapper mapper(voxel_size_m, MemoryType::kDevice);
+  mapper.esdf_cuda_stream(std::make_shared<CudaStreamOwning>());
+  EXPECT_NE(mapper.esdf_cuda_stream(), reference_mapper.esdf_cuda_stream());
+  mapper.tsdf_layer().copyFrom(tsdf_layer_host);
+  mapper.snapshotEsdfInput(UpdateFullLayer::kYes);
+  mapper.tsdf_layer().clear();
+  std::thread esdf_thread([&mapper]() { mapper.updateEsdfFromSnapshot(); });
+  esdf_thread.join();
+
+  EsdfLayer reference_esdf_host(voxel_size_m, MemoryType::kHost);
+  reference_esdf_host.copyFrom(reference_mapper.esdf_layer());
+  EsdfLayer esdf_host(voxel_size_m, MemoryType::kHost);
+  esdf_host.copyFrom(mapper.esdf_layer());
+  ASSERT_GT(reference_esdf_host.numAllocatedBlocks(), 0);
+  EXPECT_EQ(esdf_host.numAllocatedBlocks(),
+            reference_esdf_host.numAllocatedBlocks());
+  for (const Index3D& block_index : reference_esdf_host.getAllBlockIndices()) {
+    auto reference_block = reference_esdf_host.getBlockAtIndex(block_index);
+    auto block = esdf_host.getBlockAtIndex(block_index);
+    ASSERT_NE(block, nullptr);
+    callFunctionOnAllVoxels<EsdfVoxel>(
+        *reference_block,
+        [&block](const Index3D& voxel_index, const EsdfVoxel* voxel) {
+          const EsdfVoxel& other =
+              block->voxels[voxel_index.x()][voxel_index.y()][voxel_index.z()];
+          EXPECT_EQ(voxel->observed, other.observed);
+          EXPECT_EQ(voxel->squared_distance_vox, other.squared_distance_vox);
+        });
+  }
+
+  // Consuming the snapshot leaves nothing to update.
+  mapper.updateEsdfFromSnapshot();
+  EXPECT_EQ(esdf_host.numAllocatedBlocks(),
+            mapper.esdf_layer().numAllocatedBlocks());
+}
+
+TEST(MapperTest, UpdateMeshOnSeparateStream) {
+  const Vector3f sphere_center(0.0f, 0.0f, 5.0f);
+  const float sphere_radius = 2.0f;
+  primitives::Scene scene = getSphereInABoxScene(sphere_center, sphere_radius);
+
+  constexpr float voxel_size_m = 0.1;
+  TsdfLayer tsdf_layer_host(voxel_size_m, MemoryType::kHost);
+  scene.generateLayerFromScene(1.0, &tsdf_layer_host);
+
+  // The reference mesh, computed on the mapper stream.
+  Mapper reference_mapper(voxel_size_m, MemoryType::kDevice);
+  reference_mapper.tsdf_layer().copyFrom(tsdf_layer_host);
+  reference_mapper.updateMesh(UpdateFullLayer::kYes);
+
+  // The mesh computed on a low priority stream, while the ESDF is computed on
+  // a high priority one.
+  Mapper mapper(voxel_size_m, MemoryType::kDevice);
+  mapper.mesh_cuda_stream(CudaStream::createCudaStream(
+      CudaStreamType::kNonBlocking, CudaStreamPriority::kLow));
+  mapper.esdf_cuda_stream(CudaStream::createCudaStream(
+      CudaStreamType::kNonBlocking, CudaStreamPriority::kHigh));
+  EXPECT_NE(mapper.mesh_cuda_stream(), reference_mapper.mesh_cuda_stream());
+  mapper.tsdf_layer().copyFrom(tsdf_layer_host);
+  mapper.updateMesh(UpdateFullLayer::kYes);
+  mapper.updateEsdf(UpdateFullLayer::kYes);
+
+  MeshLayer reference_mesh_host(voxel_size_m, MemoryType::kHost);
+  reference_mesh_host.copyFrom(reference_mapper.mesh_layer());
+  MeshLayer mesh_host(voxel_size_m, MemoryType::kHost);
+  mesh_host.copyFrom(mapper.mesh_layer());
+  ASSERT_GT(reference_mesh_host.numAllocatedBlocks(), 0);
+  EXPECT_EQ(mesh_host.numAllocatedBlocks(),
+            reference_mesh_host.numAllocatedBlocks());
+  for (const Index3D& block_index : reference_mesh_host.getAllBlockIndices()) {
+    auto reference_block = reference_mesh_host.getBlockAtIndex(block_index);
+    auto block = mesh_host.getBlockAtIndex(block_index);
+    ASSERT_NE(block, nullptr);
+    EXPECT_EQ(block->vertices.size(), reference_block->vertices.size());
+    EXPECT_EQ(block->triangles.size(), reference_block->triangles.size());
+  }
+  EXPECT_GT(mapper.esdf_layer().numAllocatedBlocks(), 0);
+}
+
 TEST(MapperTest, GenerateEsdfInFakeObservedAreas) {
   // Scene
   primitives::Scene scene;
@@ -292,6 +884,93 @@ TEST_F(MapperLayerStreamerTest, MultipleLayers) {
   ASSERT_EQ(mapper_.serializedEsdfLayer()->block_indices.size(), 0);
 }
 
+TEST_F(MapperLayerStreamerTest, ConcurrentMultipleLayers) {
+  // Serialize sequentially in a second mapper with the same map, for
+  // comparison.
+  Mapper sequential_mapper(kVoxelSizeM, MemoryType::kHost);
+  sequential_mapper.tsdf_layer().copyFrom(mapper_.tsdf_layer());
+  const std::vector<Index3D> all_blocks =
+      mapper_.tsdf_layer().getAllBlockIndices();
+  for (Mapper* mapper : {&mapper_, &sequential_mapper}) {
+    mapper->markBlocksForUpdate(all_blocks);
+    mapper->updateMesh(UpdateFullLayer::kYes);
+  }
+
+  const LayerTypeBitMask layers =
+      LayerTypeBitMask(LayerType::kMesh) | LayerType::kTsdf;
+  mapper_.concurrent_layer_serialization(true);
+  mapper_.serializeSelectedLayers(layers, kLayerStreamerUnlimitedBandwidth);
+  sequential_mapper.serializeSelectedLayers(layers,
+                                            kLayerStreamerUnlimitedBandwidth);
+
+  // Same blocks and voxels as the sequential serialization.
+  ASSERT_GT(mapper_.serializedTsdfLayer()->block_indices.size(), 0);
+  ASSERT_GT(mapper_.serializedMeshLayer()->block_indices.size(), 0);
+  EXPECT_EQ(mapper_.serializedMeshLayer()->block_indices.size(),
+            sequential_mapper.serializedMeshLayer()->block_indices.size());
+  EXPECT_EQ(mapper_.serializedTsdfLayer()->block_indices.size(),
+            sequential_mapper.serializedTsdfLayer()->block_indices.size());
+  EXPECT_EQ(mapper_.serializedTsdfLayer()->voxels.size(),
+            sequential_mapper.serializedTsdfLayer()->voxels.size());
+}
+
+TEST_F(MapperLayerStreamerTest, PrioritizedMeshByteBudget) {
+  const std::vector<Index3D> all_mesh_blocks =
+      mapper_.mesh_layer().getAllBlockIndices();
+  ASSERT_GT(all_mesh_blocks.size(), 1);
+
+  // A budget which fits some, but not all, mesh blocks.
+  constexpr int kMaxBytesPerPublish = 20000;
+  mapper_.mesh_streaming_max_bytes_per_publish(kMaxBytesPerPublish);
+  BlockExclusionParams exclusion_params;
+  exclusion_params.exclusion_center_m = Vector3f(1.0f, 1.0f, 0.0f);
+
+  mapper_.serializeSelectedLayers(LayerType::kMesh,
+                                  kLayerStreamerUnlimitedBandwidth,
+                                  exclusion_params);
+  std::vector<Index3D> streamed_blocks =
+      mapper_.serializedMeshLayer()->block_indices;
+  ASSERT_GT(streamed_blocks.size(), 0);
+  ASSERT_LT(streamed_blocks.size(), all_mesh_blocks.size());
+
+  // In the first round, the streamed blocks are the ones closest to the robot.
+  const float block_size_m = mapper_.mesh_layer().block_size();
+  const auto distance_to_robot = [&](const Index3D& block_index) {
+    return (getCenterPositionFromBlockIndex(block_size_m, block_index) -
+            exclusion_params.exclusion_center_m.value())
+        .norm();
+  };
+  float max_streamed_distance_m = 0.0f;
+  Index3DSet streamed_set;
+  for (const Index3D& block_index : streamed_blocks) {
+    max_streamed_distance_m =
+        std::max(max_streamed_distance_m, distance_to_robot(block_index));
+    streamed_set.insert(block_index);
+  }
+  for (const Index3D& block_index : all_mesh_blocks) {
+    if (streamed_set.count(block_index) == 0) {
+      EXPECT_GE(distance_to_robot(block_index) + 1e-4f,
+                max_streamed_distance_m);
+    }
+  }
+
+  // The remaining blocks are streamed in the following calls.
+  for (size_t i = 0; i < all_mesh_blocks.size(); ++i) {
+    if (streamed_set.size() == all_mesh_blocks.size()) {
+      break;
+    }
+    mapper_.serializeSelectedLayers(LayerType::kMesh,
+                                    kLayerStreamerUnlimitedBandwidth,
+                                    exclusion_params);
+    for (const Index3D& block_index :
+         mapper_.serializedMeshLayer()->block_indices) {
+      EXPECT_EQ(streamed_set.count(block_index), 0);
+      streamed_set.insert(block_index);
+    }
+  }
+  EXPECT_EQ(streamed_set.size(), all_mesh_blocks.size());
+}
+
 TEST_F(MapperLayerStreamerTest, ColorAndTsdfHasSameNumberOfBlocks) {
   mapper_.serializeSelectedLayers(
       LayerTypeBitMask(LayerTypeBitMask(LayerType::kColor) | LayerType::kTsdf),
@@ -131,6 +131,64 @@ TEST(ConnectedComponents, BlobInBottomRightCorner) {
   for (auto p : pixels) EXPECT_GT(mask_out(p[0], p[1]), 0);
 }
 
+TEST(ConnectedComponents, FullResolutionShapes) {
+  // A "U" and a staircase, which only connect through pixels far from their
+  // first pixel in scan order, and an isolated pixel.
+  constexpr int kRows = 32;
+  constexpr int kCols = 32;
+  MonoImage mask(kRows, kCols, MemoryType::kHost);
+  MonoImage mask_out(kRows, kCols, MemoryType::kHost);
+  for (int i = 0; i < mask.numel(); ++i) {
+    mask(i) = 0;
+  }
+  int u_size = 0;
+  for (int row = 0; row < 10; ++row) {
+    mask(row, 0) = 255;
+    mask(row, 9) = 255;
+    u_size += 2;
+  }
+  for (int col = 1; col < 9; ++col) {
+    mask(9, col) = 255;
+    ++u_size;
+  }
+  int staircase_size = 0;
+  for (int step = 0; step < 12; ++step) {
+    mask(15 + step, 30 - step) = 255;
+    mask(15 + step, 29 - step) = 255;
+    staircase_size += 2;
+  }
+  mask(0, 20) = 255;
+
+  constexpr int kFullResolution = 1;
+  image::MaskPreprocessor mask_preprocessor(
+      std::make_shared<CudaStreamOwning>(), kFullResolution);
+
+  // Only the U and the staircase survive.
+  mask_preprocessor.removeSmallConnectedComponents(mask, 2, &mask_out);
+  EXPECT_EQ(mask_out(0, 20), 0);
+  int num_masked = 0;
+  for (int i = 0; i < mask_out.numel(); ++i) {
+    num_masked += mask_out(i) > 0;
+    EXPECT_EQ(mask_out(i) > 0, mask(i) > 0 && i != 20);
+  }
+  EXPECT_EQ(num_masked, u_size + staircase_size);
+
+  // Only the U survives.
+  mask_preprocessor.removeSmallConnectedComponents(mask, staircase_size + 1,
+                                                   &mask_out);
+  EXPECT_GT(mask_out(0, 0), 0);
+  EXPECT_GT(mask_out(0, 9), 0);
+  EXPECT_EQ(mask_out(15, 30), 0);
+  EXPECT_EQ(mask_out(26, 19), 0);
+
+  // Nothing survives.
+  mask_preprocessor.removeSmallConnectedComponents(mask, u_size + 1,
+                                                   &mask_out);
+  for (int i = 0; i < mask_out.numel(); ++i) {
+    EXPECT_EQ(mask_out(i), 0);
+  }
+}
+
 int main(int argc, char** argv) {
   FLAGS_alsologtostderr = true;
   google::InitGoogleLogging(argv[0]);
@@ -14,6 +14,9 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <fstream>
+#include <limits>
 #include <string>
 
 #include "nvblox/core/indexing.h"
@@ -27,6 +30,7 @@ limitations under the License.
 #include "nvblox/map/layer.h"
 #include "nvblox/map/voxels.h"
 #include "nvblox/mesh/mesh_block.h"
+#include "nvblox/mesh/mesh_decimator.h"
 #include "nvblox/mesh/mesh_integrator.h"
 #include "nvblox/primitives/scene.h"
 #include "nvblox/tests/mesh_utils.h"
@@ -37,6 +41,14 @@ using namespace nvblox;
 
 constexpr float kFloatEpsilon = 1e-4;
 
+template <typename T>
+std::vector<T> toStdVector(const unified_vector<T>& vector) {
+  const CudaStreamOwning cuda_stream;
+  std::vector<T> std_vector = vector.toVectorAsync(cuda_stream);
+  cuda_stream.synchronize();
+  return std_vector;
+}
+
 class MeshTest : public ::testing::Test {
  protected:
   void SetUp() override {
@@ -176,6 +188,107 @@ TEST_F(MeshTest, ComplexScene) {
   std::cout << timing::Timing::Print();
 }
 
+TEST_F(MeshTest, BinaryPlyMatchesCombinedMesh) {
+  scene_.addPrimitive(std::make_unique<primitives::Plane>(
+      Vector3f(0.0, 0.0, 0.0), Vector3f(-1, 0, 0)));
+  scene_.addPrimitive(
+      std::make_unique<primitives::Sphere>(Vector3f(-2, -2, 0), 2.0));
+  scene_.generateLayerFromScene(4 * voxel_size_, sdf_layer_.get());
+  EXPECT_TRUE(mesh_integrator_.integrateMeshFromDistanceField(
+      *sdf_layer_, mesh_layer_.get(), DeviceType::kCPU));
+  const Mesh mesh = Mesh::fromLayer(*mesh_layer_, CudaStreamOwning());
+  ASSERT_GT(mesh.triangles.size(), 0);
+
+  const std::string filename = "test_mesh_binary.ply";
+  ASSERT_TRUE(io::outputMeshLayerToBinaryPly(*mesh_layer_, filename));
+
+  // Read back the file.
+  std::ifstream file(filename, std::ios::in | std::ios::binary);
+  std::string line;
+  std::vector<std::string> header;
+  while (std::getline(file, line) && line != "end_header") {
+    header.push_back(line);
+  }
+  ASSERT_GE(header.size(), 3);
+  EXPECT_EQ(header[1], "format binary_little_endian 1.0");
+  EXPECT_EQ(header[2],
+            "element vertex " + std::to_string(mesh.vertices.size()));
+  EXPECT_NE(std::find(header.begin(), header.end(),
+                      "element face " +
+                          std::to_string(mesh.triangles.size() / 3)),
+            header.end());
+  const auto has_property = [&header](const std::string& property) {
+    return std::find(header.begin(), header.end(), "property " + property) !=
+           header.end();
+  };
+  ASSERT_TRUE(has_property("float nx"));
+  const bool has_colors = has_property("uchar red");
+  EXPECT_EQ(has_colors, mesh.colors.size() == mesh.vertices.size());
+  for (size_t i = 0; i < mesh.vertices.size(); i++) {
+    Vector3f vertex;
+    Vector3f normal;
+    file.read(reinterpret_cast<char*>(vertex.data()), 3 * sizeof(float));
+    file.read(reinterpret_cast<char*>(normal.data()), 3 * sizeof(float));
+    EXPECT_TRUE(vertex == mesh.vertices[i]);
+    EXPECT_TRUE(normal == mesh.normals[i]);
+    if (has_colors) {
+      uint8_t rgb[3];
+      file.read(reinterpret_cast<char*>(rgb), sizeof(rgb));
+      EXPECT_EQ(rgb[0], mesh.colors[i].r);
+    }
+  }
+  for (size_t i = 0; i < mesh.triangles.size(); i += 3) {
+    uint8_t num_indices = 0;
+    int triangle[3];
+    file.read(reinterpret_cast<char*>(&num_indices), sizeof(num_indices));
+    file.read(reinterpret_cast<char*>(triangle), sizeof(triangle));
+    EXPECT_EQ(num_indices, 3);
+    for (int j = 0; j < 3; j++) {
+      EXPECT_EQ(triangle[j], mesh.triangles[i + j]);
+    }
+  }
+  EXPECT_TRUE(file.good());
+  EXPECT_EQ(file.peek(), std::ifstream::traits_type::eof());
+}
+
+TEST_F(MeshTest, MultithreadedCpuMeshMatchesSingleThreaded) {
+  scene_.addPrimitive(std::make_unique<primitives::Plane>(
+      Vector3f(0.0, 0.0, 0.0), Vector3f(-1, 0, 0)));
+  scene_.addPrimitive(
+      std::make_unique<primitives::Sphere>(Vector3f(-2, -2, 0), 2.0));
+  scene_.generateLayerFromScene(4 * voxel_size_, sdf_layer_.get());
+
+  // Mesh on a single thread.
+  mesh_integrator_.num_cpu_threads(1);
+  BlockLayer<MeshBlock> single_threaded_mesh(block_size_, MemoryType::kUnified);
+  EXPECT_TRUE(mesh_integrator_.integrateMeshFromDistanceField(
+      *sdf_layer_, &single_threaded_mesh, DeviceType::kCPU));
+
+  // Mesh on several threads.
+  constexpr int kNumThreads = 4;
+  mesh_integrator_.num_cpu_threads(kNumThreads);
+  BlockLayer<MeshBlock> multithreaded_mesh(block_size_, MemoryType::kUnified);
+  EXPECT_TRUE(mesh_integrator_.integrateMeshFromDistanceField(
+      *sdf_layer_, &multithreaded_mesh, DeviceType::kCPU));
+
+  // The threads mesh disjoint blocks, so the meshes should be identical.
+  ASSERT_GT(single_threaded_mesh.numAllocatedBlocks(), 0);
+  EXPECT_EQ(single_threaded_mesh.numAllocatedBlocks(),
+            multithreaded_mesh.numAllocatedBlocks());
+  for (const Index3D& block_index : single_threaded_mesh.getAllBlockIndices()) {
+    MeshBlock::ConstPtr expected_block =
+        single_threaded_mesh.getBlockAtIndex(block_index);
+    MeshBlock::ConstPtr block = multithreaded_mesh.getBlockAtIndex(block_index);
+    ASSERT_NE(block, nullptr);
+    ASSERT_EQ(block->vertices.size(), expected_block->vertices.size());
+    ASSERT_EQ(block->triangles.size(), expected_block->triangles.size());
+    for (size_t i = 0; i < block->vertices.size(); i++) {
+      EXPECT_TRUE(block->vertices[i].isApprox(expected_block->vertices[i]));
+      EXPECT_EQ(block->triangles[i], expected_block->triangles[i]);
+    }
+  }
+}
+
 TEST_F(MeshTest, GPUPlaneTest) {
   // Create a scene that's just a plane.
   // Plane at the origin pointing in the -x direction.
@@ -496,6 +609,150 @@ TEST_F(MeshTest, InPlaceWeldingTest) {
   std::cout << timing::Timing::Print();
 }
 
+TEST_F(MeshTest, FusedMeshingMatchesSeparatePasses) {
+  scene_.addPrimitive(std::make_unique<primitives::Plane>(
+      Vector3f(0.0, 0.0, 0.0), Vector3f(-1, 0, 0)));
+  scene_.addPrimitive(
+      std::make_unique<primitives::Sphere>(Vector3f(-2, -2, 0), 2.0));
+  scene_.generateLayerFromScene(4 * voxel_size_, sdf_layer_.get());
+
+  MeshIntegrator separate_integrator;
+  separate_integrator.weld_vertices(false);
+  separate_integrator.fused_meshing(false);
+  MeshLayer separate_mesh_layer(block_size_, MemoryType::kUnified);
+  EXPECT_TRUE(separate_integrator.integrateMeshFromDistanceField(
+      *sdf_layer_, &separate_mesh_layer, DeviceType::kGPU));
+
+  mesh_integrator_.fused_meshing(true);
+  EXPECT_TRUE(mesh_integrator_.integrateMeshFromDistanceField(
+      *sdf_layer_, mesh_layer_.get(), DeviceType::kGPU));
+
+  // The same blocks are meshed with the same (but reordered) vertices.
+  const std::vector<Index3D> block_indices =
+      separate_mesh_layer.getAllBlockIndices();
+  EXPECT_GT(block_indices.size(), 0);
+  EXPECT_EQ(block_indices.size(), mesh_layer_->numAllocatedBlocks());
+  auto threed_less = [](const Vector3f& p_1, const Vector3f& p_2) -> bool {
+    if (p_1.x() != p_2.x()) {
+      return p_1.x() < p_2.x();
+    }
+    if (p_1.y() != p_2.y()) {
+      return p_1.y() < p_2.y();
+    }
+    return p_1.z() < p_2.z();
+  };
+  for (const Index3D& block_index : block_indices) {
+    MeshBlock::ConstPtr separate_block =
+        separate_mesh_layer.getBlockAtIndex(block_index);
+    MeshBlock::ConstPtr fused_block = mesh_layer_->getBlockAtIndex(block_index);
+    ASSERT_NE(fused_block, nullptr);
+    ASSERT_EQ(separate_block->vertices.size(), fused_block->vertices.size());
+    EXPECT_EQ(separate_block->triangles.size(), fused_block->triangles.size());
+    EXPECT_EQ(fused_block->normals.size(), fused_block->vertices.size());
+
+    std::vector<Vector3f> separate_vertices =
+        toStdVector(separate_block->vertices);
+    std::vector<Vector3f> fused_vertices = toStdVector(fused_block->vertices);
+    std::sort(separate_vertices.begin(), separate_vertices.end(), threed_less);
+    std::sort(fused_vertices.begin(), fused_vertices.end(), threed_less);
+    for (size_t i = 0; i < fused_vertices.size(); i++) {
+      EXPECT_TRUE(
+          (separate_vertices[i].array() == fused_vertices[i].array()).all());
+    }
+  }
+}
+
+TEST_F(MeshTest, FusedWeldingKeepsTriangles) {
+  scene_.addPrimitive(std::make_unique<primitives::Plane>(
+      Vector3f(0.0, 0.0, 0.0), Vector3f(-1, 0, 0)));
+  scene_.addPrimitive(std::make_unique<primitives::Plane>(
+      Vector3f(2.1, 0.1, 0.1), Vector3f(0, -1, 0)));
+  scene_.addPrimitive(
+      std::make_unique<primitives::Sphere>(Vector3f(-2, -2, 0), 2.0));
+  scene_.generateLayerFromScene(4 * voxel_size_, sdf_layer_.get());
+
+  mesh_integrator_.fused_meshing(true);
+  EXPECT_TRUE(mesh_integrator_.integrateMeshFromDistanceField(
+      *sdf_layer_, mesh_layer_.get(), DeviceType::kGPU));
+
+  MeshIntegrator welding_integrator;
+  welding_integrator.weld_vertices(true);
+  welding_integrator.fused_meshing(true);
+  MeshLayer welded_mesh_layer(block_size_, MemoryType::kUnified);
+  EXPECT_TRUE(welding_integrator.integrateMeshFromDistanceField(
+      *sdf_layer_, &welded_mesh_layer, DeviceType::kGPU));
+
+  // Both meshes list the triangles in the same order, so welding must only
+  // have replaced the duplicated vertices by shared ones.
+  const std::vector<Index3D> block_indices = mesh_layer_->getAllBlockIndices();
+  EXPECT_GT(block_indices.size(), 0);
+  for (const Index3D& block_index : block_indices) {
+    MeshBlock::ConstPtr block = mesh_layer_->getBlockAtIndex(block_index);
+    MeshBlock::ConstPtr welded_block =
+        welded_mesh_layer.getBlockAtIndex(block_index);
+    ASSERT_NE(welded_block, nullptr);
+    EXPECT_LT(welded_block->vertices.size(), block->vertices.size());
+    ASSERT_EQ(welded_block->triangles.size(), block->triangles.size());
+    ASSERT_EQ(welded_block->normals.size(), welded_block->vertices.size());
+
+    const std::vector<Vector3f> vertices = toStdVector(block->vertices);
+    const std::vector<int> triangles = toStdVector(block->triangles);
+    const std::vector<Vector3f> welded_vertices =
+        toStdVector(welded_block->vertices);
+    const std::vector<Vector3f> welded_normals =
+        toStdVector(welded_block->normals);
+    const std::vector<int> welded_triangles =
+        toStdVector(welded_block->triangles);
+    for (size_t i = 0; i < triangles.size(); i++) {
+      ASSERT_GE(welded_triangles[i], 0);
+      ASSERT_LT(welded_triangles[i], static_cast<int>(welded_vertices.size()));
+      EXPECT_TRUE(welded_vertices[welded_triangles[i]].isApprox(
+          vertices[triangles[i]], kFloatEpsilon));
+    }
+    for (const Vector3f& normal : welded_normals) {
+      EXPECT_NEAR(normal.norm(), 1.0f, kFloatEpsilon);
+    }
+  }
+}
+
+TEST_F(MeshTest, FusedMeshingGrowsStagingArena) {
+  scene_.addPrimitive(
+      std::make_unique<primitives::Sphere>(Vector3f(0, 0, 1.5), 1.2));
+  scene_.generateLayerFromScene(4 * voxel_size_, sdf_layer_.get());
+  const std::vector<Index3D> all_block_indices =
+      sdf_layer_->getAllBlockIndices();
+
+  // Mesh a single block first, such that the staging arena is sized for one
+  // block, and then the whole map with the same integrator.
+  mesh_integrator_.fused_meshing(true);
+  EXPECT_TRUE(mesh_integrator_.integrateBlocksGPU(
+      *sdf_layer_, {all_block_indices.front()}, mesh_layer_.get()));
+  EXPECT_TRUE(mesh_integrator_.integrateBlocksGPU(
+      *sdf_layer_, all_block_indices, mesh_layer_.get()));
+
+  MeshIntegrator fresh_integrator;
+  fresh_integrator.weld_vertices(false);
+  fresh_integrator.fused_meshing(true);
+  MeshLayer fresh_mesh_layer(block_size_, MemoryType::kUnified);
+  EXPECT_TRUE(fresh_integrator.integrateBlocksGPU(
+      *sdf_layer_, all_block_indices, &fresh_mesh_layer));
+
+  EXPECT_GT(fresh_mesh_layer.numAllocatedBlocks(), 0);
+  for (const Index3D& block_index : fresh_mesh_layer.getAllBlockIndices()) {
+    MeshBlock::ConstPtr block = mesh_layer_->getBlockAtIndex(block_index);
+    MeshBlock::ConstPtr fresh_block =
+        fresh_mesh_layer.getBlockAtIndex(block_index);
+    ASSERT_NE(block, nullptr);
+    ASSERT_EQ(block->vertices.size(), fresh_block->vertices.size());
+    const std::vector<Vector3f> vertices = toStdVector(block->vertices);
+    const std::vector<Vector3f> fresh_vertices =
+        toStdVector(fresh_block->vertices);
+    for (size_t i = 0; i < vertices.size(); i++) {
+      EXPECT_TRUE((vertices[i].array() == fresh_vertices[i].array()).all());
+    }
+  }
+}
+
 TEST_F(MeshTest, WeldingPartsTest) {
   // Create some scene.
   scene_.addPrimitive(std::make_unique<primitives::Plane>(
@@ -636,6 +893,62 @@ TEST_F(MeshTest, WeldingPartsTest) {
   std::cout << timing::Timing::Print();
 }
 
+TEST_F(MeshTest, DecimatedPlaneMesh) {
+  // Plane at the origin pointing in the -x direction.
+  scene_.addPrimitive(std::make_unique<primitives::Plane>(
+      Vector3f(0.00, 0.0, 0.0), Vector3f(-1, 0, 0)));
+  scene_.generateLayerFromScene(4 * voxel_size_, sdf_layer_.get());
+  EXPECT_TRUE(mesh_integrator_.integrateMeshFromDistanceField(
+      *sdf_layer_, mesh_layer_.get(), DeviceType::kGPU));
+  const std::vector<Index3D> block_indices = mesh_layer_->getAllBlockIndices();
+  ASSERT_GT(block_indices.size(), 0);
+
+  MeshDecimator decimator;
+  size_t last_num_vertices = std::numeric_limits<size_t>::max();
+  for (int lod_level = 0; lod_level <= MeshDecimator::kMaxLodLevel;
+       lod_level++) {
+    MeshLayer decimated_layer(block_size_, MemoryType::kUnified);
+    decimator.decimateBlocks(*mesh_layer_, block_indices,
+                             std::vector<int>(block_indices.size(), lod_level),
+                             &decimated_layer);
+
+    size_t num_vertices = 0;
+    const float cell_size = voxel_size_ * (1 << lod_level);
+    for (const Index3D& block_index : block_indices) {
+      MeshBlock::ConstPtr block = decimated_layer.getBlockAtIndex(block_index);
+      ASSERT_NE(block, nullptr);
+      num_vertices += block->vertices.size();
+      EXPECT_EQ(block->normals.size(), block->vertices.size());
+      EXPECT_EQ(block->triangles.size() % 3, 0);
+      for (size_t i = 0; i < block->triangles.size(); i++) {
+        EXPECT_GE(block->triangles[i], 0);
+        EXPECT_LT(block->triangles[i], block->vertices.size());
+      }
+      // Vertices are moved at most to the center of their cell.
+      for (size_t i = 0; i < block->vertices.size(); i++) {
+        EXPECT_LE(std::abs(block->vertices[i].x()), cell_size);
+      }
+    }
+    // Each level reduces the vertex count.
+    EXPECT_LT(num_vertices, last_num_vertices);
+    last_num_vertices = num_vertices;
+  }
+}
+
+TEST_F(MeshTest, MeshLodLevel) {
+  MeshDecimator decimator;
+  decimator.full_resolution_distance_m(4.0f);
+  decimator.max_lod_level(2);
+  const float block_size = 1.0f;
+  const Vector3f viewer(0.5f, 0.5f, 0.5f);
+  EXPECT_EQ(decimator.getLodLevel(Index3D(0, 0, 0), block_size, viewer), 0);
+  EXPECT_EQ(decimator.getLodLevel(Index3D(3, 0, 0), block_size, viewer), 0);
+  EXPECT_EQ(decimator.getLodLevel(Index3D(5, 0, 0), block_size, viewer), 1);
+  EXPECT_EQ(decimator.getLodLevel(Index3D(9, 0, 0), block_size, viewer), 2);
+  // Clamped to the max level
+  EXPECT_EQ(decimator.getLodLevel(Index3D(100, 0, 0), block_size, viewer), 2);
+}
+
 int main(int argc, char** argv) {
   google::InitGoogleLogging(argv[0]);
   FLAGS_alsologtostderr = true;
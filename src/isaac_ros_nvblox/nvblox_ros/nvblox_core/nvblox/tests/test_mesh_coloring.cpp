@@ -88,6 +88,73 @@ TEST(MeshColoringTests, UniformColorSphere) {
       });
 }
 
+TEST(MeshColoringTests, FusedColoringMatchesSeparatePass) {
+  constexpr float voxel_size_m = 0.1;
+  constexpr float block_size_m =
+      VoxelBlock<TsdfVoxel>::kVoxelsPerSide * voxel_size_m;
+
+  // A sphere on the ground.
+  TsdfLayer tsdf_layer(voxel_size_m, MemoryType::kUnified);
+  primitives::Scene scene;
+  scene.aabb() = AxisAlignedBoundingBox(Vector3f(-5.0f, -5.0f, 0.0f),
+                                        Vector3f(5.0f, 5.0f, 5.0f));
+  scene.addGroundLevel(0.0f);
+  scene.addPrimitive(
+      std::make_unique<primitives::Sphere>(Vector3f(0.0f, 0.0f, 2.0f), 2.0f));
+  scene.generateLayerFromScene(2 * voxel_size_m, &tsdf_layer);
+
+  // Color every voxel differently, and leave out every other block such that
+  // some of the mesh gets the default color.
+  ColorLayer color_layer(voxel_size_m, MemoryType::kUnified);
+  for (const Index3D& block_idx : tsdf_layer.getAllBlockIndices()) {
+    if (block_idx.x() % 2 == 0) {
+      continue;
+    }
+    ColorBlock::Ptr color_block = color_layer.allocateBlockAtIndex(block_idx);
+    callFunctionOnAllVoxels<ColorVoxel>(
+        color_block.get(), [](const Index3D& voxel_idx, ColorVoxel* voxel) {
+          voxel->color = Color(32 * voxel_idx.x(), 32 * voxel_idx.y(),
+                               32 * voxel_idx.z());
+        });
+  }
+  const std::vector<Index3D> block_indices = tsdf_layer.getAllBlockIndices();
+
+  // Colored while meshing
+  MeshIntegrator fused_integrator;
+  fused_integrator.fused_meshing(true);
+  MeshLayer fused_mesh_layer(block_size_m, MemoryType::kUnified);
+  EXPECT_TRUE(fused_integrator.integrateBlocksGPU(
+      tsdf_layer, block_indices, &fused_mesh_layer, &color_layer));
+
+  // Colored after meshing
+  MeshIntegrator separate_integrator;
+  separate_integrator.fused_meshing(true);
+  MeshLayer separate_mesh_layer(block_size_m, MemoryType::kUnified);
+  EXPECT_TRUE(separate_integrator.integrateBlocksGPU(tsdf_layer, block_indices,
+                                                     &separate_mesh_layer));
+  separate_integrator.colorMesh(color_layer, &separate_mesh_layer);
+
+  EXPECT_GT(fused_mesh_layer.numAllocatedBlocks(), 0);
+  EXPECT_EQ(fused_mesh_layer.numAllocatedBlocks(),
+            separate_mesh_layer.numAllocatedBlocks());
+  for (const Index3D& block_idx : separate_mesh_layer.getAllBlockIndices()) {
+    MeshBlock::ConstPtr separate_block =
+        separate_mesh_layer.getBlockAtIndex(block_idx);
+    MeshBlock::ConstPtr fused_block =
+        fused_mesh_layer.getBlockAtIndex(block_idx);
+    ASSERT_NE(fused_block, nullptr);
+    ASSERT_EQ(fused_block->vertices.size(), separate_block->vertices.size());
+    ASSERT_EQ(fused_block->colors.size(), fused_block->vertices.size());
+    ASSERT_EQ(separate_block->colors.size(), separate_block->vertices.size());
+    for (size_t i = 0; i < fused_block->vertices.size(); i++) {
+      EXPECT_TRUE((fused_block->vertices[i].array() ==
+                   separate_block->vertices[i].array())
+                      .all());
+      EXPECT_EQ(fused_block->colors[i], separate_block->colors[i]);
+    }
+  }
+}
+
 TEST(MeshColoringTests, CPUvsGPUon3DMatch) {
   // Load 3dmatch image
   const std::string base_path = "../tests/data/3dmatch";
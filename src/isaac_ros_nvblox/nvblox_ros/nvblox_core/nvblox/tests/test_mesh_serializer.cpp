@@ -15,8 +15,10 @@ limitations under the License.
 */
 #include <gtest/gtest.h>
 #include <algorithm>
+#include "nvblox/core/indexing.h"
 #include "nvblox/mesh/mesh_integrator.h"
 #include "nvblox/primitives/scene.h"
+#include "nvblox/serialization/mesh_compression.h"
 #include "nvblox/serialization/mesh_serializer_gpu.h"
 #include "nvblox/tests/utils.h"
 
@@ -122,6 +124,15 @@ class MeshSerializerGpuTestFixture : public ::testing::Test {
   }
 
   // Data generators
+  std::vector<Index3D> nonEmptyBlockIndices() const {
+    std::vector<Index3D> block_indices;
+    for (const Index3D& index : mesh_layer_->getAllBlockIndices()) {
+      if (!mesh_layer_->getBlockAtIndex(index)->vertices.empty()) {
+        block_indices.push_back(index);
+      }
+    }
+    return block_indices;
+  }
 
   // Test subjects
   MeshLayer::Ptr mesh_layer_;
@@ -190,6 +201,132 @@ TEST_F(MeshSerializerGpuTestFixture, serializeNoBlocks) {
   ASSERT_TRUE(result->triangle_indices.empty());
 }
 
+TEST_F(MeshSerializerGpuTestFixture, serializeCompactEncoding) {
+  const std::vector<Index3D> block_indices_to_serialize =
+      mesh_layer_->getAllBlockIndices();
+  serializer_.compact_encoding(true);
+  serializer_.serialize(*(mesh_layer_.get()), block_indices_to_serialize,
+                        CudaStreamOwning());
+  validateSerializedMesh(block_indices_to_serialize);
+
+  const std::shared_ptr<const SerializedMeshLayer> result =
+      serializer_.getSerializedLayer();
+  ASSERT_EQ(result->quantized_vertices.size(), 3 * result->vertices.size());
+  ASSERT_EQ(result->encoded_normals.size(), 2 * result->vertices.size());
+
+  const float block_size = mesh_layer_->block_size();
+  const float max_quantization_error =
+      block_size * mesh_compression::kQuantizedVertexRangeBlocks / 65535.0f;
+  for (size_t i = 0; i < block_indices_to_serialize.size(); ++i) {
+    const MeshBlock* mesh_block =
+        mesh_layer_->getBlockAtIndex(block_indices_to_serialize[i]).get();
+    const Vector3f block_origin =
+        getPositionFromBlockIndex(block_size, block_indices_to_serialize[i]);
+    for (size_t j = 0; j < mesh_block->vertices.size(); ++j) {
+      const int serialized_index = result->vertex_block_offsets[i] + j;
+      for (int k = 0; k < 3; ++k) {
+        const float decoded =
+            block_origin[k] +
+            mesh_compression::dequantizeVertexCoordinate(
+                result->quantized_vertices[3 * serialized_index + k],
+                block_size);
+        EXPECT_NEAR(decoded, mesh_block->vertices[j][k],
+                    max_quantization_error);
+      }
+      const Vector3f decoded_normal = mesh_compression::decodeOctahedralNormal(
+          &result->encoded_normals[2 * serialized_index]);
+      EXPECT_GT(decoded_normal.dot(mesh_block->normals[j].normalized()),
+                0.999f);
+    }
+  }
+}
+
+TEST_F(MeshSerializerGpuTestFixture, serializeFromArena) {
+  MeshArena mesh_arena;
+  const std::vector<Index3D> all_indices = nonEmptyBlockIndices();
+  mesh_arena.updateBlocks(*mesh_layer_, all_indices);
+  EXPECT_EQ(mesh_arena.numBlocks(), all_indices.size());
+  EXPECT_TRUE(mesh_arena.isCompact());
+
+  // All blocks in arena order: a single contiguous copy.
+  const std::vector<Index3D> arena_indices = mesh_arena.getAllBlockIndices();
+  serializer_.serialize(mesh_arena, arena_indices, CudaStreamOwning());
+  validateSerializedMesh(arena_indices);
+
+  // A subset in reverse order: gathered from the arena.
+  const size_t num_subset_blocks = arena_indices.size() / 2;
+  std::vector<Index3D> subset(arena_indices.rbegin(),
+                              arena_indices.rbegin() + num_subset_blocks);
+  serializer_.serialize(mesh_arena, subset, CudaStreamOwning());
+  validateSerializedMesh(subset);
+}
+
+TEST_F(MeshSerializerGpuTestFixture, arenaUpdateAndCompact) {
+  MeshArena mesh_arena;
+  // Disable automatic compaction.
+  mesh_arena.max_wasted_fraction(1.0f);
+  const std::vector<Index3D> all_indices = nonEmptyBlockIndices();
+  mesh_arena.updateBlocks(*mesh_layer_, all_indices);
+  const int32_t initial_num_vertices = mesh_arena.numVertices();
+
+  // Grow the first block, such that it has to move to the end of the arena.
+  MeshBlock* grown_block = mesh_layer_->getBlockAtIndex(all_indices[0]).get();
+  const size_t num_vertices = grown_block->vertices.size();
+  grown_block->vertices.resizeAsync(2 * num_vertices, CudaStreamOwning());
+  grown_block->normals.resizeAsync(2 * num_vertices, CudaStreamOwning());
+  grown_block->colors.resizeAsync(2 * num_vertices, CudaStreamOwning());
+  for (size_t i = 0; i < num_vertices; ++i) {
+    grown_block->vertices[num_vertices + i] = grown_block->vertices[i];
+    grown_block->normals[num_vertices + i] = grown_block->normals[i];
+    grown_block->colors[num_vertices + i] = grown_block->colors[i];
+  }
+  mesh_arena.updateBlocks(*mesh_layer_, {all_indices[0]});
+  EXPECT_FALSE(mesh_arena.isCompact());
+  EXPECT_EQ(mesh_arena.numVertices(), initial_num_vertices + num_vertices);
+  EXPECT_EQ(mesh_arena.getAllBlockIndices().back(), all_indices[0]);
+
+  // Remove a block and compact.
+  mesh_arena.removeBlocks({all_indices[1]});
+  EXPECT_EQ(mesh_arena.numBlocks(), all_indices.size() - 1);
+  mesh_arena.compact();
+  EXPECT_TRUE(mesh_arena.isCompact());
+  EXPECT_EQ(mesh_arena.vertexEnd(), mesh_arena.numVertices());
+
+  // The remaining blocks are unchanged by the compaction.
+  MeshBlock mesh_block(MemoryType::kUnified);
+  EXPECT_FALSE(mesh_arena.copyBlockTo(all_indices[1], &mesh_block));
+  for (size_t i = 0; i < all_indices.size(); ++i) {
+    if (i == 1) {
+      continue;
+    }
+    const MeshBlock* expected =
+        mesh_layer_->getBlockAtIndex(all_indices[i]).get();
+    ASSERT_TRUE(mesh_arena.copyBlockTo(all_indices[i], &mesh_block));
+    ASSERT_EQ(mesh_block.vertices.size(), expected->vertices.size());
+    ASSERT_EQ(mesh_block.triangles.size(), expected->triangles.size());
+    for (size_t j = 0; j < expected->vertices.size(); ++j) {
+      EXPECT_EQ(mesh_block.vertices[j], expected->vertices[j]);
+      EXPECT_EQ(mesh_block.colors[j].r, expected->colors[j].r);
+    }
+    for (size_t j = 0; j < expected->triangles.size(); ++j) {
+      EXPECT_EQ(mesh_block.triangles[j], expected->triangles[j]);
+    }
+  }
+}
+
+TEST(MeshCompressionTest, octahedralNormals) {
+  constexpr int kNumNormals = 1000;
+  for (int i = 0; i < kNumNormals; ++i) {
+    const Vector3f normal = Vector3f::Random().normalized();
+    uint8_t encoded[2];
+    mesh_compression::encodeOctahedralNormal(normal, encoded);
+    const Vector3f decoded = mesh_compression::decodeOctahedralNormal(encoded);
+    EXPECT_NEAR(decoded.norm(), 1.0f, 1e-5);
+    // 8-bit octahedral encoding has an error of about one degree.
+    EXPECT_GT(decoded.dot(normal), std::cos(2.0f * M_PI / 180.0f));
+  }
+}
+
 TEST(MeshSerializerGpuTest, serializeOneEmptyBlock) {
   MeshLayer mesh_layer(1.f, MemoryType::kDevice);
 
@@ -0,0 +1,183 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <string>
+
+#include "nvblox/utils/delays.h"
+#include "nvblox/utils/metrics.h"
+#include "nvblox/utils/rates.h"
+#include "nvblox/utils/timing.h"
+
+using namespace nvblox;
+using namespace nvblox::timing;
+
+class MetricsTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    Timing::Reset();
+    Metrics::reset();
+  }
+};
+
+// Send a request to a server on localhost and return the full response.
+std::string httpRequest(int port, const std::string& request) {
+  const int fd = socket(AF_INET, SOCK_STREAM, 0);
+  EXPECT_GE(fd, 0);
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(static_cast<uint16_t>(port));
+  inet_pton(AF_INET, "127.0.0.1", &address.sin_addr);
+  EXPECT_EQ(
+      connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)), 0);
+  send(fd, request.data(), request.size(), 0);
+  std::string response;
+  char buffer[1024];
+  ssize_t num_received;
+  while ((num_received = recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+    response.append(buffer, static_cast<size_t>(num_received));
+  }
+  close(fd);
+  return response;
+}
+
+bool contains(const std::string& text, const std::string& substring) {
+  return text.find(substring) != std::string::npos;
+}
+
+TEST_F(MetricsTest, WriterFormat) {
+  MetricsWriter writer;
+  writer.addGauge("b_gauge", "A gauge.", {{"tag", "x\"y"}}, 1.5);
+  writer.addCounter("a_counter", "A counter.", {}, 3);
+  writer.addGauge("b_gauge", "A gauge.", {{"tag", "z"}}, 2);
+  writer.addHistogram("c_seconds", "A histogram.", {{"tag", "t"}},
+                      {0.1, 1.0, std::numeric_limits<double>::infinity()},
+                      {1, 2, 3}, 4.5);
+
+  const std::string expected =
+      "# TYPE a_counter counter\n"
+      "# HELP a_counter A counter.\n"
+      "a_counter_total 3\n"
+      "# TYPE b_gauge gauge\n"
+      "# HELP b_gauge A gauge.\n"
+      "b_gauge{tag=\"x\\\"y\"} 1.5\n"
+      "b_gauge{tag=\"z\"} 2\n"
+      "# TYPE c_seconds histogram\n"
+      "# HELP c_seconds A histogram.\n"
+      "c_seconds_bucket{tag=\"t\",le=\"0.1\"} 1\n"
+      "c_seconds_bucket{tag=\"t\",le=\"1\"} 3\n"
+      "c_seconds_bucket{tag=\"t\",le=\"+Inf\"} 6\n"
+      "c_seconds_count{tag=\"t\"} 6\n"
+      "c_seconds_sum{tag=\"t\"} 4.5\n"
+      "# EOF\n";
+  EXPECT_EQ(writer.str(), expected);
+}
+
+TEST(DurationHistogramTest, Buckets) {
+  DurationHistogram histogram;
+  histogram.Add(0.0);
+  histogram.Add(1e-5);
+  histogram.Add(1.5e-5);
+  histogram.Add(1e6);
+  EXPECT_EQ(histogram.Count(0), 2);
+  EXPECT_EQ(histogram.Count(1), 1);
+  EXPECT_EQ(histogram.Count(DurationHistogram::kNumBuckets - 1), 1);
+  EXPECT_DOUBLE_EQ(DurationHistogram::UpperBoundSeconds(1), 2e-5);
+  constexpr int kLastBucketIdx = DurationHistogram::kNumBuckets - 1;
+  EXPECT_TRUE(std::isinf(DurationHistogram::UpperBoundSeconds(kLastBucketIdx)));
+}
+
+TEST_F(MetricsTest, TimersRatesAndDelays) {
+  for (int i = 0; i < 3; ++i) {
+    Timer timer("metrics_test/timer");
+    timer.Stop();
+  }
+  Rates::tick("metrics_test/rate");
+  Delays::tick("metrics_test/delay", Time(0l), Time(2000000000l));
+
+  const std::string metrics = Metrics::toOpenMetrics();
+  EXPECT_TRUE(contains(metrics, "# TYPE nvblox_timer_seconds histogram\n"));
+  EXPECT_TRUE(contains(
+      metrics, "nvblox_timer_seconds_count{tag=\"metrics_test/timer\"} 3\n"));
+  EXPECT_TRUE(contains(metrics,
+                       "nvblox_timer_seconds_bucket{tag=\"metrics_test/"
+                       "timer\",le=\"+Inf\"} 3\n"));
+  EXPECT_TRUE(contains(metrics, "nvblox_rate_hz{tag=\"metrics_test/rate\"}"));
+  EXPECT_TRUE(contains(
+      metrics, "nvblox_delay_seconds{tag=\"metrics_test/delay\"} 2\n"));
+  EXPECT_TRUE(contains(metrics, "# EOF\n"));
+}
+
+TEST_F(MetricsTest, GaugesCountersAndCollectors) {
+  Metrics::setGauge("queue_depth", "Depth.", {{"queue", "depth"}}, 4);
+  Metrics::setGauge("queue_depth", "Depth.", {{"queue", "depth"}}, 2);
+  Metrics::addToCounter("dropped", "Drops.", {{"queue", "depth"}});
+  Metrics::addToCounter("dropped", "Drops.", {{"queue", "depth"}}, 2);
+  int num_collector_calls = 0;
+  Metrics::registerCollector("test", [&](MetricsWriter* writer) {
+    ++num_collector_calls;
+    writer->addGauge("collected", "", {}, 7);
+  });
+
+  std::string metrics = Metrics::toOpenMetrics();
+  EXPECT_EQ(num_collector_calls, 1);
+  EXPECT_TRUE(contains(metrics, "queue_depth{queue=\"depth\"} 2\n"));
+  EXPECT_TRUE(contains(metrics, "dropped_total{queue=\"depth\"} 3\n"));
+  EXPECT_TRUE(contains(metrics, "collected 7\n"));
+
+  Metrics::unregisterCollector("test");
+  metrics = Metrics::toOpenMetrics();
+  EXPECT_EQ(num_collector_calls, 1);
+  EXPECT_FALSE(contains(metrics, "collected"));
+}
+
+TEST_F(MetricsTest, Server) {
+  Metrics::setGauge("server_test_gauge", "", {}, 1);
+  MetricsServer server(0, "127.0.0.1");
+  ASSERT_TRUE(server.isRunning());
+  ASSERT_GT(server.port(), 0);
+
+  const std::string response =
+      httpRequest(server.port(), "GET /metrics HTTP/1.1\r\nHost: x\r\n\r\n");
+  EXPECT_TRUE(contains(response, "HTTP/1.1 200 OK\r\n"));
+  EXPECT_TRUE(contains(response, "application/openmetrics-text"));
+  EXPECT_TRUE(contains(response, "server_test_gauge 1\n"));
+
+  EXPECT_TRUE(contains(httpRequest(server.port(), "GET /x HTTP/1.1\r\n\r\n"),
+                       "404 Not Found"));
+  EXPECT_TRUE(contains(httpRequest(server.port(), "POST / HTTP/1.1\r\n\r\n"),
+                       "405 Method Not Allowed"));
+}
+
+TEST_F(MetricsTest, ServerPortTaken) {
+  MetricsServer server(0, "127.0.0.1");
+  ASSERT_TRUE(server.isRunning());
+  MetricsServer second_server(server.port(), "127.0.0.1");
+  EXPECT_FALSE(second_server.isRunning());
+}
+
+int main(int argc, char** argv) {
+  google::InitGoogleLogging(argv[0]);
+  FLAGS_alsologtostderr = true;
+  google::InstallFailureSignalHandler();
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
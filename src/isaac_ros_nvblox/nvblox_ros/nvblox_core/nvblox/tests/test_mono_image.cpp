@@ -99,6 +99,43 @@ TEST_F(MonoImageTest, roundtrip) {
   }
 }
 
+TEST_F(MonoImageTest, padOrCrop) {
+  // Pad the rows and crop the columns, both by an odd amount.
+  constexpr int kPaddedRows = 13;
+  constexpr int kCroppedCols = 7;
+  MonoImage padded_cropped(MemoryType::kUnified);
+  image::padOrCropGPUAsync(mono_frame_, kPaddedRows, kCroppedCols,
+                           &padded_cropped, CudaStreamOwning());
+
+  EXPECT_EQ(padded_cropped.rows(), kPaddedRows);
+  EXPECT_EQ(padded_cropped.cols(), kCroppedCols);
+
+  // One row of padding on top and one column cropped on the left.
+  const int row_offset = (rows_ - kPaddedRows) / 2;
+  const int col_offset = (cols_ - kCroppedCols) / 2;
+  EXPECT_EQ(row_offset, -1);
+  EXPECT_EQ(col_offset, 1);
+  for (int y = 0; y < padded_cropped.rows(); ++y) {
+    for (int x = 0; x < padded_cropped.cols(); ++x) {
+      if (y == row_set_ - row_offset && x == col_set_ - col_offset) {
+        EXPECT_EQ(padded_cropped(y, x), 255);
+      } else {
+        EXPECT_EQ(padded_cropped(y, x), 0);
+      }
+    }
+  }
+
+  // Undoing the operation restores the original image.
+  MonoImage restored(MemoryType::kUnified);
+  image::padOrCropGPUAsync(padded_cropped, rows_, kCroppedCols, &restored,
+                           CudaStreamOwning());
+  for (int y = 0; y < restored.rows(); ++y) {
+    for (int x = 0; x < restored.cols(); ++x) {
+      EXPECT_EQ(restored(y, x), mono_frame_(y, x + col_offset));
+    }
+  }
+}
+
 int main(int argc, char** argv) {
   FLAGS_alsologtostderr = true;
   google::InitGoogleLogging(argv[0]);
@@ -196,6 +196,135 @@ TEST_F(MultiMapperTest, MaskOnAndOff) {
   LOG(INFO) << "num_non_zero_weight_voxels: ";
 }
 
+TEST(MultiMapperForegroundTest, CoarseOccupancyOnlyForeground) {
+  constexpr float kVoxelSizeM = 0.05f;
+  constexpr float kForegroundVoxelSizeM = 0.2f;
+  MultiMapper multi_mapper(kVoxelSizeM, MappingType::kHumanWithStaticTsdf,
+                           EsdfMode::k2D, MemoryType::kUnified);
+  EXPECT_EQ(multi_mapper.foreground_mapper()->voxel_size_m(), kVoxelSizeM);
+
+  MultiMapperParams params;
+  params.foreground_voxel_size_m = kForegroundVoxelSizeM;
+  params.foreground_occupancy_only = true;
+  multi_mapper.setMultiMapperParams(params);
+  EXPECT_EQ(multi_mapper.background_mapper()->voxel_size_m(), kVoxelSizeM);
+  EXPECT_EQ(multi_mapper.foreground_mapper()->voxel_size_m(),
+            kForegroundVoxelSizeM);
+  EXPECT_NEAR(multi_mapper.foreground_mapper()->occupancy_layer().block_size(),
+              kForegroundVoxelSizeM * OccupancyBlock::kVoxelsPerSide,
+              kFloatEpsilon);
+
+  // Everything is foreground: the (coarse) foreground mapper gets occupancy
+  // but no color.
+  constexpr int kRows = 60;
+  constexpr int kCols = 80;
+  const Camera camera(50.0f, 50.0f, kCols / 2.0f, kRows / 2.0f, kCols, kRows);
+  DepthImage depth_frame(kRows, kCols, MemoryType::kUnified);
+  ColorImage color_frame(kRows, kCols, MemoryType::kUnified);
+  MonoImage mask(kRows, kCols, MemoryType::kUnified);
+  for (int row_idx = 0; row_idx < kRows; row_idx++) {
+    for (int col_idx = 0; col_idx < kCols; col_idx++) {
+      depth_frame(row_idx, col_idx) = 2.0f;
+      color_frame(row_idx, col_idx) = Color::Red();
+      mask(row_idx, col_idx) = 1;
+    }
+  }
+  multi_mapper.integrateDepthAndColor(
+      depth_frame, color_frame, mask, Transform::Identity(),
+      Transform::Identity(), Transform::Identity(), camera, camera);
+  EXPECT_GT(
+      multi_mapper.foreground_mapper()->occupancy_layer().numAllocatedBlocks(),
+      0);
+  EXPECT_EQ(
+      multi_mapper.foreground_mapper()->color_layer().numAllocatedBlocks(), 0);
+}
+
+TEST(MultiMapperParallelTest, ParallelEqualsSerial) {
+  constexpr float kVoxelSizeM = 0.05f;
+  MultiMapper parallel_mapper(kVoxelSizeM, MappingType::kHumanWithStaticTsdf,
+                              EsdfMode::k3D, MemoryType::kUnified);
+  MultiMapper serial_mapper(kVoxelSizeM, MappingType::kHumanWithStaticTsdf,
+                            EsdfMode::k3D, MemoryType::kUnified);
+  EXPECT_TRUE(parallel_mapper.parallel_mapper_updates());
+  serial_mapper.parallel_mapper_updates(false);
+
+  // A wall, the left half of which is masked as foreground.
+  constexpr int kRows = 60;
+  constexpr int kCols = 80;
+  const Camera camera(50.0f, 50.0f, kCols / 2.0f, kRows / 2.0f, kCols, kRows);
+  DepthImage depth_frame(kRows, kCols, MemoryType::kUnified);
+  ColorImage color_frame(kRows, kCols, MemoryType::kUnified);
+  MonoImage mask(kRows, kCols, MemoryType::kUnified);
+  for (int row_idx = 0; row_idx < kRows; row_idx++) {
+    for (int col_idx = 0; col_idx < kCols; col_idx++) {
+      depth_frame(row_idx, col_idx) = 2.0f;
+      color_frame(row_idx, col_idx) = Color::Red();
+      mask(row_idx, col_idx) = col_idx < kCols / 2 ? 1 : 0;
+    }
+  }
+  // Several frames, such that the foreground worker is reused.
+  constexpr int kNumFrames = 3;
+  for (int i = 0; i < kNumFrames; i++) {
+    Transform T_L_C = Transform::Identity();
+    T_L_C.translation().x() = 0.1f * i;
+    for (MultiMapper* multi_mapper : {&parallel_mapper, &serial_mapper}) {
+      multi_mapper->integrateDepthAndColor(
+          depth_frame, color_frame, mask, T_L_C, T_L_C, Transform::Identity(),
+          camera, camera);
+      multi_mapper->updateEsdf();
+    }
+  }
+
+  const TsdfLayer& parallel_tsdf =
+      parallel_mapper.background_mapper()->tsdf_layer();
+  const TsdfLayer& serial_tsdf =
+      serial_mapper.background_mapper()->tsdf_layer();
+  ASSERT_GT(serial_tsdf.numAllocatedBlocks(), 0);
+  ASSERT_EQ(parallel_tsdf.numAllocatedBlocks(),
+            serial_tsdf.numAllocatedBlocks());
+  for (const Index3D& block_idx : serial_tsdf.getAllBlockIndices()) {
+    const auto serial_block = serial_tsdf.getBlockAtIndex(block_idx);
+    const auto parallel_block = parallel_tsdf.getBlockAtIndex(block_idx);
+    ASSERT_TRUE(parallel_block);
+    for (int x_idx = 0; x_idx < TsdfBlock::kVoxelsPerSide; x_idx++) {
+      for (int y_idx = 0; y_idx < TsdfBlock::kVoxelsPerSide; y_idx++) {
+        for (int z_idx = 0; z_idx < TsdfBlock::kVoxelsPerSide; z_idx++) {
+          const TsdfVoxel& serial_voxel =
+              serial_block->voxels[x_idx][y_idx][z_idx];
+          const TsdfVoxel& parallel_voxel =
+              parallel_block->voxels[x_idx][y_idx][z_idx];
+          EXPECT_EQ(serial_voxel.distance, parallel_voxel.distance);
+          EXPECT_EQ(serial_voxel.weight, parallel_voxel.weight);
+        }
+      }
+    }
+  }
+
+  const OccupancyLayer& parallel_occupancy =
+      parallel_mapper.foreground_mapper()->occupancy_layer();
+  const OccupancyLayer& serial_occupancy =
+      serial_mapper.foreground_mapper()->occupancy_layer();
+  ASSERT_GT(serial_occupancy.numAllocatedBlocks(), 0);
+  ASSERT_EQ(parallel_occupancy.numAllocatedBlocks(),
+            serial_occupancy.numAllocatedBlocks());
+  for (const Index3D& block_idx : serial_occupancy.getAllBlockIndices()) {
+    const auto serial_block = serial_occupancy.getBlockAtIndex(block_idx);
+    const auto parallel_block = parallel_occupancy.getBlockAtIndex(block_idx);
+    ASSERT_TRUE(parallel_block);
+    for (int x_idx = 0; x_idx < OccupancyBlock::kVoxelsPerSide; x_idx++) {
+      for (int y_idx = 0; y_idx < OccupancyBlock::kVoxelsPerSide; y_idx++) {
+        for (int z_idx = 0; z_idx < OccupancyBlock::kVoxelsPerSide; z_idx++) {
+          EXPECT_EQ(
+              static_cast<float>(
+                  serial_block->voxels[x_idx][y_idx][z_idx].log_odds),
+              static_cast<float>(
+                  parallel_block->voxels[x_idx][y_idx][z_idx].log_odds));
+        }
+      }
+    }
+  }
+}
+
 int main(int argc, char** argv) {
   FLAGS_alsologtostderr = true;
   google::InitGoogleLogging(argv[0]);
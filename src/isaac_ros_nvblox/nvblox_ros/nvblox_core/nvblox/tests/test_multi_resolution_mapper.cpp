@@ -0,0 +1,187 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+
+#include "nvblox/mapper/multi_resolution_mapper.h"
+#include "nvblox/primitives/scene.h"
+
+#include "nvblox/tests/utils.h"
+
+using namespace nvblox;
+
+constexpr float kVoxelSizeM = 0.05f;
+constexpr int kCoarseVoxelSizeFactor = 4;
+
+class MultiResolutionMapperTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    // A 3m high corridor, 10m wide, ending in a wall 20m in front of the
+    // camera.
+    scene_.aabb() = AxisAlignedBoundingBox(Vector3f(-2.0f, -6.0f, -1.0f),
+                                           Vector3f(22.0f, 6.0f, 4.0f));
+    scene_.addGroundLevel(0.0f);
+    scene_.addCeiling(3.0f);
+    scene_.addPlaneBoundaries(-1.0f, 20.0f, -5.0f, 5.0f);
+
+    // The camera z axis points along the corridor (the world x axis).
+    T_L_C_ = Transform::Identity();
+    T_L_C_.prerotate(Eigen::Quaternionf(0.5, 0.5, 0.5, 0.5));
+    T_L_C_.pretranslate(Vector3f(0.0f, 0.0f, 1.5f));
+  }
+
+  primitives::Scene scene_;
+  Transform T_L_C_;
+  const Camera camera_ = Camera(300.0f, 300.0f, 320.0f, 240.0f, 640, 480);
+};
+
+TEST_F(MultiResolutionMapperTest, DownscaledCamera) {
+  constexpr int kFactor = 4;
+  const Camera downscaled_camera =
+      MultiResolutionMapper::getDownscaledCamera(camera_, kFactor);
+  EXPECT_EQ(downscaled_camera.width(), camera_.width() / kFactor);
+  EXPECT_EQ(downscaled_camera.height(), camera_.height() / kFactor);
+
+  // The ray through each downscaled pixel center matches the ray through the
+  // full resolution pixel it was sampled from.
+  for (int u = 0; u < downscaled_camera.width(); u += 7) {
+    for (int v = 0; v < downscaled_camera.height(); v += 7) {
+      const Vector3f ray_downscaled =
+          downscaled_camera.vectorFromPixelIndices(Index2D(u, v));
+      const Vector3f ray_full =
+          camera_.vectorFromPixelIndices(Index2D(u * kFactor, v * kFactor));
+      EXPECT_TRUE(ray_downscaled.isApprox(ray_full, 1e-5f));
+    }
+  }
+}
+
+TEST_F(MultiResolutionMapperTest, FineNearCoarseFar) {
+  MultiResolutionMapper mapper(kVoxelSizeM, kCoarseVoxelSizeFactor,
+                               ProjectiveLayerType::kTsdf,
+                               MemoryType::kUnified);
+  MultiResolutionMapperParams params;
+  params.fine_level_max_integration_distance_m = 10.0f;
+  params.coarse_level_max_integration_distance_m = 30.0f;
+  mapper.setMultiResolutionMapperParams(params);
+  EXPECT_NEAR(mapper.coarse_mapper()->voxel_size_m(),
+              kVoxelSizeM * kCoarseVoxelSizeFactor, 1e-6f);
+
+  constexpr float kMaxDistM = 30.0f;
+  DepthImage depth_frame(camera_.height(), camera_.width(),
+                         MemoryType::kUnified);
+  scene_.generateDepthImageFromScene(camera_, T_L_C_, kMaxDistM, &depth_frame);
+  mapper.integrateDepth(depth_frame, T_L_C_, camera_);
+  mapper.updateEsdf();
+
+  // The fine level ends at the fine integration distance while the coarse
+  // level reaches the end of the corridor.
+  const TsdfLayer& fine_tsdf = mapper.fine_mapper()->tsdf_layer();
+  const TsdfLayer& coarse_tsdf = mapper.coarse_mapper()->tsdf_layer();
+  float fine_max_x = 0.0f;
+  for (const Index3D& block_index : fine_tsdf.getAllBlockIndices()) {
+    fine_max_x = std::max(
+        fine_max_x,
+        getPositionFromBlockIndex(fine_tsdf.block_size(), block_index).x());
+  }
+  float coarse_max_x = 0.0f;
+  for (const Index3D& block_index : coarse_tsdf.getAllBlockIndices()) {
+    coarse_max_x = std::max(
+        coarse_max_x,
+        getPositionFromBlockIndex(coarse_tsdf.block_size(), block_index).x());
+  }
+  EXPECT_LT(fine_max_x, params.fine_level_max_integration_distance_m);
+  EXPECT_GT(coarse_max_x, 18.0f);
+  EXPECT_GT(fine_tsdf.numAllocatedBlocks(), 0);
+  EXPECT_GT(coarse_tsdf.numAllocatedBlocks(), 0);
+
+  // Query the ESDF in the middle of the corridor, near (answered by the fine
+  // level) and far (answered by the coarse level). The closest surfaces are
+  // the ground and the ceiling, 1.5m away.
+  const std::vector<Vector3f> points_L = {Vector3f(4.0f, 0.0f, 1.5f),
+                                          Vector3f(15.0f, 0.0f, 1.5f),
+                                          Vector3f(50.0f, 0.0f, 1.5f)};
+  CudaStreamOwning cuda_stream;
+  device_vector<Vector3f> points_device;
+  points_device.copyFromAsync(points_L, cuda_stream);
+  cuda_stream.synchronize();
+  device_vector<float> distances_device;
+  device_vector<bool> success_device;
+  mapper.getEsdfDistances(points_device, &distances_device, &success_device);
+  const std::vector<float> distances =
+      distances_device.toVectorAsync(cuda_stream);
+  const std::vector<bool> success = success_device.toVectorAsync(cuda_stream);
+  cuda_stream.synchronize();
+
+  ASSERT_EQ(distances.size(), points_L.size());
+  EXPECT_TRUE(success[0]);
+  EXPECT_NEAR(distances[0], 1.5f, 2.0f * kVoxelSizeM);
+  EXPECT_TRUE(success[1]);
+  EXPECT_NEAR(distances[1], 1.5f,
+              2.0f * kVoxelSizeM * kCoarseVoxelSizeFactor);
+  // Outside of both levels.
+  EXPECT_FALSE(success[2]);
+}
+
+TEST_F(MultiResolutionMapperTest, CoarsenFineLevel) {
+  MultiResolutionMapper mapper(kVoxelSizeM, kCoarseVoxelSizeFactor,
+                               ProjectiveLayerType::kTsdf,
+                               MemoryType::kUnified);
+  MultiResolutionMapperParams params;
+  params.fine_level_max_integration_distance_m = 10.0f;
+  params.coarse_level_max_integration_distance_m = 30.0f;
+  mapper.setMultiResolutionMapperParams(params);
+
+  constexpr float kMaxDistM = 30.0f;
+  DepthImage depth_frame(camera_.height(), camera_.width(),
+                         MemoryType::kUnified);
+  scene_.generateDepthImageFromScene(camera_, T_L_C_, kMaxDistM, &depth_frame);
+  mapper.integrateDepth(depth_frame, T_L_C_, camera_);
+  const TsdfLayer& fine_tsdf = mapper.fine_mapper()->tsdf_layer();
+  const size_t num_fine_blocks = fine_tsdf.numAllocatedBlocks();
+  ASSERT_GT(num_fine_blocks, 0);
+
+  // Disabled by default.
+  const Vector3f far_away_position_L(-20.0f, 0.0f, 1.5f);
+  EXPECT_TRUE(mapper.coarsenFineLevel(far_away_position_L).empty());
+
+  // Nothing is dropped while the fine level is in range.
+  params.coarsen_fine_level = true;
+  mapper.setMultiResolutionMapperParams(params);
+  EXPECT_TRUE(mapper.coarsenFineLevel(T_L_C_.translation()).empty());
+  EXPECT_EQ(fine_tsdf.numAllocatedBlocks(), num_fine_blocks);
+
+  // Once out of range, the blocks along the planar floor, walls and ceiling
+  // are dropped from the fine level.
+  const std::vector<Index3D> dropped_blocks =
+      mapper.coarsenFineLevel(far_away_position_L);
+  EXPECT_GT(dropped_blocks.size(), 0);
+  EXPECT_EQ(fine_tsdf.numAllocatedBlocks(),
+            num_fine_blocks - dropped_blocks.size());
+  for (const Index3D& block_idx : dropped_blocks) {
+    EXPECT_FALSE(fine_tsdf.isBlockAllocated(block_idx));
+  }
+
+  // Integrating again refines the dropped blocks.
+  mapper.integrateDepth(depth_frame, T_L_C_, camera_);
+  EXPECT_EQ(fine_tsdf.numAllocatedBlocks(), num_fine_blocks);
+}
+
+int main(int argc, char** argv) {
+  FLAGS_alsologtostderr = true;
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
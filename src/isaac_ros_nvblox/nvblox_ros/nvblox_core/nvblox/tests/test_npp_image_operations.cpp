@@ -183,6 +183,72 @@ TEST_P(ParameterizedNppImageTest, NppDilateMaskBorder) {
   EXPECT_EQ(mask_dilated(2, 2), 0);
 }
 
+TEST_F(NppImageTest, FusedDilationMatchesIterativeDilation) {
+  // Load the test image
+  DepthImage depth_frame(MemoryType::kUnified);
+  getDepthFrame(&depth_frame);
+  constexpr float kInvalidDepthThreshold = 1e-2;
+
+  MonoImage mask(depth_frame.rows(), depth_frame.cols(), MemoryType::kUnified);
+  MonoImage mask_tmp(depth_frame.rows(), depth_frame.cols(),
+                     MemoryType::kUnified);
+  MonoImage mask_fused(depth_frame.rows(), depth_frame.cols(),
+                       MemoryType::kUnified);
+  for (const int num_dilations :
+       {0, 1, 2, 3, 7, image::kMaxNumFusedDilations}) {
+    // Reference: threshold followed by repeated 3x3 dilations.
+    image::getInvalidDepthMaskAsync(depth_frame, stream_context_, &mask,
+                                    kInvalidDepthThreshold);
+    for (int i = 0; i < num_dilations; i++) {
+      image::dilateMask3x3Async(mask, stream_context_, &mask_tmp);
+      std::swap(mask, mask_tmp);
+    }
+    image::getDilatedInvalidDepthMaskGPUAsync(depth_frame,
+                                              kInvalidDepthThreshold,
+                                              num_dilations, &mask_fused,
+                                              cuda_stream_);
+    cuda_stream_.synchronize();
+
+    // Compare everywhere, including the borders.
+    int num_mismatches = 0;
+    for (int row_idx = 0; row_idx < depth_frame.rows(); row_idx++) {
+      for (int col_idx = 0; col_idx < depth_frame.cols(); col_idx++) {
+        num_mismatches +=
+            mask(row_idx, col_idx) != mask_fused(row_idx, col_idx);
+      }
+    }
+    EXPECT_EQ(num_mismatches, 0) << "num_dilations: " << num_dilations;
+  }
+}
+
+TEST_F(NppImageTest, FusedDilationBorder) {
+  // An invalid pixel in the corner of an image which isn't a multiple of the
+  // tile size.
+  constexpr int kRows = 37;
+  constexpr int kCols = 45;
+  constexpr int kNumDilations = 3;
+  DepthImage depth(kRows, kCols, MemoryType::kUnified);
+  for (int row_idx = 0; row_idx < kRows; row_idx++) {
+    for (int col_idx = 0; col_idx < kCols; col_idx++) {
+      depth(row_idx, col_idx) = 1.0f;
+    }
+  }
+  depth(kRows - 1, kCols - 1) = 0.0f;
+
+  MonoImage mask(kRows, kCols, MemoryType::kUnified);
+  image::getDilatedInvalidDepthMaskGPUAsync(depth, 1e-2, kNumDilations, &mask,
+                                            cuda_stream_);
+  cuda_stream_.synchronize();
+
+  for (int row_idx = 0; row_idx < kRows; row_idx++) {
+    for (int col_idx = 0; col_idx < kCols; col_idx++) {
+      const bool in_dilated_region = row_idx >= kRows - 1 - kNumDilations &&
+                                     col_idx >= kCols - 1 - kNumDilations;
+      EXPECT_EQ(mask(row_idx, col_idx), in_dilated_region ? NPP_MAX_8U : 0);
+    }
+  }
+}
+
 TEST_P(ParameterizedNppImageTest, NppSetMasked) {
   // This test runs for multiple memory types.
   const MemoryType memory_type = GetParam();
@@ -15,6 +15,8 @@ limitations under the License.
 */
 #include <gtest/gtest.h>
 
+#include <thread>
+
 #include "nvblox/core/unified_vector.h"
 #include "nvblox/utils/nvtx_ranges.h"
 #include "nvblox/utils/timing.h"
@@ -66,6 +68,34 @@ TEST(NvtxTest, TimerNvtx) {
   std::cout << timing::Timing::Print() << std::endl;
 }
 
+TEST(NvtxTest, FrameIds) {
+  timing::FrameIdGenerator generator;
+  EXPECT_EQ(generator.next("front").sequence, 0u);
+  EXPECT_EQ(generator.next("front").sequence, 1u);
+  EXPECT_EQ(generator.next("left").sequence, 0u);
+  const timing::FrameId front_frame = generator.next("front");
+  EXPECT_EQ(front_frame.toString(), "front#2");
+
+  EXPECT_FALSE(timing::currentFrameId().valid());
+  {
+    timing::ScopedFrameId scoped_frame_id(front_frame);
+    EXPECT_EQ(timing::currentFrameId().toString(), "front#2");
+    {
+      timing::ScopedFrameId nested_frame_id(generator.next("left"));
+      EXPECT_EQ(timing::currentFrameId().toString(), "left#1");
+      // Shows up tagged in the trace.
+      timing::TimerNvtx timer("frame_ids/nested");
+    }
+    EXPECT_EQ(timing::currentFrameId().toString(), "front#2");
+
+    // Other threads don't inherit the frame.
+    std::thread([]() {
+      EXPECT_FALSE(timing::currentFrameId().valid());
+    }).join();
+  }
+  EXPECT_FALSE(timing::currentFrameId().valid());
+}
+
 int main(int argc, char** argv) {
   google::InitGoogleLogging(argv[0]);
   FLAGS_alsologtostderr = true;
@@ -195,6 +195,58 @@ TEST_P(OccupancyDecayParameterizedTestFixture, DecayAll) {
   EXPECT_EQ(deallocated_blocks.size(), kNumBlocksToAllocate);
 }
 
+TEST(LayerDecayTest, SkipInactiveBlocks) {
+  constexpr int kNumBlocksToAllocate = 100;
+  constexpr float kMaxLogOdds = 20.f;
+  OccupancyLayer layer = initLayer(0.05f, kNumBlocksToAllocate, kMaxLogOdds);
+
+  OccupancyDecayIntegrator decay_integrator;
+  decay_integrator.deallocate_decayed_blocks(false);
+  decay_integrator.skip_inactive_blocks(true);
+
+  // Decay until everything is fully decayed.
+  CudaStreamOwning cuda_stream;
+  constexpr int kNumDecaysUntilConverged = 200;
+  for (int i = 0; i < kNumDecaysUntilConverged; i++) {
+    decay_integrator.decay(&layer, cuda_stream);
+  }
+  const size_t num_blocks = layer.numAllocatedBlocks();
+  ASSERT_GT(num_blocks, 2);
+
+  // Touch a single block. Only this block should be decayed by the next decay
+  // step, the others are skipped.
+  const std::vector<Index3D> all_blocks = layer.getAllBlockIndices();
+  const Index3D active_block_index = all_blocks.front();
+  const Index3D inactive_block_index = all_blocks.back();
+  constexpr float kOccupiedLogOdds = 10.f;
+  constexpr float kUntouchedLogOdds = 5.f;
+  layer.getBlockAtIndex(active_block_index)->voxels[0][0][0].log_odds =
+      kOccupiedLogOdds;
+  // Written without marking the block, so this shouldn't be decayed.
+  layer.getBlockAtIndex(inactive_block_index)->voxels[0][0][0].log_odds =
+      kUntouchedLogOdds;
+  decay_integrator.markBlocksAsActive({active_block_index});
+  decay_integrator.decay(&layer, cuda_stream);
+
+  const float occupied_region_decay_log_odds = logOddsFromProbability(
+      decay_integrator.occupied_region_decay_probability());
+  EXPECT_NEAR(
+      layer.getBlockAtIndex(active_block_index)->voxels[0][0][0].log_odds,
+      kOccupiedLogOdds + occupied_region_decay_log_odds, 1e-4);
+  EXPECT_EQ(
+      layer.getBlockAtIndex(inactive_block_index)->voxels[0][0][0].log_odds,
+      kUntouchedLogOdds);
+
+  // Requesting deallocation frees all (actually) fully decayed blocks in one
+  // go, including the skipped ones.
+  decay_integrator.deallocate_decayed_blocks(true);
+  const std::vector<Index3D> deallocated_blocks =
+      decay_integrator.decay(&layer, cuda_stream);
+  EXPECT_EQ(deallocated_blocks.size(), num_blocks - 2);
+  EXPECT_TRUE(layer.isBlockAllocated(active_block_index));
+  EXPECT_TRUE(layer.isBlockAllocated(inactive_block_index));
+}
+
 // Run the above test with different values to decay to
 INSTANTIATE_TEST_CASE_P(DecayAll, OccupancyDecayParameterizedTestFixture,
                         ::testing::Values(0.5f, 0.4f));
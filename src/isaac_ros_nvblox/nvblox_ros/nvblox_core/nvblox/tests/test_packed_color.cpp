@@ -0,0 +1,79 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include "nvblox/core/packed_color.h"
+#include "nvblox/map/voxels.h"
+
+namespace nvblox {
+
+TEST(PackedRgb, RoundTrip) {
+  const PackedRgb packed(Color(10, 20, 30, 40));
+  const Color color = packed;
+  EXPECT_EQ(color, Color(10, 20, 30));
+  EXPECT_EQ(packed, Color(10, 20, 30));
+}
+
+TEST(QuantizedWeight, RoundTrip) {
+  // Multiples of the resolution survive the round trip.
+  for (const float value : {0.0f, 1.0f, 0.5f, 5.0f}) {
+    const QuantizedWeight weight(value);
+    EXPECT_EQ(static_cast<float>(weight), value);
+  }
+  // Other values are rounded to the nearest multiple.
+  constexpr float kWeight = 0.1f;
+  EXPECT_NEAR(static_cast<float>(QuantizedWeight(kWeight)), kWeight,
+              0.5f * QuantizedWeight::kResolution);
+}
+
+TEST(QuantizedWeight, Saturates) {
+  EXPECT_EQ(static_cast<float>(QuantizedWeight(1e6f)),
+            QuantizedWeight::kMaxValue);
+  EXPECT_EQ(static_cast<float>(QuantizedWeight(-1.0f)), 0.0f);
+}
+
+TEST(QuantizedWeight, Arithmetic) {
+  QuantizedWeight weight = 1.0f;
+  weight += 2.0f;
+  EXPECT_EQ(static_cast<float>(weight), 3.0f);
+  weight *= 0.5f;
+  EXPECT_EQ(static_cast<float>(weight), 1.5f);
+  weight -= 0.5f;
+  EXPECT_EQ(static_cast<float>(weight), 1.0f);
+}
+
+TEST(PackedRgb, ColorVoxelSize) {
+#ifdef NVBLOX_COMPACT_COLOR_VOXEL
+  EXPECT_EQ(sizeof(ColorVoxel), 4);
+#else
+  EXPECT_EQ(sizeof(ColorVoxel), 8);
+#endif
+  ColorVoxel voxel;
+  EXPECT_EQ(voxel.color, Color::Gray());
+  EXPECT_EQ(voxel.weight, 0.0f);
+}
+
+}  // namespace nvblox
+
+int main(int argc, char** argv) {
+  FLAGS_alsologtostderr = true;
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,136 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include <cuda_runtime.h>
+
+#include "nvblox/core/cuda_stream.h"
+#include "nvblox/core/internal/error_check.h"
+#include "nvblox/core/pinned_host_buffer_pool.h"
+#include "nvblox/sensors/image.h"
+#include "nvblox/sensors/pointcloud.h"
+
+using namespace nvblox;
+
+TEST(PinnedHostBufferPoolTest, RecycleReleasedBuffers) {
+  CudaStreamOwning cuda_stream;
+  PinnedHostBufferPool pool;
+  EXPECT_EQ(pool.num_idle_buffers(), 0);
+
+  PinnedHostBufferPool::Buffer buffer = pool.acquire(1000);
+  ASSERT_NE(buffer.data, nullptr);
+  EXPECT_GE(buffer.size_bytes, 1000);
+  const uint8_t* first_ptr = buffer.data.get();
+
+  pool.releaseAsync(std::move(buffer), cuda_stream);
+  EXPECT_EQ(pool.num_idle_buffers(), 1);
+  cuda_stream.synchronize();
+
+  // A smaller request gets the same buffer back.
+  buffer = pool.acquire(500);
+  EXPECT_EQ(buffer.data.get(), first_ptr);
+  EXPECT_EQ(pool.num_idle_buffers(), 0);
+
+  // Requests larger than the idle buffers allocate.
+  pool.releaseAsync(std::move(buffer), cuda_stream);
+  cuda_stream.synchronize();
+  PinnedHostBufferPool::Buffer large_buffer = pool.acquire(1 << 20);
+  EXPECT_NE(large_buffer.data.get(), first_ptr);
+  EXPECT_GE(large_buffer.size_bytes, 1 << 20);
+  EXPECT_EQ(pool.num_idle_buffers(), 1);
+}
+
+TEST(PinnedHostBufferPoolTest, LimitIdleBuffers) {
+  CudaStreamOwning cuda_stream;
+  constexpr size_t kMaxNumIdleBuffers = 2;
+  PinnedHostBufferPool pool(kMaxNumIdleBuffers);
+  std::vector<PinnedHostBufferPool::Buffer> buffers;
+  for (int i = 0; i < 5; i++) {
+    buffers.push_back(pool.acquire(100));
+  }
+  cuda_stream.synchronize();
+  for (auto& buffer : buffers) {
+    pool.releaseAsync(std::move(buffer), cuda_stream);
+    cuda_stream.synchronize();
+  }
+  EXPECT_EQ(pool.num_idle_buffers(), kMaxNumIdleBuffers);
+}
+
+TEST(PinnedHostBufferPoolTest, UploadImage) {
+  CudaStreamOwning cuda_stream;
+  PinnedHostBufferPool pool;
+  constexpr int kRows = 48;
+  constexpr int kCols = 64;
+  DepthImage depth_image(MemoryType::kDevice);
+
+  // Upload a few frames, overwriting the host image right after each call.
+  std::vector<float> host_image(kRows * kCols);
+  for (int frame = 0; frame < 3; frame++) {
+    for (size_t i = 0; i < host_image.size(); i++) {
+      host_image[i] = frame * 1000.0f + i;
+    }
+    depth_image.copyFromHostAsync(kRows, kCols, host_image.data(), &pool,
+                                  cuda_stream);
+    std::fill(host_image.begin(), host_image.end(), -1.0f);
+
+    std::vector<float> result(kRows * kCols);
+    depth_image.copyToAsync(result.data(), cuda_stream);
+    cuda_stream.synchronize();
+    EXPECT_EQ(depth_image.rows(), kRows);
+    EXPECT_EQ(depth_image.cols(), kCols);
+    for (size_t i = 0; i < result.size(); i++) {
+      EXPECT_EQ(result[i], frame * 1000.0f + i);
+    }
+  }
+  // Same size frames recycle the same staging buffer.
+  EXPECT_EQ(pool.num_idle_buffers(), 1);
+}
+
+TEST(PinnedHostBufferPoolTest, UploadPointcloud) {
+  CudaStreamOwning cuda_stream;
+  PinnedHostBufferPool pool;
+  std::vector<Vector3f> points;
+  for (int i = 0; i < 100; i++) {
+    points.push_back(Vector3f(i, 2 * i, 3 * i));
+  }
+
+  Pointcloud pointcloud(MemoryType::kDevice);
+  pointcloud.copyFromHostAsync(points, &pool, cuda_stream);
+  ASSERT_EQ(pointcloud.size(), points.size());
+
+  std::vector<Vector3f> result(points.size());
+  checkCudaErrors(cudaMemcpyAsync(result.data(), pointcloud.dataConstPtr(),
+                                  sizeof(Vector3f) * result.size(),
+                                  cudaMemcpyDeviceToHost, cuda_stream));
+  cuda_stream.synchronize();
+  for (size_t i = 0; i < points.size(); i++) {
+    EXPECT_EQ(result[i], points[i]);
+  }
+
+  // Empty pointclouds are fine.
+  pointcloud.copyFromHostAsync(std::vector<Vector3f>(), &pool, cuda_stream);
+  EXPECT_TRUE(pointcloud.empty());
+}
+
+int main(int argc, char** argv) {
+  google::InitGoogleLogging(argv[0]);
+  FLAGS_alsologtostderr = true;
+  google::InstallFailureSignalHandler();
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,73 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include "nvblox/core/log_odds.h"
+#include "nvblox/core/quantized_log_odds.h"
+#include "nvblox/map/voxels.h"
+
+namespace nvblox {
+
+TEST(QuantizedLogOdds, RoundTrip) {
+  // Multiples of the resolution survive the round trip.
+  for (const float value : {0.0f, 1.0f, -1.0f, 0.5f, -0.25f, 4.0f}) {
+    const QuantizedLogOdds log_odds(value);
+    EXPECT_EQ(static_cast<float>(log_odds), value);
+  }
+  // Other values are rounded to the nearest multiple.
+  const float log_odds = logOddsFromProbability(0.7f);
+  EXPECT_NEAR(static_cast<float>(QuantizedLogOdds(log_odds)), log_odds,
+              0.5f * QuantizedLogOdds::kResolution);
+}
+
+TEST(QuantizedLogOdds, Saturates) {
+  QuantizedLogOdds log_odds(QuantizedLogOdds::kMaxValue);
+  log_odds += 1.0f;
+  EXPECT_EQ(static_cast<float>(log_odds), QuantizedLogOdds::kMaxValue);
+  log_odds = -1e6f;
+  EXPECT_EQ(static_cast<float>(log_odds), -QuantizedLogOdds::kMaxValue);
+  // The full range of log-odds from probabilities is representable.
+  EXPECT_GT(QuantizedLogOdds::kMaxValue, logOddsFromProbability(1.0f));
+}
+
+TEST(QuantizedLogOdds, Ordering) {
+  const QuantizedLogOdds low(-0.5f);
+  const QuantizedLogOdds high(0.25f);
+  EXPECT_LT(low.raw(), high.raw());
+  EXPECT_LT(low, high);
+}
+
+TEST(QuantizedLogOdds, OccupancyVoxelSize) {
+#ifdef NVBLOX_QUANTIZED_OCCUPANCY
+  EXPECT_EQ(sizeof(OccupancyVoxel), 2);
+#else
+  EXPECT_EQ(sizeof(OccupancyVoxel), 4);
+#endif
+  OccupancyVoxel voxel;
+  EXPECT_EQ(voxel.log_odds, 0.0f);
+}
+
+}  // namespace nvblox
+
+int main(int argc, char** argv) {
+  FLAGS_alsologtostderr = true;
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
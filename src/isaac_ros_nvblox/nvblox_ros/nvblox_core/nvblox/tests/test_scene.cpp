@@ -17,7 +17,9 @@ limitations under the License.
 #include <string>
 
 #include "nvblox/io/image_io.h"
+#include "nvblox/map/accessors.h"
 #include "nvblox/primitives/scene.h"
+#include "nvblox/primitives/scene_renderer_gpu.h"
 
 using namespace nvblox;
 
@@ -161,6 +163,88 @@ TEST_F(SceneTest, TypesList) {
   EXPECT_EQ(type_list[3], primitives::Primitive::Type::kCylinder);
 }
 
+// A scene with all primitive types.
+void addAllPrimitiveTypes(primitives::Scene* scene) {
+  scene->addGroundLevel(0.0f);
+  scene->addPlaneBoundaries(-3.0f, 3.0f, -3.0f, 3.0f);
+  scene->addPrimitive(
+      std::make_unique<primitives::Sphere>(Vector3f(1.0f, 0.5f, 1.0f), 0.5f));
+  scene->addPrimitive(std::make_unique<primitives::Cube>(
+      Vector3f(-1.0f, 0.5f, 0.5f), Vector3f(0.5f, 1.0f, 1.0f)));
+  scene->addPrimitive(std::make_unique<primitives::Cylinder>(
+      Vector3f(0.0f, -1.0f, 1.0f), 0.4f, 1.5f));
+}
+
+TEST_F(SceneTest, GpuDepthImageMatchesCpu) {
+  constexpr float max_dist = 10.0f;
+  addAllPrimitiveTypes(&scene_);
+  primitives::SceneRendererGpu renderer;
+  renderer.setScene(scene_);
+  EXPECT_EQ(renderer.numPrimitives(), 8);
+
+  // Look at the primitives from the side and from above.
+  Transform T_S_C_side = Transform::Identity();
+  T_S_C_side.prerotate(Eigen::Quaternionf(0.5f, 0.5f, -0.5f, 0.5f));
+  T_S_C_side.pretranslate(Vector3f(0.0f, 2.5f, 1.0f));
+  Transform T_S_C_top = Transform::Identity();
+  T_S_C_top.prerotate(
+      Eigen::Quaternionf(Eigen::AngleAxisf(M_PI, Vector3f::UnitX())));
+  T_S_C_top.pretranslate(Vector3f(0.0f, 0.0f, 2.9f));
+
+  for (const Transform& T_S_C : {T_S_C_side, T_S_C_top}) {
+    DepthImage depth_cpu(camera_.height(), camera_.width(),
+                         MemoryType::kUnified);
+    DepthImage depth_gpu(camera_.height(), camera_.width(),
+                         MemoryType::kUnified);
+    scene_.generateDepthImageFromScene(camera_, T_S_C, max_dist, &depth_cpu);
+    renderer.generateDepthImageFromScene(camera_, T_S_C, max_dist,
+                                         &depth_gpu);
+
+    // Pixels at the silhouettes of the primitives may flip between them due
+    // to float vs. double arithmetic.
+    int num_different_pixels = 0;
+    int num_valid_pixels = 0;
+    for (int lin_idx = 0; lin_idx < depth_cpu.numel(); lin_idx++) {
+      num_valid_pixels += depth_cpu(lin_idx) > 0.0f;
+      if (std::abs(depth_cpu(lin_idx) - depth_gpu(lin_idx)) > 1e-3f) {
+        ++num_different_pixels;
+      }
+    }
+    EXPECT_GT(num_valid_pixels, depth_cpu.numel() / 2);
+    EXPECT_LT(num_different_pixels, depth_cpu.numel() / 1000);
+  }
+}
+
+TEST_F(SceneTest, GpuLayerMatchesCpu) {
+  constexpr float voxel_size_m = 0.1f;
+  constexpr float max_dist = 0.3f;
+  addAllPrimitiveTypes(&scene_);
+  primitives::SceneRendererGpu renderer;
+  renderer.setScene(scene_);
+
+  TsdfLayer layer_cpu(voxel_size_m, MemoryType::kUnified);
+  TsdfLayer layer_gpu(voxel_size_m, MemoryType::kUnified);
+  scene_.generateLayerFromScene(max_dist, &layer_cpu);
+  renderer.generateLayerFromScene(max_dist, &layer_gpu);
+
+  ASSERT_GT(layer_cpu.numAllocatedBlocks(), 0);
+  EXPECT_EQ(layer_cpu.numAllocatedBlocks(), layer_gpu.numAllocatedBlocks());
+  int num_voxels = 0;
+  callFunctionOnAllVoxels<TsdfVoxel>(
+      layer_cpu, [&](const Index3D& block_index, const Index3D& voxel_index,
+                     const TsdfVoxel* voxel_cpu) {
+        auto block_gpu = layer_gpu.getBlockAtIndex(block_index);
+        ASSERT_NE(block_gpu, nullptr);
+        const TsdfVoxel& voxel_gpu =
+            block_gpu->voxels[voxel_index.x()][voxel_index.y()]
+                             [voxel_index.z()];
+        EXPECT_NEAR(voxel_cpu->distance, voxel_gpu.distance, 1e-4f);
+        EXPECT_EQ(voxel_cpu->weight, voxel_gpu.weight);
+        ++num_voxels;
+      });
+  EXPECT_GT(num_voxels, 0);
+}
+
 int main(int argc, char** argv) {
   google::InitGoogleLogging(argv[0]);
   FLAGS_alsologtostderr = true;
@@ -0,0 +1,128 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+#include <cuda_runtime.h>
+
+#include "nvblox/core/cuda_stream.h"
+#include "nvblox/core/internal/error_check.h"
+#include "nvblox/core/scratch_arena.h"
+
+using namespace nvblox;
+
+TEST(ScratchArenaTest, EmptyAllocation) {
+  CudaStreamOwning cuda_stream;
+  ScratchArena arena;
+  EXPECT_EQ(arena.allocateAsync<float>(0, cuda_stream), nullptr);
+  EXPECT_EQ(arena.used_bytes(), 0);
+  EXPECT_EQ(arena.num_chunks(), 0);
+}
+
+TEST(ScratchArenaTest, AlignedAllocations) {
+  CudaStreamOwning cuda_stream;
+  ScratchArena arena;
+  std::vector<char*> ptrs;
+  for (int i = 1; i < 10; i++) {
+    ptrs.push_back(arena.allocateAsync<char>(i * 3, cuda_stream));
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(ptrs.back()) %
+                  ScratchArena::kAlignmentBytes,
+              0);
+  }
+  // All allocations are distinct.
+  for (size_t i = 1; i < ptrs.size(); i++) {
+    EXPECT_NE(ptrs[i - 1], ptrs[i]);
+  }
+  EXPECT_EQ(arena.used_bytes(), ptrs.size() * ScratchArena::kAlignmentBytes);
+}
+
+TEST(ScratchArenaTest, MemoryIsUsable) {
+  CudaStreamOwning cuda_stream;
+  ScratchArena arena;
+  constexpr size_t kNumElements = 1000;
+  int* first = arena.allocateAsync<int>(kNumElements, cuda_stream);
+  int* second = arena.allocateAsync<int>(kNumElements, cuda_stream);
+
+  // Writing one allocation doesn't touch the other.
+  std::vector<int> ones(kNumElements, 1);
+  checkCudaErrors(cudaMemsetAsync(second, 0, kNumElements * sizeof(int),
+                                  cuda_stream));
+  checkCudaErrors(cudaMemcpyAsync(first, ones.data(),
+                                  kNumElements * sizeof(int),
+                                  cudaMemcpyHostToDevice, cuda_stream));
+  std::vector<int> first_host(kNumElements);
+  std::vector<int> second_host(kNumElements);
+  checkCudaErrors(cudaMemcpyAsync(first_host.data(), first,
+                                  kNumElements * sizeof(int),
+                                  cudaMemcpyDeviceToHost, cuda_stream));
+  checkCudaErrors(cudaMemcpyAsync(second_host.data(), second,
+                                  kNumElements * sizeof(int),
+                                  cudaMemcpyDeviceToHost, cuda_stream));
+  cuda_stream.synchronize();
+  for (size_t i = 0; i < kNumElements; i++) {
+    EXPECT_EQ(first_host[i], 1);
+    EXPECT_EQ(second_host[i], 0);
+  }
+}
+
+TEST(ScratchArenaTest, ResetCoalescesChunks) {
+  CudaStreamOwning cuda_stream;
+  ScratchArena arena;
+  constexpr size_t kAllocationBytes = 1 << 16;
+  constexpr int kNumAllocations = 10;
+
+  // The first frame grows the arena over several chunks.
+  for (int i = 0; i < kNumAllocations; i++) {
+    arena.allocateBytesAsync(kAllocationBytes, cuda_stream);
+  }
+  EXPECT_GT(arena.num_chunks(), 1);
+  EXPECT_EQ(arena.used_bytes(), kNumAllocations * kAllocationBytes);
+  EXPECT_EQ(arena.peak_bytes(), kNumAllocations * kAllocationBytes);
+
+  // After a reset the peak fits into a single chunk.
+  arena.reset(cuda_stream);
+  EXPECT_EQ(arena.num_chunks(), 1);
+  EXPECT_EQ(arena.used_bytes(), 0);
+  EXPECT_EQ(arena.capacity_bytes(), kNumAllocations * kAllocationBytes);
+
+  // A frame of the same size doesn't allocate anymore.
+  for (int i = 0; i < kNumAllocations; i++) {
+    arena.allocateBytesAsync(kAllocationBytes, cuda_stream);
+  }
+  EXPECT_EQ(arena.num_chunks(), 1);
+
+  // Smaller frames re-use the memory from the start.
+  arena.reset(cuda_stream);
+  void* first = arena.allocateBytesAsync(kAllocationBytes, cuda_stream);
+  arena.reset(cuda_stream);
+  EXPECT_EQ(arena.allocateBytesAsync(kAllocationBytes, cuda_stream), first);
+  EXPECT_EQ(arena.peak_bytes(), kNumAllocations * kAllocationBytes);
+
+  arena.clearAndDeallocateAsync(cuda_stream);
+  EXPECT_EQ(arena.num_chunks(), 0);
+  EXPECT_EQ(arena.capacity_bytes(), 0);
+  cuda_stream.synchronize();
+}
+
+int main(int argc, char** argv) {
+  google::InitGoogleLogging(argv[0]);
+  FLAGS_alsologtostderr = true;
+  google::InstallFailureSignalHandler();
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
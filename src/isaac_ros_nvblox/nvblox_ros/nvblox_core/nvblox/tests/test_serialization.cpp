@@ -15,9 +15,13 @@ limitations under the License.
 */
 #include <gtest/gtest.h>
 #include <stdio.h>
+#include <cstring>
+#include <fstream>
 
 #include "nvblox/io/layer_cake_io.h"
 #include "nvblox/map/layer.h"
+#include "nvblox/map_saving/internal/binary_map_serializer.h"
+#include "nvblox/map_saving/internal/checkpoint_log.h"
 #include "nvblox/map_saving/internal/layer_serialization.h"
 #include "nvblox/map_saving/internal/layer_type_register.h"
 #include "nvblox/map_saving/internal/serializer.h"
@@ -195,6 +199,44 @@ TEST_F(SerializationTest, LayerBlockSerialization) {
   EXPECT_NE(block_byte_string.size(), 0);
 }
 
+TEST_F(SerializationTest, BatchedLayerBlockSerialization) {
+  // Create a TSDF layer from the scene, on the device.
+  cake_ = LayerCake::create<TsdfLayer>(voxel_size_m_, MemoryType::kDevice);
+  TsdfLayer tsdf_layer_host(voxel_size_m_, MemoryType::kHost);
+  scene_.generateLayerFromScene(truncation_distance, &tsdf_layer_host);
+  cake_.getPtr<TsdfLayer>()->copyFrom(tsdf_layer_host);
+  const TsdfLayer& tsdf_layer = *cake_.getConstPtr<TsdfLayer>();
+  const std::vector<Index3D> indices = getLayerDataIndices(tsdf_layer);
+  ASSERT_GT(indices.size(), 0);
+
+  // The batched serialization gives the same bytes as serializing each block.
+  CudaStreamOwning cuda_stream;
+  size_t num_written = 0;
+  auto write_data = [&](const Index3D& index, const Byte* data,
+                        size_t num_bytes) -> bool {
+    EXPECT_EQ(index, indices[num_written]);
+    const std::vector<Byte> expected_bytes =
+        serializeLayerDataAtIndex(tsdf_layer, index, cuda_stream);
+    EXPECT_EQ(num_bytes, expected_bytes.size());
+    EXPECT_EQ(std::memcmp(data, expected_bytes.data(), num_bytes), 0);
+    ++num_written;
+    return true;
+  };
+  EXPECT_TRUE(serializeLayerDataInBatches(tsdf_layer, indices, write_data,
+                                          cuda_stream));
+  EXPECT_EQ(num_written, indices.size());
+
+  // Writing stops when a write fails.
+  num_written = 0;
+  auto failing_write_data = [&](const Index3D&, const Byte*, size_t) {
+    ++num_written;
+    return false;
+  };
+  EXPECT_FALSE(serializeLayerDataInBatches(tsdf_layer, indices,
+                                           failing_write_data, cuda_stream));
+  EXPECT_EQ(num_written, 1);
+}
+
 TEST_F(SerializationTest, SerializeDeviceBlock) {
   cake_ = LayerCake::create<TsdfLayer>(voxel_size_m_, MemoryType::kHost);
   scene_.generateLayerFromScene(truncation_distance, cake_.getPtr<TsdfLayer>());
@@ -275,6 +317,200 @@ TEST_F(SerializationTest, OverwriteTest) {
   EXPECT_TRUE((block_idx_vector[0].array() == Index3D::Ones().array()).all());
 }
 
+TEST_F(SerializationTest, BinaryMapRoundTrip) {
+  cake_ = LayerCake::create<TsdfLayer, ColorLayer>(voxel_size_m_,
+                                                   MemoryType::kUnified);
+  scene_.generateLayerFromScene(truncation_distance, cake_.getPtr<TsdfLayer>());
+  cake_.getPtr<ColorLayer>()->allocateBlockAtIndex(Index3D(1, 2, 3));
+  const std::string filename = "binary_map_test.nvblx";
+  EXPECT_TRUE(io::writeLayerCakeToBinaryFile(filename, cake_));
+  EXPECT_TRUE(BinaryMapSerializer::isBinaryMapFile(filename));
+
+  // The default loader detects the format.
+  LayerCake cake2 = io::loadLayerCakeFromFile(filename, MemoryType::kHost);
+  EXPECT_EQ(cake2.voxel_size(), cake_.voxel_size());
+  ASSERT_TRUE(cake2.exists<TsdfLayer>());
+  ASSERT_TRUE(cake2.exists<ColorLayer>());
+  EXPECT_EQ(cake2.get<ColorLayer>().numAllocatedBlocks(), 1);
+  EXPECT_TRUE(cake2.get<ColorLayer>().isBlockAllocated(Index3D(1, 2, 3)));
+
+  const TsdfLayer& tsdf_layer_host = cake_.get<TsdfLayer>();
+  const TsdfLayer& tsdf_layer_loaded = cake2.get<TsdfLayer>();
+  ASSERT_GT(tsdf_layer_host.numAllocatedBlocks(), 0);
+  EXPECT_EQ(tsdf_layer_host.numAllocatedBlocks(),
+            tsdf_layer_loaded.numAllocatedBlocks());
+  for (const Index3D& index : tsdf_layer_host.getAllBlockIndices()) {
+    auto block1 = tsdf_layer_host.getBlockAtIndex(index);
+    auto block2 = tsdf_layer_loaded.getBlockAtIndex(index);
+    ASSERT_NE(block2, nullptr);
+    EXPECT_EQ(std::memcmp(block1->voxels, block2->voxels,
+                          sizeof(block1->voxels)),
+              0);
+  }
+
+  // Files in the default format are not detected as binary maps.
+  const std::string sqlite_filename = "binary_map_test_sqlite.nvblx";
+  EXPECT_TRUE(io::writeLayerCakeToFile(sqlite_filename, cake_));
+  EXPECT_FALSE(BinaryMapSerializer::isBinaryMapFile(sqlite_filename));
+  EXPECT_FALSE(BinaryMapSerializer::isBinaryMapFile("./not_a_real_file"));
+}
+
+TEST_F(SerializationTest, CompressedBlocksRoundTrip) {
+  cake_ = LayerCake::create<TsdfLayer, ColorLayer>(voxel_size_m_,
+                                                   MemoryType::kUnified);
+  scene_.generateLayerFromScene(truncation_distance, cake_.getPtr<TsdfLayer>());
+  cake_.getPtr<ColorLayer>()->allocateBlockAtIndex(Index3D(1, 2, 3));
+  const std::string filename = "compressed_blocks_test.nvblx";
+  const std::string raw_filename = "compressed_blocks_test_raw.nvblx";
+  EXPECT_TRUE(io::writeLayerCakeToFile(filename, cake_, CudaStreamOwning(),
+                                       /*compress_blocks=*/true));
+  EXPECT_TRUE(io::writeLayerCakeToFile(raw_filename, cake_));
+
+  // The generated scene has long runs of equal voxels.
+  std::ifstream file(filename, std::ios::binary | std::ios::ate);
+  std::ifstream raw_file(raw_filename, std::ios::binary | std::ios::ate);
+  EXPECT_LT(file.tellg(), raw_file.tellg());
+
+  LayerCake cake2 = io::loadLayerCakeFromFile(filename, MemoryType::kHost);
+  ASSERT_TRUE(cake2.exists<TsdfLayer>());
+  ASSERT_TRUE(cake2.exists<ColorLayer>());
+  EXPECT_TRUE(cake2.get<ColorLayer>().isBlockAllocated(Index3D(1, 2, 3)));
+
+  const TsdfLayer& tsdf_layer_host = cake_.get<TsdfLayer>();
+  const TsdfLayer& tsdf_layer_loaded = cake2.get<TsdfLayer>();
+  ASSERT_GT(tsdf_layer_host.numAllocatedBlocks(), 0);
+  EXPECT_EQ(tsdf_layer_host.numAllocatedBlocks(),
+            tsdf_layer_loaded.numAllocatedBlocks());
+  for (const Index3D& index : tsdf_layer_host.getAllBlockIndices()) {
+    auto block1 = tsdf_layer_host.getBlockAtIndex(index);
+    auto block2 = tsdf_layer_loaded.getBlockAtIndex(index);
+    ASSERT_NE(block2, nullptr);
+    EXPECT_EQ(std::memcmp(block1->voxels, block2->voxels,
+                          sizeof(block1->voxels)),
+              0);
+  }
+}
+
+TEST_F(SerializationTest, DerivedLayersRoundTrip) {
+  cake_ = LayerCake::create<TsdfLayer, EsdfLayer, MeshLayer>(
+      voxel_size_m_, MemoryType::kUnified);
+  scene_.generateLayerFromScene(truncation_distance, cake_.getPtr<TsdfLayer>());
+  const Index3D block_index(1, 2, 3);
+  auto esdf_block =
+      cake_.getPtr<EsdfLayer>()->allocateBlockAtIndex(block_index);
+  esdf_block->voxels[1][2][3].squared_distance_vox = 4.0f;
+  esdf_block->voxels[1][2][3].parent_direction = Index3D(2, 0, 0);
+  auto mesh_block =
+      cake_.getPtr<MeshLayer>()->allocateBlockAtIndex(block_index);
+  for (int i = 0; i < 3; ++i) {
+    mesh_block->vertices.push_back(Vector3f(i, 1.0f, 2.0f));
+    mesh_block->normals.push_back(Vector3f::UnitZ());
+    mesh_block->triangles.push_back(i);
+  }
+  const std::string filename = "derived_layers_test.nvblx";
+  EXPECT_TRUE(io::writeLayerCakeToFile(filename, cake_, CudaStreamOwning(),
+                                       /*compress_blocks=*/false,
+                                       /*store_derived_layers=*/true));
+
+  bool derived_layers_consistent = false;
+  LayerCake cake2 = io::loadLayerCakeFromFile(filename, MemoryType::kHost,
+                                              &derived_layers_consistent);
+  EXPECT_TRUE(derived_layers_consistent);
+  ASSERT_TRUE(cake2.exists<EsdfLayer>());
+  ASSERT_TRUE(cake2.exists<MeshLayer>());
+  auto esdf_block2 = cake2.get<EsdfLayer>().getBlockAtIndex(block_index);
+  ASSERT_NE(esdf_block2, nullptr);
+  EXPECT_EQ(esdf_block2->voxels[1][2][3].squared_distance_vox, 4.0f);
+  EXPECT_EQ(esdf_block2->voxels[1][2][3].parent_direction, Index3D(2, 0, 0));
+  auto mesh_block2 = cake2.get<MeshLayer>().getBlockAtIndex(block_index);
+  ASSERT_NE(mesh_block2, nullptr);
+  ASSERT_EQ(mesh_block2->vertices.size(), 3);
+  EXPECT_EQ(mesh_block2->normals.size(), 3);
+  EXPECT_EQ(mesh_block2->colors.size(), 0);
+  ASSERT_EQ(mesh_block2->triangles.size(), 3);
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(mesh_block2->vertices[i], Vector3f(i, 1.0f, 2.0f));
+    EXPECT_EQ(mesh_block2->triangles[i], i);
+  }
+
+  // Without derived layers the mesh isn't stored.
+  const std::string raw_filename = "derived_layers_test_raw.nvblx";
+  EXPECT_TRUE(io::writeLayerCakeToFile(raw_filename, cake_));
+  LayerCake cake3 = io::loadLayerCakeFromFile(raw_filename, MemoryType::kHost,
+                                              &derived_layers_consistent);
+  EXPECT_FALSE(derived_layers_consistent);
+  EXPECT_TRUE(cake3.exists<EsdfLayer>());
+  EXPECT_FALSE(cake3.exists<MeshLayer>());
+
+  // Changing the TSDF in the file invalidates the derived layers.
+  {
+    Serializer serializer(filename, std::ios::in | std::ios::out);
+    ASSERT_TRUE(serializer.valid());
+    EXPECT_TRUE(
+        serializer.addLayerData("tsdf_layer", Index3D(100, 100, 100),
+                                std::vector<Byte>(sizeof(TsdfBlock::voxels))));
+    serializer.close();
+  }
+  LayerCake cake4 = io::loadLayerCakeFromFile(filename, MemoryType::kHost,
+                                              &derived_layers_consistent);
+  EXPECT_FALSE(derived_layers_consistent);
+  ASSERT_TRUE(cake4.exists<TsdfLayer>());
+  EXPECT_TRUE(cake4.get<TsdfLayer>().isBlockAllocated(Index3D(100, 100, 100)));
+  EXPECT_FALSE(cake4.exists<EsdfLayer>());
+  EXPECT_FALSE(cake4.exists<MeshLayer>());
+}
+
+TEST_F(SerializationTest, CheckpointLogCompaction) {
+  cake_ = LayerCake::create<TsdfLayer>(voxel_size_m_, MemoryType::kUnified);
+  TsdfLayer* tsdf_layer = cake_.getPtr<TsdfLayer>();
+  scene_.generateLayerFromScene(truncation_distance, tsdf_layer);
+  const std::vector<Index3D> all_blocks = tsdf_layer->getAllBlockIndices();
+  ASSERT_GT(all_blocks.size(), 2);
+
+  const std::string filename = "checkpoint_log_test.nvblx";
+  CheckpointLog checkpoint_log;
+  checkpoint_log.compaction_ratio(0.0f);
+  ASSERT_TRUE(checkpoint_log.open(filename));
+  EXPECT_TRUE(CheckpointLog::isCheckpointLogFile(filename));
+  ASSERT_TRUE(checkpoint_log.appendFullCheckpoint(cake_, CudaStreamOwning()));
+  const uint64_t full_num_bytes = checkpoint_log.num_bytes();
+  EXPECT_GE(full_num_bytes, checkpoint_log.num_live_bytes());
+
+  // Rewrite the same blocks a few times and remove one.
+  const Index3D changed_block = all_blocks[0];
+  const Index3D removed_block = all_blocks[1];
+  tsdf_layer->getBlockAtIndex(changed_block)->voxels[0][0][0].weight = 123.0f;
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_TRUE(checkpoint_log.appendCheckpoint(cake_, all_blocks,
+                                                CudaStreamOwning()));
+  }
+  tsdf_layer->clearBlock(removed_block);
+  ASSERT_TRUE(checkpoint_log.appendCheckpoint(cake_, {removed_block},
+                                              CudaStreamOwning()));
+  EXPECT_GT(checkpoint_log.num_bytes(), 3 * full_num_bytes);
+
+  // Compaction keeps the live blocks only.
+  checkpoint_log.compactAsync();
+  checkpoint_log.waitForCompaction();
+  EXPECT_LT(checkpoint_log.num_bytes(), full_num_bytes);
+
+  // Appending after compaction still works.
+  ASSERT_TRUE(checkpoint_log.appendCheckpoint(cake_, {changed_block},
+                                              CudaStreamOwning()));
+
+  LayerCake cake2 = io::loadLayerCakeFromFile(filename, MemoryType::kHost);
+  ASSERT_TRUE(cake2.exists<TsdfLayer>());
+  EXPECT_EQ(cake2.voxel_size(), cake_.voxel_size());
+  EXPECT_EQ(cake2.get<TsdfLayer>().numAllocatedBlocks(),
+            all_blocks.size() - 1);
+  EXPECT_FALSE(cake2.get<TsdfLayer>().isBlockAllocated(removed_block));
+  EXPECT_EQ(cake2.get<TsdfLayer>()
+                .getBlockAtIndex(changed_block)
+                ->voxels[0][0][0]
+                .weight,
+            123.0f);
+}
+
 int main(int argc, char** argv) {
   google::InitGoogleLogging(argv[0]);
   FLAGS_alsologtostderr = true;
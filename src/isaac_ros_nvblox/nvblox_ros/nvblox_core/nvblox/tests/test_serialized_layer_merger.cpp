@@ -0,0 +1,125 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+
+#include "nvblox/serialization/layer_serializer_gpu.h"
+#include "nvblox/serialization/serialized_layer_merger.h"
+#include "nvblox/tests/utils.h"
+
+using namespace nvblox;
+
+constexpr float kVoxelSize = 0.1f;
+constexpr float kEps = 1e-4f;
+
+template <typename VoxelType>
+void setAllVoxels(const Index3D& block_index, const VoxelType& voxel,
+                  VoxelBlockLayer<VoxelType>* layer) {
+  auto block = layer->allocateBlockAtIndex(block_index);
+  for (int i = 0; i < VoxelBlock<VoxelType>::kNumVoxels; ++i) {
+    (&block->voxels[0][0][0])[i] = voxel;
+  }
+}
+
+TEST(SerializedLayerMergerTest, MergeTsdf) {
+  TsdfLayer local_layer(kVoxelSize, MemoryType::kUnified);
+  TsdfLayer peer_layer(kVoxelSize, MemoryType::kUnified);
+
+  // One block observed by both maps, one only by the peer.
+  const Index3D shared_index(0, 0, 0);
+  const Index3D peer_index(1, 0, 0);
+  TsdfVoxel local_voxel;
+  local_voxel.distance = 0.1f;
+  local_voxel.weight = 1.0f;
+  setAllVoxels(shared_index, local_voxel, &local_layer);
+  TsdfVoxel peer_voxel;
+  peer_voxel.distance = -0.2f;
+  peer_voxel.weight = 2.0f;
+  setAllVoxels(shared_index, peer_voxel, &peer_layer);
+  setAllVoxels(peer_index, peer_voxel, &peer_layer);
+
+  CudaStreamOwning cuda_stream;
+  TsdfLayerSerializerGpu serializer;
+  auto serialized_layer = serializer.serialize(
+      peer_layer, peer_layer.getAllBlockIndices(), cuda_stream);
+
+  SerializedLayerMerger merger;
+  merger.max_tsdf_weight(2.5f);
+  const std::vector<Index3D> merged_blocks =
+      merger.merge(*serialized_layer, &local_layer);
+  EXPECT_EQ(merged_blocks.size(), 2);
+  EXPECT_EQ(local_layer.numAllocatedBlocks(), 2);
+
+  // Weighted average, with the weight capped.
+  const float expected_distance = (0.1f * 1.0f - 0.2f * 2.0f) / 3.0f;
+  auto shared_block = local_layer.getBlockAtIndex(shared_index);
+  ASSERT_NE(shared_block, nullptr);
+  for (int i = 0; i < TsdfBlock::kNumVoxels; ++i) {
+    const TsdfVoxel& voxel = (&shared_block->voxels[0][0][0])[i];
+    EXPECT_NEAR(voxel.distance, expected_distance, kEps);
+    EXPECT_NEAR(voxel.weight, 2.5f, kEps);
+  }
+
+  // Blocks only observed by the peer are copied.
+  auto peer_block = local_layer.getBlockAtIndex(peer_index);
+  ASSERT_NE(peer_block, nullptr);
+  for (int i = 0; i < TsdfBlock::kNumVoxels; ++i) {
+    const TsdfVoxel& voxel = (&peer_block->voxels[0][0][0])[i];
+    EXPECT_NEAR(voxel.distance, peer_voxel.distance, kEps);
+    EXPECT_NEAR(voxel.weight, peer_voxel.weight, kEps);
+  }
+}
+
+TEST(SerializedLayerMergerTest, MergeOccupancy) {
+  OccupancyLayer local_layer(kVoxelSize, MemoryType::kUnified);
+  OccupancyLayer peer_layer(kVoxelSize, MemoryType::kUnified);
+
+  const Index3D observed_index(0, 0, 0);
+  const Index3D unobserved_index(0, 1, 0);
+  OccupancyVoxel local_voxel;
+  local_voxel.log_odds = 1.0f;
+  setAllVoxels(observed_index, local_voxel, &local_layer);
+  setAllVoxels(unobserved_index, local_voxel, &local_layer);
+  OccupancyVoxel peer_voxel;
+  peer_voxel.log_odds = -2.0f;
+  setAllVoxels(observed_index, peer_voxel, &peer_layer);
+  // The peer didn't observe this block.
+  setAllVoxels(unobserved_index, OccupancyVoxel(), &peer_layer);
+
+  CudaStreamOwning cuda_stream;
+  OccupancyLayerSerializerGpu serializer;
+  auto serialized_layer = serializer.serialize(
+      peer_layer, peer_layer.getAllBlockIndices(), cuda_stream);
+
+  SerializedLayerMerger merger;
+  merger.merge(*serialized_layer, &local_layer);
+
+  auto observed_block = local_layer.getBlockAtIndex(observed_index);
+  auto unobserved_block = local_layer.getBlockAtIndex(unobserved_index);
+  ASSERT_NE(observed_block, nullptr);
+  ASSERT_NE(unobserved_block, nullptr);
+  for (int i = 0; i < OccupancyBlock::kNumVoxels; ++i) {
+    EXPECT_NEAR((&observed_block->voxels[0][0][0])[i].log_odds, -0.5f, kEps);
+    EXPECT_NEAR((&unobserved_block->voxels[0][0][0])[i].log_odds, 1.0f, kEps);
+  }
+}
+
+int main(int argc, char** argv) {
+  google::InitGoogleLogging(argv[0]);
+  FLAGS_alsologtostderr = true;
+  google::InstallFailureSignalHandler();
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
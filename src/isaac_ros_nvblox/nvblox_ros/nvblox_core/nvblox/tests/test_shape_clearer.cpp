@@ -15,6 +15,8 @@ limitations under the License.
 */
 #include <gtest/gtest.h>
 
+#include <cmath>
+
 #include "nvblox/integrators/esdf_integrator.h"
 #include "nvblox/integrators/shape_clearer.h"
 #include "nvblox/io/pointcloud_io.h"
@@ -253,6 +255,31 @@ TYPED_TEST(ShapeClearerTest, TestMixedShapes) {
   }
 }
 
+TYPED_TEST(ShapeClearerTest, TestManyShapes) {
+  // Create the layers.
+  VoxelBlockLayer<TypeParam> layer_to_clear(this->kVoxelSizeM,
+                                            MemoryType::kHost);
+  layer_to_clear.copyFrom(this->layer_);
+
+  // Many small (overlapping) shapes, which are binned into few blocks, and a
+  // shape larger than the layer, which visits the allocated blocks.
+  std::vector<BoundingShape> shape_vec;
+  for (int i = 0; i < 50; i++) {
+    const Vector3f center(-4.0f + 0.16f * i, 0.5f * std::sin(0.3f * i), 1.0f);
+    if (i % 2 == 0) {
+      shape_vec.push_back(BoundingSphere(center, 0.3f));
+    } else {
+      shape_vec.push_back(AxisAlignedBoundingBox(
+          center - 0.2f * Vector3f::Ones(), center + 0.2f * Vector3f::Ones()));
+    }
+  }
+  shape_vec.push_back(AxisAlignedBoundingBox(Vector3f(-1e6f, -1e6f, 4.0f),
+                                             Vector3f(1e6f, 1e6f, 1e6f)));
+
+  // Test the clearing.
+  testClearingLayer(this->layer_, shape_vec, &layer_to_clear);
+}
+
 int main(int argc, char** argv) {
   FLAGS_alsologtostderr = true;
   google::InitGoogleLogging(argv[0]);
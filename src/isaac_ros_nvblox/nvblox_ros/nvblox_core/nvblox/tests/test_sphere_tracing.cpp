@@ -515,6 +515,102 @@ TEST_F(SphereTracingTest, SubsamplingTest) {
   }
 }
 
+TEST_F(SphereTracingTest, MultiViewRendering) {
+  // Ground-truth distance field
+  primitives::Scene scene = getSphereInBoxScene();
+  TsdfLayer layer_host(voxel_size_m_, MemoryType::kHost);
+  scene.generateLayerFromScene(truncation_distance_m_, &layer_host);
+  layer_->copyFrom(layer_host);
+
+  // Views with differently sized cameras.
+  constexpr int kNumViews = 4;
+  const Camera small_camera(150, 150, 80, 60, 160, 120);
+  std::vector<Camera> cameras;
+  std::vector<Transform> T_L_C_vec;
+  for (int i = 0; i < kNumViews; i++) {
+    cameras.push_back((i % 2 == 0) ? *camera_ptr_ : small_camera);
+    T_L_C_vec.push_back(getRandomViewpointInSphereInBoxScene());
+  }
+
+  SphereTracer sphere_tracer;
+  constexpr int kSubsamplingFactor = 2;
+  std::vector<DepthImage> batched_images;
+  for (int i = 0; i < kNumViews; i++) {
+    batched_images.emplace_back(MemoryType::kUnified);
+  }
+  std::vector<DepthImage*> batched_image_ptrs;
+  for (DepthImage& image : batched_images) {
+    batched_image_ptrs.push_back(&image);
+  }
+  sphere_tracer.renderImagesOnGPU(cameras, T_L_C_vec, *layer_,
+                                  truncation_distance_m_, batched_image_ptrs,
+                                  MemoryType::kUnified, kSubsamplingFactor);
+
+  // The batched render should exactly match rendering the views one by one.
+  DepthImage single_image(MemoryType::kUnified);
+  for (int i = 0; i < kNumViews; i++) {
+    sphere_tracer.renderImageOnGPU(cameras[i], T_L_C_vec[i], *layer_,
+                                   truncation_distance_m_, &single_image,
+                                   MemoryType::kUnified, kSubsamplingFactor);
+    ASSERT_EQ(batched_images[i].rows(), single_image.rows());
+    ASSERT_EQ(batched_images[i].cols(), single_image.cols());
+    int num_hits = 0;
+    for (int lin_idx = 0; lin_idx < single_image.numel(); lin_idx++) {
+      EXPECT_EQ(batched_images[i](lin_idx), single_image(lin_idx));
+      num_hits += (single_image(lin_idx) > 0.0f) ? 1 : 0;
+    }
+    EXPECT_GT(num_hits, 0);
+  }
+}
+
+TEST_F(SphereTracingTest, ReprojectPreviousRender) {
+  // Ground-truth distance field
+  primitives::Scene scene = getSphereInBoxScene();
+  TsdfLayer layer_host(voxel_size_m_, MemoryType::kHost);
+  scene.generateLayerFromScene(truncation_distance_m_, &layer_host);
+  layer_->copyFrom(layer_host);
+
+  SphereTracer reprojecting_sphere_tracer;
+  reprojecting_sphere_tracer.reproject_previous_render(true);
+  EXPECT_TRUE(reprojecting_sphere_tracer.reproject_previous_render());
+  SphereTracer sphere_tracer;
+
+  // A slowly moving camera.
+  Transform T_S_C = getRandomViewpointInSphereInBoxScene();
+  const Transform T_Cprevious_C =
+      Transform(Eigen::Translation3f(0.02f, -0.01f, 0.03f) *
+                Eigen::AngleAxisf(0.02f, Vector3f::UnitY()));
+
+  DepthImage reprojected_image(MemoryType::kUnified);
+  DepthImage image(MemoryType::kUnified);
+  constexpr int kNumFrames = 5;
+  for (int i = 0; i < kNumFrames; i++) {
+    reprojecting_sphere_tracer.renderImageOnGPU(
+        *camera_ptr_, T_S_C, *layer_, truncation_distance_m_,
+        &reprojected_image, MemoryType::kUnified);
+    sphere_tracer.renderImageOnGPU(*camera_ptr_, T_S_C, *layer_,
+                                   truncation_distance_m_, &image,
+                                   MemoryType::kUnified);
+
+    // Warm started rays should find the same surfaces.
+    int num_different_pixels = 0;
+    for (int lin_idx = 0; lin_idx < image.numel(); lin_idx++) {
+      if (std::abs(reprojected_image(lin_idx) - image(lin_idx)) >
+          voxel_size_m_) {
+        num_different_pixels++;
+      }
+    }
+    const float percentage_different_pixels =
+        100.0f * static_cast<float>(num_different_pixels) /
+        static_cast<float>(image.numel());
+    std::cout << "percentage_different_pixels: "
+              << percentage_different_pixels << std::endl;
+    EXPECT_LT(percentage_different_pixels, 1.0f);
+
+    T_S_C = T_S_C * T_Cprevious_C;
+  }
+}
+
 TEST_F(SphereTracingTest, GettersAndSetters) {
   // Sphere tracer
   SphereTracer sphere_tracer;
@@ -526,6 +622,39 @@ TEST_F(SphereTracingTest, GettersAndSetters) {
   EXPECT_EQ(sphere_tracer.surface_distance_epsilon_vox(), 3.0f);
 }
 
+TEST_F(SphereTracingTest, SkipUnallocatedBlocks) {
+  // A far away plane, with only the blocks around the surface allocated.
+  constexpr float kPlaneDistance = 15.0f;
+  primitives::Scene scene;
+  scene.aabb() =
+      AxisAlignedBoundingBox(Vector3f(kPlaneDistance - 1.0f, -1.0f, -1.0f),
+                             Vector3f(kPlaneDistance + 1.0f, 1.0f, 1.0f));
+  scene.addPrimitive(std::make_unique<primitives::Plane>(
+      Vector3f(kPlaneDistance, 0.0f, 0.0f), Vector3f(-1.0f, 0.0f, 0.0f)));
+  TsdfLayer layer_host(voxel_size_m_, MemoryType::kHost);
+  scene.generateLayerFromScene(truncation_distance_m_, &layer_host);
+  layer_->copyFrom(layer_host);
+
+  // Stepping by the truncation distance needs 75 steps to reach the plane.
+  // Skipping the unallocated blocks needs less than half of that.
+  SphereTracerTester sphere_tracer;
+  constexpr int kMaximumSteps = 50;
+  sphere_tracer.maximum_steps(kMaximumSteps);
+  sphere_tracer.maximum_ray_length_m(2.0f * kPlaneDistance);
+  EXPECT_FALSE(sphere_tracer.skip_unallocated_blocks());
+
+  const Ray ray(Vector3f(0.0f, 0.01f, 0.02f), Vector3f(1.0f, 0.0f, 0.0f));
+  float t = 0.0f;
+  EXPECT_FALSE(
+      sphere_tracer.castOnGPU(ray, *layer_, truncation_distance_m_, &t));
+
+  sphere_tracer.skip_unallocated_blocks(true);
+  EXPECT_TRUE(
+      sphere_tracer.castOnGPU(ray, *layer_, truncation_distance_m_, &t));
+  const float voxel_size = voxel_size_m_;
+  EXPECT_NEAR(t, kPlaneDistance, voxel_size);
+}
+
 // Generates a grid of voxels centers falling with a 2D bounding box at a
 // constant height.
 std::vector<Vector3f> generatePlanarGrid(
@@ -0,0 +1,104 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "nvblox/core/cuda_stream.h"
+#include "nvblox/core/sync_monitor.h"
+#include "nvblox/core/unified_vector.h"
+#include "nvblox/utils/timing.h"
+
+using namespace nvblox;
+
+constexpr int kSync = static_cast<int>(SyncEventType::kSynchronize);
+constexpr int kDefaultStreamCopy =
+    static_cast<int>(SyncEventType::kDefaultStreamCopy);
+constexpr int kPageableCopy = static_cast<int>(SyncEventType::kPageableCopy);
+
+class SyncMonitorTest : public ::testing::Test {
+ protected:
+  void SetUp() override { SyncMonitor::reset(); }
+};
+
+TEST_F(SyncMonitorTest, CopyClassification) {
+  CudaStreamOwning cuda_stream;
+  device_vector<float> device_buffer(10);
+  host_vector<float> pinned_buffer(10);
+  std::vector<float> pageable_buffer(10);
+
+  // Pinned host to device on a non-default stream: nothing to report.
+  SyncMonitor::recordCopy(device_buffer.data(), pinned_buffer.data(),
+                          cuda_stream);
+  EXPECT_EQ(SyncMonitor::totalCounts(), SyncMonitor::Counts{});
+
+  SyncMonitor::recordCopy(device_buffer.data(), pageable_buffer.data(),
+                          cuda_stream);
+  EXPECT_EQ(SyncMonitor::totalCounts()[kPageableCopy], 1u);
+  EXPECT_EQ(SyncMonitor::totalCounts()[kDefaultStreamCopy], 0u);
+
+  SyncMonitor::recordCopy(device_buffer.data(), pinned_buffer.data(),
+                          cudaStreamPerThread);
+  SyncMonitor::recordCopy(device_buffer.data(), pinned_buffer.data(), 0);
+  EXPECT_EQ(SyncMonitor::totalCounts()[kPageableCopy], 1u);
+  EXPECT_EQ(SyncMonitor::totalCounts()[kDefaultStreamCopy], 2u);
+}
+
+TEST_F(SyncMonitorTest, FrameCountsAndTags) {
+  SyncMonitor::record(SyncEventType::kSynchronize);
+  {
+    timing::Timer timer("sync_monitor_test/outer");
+    SyncMonitor::record(SyncEventType::kSynchronize);
+  }
+  EXPECT_EQ(SyncMonitor::frameCounts()[kSync], 2u);
+
+  const SyncMonitor::Counts frame_counts = SyncMonitor::endFrame();
+  EXPECT_EQ(frame_counts[kSync], 2u);
+  EXPECT_EQ(SyncMonitor::frameCounts()[kSync], 0u);
+  EXPECT_EQ(SyncMonitor::totalCounts()[kSync], 2u);
+
+  const auto counts_per_tag = SyncMonitor::countsPerTag();
+  ASSERT_GT(counts_per_tag.count("untagged"), 0u);
+  EXPECT_EQ(counts_per_tag.at("untagged")[kSync], 1u);
+#ifdef NVBLOX_SYNC_MONITOR
+  // The timers only maintain the tag stack when the monitor is compiled in.
+  ASSERT_GT(counts_per_tag.count("sync_monitor_test/outer"), 0u);
+  EXPECT_EQ(counts_per_tag.at("sync_monitor_test/outer")[kSync], 1u);
+#endif
+}
+
+#ifdef NVBLOX_SYNC_MONITOR
+TEST_F(SyncMonitorTest, InstrumentedCalls) {
+  CudaStreamOwning cuda_stream;
+  const std::vector<float> pageable_buffer(10, 1.0f);
+  device_vector<float> device_buffer;
+  device_buffer.copyFromAsync(pageable_buffer, cuda_stream);
+  cuda_stream.synchronize();
+
+  const SyncMonitor::Counts counts = SyncMonitor::totalCounts();
+  EXPECT_EQ(counts[kSync], 1u);
+  EXPECT_EQ(counts[kPageableCopy], 1u);
+  EXPECT_EQ(counts[kDefaultStreamCopy], 0u);
+}
+#endif
+
+int main(int argc, char** argv) {
+  FLAGS_alsologtostderr = true;
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,137 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+
+#include "nvblox/io/tensor_view.h"
+
+using namespace nvblox;
+
+// Reads a scalar through the strides of a view.
+template <typename ScalarType>
+ScalarType atIndex(const io::TensorView& view,
+                   const std::vector<int64_t>& index) {
+  EXPECT_EQ(static_cast<int>(index.size()), view.ndim);
+  int64_t offset = 0;
+  for (int i = 0; i < view.ndim; ++i) {
+    offset += index[i] * view.strides[i];
+  }
+  return static_cast<const ScalarType*>(view.data)[offset];
+}
+
+TEST(TensorViewTest, DepthImage) {
+  constexpr int kRows = 4;
+  constexpr int kCols = 5;
+  DepthImage image(kRows, kCols, MemoryType::kUnified);
+  for (int row = 0; row < kRows; ++row) {
+    for (int col = 0; col < kCols; ++col) {
+      image(row, col) = row * 10.0f + col;
+    }
+  }
+
+  const io::TensorView view = io::tensorViewFromImage(image);
+  EXPECT_EQ(view.data, image.dataConstPtr());
+  EXPECT_EQ(view.device_type, io::TensorDeviceType::kCudaManaged);
+  EXPECT_EQ(view.type_code, io::TensorTypeCode::kFloat);
+  EXPECT_EQ(view.type_bits, 32);
+  ASSERT_EQ(view.ndim, 2);
+  EXPECT_EQ(view.shape[0], kRows);
+  EXPECT_EQ(view.shape[1], kCols);
+  EXPECT_EQ(view.strides[0], image.stride_num_elements());
+  EXPECT_EQ(view.strides[1], 1);
+  EXPECT_EQ(view.numel(), kRows * kCols);
+  for (int row = 0; row < kRows; ++row) {
+    for (int col = 0; col < kCols; ++col) {
+      EXPECT_EQ(atIndex<float>(view, {row, col}), image(row, col));
+    }
+  }
+}
+
+TEST(TensorViewTest, ColorImage) {
+  constexpr int kRows = 3;
+  constexpr int kCols = 2;
+  ColorImage image(kRows, kCols, MemoryType::kHost);
+  for (int row = 0; row < kRows; ++row) {
+    for (int col = 0; col < kCols; ++col) {
+      image(row, col) = Color(row, col, row + col, 7);
+    }
+  }
+
+  const io::TensorView view = io::tensorViewFromImage(image);
+  EXPECT_EQ(view.device_type, io::TensorDeviceType::kCudaHost);
+  EXPECT_EQ(view.type_code, io::TensorTypeCode::kUInt);
+  EXPECT_EQ(view.type_bits, 8);
+  ASSERT_EQ(view.ndim, 3);
+  EXPECT_EQ(view.shape[2], 4);
+  EXPECT_EQ(view.strides[2], 1);
+  EXPECT_EQ(view.strides[1], 4);
+  for (int row = 0; row < kRows; ++row) {
+    for (int col = 0; col < kCols; ++col) {
+      EXPECT_EQ(atIndex<uint8_t>(view, {row, col, 0}), image(row, col).r);
+      EXPECT_EQ(atIndex<uint8_t>(view, {row, col, 1}), image(row, col).g);
+      EXPECT_EQ(atIndex<uint8_t>(view, {row, col, 2}), image(row, col).b);
+      EXPECT_EQ(atIndex<uint8_t>(view, {row, col, 3}), image(row, col).a);
+    }
+  }
+}
+
+TEST(TensorViewTest, DenseGrid) {
+  const Index3D min_index(-1, 2, 3);
+  const Index3D aabb_size(2, 3, 4);
+  Unified3DGrid<float> grid(MemoryType::kUnified);
+  grid.setAABB(min_index, aabb_size);
+  Unified3DGrid<Vector3f> gradient_grid(MemoryType::kDevice);
+  gradient_grid.setAABB(min_index, aabb_size);
+  for (int x = 0; x < aabb_size.x(); ++x) {
+    for (int y = 0; y < aabb_size.y(); ++y) {
+      for (int z = 0; z < aabb_size.z(); ++z) {
+        grid(min_index + Index3D(x, y, z)) = x * 100.0f + y * 10.0f + z;
+      }
+    }
+  }
+
+  const io::TensorView view = io::tensorViewFromGrid(grid);
+  ASSERT_EQ(view.ndim, 3);
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(view.shape[i], aabb_size[i]);
+  }
+  EXPECT_EQ(view.strides[2], 1);
+  for (int x = 0; x < aabb_size.x(); ++x) {
+    for (int y = 0; y < aabb_size.y(); ++y) {
+      for (int z = 0; z < aabb_size.z(); ++z) {
+        EXPECT_EQ(atIndex<float>(view, {x, y, z}),
+                  grid(min_index + Index3D(x, y, z)));
+      }
+    }
+  }
+
+  // Vector cells get a channel dimension.
+  const io::TensorView gradient_view = io::tensorViewFromGrid(gradient_grid);
+  EXPECT_EQ(gradient_view.device_type, io::TensorDeviceType::kCuda);
+  ASSERT_EQ(gradient_view.ndim, 4);
+  EXPECT_EQ(gradient_view.shape[3], 3);
+  EXPECT_EQ(gradient_view.strides[3], 1);
+  EXPECT_EQ(gradient_view.strides[2], 3);
+  EXPECT_EQ(gradient_view.strides[0], 3 * aabb_size.y() * aabb_size.z());
+  EXPECT_EQ(gradient_view.numel(), 3 * aabb_size.prod());
+}
+
+int main(int argc, char** argv) {
+  FLAGS_alsologtostderr = true;
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
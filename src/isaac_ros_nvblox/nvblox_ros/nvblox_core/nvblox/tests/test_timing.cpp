@@ -17,6 +17,9 @@ limitations under the License.
 #include <glog/logging.h>
 #include <gtest/gtest.h>
 
+#include <thread>
+#include <vector>
+
 #include "nvblox/utils/timing.h"
 
 using namespace nvblox;
@@ -56,6 +59,73 @@ TEST(TimingTest, TestAccumulatorInt) {
   EXPECT_NEAR(acc.LazyVariance(), 1.25, 1e-9);
 }
 
+TEST(TimingTest, TestAccumulatorMerge) {
+  timing::Accumulator<int, double, 4> acc_1;
+  timing::Accumulator<int, double, 4> acc_2;
+  for (int i = 0; i < 3; ++i) {
+    acc_1.Add(i);
+  }
+  for (int i = 3; i < 8; ++i) {
+    acc_2.Add(i);
+  }
+  acc_1.Merge(acc_2);
+
+  // Totals are exact and the window holds the newest samples of acc_2.
+  EXPECT_EQ(acc_1.TotalSamples(), 8);
+  EXPECT_EQ(acc_1.WindowSamples(), 4);
+  EXPECT_EQ(acc_1.Sum(), 28);
+  EXPECT_DOUBLE_EQ(acc_1.RollingMean(), 5.5);
+  EXPECT_EQ(acc_1.Max(), 7);
+  EXPECT_EQ(acc_1.Min(), 0);
+}
+
+TEST(TimingTest, MergeTimersOfThreads) {
+  constexpr int kNumThreads = 4;
+  constexpr int kNumSamplesPerThread = 100;
+  const std::string tag = "test_timing/threads";
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads.emplace_back([&tag]() {
+      for (int j = 0; j < kNumSamplesPerThread; ++j) {
+        timing::TimerChrono timer(tag);
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  // The samples of the exited threads are kept.
+  EXPECT_EQ(timing::Timing::GetNumSamples(tag),
+            kNumThreads * kNumSamplesPerThread);
+  EXPECT_NE(timing::Timing::Print().find(tag), std::string::npos);
+
+  timing::Timing::Reset();
+  EXPECT_EQ(timing::Timing::GetNumSamples(tag), 0);
+}
+
+TEST(TimingTest, DisableSubsystem) {
+  const std::string tag = "test_subsystem/timer";
+  const std::string other_tag = "test_subsystem_other/timer";
+  { timing::TimerChrono timer(tag); }
+  EXPECT_EQ(timing::Timing::GetNumSamples(tag), 1);
+
+  timing::Timing::SetSubsystemEnabled("test_subsystem", false);
+  EXPECT_FALSE(timing::Timing::IsEnabled(tag));
+  EXPECT_FALSE(timing::Timing::IsEnabled("test_subsystem/new_timer"));
+  EXPECT_TRUE(timing::Timing::IsEnabled(other_tag));
+  {
+    timing::TimerChrono timer(tag);
+    EXPECT_FALSE(timer.IsTiming());
+  }
+  { timing::TimerChrono timer(other_tag); }
+  EXPECT_EQ(timing::Timing::GetNumSamples(tag), 1);
+  EXPECT_EQ(timing::Timing::GetNumSamples(other_tag), 1);
+
+  timing::Timing::SetSubsystemEnabled("test_subsystem", true);
+  { timing::TimerChrono timer(tag); }
+  EXPECT_EQ(timing::Timing::GetNumSamples(tag), 2);
+}
+
 int main(int argc, char** argv) {
   google::InitGoogleLogging(argv[0]);
   FLAGS_alsologtostderr = true;
@@ -0,0 +1,133 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+
+#include <algorithm>
+
+#include "nvblox/integrators/tsdf_block_pruner.h"
+#include "nvblox/map/layer.h"
+#include "nvblox/mapper/mapper.h"
+
+using namespace nvblox;
+
+class TsdfBlockPrunerTest : public ::testing::Test {
+ protected:
+  static constexpr float kVoxelSizeM{0.1};
+  static constexpr float kTruncationDistanceM{0.4};
+
+  void SetUp() override {
+    // An empty block, a block with an observed surface voxel and a block with
+    // an observed voxel far from the surface.
+    layer_.allocateBlockAtIndex(kEmptyBlock);
+    layer_.allocateBlockAtIndex(kSurfaceBlock)->voxels[1][2][3] =
+        makeVoxel(0.05f, 1.f);
+    layer_.allocateBlockAtIndex(kFreespaceBlock)->voxels[4][5][6] =
+        makeVoxel(2.f, 1.f);
+  }
+
+  static TsdfVoxel makeVoxel(float distance, float weight) {
+    TsdfVoxel voxel;
+    voxel.distance = distance;
+    voxel.weight = weight;
+    return voxel;
+  }
+
+  static bool contains(const std::vector<Index3D>& blocks,
+                       const Index3D& block) {
+    return std::find(blocks.begin(), blocks.end(), block) != blocks.end();
+  }
+
+  const Index3D kEmptyBlock{0, 0, 0};
+  const Index3D kSurfaceBlock{1, 0, 0};
+  const Index3D kFreespaceBlock{0, 2, 0};
+  TsdfLayer layer_{kVoxelSizeM, MemoryType::kUnified};
+};
+
+TEST(TsdfBlockPruner, EmptyLayer) {
+  TsdfLayer layer(0.1f, MemoryType::kUnified);
+  TsdfBlockPruner pruner;
+  EXPECT_TRUE(pruner.getBlocksToPrune(layer, 0.4f).empty());
+}
+
+TEST_F(TsdfBlockPrunerTest, PruneUnobserved) {
+  TsdfBlockPruner pruner;
+  const std::vector<Index3D> blocks =
+      pruner.getBlocksToPrune(layer_, kTruncationDistanceM);
+  ASSERT_EQ(blocks.size(), 1);
+  EXPECT_EQ(blocks[0], kEmptyBlock);
+  // The layer is not modified.
+  EXPECT_EQ(layer_.numAllocatedBlocks(), 3);
+}
+
+TEST_F(TsdfBlockPrunerTest, PruneOutsideTruncationBand) {
+  TsdfBlockPruner pruner;
+  pruner.prune_outside_truncation_band(true);
+  const std::vector<Index3D> blocks =
+      pruner.getBlocksToPrune(layer_, kTruncationDistanceM);
+  EXPECT_EQ(blocks.size(), 2);
+  EXPECT_TRUE(contains(blocks, kEmptyBlock));
+  EXPECT_TRUE(contains(blocks, kFreespaceBlock));
+}
+
+TEST_F(TsdfBlockPrunerTest, MinWeight) {
+  TsdfBlockPruner pruner;
+  pruner.min_weight(2.f);
+  EXPECT_EQ(pruner.getBlocksToPrune(layer_, kTruncationDistanceM).size(), 3);
+}
+
+TEST(TsdfBlockPruner, Period) {
+  TsdfBlockPruner pruner;
+  // Disabled by default.
+  pruner.registerIntegration();
+  EXPECT_FALSE(pruner.isPruningDue());
+
+  pruner.period(3);
+  pruner.registerIntegration();
+  EXPECT_FALSE(pruner.isPruningDue());
+  pruner.registerIntegration();
+  EXPECT_TRUE(pruner.isPruningDue());
+  // The count restarts after a pass.
+  EXPECT_FALSE(pruner.isPruningDue());
+  pruner.registerIntegration();
+  pruner.registerIntegration();
+  EXPECT_FALSE(pruner.isPruningDue());
+  pruner.registerIntegration();
+  EXPECT_TRUE(pruner.isPruningDue());
+}
+
+TEST(TsdfBlockPruner, MapperRemovesEsdfBlocksOnEsdfUpdate) {
+  Mapper mapper(0.1f, MemoryType::kUnified);
+  const Index3D block_index(0, 0, 0);
+  mapper.tsdf_layer().allocateBlockAtIndex(block_index);
+  mapper.esdf_layer().allocateBlockAtIndex(block_index);
+
+  const std::vector<Index3D> pruned_blocks = mapper.pruneTsdfBlocks();
+  ASSERT_EQ(pruned_blocks.size(), 1);
+  EXPECT_EQ(mapper.tsdf_layer().numAllocatedBlocks(), 0);
+  // The ESDF block is left to the ESDF update, which may run on another
+  // thread.
+  EXPECT_EQ(mapper.esdf_layer().numAllocatedBlocks(), 1);
+  mapper.updateEsdf();
+  EXPECT_EQ(mapper.esdf_layer().numAllocatedBlocks(), 0);
+}
+
+int main(int argc, char** argv) {
+  FLAGS_alsologtostderr = true;
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -204,6 +204,81 @@ TEST_F(TsdfDecayIntegratorTest, DecayUntilRemoved) {
   EXPECT_EQ(num_allocated_blocks, num_dellocated_blocks);
 }
 
+// Test that lazy decay ends up at the same weights as eager decay.
+TEST_F(TsdfDecayIntegratorTest, LazyDecayMatchesEagerDecay) {
+  constexpr float kDecayFactor{0.75};
+  constexpr int kNumDecaySteps{3};
+
+  TsdfLayer layer_eager(kVoxelSizeM, MemoryType::kHost);
+  layer_eager.copyFrom(layer_);
+  TsdfLayer layer_lazy(kVoxelSizeM, MemoryType::kHost);
+  layer_lazy.copyFrom(layer_);
+
+  TsdfDecayIntegrator eager_integrator;
+  eager_integrator.deallocate_decayed_blocks(false);
+  eager_integrator.decay_factor(kDecayFactor);
+
+  TsdfDecayIntegrator lazy_integrator;
+  lazy_integrator.deallocate_decayed_blocks(false);
+  lazy_integrator.decay_factor(kDecayFactor);
+  lazy_integrator.lazy_decay(true);
+  lazy_integrator.lazy_decay_compaction_period(kNumDecaySteps + 1);
+
+  CudaStreamOwning cuda_stream;
+  for (int i = 0; i < kNumDecaySteps; i++) {
+    eager_integrator.decay(&layer_eager, cuda_stream);
+    lazy_integrator.addPendingDecayStep();
+  }
+  EXPECT_FALSE(lazy_integrator.isCompactionDue());
+
+  // Catch up a single block. It should match the eagerly decayed one, while
+  // the other blocks remain untouched.
+  const std::vector<Index3D> all_blocks = layer_lazy.getAllBlockIndices();
+  ASSERT_GT(all_blocks.size(), 1);
+  const Index3D caught_up_block = all_blocks.front();
+  EXPECT_EQ(lazy_integrator.numPendingDecaySteps(caught_up_block),
+            kNumDecaySteps);
+  lazy_integrator.applyPendingDecay(&layer_lazy, {caught_up_block},
+                                    cuda_stream);
+  EXPECT_EQ(lazy_integrator.numPendingDecaySteps(caught_up_block), 0);
+  EXPECT_EQ(lazy_integrator.numPendingDecaySteps(all_blocks.back()),
+            kNumDecaySteps);
+
+  callFunctionOnAllVoxels<TsdfVoxel>(
+      layer_lazy, [&](const Index3D& block_index, const Index3D& voxel_index,
+                      const TsdfVoxel* voxel) {
+        const TsdfLayer& expected_layer =
+            (block_index == caught_up_block) ? layer_eager : layer_;
+        const float expected_weight =
+            expected_layer.getBlockAtIndex(block_index)
+                ->voxels[voxel_index(0)][voxel_index(1)][voxel_index(2)]
+                .weight;
+        EXPECT_NEAR(voxel->weight, expected_weight, 1.0E-6);
+      });
+
+  // A further step is only pending for the caught up block, compaction then
+  // brings all blocks up to date.
+  eager_integrator.decay(&layer_eager, cuda_stream);
+  lazy_integrator.addPendingDecayStep();
+  EXPECT_TRUE(lazy_integrator.isCompactionDue());
+  EXPECT_EQ(lazy_integrator.numPendingDecaySteps(caught_up_block), 1);
+  lazy_integrator.applyAllPendingDecay(&layer_lazy, cuda_stream);
+  EXPECT_FALSE(lazy_integrator.isCompactionDue());
+
+  for (const Index3D& block_index : all_blocks) {
+    EXPECT_EQ(lazy_integrator.numPendingDecaySteps(block_index), 0);
+  }
+  callFunctionOnAllVoxels<TsdfVoxel>(
+      layer_lazy, [&](const Index3D& block_index, const Index3D& voxel_index,
+                      const TsdfVoxel* voxel) {
+        const float expected_weight =
+            layer_eager.getBlockAtIndex(block_index)
+                ->voxels[voxel_index(0)][voxel_index(1)][voxel_index(2)]
+                .weight;
+        EXPECT_NEAR(voxel->weight, expected_weight, 1.0E-5);
+      });
+}
+
 bool isAtLeastOneVoxelAboveWeight(const TsdfLayer& tsdf_layer,
                                   const float min_weight) {
   bool at_least_one_above = false;
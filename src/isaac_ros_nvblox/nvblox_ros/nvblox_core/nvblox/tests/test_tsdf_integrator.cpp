@@ -519,6 +519,165 @@ TEST_F(TsdfIntegratorTest, mask) {
         return;
       });
 }
+TEST_F(TsdfIntegratorTest, BatchedIntegrationMatchesSequential) {
+  // A plane seen from two (translated) viewpoints
+  const test_utils::Plane plane = test_utils::Plane(
+      Vector3f(0.0f, 0.0f, 5.0f), Vector3f(0.1f, -0.1f, -1.0f));
+  const DepthImage depth_frame = test_utils::getDepthImage(plane, camera_);
+  Transform T_L_C_1 = Transform::Identity();
+  Transform T_L_C_2 = Transform::Identity();
+  T_L_C_2.translation() = Vector3f(1.0f, 0.5f, 0.0f);
+
+  // Sequential integration
+  ProjectiveTsdfIntegrator integrator;
+  TsdfLayer layer_sequential(voxel_size_m_, MemoryType::kUnified);
+  integrator.integrateFrame(depth_frame, T_L_C_1, camera_, &layer_sequential);
+  integrator.integrateFrame(depth_frame, T_L_C_2, camera_, &layer_sequential);
+
+  // Batched integration
+  TsdfLayer layer_batched(voxel_size_m_, MemoryType::kUnified);
+  std::vector<Index3D> updated_blocks;
+  integrator.integrateFrames(
+      {MaskedDepthImageConstView(depth_frame),
+       MaskedDepthImageConstView(depth_frame)},
+      {T_L_C_1, T_L_C_2}, {camera_, camera_}, &layer_batched, &updated_blocks);
+
+  // Same blocks, same voxels.
+  EXPECT_GT(updated_blocks.size(), 0);
+  EXPECT_EQ(layer_batched.numAllocatedBlocks(),
+            layer_sequential.numAllocatedBlocks());
+  constexpr float kEps = 1e-4;
+  int num_voxels_compared = 0;
+  callFunctionOnAllVoxels<TsdfVoxel>(
+      layer_sequential,
+      [&](const Index3D& block_index, const Index3D& voxel_index,
+          const TsdfVoxel* voxel) -> void {
+        const auto block_ptr = layer_batched.getBlockAtIndex(block_index);
+        ASSERT_NE(block_ptr, nullptr);
+        const TsdfVoxel& voxel_batched =
+            block_ptr->voxels[voxel_index.x()][voxel_index.y()]
+                             [voxel_index.z()];
+        EXPECT_NEAR(voxel->distance, voxel_batched.distance, kEps);
+        EXPECT_NEAR(voxel->weight, voxel_batched.weight, kEps);
+        ++num_voxels_compared;
+      });
+  EXPECT_GT(num_voxels_compared, 0);
+}
+
+TEST_F(TsdfIntegratorTest, IntegerDepthMatchesFloat) {
+  const test_utils::Plane plane = test_utils::Plane(
+      Vector3f(0.0f, 0.0f, 5.0f), Vector3f(0.1f, -0.1f, -1.0f));
+  const DepthImage depth_frame_m = test_utils::getDepthImage(plane, camera_);
+
+  // The same depth in millimeters, and its (exact) float equivalent.
+  constexpr float kDepthScaleM = 1e-3f;
+  DepthImageU16 depth_frame_mm(depth_frame_m.rows(), depth_frame_m.cols(),
+                               MemoryType::kUnified);
+  DepthImage depth_frame_float(depth_frame_m.rows(), depth_frame_m.cols(),
+                               MemoryType::kUnified);
+  for (int i = 0; i < depth_frame_m.numel(); i++) {
+    depth_frame_mm(i) =
+        static_cast<uint16_t>(std::round(depth_frame_m(i) / kDepthScaleM));
+    depth_frame_float(i) = static_cast<float>(depth_frame_mm(i)) * kDepthScaleM;
+  }
+
+  ProjectiveTsdfIntegrator integrator;
+  TsdfLayer layer_float(voxel_size_m_, MemoryType::kUnified);
+  integrator.integrateFrame(depth_frame_float, Transform::Identity(), camera_,
+                            &layer_float);
+  TsdfLayer layer_integer(voxel_size_m_, MemoryType::kUnified);
+  std::vector<Index3D> updated_blocks;
+  integrator.integrateFrame(MaskedDepthImageU16ConstView(depth_frame_mm),
+                            kDepthScaleM, Transform::Identity(), camera_,
+                            &layer_integer, &updated_blocks);
+
+  EXPECT_GT(updated_blocks.size(), 0);
+  EXPECT_EQ(layer_integer.numAllocatedBlocks(),
+            layer_float.numAllocatedBlocks());
+  constexpr float kEps = 1e-5;
+  int num_voxels_compared = 0;
+  callFunctionOnAllVoxels<TsdfVoxel>(
+      layer_float,
+      [&](const Index3D& block_index, const Index3D& voxel_index,
+          const TsdfVoxel* voxel) -> void {
+        const auto block_ptr = layer_integer.getBlockAtIndex(block_index);
+        ASSERT_NE(block_ptr, nullptr);
+        const TsdfVoxel& voxel_integer =
+            block_ptr->voxels[voxel_index.x()][voxel_index.y()]
+                             [voxel_index.z()];
+        EXPECT_NEAR(voxel->distance, voxel_integer.distance, kEps);
+        EXPECT_NEAR(voxel->weight, voxel_integer.weight, kEps);
+        ++num_voxels_compared;
+      });
+  EXPECT_GT(num_voxels_compared, 0);
+}
+
+TEST_F(TsdfIntegratorTest, SubsampledIntegration) {
+  const test_utils::Plane plane = test_utils::Plane(
+      Vector3f(0.0f, 0.0f, 5.0f), Vector3f(0.1f, -0.1f, -1.0f));
+  const DepthImage depth_frame = test_utils::getDepthImage(plane, camera_);
+
+  // Subsampled integration is the integration of the downscaled frame.
+  constexpr int kFactor = 4;
+  ProjectiveTsdfIntegrator integrator;
+  EXPECT_EQ(integrator.integration_subsampling_factor(), 1);
+  integrator.integration_subsampling_factor(kFactor);
+  TsdfLayer layer_subsampled(voxel_size_m_, MemoryType::kUnified);
+  integrator.integrateFrame(depth_frame, Transform::Identity(), camera_,
+                            &layer_subsampled);
+
+  CudaStreamOwning cuda_stream;
+  DepthImage downscaled_frame(MemoryType::kDevice);
+  image::minDownscaleGPUAsync(MaskedDepthImageConstView(depth_frame), kFactor,
+                              &downscaled_frame, nullptr, cuda_stream);
+  cuda_stream.synchronize();
+  ProjectiveTsdfIntegrator reference_integrator;
+  TsdfLayer layer_reference(voxel_size_m_, MemoryType::kUnified);
+  reference_integrator.integrateFrame(downscaled_frame, Transform::Identity(),
+                                      camera_.downscaled(kFactor),
+                                      &layer_reference);
+
+  EXPECT_GT(layer_subsampled.numAllocatedBlocks(), 0);
+  EXPECT_EQ(layer_subsampled.numAllocatedBlocks(),
+            layer_reference.numAllocatedBlocks());
+  int num_voxels_compared = 0;
+  callFunctionOnAllVoxels<TsdfVoxel>(
+      layer_reference,
+      [&](const Index3D& block_index, const Index3D& voxel_index,
+          const TsdfVoxel* voxel) -> void {
+        const auto block_ptr = layer_subsampled.getBlockAtIndex(block_index);
+        ASSERT_NE(block_ptr, nullptr);
+        const TsdfVoxel& voxel_subsampled =
+            block_ptr->voxels[voxel_index.x()][voxel_index.y()]
+                             [voxel_index.z()];
+        EXPECT_EQ(voxel->distance, voxel_subsampled.distance);
+        EXPECT_EQ(voxel->weight, voxel_subsampled.weight);
+        ++num_voxels_compared;
+      });
+  EXPECT_GT(num_voxels_compared, 0);
+
+  // The plane is still reconstructed.
+  constexpr int kNumberOfPointsToCheck = 1000;
+  const Eigen::MatrixX2f u_random_C =
+      test_utils::getRandomPixelLocations(kNumberOfPointsToCheck, camera_);
+  const Eigen::MatrixX3f p_check_L =
+      test_utils::backProjectToPlaneVectorized(u_random_C, plane, camera_);
+  std::vector<Vector3f> points_L;
+  for (int i = 0; i < p_check_L.rows(); i++) {
+    points_L.push_back(p_check_L.row(i));
+  }
+  std::vector<float> distances;
+  std::vector<bool> success_flags;
+  interpolation::interpolateOnCPU(points_L, layer_subsampled, &distances,
+                                  &success_flags);
+  for (size_t i = 0; i < distances.size(); i++) {
+    if (success_flags[i]) {
+      EXPECT_NEAR(distances[i], 0.0f,
+                  surface_reconstruction_allowable_distance_error_m_);
+    }
+  }
+}
+
 int main(int argc, char** argv) {
   FLAGS_alsologtostderr = true;
   google::InitGoogleLogging(argv[0]);
@@ -241,6 +241,36 @@ TEST(UnifiedPointerTest, CopyToRaw) {
   EXPECT_EQ(*ptr_host_std, kTestValue);
 }
 
+TEST(UnifiedPointerTest, AliasingTest) {
+  constexpr int kNumElements = 10;
+  constexpr int kAliasedElement = 3;
+  int* raw_ptr;
+  unified_ptr<int> element_ptr;
+  {
+    unified_ptr<int[]> array_ptr = make_unified<int[]>(kNumElements);
+    raw_ptr = array_ptr.get();
+    setToConstantOnCPU(0, kNumElements, raw_ptr);
+    element_ptr = unified_ptr<int>(array_ptr, raw_ptr + kAliasedElement);
+    EXPECT_TRUE(element_ptr.is_alias());
+    EXPECT_FALSE(array_ptr.is_alias());
+  }
+  // The element keeps the array alive.
+  expect_cuda_allocated(raw_ptr);
+  *element_ptr = 1;
+  EXPECT_EQ(raw_ptr[kAliasedElement], 1);
+
+  // Copies and const conversions share the ownership too.
+  unified_ptr<const int> const_element_ptr = element_ptr;
+  EXPECT_TRUE(const_element_ptr.is_alias());
+  element_ptr.reset();
+  expect_cuda_allocated(raw_ptr);
+  EXPECT_EQ(*const_element_ptr, 1);
+
+  // The last pointer frees the whole array.
+  const_element_ptr.reset();
+  expect_cuda_freed(raw_ptr);
+}
+
 int main(int argc, char** argv) {
   google::InitGoogleLogging(argv[0]);
   FLAGS_alsologtostderr = true;
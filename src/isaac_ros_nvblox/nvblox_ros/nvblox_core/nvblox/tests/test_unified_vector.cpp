@@ -20,6 +20,8 @@ limitations under the License.
 #include <cuda_runtime.h>
 
 #include "nvblox/core/internal/warmup_cuda.h"
+#include "nvblox/core/memory_pool.h"
+#include "nvblox/core/unified_memory_hints.h"
 #include "nvblox/core/unified_vector.h"
 
 #include "nvblox/tests/increment_on_gpu.h"
@@ -291,6 +293,82 @@ TEST(UnifiedVector, MoveConstruct) {
   EXPECT_EQ(vec.memory_type(), MemoryType::kDevice);
 }
 
+TEST(UnifiedVectorTest, ClearAndDeallocAsync) {
+  CudaStreamOwning cuda_stream;
+  device_vector<int> vec(100);
+  vec.clearAndDeallocateAsync(cuda_stream);
+  EXPECT_TRUE(vec.empty());
+  EXPECT_EQ(vec.data(), nullptr);
+  EXPECT_EQ(vec.capacity(), 0);
+
+  // The vector can be reused afterwards.
+  vec.resizeAsync(10, cuda_stream);
+  EXPECT_EQ(vec.size(), 10);
+}
+
+TEST(UnifiedVectorTest, MemoryPoolKeepsFreedMemory) {
+  const uint64_t original_threshold = getDeviceMemoryPoolReleaseThreshold();
+  setDeviceMemoryPoolReleaseThreshold(kKeepAllMemoryPoolReleaseThreshold);
+  EXPECT_EQ(getDeviceMemoryPoolReleaseThreshold(),
+            kKeepAllMemoryPoolReleaseThreshold);
+
+  CudaStreamOwning cuda_stream;
+  constexpr size_t kNumElements = 1 << 20;
+  {
+    device_vector<int> vec(kNumElements);
+    EXPECT_GE(getDeviceMemoryPoolUsage().used_bytes,
+              kNumElements * sizeof(int));
+    vec.clearAndDeallocateAsync(cuda_stream);
+  }
+  cuda_stream.synchronize();
+
+  // The freed memory stays reserved in the pool for the next allocation.
+  const DeviceMemoryPoolUsage usage = getDeviceMemoryPoolUsage();
+  EXPECT_GE(usage.reserved_bytes, kNumElements * sizeof(int));
+  EXPECT_LE(usage.used_bytes, usage.reserved_bytes);
+
+  setDeviceMemoryPoolReleaseThreshold(original_threshold);
+}
+
+TEST(UnifiedVectorTest, UnifiedMemoryHints) {
+  CudaStreamOwning cuda_stream;
+  constexpr int kNumElems = 100;
+  unified_vector<int> vec(kNumElems, 1, MemoryType::kUnified);
+  vec.advisePreferredLocation(UnifiedMemoryLocation::kDevice);
+  vec.adviseReadMostly(true);
+
+  // Hints don't change the contents.
+  vec.prefetchAsync(UnifiedMemoryLocation::kDevice, cuda_stream);
+  cuda_stream.synchronize();
+  test_utils::incrementOnGPU(kNumElems, vec.data());
+  vec.prefetchAsync(UnifiedMemoryLocation::kHost, cuda_stream);
+  cuda_stream.synchronize();
+  checkAllConstantCPU(vec, 2);
+
+  // The advice is kept when the vector reallocates.
+  vec.reserveAsync(100 * kNumElems, cuda_stream);
+  cuda_stream.synchronize();
+  checkAllConstantCPU(vec, 2);
+  if (unifiedMemoryHintsSupported()) {
+    int read_mostly = 0;
+    checkCudaErrors(cudaMemRangeGetAttribute(
+        &read_mostly, sizeof(read_mostly), cudaMemRangeAttributeReadMostly,
+        vec.data(), vec.capacity() * sizeof(int)));
+    EXPECT_EQ(read_mostly, 1);
+    vec.adviseReadMostly(false);
+    checkCudaErrors(cudaMemRangeGetAttribute(
+        &read_mostly, sizeof(read_mostly), cudaMemRangeAttributeReadMostly,
+        vec.data(), vec.capacity() * sizeof(int)));
+    EXPECT_EQ(read_mostly, 0);
+  }
+
+  // Hints are ignored for other memory types.
+  device_vector<int> vec_device(kNumElems);
+  vec_device.adviseReadMostly(true);
+  vec_device.prefetchAsync(UnifiedMemoryLocation::kHost, cuda_stream);
+  cuda_stream.synchronize();
+}
+
 int main(int argc, char** argv) {
   google::InitGoogleLogging(argv[0]);
   FLAGS_alsologtostderr = true;
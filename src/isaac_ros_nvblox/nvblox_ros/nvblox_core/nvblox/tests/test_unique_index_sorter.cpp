@@ -0,0 +1,113 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+#include "nvblox/core/cuda_stream.h"
+#include "nvblox/core/hash.h"
+#include "nvblox/core/internal/unique_index_sorter.h"
+#include "nvblox/core/types.h"
+#include "nvblox/core/unified_vector.h"
+
+using namespace nvblox;
+
+std::vector<Index3D> sortAndTakeUniqueOnGpu(
+    const std::vector<Index3D>& indices) {
+  CudaStreamOwning cuda_stream;
+  device_vector<Index3D> indices_device;
+  indices_device.copyFromAsync(indices, cuda_stream);
+  UniqueIndexSorter sorter;
+  sorter.sortAndTakeUnique(indices.size(), &indices_device, cuda_stream);
+  std::vector<Index3D> output = indices_device.toVectorAsync(cuda_stream);
+  cuda_stream.synchronize();
+  return output;
+}
+
+std::vector<Index3D> sortAndTakeUniqueOnCpu(std::vector<Index3D> indices) {
+  std::sort(indices.begin(), indices.end(), VectorCompare<Index3D>());
+  indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+  return indices;
+}
+
+TEST(UniqueIndexSorterTest, Empty) {
+  EXPECT_TRUE(sortAndTakeUniqueOnGpu({}).empty());
+}
+
+TEST(UniqueIndexSorterTest, LargeSetWithDuplicates) {
+  // Far more indices than fit into a single thread block sort, with
+  // negative components and many duplicates.
+  std::srand(0);
+  constexpr int kNumIndices = 200000;
+  constexpr int kRange = 100;
+  std::vector<Index3D> indices;
+  indices.reserve(kNumIndices);
+  for (int i = 0; i < kNumIndices; i++) {
+    indices.emplace_back(std::rand() % kRange - kRange / 2,
+                         std::rand() % kRange - kRange / 2,
+                         std::rand() % 10 - 5);
+  }
+
+  const std::vector<Index3D> gpu_result = sortAndTakeUniqueOnGpu(indices);
+  const std::vector<Index3D> cpu_result = sortAndTakeUniqueOnCpu(indices);
+  ASSERT_EQ(gpu_result.size(), cpu_result.size());
+  EXPECT_LT(gpu_result.size(), indices.size());
+  for (size_t i = 0; i < gpu_result.size(); i++) {
+    EXPECT_EQ(gpu_result[i], cpu_result[i]);
+  }
+}
+
+TEST(UniqueIndexSorterTest, ExtremeIndices) {
+  constexpr int kMax = UniqueIndexSorter::kMaxAbsIndex - 1;
+  constexpr int kMin = -UniqueIndexSorter::kMaxAbsIndex;
+  const std::vector<Index3D> indices = {
+      Index3D(kMax, kMin, 0), Index3D(kMin, kMax, kMax),
+      Index3D(kMax, kMin, 0), Index3D(0, 0, kMin),
+      Index3D(kMin, kMin, kMin), Index3D(kMax, kMax, kMax)};
+  const std::vector<Index3D> gpu_result = sortAndTakeUniqueOnGpu(indices);
+  const std::vector<Index3D> cpu_result = sortAndTakeUniqueOnCpu(indices);
+  ASSERT_EQ(gpu_result.size(), 5);
+  for (size_t i = 0; i < gpu_result.size(); i++) {
+    EXPECT_EQ(gpu_result[i], cpu_result[i]);
+  }
+}
+
+TEST(UniqueIndexSorterTest, OnlyLeadingIndicesAreSorted) {
+  CudaStreamOwning cuda_stream;
+  const std::vector<Index3D> indices = {Index3D(2, 0, 0), Index3D(1, 0, 0),
+                                        Index3D(2, 0, 0), Index3D(7, 7, 7)};
+  device_vector<Index3D> indices_device;
+  indices_device.copyFromAsync(indices, cuda_stream);
+
+  // The last element is not part of the set.
+  UniqueIndexSorter sorter;
+  sorter.sortAndTakeUnique(3, &indices_device, cuda_stream);
+  const std::vector<Index3D> output = indices_device.toVectorAsync(cuda_stream);
+  cuda_stream.synchronize();
+  ASSERT_EQ(output.size(), 2);
+  EXPECT_EQ(output[0], Index3D(1, 0, 0));
+  EXPECT_EQ(output[1], Index3D(2, 0, 0));
+}
+
+int main(int argc, char** argv) {
+  google::InitGoogleLogging(argv[0]);
+  FLAGS_alsologtostderr = true;
+  google::InstallFailureSignalHandler();
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,124 @@
+/*
+Copyright 2024 NVIDIA CORPORATION
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+
+#include <type_traits>
+#include <vector>
+
+#include "nvblox/core/cuda_stream.h"
+#include "nvblox/core/unified_vector.h"
+#include "nvblox/serialization/internal/cuda/voxel_block_compression.cuh"
+#include "nvblox/serialization/internal/voxel_block_compression.h"
+
+using namespace nvblox;
+
+// The kernels are templated on the number of voxels per block, so both block
+// sizes of the VOXELS_PER_SIDE build option are tested in any build.
+template <typename T>
+class VoxelBlockCompressionTest : public ::testing::Test {};
+
+using NumVoxelsTypes =
+    ::testing::Types<std::integral_constant<int, 8 * 8 * 8>,
+                     std::integral_constant<int, 16 * 16 * 16>>;
+TYPED_TEST_SUITE(VoxelBlockCompressionTest, NumVoxelsTypes);
+
+TYPED_TEST(VoxelBlockCompressionTest, CompressAndHash) {
+  constexpr int kNumVoxels = TypeParam::value;
+  // Runs of kRunLength equal voxels are stored once.
+  constexpr int kRunLength = 7;
+  constexpr int kNumBlocks = 4;
+  CudaStreamOwning cuda_stream;
+
+  // Block 0: runs, block 1: unallocated, block 2: all voxels distinct,
+  // block 3: a copy of block 0.
+  unified_vector<float> voxels(kNumBlocks * kNumVoxels, MemoryType::kUnified);
+  for (int i = 0; i < kNumVoxels; i++) {
+    voxels[i] = static_cast<float>(i / kRunLength);
+    voxels[kNumVoxels + i] = 0.0f;
+    voxels[2 * kNumVoxels + i] = static_cast<float>(i);
+    voxels[3 * kNumVoxels + i] = voxels[i];
+  }
+  unified_vector<const float*> block_ptrs(kNumBlocks, MemoryType::kUnified);
+  for (int i = 0; i < kNumBlocks; i++) {
+    block_ptrs[i] = voxels.data() + i * kNumVoxels;
+  }
+  block_ptrs[1] = nullptr;
+
+  // Sizes
+  unified_vector<int32_t> num_bytes(kNumBlocks, MemoryType::kUnified);
+  compressVoxelBlocksAsync<float, kNumVoxels>(block_ptrs.data(), kNumBlocks,
+                                               nullptr, num_bytes.data(),
+                                               nullptr, cuda_stream);
+  cuda_stream.synchronize();
+  constexpr int kNumMaskBytes = kNumVoxels / 8;
+  constexpr int kVoxelNumBytes = sizeof(float);
+  const int num_runs = (kNumVoxels + kRunLength - 1) / kRunLength;
+  EXPECT_EQ(num_bytes[0], kNumMaskBytes + num_runs * kVoxelNumBytes);
+  EXPECT_EQ(num_bytes[1], 0);
+  EXPECT_EQ(num_bytes[2], kNumMaskBytes + kNumVoxels * kVoxelNumBytes);
+  EXPECT_EQ(num_bytes[3], num_bytes[0]);
+
+  // Compression
+  unified_vector<int32_t> offsets(kNumBlocks + 1, MemoryType::kUnified);
+  offsets[0] = 0;
+  for (int i = 0; i < kNumBlocks; i++) {
+    offsets[i + 1] = offsets[i] + num_bytes[i];
+  }
+  unified_vector<uint8_t> compressed(offsets[kNumBlocks],
+                                     MemoryType::kUnified);
+  compressVoxelBlocksAsync<float, kNumVoxels>(block_ptrs.data(), kNumBlocks,
+                                               offsets.data(), nullptr,
+                                               compressed.data(), cuda_stream);
+  cuda_stream.synchronize();
+  for (int i = 0; i < kNumBlocks; i++) {
+    std::vector<float> decompressed(kNumVoxels);
+    const bool success = decompressVoxelBlock<float, kNumVoxels>(
+        compressed.data() + offsets[i], num_bytes[i], decompressed.data());
+    if (block_ptrs[i] == nullptr) {
+      EXPECT_FALSE(success);
+      continue;
+    }
+    ASSERT_TRUE(success);
+    for (int j = 0; j < kNumVoxels; j++) {
+      EXPECT_EQ(decompressed[j], block_ptrs[i][j]);
+    }
+  }
+
+  // Hashes
+  unified_vector<uint64_t> hashes(kNumBlocks, MemoryType::kUnified);
+  hashVoxelBlocksAsync<float, kNumVoxels>(block_ptrs.data(), kNumBlocks,
+                                           hashes.data(), cuda_stream);
+  cuda_stream.synchronize();
+  EXPECT_NE(hashes[0], 0ull);
+  EXPECT_EQ(hashes[1], 0ull);
+  EXPECT_NE(hashes[2], hashes[0]);
+  EXPECT_EQ(hashes[3], hashes[0]);
+
+  // A change in the last voxel changes the hash.
+  voxels[4 * kNumVoxels - 1] += 1.0f;
+  hashVoxelBlocksAsync<float, kNumVoxels>(block_ptrs.data(), kNumBlocks,
+                                           hashes.data(), cuda_stream);
+  cuda_stream.synchronize();
+  EXPECT_NE(hashes[3], hashes[0]);
+}
+
+int main(int argc, char** argv) {
+  FLAGS_alsologtostderr = true;
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -13,10 +13,14 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License.
 */
+#include <algorithm>
+
 #include <gflags/gflags.h>
 #include <gtest/gtest.h>
 
+#include "nvblox/geometry/bounding_boxes.h"
 #include "nvblox/integrators/projective_tsdf_integrator.h"
+#include "nvblox/integrators/view_calculator.h"
 #include "nvblox/tests/integrator_utils.h"
 
 using namespace nvblox;
@@ -118,6 +122,79 @@ TEST_F(WorkspaceBoundsTest, CheckAllocatedBlocks) {
   EXPECT_GT(num_blocks_unbounded, num_blocks_bounding_box);
 }
 
+TEST_F(WorkspaceBoundsTest, RaycastBlocksWithinWorkspace) {
+  constexpr float kBlockSize = 0.4f;
+  constexpr float kMaxIntegrationDistanceM = 10.0f;
+  constexpr float kTruncationDistanceM = 0.2f;
+
+  // A plane in front of the camera.
+  const test_utils::Plane plane = test_utils::Plane(
+      Vector3f(0.0f, 0.0f, 5.0f), Vector3f(0.0f, 0.0f, -1.0f));
+  const DepthImage depth_frame = test_utils::getDepthImage(plane, camera_);
+
+  auto get_blocks = [&](const WorkspaceBoundsType bounds_type) {
+    ViewCalculator view_calculator;
+    view_calculator.cache_last_viewpoint(false);
+    view_calculator.workspace_bounds_type(bounds_type);
+    // The box does not contain the camera, such that rays enter it.
+    view_calculator.workspace_bounds_min_corner_m(
+        Vector3f(-1.0f, -1.0f, 2.0f));
+    view_calculator.workspace_bounds_max_corner_m(Vector3f(1.0f, 1.0f, 4.0f));
+    std::vector<Index3D> blocks = view_calculator.getBlocksInImageViewRaycast(
+        depth_frame, Transform::Identity(), camera_, kBlockSize,
+        kTruncationDistanceM, kMaxIntegrationDistanceM);
+    std::sort(blocks.begin(), blocks.end(), VectorCompare<Index3D>());
+    return blocks;
+  };
+  const std::vector<Index3D> blocks_unbounded =
+      get_blocks(WorkspaceBoundsType::kUnbounded);
+  const std::vector<Index3D> blocks_bounded =
+      get_blocks(WorkspaceBoundsType::kBoundingBox);
+  ASSERT_GT(blocks_bounded.size(), 0);
+  EXPECT_LT(blocks_bounded.size(), blocks_unbounded.size());
+
+  // All blocks touch the workspace and are also seen without bounds.
+  const Index3D min_index = getBlockIndexFromPositionInLayer(
+      kBlockSize, Vector3f(-1.0f, -1.0f, 2.0f));
+  const Index3D max_index = getBlockIndexFromPositionInLayer(
+      kBlockSize, Vector3f(1.0f, 1.0f, 4.0f));
+  for (const Index3D& block_index : blocks_bounded) {
+    EXPECT_TRUE((block_index.array() >= min_index.array()).all());
+    EXPECT_TRUE((block_index.array() <= max_index.array()).all());
+    EXPECT_TRUE(std::binary_search(blocks_unbounded.begin(),
+                                   blocks_unbounded.end(), block_index,
+                                   VectorCompare<Index3D>()));
+  }
+}
+
+TEST(WorkspaceBounds, MaxNumBlocksInWorkspace) {
+  constexpr float kBlockSize = 0.4f;
+  const Vector3f min_corner(-3.0f, -2.5f, 0.1f);
+  const Vector3f max_corner(3.0f, 4.0f, 2.0f);
+
+  // Only bounding boxes limit the number of blocks.
+  EXPECT_FALSE(getMaxNumBlocksInWorkspace(WorkspaceBoundsType::kUnbounded,
+                                          min_corner, max_corner, kBlockSize)
+                   .has_value());
+  EXPECT_FALSE(getMaxNumBlocksInWorkspace(WorkspaceBoundsType::kHeightBounds,
+                                          min_corner, max_corner, kBlockSize)
+                   .has_value());
+
+  const std::optional<size_t> num_blocks = getMaxNumBlocksInWorkspace(
+      WorkspaceBoundsType::kBoundingBox, min_corner, max_corner, kBlockSize);
+  ASSERT_TRUE(num_blocks.has_value());
+  EXPECT_EQ(num_blocks.value(),
+            getBlockIndicesTouchedByBoundingBox(
+                kBlockSize, AxisAlignedBoundingBox(min_corner, max_corner))
+                .size());
+
+  // Inverted bounds are empty.
+  EXPECT_EQ(getMaxNumBlocksInWorkspace(WorkspaceBoundsType::kBoundingBox,
+                                       max_corner, min_corner, kBlockSize)
+                .value(),
+            0);
+}
+
 int main(int argc, char** argv) {
   FLAGS_alsologtostderr = true;
   google::InitGoogleLogging(argv[0]);
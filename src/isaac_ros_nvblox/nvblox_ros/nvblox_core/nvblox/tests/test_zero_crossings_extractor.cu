@@ -116,6 +116,84 @@ TEST_F(ZeroCrossingsFromAboveSimplePlane, GPUTest) {
   }
 }
 
+TEST_F(ZeroCrossingsFromAboveSimplePlane, GPUTestWithinMinMaxZ) {
+  TsdfLayer tsdf_layer_host(voxel_size_m, MemoryType::kHost);
+  scene.generateLayerFromScene(1.0, &tsdf_layer_host);
+
+  Mapper mapper(voxel_size_m, MemoryType::kHost);
+  mapper.tsdf_layer().copyFrom(tsdf_layer_host);
+  const std::vector<Index3D> block_indices =
+      mapper.tsdf_layer().getAllBlockIndices();
+
+  auto cuda_stream = std::make_shared<CudaStreamOwning>();
+  TsdfZeroCrossingsExtractor tsdf_zero_crossings_extractor(cuda_stream);
+
+  // Range containing the plane
+  Pointcloud crossings(MemoryType::kDevice);
+  EXPECT_TRUE(tsdf_zero_crossings_extractor.computeZeroCrossingsFromAboveOnGPU(
+      mapper.tsdf_layer(), block_indices, -1.1f, -0.9f, &crossings));
+  EXPECT_EQ(crossings.size(), expected_num_crossings);
+
+  for (const auto& actual_crossing :
+       crossings.points().toVectorAsync(*cuda_stream)) {
+    EXPECT_TRUE(
+        IsContainedInVector(actual_crossing, expected_crossings_locations));
+  }
+
+  // Range excluding the plane
+  EXPECT_TRUE(tsdf_zero_crossings_extractor.computeZeroCrossingsFromAboveOnGPU(
+      mapper.tsdf_layer(), block_indices, -0.5f, 0.5f, &crossings));
+  EXPECT_EQ(crossings.size(), 0);
+
+  // No blocks
+  EXPECT_TRUE(tsdf_zero_crossings_extractor.computeZeroCrossingsFromAboveOnGPU(
+      mapper.tsdf_layer(), {}, -1.1f, -0.9f, &crossings));
+  EXPECT_EQ(crossings.size(), 0);
+}
+
+TEST_F(ZeroCrossingsFromAboveSimplePlane, GPUTestCache) {
+  TsdfLayer tsdf_layer_host(voxel_size_m, MemoryType::kHost);
+  scene.generateLayerFromScene(1.0, &tsdf_layer_host);
+
+  Mapper mapper(voxel_size_m, MemoryType::kHost);
+  mapper.tsdf_layer().copyFrom(tsdf_layer_host);
+  TsdfLayer& tsdf_layer = mapper.tsdf_layer();
+
+  auto cuda_stream = std::make_shared<CudaStreamOwning>();
+  TsdfZeroCrossingsExtractor tsdf_zero_crossings_extractor(cuda_stream);
+
+  // Build the cache from all blocks.
+  tsdf_zero_crossings_extractor.updateZeroCrossingsCacheOnGPU(
+      tsdf_layer, tsdf_layer.getAllBlockIndices());
+  EXPECT_EQ(tsdf_zero_crossings_extractor.numCachedBlocks(), 1);
+  Pointcloud crossings(MemoryType::kDevice);
+  EXPECT_TRUE(tsdf_zero_crossings_extractor.getCachedZeroCrossingsOnGPU(
+      -1.1f, -0.9f, &crossings));
+  EXPECT_EQ(crossings.size(), expected_num_crossings);
+  for (const auto& actual_crossing :
+       crossings.points().toVectorAsync(*cuda_stream)) {
+    EXPECT_TRUE(
+        IsContainedInVector(actual_crossing, expected_crossings_locations));
+  }
+  EXPECT_TRUE(tsdf_zero_crossings_extractor.getCachedZeroCrossingsOnGPU(
+      -0.5f, 0.5f, &crossings));
+  EXPECT_EQ(crossings.size(), 0);
+
+  // An update without changes keeps the crossings.
+  tsdf_zero_crossings_extractor.updateZeroCrossingsCacheOnGPU(tsdf_layer, {});
+  EXPECT_TRUE(tsdf_zero_crossings_extractor.getCachedZeroCrossingsOnGPU(
+      -1.1f, -0.9f, &crossings));
+  EXPECT_EQ(crossings.size(), expected_num_crossings);
+
+  // Removed blocks are evicted, even if not reported.
+  tsdf_layer.clear();
+  tsdf_zero_crossings_extractor.updateZeroCrossingsCacheOnGPU(tsdf_layer, {});
+  EXPECT_EQ(tsdf_zero_crossings_extractor.numCachedBlocks(), 0);
+  EXPECT_TRUE(tsdf_zero_crossings_extractor.getCachedZeroCrossingsOnGPU(
+      -1.1f, -0.9f, &crossings));
+  EXPECT_EQ(crossings.size(), 0);
+}
+
 class ZeroCrossingsFromAboveSimplePlaneAtBoundary : public ::testing::Test {
  protected:
   constexpr static float voxel_size_m = 0.1;
@@ -17,12 +17,16 @@
 
 #include <glog/logging.h>
 #include <nvblox/core/internal/warmup_cuda.h>
+#include <nvblox/core/memory_pool.h>
 
+#include <algorithm>
+#include <future>
 #include <memory>
 
 #include <rclcpp/rclcpp.hpp>
 
 #include "nvblox_ros/fuser_node.hpp"
+#include "nvblox_ros/launch_autotuning.hpp"
 
 using namespace std::chrono_literals;
 
@@ -34,11 +38,26 @@ int main(int argc, char * argv[])
   rclcpp::init(argc, argv);
 
   // Warmup CUDA so it doesn't affect our timings *as* much for the first
-  // CUDA call.
-  nvblox::warmupCuda();
+  // CUDA call. The CUDA context is created in the background, while the node parses its parameters
+  // and sets up its subscriptions.
+  std::future<void> cuda_warmup = nvblox::warmupCudaAsync();
 
   rclcpp::executors::SingleThreadedExecutor exec;
   std::shared_ptr<nvblox::FuserNode> node(new nvblox::FuserNode());
+  cuda_warmup.get();
+
+  // Keep device memory freed by the per-frame temporaries cached in CUDA's memory pool, such that
+  // steady-state frames don't allocate from the driver. Reserving the configured amount up front
+  // means that the first frames don't either.
+  nvblox::setDeviceMemoryPoolReleaseThreshold(nvblox::kKeepAllMemoryPoolReleaseThreshold);
+  const int device_memory_pool_reserve_mb = node->declare_parameter<int>(
+    nvblox::kDeviceMemoryPoolReserveMbParamDesc.name,
+    nvblox::kDeviceMemoryPoolReserveMbParamDesc.default_value);
+  nvblox::reserveDeviceMemoryPool(
+    static_cast<uint64_t>(std::max(device_memory_pool_reserve_mb, 0)) * 1024 * 1024);
+
+  // Select the fastest launch configurations for this GPU, from the cache or by tuning.
+  nvblox::configureLaunchAutotunerFromParams(node.get());
   exec.add_node(node);
   exec.spin_once();
 
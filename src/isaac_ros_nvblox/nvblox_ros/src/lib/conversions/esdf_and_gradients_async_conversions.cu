@@ -0,0 +1,316 @@
+// SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+// Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "nvblox_ros/conversions/esdf_and_gradients_async_conversions.hpp"
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <limits>
+
+#include <nvblox/map/internal/cuda/layer_to_3d_grid.cuh>
+
+namespace nvblox
+{
+namespace conversions
+{
+
+namespace
+{
+
+constexpr int kNumThreadsPerBlock = 256;
+constexpr int kNumGradientChannels = 4;
+
+// Converts ESDF voxels to signed distances in meters.
+struct EsdfVoxelToSignedDistanceFunctor
+{
+  float voxel_size_m;
+  float unobserved_value;
+
+  __device__ float operator()(const EsdfVoxel & voxel) const
+  {
+    if (!voxel.observed) {
+      return unobserved_value;
+    }
+    const float distance_m = voxel_size_m * sqrtf(voxel.squared_distance_vox);
+    return voxel.is_inside ? -distance_m : distance_m;
+  }
+};
+
+// Interleaves the distance and gradient of each cell, as in the message layout.
+// One thread per cell.
+__global__ void packDistancesAndGradientsKernel(
+  const float * distances, const Vector3f * gradients, const int num_cells,
+  float * packed)
+{
+  const int cell_idx = blockIdx.x * blockDim.x + threadIdx.x;
+  if (cell_idx >= num_cells) {
+    return;
+  }
+  float * packed_cell = packed + cell_idx * kNumGradientChannels;
+  packed_cell[0] = distances[cell_idx];
+  packed_cell[1] = gradients[cell_idx].x();
+  packed_cell[2] = gradients[cell_idx].y();
+  packed_cell[3] = gradients[cell_idx].z();
+}
+
+// Quantizes distances to kQuantizedEsdfDistanceScaleM and gradients to int8 normals. Gradients
+// are skipped if nullptr. One thread per cell.
+__global__ void quantizeEsdfKernel(
+  const float * distances, const Vector3f * gradients, const int num_cells,
+  const float unobserved_value, int16_t * quantized_distances, int8_t * quantized_gradients)
+{
+  const int cell_idx = blockIdx.x * blockDim.x + threadIdx.x;
+  if (cell_idx >= num_cells) {
+    return;
+  }
+  const float distance = distances[cell_idx];
+  const bool is_observed = distance != unobserved_value;
+  if (is_observed) {
+    constexpr float kMaxQuantizedDistance = 32767.F;
+    quantized_distances[cell_idx] = static_cast<int16_t>(
+      rintf(
+        fminf(
+          fmaxf(distance / kQuantizedEsdfDistanceScaleM, -kMaxQuantizedDistance),
+          kMaxQuantizedDistance)));
+  } else {
+    quantized_distances[cell_idx] = nvblox_msgs::msg::QuantizedEsdfGrid::UNOBSERVED_DISTANCE;
+  }
+  if (gradients == nullptr) {
+    return;
+  }
+  const Vector3f gradient = gradients[cell_idx];
+  const float norm = gradient.norm();
+  constexpr float kMaxQuantizedNormal = 127.F;
+  for (int i = 0; i < 3; i++) {
+    quantized_gradients[3 * cell_idx + i] = (is_observed && norm > 0.F) ?
+      static_cast<int8_t>(rintf(gradient[i] / norm * kMaxQuantizedNormal)) : 0;
+  }
+}
+
+}  // namespace
+
+void runLengthEncode(
+  const int16_t * values, size_t num_values, std::vector<int16_t> * run_values,
+  std::vector<uint16_t> * run_lengths)
+{
+  CHECK_NOTNULL(run_values);
+  CHECK_NOTNULL(run_lengths);
+  run_values->clear();
+  run_lengths->clear();
+  constexpr uint16_t kMaxRunLength = std::numeric_limits<uint16_t>::max();
+  for (size_t i = 0; i < num_values; i++) {
+    if (!run_values->empty() && run_values->back() == values[i] &&
+      run_lengths->back() < kMaxRunLength)
+    {
+      ++run_lengths->back();
+    } else {
+      run_values->push_back(values[i]);
+      run_lengths->push_back(1);
+    }
+  }
+}
+
+std::vector<int16_t> decodeQuantizedEsdfDistances(
+  const nvblox_msgs::msg::QuantizedEsdfGrid & grid_msg)
+{
+  if (grid_msg.distance_run_lengths.empty()) {
+    return grid_msg.distances;
+  }
+  CHECK_EQ(grid_msg.distance_run_lengths.size(), grid_msg.distances.size());
+  std::vector<int16_t> distances;
+  distances.reserve(
+    static_cast<size_t>(grid_msg.size_x) * grid_msg.size_y * grid_msg.size_z);
+  for (size_t i = 0; i < grid_msg.distances.size(); i++) {
+    distances.insert(distances.end(), grid_msg.distance_run_lengths[i], grid_msg.distances[i]);
+  }
+  return distances;
+}
+
+bool EsdfAndGradientsSnapshot::isReady() const
+{
+  return extracted_event_.isReady();
+}
+
+void EsdfAndGradientsSnapshot::fillResponse(
+  nvblox_msgs::srv::EsdfAndGradients::Response * response) const
+{
+  CHECK_NOTNULL(response);
+  if (format_.quantized) {
+    response->quantized_esdf_grid = toQuantizedEsdfGridMsg();
+  } else {
+    response->esdf_and_gradients = toMultiArrayMsg();
+  }
+  const Vector3f origin_m = min_index_.cast<float>() * voxel_size_m_;
+  response->origin_m.x = origin_m.x();
+  response->origin_m.y = origin_m.y();
+  response->origin_m.z = origin_m.z();
+  response->voxel_size_m = voxel_size_m_;
+  response->success = true;
+}
+
+std_msgs::msg::Float32MultiArray EsdfAndGradientsSnapshot::toMultiArrayMsg() const
+{
+  CHECK(!format_.quantized);
+  extracted_event_.synchronize();
+
+  std_msgs::msg::Float32MultiArray array_msg;
+  constexpr const char * kDimLabels[] = {"x", "y", "z"};
+  // Strides are the number of elements spanned by a step along a dimension, i.e. the product of
+  // this and all following sizes.
+  const int num_dims = num_channels_ > 1 ? 4 : 3;
+  array_msg.layout.dim.resize(num_dims);
+  for (int i = 0; i < 3; i++) {
+    array_msg.layout.dim[i].label = kDimLabels[i];
+    array_msg.layout.dim[i].size = aabb_size_[i];
+  }
+  if (num_dims == 4) {
+    array_msg.layout.dim[3].label = "channel";
+    array_msg.layout.dim[3].size = num_channels_;
+  }
+  uint32_t stride = 1;
+  for (int i = num_dims - 1; i >= 0; i--) {
+    stride *= array_msg.layout.dim[i].size;
+    array_msg.layout.dim[i].stride = stride;
+  }
+  // A single copy out of the pinned buffer.
+  array_msg.data.assign(data_.data(), data_.data() + data_.size());
+  return array_msg;
+}
+
+nvblox_msgs::msg::QuantizedEsdfGrid EsdfAndGradientsSnapshot::toQuantizedEsdfGridMsg() const
+{
+  CHECK(format_.quantized);
+  extracted_event_.synchronize();
+
+  nvblox_msgs::msg::QuantizedEsdfGrid grid_msg;
+  grid_msg.size_x = aabb_size_.x();
+  grid_msg.size_y = aabb_size_.y();
+  grid_msg.size_z = aabb_size_.z();
+  grid_msg.distance_scale_m = kQuantizedEsdfDistanceScaleM;
+  if (format_.run_length_encode) {
+    runLengthEncode(
+      quantized_distances_.data(), quantized_distances_.size(), &grid_msg.distances,
+      &grid_msg.distance_run_lengths);
+  } else {
+    grid_msg.distances.assign(
+      quantized_distances_.data(), quantized_distances_.data() + quantized_distances_.size());
+  }
+  grid_msg.gradients.assign(
+    quantized_gradients_.data(), quantized_gradients_.data() + quantized_gradients_.size());
+  return grid_msg;
+}
+
+AsyncEsdfAndGradientsConverter::AsyncEsdfAndGradientsConverter()
+: distance_grid_(MemoryType::kDevice), gradient_grid_(MemoryType::kDevice) {}
+
+std::shared_ptr<const EsdfAndGradientsSnapshot> AsyncEsdfAndGradientsConverter::extractAsync(
+  const EsdfLayer & esdf_layer, const float default_value,
+  const nvblox_msgs::srv::EsdfAndGradients::Request & request,
+  const CudaStream & cuda_stream)
+{
+  EsdfAndGradientsFormat format;
+  format.quantized = request.quantized_response;
+  format.run_length_encode = request.run_length_encode;
+  if (!request.use_aabb) {
+    return extractAsync(
+      esdf_layer, getAABBOfAllocatedBlocks(esdf_layer), default_value, cuda_stream, format);
+  }
+  const Vector3f aabb_min_m(request.aabb_min_m.x, request.aabb_min_m.y, request.aabb_min_m.z);
+  const Vector3f aabb_size_m(
+    request.aabb_size_m.x, request.aabb_size_m.y, request.aabb_size_m.z);
+  return extractAsync(
+    esdf_layer, AxisAlignedBoundingBox(aabb_min_m, aabb_min_m + aabb_size_m), default_value,
+    cuda_stream, format);
+}
+
+std::shared_ptr<const EsdfAndGradientsSnapshot> AsyncEsdfAndGradientsConverter::extractAsync(
+  const EsdfLayer & esdf_layer, const AxisAlignedBoundingBox & aabb,
+  const float default_value, const CudaStream & cuda_stream,
+  const EsdfAndGradientsFormat & format)
+{
+  if (aabb.isEmpty()) {
+    return nullptr;
+  }
+
+  // Gather the AABB into a dense grid.
+  const EsdfVoxelToSignedDistanceFunctor conversion_op{esdf_layer.voxel_size(), default_value};
+  voxelLayerToDenseVoxelGridInAABBAsync(
+    esdf_layer, aabb, default_value, conversion_op, &distance_grid_, cuda_stream);
+
+  std::shared_ptr<EsdfAndGradientsSnapshot> snapshot = getFreeSnapshot();
+  snapshot->min_index_ = distance_grid_.min_index();
+  snapshot->aabb_size_ = distance_grid_.aabb_size();
+  snapshot->voxel_size_m_ = esdf_layer.voxel_size();
+  snapshot->format_ = format;
+
+  const int num_cells = distance_grid_.data().size();
+  const int num_thread_blocks = (num_cells + kNumThreadsPerBlock - 1) / kNumThreadsPerBlock;
+  if (include_gradients_) {
+    denseGridGradientsAsync(
+      distance_grid_, esdf_layer.voxel_size(), default_value, &gradient_grid_, cuda_stream);
+  }
+
+  if (format.quantized) {
+    quantized_distances_.resizeAsync(num_cells, cuda_stream);
+    quantized_gradients_.resizeAsync(include_gradients_ ? 3 * num_cells : 0, cuda_stream);
+    quantizeEsdfKernel<<<num_thread_blocks, kNumThreadsPerBlock, 0, cuda_stream>>>(
+      distance_grid_.data().data(), include_gradients_ ? gradient_grid_.data().data() : nullptr,
+      num_cells, default_value, quantized_distances_.data(), quantized_gradients_.data());
+    checkCudaErrors(cudaPeekAtLastError());
+    snapshot->quantized_distances_.copyFromAsync(quantized_distances_, cuda_stream);
+    snapshot->quantized_gradients_.copyFromAsync(quantized_gradients_, cuda_stream);
+  } else if (include_gradients_) {
+    packed_grid_.resizeAsync(num_cells * kNumGradientChannels, cuda_stream);
+    packDistancesAndGradientsKernel<<<num_thread_blocks, kNumThreadsPerBlock, 0, cuda_stream>>>(
+      distance_grid_.data().data(), gradient_grid_.data().data(), num_cells,
+      packed_grid_.data());
+    checkCudaErrors(cudaPeekAtLastError());
+    snapshot->num_channels_ = kNumGradientChannels;
+    snapshot->data_.copyFromAsync(packed_grid_, cuda_stream);
+  } else {
+    snapshot->num_channels_ = 1;
+    snapshot->data_.copyFromAsync(distance_grid_.data(), cuda_stream);
+  }
+  snapshot->extracted_event_.record(cuda_stream);
+  return snapshot;
+}
+
+bool AsyncEsdfAndGradientsConverter::include_gradients() const
+{
+  return include_gradients_;
+}
+
+void AsyncEsdfAndGradientsConverter::include_gradients(bool include_gradients)
+{
+  include_gradients_ = include_gradients;
+}
+
+std::shared_ptr<EsdfAndGradientsSnapshot> AsyncEsdfAndGradientsConverter::getFreeSnapshot()
+{
+  for (const auto & snapshot : snapshots_) {
+    // Not referenced by a pending response anymore, and not being copied into.
+    if (snapshot.use_count() == 1 && snapshot->isReady()) {
+      return snapshot;
+    }
+  }
+  snapshots_.push_back(std::make_shared<EsdfAndGradientsSnapshot>());
+  return snapshots_.back();
+}
+
+}  // namespace conversions
+}  // namespace nvblox
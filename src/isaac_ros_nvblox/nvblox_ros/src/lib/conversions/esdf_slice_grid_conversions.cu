@@ -0,0 +1,593 @@
+// SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+// Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+#include "nvblox_ros/conversions/esdf_slice_grid_conversions.hpp"
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <climits>
+#include <limits>
+
+#include <nvblox/gpu_hash/internal/cuda/gpu_indexing.cuh>
+
+namespace nvblox
+{
+namespace conversions
+{
+
+namespace
+{
+
+constexpr int kNumThreadsPerBlock = 256;
+constexpr int kNumWindowElements = 4;
+constexpr int kMaxNumSlices = EsdfSliceGridConverter::kMaxNumSlices;
+
+static_assert(
+  kNumThreadsPerBlock >= kMaxNumSlices,
+  "The window of each slice is initialized and merged by a thread of the block.");
+
+// Input images of convertSliceImages(). Skipped slices are nullptr.
+struct SliceImagePointers
+{
+  const float * slice_images[kMaxNumSlices];
+};
+
+// Outputs of the slices written by a single launch. Pointers of skipped slices are nullptr.
+struct SliceGridOutputs
+{
+  int8_t * occupancy_grids[kMaxNumSlices];
+  // Hold the previous distances on input, which are compared to if requested.
+  float * distances[kMaxNumSlices];
+  // Optional device copies of the slices.
+  float * slice_images[kMaxNumSlices];
+  bool compare_to_previous[kMaxNumSlices];
+  float unknown_values[kMaxNumSlices];
+};
+
+__device__ inline int8_t occupancyCostFromDistance(
+  const float distance, const float unknown_value,
+  const float occupied_distance_m, const float free_distance_m)
+{
+  if (distance == unknown_value) {
+    return kOccupancyGridUnknownCost;
+  }
+  if (distance <= occupied_distance_m) {
+    return kOccupancyGridOccupiedCost;
+  }
+  if (distance >= free_distance_m) {
+    return kOccupancyGridFreeCost;
+  }
+  // Linear decay between the occupied and the free distance. Only cells at the occupied distance
+  // are lethal.
+  const float fraction = (free_distance_m - distance) / (free_distance_m - occupied_distance_m);
+  return static_cast<int8_t>(
+    fminf(fraction * kOccupancyGridOccupiedCost, kOccupancyGridOccupiedCost - 1));
+}
+
+__device__ inline void initWindow(int * window)
+{
+  window[0] = INT_MAX;
+  window[1] = INT_MAX;
+  window[2] = -1;
+  window[3] = -1;
+}
+
+// Merge a window reduced by a thread block into the global window.
+__device__ inline void mergeWindow(const int * block_window, int * window)
+{
+  if (block_window[2] < 0) {
+    return;
+  }
+  atomicMin(&window[0], block_window[0]);
+  atomicMin(&window[1], block_window[1]);
+  atomicMax(&window[2], block_window[2]);
+  atomicMax(&window[3], block_window[3]);
+}
+
+// Write the distance of a cell of a slice, and extend the (shared) window of the thread block if
+// the cell changed.
+__device__ inline void writeSliceCell(
+  const SliceGridOutputs & outputs, const int slice_idx, const int cell_idx, const int cols,
+  const float distance, const float occupied_distance_m, const float free_distance_m,
+  int * block_window)
+{
+  float * distance_out = &outputs.distances[slice_idx][cell_idx];
+  if (outputs.compare_to_previous[slice_idx] && *distance_out != distance) {
+    const int row = cell_idx / cols;
+    const int col = cell_idx - row * cols;
+    atomicMin(&block_window[0], col);
+    atomicMin(&block_window[1], row);
+    atomicMax(&block_window[2], col);
+    atomicMax(&block_window[3], row);
+  }
+  *distance_out = distance;
+  outputs.occupancy_grids[slice_idx][cell_idx] = occupancyCostFromDistance(
+    distance, outputs.unknown_values[slice_idx], occupied_distance_m, free_distance_m);
+  if (outputs.slice_images[slice_idx] != nullptr) {
+    outputs.slice_images[slice_idx][cell_idx] = distance;
+  }
+}
+
+// One thread per cell (x) and slice (y). Changed cells are reduced to a window per thread block
+// in shared memory, before a single thread merges it into the global window.
+__global__ void sliceGridsKernel(
+  const SliceImagePointers inputs, const SliceGridOutputs outputs, const int num_cells,
+  const int cols, const float occupied_distance_m, const float free_distance_m,
+  int * changed_windows)
+{
+  const int cell_idx = blockIdx.x * blockDim.x + threadIdx.x;
+  const int slice_idx = blockIdx.y;
+  const float * slice_image = inputs.slice_images[slice_idx];
+  // Uniform across the thread block.
+  if (slice_image == nullptr) {
+    return;
+  }
+
+  __shared__ int block_window[kNumWindowElements];
+  const bool compare = outputs.compare_to_previous[slice_idx];
+  if (compare && threadIdx.x == 0) {
+    initWindow(block_window);
+  }
+  if (compare) {
+    __syncthreads();
+  }
+
+  if (cell_idx < num_cells) {
+    writeSliceCell(
+      outputs, slice_idx, cell_idx, cols, slice_image[cell_idx], occupied_distance_m,
+      free_distance_m, block_window);
+  }
+
+  if (compare) {
+    __syncthreads();
+    if (threadIdx.x == 0) {
+      mergeWindow(block_window, changed_windows + kNumWindowElements * slice_idx);
+    }
+  }
+}
+
+// The signed distance of the voxel at p_L. False if it's unallocated or unobserved.
+__device__ inline bool getSliceDistance(
+  const Index3DDeviceHashMapType<EsdfBlock> & block_hash, const Vector3f & p_L,
+  const float block_size, const float voxel_size, float * distance)
+{
+  EsdfVoxel * voxel = nullptr;
+  if (!getVoxelAtPosition<EsdfVoxel>(block_hash, p_L, block_size, &voxel) || !voxel->observed) {
+    return false;
+  }
+  *distance = voxel_size * sqrtf(voxel->squared_distance_vox);
+  if (voxel->is_inside) {
+    *distance = -*distance;
+  }
+  return true;
+}
+
+// One thread per cell, writing all enabled slice variants of the cell. Each layer is read once.
+// The pessimistic static slice only differs from the static slice in its unknown value, and the
+// combined slice is the minimum of the static and the dynamic slice. The cells are the voxels of
+// the static layer, the dynamic layer may be coarser.
+__global__ void sliceLayersToGridsKernel(
+  const Index3DDeviceHashMapType<EsdfBlock> static_block_hash,
+  const Index3DDeviceHashMapType<EsdfBlock> dynamic_block_hash,
+  const bool read_dynamic_layer, const Vector3f first_voxel_center,
+  const float static_slice_height, const float dynamic_slice_height, const float block_size,
+  const float voxel_size, const float dynamic_block_size, const float dynamic_voxel_size,
+  const int rows, const int cols, const SliceGridOutputs outputs,
+  const float occupied_distance_m, const float free_distance_m, int * changed_windows)
+{
+  __shared__ int block_windows[kMaxNumSlices][kNumWindowElements];
+  if (threadIdx.x < kMaxNumSlices) {
+    initWindow(block_windows[threadIdx.x]);
+  }
+  __syncthreads();
+
+  const int cell_idx = blockIdx.x * blockDim.x + threadIdx.x;
+  if (cell_idx < rows * cols) {
+    const int row = cell_idx / cols;
+    const int col = cell_idx - row * cols;
+    const float x = first_voxel_center.x() + voxel_size * col;
+    const float y = first_voxel_center.y() + voxel_size * row;
+
+    float static_distance = 0.0F;
+    const bool static_observed = getSliceDistance(
+      static_block_hash, Vector3f(x, y, static_slice_height), block_size, voxel_size,
+      &static_distance);
+    const float static_value = static_observed ?
+      static_distance : outputs.unknown_values[EsdfSliceGridConverter::kStaticSliceIdx];
+    if (outputs.distances[EsdfSliceGridConverter::kStaticSliceIdx] != nullptr) {
+      writeSliceCell(
+        outputs, EsdfSliceGridConverter::kStaticSliceIdx, cell_idx, cols, static_value,
+        occupied_distance_m, free_distance_m,
+        block_windows[EsdfSliceGridConverter::kStaticSliceIdx]);
+    }
+    if (outputs.distances[EsdfSliceGridConverter::kPessimisticStaticSliceIdx] != nullptr) {
+      const float pessimistic_value = static_observed ?
+        static_distance :
+        outputs.unknown_values[EsdfSliceGridConverter::kPessimisticStaticSliceIdx];
+      writeSliceCell(
+        outputs, EsdfSliceGridConverter::kPessimisticStaticSliceIdx, cell_idx, cols,
+        pessimistic_value, occupied_distance_m, free_distance_m,
+        block_windows[EsdfSliceGridConverter::kPessimisticStaticSliceIdx]);
+    }
+
+    if (read_dynamic_layer) {
+      float dynamic_value = outputs.unknown_values[EsdfSliceGridConverter::kDynamicSliceIdx];
+      getSliceDistance(
+        dynamic_block_hash, Vector3f(x, y, dynamic_slice_height), dynamic_block_size,
+        dynamic_voxel_size, &dynamic_value);
+      if (outputs.distances[EsdfSliceGridConverter::kDynamicSliceIdx] != nullptr) {
+        writeSliceCell(
+          outputs, EsdfSliceGridConverter::kDynamicSliceIdx, cell_idx, cols, dynamic_value,
+          occupied_distance_m, free_distance_m,
+          block_windows[EsdfSliceGridConverter::kDynamicSliceIdx]);
+      }
+      if (outputs.distances[EsdfSliceGridConverter::kCombinedSliceIdx] != nullptr) {
+        writeSliceCell(
+          outputs, EsdfSliceGridConverter::kCombinedSliceIdx, cell_idx, cols,
+          fminf(static_value, dynamic_value), occupied_distance_m, free_distance_m,
+          block_windows[EsdfSliceGridConverter::kCombinedSliceIdx]);
+      }
+    }
+  }
+
+  __syncthreads();
+  if (threadIdx.x < kMaxNumSlices && outputs.compare_to_previous[threadIdx.x]) {
+    mergeWindow(
+      block_windows[threadIdx.x], changed_windows + kNumWindowElements * threadIdx.x);
+  }
+}
+
+bool isSameAabb(const AxisAlignedBoundingBox & aabb_1, const AxisAlignedBoundingBox & aabb_2)
+{
+  return aabb_1.min() == aabb_2.min() && aabb_1.max() == aabb_2.max();
+}
+
+SliceGridOutputs emptyOutputs()
+{
+  SliceGridOutputs outputs;
+  for (int i = 0; i < kMaxNumSlices; i++) {
+    outputs.occupancy_grids[i] = nullptr;
+    outputs.distances[i] = nullptr;
+    outputs.slice_images[i] = nullptr;
+    outputs.compare_to_previous[i] = false;
+    outputs.unknown_values[i] = 0.0F;
+  }
+  return outputs;
+}
+
+}  // namespace
+
+EsdfSliceGridConverter::EsdfSliceGridConverter()
+: EsdfSliceGridConverter(std::make_shared<CudaStreamOwning>()) {}
+
+EsdfSliceGridConverter::EsdfSliceGridConverter(std::shared_ptr<CudaStream> cuda_stream)
+: cuda_stream_(cuda_stream) {}
+
+void EsdfSliceGridConverter::prepareOutputs(const int rows, const int cols)
+{
+  rows_ = rows;
+  cols_ = cols;
+  // Start with empty windows.
+  changed_windows_host_.resizeAsync(kNumWindowElements * kMaxNumSlices, *cuda_stream_);
+  for (int i = 0; i < kMaxNumSlices; i++) {
+    changed_windows_host_[kNumWindowElements * i + 0] = std::numeric_limits<int>::max();
+    changed_windows_host_[kNumWindowElements * i + 1] = std::numeric_limits<int>::max();
+    changed_windows_host_[kNumWindowElements * i + 2] = -1;
+    changed_windows_host_[kNumWindowElements * i + 3] = -1;
+  }
+  changed_windows_device_.copyFromAsync(changed_windows_host_, *cuda_stream_);
+}
+
+void EsdfSliceGridConverter::finishConversion(
+  const std::array<bool, kMaxNumSlices> & compared,
+  const std::array<AxisAlignedBoundingBox, kMaxNumSlices> & aabbs,
+  const std::array<float, kMaxNumSlices> & unknown_values)
+{
+  const int num_cells = rows_ * cols_;
+  if (num_cells > 0) {
+    changed_windows_host_.copyFromAsync(changed_windows_device_, *cuda_stream_);
+  }
+  cuda_stream_->synchronize();
+
+  // Slices which weren't compared changed everywhere.
+  for (int i = 0; i < kMaxNumSlices; i++) {
+    if (!has_slice_[i]) {
+      continue;
+    }
+    if (!compared[i] && num_cells > 0) {
+      changed_windows_host_[kNumWindowElements * i + 0] = 0;
+      changed_windows_host_[kNumWindowElements * i + 1] = 0;
+      changed_windows_host_[kNumWindowElements * i + 2] = cols_ - 1;
+      changed_windows_host_[kNumWindowElements * i + 3] = rows_ - 1;
+    }
+    has_previous_slice_[i] = true;
+    previous_aabbs_[i] = aabbs[i];
+    previous_unknown_values_[i] = unknown_values[i];
+  }
+}
+
+bool EsdfSliceGridConverter::convertSliceImages(
+  const Slices & slices,
+  const float unknown_value)
+{
+  // All slices have to share a size.
+  const Image<float> * first_slice = nullptr;
+  for (const Slice & slice : slices) {
+    if (slice.image == nullptr) {
+      continue;
+    }
+    if (first_slice == nullptr) {
+      first_slice = slice.image;
+    } else if (slice.image->rows() != first_slice->rows() ||
+      slice.image->cols() != first_slice->cols())
+    {
+      LOG(ERROR) << "Slice images converted together must have the same size.";
+      return false;
+    }
+  }
+  has_slice_.fill(false);
+  if (first_slice == nullptr) {
+    return true;
+  }
+  const bool same_size = first_slice->rows() == rows_ && first_slice->cols() == cols_;
+  prepareOutputs(first_slice->rows(), first_slice->cols());
+  const int num_cells = rows_ * cols_;
+
+  SliceImagePointers inputs;
+  SliceGridOutputs outputs = emptyOutputs();
+  std::array<bool, kMaxNumSlices> compared{};
+  std::array<AxisAlignedBoundingBox, kMaxNumSlices> aabbs;
+  std::array<float, kMaxNumSlices> unknown_values;
+  unknown_values.fill(unknown_value);
+  for (int i = 0; i < kMaxNumSlices; i++) {
+    inputs.slice_images[i] = nullptr;
+    outputs.unknown_values[i] = unknown_value;
+    if (slices[i].image == nullptr) {
+      continue;
+    }
+    occupancy_grids_host_[i].resizeAsync(num_cells, *cuda_stream_);
+    distances_host_[i].resizeAsync(num_cells, *cuda_stream_);
+    inputs.slice_images[i] = slices[i].image->dataConstPtr();
+    outputs.occupancy_grids[i] = occupancy_grids_host_[i].data();
+    outputs.distances[i] = distances_host_[i].data();
+    outputs.compare_to_previous[i] = has_previous_slice_[i] && same_size &&
+      previous_unknown_values_[i] == unknown_value &&
+      isSameAabb(previous_aabbs_[i], slices[i].aabb);
+    compared[i] = outputs.compare_to_previous[i];
+    aabbs[i] = slices[i].aabb;
+    has_slice_[i] = true;
+  }
+
+  if (num_cells > 0) {
+    // A single launch covering all slices.
+    const dim3 num_blocks(
+      (num_cells + kNumThreadsPerBlock - 1) / kNumThreadsPerBlock, kMaxNumSlices);
+    sliceGridsKernel<<<num_blocks, kNumThreadsPerBlock, 0, *cuda_stream_>>>(
+      inputs,                                            // NOLINT
+      outputs,                                           // NOLINT
+      num_cells,                                         // NOLINT
+      cols_,                                             // NOLINT
+      occupied_distance_m_,                              // NOLINT
+      std::max(free_distance_m_, occupied_distance_m_),  // NOLINT
+      changed_windows_device_.data());                   // NOLINT
+    checkCudaErrors(cudaPeekAtLastError());
+  }
+  finishConversion(compared, aabbs, unknown_values);
+  return true;
+}
+
+bool EsdfSliceGridConverter::convertLayers(
+  const LayerSlices & layer_slices,
+  const SliceImages & slice_images)
+{
+  CHECK_NOTNULL(layer_slices.static_layer);
+  const EsdfLayer & static_layer = *layer_slices.static_layer;
+  const bool has_dynamic_layer = layer_slices.dynamic_layer != nullptr;
+  if (has_dynamic_layer && layer_slices.dynamic_layer->voxel_size() < static_layer.voxel_size()) {
+    LOG(ERROR) << "The dynamic layer can't be finer than the static layer it's sliced with.";
+    return false;
+  }
+  std::array<bool, kMaxNumSlices> enabled = layer_slices.enabled;
+  if (!has_dynamic_layer) {
+    enabled[kDynamicSliceIdx] = false;
+    enabled[kCombinedSliceIdx] = false;
+  }
+  has_slice_.fill(false);
+  if (layer_slices.aabb.isEmpty() ||
+    std::none_of(enabled.begin(), enabled.end(), [](bool e) {return e;}))
+  {
+    return true;
+  }
+
+  // The slice covers the AABB, as in EsdfSlicer::sliceLayerToDistanceImage().
+  const float voxel_size = static_layer.voxel_size();
+  const Index2D image_size = EsdfSlicer::getSliceImageSize(layer_slices.aabb, voxel_size);
+  const int rows = image_size[0];
+  const int cols = image_size[1];
+  const bool same_size = rows == rows_ && cols == cols_;
+  prepareOutputs(rows, cols);
+  const int num_cells = rows_ * cols_;
+
+  SliceGridOutputs outputs = emptyOutputs();
+  std::array<bool, kMaxNumSlices> compared{};
+  std::array<AxisAlignedBoundingBox, kMaxNumSlices> aabbs;
+  std::array<float, kMaxNumSlices> unknown_values;
+  unknown_values.fill(layer_slices.unknown_value);
+  unknown_values[kPessimisticStaticSliceIdx] = layer_slices.pessimistic_unknown_value;
+  for (int i = 0; i < kMaxNumSlices; i++) {
+    outputs.unknown_values[i] = unknown_values[i];
+    if (!enabled[i]) {
+      continue;
+    }
+    occupancy_grids_host_[i].resizeAsync(num_cells, *cuda_stream_);
+    distances_host_[i].resizeAsync(num_cells, *cuda_stream_);
+    outputs.occupancy_grids[i] = occupancy_grids_host_[i].data();
+    outputs.distances[i] = distances_host_[i].data();
+    if (slice_images[i] != nullptr) {
+      Image<float> * slice_image = slice_images[i];
+      if (slice_image->rows() != rows_ || slice_image->cols() != cols_ ||
+        slice_image->memory_type() != MemoryType::kDevice)
+      {
+        *slice_image = Image<float>(rows_, cols_, MemoryType::kDevice);
+      }
+      outputs.slice_images[i] = slice_image->dataPtr();
+    }
+    outputs.compare_to_previous[i] = has_previous_slice_[i] && same_size &&
+      previous_unknown_values_[i] == unknown_values[i] &&
+      isSameAabb(previous_aabbs_[i], layer_slices.aabb);
+    compared[i] = outputs.compare_to_previous[i];
+    aabbs[i] = layer_slices.aabb;
+    has_slice_[i] = true;
+  }
+
+  if (num_cells > 0) {
+    const auto static_block_hash = static_layer.getGpuLayerView(*cuda_stream_).getHash().impl_;
+    const auto dynamic_block_hash = has_dynamic_layer ?
+      layer_slices.dynamic_layer->getGpuLayerView(*cuda_stream_).getHash().impl_ :
+      static_block_hash;
+    const EsdfLayer & dynamic_layer =
+      has_dynamic_layer ? *layer_slices.dynamic_layer : static_layer;
+    const Vector3f first_voxel_center =
+      layer_slices.aabb.min() + Vector3f::Constant(voxel_size / 2.0F);
+    // A single launch covering all slices.
+    const int num_blocks = (num_cells + kNumThreadsPerBlock - 1) / kNumThreadsPerBlock;
+    sliceLayersToGridsKernel<<<num_blocks, kNumThreadsPerBlock, 0, *cuda_stream_>>>(
+      static_block_hash,                                        // NOLINT
+      dynamic_block_hash,                                       // NOLINT
+      enabled[kDynamicSliceIdx] || enabled[kCombinedSliceIdx],  // NOLINT
+      first_voxel_center,                                       // NOLINT
+      layer_slices.static_slice_height,                         // NOLINT
+      layer_slices.dynamic_slice_height,                        // NOLINT
+      static_layer.block_size(),                                // NOLINT
+      voxel_size,                                               // NOLINT
+      dynamic_layer.block_size(),                               // NOLINT
+      dynamic_layer.voxel_size(),                               // NOLINT
+      rows_,                                                    // NOLINT
+      cols_,                                                    // NOLINT
+      outputs,                                                  // NOLINT
+      occupied_distance_m_,                                     // NOLINT
+      std::max(free_distance_m_, occupied_distance_m_),         // NOLINT
+      changed_windows_device_.data());                          // NOLINT
+    checkCudaErrors(cudaPeekAtLastError());
+  }
+  finishConversion(compared, aabbs, unknown_values);
+  return true;
+}
+
+bool EsdfSliceGridConverter::hasSlice(const int slice_idx) const
+{
+  CHECK_GE(slice_idx, 0);
+  CHECK_LT(slice_idx, kMaxNumSlices);
+  return has_slice_[slice_idx];
+}
+
+std::optional<EsdfSliceGridConverter::CellWindow> EsdfSliceGridConverter::changedCellWindow(
+  const int slice_idx) const
+{
+  if (!hasSlice(slice_idx)) {
+    return std::nullopt;
+  }
+  CellWindow window;
+  window.min_col = changed_windows_host_[kNumWindowElements * slice_idx + 0];
+  window.min_row = changed_windows_host_[kNumWindowElements * slice_idx + 1];
+  window.max_col = changed_windows_host_[kNumWindowElements * slice_idx + 2];
+  window.max_row = changed_windows_host_[kNumWindowElements * slice_idx + 3];
+  if (window.max_col < 0) {
+    return std::nullopt;
+  }
+  return window;
+}
+
+void EsdfSliceGridConverter::occupancyGridMsgDataFromSlice(
+  const int slice_idx, nav_msgs::msg::OccupancyGrid * occupancy_grid_msg) const
+{
+  CHECK_NOTNULL(occupancy_grid_msg);
+  CHECK(hasSlice(slice_idx));
+  const host_vector<int8_t> & grid = occupancy_grids_host_[slice_idx];
+  occupancy_grid_msg->info.width = cols_;
+  occupancy_grid_msg->info.height = rows_;
+  occupancy_grid_msg->data.assign(grid.data(), grid.data() + grid.size());
+}
+
+void EsdfSliceGridConverter::distanceMapSliceMsgDataFromSlice(
+  const int slice_idx, nvblox_msgs::msg::DistanceMapSlice * map_slice_msg) const
+{
+  CHECK_NOTNULL(map_slice_msg);
+  CHECK(hasSlice(slice_idx));
+  const host_vector<float> & distances = distances_host_[slice_idx];
+  map_slice_msg->width = cols_;
+  map_slice_msg->height = rows_;
+  map_slice_msg->data.assign(distances.data(), distances.data() + distances.size());
+}
+
+namespace
+{
+
+// Copy a window of a row-major buffer of cols columns into a (row-major) vector.
+template<typename T, typename VectorType>
+void copyWindow(
+  const T * data, const int cols, const EsdfSliceGridConverter::CellWindow & window,
+  VectorType * output)
+{
+  output->resize(static_cast<size_t>(window.width()) * window.height());
+  for (int row = window.min_row; row <= window.max_row; row++) {
+    const T * row_start = data + static_cast<size_t>(row) * cols + window.min_col;
+    std::copy(
+      row_start, row_start + window.width(),
+      output->begin() + static_cast<size_t>(row - window.min_row) * window.width());
+  }
+}
+
+}  // namespace
+
+void EsdfSliceGridConverter::occupancyGridUpdateMsgFromSlice(
+  const int slice_idx, const CellWindow & window,
+  map_msgs::msg::OccupancyGridUpdate * occupancy_grid_update_msg) const
+{
+  CHECK_NOTNULL(occupancy_grid_update_msg);
+  CHECK(hasSlice(slice_idx));
+  CHECK_GE(window.min_col, 0);
+  CHECK_GE(window.min_row, 0);
+  CHECK_LT(window.max_col, cols_);
+  CHECK_LT(window.max_row, rows_);
+  occupancy_grid_update_msg->x = window.min_col;
+  occupancy_grid_update_msg->y = window.min_row;
+  occupancy_grid_update_msg->width = window.width();
+  occupancy_grid_update_msg->height = window.height();
+  copyWindow(
+    occupancy_grids_host_[slice_idx].data(), cols_, window, &occupancy_grid_update_msg->data);
+}
+
+void EsdfSliceGridConverter::distanceMapSliceUpdateMsgFromSlice(
+  const int slice_idx, const CellWindow & window,
+  nvblox_msgs::msg::DistanceMapSliceUpdate * map_slice_update_msg) const
+{
+  CHECK_NOTNULL(map_slice_update_msg);
+  CHECK(hasSlice(slice_idx));
+  CHECK_GE(window.min_col, 0);
+  CHECK_GE(window.min_row, 0);
+  CHECK_LT(window.max_col, cols_);
+  CHECK_LT(window.max_row, rows_);
+  map_slice_update_msg->x = window.min_col;
+  map_slice_update_msg->y = window.min_row;
+  map_slice_update_msg->width = window.width();
+  map_slice_update_msg->height = window.height();
+  copyWindow(distances_host_[slice_idx].data(), cols_, window, &map_slice_update_msg->data);
+}
+
+}  // namespace conversions
+}  // namespace nvblox
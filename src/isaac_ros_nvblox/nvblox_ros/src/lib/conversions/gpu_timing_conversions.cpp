@@ -0,0 +1,80 @@
+// SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+// Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "nvblox_ros/conversions/gpu_timing_conversions.hpp"
+
+#include <glog/logging.h>
+
+#include <iomanip>
+#include <sstream>
+
+namespace nvblox
+{
+namespace conversions
+{
+
+namespace
+{
+
+void addValue(
+  const std::string & key, float value,
+  diagnostic_msgs::msg::DiagnosticStatus * status_msg)
+{
+  std::ostringstream stream;
+  stream << std::fixed << std::setprecision(3) << value;
+  diagnostic_msgs::msg::KeyValue key_value;
+  key_value.key = key;
+  key_value.value = stream.str();
+  status_msg->values.push_back(key_value);
+}
+
+}  // namespace
+
+void gpuTimingToDiagnosticStatusMsg(
+  const std::map<std::string, timing::GpuTimingStats> & stats, const std::string & name,
+  float p99_budget_ms, diagnostic_msgs::msg::DiagnosticStatus * status_msg)
+{
+  CHECK_NOTNULL(status_msg);
+  status_msg->name = name;
+  status_msg->hardware_id = "gpu";
+  status_msg->level = diagnostic_msgs::msg::DiagnosticStatus::OK;
+  status_msg->message = "OK";
+  status_msg->values.clear();
+
+  std::string over_budget_stages;
+  for (const auto & [tag, stage_stats] : stats) {
+    diagnostic_msgs::msg::KeyValue num_samples;
+    num_samples.key = tag + "/num_samples";
+    num_samples.value = std::to_string(stage_stats.num_samples);
+    status_msg->values.push_back(num_samples);
+    addValue(tag + "/mean_ms", stage_stats.mean_ms, status_msg);
+    addValue(tag + "/p50_ms", stage_stats.p50_ms, status_msg);
+    addValue(tag + "/p90_ms", stage_stats.p90_ms, status_msg);
+    addValue(tag + "/p99_ms", stage_stats.p99_ms, status_msg);
+    addValue(tag + "/max_ms", stage_stats.max_ms, status_msg);
+    if (p99_budget_ms > 0.0F && stage_stats.p99_ms > p99_budget_ms) {
+      over_budget_stages += (over_budget_stages.empty() ? "" : ", ") + tag;
+    }
+  }
+  if (!over_budget_stages.empty()) {
+    status_msg->level = diagnostic_msgs::msg::DiagnosticStatus::WARN;
+    status_msg->message = "GPU time above budget: " + over_budget_stages;
+  }
+}
+
+}  // namespace conversions
+}  // namespace nvblox
@@ -0,0 +1,102 @@
+// SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+// Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "nvblox_ros/conversions/memory_usage_conversions.hpp"
+
+#include <iomanip>
+#include <sstream>
+
+namespace nvblox
+{
+namespace conversions
+{
+
+namespace
+{
+
+constexpr float kBytesToMiB = 1.0F / (1024.F * 1024.F);
+
+void addValue(
+  const std::string & key, float value,
+  diagnostic_msgs::msg::DiagnosticStatus * status_msg)
+{
+  std::ostringstream stream;
+  stream << std::fixed << std::setprecision(2) << value;
+  diagnostic_msgs::msg::KeyValue key_value;
+  key_value.key = key;
+  key_value.value = stream.str();
+  status_msg->values.push_back(key_value);
+}
+
+void addMemoryUsage(
+  const std::string & prefix, const MemoryUsage & usage,
+  diagnostic_msgs::msg::DiagnosticStatus * status_msg)
+{
+  addValue(prefix + "_allocated_mb", usage.allocated_bytes * kBytesToMiB, status_msg);
+  addValue(prefix + "_used_mb", usage.used_bytes * kBytesToMiB, status_msg);
+}
+
+void addGpuHashStatistics(
+  const std::string & prefix, const GPUHashStatistics & statistics,
+  diagnostic_msgs::msg::DiagnosticStatus * status_msg)
+{
+  const float load_factor =
+    statistics.load_factor_history.empty() ? 0.F : statistics.load_factor_history.back();
+  addValue(prefix + "_load_factor", load_factor, status_msg);
+  addValue(prefix + "_peak_load_factor", statistics.peak_load_factor, status_msg);
+  addValue(
+    prefix + "_rehashes",
+    statistics.num_synchronous_rehashes + statistics.num_staged_rehashes, status_msg);
+  addValue(prefix + "_max_rehash_ms", statistics.max_rehash_seconds * 1000.F, status_msg);
+  addValue(prefix + "_mean_probe_length", statistics.meanProbeLength(), status_msg);
+}
+
+}  // namespace
+
+void memoryUsageToDiagnosticStatusMsg(
+  const MapperMemoryUsage & usage, const std::string & name, float pressure_watermark,
+  diagnostic_msgs::msg::DiagnosticStatus * status_msg)
+{
+  CHECK_NOTNULL(status_msg);
+  const float pressure = usage.devicePressure();
+  status_msg->name = name;
+  status_msg->hardware_id = "gpu";
+  if (pressure > pressure_watermark) {
+    status_msg->level = diagnostic_msgs::msg::DiagnosticStatus::WARN;
+    status_msg->message = "Device memory pressure above watermark";
+  } else {
+    status_msg->level = diagnostic_msgs::msg::DiagnosticStatus::OK;
+    status_msg->message = "OK";
+  }
+
+  status_msg->values.clear();
+  addValue("device_pressure", pressure, status_msg);
+  addValue("device_in_use_mb", usage.deviceBytesInUse() * kBytesToMiB, status_msg);
+  addValue("device_total_mb", usage.device_total_bytes * kBytesToMiB, status_msg);
+  for (const auto & [layer_name, layer_usage] : usage.layers) {
+    addMemoryUsage(layer_name + "_blocks", layer_usage.blocks, status_msg);
+    addMemoryUsage(layer_name + "_gpu_hash", layer_usage.gpu_hash, status_msg);
+    addGpuHashStatistics(layer_name + "_gpu_hash", layer_usage.gpu_hash_statistics, status_msg);
+    addValue(
+      layer_name + "_paged_out_mb", layer_usage.paged_out_bytes * kBytesToMiB, status_msg);
+  }
+  addMemoryUsage("scratch_arena", usage.scratch_arena, status_msg);
+  addMemoryUsage("device_memory_pool", usage.device_memory_pool, status_msg);
+}
+
+}  // namespace conversions
+}  // namespace nvblox
@@ -0,0 +1,240 @@
+// SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+// Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "nvblox_ros/conversions/pinned_image_conversions.hpp"
+
+#include <glog/logging.h>
+
+#include <cstring>
+
+namespace nvblox
+{
+namespace conversions
+{
+
+namespace
+{
+
+constexpr float kMillimetersToMeters = 1e-3F;
+constexpr int kNumThreadsPerBlock = 256;
+
+__device__ inline Rgba toRgba(const Rgb & rgb)
+{
+  return Rgba(rgb[0], rgb[1], rgb[2], 255);
+}
+
+__device__ inline Rgba toRgba(const Bgra & bgra)
+{
+  return Rgba(bgra[2], bgra[1], bgra[0], 255);
+}
+
+__device__ inline uint8_t clampToByte(const int value)
+{
+  return static_cast<uint8_t>(min(max(value, 0), 255));
+}
+
+// BT.601 limited range YUV -> RGB, in fixed point.
+__device__ inline Rgba yuvToRgba(const uint8_t y, const uint8_t u, const uint8_t v)
+{
+  const int c = 298 * (static_cast<int>(y) - 16);
+  const int d = static_cast<int>(u) - 128;
+  const int e = static_cast<int>(v) - 128;
+  return Rgba(
+    clampToByte((c + 409 * e + 128) >> 8),
+    clampToByte((c - 100 * d - 208 * e + 128) >> 8),
+    clampToByte((c + 516 * d + 128) >> 8), 255);
+}
+
+__global__ void depthFromMillimetersKernel(
+  const int16_t * depth_mm, const int num_pixels,
+  float * depth_m)
+{
+  const int pixel_idx = blockIdx.x * blockDim.x + threadIdx.x;
+  if (pixel_idx < num_pixels) {
+    depth_m[pixel_idx] = static_cast<float>(depth_mm[pixel_idx]) * kMillimetersToMeters;
+  }
+}
+
+template<typename T>
+__global__ void rgbaKernel(const T * input, const int num_pixels, Rgba * output)
+{
+  const int pixel_idx = blockIdx.x * blockDim.x + threadIdx.x;
+  if (pixel_idx < num_pixels) {
+    output[pixel_idx] = toRgba(input[pixel_idx]);
+  }
+}
+
+__global__ void rgbaFromNv12Kernel(
+  const uint8_t * nv12, const int height, const int width,
+  Rgba * output)
+{
+  const int pixel_idx = blockIdx.x * blockDim.x + threadIdx.x;
+  if (pixel_idx >= height * width) {
+    return;
+  }
+  const int row = pixel_idx / width;
+  const int col = pixel_idx % width;
+  const uint8_t * uv = nv12 + height * width + (row / 2) * width + (col / 2) * 2;
+  output[pixel_idx] = yuvToRgba(nv12[pixel_idx], uv[0], uv[1]);
+}
+
+__global__ void rgbaFromYuyvKernel(const uint8_t * yuyv, const int num_pixels, Rgba * output)
+{
+  const int pixel_idx = blockIdx.x * blockDim.x + threadIdx.x;
+  if (pixel_idx >= num_pixels) {
+    return;
+  }
+  const uint8_t * pair = yuyv + (pixel_idx / 2) * 4;
+  output[pixel_idx] = yuvToRgba(pair[(pixel_idx % 2) * 2], pair[1], pair[3]);
+}
+
+// Copy a host image into the pinned staging image, after waiting for the previous conversion
+// reading from it.
+template<typename T>
+bool stageInPinnedImage(
+  const T * ptr_host, const int height, const int width,
+  Image<T> * staging_image, const CudaStream & cuda_stream)
+{
+  CHECK_NOTNULL(ptr_host);
+  CHECK_NOTNULL(staging_image);
+  if (staging_image->memory_type() != MemoryType::kHost) {
+    LOG(ERROR) << "The staging image has to be in pinned host memory.";
+    return false;
+  }
+  cuda_stream.synchronize();
+  staging_image->resizeAsync(height, width, cuda_stream);
+  std::memcpy(
+    staging_image->dataPtr(), ptr_host,
+    static_cast<size_t>(height) * width * sizeof(T));
+  return true;
+}
+
+int numBlocks(const int num_pixels)
+{
+  return (num_pixels + kNumThreadsPerBlock - 1) / kNumThreadsPerBlock;
+}
+
+}  // namespace
+
+bool depthFromIntHostPinnedAsync(
+  const int16_t * ptr_host, const int height,
+  const int width, DepthImage * depth_image,
+  Image<int16_t> * staging_image,
+  const CudaStream & cuda_stream)
+{
+  CHECK_NOTNULL(depth_image);
+  if (!stageInPinnedImage(ptr_host, height, width, staging_image, cuda_stream)) {
+    return false;
+  }
+  depth_image->resizeAsync(height, width, cuda_stream);
+  const int num_pixels = height * width;
+  if (num_pixels == 0) {
+    return true;
+  }
+  depthFromMillimetersKernel<<<numBlocks(num_pixels), kNumThreadsPerBlock, 0, cuda_stream>>>(
+    staging_image->dataConstPtr(), num_pixels, depth_image->dataPtr());
+  checkCudaErrors(cudaPeekAtLastError());
+  return true;
+}
+
+template<typename T>
+bool rgbaFromHostPinnedAsync(
+  const T * ptr_host, const int height,
+  const int width, ColorImage * color_image,
+  Image<T> * staging_image,
+  const CudaStream & cuda_stream)
+{
+  CHECK_NOTNULL(color_image);
+  if (!stageInPinnedImage(ptr_host, height, width, staging_image, cuda_stream)) {
+    return false;
+  }
+  color_image->resizeAsync(height, width, cuda_stream);
+  const int num_pixels = height * width;
+  if (num_pixels == 0) {
+    return true;
+  }
+  rgbaKernel<T><<<numBlocks(num_pixels), kNumThreadsPerBlock, 0, cuda_stream>>>(
+    staging_image->dataConstPtr(), num_pixels, color_image->dataPtr());
+  checkCudaErrors(cudaPeekAtLastError());
+  return true;
+}
+
+bool rgbaFromNv12HostPinnedAsync(
+  const uint8_t * ptr_host, const int height,
+  const int width, ColorImage * color_image,
+  Image<uint8_t> * staging_image,
+  const CudaStream & cuda_stream)
+{
+  CHECK_NOTNULL(color_image);
+  if (height % 2 != 0 || width % 2 != 0) {
+    LOG(ERROR) << "NV12 images need an even size, got " << width << "x" << height;
+    return false;
+  }
+  // The Y plane and the UV plane, stacked.
+  if (!stageInPinnedImage(ptr_host, height * 3 / 2, width, staging_image, cuda_stream)) {
+    return false;
+  }
+  color_image->resizeAsync(height, width, cuda_stream);
+  const int num_pixels = height * width;
+  if (num_pixels == 0) {
+    return true;
+  }
+  rgbaFromNv12Kernel<<<numBlocks(num_pixels), kNumThreadsPerBlock, 0, cuda_stream>>>(
+    staging_image->dataConstPtr(), height, width, color_image->dataPtr());
+  checkCudaErrors(cudaPeekAtLastError());
+  return true;
+}
+
+bool rgbaFromYuyvHostPinnedAsync(
+  const uint8_t * ptr_host, const int height,
+  const int width, ColorImage * color_image,
+  Image<uint8_t> * staging_image,
+  const CudaStream & cuda_stream)
+{
+  CHECK_NOTNULL(color_image);
+  if (width % 2 != 0) {
+    LOG(ERROR) << "YUYV images need an even width, got " << width;
+    return false;
+  }
+  // Two bytes per pixel.
+  if (!stageInPinnedImage(ptr_host, height, width * 2, staging_image, cuda_stream)) {
+    return false;
+  }
+  color_image->resizeAsync(height, width, cuda_stream);
+  const int num_pixels = height * width;
+  if (num_pixels == 0) {
+    return true;
+  }
+  rgbaFromYuyvKernel<<<numBlocks(num_pixels), kNumThreadsPerBlock, 0, cuda_stream>>>(
+    staging_image->dataConstPtr(), num_pixels, color_image->dataPtr());
+  checkCudaErrors(cudaPeekAtLastError());
+  return true;
+}
+
+template bool rgbaFromHostPinnedAsync<Rgb>(
+  const Rgb * ptr_host, const int height,
+  const int width, ColorImage * color_image,
+  Image<Rgb> * staging_image,
+  const CudaStream & cuda_stream);
+template bool rgbaFromHostPinnedAsync<Bgra>(
+  const Bgra * ptr_host, const int height,
+  const int width, ColorImage * color_image,
+  Image<Bgra> * staging_image,
+  const CudaStream & cuda_stream);
+
+}  // namespace conversions
+}  // namespace nvblox
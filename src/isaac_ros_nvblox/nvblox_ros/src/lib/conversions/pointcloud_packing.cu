@@ -0,0 +1,177 @@
+// SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+// Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "nvblox_ros/conversions/pointcloud_packing.hpp"
+
+#include <glog/logging.h>
+
+#include <cub/device/device_select.cuh>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/iterator/transform_iterator.h>
+
+#include <cstring>
+
+namespace nvblox
+{
+namespace conversions
+{
+
+namespace
+{
+
+// Maps a slice cell (linear index) to a point at its center.
+struct SliceCellToPointFunctor
+{
+  const float * image;
+  int cols;
+  int stride_num_elements;
+  Vector3f first_cell_center;
+  float voxel_size;
+
+  __device__ PclPointXYZI operator()(const int cell_idx) const
+  {
+    const int row = cell_idx / cols;
+    const int col = cell_idx % cols;
+    PclPointXYZI point;
+    point.x = first_cell_center.x() + voxel_size * col;
+    point.y = first_cell_center.y() + voxel_size * row;
+    point.z = first_cell_center.z();
+    point.intensity = image[row * stride_num_elements + col];
+    return point;
+  }
+};
+
+struct IsObservedCellFunctor
+{
+  float unknown_value;
+
+  __device__ bool operator()(const PclPointXYZI & point) const
+  {
+    return point.intensity != unknown_value;
+  }
+};
+
+struct PointToPclPointFunctor
+{
+  const Vector3f * points;
+
+  __device__ PclPointXYZI operator()(const int point_idx) const
+  {
+    const Vector3f & p = points[point_idx];
+    return PclPointXYZI{p.x(), p.y(), p.z(), 0.F};
+  }
+};
+
+struct IsFinitePointFunctor
+{
+  __device__ bool operator()(const PclPointXYZI & point) const
+  {
+    return isfinite(point.x) && isfinite(point.y) && isfinite(point.z);
+  }
+};
+
+}  // namespace
+
+void setPclPointXYZIMsgLayout(int num_points, sensor_msgs::msg::PointCloud2 * pointcloud_msg)
+{
+  CHECK_NOTNULL(pointcloud_msg);
+  constexpr const char * kFieldNames[] = {"x", "y", "z", "intensity"};
+  pointcloud_msg->fields.resize(4);
+  for (size_t i = 0; i < pointcloud_msg->fields.size(); i++) {
+    pointcloud_msg->fields[i].name = kFieldNames[i];
+    pointcloud_msg->fields[i].offset = i * sizeof(float);
+    pointcloud_msg->fields[i].datatype = sensor_msgs::msg::PointField::FLOAT32;
+    pointcloud_msg->fields[i].count = 1;
+  }
+  pointcloud_msg->height = 1;
+  pointcloud_msg->width = num_points;
+  pointcloud_msg->is_bigendian = false;
+  pointcloud_msg->is_dense = true;
+  pointcloud_msg->point_step = sizeof(PclPointXYZI);
+  pointcloud_msg->row_step = pointcloud_msg->point_step * num_points;
+  pointcloud_msg->data.resize(pointcloud_msg->row_step);
+}
+
+GpuPointcloudPacker::GpuPointcloudPacker()
+: GpuPointcloudPacker(std::make_shared<CudaStreamOwning>()) {}
+
+GpuPointcloudPacker::GpuPointcloudPacker(std::shared_ptr<CudaStream> cuda_stream)
+: cuda_stream_(cuda_stream),
+  num_selected_host_(make_unified<int>(MemoryType::kHost)) {}
+
+template<typename InputIteratorType, typename SelectOpType>
+void GpuPointcloudPacker::selectToMsg(
+  InputIteratorType input_it, int num_items, SelectOpType select_op,
+  sensor_msgs::msg::PointCloud2 * pointcloud_msg)
+{
+  CHECK_NOTNULL(pointcloud_msg);
+  if (num_items == 0) {
+    setPclPointXYZIMsgLayout(0, pointcloud_msg);
+    return;
+  }
+  // Room for the case that all items are selected.
+  expandBuffersIfRequired(num_items, *cuda_stream_, &points_host_);
+  points_host_.resizeAsync(num_items, *cuda_stream_);
+
+  // The pinned buffers are written by the device directly.
+  size_t temp_storage_bytes = 0;
+  checkCudaErrors(
+    cub::DeviceSelect::If(
+      nullptr, temp_storage_bytes, input_it, points_host_.data(), num_selected_host_.get(),
+      num_items, select_op, *cuda_stream_));
+  expandBuffersIfRequired(temp_storage_bytes, *cuda_stream_, &select_temp_storage_);
+  select_temp_storage_.resizeAsync(temp_storage_bytes, *cuda_stream_);
+  checkCudaErrors(
+    cub::DeviceSelect::If(
+      select_temp_storage_.data(), temp_storage_bytes, input_it, points_host_.data(),
+      num_selected_host_.get(), num_items, select_op, *cuda_stream_));
+  cuda_stream_->synchronize();
+
+  const int num_points = *num_selected_host_;
+  setPclPointXYZIMsgLayout(num_points, pointcloud_msg);
+  std::memcpy(
+    pointcloud_msg->data.data(), points_host_.data(),
+    static_cast<size_t>(num_points) * sizeof(PclPointXYZI));
+}
+
+void GpuPointcloudPacker::pointcloudMsgFromSliceImage(
+  const Image<float> & slice_image, const AxisAlignedBoundingBox & aabb,
+  float slice_height, float voxel_size, float unknown_value,
+  sensor_msgs::msg::PointCloud2 * pointcloud_msg)
+{
+  // Cell centers as in EsdfSlicer.
+  const Vector3f first_cell_center(
+    aabb.min().x() + voxel_size / 2.F, aabb.min().y() + voxel_size / 2.F, slice_height);
+  const SliceCellToPointFunctor cell_to_point{slice_image.dataConstPtr(), slice_image.cols(),
+    slice_image.stride_num_elements(), first_cell_center, voxel_size};
+  selectToMsg(
+    thrust::make_transform_iterator(thrust::make_counting_iterator(0), cell_to_point),
+    slice_image.rows() * slice_image.cols(), IsObservedCellFunctor{unknown_value},
+    pointcloud_msg);
+}
+
+void GpuPointcloudPacker::pointcloudMsgFromPointcloud(
+  const Pointcloud & pointcloud, sensor_msgs::msg::PointCloud2 * pointcloud_msg)
+{
+  const PointToPclPointFunctor point_to_pcl_point{pointcloud.dataConstPtr()};
+  selectToMsg(
+    thrust::make_transform_iterator(thrust::make_counting_iterator(0), point_to_pcl_point),
+    pointcloud.num_points(), IsFinitePointFunctor(), pointcloud_msg);
+}
+
+}  // namespace conversions
+}  // namespace nvblox
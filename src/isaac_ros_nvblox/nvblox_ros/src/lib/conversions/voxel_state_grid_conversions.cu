@@ -0,0 +1,151 @@
+// SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+// Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+#include "nvblox_ros/conversions/voxel_state_grid_conversions.hpp"
+
+#include <glog/logging.h>
+
+#include <limits>
+
+#include <nvblox/map/internal/cuda/layer_to_3d_grid.cuh>
+
+namespace nvblox
+{
+namespace conversions
+{
+
+namespace
+{
+
+constexpr int kNumThreadsPerBlock = 256;
+constexpr float kUnknownDistance = std::numeric_limits<float>::max();
+
+// Converts ESDF voxels to signed distances in meters.
+struct EsdfVoxelToSignedDistanceFunctor
+{
+  float voxel_size_m;
+
+  __device__ float operator()(const EsdfVoxel & voxel) const
+  {
+    if (!voxel.observed) {
+      return kUnknownDistance;
+    }
+    const float distance_m = voxel_size_m * sqrtf(voxel.squared_distance_vox);
+    return voxel.is_inside ? -distance_m : distance_m;
+  }
+};
+
+// Packs the voxels of a column into the occupied and unknown bit words, and (optionally) copies
+// its distances into the message layout. The dense grid is indexed with z varying fastest, then
+// y, then x (see layerIndexToAabbLinearIndex()), the message columns with x varying fastest.
+// One thread per column.
+__global__ void packVoxelStateColumnsKernel(
+  const float * distances, const Index3D aabb_size, const float occupied_distance_m,
+  uint32_t * occupied_columns, uint32_t * unknown_columns, float * distances_out)
+{
+  const int column_idx = blockIdx.x * blockDim.x + threadIdx.x;
+  if (column_idx >= aabb_size.x() * aabb_size.y()) {
+    return;
+  }
+  const int y = column_idx / aabb_size.x();
+  const int x = column_idx - y * aabb_size.x();
+  const float * column = distances + (x * aabb_size.y() + y) * aabb_size.z();
+
+  uint32_t occupied_bits = 0;
+  uint32_t unknown_bits = 0;
+  for (int z = 0; z < aabb_size.z(); z++) {
+    const float distance = column[z];
+    if (distance == kUnknownDistance) {
+      unknown_bits |= 1U << z;
+    } else if (distance <= occupied_distance_m) {
+      occupied_bits |= 1U << z;
+    }
+    if (distances_out != nullptr) {
+      distances_out[column_idx * aabb_size.z() + z] = distance;
+    }
+  }
+  occupied_columns[column_idx] = occupied_bits;
+  unknown_columns[column_idx] = unknown_bits;
+}
+
+}  // namespace
+
+VoxelStateGridConverter::VoxelStateGridConverter()
+: VoxelStateGridConverter(std::make_shared<CudaStreamOwning>()) {}
+
+VoxelStateGridConverter::VoxelStateGridConverter(std::shared_ptr<CudaStream> cuda_stream)
+: cuda_stream_(cuda_stream), distance_grid_(MemoryType::kDevice) {}
+
+bool VoxelStateGridConverter::esdfLayerToVoxelStateGridMsg(
+  const EsdfLayer & esdf_layer, const AxisAlignedBoundingBox & aabb,
+  nvblox_msgs::msg::VoxelStateGrid * voxel_state_grid_msg)
+{
+  CHECK_NOTNULL(voxel_state_grid_msg);
+  if (aabb.isEmpty()) {
+    return false;
+  }
+
+  // Gather the AABB into a dense grid.
+  const EsdfVoxelToSignedDistanceFunctor conversion_op{esdf_layer.voxel_size()};
+  voxelLayerToDenseVoxelGridInAABBAsync(
+    esdf_layer, aabb, kUnknownDistance, conversion_op, &distance_grid_, *cuda_stream_);
+  const Index3D aabb_size = distance_grid_.aabb_size();
+  if (aabb_size.z() > kMaxSizeZ) {
+    LOG(ERROR) << "The voxel state grid can be at most " << kMaxSizeZ
+               << " voxels high. Requested: " << aabb_size.z();
+    return false;
+  }
+
+  // Pack the columns straight into the pinned buffers.
+  const int num_columns = aabb_size.x() * aabb_size.y();
+  const int num_voxels = num_columns * aabb_size.z();
+  occupied_columns_host_.resizeAsync(num_columns, *cuda_stream_);
+  unknown_columns_host_.resizeAsync(num_columns, *cuda_stream_);
+  distances_host_.resizeAsync(include_distances_ ? num_voxels : 0, *cuda_stream_);
+  if (num_columns > 0) {
+    const int num_thread_blocks = (num_columns + kNumThreadsPerBlock - 1) / kNumThreadsPerBlock;
+    packVoxelStateColumnsKernel<<<num_thread_blocks, kNumThreadsPerBlock, 0, *cuda_stream_>>>(
+      distance_grid_.data().data(),                            // NOLINT
+      aabb_size,                                               // NOLINT
+      occupied_distance_m_,                                    // NOLINT
+      occupied_columns_host_.data(),                           // NOLINT
+      unknown_columns_host_.data(),                            // NOLINT
+      include_distances_ ? distances_host_.data() : nullptr);  // NOLINT
+    checkCudaErrors(cudaPeekAtLastError());
+  }
+  cuda_stream_->synchronize();
+
+  const float voxel_size = esdf_layer.voxel_size();
+  const Vector3f origin = distance_grid_.min_index().cast<float>() * voxel_size;
+  voxel_state_grid_msg->resolution = voxel_size;
+  voxel_state_grid_msg->origin.x = origin.x();
+  voxel_state_grid_msg->origin.y = origin.y();
+  voxel_state_grid_msg->origin.z = origin.z();
+  voxel_state_grid_msg->size_x = aabb_size.x();
+  voxel_state_grid_msg->size_y = aabb_size.y();
+  voxel_state_grid_msg->size_z = aabb_size.z();
+  voxel_state_grid_msg->occupied_columns.assign(
+    occupied_columns_host_.data(), occupied_columns_host_.data() + num_columns);
+  voxel_state_grid_msg->unknown_columns.assign(
+    unknown_columns_host_.data(), unknown_columns_host_.data() + num_columns);
+  voxel_state_grid_msg->distances.assign(
+    distances_host_.data(), distances_host_.data() + distances_host_.size());
+  voxel_state_grid_msg->unknown_value = kUnknownDistance;
+  return true;
+}
+
+}  // namespace conversions
+}  // namespace nvblox
@@ -0,0 +1,429 @@
+// SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+// Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "nvblox_ros/indexed_rosbag_data_loader.hpp"
+
+#include <algorithm>
+#include <map>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+
+#include "glog/logging.h"
+#include "rclcpp/clock.hpp"
+#include "rclcpp/logging.hpp"
+#include "rosbag2_cpp/reader.hpp"
+#include "rosbag2_storage/storage_filter.hpp"
+#include "sensor_msgs/msg/camera_info.hpp"
+#include "sensor_msgs/msg/image.hpp"
+#include "tf2_msgs/msg/tf_message.hpp"
+#include "tf2_ros/buffer.h"
+
+#include "nvblox_ros/conversions/image_conversions.hpp"
+#include "nvblox_ros/rosbag_reading.hpp"
+
+namespace nvblox
+{
+namespace datasets
+{
+namespace ros
+{
+
+namespace
+{
+
+constexpr char kTfTopic[] = "/tf";
+
+// The messages of an indexed frame, as they are read from the bag.
+struct PendingFrame
+{
+  std::optional<sensor_msgs::msg::Image> depth;
+  std::optional<sensor_msgs::msg::CameraInfo> depth_camera_info;
+  std::optional<sensor_msgs::msg::Image> color;
+  std::optional<sensor_msgs::msg::CameraInfo> color_camera_info;
+
+  bool complete() const
+  {
+    return depth && depth_camera_info && color && color_camera_info;
+  }
+};
+
+int64_t secondsToNanoSeconds(float seconds)
+{
+  return static_cast<int64_t>(static_cast<double>(seconds) * 1e9);
+}
+
+}  // namespace
+
+std::unique_ptr<Fuser> createIndexedFuser(
+  const std::string & rosbag_path,               // NOLINT
+  const std::string & depth_topic,               // NOLINT
+  const std::string & depth_camera_info_topic,   // NOLINT
+  const std::string & color_topic,               // NOLINT
+  const std::string & color_camera_info_topic,   // NOLINT
+  const std::string & global_frame_id,           // NOLINT
+  const float tf_preload_time_s,                 // NOLINT
+  const int prefetch_queue_size,                 // NOLINT
+  std::shared_ptr<CudaStream> cuda_stream)
+{
+  auto data_loader = IndexedRosDataLoader::create(
+    rosbag_path, depth_topic, depth_camera_info_topic, color_topic, color_camera_info_topic,
+    global_frame_id, tf_preload_time_s, prefetch_queue_size, cuda_stream);
+  if (!data_loader) {
+    return std::unique_ptr<Fuser>();
+  }
+  constexpr bool kInitFromGflags = true;
+  return std::make_unique<Fuser>(std::move(data_loader), kInitFromGflags);
+}
+
+IndexedRosDataLoader::IndexedRosDataLoader(
+  const std::string & rosbag_path,                         // NOLINT
+  const std::string & depth_topic,                         // NOLINT
+  const std::string & depth_camera_info_topic,             // NOLINT
+  const std::string & color_topic,                         // NOLINT
+  const std::string & color_camera_info_topic,             // NOLINT
+  const std::string & global_frame_id,                     // NOLINT
+  const float tf_preload_time_s,                           // NOLINT
+  const int prefetch_queue_size,                           // NOLINT
+  std::shared_ptr<CudaStream> cuda_stream)
+: rosbag_path_(rosbag_path),
+  depth_topic_(depth_topic),
+  depth_camera_info_topic_(depth_camera_info_topic),
+  color_topic_(color_topic),
+  color_camera_info_topic_(color_camera_info_topic),
+  global_frame_id_(global_frame_id),
+  tf_lead_time_s_(tf_preload_time_s),
+  prefetch_queue_size_(std::max(prefetch_queue_size, 1)),
+  index_(RosbagFrameIndex::build(
+      rosbag_path, depth_topic, depth_camera_info_topic, color_topic,
+      color_camera_info_topic)),
+  ros_logger_(rclcpp::get_logger("indexed_ros_data_loader")),
+  cuda_stream_(cuda_stream)
+{
+  setup_success_ = !index_.empty();
+  if (setup_success_) {
+    startReader(0);
+  }
+}
+
+IndexedRosDataLoader::~IndexedRosDataLoader()
+{
+  stopReader();
+}
+
+std::unique_ptr<IndexedRosDataLoader> IndexedRosDataLoader::create(
+  const std::string & rosbag_path,               // NOLINT
+  const std::string & depth_topic,               // NOLINT
+  const std::string & depth_camera_info_topic,   // NOLINT
+  const std::string & color_topic,               // NOLINT
+  const std::string & color_camera_info_topic,   // NOLINT
+  const std::string & global_frame_id,           // NOLINT
+  const float tf_preload_time_s,                 // NOLINT
+  const int prefetch_queue_size,                 // NOLINT
+  std::shared_ptr<CudaStream> cuda_stream)
+{
+  auto data_loader = std::make_unique<IndexedRosDataLoader>(
+    rosbag_path, depth_topic, depth_camera_info_topic, color_topic, color_camera_info_topic,
+    global_frame_id, tf_preload_time_s, prefetch_queue_size, cuda_stream);
+  if (!data_loader->setup_success_) {
+    LOG(ERROR) << "No matching frames found in " << rosbag_path;
+    return std::unique_ptr<IndexedRosDataLoader>();
+  }
+  return data_loader;
+}
+
+DataLoadResult IndexedRosDataLoader::loadNext(
+  DepthImage * depth_frame_ptr,                       // NOLINT
+  Transform * T_L_C_ptr,                              // NOLINT
+  Camera * camera_ptr,                                // NOLINT
+  ColorImage * color_frame_ptr)
+{
+  // The depth camera stands in for the (same) color camera.
+  Transform T_L_C_unused;
+  Camera color_camera_unused;
+  return loadNext(
+    depth_frame_ptr, T_L_C_ptr, camera_ptr, color_frame_ptr, &T_L_C_unused,
+    &color_camera_unused);
+}
+
+DataLoadResult IndexedRosDataLoader::loadNext(
+  DepthImage * depth_frame_ptr,                       // NOLINT
+  Transform * T_L_D_ptr,                              // NOLINT
+  Camera * depth_camera_ptr,                          // NOLINT
+  ColorImage * color_frame_ptr,                       // NOLINT
+  Transform * T_L_C_ptr,                              // NOLINT
+  Camera * color_camera_ptr)
+{
+  CHECK_NOTNULL(depth_frame_ptr);
+  CHECK_NOTNULL(T_L_D_ptr);
+  CHECK_NOTNULL(depth_camera_ptr);
+  CHECK_NOTNULL(T_L_C_ptr);
+  CHECK_NOTNULL(color_camera_ptr);
+
+  std::unique_ptr<Frame> frame;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    queue_not_empty_.wait(lock, [this]() {return !ready_frames_.empty() || reader_finished_;});
+    if (ready_frames_.empty()) {
+      return DataLoadResult::kNoMoreData;
+    }
+    frame = std::move(ready_frames_.front());
+    ready_frames_.pop_front();
+  }
+  queue_not_full_.notify_one();
+
+  DataLoadResult result = DataLoadResult::kBadFrame;
+  if (frame->valid) {
+    // The frame is already on the GPU, so loading is a device to device copy.
+    depth_frame_ptr->copyFromAsync(frame->depth, *cuda_stream_);
+    if (color_frame_ptr != nullptr) {
+      color_frame_ptr->copyFromAsync(frame->color, *cuda_stream_);
+    }
+    *T_L_D_ptr = frame->T_L_D;
+    *T_L_C_ptr = frame->T_L_C;
+    *depth_camera_ptr = frame->depth_camera;
+    *color_camera_ptr = frame->color_camera;
+    cuda_stream_->synchronize();
+    result = DataLoadResult::kSuccess;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  recycled_frames_.push_back(std::move(frame));
+  return result;
+}
+
+bool IndexedRosDataLoader::seek(uint64_t stamp_ns)
+{
+  stopReader();
+  const size_t first_frame_index = index_.findFirstAtOrAfter(stamp_ns);
+  if (first_frame_index >= index_.size()) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    reader_finished_ = true;
+    return false;
+  }
+  startReader(first_frame_index);
+  return true;
+}
+
+void IndexedRosDataLoader::startReader(size_t first_frame_index)
+{
+  CHECK(!reader_thread_.joinable());
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    reader_finished_ = false;
+  }
+  stop_reader_ = false;
+  reader_thread_ = std::thread(&IndexedRosDataLoader::readerLoop, this, first_frame_index);
+}
+
+void IndexedRosDataLoader::stopReader()
+{
+  if (!reader_thread_.joinable()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_reader_ = true;
+  }
+  queue_not_full_.notify_all();
+  reader_thread_.join();
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto & frame : ready_frames_) {
+    recycled_frames_.push_back(std::move(frame));
+  }
+  ready_frames_.clear();
+}
+
+bool IndexedRosDataLoader::pushFrame(std::unique_ptr<Frame> frame)
+{
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    queue_not_full_.wait(
+      lock, [this]() {return ready_frames_.size() < prefetch_queue_size_ || stop_reader_;});
+    if (stop_reader_) {
+      recycled_frames_.push_back(std::move(frame));
+      return false;
+    }
+    ready_frames_.push_back(std::move(frame));
+  }
+  queue_not_empty_.notify_one();
+  return true;
+}
+
+std::unique_ptr<IndexedRosDataLoader::Frame> IndexedRosDataLoader::getEmptyFrame()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (recycled_frames_.empty()) {
+    return std::make_unique<Frame>();
+  }
+  std::unique_ptr<Frame> frame = std::move(recycled_frames_.back());
+  recycled_frames_.pop_back();
+  return frame;
+}
+
+void IndexedRosDataLoader::readerLoop(size_t first_frame_index)
+{
+  const std::vector<RosbagFrameIndexEntry> & entries = index_.entries();
+  const int64_t tf_lead_time_ns = secondsToNanoSeconds(tf_lead_time_s_);
+
+  // Lookup from the bag time of an indexed message to its frame, per stream.
+  std::unordered_map<int64_t, size_t> depth_frames;
+  std::unordered_map<int64_t, size_t> depth_camera_info_frames;
+  std::unordered_map<int64_t, size_t> color_frames;
+  std::unordered_map<int64_t, size_t> color_camera_info_frames;
+  for (size_t i = first_frame_index; i < entries.size(); i++) {
+    depth_frames.emplace(entries[i].depth_bag_time_ns, i);
+    depth_camera_info_frames.emplace(entries[i].depth_camera_info_bag_time_ns, i);
+    color_frames.emplace(entries[i].color_bag_time_ns, i);
+    color_camera_info_frames.emplace(entries[i].color_camera_info_bag_time_ns, i);
+  }
+  const auto find_frame =
+    [](const std::unordered_map<int64_t, size_t> & frames, int64_t bag_time_ns)
+    -> std::optional<size_t> {
+      const auto it = frames.find(bag_time_ns);
+      if (it == frames.end()) {
+        return std::nullopt;
+      }
+      return it->second;
+    };
+
+  // Each run of the reader has its own tf buffer such that seeking backwards works.
+  tf2_ros::Buffer tf_buffer(std::make_shared<rclcpp::Clock>());
+  loadAllTfStaticsIntoBuffer(rosbag_path_, &tf_buffer);
+  uint64_t latest_tf_stamp_ns = 0;
+
+  // Start reading early enough that the frame's messages and the tf leading up to it are read.
+  rosbag2_cpp::Reader reader;
+  reader.open(rosbag_path_);
+  rosbag2_storage::StorageFilter filter;
+  filter.topics = {depth_topic_, depth_camera_info_topic_, color_topic_, color_camera_info_topic_,
+    kTfTopic};
+  reader.set_filter(filter);
+  reader.seek(
+    std::max<int64_t>(entries[first_frame_index].earliestBagTimeNs() - tf_lead_time_ns, 0));
+
+  // Conversion scratch.
+  Image<int16_t> depth_image_conversion_scratch(MemoryType::kDevice);
+  Image<conversions::Bgra> bgra_image_conversion_scratch(MemoryType::kDevice);
+  Image<conversions::Rgb> rgb_image_conversion_scratch(MemoryType::kDevice);
+
+  // Converts and uploads a complete frame.
+  const auto convert_frame = [&](const PendingFrame & pending) {
+      std::unique_ptr<Frame> frame = getEmptyFrame();
+      frame->valid =
+        conversions::depthImageFromRosMessageAsync(
+        *pending.depth, &frame->depth, &depth_image_conversion_scratch, ros_logger_,
+        reader_cuda_stream_) &&
+        conversions::colorImageFromImageMessageAsync(
+        *pending.color, &frame->color, &rgb_image_conversion_scratch,
+        &bgra_image_conversion_scratch, ros_logger_, reader_cuda_stream_) &&
+        getTransformAtTime(
+        global_frame_id_, pending.depth->header.frame_id, pending.depth->header.stamp,
+        tf_buffer, &frame->T_L_D) &&
+        getTransformAtTime(
+        global_frame_id_, pending.color->header.frame_id, pending.color->header.stamp,
+        tf_buffer, &frame->T_L_C);
+      frame->depth_camera = conversions::cameraFromMessage(*pending.depth_camera_info);
+      frame->color_camera = conversions::cameraFromMessage(*pending.color_camera_info);
+      reader_cuda_stream_.synchronize();
+      return frame;
+    };
+
+  // Frames are returned in index order, once all their messages and the tf leading
+  // them have been read, or at the end of the bag.
+  std::map<size_t, PendingFrame> pending_frames;
+  size_t next_frame_index = first_frame_index;
+  const auto emit_ready_frames = [&](bool bag_finished) {
+      while (next_frame_index < entries.size()) {
+        const auto it = pending_frames.find(next_frame_index);
+        const bool complete = it != pending_frames.end() && it->second.complete();
+        if (!complete && !bag_finished) {
+          return true;
+        }
+        if (!complete) {
+          LOG(WARNING) << "Messages of the indexed frame at "
+                       << entries[next_frame_index].stamp_ns << "ns were not read.";
+          ++next_frame_index;
+          continue;
+        }
+        if (!bag_finished &&
+          latest_tf_stamp_ns < entries[next_frame_index].stamp_ns + tf_lead_time_ns)
+        {
+          return true;
+        }
+        if (!pushFrame(convert_frame(it->second))) {
+          return false;
+        }
+        pending_frames.erase(it);
+        ++next_frame_index;
+      }
+      return true;
+    };
+
+  bool stopped = false;
+  while (!stopped && !stop_reader_ && reader.has_next()) {
+    const auto msg = reader.read_next();
+    if (msg->topic_name == kTfTopic) {
+      const auto tf_msg = deserializeMessage<tf2_msgs::msg::TFMessage>(*msg);
+      for (const auto & transform : tf_msg.transforms) {
+        tf_buffer.setTransform(transform, "rosbag", false);
+      }
+      if (!tf_msg.transforms.empty()) {
+        latest_tf_stamp_ns = std::max(latest_tf_stamp_ns, toNanoSeconds(getLowestStamp(tf_msg)));
+      }
+    } else {
+      // NOTE: A topic may be used for more than one stream (e.g. a shared camera_info).
+      if (msg->topic_name == depth_topic_) {
+        if (const auto i = find_frame(depth_frames, msg->time_stamp)) {
+          pending_frames[*i].depth = deserializeMessage<sensor_msgs::msg::Image>(*msg);
+        }
+      }
+      if (msg->topic_name == depth_camera_info_topic_) {
+        if (const auto i = find_frame(depth_camera_info_frames, msg->time_stamp)) {
+          pending_frames[*i].depth_camera_info =
+            deserializeMessage<sensor_msgs::msg::CameraInfo>(*msg);
+        }
+      }
+      if (msg->topic_name == color_topic_) {
+        if (const auto i = find_frame(color_frames, msg->time_stamp)) {
+          pending_frames[*i].color = deserializeMessage<sensor_msgs::msg::Image>(*msg);
+        }
+      }
+      if (msg->topic_name == color_camera_info_topic_) {
+        if (const auto i = find_frame(color_camera_info_frames, msg->time_stamp)) {
+          pending_frames[*i].color_camera_info =
+            deserializeMessage<sensor_msgs::msg::CameraInfo>(*msg);
+        }
+      }
+    }
+    stopped = !emit_ready_frames(false);
+  }
+  if (!stopped && !stop_reader_) {
+    emit_ready_frames(true);
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    reader_finished_ = true;
+  }
+  queue_not_empty_.notify_all();
+}
+
+}  // namespace ros
+}  // namespace datasets
+}  // namespace nvblox
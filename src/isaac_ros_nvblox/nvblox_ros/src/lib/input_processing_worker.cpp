@@ -0,0 +1,83 @@
+// SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+// Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+#include "nvblox_ros/input_processing_worker.hpp"
+
+#include <utility>
+
+namespace nvblox
+{
+
+InputProcessingWorker::InputProcessingWorker(
+  ProcessFunction process_function, std::chrono::milliseconds fallback_period)
+: process_function_(std::move(process_function)),
+  fallback_period_(fallback_period),
+  thread_(&InputProcessingWorker::run, this) {}
+
+InputProcessingWorker::~InputProcessingWorker()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  notified_cv_.notify_all();
+  thread_.join();
+}
+
+void InputProcessingWorker::notify()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    notified_ = true;
+  }
+  notified_cv_.notify_one();
+}
+
+int64_t InputProcessingWorker::numPasses() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return num_passes_;
+}
+
+int64_t InputProcessingWorker::numFallbackPasses() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return num_fallback_passes_;
+}
+
+void InputProcessingWorker::run()
+{
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      const bool notified = notified_cv_.wait_for(
+        lock, fallback_period_, [this]() {return stop_ || notified_;});
+      if (stop_) {
+        return;
+      }
+      // Notifications from here on trigger another pass, as they may concern items which this
+      // pass already found not to be ready.
+      notified_ = false;
+      ++num_passes_;
+      if (!notified) {
+        ++num_fallback_passes_;
+      }
+    }
+    process_function_();
+  }
+}
+
+}  // namespace nvblox
@@ -0,0 +1,197 @@
+// SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+// Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+#include "nvblox_ros/input_rate_controller.hpp"
+
+#include <glog/logging.h>
+
+#include <nvblox/utils/timing.h>
+
+#include <algorithm>
+
+namespace nvblox
+{
+
+namespace
+{
+
+// Smoothing factors for the measured integration cost and frame periods.
+constexpr float kCostSmoothingFactor = 0.2F;
+constexpr float kPeriodSmoothingFactor = 0.1F;
+
+// Tolerance on the credit, such that e.g. three thirds make a frame.
+constexpr float kCreditEpsilon = 1e-4F;
+
+float smooth(float mean, float sample, float smoothing_factor)
+{
+  return mean > 0.F ? (1.F - smoothing_factor) * mean + smoothing_factor * sample : sample;
+}
+
+}  // namespace
+
+InputRateController::InputRateController(
+  const std::vector<std::string> & integration_timer_tags)
+{
+  CHECK(!integration_timer_tags.empty());
+  for (const std::string & tag : integration_timer_tags) {
+    timers_.push_back(TimerState{tag});
+  }
+}
+
+InputRateController::CameraId InputRateController::registerCamera(
+  const std::string & name,
+  float weight)
+{
+  CHECK_GT(weight, 0.F);
+  cameras_.push_back(CameraState{name, weight});
+  return static_cast<CameraId>(cameras_.size()) - 1;
+}
+
+bool InputRateController::shouldIntegrate(CameraId camera_id, int64_t stamp_ns)
+{
+  CHECK_GE(camera_id, 0);
+  CHECK_LT(camera_id, static_cast<CameraId>(cameras_.size()));
+  CameraState & camera = cameras_[camera_id];
+
+  // Measure the input rate. Out of order frames are not used for this.
+  if (camera.last_stamp_ns >= 0 && stamp_ns > camera.last_stamp_ns) {
+    const float period_s = static_cast<float>(stamp_ns - camera.last_stamp_ns) * 1e-9F;
+    camera.mean_period_s = smooth(camera.mean_period_s, period_s, kPeriodSmoothingFactor);
+  }
+  camera.last_stamp_ns = std::max(camera.last_stamp_ns, stamp_ns);
+
+  updateIntegrationCost();
+  updateAllowedRates();
+
+  // Integrate the fraction of the frames that fits in the allowed rate.
+  const float input_rate_hz = inputRateHz(camera_id);
+  const float fraction =
+    input_rate_hz > 0.F ? std::min(camera.allowed_rate_hz / input_rate_hz, 1.F) : 1.F;
+  const bool integrate = camera.credit >= 1.F - kCreditEpsilon;
+  if (integrate) {
+    camera.credit -= 1.F;
+  } else {
+    ++camera.num_skipped;
+    VLOG(3) << "Skipping a frame of " << camera.name << ". Input rate: " << input_rate_hz
+            << "Hz, allowed rate: " << camera.allowed_rate_hz << "Hz";
+  }
+  camera.credit += fraction;
+  return integrate;
+}
+
+float InputRateController::inputRateHz(CameraId camera_id) const
+{
+  CHECK_GE(camera_id, 0);
+  CHECK_LT(camera_id, static_cast<CameraId>(cameras_.size()));
+  const float mean_period_s = cameras_[camera_id].mean_period_s;
+  return mean_period_s > 0.F ? 1.F / mean_period_s : 0.F;
+}
+
+float InputRateController::allowedRateHz(CameraId camera_id) const
+{
+  CHECK_GE(camera_id, 0);
+  CHECK_LT(camera_id, static_cast<CameraId>(cameras_.size()));
+  return cameras_[camera_id].allowed_rate_hz;
+}
+
+int InputRateController::numSkipped(CameraId camera_id) const
+{
+  CHECK_GE(camera_id, 0);
+  CHECK_LT(camera_id, static_cast<CameraId>(cameras_.size()));
+  return cameras_[camera_id].num_skipped;
+}
+
+void InputRateController::target_utilization(float target_utilization)
+{
+  CHECK_GT(target_utilization, 0.F);
+  target_utilization_ = target_utilization;
+}
+
+void InputRateController::min_rate_hz(float min_rate_hz)
+{
+  CHECK_GE(min_rate_hz, 0.F);
+  min_rate_hz_ = min_rate_hz;
+}
+
+void InputRateController::updateIntegrationCost()
+{
+  // The cost of a frame is the sum of the mean costs of the samples added since the last update.
+  float cost_s = 0.F;
+  bool has_new_samples = false;
+  for (TimerState & timer : timers_) {
+    const size_t num_samples = timing::Timing::GetNumSamples(timer.tag);
+    if (num_samples <= timer.last_num_samples) {
+      continue;
+    }
+    const double total_s = timing::Timing::GetTotalSeconds(timer.tag);
+    cost_s += static_cast<float>(
+      (total_s - timer.last_total_s) / static_cast<double>(num_samples - timer.last_num_samples));
+    timer.last_total_s = total_s;
+    timer.last_num_samples = num_samples;
+    has_new_samples = true;
+  }
+  if (has_new_samples) {
+    integration_cost_s_ = smooth(integration_cost_s_, cost_s, kCostSmoothingFactor);
+  }
+}
+
+void InputRateController::updateAllowedRates()
+{
+  // Until we know what a frame costs, integrate everything.
+  std::vector<CameraState *> unsaturated;
+  for (CameraId i = 0; i < static_cast<CameraId>(cameras_.size()); i++) {
+    cameras_[i].allowed_rate_hz = inputRateHz(i);
+    if (integration_cost_s_ > 0.F && cameras_[i].allowed_rate_hz > 0.F) {
+      unsaturated.push_back(&cameras_[i]);
+    }
+  }
+  if (unsaturated.empty()) {
+    return;
+  }
+
+  // Share the budget in proportion to the weights. Cameras needing less than their share keep
+  // their input rate, and the rest is shared between the others.
+  float budget_hz = target_utilization_ / integration_cost_s_;
+  while (!unsaturated.empty()) {
+    float total_weight = 0.F;
+    for (const CameraState * camera : unsaturated) {
+      total_weight += camera->weight;
+    }
+    const float rate_per_weight_hz = std::max(budget_hz, 0.F) / total_weight;
+    const auto saturated_begin = std::partition(
+      unsaturated.begin(), unsaturated.end(), [rate_per_weight_hz](const CameraState * camera) {
+        return camera->allowed_rate_hz > camera->weight * rate_per_weight_hz;
+      });
+    if (saturated_begin == unsaturated.end()) {
+      for (CameraState * camera : unsaturated) {
+        camera->allowed_rate_hz = camera->weight * rate_per_weight_hz;
+      }
+      break;
+    }
+    for (auto it = saturated_begin; it != unsaturated.end(); ++it) {
+      budget_hz -= (*it)->allowed_rate_hz;
+    }
+    unsaturated.erase(saturated_begin, unsaturated.end());
+  }
+
+  // Never throttle a camera below the minimum rate.
+  for (CameraId i = 0; i < static_cast<CameraId>(cameras_.size()); i++) {
+    cameras_[i].allowed_rate_hz =
+      std::max(cameras_[i].allowed_rate_hz, std::min(min_rate_hz_, inputRateHz(i)));
+  }
+}
+
+}  // namespace nvblox
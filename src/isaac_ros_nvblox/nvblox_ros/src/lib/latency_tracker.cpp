@@ -0,0 +1,162 @@
+// SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+// Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "nvblox_ros/latency_tracker.hpp"
+
+#include <glog/logging.h>
+
+#include <nvblox/utils/delays.h>
+#include <nvblox/utils/flight_recorder.h>
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+namespace nvblox
+{
+
+namespace
+{
+
+constexpr float kNanoSecondsToMs = 1.0e-6F;
+constexpr double kSecondsPerNanoSecond = 1.0e-9;
+
+float toMs(Time time)
+{
+  return static_cast<float>(static_cast<int64_t>(time)) * kNanoSecondsToMs;
+}
+
+void addValue(
+  const std::string & key, float value,
+  diagnostic_msgs::msg::DiagnosticStatus * status_msg)
+{
+  std::ostringstream stream;
+  stream << std::fixed << std::setprecision(2) << value;
+  diagnostic_msgs::msg::KeyValue key_value;
+  key_value.key = key;
+  key_value.value = stream.str();
+  status_msg->values.push_back(key_value);
+}
+
+}  // namespace
+
+void LatencyTracker::inputReceived(const std::string & source, Time stamp, Time receive_time)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::map<Time, Time> & receive_times = receive_times_[source];
+  receive_times[stamp] = receive_time;
+  while (receive_times.size() > max_num_pending_inputs_) {
+    receive_times.erase(receive_times.begin());
+  }
+}
+
+void LatencyTracker::inputIntegrated(const std::string & source, Time stamp, Time integrate_time)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  // Inputs which were never received through a queue didn't wait.
+  Time receive_time = integrate_time;
+  auto source_it = receive_times_.find(source);
+  if (source_it != receive_times_.end()) {
+    std::map<Time, Time> & receive_times = source_it->second;
+    auto it = receive_times.find(stamp);
+    if (it != receive_times.end()) {
+      receive_time = it->second;
+    }
+    // Inputs up to this one have been integrated or dropped.
+    receive_times.erase(receive_times.begin(), receive_times.upper_bound(stamp));
+  }
+  timing::Delays::tick("ros/latency/" + source + "/queue_wait", receive_time, integrate_time);
+  timing::Delays::tick("ros/latency/" + source + "/integration", stamp, integrate_time);
+
+  // Inputs may be integrated out of order (e.g. from several queues). Keep the newest.
+  auto it = integrated_.find(source);
+  if (it == integrated_.end() || stamp >= it->second.stamp) {
+    integrated_[source] = IntegratedInput{stamp, integrate_time - receive_time};
+  }
+}
+
+void LatencyTracker::stageCompleted(const std::string & stage)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  stage_inputs_[stage] = integrated_;
+}
+
+std::vector<SourceLatency> LatencyTracker::outputPublished(
+  const std::string & output, const std::string & stage, Time publish_time)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  const IntegratedInputs * inputs = &integrated_;
+  if (!stage.empty()) {
+    auto it = stage_inputs_.find(stage);
+    if (it != stage_inputs_.end()) {
+      inputs = &it->second;
+    }
+  }
+  std::vector<SourceLatency> latencies;
+  latencies.reserve(inputs->size());
+  Time max_age(0);
+  for (const auto & [source, input] : *inputs) {
+    latencies.push_back(
+      SourceLatency{source, input.stamp, publish_time - input.stamp, input.queue_wait});
+    timing::Delays::tick(
+      "ros/latency/" + output + "/" + source + "/age", input.stamp, publish_time);
+    max_age = std::max(max_age, publish_time - input.stamp);
+  }
+  // Dumps a trace of the recent history if the output is late.
+  if (!latencies.empty()) {
+    timing::FlightRecorder::frameCompleted(
+      output, static_cast<double>(static_cast<int64_t>(max_age)) * kSecondsPerNanoSecond);
+  }
+  return latencies;
+}
+
+void LatencyTracker::max_num_pending_inputs(size_t max_num_pending_inputs)
+{
+  CHECK_GT(max_num_pending_inputs, 0u);
+  std::lock_guard<std::mutex> lock(mutex_);
+  max_num_pending_inputs_ = max_num_pending_inputs;
+}
+
+namespace conversions
+{
+
+void latencyToDiagnosticStatusMsg(
+  const std::string & output, const std::vector<SourceLatency> & latencies, float max_age_ms,
+  diagnostic_msgs::msg::DiagnosticStatus * status_msg)
+{
+  CHECK_NOTNULL(status_msg);
+  status_msg->name = output;
+  status_msg->hardware_id = "";
+  status_msg->level = diagnostic_msgs::msg::DiagnosticStatus::OK;
+  status_msg->message = "OK";
+  status_msg->values.clear();
+  std::string stale_sources;
+  for (const SourceLatency & latency : latencies) {
+    addValue(latency.source + "/age_ms", toMs(latency.age), status_msg);
+    addValue(latency.source + "/queue_wait_ms", toMs(latency.queue_wait), status_msg);
+    if (max_age_ms > 0.F && toMs(latency.age) > max_age_ms) {
+      stale_sources += (stale_sources.empty() ? "" : ", ") + latency.source;
+    }
+  }
+  if (!stale_sources.empty()) {
+    status_msg->level = diagnostic_msgs::msg::DiagnosticStatus::WARN;
+    status_msg->message = "Input age above maximum: " + stale_sources;
+  }
+}
+
+}  // namespace conversions
+}  // namespace nvblox
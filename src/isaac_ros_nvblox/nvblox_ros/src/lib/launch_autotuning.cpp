@@ -0,0 +1,41 @@
+// SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+// Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "nvblox_ros/launch_autotuning.hpp"
+
+#include <nvblox/core/launch_autotuner.h>
+
+#include <string>
+
+#include "nvblox_ros/node_params.hpp"
+
+namespace nvblox
+{
+
+void configureLaunchAutotunerFromParams(rclcpp::Node * node)
+{
+  LaunchAutotuner & launch_autotuner = LaunchAutotuner::getInstance();
+  launch_autotuner.setCacheFilePath(
+    node->declare_parameter<std::string>(
+      kLaunchAutotuningCachePathParamDesc.name,
+      kLaunchAutotuningCachePathParamDesc.default_value));
+  launch_autotuner.tuning_enabled(
+    node->declare_parameter<bool>(
+      kLaunchAutotuningParamDesc.name, kLaunchAutotuningParamDesc.default_value));
+}
+
+}  // namespace nvblox
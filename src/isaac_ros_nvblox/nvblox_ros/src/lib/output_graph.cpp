@@ -0,0 +1,104 @@
+// SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+// Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "nvblox_ros/output_graph.hpp"
+
+#include <utility>
+
+#include <glog/logging.h>
+
+namespace nvblox
+{
+
+OutputGraph::NodeId OutputGraph::addOutput(
+  const std::string & name, DemandFunction has_demand,
+  const std::vector<NodeId> & inputs)
+{
+  CHECK(has_demand) << "Output " << name << " needs a demand function.";
+  return addNode(name, std::move(has_demand), inputs);
+}
+
+OutputGraph::NodeId OutputGraph::addWork(
+  const std::string & name, const std::vector<NodeId> & inputs)
+{
+  return addNode(name, DemandFunction(), inputs);
+}
+
+OutputGraph::NodeId OutputGraph::addNode(
+  const std::string & name, DemandFunction has_demand,
+  const std::vector<NodeId> & inputs)
+{
+  // Inputs must exist already. This guarantees that inputs have smaller ids than their
+  // consumers, which update() relies upon.
+  for (const NodeId input : inputs) {
+    checkNodeId(input);
+  }
+  nodes_.push_back(Node{name, std::move(has_demand), inputs});
+  return static_cast<NodeId>(nodes_.size()) - 1;
+}
+
+void OutputGraph::requestForNextUpdate(NodeId node_id)
+{
+  checkNodeId(node_id);
+  nodes_[node_id].is_requested = true;
+}
+
+void OutputGraph::update()
+{
+  for (Node & node : nodes_) {
+    node.is_needed = false;
+  }
+  // Consumers have larger ids than their inputs, so walking the nodes backwards visits every
+  // consumer before its inputs.
+  for (auto node = nodes_.rbegin(); node != nodes_.rend(); ++node) {
+    node->is_needed |= node->is_requested || (node->has_demand && node->has_demand());
+    node->is_requested = false;
+    if (!node->is_needed) {
+      continue;
+    }
+    for (const NodeId input : node->inputs) {
+      nodes_[input].is_needed = true;
+    }
+  }
+  if (VLOG_IS_ON(3)) {
+    for (const Node & node : nodes_) {
+      if (!node.is_needed) {
+        VLOG(3) << "Skipping " << node.name << ", it has no consumers.";
+      }
+    }
+  }
+}
+
+bool OutputGraph::isNeeded(NodeId node_id) const
+{
+  checkNodeId(node_id);
+  return nodes_[node_id].is_needed;
+}
+
+const std::string & OutputGraph::name(NodeId node_id) const
+{
+  checkNodeId(node_id);
+  return nodes_[node_id].name;
+}
+
+void OutputGraph::checkNodeId(NodeId node_id) const
+{
+  CHECK_GE(node_id, 0);
+  CHECK_LT(node_id, static_cast<NodeId>(nodes_.size()));
+}
+
+}  // namespace nvblox
@@ -0,0 +1,225 @@
+// SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+// Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "nvblox_ros/rosbag_frame_index.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+#include "glog/logging.h"
+#include "rosbag2_cpp/reader.hpp"
+#include "rosbag2_storage/storage_filter.hpp"
+
+namespace nvblox
+{
+namespace datasets
+{
+namespace ros
+{
+
+namespace
+{
+
+// CDR encapsulation identifiers (second byte of the encapsulation header).
+constexpr uint8_t kCdrBigEndian = 0x00;
+constexpr uint8_t kCdrLittleEndian = 0x01;
+constexpr size_t kEncapsulationHeaderSize = 4;
+
+bool isHostLittleEndian()
+{
+  const uint16_t value = 1;
+  uint8_t first_byte;
+  std::memcpy(&first_byte, &value, 1);
+  return first_byte == 1;
+}
+
+uint32_t readUint32(const uint8_t * data, bool little_endian)
+{
+  uint32_t value;
+  std::memcpy(&value, data, sizeof(value));
+  if (little_endian != isHostLittleEndian()) {
+    value = ((value & 0x000000FFU) << 24) | ((value & 0x0000FF00U) << 8) |
+      ((value & 0x00FF0000U) >> 8) | ((value & 0xFF000000U) >> 24);
+  }
+  return value;
+}
+
+// Sort by stamp (then bag time) and drop all but the first recorded message of each stamp.
+std::vector<StampedBagMessage> sortedUnique(std::vector<StampedBagMessage> msgs)
+{
+  std::sort(
+    msgs.begin(), msgs.end(), [](const StampedBagMessage & a, const StampedBagMessage & b) {
+      return a.stamp_ns < b.stamp_ns ||
+      (a.stamp_ns == b.stamp_ns && a.bag_time_ns < b.bag_time_ns);
+    });
+  msgs.erase(
+    std::unique(
+      msgs.begin(), msgs.end(),
+      [](const StampedBagMessage & a, const StampedBagMessage & b) {
+        return a.stamp_ns == b.stamp_ns;
+      }),
+    msgs.end());
+  return msgs;
+}
+
+}  // namespace
+
+std::optional<uint64_t> peekHeaderStampNs(const uint8_t * data, size_t size_bytes)
+{
+  constexpr size_t kStampEnd = kEncapsulationHeaderSize + 2 * sizeof(uint32_t);
+  if (data == nullptr || size_bytes < kStampEnd || data[0] != 0x00 ||
+    (data[1] != kCdrBigEndian && data[1] != kCdrLittleEndian))
+  {
+    return std::nullopt;
+  }
+  const bool little_endian = data[1] == kCdrLittleEndian;
+  const int32_t sec =
+    static_cast<int32_t>(readUint32(data + kEncapsulationHeaderSize, little_endian));
+  const uint32_t nanosec =
+    readUint32(data + kEncapsulationHeaderSize + sizeof(uint32_t), little_endian);
+  if (sec < 0) {
+    return std::nullopt;
+  }
+  constexpr uint64_t kNanosecondsPerSecond = 1000000000;
+  return static_cast<uint64_t>(sec) * kNanosecondsPerSecond + nanosec;
+}
+
+int64_t RosbagFrameIndexEntry::earliestBagTimeNs() const
+{
+  return std::min(
+    {depth_bag_time_ns, depth_camera_info_bag_time_ns, color_bag_time_ns,
+      color_camera_info_bag_time_ns});
+}
+
+std::vector<RosbagFrameIndexEntry> matchExactStamps(
+  std::vector<StampedBagMessage> depth_msgs,
+  std::vector<StampedBagMessage> depth_camera_info_msgs,
+  std::vector<StampedBagMessage> color_msgs,
+  std::vector<StampedBagMessage> color_camera_info_msgs)
+{
+  const std::vector<StampedBagMessage> streams[4] = {
+    sortedUnique(std::move(depth_msgs)), sortedUnique(std::move(depth_camera_info_msgs)),
+    sortedUnique(std::move(color_msgs)), sortedUnique(std::move(color_camera_info_msgs))};
+
+  // Merge the four sorted streams: advance the streams behind the latest front stamp until
+  // all fronts are equal.
+  std::vector<RosbagFrameIndexEntry> entries;
+  size_t positions[4] = {0, 0, 0, 0};
+  while (true) {
+    uint64_t max_stamp_ns = 0;
+    for (int i = 0; i < 4; i++) {
+      if (positions[i] >= streams[i].size()) {
+        return entries;
+      }
+      max_stamp_ns = std::max(max_stamp_ns, streams[i][positions[i]].stamp_ns);
+    }
+    bool all_match = true;
+    for (int i = 0; i < 4; i++) {
+      if (streams[i][positions[i]].stamp_ns < max_stamp_ns) {
+        ++positions[i];
+        all_match = false;
+      }
+    }
+    if (!all_match) {
+      continue;
+    }
+    RosbagFrameIndexEntry entry;
+    entry.stamp_ns = max_stamp_ns;
+    entry.depth_bag_time_ns = streams[0][positions[0]].bag_time_ns;
+    entry.depth_camera_info_bag_time_ns = streams[1][positions[1]].bag_time_ns;
+    entry.color_bag_time_ns = streams[2][positions[2]].bag_time_ns;
+    entry.color_camera_info_bag_time_ns = streams[3][positions[3]].bag_time_ns;
+    entries.push_back(entry);
+    for (size_t & position : positions) {
+      ++position;
+    }
+  }
+}
+
+RosbagFrameIndex::RosbagFrameIndex(std::vector<RosbagFrameIndexEntry> entries)
+: entries_(std::move(entries))
+{
+  CHECK(
+    std::is_sorted(
+      entries_.begin(), entries_.end(),
+      [](const RosbagFrameIndexEntry & a, const RosbagFrameIndexEntry & b) {
+        return a.stamp_ns < b.stamp_ns;
+      }));
+}
+
+RosbagFrameIndex RosbagFrameIndex::build(
+  const std::string & rosbag_path, const std::string & depth_topic,
+  const std::string & depth_camera_info_topic, const std::string & color_topic,
+  const std::string & color_camera_info_topic)
+{
+  rosbag2_cpp::Reader reader;
+  reader.open(rosbag_path);
+  rosbag2_storage::StorageFilter filter;
+  filter.topics = {depth_topic, depth_camera_info_topic, color_topic, color_camera_info_topic};
+  reader.set_filter(filter);
+
+  std::vector<StampedBagMessage> depth_msgs;
+  std::vector<StampedBagMessage> depth_camera_info_msgs;
+  std::vector<StampedBagMessage> color_msgs;
+  std::vector<StampedBagMessage> color_camera_info_msgs;
+  int num_unreadable = 0;
+  while (reader.has_next()) {
+    const auto msg = reader.read_next();
+    const std::optional<uint64_t> stamp_ns = peekHeaderStampNs(
+      msg->serialized_data->buffer, msg->serialized_data->buffer_length);
+    if (!stamp_ns) {
+      ++num_unreadable;
+      continue;
+    }
+    const StampedBagMessage stamped_msg{*stamp_ns, msg->time_stamp};
+    // NOTE: A topic may be used for more than one stream (e.g. a shared camera_info).
+    if (msg->topic_name == depth_topic) {
+      depth_msgs.push_back(stamped_msg);
+    }
+    if (msg->topic_name == depth_camera_info_topic) {
+      depth_camera_info_msgs.push_back(stamped_msg);
+    }
+    if (msg->topic_name == color_topic) {
+      color_msgs.push_back(stamped_msg);
+    }
+    if (msg->topic_name == color_camera_info_topic) {
+      color_camera_info_msgs.push_back(stamped_msg);
+    }
+  }
+  LOG_IF(WARNING, num_unreadable > 0)
+    << "Could not read the header stamp of " << num_unreadable << " messages.";
+
+  RosbagFrameIndex index(matchExactStamps(
+      std::move(depth_msgs), std::move(depth_camera_info_msgs), std::move(color_msgs),
+      std::move(color_camera_info_msgs)));
+  LOG(INFO) << "Indexed " << index.size() << " matching frames in " << rosbag_path;
+  return index;
+}
+
+size_t RosbagFrameIndex::findFirstAtOrAfter(uint64_t stamp_ns) const
+{
+  const auto it = std::lower_bound(
+    entries_.begin(), entries_.end(), stamp_ns,
+    [](const RosbagFrameIndexEntry & entry, uint64_t stamp) {return entry.stamp_ns < stamp;});
+  return static_cast<size_t>(it - entries_.begin());
+}
+
+}  // namespace ros
+}  // namespace datasets
+}  // namespace nvblox
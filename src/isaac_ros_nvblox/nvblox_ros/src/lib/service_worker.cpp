@@ -0,0 +1,83 @@
+// SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+// Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "nvblox_ros/service_worker.hpp"
+
+#include <utility>
+
+namespace nvblox
+{
+
+ServiceWorker::ServiceWorker()
+: thread_(&ServiceWorker::run, this) {}
+
+ServiceWorker::~ServiceWorker()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  job_posted_.notify_all();
+  thread_.join();
+}
+
+void ServiceWorker::post(Job job)
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    jobs_.push_back(std::move(job));
+    ++num_pending_jobs_;
+  }
+  job_posted_.notify_one();
+}
+
+void ServiceWorker::waitUntilIdle()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  job_completed_.wait(lock, [this]() {return num_pending_jobs_ == 0;});
+}
+
+size_t ServiceWorker::numPendingJobs() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return num_pending_jobs_;
+}
+
+void ServiceWorker::run()
+{
+  while (true) {
+    Job job;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      job_posted_.wait(lock, [this]() {return stop_ || !jobs_.empty();});
+      // Drain the queue before stopping, such that no service call is left without a response.
+      if (jobs_.empty()) {
+        return;
+      }
+      job = std::move(jobs_.front());
+      jobs_.pop_front();
+    }
+    job();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      --num_pending_jobs_;
+    }
+    job_completed_.notify_all();
+  }
+}
+
+}  // namespace nvblox
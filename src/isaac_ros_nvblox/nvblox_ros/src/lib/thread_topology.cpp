@@ -0,0 +1,226 @@
+// SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+// Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "nvblox_ros/thread_topology.hpp"
+
+#include <glog/logging.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+
+namespace nvblox
+{
+
+namespace
+{
+
+template<typename T>
+T declareOrGetParameter(rclcpp::Node * node, const std::string & name, const T & default_value)
+{
+  if (node->has_parameter(name)) {
+    return node->get_parameter(name).get_value<T>();
+  }
+  return node->declare_parameter<T>(name, default_value);
+}
+
+std::optional<int> parseCpu(const std::string & str)
+{
+  if (str.empty() || str.find_first_not_of("0123456789") != std::string::npos) {
+    return std::nullopt;
+  }
+  return std::stoi(str);
+}
+
+}  // namespace
+
+std::string toString(ThreadRole role)
+{
+  switch (role) {
+    case ThreadRole::kIngestion:
+      return "ingestion";
+    case ThreadRole::kIntegration:
+      return "integration";
+    case ThreadRole::kEsdf:
+      return "esdf";
+    case ThreadRole::kPublishing:
+      return "publishing";
+    case ThreadRole::kServices:
+      return "services";
+    default:
+      LOG(FATAL) << "Not implemented";
+      return "";
+  }
+}
+
+std::optional<std::vector<int>> parseCpuList(const std::string & cpu_list)
+{
+  std::vector<int> cpus;
+  std::stringstream ss(cpu_list);
+  std::string range;
+  while (std::getline(ss, range, ',')) {
+    const size_t dash_pos = range.find('-');
+    const std::optional<int> first = parseCpu(range.substr(0, dash_pos));
+    const std::optional<int> last =
+      dash_pos == std::string::npos ? first : parseCpu(range.substr(dash_pos + 1));
+    if (!first || !last || *last < *first) {
+      return std::nullopt;
+    }
+    for (int cpu = *first; cpu <= *last; cpu++) {
+      cpus.push_back(cpu);
+    }
+  }
+  return cpus;
+}
+
+bool applyThreadConfigToCurrentThread(const ThreadConfig & config)
+{
+  bool success = true;
+  if (!config.cpu_affinity.empty()) {
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    for (const int cpu : config.cpu_affinity) {
+      CHECK_GE(cpu, 0);
+      CHECK_LT(cpu, CPU_SETSIZE);
+      CPU_SET(cpu, &cpu_set);
+    }
+    const int error = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+    if (error != 0) {
+      LOG(WARNING) << "Couldn't set the CPU affinity of a thread: " << std::strerror(error);
+      success = false;
+    }
+  }
+  if (config.sched_fifo_priority > 0) {
+    sched_param param{};
+    param.sched_priority = config.sched_fifo_priority;
+    const int error = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if (error != 0) {
+      LOG(WARNING) << "Couldn't set SCHED_FIFO priority " << config.sched_fifo_priority
+                   << " of a thread (this needs CAP_SYS_NICE or an rtprio limit): "
+                   << std::strerror(error);
+      success = false;
+    }
+  }
+  return success;
+}
+
+ThreadConfigs getThreadConfigsFromParams(rclcpp::Node * node)
+{
+  CHECK_NOTNULL(node);
+  ThreadConfigs configs;
+  for (int i = 0; i < kNumThreadRoles; i++) {
+    const std::string prefix = "thread_topology." + toString(static_cast<ThreadRole>(i)) + ".";
+    ThreadConfig & config = configs[i];
+    config.num_threads = std::max(
+      declareOrGetParameter<int>(node, prefix + "num_threads", config.num_threads), 1);
+    config.sched_fifo_priority = declareOrGetParameter<int>(
+      node, prefix + "sched_fifo_priority", config.sched_fifo_priority);
+    const std::string cpu_list =
+      declareOrGetParameter<std::string>(node, prefix + "cpu_affinity", "");
+    const std::optional<std::vector<int>> cpus = parseCpuList(cpu_list);
+    if (cpus) {
+      config.cpu_affinity = *cpus;
+    } else {
+      LOG(ERROR) << "Ignoring malformed CPU list " << prefix << "cpu_affinity: " << cpu_list;
+    }
+  }
+  return configs;
+}
+
+ThreadTopologyExecutor::ThreadTopologyExecutor(const ThreadConfigs & configs)
+{
+  for (int i = 0; i < kNumThreadRoles; i++) {
+    RoleExecutor & role_executor = role_executors_[i];
+    role_executor.config = configs[i];
+    if (role_executor.config.num_threads > 1) {
+      role_executor.executor = std::make_shared<rclcpp::executors::MultiThreadedExecutor>(
+        rclcpp::ExecutorOptions(), role_executor.config.num_threads);
+    } else {
+      role_executor.executor = std::make_shared<rclcpp::executors::SingleThreadedExecutor>();
+    }
+  }
+}
+
+ThreadTopologyExecutor::~ThreadTopologyExecutor()
+{
+  cancel();
+  for (std::thread & thread : threads_) {
+    if (thread.joinable()) {
+      thread.join();
+    }
+  }
+}
+
+void ThreadTopologyExecutor::addNode(ThreadRole role, rclcpp::Node::SharedPtr node)
+{
+  RoleExecutor & role_executor = role_executors_[static_cast<int>(role)];
+  role_executor.executor->add_node(node);
+  role_executor.has_work = true;
+}
+
+void ThreadTopologyExecutor::addCallbackGroup(
+  ThreadRole role, rclcpp::CallbackGroup::SharedPtr group,
+  rclcpp::node_interfaces::NodeBaseInterface::SharedPtr node_base)
+{
+  if (!group) {
+    return;
+  }
+  if (group->automatically_add_to_executor_with_node()) {
+    LOG(WARNING) << "The callback group of role " << toString(role)
+                 << " is spun with its node, not on threads of its own.";
+    return;
+  }
+  RoleExecutor & role_executor = role_executors_[static_cast<int>(role)];
+  role_executor.executor->add_callback_group(group, node_base);
+  role_executor.has_work = true;
+}
+
+void ThreadTopologyExecutor::spin()
+{
+  CHECK(threads_.empty()) << "Already spinning.";
+  for (int i = 0; i < kNumThreadRoles; i++) {
+    RoleExecutor & role_executor = role_executors_[i];
+    if (!role_executor.has_work) {
+      continue;
+    }
+    const ThreadRole role = static_cast<ThreadRole>(i);
+    LOG(INFO) << "Spinning " << toString(role) << " on " << role_executor.config.num_threads
+              << " thread(s)";
+    // The worker threads of a multi-threaded executor are created by the spinning thread and
+    // inherit its affinity and scheduling policy.
+    threads_.emplace_back(
+      [&role_executor]() {
+        applyThreadConfigToCurrentThread(role_executor.config);
+        role_executor.executor->spin();
+      });
+  }
+  for (std::thread & thread : threads_) {
+    thread.join();
+  }
+  threads_.clear();
+}
+
+void ThreadTopologyExecutor::cancel()
+{
+  for (RoleExecutor & role_executor : role_executors_) {
+    role_executor.executor->cancel();
+  }
+}
+
+}  // namespace nvblox
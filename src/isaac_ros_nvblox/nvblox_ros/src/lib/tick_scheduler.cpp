@@ -0,0 +1,105 @@
+// SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+// Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "nvblox_ros/tick_scheduler.hpp"
+
+#include <glog/logging.h>
+
+#include <nvblox/utils/timing.h>
+
+namespace nvblox
+{
+
+TickScheduler::TickScheduler(float tick_budget_ms)
+: tick_start_time_(std::chrono::steady_clock::now())
+{
+  this->tick_budget_ms(tick_budget_ms);
+}
+
+TickScheduler::StageId TickScheduler::registerStage(
+  const std::string & name, const std::string & timer_tag,
+  TickStagePriority priority)
+{
+  stages_.push_back(Stage{name, timer_tag, priority});
+  return static_cast<StageId>(stages_.size()) - 1;
+}
+
+void TickScheduler::startTick()
+{
+  tick_start_time_ = std::chrono::steady_clock::now();
+}
+
+bool TickScheduler::shouldRunStage(StageId stage_id)
+{
+  CHECK_GE(stage_id, 0);
+  CHECK_LT(stage_id, static_cast<StageId>(stages_.size()));
+  Stage & stage = stages_[stage_id];
+  if (stage.priority == TickStagePriority::kCritical) {
+    return true;
+  }
+  const bool fits_in_budget = estimatedStageCostMs(stage_id) <= remainingBudgetMs();
+  if (fits_in_budget || stage.num_consecutive_deferrals >= max_num_consecutive_deferrals_) {
+    stage.num_consecutive_deferrals = 0;
+    return true;
+  }
+  VLOG(3) << "Deferring stage " << stage.name << ". Estimated cost: "
+          << estimatedStageCostMs(stage_id) << "ms, remaining budget: "
+          << remainingBudgetMs() << "ms";
+  ++stage.num_consecutive_deferrals;
+  ++stage.num_deferrals;
+  return false;
+}
+
+float TickScheduler::estimatedStageCostMs(StageId stage_id) const
+{
+  CHECK_GE(stage_id, 0);
+  CHECK_LT(stage_id, static_cast<StageId>(stages_.size()));
+  const std::string & timer_tag = stages_[stage_id].timer_tag;
+  // Stages that have never been timed are assumed to be free such that they get measured.
+  if (timing::Timing::GetNumSamples(timer_tag) == 0) {
+    return 0.F;
+  }
+  return static_cast<float>(timing::Timing::GetMeanSeconds(timer_tag) * 1000.0);
+}
+
+float TickScheduler::remainingBudgetMs() const
+{
+  const std::chrono::duration<float, std::milli> elapsed =
+    std::chrono::steady_clock::now() - tick_start_time_;
+  return tick_budget_ms_ - elapsed.count();
+}
+
+int TickScheduler::numDeferrals(StageId stage_id) const
+{
+  CHECK_GE(stage_id, 0);
+  CHECK_LT(stage_id, static_cast<StageId>(stages_.size()));
+  return stages_[stage_id].num_deferrals;
+}
+
+void TickScheduler::tick_budget_ms(float tick_budget_ms)
+{
+  CHECK_GT(tick_budget_ms, 0.F);
+  tick_budget_ms_ = tick_budget_ms;
+}
+
+void TickScheduler::max_num_consecutive_deferrals(int max_num_consecutive_deferrals)
+{
+  CHECK_GE(max_num_consecutive_deferrals, 0);
+  max_num_consecutive_deferrals_ = max_num_consecutive_deferrals;
+}
+
+}  // namespace nvblox
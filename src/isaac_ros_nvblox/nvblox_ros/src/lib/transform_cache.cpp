@@ -0,0 +1,137 @@
+// SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+// Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "nvblox_ros/transform_cache.hpp"
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <iterator>
+
+namespace nvblox
+{
+
+TransformCache::TransformCache(size_t max_num_transforms_per_frame_pair)
+: max_num_transforms_per_frame_pair_(max_num_transforms_per_frame_pair)
+{
+  CHECK_GT(max_num_transforms_per_frame_pair_, 0UL);
+}
+
+void TransformCache::insert(
+  const std::string & target_frame, const std::string & source_frame,
+  uint64_t timestamp_ns, const Transform & transform)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto & transforms = transforms_[FramePair(target_frame, source_frame)];
+  const auto compare_timestamps = [](const TimestampedTransform & lhs, uint64_t rhs) {
+      return lhs.first < rhs;
+    };
+  // Transforms almost always arrive in order, in which case this is the end.
+  auto it = transforms.end();
+  if (!transforms.empty() && transforms.back().first >= timestamp_ns) {
+    it = std::lower_bound(transforms.begin(), transforms.end(), timestamp_ns, compare_timestamps);
+    if (it != transforms.end() && it->first == timestamp_ns) {
+      it->second = transform;
+      return;
+    }
+  }
+  transforms.insert(it, TimestampedTransform(timestamp_ns, transform));
+  if (transforms.size() > max_num_transforms_per_frame_pair_) {
+    transforms.pop_front();
+  }
+}
+
+bool TransformCache::lookup(
+  const std::string & target_frame, const std::string & source_frame,
+  uint64_t timestamp_ns, Transform * transform) const
+{
+  CHECK_NOTNULL(transform);
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto transforms_it = transforms_.find(FramePair(target_frame, source_frame));
+  if (transforms_it == transforms_.end()) {
+    return false;
+  }
+  const auto & transforms = transforms_it->second;
+  const auto compare_timestamps = [](const TimestampedTransform & lhs, uint64_t rhs) {
+      return lhs.first < rhs;
+    };
+  // The first transform at or after the requested time.
+  const auto after =
+    std::lower_bound(transforms.begin(), transforms.end(), timestamp_ns, compare_timestamps);
+  if (after == transforms.end()) {
+    return false;
+  }
+  if (after->first == timestamp_ns) {
+    *transform = after->second;
+    return true;
+  }
+  if (after == transforms.begin()) {
+    return false;
+  }
+  const auto before = std::prev(after);
+  if (after->first - before->first > max_interpolation_interval_ns_) {
+    return false;
+  }
+
+  // Interpolate between the neighboring transforms.
+  const float t = static_cast<float>(timestamp_ns - before->first) /
+    static_cast<float>(after->first - before->first);
+  const Eigen::Quaternionf rotation_before(before->second.rotation());
+  const Eigen::Quaternionf rotation_after(after->second.rotation());
+  *transform = Transform::Identity();
+  transform->translate(
+    (1.F - t) * before->second.translation() + t * after->second.translation());
+  transform->rotate(rotation_before.slerp(t, rotation_after));
+  return true;
+}
+
+void TransformCache::insertStatic(
+  const std::string & target_frame, const std::string & source_frame,
+  const Transform & transform)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  static_transforms_[FramePair(target_frame, source_frame)] = transform;
+}
+
+bool TransformCache::lookupStatic(
+  const std::string & target_frame, const std::string & source_frame,
+  Transform * transform) const
+{
+  CHECK_NOTNULL(transform);
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto it = static_transforms_.find(FramePair(target_frame, source_frame));
+  if (it == static_transforms_.end()) {
+    return false;
+  }
+  *transform = it->second;
+  return true;
+}
+
+void TransformCache::clear()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  transforms_.clear();
+  static_transforms_.clear();
+}
+
+void TransformCache::max_interpolation_interval_ns(uint64_t max_interpolation_interval_ns)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  max_interpolation_interval_ns_ = max_interpolation_interval_ns;
+}
+
+}  // namespace nvblox
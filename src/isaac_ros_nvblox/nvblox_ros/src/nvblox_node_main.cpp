@@ -17,11 +17,16 @@
 
 #include <glog/logging.h>
 #include <nvblox/core/internal/warmup_cuda.h>
+#include <nvblox/core/memory_pool.h>
 
+#include <algorithm>
+#include <future>
 #include <memory>
+#include <string>
 
 #include <rclcpp/rclcpp.hpp>
 
+#include "nvblox_ros/launch_autotuning.hpp"
 #include "nvblox_ros/nvblox_node.hpp"
 
 using namespace std::chrono_literals;
@@ -34,13 +39,46 @@ int main(int argc, char * argv[])
   rclcpp::init(argc, argv);
 
   // Warmup CUDA so it doesn't affect our timings *as* much for the first
-  // CUDA call.
-  nvblox::warmupCuda();
+  // CUDA call. The CUDA context is created in the background, while the node parses its parameters
+  // and sets up its subscriptions.
+  std::future<void> cuda_warmup = nvblox::warmupCudaAsync();
 
   rclcpp::executors::MultiThreadedExecutor exec;
   std::shared_ptr<nvblox::NvbloxNode> node(new nvblox::NvbloxNode());
-  exec.add_node(node);
-  exec.spin();
+  cuda_warmup.get();
+
+  // Keep device memory freed by the per-frame temporaries cached in CUDA's memory pool, such that
+  // steady-state frames don't allocate from the driver. Reserving the configured amount up front
+  // means that the first frames don't either.
+  nvblox::setDeviceMemoryPoolReleaseThreshold(nvblox::kKeepAllMemoryPoolReleaseThreshold);
+  const int device_memory_pool_reserve_mb = node->declare_parameter<int>(
+    nvblox::kDeviceMemoryPoolReserveMbParamDesc.name,
+    nvblox::kDeviceMemoryPoolReserveMbParamDesc.default_value);
+  nvblox::reserveDeviceMemoryPool(
+    static_cast<uint64_t>(std::max(device_memory_pool_reserve_mb, 0)) * 1024 * 1024);
+
+  // Select the fastest launch configurations for this GPU, from the cache or by tuning.
+  nvblox::configureLaunchAutotunerFromParams(node.get());
+  // Optionally give each kind of work threads of its own, e.g. pinned to cores isolated from
+  // real-time controllers.
+  const std::string use_thread_topology_name = nvblox::kUseThreadTopologyParamDesc.name;
+  const bool use_thread_topology = node->has_parameter(use_thread_topology_name) ?
+    node->get_parameter(use_thread_topology_name).as_bool() :
+    node->declare_parameter<bool>(
+    use_thread_topology_name, nvblox::kUseThreadTopologyParamDesc.default_value);
+  if (use_thread_topology) {
+    nvblox::ThreadTopologyExecutor topology_exec(nvblox::getThreadConfigsFromParams(node.get()));
+    topology_exec.addNode(nvblox::ThreadRole::kIngestion, node);
+    for (int i = 0; i < nvblox::kNumThreadRoles; i++) {
+      const auto role = static_cast<nvblox::ThreadRole>(i);
+      topology_exec.addCallbackGroup(
+        role, node->callbackGroup(role), node->get_node_base_interface());
+    }
+    topology_exec.spin();
+  } else {
+    exec.add_node(node);
+    exec.spin();
+  }
 
   rclcpp::shutdown();
   return 0;
@@ -0,0 +1,242 @@
+// SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+// Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <nvblox/core/internal/warmup_cuda.h>
+#include <nvblox/core/memory_pool.h>
+#include <nvblox/mapper/multi_mapper.h>
+#include <nvblox/utils/timing.h>
+
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <rclcpp/rclcpp.hpp>
+
+#include "nvblox_ros/indexed_rosbag_data_loader.hpp"
+#include "nvblox_ros/launch_autotuning.hpp"
+#include "nvblox_ros/mapper_initialization.hpp"
+#include "nvblox_ros/node_params.hpp"
+
+// Offline "bake" of a map from a ROSbag.
+//
+// Rather than playing the bag into the NvbloxNode in real time, this reads the frames straight
+// from the bag and integrates them as fast as the GPU allows. The mapper is configured from the
+// same parameter files as the node, passed as usual through --ros-args --params-file. The ESDF
+// and mesh are only updated at the end (or every N frames if requested) and the resulting map is
+// written with Mapper::saveLayerCake().
+//
+// Usage:
+//   offline_bake_rosbag [flags] <rosbag_path> <map_output_path> \
+//     --ros-args --params-file nvblox_base.yaml
+
+DEFINE_string(depth_topic, "/front_stereo_camera/depth", "Name of the depth topic.");
+DEFINE_string(
+  depth_camera_info_topic, "/front_stereo_camera/depth/camera_info",
+  "Name of the camera_info topic of the depth topic.");
+DEFINE_string(
+  color_topic, "/front_stereo_camera/left/image_rect_color",
+  "Name of the color image topic.");
+DEFINE_string(
+  color_camera_info_topic, "/front_stereo_camera/left/camera_info_rect",
+  "Name of the camera_info topic of the color topic.");
+DEFINE_double(
+  tf_preload_time_s, 1.0,
+  "Seconds of /tf messages loaded in advance of the image topics.");
+DEFINE_int32(prefetch_queue_size, 8, "Number of frames loaded ahead of the integration.");
+DEFINE_int32(max_frames, -1, "Number of frames to integrate. All frames if negative.");
+DEFINE_int32(
+  esdf_update_interval_frames, 0,
+  "Update the ESDF every this many frames. Only at the end if zero.");
+DEFINE_int32(
+  mesh_update_interval_frames, 0,
+  "Update the mesh every this many frames. Only at the end if zero.");
+DEFINE_string(mesh_output_path, "", "If set, the mesh is also written to this .ply file.");
+DEFINE_string(
+  node_name, "nvblox_node",
+  "Name of the node the parameters are read for. Defaults to that of the NvbloxNode such "
+  "that node-specific parameter files apply unchanged.");
+
+namespace nvblox
+{
+
+namespace
+{
+
+constexpr char kStaticMapperName[] = "static_mapper";
+constexpr char kDynamicMapperName[] = "dynamic_mapper";
+
+bool isIntervalFrame(const int frame_number, const int interval)
+{
+  return interval > 0 && (frame_number + 1) % interval == 0;
+}
+
+}  // namespace
+
+/// Integrates all frames of a ROSbag into a MultiMapper configured from the node parameters.
+/// @return The number of integrated frames. Negative if the bag couldn't be loaded.
+int bakeRosbag(
+  const std::string & rosbag_path, const std::string & map_output_path,
+  rclcpp::Node * node)
+{
+  NvbloxNodeParams params;
+  initializeNvbloxNodeParams(node, &params);
+  declareMultiMapperParameters(node);
+  declareMapperParameters(kStaticMapperName, node);
+  declareMapperParameters(kDynamicMapperName, node);
+
+  std::shared_ptr<CudaStream> cuda_stream =
+    CudaStream::createCudaStream(params.cuda_stream_type.get());
+  MultiMapper multi_mapper(
+    params.voxel_size, params.mapping_type, params.esdf_mode, MemoryType::kDevice,
+    cuda_stream);
+  multi_mapper.setMultiMapperParams(getMultiMapperParamsFromROS(node));
+  multi_mapper.setMapperParams(
+    getMapperParamsFromROS(kStaticMapperName, node),
+    getMapperParamsFromROS(kDynamicMapperName, node));
+
+  std::unique_ptr<datasets::ros::IndexedRosDataLoader> data_loader =
+    datasets::ros::IndexedRosDataLoader::create(
+    rosbag_path, FLAGS_depth_topic, FLAGS_depth_camera_info_topic, FLAGS_color_topic,
+    FLAGS_color_camera_info_topic, params.global_frame.get(), FLAGS_tf_preload_time_s,
+    FLAGS_prefetch_queue_size, cuda_stream);
+  if (!data_loader) {
+    LOG(ERROR) << "Could not load frames from " << rosbag_path;
+    return -1;
+  }
+
+  DepthImage depth_frame(MemoryType::kDevice);
+  ColorImage color_frame(MemoryType::kDevice);
+  Transform T_L_D;
+  Transform T_L_C;
+  Camera depth_camera;
+  Camera color_camera;
+
+  const auto start_time = std::chrono::steady_clock::now();
+  int frame_number = 0;
+  while (FLAGS_max_frames < 0 || frame_number < FLAGS_max_frames) {
+    timing::Timer load_timer("offline_bake/load_frame");
+    const datasets::DataLoadResult result = data_loader->loadNext(
+      &depth_frame, &T_L_D, &depth_camera, &color_frame, &T_L_C, &color_camera);
+    load_timer.Stop();
+    if (result == datasets::DataLoadResult::kNoMoreData) {
+      break;
+    }
+    if (result == datasets::DataLoadResult::kBadFrame) {
+      LOG(WARNING) << "Skipping bad frame " << frame_number;
+      continue;
+    }
+
+    timing::Timer integrate_timer("offline_bake/integrate_frame");
+    if (params.use_depth) {
+      multi_mapper.integrateDepth(depth_frame, T_L_D, depth_camera);
+    }
+    if (params.use_color) {
+      multi_mapper.integrateColor(color_frame, T_L_C, color_camera);
+    }
+    integrate_timer.Stop();
+
+    if (isIntervalFrame(frame_number, FLAGS_esdf_update_interval_frames)) {
+      multi_mapper.updateEsdf();
+    }
+    if (isIntervalFrame(frame_number, FLAGS_mesh_update_interval_frames)) {
+      multi_mapper.updateMesh();
+    }
+    ++frame_number;
+  }
+
+  // Bring the ESDF and mesh up to date with all integrated frames.
+  multi_mapper.updateEsdf();
+  multi_mapper.updateMesh();
+  cuda_stream->synchronize();
+
+  const double elapsed_s =
+    std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+  LOG(INFO) << "Integrated " << frame_number << " frames in " << elapsed_s << " s ("
+            << (elapsed_s > 0.0 ? frame_number / elapsed_s : 0.0) << " frames/s).";
+  LOG(INFO) << timing::Timing::Print();
+
+  const std::shared_ptr<Mapper> static_mapper = multi_mapper.background_mapper();
+  if (!static_mapper->saveLayerCake(map_output_path)) {
+    LOG(ERROR) << "Failed to write the map to " << map_output_path;
+    return -1;
+  }
+  LOG(INFO) << "Wrote the map to " << map_output_path;
+  if (!FLAGS_mesh_output_path.empty()) {
+    if (!static_mapper->saveMeshAsPly(FLAGS_mesh_output_path)) {
+      LOG(ERROR) << "Failed to write the mesh to " << FLAGS_mesh_output_path;
+      return -1;
+    }
+    LOG(INFO) << "Wrote the mesh to " << FLAGS_mesh_output_path;
+  }
+  return frame_number;
+}
+
+}  // namespace nvblox
+
+int main(int argc, char * argv[])
+{
+  // Split off the ROS arguments (e.g. the parameter files) before handing the rest to gflags.
+  rclcpp::init(argc, argv);
+  std::vector<std::string> non_ros_args = rclcpp::remove_ros_arguments(argc, argv);
+  std::vector<char *> non_ros_argv;
+  for (std::string & arg : non_ros_args) {
+    non_ros_argv.push_back(arg.data());
+  }
+  int non_ros_argc = static_cast<int>(non_ros_argv.size());
+  char ** non_ros_argv_ptr = non_ros_argv.data();
+  gflags::ParseCommandLineFlags(&non_ros_argc, &non_ros_argv_ptr, true);
+  google::InitGoogleLogging(argv[0]);
+  FLAGS_alsologtostderr = true;
+  google::InstallFailureSignalHandler();
+
+  if (non_ros_argc < 3) {
+    LOG(ERROR) << "Usage: offline_bake_rosbag [flags] <rosbag_path> <map_output_path> "
+      "[--ros-args --params-file <params.yaml>]";
+    rclcpp::shutdown();
+    return 1;
+  }
+  const std::string rosbag_path = non_ros_argv_ptr[1];
+  const std::string map_output_path = non_ros_argv_ptr[2];
+  LOG(INFO) << "Baking ROSbag " << rosbag_path << " into " << map_output_path;
+
+  // Create the CUDA context while the parameters are parsed.
+  std::future<void> cuda_warmup = nvblox::warmupCudaAsync();
+  auto node = std::make_shared<rclcpp::Node>(FLAGS_node_name);
+  cuda_warmup.get();
+
+  // Use the same memory pool settings as the nodes.
+  nvblox::setDeviceMemoryPoolReleaseThreshold(nvblox::kKeepAllMemoryPoolReleaseThreshold);
+  const int device_memory_pool_reserve_mb = node->declare_parameter<int>(
+    nvblox::kDeviceMemoryPoolReserveMbParamDesc.name,
+    nvblox::kDeviceMemoryPoolReserveMbParamDesc.default_value);
+  nvblox::reserveDeviceMemoryPool(
+    static_cast<uint64_t>(std::max(device_memory_pool_reserve_mb, 0)) * 1024 * 1024);
+
+  // Select the fastest launch configurations for this GPU, from the cache or by tuning.
+  nvblox::configureLaunchAutotunerFromParams(node.get());
+
+  const int num_frames = nvblox::bakeRosbag(rosbag_path, map_output_path, node.get());
+
+  rclcpp::shutdown();
+  return num_frames < 0 ? 1 : 0;
+}
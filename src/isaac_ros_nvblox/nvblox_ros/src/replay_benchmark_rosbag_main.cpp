@@ -0,0 +1,100 @@
+// SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+// Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <nvblox/core/internal/warmup_cuda.h>
+#include <nvblox/core/memory_pool.h>
+#include <nvblox/executables/replay_benchmark.h>
+
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "nvblox_ros/indexed_rosbag_data_loader.hpp"
+#include "nvblox_ros/rosbag_data_loader.hpp"
+
+DEFINE_string(depth_topic, "/front_stereo_camera/depth", "Name of the depth topic.");
+DEFINE_string(
+  depth_camera_info_topic, "/front_stereo_camera/depth/camera_info",
+  "Name of the camera_info topic of the depth topic.");
+DEFINE_string(
+  color_topic, "/front_stereo_camera/left/image_rect_color",
+  "Name of the color image topic.");
+DEFINE_string(
+  color_camera_info_topic, "/front_stereo_camera/left/camera_info_rect",
+  "Name of the camera_info topic of the color topic.");
+DEFINE_string(global_frame_id, "odom", "The frame the camera poses are expressed in.");
+DEFINE_double(
+  tf_preload_time_s, 1.0,
+  "Seconds of /tf messages loaded in advance of the image topics.");
+DEFINE_bool(
+  use_indexed_loader, true,
+  "Index the bag and load frames ahead on a background thread, rather than stepping "
+  "through the bag on the main thread.");
+DEFINE_int32(prefetch_queue_size, 8, "Number of frames loaded ahead by the indexed loader.");
+DEFINE_int32(num_warmup_frames, 10, "Number of frames integrated before measuring.");
+
+int main(int argc, char * argv[])
+{
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  FLAGS_alsologtostderr = true;
+  google::InstallFailureSignalHandler();
+
+  if (argc < 2) {
+    LOG(ERROR) << "Usage: replay_benchmark_rosbag <rosbag_path> [json_output_path]";
+    return 1;
+  }
+  const std::string rosbag_path = argv[1];
+  LOG(INFO) << "Replaying ROSbag " << rosbag_path;
+
+  // Warmup CUDA so it doesn't affect the timings of the first frames.
+  nvblox::warmupCuda();
+
+  // Measure with the same memory pool settings as the nodes.
+  nvblox::setDeviceMemoryPoolReleaseThreshold(nvblox::kKeepAllMemoryPoolReleaseThreshold);
+
+  std::unique_ptr<nvblox::Fuser> fuser = FLAGS_use_indexed_loader ?
+    nvblox::datasets::ros::createIndexedFuser(
+    rosbag_path, FLAGS_depth_topic, FLAGS_depth_camera_info_topic, FLAGS_color_topic,
+    FLAGS_color_camera_info_topic, FLAGS_global_frame_id, FLAGS_tf_preload_time_s,
+    FLAGS_prefetch_queue_size) :
+    nvblox::datasets::ros::createFuser(
+    rosbag_path, FLAGS_depth_topic, FLAGS_depth_camera_info_topic, FLAGS_color_topic,
+    FLAGS_color_camera_info_topic, FLAGS_global_frame_id, FLAGS_tf_preload_time_s);
+  if (!fuser) {
+    LOG(FATAL) << "Creation of the Fuser failed";
+  }
+
+  const nvblox::ReplayBenchmarkResult result =
+    nvblox::runReplayBenchmark(FLAGS_num_warmup_frames, fuser.get());
+  result.print(std::cout);
+
+  // JSON output (optional)
+  if (argc >= 3) {
+    std::ofstream json_file(argv[2]);
+    if (!json_file) {
+      LOG(ERROR) << "Could not open " << argv[2] << " for writing.";
+      return 1;
+    }
+    result.writeJson(json_file);
+    LOG(INFO) << "Wrote results to " << argv[2];
+  }
+  return 0;
+}
@@ -20,8 +20,11 @@
 
 #include <nvblox/nvblox.h>
 
+#include <vector>
+
 #include <std_msgs/msg/float32_multi_array.hpp>
 
+#include "nvblox_ros/conversions/esdf_and_gradients_async_conversions.hpp"
 #include "nvblox_ros/conversions/esdf_and_gradients_conversions.hpp"
 
 namespace nvblox
@@ -156,6 +159,165 @@ TEST(EsdfAndGradientsConversionsTest, EsdfValues) {
   }
 }
 
+TEST(EsdfAndGradientsConversionsTest, AsyncEsdfAndGradients) {
+  // A single block in which the distance increases linearly along x.
+  constexpr float kVoxelSize = 0.05;
+  EsdfLayer esdf_layer(kVoxelSize, MemoryType::kUnified);
+  esdf_layer.allocateBlockAtIndex(Index3D(0, 0, 0));
+  callFunctionOnAllVoxels<EsdfVoxel>(
+    &esdf_layer, [](const Index3D &, const Index3D & voxel_index, EsdfVoxel * voxel) {
+      const float distance_vox = static_cast<float>(voxel_index.x() + 1);
+      voxel->squared_distance_vox = distance_vox * distance_vox;
+      voxel->observed = true;
+    });
+  constexpr int kVoxelsPerSide = VoxelBlock<bool>::kVoxelsPerSide;
+  const float block_size = esdf_layer.block_size();
+  // An AABB within the block, such that all cells are observed.
+  const AxisAlignedBoundingBox aabb(
+    Vector3f::Constant(0.5F * kVoxelSize), Vector3f::Constant(block_size - 0.5F * kVoxelSize));
+
+  conversions::AsyncEsdfAndGradientsConverter converter;
+  converter.include_gradients(true);
+  CudaStreamOwning cuda_stream;
+  constexpr float kDefaultValue = -1000;
+  auto snapshot = converter.extractAsync(esdf_layer, aabb, kDefaultValue, cuda_stream);
+  ASSERT_NE(snapshot, nullptr);
+
+  nvblox_msgs::srv::EsdfAndGradients::Response response;
+  snapshot->fillResponse(&response);
+  EXPECT_TRUE(snapshot->isReady());
+  EXPECT_TRUE(response.success);
+  EXPECT_NEAR(response.voxel_size_m, kVoxelSize, 1e-6);
+  EXPECT_NEAR(response.origin_m.x, 0.0, 1e-6);
+
+  // Layout: x, y, z and the channel, with z/channel varying fastest.
+  const auto & msg = response.esdf_and_gradients;
+  ASSERT_EQ(msg.layout.dim.size(), 4U);
+  EXPECT_EQ(msg.layout.dim[3].label, "channel");
+  EXPECT_EQ(msg.layout.dim[3].size, 4U);
+  for (int i = 0; i < 3; i++) {
+    EXPECT_EQ(msg.layout.dim[i].size, static_cast<uint32_t>(kVoxelsPerSide));
+  }
+  EXPECT_EQ(msg.layout.dim[0].stride, msg.data.size());
+  EXPECT_EQ(msg.layout.dim[2].stride, 4U * kVoxelsPerSide);
+  const int stride_x = msg.layout.dim[1].stride;
+  const int stride_y = msg.layout.dim[2].stride;
+  const int stride_z = msg.layout.dim[3].stride;
+
+  constexpr float kEps = 1e-4;
+  for (int x = 0; x < kVoxelsPerSide; x++) {
+    for (int y = 0; y < kVoxelsPerSide; y++) {
+      for (int z = 0; z < kVoxelsPerSide; z++) {
+        const float * cell = &msg.data[x * stride_x + y * stride_y + z * stride_z];
+        EXPECT_NEAR(cell[0], kVoxelSize * (x + 1), kEps);
+        // The gradient of the linear field is the x-axis, also at the grid borders.
+        EXPECT_NEAR(cell[1], 1.0F, kEps);
+        EXPECT_NEAR(cell[2], 0.0F, kEps);
+        EXPECT_NEAR(cell[3], 0.0F, kEps);
+      }
+    }
+  }
+
+  // Once released, the snapshot (and its pinned buffer) is reused.
+  snapshot.reset();
+  auto next_snapshot = converter.extractAsync(esdf_layer, aabb, kDefaultValue, cuda_stream);
+  ASSERT_NE(next_snapshot, nullptr);
+  next_snapshot->fillResponse(&response);
+  EXPECT_EQ(converter.num_allocated_snapshots(), 1U);
+
+  // Without gradients, the layout is that of the synchronous converter.
+  converter.include_gradients(false);
+  auto distance_snapshot = converter.extractAsync(esdf_layer, aabb, kDefaultValue, cuda_stream);
+  ASSERT_NE(distance_snapshot, nullptr);
+  const std_msgs::msg::Float32MultiArray distance_msg = distance_snapshot->toMultiArrayMsg();
+  ASSERT_EQ(distance_msg.layout.dim.size(), 3U);
+  EXPECT_NEAR(
+    getValueFromMessage(Index3D(2, 0, 0), distance_msg), kVoxelSize * 3, kEps);
+}
+
+TEST(EsdfAndGradientsConversionsTest, RunLengthEncode) {
+  const std::vector<int16_t> values = {3, 3, 3, -1, 7, 7};
+  std::vector<int16_t> run_values;
+  std::vector<uint16_t> run_lengths;
+  conversions::runLengthEncode(values.data(), values.size(), &run_values, &run_lengths);
+  EXPECT_EQ(run_values, std::vector<int16_t>({3, -1, 7}));
+  EXPECT_EQ(run_lengths, std::vector<uint16_t>({3, 1, 2}));
+
+  // Runs longer than the largest uint16 are split.
+  const std::vector<int16_t> long_run(70000, 5);
+  conversions::runLengthEncode(long_run.data(), long_run.size(), &run_values, &run_lengths);
+  EXPECT_EQ(run_values, std::vector<int16_t>({5, 5}));
+  EXPECT_EQ(run_lengths, std::vector<uint16_t>({65535, 70000 - 65535}));
+
+  nvblox_msgs::msg::QuantizedEsdfGrid grid_msg;
+  grid_msg.distances = run_values;
+  grid_msg.distance_run_lengths = run_lengths;
+  EXPECT_EQ(conversions::decodeQuantizedEsdfDistances(grid_msg), long_run);
+}
+
+TEST(EsdfAndGradientsConversionsTest, QuantizedEsdf) {
+  // A single block in which the distance increases linearly along x, except for an unobserved
+  // plane at x = 0.
+  constexpr float kVoxelSize = 0.05;
+  EsdfLayer esdf_layer(kVoxelSize, MemoryType::kUnified);
+  esdf_layer.allocateBlockAtIndex(Index3D(0, 0, 0));
+  callFunctionOnAllVoxels<EsdfVoxel>(
+    &esdf_layer, [](const Index3D &, const Index3D & voxel_index, EsdfVoxel * voxel) {
+      const float distance_vox = static_cast<float>(voxel_index.x());
+      voxel->squared_distance_vox = distance_vox * distance_vox;
+      voxel->observed = voxel_index.x() > 0;
+    });
+  constexpr int kVoxelsPerSide = VoxelBlock<bool>::kVoxelsPerSide;
+  const AxisAlignedBoundingBox aabb(
+    Vector3f::Constant(0.5F * kVoxelSize),
+    Vector3f::Constant(esdf_layer.block_size() - 0.5F * kVoxelSize));
+
+  conversions::AsyncEsdfAndGradientsConverter converter;
+  converter.include_gradients(true);
+  CudaStreamOwning cuda_stream;
+  constexpr float kDefaultValue = -1000;
+  conversions::EsdfAndGradientsFormat format;
+  format.quantized = true;
+  format.run_length_encode = true;
+  auto snapshot = converter.extractAsync(esdf_layer, aabb, kDefaultValue, cuda_stream, format);
+  ASSERT_NE(snapshot, nullptr);
+
+  nvblox_msgs::srv::EsdfAndGradients::Response response;
+  snapshot->fillResponse(&response);
+  EXPECT_TRUE(response.esdf_and_gradients.data.empty());
+  const auto & grid_msg = response.quantized_esdf_grid;
+  EXPECT_EQ(grid_msg.size_x, static_cast<uint32_t>(kVoxelsPerSide));
+  EXPECT_EQ(grid_msg.size_y, static_cast<uint32_t>(kVoxelsPerSide));
+  EXPECT_EQ(grid_msg.size_z, static_cast<uint32_t>(kVoxelsPerSide));
+  EXPECT_NEAR(grid_msg.distance_scale_m, conversions::kQuantizedEsdfDistanceScaleM, 1e-9);
+  // Distances are constant along z, so each z-column is a single run.
+  constexpr int kNumCells = kVoxelsPerSide * kVoxelsPerSide * kVoxelsPerSide;
+  EXPECT_LE(grid_msg.distances.size(), static_cast<size_t>(kVoxelsPerSide * kVoxelsPerSide));
+  ASSERT_EQ(grid_msg.gradients.size(), static_cast<size_t>(3 * kNumCells));
+
+  const std::vector<int16_t> distances = conversions::decodeQuantizedEsdfDistances(grid_msg);
+  ASSERT_EQ(distances.size(), static_cast<size_t>(kNumCells));
+  for (int x = 0; x < kVoxelsPerSide; x++) {
+    for (int y = 0; y < kVoxelsPerSide; y++) {
+      for (int z = 0; z < kVoxelsPerSide; z++) {
+        const int linear_idx = z + kVoxelsPerSide * (y + kVoxelsPerSide * x);
+        const int8_t * gradient = &grid_msg.gradients[3 * linear_idx];
+        if (x == 0) {
+          EXPECT_EQ(
+            distances[linear_idx], nvblox_msgs::msg::QuantizedEsdfGrid::UNOBSERVED_DISTANCE);
+          EXPECT_EQ(gradient[0], 0);
+        } else {
+          // Millimeters
+          EXPECT_EQ(distances[linear_idx], x * 50);
+          EXPECT_EQ(gradient[0], 127);
+        }
+        EXPECT_EQ(gradient[1], 0);
+        EXPECT_EQ(gradient[2], 0);
+      }
+    }
+  }
+}
+
 int main(int argc, char ** argv)
 {
   FLAGS_alsologtostderr = true;
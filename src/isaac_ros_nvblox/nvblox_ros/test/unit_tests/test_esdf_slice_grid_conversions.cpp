@@ -0,0 +1,314 @@
+// SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+// Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <array>
+
+#include <nvblox/nvblox.h>
+
+#include "nvblox_ros/conversions/esdf_slice_grid_conversions.hpp"
+
+namespace nvblox
+{
+namespace conversions
+{
+
+constexpr float kUnknownValue = -1000.F;
+
+Image<float> getTestSlice(const int rows, const int cols, const float offset)
+{
+  Image<float> slice(rows, cols, MemoryType::kUnified);
+  for (int row = 0; row < rows; row++) {
+    for (int col = 0; col < cols; col++) {
+      slice(row, col) = (col == 0) ? kUnknownValue : 0.1F * col - offset;
+    }
+  }
+  return slice;
+}
+
+TEST(EsdfSliceGridConversionsTest, ThresholdAndCostDecay) {
+  constexpr int kRows = 4;
+  constexpr int kCols = 10;
+  const Image<float> static_slice = getTestSlice(kRows, kCols, 0.0F);
+  const Image<float> combined_slice = getTestSlice(kRows, kCols, 0.3F);
+
+  EsdfSliceGridConverter converter;
+  converter.occupied_distance_m(0.15F);
+  converter.free_distance_m(0.55F);
+  EXPECT_TRUE(
+    converter.convertSliceImages(
+      {{{&static_slice, {}}, {nullptr, {}}, {&combined_slice, {}}}}, kUnknownValue));
+  EXPECT_TRUE(converter.hasSlice(0));
+  EXPECT_FALSE(converter.hasSlice(1));
+  EXPECT_TRUE(converter.hasSlice(2));
+
+  nav_msgs::msg::OccupancyGrid grid_msg;
+  converter.occupancyGridMsgDataFromSlice(0, &grid_msg);
+  EXPECT_EQ(grid_msg.info.width, kCols);
+  EXPECT_EQ(grid_msg.info.height, kRows);
+  ASSERT_EQ(grid_msg.data.size(), kRows * kCols);
+  for (int row = 0; row < kRows; row++) {
+    const int8_t * grid_row = grid_msg.data.data() + row * kCols;
+    EXPECT_EQ(grid_row[0], kOccupancyGridUnknownCost);
+    EXPECT_EQ(grid_row[1], kOccupancyGridOccupiedCost);
+    EXPECT_GT(grid_row[2], kOccupancyGridFreeCost);
+    EXPECT_LT(grid_row[2], kOccupancyGridOccupiedCost);
+    // Costs decrease with distance.
+    for (int col = 3; col < kCols; col++) {
+      EXPECT_LE(grid_row[col], grid_row[col - 1]);
+    }
+    EXPECT_EQ(grid_row[6], kOccupancyGridFreeCost);
+  }
+
+  // The combined slice is closer to obstacles.
+  nav_msgs::msg::OccupancyGrid combined_grid_msg;
+  converter.occupancyGridMsgDataFromSlice(2, &combined_grid_msg);
+  ASSERT_EQ(combined_grid_msg.data.size(), kRows * kCols);
+  EXPECT_EQ(combined_grid_msg.data[4], kOccupancyGridOccupiedCost);
+  EXPECT_EQ(combined_grid_msg.data[9], kOccupancyGridFreeCost);
+
+  // The distance map carries the slice values.
+  nvblox_msgs::msg::DistanceMapSlice map_slice_msg;
+  converter.distanceMapSliceMsgDataFromSlice(0, &map_slice_msg);
+  ASSERT_EQ(map_slice_msg.data.size(), kRows * kCols);
+  for (int i = 0; i < kRows * kCols; i++) {
+    EXPECT_EQ(map_slice_msg.data[i], static_slice(i));
+  }
+}
+
+TEST(EsdfSliceGridConversionsTest, BinaryThresholdAndSizeMismatch) {
+  const Image<float> slice = getTestSlice(2, 5, 0.2F);
+  EsdfSliceGridConverter converter;
+  EXPECT_TRUE(
+    converter.convertSliceImages({{{&slice, {}}, {nullptr, {}}, {nullptr, {}}}}, kUnknownValue));
+  nav_msgs::msg::OccupancyGrid grid_msg;
+  converter.occupancyGridMsgDataFromSlice(0, &grid_msg);
+  ASSERT_EQ(grid_msg.data.size(), 10u);
+  EXPECT_EQ(grid_msg.data[0], kOccupancyGridUnknownCost);
+  EXPECT_EQ(grid_msg.data[1], kOccupancyGridOccupiedCost);
+  EXPECT_EQ(grid_msg.data[2], kOccupancyGridOccupiedCost);
+  EXPECT_EQ(grid_msg.data[3], kOccupancyGridFreeCost);
+
+  const Image<float> other_slice = getTestSlice(3, 5, 0.2F);
+  EXPECT_FALSE(
+    converter.convertSliceImages(
+      {{{&slice, {}}, {&other_slice, {}}, {nullptr, {}}}}, kUnknownValue));
+}
+
+TEST(EsdfSliceGridConversionsTest, ChangedCellWindow) {
+  constexpr int kRows = 20;
+  constexpr int kCols = 30;
+  Image<float> slice = getTestSlice(kRows, kCols, 0.0F);
+  const AxisAlignedBoundingBox aabb(Vector3f::Zero(), Vector3f::Ones());
+  const EsdfSliceGridConverter::Slices slices = {{{&slice, aabb}, {nullptr, {}}, {nullptr, {}}}};
+
+  // The first conversion changes everything.
+  EsdfSliceGridConverter converter;
+  ASSERT_TRUE(converter.convertSliceImages(slices, kUnknownValue));
+  auto window = converter.changedCellWindow(0);
+  ASSERT_TRUE(window.has_value());
+  EXPECT_EQ(window->width(), kCols);
+  EXPECT_EQ(window->height(), kRows);
+  EXPECT_FALSE(converter.changedCellWindow(1).has_value());
+
+  // Converting the same slice again changes nothing.
+  ASSERT_TRUE(converter.convertSliceImages(slices, kUnknownValue));
+  EXPECT_FALSE(converter.changedCellWindow(0).has_value());
+
+  // Change two cells.
+  slice(3, 5) = 2.0F;
+  slice(7, 12) = kUnknownValue;
+  ASSERT_TRUE(converter.convertSliceImages(slices, kUnknownValue));
+  window = converter.changedCellWindow(0);
+  ASSERT_TRUE(window.has_value());
+  EXPECT_EQ(window->min_row, 3);
+  EXPECT_EQ(window->min_col, 5);
+  EXPECT_EQ(window->max_row, 7);
+  EXPECT_EQ(window->max_col, 12);
+
+  // The updates carry the window.
+  map_msgs::msg::OccupancyGridUpdate grid_update_msg;
+  converter.occupancyGridUpdateMsgFromSlice(0, *window, &grid_update_msg);
+  EXPECT_EQ(grid_update_msg.x, 5);
+  EXPECT_EQ(grid_update_msg.y, 3);
+  EXPECT_EQ(grid_update_msg.width, 8);
+  EXPECT_EQ(grid_update_msg.height, 5);
+  ASSERT_EQ(grid_update_msg.data.size(), 8u * 5u);
+  EXPECT_EQ(grid_update_msg.data[0], kOccupancyGridFreeCost);
+  EXPECT_EQ(grid_update_msg.data.back(), kOccupancyGridUnknownCost);
+
+  nvblox_msgs::msg::DistanceMapSliceUpdate map_slice_update_msg;
+  converter.distanceMapSliceUpdateMsgFromSlice(0, *window, &map_slice_update_msg);
+  ASSERT_EQ(map_slice_update_msg.data.size(), 8u * 5u);
+  for (int row = 0; row < window->height(); row++) {
+    for (int col = 0; col < window->width(); col++) {
+      EXPECT_EQ(
+        map_slice_update_msg.data[row * window->width() + col],
+        slice(window->min_row + row, window->min_col + col));
+    }
+  }
+
+  // Moving the slice invalidates the comparison.
+  const EsdfSliceGridConverter::Slices moved_slices = {
+    {{&slice, AxisAlignedBoundingBox(Vector3f::Ones(), 2.0F * Vector3f::Ones())},
+      {nullptr, {}}, {nullptr, {}}}};
+  ASSERT_TRUE(converter.convertSliceImages(moved_slices, kUnknownValue));
+  window = converter.changedCellWindow(0);
+  ASSERT_TRUE(window.has_value());
+  EXPECT_EQ(window->width(), kCols);
+  EXPECT_EQ(window->height(), kRows);
+}
+
+// Fill a block of an ESDF layer with distances increasing along an axis. Voxels beyond
+// observed_limit along the axis are unobserved.
+void fillEsdfBlock(
+  const Index3D & block_index, const int axis, const int observed_limit, EsdfLayer * layer)
+{
+  EsdfBlock::Ptr block = layer->allocateBlockAtIndex(block_index);
+  constexpr int kVoxelsPerSide = EsdfBlock::kVoxelsPerSide;
+  for (int x = 0; x < kVoxelsPerSide; x++) {
+    for (int y = 0; y < kVoxelsPerSide; y++) {
+      for (int z = 0; z < kVoxelsPerSide; z++) {
+        const int coordinate = Index3D(x, y, z)[axis];
+        EsdfVoxel & voxel = block->voxels[x][y][z];
+        voxel.observed = coordinate < observed_limit;
+        voxel.squared_distance_vox = static_cast<float>(coordinate * coordinate);
+        voxel.is_inside = coordinate == 0;
+      }
+    }
+  }
+}
+
+Image<float> toHost(const Image<float> & image)
+{
+  Image<float> host_image(MemoryType::kHost);
+  host_image.copyFrom(image);
+  return host_image;
+}
+
+TEST(EsdfSliceGridConversionsTest, FusedLayerSlicesMatchSeparateSlices) {
+  constexpr float kVoxelSize = 0.1F;
+  constexpr float kSliceHeight = 0.25F;
+  constexpr float kPessimisticUnknownValue = -2000.F;
+  EsdfLayer static_layer(kVoxelSize, MemoryType::kUnified);
+  EsdfLayer dynamic_layer(kVoxelSize, MemoryType::kUnified);
+  fillEsdfBlock(Index3D(0, 0, 0), 0, 6, &static_layer);
+  fillEsdfBlock(Index3D(1, 0, 0), 0, 8, &static_layer);
+  fillEsdfBlock(Index3D(0, 0, 0), 1, 4, &dynamic_layer);
+  fillEsdfBlock(Index3D(0, 1, 0), 1, 8, &dynamic_layer);
+
+  EsdfSlicer slicer;
+  const AxisAlignedBoundingBox aabb = slicer.getCombinedAabbOfLayersAtHeight(
+    static_layer, dynamic_layer, kSliceHeight, kSliceHeight);
+  ASSERT_FALSE(aabb.isEmpty());
+
+  // The separate slices.
+  std::array<Image<float>, EsdfSliceGridConverter::kMaxNumSlices> reference_slices = {
+    Image<float>(MemoryType::kDevice), Image<float>(MemoryType::kDevice),
+    Image<float>(MemoryType::kDevice), Image<float>(MemoryType::kDevice)};
+  slicer.sliceLayerToDistanceImage(
+    static_layer, kSliceHeight, kUnknownValue, aabb,
+    &reference_slices[EsdfSliceGridConverter::kStaticSliceIdx]);
+  slicer.sliceLayerToDistanceImage(
+    dynamic_layer, kSliceHeight, kUnknownValue, aabb,
+    &reference_slices[EsdfSliceGridConverter::kDynamicSliceIdx]);
+  slicer.sliceLayersToCombinedDistanceImage(
+    static_layer, dynamic_layer, kSliceHeight, kSliceHeight, kUnknownValue, aabb,
+    &reference_slices[EsdfSliceGridConverter::kCombinedSliceIdx]);
+  slicer.sliceLayerToDistanceImage(
+    static_layer, kSliceHeight, kPessimisticUnknownValue, aabb,
+    &reference_slices[EsdfSliceGridConverter::kPessimisticStaticSliceIdx]);
+
+  // All of them at once.
+  EsdfSliceGridConverter converter;
+  converter.occupied_distance_m(0.15F);
+  converter.free_distance_m(0.55F);
+  EsdfSliceGridConverter::LayerSlices layer_slices;
+  layer_slices.static_layer = &static_layer;
+  layer_slices.dynamic_layer = &dynamic_layer;
+  layer_slices.static_slice_height = kSliceHeight;
+  layer_slices.dynamic_slice_height = kSliceHeight;
+  layer_slices.aabb = aabb;
+  layer_slices.unknown_value = kUnknownValue;
+  layer_slices.pessimistic_unknown_value = kPessimisticUnknownValue;
+  layer_slices.enabled.fill(true);
+  std::array<Image<float>, EsdfSliceGridConverter::kMaxNumSlices> fused_slices = {
+    Image<float>(MemoryType::kDevice), Image<float>(MemoryType::kDevice),
+    Image<float>(MemoryType::kDevice), Image<float>(MemoryType::kDevice)};
+  ASSERT_TRUE(
+    converter.convertLayers(
+      layer_slices,
+      {&fused_slices[0], &fused_slices[1], &fused_slices[2], &fused_slices[3]}));
+
+  for (int i = 0; i < EsdfSliceGridConverter::kMaxNumSlices; i++) {
+    ASSERT_TRUE(converter.hasSlice(i));
+    const Image<float> reference = toHost(reference_slices[i]);
+    const Image<float> fused = toHost(fused_slices[i]);
+    ASSERT_EQ(fused.rows(), reference.rows());
+    ASSERT_EQ(fused.cols(), reference.cols());
+
+    nvblox_msgs::msg::DistanceMapSlice map_slice_msg;
+    converter.distanceMapSliceMsgDataFromSlice(i, &map_slice_msg);
+    ASSERT_EQ(map_slice_msg.data.size(), static_cast<size_t>(reference.numel()));
+    for (int cell = 0; cell < reference.numel(); cell++) {
+      EXPECT_EQ(fused(cell), reference(cell));
+      EXPECT_EQ(map_slice_msg.data[cell], reference(cell));
+    }
+
+    // The occupancy grids match those converted from the separate slices.
+    const float unknown_value = i == EsdfSliceGridConverter::kPessimisticStaticSliceIdx ?
+      kPessimisticUnknownValue : kUnknownValue;
+    EsdfSliceGridConverter reference_converter;
+    reference_converter.occupied_distance_m(0.15F);
+    reference_converter.free_distance_m(0.55F);
+    ASSERT_TRUE(
+      reference_converter.convertSliceImages(
+        {{{&reference_slices[i], aabb}, {nullptr, {}}, {nullptr, {}}, {nullptr, {}}}},
+        unknown_value));
+    nav_msgs::msg::OccupancyGrid grid_msg;
+    nav_msgs::msg::OccupancyGrid reference_grid_msg;
+    converter.occupancyGridMsgDataFromSlice(i, &grid_msg);
+    reference_converter.occupancyGridMsgDataFromSlice(0, &reference_grid_msg);
+    EXPECT_EQ(grid_msg.data, reference_grid_msg.data);
+  }
+
+  // Without a dynamic layer only the static slices are output, and converting them again changes
+  // nothing.
+  layer_slices.dynamic_layer = nullptr;
+  ASSERT_TRUE(converter.convertLayers(layer_slices));
+  ASSERT_TRUE(converter.convertLayers(layer_slices));
+  EXPECT_TRUE(converter.hasSlice(EsdfSliceGridConverter::kStaticSliceIdx));
+  EXPECT_TRUE(converter.hasSlice(EsdfSliceGridConverter::kPessimisticStaticSliceIdx));
+  EXPECT_FALSE(converter.hasSlice(EsdfSliceGridConverter::kDynamicSliceIdx));
+  EXPECT_FALSE(converter.hasSlice(EsdfSliceGridConverter::kCombinedSliceIdx));
+  EXPECT_FALSE(
+    converter.changedCellWindow(EsdfSliceGridConverter::kStaticSliceIdx).has_value());
+}
+
+}  // namespace conversions
+}  // namespace nvblox
+
+int main(int argc, char ** argv)
+{
+  FLAGS_alsologtostderr = true;
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
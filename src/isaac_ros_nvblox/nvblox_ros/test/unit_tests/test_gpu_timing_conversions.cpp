@@ -0,0 +1,91 @@
+// SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+// Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <map>
+#include <string>
+
+#include "nvblox_ros/conversions/gpu_timing_conversions.hpp"
+
+namespace nvblox
+{
+
+std::string getValue(
+  const diagnostic_msgs::msg::DiagnosticStatus & status_msg, const std::string & key)
+{
+  for (const auto & key_value : status_msg.values) {
+    if (key_value.key == key) {
+      return key_value.value;
+    }
+  }
+  return "";
+}
+
+std::map<std::string, timing::GpuTimingStats> makeStats()
+{
+  timing::GpuTimingStats tsdf_stats;
+  tsdf_stats.num_samples = 100;
+  tsdf_stats.mean_ms = 1.5F;
+  tsdf_stats.p50_ms = 1.25F;
+  tsdf_stats.p90_ms = 2.0F;
+  tsdf_stats.p99_ms = 3.5F;
+  tsdf_stats.max_ms = 4.0F;
+  timing::GpuTimingStats esdf_stats;
+  esdf_stats.num_samples = 50;
+  esdf_stats.p99_ms = 0.5F;
+  std::map<std::string, timing::GpuTimingStats> stats;
+  stats["tsdf/integrate/update_blocks"] = tsdf_stats;
+  stats["esdf/integrate/compute/sweep"] = esdf_stats;
+  return stats;
+}
+
+TEST(GpuTimingConversions, DiagnosticStatus) {
+  diagnostic_msgs::msg::DiagnosticStatus status_msg;
+  conversions::gpuTimingToDiagnosticStatusMsg(makeStats(), "gpu_timing", 0.0F, &status_msg);
+  EXPECT_EQ(status_msg.name, "gpu_timing");
+  EXPECT_EQ(status_msg.level, diagnostic_msgs::msg::DiagnosticStatus::OK);
+  EXPECT_EQ(status_msg.values.size(), 12u);
+  EXPECT_EQ(getValue(status_msg, "tsdf/integrate/update_blocks/num_samples"), "100");
+  EXPECT_EQ(getValue(status_msg, "tsdf/integrate/update_blocks/mean_ms"), "1.500");
+  EXPECT_EQ(getValue(status_msg, "tsdf/integrate/update_blocks/p50_ms"), "1.250");
+  EXPECT_EQ(getValue(status_msg, "tsdf/integrate/update_blocks/p99_ms"), "3.500");
+  EXPECT_EQ(getValue(status_msg, "esdf/integrate/compute/sweep/num_samples"), "50");
+}
+
+TEST(GpuTimingConversions, WarnAboveBudget) {
+  diagnostic_msgs::msg::DiagnosticStatus status_msg;
+  conversions::gpuTimingToDiagnosticStatusMsg(makeStats(), "gpu_timing", 5.0F, &status_msg);
+  EXPECT_EQ(status_msg.level, diagnostic_msgs::msg::DiagnosticStatus::OK);
+
+  conversions::gpuTimingToDiagnosticStatusMsg(makeStats(), "gpu_timing", 1.0F, &status_msg);
+  EXPECT_EQ(status_msg.level, diagnostic_msgs::msg::DiagnosticStatus::WARN);
+  EXPECT_NE(status_msg.message.find("tsdf/integrate/update_blocks"), std::string::npos);
+  EXPECT_EQ(status_msg.message.find("esdf/integrate/compute/sweep"), std::string::npos);
+}
+
+}  // namespace nvblox
+
+int main(int argc, char ** argv)
+{
+  FLAGS_alsologtostderr = true;
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
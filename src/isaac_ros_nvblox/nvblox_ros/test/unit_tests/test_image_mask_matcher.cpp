@@ -0,0 +1,132 @@
+// SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+// Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "nvblox_ros/image_mask_matcher.hpp"
+
+namespace nvblox
+{
+
+constexpr int64_t kMatchToleranceNs = 2;
+constexpr int64_t kMaskDeadlineNs = 50;
+constexpr int kBufferSize = 10;
+
+// The image and mask stamps of the callbacks, with a mask of -1 for unmasked images.
+using Matches = std::vector<std::pair<int, int>>;
+
+ImageMaskMatcher<int> makeMatcher(Matches * matches)
+{
+  return ImageMaskMatcher<int>(
+    kMatchToleranceNs, kMaskDeadlineNs, kBufferSize,
+    [matches](const int & image, const int * mask) {
+      matches->emplace_back(image, mask ? *mask : -1);
+    });
+}
+
+TEST(ImageMaskMatcher, MatchesWithinTolerance) {
+  Matches matches;
+  auto matcher = makeMatcher(&matches);
+  matcher.addImage(100, 100);
+  matcher.addMask(101, 101);
+  matcher.addMask(200, 200);
+  matcher.addImage(202, 202);
+  EXPECT_EQ(matches, Matches({{100, 101}, {202, 200}}));
+  EXPECT_EQ(matcher.numMatched(), 2);
+  EXPECT_EQ(matcher.numUnmasked(), 0);
+  EXPECT_EQ(matcher.numDroppedMasks(), 0);
+}
+
+TEST(ImageMaskMatcher, LateMaskExpires) {
+  Matches matches;
+  auto matcher = makeMatcher(&matches);
+  matcher.addImage(100, 100);
+  // Waiting for the mask.
+  matcher.flushExpired(100 + kMaskDeadlineNs);
+  EXPECT_TRUE(matches.empty());
+  // Past the deadline.
+  matcher.flushExpired(100 + kMatchToleranceNs + kMaskDeadlineNs);
+  EXPECT_EQ(matches, Matches({{100, -1}}));
+
+  // The late mask is dropped and doesn't hold up the next image.
+  matcher.addMask(100, 100);
+  matcher.addImage(300, 300);
+  matcher.addMask(300, 300);
+  EXPECT_EQ(matches, Matches({{100, -1}, {300, 300}}));
+  EXPECT_EQ(matcher.numMatched(), 1);
+  EXPECT_EQ(matcher.numUnmasked(), 1);
+  EXPECT_EQ(matcher.numDroppedMasks(), 1);
+}
+
+TEST(ImageMaskMatcher, LaterImagesFlushExpiredImages) {
+  Matches matches;
+  auto matcher = makeMatcher(&matches);
+  // The mask stream stalls.
+  matcher.addImage(100, 100);
+  matcher.addImage(130, 130);
+  EXPECT_TRUE(matches.empty());
+  matcher.addImage(160, 160);
+  EXPECT_EQ(matches, Matches({{100, -1}}));
+  // A mask of a later image passes on the earlier images right away.
+  matcher.addMask(160, 160);
+  EXPECT_EQ(matches, Matches({{100, -1}, {130, -1}, {160, 160}}));
+}
+
+TEST(ImageMaskMatcher, Clear) {
+  Matches matches;
+  auto matcher = makeMatcher(&matches);
+  matcher.addImage(100, 100);
+  matcher.clear();
+  matcher.flushExpired(1000);
+  EXPECT_TRUE(matches.empty());
+}
+
+TEST(ImageMaskMatcher, ReleasesMessages) {
+  // The messages are only referenced by the matcher until they're passed on.
+  std::vector<std::shared_ptr<int>> passed_on;
+  ImageMaskMatcher<std::shared_ptr<int>> matcher(
+    kMatchToleranceNs, kMaskDeadlineNs, kBufferSize,
+    [&passed_on](const std::shared_ptr<int> & image, const std::shared_ptr<int> * mask) {
+      passed_on.push_back(image);
+      EXPECT_NE(mask, nullptr);
+    });
+  auto image = std::make_shared<int>(1);
+  auto mask = std::make_shared<int>(2);
+  matcher.addImage(100, image);
+  matcher.addMask(100, mask);
+  ASSERT_EQ(passed_on.size(), 1u);
+  EXPECT_EQ(passed_on[0], image);
+  // The buffers released the messages.
+  EXPECT_EQ(image.use_count(), 2);
+  EXPECT_EQ(mask.use_count(), 1);
+}
+
+}  // namespace nvblox
+
+int main(int argc, char ** argv)
+{
+  FLAGS_alsologtostderr = true;
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,133 @@
+// SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+// Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "nvblox_ros/input_processing_worker.hpp"
+
+namespace nvblox
+{
+
+// Long enough to not trigger in the tests which rely on notifications.
+constexpr std::chrono::milliseconds kLongFallbackPeriod(60 * 1000);
+
+// Counts the passes, and lets the test wait for them.
+class PassCounter
+{
+public:
+  void count()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      ++num_passes_;
+    }
+    cv_.notify_all();
+  }
+
+  bool waitFor(int num_passes)
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return cv_.wait_for(
+      lock, std::chrono::seconds(10), [&]() {return num_passes_ >= num_passes;});
+  }
+
+  int numPasses()
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return num_passes_;
+  }
+
+private:
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  int num_passes_ = 0;
+};
+
+TEST(InputProcessingWorker, ProcessesOnNotification) {
+  PassCounter counter;
+  std::atomic<std::thread::id> pass_thread_id;
+  InputProcessingWorker worker(
+    [&]() {
+      pass_thread_id = std::this_thread::get_id();
+      counter.count();
+    }, kLongFallbackPeriod);
+  // Sleeps until notified.
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_EQ(counter.numPasses(), 0);
+
+  worker.notify();
+  ASSERT_TRUE(counter.waitFor(1));
+  EXPECT_NE(pass_thread_id.load(), std::this_thread::get_id());
+  worker.notify();
+  ASSERT_TRUE(counter.waitFor(2));
+  EXPECT_EQ(worker.numFallbackPasses(), 0);
+}
+
+TEST(InputProcessingWorker, CoalescesNotificationsDuringPass) {
+  PassCounter counter;
+  std::mutex release_mutex;
+  std::condition_variable release_cv;
+  bool released = false;
+  InputProcessingWorker worker(
+    [&]() {
+      counter.count();
+      // Block the first pass until released.
+      std::unique_lock<std::mutex> lock(release_mutex);
+      release_cv.wait(lock, [&]() {return released;});
+    }, kLongFallbackPeriod);
+
+  worker.notify();
+  ASSERT_TRUE(counter.waitFor(1));
+  // Notifications during the pass aren't lost, but result in a single further pass.
+  for (int i = 0; i < 10; i++) {
+    worker.notify();
+  }
+  {
+    std::lock_guard<std::mutex> lock(release_mutex);
+    released = true;
+  }
+  release_cv.notify_all();
+  ASSERT_TRUE(counter.waitFor(2));
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_EQ(counter.numPasses(), 2);
+  EXPECT_EQ(worker.numPasses(), 2);
+}
+
+TEST(InputProcessingWorker, FallbackPeriod) {
+  PassCounter counter;
+  InputProcessingWorker worker([&]() {counter.count();}, std::chrono::milliseconds(5));
+  ASSERT_TRUE(counter.waitFor(3));
+  EXPECT_GE(worker.numFallbackPasses(), 3);
+}
+
+}  // namespace nvblox
+
+int main(int argc, char ** argv)
+{
+  FLAGS_alsologtostderr = true;
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,105 @@
+// SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+// Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "nvblox_ros/input_queue.hpp"
+
+namespace nvblox
+{
+
+TEST(InputQueue, DropsOldest) {
+  InputQueue<std::shared_ptr<int>> queue(3);
+  EXPECT_TRUE(queue.empty());
+  for (int i = 0; i < 5; i++) {
+    const bool dropped = queue.push(std::make_shared<int>(i));
+    EXPECT_EQ(dropped, i >= 3);
+  }
+  EXPECT_EQ(queue.numDropped(), 2);
+
+  std::vector<std::shared_ptr<int>> items;
+  queue.extractReadyItems([](const std::shared_ptr<int> &) {return true;}, &items);
+  ASSERT_EQ(items.size(), 3u);
+  EXPECT_EQ(*items[0], 2);
+  EXPECT_EQ(*items[1], 3);
+  EXPECT_EQ(*items[2], 4);
+  EXPECT_TRUE(queue.empty());
+}
+
+TEST(InputQueue, HoldsBackItemsNotReady) {
+  InputQueue<int> queue(4);
+  for (int i = 0; i < 4; i++) {
+    queue.push(i);
+  }
+  // Only even items are ready.
+  std::vector<int> items;
+  queue.extractReadyItems([](const int & item) {return item % 2 == 0;}, &items);
+  EXPECT_EQ(items, std::vector<int>({0, 2}));
+  EXPECT_FALSE(queue.empty());
+
+  // The odd items are returned, in order, once they're ready.
+  items.clear();
+  queue.push(4);
+  queue.extractReadyItems([](const int &) {return true;}, &items);
+  EXPECT_EQ(items, std::vector<int>({1, 3, 4}));
+  EXPECT_EQ(queue.numDropped(), 0);
+}
+
+TEST(InputQueue, ConcurrentPushAndExtract) {
+  constexpr int kNumItems = 100000;
+  InputQueue<int> queue(10);
+
+  std::thread producer([&queue]() {
+      for (int i = 0; i < kNumItems; i++) {
+        queue.push(i);
+      }
+    });
+
+  // Items must come out in order, and none must be lost without being counted as dropped. The
+  // last item is the newest, so it is never dropped.
+  std::vector<int> items;
+  int num_received = 0;
+  int last_item = -1;
+  while (last_item != kNumItems - 1) {
+    items.clear();
+    queue.extractReadyItems([](const int &) {return true;}, &items);
+    for (const int item : items) {
+      EXPECT_GT(item, last_item);
+      last_item = item;
+      ++num_received;
+    }
+  }
+  producer.join();
+  EXPECT_EQ(last_item, kNumItems - 1);
+  EXPECT_EQ(num_received + queue.numDropped(), kNumItems);
+}
+
+}  // namespace nvblox
+
+int main(int argc, char ** argv)
+{
+  FLAGS_alsologtostderr = true;
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
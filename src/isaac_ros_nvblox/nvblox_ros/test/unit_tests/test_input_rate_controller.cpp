@@ -0,0 +1,141 @@
+// SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+// Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include <nvblox/utils/timing.h>
+
+#include "nvblox_ros/input_rate_controller.hpp"
+
+namespace nvblox
+{
+
+void recordIntegrationCost(const std::string & timer_tag, int cost_ms)
+{
+  timing::Timer timer(timer_tag);
+  std::this_thread::sleep_for(std::chrono::milliseconds(cost_ms));
+}
+
+int64_t frameStampNs(int frame_idx, float rate_hz)
+{
+  return static_cast<int64_t>(frame_idx * 1e9 / rate_hz);
+}
+
+TEST(InputRateController, IntegratesEverythingWithoutTimings) {
+  InputRateController controller({"test/untimed_integrate"});
+  const auto camera = controller.registerCamera("camera_0");
+  for (int i = 0; i < 100; i++) {
+    EXPECT_TRUE(controller.shouldIntegrate(camera, frameStampNs(i, 30.F)));
+  }
+  EXPECT_EQ(controller.numSkipped(camera), 0);
+  EXPECT_NEAR(controller.inputRateHz(camera), 30.F, 0.1F);
+}
+
+TEST(InputRateController, SharesBudgetByWeight) {
+  const std::string kTimerTag = "test/weighted_integrate";
+  InputRateController controller({kTimerTag});
+  controller.target_utilization(0.8F);
+  const auto front_camera = controller.registerCamera("camera_0", 2.F);
+  const auto side_camera = controller.registerCamera("camera_1", 1.F);
+
+  // 20ms per frame at 80% utilization leaves 40 frames per second, i.e. less than the 60 Hz the
+  // two cameras produce.
+  recordIntegrationCost(kTimerTag, 20);
+  constexpr float kInputRateHz = 30.F;
+  constexpr int kNumFrames = 300;
+  int num_integrated_front = 0;
+  int num_integrated_side = 0;
+  int max_consecutive_skips_front = 0;
+  int consecutive_skips_front = 0;
+  for (int i = 0; i < kNumFrames; i++) {
+    const int64_t stamp_ns = frameStampNs(i, kInputRateHz);
+    if (controller.shouldIntegrate(front_camera, stamp_ns)) {
+      ++num_integrated_front;
+      consecutive_skips_front = 0;
+    } else {
+      ++consecutive_skips_front;
+      max_consecutive_skips_front = std::max(max_consecutive_skips_front, consecutive_skips_front);
+    }
+    if (controller.shouldIntegrate(side_camera, stamp_ns)) {
+      ++num_integrated_side;
+    }
+  }
+  const float budget_hz = controller.target_utilization() / (controller.integrationCostMs() / 1e3F);
+  EXPECT_LE(budget_hz, 40.F);
+  EXPECT_NEAR(controller.allowedRateHz(front_camera), 2.F / 3.F * budget_hz, 0.5F);
+  EXPECT_NEAR(controller.allowedRateHz(side_camera), 1.F / 3.F * budget_hz, 0.5F);
+
+  // The skipped frames are spread out rather than dropped in bursts.
+  const float duration_s = kNumFrames / kInputRateHz;
+  EXPECT_NEAR(num_integrated_front, controller.allowedRateHz(front_camera) * duration_s, 5);
+  EXPECT_NEAR(num_integrated_side, controller.allowedRateHz(side_camera) * duration_s, 5);
+  EXPECT_LE(max_consecutive_skips_front, 1);
+  EXPECT_EQ(controller.numSkipped(front_camera), kNumFrames - num_integrated_front);
+}
+
+TEST(InputRateController, SlowCamerasLeaveBudgetToOthers) {
+  const std::string kTimerTag = "test/slow_camera_integrate";
+  InputRateController controller({kTimerTag});
+  controller.target_utilization(0.8F);
+  const auto slow_camera = controller.registerCamera("camera_0");
+  const auto fast_camera = controller.registerCamera("camera_1");
+
+  recordIntegrationCost(kTimerTag, 20);
+  constexpr float kSlowRateHz = 5.F;
+  constexpr float kFastRateHz = 60.F;
+  for (int i = 0; i < 120; i++) {
+    if (i % 12 == 0) {
+      EXPECT_TRUE(controller.shouldIntegrate(slow_camera, frameStampNs(i / 12, kSlowRateHz)));
+    }
+    controller.shouldIntegrate(fast_camera, frameStampNs(i, kFastRateHz));
+  }
+  const float budget_hz = controller.target_utilization() / (controller.integrationCostMs() / 1e3F);
+  EXPECT_NEAR(controller.allowedRateHz(slow_camera), kSlowRateHz, 0.1F);
+  EXPECT_NEAR(controller.allowedRateHz(fast_camera), budget_hz - kSlowRateHz, 0.5F);
+  EXPECT_EQ(controller.numSkipped(slow_camera), 0);
+  EXPECT_GT(controller.numSkipped(fast_camera), 0);
+}
+
+TEST(InputRateController, MinimumRate) {
+  const std::string kTimerTag = "test/expensive_integrate";
+  InputRateController controller({kTimerTag});
+  controller.min_rate_hz(2.F);
+  const auto camera = controller.registerCamera("camera_0");
+
+  // A budget of less than a frame per second is raised to the minimum rate.
+  recordIntegrationCost(kTimerTag, 1000);
+  for (int i = 0; i < 30; i++) {
+    controller.shouldIntegrate(camera, frameStampNs(i, 30.F));
+  }
+  EXPECT_NEAR(controller.allowedRateHz(camera), 2.F, 1e-3F);
+}
+
+}  // namespace nvblox
+
+int main(int argc, char ** argv)
+{
+  FLAGS_alsologtostderr = true;
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,131 @@
+// SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+// Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include <nvblox/utils/delays.h>
+
+#include "nvblox_ros/latency_tracker.hpp"
+
+namespace nvblox
+{
+
+constexpr int64_t kMsToNs = 1000000;
+
+Time ms(int64_t milliseconds)
+{
+  return Time(milliseconds * kMsToNs);
+}
+
+TEST(LatencyTracker, AgeAndQueueWait) {
+  LatencyTracker tracker;
+  tracker.inputReceived("camera_0", ms(100), ms(110));
+  tracker.inputIntegrated("camera_0", ms(100), ms(130));
+
+  const std::vector<SourceLatency> latencies = tracker.outputPublished("age_test", "", ms(150));
+  ASSERT_EQ(latencies.size(), 1u);
+  EXPECT_EQ(latencies[0].source, "camera_0");
+  EXPECT_EQ(latencies[0].input_stamp, ms(100));
+  EXPECT_EQ(latencies[0].age, ms(50));
+  EXPECT_EQ(latencies[0].queue_wait, ms(20));
+
+  EXPECT_TRUE(timing::Delays::exists("ros/latency/camera_0/queue_wait"));
+  EXPECT_TRUE(timing::Delays::exists("ros/latency/age_test/camera_0/age"));
+  EXPECT_NEAR(
+    timing::Delays::getRollingMeanDelayInSeconds("ros/latency/age_test/camera_0/age"), 0.05,
+    1e-6);
+}
+
+TEST(LatencyTracker, OutputsUseStageSnapshot) {
+  LatencyTracker tracker;
+  tracker.inputReceived("camera_0", ms(100), ms(100));
+  tracker.inputIntegrated("camera_0", ms(100), ms(100));
+  tracker.inputReceived("camera_1", ms(105), ms(105));
+  tracker.inputIntegrated("camera_1", ms(105), ms(110));
+  tracker.stageCompleted("esdf");
+
+  // Integrated after the ESDF was computed, so not part of its outputs.
+  tracker.inputReceived("camera_0", ms(120), ms(120));
+  tracker.inputIntegrated("camera_0", ms(120), ms(125));
+
+  std::vector<SourceLatency> latencies = tracker.outputPublished("slice", "esdf", ms(200));
+  ASSERT_EQ(latencies.size(), 2u);
+  EXPECT_EQ(latencies[0].source, "camera_0");
+  EXPECT_EQ(latencies[0].age, ms(100));
+  EXPECT_EQ(latencies[1].source, "camera_1");
+  EXPECT_EQ(latencies[1].age, ms(95));
+  EXPECT_EQ(latencies[1].queue_wait, ms(5));
+
+  // Without a stage the newest integrated inputs are used.
+  latencies = tracker.outputPublished("mesh", "", ms(200));
+  ASSERT_EQ(latencies.size(), 2u);
+  EXPECT_EQ(latencies[0].age, ms(80));
+}
+
+TEST(LatencyTracker, OutOfOrderAndDroppedInputs) {
+  LatencyTracker tracker;
+  tracker.max_num_pending_inputs(2);
+  tracker.inputReceived("camera_0", ms(100), ms(100));
+  tracker.inputReceived("camera_0", ms(110), ms(110));
+  tracker.inputReceived("camera_0", ms(120), ms(120));
+  // The oldest pending input was forgotten, so it didn't wait.
+  tracker.inputIntegrated("camera_0", ms(100), ms(130));
+  std::vector<SourceLatency> latencies = tracker.outputPublished("slice", "", ms(130));
+  ASSERT_EQ(latencies.size(), 1u);
+  EXPECT_EQ(latencies[0].queue_wait, ms(0));
+
+  // Older inputs don't replace newer ones.
+  tracker.inputIntegrated("camera_0", ms(120), ms(140));
+  tracker.inputIntegrated("camera_0", ms(110), ms(150));
+  latencies = tracker.outputPublished("slice", "", ms(150));
+  EXPECT_EQ(latencies[0].input_stamp, ms(120));
+  EXPECT_EQ(latencies[0].queue_wait, ms(20));
+}
+
+TEST(LatencyTracker, DiagnosticStatus) {
+  const std::vector<SourceLatency> latencies{
+    SourceLatency{"camera_0", ms(100), ms(50), ms(20)},
+    SourceLatency{"camera_1", ms(100), ms(250), ms(5)}};
+  diagnostic_msgs::msg::DiagnosticStatus status_msg;
+  conversions::latencyToDiagnosticStatusMsg("slice", latencies, 0.F, &status_msg);
+  EXPECT_EQ(status_msg.name, "slice");
+  EXPECT_EQ(status_msg.level, diagnostic_msgs::msg::DiagnosticStatus::OK);
+  ASSERT_EQ(status_msg.values.size(), 4u);
+  EXPECT_EQ(status_msg.values[0].key, "camera_0/age_ms");
+  EXPECT_EQ(status_msg.values[0].value, "50.00");
+  EXPECT_EQ(status_msg.values[1].key, "camera_0/queue_wait_ms");
+  EXPECT_EQ(status_msg.values[1].value, "20.00");
+
+  conversions::latencyToDiagnosticStatusMsg("slice", latencies, 100.F, &status_msg);
+  EXPECT_EQ(status_msg.level, diagnostic_msgs::msg::DiagnosticStatus::WARN);
+  EXPECT_EQ(status_msg.message, "Input age above maximum: camera_1");
+}
+
+}  // namespace nvblox
+
+int main(int argc, char ** argv)
+{
+  FLAGS_alsologtostderr = true;
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
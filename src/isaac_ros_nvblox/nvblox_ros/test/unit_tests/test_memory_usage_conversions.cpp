@@ -0,0 +1,103 @@
+// SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+// Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "nvblox_ros/conversions/memory_usage_conversions.hpp"
+
+namespace nvblox
+{
+
+constexpr size_t kMiB = 1024 * 1024;
+
+std::string getValue(
+  const diagnostic_msgs::msg::DiagnosticStatus & status_msg, const std::string & key)
+{
+  for (const auto & key_value : status_msg.values) {
+    if (key_value.key == key) {
+      return key_value.value;
+    }
+  }
+  return "";
+}
+
+MapperMemoryUsage makeMemoryUsage()
+{
+  MapperMemoryUsage usage;
+  LayerMemoryUsage tsdf_usage;
+  tsdf_usage.memory_type = MemoryType::kDevice;
+  tsdf_usage.blocks.allocated_bytes = 300 * kMiB;
+  tsdf_usage.blocks.used_bytes = 100 * kMiB;
+  tsdf_usage.gpu_hash.allocated_bytes = 4 * kMiB;
+  tsdf_usage.gpu_hash.used_bytes = 1 * kMiB;
+  tsdf_usage.gpu_hash_statistics.load_factor_history = {0.2F, 0.25F};
+  tsdf_usage.gpu_hash_statistics.peak_load_factor = 0.4F;
+  tsdf_usage.gpu_hash_statistics.num_synchronous_rehashes = 1;
+  tsdf_usage.gpu_hash_statistics.num_staged_rehashes = 2;
+  tsdf_usage.gpu_hash_statistics.max_rehash_seconds = 0.003;
+  tsdf_usage.gpu_hash_statistics.probe_length_histogram[0] = 3;
+  tsdf_usage.gpu_hash_statistics.probe_length_histogram[1] = 1;
+  usage.layers.emplace_back("tsdf", tsdf_usage);
+  usage.device_memory_pool.allocated_bytes = 200 * kMiB;
+  usage.device_memory_pool.used_bytes = 100 * kMiB;
+  usage.device_total_bytes = 1000 * kMiB;
+  usage.device_free_bytes = 200 * kMiB;
+  return usage;
+}
+
+TEST(MemoryUsageConversions, IdleMemoryIsNotInUse) {
+  const MapperMemoryUsage usage = makeMemoryUsage();
+  // 800 MiB used by the device, of which 200 MiB idle in the block pool and 100 MiB idle in the
+  // memory pool.
+  EXPECT_EQ(usage.deviceBytesInUse(), 500 * kMiB);
+  EXPECT_FLOAT_EQ(usage.devicePressure(), 0.5F);
+}
+
+TEST(MemoryUsageConversions, DiagnosticStatus) {
+  const MapperMemoryUsage usage = makeMemoryUsage();
+  diagnostic_msgs::msg::DiagnosticStatus status_msg;
+  conversions::memoryUsageToDiagnosticStatusMsg(usage, "mapper", 0.9F, &status_msg);
+  EXPECT_EQ(status_msg.name, "mapper");
+  EXPECT_EQ(status_msg.level, diagnostic_msgs::msg::DiagnosticStatus::OK);
+  EXPECT_EQ(getValue(status_msg, "device_pressure"), "0.50");
+  EXPECT_EQ(getValue(status_msg, "tsdf_blocks_allocated_mb"), "300.00");
+  EXPECT_EQ(getValue(status_msg, "tsdf_blocks_used_mb"), "100.00");
+  EXPECT_EQ(getValue(status_msg, "tsdf_gpu_hash_allocated_mb"), "4.00");
+  EXPECT_EQ(getValue(status_msg, "device_memory_pool_used_mb"), "100.00");
+  EXPECT_EQ(getValue(status_msg, "tsdf_gpu_hash_load_factor"), "0.25");
+  EXPECT_EQ(getValue(status_msg, "tsdf_gpu_hash_peak_load_factor"), "0.40");
+  EXPECT_EQ(getValue(status_msg, "tsdf_gpu_hash_rehashes"), "3.00");
+  EXPECT_EQ(getValue(status_msg, "tsdf_gpu_hash_max_rehash_ms"), "3.00");
+  EXPECT_EQ(getValue(status_msg, "tsdf_gpu_hash_mean_probe_length"), "1.25");
+
+  conversions::memoryUsageToDiagnosticStatusMsg(usage, "mapper", 0.4F, &status_msg);
+  EXPECT_EQ(status_msg.level, diagnostic_msgs::msg::DiagnosticStatus::WARN);
+}
+
+}  // namespace nvblox
+
+int main(int argc, char ** argv)
+{
+  FLAGS_alsologtostderr = true;
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
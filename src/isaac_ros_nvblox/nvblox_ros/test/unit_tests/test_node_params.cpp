@@ -52,7 +52,7 @@ void testParamSize(const int expected_param_size, const int actual_param_size)
 }
 
 TEST(BaseNodeParams, initialize) {
-  constexpr size_t kExpectedParamSize = 480;
+  constexpr size_t kExpectedParamSize = 512;
   testParamSize(kExpectedParamSize, sizeof(BaseNodeParams));
 
   auto node = std::make_shared<rclcpp::Node>("node", rclcpp::NodeOptions());
@@ -67,6 +67,7 @@ TEST(BaseNodeParams, initialize) {
   testParam<float>(node.get(), params.layer_visualization_exclusion_height_m);
   testParam<float>(node.get(), params.layer_visualization_exclusion_radius_m);
   testParam<float>(node.get(), params.layer_streamer_bandwidth_limit_mbps);
+  testParam<bool>(node.get(), params.layer_streamer_use_loaned_messages);
 
   testStringParam(node.get(), params.esdf_mode_str);
   EXPECT_EQ(params.esdf_mode, EsdfMode::k2D);
@@ -75,7 +76,7 @@ TEST(BaseNodeParams, initialize) {
 }
 
 TEST(NvbloxNodeParams, initialize) {
-  constexpr size_t kExpectedParamSize = 2008;
+  constexpr size_t kExpectedParamSize = 2832;
   testParamSize(kExpectedParamSize, sizeof(NvbloxNodeParams));
 
   auto node = std::make_shared<rclcpp::Node>("node", rclcpp::NodeOptions());
@@ -90,6 +91,7 @@ TEST(NvbloxNodeParams, initialize) {
   testStringParam(node.get(), params.after_shutdown_map_save_path);
   testStringParam(node.get(), params.esdf_slice_bounds_visualization_attachment_frame_id);
   testStringParam(node.get(), params.workspace_height_bounds_visualization_attachment_frame_id);
+  testStringParam(node.get(), params.flight_recorder_output_dir);
 
   testParam<bool>(node.get(), params.print_timings_to_console);
   testParam<bool>(node.get(), params.print_rates_to_console);
@@ -99,6 +101,15 @@ TEST(NvbloxNodeParams, initialize) {
   testParam<bool>(node.get(), params.publish_esdf_distance_slice);
   testParam<bool>(node.get(), params.use_color);
   testParam<bool>(node.get(), params.use_lidar);
+  testParam<bool>(node.get(), params.use_nitros_pointcloud);
+  testParam<bool>(node.get(), params.esdf_on_separate_thread);
+  testParam<bool>(node.get(), params.use_thread_topology);
+  testParam<bool>(node.get(), params.event_driven_input_processing);
+  testParam<bool>(node.get(), params.publish_slice_updates);
+  testParam<bool>(node.get(), params.adaptive_input_rate);
+  testParam<bool>(node.get(), params.publish_voxel_state_grid);
+  testParam<bool>(node.get(), params.voxel_state_grid_include_distances);
+  testParam<bool>(node.get(), params.use_flight_recorder);
   testParam<bool>(node.get(), params.layer_visualization_undo_gamma_correction);
   testParam<bool>(node.get(), params.use_segmentation);
 
@@ -106,7 +117,11 @@ TEST(NvbloxNodeParams, initialize) {
   testParam<int>(node.get(), params.back_projection_subsampling);
   testParam<int>(node.get(), params.tick_period_ms);
   testParam<int>(node.get(), params.print_statistics_on_console_period_ms);
+  testParam<int>(node.get(), params.metrics_port);
   testParam<int>(node.get(), params.num_cameras);
+  testParam<int>(node.get(), params.full_slice_publish_interval);
+  testParam<int>(node.get(), params.mask_desired_height);
+  testParam<int>(node.get(), params.mask_desired_width);
   testParam<int>(node.get(), params.lidar_width);
   testParam<int>(node.get(), params.lidar_height);
 
@@ -127,12 +142,22 @@ TEST(NvbloxNodeParams, initialize) {
   testParam<float>(node.get(), params.decay_tsdf_rate_hz);
   testParam<float>(node.get(), params.decay_dynamic_occupancy_rate_hz);
   testParam<float>(node.get(), params.clear_map_outside_radius_rate_hz);
+  testParam<float>(node.get(), params.flight_recorder_window_s);
+  testParam<float>(node.get(), params.flight_recorder_latency_threshold_ms);
+  testParam<float>(node.get(), params.mask_match_tolerance_ms);
+  testParam<float>(node.get(), params.mask_deadline_ms);
+  testParam<float>(node.get(), params.adaptive_input_rate_target_utilization);
+  testParam<float>(node.get(), params.adaptive_input_rate_front_camera_weight);
   testParam<float>(node.get(), params.esdf_and_gradients_unobserved_value);
+  testParam<bool>(node.get(), params.esdf_and_gradients_async_response);
+  testParam<bool>(node.get(), params.esdf_and_gradients_include_gradients);
   testParam<float>(node.get(), params.map_clearing_radius_m);
+  testParam<float>(node.get(), params.voxel_state_grid_radius_m);
+  testParam<float>(node.get(), params.esdf_slice_radius_m);
 }
 
 TEST(FuserNodeParams, initialize) {
-  constexpr size_t kExpectedParamSize = 920;
+  constexpr size_t kExpectedParamSize = 952;
   testParamSize(kExpectedParamSize, sizeof(FuserNodeParams));
 
   auto node = std::make_shared<rclcpp::Node>("node", rclcpp::NodeOptions());
@@ -0,0 +1,104 @@
+// SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+// Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include "nvblox_ros/output_graph.hpp"
+
+namespace nvblox
+{
+
+TEST(OutputGraph, WorkIsNeededOnlyWithDemand) {
+  OutputGraph graph;
+  bool static_slice_demand = false;
+  bool combined_slice_demand = false;
+  bool back_projected_depth_demand = false;
+
+  // Static and combined ESDF both need the static slice. Only the combined output needs the
+  // combined slice.
+  const auto static_slice = graph.addWork("static_slice");
+  const auto combined_slice = graph.addWork("combined_slice", {static_slice});
+  const auto back_projection = graph.addWork("back_projection");
+  const auto static_output =
+    graph.addOutput("static_map_slice", [&]() {return static_slice_demand;}, {static_slice});
+  const auto combined_output = graph.addOutput(
+    "combined_map_slice", [&]() {return combined_slice_demand;}, {combined_slice});
+  graph.addOutput(
+    "back_projected_depth", [&]() {return back_projected_depth_demand;}, {back_projection});
+  EXPECT_EQ(graph.size(), 6u);
+  EXPECT_EQ(graph.name(combined_slice), "combined_slice");
+
+  // Nothing is consumed.
+  graph.update();
+  EXPECT_FALSE(graph.isNeeded(static_slice));
+  EXPECT_FALSE(graph.isNeeded(combined_slice));
+  EXPECT_FALSE(graph.isNeeded(back_projection));
+  EXPECT_FALSE(graph.isNeeded(static_output));
+
+  // Demand propagates through the inputs of inputs.
+  combined_slice_demand = true;
+  graph.update();
+  EXPECT_TRUE(graph.isNeeded(combined_output));
+  EXPECT_TRUE(graph.isNeeded(combined_slice));
+  EXPECT_TRUE(graph.isNeeded(static_slice));
+  EXPECT_FALSE(graph.isNeeded(static_output));
+  EXPECT_FALSE(graph.isNeeded(back_projection));
+
+  // Demand is only re-evaluated on update().
+  combined_slice_demand = false;
+  static_slice_demand = true;
+  EXPECT_TRUE(graph.isNeeded(combined_slice));
+  graph.update();
+  EXPECT_FALSE(graph.isNeeded(combined_slice));
+  EXPECT_TRUE(graph.isNeeded(static_slice));
+}
+
+TEST(OutputGraph, RequestsLastOneUpdate) {
+  OutputGraph graph;
+  const auto slice = graph.addWork("slice");
+  const auto esdf = graph.addWork("esdf", {slice});
+  graph.addOutput("pointcloud", []() {return false;}, {esdf});
+
+  // E.g. a service call needing the ESDF.
+  graph.requestForNextUpdate(esdf);
+  graph.update();
+  EXPECT_TRUE(graph.isNeeded(esdf));
+  EXPECT_TRUE(graph.isNeeded(slice));
+
+  graph.update();
+  EXPECT_FALSE(graph.isNeeded(esdf));
+  EXPECT_FALSE(graph.isNeeded(slice));
+}
+
+TEST(OutputGraph, InputsMustExist) {
+  OutputGraph graph;
+  const auto work = graph.addWork("work");
+  EXPECT_DEATH(graph.addWork("consumer", {work + 1}), "");
+  EXPECT_DEATH(graph.isNeeded(-1), "");
+}
+
+}  // namespace nvblox
+
+int main(int argc, char ** argv)
+{
+  FLAGS_alsologtostderr = true;
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,133 @@
+// SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+// Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <nvblox/nvblox.h>
+
+#include <cstdlib>
+#include <vector>
+
+#include "nvblox_ros/conversions/pinned_image_conversions.hpp"
+
+namespace nvblox
+{
+
+// (Y, U, V) of black, white, red, green and blue, in BT.601 limited range.
+constexpr int kNumTestColors = 5;
+constexpr uint8_t kYuv[kNumTestColors][3] = {
+  {16, 128, 128}, {235, 128, 128}, {81, 90, 240}, {145, 54, 34}, {41, 240, 110}};
+const Color kRgb[kNumTestColors] = {
+  Color(0, 0, 0), Color(255, 255, 255), Color(255, 0, 0), Color(0, 255, 0), Color(0, 0, 255)};
+
+// The conversion is in fixed point and the test colors are rounded.
+constexpr int kMaxChannelError = 3;
+
+void expectColorNear(const Color & color, const Color & expected)
+{
+  EXPECT_LE(std::abs(color.r - expected.r), kMaxChannelError);
+  EXPECT_LE(std::abs(color.g - expected.g), kMaxChannelError);
+  EXPECT_LE(std::abs(color.b - expected.b), kMaxChannelError);
+  EXPECT_EQ(color.a, 255);
+}
+
+TEST(PinnedImageConversions, Nv12) {
+  // Each 2x2 patch of pixels has one of the test colors.
+  constexpr int kHeight = 4;
+  constexpr int kWidth = 2 * kNumTestColors;
+  std::vector<uint8_t> nv12(kHeight * kWidth * 3 / 2);
+  for (int row = 0; row < kHeight; row++) {
+    for (int col = 0; col < kWidth; col++) {
+      nv12[row * kWidth + col] = kYuv[col / 2][0];
+    }
+  }
+  for (int row = 0; row < kHeight / 2; row++) {
+    for (int col = 0; col < kWidth / 2; col++) {
+      uint8_t * uv = nv12.data() + kHeight * kWidth + row * kWidth + col * 2;
+      uv[0] = kYuv[col][1];
+      uv[1] = kYuv[col][2];
+    }
+  }
+
+  CudaStreamOwning cuda_stream;
+  ColorImage color_image(MemoryType::kUnified);
+  Image<uint8_t> staging_image(MemoryType::kHost);
+  ASSERT_TRUE(
+    conversions::rgbaFromNv12HostPinnedAsync(
+      nv12.data(), kHeight, kWidth, &color_image, &staging_image, cuda_stream));
+  cuda_stream.synchronize();
+
+  ASSERT_EQ(color_image.rows(), kHeight);
+  ASSERT_EQ(color_image.cols(), kWidth);
+  for (int row = 0; row < kHeight; row++) {
+    for (int col = 0; col < kWidth; col++) {
+      expectColorNear(color_image(row, col), kRgb[col / 2]);
+    }
+  }
+
+  // Odd sizes have no NV12 layout.
+  EXPECT_FALSE(
+    conversions::rgbaFromNv12HostPinnedAsync(
+      nv12.data(), kHeight - 1, kWidth, &color_image, &staging_image, cuda_stream));
+}
+
+TEST(PinnedImageConversions, Yuyv) {
+  // Each pair of pixels has one of the test colors, with a black second pixel.
+  constexpr int kHeight = 3;
+  constexpr int kWidth = 2 * kNumTestColors;
+  std::vector<uint8_t> yuyv(kHeight * kWidth * 2);
+  for (int row = 0; row < kHeight; row++) {
+    for (int pair = 0; pair < kNumTestColors; pair++) {
+      uint8_t * yuyv_pair = yuyv.data() + (row * kWidth + pair * 2) * 2;
+      yuyv_pair[0] = kYuv[pair][0];
+      yuyv_pair[1] = kYuv[pair][1];
+      yuyv_pair[2] = 16;
+      yuyv_pair[3] = kYuv[pair][2];
+    }
+  }
+
+  CudaStreamOwning cuda_stream;
+  ColorImage color_image(MemoryType::kUnified);
+  Image<uint8_t> staging_image(MemoryType::kHost);
+  ASSERT_TRUE(
+    conversions::rgbaFromYuyvHostPinnedAsync(
+      yuyv.data(), kHeight, kWidth, &color_image, &staging_image, cuda_stream));
+  cuda_stream.synchronize();
+
+  ASSERT_EQ(color_image.rows(), kHeight);
+  ASSERT_EQ(color_image.cols(), kWidth);
+  for (int row = 0; row < kHeight; row++) {
+    for (int col = 0; col < kWidth; col += 2) {
+      expectColorNear(color_image(row, col), kRgb[col / 2]);
+    }
+  }
+  // Only for the grey pairs, the chroma of the pair leaves the second pixel black.
+  expectColorNear(color_image(0, 1), kRgb[0]);
+  expectColorNear(color_image(0, 3), kRgb[0]);
+}
+
+}  // namespace nvblox
+
+int main(int argc, char ** argv)
+{
+  FLAGS_alsologtostderr = true;
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
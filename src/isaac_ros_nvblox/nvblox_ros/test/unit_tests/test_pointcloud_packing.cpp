@@ -0,0 +1,118 @@
+// SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+// Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <nvblox/nvblox.h>
+
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include "nvblox_ros/conversions/pointcloud_packing.hpp"
+
+namespace nvblox
+{
+
+std::vector<conversions::PclPointXYZI> pointsFromMsg(const sensor_msgs::msg::PointCloud2 & msg)
+{
+  std::vector<conversions::PclPointXYZI> points(msg.width);
+  std::memcpy(points.data(), msg.data.data(), msg.data.size());
+  return points;
+}
+
+TEST(GpuPointcloudPacker, SliceImage) {
+  constexpr int kRows = 3;
+  constexpr int kCols = 4;
+  constexpr float kUnknownValue = -1000.F;
+  Image<float> slice_image(kRows, kCols, MemoryType::kUnified);
+  int num_observed = 0;
+  for (int row = 0; row < kRows; row++) {
+    for (int col = 0; col < kCols; col++) {
+      // Every other cell is unknown.
+      const bool is_observed = (row + col) % 2 == 0;
+      slice_image(row, col) = is_observed ? static_cast<float>(row * kCols + col) : kUnknownValue;
+      num_observed += is_observed;
+    }
+  }
+
+  constexpr float kVoxelSize = 0.1F;
+  constexpr float kSliceHeight = 0.5F;
+  const AxisAlignedBoundingBox aabb(Vector3f(1.F, 2.F, 0.F), Vector3f(1.4F, 2.3F, 1.F));
+  conversions::GpuPointcloudPacker packer;
+  sensor_msgs::msg::PointCloud2 msg;
+  packer.pointcloudMsgFromSliceImage(
+    slice_image, aabb, kSliceHeight, kVoxelSize, kUnknownValue, &msg);
+
+  ASSERT_EQ(msg.fields.size(), 4U);
+  EXPECT_EQ(msg.fields[3].name, "intensity");
+  EXPECT_EQ(msg.point_step, sizeof(conversions::PclPointXYZI));
+  ASSERT_EQ(msg.width, static_cast<uint32_t>(num_observed));
+  ASSERT_EQ(msg.data.size(), num_observed * sizeof(conversions::PclPointXYZI));
+
+  // Points keep the order of the cells.
+  constexpr float kEps = 1e-5;
+  int point_idx = 0;
+  const auto points = pointsFromMsg(msg);
+  for (int row = 0; row < kRows; row++) {
+    for (int col = 0; col < kCols; col++) {
+      if ((row + col) % 2 != 0) {
+        continue;
+      }
+      const auto & point = points[point_idx++];
+      EXPECT_NEAR(point.x, 1.F + kVoxelSize * (col + 0.5F), kEps);
+      EXPECT_NEAR(point.y, 2.F + kVoxelSize * (row + 0.5F), kEps);
+      EXPECT_NEAR(point.z, kSliceHeight, kEps);
+      EXPECT_NEAR(point.intensity, row * kCols + col, kEps);
+    }
+  }
+}
+
+TEST(GpuPointcloudPacker, Pointcloud) {
+  const std::vector<Vector3f> points = {Vector3f(1.F, 2.F, 3.F),
+    Vector3f(std::numeric_limits<float>::quiet_NaN(), 0.F, 0.F), Vector3f(-1.F, 0.F, 4.F)};
+  Pointcloud pointcloud(MemoryType::kUnified);
+  CudaStreamOwning cuda_stream;
+  pointcloud.copyFromAsync(points, cuda_stream);
+  cuda_stream.synchronize();
+
+  conversions::GpuPointcloudPacker packer;
+  sensor_msgs::msg::PointCloud2 msg;
+  packer.pointcloudMsgFromPointcloud(pointcloud, &msg);
+  ASSERT_EQ(msg.width, 2U);
+  const auto msg_points = pointsFromMsg(msg);
+  EXPECT_EQ(msg_points[0].x, 1.F);
+  EXPECT_EQ(msg_points[1].z, 4.F);
+  EXPECT_EQ(msg_points[1].intensity, 0.F);
+
+  // An empty pointcloud gives an empty message.
+  packer.pointcloudMsgFromPointcloud(Pointcloud(MemoryType::kUnified), &msg);
+  EXPECT_EQ(msg.width, 0U);
+  EXPECT_TRUE(msg.data.empty());
+}
+
+}  // namespace nvblox
+
+int main(int argc, char ** argv)
+{
+  FLAGS_alsologtostderr = true;
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,168 @@
+// SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+// Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+
+#include "ament_index_cpp/get_package_share_directory.hpp"
+#include "rclcpp/serialization.hpp"
+#include "rclcpp/serialized_message.hpp"
+#include "sensor_msgs/msg/camera_info.hpp"
+#include "sensor_msgs/msg/image.hpp"
+
+#include "nvblox_ros/indexed_rosbag_data_loader.hpp"
+#include "nvblox_ros/rosbag_frame_index.hpp"
+
+namespace nvblox
+{
+
+using datasets::ros::RosbagFrameIndexEntry;
+using datasets::ros::StampedBagMessage;
+
+template<typename MessageType>
+std::optional<uint64_t> serializeAndPeek(const MessageType & msg)
+{
+  rclcpp::Serialization<MessageType> serialization;
+  rclcpp::SerializedMessage serialized_msg;
+  serialization.serialize_message(&msg, &serialized_msg);
+  const auto & rcl_msg = serialized_msg.get_rcl_serialized_message();
+  return datasets::ros::peekHeaderStampNs(rcl_msg.buffer, rcl_msg.buffer_length);
+}
+
+TEST(RosbagFrameIndexTest, PeekHeaderStamp) {
+  sensor_msgs::msg::Image image_msg;
+  image_msg.header.stamp.sec = 12;
+  image_msg.header.stamp.nanosec = 345;
+  image_msg.header.frame_id = "camera";
+  auto stamp_ns = serializeAndPeek(image_msg);
+  ASSERT_TRUE(stamp_ns.has_value());
+  EXPECT_EQ(*stamp_ns, 12000000345ULL);
+
+  sensor_msgs::msg::CameraInfo camera_info_msg;
+  camera_info_msg.header.stamp.sec = 1;
+  camera_info_msg.header.stamp.nanosec = 999999999;
+  stamp_ns = serializeAndPeek(camera_info_msg);
+  ASSERT_TRUE(stamp_ns.has_value());
+  EXPECT_EQ(*stamp_ns, 1999999999ULL);
+
+  // Big endian CDR.
+  const uint8_t big_endian_msg[] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02,
+    0x00, 0x00, 0x00, 0x03};
+  stamp_ns = datasets::ros::peekHeaderStampNs(big_endian_msg, sizeof(big_endian_msg));
+  ASSERT_TRUE(stamp_ns.has_value());
+  EXPECT_EQ(*stamp_ns, 2000000003ULL);
+
+  // Too short or not CDR.
+  EXPECT_FALSE(datasets::ros::peekHeaderStampNs(big_endian_msg, 8).has_value());
+  const uint8_t not_cdr_msg[] = {0x00, 0x07, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02,
+    0x00, 0x00, 0x00, 0x03};
+  EXPECT_FALSE(datasets::ros::peekHeaderStampNs(not_cdr_msg, sizeof(not_cdr_msg)).has_value());
+}
+
+TEST(RosbagFrameIndexTest, MatchExactStamps) {
+  // Stamps 1..5 for depth, color misses 2, depth info misses 4, color info is duplicated at 3.
+  const std::vector<StampedBagMessage> depth = {{1, 10}, {2, 20}, {3, 30}, {4, 40}, {5, 50}};
+  const std::vector<StampedBagMessage> depth_info = {{5, 51}, {1, 11}, {2, 21}, {3, 31}};
+  const std::vector<StampedBagMessage> color = {{1, 12}, {3, 32}, {4, 42}, {5, 52}};
+  const std::vector<StampedBagMessage> color_info = {{1, 13}, {3, 34}, {3, 33}, {4, 43},
+    {5, 53}};
+
+  const std::vector<RosbagFrameIndexEntry> entries =
+    datasets::ros::matchExactStamps(depth, depth_info, color, color_info);
+  ASSERT_EQ(entries.size(), 3);
+  EXPECT_EQ(entries[0].stamp_ns, 1);
+  EXPECT_EQ(entries[1].stamp_ns, 3);
+  EXPECT_EQ(entries[2].stamp_ns, 5);
+  // The first recorded of the duplicates is used.
+  EXPECT_EQ(entries[1].color_camera_info_bag_time_ns, 33);
+  EXPECT_EQ(entries[2].depth_camera_info_bag_time_ns, 51);
+  EXPECT_EQ(entries[2].earliestBagTimeNs(), 50);
+
+  const datasets::ros::RosbagFrameIndex index(entries);
+  EXPECT_EQ(index.findFirstAtOrAfter(0), 0);
+  EXPECT_EQ(index.findFirstAtOrAfter(2), 1);
+  EXPECT_EQ(index.findFirstAtOrAfter(3), 1);
+  EXPECT_EQ(index.findFirstAtOrAfter(6), 3);
+}
+
+TEST(RosbagFrameIndexTest, IndexedDataLoader) {
+  const std::string rosbag_path = ament_index_cpp::get_package_share_directory("nvblox_ros") +
+    "/test_cases/rosbags/nvblox_pol";
+  ASSERT_TRUE(std::filesystem::exists(rosbag_path) && std::filesystem::is_directory(rosbag_path));
+
+  const std::string depth_topic = "/front_stereo_camera/depth/ground_truth";
+  const std::string depth_camera_info_topic = "/front_stereo_camera/depth/camera_info";
+  const std::string color_topic = "/front_stereo_camera/left/image_raw";
+  const std::string color_camera_info_topic = "/front_stereo_camera/left/camera_info";
+  constexpr float kTfPreloadTimeS = 0.1;
+  constexpr int kPrefetchQueueSize = 2;
+  auto data_loader = datasets::ros::IndexedRosDataLoader::create(
+    rosbag_path, depth_topic, depth_camera_info_topic, color_topic, color_camera_info_topic,
+    "odom", kTfPreloadTimeS, kPrefetchQueueSize);
+  ASSERT_TRUE(data_loader);
+  // NOTE: The test bag contains 11 messages all with exact matches.
+  EXPECT_EQ(data_loader->index().size(), 11);
+
+  DepthImage depth_frame(MemoryType::kDevice);
+  ColorImage color_frame(MemoryType::kDevice);
+  Transform T_L_C;
+  Camera camera;
+  const auto load_all = [&]() {
+      int num_frames = 0;
+      int num_loaded = 0;
+      datasets::DataLoadResult load_result;
+      while ((load_result = data_loader->loadNext(&depth_frame, &T_L_C, &camera, &color_frame)) !=
+        datasets::DataLoadResult::kNoMoreData)
+      {
+        ++num_frames;
+        if (load_result == datasets::DataLoadResult::kSuccess) {
+          EXPECT_GT(depth_frame.numel(), 0);
+          EXPECT_GT(color_frame.numel(), 0);
+          ++num_loaded;
+        }
+      }
+      return std::make_pair(num_frames, num_loaded);
+    };
+
+  // All indexed frames are returned, a few of the first ones may not have tf yet.
+  const auto [num_frames, num_loaded] = load_all();
+  EXPECT_EQ(num_frames, 11);
+  constexpr int kNumLoadedExpected = 8;
+  EXPECT_GE(num_loaded, kNumLoadedExpected);
+
+  // Seeking back to the last frame returns a single frame.
+  EXPECT_TRUE(data_loader->seek(data_loader->index().entries().back().stamp_ns));
+  EXPECT_EQ(load_all().first, 1);
+  // Seeking past the end returns no frames.
+  EXPECT_FALSE(data_loader->seek(data_loader->index().entries().back().stamp_ns + 1));
+  EXPECT_EQ(load_all().first, 0);
+}
+
+int main(int argc, char ** argv)
+{
+  FLAGS_alsologtostderr = true;
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
+
+}  // namespace nvblox
@@ -0,0 +1,98 @@
+// SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+// Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <thread>
+#include <vector>
+
+#include "nvblox_ros/service_worker.hpp"
+
+namespace nvblox
+{
+
+TEST(ServiceWorker, RunsJobsInOrderOffThePostingThread) {
+  std::vector<int> job_order;
+  std::vector<std::thread::id> job_thread_ids;
+  {
+    ServiceWorker worker;
+    constexpr int kNumJobs = 10;
+    for (int i = 0; i < kNumJobs; i++) {
+      worker.post(
+        [i, &job_order, &job_thread_ids]() {
+          job_order.push_back(i);
+          job_thread_ids.push_back(std::this_thread::get_id());
+        });
+    }
+    worker.waitUntilIdle();
+    EXPECT_EQ(worker.numPendingJobs(), 0U);
+    ASSERT_EQ(job_order.size(), static_cast<size_t>(kNumJobs));
+    for (int i = 0; i < kNumJobs; i++) {
+      EXPECT_EQ(job_order[i], i);
+      EXPECT_NE(job_thread_ids[i], std::this_thread::get_id());
+    }
+  }
+}
+
+TEST(ServiceWorker, PostDoesNotWaitForJobs) {
+  ServiceWorker worker;
+  std::promise<void> release_job;
+  std::shared_future<void> job_released = release_job.get_future().share();
+  std::atomic<bool> job_done{false};
+  // The job blocks until released. Posting, and hence the posting (tick) thread, must not.
+  worker.post(
+    [job_released, &job_done]() {
+      job_released.wait();
+      job_done = true;
+    });
+  EXPECT_FALSE(job_done);
+  EXPECT_EQ(worker.numPendingJobs(), 1U);
+  release_job.set_value();
+  worker.waitUntilIdle();
+  EXPECT_TRUE(job_done);
+}
+
+TEST(ServiceWorker, DestructorRunsPendingJobs) {
+  std::atomic<int> num_jobs_run{0};
+  constexpr int kNumJobs = 5;
+  {
+    ServiceWorker worker;
+    for (int i = 0; i < kNumJobs; i++) {
+      worker.post(
+        [&num_jobs_run]() {
+          std::this_thread::sleep_for(std::chrono::milliseconds(1));
+          ++num_jobs_run;
+        });
+    }
+  }
+  EXPECT_EQ(num_jobs_run, kNumJobs);
+}
+
+}  // namespace nvblox
+
+int main(int argc, char ** argv)
+{
+  FLAGS_alsologtostderr = true;
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
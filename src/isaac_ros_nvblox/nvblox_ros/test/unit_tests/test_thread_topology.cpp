@@ -0,0 +1,130 @@
+// SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+// Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "nvblox_ros/thread_topology.hpp"
+
+namespace nvblox
+{
+
+// The first CPU the calling thread may run on.
+int firstAllowedCpu()
+{
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  EXPECT_EQ(pthread_getaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set), 0);
+  for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+    if (CPU_ISSET(cpu, &cpu_set)) {
+      return cpu;
+    }
+  }
+  return -1;
+}
+
+// Whether the calling thread may only run on cpu.
+bool isPinnedTo(int cpu)
+{
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  pthread_getaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+  return CPU_COUNT(&cpu_set) == 1 && CPU_ISSET(cpu, &cpu_set);
+}
+
+TEST(ThreadTopology, ParseCpuList) {
+  EXPECT_EQ(parseCpuList(""), std::vector<int>{});
+  EXPECT_EQ(parseCpuList("3"), std::vector<int>{3});
+  EXPECT_EQ(parseCpuList("0,2-4,7"), (std::vector<int>{0, 2, 3, 4, 7}));
+  EXPECT_FALSE(parseCpuList("4-2"));
+  EXPECT_FALSE(parseCpuList("1,,2"));
+  EXPECT_FALSE(parseCpuList("a"));
+  EXPECT_FALSE(parseCpuList("-1"));
+}
+
+TEST(ThreadTopology, RoleNames) {
+  EXPECT_EQ(toString(ThreadRole::kIngestion), "ingestion");
+  EXPECT_EQ(toString(ThreadRole::kIntegration), "integration");
+  EXPECT_EQ(toString(ThreadRole::kEsdf), "esdf");
+  EXPECT_EQ(toString(ThreadRole::kPublishing), "publishing");
+  EXPECT_EQ(toString(ThreadRole::kServices), "services");
+}
+
+TEST(ThreadTopology, ApplyAffinity) {
+  const int cpu = firstAllowedCpu();
+  ASSERT_GE(cpu, 0);
+  std::async(
+    std::launch::async, [cpu]() {
+      ThreadConfig config;
+      config.cpu_affinity = {cpu};
+      EXPECT_TRUE(applyThreadConfigToCurrentThread(config));
+      EXPECT_TRUE(isPinnedTo(cpu));
+      // Threads started from here inherit the affinity.
+      std::async(std::launch::async, [cpu]() {EXPECT_TRUE(isPinnedTo(cpu));}).get();
+    }).get();
+}
+
+TEST(ThreadTopology, CallbackGroupsSpinOnTheThreadsOfTheirRole) {
+  rclcpp::init(0, nullptr);
+  auto node = std::make_shared<rclcpp::Node>("thread_topology_test_node");
+  auto group = node->create_callback_group(
+    rclcpp::CallbackGroupType::MutuallyExclusive, /*automatically_add_to_executor_with_node=*/
+    false);
+
+  const int cpu = firstAllowedCpu();
+  ThreadConfigs configs;
+  configs[static_cast<int>(ThreadRole::kIntegration)].cpu_affinity = {cpu};
+  ThreadTopologyExecutor executor(configs);
+  executor.addNode(ThreadRole::kIngestion, node);
+  executor.addCallbackGroup(ThreadRole::kIntegration, group, node->get_node_base_interface());
+
+  std::promise<bool> pinned;
+  std::atomic<bool> done{false};
+  auto timer = node->create_wall_timer(
+    std::chrono::milliseconds(1), [&]() {
+      if (!done.exchange(true)) {
+        pinned.set_value(isPinnedTo(cpu));
+      }
+    }, group);
+  std::future<void> spinning = std::async(std::launch::async, [&]() {executor.spin();});
+  std::future<bool> pinned_future = pinned.get_future();
+  ASSERT_EQ(pinned_future.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+  EXPECT_TRUE(pinned_future.get());
+
+  rclcpp::shutdown();
+  spinning.get();
+}
+
+}  // namespace nvblox
+
+int main(int argc, char ** argv)
+{
+  FLAGS_alsologtostderr = true;
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
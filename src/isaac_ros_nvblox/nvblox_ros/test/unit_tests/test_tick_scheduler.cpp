@@ -0,0 +1,89 @@
+// SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+// Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+
+#include <nvblox/utils/timing.h>
+
+#include "nvblox_ros/tick_scheduler.hpp"
+
+namespace nvblox
+{
+
+void recordStageCost(const std::string & timer_tag, int cost_ms)
+{
+  timing::Timer timer(timer_tag);
+  std::this_thread::sleep_for(std::chrono::milliseconds(cost_ms));
+}
+
+TEST(TickScheduler, DefersExpensiveStages) {
+  constexpr float kTickBudgetMs = 10.F;
+  TickScheduler scheduler(kTickBudgetMs);
+  scheduler.max_num_consecutive_deferrals(2);
+
+  const auto critical_stage =
+    scheduler.registerStage("esdf", "test/esdf", TickStagePriority::kCritical);
+  const auto cheap_stage =
+    scheduler.registerStage("color", "test/color", TickStagePriority::kDeferrable);
+  const auto expensive_stage =
+    scheduler.registerStage("mesh", "test/mesh", TickStagePriority::kDeferrable);
+
+  // Before any timings exist, all stages are run.
+  scheduler.startTick();
+  EXPECT_TRUE(scheduler.shouldRunStage(critical_stage));
+  EXPECT_TRUE(scheduler.shouldRunStage(cheap_stage));
+  EXPECT_TRUE(scheduler.shouldRunStage(expensive_stage));
+
+  recordStageCost("test/esdf", 20);
+  recordStageCost("test/color", 1);
+  recordStageCost("test/mesh", 20);
+  EXPECT_GT(scheduler.estimatedStageCostMs(expensive_stage), kTickBudgetMs);
+
+  // The expensive stage doesn't fit and is deferred, until it's been deferred too often.
+  for (int i = 0; i < 2; i++) {
+    scheduler.startTick();
+    EXPECT_TRUE(scheduler.shouldRunStage(critical_stage));
+    EXPECT_TRUE(scheduler.shouldRunStage(cheap_stage));
+    EXPECT_FALSE(scheduler.shouldRunStage(expensive_stage));
+  }
+  scheduler.startTick();
+  EXPECT_TRUE(scheduler.shouldRunStage(expensive_stage));
+  EXPECT_EQ(scheduler.numDeferrals(expensive_stage), 2);
+  EXPECT_EQ(scheduler.numDeferrals(cheap_stage), 0);
+
+  // Critical stages run even once the budget is exhausted.
+  scheduler.startTick();
+  std::this_thread::sleep_for(std::chrono::milliseconds(static_cast<int>(kTickBudgetMs) + 1));
+  EXPECT_LT(scheduler.remainingBudgetMs(), 0.F);
+  EXPECT_TRUE(scheduler.shouldRunStage(critical_stage));
+  EXPECT_FALSE(scheduler.shouldRunStage(cheap_stage));
+}
+
+}  // namespace nvblox
+
+int main(int argc, char ** argv)
+{
+  FLAGS_alsologtostderr = true;
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,94 @@
+// SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+// Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include "nvblox_ros/transform_cache.hpp"
+
+namespace nvblox
+{
+
+constexpr float kEps = 1e-5;
+
+Transform makeTransform(const Vector3f & translation, float yaw_rad)
+{
+  Transform transform = Transform::Identity();
+  transform.translate(translation);
+  transform.rotate(Eigen::AngleAxisf(yaw_rad, Vector3f::UnitZ()));
+  return transform;
+}
+
+TEST(TransformCache, ExactAndInterpolatedLookups) {
+  TransformCache cache;
+  cache.max_interpolation_interval_ns(100);
+  cache.insert("map", "base", 100, makeTransform(Vector3f(0.F, 0.F, 0.F), 0.F));
+  cache.insert("map", "base", 400, makeTransform(Vector3f(4.F, 0.F, 0.F), 0.F));
+  // Out of order. The gap to the transform at 400 is too large to be interpolated across.
+  cache.insert("map", "base", 200, makeTransform(Vector3f(2.F, 0.F, 0.F), 1.F));
+
+  Transform transform;
+  ASSERT_TRUE(cache.lookup("map", "base", 200, &transform));
+  EXPECT_NEAR(transform.translation().x(), 2.F, kEps);
+
+  // Halfway between the first two transforms.
+  ASSERT_TRUE(cache.lookup("map", "base", 150, &transform));
+  EXPECT_NEAR(transform.translation().x(), 1.F, kEps);
+  const Eigen::AngleAxisf rotation(transform.rotation());
+  EXPECT_NEAR(rotation.angle(), 0.5F, kEps);
+
+  // Outside the cached range, across a large gap, or for another frame pair.
+  EXPECT_FALSE(cache.lookup("map", "base", 50, &transform));
+  EXPECT_FALSE(cache.lookup("map", "base", 500, &transform));
+  EXPECT_FALSE(cache.lookup("map", "base", 300, &transform));
+  EXPECT_FALSE(cache.lookup("base", "map", 200, &transform));
+
+  cache.clear();
+  EXPECT_FALSE(cache.lookup("map", "base", 200, &transform));
+}
+
+TEST(TransformCache, DropsOldestTransforms) {
+  constexpr size_t kCapacity = 4;
+  TransformCache cache(kCapacity);
+  for (uint64_t i = 0; i < 2 * kCapacity; i++) {
+    cache.insert("map", "base", i, makeTransform(Vector3f(static_cast<float>(i), 0.F, 0.F), 0.F));
+  }
+  Transform transform;
+  EXPECT_FALSE(cache.lookup("map", "base", kCapacity - 1, &transform));
+  ASSERT_TRUE(cache.lookup("map", "base", kCapacity, &transform));
+  EXPECT_NEAR(transform.translation().x(), kCapacity, kEps);
+}
+
+TEST(TransformCache, StaticTransforms) {
+  TransformCache cache;
+  Transform transform;
+  EXPECT_FALSE(cache.lookupStatic("base", "camera", &transform));
+  cache.insertStatic("base", "camera", makeTransform(Vector3f(0.F, 1.F, 0.F), 0.F));
+  ASSERT_TRUE(cache.lookupStatic("base", "camera", &transform));
+  EXPECT_NEAR(transform.translation().y(), 1.F, kEps);
+}
+
+}  // namespace nvblox
+
+int main(int argc, char ** argv)
+{
+  FLAGS_alsologtostderr = true;
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
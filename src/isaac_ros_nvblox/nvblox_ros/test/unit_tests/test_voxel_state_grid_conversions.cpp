@@ -0,0 +1,106 @@
+// SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+// Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <nvblox/nvblox.h>
+
+#include "nvblox_ros/conversions/voxel_state_grid_conversions.hpp"
+
+namespace nvblox
+{
+namespace conversions
+{
+
+constexpr float kVoxelSize = 0.1F;
+
+TEST(VoxelStateGridConversionsTest, PacksColumns) {
+  // A single block: a floor of occupied voxels at z = 0, free voxels above, and an unobserved
+  // column at x = 3, y = 4.
+  EsdfLayer layer(kVoxelSize, MemoryType::kUnified);
+  EsdfBlock::Ptr block = layer.allocateBlockAtIndex(Index3D::Zero());
+  constexpr int kVoxelsPerSide = EsdfBlock::kVoxelsPerSide;
+  for (int x = 0; x < kVoxelsPerSide; x++) {
+    for (int y = 0; y < kVoxelsPerSide; y++) {
+      for (int z = 0; z < kVoxelsPerSide; z++) {
+        EsdfVoxel & voxel = block->voxels[x][y][z];
+        voxel.observed = !(x == 3 && y == 4);
+        voxel.is_inside = z == 0;
+        voxel.squared_distance_vox = static_cast<float>(z * z);
+      }
+    }
+  }
+
+  VoxelStateGridConverter converter;
+  converter.occupied_distance_m(0.5F * kVoxelSize);
+  converter.include_distances(true);
+  // Cover the block, but not the neighbouring ones.
+  const float kBlockSize = layer.block_size();
+  const AxisAlignedBoundingBox aabb(
+    Vector3f::Constant(0.5F * kVoxelSize), Vector3f::Constant(kBlockSize - 0.5F * kVoxelSize));
+  nvblox_msgs::msg::VoxelStateGrid msg;
+  ASSERT_TRUE(converter.esdfLayerToVoxelStateGridMsg(layer, aabb, &msg));
+
+  EXPECT_EQ(msg.size_x, kVoxelsPerSide);
+  EXPECT_EQ(msg.size_y, kVoxelsPerSide);
+  EXPECT_EQ(msg.size_z, kVoxelsPerSide);
+  EXPECT_FLOAT_EQ(msg.resolution, kVoxelSize);
+  EXPECT_NEAR(msg.origin.x, 0.0, 1e-6);
+  ASSERT_EQ(msg.occupied_columns.size(), kVoxelsPerSide * kVoxelsPerSide);
+  ASSERT_EQ(msg.unknown_columns.size(), kVoxelsPerSide * kVoxelsPerSide);
+  ASSERT_EQ(msg.distances.size(), kVoxelsPerSide * kVoxelsPerSide * kVoxelsPerSide);
+
+  const uint32_t kAllBits = (1U << kVoxelsPerSide) - 1U;
+  for (int y = 0; y < kVoxelsPerSide; y++) {
+    for (int x = 0; x < kVoxelsPerSide; x++) {
+      const int column_idx = y * kVoxelsPerSide + x;
+      if (x == 3 && y == 4) {
+        EXPECT_EQ(msg.occupied_columns[column_idx], 0U);
+        EXPECT_EQ(msg.unknown_columns[column_idx], kAllBits);
+        EXPECT_EQ(msg.distances[column_idx * kVoxelsPerSide], msg.unknown_value);
+      } else {
+        EXPECT_EQ(msg.occupied_columns[column_idx], 1U);
+        EXPECT_EQ(msg.unknown_columns[column_idx], 0U);
+        EXPECT_NEAR(msg.distances[column_idx * kVoxelsPerSide + 2], 2.F * kVoxelSize, 1e-6);
+      }
+    }
+  }
+}
+
+TEST(VoxelStateGridConversionsTest, RejectsTallGrids) {
+  EsdfLayer layer(kVoxelSize, MemoryType::kUnified);
+  layer.allocateBlockAtIndex(Index3D::Zero());
+  VoxelStateGridConverter converter;
+  const AxisAlignedBoundingBox aabb(
+    Vector3f::Zero(),
+    Vector3f(1.F, 1.F, (VoxelStateGridConverter::kMaxSizeZ + 1) * kVoxelSize));
+  nvblox_msgs::msg::VoxelStateGrid msg;
+  EXPECT_FALSE(converter.esdfLayerToVoxelStateGridMsg(layer, aabb, &msg));
+  EXPECT_FALSE(converter.esdfLayerToVoxelStateGridMsg(layer, AxisAlignedBoundingBox(), &msg));
+}
+
+}  // namespace conversions
+}  // namespace nvblox
+
+int main(int argc, char ** argv)
+{
+  FLAGS_alsologtostderr = true;
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
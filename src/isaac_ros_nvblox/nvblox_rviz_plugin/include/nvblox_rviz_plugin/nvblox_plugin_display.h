@@ -43,6 +43,7 @@ public:
 protected:
   virtual void onInitialize();
   virtual void reset();
+  void update(float wall_dt, float ros_dt) override;
   void updatePose(const typename MessageType::ConstSharedPtr msg);
 
 private:
@@ -19,6 +19,7 @@
 
 #include <QObject>
 #include <OgreManualObject.h>
+#include <OgreVector3.h>
 #include <string>
 #include <memory>
 
@@ -43,15 +44,23 @@ public:
 
   float getCeilingHeight();
   bool getCutCeiling();
+  /// Distance from the camera beyond which blocks are not rendered. 0 if disabled.
+  float getMaxRenderDistance();
+  /// Distance from the camera beyond which voxel blocks are rendered at half resolution. 0 if
+  /// disabled.
+  float getLodDistance();
 
   bool paramsChanged();
 
 public Q_SLOTS:
   virtual void updateCeilingOptions();
+  virtual void updateDistanceOptions();
 
 private:
   rviz_common::properties::BoolProperty * cut_ceiling_property_ = nullptr;
   rviz_common::properties::FloatProperty * ceiling_height_property_ = nullptr;
+  rviz_common::properties::FloatProperty * max_render_distance_property_ = nullptr;
+  rviz_common::properties::FloatProperty * lod_distance_property_ = nullptr;
 
   bool params_changed_ = false;
 };
@@ -73,16 +82,37 @@ public:
   void setFramePosition(const Ogre::Vector3 & position);
   void setFrameOrientation(const Ogre::Quaternion & orientation);
 
+  /// Select the level of detail of the blocks based on their distance to the camera. Called
+  /// every frame, but only revisits the blocks if the camera moved or the params changed.
+  /// @param camera_position The camera position in the world (scene) frame.
+  void updateCamera(const Ogre::Vector3 & camera_position);
+
 private:
+  /// The Ogre objects rendering a single block. Both are kept on the GPU between messages and
+  /// only rebuilt when the block is part of a message.
+  struct BlockObjects
+  {
+    /// All voxels or the mesh of the block.
+    Ogre::ManualObject * full = nullptr;
+    /// The voxels downsampled to twice the voxel size, rendered in place of the full object
+    /// beyond the LOD distance. Not used for meshes.
+    Ogre::ManualObject * coarse = nullptr;
+  };
+
   void initializeFallbackMaterial();
   void initializeBoxMaterial();
   std::unique_ptr<NvbloxVisualParams> params_;
 
-  void maybeCutCeiling(const bool cut_ceiling, const float ceiling_height);
+  /// Apply changed visual params to all blocks.
+  void applyParams();
+  /// Set which of the block's objects are visible given the ceiling and the LOD distance.
+  void updateBlockVisibility(const Index3D & block_index, const BlockObjects & objects);
+  void destroyBlockObjects(const BlockObjects & objects);
 
   Ogre::SceneNode * frame_node_ = nullptr;
   Ogre::SceneManager * scene_manager_ = nullptr;
   Ogre::MaterialPtr voxel_material_ = nullptr;
+  Ogre::MaterialPtr coarse_voxel_material_ = nullptr;
 
   unsigned int instance_number_{0};
   static unsigned int instance_counter_;
@@ -90,7 +120,10 @@ private:
   float block_size_m_ = 0.0f;
 
   bool using_fallback_voxel_material_ = false;
-  nvblox_rviz_plugin::Index3DHashMapType<Ogre::ManualObject *>::type object_map_;
+  nvblox_rviz_plugin::Index3DHashMapType<BlockObjects>::type object_map_;
+
+  /// The camera position in the frame of the visual at the last LOD update.
+  Ogre::Vector3 camera_position_ = Ogre::Vector3::ZERO;
 };
 
 using NvbloxMeshVisual = NvbloxBaseVisual<nvblox_msgs::msg::Mesh>;
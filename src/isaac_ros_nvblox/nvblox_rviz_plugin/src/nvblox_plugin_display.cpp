@@ -15,7 +15,12 @@
 //
 // SPDX-License-Identifier: Apache-2.0
 
+#include <OgreCamera.h>
+#include <OgreSceneNode.h>
+
 #include <rviz_common/frame_manager_iface.hpp>
+#include <rviz_common/view_controller.hpp>
+#include <rviz_common/view_manager.hpp>
 #include <rviz_common/visualization_manager.hpp>
 
 #include "nvblox_rviz_plugin/nvblox_plugin_display.h"
@@ -40,6 +45,22 @@ void NvbloxBaseDisplay<MessageType>::reset()
   visual_.reset();
 }
 
+template<typename MessageType>
+void NvbloxBaseDisplay<MessageType>::update(float wall_dt, float ros_dt)
+{
+  rviz_common::MessageFilterDisplay<MessageType>::MFDClass::update(wall_dt, ros_dt);
+  if (visual_ == nullptr) {
+    return;
+  }
+  // Blocks are culled and their level of detail selected by distance to the camera.
+  rviz_common::ViewController * view_controller = this->context_->getViewManager()->getCurrent();
+  if (view_controller == nullptr || view_controller->getCamera() == nullptr) {
+    return;
+  }
+  visual_->updateCamera(
+    view_controller->getCamera()->getParentSceneNode()->_getDerivedPosition());
+}
+
 template<typename MessageType>
 void NvbloxBaseDisplay<MessageType>::updatePose(const typename MessageType::ConstSharedPtr msg)
 {
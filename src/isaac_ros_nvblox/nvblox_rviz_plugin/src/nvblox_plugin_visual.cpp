@@ -15,8 +15,11 @@
 //
 // SPDX-License-Identifier: Apache-2.0
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <limits>
+#include <vector>
 
 
 #include <OgreSceneManager.h>
@@ -49,8 +52,23 @@ NvbloxVisualParams::NvbloxVisualParams(rviz_common::_RosTopicDisplay * parent)
     "Ceiling Height", 1.5, "Height above which the visualization will be cut off.", nullptr,
     SLOT(updateCeilingOptions()), this);
 
+  max_render_distance_property_ = new rviz_common::properties::FloatProperty(
+    "Max Render Distance", 0.0,
+    "Blocks further away from the camera than this are not rendered. 0 to render all blocks.",
+    nullptr, SLOT(updateDistanceOptions()), this);
+  max_render_distance_property_->setMin(0.0);
+
+  lod_distance_property_ = new rviz_common::properties::FloatProperty(
+    "LOD Distance", 0.0,
+    "Voxel blocks further away from the camera than this are rendered at half resolution. 0 to "
+    "always render at full resolution.",
+    nullptr, SLOT(updateDistanceOptions()), this);
+  lod_distance_property_->setMin(0.0);
+
   parent->addChild(cut_ceiling_property_);
   parent->addChild(ceiling_height_property_);
+  parent->addChild(max_render_distance_property_);
+  parent->addChild(lod_distance_property_);
 }
 
 void NvbloxVisualParams::updateCeilingOptions()
@@ -60,6 +78,11 @@ void NvbloxVisualParams::updateCeilingOptions()
   params_changed_ = true;
 }
 
+void NvbloxVisualParams::updateDistanceOptions()
+{
+  params_changed_ = true;
+}
+
 bool NvbloxVisualParams::paramsChanged()
 {
   if (params_changed_) {
@@ -79,6 +102,16 @@ bool NvbloxVisualParams::getCutCeiling()
   return cut_ceiling_property_->getBool();
 }
 
+float NvbloxVisualParams::getMaxRenderDistance()
+{
+  return max_render_distance_property_->getFloat();
+}
+
+float NvbloxVisualParams::getLodDistance()
+{
+  return lod_distance_property_->getFloat();
+}
+
 
 template<typename MessageType>
 unsigned int
@@ -123,11 +156,20 @@ void NvbloxBaseVisual<MessageType>::initializeBoxMaterial()
   // The default geometry shader uses directional lighting which creates large contrasts between the
   // sides of the rendered cubes. We therefore select another shader that doesn't use lighting.
   voxel_material_->getBestTechnique()->getPass(0)->setGeometryProgram("rviz/glsl150/box.geom");
+
+  // The coarse voxels are rendered with the same shader but twice the box size, which is a
+  // parameter of the material.
+  constexpr const char * kCoarseBoxMaterialName = "nvblox/box_coarse";
+  coarse_voxel_material_ = Ogre::MaterialManager::getSingleton().getByName(kCoarseBoxMaterialName);
+  if (coarse_voxel_material_ == nullptr) {
+    coarse_voxel_material_ = voxel_material_->clone(kCoarseBoxMaterialName);
+  }
 }
 template<typename MessageType>
 void NvbloxBaseVisual<MessageType>::initializeFallbackMaterial()
 {
   voxel_material_ = Ogre::MaterialManager::getSingleton().getByName("BaseWhiteNoLighting");
+  coarse_voxel_material_ = voxel_material_;
   using_fallback_voxel_material_ = true;
 }
 
@@ -171,29 +213,100 @@ template<typename MessageType>
 NvbloxBaseVisual<MessageType>::~NvbloxBaseVisual()
 {
   // Destroy all the objects
-  for (const auto ogre_object : object_map_) {
-    scene_manager_->destroyManualObject(ogre_object.second);
+  for (const auto & kv : object_map_) {
+    destroyBlockObjects(kv.second);
   }
 }
+
 template<typename MessageType>
-void NvbloxBaseVisual<MessageType>::maybeCutCeiling(
-  const bool cut_ceiling,
-  const float ceiling_height)
+void NvbloxBaseVisual<MessageType>::destroyBlockObjects(const BlockObjects & objects)
 {
-  // Iterate over all the ogre objects, setting blocks visible and not again.
-  for (const auto kv : object_map_) {
-    if (cut_ceiling) {
-      if (kv.first.z * block_size_m_ <= ceiling_height) {
-        kv.second->setVisible(true);
-      } else {
-        kv.second->setVisible(false);
-      }
-    } else {
-      kv.second->setVisible(true);
+  scene_manager_->destroyManualObject(objects.full);
+  if (objects.coarse != nullptr) {
+    scene_manager_->destroyManualObject(objects.coarse);
+  }
+}
+
+template<typename MessageType>
+void NvbloxBaseVisual<MessageType>::updateBlockVisibility(
+  const Index3D & block_index,
+  const BlockObjects & objects)
+{
+  const bool above_ceiling = params_->getCutCeiling() &&
+    block_index.z * block_size_m_ > params_->getCeilingHeight();
+  bool use_coarse = false;
+  if (objects.coarse != nullptr && params_->getLodDistance() > 0.0f) {
+    const Ogre::Vector3 block_center =
+      (Ogre::Vector3(block_index.x, block_index.y, block_index.z) + 0.5f) * block_size_m_;
+    use_coarse = block_center.squaredDistance(camera_position_) >
+      params_->getLodDistance() * params_->getLodDistance();
+  }
+  objects.full->setVisible(!above_ceiling && !use_coarse);
+  if (objects.coarse != nullptr) {
+    objects.coarse->setVisible(!above_ceiling && use_coarse);
+  }
+}
+
+template<typename MessageType>
+void NvbloxBaseVisual<MessageType>::applyParams()
+{
+  // Distance culling is done by Ogre, which skips objects further away from the camera than
+  // their rendering distance (0 meaning no limit).
+  const float max_render_distance = params_->getMaxRenderDistance();
+  for (const auto & kv : object_map_) {
+    kv.second.full->setRenderingDistance(max_render_distance);
+    if (kv.second.coarse != nullptr) {
+      kv.second.coarse->setRenderingDistance(max_render_distance);
     }
+    updateBlockVisibility(kv.first, kv.second);
+  }
+}
+
+template<typename MessageType>
+void NvbloxBaseVisual<MessageType>::updateCamera(const Ogre::Vector3 & camera_position)
+{
+  const Ogre::Vector3 camera_position_in_frame =
+    frame_node_->convertWorldToLocalPosition(camera_position);
+  if (params_->paramsChanged()) {
+    camera_position_ = camera_position_in_frame;
+    applyParams();
+    return;
+  }
+  if (params_->getLodDistance() <= 0.0f) {
+    return;
+  }
+  // Only revisit the blocks once the camera moved by a significant fraction of a block.
+  const float min_camera_motion_m = 0.5f * block_size_m_;
+  if (camera_position_in_frame.squaredDistance(camera_position_) <
+    min_camera_motion_m * min_camera_motion_m)
+  {
+    return;
+  }
+  camera_position_ = camera_position_in_frame;
+  for (const auto & kv : object_map_) {
+    updateBlockVisibility(kv.first, kv.second);
   }
 }
 
+// Number of vertices in a mesh block, in either of its encodings.
+size_t numVertices(const nvblox_msgs::msg::MeshBlock & mesh_block)
+{
+  if (!mesh_block.quantized_vertices.empty()) {
+    return mesh_block.quantized_vertices.size() / 3;
+  }
+  return mesh_block.vertices.size();
+}
+
+// Decode a vertex coordinate of the compact mesh encoding.
+float decodeQuantizedCoordinate(
+  const uint16_t quantized_coordinate, const float block_origin_m,
+  const float block_size_m)
+{
+  constexpr float kMaxQuantizedValue = 65535.0f;
+  return block_origin_m + static_cast<float>(quantized_coordinate) / kMaxQuantizedValue *
+         nvblox_msgs::msg::MeshBlock::QUANTIZED_VERTEX_RANGE_BLOCKS * block_size_m;
+}
+
 // Specialization for mesh message
 template<> void
 NvbloxBaseVisual<nvblox_msgs::msg::Mesh>::setMessage(
@@ -202,13 +315,13 @@ NvbloxBaseVisual<nvblox_msgs::msg::Mesh>::setMessage(
   block_size_m_ = msg->block_size_m;
 
   if (params_->paramsChanged()) {
-    maybeCutCeiling(params_->getCutCeiling(), params_->getCeilingHeight());
+    applyParams();
   }
 
   // First, check if we need to clear the existing map.
   if (msg->clear) {
-    for (const auto ogre_object : object_map_) {
-      scene_manager_->destroyManualObject(ogre_object.second);
+    for (const auto & kv : object_map_) {
+      destroyBlockObjects(kv.second);
     }
     object_map_.clear();
   }
@@ -224,16 +337,16 @@ NvbloxBaseVisual<nvblox_msgs::msg::Mesh>::setMessage(
     const auto it = object_map_.find(block_index);
     if (it != object_map_.end()) {
       // delete empty mesh blocks
-      if (mesh_block.vertices.empty()) {
-        scene_manager_->destroyManualObject(it->second);
+      if (numVertices(mesh_block) == 0) {
+        destroyBlockObjects(it->second);
         object_map_.erase(it);
         continue;
       }
 
-      ogre_object = it->second;
+      ogre_object = it->second.full;
       new_object = false;
     } else {
-      if (mesh_block.vertices.empty()) {
+      if (numVertices(mesh_block) == 0) {
         continue;
       }
       std::string object_name = std::to_string(block_index.x) + std::string(" ") +
@@ -241,12 +354,14 @@ NvbloxBaseVisual<nvblox_msgs::msg::Mesh>::setMessage(
         std::to_string(block_index.z) + std::string(" ") +
         std::to_string(instance_number_);
       ogre_object = scene_manager_->createManualObject(object_name);
-      object_map_.insert(std::make_pair(block_index, ogre_object));
+      ogre_object->setRenderingDistance(params_->getMaxRenderDistance());
+      object_map_.insert(std::make_pair(block_index, BlockObjects{ogre_object, nullptr}));
 
       frame_node_->attachObject(ogre_object);
     }
 
-    ogre_object->estimateVertexCount(mesh_block.vertices.size());
+    const size_t num_vertices = numVertices(mesh_block);
+    ogre_object->estimateVertexCount(num_vertices);
     ogre_object->estimateIndexCount(mesh_block.triangles.size());
     if (new_object) {
       ogre_object->begin("BaseWhiteNoLighting", Ogre::RenderOperation::OT_TRIANGLE_LIST);
@@ -254,15 +369,34 @@ NvbloxBaseVisual<nvblox_msgs::msg::Mesh>::setMessage(
       ogre_object->beginUpdate(0);
     }
 
-    for (size_t i = 0; i < mesh_block.vertices.size(); ++i) {
+    const bool is_compact = !mesh_block.quantized_vertices.empty();
+    for (size_t i = 0; i < num_vertices; ++i) {
       // note calling position changes what vertex the color and normal calls
       // point to
-      ogre_object->position(
-        mesh_block.vertices[i].x, mesh_block.vertices[i].y,
-        mesh_block.vertices[i].z);
+      if (is_compact) {
+        ogre_object->position(
+          decodeQuantizedCoordinate(
+            mesh_block.quantized_vertices[3 * i], block_index.x * block_size_m_,
+            block_size_m_),
+          decodeQuantizedCoordinate(
+            mesh_block.quantized_vertices[3 * i + 1], block_index.y * block_size_m_,
+            block_size_m_),
+          decodeQuantizedCoordinate(
+            mesh_block.quantized_vertices[3 * i + 2], block_index.z * block_size_m_,
+            block_size_m_));
+      } else {
+        ogre_object->position(
+          mesh_block.vertices[i].x, mesh_block.vertices[i].y,
+          mesh_block.vertices[i].z);
+      }
 
       std_msgs::msg::ColorRGBA color;
-      if (!mesh_block.colors.empty()) {
+      if (is_compact && !mesh_block.compact_colors.empty()) {
+        constexpr float kMaxColorValue = 255.0f;
+        color.r = mesh_block.compact_colors[3 * i] / kMaxColorValue;
+        color.g = mesh_block.compact_colors[3 * i + 1] / kMaxColorValue;
+        color.b = mesh_block.compact_colors[3 * i + 2] / kMaxColorValue;
+      } else if (!mesh_block.colors.empty()) {
         color = mesh_block.colors[i];
       }
       ogre_object->colour(color.r, color.g, color.b);
@@ -290,6 +424,76 @@ void addVertex(
   obj->colour(color.r, color.g, color.b);
 }
 
+// Downsample the voxels of a block to a grid of twice the voxel size. Each occupied coarse cell
+// is represented by a voxel at its center, with the color of the first voxel falling into it.
+void getCoarseVoxels(
+  const nvblox_msgs::msg::Index3D & block_index,
+  const nvblox_msgs::msg::VoxelBlock & voxel_block, const float block_size_m,
+  const float voxel_size_m, std::vector<geometry_msgs::msg::Point32> * coarse_centers,
+  std::vector<std_msgs::msg::ColorRGBA> * coarse_colors)
+{
+  const float coarse_voxel_size_m = 2.0f * voxel_size_m;
+  const int cells_per_side =
+    std::max(1, static_cast<int>(std::ceil(block_size_m / coarse_voxel_size_m - 1e-3f)));
+  const Ogre::Vector3 block_origin =
+    Ogre::Vector3(block_index.x, block_index.y, block_index.z) * block_size_m;
+
+  const auto to_cell = [&](float position, float origin) {
+      return std::clamp(
+        static_cast<int>((position - origin) / coarse_voxel_size_m), 0, cells_per_side - 1);
+    };
+
+  std::vector<bool> occupied(cells_per_side * cells_per_side * cells_per_side, false);
+  for (size_t i = 0; i < voxel_block.centers.size(); ++i) {
+    const auto & center = voxel_block.centers[i];
+    const int x = to_cell(center.x, block_origin.x);
+    const int y = to_cell(center.y, block_origin.y);
+    const int z = to_cell(center.z, block_origin.z);
+    const int linear_index = (z * cells_per_side + y) * cells_per_side + x;
+    if (occupied[linear_index]) {
+      continue;
+    }
+    occupied[linear_index] = true;
+
+    geometry_msgs::msg::Point32 coarse_center;
+    coarse_center.x = block_origin.x + (x + 0.5f) * coarse_voxel_size_m;
+    coarse_center.y = block_origin.y + (y + 0.5f) * coarse_voxel_size_m;
+    coarse_center.z = block_origin.z + (z + 0.5f) * coarse_voxel_size_m;
+    coarse_centers->push_back(coarse_center);
+    coarse_colors->push_back(
+      voxel_block.colors.empty() ? std_msgs::msg::ColorRGBA() : voxel_block.colors[i]);
+  }
+}
+
+// (Re)build the geometry of an object rendering voxels as points (which are expanded to boxes by
+// the geometry shader of the voxel material). Updating an object reuses its vertex buffer on the
+// GPU if the new geometry fits.
+void setVoxelGeometry(
+  const std::vector<geometry_msgs::msg::Point32> & centers,
+  const std::vector<std_msgs::msg::ColorRGBA> & colors, const Ogre::MaterialPtr & material,
+  const bool new_object, Ogre::ManualObject * ogre_object)
+{
+  ogre_object->setDynamic(true);
+  ogre_object->estimateVertexCount(centers.size());
+
+  // Create points for all voxels
+  if (new_object) {
+    ogre_object->begin(
+      material->getName(), Ogre::RenderOperation::OT_POINT_LIST, material->getGroup());
+  } else {
+    ogre_object->beginUpdate(0);
+  }
+
+  for (size_t i = 0; i < centers.size(); ++i) {
+    std_msgs::msg::ColorRGBA color;
+    if (!colors.empty()) {
+      color = colors[i];
+    }
+    addVertex(centers[i].x, centers[i].y, centers[i].z, color, ogre_object);
+  }
+  ogre_object->end();
+}
+
 // Specialization for voxelblocks
 template<> void
 NvbloxBaseVisual<nvblox_msgs::msg::VoxelBlockLayer>::setMessage(
@@ -298,7 +502,7 @@ NvbloxBaseVisual<nvblox_msgs::msg::VoxelBlockLayer>::setMessage(
   block_size_m_ = msg->block_size_m;
 
   if (params_->paramsChanged()) {
-    maybeCutCeiling(params_->getCutCeiling(), params_->getCeilingHeight());
+    applyParams();
   }
 
   // Set size. How this is done depends on which material we are rendering
@@ -312,23 +516,32 @@ NvbloxBaseVisual<nvblox_msgs::msg::VoxelBlockLayer>::setMessage(
     params->setNamedConstant(
       "size",
       Ogre::Vector4(msg->voxel_size_m, msg->voxel_size_m, msg->voxel_size_m, 1));
+    const float coarse_voxel_size_m = 2.0f * msg->voxel_size_m;
+    Ogre::GpuProgramParametersSharedPtr coarse_params =
+      coarse_voxel_material_->getBestTechnique()->getPass(0)->getGeometryProgramParameters();
+    coarse_params->setNamedConstant(
+      "size",
+      Ogre::Vector4(coarse_voxel_size_m, coarse_voxel_size_m, coarse_voxel_size_m, 1));
   }
 
   // First, check if we need to clear the existing map.
   if (msg->clear) {
-    for (const auto ogre_object : object_map_) {
-      scene_manager_->destroyManualObject(ogre_object.second);
+    for (const auto & kv : object_map_) {
+      destroyBlockObjects(kv.second);
     }
     object_map_.clear();
   }
 
-  // Iterate over all the blocks in the message and make sure to add them.
+  // Iterate over all the blocks in the message and make sure to add them. Blocks which are not in
+  // the message are left untouched on the GPU.
+  std::vector<geometry_msgs::msg::Point32> coarse_centers;
+  std::vector<std_msgs::msg::ColorRGBA> coarse_colors;
   for (size_t i = 0; i < msg->block_indices.size(); i++) {
     const nvblox_msgs::msg::Index3D & block_index = msg->block_indices[i];
     const nvblox_msgs::msg::VoxelBlock & voxel_block = msg->blocks[i];
 
-    // create ogre object
-    Ogre::ManualObject * ogre_object;
+    // create ogre objects
+    BlockObjects objects;
     bool new_object = true;
     const auto it = object_map_.find(block_index);
 
@@ -337,12 +550,12 @@ NvbloxBaseVisual<nvblox_msgs::msg::VoxelBlockLayer>::setMessage(
 
       // delete empty blocks
       if (voxel_block.centers.empty()) {
-        scene_manager_->destroyManualObject(it->second);
+        destroyBlockObjects(it->second);
         object_map_.erase(it);
         continue;
       }
 
-      ogre_object = it->second;
+      objects = it->second;
       new_object = false;
     } else {
       //  The block doesn't exist
@@ -354,39 +567,29 @@ NvbloxBaseVisual<nvblox_msgs::msg::VoxelBlockLayer>::setMessage(
         std::to_string(block_index.y) + std::string(" ") +
         std::to_string(block_index.z) + std::string(" ") +
         std::to_string(instance_number_);
-      ogre_object = scene_manager_->createManualObject(object_name);
-      object_map_.insert(std::make_pair(block_index, ogre_object));
-
-      frame_node_->attachObject(ogre_object);
-    }
-    ogre_object->setDynamic(true);
-    ogre_object->estimateVertexCount(voxel_block.centers.size());
-
-    // Create points for all voxels
-    if (new_object) {
-      ogre_object->begin(
-        voxel_material_->getName(), Ogre::RenderOperation::OT_POINT_LIST,
-        voxel_material_->getGroup());
-    } else {
-      ogre_object->beginUpdate(0);
+      objects.full = scene_manager_->createManualObject(object_name);
+      objects.coarse = scene_manager_->createManualObject(object_name + " coarse");
+      objects.full->setRenderingDistance(params_->getMaxRenderDistance());
+      objects.coarse->setRenderingDistance(params_->getMaxRenderDistance());
+      object_map_.insert(std::make_pair(block_index, objects));
+
+      frame_node_->attachObject(objects.full);
+      frame_node_->attachObject(objects.coarse);
     }
 
-    for (size_t i = 0; i < voxel_block.centers.size(); ++i) {
-      std_msgs::msg::ColorRGBA color;
-      if (!voxel_block.colors.empty()) {
-        color = voxel_block.colors[i];
-      }
+    setVoxelGeometry(
+      voxel_block.centers, voxel_block.colors, voxel_material_, new_object, objects.full);
 
-      addVertex(
-        voxel_block.centers[i].x, voxel_block.centers[i].y, voxel_block.centers[i].z, color,
-        ogre_object);
-    }
-    ogre_object->end();
+    coarse_centers.clear();
+    coarse_colors.clear();
+    getCoarseVoxels(
+      block_index, voxel_block, block_size_m_, msg->voxel_size_m, &coarse_centers,
+      &coarse_colors);
+    setVoxelGeometry(
+      coarse_centers, coarse_colors, coarse_voxel_material_, new_object, objects.coarse);
 
-    // Cut the ceiling immediatly if we're doing that.
-    if (params_->getCutCeiling() && block_index.z * block_size_m_ > params_->getCeilingHeight()) {
-      ogre_object->setVisible(false);
-    }
+    // Cut the ceiling and select the level of detail immediately.
+    updateBlockVisibility(block_index, objects);
   }  // end block_indices loop
 }
 
@@ -0,0 +1,130 @@
+# SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+# Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# SPDX-License-Identifier: Apache-2.0
+
+from dataclasses import asdict, dataclass, field
+import json
+import re
+import time
+from typing import Dict, List
+
+# Printed by the node when print_queue_drops_to_console is enabled, e.g.
+# "Dropped an item from: depth_queue. ... Total number of dropped items is: 12"
+_DROPPED_ITEMS_REGEX = re.compile(
+    r'Dropped an item from: (\S+)\..*Total number of dropped items is: (\d+)')
+
+# A line of the delays table printed by the node when print_delays_to_console is
+# enabled, restricted to the input-to-output latencies, e.g.
+# "ros/latency/static_map_slice/camera_0/age    120     0.085"
+_LATENCY_REGEX = re.compile(r'ros/latency/(\S+)/(\S+)/age\s+(\d+)\s+([0-9.]+)')
+
+
+class TopicMonitor:
+    """Counts the messages received on a topic and their (wall clock) arrival times."""
+
+    def __init__(self):
+        self.arrival_times_s: List[float] = []
+
+    def callback(self, msg: object) -> None:
+        self.arrival_times_s.append(time.monotonic())
+
+    def num_messages(self) -> int:
+        return len(self.arrival_times_s)
+
+    def rate_hz(self) -> float:
+        """Mean rate over the arrival times, 0 for less than two messages."""
+        if len(self.arrival_times_s) < 2:
+            return 0.0
+        duration_s = self.arrival_times_s[-1] - self.arrival_times_s[0]
+        return (len(self.arrival_times_s) - 1) / duration_s if duration_s > 0.0 else 0.0
+
+    def max_gap_s(self) -> float:
+        """Largest time between two consecutive messages."""
+        gaps = [b - a for a, b in zip(self.arrival_times_s, self.arrival_times_s[1:])]
+        return max(gaps, default=0.0)
+
+
+def parse_dropped_items(log_text: str) -> Dict[str, int]:
+    """
+    Parse the number of items dropped per input queue from the node's console output.
+
+    Parameters
+    ----------
+    log_text : str
+        The console output of the process running the nvblox node.
+
+    Returns
+    -------
+    Dict[str, int]
+        The total number of dropped items per queue name. The node reports running
+        totals, so the largest reported value of each queue is returned.
+
+    """
+    dropped_items = {}
+    for match in _DROPPED_ITEMS_REGEX.finditer(log_text):
+        queue_name = match.group(1)
+        dropped_items[queue_name] = max(dropped_items.get(queue_name, 0), int(match.group(2)))
+    return dropped_items
+
+
+def parse_latencies_s(log_text: str) -> Dict[str, Dict[str, float]]:
+    """
+    Parse the input-to-output latencies from the node's console output.
+
+    Parameters
+    ----------
+    log_text : str
+        The console output of the process running the nvblox node.
+
+    Returns
+    -------
+    Dict[str, Dict[str, float]]
+        Per output (e.g. 'static_map_slice') and input source (e.g. 'camera_0') the
+        rolling mean age of the newest contributing input at publish time, in seconds.
+        The last printed value is returned.
+
+    """
+    latencies_s = {}
+    for match in _LATENCY_REGEX.finditer(log_text):
+        output, source, num_samples, mean_delay_s = match.groups()
+        if int(num_samples) > 0:
+            latencies_s.setdefault(output, {})[source] = float(mean_delay_s)
+    return latencies_s
+
+
+@dataclass
+class ThroughputBenchmarkReport:
+    """The result of playing a bag through the nvblox pipeline at a given rate."""
+
+    bag_path: str
+    playback_rate: float
+    duration_s: float
+    # Per topic, the rate at which messages were received in Hz.
+    input_rates_hz: Dict[str, float] = field(default_factory=dict)
+    output_rates_hz: Dict[str, float] = field(default_factory=dict)
+    # Per output topic, the largest gap between two messages in seconds.
+    output_max_gaps_s: Dict[str, float] = field(default_factory=dict)
+    # Per input queue, the number of items dropped by the node.
+    dropped_items: Dict[str, int] = field(default_factory=dict)
+    # Per output and input source, the mean sensor-to-output latency in seconds.
+    latencies_s: Dict[str, Dict[str, float]] = field(default_factory=dict)
+
+    def total_dropped_items(self) -> int:
+        return sum(self.dropped_items.values())
+
+    def write_json(self, file_path: str) -> None:
+        with open(file_path, 'w') as file:
+            json.dump(asdict(self), file, indent=2, sort_keys=True)
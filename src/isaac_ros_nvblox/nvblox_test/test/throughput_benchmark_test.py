@@ -0,0 +1,163 @@
+# SPDX-FileCopyrightText: NVIDIA CORPORATION & AFFILIATES
+# Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# SPDX-License-Identifier: Apache-2.0
+
+"""
+Throughput and latency benchmark of the full nvblox node pipeline.
+
+Plays a recorded multi-camera bag through the Isaac Sim example pipeline at a given
+rate and reports per rate:
+- the rates of the inputs and outputs,
+- the number of items dropped from the node's input queues,
+- the sensor-to-output latency per camera, as measured by the node.
+
+Configured through environment variables, such that the same test can be run at
+several rates (see README.md):
+- NVBLOX_BENCHMARK_RATE: bag playback rate (default 1.0).
+- NVBLOX_BENCHMARK_BAG: path to the bag (default: the quickstart bag).
+- NVBLOX_BENCHMARK_DURATION_S: maximum measurement duration (default 120).
+- NVBLOX_BENCHMARK_OUTPUT_DIR: where the JSON report is written (default /tmp).
+"""
+
+import os
+import pathlib
+import time
+
+import pytest
+import rclpy
+
+import launch_testing
+from launch import LaunchDescription
+from launch_ros.actions import SetParameter
+from sensor_msgs.msg import CameraInfo
+
+from isaac_ros_test import IsaacROSBaseTest
+import isaac_ros_launch_utils as lu
+from nvblox_msgs.msg import DistanceMapSlice, Mesh
+from nvblox_ros_python_utils.nvblox_constants import NVBLOX_CONTAINER_NAME
+from nvblox_test.benchmark_utils import (parse_dropped_items, parse_latencies_s,
+                                         ThroughputBenchmarkReport, TopicMonitor)
+
+PLAYBACK_RATE = float(os.environ.get('NVBLOX_BENCHMARK_RATE', '1.0'))
+BAG_PATH = os.environ.get(
+    'NVBLOX_BENCHMARK_BAG',
+    os.path.join(lu.get_isaac_ros_ws_path(), 'isaac_ros_assets', 'isaac_ros_nvblox',
+                 'quickstart'))
+DURATION_S = float(os.environ.get('NVBLOX_BENCHMARK_DURATION_S', '120'))
+OUTPUT_DIR = os.environ.get('NVBLOX_BENCHMARK_OUTPUT_DIR', '/tmp')
+NUM_CAMERAS = 3
+# Stop measuring once the bag hasn't published anything for this long.
+END_OF_BAG_TIMEOUT_S = 5.0
+# How long to wait for the first input message.
+STARTUP_TIMEOUT_S = 60.0
+
+INPUT_TOPICS = [
+    f'/{name}/left/camera_info'
+    for name in ['front_stereo_camera', 'left_stereo_camera', 'right_stereo_camera']
+][:NUM_CAMERAS]
+OUTPUT_TOPICS = [('/nvblox_node/static_map_slice', DistanceMapSlice),
+                 ('/nvblox_node/mesh', Mesh)]
+
+
+@pytest.mark.rostest
+def generate_test_description():
+    actions = []
+    actions.append(SetParameter('use_sim_time', True))
+    # The benchmark reads queue drops and latencies from the console output.
+    actions.append(SetParameter('print_queue_drops_to_console', True))
+    actions.append(SetParameter('print_delays_to_console', True))
+    actions.append(SetParameter('print_statistics_on_console_period_ms', 1000))
+
+    actions.append(
+        lu.component_container(NVBLOX_CONTAINER_NAME, container_type='isolated'))
+    actions.append(
+        lu.include(
+            'nvblox_examples_bringup',
+            'launch/perception/nvblox.launch.py',
+            launch_arguments={
+                'container_name': NVBLOX_CONTAINER_NAME,
+                'mode': 'static',
+                'camera': 'isaac_sim',
+                'num_cameras': str(NUM_CAMERAS),
+            }))
+    actions.append(lu.play_rosbag(bag_path=BAG_PATH, rate=str(PLAYBACK_RATE)))
+
+    # Required for ROS launch testing.
+    actions.append(launch_testing.util.KeepAliveProc())
+    actions.append(launch_testing.actions.ReadyToTest())
+    return LaunchDescription(actions)
+
+
+class NvbloxThroughputBenchmark(IsaacROSBaseTest):
+    filepath = pathlib.Path(__file__).parent
+
+    def test_throughput(self, proc_output):
+        assert os.path.exists(BAG_PATH), f'Benchmark rosbag {BAG_PATH} does not exist.'
+
+        monitors = {}
+        subs = []
+        for topic in INPUT_TOPICS:
+            monitors[topic] = TopicMonitor()
+            subs.append(
+                self.node.create_subscription(CameraInfo, topic, monitors[topic].callback, 10))
+        for topic, msg_type in OUTPUT_TOPICS:
+            monitors[topic] = TopicMonitor()
+            subs.append(
+                self.node.create_subscription(msg_type, topic, monitors[topic].callback, 10))
+
+        try:
+            start_time_s = time.monotonic()
+            end_time_s = start_time_s + DURATION_S
+            while time.monotonic() < end_time_s:
+                rclpy.spin_once(self.node, timeout_sec=0.1)
+                last_input_times_s = [
+                    monitors[topic].arrival_times_s[-1] for topic in INPUT_TOPICS
+                    if monitors[topic].num_messages() > 0
+                ]
+                if not last_input_times_s:
+                    self.assertLess(time.monotonic() - start_time_s, STARTUP_TIMEOUT_S,
+                                    'Timed out waiting for the bag to start playing.')
+                elif time.monotonic() - max(last_input_times_s) > END_OF_BAG_TIMEOUT_S:
+                    break
+            duration_s = time.monotonic() - start_time_s
+        finally:
+            [self.node.destroy_subscription(sub) for sub in subs]
+
+        log_text = ''.join(io.text.decode(errors='replace') for io in proc_output)
+        report = ThroughputBenchmarkReport(
+            bag_path=BAG_PATH,
+            playback_rate=PLAYBACK_RATE,
+            duration_s=duration_s,
+            input_rates_hz={topic: monitors[topic].rate_hz()
+                            for topic in INPUT_TOPICS},
+            output_rates_hz={topic: monitors[topic].rate_hz()
+                             for topic, _ in OUTPUT_TOPICS},
+            output_max_gaps_s={topic: monitors[topic].max_gap_s()
+                               for topic, _ in OUTPUT_TOPICS},
+            dropped_items=parse_dropped_items(log_text),
+            latencies_s=parse_latencies_s(log_text))
+
+        report_path = os.path.join(
+            OUTPUT_DIR, f'nvblox_throughput_benchmark_{PLAYBACK_RATE:g}x.json')
+        report.write_json(report_path)
+        self.node.get_logger().info(
+            f'Playback rate {PLAYBACK_RATE:g}x: dropped {report.total_dropped_items()} items, '
+            f'output rates {report.output_rates_hz}, latencies {report.latencies_s}. '
+            f'Report written to {report_path}')
+
+        for topic, _ in OUTPUT_TOPICS:
+            self.assertGreater(monitors[topic].num_messages(), 0,
+                               f'No messages received on {topic}.')